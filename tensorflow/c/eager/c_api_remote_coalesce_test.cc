@@ -0,0 +1,159 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <stdlib.h>
+
+#include <memory>
+
+#include "tensorflow/c/eager/c_api.h"
+#include "tensorflow/c/eager/c_api_experimental.h"
+#include "tensorflow/c/eager/c_api_test_util.h"
+#include "tensorflow/core/distributed_runtime/rpc/grpc_server_lib.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/tensorflow_server.pb.h"
+
+namespace {
+
+// Enables coalescing of remote operations before the first remote operation
+// reads the setting. Set TF_EAGER_MAX_COALESCED_REMOTE_OPS=1 to compare the
+// benchmark without coalescing.
+const bool kCoalescingEnabled =
+    setenv("TF_EAGER_MAX_COALESCED_REMOTE_OPS", "16", /*overwrite=*/0) == 0;
+
+constexpr char kRemoteDeviceName[] =
+    "/job:localhost/replica:0/task:1/device:CPU:0";
+
+// An async context connected over gRPC to a worker running on this process.
+class RemoteContext {
+ public:
+  RemoteContext() : status_(TF_NewStatus()) {
+    CHECK(kCoalescingEnabled);
+    tensorflow::ServerDef server_def = GetServerDef(2);
+    // This server def has the task index set to 0.
+    const std::string serialized = server_def.SerializeAsString();
+    server_def.set_task_index(1);
+    TF_CHECK_OK(tensorflow::GrpcServer::Create(
+        server_def, tensorflow::Env::Default(), &worker_server_));
+    TF_CHECK_OK(worker_server_->Start());
+
+    TFE_ContextOptions* opts = TFE_NewContextOptions();
+    TFE_ContextOptionsSetAsync(opts, static_cast<unsigned char>(true));
+    TFE_ContextOptionsSetDevicePlacementPolicy(opts,
+                                               TFE_DEVICE_PLACEMENT_EXPLICIT);
+    ctx_ = TFE_NewContext(opts, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TFE_DeleteContextOptions(opts);
+    TFE_ContextSetServerDef(ctx_, 0, serialized.data(), serialized.size(),
+                            status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+  }
+
+  ~RemoteContext() {
+    TFE_Executor* executor = TFE_ContextGetExecutorForThread(ctx_);
+    TFE_ExecutorWaitForAllPendingNodes(executor, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TFE_DeleteExecutor(executor);
+    TFE_DeleteContext(ctx_);
+    TF_DeleteStatus(status_);
+    // TODO(b/136478427): Figure out how to correctly shut the server down.
+    worker_server_.release();
+  }
+
+  // Returns a scalar on the remote worker.
+  TFE_TensorHandle* RemoteScalar(float value) {
+    TFE_TensorHandle* local = TestScalarTensorHandle(ctx_, value);
+    TFE_TensorHandle* remote =
+        TFE_TensorHandleCopyToDevice(local, ctx_, kRemoteDeviceName, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TFE_DeleteTensorHandle(local);
+    return remote;
+  }
+
+  // Returns `x + y` computed on the remote worker.
+  TFE_TensorHandle* RemoteAdd(TFE_TensorHandle* x, TFE_TensorHandle* y) {
+    TFE_Op* add = AddOp(ctx_, x, y);
+    TFE_OpSetDevice(add, kRemoteDeviceName, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TFE_TensorHandle* retvals[1];
+    int num_retvals = 1;
+    TFE_Execute(add, &retvals[0], &num_retvals, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    TFE_DeleteOp(add);
+    return retvals[0];
+  }
+
+  // Returns `x + n` computed as a chain of `n` dependent remote operations.
+  TFE_TensorHandle* RemoteChain(TFE_TensorHandle* x, TFE_TensorHandle* one,
+                                int n) {
+    TFE_TensorHandle* y = RemoteAdd(x, one);
+    for (int i = 1; i < n; ++i) {
+      TFE_TensorHandle* next = RemoteAdd(y, one);
+      TFE_DeleteTensorHandle(y);
+      y = next;
+    }
+    return y;
+  }
+
+  float Resolve(TFE_TensorHandle* h) {
+    TF_Tensor* t = TFE_TensorHandleResolve(h, status_);
+    CHECK_EQ(TF_OK, TF_GetCode(status_)) << TF_Message(status_);
+    float value = *static_cast<float*>(TF_TensorData(t));
+    TF_DeleteTensor(t);
+    return value;
+  }
+
+ private:
+  std::unique_ptr<tensorflow::GrpcServer> worker_server_;
+  TF_Status* status_;
+  TFE_Context* ctx_;
+};
+
+TEST(CAPI, RemoteExecuteCoalescedChain) {
+  RemoteContext ctx;
+  TFE_TensorHandle* zero = ctx.RemoteScalar(0.0f);
+  TFE_TensorHandle* one = ctx.RemoteScalar(1.0f);
+
+  TFE_TensorHandle* y = ctx.RemoteChain(zero, one, 100);
+  // Resolving a handle is a sync point, after which the chain continues.
+  EXPECT_EQ(ctx.Resolve(y), 100.0f);
+  TFE_TensorHandle* z = ctx.RemoteChain(y, one, 50);
+  EXPECT_EQ(ctx.Resolve(z), 150.0f);
+
+  TFE_DeleteTensorHandle(zero);
+  TFE_DeleteTensorHandle(one);
+  TFE_DeleteTensorHandle(y);
+  TFE_DeleteTensorHandle(z);
+}
+
+void BM_RemoteExecuteChain(::testing::benchmark::State& state) {
+  const int length = state.range(0);
+  RemoteContext ctx;
+  TFE_TensorHandle* zero = ctx.RemoteScalar(0.0f);
+  TFE_TensorHandle* one = ctx.RemoteScalar(1.0f);
+  for (auto s : state) {
+    TFE_TensorHandle* y = ctx.RemoteChain(zero, one, length);
+    CHECK_EQ(ctx.Resolve(y), length);
+    TFE_DeleteTensorHandle(y);
+  }
+  state.SetItemsProcessed(length * static_cast<int64_t>(state.iterations()));
+  TFE_DeleteTensorHandle(zero);
+  TFE_DeleteTensorHandle(one);
+}
+BENCHMARK(BM_RemoteExecuteChain)->Arg(1)->Arg(16)->Arg(256);
+
+}  // namespace
@@ -185,6 +185,7 @@ void TF_AssignVariable(TF_OpKernelContext* ctx, int input_index,
                                return ::tensorflow::OkStatus();
                              }));
   tensorflow::mutex_lock ml(*variable->mu());
+  variable->MarkAllRowsDirty();
 
   if (validate_shape) {
     OP_REQUIRES(cc_ctx,
@@ -266,6 +267,7 @@ void TF_AssignUpdateVariable(TF_OpKernelContext* ctx, int input_index,
   }
   const Tensor& value = context->input(value_index);
   mutex_lock ml(*variable->mu());
+  variable->MarkAllRowsDirty();
   Tensor* var_tensor = variable->tensor();
   OP_REQUIRES(
       context, var_tensor->shape().IsSameSize(value.shape()),
@@ -387,6 +389,10 @@ void TF_OpKernelContext_ForwardRefInputToRefOutput(TF_OpKernelContext* ctx,
 
 void TF_ReleaseVariableInputLockHolder(TF_VariableInputLockHolder* lockHolder) {
   if (lockHolder != nullptr) {
+    // The updates made by plugin kernels are not tracked row by row.
+    for (tensorflow::Var* var : lockHolder->vars) {
+      var->MarkAllRowsDirty();
+    }
     lockHolder->locks.reset();
     for (tensorflow::Var* var : lockHolder->vars) {
       var->Unref();
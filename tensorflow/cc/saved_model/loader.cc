@@ -203,6 +203,19 @@ Status RunOnce(const RunOptions& run_options,
   return run_status;
 }
 
+// Runs the nodes `init_node_names` of the init op, feeding the asset file
+// names.
+Status RunInitNodes(const RunOptions& run_options, const string& export_dir,
+                    const std::vector<AssetFileDef>& asset_file_defs,
+                    const std::vector<string>& init_node_names,
+                    Session* session) {
+  std::vector<std::pair<string, Tensor>> inputs;
+  AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
+  RunMetadata run_metadata;
+  return RunOnce(run_options, inputs, {}, init_node_names,
+                 nullptr /* outputs */, &run_metadata, session);
+}
+
 // RunInitOp will return OK if the initialization op was run successfully.
 // An empty init_op_name indicates that there are no init ops to run.
 Status RunInitOp(const RunOptions& run_options, const string& export_dir,
@@ -221,13 +234,9 @@ Status RunInitOp(const RunOptions& run_options, const string& export_dir,
   return OkStatus();
 }
 
-Status RunRestore(const RunOptions& run_options, const string& export_dir,
-                  const StringPiece restore_op_name,
-                  const StringPiece variable_filename_const_op_name,
-                  const std::vector<AssetFileDef>& asset_file_defs,
-                  Session* session) {
-  LOG(INFO) << "Restoring SavedModel bundle.";
-  // Find path to variables to be restored in export directory.
+// Returns the path of the variables to be restored in the export directory,
+// or an empty string if there are none.
+StatusOr<string> GetVariablesPath(const string& export_dir) {
   const string variables_directory =
       io::JoinPath(export_dir, kSavedModelVariablesDirectory);
   // Check for saver checkpoints in v2 format. Models exported in the checkpoint
@@ -239,13 +248,26 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
       bool variables_index_exists,
       internal::FileExists(Env::Default(), variables_index_path));
   if (!variables_index_exists) {
+    return string();
+  }
+  return io::JoinPath(variables_directory, kSavedModelVariablesFilename);
+}
+
+Status RunRestore(const RunOptions& run_options, const string& export_dir,
+                  const StringPiece restore_op_name,
+                  const StringPiece variable_filename_const_op_name,
+                  const std::vector<AssetFileDef>& asset_file_defs,
+                  Session* session) {
+  LOG(INFO) << "Restoring SavedModel bundle.";
+  TF_ASSIGN_OR_RETURN(const string variables_path,
+                      GetVariablesPath(export_dir));
+  if (variables_path.empty()) {
     LOG(INFO) << "The specified SavedModel has no variables; no checkpoints "
                  "were restored. File does not exist: "
-              << variables_index_path;
+              << io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                              MetaFilename(kSavedModelVariablesFilename));
     return OkStatus();
   }
-  const string variables_path =
-      io::JoinPath(variables_directory, kSavedModelVariablesFilename);
 
   // Add variables to the graph.
   Tensor variables_path_tensor(DT_STRING, TensorShape({}));
@@ -275,8 +297,37 @@ Status LoadMetagraphIntoSession(const SessionOptions& session_options,
   return (*session)->Create(meta_graph.graph_def());
 }
 
+namespace {
+
+// Like LoadMetagraphIntoSession(), but splits the restore ops of the graph as
+// requested by `load_options`.
+Status LoadMetagraphIntoSessionInternal(
+    const SessionOptions& session_options,
+    const SavedModelLoadOptions& load_options, const MetaGraphDef& meta_graph,
+    const string& export_dir, std::unique_ptr<Session>* session) {
+  if (load_options.restore_parallelism <= 1 || !meta_graph.has_saver_def()) {
+    return LoadMetagraphIntoSession(session_options, meta_graph, session);
+  }
+  TF_ASSIGN_OR_RETURN(const string variables_path,
+                      GetVariablesPath(export_dir));
+  if (variables_path.empty()) {
+    return LoadMetagraphIntoSession(session_options, meta_graph, session);
+  }
+  Session* session_p = nullptr;
+  TF_RETURN_IF_ERROR(NewSession(session_options, &session_p));
+  session->reset(session_p);
+  TF_RETURN_IF_ERROR(ValidateSavedTensors(meta_graph.graph_def()));
+  GraphDef graph_def = meta_graph.graph_def();
+  TF_RETURN_IF_ERROR(internal::SplitRestoreOps(
+      variables_path, load_options.restore_parallelism, &graph_def));
+  return (*session)->Create(std::move(graph_def));
+}
+
+}  // namespace
+
 Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
+                              const SavedModelLoadOptions& load_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
                               SavedModelBundle* const bundle) {
@@ -284,10 +335,12 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                                     &bundle->meta_graph_def));
   TF_RETURN_IF_ERROR(
       ReadSavedModelDebugInfoIfPresent(export_dir, &bundle->debug_info));
-  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
-      session_options, bundle->meta_graph_def, &bundle->session));
-  TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
-                                    export_dir, &bundle->session));
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSessionInternal(
+      session_options, load_options, bundle->meta_graph_def, export_dir,
+      &bundle->session));
+  TF_RETURN_IF_ERROR(RestoreSession(run_options, load_options,
+                                    bundle->meta_graph_def, export_dir,
+                                    &bundle->session));
   return OkStatus();
 }
 
@@ -295,12 +348,22 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, SavedModelLoadOptions(),
+                        export_dir, tags, bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle) {
   metrics::SavedModelReadApi(kCCLoadLabel).IncrementBy(1);
 
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status = LoadSavedModelInternal(
+      session_options, run_options, load_options, export_dir, tags, bundle);
   auto log_and_count = [&](const string& status_str) {
     LOG(INFO) << "SavedModel load for tags { " << absl::StrJoin(tags, " ")
               << " }; Status: " << status_str << ": " << status << ". Took "
@@ -429,26 +492,69 @@ class LiteSessionWrapper : public Session {
 Status RestoreSession(const RunOptions& run_options,
                       const MetaGraphDef& meta_graph, const string& export_dir,
                       std::unique_ptr<Session>* session) {
+  return RestoreSession(run_options, SavedModelLoadOptions(), meta_graph,
+                        export_dir, session);
+}
+
+Status RestoreSession(const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const MetaGraphDef& meta_graph, const string& export_dir,
+                      std::unique_ptr<Session>* session) {
   const uint64 read_start_microseconds = Env::Default()->NowMicros();
   std::vector<AssetFileDef> asset_file_defs;
   TF_RETURN_IF_ERROR(internal::GetAssetFileDefs(meta_graph, &asset_file_defs));
-  if (meta_graph.has_saver_def()) {
-    TF_RETURN_IF_ERROR(RunRestore(run_options, export_dir,
-                                  meta_graph.saver_def().restore_op_name(),
-                                  meta_graph.saver_def().filename_tensor_name(),
-                                  asset_file_defs, session->get()));
+  string init_op_name;
+  TF_RETURN_IF_ERROR(
+      internal::GetInitOp(export_dir, meta_graph, &init_op_name));
+
+  // If requested, the initializers of asset tables run while the variables are
+  // restored, and the other nodes of the init op run afterwards.
+  std::vector<string> asset_table_initializers;
+  std::vector<string> init_node_names;
+  if (load_options.init_asset_tables_during_restore && !init_op_name.empty()) {
+    TF_RETURN_IF_ERROR(internal::SplitInitOp(meta_graph.graph_def(),
+                                             init_op_name,
+                                             &asset_table_initializers,
+                                             &init_node_names));
+  }
+  Status asset_tables_status;
+  {
+    std::unique_ptr<Thread> asset_tables_thread;
+    if (!asset_table_initializers.empty()) {
+      LOG(INFO) << "Initializing " << asset_table_initializers.size()
+                << " asset tables while restoring SavedModel bundle.";
+      asset_tables_thread.reset(Env::Default()->StartThread(
+          ThreadOptions(), "saved_model_asset_tables", [&]() {
+            asset_tables_status =
+                RunInitNodes(run_options, export_dir, asset_file_defs,
+                             asset_table_initializers, session->get());
+          }));
+    }
+    if (meta_graph.has_saver_def()) {
+      TF_RETURN_IF_ERROR(RunRestore(
+          run_options, export_dir, meta_graph.saver_def().restore_op_name(),
+          meta_graph.saver_def().filename_tensor_name(), asset_file_defs,
+          session->get()));
+    }
   }
+  TF_RETURN_IF_ERROR(asset_tables_status);
   // Record walltime spent in restoring graph from disk, but postpone metric
   // increments until graph init finishes.
   const uint64 restore_graph_walltime =
       GetLatencyMicroseconds(read_start_microseconds);
 
   const uint64 graph_init_start_microseconds = Env::Default()->NowMicros();
-  string init_op_name;
-  TF_RETURN_IF_ERROR(
-      internal::GetInitOp(export_dir, meta_graph, &init_op_name));
-  TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
-                               asset_file_defs, session->get(), init_op_name));
+  if (asset_table_initializers.empty()) {
+    TF_RETURN_IF_ERROR(RunInitOp(run_options, export_dir, meta_graph,
+                                 asset_file_defs, session->get(),
+                                 init_op_name));
+  } else if (!init_node_names.empty()) {
+    LOG(INFO) << "Running remaining initialization op nodes on SavedModel "
+                 "bundle at path: "
+              << export_dir;
+    TF_RETURN_IF_ERROR(RunInitNodes(run_options, export_dir, asset_file_defs,
+                                    init_node_names, session->get()));
+  }
   load_latency_by_stage->GetCell(export_dir, "restore_graph")
       ->Add(restore_graph_walltime);
   // Record wall time spent in init op.
@@ -461,6 +567,16 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundleLite* const bundle) {
+  return LoadSavedModel(session_options, run_options, SavedModelLoadOptions(),
+                        export_dir, tags, bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundleLite* const bundle) {
   SavedModelBundle legacy_bundle;
   SessionOptions rewritten_options(session_options);
   // We disallow calls to Session::Extend() on the returned session, so we can
@@ -474,8 +590,9 @@ Status LoadSavedModel(const SessionOptions& session_options,
       ->set_disable_output_partition_graphs(true);
   // TODO(mrry): Consider specializing the session creation to reduce peak
   // RAM consumption by using `Session::Create(GraphDef&&)`.
-  TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options, export_dir,
-                                    tags, &legacy_bundle));
+  TF_RETURN_IF_ERROR(LoadSavedModel(rewritten_options, run_options,
+                                    load_options, export_dir, tags,
+                                    &legacy_bundle));
   *bundle = SavedModelBundleLite(
       absl::make_unique<LiteSessionWrapper>(std::move(legacy_bundle.session)),
       std::move(*legacy_bundle.meta_graph_def.mutable_signature_def()));
@@ -97,6 +97,22 @@ class SavedModelBundleLite : public SavedModelBundleInterface {
   protobuf::Map<string, SignatureDef> signatures_;
 };
 
+/// Options that control how a SavedModel is loaded, beyond the options of the
+/// session it is loaded into.
+struct SavedModelLoadOptions {
+  /// If greater than 1, each restore op that restores several variables is
+  /// split into up to this many restore ops for groups of variables of similar
+  /// total size, which read from the checkpoint in parallel on the inter-op
+  /// threads of the session. This speeds up restoring models with variables of
+  /// skewed sizes, at the cost of a temporary copy of the graph.
+  int restore_parallelism = 1;
+
+  /// If true, the initializers of lookup tables from asset files that do not
+  /// depend on variables run on a background thread while the variables are
+  /// restored, instead of after them with the rest of the init op.
+  bool init_asset_tables_during_restore = false;
+};
+
 // Restore variable and resources in the SavedModel export dir for the
 // indicated metagraph.
 // The recommended way to load a saved model is to call LoadSavedModel,
@@ -104,6 +120,10 @@ class SavedModelBundleLite : public SavedModelBundleInterface {
 Status RestoreSession(const RunOptions& run_options,
                       const MetaGraphDef& meta_graph, const string& export_dir,
                       std::unique_ptr<Session>* session);
+Status RestoreSession(const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const MetaGraphDef& meta_graph, const string& export_dir,
+                      std::unique_ptr<Session>* session);
 
 // Initialize a session which wraps this metagraph.
 // The recommended way to load a saved model is to call LoadSavedModel,
@@ -122,6 +142,12 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundle* const bundle);
 
 /// Loads a SavedModel from the specified export directory. The MetaGraphDef
 /// to be loaded is identified by the supplied tags, corresponding exactly to
@@ -134,6 +160,12 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundleLite* const bundle);
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options,
+                      const SavedModelLoadOptions& load_options,
+                      const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      SavedModelBundleLite* const bundle);
 
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
@@ -15,15 +15,145 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader_util.h"
 
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace internal {
+namespace {
+
+using NodeIndex = std::unordered_map<string, int>;
+
+NodeIndex MakeNodeIndex(const GraphDef& graph_def) {
+  NodeIndex node_index;
+  for (int i = 0; i < graph_def.node_size(); ++i) {
+    node_index[graph_def.node(i).name()] = i;
+  }
+  return node_index;
+}
+
+// Returns the node of `graph_def` named `name`, or nullptr if there is none.
+const NodeDef* FindNode(const GraphDef& graph_def, const NodeIndex& node_index,
+                        const string& name) {
+  const auto it = node_index.find(name);
+  return it == node_index.end() ? nullptr : &graph_def.node(it->second);
+}
+
+// Returns the node producing `input`, or nullptr if there is none.
+const NodeDef* FindInputNode(const GraphDef& graph_def,
+                             const NodeIndex& node_index, const string& input) {
+  return FindNode(graph_def, node_index, string(ParseTensorName(input).node()));
+}
+
+// Returns true and sets `value` if `input` is the output of a Const node of
+// type string.
+bool GetConstStringValue(const GraphDef& graph_def, const NodeIndex& node_index,
+                         const string& input, Tensor* value) {
+  if (ParseTensorName(input).index() != 0) return false;
+  const NodeDef* node = FindInputNode(graph_def, node_index, input);
+  if (node == nullptr || node->op() != "Const") return false;
+  const auto value_it = node->attr().find("value");
+  return value_it != node->attr().end() &&
+         value_it->second.tensor().dtype() == DT_STRING &&
+         value->FromProto(value_it->second.tensor());
+}
+
+// Returns the groups of indices of `sizes` with similar total sizes, using
+// the longest processing time first heuristic. Indices are sorted within each
+// group, and empty groups are dropped.
+std::vector<std::vector<int>> MakeBalancedGroups(
+    const std::vector<int64_t>& sizes, int num_groups) {
+  std::vector<int> order(sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return sizes[a] > sizes[b]; });
+  std::vector<std::vector<int>> groups(num_groups);
+  std::vector<int64_t> group_sizes(num_groups, 0);
+  for (int i : order) {
+    const int group =
+        std::min_element(group_sizes.begin(), group_sizes.end()) -
+        group_sizes.begin();
+    groups[group].push_back(i);
+    group_sizes[group] += sizes[i];
+  }
+  groups.erase(std::remove_if(groups.begin(), groups.end(),
+                              [](const std::vector<int>& group) {
+                                return group.empty();
+                              }),
+               groups.end());
+  for (auto& group : groups) {
+    std::sort(group.begin(), group.end());
+  }
+  return groups;
+}
+
+string OutputName(const string& node_name, int index) {
+  return strings::StrCat(node_name, ":", index);
+}
+
+// Sets `node` to a copy of the Const node `original` named `name` with
+// `value`.
+void MakeConstNode(const NodeDef& original, const string& name,
+                   const Tensor& value, NodeDef* node) {
+  *node = original;
+  node->set_name(name);
+  node->mutable_attr()->erase("_output_shapes");
+  value.AsProtoField((*node->mutable_attr())["value"].mutable_tensor());
+}
+
+bool IsTextFileTableInitializer(const NodeDef& node) {
+  return node.op() == "InitializeTableFromTextFile" ||
+         node.op() == "InitializeTableFromTextFileV2";
+}
+
+// Returns true if `node` only depends on constants, placeholders (such as the
+// asset file names) and lookup tables, so it can run before the variables are
+// restored.
+bool DependsOnlyOnAssetsAndTables(const GraphDef& graph_def,
+                                  const NodeIndex& node_index,
+                                  const NodeDef& node) {
+  static const auto* const kAllowedOps = new std::unordered_set<string>({
+      "Const",
+      "HashTable",
+      "HashTableV2",
+      "Identity",
+      "InitializeTableFromTextFile",
+      "InitializeTableFromTextFileV2",
+      "Placeholder",
+      "PlaceholderWithDefault",
+  });
+  std::vector<const NodeDef*> stack = {&node};
+  std::unordered_set<const NodeDef*> visited = {&node};
+  while (!stack.empty()) {
+    const NodeDef* current = stack.back();
+    stack.pop_back();
+    if (kAllowedOps->count(current->op()) == 0) return false;
+    for (const string& input : current->input()) {
+      const NodeDef* input_node = FindInputNode(graph_def, node_index, input);
+      if (input_node == nullptr) return false;
+      if (visited.insert(input_node).second) {
+        stack.push_back(input_node);
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
 
 // A SavedModel may store the name of the initialization op to run in the
 // in the SignatureDef (v2) or a collection (v1). If an init_op collection
@@ -91,5 +221,178 @@ Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
   return OkStatus();
 }
 
+Status SplitRestoreOps(const string& variables_path, int num_groups,
+                       GraphDef* graph_def) {
+  if (num_groups <= 1) {
+    return OkStatus();
+  }
+  BundleReader reader(Env::Default(), variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+
+  const NodeIndex node_index = MakeNodeIndex(*graph_def);
+  // Maps the outputs of the split ops to the outputs of the new ops.
+  std::unordered_map<string, string> new_outputs;
+  // Maps the split ops to the added ops, which control dependencies on the
+  // split ops must also depend on.
+  std::unordered_map<string, std::vector<string>> added_ops;
+  const int num_nodes = graph_def->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    const NodeDef& restore = graph_def->node(i);
+    if (restore.op() != "RestoreV2" || restore.input_size() != 3) continue;
+    Tensor tensor_names;
+    Tensor shape_and_slices;
+    std::vector<DataType> dtypes;
+    if (!GetConstStringValue(*graph_def, node_index, restore.input(1),
+                             &tensor_names) ||
+        !GetConstStringValue(*graph_def, node_index, restore.input(2),
+                             &shape_and_slices) ||
+        !GetNodeAttr(restore, "dtypes", &dtypes).ok()) {
+      continue;
+    }
+    const int num_tensors = tensor_names.NumElements();
+    if (num_tensors < 2 || shape_and_slices.NumElements() != num_tensors ||
+        dtypes.size() != num_tensors) {
+      continue;
+    }
+
+    // Sliced tensors are approximated by the size of the full tensor. Leave
+    // the op as is if a tensor is missing, so that it reports the error.
+    std::vector<int64_t> sizes(num_tensors);
+    bool all_found = true;
+    for (int t = 0; t < num_tensors && all_found; ++t) {
+      DataType dtype;
+      TensorShape shape;
+      all_found = reader
+                      .LookupDtypeAndShape(tensor_names.flat<tstring>()(t),
+                                           &dtype, &shape)
+                      .ok();
+      sizes[t] = shape.num_elements() * std::max(DataTypeSize(dtype), 1);
+    }
+    if (!all_found) continue;
+    const std::vector<std::vector<int>> groups =
+        MakeBalancedGroups(sizes, num_groups);
+    if (groups.size() < 2) continue;
+
+    const NodeDef* tensor_names_node =
+        FindInputNode(*graph_def, node_index, restore.input(1));
+    const NodeDef* shape_and_slices_node =
+        FindInputNode(*graph_def, node_index, restore.input(2));
+    // The first group overwrites the original op.
+    const NodeDef original_restore = restore;
+    for (int g = 0; g < groups.size(); ++g) {
+      const std::vector<int>& group = groups[g];
+      // The first group keeps the name of the original op.
+      const string name =
+          g == 0 ? original_restore.name()
+                 : strings::StrCat(original_restore.name(), "/split_", g);
+      const string prefix = strings::StrCat(original_restore.name(), "/split_",
+                                            g, "/");
+      const TensorShape group_shape({static_cast<int64_t>(group.size())});
+      Tensor group_tensor_names(DT_STRING, group_shape);
+      Tensor group_shape_and_slices(DT_STRING, group_shape);
+      std::vector<DataType> group_dtypes;
+      for (int m = 0; m < group.size(); ++m) {
+        group_tensor_names.flat<tstring>()(m) =
+            tensor_names.flat<tstring>()(group[m]);
+        group_shape_and_slices.flat<tstring>()(m) =
+            shape_and_slices.flat<tstring>()(group[m]);
+        group_dtypes.push_back(dtypes[group[m]]);
+        new_outputs[OutputName(original_restore.name(), group[m])] =
+            OutputName(name, m);
+      }
+      MakeConstNode(*tensor_names_node,
+                    strings::StrCat(prefix, "tensor_names"),
+                    group_tensor_names, graph_def->add_node());
+      MakeConstNode(*shape_and_slices_node,
+                    strings::StrCat(prefix, "shape_and_slices"),
+                    group_shape_and_slices, graph_def->add_node());
+
+      NodeDef* group_restore =
+          g == 0 ? graph_def->mutable_node(i) : graph_def->add_node();
+      *group_restore = original_restore;
+      group_restore->set_name(name);
+      group_restore->set_input(1, strings::StrCat(prefix, "tensor_names"));
+      group_restore->set_input(2, strings::StrCat(prefix, "shape_and_slices"));
+      group_restore->mutable_attr()->erase("_output_shapes");
+      SetAttrValue(group_dtypes, &(*group_restore->mutable_attr())["dtypes"]);
+      if (g > 0) {
+        added_ops[original_restore.name()].push_back(name);
+      }
+    }
+  }
+
+  if (new_outputs.empty()) {
+    return OkStatus();
+  }
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    std::vector<string> added_control_inputs;
+    for (string& input : *node.mutable_input()) {
+      const TensorId id = ParseTensorName(input);
+      if (id.index() < 0) {
+        const auto it = added_ops.find(string(id.node()));
+        if (it == added_ops.end()) continue;
+        for (const string& added_op : it->second) {
+          added_control_inputs.push_back(strings::StrCat("^", added_op));
+        }
+      } else {
+        const auto it = new_outputs.find(OutputName(string(id.node()),
+                                                    id.index()));
+        if (it != new_outputs.end()) {
+          input = it->second;
+        }
+      }
+    }
+    for (string& input : added_control_inputs) {
+      node.add_input(std::move(input));
+    }
+  }
+  return OkStatus();
+}
+
+Status SplitInitOp(const GraphDef& graph_def, const string& init_op_name,
+                   std::vector<string>* asset_table_initializers,
+                   std::vector<string>* other_init_nodes) {
+  const NodeIndex node_index = MakeNodeIndex(graph_def);
+  const NodeDef* init_op = FindNode(graph_def, node_index, init_op_name);
+  if (init_op == nullptr || init_op->op() != "NoOp") {
+    other_init_nodes->push_back(init_op_name);
+    return OkStatus();
+  }
+
+  // Replace the NoOps grouping other nodes by these nodes.
+  std::vector<const NodeDef*> stack = {init_op};
+  std::unordered_set<const NodeDef*> visited = {init_op};
+  while (!stack.empty()) {
+    const NodeDef* node = stack.back();
+    stack.pop_back();
+    const bool is_group =
+        node->op() == "NoOp" &&
+        std::all_of(node->input().begin(), node->input().end(),
+                    [](const string& input) {
+                      return ParseTensorName(input).index() < 0;
+                    });
+    if (!is_group) {
+      if (IsTextFileTableInitializer(*node) &&
+          DependsOnlyOnAssetsAndTables(graph_def, node_index, *node)) {
+        asset_table_initializers->push_back(node->name());
+      } else {
+        other_init_nodes->push_back(node->name());
+      }
+      continue;
+    }
+    for (const string& input : node->input()) {
+      const NodeDef* input_node = FindInputNode(graph_def, node_index, input);
+      if (input_node == nullptr) {
+        return errors::FailedPrecondition("Init op ", init_op_name,
+                                          " depends on missing node ", input);
+      }
+      if (visited.insert(input_node).second) {
+        stack.push_back(input_node);
+      }
+    }
+  }
+  return OkStatus();
+}
+
 }  // namespace internal
 }  // namespace tensorflow
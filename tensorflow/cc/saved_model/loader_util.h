@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CC_SAVED_MODEL_LOADER_UTIL_H_
 
 #include <string>
+#include <vector>
 
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 
@@ -33,6 +35,23 @@ Status GetInitOp(const string& export_dir, const MetaGraphDef& meta_graph_def,
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs);
 
+// Splits each RestoreV2 op of `graph_def` that restores several tensors, with
+// tensor names and slices given by constants, into up to `num_groups` RestoreV2
+// ops. The groups have similar total sizes according to the checkpoint at
+// `variables_path`, so that they restore in parallel in about the same time.
+// Consumers of the original op are rewired to the new ops.
+Status SplitRestoreOps(const string& variables_path, int num_groups,
+                       GraphDef* graph_def);
+
+// Splits the nodes run by the init op `init_op_name` into the initializers of
+// lookup tables from asset files that do not depend on variables, which may
+// run before or while the variables are restored, and the other nodes. NoOps
+// that only group other nodes are replaced by the nodes they group. If the
+// init op is not such a NoOp, it is returned as the only other node.
+Status SplitInitOp(const GraphDef& graph_def, const string& init_op_name,
+                   std::vector<string>* asset_table_initializers,
+                   std::vector<string>* other_init_nodes);
+
 }  // namespace internal
 }  // namespace tensorflow
 
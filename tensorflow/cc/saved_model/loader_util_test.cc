@@ -0,0 +1,198 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/cc/saved_model/loader_util.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+
+NodeDef* AddNode(const string& name, const string& op,
+                 const std::vector<string>& inputs, GraphDef* graph_def) {
+  NodeDef* node = graph_def->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  for (const string& input : inputs) {
+    node->add_input(input);
+  }
+  return node;
+}
+
+void AddConst(const string& name, const Tensor& value, GraphDef* graph_def) {
+  NodeDef* node = AddNode(name, "Const", {}, graph_def);
+  AddNodeAttr("dtype", value.dtype(), node);
+  AddNodeAttr("value", value, node);
+}
+
+const NodeDef* FindNode(const GraphDef& graph_def, const string& name) {
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.name() == name) return &node;
+  }
+  return nullptr;
+}
+
+std::vector<tstring> GetConstStrings(const GraphDef& graph_def,
+                                     const string& name) {
+  const NodeDef* node = FindNode(graph_def, name);
+  EXPECT_NE(node, nullptr) << name;
+  if (node == nullptr) return {};
+  Tensor value;
+  EXPECT_TRUE(value.FromProto(node->attr().at("value").tensor()));
+  const auto flat = value.flat<tstring>();
+  return std::vector<tstring>(flat.data(), flat.data() + flat.size());
+}
+
+class SplitRestoreOpsTest : public ::testing::Test {
+ protected:
+  SplitRestoreOpsTest()
+      : variables_path_(io::JoinPath(testing::TmpDir(), "split_restore_ops")) {
+    // Variable `a` is as large as `b` and `c` together.
+    BundleWriter writer(Env::Default(), variables_path_);
+    TF_CHECK_OK(writer.Add("a", Tensor(DT_FLOAT, TensorShape({8}))));
+    TF_CHECK_OK(writer.Add("b", Tensor(DT_FLOAT, TensorShape({4}))));
+    TF_CHECK_OK(writer.Add("c", Tensor(DT_FLOAT, TensorShape({4}))));
+    TF_CHECK_OK(writer.Finish());
+
+    AddConst("save/Const", test::AsScalar<tstring>(variables_path_),
+             &graph_def_);
+    AddConst("save/RestoreV2/tensor_names",
+             test::AsTensor<tstring>({"b", "a", "c"}), &graph_def_);
+    AddConst("save/RestoreV2/shape_and_slices",
+             test::AsTensor<tstring>({"", "", ""}), &graph_def_);
+    AddNodeAttr("dtypes", std::vector<DataType>({DT_FLOAT, DT_FLOAT, DT_FLOAT}),
+                AddNode("save/RestoreV2", "RestoreV2",
+                        {"save/Const", "save/RestoreV2/tensor_names",
+                         "save/RestoreV2/shape_and_slices"},
+                        &graph_def_));
+    AddNode("save/Assign_b", "Assign", {"b", "save/RestoreV2"}, &graph_def_);
+    AddNode("save/Assign_a", "Assign", {"a", "save/RestoreV2:1"}, &graph_def_);
+    AddNode("save/Assign_c", "Assign", {"c", "save/RestoreV2:2"}, &graph_def_);
+    AddNode("save/After", "NoOp", {"^save/RestoreV2"}, &graph_def_);
+  }
+
+  const string variables_path_;
+  GraphDef graph_def_;
+};
+
+TEST_F(SplitRestoreOpsTest, SplitsIntoBalancedGroups) {
+  TF_ASSERT_OK(SplitRestoreOps(variables_path_, 2, &graph_def_));
+
+  EXPECT_THAT(
+      GetConstStrings(graph_def_, "save/RestoreV2/split_0/tensor_names"),
+      ElementsAre("a"));
+  EXPECT_THAT(
+      GetConstStrings(graph_def_, "save/RestoreV2/split_1/tensor_names"),
+      ElementsAre("b", "c"));
+  EXPECT_THAT(
+      GetConstStrings(graph_def_, "save/RestoreV2/split_1/shape_and_slices"),
+      ElementsAre("", ""));
+  const NodeDef* split = FindNode(graph_def_, "save/RestoreV2/split_1");
+  ASSERT_NE(split, nullptr);
+  EXPECT_EQ(split->input(0), "save/Const");
+  std::vector<DataType> dtypes;
+  TF_ASSERT_OK(GetNodeAttr(*split, "dtypes", &dtypes));
+  EXPECT_EQ(dtypes.size(), 2);
+
+  EXPECT_EQ(FindNode(graph_def_, "save/Assign_a")->input(1),
+            "save/RestoreV2:0");
+  EXPECT_EQ(FindNode(graph_def_, "save/Assign_b")->input(1),
+            "save/RestoreV2/split_1:0");
+  EXPECT_EQ(FindNode(graph_def_, "save/Assign_c")->input(1),
+            "save/RestoreV2/split_1:1");
+  EXPECT_THAT(FindNode(graph_def_, "save/After")->input(),
+              ElementsAre("^save/RestoreV2", "^save/RestoreV2/split_1"));
+}
+
+TEST_F(SplitRestoreOpsTest, SingleGroupIsNoOp) {
+  const GraphDef original = graph_def_;
+  TF_ASSERT_OK(SplitRestoreOps(variables_path_, 1, &graph_def_));
+  EXPECT_EQ(graph_def_.DebugString(), original.DebugString());
+}
+
+TEST_F(SplitRestoreOpsTest, SkipsTensorsMissingFromCheckpoint) {
+  NodeDef* tensor_names = graph_def_.mutable_node(1);
+  ASSERT_EQ(tensor_names->name(), "save/RestoreV2/tensor_names");
+  test::AsTensor<tstring>({"b", "a", "d"})
+      .AsProtoField((*tensor_names->mutable_attr())["value"].mutable_tensor());
+  const GraphDef original = graph_def_;
+  TF_ASSERT_OK(SplitRestoreOps(variables_path_, 2, &graph_def_));
+  EXPECT_EQ(graph_def_.DebugString(), original.DebugString());
+}
+
+TEST(SplitInitOpTest, SeparatesAssetTableInitializers) {
+  GraphDef graph_def;
+  AddNode("table", "HashTableV2", {}, &graph_def);
+  AddNode("filename", "Placeholder", {}, &graph_def);
+  AddNode("init_table", "InitializeTableFromTextFileV2",
+          {"table", "filename"}, &graph_def);
+  AddNode("v", "VariableV2", {}, &graph_def);
+  AddNode("other_table", "HashTableV2", {}, &graph_def);
+  AddNode("init_other_table", "InitializeTableFromTextFileV2",
+          {"other_table", "v"}, &graph_def);
+  AddNode("group_tables", "NoOp", {"^init_table", "^init_other_table"},
+          &graph_def);
+  AddNode("assign_v", "Assign", {"v", "filename"}, &graph_def);
+  AddNode("init", "NoOp", {"^group_tables", "^assign_v"}, &graph_def);
+
+  std::vector<string> asset_table_initializers;
+  std::vector<string> other_init_nodes;
+  TF_ASSERT_OK(SplitInitOp(graph_def, "init", &asset_table_initializers,
+                           &other_init_nodes));
+  EXPECT_THAT(asset_table_initializers, ElementsAre("init_table"));
+  EXPECT_THAT(other_init_nodes,
+              UnorderedElementsAre("init_other_table", "assign_v"));
+}
+
+TEST(SplitInitOpTest, KeepsInitOpThatIsNotNoOp) {
+  GraphDef graph_def;
+  AddNode("init", "Assign", {}, &graph_def);
+
+  std::vector<string> asset_table_initializers;
+  std::vector<string> other_init_nodes;
+  TF_ASSERT_OK(SplitInitOp(graph_def, "init", &asset_table_initializers,
+                           &other_init_nodes));
+  EXPECT_TRUE(asset_table_initializers.empty());
+  EXPECT_THAT(other_init_nodes, ElementsAre("init"));
+}
+
+TEST(SplitInitOpTest, MissingInput) {
+  GraphDef graph_def;
+  AddNode("init", "NoOp", {"^missing"}, &graph_def);
+
+  std::vector<string> asset_table_initializers;
+  std::vector<string> other_init_nodes;
+  EXPECT_FALSE(SplitInitOp(graph_def, "init", &asset_table_initializers,
+                           &other_init_nodes)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace tensorflow
@@ -137,6 +137,21 @@ TEST_F(LoaderTest, TagMatch) {
   CheckSavedModelBundle(export_dir, bundle);
 }
 
+TEST_F(LoaderTest, ParallelRestoreAndAssetTableInit) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.restore_parallelism = 4;
+  load_options.init_asset_tables_during_restore = true;
+
+  const string export_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, load_options,
+                              export_dir, {kSavedModelTagServe}, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
 TEST_F(LoaderTest, ReadMetaGraphFromSavedModel) {
   SavedModelBundle bundle;
   SessionOptions session_options;
@@ -109,6 +109,16 @@ void DumpStatsToStdout(const Stats& stats) {
   }
 }
 
+void DumpThroughputToStdout(const Stats& stats, int64_t examples_per_iter,
+                            int num_threads) {
+  const double total_examples =
+      static_cast<double>(examples_per_iter) * stats.per_iter_us.size();
+  const double examples_per_sec =
+      stats.total_us > 0 ? total_examples * 1e6 / stats.total_us : 0;
+  printf("Threads: %3d  Throughput: %12.1f examples/s  (%.1f per thread)\n",
+         num_threads, examples_per_sec, examples_per_sec / num_threads);
+}
+
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
   // If neither max_seconds or max_iters is set, stop at kDefaultMicros.
   const int64_t max_us = (options.max_micros <= 0 && options.max_iters <= 0)
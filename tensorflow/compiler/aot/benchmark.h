@@ -56,6 +56,12 @@ struct Stats {
 // form.
 void DumpStatsToStdout(const Stats& stats);
 
+// DumpThroughputToStdout printfs to stdout the throughput of a benchmark in
+// which each iteration ran `examples_per_iter` examples on `num_threads`
+// threads, as a single line that can be compared across thread counts.
+void DumpThroughputToStdout(const Stats& stats, int64_t examples_per_iter,
+                            int num_threads);
+
 // BenchmarkFn is the signature of the function generated by tfcompile.
 typedef std::function<void()> BenchmarkFn;
 
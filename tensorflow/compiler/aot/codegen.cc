@@ -467,6 +467,31 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
           ? R"(#include "tensorflow/compiler/xla/service/hlo_profile_printer_data.pb.h")"
           : "";
 
+  const string include_batch_runner =
+      opts.gen_batch_entry_point
+          ? "#include \"tensorflow/compiler/tf2xla/xla_batch_runner.h\"\n"
+          : "";
+  string batch_runner;
+  if (opts.gen_batch_entry_point) {
+    batch_runner = absl::StrReplaceAll(R"(
+  // Runs batches of independent examples in parallel on the threads of an
+  // Eigen thread pool, with one preallocated instance of this class per
+  // thread. Usage example:
+  //
+  //   {{CLASS}}::BatchRunner runner(&device);
+  //   CHECK(runner.Run(
+  //       num_examples,
+  //       [&](int64_t i, {{CLASS}}* computation) {
+  //         // ...set args for example i using computation->argN methods
+  //       },
+  //       [&](int64_t i, {{CLASS}}* computation) {
+  //         // ...read results of example i using computation->resultN methods
+  //       }));
+  using BatchRunner = ::tensorflow::TypedXlaBatchRunner<{{CLASS}}>;
+)",
+                                       {{"{{CLASS}}", opts.class_name}});
+  }
+
   // When HLO profiling is disabled we only forward declare the
   // HloProfilePrinter protobuf.  So we can only conditionally emit this code
   // calling HloProfilePrinter::profile_counters_size.
@@ -493,7 +518,7 @@ Status GenerateHeader(const CodegenOpts& opts, const tf2xla::Config& config,
 
 {{INCLUDE_XLA_DATA_PROTO}}
 {{INCLUDE_HLO_PROFILE_PRINTER_DATA_PROTO}}
-#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
+{{INCLUDE_BATCH_RUNNER}}#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace Eigen { struct ThreadPoolDevice; }
@@ -582,6 +607,7 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
 
   {{CLASS}}(const {{CLASS}}&) = delete;
   {{CLASS}}& operator=(const {{CLASS}}&) = delete;
+{{BATCH_RUNNER}}
 
   // Arg methods for managing input buffers. Buffers are in row-major order.
   // There is a set of methods for each positional argument, with the following
@@ -702,12 +728,14 @@ class {{CLASS}} final : public tensorflow::XlaCompiledCpuFunction {
       {"{{VARIABLE_NUM}}", absl::StrCat(config.variable_size())},
       {"{{ARG_INDEX_TABLE}}", absl::StrJoin(arg_index_table, ", ")},
       {"{{ASSIGN_PROFILE_COUNTERS_SIZE}}", assign_profile_counters_size},
+      {"{{BATCH_RUNNER}}\n", batch_runner},
       {"{{CLASS}}", opts.class_name},
       {"{{DECLS_FROM_OBJ_FILE}}",
        absl::StrJoin(metadata_result.header_variable_decls, "\n")},
       {"{{ENTRY}}", compile_result.entry_point},
       {"{{HLO_PROFILE_PRINTER_DATA_SHIM_EXPRESSION}}",
        metadata_result.hlo_profile_printer_data_access_shim},
+      {"{{INCLUDE_BATCH_RUNNER}}", include_batch_runner},
       {"{{INCLUDE_XLA_DATA_PROTO}}", include_xla_data_proto},
       {"{{INCLUDE_HLO_PROFILE_PRINTER_DATA_PROTO}}",
        include_hlo_profile_printer_data_proto},
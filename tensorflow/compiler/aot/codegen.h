@@ -45,6 +45,10 @@ struct CodegenOpts {
   // If true, generate program shape data for the ProgramShape method.
   bool gen_program_shape = false;
 
+  // If true, generate a BatchRunner type for running batches of examples in
+  // parallel on a thread pool.
+  bool gen_batch_entry_point = false;
+
   // If true, emit a serialized HloProfilePrinterData protobuf that can be used
   // to pretty print HLO profile counters.
   bool gen_hlo_profile_printer_data = false;
@@ -189,6 +189,7 @@ TEST(CodegenTest, Golden) {
   opts.namespaces = {"foo", "bar"};
   opts.gen_name_to_index = true;
   opts.gen_program_shape = true;
+  opts.gen_batch_entry_point = true;
   tf2xla::Config config;
   tf2xla::Feed* feed = config.add_feed();
   feed->mutable_id()->set_node_name("feed0");
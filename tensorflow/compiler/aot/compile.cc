@@ -268,6 +268,7 @@ Status Main(const MainFlags& flags) {
   CodegenOpts codegen_opts;
   codegen_opts.gen_name_to_index = flags.gen_name_to_index;
   codegen_opts.gen_program_shape = flags.gen_program_shape;
+  codegen_opts.gen_batch_entry_point = flags.gen_batch_entry_point;
   codegen_opts.target_triple = flags.target_triple;
   if (flags.cpp_class.empty()) {
     return errors::InvalidArgument("Must specify --cpp_class");
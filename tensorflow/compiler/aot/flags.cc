@@ -88,6 +88,9 @@ void AppendMainFlags(std::vector<Flag>* flag_list, MainFlags* flags) {
        "Generate name-to-index data for Lookup{Arg,Result}Index methods."},
       {"gen_program_shape", &flags->gen_program_shape,
        "Generate program shape data for the ProgramShape method."},
+      {"gen_batch_entry_point", &flags->gen_batch_entry_point,
+       "Generate a BatchRunner type for running batches of examples in "
+       "parallel on a thread pool."},
   };
   flag_list->insert(flag_list->end(), tmp.begin(), tmp.end());
 }
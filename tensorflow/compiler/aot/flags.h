@@ -51,6 +51,7 @@ struct MainFlags {
   // C++ codegen options
   bool gen_name_to_index = false;
   bool gen_program_shape = false;
+  bool gen_batch_entry_point = false;
 };
 
 // Appends to flag_list a tensorflow::Flag for each field in MainFlags.
@@ -16,8 +16,11 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 #define EIGEN_USE_CUSTOM_THREAD_POOL
 
+#include <vector>
+
 #include "absl/strings/str_split.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/compiler/tf2xla/xla_batch_runner.h"
 #include "tensorflow/compiler/xla/service/hlo_profile_printer.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/test.h"
@@ -138,6 +141,28 @@ TEST(TFCompileTest, Add_SetArg) {
   EXPECT_EQ(add.result0_data(), add.results()[0]);
 }
 
+TEST(TFCompileTest, AddBatch) {
+  Eigen::ThreadPool tp(4);
+  Eigen::ThreadPoolDevice device(&tp, tp.NumThreads());
+  TypedXlaBatchRunner<AddComp> runner(&device);
+  EXPECT_EQ(runner.num_workers(), 4);
+
+  constexpr int kNumExamples = 100;
+  std::vector<int32> results(kNumExamples, -1);
+  for (int batch = 0; batch < 2; ++batch) {
+    EXPECT_TRUE(runner.Run(
+        kNumExamples,
+        [&](int64_t i, AddComp* add) {
+          add->arg0() = i;
+          add->arg1() = batch;
+        },
+        [&](int64_t i, AddComp* add) { results[i] = add->result0(); }));
+    for (int i = 0; i < kNumExamples; ++i) {
+      EXPECT_EQ(results[i], i + batch);
+    }
+  }
+}
+
 TEST(TFCompileTest, AddWithCkpt) {
   AddWithCkptComp add;
   EXPECT_EQ(add.arg0_data(), add.arg_data(0));
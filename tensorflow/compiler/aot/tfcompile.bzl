@@ -290,6 +290,7 @@ def tf_library(
     # transforms `flags` into a variable of type `select`, and we can't call
     # `find` on such an object.
     need_xla_data_proto = flags and flags.find("--gen_program_shape") != -1
+    need_batch_runner = flags and flags.find("--gen_batch_entry_point") != -1
 
     if enable_xla_hlo_profiling:
         profiling_flags = ["--xla_hlo_profile"]
@@ -362,6 +363,8 @@ def tf_library(
             # If we're generating the program shape, we must depend on the
             # proto.
             "//tensorflow/compiler/xla:xla_data_proto_cc",
+        ] or []) + (need_batch_runner and [
+            "//tensorflow/compiler/tf2xla:xla_batch_runner",
         ] or []) + (enable_xla_hlo_profiling and [
             "//tensorflow/compiler/xla/service:hlo_profile_printer_data_cc",
         ] or []) + (include_standard_runtime_deps and [
@@ -473,6 +476,7 @@ def tf_library(
             deps = [
                 ":" + name,
                 "//tensorflow/compiler/aot:benchmark",
+                "//tensorflow/compiler/tf2xla:xla_batch_runner",
                 "//tensorflow/compiler/xla:executable_run_options",
                 "//third_party/eigen3",
             ] + if_android([
@@ -155,7 +155,15 @@ void AppendMarkForCompilationPassFlagsInternal(std::vector<Flag>* flag_list) {
       Flag("tf_xla_persistent_cache_prefix",
            &mark_for_compilation_flags->tf_xla_persistent_cache_prefix,
            "Specifies the persistance cache prefix. Default is "
-           "\"xla_compile_cache\"")};
+           "\"xla_compile_cache\""),
+      Flag("tf_xla_shape_buckets",
+           &mark_for_compilation_flags->tf_xla_shape_buckets,
+           "If non-empty, pads the leading (batch) dimension of the inputs of "
+           "auto-clustered computations up to the next bucket, and slices "
+           "the outputs back, to bound the number of compiled shapes. Either "
+           "\"pow2\" or a comma-separated list of sizes. Only clusters in "
+           "which the rows of the leading dimension are computed "
+           "independently are rewritten.")};
   flag_list->insert(flag_list->end(), new_flags.begin(), new_flags.end());
 }
 
@@ -206,6 +214,7 @@ void AllocateAndParseFlags() {
   mark_for_compilation_flags->tf_xla_disable_strict_signature_checks = false;
   mark_for_compilation_flags->tf_xla_persistent_cache_prefix =
       "xla_compile_cache";
+  mark_for_compilation_flags->tf_xla_shape_buckets = "";
 
   device_flags = new XlaDeviceFlags;
   device_flags->tf_xla_compile_on_demand = false;
@@ -273,7 +282,8 @@ void AllocateAndParseFlags() {
        Flag("tf_xla_async_compilation", &ops_flags->tf_xla_async_compilation,
             "When lazy compilation is enabled, asynchronous compilation starts "
             "the cluster compilation in the background, and the fallback path "
-            "is executed until the compilation has finished."),
+            "is executed until the compilation has finished. Clusters that "
+            "fail to compile keep using the fallback path."),
 
        Flag("tf_introduce_floating_point_jitter_to_tensors",
             setter_for_jitter_tensor_names, "",
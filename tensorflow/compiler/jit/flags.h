@@ -100,6 +100,11 @@ struct MarkForCompilationPassFlags {
 
   // Specifies the persistance cache prefix. Default is "xla_compile_cache"
   string tf_xla_persistent_cache_prefix;
+
+  // If non-empty, dimension 0 of the inputs of auto-jit clusters is padded up
+  // to one of these sizes so that fewer variants of each cluster are compiled.
+  // Either "pow2" or a comma-separated list of sizes.
+  string tf_xla_shape_buckets;
 };
 
 // Flags associated with the XLA bridge's xla_device module.
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/compiler/jit/mark_for_compilation_pass.h"
 #include "tensorflow/compiler/jit/partially_decluster_pass.h"
 #include "tensorflow/compiler/jit/report_clustering_info_pass.h"
+#include "tensorflow/compiler/jit/shape_bucketing_for_auto_jit_pass.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
 
 namespace tensorflow {
@@ -67,6 +68,11 @@ REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, 20,
 REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, 30,
                       PartiallyDeclusterPass);
 
+// ShapeBucketingForAutoJitPass inserts nodes at the cluster boundaries, so it
+// must run once the clusters are final.
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, 35,
+                      ShapeBucketingForAutoJitPass);
+
 // ReportClusteringInfoPass pass needs to run after all of the auto-clustering
 // passes have run but before encapsulation has run.  This way it can easily
 // compute a summary of the clustering decisions we made and broadcast it via
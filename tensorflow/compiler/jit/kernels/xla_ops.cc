@@ -514,7 +514,10 @@ void XlaCompileOp::Compute(OpKernelContext* ctx) {
     const Status status = CompileToLocalExecutable(
         ctx, function_, has_ref_vars_, platform_info_, args, compile_mode,
         /*may_alias_resource_update=*/false, &client, &kernel, &executable);
-    if (compile_mode != XlaCompilationCache::CompileMode::kLazy ||
+    // Clusters that XLA cannot compile run through the TF function call
+    // instead, unless compilation was required.  In asynchronous mode the
+    // error surfaces on a call after the background compilation finished.
+    if (compile_mode == XlaCompilationCache::CompileMode::kStrict ||
         status.code() != error::UNIMPLEMENTED) {
       OP_REQUIRES_OK(ctx, status);
     }
@@ -0,0 +1,607 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing_for_auto_jit_pass.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/cc/framework/scope_internal.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/shape_inference.h"
+#include "tensorflow/compiler/jit/xla_cluster_util.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/dump_graph.h"
+
+namespace tensorflow {
+namespace {
+
+// "pow2" uses the powers of two up to 2^kMaxPowerOfTwoBucketLog2.
+constexpr int kMaxPowerOfTwoBucketLog2 = 30;
+
+// Ops with one input whose output rows only depend on the same input row.
+bool IsRowwiseUnaryOp(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>({
+      "Abs", "Acos", "Acosh", "Asin", "Asinh", "Atan", "Atanh", "Cast", "Ceil",
+      "Cos", "Cosh", "Elu", "Erf", "Erfc", "Exp", "Expm1", "Floor", "Identity",
+      "Inv", "IsFinite", "IsInf", "IsNan", "LeakyRelu", "Log", "Log1p",
+      "LogicalNot", "Neg", "PreventGradient", "Reciprocal", "Relu", "Relu6",
+      "Rint", "Round", "Rsqrt", "Selu", "Sigmoid", "Sign", "Sin", "Sinh",
+      "Snapshot", "Softplus", "Softsign", "Sqrt", "Square", "StopGradient",
+      "Tan", "Tanh",
+  });
+  return kOps->contains(n.type_string());
+}
+
+// Elementwise ops with broadcasting, whose data inputs are all of their
+// inputs.
+bool IsBroadcastingElementwiseOp(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>({
+      "Add", "AddN", "AddV2", "Atan2", "BiasAdd", "Div", "DivNoNan", "Equal",
+      "FloorDiv", "FloorMod", "Greater", "GreaterEqual", "Less", "LessEqual",
+      "LogicalAnd", "LogicalOr", "Maximum", "Minimum", "Mod", "Mul", "MulNoNan",
+      "NotEqual", "Pow", "RealDiv", "SelectV2", "SquaredDifference", "Sub",
+      "TruncateDiv", "TruncateMod", "Xdivy", "Xlogy",
+  });
+  return kOps->contains(n.type_string());
+}
+
+// Ops that only compute along the dimensions after the leading one, with the
+// data in their first input and weights in their other inputs.
+bool IsRowwiseOpWithWeights(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>({
+      "AvgPool", "Conv2D", "DepthwiseConv2dNative", "MaxPool",
+  });
+  return kOps->contains(n.type_string());
+}
+
+// Ops whose second input is a constant list of the dimensions to reduce.
+bool IsReductionOp(const Node& n) {
+  static const auto* const kOps = new absl::flat_hash_set<std::string>({
+      "All", "Any", "ArgMax", "ArgMin", "Max", "Mean", "Min", "Prod", "Sum",
+  });
+  return kOps->contains(n.type_string());
+}
+
+// How a tensor in a cluster depends on the inputs being padded.
+struct BatchInfo {
+  // Indices in `ClusterInfo::sources` of the padded inputs whose leading
+  // dimension is the leading dimension of this tensor, or empty if the tensor
+  // does not depend on any padded input.
+  std::vector<int> sources;
+};
+
+struct ClusterInfo {
+  // The inputs of the cluster that are padded.
+  std::vector<std::pair<Node*, int>> sources;
+  absl::flat_hash_map<std::pair<Node*, int>, int> source_indices;
+  // The outputs of the cluster that depend on a padded input and are sliced,
+  // with the inputs they depend on.
+  struct SlicedOutput {
+    Node* node;
+    int output_index;
+    std::vector<int> sources;
+  };
+  std::vector<SlicedOutput> sliced_outputs;
+  bool rewritable = true;
+};
+
+const PartialTensorShape* GetShape(const GraphShapeInfo& shape_info,
+                                   const Node* n, int output) {
+  auto it = shape_info.find(n->name());
+  if (it == shape_info.end() || output >= it->second.size()) {
+    return nullptr;
+  }
+  return &it->second[output].shape;
+}
+
+int GetRank(const GraphShapeInfo& shape_info, const Node* n, int output) {
+  const PartialTensorShape* shape = GetShape(shape_info, n, output);
+  return shape == nullptr ? -1 : shape->dims();
+}
+
+// Returns true if the tensor with shape `shape` can be padded along its
+// leading dimension to remove a source of recompilation.
+bool IsBucketableInput(const PartialTensorShape* shape, DataType dtype) {
+  if (shape == nullptr || shape->unknown_rank() || shape->dims() == 0 ||
+      shape->dim_size(0) >= 0) {
+    return false;
+  }
+  return DataTypeIsFloating(dtype) || DataTypeIsInteger(dtype) ||
+         DataTypeIsComplex(dtype) || dtype == DT_BOOL;
+}
+
+// Reads the integer values of the Const node `n` into `values`.
+bool GetConstIntValues(const Node* n, std::vector<int64_t>* values) {
+  if (!n->IsConstant()) {
+    return false;
+  }
+  const TensorProto* proto;
+  if (!TryGetNodeAttr(n->attrs(), "value", &proto)) {
+    return false;
+  }
+  Tensor t;
+  if (!t.FromProto(*proto) ||
+      (t.dtype() != DT_INT32 && t.dtype() != DT_INT64)) {
+    return false;
+  }
+  values->clear();
+  for (int64_t i = 0; i < t.NumElements(); ++i) {
+    values->push_back(t.dtype() == DT_INT32 ? t.flat<int32>()(i)
+                                            : t.flat<int64_t>()(i));
+  }
+  return true;
+}
+
+// Returns true if `dims`, a list of dimensions of a tensor of rank `rank`,
+// does not mention the leading dimension.
+bool ExcludesLeadingDimension(const std::vector<int64_t>& dims, int rank) {
+  return absl::c_none_of(dims, [&](int64_t dim) {
+    return dim == 0 || (rank > 0 && dim == -rank);
+  });
+}
+
+// Returns true if output 0 of `n` is computed row by row along its leading
+// dimension, given the inputs of `n` and whether they depend on a padded
+// input.
+bool PreservesRows(const Node& n, const std::vector<const Edge*>& inputs,
+                   const std::vector<bool>& batched,
+                   const GraphShapeInfo& shape_info) {
+  auto rank_of = [&](int i) {
+    return GetRank(shape_info, inputs[i]->src(), inputs[i]->src_output());
+  };
+  const int num_inputs = inputs.size();
+  const int output_rank = GetRank(shape_info, &n, 0);
+  if (n.num_outputs() != 1 || output_rank < 1) {
+    return false;
+  }
+
+  if (IsRowwiseUnaryOp(n)) {
+    return true;
+  }
+  if (n.type_string() == "Softmax" || n.type_string() == "LogSoftmax") {
+    return output_rank >= 2;
+  }
+  if (IsBroadcastingElementwiseOp(n)) {
+    // Batched operands must not be broadcast along the leading dimension, and
+    // the other operands must not have a leading dimension of their own.
+    for (int i = 0; i < num_inputs; ++i) {
+      const int rank = rank_of(i);
+      if (batched[i]) {
+        if (rank != output_rank) return false;
+        continue;
+      }
+      if (rank < 0) return false;
+      if (rank == output_rank) {
+        const PartialTensorShape* shape =
+            GetShape(shape_info, inputs[i]->src(), inputs[i]->src_output());
+        if (shape->dim_size(0) != 1) return false;
+      }
+    }
+    if (n.type_string() == "BiasAdd") {
+      return !batched[1];
+    }
+    return true;
+  }
+
+  // The remaining ops have a batched data input 0 and unbatched other inputs.
+  if (num_inputs == 0 || !batched[0] ||
+      std::any_of(batched.begin() + 1, batched.end(),
+                  [](bool b) { return b; })) {
+    return false;
+  }
+  if (IsRowwiseOpWithWeights(n)) {
+    return true;
+  }
+  if (n.type_string() == "MatMul") {
+    bool transpose_a;
+    return TryGetNodeAttr(n.attrs(), "transpose_a", &transpose_a) &&
+           !transpose_a;
+  }
+  std::vector<int64_t> dims;
+  if (IsReductionOp(n)) {
+    return num_inputs == 2 && GetConstIntValues(inputs[1]->src(), &dims) &&
+           ExcludesLeadingDimension(dims, rank_of(0));
+  }
+  if (n.type_string() == "Transpose") {
+    return num_inputs == 2 && GetConstIntValues(inputs[1]->src(), &dims) &&
+           !dims.empty() && dims[0] == 0;
+  }
+  return false;
+}
+
+// Same as `PreservesRows`, for ConcatV2, whose value inputs must all depend
+// on padded inputs.
+bool ConcatPreservesRows(const Node& n, const std::vector<const Edge*>& inputs,
+                         const std::vector<bool>& batched,
+                         const GraphShapeInfo& shape_info) {
+  const int num_inputs = inputs.size();
+  const int output_rank = GetRank(shape_info, &n, 0);
+  std::vector<int64_t> axis;
+  if (num_inputs < 2 || output_rank < 1 ||
+      !GetConstIntValues(inputs.back()->src(), &axis) || axis.size() != 1 ||
+      !ExcludesLeadingDimension(axis, output_rank)) {
+    return false;
+  }
+  return std::all_of(batched.begin(), batched.end() - 1,
+                     [](bool b) { return b; });
+}
+
+// Computes the padded inputs each tensor in each cluster depends on, and
+// decides which clusters can be rewritten.
+Status AnalyzeClusters(const Graph& g, const GraphShapeInfo& shape_info,
+                       std::map<std::string, ClusterInfo>* clusters) {
+  std::vector<std::vector<BatchInfo>> batch_infos(g.num_node_ids());
+  std::vector<Node*> order;
+  GetReversePostOrder(g, &order, NodeComparatorName());
+
+  for (Node* n : order) {
+    std::optional<absl::string_view> cluster_name = GetXlaClusterForNode(*n);
+    if (!cluster_name.has_value()) continue;
+    ClusterInfo& cluster = (*clusters)[std::string(*cluster_name)];
+    if (!cluster.rewritable) continue;
+
+    std::vector<const Edge*> inputs;
+    TF_RETURN_IF_ERROR(n->input_edges(&inputs));
+    std::vector<bool> batched(inputs.size());
+    std::vector<int> sources;
+    for (int i = 0; i < inputs.size(); ++i) {
+      Node* src = inputs[i]->src();
+      const int src_output = inputs[i]->src_output();
+      if (GetXlaClusterForNode(*src) == cluster_name) {
+        const std::vector<BatchInfo>& src_infos = batch_infos[src->id()];
+        if (src_output < src_infos.size()) {
+          absl::c_copy(src_infos[src_output].sources,
+                       std::back_inserter(sources));
+          batched[i] = !src_infos[src_output].sources.empty();
+        }
+        continue;
+      }
+      if (!IsBucketableInput(GetShape(shape_info, src, src_output),
+                             src->output_type(src_output))) {
+        continue;
+      }
+      auto inserted = cluster.source_indices.emplace(
+          std::make_pair(src, src_output), cluster.sources.size());
+      if (inserted.second) {
+        cluster.sources.push_back({src, src_output});
+      }
+      sources.push_back(inserted.first->second);
+      batched[i] = true;
+    }
+    if (sources.empty()) continue;
+
+    const bool preserves_rows =
+        n->type_string() == "ConcatV2"
+            ? ConcatPreservesRows(*n, inputs, batched, shape_info)
+            : PreservesRows(*n, inputs, batched, shape_info);
+    if (!preserves_rows) {
+      VLOG(2) << "Not bucketing cluster " << *cluster_name << " because of "
+              << n->name() << " (" << n->type_string() << ")";
+      cluster.rewritable = false;
+      continue;
+    }
+    absl::c_sort(sources);
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    batch_infos[n->id()].resize(1);
+    batch_infos[n->id()][0].sources = std::move(sources);
+  }
+
+  // Find the outputs that must be sliced back to their original size.
+  for (Node* n : order) {
+    std::optional<absl::string_view> cluster_name = GetXlaClusterForNode(*n);
+    if (!cluster_name.has_value() || batch_infos[n->id()].empty()) continue;
+    ClusterInfo& cluster = (*clusters)[std::string(*cluster_name)];
+    for (const Edge* e : n->out_edges()) {
+      if (e->IsControlEdge() ||
+          GetXlaClusterForNode(*e->dst()) == cluster_name) {
+        continue;
+      }
+      // Only output 0 of the ops accepted above depends on padded inputs.
+      DCHECK_EQ(e->src_output(), 0);
+      if (cluster.sliced_outputs.empty() ||
+          cluster.sliced_outputs.back().node != n) {
+        cluster.sliced_outputs.push_back(
+            {n, e->src_output(), batch_infos[n->id()][0].sources});
+      }
+    }
+  }
+  return OkStatus();
+}
+
+// Returns a host constant with the contents of `values`, reshaped to `shape`.
+// The constant has a control dependency on `frame_node` so that it is in the
+// same frame as the tensors it is combined with.
+Output HostIntConstant(const Scope& host_scope, absl::string_view name,
+                       Node* frame_node, const std::vector<int>& values,
+                       const TensorShape& shape) {
+  Tensor t(DT_INT32, shape);
+  absl::c_copy(values, t.flat<int32>().data());
+  Output result = ops::Const(host_scope.WithOpName(name), t);
+  host_scope.graph()->AddControlEdge(frame_node, result.node());
+  return result;
+}
+
+// Returns the host device of the device `n` is assigned to, or an empty
+// string if `n` is not assigned to a device.
+std::string GetHostName(const Node& n) {
+  std::string host_name;
+  if (n.assigned_device_name().empty() ||
+      !DeviceNameUtils::DeviceNameToCpuDeviceName(n.assigned_device_name(),
+                                                  &host_name)
+           .ok()) {
+    return "";
+  }
+  return host_name;
+}
+
+// Pads the leading dimension of the inputs of `cluster` up to the next bucket
+// and slices the outputs back to their original sizes.
+Status RewriteCluster(Graph* g, const std::string& cluster_name,
+                      const ClusterInfo& cluster,
+                      const std::vector<int>& buckets,
+                      const GraphShapeInfo& shape_info) {
+  Status status;
+  Scope scope =
+      NewInternalScope(g, &status, /*refiner=*/nullptr)
+          .NewSubScope(absl::StrCat(cluster_name, "/shape_bucketing"));
+
+  // The candidate buckets, with 0 and 1 which are never padded, and a
+  // sentinel for sizes larger than the largest bucket.
+  std::vector<int> candidates = {0, 1};
+  absl::c_copy(buckets, std::back_inserter(candidates));
+  absl::c_sort(candidates);
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  const int largest_bucket = candidates.back();
+  candidates.push_back(std::numeric_limits<int32>::max());
+
+  // The original leading dimension of each padded input.
+  std::vector<Output> sizes;
+  Node* frame_node = cluster.sources[0].first;
+  for (int i = 0; i < cluster.sources.size(); ++i) {
+    Node* src = cluster.sources[i].first;
+    const int src_output = cluster.sources[i].second;
+    Scope input_scope = scope.NewSubScope(absl::StrCat("input_", i));
+    Scope src_scope =
+        input_scope.WithAssignedDevice(src->assigned_device_name());
+    Scope src_host_scope = input_scope.WithAssignedDevice(GetHostName(*src));
+    Output input(src, src_output);
+
+    Output shape = ops::Shape(src_scope.WithOpName("shape"), input);
+    Output size = ops::StridedSlice(
+        src_host_scope.WithOpName("size"), shape,
+        HostIntConstant(src_host_scope, "begin", src, {0}, TensorShape({1})),
+        HostIntConstant(src_host_scope, "end", src, {1}, TensorShape({1})),
+        HostIntConstant(src_host_scope, "strides", src, {1}, TensorShape({1})),
+        ops::StridedSlice::ShrinkAxisMask(1));
+    sizes.push_back(size);
+
+    // bucket = min(candidates[count(candidates < size)],
+    //              max(size, largest_bucket))
+    Output candidates_t = HostIntConstant(
+        src_host_scope, "candidates", src, candidates,
+        TensorShape({static_cast<int64_t>(candidates.size())}));
+    Output index = ops::Sum(
+        src_host_scope.WithOpName("bucket_index"),
+        ops::Cast(src_host_scope.WithOpName("smaller_candidates"),
+                  ops::Less(src_host_scope.WithOpName("candidate_is_smaller"),
+                            candidates_t, size),
+                  DT_INT32),
+        HostIntConstant(src_host_scope, "reduction_axis", src, {0},
+                        TensorShape({})));
+    Output bucket = ops::Minimum(
+        src_host_scope.WithOpName("bucket"),
+        ops::GatherV2(src_host_scope.WithOpName("next_candidate"),
+                      candidates_t, index,
+                      HostIntConstant(src_host_scope, "gather_axis", src, {0},
+                                      TensorShape({}))),
+        ops::Maximum(src_host_scope.WithOpName("no_padding_limit"), size,
+                     HostIntConstant(src_host_scope, "largest_bucket", src,
+                                     {largest_bucket}, TensorShape({}))));
+
+    // paddings = [[0, bucket - size], [0, 0], ...]
+    const int rank = GetRank(shape_info, src, src_output);
+    std::vector<int> padding_mask(2 * rank, 0);
+    padding_mask[1] = 1;
+    Output paddings = ops::Mul(
+        src_host_scope.WithOpName("paddings"),
+        HostIntConstant(src_host_scope, "padding_mask", src, padding_mask,
+                        TensorShape({rank, 2})),
+        ops::Sub(src_host_scope.WithOpName("padding"), bucket, size));
+    Output padded = ops::Pad(src_scope.WithOpName("padded"), input, paddings);
+    TF_RETURN_IF_ERROR(scope.status());
+
+    std::vector<const Edge*> edges_to_update;
+    for (const Edge* e : src->out_edges()) {
+      if (e->src_output() == src_output &&
+          GetXlaClusterForNode(*e->dst()) == cluster_name) {
+        edges_to_update.push_back(e);
+      }
+    }
+    for (const Edge* e : edges_to_update) {
+      TF_RETURN_IF_ERROR(
+          g->UpdateEdge(padded.node(), 0, e->dst(), e->dst_input()));
+    }
+  }
+
+  // The leading dimension of an output is the largest original size of the
+  // inputs it depends on, since the others are broadcast.
+  for (int i = 0; i < cluster.sliced_outputs.size(); ++i) {
+    const ClusterInfo::SlicedOutput& sliced_output = cluster.sliced_outputs[i];
+    Node* n = sliced_output.node;
+    Scope output_scope = scope.NewSubScope(absl::StrCat("output_", i));
+    Scope output_host_scope = output_scope.WithAssignedDevice(GetHostName(*n));
+
+    Output size = sizes[sliced_output.sources[0]];
+    for (int j = 1; j < sliced_output.sources.size(); ++j) {
+      size = ops::Maximum(output_host_scope.WithOpName("size"), size,
+                          sizes[sliced_output.sources[j]]);
+    }
+
+    // slice_size = [size, -1, -1, ...]
+    const int rank = GetRank(shape_info, n, sliced_output.output_index);
+    std::vector<int> size_mask(rank, 0);
+    size_mask[0] = 1;
+    std::vector<int> size_offset(rank, -1);
+    size_offset[0] = 0;
+    Output slice_size = ops::Add(
+        output_host_scope.WithOpName("slice_size"),
+        ops::Mul(output_host_scope.WithOpName("leading_slice_size"),
+                 HostIntConstant(output_host_scope, "size_mask", frame_node,
+                                 size_mask, TensorShape({rank})),
+                 size),
+        HostIntConstant(output_host_scope, "size_offset", frame_node,
+                        size_offset, TensorShape({rank})));
+    Output sliced = ops::Slice(
+        output_scope.WithOpName("sliced").WithAssignedDevice(
+            n->assigned_device_name()),
+        Output(n, sliced_output.output_index),
+        HostIntConstant(output_host_scope, "slice_begin", frame_node,
+                        std::vector<int>(rank, 0), TensorShape({rank})),
+        slice_size);
+    TF_RETURN_IF_ERROR(scope.status());
+
+    std::vector<const Edge*> edges_to_update;
+    for (const Edge* e : n->out_edges()) {
+      if (e->src_output() == sliced_output.output_index &&
+          GetXlaClusterForNode(*e->dst()) != cluster_name &&
+          e->dst() != sliced.node()) {
+        edges_to_update.push_back(e);
+      }
+    }
+    for (const Edge* e : edges_to_update) {
+      TF_RETURN_IF_ERROR(
+          g->UpdateEdge(sliced.node(), 0, e->dst(), e->dst_input()));
+    }
+  }
+  return status;
+}
+
+// Returns the largest relative amount of padding added by `buckets`, which is
+// reached for the sizes just above a bucket.
+double MaxPaddingOverhead(const std::vector<int>& buckets) {
+  double max_overhead = 0;
+  int previous = 1;
+  for (int bucket : buckets) {
+    if (bucket > previous + 1) {
+      max_overhead = std::max(
+          max_overhead, static_cast<double>(bucket - previous - 1) /
+                            static_cast<double>(previous + 1));
+    }
+    previous = std::max(previous, bucket);
+  }
+  return max_overhead;
+}
+
+}  // namespace
+
+StatusOr<std::vector<int>> ParseShapeBuckets(absl::string_view spec) {
+  std::vector<int> buckets;
+  if (spec == "pow2") {
+    for (int i = 0; i <= kMaxPowerOfTwoBucketLog2; ++i) {
+      buckets.push_back(1 << i);
+    }
+    return buckets;
+  }
+  for (absl::string_view bucket_str :
+       absl::StrSplit(spec, ',', absl::SkipWhitespace())) {
+    int bucket;
+    if (!absl::SimpleAtoi(bucket_str, &bucket) || bucket <= 0) {
+      return errors::InvalidArgument(
+          "Invalid --tf_xla_shape_buckets: \"", spec,
+          "\"; expected \"pow2\" or a comma-separated list of positive "
+          "sizes");
+    }
+    buckets.push_back(bucket);
+  }
+  if (buckets.empty()) {
+    return errors::InvalidArgument("Invalid --tf_xla_shape_buckets: \"", spec,
+                                   "\"");
+  }
+  absl::c_sort(buckets);
+  buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+  return buckets;
+}
+
+Status ShapeBucketingForAutoJitPass::Run(
+    const GraphOptimizationPassOptions& options) {
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  if (flags->tf_xla_shape_buckets.empty()) {
+    return OkStatus();
+  }
+  TF_ASSIGN_OR_RETURN(std::vector<int> buckets,
+                      ParseShapeBuckets(flags->tf_xla_shape_buckets));
+
+  Graph* g = options.graph->get();
+  GraphShapeInfo shape_info;
+  Status status =
+      InferShapes(g, /*arg_shapes=*/{}, options.flib_def, &shape_info);
+  if (!status.ok()) {
+    VLOG(1) << "Not bucketing shapes because shape inference failed: "
+            << status;
+    return OkStatus();
+  }
+
+  std::map<std::string, ClusterInfo> clusters;
+  TF_RETURN_IF_ERROR(AnalyzeClusters(*g, shape_info, &clusters));
+
+  bool changed = false;
+  for (const auto& it : clusters) {
+    const ClusterInfo& cluster = it.second;
+    if (!cluster.rewritable || cluster.sources.empty()) continue;
+    if (flags->tf_xla_clustering_debug && !changed) {
+      DumpGraphToFile("before_shape_bucketing_for_auto_jit_pass", *g,
+                      options.flib_def);
+    }
+    TF_RETURN_IF_ERROR(
+        RewriteCluster(g, it.first, cluster, buckets, shape_info));
+    changed = true;
+    LOG(INFO) << "Padding the leading dimension of " << cluster.sources.size()
+              << " input(s) of XLA cluster " << it.first << " to at most "
+              << buckets.size() << " sizes up to " << buckets.back()
+              << "; padding adds at most "
+              << static_cast<int>(100 * MaxPaddingOverhead(buckets))
+              << "% to the work of the cluster";
+  }
+
+  if (changed) {
+    // We've added constants to the graph; hook them up to _SOURCE.
+    FixupSourceAndSinkEdges(g);
+    if (flags->tf_xla_clustering_debug) {
+      DumpGraphToFile("shape_bucketing_for_auto_jit_pass", *g,
+                      options.flib_def);
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace tensorflow
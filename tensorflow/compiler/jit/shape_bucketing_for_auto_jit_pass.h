@@ -0,0 +1,59 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
+#define TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+
+namespace tensorflow {
+
+// Bounds the number of executables compiled for an auto-jit cluster whose
+// leading (batch) dimension changes from step to step, by padding that
+// dimension up to one of the sizes listed in --tf_xla_shape_buckets:
+//
+//   y = cluster(x)
+//     =>
+//   y = Slice(cluster(Pad(x, [[0, bucket(b) - b], [0, 0], ...])), 0, b)
+//
+// where `b` is the leading dimension of `x` and `bucket(b)` is the smallest
+// bucket no smaller than `b`.  Sizes 0 and 1, and sizes larger than the
+// largest bucket, are not padded.  The Pad and Slice nodes are placed outside
+// the cluster, so XLA only ever sees bucketed shapes.
+//
+// Padding is only correct if the rows along the leading dimension are
+// computed independently of each other, so a cluster is only rewritten if
+// every node that depends on a padded input is known to preserve this, e.g.
+// elementwise ops, MatMul against weights, convolutions, and reductions over
+// the other dimensions.  Anything else (a reduction over the batch, a
+// Reshape, a stateful op, ...) leaves the cluster unchanged.
+//
+// Must run after PartiallyDeclusterPass, since the cluster boundaries must
+// not change after the Slice nodes were inserted.
+class ShapeBucketingForAutoJitPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+// Parses the value of --tf_xla_shape_buckets, either "pow2" or a
+// comma-separated list of positive sizes, into a sorted list of sizes.
+StatusOr<std::vector<int>> ParseShapeBuckets(absl::string_view spec);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_JIT_SHAPE_BUCKETING_FOR_AUTO_JIT_PASS_H_
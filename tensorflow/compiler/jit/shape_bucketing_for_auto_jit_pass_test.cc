@@ -0,0 +1,239 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/jit/shape_bucketing_for_auto_jit_pass.h"
+
+#include <limits>
+
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/compiler/jit/flags.h"
+#include "tensorflow/compiler/jit/node_matchers.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+using ::testing::Contains;
+using ::testing::Not;
+using testing::matchers::AssignedDevice;
+using testing::matchers::Const;
+using testing::matchers::Inputs;
+using testing::matchers::Name;
+using testing::matchers::NodeWith;
+using testing::matchers::Op;
+using testing::matchers::Out;
+
+const char* kHostName = "/job:worker/replica:0/task:0/device:CPU:0";
+const char* kDeviceName = "/job:worker/replica:0/task:0/device:GPU:0";
+
+Status BucketShapesForAutoJit(const Scope& s, absl::string_view buckets,
+                              std::unique_ptr<Graph>* result) {
+  auto graph = std::make_unique<Graph>(OpRegistry::Global());
+  FunctionLibraryDefinition flib_def(OpRegistry::Global(), {});
+  GraphOptimizationPassOptions options;
+  options.graph = &graph;
+  options.flib_def = &flib_def;
+
+  // Scope::ToGraph drops assigned devices, so explicitly maintain the device
+  // assignment.
+  std::unordered_map<string, string> assigned_device_names;
+  for (Node* n : s.graph()->nodes()) {
+    assigned_device_names[n->name()] = n->assigned_device_name();
+  }
+  TF_RETURN_IF_ERROR(s.ToGraph(graph.get()));
+  for (Node* n : graph->nodes()) {
+    n->set_assigned_device_name(assigned_device_names[n->name()]);
+  }
+
+  MarkForCompilationPassFlags* flags = GetMarkForCompilationPassFlags();
+  const string old_buckets = flags->tf_xla_shape_buckets;
+  flags->tf_xla_shape_buckets = string(buckets);
+  ShapeBucketingForAutoJitPass rewriter;
+  Status status = rewriter.Run(options);
+  flags->tf_xla_shape_buckets = old_buckets;
+  *result = std::move(graph);
+  return status;
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, PadsInputsAndSlicesOutputs) {
+  Scope root = Scope::NewRootScope().ExitOnError().WithAssignedDevice(
+      kDeviceName);
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output weights = ops::Const(cluster.WithOpName("weights"), 1.0f, {4, 3});
+  Output bias = ops::Const(cluster.WithOpName("bias"), {1.0f, 2.0f, 3.0f});
+  Output matmul = ops::MatMul(cluster.WithOpName("matmul"), input, weights);
+  Output bias_add =
+      ops::BiasAdd(cluster.WithOpName("bias_add"), matmul, bias);
+  Output relu = ops::Relu(cluster.WithOpName("relu"), bias_add);
+  Output output = ops::Identity(root.WithOpName("output"), relu);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "16,8", &result));
+
+  const int32 max_int32 = std::numeric_limits<int32>::max();
+  auto m_input = Out(NodeWith(Op("Placeholder"), Name("input")));
+  auto m_size = Out(NodeWith(
+      Op("StridedSlice"), AssignedDevice(kHostName),
+      Inputs(Out(NodeWith(Op("Shape"), AssignedDevice(kDeviceName),
+                          Inputs(m_input))),
+             Const({0}), Const({1}), Const({1}))));
+  auto m_bucket = Out(NodeWith(Op("Minimum"), AssignedDevice(kHostName)));
+  auto m_paddings = Out(NodeWith(
+      Op("Mul"), Inputs(Const(Input::Initializer({0, 1, 0, 0}, {2, 2})),
+                        Out(NodeWith(Op("Sub"), Inputs(m_bucket, m_size))))));
+  auto m_padded = Out(NodeWith(Op("Pad"), AssignedDevice(kDeviceName),
+                               Inputs(m_input, m_paddings)));
+
+  Node* matmul_node = testing::FindNodeByName(result.get(), "matmul");
+  ASSERT_NE(matmul_node, nullptr);
+  EXPECT_THAT(matmul_node,
+              NodeWith(Inputs(m_padded, Out(NodeWith(Name("weights"))))));
+
+  Node* candidates = testing::FindNodeByName(
+      result.get(), "cluster_0/shape_bucketing/input_0/candidates");
+  ASSERT_NE(candidates, nullptr);
+  EXPECT_THAT(candidates, NodeWith(testing::matchers::ConstantValue(
+                              {0, 1, 8, 16, max_int32})));
+
+  Node* output_node = testing::FindNodeByName(result.get(), "output");
+  ASSERT_NE(output_node, nullptr);
+  EXPECT_THAT(
+      output_node,
+      NodeWith(Inputs(Out(NodeWith(
+          Op("Slice"), AssignedDevice(kDeviceName),
+          Inputs(Out(NodeWith(Name("relu"))), Const({0, 0}),
+                 Out(NodeWith(Op("Add"),
+                              Inputs(Out(NodeWith(Op("Mul"),
+                                                  Inputs(Const({1, 0}),
+                                                         m_size))),
+                                     Const({0, -1}))))))))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, DisabledByDefault) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output relu = ops::Relu(cluster.WithOpName("relu"), input);
+  Output output = ops::Identity(root.WithOpName("output"), relu);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "", &result));
+  EXPECT_THAT(result->nodes(), Not(Contains(NodeWith(Op("Pad")))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, ReductionOverBatchIsNotBucketed) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output relu = ops::Relu(cluster.WithOpName("relu"), input);
+  Output sum = ops::Sum(cluster.WithOpName("sum"), relu,
+                        ops::Const(cluster.WithOpName("axis"), {0}));
+  Output output = ops::Identity(root.WithOpName("output"), sum);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "pow2", &result));
+  EXPECT_THAT(result->nodes(), Not(Contains(NodeWith(Op("Pad")))));
+  EXPECT_THAT(result->nodes(), Not(Contains(NodeWith(Op("Slice")))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, ReductionOverOtherDimsIsBucketed) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output sum = ops::Sum(cluster.WithOpName("sum"), input,
+                        ops::Const(cluster.WithOpName("axis"), {-1}));
+  Output output = ops::Identity(root.WithOpName("output"), sum);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "pow2", &result));
+  Node* sum_node = testing::FindNodeByName(result.get(), "sum");
+  ASSERT_NE(sum_node, nullptr);
+  EXPECT_THAT(sum_node, NodeWith(Inputs(Out(NodeWith(Op("Pad"))),
+                                        Out(NodeWith(Name("axis"))))));
+  Node* output_node = testing::FindNodeByName(result.get(), "output");
+  ASSERT_NE(output_node, nullptr);
+  EXPECT_THAT(output_node, NodeWith(Inputs(Out(NodeWith(Op("Slice"))))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, StaticShapesAreNotBucketed) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({5, 4})));
+  Output relu = ops::Relu(cluster.WithOpName("relu"), input);
+  Output output = ops::Identity(root.WithOpName("output"), relu);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "pow2", &result));
+  EXPECT_THAT(result->nodes(), Not(Contains(NodeWith(Op("Pad")))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, BroadcastAlongBatchIsNotBucketed) {
+  Scope root = Scope::NewRootScope().ExitOnError();
+  Scope cluster = root.WithXlaCluster("cluster_0");
+
+  // `other` has a leading dimension of its own, which `input` may be
+  // broadcast against.
+  Output input = ops::Placeholder(
+      root.WithOpName("input"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({-1, 4})));
+  Output other = ops::Placeholder(
+      root.WithOpName("other"), DT_FLOAT,
+      ops::Placeholder::Shape(PartialTensorShape({3, 4})));
+  Output add = ops::Add(cluster.WithOpName("add"), input, other);
+  Output output = ops::Identity(root.WithOpName("output"), add);
+
+  std::unique_ptr<Graph> result;
+  TF_ASSERT_OK(BucketShapesForAutoJit(root, "pow2", &result));
+  EXPECT_THAT(result->nodes(), Not(Contains(NodeWith(Op("Pad")))));
+}
+
+TEST(ShapeBucketingForAutoJitPassTest, ParseShapeBuckets) {
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<int> buckets,
+                          ParseShapeBuckets("32, 8,16,8"));
+  EXPECT_EQ(buckets, std::vector<int>({8, 16, 32}));
+
+  TF_ASSERT_OK_AND_ASSIGN(buckets, ParseShapeBuckets("pow2"));
+  EXPECT_EQ(buckets.front(), 1);
+  EXPECT_EQ(buckets[3], 8);
+
+  EXPECT_FALSE(ParseShapeBuckets("8,x").ok());
+  EXPECT_FALSE(ParseShapeBuckets("0").ok());
+  EXPECT_FALSE(ParseShapeBuckets(",").ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
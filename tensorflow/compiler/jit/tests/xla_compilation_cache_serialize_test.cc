@@ -13,10 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/compiler/jit/flags.h"
 #include "tensorflow/compiler/jit/mark_for_compilation_pass.h"
 #include "tensorflow/compiler/jit/tests/xla_compilation_cache_test_helper.h"
+#include "tensorflow/compiler/jit/xla_compilation_cache.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace tensorflow {
 namespace {
@@ -33,6 +38,25 @@ TEST_F(XlaCompilationCacheSerializeTest, PersistentCacheTest) {
   TF_ASSERT_OK(
       listener()->VerifyListenerHistory(/*expect_persistent_cache_use=*/false));
 
+  // The entries are keyed by the compiler and the device they were compiled
+  // for, so that other versions of TensorFlow never load them.
+  std::vector<string> file_names;
+  TF_ASSERT_OK(
+      Env::Default()->GetChildren(tensorflow::testing::TmpDir(), &file_names));
+  int num_entries = 0;
+  for (const string& file_name : file_names) {
+    if (!absl::EndsWith(file_name, ".pb")) continue;
+    XlaSerializedCacheEntry entry;
+    TF_ASSERT_OK(ReadBinaryProto(
+        Env::Default(), io::JoinPath(tensorflow::testing::TmpDir(), file_name),
+        &entry));
+    EXPECT_NE(entry.key().compiler_fingerprint(), 0);
+    EXPECT_TRUE(absl::EndsWith(
+        file_name, absl::StrCat(entry.key().compiler_fingerprint(), ".pb")));
+    ++num_entries;
+  }
+  EXPECT_GT(num_entries, 0);
+
   // Reset the cluster numbering between sessions so we can get the same
   // cluster numbering.
   testing::ResetClusterSequenceNumber();
@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/compiler.h"
 #include "tensorflow/compiler/xla/service/hlo.pb.h"
 #include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/compiler/xla/stream_executor/host/host_platform_id.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -57,6 +58,7 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/fingerprint.h"
@@ -140,7 +142,35 @@ std::string XlaSerializedCacheKeyToString(const XlaSerializedCacheKey& key) {
       key.prefix(), key.prefix().empty() ? "" : kXlaSerializedCacheKeySeparator,
       key.signature_fingerprint(), kXlaSerializedCacheKeySeparator,
       key.cluster_fingerprint(), kXlaSerializedCacheKeySeparator,
-      key.device_type());
+      key.device_type(), kXlaSerializedCacheKeySeparator,
+      key.compiler_fingerprint());
+}
+
+// Returns a fingerprint of what the compiled executables depend on besides
+// the HLO module: the version of the compiler, and the device. Executables
+// compiled for the host also depend on the instruction set of the CPU.
+uint64 ComputeCompilerFingerprint(xla::LocalClient* client) {
+  uint64 fingerprint = Fingerprint64(TF_VERSION_STRING);
+  if (client == nullptr) return fingerprint;
+  fingerprint =
+      FingerprintCat64(fingerprint, Fingerprint64(client->platform()->Name()));
+  const se::StreamExecutor* executor =
+      client->backend().default_stream_executor();
+  if (executor != nullptr) {
+    const se::DeviceDescription& description =
+        executor->GetDeviceDescription();
+    fingerprint =
+        FingerprintCat64(fingerprint, Fingerprint64(description.name()));
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(description.platform_version()));
+  }
+  if (client->platform()->id() == se::host::kHostPlatformId) {
+    fingerprint = FingerprintCat64(
+        fingerprint, Fingerprint64(absl::StrCat(port::CPUVendorIDString(), ":",
+                                                port::CPUFamily(), ":",
+                                                port::CPUModelNum())));
+  }
+  return fingerprint;
 }
 
 }  // namespace
@@ -158,7 +188,8 @@ XlaCompilationCache::XlaCompilationCache(Config config,
       device_type_(std::move(device_type)),
       disable_strict_signature_checks_(config.disable_strict_signature_checks),
       persistance_prefix_(config.persistance_prefix),
-      persistent_cache_directory_(config.persistent_cache_directory) {}
+      persistent_cache_directory_(config.persistent_cache_directory),
+      compiler_fingerprint_(ComputeCompilerFingerprint(client)) {}
 
 XlaCompilationCache::~XlaCompilationCache() {
   // Ensure any use of our programs have completed by waiting for all stream
@@ -809,6 +840,7 @@ XlaSerializedCacheKey XlaCompilationCache::BuildSerializedCacheKey(
       DeterministicProtoHash64(hlo_module));
   serialized_cache_key.set_device_type(device_type_.type_string());
   serialized_cache_key.set_prefix(persistance_prefix_);
+  serialized_cache_key.set_compiler_fingerprint(compiler_fingerprint_);
   return serialized_cache_key;
 }
 
@@ -891,7 +923,17 @@ Status XlaCompilationCache::SaveSerializedEntry(
   TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(persistent_cache_directory_));
   const std::string file_path =
       GetFilePath(entry.key(), persistent_cache_directory_);
-  return WriteBinaryProto(env, file_path, entry);
+  // Write to a temporary file and rename it, so that processes sharing the
+  // directory never load a partially written entry.
+  std::string temp_path = absl::StrCat(file_path, ".");
+  if (!env->CreateUniqueFileName(&temp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            file_path);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, temp_path, entry));
+  Status status = env->RenameFile(temp_path, file_path);
+  if (!status.ok()) env->DeleteFile(temp_path).IgnoreError();
+  return status;
 }
 
 StatusOr<std::optional<XlaSerializedCacheEntry>>
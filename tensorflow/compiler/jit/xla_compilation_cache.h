@@ -313,6 +313,10 @@ class XlaCompilationCache : public ResourceBase {
   // specified file system directory path.
   std::string persistent_cache_directory_;
 
+  // Fingerprint of the compiler and the device, which is part of the keys of
+  // the persisted entries.
+  const uint64 compiler_fingerprint_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
 
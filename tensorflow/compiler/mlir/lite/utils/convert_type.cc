@@ -51,6 +51,8 @@ tflite::TensorType ConvertTypeToTensorType(mlir::Type type) {
     switch (itype.getWidth()) {
       case 1:
         return tflite::TensorType_BOOL;
+      case 4:
+        return tflite::TensorType_INT4;
       case 8:
         if (itype.isUnsigned())
           return tflite::TensorType_UINT8;
@@ -102,6 +104,8 @@ mlir::Type ConvertElementType(tflite::TensorType type, mlir::Builder builder) {
       return mlir::ComplexType::get(builder.getF64Type());
     case tflite::TensorType_INT8:
       return builder.getIntegerType(8);
+    case tflite::TensorType_INT4:
+      return builder.getIntegerType(4);
     case tflite::TensorType_UINT64:
       return builder.getIntegerType(64, /*isSigned=*/false);
     case tflite::TensorType_RESOURCE:
@@ -127,6 +131,9 @@ tensorflow::DataType TflTypeToTfType(tflite::TensorType type) {
       return tensorflow::DT_DOUBLE;
     case tflite::TensorType_INT8:
       return tensorflow::DT_INT8;
+    case tflite::TensorType_INT4:
+      // TensorFlow has no 4-bit type, so int4 values are widened to int8.
+      return tensorflow::DT_INT8;
     case tflite::TensorType_INT16:
       return tensorflow::DT_INT16;
     case tflite::TensorType_INT32:
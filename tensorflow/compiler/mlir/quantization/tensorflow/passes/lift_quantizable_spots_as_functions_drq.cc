@@ -27,6 +27,7 @@ limitations under the License.
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/lite/quantization/quantization_utils.h"
 #include "tensorflow/compiler/mlir/quantization/tensorflow/ops/tf_op_quant_spec.h"
+#include "tensorflow/compiler/mlir/quantization/tensorflow/passes/passes.h"
 #include "tensorflow/compiler/mlir/quantization/tensorflow/utils/lift_as_function_call_utils.h"
 #include "tensorflow/compiler/mlir/tensorflow/ir/tf_dialect.h"
 #include "tensorflow/compiler/mlir/tensorflow/ir/tf_ops.h"
@@ -47,13 +48,15 @@ class LiftQuantizableSpotsAsFunctionsDRQPass
 
   // Constructor used by manually creating the pass.
   explicit LiftQuantizableSpotsAsFunctionsDRQPass(
-      int min_num_elements_for_weights) {
+      int min_num_elements_for_weights, OpSet target_opset) {
     min_num_elements_for_weights_ = min_num_elements_for_weights;
+    target_opset_ = target_opset;
   }
 
   LiftQuantizableSpotsAsFunctionsDRQPass(
       const LiftQuantizableSpotsAsFunctionsDRQPass& other) {
     min_num_elements_for_weights_ = other.min_num_elements_for_weights_;
+    target_opset_ = other.target_opset_;
   }
 
   StringRef getArgument() const final {
@@ -78,15 +81,26 @@ class LiftQuantizableSpotsAsFunctionsDRQPass
       *this, "min-num-elements-for-weights", llvm::cl::init(0),
       llvm::cl::desc("The minimum required number of elements in a weight "
                      "array to apply quantization.")};
+
+  Option<OpSet> target_opset_{
+      *this, "target-opset", llvm::cl::init(OpSet::TF),
+      llvm::cl::desc("Choose target opset."),
+      llvm::cl::values(
+          clEnumValN(OpSet::TF, "TF",
+                     "Uses TF ops that mimic quantization behavior"),
+          clEnumValN(OpSet::UNIFORM_QUANTIZED, "UNIFORM_QUANTIZED",
+                     "Uses TF Uniform Quantized ops"))};
 };
 
 class CheckQuantizableOps
     : public mlir::OpRewritePattern<TF::PartitionedCallOp> {
  public:
   explicit CheckQuantizableOps(MLIRContext* context,
-                               int min_num_elements_for_weights)
+                               int min_num_elements_for_weights,
+                               OpSet target_opset)
       : OpRewritePattern<TF::PartitionedCallOp>(context),
-        min_num_elements_for_weights_(min_num_elements_for_weights) {}
+        min_num_elements_for_weights_(min_num_elements_for_weights),
+        target_opset_(target_opset) {}
 
  private:
   LogicalResult matchAndRewrite(TF::PartitionedCallOp call_op,
@@ -94,6 +108,18 @@ class CheckQuantizableOps
     std::unique_ptr<OpQuantSpec> spec = GetTFOpQuantSpec(call_op);
     if (spec->quantizable_operands.empty()) return failure();
 
+    // The uniform quantized opset only has a quantized function for MatMul.
+    StringRef function_name =
+        call_op.fAttr().cast<FlatSymbolRefAttr>().getValue();
+    if (target_opset_ == OpSet::UNIFORM_QUANTIZED &&
+        !function_name.contains("matmul")) {
+      call_op.emitRemark("Quantization is skipped for ")
+          << function_name.str() << " because it is not supported by the "
+          << "UNIFORM_QUANTIZED opset.";
+      call_op->removeAttr(kQuantTraitAttrName);
+      return failure();
+    }
+
     for (auto idx : spec->quantizable_operands) {
       // This op is guaranteed to be a constant as ODS checks IsConstTensor.
       // Check if the number of elements meets the requirement.
@@ -112,6 +138,7 @@ class CheckQuantizableOps
   }
 
   int min_num_elements_for_weights_;
+  OpSet target_opset_;
 };
 
 static PassRegistration<LiftQuantizableSpotsAsFunctionsDRQPass> pass;
@@ -124,7 +151,8 @@ void LiftQuantizableSpotsAsFunctionsDRQPass::runOnOperation() {
   ModuleOp module = getOperation();
 
   populateWithGenerated(patterns);
-  patterns.add<CheckQuantizableOps>(ctx, min_num_elements_for_weights_);
+  patterns.add<CheckQuantizableOps>(ctx, min_num_elements_for_weights_,
+                                    target_opset_);
   FrozenRewritePatternSet frozen_patterns(std::move(patterns));
   for (auto func : module.getOps<func::FuncOp>()) {
     if (failed(applyPatternsAndFoldGreedily(func, frozen_patterns))) {
@@ -138,9 +166,10 @@ void LiftQuantizableSpotsAsFunctionsDRQPass::runOnOperation() {
 }  // namespace
 
 std::unique_ptr<OperationPass<ModuleOp>>
-CreateLiftQuantizableSpotsAsFunctionsDRQPass(int min_num_elements_for_weights) {
+CreateLiftQuantizableSpotsAsFunctionsDRQPass(int min_num_elements_for_weights,
+                                             OpSet target_opset) {
   return std::make_unique<LiftQuantizableSpotsAsFunctionsDRQPass>(
-      min_num_elements_for_weights);
+      min_num_elements_for_weights, target_opset);
 }
 
 }  // namespace quant
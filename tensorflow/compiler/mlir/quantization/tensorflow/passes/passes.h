@@ -42,9 +42,12 @@ CreateLiftQuantizableSpotsAsFunctionsPass();
 // lifting.
 std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareLiftingPass();
 
-// Lifts the dynamic range quantizable spots as composite functions.
+// Lifts the dynamic range quantizable spots as composite functions. Spots that
+// have no quantized function for `target_opset` are lifted but left
+// unquantized.
 std::unique_ptr<OperationPass<ModuleOp>>
-CreateLiftQuantizableSpotsAsFunctionsDRQPass(int min_num_elements_for_weights);
+CreateLiftQuantizableSpotsAsFunctionsDRQPass(int min_num_elements_for_weights,
+                                             OpSet target_opset = OpSet::TF);
 
 // Replaces tf.CustomAggregator ops with quant.Stats ops for finalizing the
 // calibration procedure.
@@ -66,8 +69,11 @@ CreateInsertCustomAggregationOpsPass();
 // Replaces composite functions with quantized composite functions. After this
 // pass runs, functions in the given graph will be replaced with their quantized
 // versions. By doing so, the quantization will be applied to the given input.
+// `enable_per_channel_quantization` is only supported for dynamic range
+// quantization with the TF opset.
 std::unique_ptr<OperationPass<ModuleOp>> CreateQuantizeCompositeFunctionsPass(
-    QuantizationMethod quantization_method, OpSet target_opset = OpSet::TF);
+    QuantizationMethod quantization_method, OpSet target_opset = OpSet::TF,
+    bool enable_per_channel_quantization = false);
 
 // Converts dequantize-(quantizable) call-quantize pattern to a single call op
 // that has quantized input and output types. It is expected for this pass to
@@ -89,6 +95,11 @@ std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareQuantizePass(
 // perfrom similar transformations as TFL::PrepareQuantizeDynamicRangePass.
 std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareQuantizeDRQPass();
 
+// Overloading of CreatePrepareQuantizeDRQPass which takes QuantizationSpecs.
+// The weights are quantized per channel unless `disable_per_channel` is set.
+std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareQuantizeDRQPass(
+    const QuantizationSpecs& quant_specs);
+
 // Creates an instance of the PostQuantize pass, which will remove unnecessary
 // ops from the final quantized graph.
 std::unique_ptr<OperationPass<func::FuncOp>> CreatePostQuantizePass();
@@ -25,6 +25,7 @@ limitations under the License.
 #include "mlir/Dialect/Quant/QuantOps.h"  // from @llvm-project
 #include "mlir/Dialect/Quant/QuantTypes.h"  // from @llvm-project
 #include "mlir/IR/Operation.h"  // from @llvm-project
+#include "mlir/IR/SymbolTable.h"  // from @llvm-project
 #include "mlir/Pass/Pass.h"  // from @llvm-project
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"  // from @llvm-project
 #include "tensorflow/compiler/mlir/lite/quantization/ir/QuantOps.h"
@@ -64,7 +65,14 @@ class PrepareQuantizeDRQPass
 
   // Constructor used by manually creating the pass.
   explicit PrepareQuantizeDRQPass(const QuantizationSpecs& quant_specs)
-      : quant_specs_(quant_specs) {}
+      : quant_specs_(quant_specs) {
+    enable_per_channel_quantization_ = !quant_specs.disable_per_channel;
+  }
+
+  PrepareQuantizeDRQPass(const PrepareQuantizeDRQPass& other) {
+    quant_specs_ = other.quant_specs_;
+    enable_per_channel_quantization_ = other.enable_per_channel_quantization_;
+  }
 
   StringRef getArgument() const final {
     // This is the argument used to refer to the pass in
@@ -86,10 +94,15 @@ class PrepareQuantizeDRQPass
 
  private:
   QuantizationSpecs quant_specs_;
+
+  Option<bool> enable_per_channel_quantization_{
+      *this, "enable-per-channel-quantization", llvm::cl::init(false),
+      llvm::cl::desc("Whether to quantize the weights with a scale for each "
+                     "output channel.")};
 };
 
 // If the weight is applicable to dynamic range quantization, insert Quantize
-// and Dequantize ops with per-tensor scale.
+// and Dequantize ops with per-tensor or per-channel scales.
 class PrepareDRQQuantizableOp : public OpRewritePattern<arith::ConstantOp> {
  public:
   explicit PrepareDRQQuantizableOp(MLIRContext* context,
@@ -141,7 +154,46 @@ class PrepareDRQQuantizableOp : public OpRewritePattern<arith::ConstantOp> {
     return !quantizable_ops.empty();
   }
 
-  // Apply per-tensor quantization for int8 dynamic range quantization.
+  // Returns true if `op` calls a function whose MatMul takes the transposed
+  // weight.
+  bool hasTransposedMatMulWeight(Operation* op) const {
+    auto call_op = dyn_cast<TF::PartitionedCallOp>(op);
+    if (!call_op) return false;
+    auto func = dyn_cast_or_null<func::FuncOp>(
+        SymbolTable::lookupNearestSymbolFrom(call_op, call_op.fAttr()));
+    if (!func) return false;
+    bool transposed = false;
+    func.walk([&](TF::MatMulOp matmul_op) {
+      transposed |= matmul_op.transpose_b();
+    });
+    return transposed;
+  }
+
+  // Returns the dimension of the weight along which the scales are computed
+  // for per-channel quantization, or -1 if the weight should be quantized per
+  // tensor.
+  int getPerChannelQuantDim(arith::ConstantOp op,
+                            std::pair<Operation*, int> quant_op) const {
+    if (quant_specs_.disable_per_channel) return -1;
+
+    auto type = op.getType().cast<ShapedType>();
+    if (!type.hasRank() || type.getRank() == 0) return -1;
+
+    std::unique_ptr<OpQuantSpec> spec = GetTFOpQuantSpec(quant_op.first);
+    auto it = spec->coeff_op_quant_dim.find(quant_op.second);
+    if (it == spec->coeff_op_quant_dim.end()) return -1;
+    const int quant_dim = it->second < 0 ? type.getRank() - 1 : it->second;
+    if (quant_dim >= type.getRank()) return -1;
+
+    // The quantized functions broadcast the scales along the last dimension
+    // of the weight, which is the reduction dimension of a transposed MatMul
+    // weight.
+    if (hasTransposedMatMulWeight(quant_op.first)) return -1;
+    return quant_dim;
+  }
+
+  // Apply per-tensor or per-channel quantization for int8 dynamic range
+  // quantization.
   bool quantizeOpAsInt8(PatternRewriter& rewriter, arith::ConstantOp op,
                         std::pair<Operation*, int> quant_op) const {
     bool is_narrow_range = true;
@@ -153,10 +205,18 @@ class PrepareDRQQuantizableOp : public OpRewritePattern<arith::ConstantOp> {
     DenseFPElementsAttr attr;
     if (!matchPattern(op->getResult(0), m_Constant(&attr))) return false;
 
-    quant_type = quant::GetUniformQuantizedTypeForWeight(
-                     attr, is_narrow_range && is_signed, bit_width, is_signed,
-                     is_narrow_range, is_legacy_float)
-                     .template dyn_cast<quant::QuantizedType>();
+    const int quant_dim = getPerChannelQuantDim(op, quant_op);
+    if (quant_dim >= 0) {
+      quant_type = quant::GetUniformQuantizedPerAxisTypeForWeight(
+                       attr, quant_dim, is_narrow_range && is_signed, bit_width,
+                       is_signed, is_narrow_range, is_legacy_float)
+                       .template dyn_cast<quant::QuantizedType>();
+    } else {
+      quant_type = quant::GetUniformQuantizedTypeForWeight(
+                       attr, is_narrow_range && is_signed, bit_width, is_signed,
+                       is_narrow_range, is_legacy_float)
+                       .template dyn_cast<quant::QuantizedType>();
+    }
 
     return insertQDQ(rewriter, op, quant_type, quant_op);
   }
@@ -226,6 +286,7 @@ void PrepareQuantizeDRQPass::runOnOperation() {
   MLIRContext* ctx = func.getContext();
 
   removeAllStatsOp(func);
+  quant_specs_.disable_per_channel = !enable_per_channel_quantization_;
 
   RewritePatternSet patterns(&getContext());
   populateWithGenerated(patterns);
@@ -241,6 +302,11 @@ std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareQuantizeDRQPass() {
   return std::make_unique<PrepareQuantizeDRQPass>();
 }
 
+std::unique_ptr<OperationPass<func::FuncOp>> CreatePrepareQuantizeDRQPass(
+    const QuantizationSpecs& quant_specs) {
+  return std::make_unique<PrepareQuantizeDRQPass>(quant_specs);
+}
+
 static PassRegistration<PrepareQuantizeDRQPass> pass;
 
 }  // namespace quant
@@ -65,14 +65,17 @@ class QuantizeCompositeFunctionsPass
   explicit QuantizeCompositeFunctionsPass() {}
 
   explicit QuantizeCompositeFunctionsPass(
-      QuantizationMethod quantization_method, OpSet target_opset) {
+      QuantizationMethod quantization_method, OpSet target_opset,
+      bool enable_per_channel_quantization) {
     quantization_method_ = quantization_method;
     target_opset_ = target_opset;
+    enable_per_channel_quantization_ = enable_per_channel_quantization;
   }
 
   QuantizeCompositeFunctionsPass(const QuantizeCompositeFunctionsPass& other) {
     quantization_method_ = other.quantization_method_;
     target_opset_ = other.target_opset_;
+    enable_per_channel_quantization_ = other.enable_per_channel_quantization_;
   }
 
   StringRef getArgument() const final {
@@ -113,6 +116,11 @@ class QuantizeCompositeFunctionsPass
           clEnumValN(OpSet::XLA, "XLA", "Uses TF XLA ops"),
           clEnumValN(OpSet::UNIFORM_QUANTIZED, "UNIFORM_QUANTIZED",
                      "Uses TF Uniform Quantized ops"))};
+  Option<bool> enable_per_channel_quantization_{
+      *this, "enable-per-channel-quantization", llvm::cl::init(false),
+      llvm::cl::desc("Whether to quantize the weights per channel. Only "
+                     "supported for dynamic range quantization with the TF "
+                     "opset.")};
 };
 
 LogicalResult CreateUniformQuantizedTypeParams(UniformQuantizedType qtype,
@@ -769,7 +777,11 @@ void QuantizeCompositeFunctionsPass::runOnOperation() {
   if (quantization_method_ == QuantizationMethod::kDynamicRangeQuantization) {
     quant_specs.weight_quantization = true;
     quant_specs.inference_type = tensorflow::DT_QINT8;
-    pm.addNestedPass<func::FuncOp>(CreatePrepareQuantizeDRQPass());
+    // The uniform quantized ops take the quantization axis as an attribute,
+    // which the quantized functions do not set yet.
+    quant_specs.disable_per_channel =
+        !enable_per_channel_quantization_ || target_opset_ != OpSet::TF;
+    pm.addNestedPass<func::FuncOp>(CreatePrepareQuantizeDRQPass(quant_specs));
   } else {
     pm.addNestedPass<func::FuncOp>(
         CreatePrepareQuantizePass(quantization_method_));
@@ -804,9 +816,10 @@ void QuantizeCompositeFunctionsPass::runOnOperation() {
 }  // namespace
 
 std::unique_ptr<OperationPass<ModuleOp>> CreateQuantizeCompositeFunctionsPass(
-    QuantizationMethod quantization_method, OpSet target_opset) {
-  return std::make_unique<QuantizeCompositeFunctionsPass>(quantization_method,
-                                                          target_opset);
+    QuantizationMethod quantization_method, OpSet target_opset,
+    bool enable_per_channel_quantization) {
+  return std::make_unique<QuantizeCompositeFunctionsPass>(
+      quantization_method, target_opset, enable_per_channel_quantization);
 }
 
 }  // namespace quant
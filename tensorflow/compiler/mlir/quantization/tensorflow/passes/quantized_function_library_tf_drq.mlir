@@ -32,7 +32,9 @@
 
 module {
 
-  // Note: following functions won't handle per-channel quantization for now.
+  // Note: the inputs are quantized per tensor. The weight scales and zero
+  // points can also be per channel, along the last dimension of the weight,
+  // which is broadcast with the last dimension of the int32 accumulation.
   func.func private @internal_quantize_i8(%input : tensor<*xf32>, %scale : tensor<*xf32>, %zp : tensor<*xi32>) -> tensor<*xi8> {
     %div = "tf.Div"(%input, %scale) : (tensor<*xf32>, tensor<*xf32>) -> tensor<*xf32>
     %round = "tf.Round"(%div) : (tensor<*xf32>) -> tensor<*xf32>
@@ -97,6 +99,26 @@ module {
     func.return %5 : tensor<*xi32>
   }
 
+  // Conv2D with int32 accumulation
+  func.func private @internal_conv2d_fn(
+                         %input : tensor<*xi8>, %filter : tensor<*xi8>,
+                         %input_scale : tensor<*xf32>, %input_zp : tensor<*xi32>,
+                         %filter_scale : tensor<*xf32>, %filter_zp : tensor<*xi32>) -> tensor<*xi32> {
+    %0 = "tf.Cast"(%input) {Truncate = false} : (tensor<*xi8>) -> tensor<*xi32>
+    %1 = "tf.Sub"(%0, %input_zp) : (tensor<*xi32>, tensor<*xi32>) -> tensor<*xi32>
+
+    // Use identity op to avoid the filter being constant-folded.
+    %identity = "tf.Identity"(%filter) : (tensor<*xi8>) -> tensor<*xi8>
+    %2 = "tf.Cast"(%identity) {Truncate = false} : (tensor<*xi8>) -> tensor<*xi32>
+    %3 = "tf.Sub"(%2, %filter_zp) : (tensor<*xi32>, tensor<*xi32>) -> tensor<*xi32>
+
+    %5 = "tf.Conv2D"(%1, %3) {
+      padding = "VALID", strides = [1, 1, 1, 1],
+      attr_map = "strides:0,use_cudnn_on_gpu:1,padding:2,explicit_paddings:3,dilations:4"
+    } : (tensor<*xi32>, tensor<*xi32>) -> tensor<*xi32>
+    func.return %5 : tensor<*xi32>
+  }
+
   func.func @quantized_matmul_fn(
                          %input : tensor<*xf32>, %weight : tensor<*xi8>,
                          %weight_scale : tensor<*xf32>, %weight_zp : tensor<*xi32>) -> tensor<*xf32> {
@@ -122,4 +144,29 @@ module {
     func.return %out : tensor<*xf32>
   }
 
+  func.func @quantized_conv2d_fn(
+                         %input : tensor<*xf32>, %filter : tensor<*xi8>,
+                         %filter_scale : tensor<*xf32>, %filter_zp : tensor<*xi32>) -> tensor<*xf32> {
+
+    %input_scale, %input_zp = "tf.PartitionedCall"(%input) {
+        config = "", config_proto = "", executor_type = "", f=@internal_calculate_quant_params
+      } : (tensor<*xf32>) -> (tensor<*xf32>, tensor<*xi32>)
+
+    %quantized_input = "tf.PartitionedCall"(%input, %input_scale, %input_zp) {
+        config = "", config_proto = "", executor_type = "", f=@internal_quantize_i8
+      } : (tensor<*xf32>, tensor<*xf32>, tensor<*xi32>) -> tensor<*xi8>
+
+    %accum_out = "tf.PartitionedCall"(%quantized_input, %filter, %input_scale, %input_zp,
+                                %filter_scale, %filter_zp) {
+        config = "", config_proto = "", executor_type = "", f=@internal_conv2d_fn
+      } : (tensor<*xi8>, tensor<*xi8>, tensor<*xf32>, tensor<*xi32>,
+             tensor<*xf32>, tensor<*xi32>) -> tensor<*xi32>
+
+    %out = "tf.PartitionedCall"(%accum_out, %input_scale, %filter_scale) {
+        config = "", config_proto = "", executor_type = "", f=@internal_dequantize_i32
+      } : (tensor<*xi32>, tensor<*xf32>, tensor<*xf32>) -> tensor<*xf32>
+
+    func.return %out : tensor<*xf32>
+  }
+
 }
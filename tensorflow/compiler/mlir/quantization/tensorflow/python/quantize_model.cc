@@ -405,13 +405,15 @@ absl::StatusOr<GraphDef> QuantizePtqDynamicRange(
       mlir::TF::CreateUnrollBatchMatMulPassPass());
   pm.addNestedPass<mlir::func::FuncOp>(mlir::quant::CreatePrepareLiftingPass());
   pm.addPass(mlir::quant::CreateLiftQuantizableSpotsAsFunctionsDRQPass(
-      quantization_options.min_num_elements_for_weights()));
+      quantization_options.min_num_elements_for_weights(),
+      quantization_options.op_set()));
   pm.addPass(mlir::quant::CreateInsertQuantizedFunctionsPass(
       mlir::quant::QuantizationMethod::kDynamicRangeQuantization,
       quantization_options.op_set()));
   pm.addPass(mlir::quant::CreateQuantizeCompositeFunctionsPass(
       mlir::quant::QuantizationMethod::kDynamicRangeQuantization,
-      quantization_options.op_set()));
+      quantization_options.op_set(),
+      quantization_options.enable_per_channel_quantization()));
   pm.addPass(mlir::createSymbolDCEPass());
   pm.addPass(mlir::TF::CreateTFShapeInferencePass());
   pm.addPass(mlir::quant::CreateInsertMainFunctionPass());
@@ -808,6 +808,11 @@ def _dynamic_range_quantize(
     logging.warn(
         'min_num_elements_for_weights is unset so is set to the default value'
         '(1024).')
+  if (quantization_options.enable_per_channel_quantization and
+      quantization_options.op_set != quant_opts_pb2.OpSet.TF):
+    logging.warn(
+        'enable_per_channel_quantization is set but is only supported for the '
+        'TF opset. The weights are quantized per tensor.')
 
   is_qat_saved_model = _is_qat_saved_model(saved_model_path)
   signature_def_map = _get_signatures_from_saved_model(saved_model_path,
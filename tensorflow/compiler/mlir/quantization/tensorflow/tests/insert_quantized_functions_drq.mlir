@@ -13,6 +13,7 @@
 // limitations under the License.
 
 // RUN: tf-quant-opt %s -quant-insert-quantized-functions='quantization-method=drq target-opset=UNIFORM_QUANTIZED' | FileCheck %s
+// RUN: tf-quant-opt %s -quant-insert-quantized-functions='quantization-method=drq target-opset=TF' | FileCheck --check-prefix=TF %s
 
 // Empty module
 module {
@@ -26,3 +27,7 @@ module {
 // CHECK-NOT: func private @internal_quantize_i8
 // CHECK-NOT: func private @internal_matmul_fn
 // CHECK: func private @quantized_matmul_fn
+
+// TF-NOT: func private @internal_conv2d_fn
+// TF-DAG: func private @quantized_matmul_fn
+// TF-DAG: func private @quantized_conv2d_fn
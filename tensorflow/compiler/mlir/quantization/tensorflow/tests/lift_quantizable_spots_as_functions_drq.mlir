@@ -22,3 +22,29 @@ func.func @lift_float_matmul(%arg0: tensor<1x12x12x512xf32>) -> (tensor<*xf32>,
 // CHECK-NEXT: %[[OUT:.*]] = "tf.MatMul"(%arg0, %arg1)
 // CHECK-NEXT: return %[[OUT]]
 }
+
+// -----
+
+// CHECK-LABEL: lift_float_conv2d
+func.func @lift_float_conv2d(%arg0: tensor<1x3x4x3xf32>) -> (tensor<*xf32>, tensor<*xf32>) {
+  %cst = "tf.Const"() {value = dense<1.000000e+00> : tensor<2x3x3x2xf32>} : () -> tensor<2x3x3x2xf32>
+  %out_1 = "tf.Conv2D"(%arg0, %cst) {
+    data_format = "NHWC", device = "", dilations = [1, 1, 1, 1], explicit_paddings = [], padding = "SAME", strides = [1, 1, 2, 1], use_cudnn_on_gpu = true
+  } : (tensor<1x3x4x3xf32>, tensor<2x3x3x2xf32>) -> tensor<*xf32>
+  %out_2 = "tf.Conv2D"(%arg0, %arg0) {
+    data_format = "NHWC", device = "", dilations = [1, 1, 1, 1], explicit_paddings = [], padding = "SAME", strides = [1, 1, 2, 1], use_cudnn_on_gpu = true
+  } : (tensor<1x3x4x3xf32>, tensor<1x3x4x3xf32>) -> tensor<*xf32>
+  func.return %out_1, %out_2 : tensor<*xf32>, tensor<*xf32>
+
+// CHECK-DAG: %[[CONST:.*]] = "tf.Const"() {value = dense<1.000000e+00> : tensor<2x3x3x2xf32>} : () -> tensor<2x3x3x2xf32>
+// CHECK: %[[PARTITIONEDCALL:.*]] = "tf.PartitionedCall"(%arg0, %[[CONST]])
+// CHECK-SAME: {_tfl_quant_trait = "fully_quantizable",
+// CHECK-SAME: f = @composite_conv2d_fn_1}
+// CHECK: %[[UNQUANTIZED_OUTPUT:.*]] = "tf.Conv2D"(%arg0, %arg0)
+// CHECK: }
+
+// CHECK-LABEL: private @composite_conv2d_fn_1
+// CHECK-NEXT: %[[OUT:.*]] = "tf.Conv2D"(%arg0, %arg1)
+// CHECK-SAME: attr_map = "0:strides,1:use_cudnn_on_gpu,2:padding,3:explicit_paddings,4:dilations"
+// CHECK-NEXT: return %[[OUT]]
+}
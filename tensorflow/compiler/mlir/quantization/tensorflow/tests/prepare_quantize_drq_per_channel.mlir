@@ -0,0 +1,70 @@
+// Copyright 2022 The TensorFlow Runtime Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RUN: tf-quant-opt %s -split-input-file -quant-prepare-quantize-drq='enable-per-channel-quantization=true' | FileCheck %s
+
+// -----
+
+module {
+  func.func @matmul(%arg0: tensor<1x2x2x3xf32>) -> (tensor<*xf32>) {
+    %cst_0 = "tf.Const"() {value = dense<[[1.0, 2.0, 4.0], [-1.0, 0.5, 2.0]]> : tensor<2x3xf32>} : () -> tensor<2x3xf32>
+    %1 = "tf.PartitionedCall"(%arg0, %cst_0) {_tfl_quant_trait = "fully_quantizable", config = "", config_proto = "", executor_type = "", f = @composite_matmul_fn} : (tensor<1x2x2x3xf32>, tensor<2x3xf32>) -> tensor<*xf32>
+    func.return %1: tensor<*xf32>
+  }
+  func.func private @composite_matmul_fn(%arg0: tensor<1x2x2x3xf32>, %arg1: tensor<2x3xf32>) -> tensor<*xf32> attributes {tf_quant.composite_function} {
+    %0 = "tf.MatMul"(%arg0, %arg1) {attr_map = "0:transpose_a,1:transpose_b", device = "", transpose_a = false, transpose_b = false} : (tensor<1x2x2x3xf32>, tensor<2x3xf32>) -> tensor<*xf32>
+    return %0 : tensor<*xf32>
+  }
+
+// CHECK-LABEL: func @matmul
+// CHECK: %[[Q:.*]] = "quantfork.qcast"(%cst) : (tensor<2x3xf32>) -> tensor<2x3x!quant.uniform<i8<-127:127>:f32:1, {{.*}}>>
+// CHECK: %[[DQ:.*]] = "quantfork.dcast"(%[[Q]])
+// CHECK: "tf.PartitionedCall"(%arg0, %[[DQ]])
+}
+
+// -----
+
+module {
+  func.func @matmul_transposed(%arg0: tensor<1x3xf32>) -> (tensor<*xf32>) {
+    %cst_0 = "tf.Const"() {value = dense<[[1.0, 2.0, 4.0], [-1.0, 0.5, 2.0]]> : tensor<2x3xf32>} : () -> tensor<2x3xf32>
+    %1 = "tf.PartitionedCall"(%arg0, %cst_0) {_tfl_quant_trait = "fully_quantizable", config = "", config_proto = "", executor_type = "", f = @composite_matmul_fn} : (tensor<1x3xf32>, tensor<2x3xf32>) -> tensor<*xf32>
+    func.return %1: tensor<*xf32>
+  }
+  func.func private @composite_matmul_fn(%arg0: tensor<1x3xf32>, %arg1: tensor<2x3xf32>) -> tensor<*xf32> attributes {tf_quant.composite_function} {
+    %0 = "tf.MatMul"(%arg0, %arg1) {attr_map = "0:transpose_a,1:transpose_b", device = "", transpose_a = false, transpose_b = true} : (tensor<1x3xf32>, tensor<2x3xf32>) -> tensor<*xf32>
+    return %0 : tensor<*xf32>
+  }
+
+// The scales of a transposed weight are not along its last dimension, so it is
+// quantized per tensor.
+// CHECK-LABEL: func @matmul_transposed
+// CHECK: "quantfork.qcast"(%cst) : (tensor<2x3xf32>) -> tensor<2x3x!quant.uniform<i8<-127:127>:f32, {{.*}}>>
+}
+
+// -----
+
+module {
+  func.func @conv2d(%arg0: tensor<1x3x4x3xf32>) -> (tensor<*xf32>) {
+    %cst_0 = "tf.Const"() {value = dense<1.000000e+00> : tensor<2x3x3x2xf32>} : () -> tensor<2x3x3x2xf32>
+    %1 = "tf.PartitionedCall"(%arg0, %cst_0) {_tfl_quant_trait = "fully_quantizable", config = "", config_proto = "", executor_type = "", f = @composite_conv2d_fn} : (tensor<1x3x4x3xf32>, tensor<2x3x3x2xf32>) -> tensor<*xf32>
+    func.return %1: tensor<*xf32>
+  }
+  func.func private @composite_conv2d_fn(%arg0: tensor<1x3x4x3xf32>, %arg1: tensor<2x3x3x2xf32>) -> tensor<*xf32> attributes {tf_quant.composite_function} {
+    %0 = "tf.Conv2D"(%arg0, %arg1) {attr_map = "0:strides,1:use_cudnn_on_gpu,2:padding,3:explicit_paddings,4:dilations", data_format = "NHWC", device = "", dilations = [1, 1, 1, 1], explicit_paddings = [], padding = "SAME", strides = [1, 1, 2, 1], use_cudnn_on_gpu = true} : (tensor<1x3x4x3xf32>, tensor<2x3x3x2xf32>) -> tensor<*xf32>
+    return %0 : tensor<*xf32>
+  }
+
+// CHECK-LABEL: func @conv2d
+// CHECK: "quantfork.qcast"(%cst) : (tensor<2x3x3x2xf32>) -> tensor<2x3x3x2x!quant.uniform<i8<-127:127>:f32:3, {{.*}}>>
+}
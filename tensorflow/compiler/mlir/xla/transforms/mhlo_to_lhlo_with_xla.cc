@@ -1661,6 +1661,12 @@ Status LhloDialectEmitter::Initialize() {
           builder_.getStringAttr(
               xla::llvm_ir::ConstantBufferAllocationToGlobalName(*alloc)));
     }
+    // Optional: the memory space of the buffers of the allocation, if it is
+    // not the default one.
+    if (alloc->color() != 0) {
+      arg_attr_list.set("lmhlo.memory_space",
+                        builder_.getIndexAttr(alloc->color()));
+    }
     auto iter = allocation_to_output_info.find(alloc);
     if (iter != allocation_to_output_info.end()) {
       const Shape* sub_shape = iter->second.first;
@@ -0,0 +1,83 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/compiler/tf2xla/xla_batch_runner.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace tensorflow {
+
+XlaBatchRunner::XlaBatchRunner(const Eigen::ThreadPoolDevice* pool,
+                               const CreateFn& create)
+    : pool_(pool) {
+  const int num_workers = std::max(1, pool->numThreads());
+  functions_.reserve(num_workers);
+  for (int i = 0; i < num_workers; ++i) {
+    functions_.push_back(create());
+  }
+}
+
+XlaBatchRunner::XlaBatchRunner(
+    const Eigen::ThreadPoolDevice* pool,
+    const XlaCompiledCpuFunction::StaticData& static_data)
+    : XlaBatchRunner(pool, [&static_data] {
+        return std::make_unique<XlaCompiledCpuFunction>(static_data);
+      }) {}
+
+bool XlaBatchRunner::Run(int64_t num_examples, const ExampleFn& set_args,
+                         const ExampleFn& get_results) {
+  if (num_examples <= 0) {
+    return true;
+  }
+  // Workers claim examples one at a time, so that examples that take longer
+  // to run do not hold back the others.
+  std::atomic<int64_t> next_example{0};
+  std::atomic<bool> ok{true};
+  auto run_examples = [&](XlaCompiledCpuFunction* function) {
+    for (int64_t i = next_example.fetch_add(1); i < num_examples;
+         i = next_example.fetch_add(1)) {
+      if (set_args) {
+        set_args(i, function);
+      }
+      if (!function->Run()) {
+        ok.store(false);
+        continue;
+      }
+      if (get_results) {
+        get_results(i, function);
+      }
+    }
+  };
+
+  // The calling thread runs examples too, with the first instance.
+  const int num_workers = std::min<int64_t>(functions_.size(), num_examples);
+  Eigen::Barrier barrier(num_workers - 1);
+  for (int w = 1; w < num_workers; ++w) {
+    XlaCompiledCpuFunction* function = functions_[w].get();
+    pool_->enqueueNoNotification([&, function] {
+      run_examples(function);
+      barrier.Notify();
+    });
+  }
+  run_examples(functions_[0].get());
+  barrier.Wait();
+  return ok.load();
+}
+
+}  // namespace tensorflow
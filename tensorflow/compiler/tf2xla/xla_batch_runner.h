@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_TF2XLA_XLA_BATCH_RUNNER_H_
+#define TENSORFLOW_COMPILER_TF2XLA_XLA_BATCH_RUNNER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/tf2xla/xla_compiled_cpu_function.h"
+
+namespace Eigen {
+struct ThreadPoolDevice;
+}  // namespace Eigen
+
+namespace tensorflow {
+
+// Runs a function compiled by XLA on batches of independent examples, in
+// parallel on the threads of an Eigen thread pool.
+//
+// The runner creates one instance of the function per thread of the pool when
+// it is constructed, so each worker reuses the same preallocated arg, result
+// and temp buffers for all the examples it runs, across batches. Each example
+// runs on a single thread; the parallelism comes from running different
+// examples concurrently, so the instances are not given an intra-op pool.
+//
+// This class is thread-compatible: calls to Run require exclusive access to
+// the runner, and must not be made from a thread of the pool.
+class XlaBatchRunner {
+ public:
+  // Called for each example with the index of the example and the instance of
+  // the function that runs it.
+  using ExampleFn = std::function<void(int64_t, XlaCompiledCpuFunction*)>;
+  using CreateFn = std::function<std::unique_ptr<XlaCompiledCpuFunction>()>;
+
+  // Creates the instances of the function with `create`. `pool` must outlive
+  // the runner.
+  XlaBatchRunner(const Eigen::ThreadPoolDevice* pool, const CreateFn& create);
+
+  // Creates instances of the function described by `static_data`, with the
+  // default AllocMode.
+  XlaBatchRunner(const Eigen::ThreadPoolDevice* pool,
+                 const XlaCompiledCpuFunction::StaticData& static_data);
+
+  XlaBatchRunner(const XlaBatchRunner&) = delete;
+  XlaBatchRunner& operator=(const XlaBatchRunner&) = delete;
+
+  // Runs examples [0, num_examples). For each example, calls `set_args` to set
+  // the arguments of the instance it runs on, runs the instance, and on
+  // success calls `get_results` to read its results before the instance is
+  // reused. Either callback may be null, and both may be called concurrently
+  // for different examples. Returns true if every example ran successfully.
+  bool Run(int64_t num_examples, const ExampleFn& set_args,
+           const ExampleFn& get_results);
+
+  // Number of examples that run concurrently.
+  int num_workers() const { return functions_.size(); }
+
+ private:
+  const Eigen::ThreadPoolDevice* const pool_;
+  std::vector<std::unique_ptr<XlaCompiledCpuFunction>> functions_;
+};
+
+// An XlaBatchRunner for a class `T` generated by tfcompile, whose callbacks
+// are given the typed instances of `T`.
+template <typename T>
+class TypedXlaBatchRunner : public XlaBatchRunner {
+ public:
+  using TypedExampleFn = std::function<void(int64_t, T*)>;
+
+  explicit TypedXlaBatchRunner(const Eigen::ThreadPoolDevice* pool)
+      : XlaBatchRunner(pool, [] {
+          return std::unique_ptr<XlaCompiledCpuFunction>(new T());
+        }) {}
+
+  bool Run(int64_t num_examples, const TypedExampleFn& set_args,
+           const TypedExampleFn& get_results) {
+    return XlaBatchRunner::Run(num_examples, Wrap(set_args), Wrap(get_results));
+  }
+
+ private:
+  static ExampleFn Wrap(const TypedExampleFn& fn) {
+    if (!fn) {
+      return nullptr;
+    }
+    return [&fn](int64_t example, XlaCompiledCpuFunction* function) {
+      fn(example, static_cast<T*>(function));
+    };
+  }
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMPILER_TF2XLA_XLA_BATCH_RUNNER_H_
@@ -670,6 +670,80 @@ static void AllocateFlags() {
       flag_values->xla_gpu_force_compilation_parallelism(),
       "Overrides normal multi-threaded compilation settting to use this many "
       "threads. Setting to 0 (the default value) means no enforcement."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_force_compilation_parallelism",
+      int32_setter_for(
+          &DebugOptions::set_xla_cpu_force_compilation_parallelism),
+      flag_values->xla_cpu_force_compilation_parallelism(),
+      "Number of threads used to compile the LLVM IR of XLA:CPU executables. "
+      "Setting to 0 (the default value) uses the thread pool of the client, "
+      "if any, and 1 compiles on the calling thread."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_cpu_parallel_task_profile_dir",
+      string_setter_for(&DebugOptions::set_xla_cpu_parallel_task_profile_dir),
+      flag_values->xla_cpu_parallel_task_profile_dir(),
+      "Directory of the execution profiles used to assign parallel tasks on "
+      "XLA:CPU. Executables run with --xla_hlo_profile save their profile "
+      "there, and later compilations of the same module use the measured "
+      "cycles of the instructions to pick their number of parallel tasks."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_cuda_graphs",
+      bool_setter_for(&DebugOptions::set_xla_gpu_enable_cuda_graphs),
+      flag_values->xla_gpu_enable_cuda_graphs(),
+      "Execute the thunks of XLA:GPU executables by replaying CUDA graphs "
+      "captured from their kernel launches, memsets and device-to-device "
+      "copies. Graphs are captured on the first run and updated with the new "
+      "buffer addresses on later runs."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_load_autotune_results_from",
+      string_setter_for(
+          &DebugOptions::set_xla_gpu_load_autotune_results_from),
+      flag_values->xla_gpu_load_autotune_results_from(),
+      "File of GPU autotuning results to load before autotuning. It is in "
+      "text format if its name ends in .pbtxt, and binary format otherwise."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_dump_autotune_results_to",
+      string_setter_for(&DebugOptions::set_xla_gpu_dump_autotune_results_to),
+      flag_values->xla_gpu_dump_autotune_results_to(),
+      "File to which the GPU autotuning results of the process are saved. It "
+      "is in text format if its name ends in .pbtxt, and binary format "
+      "otherwise."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_require_complete_autotune_results",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_require_complete_autotune_results),
+      flag_values->xla_gpu_require_complete_autotune_results(),
+      "Fail compilation instead of autotuning instructions that have no "
+      "result in --xla_gpu_load_autotune_results_from."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_parallel_autotuning",
+      bool_setter_for(&DebugOptions::set_xla_gpu_parallel_autotuning),
+      flag_values->xla_gpu_parallel_autotuning(),
+      "Autotune convolutions and GEMMs in parallel on all the visible GPUs "
+      "identical to the one being compiled for, sharing the results."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_host_offload_memory_limit_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_host_offload_memory_limit_bytes),
+      flag_values->xla_gpu_host_offload_memory_limit_bytes(),
+      "If positive, offload long-lived values to pinned host memory until the "
+      "estimated peak device memory of the module is below this many bytes. "
+      "CUDA only."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_enable_latency_hiding_scheduler",
+      bool_setter_for(
+          &DebugOptions::set_xla_gpu_enable_latency_hiding_scheduler),
+      flag_values->xla_gpu_enable_latency_hiding_scheduler(),
+      "Schedule asynchronous collectives to overlap with independent "
+      "compute."));
+  flag_objects->push_back(tensorflow::Flag(
+      "xla_gpu_latency_hiding_scheduler_memory_limit_bytes",
+      int64_setter_for(
+          &DebugOptions::set_xla_gpu_latency_hiding_scheduler_memory_limit_bytes),
+      flag_values->xla_gpu_latency_hiding_scheduler_memory_limit_bytes(),
+      "Estimated peak memory that the latency-hiding scheduler may use. If "
+      "not positive, 10% more than the estimated peak memory of the default "
+      "schedule."));
   flag_objects->push_back(tensorflow::Flag(
       "xla_gpu_deterministic_ops",
       bool_setter_for(&DebugOptions::set_xla_gpu_deterministic_ops),
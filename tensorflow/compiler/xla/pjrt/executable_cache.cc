@@ -0,0 +1,245 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/pjrt/executable_cache.h"
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/pjrt/pjrt_executable.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+
+namespace xla {
+namespace {
+
+// Writes `contents` to `path` through a temporary file, so that concurrent
+// readers never see a partially written file.
+Status WriteFileAtomically(tensorflow::Env* env, const std::string& path,
+                           const std::string& contents) {
+  std::string tmp_path = absl::StrCat(path, ".tmp.", env->NowMicros(), ".",
+                                      env->GetCurrentThreadId());
+  TF_RETURN_IF_ERROR(tensorflow::WriteStringToFile(env, tmp_path, contents));
+  Status status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // namespace
+
+PjRtExecutableCache::PjRtExecutableCache(PjRtClient* client, Options options)
+    : client_(client), options_(std::move(options)) {}
+
+StatusOr<std::string> PjRtExecutableCache::Key(
+    const XlaComputation& computation, const CompileOptions& options) const {
+  if (options.multi_slice_config != nullptr) {
+    return Unimplemented(
+        "Caching executables with a multi-slice config is not supported.");
+  }
+  TF_ASSIGN_OR_RETURN(CompileOptionsProto options_proto, options.ToProto());
+  std::string serialized_computation;
+  std::string serialized_options;
+  if (!tensorflow::SerializeToStringDeterministic(computation.proto(),
+                                                  &serialized_computation) ||
+      !tensorflow::SerializeToStringDeterministic(options_proto,
+                                                  &serialized_options)) {
+    return InternalError("Failed to serialize the computation or options.");
+  }
+  // Prefix the variable-length fields with their lengths, so that different
+  // fields cannot produce the same fingerprint input.
+  tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(absl::StrCat(
+      client_->platform_name().size(), ":", client_->platform_name(),
+      client_->platform_version().size(), ":", client_->platform_version(),
+      serialized_computation.size(), ":", serialized_computation,
+      serialized_options));
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+std::string PjRtExecutableCache::PersistentCachePath(
+    const std::string& key) const {
+  return tensorflow::io::JoinPath(options_.persistent_cache_dir,
+                                  absl::StrCat(key, ".pjrt_executable"));
+}
+
+StatusOr<std::unique_ptr<PjRtLoadedExecutable>> PjRtExecutableCache::Load(
+    const std::string& key, const XlaComputation& computation,
+    const CompileOptions& options, int64_t* serialized_bytes) {
+  *serialized_bytes = 0;
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const bool persistent = !options_.persistent_cache_dir.empty();
+  if (persistent && env->FileExists(PersistentCachePath(key)).ok()) {
+    std::string serialized;
+    Status status = tensorflow::ReadFileToString(env, PersistentCachePath(key),
+                                                 &serialized);
+    if (status.ok()) {
+      StatusOr<std::unique_ptr<PjRtLoadedExecutable>> executable =
+          client_->DeserializeExecutable(serialized, options);
+      if (executable.ok()) {
+        *serialized_bytes = serialized.size();
+        absl::MutexLock lock(&mu_);
+        ++stats_.num_persistent_hits;
+        return std::move(executable);
+      }
+      status = executable.status();
+    }
+    LOG(WARNING) << "Failed to load persisted executable "
+                 << PersistentCachePath(key) << ", compiling instead: "
+                 << status;
+  }
+
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtLoadedExecutable> executable,
+                      client_->Compile(computation, options));
+  if (persistent) {
+    StatusOr<std::string> serialized =
+        client_->SerializeExecutable(*executable);
+    if (serialized.ok()) {
+      *serialized_bytes = serialized->size();
+      Status status =
+          env->RecursivelyCreateDir(options_.persistent_cache_dir);
+      if (status.ok()) {
+        status =
+            WriteFileAtomically(env, PersistentCachePath(key), *serialized);
+      }
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to persist executable "
+                     << PersistentCachePath(key) << ": " << status;
+      }
+    } else {
+      VLOG(1) << "Not persisting executable " << executable->name() << ": "
+              << serialized.status();
+    }
+  }
+  return executable;
+}
+
+StatusOr<std::shared_ptr<PjRtLoadedExecutable>>
+PjRtExecutableCache::GetOrCompile(const XlaComputation& computation,
+                                  CompileOptions options) {
+  StatusOr<std::string> key = Key(computation, options);
+  if (!key.ok()) {
+    VLOG(1) << "Not caching executable: " << key.status();
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtLoadedExecutable> executable,
+                        client_->Compile(computation, std::move(options)));
+    return std::shared_ptr<PjRtLoadedExecutable>(std::move(executable));
+  }
+
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = entries_.find(*key);
+    if (it != entries_.end()) {
+      ++stats_.num_hits;
+      lru_.splice(lru_.end(), lru_, it->second.lru_position);
+      return it->second.executable;
+    }
+    ++stats_.num_misses;
+  }
+
+  // Compile without holding the lock. Concurrent misses for the same key may
+  // compile twice, in which case the first executable inserted wins.
+  int64_t serialized_bytes;
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<PjRtLoadedExecutable> executable,
+                      Load(*key, computation, options, &serialized_bytes));
+  int64_t device_bytes = executable->SizeOfGeneratedCodeInBytes();
+  StatusOr<CompiledMemoryStats> memory_stats =
+      executable->GetCompiledMemoryStats();
+  if (memory_stats.ok()) {
+    device_bytes = memory_stats->generated_code_size_in_bytes +
+                   memory_stats->temp_size_in_bytes;
+  }
+  int64_t host_bytes = serialized_bytes > 0
+                           ? serialized_bytes
+                           : executable->SizeOfGeneratedCodeInBytes();
+
+  absl::MutexLock lock(&mu_);
+  auto [it, inserted] = entries_.try_emplace(*key);
+  if (!inserted) {
+    lru_.splice(lru_.end(), lru_, it->second.lru_position);
+    return it->second.executable;
+  }
+  Entry& entry = it->second;
+  entry.executable = executable;
+  entry.device_bytes = device_bytes;
+  entry.host_bytes = host_bytes;
+  entry.lru_position = lru_.insert(lru_.end(), *key);
+  device_bytes_ += device_bytes;
+  host_bytes_ += host_bytes;
+  EvictIfNeeded(*key);
+  return executable;
+}
+
+void PjRtExecutableCache::EvictIfNeeded(const std::string& keep) {
+  auto exceeds_bounds = [&] {
+    return (options_.max_device_bytes > 0 &&
+            device_bytes_ > options_.max_device_bytes) ||
+           (options_.max_host_bytes > 0 &&
+            host_bytes_ > options_.max_host_bytes);
+  };
+  auto lru_it = lru_.begin();
+  while (exceeds_bounds() && lru_it != lru_.end()) {
+    if (*lru_it == keep) {
+      ++lru_it;
+      continue;
+    }
+    auto it = entries_.find(*lru_it);
+    VLOG(1) << "Evicting executable " << it->second.executable->name()
+            << " using " << it->second.device_bytes << " device bytes and "
+            << it->second.host_bytes << " host bytes";
+    device_bytes_ -= it->second.device_bytes;
+    host_bytes_ -= it->second.host_bytes;
+    ++stats_.num_evictions;
+    lru_it = lru_.erase(lru_it);
+    entries_.erase(it);
+  }
+}
+
+void PjRtExecutableCache::Clear() {
+  absl::MutexLock lock(&mu_);
+  entries_.clear();
+  lru_.clear();
+  device_bytes_ = 0;
+  host_bytes_ = 0;
+}
+
+int PjRtExecutableCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+int64_t PjRtExecutableCache::device_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return device_bytes_;
+}
+
+int64_t PjRtExecutableCache::host_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return host_bytes_;
+}
+
+PjRtExecutableCache::Stats PjRtExecutableCache::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+}  // namespace xla
@@ -0,0 +1,130 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_XLA_PJRT_EXECUTABLE_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_PJRT_EXECUTABLE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/compiler/xla/client/xla_computation.h"
+#include "tensorflow/compiler/xla/pjrt/pjrt_client.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+
+// A cache of compiled executables in front of PjRtClient::Compile, keyed by a
+// fingerprint of the computation, the compile options and the platform.
+//
+// Unlike LRUCache, which bounds the number of entries, the cache bounds the
+// total memory of the executables it keeps loaded and evicts the least
+// recently used executables until they fit. Executables are returned as
+// shared pointers, so evicted executables remain valid for the callers that
+// still hold them.
+//
+// If `persistent_cache_dir` is set and the client supports
+// SerializeExecutable, compiled executables are also written to that
+// directory, and later cache misses, possibly in other processes,
+// deserialize them instead of compiling.
+//
+// Thread-safe.
+class PjRtExecutableCache {
+ public:
+  struct Options {
+    // Bounds on the total device and host memory of the cached executables,
+    // or 0 for no bound. The device memory of an executable is the size of its
+    // generated code and temporary buffers. The host memory of an executable
+    // is the size of its serialization if known, and the size of its
+    // generated code otherwise.
+    int64_t max_device_bytes = 0;
+    int64_t max_host_bytes = 0;
+
+    // Directory in which to persist serialized executables, or empty.
+    std::string persistent_cache_dir;
+  };
+
+  struct Stats {
+    int64_t num_hits = 0;
+    int64_t num_misses = 0;
+    // Number of misses served by deserializing a persisted executable.
+    int64_t num_persistent_hits = 0;
+    int64_t num_evictions = 0;
+  };
+
+  // `client` must outlive the cache.
+  PjRtExecutableCache(PjRtClient* client, Options options);
+
+  PjRtExecutableCache(const PjRtExecutableCache&) = delete;
+  PjRtExecutableCache& operator=(const PjRtExecutableCache&) = delete;
+
+  // Returns the executable for `computation` compiled with `options`,
+  // compiling it if it is neither cached nor persisted.
+  StatusOr<std::shared_ptr<PjRtLoadedExecutable>> GetOrCompile(
+      const XlaComputation& computation, CompileOptions options);
+
+  // Drops all cached executables. Does not remove persisted executables.
+  void Clear();
+
+  int size() const;
+  int64_t device_bytes() const;
+  int64_t host_bytes() const;
+  Stats stats() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<PjRtLoadedExecutable> executable;
+    int64_t device_bytes;
+    int64_t host_bytes;
+    // Position of the key in `lru_`.
+    std::list<std::string>::iterator lru_position;
+  };
+
+  // Returns the cache key for `computation` and `options`.
+  StatusOr<std::string> Key(const XlaComputation& computation,
+                            const CompileOptions& options) const;
+
+  std::string PersistentCachePath(const std::string& key) const;
+
+  // Compiles `computation`, or deserializes it from the persistent cache.
+  // Sets `*serialized_bytes` to the size of its serialization, or 0 if
+  // unknown.
+  StatusOr<std::unique_ptr<PjRtLoadedExecutable>> Load(
+      const std::string& key, const XlaComputation& computation,
+      const CompileOptions& options, int64_t* serialized_bytes);
+
+  // Evicts the least recently used entries other than `keep` until the
+  // cached executables fit in the memory bounds.
+  void EvictIfNeeded(const std::string& keep)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  PjRtClient* const client_;
+  const Options options_;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  // Keys of `entries_`, from least to most recently used.
+  std::list<std::string> lru_ ABSL_GUARDED_BY(mu_);
+  int64_t device_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  int64_t host_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  Stats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_PJRT_EXECUTABLE_CACHE_H_
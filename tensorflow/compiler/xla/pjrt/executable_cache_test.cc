@@ -0,0 +1,142 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/pjrt/executable_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/compiler/xla/pjrt/tfrt_cpu_pjrt_client.h"
+#include "tensorflow/compiler/xla/service/hlo_parser.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace {
+
+constexpr char kAddProgram[] = R"(
+HloModule Add
+
+ENTRY main {
+  p = f32[4] parameter(0)
+  ROOT add = f32[4] add(p, p)
+})";
+
+constexpr char kMultiplyProgram[] = R"(
+HloModule Multiply
+
+ENTRY main {
+  p = f32[4] parameter(0)
+  ROOT multiply = f32[4] multiply(p, p)
+})";
+
+XlaComputation ParseComputation(const char* program) {
+  auto hlo_module = ParseAndReturnUnverifiedModule(program, {});
+  TF_CHECK_OK(hlo_module.status());
+  return XlaComputation((*hlo_module)->ToProto());
+}
+
+class PjRtExecutableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK_AND_ASSIGN(client_, GetTfrtCpuClient(/*asynchronous=*/true));
+  }
+
+  std::unique_ptr<PjRtClient> client_;
+};
+
+TEST_F(PjRtExecutableCacheTest, ReturnsCachedExecutable) {
+  PjRtExecutableCache cache(client_.get(), {});
+  XlaComputation computation = ParseComputation(kAddProgram);
+  TF_ASSERT_OK_AND_ASSIGN(auto first, cache.GetOrCompile(computation, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto second, cache.GetOrCompile(computation, {}));
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_GT(cache.device_bytes(), 0);
+  EXPECT_GT(cache.host_bytes(), 0);
+  EXPECT_EQ(cache.stats().num_hits, 1);
+  EXPECT_EQ(cache.stats().num_misses, 1);
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto other, cache.GetOrCompile(ParseComputation(kMultiplyProgram), {}));
+  EXPECT_NE(first.get(), other.get());
+  EXPECT_EQ(cache.size(), 2);
+}
+
+TEST_F(PjRtExecutableCacheTest, KeysOnCompileOptions) {
+  PjRtExecutableCache cache(client_.get(), {});
+  XlaComputation computation = ParseComputation(kAddProgram);
+  TF_ASSERT_OK_AND_ASSIGN(auto first, cache.GetOrCompile(computation, {}));
+  CompileOptions options;
+  DebugOptions* debug_options =
+      options.executable_build_options.mutable_debug_options();
+  debug_options->set_xla_cpu_enable_fast_math(
+      !debug_options->xla_cpu_enable_fast_math());
+  TF_ASSERT_OK_AND_ASSIGN(auto second,
+                          cache.GetOrCompile(computation, options));
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(cache.stats().num_misses, 2);
+}
+
+TEST_F(PjRtExecutableCacheTest, EvictsLeastRecentlyUsedToFitMemoryBound) {
+  XlaComputation add = ParseComputation(kAddProgram);
+  XlaComputation multiply = ParseComputation(kMultiplyProgram);
+  int64_t add_bytes;
+  {
+    PjRtExecutableCache unbounded(client_.get(), {});
+    TF_ASSERT_OK(unbounded.GetOrCompile(add, {}).status());
+    add_bytes = unbounded.host_bytes();
+  }
+
+  PjRtExecutableCache::Options options;
+  options.max_host_bytes = add_bytes;
+  PjRtExecutableCache cache(client_.get(), options);
+  TF_ASSERT_OK_AND_ASSIGN(auto add_executable, cache.GetOrCompile(add, {}));
+  EXPECT_EQ(cache.size(), 1);
+  TF_ASSERT_OK_AND_ASSIGN(auto multiply_executable,
+                          cache.GetOrCompile(multiply, {}));
+  // The most recently inserted executable is kept even if it alone exceeds
+  // the bound.
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.stats().num_evictions, 1);
+
+  // The evicted executable is still usable, and is compiled again on the
+  // next request.
+  EXPECT_EQ(add_executable->name(), "Add");
+  TF_ASSERT_OK_AND_ASSIGN(auto recompiled, cache.GetOrCompile(add, {}));
+  EXPECT_NE(recompiled.get(), add_executable.get());
+  EXPECT_EQ(cache.stats().num_misses, 3);
+}
+
+TEST_F(PjRtExecutableCacheTest, DoesNotPersistWhenSerializationUnsupported) {
+  PjRtExecutableCache::Options options;
+  options.persistent_cache_dir =
+      tensorflow::io::JoinPath(::testing::TempDir(), "executable_cache");
+  PjRtExecutableCache cache(client_.get(), options);
+  TF_ASSERT_OK(cache.GetOrCompile(ParseComputation(kAddProgram), {}).status());
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.stats().num_persistent_hits, 0);
+  std::vector<std::string> files;
+  TF_ASSERT_OK(tensorflow::Env::Default()->GetMatchingPaths(
+      tensorflow::io::JoinPath(options.persistent_cache_dir, "*"), &files));
+  EXPECT_TRUE(files.empty());
+}
+
+}  // namespace
+}  // namespace xla
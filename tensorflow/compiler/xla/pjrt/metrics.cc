@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 
 namespace xla {
 namespace {
@@ -31,6 +32,24 @@ auto* pjrt_executable_execution_time_usecs =
         "The total time spent on PjRtExecutable::ExecuteHelper in "
         "microseconds.");
 
+auto* pjrt_host_to_device_staged_transfers =
+    tensorflow::monitoring::Counter<1>::New(
+        "/jax/pjrt/host_to_device_staged_transfers",
+        "The number of host-to-device transfers through a host staging "
+        "buffer.",
+        "pipelined");
+
+auto* pjrt_host_to_device_staged_bytes =
+    tensorflow::monitoring::Counter<0>::New(
+        "/jax/pjrt/host_to_device_staged_bytes",
+        "The total number of bytes transferred from host to device through a "
+        "host staging buffer.");
+
+auto* pjrt_host_staging_bytes_in_use = tensorflow::monitoring::Gauge<
+    int64_t, 0>::New("/jax/pjrt/host_staging_bytes_in_use",
+                     "The number of bytes allocated from the host staging "
+                     "memory pool.");
+
 }  // namespace
 
 void ReportExecutableEnqueueTime(const uint64_t running_time_usecs) {
@@ -44,4 +63,19 @@ void ReportExecutableEnqueueTime(const uint64_t running_time_usecs) {
   }
 }
 
+void ReportHostToDeviceStagedTransfer(uint64_t bytes, bool pipelined) {
+  pjrt_host_to_device_staged_transfers
+      ->GetCell(pipelined ? "true" : "false")
+      ->IncrementBy(1);
+  static auto* pjrt_host_to_device_staged_bytes_cell =
+      pjrt_host_to_device_staged_bytes->GetCell();
+  pjrt_host_to_device_staged_bytes_cell->IncrementBy(bytes);
+}
+
+void ReportHostStagingBytesInUse(int64_t bytes_in_use) {
+  static auto* pjrt_host_staging_bytes_in_use_cell =
+      pjrt_host_staging_bytes_in_use->GetCell();
+  pjrt_host_staging_bytes_in_use_cell->Set(bytes_in_use);
+}
+
 }  // namespace xla
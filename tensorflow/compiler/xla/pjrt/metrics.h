@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_PJRT_METRICS_H_
 #define TENSORFLOW_COMPILER_XLA_PJRT_METRICS_H_
 
+#include <cstdint>
+
 #include "tensorflow/core/lib/monitoring/counter.h"
 
 // Simplified version of tensorflow/core/framework/metrics.h for JAX.
@@ -24,6 +26,13 @@ namespace xla {
 
 void ReportExecutableEnqueueTime(const uint64_t running_time_usecs);
 
+// Reports a host-to-device transfer of `bytes` bytes through a host staging
+// buffer, and whether it was split into pipelined chunks.
+void ReportHostToDeviceStagedTransfer(uint64_t bytes, bool pipelined);
+
+// Reports the number of bytes allocated from the host staging memory pool.
+void ReportHostStagingBytesInUse(int64_t bytes_in_use);
+
 }
 
 #endif  // TENSORFLOW_COMPILER_XLA_PJRT_METRICS_H_
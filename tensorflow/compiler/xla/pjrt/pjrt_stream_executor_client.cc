@@ -686,6 +686,37 @@ PjRtStreamExecutorBuffer::ReleaseDeviceMemoryOwnership(
   return ref;
 }
 
+namespace {
+
+// Size of the chunks in which large host-to-device transfers through a
+// staging buffer are pipelined.
+constexpr int64_t kPipelinedTransferChunkBytes = 4 << 20;
+
+// Copies `size` bytes from `data` into `staging_buffer` and enqueues their
+// transfer to `device_memory` on `stream`, one chunk at a time, so that the
+// copy of each chunk into the staging buffer overlaps with the DMA of the
+// previous chunks.
+Status PipelinedTransferToDevice(se::Stream* stream, const void* data,
+                                 void* staging_buffer, int64_t size,
+                                 se::DeviceMemoryBase device_memory) {
+  const char* src = static_cast<const char*>(data);
+  char* staging = static_cast<char*>(staging_buffer);
+  for (int64_t offset = 0; offset < size;
+       offset += kPipelinedTransferChunkBytes) {
+    int64_t chunk_bytes = std::min(kPipelinedTransferChunkBytes, size - offset);
+    std::memcpy(staging + offset, src + offset, chunk_bytes);
+    se::DeviceMemoryBase chunk(
+        static_cast<char*>(device_memory.opaque()) + offset, chunk_bytes);
+    stream->ThenMemcpy(&chunk, staging + offset, chunk_bytes);
+  }
+  if (!stream->ok()) {
+    return InternalError("Failed to enqueue pipelined host-to-device transfer");
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
 StatusOr<std::unique_ptr<PjRtBuffer>>
 PjRtStreamExecutorClient::BufferFromHostBuffer(
     const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
@@ -795,6 +826,11 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
         ptr, [host_memory_allocator = host_memory_allocator()](void* ptr) {
           host_memory_allocator->DeallocateRaw(ptr);
         });
+    std::optional<tensorflow::AllocatorStats> stats =
+        host_memory_allocator()->GetStats();
+    if (stats) {
+      ReportHostStagingBytesInUse(stats->bytes_in_use);
+    }
   }
 
   std::shared_ptr<TransposePlan> transpose;
@@ -803,10 +839,31 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
     absl::c_reverse_copy(compact_shape.layout().minor_to_major(),
                          permutation.begin());
     absl::MutexLock lock(&transpose_mu_);
-    TF_ASSIGN_OR_RETURN(transpose,
-                        transpose_cache_.GetOrCreate(
-                            primitive_util::ByteWidth(type), dims, permutation,
-                            TransposePlan::Striding{*byte_strides}));
+    TF_ASSIGN_OR_RETURN(
+        transpose,
+        transpose_cache_.GetOrCreate(
+            primitive_util::ByteWidth(type), dims, permutation,
+            TransposePlan::Striding{*byte_strides},
+            /*output_tiling=*/TransposePlan::Tiling{},
+            TransposePlan::Transformation::kNone,
+            /*num_threads=*/thread_pool()->NumThreads()));
+  }
+
+  // Large transfers that are staged on the worker thread into pinned memory
+  // are split into chunks, so that copying into the staging buffer and the
+  // DMA from it are pipelined. This requires a dense, static array that the
+  // device stores exactly as the staging buffer lays it out.
+  const Shape& device_shape = py_buffer->on_device_shape();
+  bool pipeline_transfer =
+      staging_buffer != nullptr && !transpose &&
+      should_stage_host_to_device_transfers() &&
+      host_buffer_semantics !=
+          HostBufferSemantics::kImmutableOnlyDuringCall &&
+      size >= 2 * kPipelinedTransferChunkBytes && device_shape.IsArray() &&
+      device_shape.is_static() && device_shape.layout().tiles().empty() &&
+      transfer_manager->GetByteSizeRequirement(device_shape) == size;
+  if (staging_buffer) {
+    ReportHostToDeviceStagedTransfer(size, pipeline_transfer);
   }
 
   // Copy the buffer into a staging buffer before returning control to the
@@ -815,7 +872,16 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
   // thread.
   if (host_buffer_semantics == HostBufferSemantics::kImmutableOnlyDuringCall) {
     if (transpose) {
-      transpose->Execute(data, staging_buffer.get());
+      // Split the transpose across the thread pool, unless we are running on
+      // it already, since waiting for it from one of its threads could
+      // deadlock. Transposes deferred to the thread pool below run serially.
+      std::function<void(std::function<void()>)> schedule_work;
+      if (thread_pool()->CurrentThreadId() == -1) {
+        schedule_work = [this](std::function<void()> fn) {
+          thread_pool()->Schedule(std::move(fn));
+        };
+      }
+      transpose->Execute(data, staging_buffer.get(), schedule_work);
     } else {
       std::memcpy(staging_buffer.get(), data, size);
     }
@@ -838,7 +904,8 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
        on_device_shape{py_buffer->on_device_shape()},
        staging_buffer{std::move(staging_buffer)},
        on_done_with_host_buffer{std::move(on_done_with_host_buffer)},
-       host_buffer_semantics, transpose{std::move(transpose)}]() {
+       host_buffer_semantics, transpose{std::move(transpose)},
+       pipeline_transfer]() {
         PjRtStreamExecutorBuffer::ScopedHold device_buffer(
             movable_device_buffer);
         // This function uses TF_CHECK_OK and ValueOrDie() since we have no way
@@ -851,7 +918,11 @@ PjRtStreamExecutorClient::BufferFromHostBuffer(
         // If applicable on the backend, stage the transfer via host memory
         // allocated via the host_memory_allocator. On GPU, this is pinned
         // memory.
-        if (staging_buffer) {
+        if (pipeline_transfer) {
+          TF_CHECK_OK(PipelinedTransferToDevice(
+              local_device->host_to_device_stream(), data,
+              staging_buffer.get(), size, buffer.root_buffer()));
+        } else if (staging_buffer) {
           // If we didn't already copy the input buffer into the staging buffer,
           // do so now.
           if (host_buffer_semantics !=
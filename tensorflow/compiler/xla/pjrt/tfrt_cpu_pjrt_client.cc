@@ -186,6 +186,10 @@ TfrtCpuClient::TfrtCpuClient(
       last_collective_launch_event_(
           tfrt::MakeAvailableAsyncValueRef<CpuEvent>(host_ctx_.get())),
       transpose_cache_(1024) {
+  for (int i = 1; i <= eigen_intraop_pool_->NumThreads(); ++i) {
+    eigen_intraop_devices_.push_back(std::make_unique<Eigen::ThreadPoolDevice>(
+        eigen_intraop_pool_->AsEigenThreadPool(), i));
+  }
   for (const std::unique_ptr<TfrtCpuDevice>& device : owned_devices_) {
     devices_.push_back(device.get());
     CHECK(id_to_device_.insert({device->id(), device.get()}).second)
@@ -209,6 +213,21 @@ TfrtCpuClient::TfrtCpuClient(
 
 TfrtCpuClient::~TfrtCpuClient() { LOG(INFO) << "TfrtCpuClient destroyed."; }
 
+Eigen::ThreadPoolDevice* TfrtCpuClient::StartExecution() {
+  const int num_running =
+      num_running_executions_.fetch_add(1, std::memory_order_relaxed) + 1;
+  // Round up so that all threads stay busy; the pool steals work when
+  // executions finish unevenly.
+  const int num_threads = std::min<int>(
+      eigen_intraop_devices_.size(),
+      CeilOfRatio<int>(eigen_intraop_devices_.size(), num_running));
+  return eigen_intraop_devices_[num_threads - 1].get();
+}
+
+void TfrtCpuClient::FinishExecution() {
+  num_running_executions_.fetch_sub(1, std::memory_order_relaxed);
+}
+
 StatusOr<PjRtDevice*> TfrtCpuClient::LookupDevice(int device_id) const {
   auto it = id_to_device_.find(device_id);
   if (it != id_to_device_.end()) {
@@ -527,18 +546,24 @@ StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
       // into major-to-minor layout. Currently we choose to always do this
       // synchronously.
       // TODO(phawkins): consider performing the transpose asynchronously.
-      // TODO(phawkins): parallelize the transpose.
+      // Large transposes are split across the intra-op thread pool.
       std::shared_ptr<TransposePlan> transpose;
       {
         absl::InlinedVector<int64_t, 4> permutation(dims.size());
         absl::c_iota(permutation, 0);
         absl::MutexLock lock(&transpose_mu_);
         TF_ASSIGN_OR_RETURN(
-            transpose, transpose_cache_.GetOrCreate(
-                           primitive_util::ByteWidth(type), dims, permutation,
-                           TransposePlan::Striding{*byte_strides}));
+            transpose,
+            transpose_cache_.GetOrCreate(
+                primitive_util::ByteWidth(type), dims, permutation,
+                TransposePlan::Striding{*byte_strides},
+                /*output_tiling=*/TransposePlan::Tiling{},
+                TransposePlan::Transformation::kNone,
+                /*num_threads=*/eigen_intraop_pool_->NumThreads()));
       }
-      transpose->Execute(data, dst_data_ptr);
+      transpose->Execute(data, dst_data_ptr, [this](std::function<void()> fn) {
+        eigen_intraop_pool_->Schedule(std::move(fn));
+      });
       if (on_done_with_host_buffer) {
         on_done_with_host_buffer();
         on_done_with_host_buffer = nullptr;
@@ -1457,7 +1482,6 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   run_options.set_device_ordinal(device->local_hardware_id());
   // Need to keep device_assignment alive until execution completes.
   run_options.set_device_assignment(device_assignment.get());
-  run_options.set_intra_op_thread_pool(client_->eigen_intraop_device());
 
   // Schedule only one collective at a time.
   bool is_a_collective_launch = !!last_collective_launch_event;
@@ -1486,9 +1510,11 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
     XlaCustomCallStatus status;
 
     // Call generated function.
+    run_options.set_intra_op_thread_pool(client_->StartExecution());
     cpu_executable->compute_function()(result_buffer, &run_options, nullptr,
                                        buffer_pointers.data(), &status,
                                        nullptr);
+    client_->FinishExecution();
 
     for (auto& donation_transaction : donation_transactions) {
       std::move(donation_transaction).Commit();
@@ -1515,7 +1541,7 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
         CopyAsyncValues(input_deps);
     EnqueueWorkWhenReady(
         host_context, input_deps,
-        [cpu_executable, result_buffer,
+        [client = client_, cpu_executable, result_buffer,
          buffer_pointers = std::move(buffer_pointers),
          buffer_table = std::move(buffer_table),
          run_options = std::move(run_options),
@@ -1542,9 +1568,11 @@ StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
           XlaCustomCallStatus status;
 
           // Call generated function.
+          run_options.set_intra_op_thread_pool(client->StartExecution());
           cpu_executable->compute_function()(result_buffer, &run_options,
                                              nullptr, buffer_pointers.data(),
                                              &status, nullptr);
+          client->FinishExecution();
 
           std::optional<absl::string_view> error_message =
               xla::CustomCallStatusGetMessage(&status);
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_PJRT_TFRT_CPU_PJRT_CLIENT_H_
 #define TENSORFLOW_COMPILER_XLA_PJRT_TFRT_CPU_PJRT_CLIENT_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -229,6 +230,20 @@ class TfrtCpuClient final : public PjRtClient {
     return eigen_intraop_device_.get();
   }
 
+  // Registers an execution that is about to run and returns the Eigen device
+  // it should use for intra-op parallelism, including the parallel fork-join
+  // of the XLA CPU runtime. All executions share `eigen_intraop_pool_`, so
+  // rather than letting every execution parallelize across all of its threads
+  // and compete for cores, each running execution is given an equal share of
+  // the threads. Executions waiting for their inputs are not counted. Every
+  // call must be paired with a call to `FinishExecution()`.
+  Eigen::ThreadPoolDevice* StartExecution();
+  void FinishExecution();
+
+  int num_running_executions() const {
+    return num_running_executions_.load(std::memory_order_relaxed);
+  }
+
   tfrt::AsyncValueRef<CpuEvent> GetLastCollectiveLaunchEvent() {
     absl::MutexLock lock(&mu_);
     return last_collective_launch_event_.CopyRef();
@@ -255,6 +270,10 @@ class TfrtCpuClient final : public PjRtClient {
   // TODO(zhangqiaorjc): Use tfrt::compat::EigenHostContextThreadPool.
   std::unique_ptr<tensorflow::thread::ThreadPool> eigen_intraop_pool_;
   std::unique_ptr<Eigen::ThreadPoolDevice> eigen_intraop_device_;
+  // `eigen_intraop_devices_[i]` schedules onto `eigen_intraop_pool_` with a
+  // parallelism of `i + 1` threads.
+  std::vector<std::unique_ptr<Eigen::ThreadPoolDevice>> eigen_intraop_devices_;
+  std::atomic<int> num_running_executions_{0};
 
   // Launching collectives are prone to deadlock when we use fixed-sized
   // threadpools since ExecuteHelper will block until all replicas reach the
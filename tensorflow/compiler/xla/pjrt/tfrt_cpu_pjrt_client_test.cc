@@ -72,5 +72,33 @@ ENTRY DonationWithExecutionError() -> f32[2, 2] {
               ::testing::HasSubstr("Donation requested for invalid buffer"));
 }
 
+TEST(TfrtCpuClientTest, SplitsIntraOpThreadsBetweenRunningExecutions) {
+  TF_ASSERT_OK_AND_ASSIGN(auto pjrt_client,
+                          GetTfrtCpuClient(/*asynchronous=*/true));
+  auto* client = static_cast<TfrtCpuClient*>(pjrt_client.get());
+  const int num_threads = client->eigen_intraop_device()->numThreads();
+
+  Eigen::ThreadPoolDevice* first = client->StartExecution();
+  EXPECT_EQ(first->numThreads(), num_threads);
+  EXPECT_EQ(client->num_running_executions(), 1);
+
+  Eigen::ThreadPoolDevice* second = client->StartExecution();
+  EXPECT_EQ(second->numThreads(), (num_threads + 1) / 2);
+  EXPECT_EQ(client->num_running_executions(), 2);
+
+  // Executions never get less than one thread, however many are running.
+  std::vector<Eigen::ThreadPoolDevice*> more;
+  for (int i = 0; i < num_threads; ++i) {
+    more.push_back(client->StartExecution());
+  }
+  EXPECT_EQ(more.back()->numThreads(), 1);
+  for (int i = 0; i < num_threads + 1; ++i) {
+    client->FinishExecution();
+  }
+  EXPECT_EQ(client->StartExecution()->numThreads(), num_threads);
+  client->FinishExecution();
+  EXPECT_EQ(client->num_running_executions(), 0);
+}
+
 }  // namespace
 }  // namespace xla
@@ -1109,16 +1109,24 @@ void TransposePlan::Initialize() {
         max_inner_block_elems = 16;
         break;
       case 2:
-        min_inner_block_elems = 8;
+        min_inner_block_elems = 4;
         max_inner_block_elems = 8;
         break;
       case 4:
         min_inner_block_elems = 4;
+#ifdef EIGEN_VECTORIZE_AVX512
+        max_inner_block_elems = 16;
+#else
         max_inner_block_elems = 8;
+#endif
         break;
       case 8:
         min_inner_block_elems = 2;
+#ifdef EIGEN_VECTORIZE_AVX512
+        max_inner_block_elems = 8;
+#else
         max_inner_block_elems = 4;
+#endif
         break;
       case 16:
         min_inner_block_elems = 1;
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_PJRT_TRANSPOSE_KERNELS_H_
 #define TENSORFLOW_COMPILER_XLA_PJRT_TRANSPOSE_KERNELS_H_
 
+#include <array>
 #include <cstdint>
 
 #include "third_party/eigen3/Eigen/Core"
@@ -69,7 +70,43 @@ struct TransposeMicroKernel<uint8_t, /*bs=*/4> {
   }
 };
 
-// TODO(phawkins): add an 8x8 byte transpose kernel.
+template <>
+struct TransposeMicroKernel<uint8_t, /*bs=*/8> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    std::array<__m128i, 8> packet;
+    for (int i = 0; i < 8; ++i) {
+      packet[i] =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + lda * i));
+    }
+    // 00 10 01 11 02 12 03 13 04 14 05 15 06 16 07 17
+    __m128i t0 = _mm_unpacklo_epi8(packet[0], packet[1]);
+    // 20 30 21 31 22 32 23 33 24 34 25 35 26 36 27 37
+    __m128i t1 = _mm_unpacklo_epi8(packet[2], packet[3]);
+    __m128i t2 = _mm_unpacklo_epi8(packet[4], packet[5]);
+    __m128i t3 = _mm_unpacklo_epi8(packet[6], packet[7]);
+
+    // 00 10 20 30 01 11 21 31 02 12 22 32 03 13 23 33
+    __m128i s0 = _mm_unpacklo_epi16(t0, t1);
+    // 04 14 24 34 05 15 25 35 06 16 26 36 07 17 27 37
+    __m128i s1 = _mm_unpackhi_epi16(t0, t1);
+    __m128i s2 = _mm_unpacklo_epi16(t2, t3);
+    __m128i s3 = _mm_unpackhi_epi16(t2, t3);
+
+    // 00 10 20 30 40 50 60 70 01 11 21 31 41 51 61 71
+    packet[0] = _mm_unpacklo_epi32(s0, s2);
+    // 02 12 22 32 42 52 62 72 03 13 23 33 43 53 63 73
+    packet[2] = _mm_unpackhi_epi32(s0, s2);
+    packet[4] = _mm_unpacklo_epi32(s1, s3);
+    packet[6] = _mm_unpackhi_epi32(s1, s3);
+    for (int i = 0; i < 8; i += 2) {
+      packet[i + 1] = _mm_unpackhi_epi64(packet[i], packet[i]);
+    }
+    for (int i = 0; i < 8; ++i) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(b + ldb * i), packet[i]);
+    }
+  }
+};
 
 // TODO(phawkins): Eigen doesn't have a SSE/AVX byte Packet16c type. Add one
 // and call it here rather than using AVX intrinsics.
@@ -183,7 +220,30 @@ struct TransposeMicroKernel<uint8_t, /*bs=*/16> {
   }
 };
 
-// TODO(phawkins): add an 4x4 uint16_t transpose kernel.
+template <>
+struct TransposeMicroKernel<uint16_t, /*bs=*/4> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    std::array<__m128i, 4> packet;
+    for (int i = 0; i < 4; ++i) {
+      packet[i] =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + lda * i));
+    }
+    // 00 10 01 11 02 12 03 13
+    __m128i t0 = _mm_unpacklo_epi16(packet[0], packet[1]);
+    // 20 30 21 31 22 32 23 33
+    __m128i t1 = _mm_unpacklo_epi16(packet[2], packet[3]);
+    // 00 10 20 30 01 11 21 31
+    packet[0] = _mm_unpacklo_epi32(t0, t1);
+    // 02 12 22 32 03 13 23 33
+    packet[2] = _mm_unpackhi_epi32(t0, t1);
+    packet[1] = _mm_unpackhi_epi64(packet[0], packet[0]);
+    packet[3] = _mm_unpackhi_epi64(packet[2], packet[2]);
+    for (int i = 0; i < 4; ++i) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(b + ldb * i), packet[i]);
+    }
+  }
+};
 
 template <>
 struct TransposeMicroKernel<uint16_t, /*bs=*/8> {
@@ -285,6 +345,50 @@ struct TransposeMicroKernel<uint64_t, /*bs=*/4> {
   }
 };
 
+#ifdef EIGEN_VECTORIZE_AVX512
+
+template <>
+struct TransposeMicroKernel<uint32_t, /*bs=*/16> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet16f;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 16;
+    PacketBlock<Packet16f, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet16f>(
+          reinterpret_cast<const float*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<float>(reinterpret_cast<float*>(b + ldb * i),
+                                      block.packet[i]);
+    }
+  }
+};
+
+template <>
+struct TransposeMicroKernel<uint64_t, /*bs=*/8> {
+  static void Apply(const char* __restrict a, int64_t lda, char* __restrict b,
+                    int64_t ldb) {
+    using Eigen::internal::Packet8d;
+    using Eigen::internal::PacketBlock;
+    constexpr int bs = 8;
+    PacketBlock<Packet8d, bs> block;
+    for (int i = 0; i < bs; ++i) {
+      block.packet[i] = Eigen::internal::ploadu<Packet8d>(
+          reinterpret_cast<const double*>(a + lda * i));
+    }
+    Eigen::internal::ptranspose(block);
+    for (int i = 0; i < bs; ++i) {
+      Eigen::internal::pstoreu<double>(reinterpret_cast<double*>(b + ldb * i),
+                                       block.packet[i]);
+    }
+  }
+};
+
+#endif  // EIGEN_VECTORIZE_AVX512
+
 #endif  // EIGEN_VECTORIZE_AVX
 
 }  // namespace xla
@@ -300,6 +300,8 @@ std::vector<TransposeTestCase> GetTransposeTestCases() {
       TransposeTestCase(/*dims=*/{16, 16}, /*permutation=*/{1, 0}),
       TransposeTestCase(/*dims=*/{11, 15}, /*permutation=*/{0, 1}),
       TransposeTestCase(/*dims=*/{11, 15}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{6, 12}, /*permutation=*/{1, 0}),
+      TransposeTestCase(/*dims=*/{40, 24}, /*permutation=*/{1, 0}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{0, 1, 2}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{0, 2, 1}),
       TransposeTestCase(/*dims=*/{11, 15, 13}, /*permutation=*/{1, 2, 0}),
@@ -391,7 +393,9 @@ TEST_P(TransposeTest, TransposeInt64) { TestTranspose<int64_t>(1); }
 TEST_P(TransposeTest, TransposeInt128) { TestTranspose<absl::int128>(1); }
 
 TEST_P(TransposeTest, ParallelTransposeInt8) { TestTranspose<int8_t>(16); }
+TEST_P(TransposeTest, ParallelTransposeInt16) { TestTranspose<int16_t>(16); }
 TEST_P(TransposeTest, ParallelTransposeInt32) { TestTranspose<int32_t>(16); }
+TEST_P(TransposeTest, ParallelTransposeInt64) { TestTranspose<int64_t>(16); }
 
 INSTANTIATE_TEST_SUITE_P(TransposeTestInstance, TransposeTest,
                          ::testing::ValuesIn(GetTransposeTestCases()));
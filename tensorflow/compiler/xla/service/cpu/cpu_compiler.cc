@@ -21,6 +21,7 @@ limitations under the License.
 #include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stack>
 #include <string>
 #include <tuple>
@@ -37,6 +38,8 @@ limitations under the License.
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Mangler.h"
@@ -47,9 +50,11 @@ limitations under the License.
 #include "llvm/Support/CodeGen.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"  // from @llvm-project
 #include "mlir/Conversion/ArithmeticToLLVM/ArithmeticToLLVM.h"  // from @llvm-project
 #include "mlir/Conversion/BufferizationToMemRef/BufferizationToMemRef.h"  // from @llvm-project
@@ -105,6 +110,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/bitcast_dtypes_expander.h"
 #include "tensorflow/compiler/xla/service/broadcast_canonicalizer.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
+#include "tensorflow/compiler/xla/service/call_graph.h"
 #include "tensorflow/compiler/xla/service/call_inliner.h"
 #include "tensorflow/compiler/xla/service/change_op_data_type.h"
 #include "tensorflow/compiler/xla/service/cholesky_expander.h"
@@ -191,6 +197,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -1111,10 +1118,131 @@ std::vector<ComputationToEmit> SubcomputationEmissionOrder(
   return postorder;
 }
 
+// Splits `llvm_module` into up to `num_partitions` modules, compiles them
+// concurrently on `thread_pool` and adds the resulting object files to `jit`.
+//
+// The module must have been emitted such that every function called from
+// another partition has external linkage. Functions with internal linkage, such
+// as reduction computations, stay in the same partition as their callers so
+// that they can be inlined.
+Status CompileModuleInParallel(std::unique_ptr<llvm::Module> llvm_module,
+                               int num_partitions,
+                               tensorflow::thread::ThreadPool* thread_pool,
+                               SimpleOrcJIT* jit) {
+  XLA_SCOPED_LOGGING_TIMER("CpuCompiler - Compiling LLVM IR in parallel");
+  // Constants that are small enough are copied into every partition that uses
+  // them, so that they can still be constant folded. Larger constants become
+  // external globals, defined in a single partition.
+  constexpr int64_t kMaxCopiedConstantBytes = 1024;
+  llvm::DenseMap<llvm::StringRef, llvm::Constant*> const_initializer_map;
+  const llvm::DataLayout& data_layout = llvm_module->getDataLayout();
+  for (llvm::GlobalVariable& gv : llvm_module->globals()) {
+    if (!gv.hasInitializer() || !gv.hasLocalLinkage()) {
+      continue;
+    }
+    if (!gv.hasName()) {
+      gv.setName("__xla_global");
+    }
+    gv.setLinkage(llvm::GlobalValue::ExternalLinkage);
+    if (gv.isConstant() && data_layout.getTypeAllocSize(gv.getValueType()) <=
+                               kMaxCopiedConstantBytes) {
+      const_initializer_map[gv.getName()] = gv.getInitializer();
+    }
+  }
+
+  // Serialize the partitions to bitcode, so that each of them can be loaded in
+  // its own LLVM context, as contexts are not thread safe.
+  std::vector<std::string> bitcodes;
+  llvm::SplitModule(
+      *llvm_module, num_partitions,
+      [&](std::unique_ptr<llvm::Module> module) {
+        for (llvm::GlobalVariable& gv : module->globals()) {
+          auto it = const_initializer_map.find(gv.getName());
+          if (!gv.hasInitializer() && it != const_initializer_map.end()) {
+            gv.setInitializer(it->second);
+            gv.setLinkage(llvm::GlobalValue::InternalLinkage);
+          }
+        }
+        std::string& bitcode = bitcodes.emplace_back();
+        llvm::raw_string_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(*module, os);
+      },
+      /*PreserveLocals=*/true);
+  VLOG(2) << "Split the LLVM module into " << bitcodes.size() << " modules";
+
+  std::vector<StatusOr<std::unique_ptr<llvm::MemoryBuffer>>> object_files(
+      bitcodes.size());
+  tensorflow::BlockingCounter counter(bitcodes.size());
+  for (int i = 0; i < bitcodes.size(); ++i) {
+    thread_pool->Schedule([&, i] {
+      llvm::LLVMContext context;
+      llvm::Expected<std::unique_ptr<llvm::Module>> module =
+          llvm::parseBitcodeFile(
+              llvm::MemoryBufferRef(bitcodes[i], "__compute_module"), context);
+      if (!module) {
+        object_files[i] = InternalError("Failed to parse LLVM module: %s",
+                                        llvm::toString(module.takeError()));
+      } else {
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object_file =
+            jit->CompileModule(**module);
+        if (!object_file) {
+          object_files[i] =
+              InternalError("Failed to compile LLVM module: %s",
+                            llvm::toString(object_file.takeError()));
+        } else {
+          object_files[i] = std::move(*object_file);
+        }
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+
+  for (StatusOr<std::unique_ptr<llvm::MemoryBuffer>>& object_file :
+       object_files) {
+    TF_RETURN_IF_ERROR(object_file.status());
+    if (llvm::Error error = jit->AddObjectFile(std::move(*object_file))) {
+      return InternalError("Failed to add object file to the JIT: %s",
+                           llvm::toString(std::move(error)));
+    }
+  }
+  return OkStatus();
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<CpuExecutable>>
-CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
+CpuCompiler::CompileLegacyCpuExecutable(
+    std::unique_ptr<HloModule> module,
+    tensorflow::thread::ThreadPool* thread_pool) {
+  std::optional<tensorflow::thread::ThreadPool> overriding_thread_pool;
+  switch (module->config()
+              .debug_options()
+              .xla_cpu_force_compilation_parallelism()) {
+    case 0:
+      break;
+    case 1:
+      thread_pool = nullptr;
+      break;
+    default:
+      overriding_thread_pool.emplace(
+          tensorflow::Env::Default(), "xla_cpu_compilation",
+          module->config()
+              .debug_options()
+              .xla_cpu_force_compilation_parallelism());
+      thread_pool = &*overriding_thread_pool;
+      break;
+  }
+  // Splitting the LLVM module would run the IR hooks, which also dump the IR,
+  // once per partition.
+  const bool compile_in_parallel =
+      thread_pool != nullptr && thread_pool->NumThreads() > 1 &&
+      !user_pre_optimization_hook_ && !user_post_optimization_hook_ &&
+      !DumpingEnabledForHloModule(*module);
+  // Number of functions with external linkage that can be compiled
+  // independently.
+  int num_external_functions = 0;
+
   ModuleHook pre_optimization_ir_hook;
   ModuleHook post_optimization_ir_hook;
   std::tie(pre_optimization_ir_hook, post_optimization_ir_hook) =
@@ -1221,20 +1349,31 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 
     TF_RETURN_IF_ERROR(ir_emitter.EmitConstantGlobals());
 
+    std::unique_ptr<CallGraph> call_graph;
+    if (compile_in_parallel) {
+      call_graph = CallGraph::Build(module.get());
+    }
     for (ComputationToEmit subcomputation :
          SubcomputationEmissionOrder(entry_computation)) {
       if (subcomputation.computation->IsFusionComputation()) {
         continue;
       }
-      TF_RETURN_IF_ERROR(
-          ir_emitter
-              .EmitComputation(
-                  subcomputation.computation,
-                  subcomputation.computation->name(),
-                  /*is_top_level_computation=*/false,
-                  schedule.sequence(subcomputation.computation).instructions(),
-                  subcomputation.allow_reassociation)
-              .status());
+      TF_ASSIGN_OR_RETURN(
+          llvm::Function * function,
+          ir_emitter.EmitComputation(
+              subcomputation.computation, subcomputation.computation->name(),
+              /*is_top_level_computation=*/false,
+              schedule.sequence(subcomputation.computation).instructions(),
+              subcomputation.allow_reassociation));
+      // Computations called from control flow, such as while loop bodies and
+      // parallel tasks, can be compiled in a different module than their
+      // callers. Computations called per element, such as reductions, are
+      // better left with their callers to be inlined.
+      if (call_graph && call_graph->GetNode(subcomputation.computation)
+                                .context() == CallContext::kControlFlow) {
+        function->setLinkage(llvm::GlobalValue::ExternalLinkage);
+        ++num_external_functions;
+      }
     }
     std::string function_name_prefix = entry_computation->name().empty()
                                            ? "__compute"
@@ -1245,6 +1384,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
                             /*is_top_level_computation=*/true,
                             schedule.sequence(entry_computation).instructions(),
                             /*allow_reassociation=*/false));
+    ++num_external_functions;
 
     function_name = [&]() {
       llvm::SmallVector<char, 40> function_name_vector;
@@ -1264,9 +1404,16 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   TF_RETURN_IF_ERROR(VerifyLlvmModule(*llvm_module));
 
   // JIT compile the LLVM IR module to in-memory machine code.
-  llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
-                                                 std::move(llvm_context));
-  cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  if (compile_in_parallel && num_external_functions > 1) {
+    TF_RETURN_IF_ERROR(CompileModuleInParallel(
+        std::move(llvm_module),
+        std::min(thread_pool->NumThreads(), num_external_functions),
+        thread_pool, jit->get()));
+  } else {
+    llvm::orc::ThreadSafeModule thread_safe_module(std::move(llvm_module),
+                                                   std::move(llvm_context));
+    cantFail((*jit)->AddModule(std::move(thread_safe_module)));
+  }
 
   auto cpu_executable = std::make_unique<CpuExecutable>(
       std::move(*jit), std::move(assignment), std::move(module), function_name,
@@ -1293,7 +1440,7 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
 StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
     std::unique_ptr<HloModule> module,
     [[maybe_unused]] se::StreamExecutor* stream_exec,
-    [[maybe_unused]] const CompileOptions& options) {
+    const CompileOptions& options) {
   VLOG(1) << "Compiling: " << module->name();
   XLA_SCOPED_LOGGING_TIMER(
       absl::StrFormat("Compiling [%s] for CPU using JIT", module->name()));
@@ -1306,7 +1453,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   std::unique_ptr<CpuExecutable> cpu_executable;
   TF_ASSIGN_OR_RETURN(cpu_executable,
-                      CompileLegacyCpuExecutable(std::move(module)));
+                      CompileLegacyCpuExecutable(std::move(module),
+                                                 options.thread_pool));
 
   cpu_executable->set_debug_info(
       cpu_executable->buffer_assignment().GetStats().ToString());
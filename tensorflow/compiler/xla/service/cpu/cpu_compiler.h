@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_compiler.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace xla {
 namespace cpu {
@@ -175,8 +176,11 @@ class CpuCompiler : public LLVMCompiler {
       HloModule* module, bool is_aot_compile,
       LLVMTargetMachineFeatures* target_machine_features, bool is_mlir_compile);
 
+  // Compiles `module` to a CpuExecutable. If `thread_pool` is not null, it may
+  // be used to compile the LLVM IR in parallel.
   StatusOr<std::unique_ptr<CpuExecutable>> CompileLegacyCpuExecutable(
-      std::unique_ptr<HloModule> module);
+      std::unique_ptr<HloModule> module,
+      tensorflow::thread::ThreadPool* thread_pool);
 
   CpuCompiler(const CpuCompiler&) = delete;
   CpuCompiler& operator=(const CpuCompiler&) = delete;
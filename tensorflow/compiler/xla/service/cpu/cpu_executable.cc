@@ -30,6 +30,7 @@ limitations under the License.
 #include "llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "tensorflow/compiler/xla/service/buffer_assignment.h"
 #include "tensorflow/compiler/xla/service/computation_layout.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/logical_buffer.h"
@@ -212,6 +213,21 @@ Status CpuExecutable::ExecuteComputeFunction(
     return InternalError("CustomCall failed: %s", *error_message);
   }
 
+  // Save the profile for the parallel task assignment of later compilations.
+  if (hlo_execution_profile && has_module()) {
+    const std::string profile_path =
+        options::ParallelTaskProfilePath(module_config(), module().name());
+    if (!profile_path.empty()) {
+      Status write_status = tensorflow::WriteBinaryProto(
+          tensorflow::Env::Default(), profile_path,
+          hlo_execution_profile->ToProto());
+      if (!write_status.ok()) {
+        LOG(WARNING) << "Failed to save the execution profile to "
+                     << profile_path << ": " << write_status;
+      }
+    }
+  }
+
   return OkStatus();
 }
 
@@ -16,7 +16,10 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace {
 
@@ -98,6 +101,18 @@ std::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
                                                tile_size_n_in_vector_width);
 }
 
+std::string ParallelTaskProfilePath(const HloModuleConfig& config,
+                                    absl::string_view module_name) {
+  const std::string& profile_dir =
+      config.debug_options().xla_cpu_parallel_task_profile_dir();
+  if (profile_dir.empty()) {
+    return "";
+  }
+  return tensorflow::io::JoinPath(
+      profile_dir, absl::StrCat(absl::StrReplaceAll(module_name, {{"/", "_"}}),
+                                ".hlo_execution_profile_data"));
+}
+
 }  // namespace options
 }  // namespace cpu
 }  // namespace xla
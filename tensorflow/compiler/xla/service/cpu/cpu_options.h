@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_OPTIONS_H_
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_CPU_OPTIONS_H_
 
+#include <string>
+
+#include "absl/strings/string_view.h"
 #include "tensorflow/compiler/xla/service/hlo_module_config.h"
 
 // Helper functions for querying options that are specific to the CPU backend.
@@ -30,6 +33,11 @@ bool ForceEnableExperimentalLlvmIrGemm(const HloModuleConfig& config);
 std::optional<int64_t> LlvmIrGemvTilingFactor(const HloModuleConfig& config);
 std::optional<std::tuple<int64_t, int64_t, int64_t>> LlvmIrGemmTileSize(
     const HloModuleConfig& config);
+// Returns the path of the execution profile of the module called `module_name`
+// used for the parallel task assignment, or an empty string if profile guided
+// parallel task assignment is disabled.
+std::string ParallelTaskProfilePath(const HloModuleConfig& config,
+                                    absl::string_view module_name);
 
 }  // namespace options
 }  // namespace cpu
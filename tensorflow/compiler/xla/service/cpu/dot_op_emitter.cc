@@ -209,10 +209,25 @@ class DotOpEmitter {
     //
     // TODO(b/80093688): Tune for other architectures and centralize this
     // information in one place.
-    const std::tuple<int64_t, int64_t, int64_t> kDefaultTileSize =
+    std::tuple<int64_t, int64_t, int64_t> default_tile_size =
         std::tuple<int64_t, int64_t, int64_t>(11, 9, 1);
+
+    // Targets with 32 vector registers (AVX-512, whether or not LLVM prefers
+    // 512 bit vectors) use the register blocking of the usual AVX-512 GEMM
+    // micro-kernels: the accumulators for tile_size_m rows of two vectors each
+    // stay in registers, leaving 4 registers for the RHS vectors and the LHS
+    // broadcasts.
+    constexpr int64_t kAvx512VectorRegisterCount = 32;
+    if (target_machine_features_.vector_register_count(
+            *b_->GetInsertBlock()->getParent()) >=
+        kAvx512VectorRegisterCount) {
+      constexpr int64_t kVectorsPerRow = 2;
+      default_tile_size = std::tuple<int64_t, int64_t, int64_t>(
+          (kAvx512VectorRegisterCount - 4) / kVectorsPerRow, 4,
+          kVectorsPerRow);
+    }
     return options::LlvmIrGemmTileSize(hlo_module_config_)
-        .value_or(kDefaultTileSize);
+        .value_or(default_tile_size);
   }
 
   std::array<int64_t, 3> GetMlirGemmTileSize() const {
@@ -58,6 +58,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_function.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_loop_emitter.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_key_value_sort.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
@@ -556,6 +557,56 @@ Status IrEmitter::HandleOutfeed(HloInstruction* outfeed) {
   return OkStatus();
 }
 
+namespace {
+
+// Returns how the comparator of `sort` compares the keys, if it only compares
+// them with < or >, in which case `descending` is set to whether it is >.
+SortKeyType GetSortKeyType(const HloSortInstruction& sort, bool* descending) {
+  const HloInstruction* root = sort.to_apply()->root_instruction();
+  if (root->opcode() != HloOpcode::kCompare ||
+      root->operand(0)->opcode() != HloOpcode::kParameter ||
+      root->operand(1)->opcode() != HloOpcode::kParameter) {
+    return SortKeyType::kComparator;
+  }
+  const int64_t lhs = root->operand(0)->parameter_number();
+  const int64_t rhs = root->operand(1)->parameter_number();
+  const auto* compare = Cast<HloCompareInstruction>(root);
+  bool greater;
+  switch (compare->direction()) {
+    case ComparisonDirection::kLt:
+      greater = false;
+      break;
+    case ComparisonDirection::kGt:
+      greater = true;
+      break;
+    default:
+      return SortKeyType::kComparator;
+  }
+  if (lhs == 0 && rhs == 1) {
+    *descending = greater;
+  } else if (lhs == 1 && rhs == 0) {
+    *descending = !greater;
+  } else {
+    return SortKeyType::kComparator;
+  }
+
+  const PrimitiveType key_type = sort.keys()->shape().element_type();
+  if (primitive_util::IsSignedIntegralType(key_type)) {
+    return SortKeyType::kSigned;
+  }
+  if (primitive_util::IsUnsignedIntegralType(key_type)) {
+    return SortKeyType::kUnsigned;
+  }
+  if (key_type == F32 || key_type == F64) {
+    return compare->order() == ComparisonOrder::kTotal
+               ? SortKeyType::kFloatTotalOrder
+               : SortKeyType::kFloat;
+  }
+  return SortKeyType::kComparator;
+}
+
+}  // namespace
+
 Status IrEmitter::HandleSort(HloInstruction* hlo) {
   const HloSortInstruction* sort = Cast<HloSortInstruction>(hlo);
   TF_RETURN_IF_ERROR(EmitTargetAddressForOp(sort));
@@ -638,13 +689,16 @@ Status IrEmitter::HandleSort(HloInstruction* hlo) {
   auto less_than_function =
       FindOrDie(emitted_functions_,
                 ComputationToEmit{sort->to_apply(), allow_reassociation_});
+  bool descending = false;
+  const SortKeyType key_type = GetSortKeyType(*sort, &descending);
   EmitCallToFunc(
       runtime::kKeyValueSortSymbolName,
       {b_.getInt64(higher_dimensions), b_.getInt64(sort_dimension_elements),
        b_.getInt64(lower_dimensions), values,
        b_.getInt32(sort->operand_count()), sizes, b_.getInt1(sort->is_stable()),
        GetExecutableRunOptionsArgument(), GetProfileCountersArgument(),
-       less_than_function},
+       less_than_function, b_.getInt32(static_cast<int32_t>(key_type)),
+       b_.getInt1(descending)},
       b_.getVoidTy());
 
   if (sort->values_count() > 0) {
@@ -16,15 +16,22 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 
 #include <memory>
+#include <string>
+#include <utility>
 
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/compiler/xla/service/cpu/cpu_options.h"
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile_data.pb.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/dynamic_update_slice_util.h"
+#include "tensorflow/core/platform/env.h"
 
 namespace xla {
 namespace cpu {
@@ -109,6 +116,85 @@ class DefaultCostModel : public ParallelCostModel {
   const std::unique_ptr<HloCostAnalysis> cost_analysis_;
 };
 
+// Cost model based on the cycles measured by an execution profile of the
+// module, for the instructions of the entry computation. Instructions in other
+// computations, such as while loop bodies, only have their cumulative cycles
+// over all the executions of the computation, and use `fallback_cost_model`.
+class ProfileGuidedCostModel : public ParallelCostModel {
+ public:
+  ProfileGuidedCostModel(
+      const int64_t max_parallelism, const HloComputation* entry_computation,
+      absl::flat_hash_map<std::string, int64_t> cycles_by_instruction,
+      std::unique_ptr<ParallelCostModel> fallback_cost_model)
+      : max_parallelism_(max_parallelism),
+        entry_computation_(entry_computation),
+        cycles_by_instruction_(std::move(cycles_by_instruction)),
+        fallback_cost_model_(std::move(fallback_cost_model)) {}
+  ~ProfileGuidedCostModel() override {}
+
+  int64_t GetParallelTaskCount(HloInstruction* instruction) override {
+    auto it = cycles_by_instruction_.find(instruction->name());
+    if (instruction->parent() != entry_computation_ ||
+        it == cycles_by_instruction_.end()) {
+      return fallback_cost_model_->GetParallelTaskCount(instruction);
+    }
+    // Minimum per-thread cost is 100us of work on a 2GHz core, as in
+    // DefaultCostModel.
+    const int64_t min_cycles_per_thread = 100000;
+    // Return target parallel task count in [1, max_parallelism_].
+    return std::min(max_parallelism_,
+                    std::max(int64_t{1}, it->second / min_cycles_per_thread));
+  }
+
+ private:
+  const int64_t max_parallelism_;
+  const HloComputation* entry_computation_;
+  const absl::flat_hash_map<std::string, int64_t> cycles_by_instruction_;
+  const std::unique_ptr<ParallelCostModel> fallback_cost_model_;
+};
+
+namespace {
+
+// Returns the name of the instruction printed in `short_name`, which looks like
+// "[ROOT ]%name = ...".
+absl::string_view InstructionName(absl::string_view short_name) {
+  absl::ConsumePrefix(&short_name, "ROOT ");
+  absl::ConsumePrefix(&short_name, "%");
+  return short_name.substr(0, short_name.find(' '));
+}
+
+// Returns the cycles taken by each instruction of the module in `profile`,
+// summed over all the tasks it ran as. Instructions that were assigned parallel
+// tasks when the profile was collected were outlined into a computation called
+// "parallel_<name>", whose cycles are used instead.
+absl::flat_hash_map<std::string, int64_t> CyclesByInstruction(
+    const HloExecutionProfileData& profile) {
+  absl::flat_hash_map<std::string, int64_t> cycles_by_instruction;
+  auto get_counter = [&](int64_t index) -> int64_t {
+    return index >= 0 && index < profile.profile_counters_size()
+               ? profile.profile_counters(index)
+               : 0;
+  };
+  for (const HloProfilePrinterData::HloComputationInfo& computation_info :
+       profile.printer_data().computation_infos()) {
+    absl::string_view outlined_name = computation_info.name();
+    if (absl::ConsumePrefix(&outlined_name, "parallel_")) {
+      cycles_by_instruction[std::string(outlined_name)] =
+          get_counter(computation_info.profile_index());
+      continue;
+    }
+    for (const HloProfilePrinterData::HloInstructionInfo& instruction_info :
+         computation_info.instruction_infos()) {
+      cycles_by_instruction.emplace(
+          InstructionName(instruction_info.short_name()),
+          get_counter(instruction_info.profile_index()));
+    }
+  }
+  return cycles_by_instruction;
+}
+
+}  // namespace
+
 ParallelTaskAssignment::ParallelTaskAssignment(
     const int64_t max_parallelism,
     const HloCostAnalysis::ShapeSizeFunction& shape_size, HloModule* module,
@@ -129,6 +215,26 @@ ParallelTaskAssignment::ParallelTaskAssignment(
     // HLOs like CustomCall are not yet implemented in the HloCostAnalysis).
     cost_model_.reset(new SimpleCostModel(max_parallelism, shape_size));
   }
+
+  // Use the measured cycles of the instructions if a profile was saved by an
+  // earlier execution of the module.
+  const std::string profile_path =
+      options::ParallelTaskProfilePath(module->config(), module->name());
+  if (!profile_path.empty() &&
+      tensorflow::Env::Default()->FileExists(profile_path).ok()) {
+    HloExecutionProfileData profile;
+    status = tensorflow::ReadBinaryProto(tensorflow::Env::Default(),
+                                         profile_path, &profile);
+    if (status.ok()) {
+      VLOG(1) << "ParallelTaskAssignment using the profile " << profile_path;
+      cost_model_ = std::make_unique<ProfileGuidedCostModel>(
+          max_parallelism, computation, CyclesByInstruction(profile),
+          std::move(cost_model_));
+    } else {
+      LOG(WARNING) << "Failed to read the execution profile " << profile_path
+                   << ": " << status;
+    }
+  }
 }
 
 int64_t ParallelTaskAssignment::GetTargetParallelTaskCount(
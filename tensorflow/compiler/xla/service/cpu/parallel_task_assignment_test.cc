@@ -17,9 +17,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/cpu_executable.h"
 #include "tensorflow/compiler/xla/service/cpu/target_machine_features_fake.h"
+#include "tensorflow/compiler/xla/service/hlo_execution_profile_data.pb.h"
 #include "tensorflow/compiler/xla/test.h"
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
 
 namespace xla {
 namespace {
@@ -45,6 +48,39 @@ class ParallelTaskAssignmentTest : public HloTestBase {
                                      &target_machine_features_)
         .Run(module);
   }
+
+  // Runs the ParallelTaskAssigner on `module` with a saved profile in which
+  // the instruction called `instruction_name` of the entry computation took
+  // `cycles`.
+  StatusOr<bool> RunParallelTaskAssignerWithProfile(
+      HloModule* module, const std::string& instruction_name, int64_t cycles) {
+    HloExecutionProfileData profile;
+    HloProfilePrinterData::HloComputationInfo* computation_info =
+        profile.mutable_printer_data()->add_computation_infos();
+    computation_info->set_name(module->entry_computation()->name());
+    computation_info->set_profile_index(0);
+    HloProfilePrinterData::HloInstructionInfo* instruction_info =
+        computation_info->add_instruction_infos();
+    instruction_info->set_short_name(
+        absl::StrCat("ROOT %", instruction_name, " = f32[] parameter(0)"));
+    instruction_info->set_profile_index(1);
+    profile.add_profile_counters(cycles);
+    profile.add_profile_counters(cycles);
+
+    std::string profile_dir = tensorflow::io::JoinPath(
+        ::testing::TempDir(), absl::StrCat("profiles_", module->unique_id()));
+    TF_RETURN_IF_ERROR(
+        tensorflow::Env::Default()->RecursivelyCreateDir(profile_dir));
+    DebugOptions debug_options = module->config().debug_options();
+    debug_options.set_xla_cpu_parallel_task_profile_dir(profile_dir);
+    module->mutable_config().set_debug_options(debug_options);
+    TF_RETURN_IF_ERROR(tensorflow::WriteBinaryProto(
+        tensorflow::Env::Default(),
+        cpu::options::ParallelTaskProfilePath(module->config(),
+                                              module->name()),
+        profile));
+    return RunParallelTaskAssigner(module);
+  }
 };
 
 TEST_F(ParallelTaskAssignmentTest, DotOperationNotParallelized) {
@@ -192,6 +228,43 @@ TEST_F(ParallelTaskAssignmentTest, AllReduceNotParallelized) {
   EXPECT_FALSE(changed);
 }
 
+TEST_F(ParallelTaskAssignmentTest, ProfiledSlowInstructionParallelized) {
+  // Too small to be parallelized by the static cost model.
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_profiled_slow
+    ENTRY entry {
+      p0 = f32[1024] parameter(0)
+      ROOT exp = f32[1024] exponential(p0)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssigner(m.get()));
+  EXPECT_FALSE(changed);
+
+  TF_ASSERT_OK_AND_ASSIGN(m, ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(changed, RunParallelTaskAssignerWithProfile(
+                                       m.get(), "exp", /*cycles=*/10000000));
+  EXPECT_TRUE(changed);
+}
+
+TEST_F(ParallelTaskAssignmentTest, ProfiledFastInstructionNotParallelized) {
+  constexpr char hlo_string[] = R"(
+  HloModule TestTaskParallel_profiled_fast
+    ENTRY entry {
+      p0 = f32[12345678] parameter(0)
+      ROOT neg = f32[12345678] negate(p0)
+    }
+  )";
+
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> m,
+                          ParseAndReturnVerifiedModule(hlo_string));
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunParallelTaskAssignerWithProfile(
+                                            m.get(), "neg", /*cycles=*/1000));
+  EXPECT_FALSE(changed);
+}
+
 TEST_F(ParallelTaskAssignmentTest, ConstantNotParallelized) {
   constexpr char hlo_string[] = R"(
   HloModule TestTaskParallel_constant
@@ -12,22 +12,303 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+
 #include "tensorflow/compiler/xla/service/cpu/runtime_key_value_sort.h"
 
+#define EIGEN_USE_THREADS
+
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <numeric>
-#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "absl/base/dynamic_annotations.h"
+#include "tensorflow/compiler/xla/executable_run_options.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
+namespace {
+
+using xla::cpu::SortKeyType;
+
+using LessThan = void (*)(char*, char*, char**, char**, int64_t*);
+
+// Minimum number of elements of a row for it to be sorted by several threads.
+constexpr int64_t kMinElementsForParallelSort = 16 * 1024;
+// Minimum number of elements of a row for a radix sort of its keys, which has
+// a higher fixed cost than a comparison sort.
+constexpr int64_t kMinElementsForRadixSort = 256;
+// Estimated cost in cycles of a call to 'less_than', for the thread pool.
+constexpr double kCyclesPerComparison = 20;
+
+// The arguments of __xla_cpu_runtime_KeyValueSort that are the same for all
+// the rows.
+struct SortArgs {
+  int64_t sort_dimension_elements;
+  int64_t sort_dimension_offset;
+  char** values;
+  int32_t values_count;
+  int32_t* values_primitive_type_size_in_bytes;
+  bool is_stable;
+  char* run_options;
+  int64_t* prof_counters;
+  LessThan less_than;
+  SortKeyType key_type;
+  bool descending;
+};
+
+// Compares the elements at two indices of a row with 'less_than'. Not
+// thread-safe, as it reuses its buffer of parameters; each thread needs its
+// own instance, which is passed to the algorithms with std::ref.
+class RowComparator {
+ public:
+  RowComparator(const SortArgs& args, int64_t base_offset)
+      : args_(args),
+        base_offset_(base_offset),
+        comparison_values_(new char*[2 * args.values_count]) {}
+
+  bool operator()(int64_t a, int64_t b) const {
+    for (int32_t i = 0; i < args_.values_count; ++i) {
+      int64_t memory_index_lhs =
+          (base_offset_ + a * args_.sort_dimension_offset) *
+          args_.values_primitive_type_size_in_bytes[i];
+      int64_t memory_index_rhs =
+          (base_offset_ + b * args_.sort_dimension_offset) *
+          args_.values_primitive_type_size_in_bytes[i];
+      comparison_values_[i * 2] = args_.values[i] + memory_index_lhs;
+      comparison_values_[i * 2 + 1] = args_.values[i] + memory_index_rhs;
+    }
+    char result = 0;  // Overwritten by less_than.
+    args_.less_than(&result, args_.run_options, comparison_values_.get(),
+                    nullptr, args_.prof_counters);
+    return result != 0u;
+  }
+
+ private:
+  const SortArgs& args_;
+  const int64_t base_offset_;
+  std::unique_ptr<char*[]> comparison_values_;
+};
+
+// Runs fn(i) for each i in [0, n), on the threads of 'pool' if not null.
+template <typename Fn>
+void ParallelFor(const Eigen::ThreadPoolDevice* pool, int64_t n,
+                 double cycles_per_iteration, const Fn& fn) {
+  if (pool == nullptr || n == 1) {
+    for (int64_t i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  pool->parallelFor(n, Eigen::TensorOpCost(0, 0, cycles_per_iteration),
+                    [&fn](Eigen::Index first, Eigen::Index last) {
+                      for (Eigen::Index i = first; i < last; ++i) fn(i);
+                    });
+}
+
+// Sorts 'indices' with 'less_than'. The row is split into one part for each
+// thread of 'pool', which are sorted in parallel and then merged pairwise.
+void ComparisonSort(const SortArgs& args, int64_t base_offset,
+                    const Eigen::ThreadPoolDevice* pool,
+                    std::vector<int64_t>& indices) {
+  const int64_t n = indices.size();
+  const int64_t num_parts =
+      pool == nullptr
+          ? 1
+          : std::min<int64_t>(pool->numThreads(),
+                              n / (kMinElementsForParallelSort / 2));
+  auto sort_part = [&](int64_t begin, int64_t end) {
+    RowComparator less_than(args, base_offset);
+    if (args.is_stable) {
+      std::stable_sort(indices.begin() + begin, indices.begin() + end,
+                       std::ref(less_than));
+    } else {
+      std::sort(indices.begin() + begin, indices.begin() + end,
+                std::ref(less_than));
+    }
+  };
+  if (num_parts <= 1) {
+    sort_part(0, n);
+    return;
+  }
+
+  const int64_t part_size = (n + num_parts - 1) / num_parts;
+  const double log_part_size = std::log2(static_cast<double>(part_size));
+  ParallelFor(pool, num_parts,
+              part_size * log_part_size * kCyclesPerComparison,
+              [&](int64_t part) {
+                sort_part(std::min(n, part * part_size),
+                          std::min(n, (part + 1) * part_size));
+              });
+
+  // std::merge takes the element of the first range when elements compare
+  // equal, so merging adjacent ranges keeps the sort stable.
+  std::vector<int64_t> merged(n);
+  for (int64_t width = part_size; width < n; width *= 2) {
+    const int64_t num_merges = (n + 2 * width - 1) / (2 * width);
+    ParallelFor(pool, num_merges, 2 * width * kCyclesPerComparison,
+                [&](int64_t merge) {
+                  const int64_t begin = merge * 2 * width;
+                  const int64_t middle = std::min(n, begin + width);
+                  const int64_t end = std::min(n, begin + 2 * width);
+                  RowComparator less_than(args, base_offset);
+                  std::merge(indices.begin() + begin, indices.begin() + middle,
+                             indices.begin() + middle, indices.begin() + end,
+                             merged.begin() + begin, std::ref(less_than));
+                });
+    indices.swap(merged);
+  }
+}
+
+// Maps the keys of type 'KeyType' to unsigned integers that compare in the
+// same order. Returns false if a key has no such mapping.
+template <typename KeyType, typename UInt>
+bool SortableKeyBits(const SortArgs& args, int64_t base_offset,
+                     std::vector<UInt>& bits) {
+  constexpr UInt kSignBit = UInt{1} << (8 * sizeof(UInt) - 1);
+  const char* keys = args.values[0];
+  const int64_t n = bits.size();
+  for (int64_t i = 0; i < n; ++i) {
+    UInt key;
+    std::memcpy(&key,
+                keys + (base_offset + i * args.sort_dimension_offset) *
+                           sizeof(UInt),
+                sizeof(UInt));
+    switch (args.key_type) {
+      case SortKeyType::kSigned:
+        key ^= kSignBit;
+        break;
+      case SortKeyType::kUnsigned:
+        break;
+      case SortKeyType::kFloat:
+      case SortKeyType::kFloatTotalOrder:
+        if constexpr (std::is_floating_point_v<KeyType>) {
+          if (args.key_type == SortKeyType::kFloat) {
+            KeyType value;
+            std::memcpy(&value, &key, sizeof(UInt));
+            // NaNs are not ordered, and -0 is equal to +0.
+            if (std::isnan(value)) return false;
+            if (value == 0) key = 0;
+          }
+          key = (key & kSignBit) ? ~key : key | kSignBit;
+        }
+        break;
+      default:
+        return false;
+    }
+    bits[i] = args.descending ? static_cast<UInt>(~key) : key;
+  }
+  return true;
+}
+
+// Stably sorts 'indices' by 'bits', one byte at a time from the least
+// significant one.
+template <typename UInt>
+void RadixSort(std::vector<UInt>& bits, std::vector<int64_t>& indices) {
+  const int64_t n = indices.size();
+  std::vector<UInt> sorted_bits(n);
+  std::vector<int64_t> sorted_indices(n);
+  for (int shift = 0; shift < 8 * static_cast<int>(sizeof(UInt)); shift += 8) {
+    int64_t offsets[256] = {};
+    for (UInt key : bits) ++offsets[(key >> shift) & 0xff];
+    // Skips the bytes that are the same for all the keys.
+    if (offsets[(bits[0] >> shift) & 0xff] == n) continue;
+    int64_t offset = 0;
+    for (int64_t& count : offsets) {
+      const int64_t next_offset = offset + count;
+      count = offset;
+      offset = next_offset;
+    }
+    for (int64_t i = 0; i < n; ++i) {
+      const int64_t position = offsets[(bits[i] >> shift) & 0xff]++;
+      sorted_bits[position] = bits[i];
+      sorted_indices[position] = indices[i];
+    }
+    bits.swap(sorted_bits);
+    indices.swap(sorted_indices);
+  }
+}
+
+template <typename KeyType, typename UInt>
+bool TryRadixSort(const SortArgs& args, int64_t base_offset,
+                  std::vector<int64_t>& indices) {
+  std::vector<UInt> bits(indices.size());
+  if (!SortableKeyBits<KeyType>(args, base_offset, bits)) return false;
+  RadixSort(bits, indices);
+  return true;
+}
+
+// Sorts 'indices' by the keys of the row without calling 'less_than', if
+// the key type allows it. Returns false otherwise.
+bool TryRadixSort(const SortArgs& args, int64_t base_offset,
+                  std::vector<int64_t>& indices) {
+  if (args.key_type == SortKeyType::kComparator ||
+      indices.size() < kMinElementsForRadixSort) {
+    return false;
+  }
+  const bool is_float = args.key_type == SortKeyType::kFloat ||
+                        args.key_type == SortKeyType::kFloatTotalOrder;
+  switch (args.values_primitive_type_size_in_bytes[0]) {
+    case 1:
+      return !is_float &&
+             TryRadixSort<uint8_t, uint8_t>(args, base_offset, indices);
+    case 2:
+      return !is_float &&
+             TryRadixSort<uint16_t, uint16_t>(args, base_offset, indices);
+    case 4:
+      return is_float
+                 ? TryRadixSort<float, uint32_t>(args, base_offset, indices)
+                 : TryRadixSort<uint32_t, uint32_t>(args, base_offset, indices);
+    case 8:
+      return is_float
+                 ? TryRadixSort<double, uint64_t>(args, base_offset, indices)
+                 : TryRadixSort<uint64_t, uint64_t>(args, base_offset, indices);
+    default:
+      return false;
+  }
+}
+
+// Sorts the row that starts at 'base_offset', using the threads of 'pool' if
+// not null.
+void SortRow(const SortArgs& args, int64_t base_offset,
+             const Eigen::ThreadPoolDevice* pool) {
+  const int64_t n = args.sort_dimension_elements;
+  std::vector<int64_t> indices(n);
+  std::iota(indices.begin(), indices.end(), 0);
+  if (!TryRadixSort(args, base_offset, indices)) {
+    ComparisonSort(args, base_offset, pool, indices);
+  }
+
+  // Reorder the values according to the order defined by 'indices'.
+  std::vector<char> reordered_values;
+  for (int32_t idx = 0; idx < args.values_count; ++idx) {
+    const int64_t size = args.values_primitive_type_size_in_bytes[idx];
+    reordered_values.resize(n * size);
+    for (int64_t i = 0; i < n; ++i) {
+      int64_t memory_index =
+          (base_offset + indices[i] * args.sort_dimension_offset) * size;
+      std::memcpy(reordered_values.data() + i * size,
+                  args.values[idx] + memory_index, size);
+    }
+    for (int64_t i = 0; i < n; ++i) {
+      int64_t memory_index =
+          (base_offset + i * args.sort_dimension_offset) * size;
+      std::memcpy(args.values[idx] + memory_index,
+                  reordered_values.data() + i * size, size);
+    }
+  }
+}
+
+}  // namespace
+
 ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
     int32_t* values_primitive_type_size_in_bytes, bool is_stable,
     char* run_options, int64_t* prof_counters,
-    void (*less_than)(char*, char*, char**, char**, int64_t*)) {
+    void (*less_than)(char*, char*, char**, char**, int64_t*),
+    int32_t key_type, bool descending) {
   // 'values' and 'values_primitive_type_size_in_bytes' are managed by the JIT
   // code, so msan can't tell they are initialized.
   ABSL_ANNOTATE_MEMORY_IS_INITIALIZED(values, values_count * sizeof(char*));
@@ -43,69 +324,54 @@ ABSL_ATTRIBUTE_NO_SANITIZE_MEMORY void __xla_cpu_runtime_KeyValueSort(
   // 'base_offset' value which points to the first element in that row, and add
   // i * c for accessing the 'i'-th element in that row.
 
+  const SortArgs args = {b,
+                         c,
+                         values,
+                         values_count,
+                         values_primitive_type_size_in_bytes,
+                         is_stable,
+                         run_options,
+                         prof_counters,
+                         less_than,
+                         static_cast<SortKeyType>(key_type),
+                         descending};
   int64_t sort_dimension_elements = b;
   int64_t num_iteration_elements = a * c;
   int64_t sort_dimension_offset = c;
 
-  std::unique_ptr<int64_t[]> indices(new int64_t[sort_dimension_elements]);
-  std::unique_ptr<char*[]> comparison_values(new char*[2 * values_count]);
-  std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-  std::unique_ptr<std::string[]> reordered_values(
-      new std::string[sort_dimension_elements]);
-  for (int64_t index = 0; index < num_iteration_elements; ++index) {
-    // If the sort should be stable, we have to reinitialize indices to iota to
-    // guarantee that we still keep the relative order in case of ties.
-    if (is_stable && index > 0) {
-      std::iota(indices.get(), indices.get() + sort_dimension_elements, 0);
-    }
-    // 'index' can be split into two values which index into the 'c' dimension
-    // and the 'a' dimension, respectively. 'index' % 'c' is the index into the
-    // 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
-    // calculating the base offset, we need to multiply the index into the 'a'
-    // dimension with 'b' * 'c'.
-    // 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
-    int64_t base_offset =
-        index % sort_dimension_offset +
-        (index - index % sort_dimension_offset) * sort_dimension_elements;
-    auto compare_function = [&](int64_t a, int64_t b) -> bool {
-      for (int32_t i = 0; i < values_count; ++i) {
-        int64_t memory_index_lhs = (base_offset + a * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        int64_t memory_index_rhs = (base_offset + b * sort_dimension_offset) *
-                                   values_primitive_type_size_in_bytes[i];
-        comparison_values[i * 2] = values[i] + memory_index_lhs;
-        comparison_values[i * 2 + 1] = values[i] + memory_index_rhs;
-      }
-      char result = 0;  // Overwritten by less_than.
-      less_than(&result, run_options, comparison_values.get(), nullptr,
-                prof_counters);
-      return result != 0u;
-    };
-    if (is_stable) {
-      std::stable_sort(indices.get(), indices.get() + sort_dimension_elements,
-                       compare_function);
-    } else {
-      std::sort(indices.get(), indices.get() + sort_dimension_elements,
-                compare_function);
-    }
+  // The profile counters are not updated atomically, so 'less_than' is only
+  // called from a single thread when profiling.
+  const Eigen::ThreadPoolDevice* pool = nullptr;
+  if (run_options != nullptr && prof_counters == nullptr) {
+    pool = reinterpret_cast<const xla::ExecutableRunOptions*>(run_options)
+               ->intra_op_thread_pool();
+  }
+
+  // 'index' can be split into two values which index into the 'c' dimension
+  // and the 'a' dimension, respectively. 'index' % 'c' is the index into the
+  // 'c' dimension, 'index' / 'c' is the index into the 'a' dimension. When
+  // calculating the base offset, we need to multiply the index into the 'a'
+  // dimension with 'b' * 'c'.
+  // 'index' / 'c' * 'c' * 'b' = ('index' - 'index' % 'c') * 'b'.
+  auto base_offset = [&](int64_t index) {
+    return index % sort_dimension_offset +
+           (index - index % sort_dimension_offset) * sort_dimension_elements;
+  };
 
-    // Reorder the values according to the order defined by 'indices'.
-    for (int32_t idx = 0; idx < values_count; ++idx) {
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index =
-            (base_offset + indices[i] * sort_dimension_offset) *
-            values_primitive_type_size_in_bytes[idx];
-
-        reordered_values[i] =
-            std::string(values[idx] + memory_index,
-                        values_primitive_type_size_in_bytes[idx]);
-      }
-      for (int64_t i = 0; i < sort_dimension_elements; ++i) {
-        int64_t memory_index = (base_offset + i * sort_dimension_offset) *
-                               values_primitive_type_size_in_bytes[idx];
-        memcpy(values[idx] + memory_index, reordered_values[i].c_str(),
-               values_primitive_type_size_in_bytes[idx]);
-      }
+  // Long rows are sorted by several threads each, if there are not enough
+  // rows to keep the threads busy.
+  if (pool != nullptr &&
+      sort_dimension_elements >= kMinElementsForParallelSort &&
+      num_iteration_elements < pool->numThreads()) {
+    for (int64_t index = 0; index < num_iteration_elements; ++index) {
+      SortRow(args, base_offset(index), pool);
     }
+    return;
   }
+  const double log_elements =
+      std::log2(static_cast<double>(std::max<int64_t>(2, b)));
+  ParallelFor(pool, num_iteration_elements,
+              b * log_elements * kCyclesPerComparison, [&](int64_t index) {
+                SortRow(args, base_offset(index), /*pool=*/nullptr);
+              });
 }
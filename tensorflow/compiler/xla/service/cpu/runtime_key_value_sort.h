@@ -20,6 +20,28 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
+namespace xla {
+namespace cpu {
+
+// How the keys, i.e. the first entry of 'values', are compared by the
+// 'less_than' function of __xla_cpu_runtime_KeyValueSort, when it only
+// compares them with < or >. The runtime can then sort the keys without
+// calling 'less_than'.
+enum class SortKeyType : int32_t {
+  // 'less_than' may compare anything, so it has to be called.
+  kComparator = 0,
+  kSigned = 1,
+  kUnsigned = 2,
+  // Floats compared with partial order: -0 and +0 are equal, and NaNs are not
+  // ordered, so 'less_than' is called for rows that contain a NaN.
+  kFloat = 3,
+  // Floats compared with total order.
+  kFloatTotalOrder = 4,
+};
+
+}  // namespace cpu
+}  // namespace xla
+
 extern "C" {
 
 // Each entry in 'values' represents a 3-dimensional shape with dimensions
@@ -36,11 +58,19 @@ extern "C" {
 // - pointers to the parameter buffers (char**)
 // - pointers to the buffer tables = nullptr for thread local functions (char**)
 // - profile counters = 'prof_counters' (int64_t*)
+// 'key_type' is a xla::cpu::SortKeyType. Unless it is kComparator, 'less_than'
+// compares the keys with < if 'descending' is false, or with > otherwise.
+//
+// The rows are sorted in parallel on the intra-op thread pool of
+// 'run_options', if any, and so are long rows by a merge sort. 'less_than'
+// is only called from a single thread if 'prof_counters' is not null, as it
+// updates the counters without synchronization.
 extern void __xla_cpu_runtime_KeyValueSort(
     int64_t a, int64_t b, int64_t c, char** values, int32_t values_count,
     int32_t* values_primitive_type_size_in_bytes, bool is_stable,
     char* run_options, int64_t* prof_counters,
-    void (*less_than)(char*, char*, char**, char**, int64_t*));
+    void (*less_than)(char*, char*, char**, char**, int64_t*),
+    int32_t key_type, bool descending);
 }
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_RUNTIME_KEY_VALUE_SORT_H_
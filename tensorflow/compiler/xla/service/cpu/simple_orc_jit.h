@@ -40,9 +40,10 @@ namespace cpu {
 // This class wraps Orc's functionality into a single interface that only
 // exposes what we need for XLA.
 //
-// Supports JIT-ing multiple modules but without cross-module linking.
-// Implements eager compilation - the module is lowered to binary as soon as
-// it's added to the JIT.
+// Supports JIT-ing multiple modules. Symbols with external linkage defined by
+// one module or object file are visible to all the others. Implements eager
+// compilation - the module is lowered to binary as soon as it's added to the
+// JIT.
 class SimpleOrcJIT : public llvm::JITEventListener {
  public:
   using ObjLayerT = llvm::orc::RTDyldObjectLinkingLayer;
@@ -79,6 +80,16 @@ class SimpleOrcJIT : public llvm::JITEventListener {
 
   llvm::Error AddModule(llvm::orc::ThreadSafeModule module);
 
+  // Optimizes and compiles `module` to an object file that can be passed to
+  // `AddObjectFile`, without the optimization and codegen hooks. Uses its own
+  // llvm::TargetMachine, so it can be called concurrently on different
+  // modules, as long as each module lives in its own llvm::LLVMContext.
+  llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> CompileModule(
+      llvm::Module& module) const;
+
+  // Adds an object file produced by `CompileModule` to the JIT.
+  llvm::Error AddObjectFile(std::unique_ptr<llvm::MemoryBuffer> object_file);
+
   // Discards objects we no longer need once we are done compiling.
   void DoneCompiling();
 
@@ -111,6 +122,12 @@ class SimpleOrcJIT : public llvm::JITEventListener {
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   llvm::Triple target_triple_;
   const llvm::DataLayout data_layout_;
+  // Options used to create the compiler of `CompileModule`.
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
+  const bool optimize_for_size_;
+  const bool disable_expensive_passes_;
+  const llvm::FastMathFlags fast_math_flags_;
   std::unique_ptr<llvm::orc::ExecutorProcessControl> target_process_control_;
   std::unique_ptr<llvm::orc::ExecutionSession> execution_session_;
   ObjLayerT object_layer_;
@@ -42,8 +42,49 @@ ENTRY main {
 }
 )";
 
+  // The keys are floats sorted in ascending order.
   std::string filecheck_pattern = R"(
 CHECK: call void @__xla_cpu_runtime_KeyValueSort
+CHECK-SAME: i32 3, i1 false)
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+
+  CpuAotCompilationOptions options{
+      /*triple=*/kTargetTripleForHost, /*cpu_name=*/kTargetCpuForHost,
+      /*features=*/"",
+      /*entry_point_name=*/"entry",
+      /*relocation_model=*/CpuAotCompilationOptions::RelocationModel::Static};
+
+  CompileAheadOfTimeAndVerifyIr(std::move(module), options, filecheck_pattern,
+                                /*match_optimized_ir=*/true);
+}
+
+TEST_F(CpuKeyValueSortTest, SortR2DescendingWithValues) {
+  const std::string hlo_text = R"(
+HloModule KeyValueSort
+
+compare {
+  p.0.lhs = s32[] parameter(0)
+  p.0.rhs = s32[] parameter(1)
+  p.1.lhs = f32[] parameter(2)
+  p.1.rhs = f32[] parameter(3)
+  ROOT lt = pred[] compare(p.0.rhs, p.0.lhs), direction=LT
+}
+
+ENTRY main {
+  keys = s32[4,10] parameter(0)
+  values = f32[4,10] parameter(1)
+
+  ROOT result = (s32[4,10], f32[4,10]) sort(keys, values), dimensions={1},
+    is_stable=true, to_apply=compare
+}
+)";
+
+  // The keys are signed integers sorted in descending order.
+  std::string filecheck_pattern = R"(
+CHECK: call void @__xla_cpu_runtime_KeyValueSort
+CHECK-SAME: i32 1, i1 true)
 )";
 
   TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
@@ -66,6 +66,57 @@ ENTRY entry {
   LiteralTestUtil::ExpectR0Equal(3, result);
 }
 
+TEST_F(CpuCodegenTest, WhileCompiledInParallel) {
+  const std::string hlo_text = R"(
+HloModule module
+
+add {
+  add.p0 = f32[] parameter(0)
+  add.p1 = f32[] parameter(1)
+  ROOT add.sum = f32[] add(add.p0, add.p1)
+}
+
+body {
+  body.p0 = (s32[], f32[4]) parameter(0)
+  body.i = s32[] get-tuple-element(body.p0), index=0
+  body.v = f32[4] get-tuple-element(body.p0), index=1
+  body.c1 = s32[] constant(1)
+  body.c = f32[4] constant({1, 2, 3, 4})
+  body.next_i = s32[] add(body.i, body.c1)
+  body.next_v = f32[4] add(body.v, body.c)
+  ROOT body.root = (s32[], f32[4]) tuple(body.next_i, body.next_v)
+}
+
+cond {
+  cond.p0 = (s32[], f32[4]) parameter(0)
+  cond.i = s32[] get-tuple-element(cond.p0), index=0
+  cond.c3 = s32[] constant(3)
+  ROOT cond.root = pred[] compare(cond.i, cond.c3), direction=LT
+}
+
+ENTRY entry {
+  entry.c0 = s32[] constant(0)
+  entry.zeros = f32[4] constant({0, 0, 0, 0})
+  entry.init = (s32[], f32[4]) tuple(entry.c0, entry.zeros)
+  entry.while = (s32[], f32[4]) while(entry.init), condition=cond, body=body
+  entry.v = f32[4] get-tuple-element(entry.while), index=1
+  entry.f0 = f32[] constant(0)
+  ROOT entry.root = f32[] reduce(entry.v, entry.f0), dimensions={0},
+    to_apply=add
+}
+)";
+
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  // The while loop body and condition are compiled in separate LLVM modules.
+  DebugOptions debug_options = GetDebugOptionsForTest();
+  debug_options.set_xla_cpu_force_compilation_parallelism(4);
+  module->mutable_config().set_debug_options(debug_options);
+
+  auto result = ExecuteAndTransfer(std::move(module), {});
+
+  LiteralTestUtil::ExpectR0Equal(30.0f, result);
+}
+
 }  // namespace
 }  // namespace cpu
 }  // namespace xla
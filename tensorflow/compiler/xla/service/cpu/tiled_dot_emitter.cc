@@ -677,8 +677,9 @@ class TiledSmallGemmEmitter {
     std::string GetCacheKey() const {
       return absl::StrCat("gemm_", PrimitiveType_Name(scalar_type()), "_",
                           dims().ToString(), "_", max_vectorization_width(),
-                          "_", min_vectorization_width(), "_", tile_size_m(),
-                          "_", tile_size_k());
+                          "_", max_vector_count(), "_",
+                          min_vectorization_width(), "_", tile_size_m(), "_",
+                          tile_size_k());
     }
 
     PrimitiveType scalar_type() const { return scalar_type_; }
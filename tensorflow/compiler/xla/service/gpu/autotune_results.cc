@@ -0,0 +1,246 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
+
+#include <atomic>
+#include <utility>
+
+#include "absl/algorithm/container.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace xla {
+namespace gpu {
+
+/*static*/ AutotuneResultsDb& AutotuneResultsDb::Global() {
+  static auto* db = new AutotuneResultsDb();
+  return *db;
+}
+
+/*static*/ std::string AutotuneResultsDb::DeviceKey(
+    se::StreamExecutor* executor) {
+  const se::DeviceDescription& desc = executor->GetDeviceDescription();
+  std::string key = desc.name();
+  if (executor->platform_kind() == se::PlatformKind::kROCm) {
+    absl::StrAppend(&key, ", ", desc.rocm_compute_capability().gcn_arch_name());
+  } else {
+    absl::StrAppend(&key, ", sm_", desc.cuda_compute_capability().ToString());
+  }
+  if (auto* dnn = executor->AsDnn()) {
+    StatusOr<se::dnn::VersionInfo> version_or = dnn->GetVersion();
+    if (version_or.ok()) {
+      const se::dnn::VersionInfo& version = version_or.ValueOrDie();
+      absl::StrAppend(&key, ", DNN ", version.major_version(), ".",
+                      version.minor_version(), ".", version.patch());
+    }
+  }
+  if (auto* blas = executor->AsBlas()) {
+    std::string blas_version;
+    if (blas->GetVersion(&blas_version).ok()) {
+      absl::StrAppend(&key, ", BLAS ", blas_version);
+    }
+  }
+  return key;
+}
+
+/*static*/ std::string AutotuneResultsDb::HloKey(const HloInstruction& instr) {
+  auto options = HloPrintOptions::Canonical();
+  options.set_print_backend_config(true);
+  return instr.ToString(options);
+}
+
+std::optional<tensorflow::AutotuneResult> AutotuneResultsDb::Lookup(
+    Kind kind, const std::string& device, const std::string& hlo) const {
+  absl::MutexLock lock(&mu_);
+  auto it = results_.find(Key(kind, device, hlo));
+  if (it == results_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void AutotuneResultsDb::Insert(Kind kind, const std::string& device,
+                               const std::string& hlo,
+                               const tensorflow::AutotuneResult& result) {
+  absl::MutexLock lock(&mu_);
+  results_[Key(kind, device, hlo)] = result;
+}
+
+AutotuneResults AutotuneResultsDb::ToProto() const {
+  AutotuneResults results;
+  absl::MutexLock lock(&mu_);
+  for (const auto& [key, result] : results_) {
+    const auto& [kind, device, hlo] = key;
+    AutotuneResults::Entry* entry =
+        kind == Kind::kDot ? results.add_dots() : results.add_convs();
+    entry->set_device(device);
+    entry->set_hlo(hlo);
+    *entry->mutable_result() = result;
+  }
+  // Sort the entries so that the same results always produce the same file.
+  auto by_key = [](const AutotuneResults::Entry& a,
+                   const AutotuneResults::Entry& b) {
+    return std::tie(a.device(), a.hlo()) < std::tie(b.device(), b.hlo());
+  };
+  absl::c_sort(*results.mutable_dots(), by_key);
+  absl::c_sort(*results.mutable_convs(), by_key);
+  return results;
+}
+
+void AutotuneResultsDb::AddProto(const AutotuneResults& results) {
+  for (const AutotuneResults::Entry& entry : results.dots()) {
+    Insert(Kind::kDot, entry.device(), entry.hlo(), entry.result());
+  }
+  for (const AutotuneResults::Entry& entry : results.convs()) {
+    Insert(Kind::kConv, entry.device(), entry.hlo(), entry.result());
+  }
+}
+
+Status AutotuneResultsDb::LoadFromFile(const std::string& path) {
+  {
+    absl::MutexLock lock(&mu_);
+    if (!loaded_paths_.insert(path).second) {
+      return OkStatus();
+    }
+  }
+  AutotuneResults results;
+  Status status = tensorflow::ReadTextOrBinaryProto(tensorflow::Env::Default(),
+                                                    path, &results);
+  if (!status.ok()) {
+    absl::MutexLock lock(&mu_);
+    loaded_paths_.erase(path);
+    return tensorflow::errors::CreateWithUpdatedMessage(
+        status, absl::StrCat("Failed to load autotuning results from ", path,
+                             ": ", status.error_message()));
+  }
+  VLOG(1) << "Loaded " << results.dots_size() << " dot and "
+          << results.convs_size() << " convolution autotuning results from "
+          << path;
+  AddProto(results);
+  return OkStatus();
+}
+
+Status AutotuneResultsDb::SaveToFile(const std::string& path) const {
+  AutotuneResults results = ToProto();
+  if (absl::EndsWith(path, ".pbtxt")) {
+    return tensorflow::WriteTextProto(tensorflow::Env::Default(), path,
+                                      results);
+  }
+  return tensorflow::WriteBinaryProto(tensorflow::Env::Default(), path,
+                                      results);
+}
+
+Status MaybeLoadAutotuneResults(const DebugOptions& debug_options) {
+  const std::string& path = debug_options.xla_gpu_load_autotune_results_from();
+  if (path.empty()) {
+    return OkStatus();
+  }
+  return AutotuneResultsDb::Global().LoadFromFile(path);
+}
+
+Status MaybeSaveAutotuneResults(const DebugOptions& debug_options) {
+  const std::string& path = debug_options.xla_gpu_dump_autotune_results_to();
+  if (path.empty()) {
+    return OkStatus();
+  }
+  return AutotuneResultsDb::Global().SaveToFile(path);
+}
+
+StatusOr<std::optional<tensorflow::AutotuneResult>> FindAutotuneResult(
+    AutotuneResultsDb::Kind kind, se::StreamExecutor* executor,
+    const HloInstruction& instr) {
+  std::string device = AutotuneResultsDb::DeviceKey(executor);
+  std::string hlo = AutotuneResultsDb::HloKey(instr);
+  std::optional<tensorflow::AutotuneResult> result =
+      AutotuneResultsDb::Global().Lookup(kind, device, hlo);
+  if (!result.has_value() && instr.GetModule()
+                                 ->config()
+                                 .debug_options()
+                                 .xla_gpu_require_complete_autotune_results()) {
+    return NotFound(
+        "No autotuning result for %s on %s, and autotuning is disabled by "
+        "--xla_gpu_require_complete_autotune_results",
+        hlo, device);
+  }
+  return result;
+}
+
+void AddAutotuneResult(AutotuneResultsDb::Kind kind,
+                       se::StreamExecutor* executor,
+                       const HloInstruction& instr,
+                       const tensorflow::AutotuneResult& result) {
+  AutotuneResultsDb::Global().Insert(kind,
+                                     AutotuneResultsDb::DeviceKey(executor),
+                                     AutotuneResultsDb::HloKey(instr), result);
+}
+
+std::vector<se::StreamExecutor*> GetIdenticalExecutors(
+    se::StreamExecutor* executor) {
+  std::vector<se::StreamExecutor*> executors = {executor};
+  StatusOr<se::Platform*> platform =
+      se::MultiPlatformManager::PlatformWithId(executor->platform()->id());
+  if (!platform.ok()) {
+    return executors;
+  }
+  const std::string device_key = AutotuneResultsDb::DeviceKey(executor);
+  for (int ordinal = 0; ordinal < platform.ValueOrDie()->VisibleDeviceCount();
+       ++ordinal) {
+    if (ordinal == executor->device_ordinal()) {
+      continue;
+    }
+    StatusOr<se::StreamExecutor*> other =
+        platform.ValueOrDie()->ExecutorForDevice(ordinal);
+    if (other.ok() &&
+        AutotuneResultsDb::DeviceKey(other.ValueOrDie()) == device_key) {
+      executors.push_back(other.ValueOrDie());
+    }
+  }
+  return executors;
+}
+
+void AutotuneOnIdenticalDevices(
+    se::StreamExecutor* executor, int64_t num_items,
+    const std::function<void(se::StreamExecutor*, int64_t)>& autotune) {
+  if (num_items < 2) {
+    return;
+  }
+  std::vector<se::StreamExecutor*> executors = GetIdenticalExecutors(executor);
+  if (executors.size() < 2) {
+    return;
+  }
+  VLOG(1) << "Autotuning " << num_items << " instructions on "
+          << executors.size() << " devices";
+
+  std::atomic<int64_t> next_item{0};
+  // The destructor of the pool waits for all the devices to finish.
+  tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                      "xla_gpu_autotuning", executors.size());
+  for (se::StreamExecutor* device : executors) {
+    pool.Schedule([&, device] {
+      for (int64_t i = next_item++; i < num_items; i = next_item++) {
+        autotune(device, i);
+      }
+    });
+  }
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,123 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_autotuning.pb.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/compiler/xla/xla.pb.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/protobuf/autotuning.pb.h"
+
+namespace xla {
+namespace gpu {
+
+// Autotuning results keyed by device and instruction, which can be saved to
+// and loaded from files containing an AutotuneResults proto, so that a
+// process does not autotune again the instructions autotuned by a previous
+// one.
+class AutotuneResultsDb {
+ public:
+  enum class Kind { kDot, kConv };
+
+  // The database shared by the autotuning passes of the process.
+  static AutotuneResultsDb& Global();
+
+  // Returns the device key of the results measured on `executor`: its name,
+  // compute capability and the versions of its DNN and BLAS libraries, which
+  // all determine the best algorithms.
+  static std::string DeviceKey(se::StreamExecutor* executor);
+
+  // Returns the instruction key of the results of `instr`: its canonical text,
+  // with its operand shapes and backend config.
+  static std::string HloKey(const HloInstruction& instr);
+
+  std::optional<tensorflow::AutotuneResult> Lookup(
+      Kind kind, const std::string& device, const std::string& hlo) const;
+
+  // Adds or replaces a result.
+  void Insert(Kind kind, const std::string& device, const std::string& hlo,
+              const tensorflow::AutotuneResult& result);
+
+  AutotuneResults ToProto() const;
+  void AddProto(const AutotuneResults& results);
+
+  // Adds the results in the file at `path`, unless it was already loaded.
+  Status LoadFromFile(const std::string& path);
+
+  // Writes all the results to the file at `path`. Files whose name ends in
+  // ".pbtxt" are in text format, and other files in binary format.
+  Status SaveToFile(const std::string& path) const;
+
+ private:
+  using Key = std::tuple<Kind, std::string, std::string>;
+
+  mutable absl::Mutex mu_;
+  absl::flat_hash_map<Key, tensorflow::AutotuneResult> results_
+      ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_set<std::string> loaded_paths_ ABSL_GUARDED_BY(mu_);
+};
+
+// Loads the results of --xla_gpu_load_autotune_results_from into the global
+// database, if set.
+Status MaybeLoadAutotuneResults(const DebugOptions& debug_options);
+
+// Saves the global database to --xla_gpu_dump_autotune_results_to, if set.
+Status MaybeSaveAutotuneResults(const DebugOptions& debug_options);
+
+// Returns the result of autotuning `instr` on `executor` in the global
+// database, or nullopt if there is none. Returns an error instead of nullopt
+// if --xla_gpu_require_complete_autotune_results is set.
+StatusOr<std::optional<tensorflow::AutotuneResult>> FindAutotuneResult(
+    AutotuneResultsDb::Kind kind, se::StreamExecutor* executor,
+    const HloInstruction& instr);
+
+// Adds the result of autotuning `instr` on `executor` to the global database.
+void AddAutotuneResult(AutotuneResultsDb::Kind kind,
+                       se::StreamExecutor* executor,
+                       const HloInstruction& instr,
+                       const tensorflow::AutotuneResult& result);
+
+// Returns `executor` followed by the executors of the other visible devices of
+// its platform with the same device key, whose autotuning results can be used
+// for `executor`.
+std::vector<se::StreamExecutor*> GetIdenticalExecutors(
+    se::StreamExecutor* executor);
+
+// Calls `autotune(executor, i)` for each i in [0, num_items), with the calls
+// distributed over one thread per executor of GetIdenticalExecutors(executor),
+// so that the results measured on all these devices are shared through the
+// global database. Does nothing if there are no other identical devices.
+void AutotuneOnIdenticalDevices(
+    se::StreamExecutor* executor, int64_t num_items,
+    const std::function<void(se::StreamExecutor*, int64_t)>& autotune);
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_AUTOTUNE_RESULTS_H_
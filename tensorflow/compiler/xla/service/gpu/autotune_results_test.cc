@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
+
+#include <string>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using Kind = AutotuneResultsDb::Kind;
+
+tensorflow::AutotuneResult GemmResult(int64_t algorithm) {
+  tensorflow::AutotuneResult result;
+  result.mutable_gemm()->set_algorithm(algorithm);
+  return result;
+}
+
+TEST(AutotuneResultsDbTest, LookupByKindDeviceAndHlo) {
+  AutotuneResultsDb db;
+  db.Insert(Kind::kDot, "gpu0", "dot", GemmResult(3));
+  ASSERT_TRUE(db.Lookup(Kind::kDot, "gpu0", "dot").has_value());
+  EXPECT_EQ(db.Lookup(Kind::kDot, "gpu0", "dot")->gemm().algorithm(), 3);
+  EXPECT_FALSE(db.Lookup(Kind::kConv, "gpu0", "dot").has_value());
+  EXPECT_FALSE(db.Lookup(Kind::kDot, "gpu1", "dot").has_value());
+  EXPECT_FALSE(db.Lookup(Kind::kDot, "gpu0", "conv").has_value());
+}
+
+TEST(AutotuneResultsDbTest, SaveAndLoad) {
+  for (const char* extension : {".pb", ".pbtxt"}) {
+    std::string path = tensorflow::io::JoinPath(
+        tensorflow::testing::TmpDir(),
+        absl::StrCat("autotune_results", extension));
+    AutotuneResultsDb saved;
+    saved.Insert(Kind::kDot, "gpu0", "dot", GemmResult(3));
+    tensorflow::AutotuneResult conv_result;
+    conv_result.mutable_conv()->set_algorithm(7);
+    conv_result.set_scratch_bytes(1024);
+    saved.Insert(Kind::kConv, "gpu0", "conv", conv_result);
+    TF_ASSERT_OK(saved.SaveToFile(path));
+
+    AutotuneResultsDb loaded;
+    TF_ASSERT_OK(loaded.LoadFromFile(path));
+    EXPECT_EQ(loaded.Lookup(Kind::kDot, "gpu0", "dot")->gemm().algorithm(),
+              3);
+    std::optional<tensorflow::AutotuneResult> loaded_conv =
+        loaded.Lookup(Kind::kConv, "gpu0", "conv");
+    ASSERT_TRUE(loaded_conv.has_value());
+    EXPECT_EQ(loaded_conv->conv().algorithm(), 7);
+    EXPECT_EQ(loaded_conv->scratch_bytes(), 1024);
+    EXPECT_EQ(loaded.ToProto().SerializeAsString(),
+              saved.ToProto().SerializeAsString());
+  }
+}
+
+TEST(AutotuneResultsDbTest, LoadsEachFileOnce) {
+  std::string path = tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                              "autotune_results_once.pb");
+  AutotuneResultsDb saved;
+  saved.Insert(Kind::kDot, "gpu0", "dot", GemmResult(3));
+  TF_ASSERT_OK(saved.SaveToFile(path));
+
+  AutotuneResultsDb db;
+  TF_ASSERT_OK(db.LoadFromFile(path));
+  // Results measured by this process are not replaced by loading the file
+  // again.
+  db.Insert(Kind::kDot, "gpu0", "dot", GemmResult(5));
+  TF_ASSERT_OK(db.LoadFromFile(path));
+  EXPECT_EQ(db.Lookup(Kind::kDot, "gpu0", "dot")->gemm().algorithm(), 5);
+}
+
+TEST(AutotuneResultsDbTest, MissingFileIsAnError) {
+  AutotuneResultsDb db;
+  EXPECT_FALSE(db.LoadFromFile(tensorflow::io::JoinPath(
+                                   tensorflow::testing::TmpDir(), "missing.pb"))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -20,7 +20,9 @@ limitations under the License.
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/buffer_comparator.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_asm_opts_util.h"
@@ -228,23 +230,44 @@ StatusOr<std::optional<se::blas::AlgorithmType>> DoGemmAutotune(
   static int64_t cache_hits ABSL_GUARDED_BY(mutex) = 0;
   static int64_t cache_misses ABSL_GUARDED_BY(mutex) = 0;
 
-  absl::MutexLock lock(&mutex);
-  auto it = cache.find(key);
-  int64_t requests = cache_hits + cache_misses;
-  if (requests && requests % 10 == 0) {
-    VLOG(2) << "Autotuning cache hits/(hits + misses): " << cache_hits << "/"
-            << requests;
+  {
+    // The cache is not locked while autotuning, so that GEMMs can be
+    // autotuned on several devices in parallel. Keys of the same device can't
+    // be inserted concurrently, as the device is locked.
+    absl::MutexLock lock(&mutex);
+    auto it = cache.find(key);
+    int64_t requests = cache_hits + cache_misses;
+    if (requests && requests % 10 == 0) {
+      VLOG(2) << "Autotuning cache hits/(hits + misses): " << cache_hits << "/"
+              << requests;
+    }
+
+    if (it != cache.end()) {
+      cache_hits++;
+      VLOG(4) << "Autotuning cache hit, using algorithm: "
+              << (it->second.has_value() ? absl::StrCat(*(it->second))
+                                         : "<generic>");
+      return it->second;
+    }
+    cache_misses++;
+    VLOG(4) << "Autotuning cache miss";
   }
 
-  if (it != cache.end()) {
-    cache_hits++;
-    VLOG(4) << "Autotuning cache hit, using algorithm: "
-            << (it->second.has_value() ? absl::StrCat(*(it->second))
-                                       : "<generic>");
-    return it->second;
+  TF_ASSIGN_OR_RETURN(std::optional<AutotuneResult> saved_result,
+                      FindAutotuneResult(AutotuneResultsDb::Kind::kDot,
+                                         stream->parent(), *gemm));
+  if (saved_result.has_value()) {
+    std::optional<se::blas::AlgorithmType> algorithm;
+    if (saved_result->has_gemm()) {
+      algorithm = saved_result->gemm().algorithm();
+    }
+    VLOG(4) << "Using saved autotuning result: "
+            << (algorithm.has_value() ? absl::StrCat(*algorithm)
+                                      : "<generic>");
+    absl::MutexLock lock(&mutex);
+    CHECK(cache.emplace(key, algorithm).second);
+    return algorithm;
   }
-  cache_misses++;
-  VLOG(4) << "Autotuning cache miss";
 
   const DebugOptions& debug_options =
       gemm->GetModule()->config().debug_options();
@@ -331,6 +354,14 @@ StatusOr<std::optional<se::blas::AlgorithmType>> DoGemmAutotune(
     if (best_algorithm_idx) best_algorithm = algorithms[*best_algorithm_idx];
   }
 
+  AutotuneResult result;
+  if (best_algorithm) {
+    result.mutable_gemm()->set_algorithm(*best_algorithm);
+  }
+  AddAutotuneResult(AutotuneResultsDb::Kind::kDot, stream->parent(), *gemm,
+                    result);
+
+  absl::MutexLock lock(&mutex);
   CHECK(cache.emplace(key, best_algorithm).second);
   return best_algorithm;
 }
@@ -375,6 +406,45 @@ StatusOr<bool> RunOnComputation(HloComputation* computation,
   return changed;
 }
 
+// Autotunes the GEMMs of `module` in parallel on the devices identical to
+// `executor`, which fills the autotuning caches.
+void AutotuneInParallel(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads,
+    se::StreamExecutor* executor, se::DeviceMemoryAllocator* allocator) {
+  std::vector<const HloInstruction*> gemms;
+  for (HloComputation* computation :
+       module->MakeNonfusionComputations(execution_threads)) {
+    for (HloInstruction* instr : computation->instructions()) {
+      if (IsCublasGemm(*instr) || IsCublasLtMatmul(*instr)) {
+        gemms.push_back(instr);
+      }
+    }
+  }
+  AutotuneOnIdenticalDevices(
+      executor, gemms.size(), [&](se::StreamExecutor* device, int64_t i) {
+        // `allocator` only allocates memory on the device of `executor`.
+        se::DeviceMemoryAllocator* device_allocator =
+            device == executor && allocator != nullptr ? allocator
+                                                       : device->GetAllocator();
+        Status status = [&]() -> Status {
+          TF_ASSIGN_OR_RETURN(
+              se::Stream* const stream,
+              device_allocator->GetStream(device->device_ordinal()));
+          TF_ASSIGN_OR_RETURN(GemmBackendConfig gemm_config,
+                              gemms[i]->backend_config<GemmBackendConfig>());
+          return DoGemmAutotune(gemms[i], gemm_config, device_allocator, stream)
+              .status();
+        }();
+        // Failures are reported when the GEMM is autotuned again on
+        // `executor`.
+        if (!status.ok()) {
+          VLOG(1) << "Failed to autotune " << gemms[i]->name() << " on device "
+                  << device->device_ordinal() << ": " << status;
+        }
+      });
+}
+
 }  // namespace
 
 StatusOr<bool> GemmAlgorithmPicker::Run(
@@ -386,6 +456,11 @@ StatusOr<bool> GemmAlgorithmPicker::Run(
     VLOG(2) << "GEMM auto-tuning disabled, GemmAlgorithmPicker returning early";
     return false;
   }
+  const DebugOptions& debug_options = module->config().debug_options();
+  TF_RETURN_IF_ERROR(MaybeLoadAutotuneResults(debug_options));
+  if (debug_options.xla_gpu_parallel_autotuning()) {
+    AutotuneInParallel(module, execution_threads, stream_exec_, allocator_);
+  }
 
   bool changed = false;
   for (HloComputation* computation :
@@ -394,6 +469,7 @@ StatusOr<bool> GemmAlgorithmPicker::Run(
         bool result, RunOnComputation(computation, stream_exec_, allocator_));
     changed |= result;
   }
+  TF_RETURN_IF_ERROR(MaybeSaveAutotuneResults(debug_options));
   return changed;
 }
 
@@ -107,6 +107,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/hlo_fusion_stats.h"
 #include "tensorflow/compiler/xla/service/gpu/horizontal_input_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/horizontal_loop_fusion.h"
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offloader.h"
 #include "tensorflow/compiler/xla/service/gpu/instruction_fusion.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/gpu/ir_emitter_context.h"
@@ -979,6 +980,25 @@ static Status CompileModuleToLlvmIrImpl(
   TF_ASSIGN_OR_RETURN(HloSchedule hlo_schedule,
                       ScheduleGpuModule(hlo_module, pointer_size));
 
+  // Only the CUDA executor allocates buffers in the host memory space.
+  const int64_t host_offload_memory_limit_bytes =
+      hlo_module->config()
+          .debug_options()
+          .xla_gpu_host_offload_memory_limit_bytes();
+  if (host_offload_memory_limit_bytes > 0 &&
+      platform_id == se::cuda::kCudaPlatformId) {
+    HostMemoryOffloader::Options options;
+    options.memory_limit_bytes = host_offload_memory_limit_bytes;
+    options.pointer_size = pointer_size;
+    if (stream_exec != nullptr) {
+      options.device_bytes_per_second =
+          stream_exec->GetDeviceDescription().memory_bandwidth();
+    }
+    TF_RETURN_IF_ERROR(hlo_module->set_schedule(std::move(hlo_schedule)));
+    TF_RETURN_IF_ERROR(HostMemoryOffloader(options).Run(hlo_module).status());
+    hlo_schedule = hlo_module->schedule();
+  }
+
   auto buffer_size_bytes_function =
       [pointer_size](const BufferValue& buffer_value) -> int64_t {
     return GetSizeOfShape(buffer_value.shape(), pointer_size);
@@ -1563,6 +1583,7 @@ static Status GetMlirAllocationInfo(mlir::func::FuncOp func,
                    attr.getName() == "lmhlo.param_shape_index" ||
                    attr.getName() == "lmhlo.constant_name" ||
                    attr.getName() == "lmhlo.must_alias" ||
+                   attr.getName() == "lmhlo.memory_space" ||
                    attr.getName() == "lmhlo.output_index");
     }
   }
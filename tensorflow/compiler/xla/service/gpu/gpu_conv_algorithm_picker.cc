@@ -19,12 +19,14 @@ limitations under the License.
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/time/time.h"
 #include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/autotune_results.h"
 #include "tensorflow/compiler/xla/service/gpu/backend_configs.pb.h"
 #include "tensorflow/compiler/xla/service/gpu/convolution_thunk.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_asm_opts_util.h"
@@ -361,6 +363,15 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
     autotune_cache_stats.cache_misses++;
   }
 
+  TF_ASSIGN_OR_RETURN(std::optional<AutotuneResult> saved_result,
+                      FindAutotuneResult(AutotuneResultsDb::Kind::kConv,
+                                         stream_exec_, *instr));
+  if (saved_result.has_value()) {
+    absl::MutexLock lock(&autotune_cache_lock);
+    CHECK(autotune_cache.insert({key, *saved_result}).second);
+    return *saved_result;
+  }
+
   // Make sure any previous activity on this executor is done. We don't want
   // other work still running on the GPU to interfere with autotuning.
   if (!stream_exec_->SynchronizeAllActivity()) {
@@ -395,6 +406,8 @@ StatusOr<AutotuneResult> GpuConvAlgorithmPicker::PickBestAlgorithm(
   }
 
   if (result_or.ok()) {
+    AddAutotuneResult(AutotuneResultsDb::Kind::kConv, stream_exec_, *instr,
+                      result_or.ValueOrDie());
     absl::MutexLock lock(&autotune_cache_lock);
     CHECK(autotune_cache.insert({key, result_or.ValueOrDie()}).second);
   }
@@ -996,6 +1009,35 @@ StatusOr<bool> GpuConvAlgorithmPicker::RunOnComputation(
   return changed;
 }
 
+void GpuConvAlgorithmPicker::AutotuneInParallel(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  std::vector<const HloCustomCallInstruction*> convs;
+  for (HloComputation* computation :
+       module->MakeNonfusionComputations(execution_threads)) {
+    for (HloInstruction* instr : computation->instructions()) {
+      if (IsCustomCallToDnnConvolution(*instr)) {
+        convs.push_back(Cast<HloCustomCallInstruction>(instr));
+      }
+    }
+  }
+  AutotuneOnIdenticalDevices(
+      stream_exec_, convs.size(),
+      [&](se::StreamExecutor* executor, int64_t i) {
+        // `allocator_` only allocates memory on the device of `stream_exec_`.
+        GpuConvAlgorithmPicker picker(
+            executor, executor == stream_exec_ ? allocator_ : nullptr);
+        StatusOr<AutotuneResult> result = picker.PickBestAlgorithm(convs[i]);
+        // Failures are reported when the convolution is autotuned again on
+        // `stream_exec_`.
+        if (!result.ok()) {
+          VLOG(1) << "Failed to autotune " << convs[i]->name()
+                  << " on device " << executor->device_ordinal() << ": "
+                  << result.status();
+        }
+      });
+}
+
 StatusOr<bool> GpuConvAlgorithmPicker::Run(
     HloModule* module,
     const absl::flat_hash_set<absl::string_view>& execution_threads) {
@@ -1006,6 +1048,11 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(
                "returning early.";
     return false;
   }
+  const DebugOptions& debug_options = module->config().debug_options();
+  TF_RETURN_IF_ERROR(MaybeLoadAutotuneResults(debug_options));
+  if (debug_options.xla_gpu_parallel_autotuning()) {
+    AutotuneInParallel(module, execution_threads);
+  }
 
   bool changed = false;
   for (HloComputation* computation :
@@ -1018,6 +1065,7 @@ StatusOr<bool> GpuConvAlgorithmPicker::Run(
     absl::MutexLock lock(&autotune_cache_lock);
     autotune_cache_stats.LogStats();
   }
+  TF_RETURN_IF_ERROR(MaybeSaveAutotuneResults(debug_options));
 
   return changed;
 }
@@ -56,6 +56,12 @@ class GpuConvAlgorithmPicker : public HloModulePass {
       const absl::flat_hash_set<absl::string_view>& execution_threads) override;
 
  private:
+  // Autotunes the convolutions of `module` in parallel on the devices
+  // identical to `stream_exec_`, which fills the autotuning caches.
+  void AutotuneInParallel(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads);
+
   StatusOr<bool> RunOnComputation(HloComputation* computation);
   StatusOr<bool> RunOnInstruction(HloInstruction* instr);
   StatusOr<tensorflow::AutotuneResult> PickBestAlgorithm(
@@ -221,6 +221,12 @@ StatusOr<std::unique_ptr<GpuExecutable>> GpuExecutable::Create(Params params) {
 
   if (std::holds_alternative<OwnedThunkSequence>(executable)) {
     result->thunks_ = std::move(std::get<OwnedThunkSequence>(executable));
+    if (result->has_module() && result->module_config()
+                                    .debug_options()
+                                    .xla_gpu_enable_cuda_graphs()) {
+      result->thunk_graph_cache_ =
+          std::make_unique<ThunkGraphCache>(*result->thunks_);
+    }
     return result;
   }
 
@@ -317,6 +323,7 @@ Status MaybeSyncAndProfile(const ServiceExecutableRunOptions* run_options,
 
 Status ExecuteThunks(const std::string& module_name,
                      const ThunkSequence& thunk_sequence,
+                     ThunkGraphCache* thunk_graph_cache,
                      const ServiceExecutableRunOptions* run_options,
                      const BufferAllocations& buffer_allocations,
                      bool block_host_until_done) {
@@ -332,19 +339,28 @@ Status ExecuteThunks(const std::string& module_name,
       [&] { return absl::StrCat(module_name, ":XLA GPU module"); },
       tensorflow::profiler::TraceMeLevel::kInfo);
 
-  for (const std::unique_ptr<Thunk>& thunk : thunk_sequence) {
+  auto execute_thunk = [&](Thunk& thunk) -> Status {
     // Annotate execution of this op if tracing was enabled when we started
     // running this module.  If tracing is enabled *while* we're running the
     // module, we won't get any data, but that's probably an OK trade-off.
-    ScopedAnnotation annotation([&] { return thunk->profile_annotation(); });
-    VLOG(2) << "Executing the thunk for " << thunk->profile_annotation();
-    TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(*thunk))
+    ScopedAnnotation annotation([&] { return thunk.profile_annotation(); });
+    VLOG(2) << "Executing the thunk for " << thunk.profile_annotation();
+    TF_RET_CHECK(async_comms_stream.ok() || !NeedsAsyncCommsStream(thunk))
         << "`run_options` must have a stream borrower for async thunks.";
 
     Thunk::ExecuteParams thunk_params{
         *run_options, buffer_allocations, main_stream,
         async_comms_stream.ok() ? async_comms_stream->get() : nullptr};
-    TF_RETURN_IF_ERROR(thunk->ExecuteOnStream(thunk_params));
+    return thunk.ExecuteOnStream(thunk_params);
+  };
+
+  if (thunk_graph_cache != nullptr) {
+    TF_RETURN_IF_ERROR(thunk_graph_cache->Execute(
+        main_stream, buffer_allocations, execute_thunk));
+  } else {
+    for (const std::unique_ptr<Thunk>& thunk : thunk_sequence) {
+      TF_RETURN_IF_ERROR(execute_thunk(*thunk));
+    }
   }
   return MaybeSyncAndProfile(run_options, start_micros,
                              block_host_until_done ? main_stream : nullptr);
@@ -496,8 +512,10 @@ StatusOr<se::DeviceMemoryBase> GpuExecutable::BufferForAllocation(
     const int64_t buffer_size = allocation.size();
     se::DeviceMemoryBase buffer_address;
     if (buffer_size > 0) {
-      StatusOr<se::OwningDeviceMemory> buffer =
-          memory_allocator->Allocate(device_ordinal, buffer_size);
+      // The color of an allocation is the memory space of its buffers.
+      StatusOr<se::OwningDeviceMemory> buffer = memory_allocator->Allocate(
+          device_ordinal, buffer_size, /*retry_on_failure=*/true,
+          /*memory_space=*/allocation.color());
       if (!buffer.ok()) {
         return ResourceExhausted("%s\n%s\n", buffer.status().error_message(),
                                  verbose_buffer_assignment_string_dumper_());
@@ -852,8 +870,9 @@ Status GpuExecutable::ExecuteThunksOrJitRt(
     for (const std::unique_ptr<Thunk>& thunk : *thunks_) {
       TF_RETURN_IF_ERROR(thunk->Initialize(*this, executor));
     }
-    return ExecuteThunks(module_name_, *thunks_, run_options,
-                         buffer_allocations, block_host_until_done);
+    return ExecuteThunks(module_name_, *thunks_, thunk_graph_cache_.get(),
+                         run_options, buffer_allocations,
+                         block_host_until_done);
   }
 
 #if XLA_ENABLE_XLIR
@@ -917,6 +936,10 @@ Status GpuExecutable::SetUpMlirAllocation(
     if (func.getArgAttr(i, "lmhlo.constant_name")) {
       allocations->at(buffer_index).set_constant(true);
     }
+    if (auto memory_space_attr = func.getArgAttrOfType<mlir::IntegerAttr>(
+            i, "lmhlo.memory_space")) {
+      allocations->at(buffer_index).set_color(memory_space_attr.getInt());
+    }
     if (auto output_index_attr = func.getArgAttr(i, "lmhlo.output_index")) {
       allocations->at(buffer_index).set_maybe_live_out(true);
 
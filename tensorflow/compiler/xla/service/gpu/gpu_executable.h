@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
 #include "tensorflow/compiler/xla/service/gpu/gpu_types.h"
 #include "tensorflow/compiler/xla/service/gpu/thunk.h"
+#include "tensorflow/compiler/xla/service/gpu/thunk_graph_cache.h"
 #include "tensorflow/compiler/xla/service/hlo_dataflow_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_execution_profile.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -273,6 +274,9 @@ class GpuExecutable : public Executable {
   // IrEmitter.
   OwnedThunkSequence thunks_;
 
+  // Replays the thunks as CUDA graphs if xla_gpu_enable_cuda_graphs is set.
+  std::unique_ptr<ThunkGraphCache> thunk_graph_cache_;
+
   xla::EntryFunctionAttributes entry_func_attrs_;
 
   std::string module_name_;
@@ -15,14 +15,19 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu/gpu_hlo_schedule.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/xla/service/buffer_value.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_hlo_cost_analysis.h"
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/service/hlo_memory_scheduler.h"
 #include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 
 namespace xla {
 namespace gpu {
@@ -149,18 +154,375 @@ HloInstructionSequence PostprocessorToScheduleAsEarlyOrLateAsPossible(
   return result;
 }
 
+// Estimated throughput of the collectives and of the device, used by the
+// latency-hiding scheduler. Only their ratios matter.
+constexpr float kCollectiveBytesPerSecond = 1e10;
+constexpr float kCollectiveLatencySeconds = 5e-5;
+constexpr float kDeviceFlopsPerSecond = 1e13;
+constexpr float kDeviceBytesPerSecond = 5e11;
+
+// Fraction by which the latency-hiding scheduler may exceed the estimated
+// peak memory of the memory-minimizing schedule, unless a limit is set.
+constexpr float kDefaultMemoryHeadroom = 0.1;
+
+bool IsAsyncCollectiveStart(const HloInstruction& instr) {
+  switch (instr.opcode()) {
+    case HloOpcode::kAllGatherStart:
+    case HloOpcode::kAllReduceStart:
+    case HloOpcode::kCollectivePermuteStart:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsAsyncCollectiveDone(const HloInstruction& instr) {
+  switch (instr.opcode()) {
+    case HloOpcode::kAllGatherDone:
+    case HloOpcode::kAllReduceDone:
+    case HloOpcode::kCollectivePermuteDone:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if `instr` defines no buffer and forwards the buffers of its
+// operands instead.
+bool ForwardsOperandBuffers(const HloInstruction& instr) {
+  switch (instr.opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kTuple:
+      return true;
+    default:
+      return IsAsyncCollectiveDone(instr);
+  }
+}
+
+// Estimates the bytes of live buffers while the instructions of a computation
+// are scheduled one by one. A buffer is live from its definition until all of
+// the instructions that use it, directly or through forwarding instructions,
+// are scheduled. Parameters and outputs stay live.
+class MemoryTracker {
+ public:
+  MemoryTracker(const HloInstructionSequence& sequence, int64_t pointer_size) {
+    for (const HloInstruction* instr : sequence.instructions()) {
+      std::vector<const HloInstruction*>& sources = sources_[instr];
+      if (ForwardsOperandBuffers(*instr)) {
+        for (const HloInstruction* operand : instr->operands()) {
+          for (const HloInstruction* source : sources_.at(operand)) {
+            if (!absl::c_linear_search(sources, source)) {
+              sources.push_back(source);
+            }
+          }
+        }
+        continue;
+      }
+      sources.push_back(instr);
+
+      int64_t& bytes = bytes_[instr];
+      if (instr->opcode() != HloOpcode::kConstant) {
+        ShapeUtil::ForEachSubshape(
+            instr->shape(), [&](const Shape& subshape, const ShapeIndex&) {
+              if (subshape.IsArray()) {
+                bytes += ShapeUtil::ByteSizeOf(subshape, pointer_size);
+              }
+            });
+      }
+      if (instr->opcode() == HloOpcode::kParameter) {
+        ++pending_uses_[instr];
+      }
+      std::vector<const HloInstruction*>& used = used_sources_[instr];
+      for (const HloInstruction* operand : instr->operands()) {
+        for (const HloInstruction* source : sources_.at(operand)) {
+          if (!absl::c_linear_search(used, source)) {
+            used.push_back(source);
+            ++pending_uses_[source];
+          }
+        }
+      }
+    }
+    const HloComputation* computation = sequence.instructions()[0]->parent();
+    for (const HloInstruction* source :
+         sources_.at(computation->root_instruction())) {
+      ++pending_uses_[source];
+    }
+  }
+
+  // Returns the bytes of the buffers defined by `instr`.
+  int64_t OutputBytes(const HloInstruction* instr) const {
+    auto it = bytes_.find(instr);
+    return it == bytes_.end() ? 0 : it->second;
+  }
+
+  // Returns the bytes of the buffers that die once `instr` is scheduled.
+  int64_t FreedBytes(const HloInstruction* instr) const {
+    int64_t freed = 0;
+    auto it = used_sources_.find(instr);
+    if (it != used_sources_.end()) {
+      for (const HloInstruction* source : it->second) {
+        if (pending_uses_.at(source) == 1) {
+          freed += OutputBytes(source);
+        }
+      }
+    }
+    if (!pending_uses_.contains(instr)) {
+      freed += OutputBytes(instr);
+    }
+    return freed;
+  }
+
+  void Schedule(const HloInstruction* instr) {
+    const int64_t freed = FreedBytes(instr);
+    live_bytes_ += OutputBytes(instr);
+    peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+    live_bytes_ -= freed;
+    auto it = used_sources_.find(instr);
+    if (it != used_sources_.end()) {
+      for (const HloInstruction* source : it->second) {
+        --pending_uses_[source];
+      }
+    }
+  }
+
+  int64_t live_bytes() const { return live_bytes_; }
+  int64_t peak_bytes() const { return peak_bytes_; }
+
+ private:
+  // The instructions whose buffers each instruction defines or forwards.
+  absl::flat_hash_map<const HloInstruction*,
+                      std::vector<const HloInstruction*>>
+      sources_;
+  // The buffers used by each instruction that is not forwarding.
+  absl::flat_hash_map<const HloInstruction*,
+                      std::vector<const HloInstruction*>>
+      used_sources_;
+  absl::flat_hash_map<const HloInstruction*, int64_t> bytes_;
+  // Number of unscheduled instructions that use each buffer.
+  absl::flat_hash_map<const HloInstruction*, int64_t> pending_uses_;
+  int64_t live_bytes_ = 0;
+  int64_t peak_bytes_ = 0;
+};
+
+// Reorders the memory-minimizing `sequence` of a computation so that
+// asynchronous collectives overlap with independent compute.
+//
+// This is a list scheduler that simulates one compute stream and one stream on
+// which the collectives run one after another, with the times estimated by
+// `cost_analysis`. An instruction is picked among the ready ones in this order
+// of preference:
+//  1. a collective done whose collective is estimated to be complete,
+//  2. a collective start, so that collectives start as early as their
+//     operands allow,
+//  3. another instruction, preferring the ones that lead to a collective
+//     start, then the order of `sequence`,
+//  4. the collective done that is estimated to complete first, as the compute
+//     stream would otherwise be idle.
+// Collective starts and other instructions are only picked if the estimated
+// live bytes stay within `memory_limit_bytes`. If no instruction fits, the one
+// that frees the most memory is picked.
+HloInstructionSequence ScheduleToHideLatency(
+    const HloInstructionSequence& sequence, int64_t pointer_size,
+    int64_t memory_limit_bytes, const HloCostAnalysis& cost_analysis) {
+  const std::vector<HloInstruction*>& instructions = sequence.instructions();
+  absl::flat_hash_map<const HloInstruction*, int64_t> positions;
+  for (int64_t i = 0; i < instructions.size(); ++i) {
+    positions[instructions[i]] = i;
+  }
+
+  // Instructions that a collective start depends on.
+  absl::flat_hash_set<const HloInstruction*> leads_to_start;
+  std::vector<const HloInstruction*> worklist;
+  for (const HloInstruction* instr : instructions) {
+    if (IsAsyncCollectiveStart(*instr)) {
+      worklist.push_back(instr);
+    }
+  }
+  while (!worklist.empty()) {
+    const HloInstruction* instr = worklist.back();
+    worklist.pop_back();
+    for (const HloInstruction* operand : instr->operands()) {
+      if (leads_to_start.insert(operand).second) {
+        worklist.push_back(operand);
+      }
+    }
+    for (const HloInstruction* predecessor : instr->control_predecessors()) {
+      if (leads_to_start.insert(predecessor).second) {
+        worklist.push_back(predecessor);
+      }
+    }
+  }
+
+  absl::flat_hash_map<const HloInstruction*, int64_t> unscheduled_deps;
+  std::vector<HloInstruction*> ready;
+  for (HloInstruction* instr : instructions) {
+    const int64_t deps = instr->unique_operands().size() +
+                         instr->control_predecessors().size();
+    unscheduled_deps[instr] = deps;
+    if (deps == 0) {
+      ready.push_back(instr);
+    }
+  }
+
+  MemoryTracker memory(sequence, pointer_size);
+  auto fits = [&](const HloInstruction* instr) {
+    return memory.live_bytes() + memory.OutputBytes(instr) <=
+           memory_limit_bytes;
+  };
+  auto earlier = [&](const HloInstruction* a, const HloInstruction* b) {
+    return positions.at(a) < positions.at(b);
+  };
+
+  // Estimated time on the compute stream, time at which the collective stream
+  // becomes idle, and completion time of each started collective.
+  float now = 0;
+  float collectives_idle = 0;
+  absl::flat_hash_map<const HloInstruction*, float> completion;
+
+  HloInstructionSequence result;
+  while (!ready.empty()) {
+    int64_t complete_done = -1, start = -1, compute = -1, pending_done = -1;
+    int64_t fallback = -1;
+    for (int64_t i = 0; i < ready.size(); ++i) {
+      const HloInstruction* instr = ready[i];
+      if (IsAsyncCollectiveDone(*instr)) {
+        const float done_time = completion.at(instr->operand(0));
+        if (done_time <= now) {
+          if (complete_done < 0 || earlier(instr, ready[complete_done])) {
+            complete_done = i;
+          }
+        } else if (pending_done < 0 ||
+                   done_time < completion.at(ready[pending_done]->operand(0))) {
+          pending_done = i;
+        }
+      } else if (fits(instr)) {
+        if (IsAsyncCollectiveStart(*instr)) {
+          if (start < 0 || earlier(instr, ready[start])) {
+            start = i;
+          }
+        } else if (compute < 0 ||
+                   std::make_pair(!leads_to_start.contains(instr),
+                                  positions.at(instr)) <
+                       std::make_pair(!leads_to_start.contains(ready[compute]),
+                                      positions.at(ready[compute]))) {
+          compute = i;
+        }
+      }
+      if (fallback < 0 ||
+          std::make_pair(memory.OutputBytes(instr) - memory.FreedBytes(instr),
+                         positions.at(instr)) <
+              std::make_pair(memory.OutputBytes(ready[fallback]) -
+                                 memory.FreedBytes(ready[fallback]),
+                             positions.at(ready[fallback]))) {
+        fallback = i;
+      }
+    }
+    int64_t picked = complete_done;
+    for (int64_t candidate : {start, compute, pending_done, fallback}) {
+      if (picked < 0) {
+        picked = candidate;
+      }
+    }
+
+    HloInstruction* instr = ready[picked];
+    ready[picked] = ready.back();
+    ready.pop_back();
+    if (IsAsyncCollectiveStart(*instr)) {
+      collectives_idle =
+          std::max(now, collectives_idle) + kCollectiveLatencySeconds +
+          cost_analysis.bytes_accessed(*instr) / kCollectiveBytesPerSecond;
+      completion[instr] = collectives_idle;
+    } else if (IsAsyncCollectiveDone(*instr)) {
+      now = std::max(now, completion.at(instr->operand(0)));
+    } else {
+      now += cost_analysis.optimal_seconds(*instr);
+    }
+    memory.Schedule(instr);
+    result.push_back(instr);
+
+    auto release = [&](HloInstruction* successor) {
+      if (--unscheduled_deps[successor] == 0) {
+        ready.push_back(successor);
+      }
+    };
+    for (HloInstruction* user : instr->users()) {
+      release(user);
+    }
+    for (HloInstruction* successor : instr->control_successors()) {
+      release(successor);
+    }
+  }
+  CHECK_EQ(result.size(), instructions.size());
+  return result;
+}
+
+// Reschedules the computations of `module` that contain asynchronous
+// collectives with `ScheduleToHideLatency`.
+Status ScheduleModuleToHideLatency(const HloModule* module,
+                                   int64_t pointer_size,
+                                   HloSchedule* schedule) {
+  const int64_t memory_limit_bytes =
+      module->config()
+          .debug_options()
+          .xla_gpu_latency_hiding_scheduler_memory_limit_bytes();
+  for (const HloComputation* computation :
+       module->MakeNonfusionComputations()) {
+    if (!schedule->is_computation_scheduled(computation) ||
+        absl::c_none_of(computation->instructions(),
+                        [](const HloInstruction* instr) {
+                          return IsAsyncCollectiveStart(*instr);
+                        })) {
+      continue;
+    }
+    const HloInstructionSequence& sequence = schedule->sequence(computation);
+
+    HloCostAnalysis::Options options{[pointer_size](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, pointer_size);
+    }};
+    options.set_flops_per_second(kDeviceFlopsPerSecond);
+    options.set_bytes_per_second(kDeviceBytesPerSecond);
+    GpuHloCostAnalysis cost_analysis(options);
+    TF_RETURN_IF_ERROR(computation->Accept(&cost_analysis));
+
+    int64_t limit = memory_limit_bytes;
+    if (limit <= 0) {
+      MemoryTracker memory(sequence, pointer_size);
+      for (const HloInstruction* instr : sequence.instructions()) {
+        memory.Schedule(instr);
+      }
+      limit = static_cast<int64_t>(memory.peak_bytes() *
+                                   (1 + kDefaultMemoryHeadroom));
+    }
+    schedule->set_sequence(
+        computation,
+        PostprocessorToScheduleAsEarlyOrLateAsPossible(ScheduleToHideLatency(
+            sequence, pointer_size, limit, cost_analysis)));
+  }
+  return OkStatus();
+}
+
 }  // end namespace
 
 StatusOr<HloSchedule> ScheduleGpuModule(const HloModule* module,
                                         int64_t pointer_size) {
-  return ScheduleModule(
-      module,
-      [pointer_size](const BufferValue& buffer) {
-        return ShapeUtil::ByteSizeOf(buffer.shape(), pointer_size);
-      },
-      ComputationSchedulerToModuleScheduler(
-          DefaultMemoryScheduler,
-          PostprocessorToScheduleAsEarlyOrLateAsPossible));
+  TF_ASSIGN_OR_RETURN(
+      HloSchedule schedule,
+      ScheduleModule(module,
+                     [pointer_size](const BufferValue& buffer) {
+                       return ShapeUtil::ByteSizeOf(buffer.shape(),
+                                                    pointer_size);
+                     },
+                     ComputationSchedulerToModuleScheduler(
+                         DefaultMemoryScheduler,
+                         PostprocessorToScheduleAsEarlyOrLateAsPossible)));
+  if (module->config()
+          .debug_options()
+          .xla_gpu_enable_latency_hiding_scheduler()) {
+    TF_RETURN_IF_ERROR(
+        ScheduleModuleToHideLatency(module, pointer_size, &schedule));
+  }
+  return schedule;
 }
 
 }  // namespace gpu
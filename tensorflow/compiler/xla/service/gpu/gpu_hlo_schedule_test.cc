@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/compiler/xla/tests/test_utils.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 
 namespace xla {
 namespace gpu {
@@ -235,5 +236,74 @@ TEST_F(GpuHloScheduleTest, AsyncAllReduce) {
   EXPECT_TRUE(order.ExecutesBefore(all_reduce_done, add4));
 }
 
+class GpuLatencyHidingScheduleTest : public GpuHloScheduleTest {
+ protected:
+  // The all-reduce depends on the `a` chain, and the `b` chain is independent
+  // of it.
+  static constexpr absl::string_view kHloText = R"(
+  HloModule m
+
+  add {
+    x = f32[] parameter(0)
+    y = f32[] parameter(1)
+    ROOT add = f32[] add(x, y)
+  }
+
+  ENTRY e {
+    p0 = f32[1024] parameter(0)
+    p1 = f32[1024,1024] parameter(1)
+    b0 = f32[1024,1024] dot(p1, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    b1 = f32[1024,1024] dot(b0, p1), lhs_contracting_dims={1}, rhs_contracting_dims={0}
+    a0 = f32[1024] negate(p0)
+    a1 = f32[1024] exponential(a0)
+    start = (f32[1024], f32[1024]) all-reduce-start(a1), to_apply=add
+    done = f32[1024] all-reduce-done(start)
+    c = f32[1024] negate(done)
+    ROOT t = (f32[1024], f32[1024,1024]) tuple(c, b1)
+  })";
+
+  std::unique_ptr<HloModule> ParseModule(int64_t memory_limit_bytes) {
+    HloModuleConfig config = GetModuleConfigForTest();
+    DebugOptions debug_options = GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_latency_hiding_scheduler(true);
+    debug_options.set_xla_gpu_latency_hiding_scheduler_memory_limit_bytes(
+        memory_limit_bytes);
+    config.set_debug_options(debug_options);
+    return ParseAndReturnVerifiedModule(kHloText, config).value();
+  }
+};
+
+TEST_F(GpuLatencyHidingScheduleTest, OverlapsAllReduceWithIndependentCompute) {
+  std::unique_ptr<HloModule> module = ParseModule(/*memory_limit_bytes=*/0);
+  SequentialHloOrdering order = BuildHloOrdering(module.get());
+  VLOG(2) << order.ToString();
+
+  auto get = [&](absl::string_view name) {
+    return FindInstruction(module.get(), name);
+  };
+  // The all-reduce starts before the independent dots, and completes after
+  // the first one, which is estimated to take longer than the all-reduce.
+  EXPECT_TRUE(order.ExecutesBefore(get("start"), get("b0")));
+  EXPECT_TRUE(order.ExecutesBefore(get("b0"), get("done")));
+  EXPECT_TRUE(order.ExecutesBefore(get("done"), get("c")));
+}
+
+TEST_F(GpuLatencyHidingScheduleTest, RespectsDependenciesUnderTightLimit) {
+  // No instruction fits the limit, so the scheduler falls back to picking the
+  // ready instructions that need the least memory.
+  std::unique_ptr<HloModule> module = ParseModule(/*memory_limit_bytes=*/1);
+  HloSchedule schedule = ScheduleGpuModule(module.get(), /*pointer_size=*/8)
+                             .value();
+  TF_EXPECT_OK(schedule.Verify());
+  SequentialHloOrdering order{schedule};
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  for (const HloInstruction* instr :
+       module->entry_computation()->instructions()) {
+    if (instr != root) {
+      EXPECT_TRUE(order.ExecutesBefore(instr, root)) << instr->name();
+    }
+  }
+}
+
 }  // namespace gpu
 }  // namespace xla
@@ -0,0 +1,288 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offloader.h"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/compiler/xla/layout_util.h"
+#include "tensorflow/compiler/xla/service/gpu/gpu_hlo_cost_analysis.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/service/hlo_schedule.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+using PositionMap = absl::flat_hash_map<const HloInstruction*, int64_t>;
+
+// Returns true if `instr` defines no buffer and forwards the buffers of its
+// operands instead.
+bool ForwardsOperandBuffers(const HloInstruction* instr) {
+  switch (instr->opcode()) {
+    case HloOpcode::kBitcast:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kTuple:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns the size of the device buffers defined by `instr`.
+int64_t DeviceBytes(const HloInstruction* instr, int64_t pointer_size) {
+  if (ForwardsOperandBuffers(instr) ||
+      instr->opcode() == HloOpcode::kConstant) {
+    return 0;
+  }
+  int64_t bytes = 0;
+  ShapeUtil::ForEachSubshape(
+      instr->shape(), [&](const Shape& subshape, const ShapeIndex& index) {
+        if (subshape.IsArray() && LayoutUtil::MemorySpace(subshape) !=
+                                      HostMemoryOffloader::kHostMemorySpace) {
+          bytes += ShapeUtil::ByteSizeOf(subshape, pointer_size);
+        }
+      });
+  return bytes;
+}
+
+// Live range of the device buffers defined by an instruction, in positions of
+// the sequence of its computation.
+struct LiveRange {
+  int64_t bytes = 0;
+  int64_t start = 0;
+  int64_t end = 0;
+};
+
+// Estimates the live ranges of the buffers defined by each instruction of
+// `sequence`. Buffers forwarded by other instructions are live until the last
+// use of these instructions. This ignores buffer sharing between operands and
+// outputs, which only makes the estimate of the memory use conservative.
+std::vector<LiveRange> ComputeLiveRanges(
+    absl::Span<HloInstruction* const> sequence, const PositionMap& positions,
+    int64_t pointer_size) {
+  const int64_t size = sequence.size();
+  std::vector<LiveRange> ranges(size);
+  for (int64_t i = size - 1; i >= 0; --i) {
+    const HloInstruction* instr = sequence[i];
+    LiveRange& range = ranges[i];
+    range.bytes = DeviceBytes(instr, pointer_size);
+    // Parameters and outputs are live during the whole computation.
+    const bool is_parameter = instr->opcode() == HloOpcode::kParameter;
+    range.start = is_parameter ? 0 : i;
+    range.end = is_parameter || instr == instr->parent()->root_instruction()
+                    ? size - 1
+                    : i;
+    for (const HloInstruction* user : instr->users()) {
+      const int64_t position = positions.at(user);
+      range.end = std::max(range.end, ForwardsOperandBuffers(user)
+                                          ? ranges[position].end
+                                          : position);
+    }
+  }
+  return ranges;
+}
+
+// Returns the position at which the estimated device memory use peaks, and
+// the peak in bytes.
+std::pair<int64_t, int64_t> FindPeak(absl::Span<const LiveRange> ranges) {
+  std::vector<int64_t> deltas(ranges.size() + 1, 0);
+  for (const LiveRange& range : ranges) {
+    deltas[range.start] += range.bytes;
+    deltas[range.end + 1] -= range.bytes;
+  }
+  int64_t bytes = 0;
+  int64_t peak_bytes = 0;
+  int64_t peak_position = 0;
+  for (int64_t i = 0; i < ranges.size(); ++i) {
+    bytes += deltas[i];
+    if (bytes > peak_bytes) {
+      peak_bytes = bytes;
+      peak_position = i;
+    }
+  }
+  return {peak_position, peak_bytes};
+}
+
+// A value to offload, with the positions of the uses around the gap that the
+// offload spans.
+struct Offload {
+  HloInstruction* instr;
+  int64_t bytes;
+  // Position of the last use before the gap, or of the definition.
+  int64_t before_gap;
+  // Position of the first use after the gap.
+  int64_t after_gap;
+};
+
+// Returns the largest value live across `peak_position` without a use there
+// that is worth offloading, if any.
+std::optional<Offload> FindOffload(
+    const HostMemoryOffloader::Options& options,
+    absl::Span<HloInstruction* const> sequence, const PositionMap& positions,
+    absl::Span<const LiveRange> ranges, int64_t peak_position,
+    const HloCostAnalysis& cost_analysis,
+    const absl::flat_hash_set<const HloInstruction*>& excluded) {
+  std::optional<Offload> best;
+  for (int64_t i = 0; i < peak_position; ++i) {
+    HloInstruction* instr = sequence[i];
+    const LiveRange& range = ranges[i];
+    if (range.end <= peak_position || range.bytes < options.min_buffer_bytes ||
+        (best.has_value() && range.bytes <= best->bytes) ||
+        !instr->shape().IsArray() ||
+        instr->opcode() == HloOpcode::kParameter ||
+        instr == instr->parent()->root_instruction() ||
+        excluded.contains(instr)) {
+      continue;
+    }
+
+    std::vector<int64_t> uses = {i};
+    bool forwarded = false;
+    for (const HloInstruction* user : instr->users()) {
+      forwarded |= ForwardsOperandBuffers(user);
+      uses.push_back(positions.at(user));
+    }
+    if (forwarded) {
+      continue;
+    }
+    absl::c_sort(uses);
+    auto after_gap = absl::c_upper_bound(uses, peak_position);
+    if (after_gap == uses.end() || *std::prev(after_gap) == peak_position) {
+      continue;
+    }
+    Offload offload{instr, range.bytes, *std::prev(after_gap), *after_gap};
+
+    float gap_seconds = 0;
+    for (int64_t j = offload.before_gap + 1; j < offload.after_gap; ++j) {
+      gap_seconds += cost_analysis.optimal_seconds(*sequence[j]);
+    }
+    const float copy_seconds =
+        2.0f * offload.bytes / options.host_bytes_per_second;
+    if (copy_seconds > options.max_copy_time_fraction * gap_seconds) {
+      VLOG(3) << "Not offloading " << instr->name() << ": copies take "
+              << copy_seconds << "s for a gap of " << gap_seconds << "s";
+      continue;
+    }
+    best = offload;
+  }
+  return best;
+}
+
+// Inserts the copies of `offload` and updates `schedule`.
+Status ApplyOffload(const Offload& offload, const PositionMap& positions,
+                    HloSchedule& schedule,
+                    absl::flat_hash_set<const HloInstruction*>& excluded) {
+  HloInstruction* instr = offload.instr;
+  HloComputation* computation = instr->parent();
+  Shape host_shape = instr->shape();
+  host_shape.mutable_layout()->set_memory_space(
+      HostMemoryOffloader::kHostMemorySpace);
+  HloInstruction* evict = computation->AddInstruction(
+      HloInstruction::CreateUnary(host_shape, HloOpcode::kCopy, instr));
+  HloInstruction* prefetch = computation->AddInstruction(
+      HloInstruction::CreateUnary(instr->shape(), HloOpcode::kCopy, evict));
+
+  std::vector<HloInstruction*> users = instr->users();
+  for (HloInstruction* user : users) {
+    if (user != evict && positions.at(user) >= offload.after_gap) {
+      TF_RETURN_IF_ERROR(instr->ReplaceUseWith(user, prefetch));
+    }
+  }
+
+  const HloInstructionSequence& old_sequence = schedule.sequence(computation);
+  HloInstructionSequence sequence;
+  for (int64_t i = 0; i < old_sequence.size(); ++i) {
+    if (i == offload.after_gap) {
+      sequence.push_back(prefetch);
+    }
+    sequence.push_back(old_sequence.instructions()[i]);
+    if (i == offload.before_gap) {
+      sequence.push_back(evict);
+    }
+  }
+  schedule.set_sequence(computation, std::move(sequence));
+
+  excluded.insert({instr, evict, prefetch});
+  VLOG(2) << "Offloading " << instr->name() << " (" << offload.bytes
+          << " bytes) between " << evict->name() << " and "
+          << prefetch->name();
+  return OkStatus();
+}
+
+}  // namespace
+
+StatusOr<bool> HostMemoryOffloader::Run(
+    HloModule* module,
+    const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  TF_RET_CHECK(module->has_schedule());
+  if (options_.memory_limit_bytes <= 0) {
+    return false;
+  }
+  HloComputation* entry = module->entry_computation();
+
+  const int64_t pointer_size = options_.pointer_size;
+  HloCostAnalysis::Options cost_options{[pointer_size](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, pointer_size);
+  }};
+  cost_options.set_flops_per_second(options_.device_flops_per_second);
+  cost_options.set_bytes_per_second(options_.device_bytes_per_second);
+  GpuHloCostAnalysis cost_analysis(cost_options);
+  TF_RETURN_IF_ERROR(entry->Accept(&cost_analysis));
+
+  // Offloaded values and the copies inserted by the pass.
+  absl::flat_hash_set<const HloInstruction*> excluded;
+  bool changed = false;
+  while (true) {
+    const std::vector<HloInstruction*>& sequence =
+        module->schedule().sequence(entry).instructions();
+    PositionMap positions;
+    for (int64_t i = 0; i < sequence.size(); ++i) {
+      positions[sequence[i]] = i;
+    }
+    std::vector<LiveRange> ranges =
+        ComputeLiveRanges(sequence, positions, pointer_size);
+    auto [peak_position, peak_bytes] = FindPeak(ranges);
+    if (peak_bytes <= options_.memory_limit_bytes) {
+      break;
+    }
+    std::optional<Offload> offload =
+        FindOffload(options_, sequence, positions, ranges, peak_position,
+                    cost_analysis, excluded);
+    if (!offload.has_value()) {
+      VLOG(1) << "Could not offload enough values of " << module->name()
+              << " to reach " << options_.memory_limit_bytes << " bytes, "
+              << "peak is " << peak_bytes << " bytes at "
+              << sequence[peak_position]->name();
+      break;
+    }
+    TF_RETURN_IF_ERROR(ApplyOffload(*offload, positions,
+                                    module->schedule(), excluded));
+    changed = true;
+  }
+  return changed;
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,91 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOADER_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOADER_H_
+
+#include <cstdint>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/compiler/xla/statusor.h"
+
+namespace xla {
+namespace gpu {
+
+// Offloads long-lived activations of a scheduled module to pinned host memory
+// when the peak device memory of the schedule exceeds a limit.
+//
+// An offloaded value X is evicted with a copy to the host memory space right
+// after its last use before a long gap in its uses, and prefetched back with a
+// copy right before its first use after the gap:
+//
+//   X = ...                        X = ...
+//   A = f(X)                       A = f(X)
+//   ...                 ==>        X.host = copy(X)
+//   B = g(X)                       ...
+//                                  X.device = copy(X.host)
+//                                  B = g(X.device)
+//
+// The copies run on the compute stream, so offloading trades time for memory.
+// A value is only offloaded if the estimated time of its two copies over the
+// host link is at most `max_copy_time_fraction` of the estimated time of the
+// instructions in the gap. Values are offloaded, largest first, until the
+// estimated peak memory of the entry computation fits the limit or no value
+// live at the peak is worth offloading.
+//
+// The buffers of the host memory space get their own buffer allocations,
+// which the GPU executable allocates in memory space `kHostMemorySpace`.
+//
+// This pass must run on a scheduled module, after all other HLO passes.
+class HostMemoryOffloader : public HloModulePass {
+ public:
+  // Memory space of the buffers in pinned host memory.
+  static constexpr int64_t kHostMemorySpace = 1;
+
+  struct Options {
+    // Peak size in bytes of the device buffers of the entry computation that
+    // the pass tries to reach.
+    int64_t memory_limit_bytes = 0;
+    // Smaller values are never offloaded.
+    int64_t min_buffer_bytes = 1 << 20;
+    // Bandwidth of copies between device and pinned host memory.
+    float host_bytes_per_second = 12e9;
+    // Throughput of the device, used to estimate the time of the gaps.
+    float device_flops_per_second = 1e13;
+    float device_bytes_per_second = 5e11;
+    // Upper bound on the ratio between the time of the copies of a value and
+    // the time of the gap they span.
+    float max_copy_time_fraction = 0.5;
+    int64_t pointer_size = 8;
+  };
+
+  explicit HostMemoryOffloader(const Options& options) : options_(options) {}
+  absl::string_view name() const override { return "host-memory-offloader"; }
+
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(
+      HloModule* module,
+      const absl::flat_hash_set<absl::string_view>& execution_threads) override;
+
+ private:
+  Options options_;
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_HOST_MEMORY_OFFLOADER_H_
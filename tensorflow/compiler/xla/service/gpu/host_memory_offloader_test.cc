@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/service/gpu/host_memory_offloader.h"
+
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/pattern_matcher.h"
+#include "tensorflow/compiler/xla/service/pattern_matcher_gmock.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+namespace m = xla::match;
+
+class HostMemoryOffloaderTest : public HloTestBase {
+ protected:
+  // `a` is live during the concatenation, whose buffers make the peak of
+  // 24MiB. Offloading `a` brings the peak down to 20MiB.
+  static constexpr absl::string_view kHloText = R"(
+  HloModule TestModule, is_scheduled=true
+
+  ENTRY TestComputation {
+    p0 = f32[1024,1024] parameter(0)
+    a = f32[1024,1024] exponential(p0)
+    b = f32[2048,1024] concatenate(p0, p0), dimensions={0}
+    c = f32[2048,1024] negate(b)
+    d = f32[1024,1024] slice(c), slice={[0:1024], [0:1024]}
+    ROOT e = f32[1024,1024] add(a, d)
+  })";
+
+  static HostMemoryOffloader::Options FastHostOptions() {
+    HostMemoryOffloader::Options options;
+    options.memory_limit_bytes = 20 << 20;
+    options.host_bytes_per_second = 1e12;
+    return options;
+  }
+};
+
+TEST_F(HostMemoryOffloaderTest, OffloadsValueLiveAtPeak) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  HostMemoryOffloader offloader(FastHostOptions());
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&offloader, module.get()));
+  EXPECT_TRUE(changed);
+
+  const HloInstruction* evict;
+  const HloInstruction* prefetch;
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              GmockMatch(m::Add(m::Copy(&prefetch, m::Copy(&evict, m::Exp())),
+                                m::Slice())));
+  EXPECT_EQ(evict->shape().layout().memory_space(),
+            HostMemoryOffloader::kHostMemorySpace);
+  EXPECT_EQ(prefetch->shape().layout().memory_space(), 0);
+
+  // The copies are scheduled around the gap.
+  const auto& sequence =
+      module->schedule().sequence(module->entry_computation()).instructions();
+  ASSERT_EQ(sequence.size(), 8);
+  EXPECT_EQ(sequence[2], evict);
+  EXPECT_EQ(sequence[6], prefetch);
+  TF_EXPECT_OK(module->schedule().Verify());
+}
+
+TEST_F(HostMemoryOffloaderTest, DoesNotOffloadWhenCopiesAreTooSlow) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  HostMemoryOffloader::Options options = FastHostOptions();
+  options.host_bytes_per_second = 1e9;
+  HostMemoryOffloader offloader(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&offloader, module.get()));
+  EXPECT_FALSE(changed);
+}
+
+TEST_F(HostMemoryOffloaderTest, DoesNotOffloadBelowLimit) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHloText));
+  HostMemoryOffloader::Options options = FastHostOptions();
+  options.memory_limit_bytes = 24 << 20;
+  HostMemoryOffloader offloader(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool changed, RunHloPass(&offloader, module.get()));
+  EXPECT_FALSE(changed);
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -1791,7 +1791,8 @@ Status IrEmitterUnnested::EmitFusion(mlir::Operation* op) {
 
     CHECK(ShapeUtil::Compatible(operand_shape, output_shape));
     auto maybe_slice = GetAllocationSlice(operands[0]);
-    if (LayoutUtil::Equal(operand_shape.layout(), output_shape.layout()) &&
+    if (Layout::Equal().IgnoreMemorySpace()(operand_shape.layout(),
+                                            output_shape.layout()) &&
         maybe_slice.ok()) {
       // Copy the operand into the output if it's not the same buffer already.
       auto operand_buffer = *maybe_slice;
@@ -2923,7 +2924,8 @@ StatusOr<std::unique_ptr<Thunk>> IrEmitterUnnested::BuildKernelThunkImpl(
   }
   std::optional<const BufferAllocation*> temp_buffer;
   for (const BufferAllocation& alloc : ir_emitter_context_->allocations()) {
-    if (alloc.IsPreallocatedTempBuffer()) {
+    if (alloc.IsPreallocatedTempBuffer() &&
+        alloc.color() == Layout::kDefaultMemorySpace) {
       if (!temp_buffer.has_value()) {
         // Retrieve the first seen temp buffer.
         temp_buffer = &alloc;
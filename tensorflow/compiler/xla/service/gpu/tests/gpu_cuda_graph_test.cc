@@ -0,0 +1,79 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <memory>
+#include <utility>
+
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/service/gpu/tests/gpu_codegen_test.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+
+namespace xla {
+namespace gpu {
+namespace {
+
+class GpuCudaGraphTest : public GpuCodegenTest {
+  DebugOptions GetDebugOptionsForTest() override {
+    DebugOptions debug_options = GpuCodegenTest::GetDebugOptionsForTest();
+    debug_options.set_xla_gpu_enable_cuda_graphs(true);
+    return debug_options;
+  }
+};
+
+TEST_F(GpuCudaGraphTest, ReplaysGraphWithNewBuffers) {
+  // A sort between two elementwise fusions, so that the thunk sequence has
+  // several kernels that are captured into one graph.
+  const char* hlo_text = R"(
+HloModule m
+
+compare {
+  p0 = f32[] parameter(0)
+  p1 = f32[] parameter(1)
+  ROOT lt = pred[] compare(p0, p1), direction=LT
+}
+
+ENTRY e {
+  p = f32[4] parameter(0)
+  c = f32[4] constant({1, 2, 3, 4})
+  add = f32[4] add(p, c)
+  neg = f32[4] negate(add)
+  sort = f32[4] sort(neg), dimensions={0}, to_apply=compare
+  ROOT mul = f32[4] multiply(sort, c)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<Executable> executable,
+      test_runner_.CreateExecutable(std::move(module),
+                                    /*run_hlo_passes=*/true));
+
+  // Every run uses new argument and result buffers, so the graphs captured on
+  // the first run must be updated.
+  for (float i = 0; i < 3; ++i) {
+    Literal arg = LiteralUtil::CreateR1<float>({i, 2 * i, 3 * i, 4 * i});
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal result,
+        test_runner_.ExecuteWithExecutable(executable.get(), {&arg},
+                                           /*profile=*/nullptr));
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR1<float>(
+            {-(4 * i + 4), -2 * (3 * i + 3), -3 * (2 * i + 2), -4 * (i + 1)}),
+        result));
+  }
+}
+
+}  // namespace
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,208 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/compiler/xla/service/gpu/thunk_graph_cache.h"
+
+#include <utility>
+
+#include "absl/cleanup/cleanup.h"
+#include "tensorflow/compiler/xla/status_macros.h"
+#include "tensorflow/core/platform/logging.h"
+
+#if GOOGLE_CUDA
+#include "tensorflow/compiler/xla/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/compiler/xla/stream_executor/gpu/gpu_executor.h"
+#include "tensorflow/compiler/xla/stream_executor/gpu/gpu_stream.h"
+#endif  // GOOGLE_CUDA
+
+namespace xla {
+namespace gpu {
+namespace {
+
+// Launching a graph of a single thunk saves no launch overhead.
+constexpr int kMinThunksPerGraph = 2;
+
+// Returns whether `thunk` only enqueues device work onto the stream, which can
+// be captured into a graph and replayed.
+bool IsCapturable(const Thunk& thunk) {
+  switch (thunk.kind()) {
+    case Thunk::kKernel:
+    case Thunk::kMemset32BitValue:
+    case Thunk::kMemzero:
+    // Only device-to-device copies have kind kCopy.
+    case Thunk::kCopy:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+#if GOOGLE_CUDA && CUDA_VERSION >= 10020
+
+struct ThunkGraphCache::Graph {
+  explicit Graph(se::gpu::GpuContext* context) : context(context) {}
+  ~Graph() {
+    if (exec != nullptr) {
+      se::gpu::GpuDriver::DestroyGraphExec(context, exec);
+    }
+  }
+
+  se::gpu::GpuContext* const context;
+
+  absl::Mutex mu;
+  se::gpu::GpuGraphExecHandle exec ABSL_GUARDED_BY(mu) = nullptr;
+  // The buffer addresses `exec` was captured or updated with.
+  std::vector<void*> buffer_addresses ABSL_GUARDED_BY(mu);
+  bool capture_failed ABSL_GUARDED_BY(mu) = false;
+};
+
+StatusOr<bool> ThunkGraphCache::ExecuteGraph(
+    int segment_index, se::Stream* stream,
+    const std::vector<void*>& buffer_addresses,
+    const ExecuteThunkFn& execute_thunk) {
+  using se::gpu::GpuDriver;
+
+  se::StreamExecutor* executor = stream->parent();
+  Graph* graph;
+  {
+    absl::MutexLock lock(&mu_);
+    std::unique_ptr<Graph>& entry = graphs_[{executor, segment_index}];
+    if (entry == nullptr) {
+      entry = std::make_unique<Graph>(
+          se::gpu::ExtractGpuExecutor(executor)->gpu_context());
+    }
+    graph = entry.get();
+  }
+
+  absl::MutexLock lock(&graph->mu);
+  if (graph->capture_failed) {
+    return false;
+  }
+  se::gpu::GpuStreamHandle gpu_stream = se::gpu::AsGpuStreamValue(stream);
+
+  if (graph->exec == nullptr || graph->buffer_addresses != buffer_addresses) {
+    const Segment& segment = segments_[segment_index];
+    // Errors while capturing are not fatal: the segment is executed directly
+    // instead, which reports the errors that are not caused by capturing.
+    Status status = GpuDriver::StreamBeginCapture(graph->context, gpu_stream);
+    if (status.ok()) {
+      for (size_t i = segment.begin; i < segment.end && status.ok(); ++i) {
+        status = execute_thunk(*thunks_[i]);
+      }
+      StatusOr<se::gpu::GpuGraphHandle> captured =
+          GpuDriver::StreamEndCapture(graph->context, gpu_stream);
+      if (captured.ok()) {
+        auto destroy_captured = absl::MakeCleanup([&] {
+          GpuDriver::DestroyGraph(graph->context, captured.ValueOrDie());
+        });
+        if (status.ok() && graph->exec != nullptr) {
+          StatusOr<bool> updated = GpuDriver::GraphExecUpdate(
+              graph->context, graph->exec, captured.ValueOrDie());
+          status = updated.status();
+          if (updated.ok() && !updated.ValueOrDie()) {
+            GpuDriver::DestroyGraphExec(graph->context, graph->exec);
+            graph->exec = nullptr;
+          }
+        }
+        if (status.ok() && graph->exec == nullptr) {
+          StatusOr<se::gpu::GpuGraphExecHandle> exec =
+              GpuDriver::GraphInstantiate(graph->context,
+                                          captured.ValueOrDie());
+          status = exec.status();
+          if (exec.ok()) {
+            graph->exec = exec.ValueOrDie();
+          }
+        }
+      } else if (status.ok()) {
+        status = captured.status();
+      }
+    }
+    if (!status.ok()) {
+      VLOG(1) << "Executing thunks [" << segment.begin << ", " << segment.end
+              << ") directly, as they failed to be captured into a CUDA "
+                 "graph: "
+              << status;
+      if (graph->exec != nullptr) {
+        GpuDriver::DestroyGraphExec(graph->context, graph->exec);
+        graph->exec = nullptr;
+      }
+      graph->capture_failed = true;
+      return false;
+    }
+    graph->buffer_addresses = buffer_addresses;
+  }
+
+  TF_RETURN_IF_ERROR(
+      GpuDriver::GraphLaunch(graph->context, graph->exec, gpu_stream));
+  return true;
+}
+
+#else  // GOOGLE_CUDA && CUDA_VERSION >= 10020
+
+struct ThunkGraphCache::Graph {};
+
+StatusOr<bool> ThunkGraphCache::ExecuteGraph(
+    int segment_index, se::Stream* stream,
+    const std::vector<void*>& buffer_addresses,
+    const ExecuteThunkFn& execute_thunk) {
+  return false;
+}
+
+#endif  // GOOGLE_CUDA && CUDA_VERSION >= 10020
+
+ThunkGraphCache::ThunkGraphCache(const ThunkSequence& thunks)
+    : thunks_(thunks) {
+  for (size_t i = 0; i < thunks_.size();) {
+    size_t end = i + 1;
+    bool capturable = IsCapturable(*thunks_[i]);
+    while (end < thunks_.size() && IsCapturable(*thunks_[end]) == capturable) {
+      ++end;
+    }
+    segments_.push_back(
+        {i, end, capturable && end - i >= kMinThunksPerGraph});
+    i = end;
+  }
+}
+
+ThunkGraphCache::~ThunkGraphCache() = default;
+
+Status ThunkGraphCache::Execute(se::Stream* stream,
+                                const BufferAllocations& buffer_allocations,
+                                const ExecuteThunkFn& execute_thunk) {
+  std::vector<void*> buffer_addresses(buffer_allocations.size());
+  for (int i = 0; i < buffer_allocations.size(); ++i) {
+    buffer_addresses[i] = buffer_allocations.GetDeviceAddress(i).opaque();
+  }
+
+  for (int i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    if (segment.capturable) {
+      TF_ASSIGN_OR_RETURN(
+          bool launched,
+          ExecuteGraph(i, stream, buffer_addresses, execute_thunk));
+      if (launched) {
+        continue;
+      }
+    }
+    for (size_t j = segment.begin; j < segment.end; ++j) {
+      TF_RETURN_IF_ERROR(execute_thunk(*thunks_[j]));
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace gpu
+}  // namespace xla
@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/compiler/xla/service/gpu/buffer_allocations.h"
+#include "tensorflow/compiler/xla/service/gpu/thunk.h"
+#include "tensorflow/compiler/xla/status.h"
+#include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
+
+namespace xla {
+namespace gpu {
+
+// Executes a thunk sequence by replaying CUDA graphs captured from it.
+//
+// The sequence is split into segments of consecutive thunks that only enqueue
+// device work onto the stream: kernel launches, memsets and device-to-device
+// copies. The first time a segment runs on a device, the work it enqueues is
+// captured into a graph, which is instantiated and launched. Later runs with
+// the same buffer addresses only launch the instantiated graph. Runs with
+// different buffer addresses capture the segment again and update the kernel
+// arguments of the instantiated graph in place, which is much cheaper than
+// instantiating a new graph.
+//
+// The other thunks, and the segments that fail to be captured, are executed
+// directly on the stream. Without CUDA graph support, all the thunks are
+// executed directly.
+class ThunkGraphCache {
+ public:
+  // Executes `thunk` on the stream passed to `Execute`, or enqueues its work
+  // onto that stream while it is being captured.
+  using ExecuteThunkFn = std::function<Status(Thunk& thunk)>;
+
+  // `thunks` must outlive the cache.
+  explicit ThunkGraphCache(const ThunkSequence& thunks);
+  ~ThunkGraphCache();
+
+  ThunkGraphCache(const ThunkGraphCache&) = delete;
+  ThunkGraphCache& operator=(const ThunkGraphCache&) = delete;
+
+  // Executes all the thunks of the sequence in order on `stream`, with the
+  // buffers in `buffer_allocations`.
+  Status Execute(se::Stream* stream,
+                 const BufferAllocations& buffer_allocations,
+                 const ExecuteThunkFn& execute_thunk);
+
+ private:
+  // The thunks [begin, end) of the sequence.
+  struct Segment {
+    size_t begin;
+    size_t end;
+    bool capturable;
+  };
+
+  // An instantiated graph of a segment on a device.
+  struct Graph;
+
+  // Executes the segment at `segment_index` as a graph. Returns false if the
+  // segment can't be captured on this device, in which case it must be
+  // executed directly.
+  StatusOr<bool> ExecuteGraph(int segment_index, se::Stream* stream,
+                              const std::vector<void*>& buffer_addresses,
+                              const ExecuteThunkFn& execute_thunk);
+
+  const ThunkSequence& thunks_;
+  std::vector<Segment> segments_;
+
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::pair<se::StreamExecutor*, int>,
+                      std::unique_ptr<Graph>>
+      graphs_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace gpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_GPU_THUNK_GRAPH_CACHE_H_
@@ -612,12 +612,68 @@ void GlobalDecreasingSizeBestFitHeap<BufferType>::Free(const BufferType* buffer,
 
 using Chunk = HeapSimulator::Chunk;
 
+namespace {
+
+// Returns a pseudo-random priority for the `index`-th node of a treap. This
+// is the SplitMix64 finalizer, which makes the tree shape deterministic.
+uint64_t TreapPriority(uint64_t index) {
+  uint64_t z = index + 0x9e3779b97f4a7c15;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+void UpdateSubtreeEnd(BufferIntervalTreeNode* node) {
+  node->subtree_end = node->end;
+  if (node->left != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->left->subtree_end);
+  }
+  if (node->right != nullptr) {
+    node->subtree_end = std::max(node->subtree_end, node->right->subtree_end);
+  }
+}
+
+}  // namespace
+
+void BufferIntervalTree::RotateUp(BufferIntervalTreeNode* node) {
+  // Moves `node` one level up, in place of its parent, preserving both the
+  // order of the keys and the `subtree_end` invariant.
+  BufferIntervalTreeNode* parent = node->parent;
+  BufferIntervalTreeNode* grandparent = parent->parent;
+  if (parent->left == node) {
+    parent->left = node->right;
+    if (node->right != nullptr) {
+      node->right->parent = parent;
+    }
+    node->right = parent;
+  } else {
+    parent->right = node->left;
+    if (node->left != nullptr) {
+      node->left->parent = parent;
+    }
+    node->left = parent;
+  }
+  parent->parent = node;
+  node->parent = grandparent;
+  if (grandparent == nullptr) {
+    root_ = node;
+  } else if (grandparent->left == parent) {
+    grandparent->left = node;
+  } else {
+    grandparent->right = node;
+  }
+  UpdateSubtreeEnd(parent);
+  UpdateSubtreeEnd(node);
+}
+
 void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
   node_storage_.emplace_back(BufferIntervalTreeNode{
       start, end, end, chunk,
-      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr});
+      /*left=*/nullptr, /*right=*/nullptr, /*parent=*/nullptr,
+      /*priority=*/TreapPriority(node_storage_.size())});
+  BufferIntervalTreeNode* node = &node_storage_.back();
   if (root_ == nullptr) {
-    root_ = &node_storage_.back();
+    root_ = node;
     // This is root.
     return;
   }
@@ -627,145 +683,79 @@ void BufferIntervalTree::Add(int64_t start, int64_t end, const Chunk& chunk) {
     parent->subtree_end = std::max(parent->subtree_end, end);
     if (parent->start > start) {
       if (parent->left == nullptr) {
-        parent->left = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->left = node;
+        break;
       }
       parent = parent->left;
     } else {
       if (parent->right == nullptr) {
-        parent->right = &node_storage_.back();
-        node_storage_.back().parent = parent;
-        return;
+        parent->right = node;
+        break;
       }
       parent = parent->right;
     }
   }
+  node->parent = parent;
+
+  // Restore the heap order of the priorities.
+  while (node->parent != nullptr && node->priority > node->parent->priority) {
+    RotateUp(node);
+  }
 }
 
 bool BufferIntervalTree::Remove(int64_t start, int64_t end,
                                 const Chunk& chunk) {
-  BufferIntervalTreeNode* to_delete = root_;
-  while (to_delete != nullptr) {
-    if (to_delete->start == start && to_delete->end == end &&
-        to_delete->chunk.offset == chunk.offset) {
+  // Rotations may move nodes with the same start time as a node to either of
+  // its subtrees, so look for the node in both of them in that case.
+  BufferIntervalTreeNode* to_delete = nullptr;
+  std::vector<BufferIntervalTreeNode*> visiting_stack;
+  if (root_ != nullptr) {
+    visiting_stack.push_back(root_);
+  }
+  while (!visiting_stack.empty()) {
+    BufferIntervalTreeNode* top = visiting_stack.back();
+    visiting_stack.pop_back();
+    if (top->start == start && top->end == end &&
+        top->chunk.offset == chunk.offset) {
+      to_delete = top;
       break;
     }
-    if (start < to_delete->start) {
-      to_delete = to_delete->left;
-    } else {
-      to_delete = to_delete->right;
+    if (start <= top->start && top->left != nullptr) {
+      visiting_stack.push_back(top->left);
+    }
+    if (start >= top->start && top->right != nullptr) {
+      visiting_stack.push_back(top->right);
     }
   }
   if (to_delete == nullptr) {
     // Nothing to delete.
     return false;
   }
-  // Found the node to be deleted, enter deletion sequence.
-
-  // Recursively traverse the parents of node and fix up the `subtree_end`
-  // invariant of a node. Recursive lambda need an explicit
-  // std::function declaration.
-  std::function<void(BufferIntervalTreeNode*)> fix_up =
-      [&](BufferIntervalTreeNode* node) {
-        if (node == nullptr) {
-          return;
-        }
-        node->subtree_end = node->end;
-        if (node->left) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->left->subtree_end);
-        }
-        if (node->right) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->right->subtree_end);
-        }
-        // Recursively go up.
-        fix_up(node->parent);
-      };
-
-  if (to_delete->right == nullptr) {
-    // to_delete has no right child, simply move up left child of to_delete if
-    // any.
-    //
-    // Turn:
-    //      parent
-    //       /
-    // to_delete
-    //  /      \
-    // left    nullptr
-    //
-    // Into:
-    //      parent
-    //      /
-    //    left
-    if (root_ == to_delete) {
-      // Deleting root is simply reseting root;
-      root_ = to_delete->left;
-      return true;
-    }
 
-    if (to_delete == to_delete->parent->left) {
-      // to_delete is left child of parent.
-      to_delete->parent->left = to_delete->left;
-    }
-    if (to_delete == to_delete->parent->right) {
-      // to_delete is right child of parent.
-      to_delete->parent->right = to_delete->left;
-    }
-    // Rewire parent to the node being moved up.
-    if (to_delete->left) {
-      to_delete->left->parent = to_delete->parent;
-    }
-    // Fix up starting from subroot.
-    fix_up(to_delete);
+  // Rotate the node down until it has at most one child, then replace it
+  // with that child.
+  while (to_delete->left != nullptr && to_delete->right != nullptr) {
+    RotateUp(to_delete->left->priority > to_delete->right->priority
+                 ? to_delete->left
+                 : to_delete->right);
+  }
+  BufferIntervalTreeNode* child =
+      to_delete->left != nullptr ? to_delete->left : to_delete->right;
+  BufferIntervalTreeNode* parent = to_delete->parent;
+  if (child != nullptr) {
+    child->parent = parent;
+  }
+  if (parent == nullptr) {
+    root_ = child;
+  } else if (parent->left == to_delete) {
+    parent->left = child;
   } else {
-    // 1. Find left-most node of the right subtree, promote it to the position
-    // of to_delete.
-    BufferIntervalTreeNode* to_promote = to_delete->right;
-    while (to_promote->left != nullptr) {
-      // Go to left-most subtree.
-      to_promote = to_promote->left;
-    }
+    parent->right = child;
+  }
 
-    // 2. Copy the content of `to_promote` to `to_delete`.
-    to_delete->start = to_promote->start;
-    to_delete->end = to_promote->end;
-    // This is incorrect but we will fix this up later in the `fix_up`
-    // procedure.
-    to_delete->subtree_end = to_promote->subtree_end;
-    to_delete->chunk = to_promote->chunk;
-    auto to_promote_parent = to_promote->parent;
-    // 3. Move the right child of `to_promote` up if there is any.
-    //
-    // Turn
-    //
-    // to_delete
-    //         \
-    //        to_promote_parent
-    //         /
-    //    to_promote
-    //          \
-    //          right
-    // into
-    //
-    // to_promote
-    //         \
-    //         to_promote_parent
-    //         /
-    //      right
-    if (to_promote_parent->left == to_promote) {
-      to_promote_parent->left = to_promote->right;
-    } else {
-      to_promote_parent->right = to_promote->right;
-    }
-    if (to_promote->right) {
-      // Set correct parent.
-      to_promote->right->parent = to_promote_parent;
-    }
-    // 4. Recursive fix up the `subtree_end` starting from
-    // `to_promote_parent`.
-    fix_up(to_promote_parent);
+  // Fix up the `subtree_end` invariant of the ancestors.
+  for (; parent != nullptr; parent = parent->parent) {
+    UpdateSubtreeEnd(parent);
   }
   // Don't free the entry in node_storage_ until we free the entire tree.
   return true;
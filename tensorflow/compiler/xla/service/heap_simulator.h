@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_HEAP_SIMULATOR_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <utility>
@@ -331,9 +332,18 @@ struct BufferIntervalTreeNode {
   BufferIntervalTreeNode* right;
   // parent
   BufferIntervalTreeNode* parent;
+  // Heap priority of the node in the treap: every node has a higher priority
+  // than its children.
+  uint64_t priority;
 };
 
 // An interval tree that can query buffers overlapping in time.
+//
+// The tree is a treap ordered by start time, whose priorities are a hash of
+// the insertion order. It stays balanced in expectation even when buffers
+// are added in order of time, as is the case for large modules with many
+// buffers of the same size, so that Add, Remove and ChunksOverlappingInTime
+// take O(log n) time in addition to the number of chunks returned.
 class BufferIntervalTree {
  public:
   using Chunk = HeapSimulator::Chunk;
@@ -351,6 +361,9 @@ class BufferIntervalTree {
   BufferIntervalTreeNode* GetRoot() { return root_; }
 
  private:
+  // Rotates `node` above its parent.
+  void RotateUp(BufferIntervalTreeNode* node);
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
 };
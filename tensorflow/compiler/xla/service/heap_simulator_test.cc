@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/heap_simulator.h"
 
+#include <algorithm>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -32,6 +34,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/tests/hlo_test_base.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -1697,5 +1700,100 @@ TEST_F(IntervalTreeTest, ThreeLevelsRightLeftChunkDifferent) {
   ASSERT_EQ(tree.GetRoot(), nullptr);
 }
 
+int TreeDepth(const BufferIntervalTreeNode* node) {
+  if (node == nullptr) {
+    return 0;
+  }
+  return 1 + std::max(TreeDepth(node->left), TreeDepth(node->right));
+}
+
+TEST_F(IntervalTreeTest, StaysBalancedWhenAddedInOrder) {
+  // The heap simulator adds buffers of the same size in order of time. An
+  // unbalanced tree would degenerate into a list of 10000 nodes.
+  constexpr int kNumNodes = 10000;
+  BufferIntervalTree tree;
+  for (int i = 0; i < kNumNodes; ++i) {
+    tree.Add(i, i + 10, HeapSimulator::Chunk({i, 1}));
+  }
+  EXPECT_LT(TreeDepth(tree.GetRoot()), 64);
+  for (int i = 0; i < kNumNodes; i += 2) {
+    EXPECT_TRUE(tree.Remove(i, i + 10, HeapSimulator::Chunk({i, 1})));
+  }
+  EXPECT_LT(TreeDepth(tree.GetRoot()), 64);
+  EXPECT_EQ(tree.ChunksOverlappingInTime(kNumNodes / 2, kNumNodes / 2).size(),
+            5);
+}
+
+TEST_F(IntervalTreeTest, MatchesBruteForce) {
+  struct Interval {
+    int64_t start;
+    int64_t end;
+    HeapSimulator::Chunk chunk;
+  };
+  std::vector<Interval> intervals;
+  BufferIntervalTree tree;
+  std::minstd_rand0 rng(42);
+  for (int i = 0; i < 2000; ++i) {
+    if (intervals.empty() || rng() % 3 != 0) {
+      // Use few distinct start times to exercise ties.
+      const int64_t start = rng() % 50;
+      Interval interval{start, start + static_cast<int64_t>(rng() % 20),
+                        HeapSimulator::Chunk({static_cast<int64_t>(i), 1})};
+      tree.Add(interval.start, interval.end, interval.chunk);
+      intervals.push_back(interval);
+    } else {
+      const int index = rng() % intervals.size();
+      const Interval& interval = intervals[index];
+      ASSERT_TRUE(tree.Remove(interval.start, interval.end, interval.chunk));
+      intervals.erase(intervals.begin() + index);
+    }
+
+    const int64_t start = rng() % 60;
+    const int64_t end = start + rng() % 10;
+    std::vector<int64_t> expected;
+    for (const Interval& interval : intervals) {
+      if (interval.start <= end && interval.end >= start) {
+        expected.push_back(interval.chunk.offset);
+      }
+    }
+    std::vector<int64_t> actual;
+    for (const HeapSimulator::Chunk& chunk :
+         tree.ChunksOverlappingInTime(start, end)) {
+      actual.push_back(chunk.offset);
+    }
+    EXPECT_THAT(actual, ::testing::UnorderedElementsAreArray(expected));
+  }
+}
+
+// Simulates a long sequence of buffers of the same size with short, staggered
+// lifetimes, as in large unrolled models.
+void BM_GlobalDecreasingSizeBestFitHeap(::testing::benchmark::State& state) {
+  const int num_buffers = state.range(0);
+  constexpr int kNumLiveBuffers = 16;
+  HloComputation::Builder builder("BM_GlobalDecreasingSizeBestFitHeap");
+  std::vector<std::unique_ptr<HloValue>> values;
+  for (int i = 0; i < num_buffers; ++i) {
+    auto constant = builder.AddInstruction(
+        HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+    values.push_back(std::make_unique<HloValue>(i, constant, ShapeIndex{}));
+  }
+  for (auto s : state) {
+    GlobalDecreasingSizeBestFitHeap<HloValue> heap(/*alignment=*/1);
+    for (int i = 0; i < num_buffers; ++i) {
+      heap.Alloc(values[i].get(), 1024);
+      if (i >= kNumLiveBuffers) {
+        heap.Free(values[i - kNumLiveBuffers].get(), 1024);
+      }
+    }
+    for (int i = std::max(0, num_buffers - kNumLiveBuffers); i < num_buffers;
+         ++i) {
+      heap.Free(values[i].get(), 1024);
+    }
+    auto result = heap.Finish();
+    tensorflow::testing::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_GlobalDecreasingSizeBestFitHeap)->Range(1 << 10, 1 << 16);
+
 }  // namespace
 }  // namespace xla
@@ -98,6 +98,24 @@ class HloModuleMetadata {
           pass_metadata->set_module_id(module_id);
         });
   }
+  Status set_current_pass_instruction_count_before(int64_t count) {
+    return MutateCurrentHloPassMetadata(
+        [&count](HloPassMetadata* pass_metadata) {
+          pass_metadata->set_instruction_count_before(count);
+        });
+  }
+  Status set_current_pass_instruction_count_after(int64_t count) {
+    return MutateCurrentHloPassMetadata(
+        [&count](HloPassMetadata* pass_metadata) {
+          pass_metadata->set_instruction_count_after(count);
+        });
+  }
+  Status set_current_pass_peak_host_memory_bytes(int64_t bytes) {
+    return MutateCurrentHloPassMetadata(
+        [&bytes](HloPassMetadata* pass_metadata) {
+          pass_metadata->set_peak_host_memory_bytes(bytes);
+        });
+  }
   Status add_current_pass_module_group_module_id(int64_t module_id) {
     return MutateCurrentHloPassMetadata(
         [&module_id](HloPassMetadata* pass_metadata) {
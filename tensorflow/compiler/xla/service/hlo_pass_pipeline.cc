@@ -15,6 +15,10 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
 #include <functional>
 #include <string>
 
@@ -30,17 +34,46 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 
 namespace xla {
 
 namespace {
 
+// Returns the peak resident memory of the process in bytes, or 0 if it is not
+// known on this platform.
+int64_t PeakHostMemoryBytes() {
+#if defined(__linux__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    // ru_maxrss is in kilobytes on Linux.
+    return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+  }
+#endif
+  return 0;
+}
+
+int64_t InstructionCount(const HloModule& module) {
+  return module.instruction_count();
+}
+
+int64_t InstructionCount(HloModuleGroup& module_group) {
+  int64_t count = 0;
+  for (const HloModule* module : module_group.modules()) {
+    count += module->instruction_count();
+  }
+  return count;
+}
+
 void RecordPassStartMetadata(HloModule& module, const std::string& pass_name,
                              const std::string& pipeline_name) {
   module.metadata()->RecordPassStart();
   // An HloPassMetadata was just created so Status should always be OK.
   TF_CHECK_OK(module.metadata()->set_current_pass_name(pass_name));
   TF_CHECK_OK(module.metadata()->set_current_pass_pipeline_name(pipeline_name));
+  TF_CHECK_OK(module.metadata()->set_current_pass_instruction_count_before(
+      module.instruction_count()));
 }
 
 void RecordPassStartMetadata(HloModuleGroup& module_group,
@@ -60,6 +93,11 @@ Status AttemptRecordPassEndMetadata(HloModule& module,
       module.metadata()->set_current_pass_module_id(module.unique_id()));
   TF_RETURN_IF_ERROR(
       module.metadata()->set_current_pass_module_changed(module_changed));
+  TF_RETURN_IF_ERROR(
+      module.metadata()->set_current_pass_instruction_count_after(
+          module.instruction_count()));
+  TF_RETURN_IF_ERROR(module.metadata()->set_current_pass_peak_host_memory_bytes(
+      PeakHostMemoryBytes()));
   TF_RETURN_IF_ERROR(module.metadata()->RecordPassEnd());
   return OkStatus();
 }
@@ -174,6 +212,12 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
     HloPassInterface* pass = passes[i];
     XLA_SCOPED_LOGGING_TIMER(absl::StrCat("HLO pass: ", pass->name()));
     std::string pass_name = std::string(pass->name());
+    tensorflow::profiler::TraceMe traceme([&] {
+      return tensorflow::profiler::TraceMeEncode(
+          "HloPass", {{"name", pass_name},
+                      {"pipeline", pipeline_name},
+                      {"instructions_before", InstructionCount(*hlo)}});
+    });
     VLOG(1) << "  HLO pass " << pass_name;
     VLOG(2) << "  Module hash " << absl::HashOf(*hlo);
     if (!pass->IsPassPipeline()) {
@@ -191,6 +235,11 @@ StatusOr<bool> HloPassPipeline::RunPassesInternal(
                                        : passes[i + 1]->name());
     }
     RecordPassEndMetadata(*hlo, pass_name, pass_changed);
+    traceme.AppendMetadata([&] {
+      return tensorflow::profiler::TraceMeEncode(
+          {{"instructions_after", InstructionCount(*hlo)},
+           {"changed", pass_changed}});
+    });
     changed |= pass_changed;
     if (pass_changed) {
       VLOG(3) << "  Pass caused changes " << pass->name();
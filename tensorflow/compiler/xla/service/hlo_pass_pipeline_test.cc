@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/hlo_pass_pipeline.h"
 
+#include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
@@ -88,6 +89,20 @@ class ReverseStringModulePass : public HloModulePass {
   }
 };
 
+// A module pass which adds an unused constant to the entry computation.
+class AddConstantModulePass : public HloModulePass {
+  absl::string_view name() const override { return "add-constant"; }
+
+  using HloPassInterface::Run;
+  StatusOr<bool> Run(HloModule* module,
+                     const absl::flat_hash_set<absl::string_view>&
+                         execution_threads) override {
+    module->entry_computation()->AddInstruction(
+        HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0f)));
+    return true;
+  }
+};
+
 // A module group pass which renames instructions named 'baz' to 'qux'.
 class BazToQuxModuleGroupPass : public HloModuleGroupPass {
   absl::string_view name() const override { return "baz2qux"; }
@@ -401,5 +416,37 @@ TEST_F(HloPassPipelineTest, SetHloModuleMetadata) {
   }
 }
 
+TEST_F(HloPassPipelineTest, SetInstructionCountAndMemoryMetadata) {
+  const std::string module_str = R"(
+HloModule SetInstructionCountAndMemoryMetadata
+
+ENTRY main {
+  a = f32[] parameter(0)
+  b = f32[] parameter(1)
+  ROOT foo = f32[] multiply(a, b)
+}
+)";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<VerifiedHloModule> module,
+                          ParseAndReturnVerifiedModule(module_str));
+  HloPassPipeline pipeline(TestName());
+  pipeline.AddPass<AddConstantModulePass>();
+  pipeline.AddPass<FooToBarModulePass>();
+  TF_ASSERT_OK(pipeline.Run(module.get()).status());
+
+  const HloModuleMetadataProto& metadata = module->metadata().proto();
+  ASSERT_THAT(metadata.pass_metadata(), SizeIs(3));
+  const HloPassMetadata& add_constant = metadata.pass_metadata(1);
+  EXPECT_THAT(add_constant.pass_name(), StrEq("add-constant"));
+  EXPECT_EQ(add_constant.instruction_count_before(), 3);
+  EXPECT_EQ(add_constant.instruction_count_after(), 4);
+  const HloPassMetadata& foo2bar = metadata.pass_metadata(2);
+  EXPECT_THAT(foo2bar.pass_name(), StrEq("foo2bar"));
+  EXPECT_EQ(foo2bar.instruction_count_before(), 4);
+  EXPECT_EQ(foo2bar.instruction_count_after(), 4);
+  for (const HloPassMetadata& pass_metadata : metadata.pass_metadata()) {
+    EXPECT_GE(pass_metadata.peak_host_memory_bytes(), 0);
+  }
+}
+
 }  // namespace
 }  // namespace xla
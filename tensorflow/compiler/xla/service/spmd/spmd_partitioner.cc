@@ -240,6 +240,38 @@ HloSharding GetShardingReplicatedOnWindowedDimension(
 
 }  // namespace
 
+HloInstruction* SpmdBuilder::LookupConstantTable(
+    absl::Span<const int64_t> table, PrimitiveType type,
+    HloInstruction* index) {
+  auto key = std::make_tuple(index, type,
+                             std::vector<int64_t>(table.begin(), table.end()));
+  auto it = table_lookups_.find(key);
+  if (it != table_lookups_.end()) {
+    return it->second;
+  }
+  Literal literal;
+  switch (type) {
+    case S32:
+      literal = LiteralUtil::CreateR1<int32_t>(
+          std::vector<int32_t>(table.begin(), table.end()));
+      break;
+    case U32:
+      literal = LiteralUtil::CreateR1<uint32_t>(
+          std::vector<uint32_t>(table.begin(), table.end()));
+      break;
+    default:
+      LOG(FATAL) << "Unsupported table type " << PrimitiveType_Name(type);
+  }
+  HloInstruction* constant =
+      AddInstruction(HloInstruction::CreateConstant(std::move(literal)));
+  HloInstruction* element = AddInstruction(HloInstruction::CreateDynamicSlice(
+      ShapeUtil::MakeShape(type, {1}), constant, {index}, {1}));
+  HloInstruction* result = AddInstruction(HloInstruction::CreateReshape(
+      ShapeUtil::MakeScalarShape(type), element));
+  table_lookups_.emplace(std::move(key), result);
+  return result;
+}
+
 HloInstruction* SpmdBuilder::AddInstruction(
     std::unique_ptr<HloInstruction> instruction) {
   HloInstruction* hlo =
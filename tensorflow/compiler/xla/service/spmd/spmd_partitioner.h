@@ -19,10 +19,13 @@ limitations under the License.
 #include <memory>
 #include <optional>
 #include <string>
+#include <tuple>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
@@ -106,6 +109,15 @@ class SpmdBuilder : public HloComputation::Builder {
     return &it->second;
   }
 
+  // Returns the element of the constant R1 `table` at the scalar `index`, with
+  // element type `type` (S32 or U32). Tables of partition offsets or IDs are
+  // looked up with the same partition ID many times in a computation, and
+  // their size is linear in the number of partitions, so an identical lookup
+  // reuses the instructions created by the first one.
+  HloInstruction* LookupConstantTable(absl::Span<const int64_t> table,
+                                      PrimitiveType type,
+                                      HloInstruction* index);
+
  private:
   // Currently visiting instruction.
   HloInstruction* visiting_hlo_;
@@ -119,6 +131,12 @@ class SpmdBuilder : public HloComputation::Builder {
   // these dimensions have the same value.
   absl::flat_hash_map<const HloInstruction*, absl::flat_hash_set<int64_t>>
       broadcast_dims_;
+
+  // Results of LookupConstantTable(), keyed by index, type and table.
+  absl::flat_hash_map<
+      std::tuple<const HloInstruction*, PrimitiveType, std::vector<int64_t>>,
+      HloInstruction*>
+      table_lookups_;
 };
 
 // A set of functions that create the cross-partition collective ops.
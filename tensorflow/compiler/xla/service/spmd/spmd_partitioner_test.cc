@@ -15,6 +15,12 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/spmd/spmd_partitioner.h"
 
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/xla/service/hlo_casting_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_instructions.h"
 #include "tensorflow/compiler/xla/service/hlo_matchers.h"
@@ -26,6 +32,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace xla {
 namespace spmd {
@@ -11050,6 +11057,74 @@ ENTRY %main.21 (Arg_0.1: f32[4,4,8], Arg_1.2: f32[4,8]) -> (f32[4,4,8], f32[4])
                             _, op::Shape("f32[1]"), _))));
 }
 
+TEST_F(SpmdPartitioningTest, ReusesPartitionOffsetTables) {
+  absl::string_view hlo_string = R"(
+HloModule module
+
+ENTRY entry {
+  %p0 = f32[8,8] parameter(0), sharding={replicated}
+  %p1 = f32[8,8] parameter(1), sharding={replicated}
+  %p2 = f32[8,8] parameter(2), sharding={replicated}
+  %add0 = f32[8,8] add(%p0, %p1), sharding={devices=[4,1]0,1,2,3}
+  ROOT %add1 = f32[8,8] add(%add0, %p2), sharding={devices=[4,1]0,1,2,3}
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          PartitionComputation(hlo_string, /*num_devices=*/4));
+  VLOG(1) << module->ToString();
+  // All three parameters are sliced with the offset table of the same
+  // sharding, which is only created once.
+  int64_t num_offset_tables = 0;
+  for (const HloInstruction* hlo :
+       module->entry_computation()->instructions()) {
+    if (hlo->opcode() == HloOpcode::kConstant &&
+        ShapeUtil::Equal(hlo->shape(), ShapeUtil::MakeShape(S32, {4}))) {
+      ++num_offset_tables;
+    }
+  }
+  EXPECT_EQ(num_offset_tables, 1);
+  const auto param0 = AllOf(
+      op::DynamicSlice(op::Parameter(0), op::Reshape(), op::Constant()),
+      op::Shape("f32[2,8]"));
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              AllOf(op::Add(op::Add(param0, _), _), op::Shape("f32[2,8]")));
+}
+
+// Measures the compile time of partitioning a chain of reshards between
+// shardings along different dimensions with `state.range(0)` partitions.
+void BM_PartitionReshardChain(::testing::benchmark::State& state) {
+  const int64_t num_partitions = state.range(0);
+  constexpr int kNumReshards = 16;
+  std::vector<int64_t> devices(num_partitions);
+  std::iota(devices.begin(), devices.end(), 0);
+  const std::string device_list = absl::StrJoin(devices, ",");
+  const std::string row_sharding =
+      absl::StrCat("{devices=[", num_partitions, ",1]", device_list, "}");
+  const std::string column_sharding =
+      absl::StrCat("{devices=[1,", num_partitions, "]", device_list, "}");
+  std::string hlo_string = absl::StrCat(
+      "HloModule module\n\nENTRY entry {\n"
+      "  %p0 = f32[2048,2048] parameter(0), sharding={replicated}\n"
+      "  %x0 = f32[2048,2048] copy(%p0), sharding=",
+      row_sharding, "\n");
+  for (int i = 1; i <= kNumReshards; ++i) {
+    absl::StrAppend(&hlo_string, "  %x", i, " = f32[2048,2048] negate(%x",
+                    i - 1, "), sharding=",
+                    i % 2 == 0 ? row_sharding : column_sharding, "\n");
+  }
+  absl::StrAppend(&hlo_string, "  ROOT %result = f32[2048,2048] copy(%x",
+                  kNumReshards, "), sharding={replicated}\n}\n");
+
+  for (auto s : state) {
+    state.PauseTiming();
+    auto module = ParseAndReturnUnverifiedModule(hlo_string).ValueOrDie();
+    SpmdPartitionerOptions options;
+    SpmdPartitioner partitioner(num_partitions, /*num_replicas=*/1, options);
+    state.ResumeTiming();
+    TF_CHECK_OK(partitioner.Run(module.get()).status());
+  }
+}
+BENCHMARK(BM_PartitionReshardChain)->RangeMultiplier(4)->Range(8, 2048);
+
 }  // namespace
 }  // namespace spmd
 }  // namespace xla
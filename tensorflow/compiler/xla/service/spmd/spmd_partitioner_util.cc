@@ -158,7 +158,7 @@ std::vector<HloInstruction*> MakePartitionOffsets(
     absl::Span<const int64_t> dims) {
   CHECK(!shape.IsTuple());
 
-  std::vector<std::vector<int32_t>> offset_arrays(shape.rank());
+  std::vector<std::vector<int64_t>> offset_arrays(shape.rank());
   for (int64_t i = 0; i < shape.rank(); ++i) {
     offset_arrays[i].resize(sharding.tile_assignment().num_elements());
   }
@@ -176,12 +176,8 @@ std::vector<HloInstruction*> MakePartitionOffsets(
       offsets.push_back(b->AddInstruction(
           HloInstruction::CreateConstant(LiteralUtil::Zero(S32))));
     } else {
-      auto offset_table = b->AddInstruction(HloInstruction::CreateConstant(
-          LiteralUtil::CreateR1<int32_t>(offset_arrays[i])));
-      auto index = b->AddInstruction(HloInstruction::CreateDynamicSlice(
-          ShapeUtil::MakeShape(S32, {1}), offset_table, {partition_id}, {1}));
-      offsets.push_back(b->AddInstruction(
-          HloInstruction::CreateReshape(ShapeUtil::MakeShape(S32, {}), index)));
+      offsets.push_back(
+          b->LookupConstantTable(offset_arrays[i], S32, partition_id));
     }
   }
   return offsets;
@@ -1459,18 +1455,13 @@ HloInstruction* GetInGroupPartitionId(
     HloInstruction* partition_id,
     const std::vector<std::vector<int64_t>>& device_groups, SpmdBuilder* b) {
   int64_t total_devices = device_groups.size() * device_groups[0].size();
-  std::vector<uint32_t> in_group_ids(total_devices);
-  for (uint32_t i = 0; i < device_groups.size(); ++i) {
-    for (uint32_t j = 0; j < device_groups[i].size(); ++j) {
+  std::vector<int64_t> in_group_ids(total_devices);
+  for (int64_t i = 0; i < device_groups.size(); ++i) {
+    for (int64_t j = 0; j < device_groups[i].size(); ++j) {
       in_group_ids[device_groups[i][j]] = j;
     }
   }
-  auto id_table = b->AddInstruction(HloInstruction::CreateConstant(
-      LiteralUtil::CreateR1<uint32_t>(in_group_ids)));
-  return b->AddInstruction(HloInstruction::CreateReshape(
-      ShapeUtil::MakeScalarShape(U32),
-      b->AddInstruction(HloInstruction::CreateDynamicSlice(
-          ShapeUtil::MakeShape(U32, {1}), id_table, {partition_id}, {1}))));
+  return b->LookupConstantTable(in_group_ids, U32, partition_id);
 }
 
 SPMDCollectiveOpsCreator GetPerGroupCollectiveOpsCreator(
@@ -1072,6 +1072,80 @@ GpuDriver::CreateMemoryHandle(GpuContext* context, uint64_t bytes) {
   return false;
 }
 
+#if CUDA_VERSION >= 10020
+/* static */ port::Status GpuDriver::StreamBeginCapture(GpuContext* context,
+                                                        CUstream stream) {
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  RETURN_IF_CUDA_RES_ERROR(
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL),
+      "Failed to begin capturing CUDA stream");
+  return ::tensorflow::OkStatus();
+}
+
+/* static */ port::StatusOr<CUgraph> GpuDriver::StreamEndCapture(
+    GpuContext* context, CUstream stream) {
+  ScopedActivateContext activated{context};
+  CHECK(stream != nullptr);
+  CUgraph graph;
+  RETURN_IF_CUDA_RES_ERROR(cuStreamEndCapture(stream, &graph),
+                           "Failed to end capturing CUDA stream");
+  return graph;
+}
+
+/* static */ port::StatusOr<CUgraphExec> GpuDriver::GraphInstantiate(
+    GpuContext* context, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUgraphExec exec;
+  RETURN_IF_CUDA_RES_ERROR(
+      cuGraphInstantiate(&exec, graph, /*phErrorNode=*/nullptr,
+                         /*logBuffer=*/nullptr, /*bufferSize=*/0),
+      "Failed to instantiate CUDA graph");
+  return exec;
+}
+
+/* static */ port::StatusOr<bool> GpuDriver::GraphExecUpdate(
+    GpuContext* context, CUgraphExec exec, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUgraphNode error_node;
+  CUgraphExecUpdateResult update_result;
+  CUresult res = cuGraphExecUpdate(exec, graph, &error_node, &update_result);
+  if (res == CUDA_ERROR_GRAPH_EXEC_UPDATE_FAILURE) {
+    VLOG(2) << "could not update CUDA graph " << exec
+            << " in place: " << update_result;
+    return false;
+  }
+  RETURN_IF_CUDA_RES_ERROR(res, "Failed to update CUDA graph");
+  return true;
+}
+
+/* static */ port::Status GpuDriver::GraphLaunch(GpuContext* context,
+                                                 CUgraphExec exec,
+                                                 CUstream stream) {
+  ScopedActivateContext activated{context};
+  RETURN_IF_CUDA_RES_ERROR(cuGraphLaunch(exec, stream),
+                           "Failed to launch CUDA graph");
+  return ::tensorflow::OkStatus();
+}
+
+/* static */ void GpuDriver::DestroyGraph(GpuContext* context, CUgraph graph) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph: " << ToString(res);
+  }
+}
+
+/* static */ void GpuDriver::DestroyGraphExec(GpuContext* context,
+                                              CUgraphExec exec) {
+  ScopedActivateContext activated{context};
+  CUresult res = cuGraphExecDestroy(exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy executable CUDA graph: " << ToString(res);
+  }
+}
+#endif  // CUDA_VERSION >= 10020
+
 /* static */ port::Status GpuDriver::SynchronousMemcpyD2H(GpuContext* context,
                                                           void* host_dst,
                                                           CUdeviceptr gpu_src,
@@ -558,6 +558,11 @@ int GpuExecutor::CompareOccupancy(int* initial_blocks,
 }
 
 DeviceMemoryBase GpuExecutor::Allocate(uint64_t size, int64_t memory_space) {
+  // Memory space 1 is pinned host memory. With unified addressing, kernels and
+  // copies on the device can use the host pointer directly.
+  if (memory_space == 1) {
+    return DeviceMemoryBase(GpuDriver::HostAllocate(context_, size), size);
+  }
   CHECK_EQ(memory_space, 0);
   return DeviceMemoryBase(GpuDriver::DeviceAllocate(context_, size), size);
 }
@@ -569,6 +574,12 @@ void* GpuExecutor::GetSubBuffer(DeviceMemoryBase* mem, uint64_t offset_bytes,
 }
 
 void GpuExecutor::Deallocate(DeviceMemoryBase* mem) {
+  port::StatusOr<MemorySpace> memory_space =
+      GpuDriver::GetPointerMemorySpace(AsCudaDevicePtr(mem));
+  if (memory_space.ok() && memory_space.ValueOrDie() == MemorySpace::kHost) {
+    GpuDriver::HostDeallocate(context_, mem->opaque());
+    return;
+  }
   GpuDriver::DeviceDeallocate(context_, mem->opaque());
 }
 
@@ -412,6 +412,51 @@ class GpuDriver {
   // the stream immediately after this returns).
   static bool IsStreamIdle(GpuContext* context, GpuStreamHandle stream);
 
+  // Graph support for updating instantiated graphs was added to CUDA in 10.2
+#if CUDA_VERSION >= 10020
+
+  // Begins capturing the work enqueued onto stream into a graph, via
+  // cuStreamBeginCapture in thread-local mode: only potentially unsafe API
+  // calls made by the calling thread invalidate the capture. Work enqueued
+  // while capturing is recorded but not executed.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status StreamBeginCapture(GpuContext* context,
+                                         GpuStreamHandle stream);
+
+  // Ends the capture started by StreamBeginCapture and returns the captured
+  // graph, via cuStreamEndCapture. The stream stops capturing even if an error
+  // is returned, e.g. because the capture was invalidated.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::StatusOr<GpuGraphHandle> StreamEndCapture(
+      GpuContext* context, GpuStreamHandle stream);
+
+  // Instantiates graph into an executable graph via cuGraphInstantiate.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::StatusOr<GpuGraphExecHandle> GraphInstantiate(
+      GpuContext* context, GpuGraphHandle graph);
+
+  // Sets the parameters of the nodes of the executable graph exec to the ones
+  // of graph via cuGraphExecUpdate. Returns false if exec can't be updated in
+  // place, e.g. because the topology of graph is different, in which case
+  // graph must be instantiated again.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::StatusOr<bool> GraphExecUpdate(GpuContext* context,
+                                              GpuGraphExecHandle exec,
+                                              GpuGraphHandle graph);
+
+  // Enqueues the executable graph exec onto stream via cuGraphLaunch.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::Status GraphLaunch(GpuContext* context, GpuGraphExecHandle exec,
+                                  GpuStreamHandle stream);
+
+  // Destroys graph via cuGraphDestroy.
+  static void DestroyGraph(GpuContext* context, GpuGraphHandle graph);
+
+  // Destroys the executable graph exec via cuGraphExecDestroy.
+  static void DestroyGraphExec(GpuContext* context, GpuGraphExecHandle exec);
+
+#endif  // CUDA_VERSION >= 10020
+
   // Returns whether code in the from context can access memory in the to
   // context via cuDeviceCanAccessPeer.
   // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__PEER__ACCESS.html#group__CUDA__PEER__ACCESS_1g496bdaae1f632ebfb695b99d2c40f19e
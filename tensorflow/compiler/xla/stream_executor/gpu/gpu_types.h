@@ -79,6 +79,8 @@ using GpuSharedMemConfig = CUsharedconfig;
 using GpuComplexType = cuComplex;
 using GpuDoubleComplexType = cuDoubleComplex;
 using GpuRngHandle = curandGenerator_t;
+using GpuGraphHandle = CUgraph;
+using GpuGraphExecHandle = CUgraphExec;
 
 #endif
 
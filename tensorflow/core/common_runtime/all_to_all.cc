@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/all_to_all.h"
 
+#include <algorithm>
 #include <utility>
 
 #include "tensorflow/core/common_runtime/collective_rma_local.h"
@@ -39,40 +40,45 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+// Chunks larger than this are split, so that a chunk can be in flight while
+// the next one is being sent. Same as the maximum chunk size of RingAlg.
+constexpr int64_t kMaxChunkSizeBytes = 4 * 1024 * 1024;
+// Maximum number of chunks that are sent to or received from a peer at once.
+constexpr int kMaxChunksInFlight = 2;
+}  // namespace
+
 AllToAll::AllToAll()
-    : col_ctx_(nullptr), col_params_(nullptr), done_(nullptr), counter_(0) {}
-
-StatusCallback AllToAll::CheckCounterAndCallDone() {
-  return [this](const Status& s) {
-    Status final_status;
-    {
-      mutex_lock l(mu_);
-      status_.Update(s);
-      ++counter_;
-      // For all devices other than itself, there's a send and a receive. We
-      // wait until all of them complete.
-      if (counter_ < 2 * col_params_->group.group_size) {
-        return;
-      }
-      CHECK_LE(counter_, 2 * col_params_->group.group_size);  // Crash ok.
-      final_status = status_;
-    }
-    if (!final_status.ok()) {
-      done_(final_status);
+    : col_ctx_(nullptr), col_params_(nullptr), done_(nullptr),
+      num_pending_(0) {}
+
+void AllToAll::OpsDone(const Status& s, int num_ops) {
+  Status final_status;
+  {
+    mutex_lock l(mu_);
+    status_.Update(s);
+    num_pending_ -= num_ops;
+    if (num_pending_ > 0) {
       return;
     }
-    if (col_ctx_->output->SharesBufferWith(output_buffer_)) {
-      done_(final_status);
-    } else {
-      // We are using a temp buffer. Copy to the output tensor.
-      CollectiveRemoteAccessLocal::MemCpyAsync(
-          col_ctx_->op_ctx->op_device_context(),
-          col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
-          col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
-          col_ctx_->op_ctx->output_alloc_attr(0), &output_buffer_,
-          col_ctx_->output, /*dev_to_dev_stream_index*/ 0, done_);
-    }
-  };
+    CHECK_EQ(num_pending_, 0);  // Crash ok.
+    final_status = status_;
+  }
+  if (!final_status.ok()) {
+    done_(final_status);
+    return;
+  }
+  if (col_ctx_->output->SharesBufferWith(output_buffer_)) {
+    done_(final_status);
+  } else {
+    // We are using a temp buffer. Copy to the output tensor.
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), &output_buffer_,
+        col_ctx_->output, /*dev_to_dev_stream_index*/ 0, done_);
+  }
 }
 
 Status AllToAll::InitializeCollectiveContext(
@@ -91,10 +97,29 @@ Status AllToAll::InitializeCollectiveContext(
       &col_ctx->device_locality);
 }
 
+std::vector<Tensor> AllToAll::SplitIntoChunks(const Tensor& tensor) {
+  const int64_t num_elements = tensor.NumElements();
+  const int64_t element_size = DataTypeSize(tensor.dtype());
+  if (element_size == 0 || num_elements * element_size <= kMaxChunkSizeBytes) {
+    return {tensor};
+  }
+  // Chunks are slices of a flat view of the tensor.
+  Tensor flat;
+  CHECK(flat.CopyFrom(tensor, TensorShape({num_elements})));  // Crash ok.
+  const int64_t chunk_elements = kMaxChunkSizeBytes / element_size;
+  std::vector<Tensor> chunks;
+  chunks.reserve((num_elements + chunk_elements - 1) / chunk_elements);
+  for (int64_t start = 0; start < num_elements; start += chunk_elements) {
+    chunks.push_back(
+        flat.Slice(start, std::min(start + chunk_elements, num_elements)));
+  }
+  return chunks;
+}
+
 void AllToAll::Run(StatusCallback done) {
   done_ = std::move(done);
-  input_chunks_.reserve(col_params_->group.group_size);
-  output_chunks_.reserve(col_params_->group.group_size);
+  const int group_size = col_params_->group.group_size;
+  const int default_rank = col_params_->default_rank;
   if (col_ctx_->input->SharesBufferWith(*col_ctx_->output)) {
     // The input is forwarded to the output, and we need to use a temp buffer.
     output_buffer_ = Tensor(
@@ -103,27 +128,95 @@ void AllToAll::Run(StatusCallback done) {
   } else {
     output_buffer_ = *col_ctx_->output;
   }
-  for (int i = 0; i < col_params_->group.group_size; ++i) {
-    input_chunks_.push_back(col_ctx_->input->SubSlice(i));
+  send_chunks_.resize(group_size);
+  recv_chunks_.resize(group_size);
+  for (int i = 0; i < group_size; ++i) {
     // Select output index based on user specified rank, if available.
     int output_index = col_params_->group.members[i].rank;
-    output_chunks_.push_back(output_buffer_.SubSlice(output_index));
+    if (i == default_rank) {
+      send_chunks_[i] = {col_ctx_->input->SubSlice(i)};
+      recv_chunks_[i] = {output_buffer_.SubSlice(output_index)};
+    } else {
+      send_chunks_[i] = SplitIntoChunks(col_ctx_->input->SubSlice(i));
+      recv_chunks_[i] = SplitIntoChunks(output_buffer_.SubSlice(output_index));
+    }
+  }
+  {
+    mutex_lock l(mu_);
+    // The slice of this device is copied at once.
+    num_pending_ = 1;
+    for (int i = 0; i < group_size; ++i) {
+      if (i == default_rank) continue;
+      num_pending_ += send_chunks_[i].size() + recv_chunks_[i].size();
+    }
   }
 
-  for (int i = 0; i < col_params_->group.group_size; ++i) {
-    auto default_rank = col_params_->default_rank;
-    // Issue send request from current device to all devices in group.
-    DispatchSend(default_rank, i, &input_chunks_[i], CheckCounterAndCallDone());
-    // Issue receive requests from all devices to current device.
-    DispatchRecv(i, default_rank, &output_chunks_[i],
-                 CheckCounterAndCallDone());
+  for (int i = 0; i < group_size; ++i) {
+    if (i == default_rank) continue;
+    const int num_send_chunks = send_chunks_[i].size();
+    const int num_recv_chunks = recv_chunks_[i].size();
+    for (int chunk_idx = 0; chunk_idx < kMaxChunksInFlight; ++chunk_idx) {
+      // Issue send requests from current device to all devices in group.
+      if (chunk_idx < num_send_chunks) SendChunk(i, chunk_idx);
+      // Issue receive requests from all devices to current device.
+      if (chunk_idx < num_recv_chunks) RecvChunk(i, chunk_idx);
+    }
   }
+  CollectiveRemoteAccessLocal::MemCpyAsync(
+      col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+      col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+      col_ctx_->op_ctx->output_alloc_attr(0), &send_chunks_[default_rank][0],
+      &recv_chunks_[default_rank][0], /*dev_to_dev_stream_index*/ 0,
+      [this](const Status& s) { OpsDone(s, 1); });
+}
+
+void AllToAll::SendChunk(int peer_rank, int chunk_idx) {
+  DispatchSend(
+      col_params_->default_rank, peer_rank, chunk_idx,
+      &send_chunks_[peer_rank][chunk_idx],
+      [this, peer_rank, chunk_idx](const Status& s) {
+        const int num_chunks = send_chunks_[peer_rank].size();
+        const int next_chunk_idx = chunk_idx + kMaxChunksInFlight;
+        int num_ops = 1;
+        if (next_chunk_idx < num_chunks) {
+          if (s.ok()) {
+            SendChunk(peer_rank, next_chunk_idx);
+          } else {
+            // The remaining chunks of this sequence are not sent.
+            num_ops += (num_chunks - 1 - next_chunk_idx) / kMaxChunksInFlight +
+                       1;
+          }
+        }
+        OpsDone(s, num_ops);
+      });
+}
+
+void AllToAll::RecvChunk(int peer_rank, int chunk_idx) {
+  DispatchRecv(
+      peer_rank, col_params_->default_rank, chunk_idx,
+      &recv_chunks_[peer_rank][chunk_idx],
+      [this, peer_rank, chunk_idx](const Status& s) {
+        const int num_chunks = recv_chunks_[peer_rank].size();
+        const int next_chunk_idx = chunk_idx + kMaxChunksInFlight;
+        int num_ops = 1;
+        if (next_chunk_idx < num_chunks) {
+          if (s.ok()) {
+            RecvChunk(peer_rank, next_chunk_idx);
+          } else {
+            // The remaining chunks of this sequence are not received.
+            num_ops += (num_chunks - 1 - next_chunk_idx) / kMaxChunksInFlight +
+                       1;
+          }
+        }
+        OpsDone(s, num_ops);
+      });
 }
 
-void AllToAll::DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
-                            const StatusCallback& done) {
-  string send_buf_key =
-      strings::StrCat(col_ctx_->exec_key, src_rank, target_rank);
+void AllToAll::DispatchSend(int src_rank, int target_rank, int chunk_idx,
+                            const Tensor* tensor, const StatusCallback& done) {
+  string send_buf_key = strings::StrCat(col_ctx_->exec_key, ":", src_rank, ":",
+                                        target_rank, ":", chunk_idx);
   col_ctx_->col_exec->remote_access()->PostToPeer(
       col_params_->group.members[target_rank].device.name(),
       col_params_->group.members[target_rank].task, send_buf_key,
@@ -132,10 +225,10 @@ void AllToAll::DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
       col_ctx_->op_ctx->cancellation_manager(), done);
 }
 
-void AllToAll::DispatchRecv(int src_rank, int target_rank, Tensor* tensor,
-                            const StatusCallback& done) {
-  string recv_buf_key =
-      strings::StrCat(col_ctx_->exec_key, src_rank, target_rank);
+void AllToAll::DispatchRecv(int src_rank, int target_rank, int chunk_idx,
+                            Tensor* tensor, const StatusCallback& done) {
+  string recv_buf_key = strings::StrCat(col_ctx_->exec_key, ":", src_rank, ":",
+                                        target_rank, ":", chunk_idx);
   col_ctx_->col_exec->remote_access()->RecvFromPeer(
       col_params_->group.members[src_rank].device.name(),
       col_params_->group.members[src_rank].task,
@@ -27,6 +27,14 @@ limitations under the License.
 namespace tensorflow {
 
 // Implementation of collective all-to-all.
+//
+// The slice exchanged with each peer is split into chunks of at most
+// kMaxChunkSizeBytes, which are sent to and received from all peers in
+// parallel. With each peer, up to kMaxChunksInFlight chunks are in flight in
+// each direction, so that the transfer of a chunk overlaps with issuing the
+// next ones without buffering the whole slice in the transport. The received
+// chunks are written in place into the output. The slice of this device is
+// copied directly from the input to the output.
 class AllToAll : public CollectiveImplementationInterface {
  public:
   AllToAll();
@@ -45,24 +53,35 @@ class AllToAll : public CollectiveImplementationInterface {
  private:
   std::shared_ptr<CollectiveContext> col_ctx_;
   const CollectiveParams* col_params_;  // Not owned
-  std::vector<Tensor> input_chunks_;
   Tensor output_buffer_;
-  std::vector<Tensor> output_chunks_;
+  // Chunks of the input to send to and of the output to receive from each
+  // peer, by rank.
+  std::vector<std::vector<Tensor>> send_chunks_;
+  std::vector<std::vector<Tensor>> recv_chunks_;
   StatusCallback done_;
   mutex mu_;
   Status status_ TF_GUARDED_BY(mu_);
-  int counter_ TF_GUARDED_BY(mu_);
+  // Number of sends, receives and copies that have not completed yet.
+  int num_pending_ TF_GUARDED_BY(mu_);
 
-  void DispatchSend(int src_rank, int target_rank, const Tensor* tensor,
-                    const StatusCallback& done);
+  // Splits `tensor` into chunks of at most kMaxChunkSizeBytes that share its
+  // buffer.
+  static std::vector<Tensor> SplitIntoChunks(const Tensor& tensor);
 
-  void DispatchRecv(int src_rank, int target_rank, Tensor* tensor,
-                    const StatusCallback& done);
+  // Sends or receives the chunk `chunk_idx` of `peer_rank`, then the next
+  // chunk of the same peer that is kMaxChunksInFlight chunks further.
+  void SendChunk(int peer_rank, int chunk_idx);
+  void RecvChunk(int peer_rank, int chunk_idx);
 
-  // Atomically increments counter_ by one for sending, one for receiving.
-  // Invokes done when counter_ reaches 2.
-  // The purpose of checking counter_ is to ensure that done_ is called once.
-  StatusCallback CheckCounterAndCallDone();
+  void DispatchSend(int src_rank, int target_rank, int chunk_idx,
+                    const Tensor* tensor, const StatusCallback& done);
+
+  void DispatchRecv(int src_rank, int target_rank, int chunk_idx,
+                    Tensor* tensor, const StatusCallback& done);
+
+  // Records the completion of `num_ops` operations with status `s`. Invokes
+  // done_ once all of them have completed, so that it is called once.
+  void OpsDone(const Status& s, int num_ops);
 };
 
 }  // namespace tensorflow
@@ -95,6 +95,47 @@ TEST_F(AllToAllTest, SuccessDifferentRank) {
                                   test::AsTensor<double>({9., 6., 3.}));
 }
 
+TEST_F(AllToAllTest, SuccessLargeTensor) {
+  test_env_ = CreateCollectiveTestEnv(/*num_workers*/ 1,
+                                      /*num_devices_per_worker*/ 2, DEVICE_CPU);
+  // Each slice is larger than a chunk, and is exchanged in three chunks.
+  constexpr int64_t kSliceSize = (9 * 1024 * 1024) / sizeof(float) + 3;
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < 2; ++i) {
+    Tensor tensor(DT_FLOAT, TensorShape({2, kSliceSize}));
+    auto matrix = tensor.matrix<float>();
+    for (int j = 0; j < 2; ++j) {
+      for (int64_t k = 0; k < kSliceSize; ++k) {
+        matrix(j, k) = i * 10 + j + k % 1000;
+      }
+    }
+    tensors.push_back(tensor);
+  }
+  BlockingCounter counter(2);
+  for (int i = 0; i < 2; ++i) {
+    SchedClosure([this, &tensors, i, &counter]() {
+      auto col_params = CreateCollectiveParams(*test_env_, i, "AllToAll",
+                                               ALL_TO_ALL_COLLECTIVE, DT_FLOAT,
+                                               tensors[i].shape());
+      Device* device = nullptr;
+      TF_CHECK_OK(test_env_->device_mgr->LookupDevice(
+          col_params->group.members[i].device.name(), &device));
+      TF_CHECK_OK(RunCollective(test_env_.get(), col_params.get(), device,
+                                &tensors[i], &tensors[i]));
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (int i = 0; i < 2; ++i) {
+    auto matrix = tensors[i].matrix<float>();
+    for (int j = 0; j < 2; ++j) {
+      for (int64_t k = 0; k < kSliceSize; ++k) {
+        ASSERT_EQ(matrix(j, k), j * 10 + i + k % 1000);
+      }
+    }
+  }
+}
+
 TEST_F(AllToAllTest, Failure) {
   test_env_ = CreateCollectiveTestEnv(/*num_workers*/ 1,
                                       /*num_devices_per_worker*/ 3, DEVICE_CPU);
@@ -18,6 +18,7 @@ limitations under the License.
 #include <functional>
 #include <utility>
 
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
 #include "tensorflow/core/common_runtime/copy_tensor.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/refcount.h"
@@ -40,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/connected_traceme.h"
 #include "tensorflow/core/profiler/lib/scoped_memory_debug_annotation.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/util/env_var.h"
 
 #define VALUE_IN_DEBUG_STRING false
 
@@ -50,6 +53,44 @@ bool IsCancelled(CancellationManager* cancel_mgr) {
   return cancel_mgr != nullptr &&
          (cancel_mgr->IsCancelled() || cancel_mgr->IsCancelling());
 }
+
+// Reductions of fewer bytes than TF_COLLECTIVE_BUCKET_BYTES are fused with the
+// other reductions of the same device and group that are ready at the same
+// time, in buckets of about that size.  A bucket that is not full is flushed
+// TF_COLLECTIVE_BUCKET_DELAY_US microseconds after its first reduction.
+//
+// Buckets are formed in the order in which the reductions are executed, so
+// every member of a group must execute its reductions in the same order, for
+// example by ordering them with control dependencies or ordering tokens.
+// Disabled by default.
+int64_t BucketBytes() {
+  static const int64_t bucket_bytes = [] {
+    int64_t bytes;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_COLLECTIVE_BUCKET_BYTES", 0, &bytes));
+    return bytes;
+  }();
+  return bucket_bytes;
+}
+
+int64_t BucketDelayMicros() {
+  static const int64_t delay_us = [] {
+    int64_t delay;
+    TF_CHECK_OK(
+        ReadInt64FromEnvVar("TF_COLLECTIVE_BUCKET_DELAY_US", 1000, &delay));
+    return delay;
+  }();
+  return delay_us;
+}
+
+// Fused reductions use negative instance keys, which are derived from the
+// instance keys of the fused reductions so that they match across members.
+int32 FusedInstanceKey(const std::vector<int32>& instance_keys) {
+  uint64 hash = 0;
+  for (int32_t key : instance_keys) {
+    hash = Hash64Combine(hash, static_cast<uint64>(key));
+  }
+  return -1 - static_cast<int32>(hash & 0x3fffffff);
+}
 }  // namespace
 
 /*static*/
@@ -273,6 +314,24 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
                                           const CollectiveParams* col_params,
                                           const string& exec_key,
                                           StatusCallback done) {
+  if (MaybeAddToBucket(ctx, col_params, exec_key, done)) return;
+  Tensor* output = ctx->mutable_output(0);
+  const Tensor* input = (col_params->instance.type == REDUCTION_COLLECTIVE ||
+                         col_params->instance.type == GATHER_COLLECTIVE ||
+                         col_params->instance.type == PERMUTE_COLLECTIVE ||
+                         col_params->instance.type == ALL_TO_ALL_COLLECTIVE ||
+                         (col_params->instance.type == BROADCAST_COLLECTIVE &&
+                          col_params->is_source))
+                            ? &ctx->input(0)
+                            : nullptr;
+  ExecuteWithTensors(ctx, col_params, exec_key, input, output,
+                     std::move(done));
+}
+
+void BaseCollectiveExecutor::ExecuteWithTensors(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    const string& exec_key, const Tensor* input, Tensor* output,
+    StatusCallback done) {
   // See CompleteParamsAsync() how done() and the timeout callback interacts.
   const auto is_callback_called = std::make_shared<std::atomic<bool>>(false);
   auto done_safe = [this, done, ctx, is_callback_called](const Status& s) {
@@ -302,15 +361,6 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
         });
   }
 
-  Tensor* output = ctx->mutable_output(0);
-  const Tensor* input = (col_params->instance.type == REDUCTION_COLLECTIVE ||
-                         col_params->instance.type == GATHER_COLLECTIVE ||
-                         col_params->instance.type == PERMUTE_COLLECTIVE ||
-                         col_params->instance.type == ALL_TO_ALL_COLLECTIVE ||
-                         (col_params->instance.type == BROADCAST_COLLECTIVE &&
-                          col_params->is_source))
-                            ? &ctx->input(0)
-                            : nullptr;
   CollectiveImplementationInterface* col_impl = nullptr;
   Status status = CreateCollective(*col_params, &col_impl);
   if (!status.ok()) {
@@ -353,6 +403,190 @@ void BaseCollectiveExecutor::ExecuteAsync(OpKernelContext* ctx,
   });
 }
 
+bool BaseCollectiveExecutor::MaybeAddToBucket(
+    OpKernelContext* ctx, const CollectiveParams* col_params,
+    const string& exec_key, const StatusCallback& done) {
+  const int64_t bucket_bytes = BucketBytes();
+  if (bucket_bytes <= 0 || col_params->instance.type != REDUCTION_COLLECTIVE ||
+      !col_params->instance.impl_details.dependencies.empty() ||
+      DataTypeSize(col_params->instance.data_type) == 0 ||
+      ctx->input(0).TotalBytes() >= bucket_bytes) {
+    return false;
+  }
+  const DataType dtype = col_params->instance.data_type;
+  const string key = strings::StrCat(
+      ctx->device()->name(), ":", col_params->group.group_key, ":",
+      DataTypeString(dtype), ":", col_params->merge_op->type_string(), ":",
+      col_params->final_op ? col_params->final_op->type_string() : "", ":",
+      col_params->instance.impl_details.communication_hint, ":",
+      ctx->frame_iter().frame_id, ":", ctx->frame_iter().iter_id);
+  // Keep the input of each reduction aligned in the fused tensor.
+  const int64_t align_elts = std::max<int64_t>(
+      1, Allocator::kAllocatorAlignment / DataTypeSize(dtype));
+  Bucket full_bucket;
+  int64_t new_bucket_id = -1;
+  {
+    mutex_lock l(bucket_mu_);
+    Bucket& bucket = buckets_[key];
+    if (bucket.entries.empty()) {
+      bucket.id = next_bucket_id_++;
+      new_bucket_id = bucket.id;
+    }
+    const int64_t offset =
+        (bucket.num_elements + align_elts - 1) / align_elts * align_elts;
+    bucket.entries.push_back({ctx, col_params, exec_key, done, offset});
+    bucket.num_elements = offset + ctx->input(0).NumElements();
+    if (bucket.num_elements * DataTypeSize(dtype) >= bucket_bytes) {
+      full_bucket = std::move(bucket);
+      buckets_.erase(key);
+      new_bucket_id = -1;
+    }
+  }
+  if (!full_bucket.entries.empty()) {
+    FlushBucket(std::move(full_bucket));
+  } else if (new_bucket_id >= 0) {
+    Ref();
+    SchedNonBlockingClosureAfter(BucketDelayMicros(),
+                                 [this, key, new_bucket_id]() {
+                                   FlushBucketIfPending(key, new_bucket_id);
+                                   Unref();
+                                 });
+  }
+  return true;
+}
+
+void BaseCollectiveExecutor::FlushBucketIfPending(const string& key,
+                                                  int64_t id) {
+  Bucket bucket;
+  {
+    mutex_lock l(bucket_mu_);
+    auto it = buckets_.find(key);
+    if (it == buckets_.end() || it->second.id != id) return;
+    bucket = std::move(it->second);
+    buckets_.erase(it);
+  }
+  FlushBucket(std::move(bucket));
+}
+
+void BaseCollectiveExecutor::FlushBucket(Bucket bucket) {
+  const BucketEntry& first = bucket.entries[0];
+  if (bucket.entries.size() == 1) {
+    ExecuteWithTensors(first.ctx, first.col_params, first.exec_key,
+                       &first.ctx->input(0), first.ctx->mutable_output(0),
+                       first.done);
+    return;
+  }
+  // Copying the inputs may block, so run on the work queue.
+  Ref();
+  RunClosure([this, bucket = std::move(bucket)]() {
+    core::ScopedUnref unref(this);
+    auto finish = [bucket](const Status& s) {
+      for (const BucketEntry& entry : bucket.entries) entry.done(s);
+    };
+    const BucketEntry& first = bucket.entries[0];
+    OpKernelContext* ctx = first.ctx;
+    const CollectiveParams& first_params = *first.col_params;
+    VLOG(2) << "Fusing " << bucket.entries.size() << " reductions of group "
+            << first_params.group.group_key << " on " << ctx->device()->name()
+            << " into " << bucket.num_elements << " elements";
+    auto fused = std::make_shared<Tensor>(
+        ctx->device()->GetAllocator(ctx->output_alloc_attr(0)),
+        first_params.instance.data_type,
+        TensorShape({bucket.num_elements}));
+    Status status = CopyBucket(bucket, fused.get(), /*to_fused=*/true);
+    if (!status.ok()) {
+      finish(status);
+      return;
+    }
+
+    std::vector<int32> instance_keys;
+    for (const BucketEntry& entry : bucket.entries) {
+      instance_keys.push_back(entry.col_params->instance.instance_key);
+    }
+    CollectiveParams* cp = new CollectiveParams();
+    cp->name = strings::StrCat("Fused(", first_params.name, ", ",
+                               bucket.entries.size(), ")");
+    cp->group.group_key = first_params.group.group_key;
+    cp->group.group_size = first_params.group.group_size;
+    cp->group.device_type = first_params.group.device_type;
+    cp->instance.type = REDUCTION_COLLECTIVE;
+    cp->instance.data_type = first_params.instance.data_type;
+    cp->instance.shape = fused->shape();
+    cp->instance.instance_key = FusedInstanceKey(instance_keys);
+    cp->instance.impl_details.communication_hint =
+        first_params.instance.impl_details.communication_hint;
+    cp->instance.impl_details.timeout_seconds =
+        first_params.instance.impl_details.timeout_seconds;
+    cp->instance.impl_details.max_subdivs_per_device =
+        first_params.instance.impl_details.max_subdivs_per_device;
+    cp->merge_op = first_params.merge_op;
+    cp->final_op = first_params.final_op;
+    const string exec_key = strings::StrCat(
+        cp->group.group_key, ":", cp->instance.instance_key, ":",
+        ctx->frame_iter().frame_id, ":", ctx->frame_iter().iter_id);
+    CompleteParamsAsync(
+        ctx->device()->attributes(), cp, ctx->cancellation_manager(),
+        [this, ctx, cp, exec_key, fused, bucket, finish](const Status& s) {
+          if (!s.ok()) {
+            finish(s);
+            cp->Unref();
+            return;
+          }
+          ExecuteWithTensors(
+              ctx, cp, exec_key, fused.get(), fused.get(),
+              [this, cp, fused, bucket, finish](const Status& s) {
+                cp->Unref();
+                if (!s.ok()) {
+                  finish(s);
+                  return;
+                }
+                Ref();
+                RunClosure([this, fused, bucket, finish]() {
+                  core::ScopedUnref unref(this);
+                  finish(CopyBucket(bucket, fused.get(), /*to_fused=*/false));
+                });
+              });
+        });
+  });
+}
+
+Status BaseCollectiveExecutor::CopyBucket(const Bucket& bucket, Tensor* fused,
+                                          bool to_fused) {
+  const AllocatorAttributes fused_attr =
+      bucket.entries[0].ctx->output_alloc_attr(0);
+  Device* device = nullptr;
+  TF_RETURN_IF_ERROR(
+      dev_mgr_->LookupDevice(bucket.entries[0].ctx->device()->name(), &device));
+  for (const BucketEntry& entry : bucket.entries) {
+    OpKernelContext* ctx = entry.ctx;
+    const TensorShape& shape = ctx->input(0).shape();
+    if (shape.num_elements() == 0) continue;
+    Tensor slice =
+        fused->Slice(entry.offset, entry.offset + shape.num_elements());
+    DMAHelper::UnsafeSetShape(&slice, shape);
+    Notification note;
+    Status status;
+    auto done = [&note, &status](const Status& s) {
+      status = s;
+      note.Notify();
+    };
+    if (to_fused) {
+      CollectiveRemoteAccessLocal::MemCpyAsync(
+          ctx->op_device_context(), ctx->op_device_context(), device, device,
+          ctx->input_alloc_attr(0), fused_attr, &ctx->input(0), &slice,
+          0 /*dev_to_dev_stream_index*/, done);
+    } else {
+      CollectiveRemoteAccessLocal::MemCpyAsync(
+          ctx->op_device_context(), ctx->op_device_context(), device, device,
+          fused_attr, ctx->output_alloc_attr(0), &slice, ctx->mutable_output(0),
+          0 /*dev_to_dev_stream_index*/, done);
+    }
+    note.WaitForNotification();
+    TF_RETURN_IF_ERROR(status);
+  }
+  return OkStatus();
+}
+
 void BaseCollectiveExecutor::CompleteParamsAsync(
     const DeviceAttributes& device, CollectiveParams* cp,
     CancellationManager* cancel_mgr, StatusCallback done) {
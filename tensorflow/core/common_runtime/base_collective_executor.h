@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/buf_rendezvous.h"
 #include "tensorflow/core/framework/collective.h"
@@ -150,6 +152,50 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   Status status_ TF_GUARDED_BY(status_mu_);
 
  private:
+  // A reduction waiting to be fused with others of the same device and group.
+  struct BucketEntry {
+    OpKernelContext* ctx;
+    const CollectiveParams* col_params;
+    string exec_key;
+    StatusCallback done;
+    // Offset of the input in the fused tensor, in elements.
+    int64_t offset;
+  };
+
+  // Reductions that are fused into a single reduction of a tensor of
+  // `num_elements` elements when the bucket is flushed.
+  struct Bucket {
+    int64_t id = 0;
+    int64_t num_elements = 0;
+    std::vector<BucketEntry> entries;
+  };
+
+  // Runs the collective of `col_params` from `input` into `output`.
+  void ExecuteWithTensors(OpKernelContext* ctx,
+                          const CollectiveParams* col_params,
+                          const string& exec_key, const Tensor* input,
+                          Tensor* output, StatusCallback done);
+
+  // If reductions are bucketed, adds the reduction of `col_params` to the
+  // bucket of its device and group and returns true.  `done` is called when
+  // the bucket has been reduced.
+  bool MaybeAddToBucket(OpKernelContext* ctx,
+                        const CollectiveParams* col_params,
+                        const string& exec_key, const StatusCallback& done)
+      TF_LOCKS_EXCLUDED(bucket_mu_);
+
+  // Removes the bucket with `key` and `id` if it still exists, and flushes it.
+  void FlushBucketIfPending(const string& key, int64_t id)
+      TF_LOCKS_EXCLUDED(bucket_mu_);
+
+  // Copies the inputs of the reductions of `bucket` into a fused tensor,
+  // reduces it, and copies the result back into their outputs.
+  void FlushBucket(Bucket bucket);
+
+  // Copies the inputs of the entries of `bucket` into `fused` if `to_fused`,
+  // or the reduced values in `fused` into their outputs otherwise.
+  Status CopyBucket(const Bucket& bucket, Tensor* fused, bool to_fused);
+
   Status CreateCollective(const CollectiveParams& col_params,
                           CollectiveImplementationInterface** col_impl);
   // Check if all ops on which this collective depends on have launched.
@@ -158,6 +204,11 @@ class BaseCollectiveExecutor : public CollectiveExecutor {
   // Tries to return the status that is the original error. It returns the
   // aborted status if the collective executor is aborted.
   Status GetStatus(const Status& s) TF_LOCKS_EXCLUDED(status_mu_);
+
+  mutex bucket_mu_;
+  // Pending buckets, keyed by device, group and reduction ops.
+  std::unordered_map<string, Bucket> buckets_ TF_GUARDED_BY(bucket_mu_);
+  int64_t next_bucket_id_ TF_GUARDED_BY(bucket_mu_) = 0;
 };
 
 }  // namespace tensorflow
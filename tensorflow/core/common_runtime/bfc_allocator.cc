@@ -22,9 +22,11 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -40,6 +42,34 @@ namespace tensorflow {
 
 constexpr BFCAllocator::ChunkHandle BFCAllocator::kInvalidChunkHandle;
 
+namespace {
+
+auto* bfc_free_bytes = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/core/bfc_allocator/free_bytes",
+    "Bytes of the regions of a BFCAllocator that are not in use.",
+    "allocator");
+
+auto* bfc_largest_free_chunk_bytes = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/core/bfc_allocator/largest_free_chunk_bytes",
+    "Size in bytes of the largest free chunk of a BFCAllocator.", "allocator");
+
+auto* bfc_fragmentation_percent = monitoring::Gauge<int64_t, 1>::New(
+    "/tensorflow/core/bfc_allocator/fragmentation_percent",
+    "Percentage of the free bytes of a BFCAllocator that are not in its "
+    "largest free chunk.",
+    "allocator");
+
+// Returns a small integer identifying the calling thread, used to pick a
+// small chunk cache shard.
+int CurrentThreadIndex() {
+  static std::atomic<int> next_index{0};
+  thread_local const int index =
+      next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
                            size_t total_memory, const string& name,
                            const Options& opts)
@@ -80,6 +110,18 @@ BFCAllocator::BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (opts.allocation_timeline_size > 0) {
+    timeline_.resize(opts.allocation_timeline_size);
+  }
+
+  if (opts.small_chunk_cache) {
+    VLOG(1) << "Enabling the small chunk cache for " << name;
+    small_chunk_caches_.reset(
+        new SmallChunkCacheShard[kNumSmallChunkCacheShards]);
+    small_chunk_sizes_.reset(
+        new SmallChunkSizeShard[kNumSmallChunkCacheShards]);
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -183,6 +225,7 @@ bool BFCAllocator::Extend(size_t alignment, size_t rounded_bytes) {
   c->prev = kInvalidChunkHandle;
   c->next = kInvalidChunkHandle;
   c->freed_at_count = 0;
+  c->freed_at_release_epoch = release_epoch_;
 
   region_manager_.set_handle(c->ptr, h);
 
@@ -258,6 +301,15 @@ void* BFCAllocator::AllocateRawInternalWithRetry(
 void* BFCAllocator::AllocateRaw(size_t unused_alignment, size_t num_bytes,
                                 const AllocationAttributes& allocation_attr) {
   VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes;
+  if (small_chunk_caches_ != nullptr &&
+      allocation_attr.freed_by_func == nullptr) {
+    void* result = AllocateFromSmallChunkCache(num_bytes);
+    if (result != nullptr) {
+      VLOG(3) << "AllocateRaw " << Name() << "  " << num_bytes << " "
+              << result << " (cached)";
+      return result;
+    }
+  }
   void* result = [&] {
     if (!opts_.allow_retry_on_failure || !allocation_attr.retry_on_failure) {
       // If we have globally disabled retry-on-failure and fail to allocate an
@@ -402,8 +454,15 @@ void BFCAllocator::DeallocateRegions(
     }
 
     // Deallocate the memory.
+    size_t region_decommitted_bytes = 0;
+    if (decommitted_bytes_ > 0) {
+      region_decommitted_bytes =
+          sub_allocator_->DecommittedBytes(it->ptr(), it->memory_size());
+      decommitted_bytes_ -= region_decommitted_bytes;
+    }
     sub_allocator_->Free(it->ptr(), it->memory_size());
-    total_region_allocated_bytes_ -= it->memory_size();
+    total_region_allocated_bytes_ -=
+        it->memory_size() - region_decommitted_bytes;
     it = region_manager_.RemoveAllocationRegion(it);
   }
 }
@@ -444,6 +503,16 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Return the chunks held by the small chunk caches to the bins, where they
+  // may be merged or split to satisfy this request.
+  if (FlushSmallChunkCaches()) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   if ((freed_before == 0) && (!timestamped_chunks_.empty())) {
     // We're unable to satisfy an allocation request without a specific
     // timestamp requirement.  Rather than fail, try merging any held-out
@@ -458,6 +527,20 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
     }
   }
 
+  // Release the physical memory under all free chunks, so that it can back
+  // the chunk found for this request, or a new region.
+  if (opts_.release_free_memory_interval_micros > 0 &&
+      ReleaseFreeMemoryInternal(/*idle_only=*/false) > 0) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    if (ptr == nullptr && Extend(unused_alignment, rounded_bytes)) {
+      ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes, freed_before);
+    }
+    if (ptr != nullptr) {
+      AddTraceMe("MemoryAllocation", ptr);
+      return ptr;
+    }
+  }
+
   // Reaching this point means that no chunks can satisfy the request. Also,
   // the unallocated bytes cannot satisfy the request. Before giving up, let's
   // try deallocating free regions so that suballocator can combine them with
@@ -565,10 +648,6 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
         continue;
       }
       if (chunk->size >= rounded_bytes) {
-        // We found an existing chunk that fits us that wasn't in use, so remove
-        // it from the free bin structure prior to using.
-        RemoveFreeChunkIterFromBin(&b->free_chunks, citer);
-
         // If we can break the size of the chunk into two reasonably large
         // pieces, do don't waste more than max_internal_fragmentation_bytes on
         // padding. If this threshold is not set by the user, then use 128MB as
@@ -577,10 +656,23 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
             (opts_.fragmentation_fraction > 0.0)
                 ? opts_.fragmentation_fraction * memory_limit_
                 : 128 << 20;
-
-        if (chunk->size >= rounded_bytes * 2 ||
+        const bool split =
+            chunk->size >= rounded_bytes * 2 ||
             static_cast<int64_t>(chunk->size) - rounded_bytes >=
-                max_internal_fragmentation_bytes) {
+                max_internal_fragmentation_bytes;
+
+        // Back the part of the chunk that is returned with physical memory
+        // again if some of it was decommitted.
+        if (decommitted_bytes_ > 0 &&
+            !CommitMemory(chunk->ptr, split ? rounded_bytes : chunk->size)) {
+          continue;
+        }
+
+        // We found an existing chunk that fits us that wasn't in use, so remove
+        // it from the free bin structure prior to using.
+        RemoveFreeChunkIterFromBin(&b->free_chunks, citer);
+
+        if (split) {
           SplitChunk(h, rounded_bytes);
           chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
         }
@@ -603,6 +695,8 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
             std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
         stats_.largest_alloc_size =
             std::max<std::size_t>(stats_.largest_alloc_size, chunk->size);
+        MaybeTrackSmallChunk(*chunk);
+        RecordAllocationEvent(/*is_allocation=*/true, *chunk);
 
 #ifdef TENSORFLOW_MEM_DEBUG
         if (ShouldRecordOpName()) {
@@ -658,6 +752,7 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 
   // It inherits the freed time.
   new_chunk->freed_at_count = c->freed_at_count;
+  new_chunk->freed_at_release_epoch = c->freed_at_release_epoch;
 
   // Maintain the pointers.
   // c <-> c_neighbor becomes
@@ -678,7 +773,10 @@ void BFCAllocator::SplitChunk(BFCAllocator::ChunkHandle h, size_t num_bytes) {
 void BFCAllocator::DeallocateRaw(void* ptr) {
   VLOG(3) << "DeallocateRaw " << Name() << " "
           << (ptr ? RequestedSize(ptr) : 0);
-  DeallocateRawInternal(ptr);
+  if (ptr == nullptr || small_chunk_caches_ == nullptr ||
+      !DeallocateToSmallChunkCache(ptr)) {
+    DeallocateRawInternal(ptr);
+  }
   retry_helper_.NotifyDealloc();
 }
 
@@ -708,6 +806,10 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     InsertFreeChunkIntoBin(TryToCoalesce(h, false));
   }
 
+  if (opts_.release_free_memory_interval_micros > 0) {
+    MaybeReleaseFreeMemory();
+  }
+
   // TraceMe needs to be added after MarkFree and InsertFreeChunkIntoBin for
   // correct aggregation stats (bytes_in_use, fragmentation).
   AddTraceMe("MemoryDeallocation", chunk_ptr, req_bytes, alloc_bytes);
@@ -717,6 +819,335 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
   }
 }
 
+BFCAllocator::SmallChunkCacheShard*
+BFCAllocator::CurrentSmallChunkCacheShard() {
+  return &small_chunk_caches_[CurrentThreadIndex() %
+                              kNumSmallChunkCacheShards];
+}
+
+BFCAllocator::SmallChunkSizeShard* BFCAllocator::SmallChunkSizeShardFor(
+    const void* ptr) {
+  const std::uintptr_t index =
+      reinterpret_cast<std::uintptr_t>(ptr) >> kMinAllocationBits;
+  return &small_chunk_sizes_[index % kNumSmallChunkCacheShards];
+}
+
+void* BFCAllocator::AllocateFromSmallChunkCache(size_t num_bytes) {
+  if (num_bytes == 0 || timing_counter_ != nullptr) return nullptr;
+  const size_t rounded_bytes = RoundedBytes(num_bytes);
+  if (rounded_bytes > kSmallChunkCacheMaxBytes) return nullptr;
+
+  void* ptr = nullptr;
+  {
+    SmallChunkCacheShard* shard = CurrentSmallChunkCacheShard();
+    mutex_lock l(shard->mu);
+    std::vector<void*>& chunks =
+        shard->chunks[rounded_bytes / kMinAllocationSize - 1];
+    if (!chunks.empty()) {
+      ptr = chunks.back();
+      chunks.pop_back();
+      shard->bytes -= rounded_bytes;
+    }
+  }
+  if (ptr == nullptr) {
+    num_small_chunk_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  num_small_chunk_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  small_chunk_cache_bytes_.fetch_sub(rounded_bytes, std::memory_order_relaxed);
+  return ptr;
+}
+
+bool BFCAllocator::DeallocateToSmallChunkCache(void* ptr) {
+  size_t chunk_size;
+  {
+    SmallChunkSizeShard* shard = SmallChunkSizeShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->chunk_sizes.find(ptr);
+    if (it == shard->chunk_sizes.end()) return false;
+    if (timing_counter_ != nullptr) {
+      // The chunk must be freed with a timestamp.
+      shard->chunk_sizes.erase(it);
+      return false;
+    }
+    chunk_size = it->second;
+  }
+
+  // When the shard grows too large, about half of the chunks of each size are
+  // returned to the bins, starting with the least recently cached ones.
+  std::vector<void*> to_release;
+  int64_t released_bytes = 0;
+  {
+    SmallChunkCacheShard* shard = CurrentSmallChunkCacheShard();
+    mutex_lock l(shard->mu);
+    shard->chunks[chunk_size / kMinAllocationSize - 1].push_back(ptr);
+    shard->bytes += chunk_size;
+    if (shard->bytes > kSmallChunkCacheShardBytes) {
+      for (int i = 0; i < kNumSmallChunkSizes; ++i) {
+        std::vector<void*>& chunks = shard->chunks[i];
+        const size_t num_to_release = (chunks.size() + 1) / 2;
+        to_release.insert(to_release.end(), chunks.begin(),
+                          chunks.begin() + num_to_release);
+        chunks.erase(chunks.begin(), chunks.begin() + num_to_release);
+        released_bytes += num_to_release * (i + 1) * kMinAllocationSize;
+      }
+      shard->bytes -= released_bytes;
+    }
+  }
+  small_chunk_cache_bytes_.fetch_add(
+      static_cast<int64_t>(chunk_size) - released_bytes,
+      std::memory_order_relaxed);
+
+  if (!to_release.empty()) {
+    mutex_lock l(lock_);
+    ReleaseSmallChunks(to_release);
+  }
+  return true;
+}
+
+void BFCAllocator::MaybeTrackSmallChunk(const Chunk& chunk) {
+  if (small_chunk_caches_ == nullptr || timing_counter_ != nullptr ||
+      chunk.size > kSmallChunkCacheMaxBytes) {
+    return;
+  }
+  SmallChunkSizeShard* shard = SmallChunkSizeShardFor(chunk.ptr);
+  mutex_lock l(shard->mu);
+  shard->chunk_sizes[chunk.ptr] = chunk.size;
+}
+
+void BFCAllocator::ReleaseSmallChunks(const std::vector<void*>& ptrs) {
+  for (void* ptr : ptrs) {
+    // Forget the size before freeing the chunk, since the memory may be
+    // allocated again, and tracked again, as soon as it is in a bin.
+    {
+      SmallChunkSizeShard* shard = SmallChunkSizeShardFor(ptr);
+      mutex_lock l(shard->mu);
+      shard->chunk_sizes.erase(ptr);
+    }
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+    CHECK(h != kInvalidChunkHandle);
+    MarkFree(h);
+    if (timing_counter_) {
+      InsertFreeChunkIntoBin(h);
+      timestamped_chunks_.push_back(h);
+    } else {
+      InsertFreeChunkIntoBin(TryToCoalesce(h, false));
+    }
+  }
+}
+
+bool BFCAllocator::FlushSmallChunkCaches() {
+  if (small_chunk_caches_ == nullptr) return false;
+  std::vector<void*> to_release;
+  int64_t released_bytes = 0;
+  for (int i = 0; i < kNumSmallChunkCacheShards; ++i) {
+    SmallChunkCacheShard* shard = &small_chunk_caches_[i];
+    mutex_lock l(shard->mu);
+    for (std::vector<void*>& chunks : shard->chunks) {
+      to_release.insert(to_release.end(), chunks.begin(), chunks.end());
+      chunks.clear();
+    }
+    released_bytes += shard->bytes;
+    shard->bytes = 0;
+  }
+  if (to_release.empty()) return false;
+  VLOG(1) << "Returning " << to_release.size() << " cached chunks ("
+          << strings::HumanReadableNumBytes(released_bytes) << ") to the bins"
+          << " of " << Name();
+  small_chunk_cache_bytes_.fetch_sub(released_bytes,
+                                     std::memory_order_relaxed);
+  ReleaseSmallChunks(to_release);
+  return true;
+}
+
+std::string BFCAllocator::AllocationEvent::DebugString() const {
+  return strings::StrCat(
+      is_allocation ? "Allocation" : "Deallocation", " at ", timestamp_micros,
+      "us of ", strings::HumanReadableNumBytes(chunk_bytes), " (requested ",
+      strings::HumanReadableNumBytes(requested_bytes), ") in bin ", bin_num,
+      " by op ", op_name.empty() ? "(null)" : op_name, " step ", step_id,
+      ", in use after: ", strings::HumanReadableNumBytes(bytes_in_use));
+}
+
+void BFCAllocator::RecordAllocationEvent(bool is_allocation,
+                                         const Chunk& chunk) {
+  const bool sample_fragmentation =
+      opts_.fragmentation_sampling_interval_micros > 0;
+  if (timeline_.empty() && !sample_fragmentation) return;
+
+  const uint64 now_micros = EnvTime::NowMicros();
+  if (!timeline_.empty()) {
+    const auto& annotation =
+        profiler::ScopedMemoryDebugAnnotation::CurrentAnnotation();
+    AllocationEvent& event = timeline_[next_timeline_event_];
+    next_timeline_event_ = (next_timeline_event_ + 1) % timeline_.size();
+    event.is_allocation = is_allocation;
+    event.timestamp_micros = now_micros;
+    event.chunk_bytes = chunk.size;
+    event.requested_bytes = chunk.requested_size;
+    event.bin_num = BinNumForSize(chunk.size);
+    // Reuses the capacity of the string of the overwritten event.
+    event.op_name.assign(annotation.pending_op_name ? annotation.pending_op_name
+                                                    : "");
+    event.step_id = annotation.pending_step_id;
+    event.bytes_in_use = stats_.bytes_in_use;
+  }
+
+  if (sample_fragmentation &&
+      now_micros - last_fragmentation_sample_micros_ >=
+          static_cast<uint64>(opts_.fragmentation_sampling_interval_micros)) {
+    last_fragmentation_sample_micros_ = now_micros;
+    SampleFragmentation();
+  }
+}
+
+std::vector<BFCAllocator::AllocationEvent>
+BFCAllocator::GetAllocationTimeline() {
+  mutex_lock l(lock_);
+  std::vector<AllocationEvent> events;
+  events.reserve(timeline_.size());
+  for (size_t i = 0; i < timeline_.size(); ++i) {
+    const AllocationEvent& event =
+        timeline_[(next_timeline_event_ + i) % timeline_.size()];
+    // Skips the slots that have not been written yet.
+    if (event.timestamp_micros == 0) continue;
+    events.push_back(event);
+  }
+  return events;
+}
+
+std::vector<BFCAllocator::RegionFragmentation>
+BFCAllocator::GetRegionFragmentation() {
+  mutex_lock l(lock_);
+  return GetRegionFragmentationInternal();
+}
+
+std::vector<BFCAllocator::RegionFragmentation>
+BFCAllocator::GetRegionFragmentationInternal() {
+  std::vector<RegionFragmentation> result;
+  result.reserve(region_manager_.regions().size());
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    RegionFragmentation fragmentation;
+    fragmentation.ptr = region.ptr();
+    fragmentation.region_bytes = region.memory_size();
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      if (!c->in_use()) {
+        const int64_t size = c->size;
+        fragmentation.free_bytes += size;
+        fragmentation.largest_free_chunk_bytes =
+            std::max(fragmentation.largest_free_chunk_bytes, size);
+        ++fragmentation.num_free_chunks;
+      }
+      h = c->next;
+    }
+    result.push_back(fragmentation);
+  }
+  return result;
+}
+
+void BFCAllocator::SampleFragmentation() {
+  const std::vector<RegionFragmentation> regions =
+      GetRegionFragmentationInternal();
+  int64_t free_bytes = 0;
+  int64_t largest_free_chunk_bytes = 0;
+  for (int i = 0, end = regions.size(); i < end; ++i) {
+    const RegionFragmentation& region = regions[i];
+    free_bytes += region.free_bytes;
+    largest_free_chunk_bytes =
+        std::max(largest_free_chunk_bytes, region.largest_free_chunk_bytes);
+    profiler::TraceMe::InstantActivity(
+        [this, i, &region]() {
+          return profiler::TraceMeEncode(
+              "MemoryFragmentation",
+              {{"allocator_name", name_},
+               {"region", i},
+               {"region_bytes", region.region_bytes},
+               {"free_bytes", region.free_bytes},
+               {"largest_free_chunk_bytes", region.largest_free_chunk_bytes},
+               {"num_free_chunks", region.num_free_chunks}});
+        },
+        /*level=*/profiler::TraceMeLevel::kInfo);
+  }
+  bfc_free_bytes->GetCell(name_)->Set(free_bytes);
+  bfc_largest_free_chunk_bytes->GetCell(name_)->Set(largest_free_chunk_bytes);
+  bfc_fragmentation_percent->GetCell(name_)->Set(
+      free_bytes > 0
+          ? 100 * (free_bytes - largest_free_chunk_bytes) / free_bytes
+          : 0);
+}
+
+size_t BFCAllocator::ReleaseFreeMemory() {
+  mutex_lock l(lock_);
+  return ReleaseFreeMemoryInternal(/*idle_only=*/false);
+}
+
+size_t BFCAllocator::ReleaseFreeMemoryInternal(bool idle_only) {
+  const size_t granularity = sub_allocator_->DecommitGranularity();
+  if (granularity == 0) return 0;
+
+  size_t released_bytes = 0;
+  for (const AllocationRegion& region : region_manager_.regions()) {
+    ChunkHandle h = region_manager_.get_handle(region.ptr());
+    while (h != kInvalidChunkHandle) {
+      const Chunk* c = ChunkFromHandle(h);
+      h = c->next;
+      // Timestamped chunks may still be used by pending work.
+      if (c->in_use() || c->freed_at_count > 0 || c->size < granularity ||
+          (idle_only && c->freed_at_release_epoch >= release_epoch_)) {
+        continue;
+      }
+      const std::uintptr_t ptr = reinterpret_cast<std::uintptr_t>(c->ptr);
+      const std::uintptr_t begin =
+          (ptr + granularity - 1) / granularity * granularity;
+      const std::uintptr_t end = (ptr + c->size) / granularity * granularity;
+      if (begin < end) {
+        released_bytes +=
+            sub_allocator_->Decommit(reinterpret_cast<void*>(begin),
+                                     end - begin);
+      }
+    }
+  }
+  ++release_epoch_;
+  total_region_allocated_bytes_ -= released_bytes;
+  decommitted_bytes_ += released_bytes;
+  if (released_bytes > 0) {
+    VLOG(1) << "Released " << strings::HumanReadableNumBytes(released_bytes)
+            << " of free memory of " << Name() << ", "
+            << strings::HumanReadableNumBytes(decommitted_bytes_)
+            << " decommitted in total.";
+  }
+  return released_bytes;
+}
+
+void BFCAllocator::MaybeReleaseFreeMemory() {
+  const uint64 now_micros = EnvTime::NowMicros();
+  if (now_micros - last_release_micros_ <
+      static_cast<uint64>(opts_.release_free_memory_interval_micros)) {
+    return;
+  }
+  last_release_micros_ = now_micros;
+  ReleaseFreeMemoryInternal(/*idle_only=*/true);
+}
+
+bool BFCAllocator::CommitMemory(void* ptr, size_t num_bytes) {
+  const size_t bytes = sub_allocator_->DecommittedBytes(ptr, num_bytes);
+  if (bytes == 0) return true;
+  if (total_region_allocated_bytes_ + bytes > memory_limit_) {
+    VLOG(2) << "Committing " << strings::HumanReadableNumBytes(bytes)
+            << " would exceed the memory limit of " << Name();
+    return false;
+  }
+  size_t bytes_committed;
+  if (!sub_allocator_->Commit(ptr, num_bytes, &bytes_committed)) {
+    return false;
+  }
+  total_region_allocated_bytes_ += bytes_committed;
+  decommitted_bytes_ -= bytes_committed;
+  return true;
+}
+
 // Merges h1 and h2 when Chunk(h1)->next is h2 and Chunk(h2)->prev is c1.
 // We merge Chunk(h2) into Chunk(h1).
 void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
@@ -747,6 +1178,8 @@ void BFCAllocator::Merge(BFCAllocator::ChunkHandle h1,
 
   // Pick latest free time.
   c1->freed_at_count = std::max(c1->freed_at_count, c2->freed_at_count);
+  c1->freed_at_release_epoch =
+      std::max(c1->freed_at_release_epoch, c2->freed_at_release_epoch);
 
   DeleteChunk(h2);
 }
@@ -797,9 +1230,11 @@ void BFCAllocator::MarkFree(BFCAllocator::ChunkHandle h) {
   if (timing_counter_) {
     c->freed_at_count = timing_counter_->next();
   }
+  c->freed_at_release_epoch = release_epoch_;
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
+  RecordAllocationEvent(/*is_allocation=*/false, *c);
 
 #ifdef TENSORFLOW_MEM_DEBUG
   if (ShouldRecordOpName()) {
@@ -1107,6 +1542,19 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
             << " curr_region_allocation_bytes_: "
             << curr_region_allocation_bytes_;
   LOG(INFO) << "Stats: \n" << stats_.DebugString();
+
+  if (!timeline_.empty()) {
+    // Logs the most recent events, oldest first.
+    constexpr size_t kMaxEventsToLog = 100;
+    const size_t num_events = std::min(timeline_.size(), kMaxEventsToLog);
+    LOG(INFO) << "Last allocation events:";
+    for (size_t i = timeline_.size() - num_events; i < timeline_.size(); ++i) {
+      const AllocationEvent& event =
+          timeline_[(next_timeline_event_ + i) % timeline_.size()];
+      if (event.timestamp_micros == 0) continue;
+      LOG(INFO) << event.DebugString();
+    }
+  }
 }
 
 void BFCAllocator::MaybeWriteMemoryMap() {
@@ -1202,12 +1650,27 @@ MemoryDump BFCAllocator::RecordMemoryMapInternal() {
 
 absl::optional<AllocatorStats> BFCAllocator::GetStats() {
   mutex_lock l(lock_);
-  return stats_;
+  AllocatorStats stats = stats_;
+  if (small_chunk_caches_ != nullptr) {
+    // Cached chunks are still marked in use in `stats_`, and allocations
+    // served from the caches are not counted in `stats_`.
+    const int64_t num_hits =
+        num_small_chunk_cache_hits_.load(std::memory_order_relaxed);
+    stats.bytes_in_use -=
+        small_chunk_cache_bytes_.load(std::memory_order_relaxed);
+    stats.num_allocs += num_hits;
+    stats.num_cache_hits = num_hits;
+    stats.num_cache_misses =
+        num_small_chunk_cache_misses_.load(std::memory_order_relaxed);
+  }
+  return stats;
 }
 
 bool BFCAllocator::ClearStats() {
   mutex_lock l(lock_);
   stats_.num_allocs = 0;
+  num_small_chunk_cache_hits_.store(0, std::memory_order_relaxed);
+  num_small_chunk_cache_misses_.store(0, std::memory_order_relaxed);
   stats_.peak_bytes_in_use = stats_.bytes_in_use;
   stats_.largest_alloc_size = 0;
   return true;
@@ -23,6 +23,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/shared_counter.h"
@@ -66,7 +67,71 @@ class BFCAllocator : public Allocator {
     // Controls when a chunk should be split, if its size exceeds the requested
     // allocation size.
     double fragmentation_fraction = 0;
+
+    // If true, freed chunks of at most 64KiB are kept in sharded per-thread
+    // caches, and later allocations of the same rounded size are served from
+    // these caches without taking the allocator lock. Cached chunks are
+    // returned to the bins in batches when a cache grows too large, and all of
+    // them are returned before an allocation is allowed to fail.
+    //
+    // Cached chunks still count as in use for the purpose of
+    // `peak_bytes_in_use`. Allocations served from a cache are not traced with
+    // TraceMe, and keep the requested size and allocation id of the previous
+    // use of their chunk. The caches are bypassed when a timing counter is
+    // set, or when `AllocationAttributes::freed_by_func` is provided.
+    bool small_chunk_cache = false;
+
+    // If positive, the allocator keeps the last `allocation_timeline_size`
+    // allocation and deallocation events in a ring buffer, which can be read
+    // with GetAllocationTimeline() and is logged when an allocation fails.
+    int64_t allocation_timeline_size = 0;
+
+    // If positive, the allocator computes the fragmentation of its regions at
+    // most once per interval, on the next allocation or deallocation, and
+    // exports it to the profiler and to the
+    // /tensorflow/core/bfc_allocator/* monitoring gauges.
+    int64_t fragmentation_sampling_interval_micros = 0;
+
+    // If positive and the SubAllocator supports decommitting memory, the
+    // allocator returns the physical memory under the free chunks that
+    // stayed free for a whole interval to the SubAllocator, at most once per
+    // interval on the next deallocation, while keeping their addresses. An
+    // allocation that reuses these addresses commits them again. All free
+    // chunks are also released before an allocation is allowed to fail.
+    //
+    // Decommitted memory does not count against the memory limit, so the
+    // physical memory held by the allocator tracks its live allocations, and
+    // the allocator can grow into new addresses with the physical memory of
+    // idle ranges instead of failing on fragmentation.
+    int64_t release_free_memory_interval_micros = 0;
+  };
+
+  // An allocation or deallocation recorded in the allocation timeline.
+  struct AllocationEvent {
+    bool is_allocation = false;
+    uint64 timestamp_micros = 0;
+    // Size of the chunk, and size requested by the client.
+    int64_t chunk_bytes = 0;
+    int64_t requested_bytes = 0;
+    int bin_num = -1;
+    // From profiler::ScopedMemoryDebugAnnotation, when the event occurred.
+    std::string op_name;
+    int64_t step_id = 0;
+    // Bytes in use after the event.
+    int64_t bytes_in_use = 0;
+
+    std::string DebugString() const;
   };
+
+  // Fragmentation of one allocation region.
+  struct RegionFragmentation {
+    const void* ptr = nullptr;
+    int64_t region_bytes = 0;
+    int64_t free_bytes = 0;
+    int64_t largest_free_chunk_bytes = 0;
+    int64_t num_free_chunks = 0;
+  };
+
   BFCAllocator(std::unique_ptr<SubAllocator> sub_allocator, size_t total_memory,
                const string& name, const Options& opts);
 
@@ -105,8 +170,20 @@ class BFCAllocator : public Allocator {
 
   MemoryDump RecordMemoryMap();
 
+  // Returns the events of the allocation timeline, oldest first. Empty unless
+  // `Options::allocation_timeline_size` is positive.
+  std::vector<AllocationEvent> GetAllocationTimeline();
+
+  // Returns the fragmentation of each allocation region.
+  std::vector<RegionFragmentation> GetRegionFragmentation();
+
+  // Decommits the physical memory under all free chunks if the SubAllocator
+  // supports it, and returns the number of bytes released.
+  size_t ReleaseFreeMemory();
+
  private:
   struct Bin;
+  struct Chunk;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure,
@@ -150,6 +227,71 @@ class BFCAllocator : public Allocator {
                   int64_t req_bytes, int64_t alloc_bytes)
       TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Largest chunk size kept in the small chunk caches.
+  static constexpr size_t kSmallChunkCacheMaxBytes = 64 << 10;
+  // Number of bytes one cache shard may hold before about half of its chunks
+  // are returned to the bins.
+  static constexpr size_t kSmallChunkCacheShardBytes = 4 << 20;
+  static constexpr int kNumSmallChunkCacheShards = 16;
+
+  struct SmallChunkCacheShard;
+  struct SmallChunkSizeShard;
+
+  // Returns the small chunk cache shard used by the calling thread.
+  SmallChunkCacheShard* CurrentSmallChunkCacheShard();
+
+  // Returns the shard holding the size of the chunk of `ptr`, if that chunk is
+  // tracked by the small chunk caches.
+  SmallChunkSizeShard* SmallChunkSizeShardFor(const void* ptr);
+
+  // Returns a cached chunk of exactly RoundedBytes(num_bytes) bytes, or
+  // nullptr if the request is not cacheable or no such chunk is cached.
+  void* AllocateFromSmallChunkCache(size_t num_bytes);
+
+  // Keeps the chunk of `ptr` in the cache of the calling thread. Returns false
+  // if the chunk must be freed to the bins instead.
+  bool DeallocateToSmallChunkCache(void* ptr);
+
+  // Records that the chunk of `ptr`, which has just been allocated from the
+  // bins, may be kept in the small chunk caches when it is freed.
+  void MaybeTrackSmallChunk(const Chunk& chunk)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Frees the chunks previously removed from the small chunk caches.
+  void ReleaseSmallChunks(const std::vector<void*>& ptrs)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns the chunks held by all small chunk caches to the bins. Returns
+  // true if any chunk was returned.
+  bool FlushSmallChunkCaches() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Records an event in the allocation timeline for `chunk`, and samples the
+  // fragmentation if it is due.
+  void RecordAllocationEvent(bool is_allocation, const Chunk& chunk)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  std::vector<RegionFragmentation> GetRegionFragmentationInternal()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Exports the fragmentation of the regions to the profiler and to the
+  // monitoring gauges.
+  void SampleFragmentation() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Decommits the physical memory under the free chunks, or only under those
+  // that stayed free since the previous call if `idle_only`. Returns the
+  // number of bytes released.
+  size_t ReleaseFreeMemoryInternal(bool idle_only)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Calls ReleaseFreeMemoryInternal() if an interval has passed since the
+  // previous release.
+  void MaybeReleaseFreeMemory() TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Commits the decommitted memory of [ptr, ptr + num_bytes), if any. Returns
+  // false if that would exceed the memory limit or fails.
+  bool CommitMemory(void* ptr, size_t num_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
   // kInvalidChunkHandle means an invalid chunk
   typedef size_t ChunkHandle;
@@ -206,6 +348,9 @@ class BFCAllocator : public Allocator {
     // Optional count when this chunk was most recently made free.
     uint64 freed_at_count = 0;
 
+    // Value of release_epoch_ when this chunk was most recently made free.
+    uint64 freed_at_release_epoch = 0;
+
     bool in_use() const { return allocation_id != -1; }
 
 #ifdef TENSORFLOW_MEM_DEBUG
@@ -617,6 +762,48 @@ class BFCAllocator : public Allocator {
   int64 size_history_[MEM_DEBUG_SIZE_HISTORY_SIZE];
 #endif
 
+  // Number of chunk sizes kept in the small chunk caches.
+  static constexpr int kNumSmallChunkSizes =
+      kSmallChunkCacheMaxBytes / kMinAllocationSize;
+
+  // Aligned to avoid false sharing between the shards.
+  struct alignas(64) SmallChunkCacheShard {
+    mutex mu;
+    // Cached chunks, indexed by chunk size / kMinAllocationSize - 1.
+    std::array<std::vector<void*>, kNumSmallChunkSizes> chunks
+        TF_GUARDED_BY(mu);
+    size_t bytes TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Sizes of the chunks that are cached or were allocated from the bins and
+  // may be cached when freed, sharded by address. Used to find the size of a
+  // freed chunk without taking `lock_`.
+  struct alignas(64) SmallChunkSizeShard {
+    mutex mu;
+    absl::flat_hash_map<const void*, size_t> chunk_sizes TF_GUARDED_BY(mu);
+  };
+
+  // Ring buffer of the last `opts_.allocation_timeline_size` events. The
+  // oldest event is at `next_timeline_event_` once the buffer is full.
+  std::vector<AllocationEvent> timeline_ TF_GUARDED_BY(lock_);
+  size_t next_timeline_event_ TF_GUARDED_BY(lock_) = 0;
+  uint64 last_fragmentation_sample_micros_ TF_GUARDED_BY(lock_) = 0;
+
+  // Number of bytes of the regions decommitted by ReleaseFreeMemoryInternal()
+  // and not committed again. They are not part of
+  // total_region_allocated_bytes_.
+  size_t decommitted_bytes_ TF_GUARDED_BY(lock_) = 0;
+  // Incremented by each ReleaseFreeMemoryInternal() call.
+  uint64 release_epoch_ TF_GUARDED_BY(lock_) = 0;
+  uint64 last_release_micros_ TF_GUARDED_BY(lock_) = 0;
+
+  // Set iff `opts_.small_chunk_cache` is true.
+  std::unique_ptr<SmallChunkCacheShard[]> small_chunk_caches_;
+  std::unique_ptr<SmallChunkSizeShard[]> small_chunk_sizes_;
+  std::atomic<int64_t> small_chunk_cache_bytes_{0};
+  std::atomic<int64_t> num_small_chunk_cache_hits_{0};
+  std::atomic<int64_t> num_small_chunk_cache_misses_{0};
+
   friend class GPUBFCAllocatorPrivateMethodsTest;
   friend class GPUBFCAllocatorPrivateMethodsTest_SubAllocatorSpecific;
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
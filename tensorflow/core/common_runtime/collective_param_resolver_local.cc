@@ -83,6 +83,18 @@ const char* GetCollectiveName(const CollectiveParams* cp, bool nccl) {
   }
 }
 
+// Returns true if a reduction in `cp` should use the hierarchical all-reduce,
+// i.e. if its group spans several tasks with the same number of devices
+// each, more than one, so that a flat ring would cross tasks many times.
+bool UseHierarchicalReduce(const CollectiveParams* cp) {
+  const string& hint = cp->instance.impl_details.communication_hint;
+  if (!hint.empty() && hint != "auto" && hint != "hierarchical") return false;
+  return cp->instance.type == REDUCTION_COLLECTIVE &&
+         cp->group.num_tasks > 1 && cp->group.same_num_devices_per_task &&
+         cp->group.group_size > cp->group.num_tasks &&
+         cp->instance.shape.num_elements() >= cp->group.group_size;
+}
+
 string TaskNameFromDeviceName(const string& device_name) {
   DeviceNameUtils::ParsedName parsed_device;
   CHECK(DeviceNameUtils::ParseFullName(device_name, &parsed_device));
@@ -447,13 +459,17 @@ GlobalDeviceMap EstablishGlobalRank(const CollGroupParams& gp,
     TaskDeviceMap& tdm = iter.second;
     OrderTaskDeviceMap(gpu_ring_order, &tdm);
   }
-  // Connect the global rank order by the lexicographical order of the tasks.
-  std::set<string> tasks;
+  // Connect the global rank order by the lexicographical order of the network
+  // locations of the tasks, then of the task names.  Tasks in the same rack, or
+  // any other level of the location hierarchy, are then adjacent in the ring,
+  // which crosses each level only once.
+  std::set<std::pair<string, string>> tasks;
   for (const CollGroupMember& member : gp.members) {
-    tasks.insert(member.task);
+    tasks.emplace(member.device.locality().network_location(), member.task);
   }
   int next_rank = 0;
-  for (const string& task : tasks) {
+  for (const auto& location_and_task : tasks) {
+    const string& task = location_and_task.second;
     TaskDeviceMap* tdm = &gdm[task];
     for (auto& it : *tdm) {
       it.second.global_rank = it.second.local_rank + next_rank;
@@ -707,7 +723,11 @@ void CollectiveParamResolverLocal::AssignCollectiveType(CollectiveParams* cp) {
       cp->group.device_type == DEVICE_GPU &&
       CollectiveRegistry::LookupParamResolverInstance("NcclReduce", &col_impl)
           .ok();
-  cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  if (!use_nccl && UseHierarchicalReduce(cp)) {
+    cp->instance.impl_details.collective_name = "HierarchicalReduce";
+  } else {
+    cp->instance.impl_details.collective_name = GetCollectiveName(cp, use_nccl);
+  }
   VLOG(1) << "AssignCollectiveType "
           << cp->instance.impl_details.collective_name;
 }
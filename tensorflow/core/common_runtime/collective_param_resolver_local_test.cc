@@ -160,6 +160,39 @@ TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRanking) {
                             });
 }
 
+TEST_F(CollectiveParamResolverLocalTest, CompleteDefaultRankingByLocation) {
+  // Tasks 0 and 2 are in one rack, and tasks 1 and 3 in another.
+  const std::vector<string> locations = {"/zone1/rack2", "/zone1/rack1",
+                                         "/zone1/rack2", "/zone1/rack1"};
+  CollGroupParams group;
+  group.device_type = DeviceType("CPU");
+  group.num_tasks = locations.size();
+  group.group_size = 2 * locations.size();
+  for (int task_idx = 0; task_idx < locations.size(); ++task_idx) {
+    for (int cpu_idx = 0; cpu_idx < 2; ++cpu_idx) {
+      CollGroupMember member;
+      member.task = strings::StrCat("/job:worker/replica:0/task:", task_idx);
+      member.device.set_name(
+          strings::StrCat(member.task, "/device:CPU:", cpu_idx));
+      member.device.mutable_locality()->set_network_location(
+          locations[task_idx]);
+      group.members.push_back(member);
+    }
+  }
+  // The ring crosses between the racks only twice.
+  RunCompleteDefaultRanking(group, {},
+                            {
+                                "/job:worker/replica:0/task:1/device:CPU:0",
+                                "/job:worker/replica:0/task:1/device:CPU:1",
+                                "/job:worker/replica:0/task:3/device:CPU:0",
+                                "/job:worker/replica:0/task:3/device:CPU:1",
+                                "/job:worker/replica:0/task:0/device:CPU:0",
+                                "/job:worker/replica:0/task:0/device:CPU:1",
+                                "/job:worker/replica:0/task:2/device:CPU:0",
+                                "/job:worker/replica:0/task:2/device:CPU:1",
+                            });
+}
+
 TEST_F(CollectiveParamResolverLocalTest, CompleteParamsReduction1Task) {
   CollectiveParams* cps[NUM_DEVS];
   Status statuses[NUM_DEVS];
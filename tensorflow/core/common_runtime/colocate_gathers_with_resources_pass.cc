@@ -0,0 +1,208 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/colocate_gathers_with_resources_pass.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+bool IsEnabled() {
+  static const bool enabled = [] {
+    bool enabled;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_COLOCATE_GATHERS_WITH_RESOURCES",
+                                   /*default_val=*/true, &enabled));
+    return enabled;
+  }();
+  return enabled;
+}
+
+// Returns true if `n` is a scalar constant equal to 0.
+bool IsZeroScalarConst(const Node* n) {
+  if (!n->IsConstant()) return false;
+  const TensorProto* proto;
+  if (!TryGetNodeAttr(n->attrs(), "value", &proto)) return false;
+  Tensor value;
+  if (!value.FromProto(*proto) || value.NumElements() != 1) return false;
+  if (value.dtype() == DT_INT32) return value.flat<int32>()(0) == 0;
+  if (value.dtype() == DT_INT64) return value.flat<int64_t>()(0) == 0;
+  return false;
+}
+
+// A gather of the value of a variable read in another task.
+struct RemoteGather {
+  Node* gather;
+  Node* read;
+  // The resource handle read by `read`.
+  const Edge* handle;
+  // The indices of `gather`.
+  const Edge* indices;
+};
+
+// Returns true if `n` can be replaced by a `ResourceGather` on the device of
+// the variable it gathers from, and fills in `match`.
+bool MatchRemoteGather(Node* n, RemoteGather* match) {
+  if (n->type_string() != "Gather" && n->type_string() != "GatherV2") {
+    return false;
+  }
+  if (n->type_string() == "GatherV2") {
+    int32_t batch_dims = 0;
+    if (TryGetNodeAttr(n->attrs(), "batch_dims", &batch_dims) &&
+        batch_dims != 0) {
+      return false;
+    }
+    const Edge* axis;
+    if (!n->input_edge(2, &axis).ok() || !IsZeroScalarConst(axis->src())) {
+      return false;
+    }
+  }
+  const Edge* params;
+  if (!n->input_edge(0, &params).ok() ||
+      !n->input_edge(1, &match->indices).ok()) {
+    return false;
+  }
+  Node* read = params->src();
+  if (read->type_string() != "ReadVariableOp") return false;
+  const string& read_device = read->assigned_device_name();
+  const string& gather_device = n->assigned_device_name();
+  if (read_device.empty() || gather_device.empty() ||
+      DeviceNameUtils::IsSameAddressSpace(read_device, gather_device)) {
+    return false;
+  }
+  // Other consumers of the read would still need the whole value, and would
+  // observe the variable at a different time than the new gather.
+  for (const Edge* e : read->out_edges()) {
+    if (!e->IsControlEdge() && e->dst() != n) return false;
+  }
+  if (!read->input_edge(0, &match->handle).ok()) return false;
+  match->gather = n;
+  match->read = read;
+  return true;
+}
+
+// Replaces `match.gather` and `match.read` with a `ResourceGather` on the
+// device of the read, and sets `*rewritten` to true. Leaves the graph
+// unchanged if the device has no kernel for it.
+Status RewriteRemoteGather(Graph* g, const RemoteGather& match,
+                           bool* rewritten) {
+  *rewritten = false;
+  Node* gather = match.gather;
+  Node* read = match.read;
+  DataType dtype;
+  TF_RETURN_IF_ERROR(GetNodeAttr(read->attrs(), "dtype", &dtype));
+  DataType tindices;
+  TF_RETURN_IF_ERROR(GetNodeAttr(gather->attrs(), "Tindices", &tindices));
+  bool validate_indices = true;
+  TryGetNodeAttr(gather->attrs(), "validate_indices", &validate_indices);
+
+  NodeDebugInfo debug_info(*gather);
+  Node* resource_gather;
+  TF_RETURN_IF_ERROR(
+      NodeBuilder(gather->name(), "ResourceGather", OpRegistry::Global(),
+                  &debug_info)
+          .Input(match.handle->src(), match.handle->src_output())
+          .Input(match.indices->src(), match.indices->src_output())
+          .Attr("dtype", dtype)
+          .Attr("Tindices", tindices)
+          .Attr("validate_indices", validate_indices)
+          .Device(read->requested_device())
+          .AssignedDevice(read->assigned_device_name())
+          .Finalize(g, &resource_gather));
+
+  DeviceNameUtils::ParsedName parsed;
+  if (!DeviceNameUtils::ParseFullName(read->assigned_device_name(), &parsed) ||
+      !parsed.has_type ||
+      !FindKernelDef(DeviceType(parsed.type), resource_gather->def(),
+                     /*def=*/nullptr, /*kernel_class_name=*/nullptr)
+           .ok()) {
+    g->RemoveNode(resource_gather);
+    return OkStatus();
+  }
+
+  for (Node* n : {read, gather}) {
+    for (const Edge* e : n->in_edges()) {
+      if (e->IsControlEdge()) {
+        g->AddControlEdge(e->src(), resource_gather);
+      }
+    }
+  }
+  for (Node* n : {read, gather}) {
+    for (const Edge* e : n->out_edges()) {
+      if (e->IsControlEdge()) {
+        g->AddControlEdge(resource_gather, e->dst());
+      } else if (e->dst() != gather) {
+        g->AddEdge(resource_gather, e->src_output(), e->dst(), e->dst_input());
+      }
+    }
+  }
+  VLOG(1) << "Replaced " << gather->name() << " on "
+          << gather->assigned_device_name() << " with a ResourceGather on "
+          << read->assigned_device_name();
+  g->RemoveNode(gather);
+  g->RemoveNode(read);
+  *rewritten = true;
+  return OkStatus();
+}
+
+}  // namespace
+
+Status ColocateGathersWithResourcesPass::Run(
+    const GraphOptimizationPassOptions& options) {
+  if (options.graph == nullptr || !IsEnabled()) {
+    return OkStatus();
+  }
+  Graph* g = options.graph->get();
+  if (g == nullptr) {
+    return errors::Internal(
+        "Gathers should be colocated with resources before partitioning and a "
+        "graph should be available.");
+  }
+  std::vector<RemoteGather> matches;
+  for (Node* n : g->op_nodes()) {
+    RemoteGather match;
+    if (MatchRemoteGather(n, &match)) {
+      matches.push_back(match);
+    }
+  }
+  int num_rewritten = 0;
+  for (const RemoteGather& match : matches) {
+    bool rewritten;
+    TF_RETURN_IF_ERROR(RewriteRemoteGather(g, match, &rewritten));
+    if (rewritten) ++num_rewritten;
+  }
+  if (num_rewritten > 0) {
+    VLOG(1) << "Colocated " << num_rewritten
+            << " gathers with the variables they read.";
+  }
+  return OkStatus();
+}
+
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_PLACEMENT, 10,
+                      ColocateGathersWithResourcesPass);
+
+}  // namespace tensorflow
@@ -0,0 +1,41 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLOCATE_GATHERS_WITH_RESOURCES_PASS_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_COLOCATE_GATHERS_WITH_RESOURCES_PASS_H_
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+
+namespace tensorflow {
+
+// Moves gathers of resource variables to the task that owns the variable.
+//
+// A `Gather` or `GatherV2` (on axis 0) whose params come from a
+// `ReadVariableOp` in another task transfers the whole variable over the
+// network, which is expensive for large embeddings hosted on parameter
+// servers. When the gather is the only consumer of the read, this pass
+// replaces both nodes with a `ResourceGather` on the device of the read, so
+// that only the indices and the gathered rows are transferred. The new node
+// keeps the name of the gather, and the control dependencies of both nodes.
+//
+// Runs after placement. Can be disabled by setting the environment variable
+// TF_COLOCATE_GATHERS_WITH_RESOURCES=0.
+class ColocateGathersWithResourcesPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_COLOCATE_GATHERS_WITH_RESOURCES_PASS_H_
@@ -0,0 +1,121 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/colocate_gathers_with_resources_pass.h"
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kPsDevice[] = "/job:ps/replica:0/task:0/device:CPU:0";
+constexpr char kWorkerDevice[] = "/job:worker/replica:0/task:0/device:CPU:0";
+
+class ColocateGathersWithResourcesPassTest : public ::testing::Test {
+ protected:
+  // Builds a graph that gathers rows of a variable on `ps_device` from
+  // `worker_device`. If `extra_consumer` is true, the value of the variable is
+  // also used by another node.
+  void BuildGraph(const string& ps_device, const string& worker_device,
+                  bool extra_consumer) {
+    Scope root = Scope::NewRootScope().ExitOnError();
+    Scope ps = root.WithDevice(ps_device);
+    Scope worker = root.WithDevice(worker_device);
+    auto var = ops::VarHandleOp(ps.WithOpName("var"), DT_FLOAT,
+                                TensorShape({100, 8}));
+    auto read = ops::ReadVariableOp(ps.WithOpName("read"), var, DT_FLOAT);
+    auto indices = ops::Const(worker.WithOpName("indices"), {1, 5, 7});
+    auto axis = ops::Const(worker.WithOpName("axis"), 0);
+    auto gather =
+        ops::GatherV2(worker.WithOpName("gather"), read, indices, axis);
+    ops::Identity(worker.WithOpName("output"), gather);
+    if (extra_consumer) {
+      ops::Identity(worker.WithOpName("other"), read);
+    }
+    graph_ = std::make_unique<Graph>(OpRegistry::Global());
+    TF_ASSERT_OK(root.ToGraph(graph_.get()));
+    for (Node* n : graph_->op_nodes()) {
+      n->set_assigned_device_name(n->requested_device());
+    }
+  }
+
+  void RunPass() {
+    GraphOptimizationPassOptions options;
+    options.graph = &graph_;
+    ColocateGathersWithResourcesPass pass;
+    TF_ASSERT_OK(pass.Run(options));
+  }
+
+  Node* FindNode(const string& name) {
+    for (Node* n : graph_->op_nodes()) {
+      if (n->name() == name) return n;
+    }
+    return nullptr;
+  }
+
+  std::unique_ptr<Graph> graph_;
+};
+
+TEST_F(ColocateGathersWithResourcesPassTest, RewritesRemoteGather) {
+  BuildGraph(kPsDevice, kWorkerDevice, /*extra_consumer=*/false);
+  RunPass();
+
+  EXPECT_EQ(FindNode("read"), nullptr);
+  Node* gather = FindNode("gather");
+  ASSERT_NE(gather, nullptr);
+  EXPECT_EQ(gather->type_string(), "ResourceGather");
+  EXPECT_EQ(gather->assigned_device_name(), kPsDevice);
+  DataType dtype;
+  TF_ASSERT_OK(GetNodeAttr(gather->attrs(), "dtype", &dtype));
+  EXPECT_EQ(dtype, DT_FLOAT);
+
+  const Edge* e;
+  TF_ASSERT_OK(gather->input_edge(0, &e));
+  EXPECT_EQ(e->src()->name(), "var");
+  TF_ASSERT_OK(gather->input_edge(1, &e));
+  EXPECT_EQ(e->src()->name(), "indices");
+  TF_ASSERT_OK(FindNode("output")->input_edge(0, &e));
+  EXPECT_EQ(e->src(), gather);
+}
+
+TEST_F(ColocateGathersWithResourcesPassTest, KeepsLocalGather) {
+  BuildGraph(kWorkerDevice, kWorkerDevice, /*extra_consumer=*/false);
+  RunPass();
+
+  EXPECT_NE(FindNode("read"), nullptr);
+  EXPECT_EQ(FindNode("gather")->type_string(), "GatherV2");
+}
+
+TEST_F(ColocateGathersWithResourcesPassTest, KeepsGatherOfSharedRead) {
+  BuildGraph(kPsDevice, kWorkerDevice, /*extra_consumer=*/true);
+  RunPass();
+
+  EXPECT_NE(FindNode("read"), nullptr);
+  EXPECT_EQ(FindNode("gather")->type_string(), "GatherV2");
+  EXPECT_EQ(FindNode("gather")->assigned_device_name(), kWorkerDevice);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -49,6 +49,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
 #include "tensorflow/core/util/port.h"
@@ -176,6 +177,19 @@ Status Member::SetParentAndSupportedDevices(
       types, node.def(), &supported_device_types_, local_address_spec);
 }
 
+Status Member::SetParentAndSupportedDevices(
+    const Node& node,
+    const PrioritizedDeviceTypeVector& supported_device_types) {
+  int id = node.id();
+  if (id < 0) {
+    return errors::Internal("Placer should not be creating a Member for node: ",
+                            node.DebugString());
+  }
+  parent_ = id;
+  supported_device_types_ = supported_device_types;
+  return OkStatus();
+}
+
 Status Member::SetAssignedDeviceName(const string& device_name) {
   if (DeviceNameUtils::HasSomeDetails(requested_device_name_)) {
     return errors::Internal(
@@ -427,6 +441,14 @@ bool Member::MergeSupportedDevices(const Member& other) {
 
 bool Member::MergeSupportedDevices(
     const PrioritizedDeviceTypeVector& other_devices) {
+  // Nodes colocated together usually support the same devices, in which case
+  // the intersection below is the sorted input.
+  if (supported_device_types_ == other_devices) {
+    if (supported_device_types_.empty()) return false;
+    DeviceSet::SortPrioritizedDeviceTypeVector(&supported_device_types_);
+    return true;
+  }
+
   // Generate intersection with priorities.
   // Each vector contains the same device types but with different priorities.
   // The priorities are taken from the corresponding source vector.
@@ -1346,9 +1368,18 @@ Status ColocationGraph::GetDevicesForNode(
     if (device_set_.devices().empty()) {
       return errors::Internal("No devices are registered");
     }
-    devices = FilterSupportedDevices(device_set_.devices(),
-                                     root_member.supported_device_types(),
-                                     default_local_device_);
+    auto it =
+        supported_devices_cache_.find(root_member.supported_device_types());
+    if (it == supported_devices_cache_.end()) {
+      it = supported_devices_cache_
+               .emplace(root_member.supported_device_types(),
+                        FilterSupportedDevices(
+                            device_set_.devices(),
+                            root_member.supported_device_types(),
+                            default_local_device_))
+               .first;
+    }
+    devices = it->second;
 
     if (devices.empty()) {
       return errors::InvalidArgument(
@@ -1492,9 +1523,34 @@ Status ColocationGraph::InitializeMemberWithAssignedDevice(
                           node_type);
 }
 
+/*static*/ uint64 ColocationGraph::SupportedDeviceTypesKey(const Node& node) {
+  uint64 key = Hash64Combine(Hash64(node.type_string()),
+                             Hash64(node.requested_device()));
+  // The attrs are combined in an order-independent way, since the iteration
+  // order of the attr map is unspecified. Tensor-valued attrs (e.g. the value
+  // of a large constant) never select kernels, so they are skipped.
+  uint64 attrs_hash = 0;
+  for (const auto& attr : node.def().attr()) {
+    if (attr.second.has_tensor() || attr.second.list().tensor_size() > 0) {
+      continue;
+    }
+    attrs_hash += Hash64Combine(Hash64(attr.first),
+                                FastAttrValueHash(attr.second));
+  }
+  return Hash64Combine(key, attrs_hash);
+}
+
 Status ColocationGraph::InitializeMember(const Node& node, Member* member) {
-  TF_RETURN_IF_ERROR(member->SetParentAndSupportedDevices(
-      node, device_types_, &local_address_spec_));
+  const uint64 key = SupportedDeviceTypesKey(node);
+  auto it = supported_device_types_cache_.find(key);
+  if (it != supported_device_types_cache_.end()) {
+    TF_RETURN_IF_ERROR(member->SetParentAndSupportedDevices(node, it->second));
+  } else {
+    TF_RETURN_IF_ERROR(member->SetParentAndSupportedDevices(
+        node, device_types_, &local_address_spec_));
+    supported_device_types_cache_.emplace(key,
+                                          member->supported_device_types());
+  }
 
   if (node.has_assigned_device_name()) {
     TF_RETURN_IF_ERROR(InitializeMemberWithAssignedDevice(
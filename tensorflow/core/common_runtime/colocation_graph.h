@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_COLOCATION_GRAPH_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_COLOCATION_GRAPH_H_
 
+#include <map>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/inspecting_placer.h"
@@ -41,6 +43,13 @@ class Member {
       const Node& node, const std::vector<DeviceType>& types,
       const DeviceNameUtils::ParsedName* local_address_spec);
 
+  // Same as above, but uses `supported_device_types`, computed for a node with
+  // the same op, attrs and requested device, instead of looking up the kernel
+  // registrations again.
+  Status SetParentAndSupportedDevices(
+      const Node& node,
+      const PrioritizedDeviceTypeVector& supported_device_types);
+
   const DeviceNameUtils::ParsedName& requested_device_name() const {
     return requested_device_name_;
   }
@@ -362,6 +371,10 @@ class ColocationGraph {
 
   Status InitializeMember(const Node& node, Member* member);
 
+  // Returns a fingerprint of the op, requested device and attrs of `node`,
+  // which determine the device types supported by its kernels.
+  static uint64 SupportedDeviceTypesKey(const Node& node);
+
   // Returns the root node of the disjoint tree to which the node with the
   // given id is connected.
   // FindRoot should be called only for debugging or after the members have
@@ -384,6 +397,15 @@ class ColocationGraph {
   const bool allow_soft_placement_;
   const bool log_device_placement_;
 
+  // Large graphs typically contain many nodes with the same op and attrs, so
+  // the device types supported by a node are cached by
+  // `SupportedDeviceTypesKey()`, and the devices of groups with no requested
+  // device are cached by their supported device types.
+  absl::flat_hash_map<uint64, PrioritizedDeviceTypeVector>
+      supported_device_types_cache_;
+  std::map<PrioritizedDeviceTypeVector, std::vector<Device*>>
+      supported_devices_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ColocationGraph);
 };
 
@@ -17,6 +17,9 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
+#include <numeric>
+#include <atomic>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -39,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/flatset.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/denormal.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -582,6 +586,239 @@ bool ReplaceTensorWithConstant(
   return true;
 }
 
+// Returns the names of the tensors of the constant graph in `tensors_to_fetch`,
+// and the corresponding tensors of the original graph, sorted by name.
+void SortTensorsToFetch(
+    const std::map<NodeAndOutput, NodeAndOutput>& tensors_to_fetch,
+    std::vector<string>* tensors_to_fetch_names,
+    std::vector<NodeAndOutput>* tensors_to_replace) {
+  // Sorting the nodes based on the name gives us a stable ordering between runs
+  // for the same graph.
+  std::vector<std::pair<NodeAndOutput, NodeAndOutput>> tensors_to_fetch_sorted(
+      tensors_to_fetch.begin(), tensors_to_fetch.end());
+  std::sort(tensors_to_fetch_sorted.begin(), tensors_to_fetch_sorted.end(),
+            [](const std::pair<NodeAndOutput, NodeAndOutput>& n1,
+               const std::pair<NodeAndOutput, NodeAndOutput>& n2) {
+              return std::tie(n1.first.first->name(), n1.first.second) <
+                     std::tie(n2.first.first->name(), n2.first.second);
+            });
+  for (auto n : tensors_to_fetch_sorted) {
+    tensors_to_fetch_names->push_back(
+        strings::StrCat(n.first.first->name(), ":", n.first.second));
+    tensors_to_replace->push_back(n.second);
+  }
+}
+
+// Splits the constant foldable `nodes`, in topological order, into groups of
+// weakly connected components of at least `min_group_size` nodes. Each group
+// is in topological order.
+std::vector<std::vector<Node*>> GroupIndependentSubgraphs(
+    const std::vector<Node*>& nodes,
+    const std::unordered_map<const Node*, std::vector<Tensor>>&
+        shape_replacement_map,
+    int min_group_size) {
+  const int num_nodes = nodes.size();
+  std::unordered_map<const Node*, int> node_index;
+  for (int i = 0; i < num_nodes; ++i) node_index[nodes[i]] = i;
+
+  std::vector<int> parent(num_nodes);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find_root = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (int i = 0; i < num_nodes; ++i) {
+    // The in-edges of replaced shape nodes and control edges are not copied
+    // to the constant graph, so they do not connect subgraphs.
+    if (shape_replacement_map.count(nodes[i]) != 0) continue;
+    for (const Edge* in_edge : nodes[i]->in_edges()) {
+      if (in_edge->IsControlEdge()) continue;
+      auto it = node_index.find(in_edge->src());
+      if (it == node_index.end()) continue;
+      parent[find_root(i)] = find_root(it->second);
+    }
+  }
+
+  // Components are ordered by their first node, and their nodes keep the
+  // order of `nodes`, so the grouping is deterministic.
+  std::vector<std::vector<Node*>> components;
+  std::unordered_map<int, int> component_index;
+  for (int i = 0; i < num_nodes; ++i) {
+    const int num_components = components.size();
+    auto it = component_index.emplace(find_root(i), num_components).first;
+    if (it->second == num_components) components.emplace_back();
+    components[it->second].push_back(nodes[i]);
+  }
+
+  // Batch small components together, since every evaluated graph has a fixed
+  // overhead. There are no edges between components, so the concatenation of
+  // components in topological order is in topological order.
+  std::vector<std::vector<Node*>> groups;
+  for (std::vector<Node*>& component : components) {
+    if (groups.empty() ||
+        static_cast<int>(groups.back().size()) >= min_group_size) {
+      groups.emplace_back();
+    }
+    groups.back().insert(groups.back().end(), component.begin(),
+                         component.end());
+  }
+  return groups;
+}
+
+// A constant graph evaluated by `ParallelConstantFold()`.
+struct ConstantFoldTask {
+  std::unique_ptr<Graph> constant_graph;
+  std::vector<string> tensors_to_fetch_names;
+  std::vector<NodeAndOutput> tensors_to_replace;
+
+  enum State { kPending, kRunning, kDone };
+  // Becomes `kDone` while holding the mutex of `ParallelConstantFold()`.
+  std::atomic<int> state{kPending};
+  Status status;
+  std::vector<Tensor> outputs;
+  int64_t output_bytes = 0;
+};
+
+// Evaluates the independent subgraphs of the constant foldable `nodes`
+// concurrently on `opts.thread_pool`, and replaces the fetched tensors with
+// constants in the order of the subgraphs.
+//
+// The calling thread evaluates the next subgraph to replace itself if no
+// worker has started it, so this makes progress even if it runs on a thread of
+// `opts.thread_pool`.
+Status ParallelConstantFold(
+    const ConstantFoldingOptions& opts,
+    FunctionLibraryRuntime* function_library, Env* env,
+    const Device* partition_device, Graph* graph,
+    const std::vector<Node*>& nodes,
+    std::unordered_map<const Node*, gtl::FlatSet<Node*>>* constant_control_deps,
+    const std::unordered_map<const Node*, std::vector<Tensor>>&
+        shape_replacement_map,
+    const ConstantFoldNameGenerator& generate_new_name, bool* was_mutated) {
+  thread::ThreadPool* const pool = opts.thread_pool;
+  // Aim for a few subgraphs per thread, for load balancing.
+  const int max_tasks_ahead = 2 * pool->NumThreads();
+  const int min_group_size =
+      std::max<int>(1, nodes.size() / (2 * max_tasks_ahead));
+
+  std::vector<std::unique_ptr<ConstantFoldTask>> tasks;
+  for (const std::vector<Node*>& group :
+       GroupIndependentSubgraphs(nodes, shape_replacement_map,
+                                 min_group_size)) {
+    auto task = std::make_unique<ConstantFoldTask>();
+    std::map<NodeAndOutput, NodeAndOutput> tensors_to_fetch;
+    task->constant_graph.reset(GetConstantGraph(graph, group,
+                                                shape_replacement_map,
+                                                &tensors_to_fetch,
+                                                generate_new_name));
+    if (tensors_to_fetch.empty()) continue;
+    SortTensorsToFetch(tensors_to_fetch, &task->tensors_to_fetch_names,
+                       &task->tensors_to_replace);
+    tasks.push_back(std::move(task));
+  }
+  VLOG(1) << "Constant folding " << nodes.size() << " nodes in "
+          << tasks.size() << " independent subgraphs";
+
+  // The output tensors share lifetime with the GraphRunner, so they are
+  // cleared before it is deleted.
+  GraphRunner graph_runner(env);
+  auto clear_outputs = gtl::MakeCleanup([&tasks] {
+    for (auto& task : tasks) task->outputs.clear();
+  });
+
+  mutex mu;
+  condition_variable cv;
+  int64_t in_flight_bytes = 0;
+  int num_scheduled_closures = 0;
+
+  auto run_task = [&](ConstantFoldTask* task) {
+    int expected = ConstantFoldTask::kPending;
+    if (!task->state.compare_exchange_strong(expected,
+                                             ConstantFoldTask::kRunning)) {
+      return;
+    }
+    port::ScopedFlushDenormal flush;
+    port::ScopedSetRound round(FE_TONEAREST);
+    task->status = graph_runner.Run(task->constant_graph.get(),
+                                    function_library, {} /* inputs*/,
+                                    task->tensors_to_fetch_names,
+                                    &task->outputs);
+    for (const Tensor& output : task->outputs) {
+      task->output_bytes += output.TotalBytes();
+    }
+    mutex_lock l(mu);
+    in_flight_bytes += task->output_bytes;
+    task->state = ConstantFoldTask::kDone;
+    cv.notify_all();
+  };
+
+  const int num_tasks = tasks.size();
+  int next_to_schedule = 0;
+  int32_t num_nodes_replaced = 0;
+  Status status;
+  for (int i = 0; i < num_tasks; ++i) {
+    ConstantFoldTask* task = tasks[i].get();
+    {
+      mutex_lock l(mu);
+      while (next_to_schedule < num_tasks &&
+             next_to_schedule - i < max_tasks_ahead &&
+             in_flight_bytes < opts.max_in_flight_constant_bytes) {
+        ConstantFoldTask* scheduled = tasks[next_to_schedule++].get();
+        ++num_scheduled_closures;
+        pool->Schedule([&, scheduled]() {
+          run_task(scheduled);
+          mutex_lock lock(mu);
+          --num_scheduled_closures;
+          cv.notify_all();
+        });
+      }
+    }
+    run_task(task);
+    {
+      mutex_lock l(mu);
+      while (task->state != ConstantFoldTask::kDone) cv.wait(l);
+    }
+    if (!task->status.ok()) {
+      VLOG(1) << "Could not fetch constants: " << task->status;
+      status = task->status;
+      break;
+    }
+
+    for (size_t c = 0; c < task->outputs.size(); ++c) {
+      const gtl::FlatSet<Node*>& control_deps =
+          (*constant_control_deps)[task->tensors_to_replace[c].first];
+      if (ReplaceTensorWithConstant(graph, partition_device,
+                                    task->tensors_to_replace[c],
+                                    task->outputs[c], control_deps,
+                                    opts.max_constant_size_in_bytes,
+                                    generate_new_name)) {
+        ++num_nodes_replaced;
+      }
+    }
+    task->outputs.clear();
+    task->constant_graph.reset();
+    mutex_lock l(mu);
+    in_flight_bytes -= task->output_bytes;
+  }
+
+  // Wait for the scheduled closures, which refer to the local variables, after
+  // preventing the tasks that have not started from running.
+  for (auto& task : tasks) {
+    int expected = ConstantFoldTask::kPending;
+    task->state.compare_exchange_strong(expected, ConstantFoldTask::kDone);
+  }
+  {
+    mutex_lock l(mu);
+    while (num_scheduled_closures > 0) cv.wait(l);
+  }
+
+  *was_mutated = (num_nodes_replaced > 0);
+  return status;
+}
+
 }  // namespace
 
 Status ConstantFold(const ConstantFoldingOptions& opts,
@@ -616,6 +853,15 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
     return OkStatus();
   }
 
+  if (opts.thread_pool != nullptr) {
+    Status s = ParallelConstantFold(
+        opts, function_library, env, partition_device, graph,
+        constant_foldable_nodes, &constant_control_deps, shape_replacement_map,
+        generate_new_name, was_mutated);
+    DumpGraph("After", graph);
+    return s;
+  }
+
   std::map<NodeAndOutput, NodeAndOutput> tensors_to_fetch;
   std::unique_ptr<Graph> constant_graph(
       GetConstantGraph(graph, constant_foldable_nodes, shape_replacement_map,
@@ -633,21 +879,8 @@ Status ConstantFold(const ConstantFoldingOptions& opts,
 
   std::vector<string> tensors_to_fetch_names;
   std::vector<NodeAndOutput> tensors_to_replace;
-  // Sorting the nodes based on the name gives us a stable ordering between runs
-  // for the same graph.
-  std::vector<std::pair<NodeAndOutput, NodeAndOutput>> tensors_to_fetch_sorted(
-      tensors_to_fetch.begin(), tensors_to_fetch.end());
-  std::sort(tensors_to_fetch_sorted.begin(), tensors_to_fetch_sorted.end(),
-            [](const std::pair<NodeAndOutput, NodeAndOutput>& n1,
-               const std::pair<NodeAndOutput, NodeAndOutput>& n2) {
-              return std::tie(n1.first.first->name(), n1.first.second) <
-                     std::tie(n2.first.first->name(), n2.first.second);
-            });
-  for (auto n : tensors_to_fetch_sorted) {
-    tensors_to_fetch_names.push_back(
-        strings::StrCat(n.first.first->name(), ":", n.first.second));
-    tensors_to_replace.push_back(n.second);
-  }
+  SortTensorsToFetch(tensors_to_fetch, &tensors_to_fetch_names,
+                     &tensors_to_replace);
 
   auto graph_runner = std::unique_ptr<GraphRunner>(new GraphRunner(env));
   // Evaluate the constant foldable nodes.
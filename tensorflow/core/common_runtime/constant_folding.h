@@ -25,6 +25,9 @@ limitations under the License.
 // TODO(skyewm): can this be combined with EvaluateConstantTensor?
 
 namespace tensorflow {
+namespace thread {
+class ThreadPool;
+}  // namespace thread
 
 // This generator type is used to generate a name for the newly folded node
 // based on the node's old name.
@@ -49,6 +52,14 @@ struct ConstantFoldingOptions {
   // default id generator that monotonically increases is used if nullptr is
   // passed.
   ConstantFoldNameGenerator generate_new_name = nullptr;
+  // If not nullptr, independent constant foldable subgraphs are evaluated
+  // concurrently on this threadpool. Otherwise, all the constant foldable
+  // nodes are evaluated in a single graph on the calling thread.
+  thread::ThreadPool* thread_pool = nullptr;  // not owned
+  // When evaluating on `thread_pool`, no new subgraph is started while the
+  // folded constants that are waiting to be inserted into the graph exceed
+  // this size in bytes.
+  int64_t max_in_flight_constant_bytes = 256 * 1024 * 1024;
 };
 
 // Perform constant folding optimization on "graph".
@@ -134,6 +134,41 @@ TEST_F(ConstantFoldingTest, Basic) {
                          {2, 2});
 }
 
+TEST_F(ConstantFoldingTest, ParallelIndependentSubgraphs) {
+  constexpr int kNumSubgraphs = 50;
+  thread::ThreadPool pool(Env::Default(), "constant_folding", 4);
+  // The second configuration allows a single folded constant in flight.
+  for (int64_t max_in_flight_bytes : {int64_t{256 << 20}, int64_t{1}}) {
+    Scope s = Scope::NewRootScope();
+    for (int i = 0; i < kNumSubgraphs; ++i) {
+      auto a = ops::Const<float>(s, {1.0, 0.0, 0.0, 1.0}, {2, 2});
+      auto b = ops::Const<float>(s, {1.0, 2.0, 3.0, static_cast<float>(i)},
+                                 {2, 2});
+      auto m = ops::MatMul(s, a, b);
+      ops::_Send(s.WithOpName(strings::StrCat("s", i)), m,
+                 strings::StrCat("m", i), "sender", 0, "receiver");
+    }
+    Graph g(OpRegistry::Global());
+    TF_ASSERT_OK(s.ToGraph(&g));
+
+    ConstantFoldingOptions opts;
+    opts.thread_pool = &pool;
+    opts.max_in_flight_constant_bytes = max_in_flight_bytes;
+    bool was_mutated;
+    TF_ASSERT_OK(
+        ConstantFold(opts, nullptr, Env::Default(), nullptr, &g, &was_mutated));
+    EXPECT_TRUE(was_mutated);
+
+    std::unordered_map<string, Node*> index = g.BuildNodeNameIndex();
+    for (int i = 0; i < kNumSubgraphs; ++i) {
+      Node* send = index.at(strings::StrCat("s", i));
+      EXPECT_EQ(1, send->num_inputs());
+      ExpectNodeClose<float>(*(send->in_nodes().begin()),
+                             {1.0, 2.0, 3.0, static_cast<float>(i)}, {2, 2});
+    }
+  }
+}
+
 // Tests that different node creation ordering creates same graph after constant
 // folding.
 TEST_F(ConstantFoldingTest, DeterministicFolding) {
@@ -22,6 +22,7 @@ namespace tensorflow {
 inline constexpr char kTpuCostName[] = "tpu";
 inline constexpr char kGcuCostName[] = "gcu";
 inline constexpr char kNoOpCostName[] = "no_op";
+inline constexpr char kCpuCostName[] = "cpu";
 
 // Each type of per-request cost could have the following versions.
 //
@@ -36,6 +37,8 @@ inline constexpr char kTpuWithSmearCostName[] = "tpu_with_smear";
 inline constexpr char kTpuNoSmearCostName[] = "tpu_no_smear";
 inline constexpr char kGcuWithSmearCostName[] = "gcu_with_smear";
 inline constexpr char kGcuNoSmearCostName[] = "gcu_no_smear";
+inline constexpr char kCpuWithSmearCostName[] = "cpu_with_smear";
+inline constexpr char kCpuNoSmearCostName[] = "cpu_no_smear";
 
 }  // namespace tensorflow
 
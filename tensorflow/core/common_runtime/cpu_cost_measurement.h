@@ -0,0 +1,51 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_CPU_COST_MEASUREMENT_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_CPU_COST_MEASUREMENT_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/common_runtime/cost_measurement.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+
+// Measures the CPU time added to the `thread::CpuTimeAccumulator` that is
+// current on the thread creating the measurement, from its creation until
+// `GetTotalCost()` is called. This includes the CPU time of the closures run
+// on inter-op and intra-op thread pools on behalf of the accumulator, e.g. the
+// kernels of a batch function and the shards of their Eigen expressions.
+//
+// The caller that owns the per-query or per-batch context must make an
+// accumulator current with a `thread::ScopedCpuTimeAccumulator`. If no
+// accumulator is current, the total cost is always zero.
+class CpuCostMeasurement : public CostMeasurement {
+ public:
+  explicit CpuCostMeasurement(const Context& context);
+
+  absl::Duration GetTotalCost() override;
+  absl::string_view GetCostType() const override;
+
+ private:
+  const std::shared_ptr<thread::CpuTimeAccumulator> accumulator_;
+  const int64_t start_nanos_;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_CPU_COST_MEASUREMENT_H_
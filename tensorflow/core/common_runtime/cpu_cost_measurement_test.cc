@@ -0,0 +1,73 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/cpu_cost_measurement.h"
+
+#include <memory>
+
+#include "absl/time/time.h"
+#include "tensorflow/core/common_runtime/cost_measurement.h"
+#include "tensorflow/core/common_runtime/cost_measurement_registry.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(CpuCostMeasurementTest, NoAccumulator) {
+  CostMeasurement::Context context;
+  CpuCostMeasurement measurement(context);
+  EXPECT_EQ(measurement.GetTotalCost(), absl::ZeroDuration());
+  EXPECT_EQ(measurement.GetCostType(), "cpu");
+}
+
+TEST(CpuCostMeasurementTest, Registered) {
+  CostMeasurement::Context context;
+  std::unique_ptr<CostMeasurement> measurement =
+      CostMeasurementRegistry::CreateByNameOrNull("cpu", context);
+  ASSERT_NE(measurement, nullptr);
+  EXPECT_EQ(measurement->GetCostType(), "cpu");
+}
+
+TEST(CpuCostMeasurementTest, MeasuresClosuresOnThreadPool) {
+  // The per-thread CPU clock is not available on all platforms.
+  if (thread::CpuTimeAccumulator::ThreadCpuNanos() == 0) return;
+  constexpr int64_t kSpinNanos = 10 * 1000 * 1000;
+  auto accumulator = std::make_shared<thread::CpuTimeAccumulator>();
+  // Time added before the measurement is created is not part of its cost.
+  accumulator->Add(kSpinNanos);
+
+  CostMeasurement::Context context;
+  thread::ScopedCpuTimeAccumulator scope(accumulator);
+  CpuCostMeasurement measurement(context);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 2);
+    for (int i = 0; i < 2; ++i) {
+      pool.Schedule([]() {
+        const int64_t start = thread::CpuTimeAccumulator::ThreadCpuNanos();
+        while (thread::CpuTimeAccumulator::ThreadCpuNanos() - start <
+               kSpinNanos) {
+        }
+      });
+    }
+  }
+  EXPECT_GE(measurement.GetTotalCost(), absl::Nanoseconds(2 * kSpinNanos));
+  EXPECT_EQ(measurement.GetTotalCost(),
+            absl::Nanoseconds(accumulator->total_nanos() - kSpinNanos));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/device/device_event_mgr.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/platform/stacktrace.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -28,6 +32,11 @@ namespace {
 //  - Should EventMgrs be shared between devices on a machine with multiple
 //  devices of the same type?
 static const int kNumThreads = 2;
+
+// While the oldest pending event stays pending, the polling loop doubles its
+// delay between polls, up to this multiple of polling_active_delay_usecs, so
+// that it does not spin on long running work.
+static const int kMaxPollingBackoff = 8;
 }  // namespace
 
 namespace device_event_mgr {
@@ -97,10 +106,20 @@ EventMgr::EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options)
                                       : 10),
       threadpool_(Env::Default(), "Device_Event_Manager", kNumThreads) {
   device_event_mgr::InitThreadpoolLabels(&threadpool_);
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS",
+                                 /*default_val=*/false, &use_host_callbacks_));
+  // Even with host callbacks, streams in an error state fall back to events,
+  // so the polling loop still runs.  It sleeps while no event is queued.
   StartPollingLoop();
 }
 
 EventMgr::~EventMgr() {
+  {
+    mutex_lock l(mu_);
+    while (pending_host_callbacks_ > 0) {
+      host_callbacks_done_.wait(l);
+    }
+  }
   StopPollingLoop();
 
   // Events are owned by this object.
@@ -141,8 +160,13 @@ void EventMgr::StopPollingLoop() {
 //
 // While one or more events is outstanding, poll for completed events.  When no
 // events are outstanding, we sleep until one is enqueued.
+//
+// The delay between polls starts at polling_active_delay_usecs_ and backs off
+// exponentially, up to kMaxPollingBackoff times that, while no event
+// completes.
 void EventMgr::PollLoop() {
   ToFreeVector to_free;
+  int64_t delay_usecs = polling_active_delay_usecs_;
   while (true) {
     bool events_still_pending;
     {
@@ -156,11 +180,16 @@ void EventMgr::PollLoop() {
       PollEvents(true, &to_free);
       events_still_pending = !used_events_.empty();
     }
+    if (!to_free.empty() || !events_still_pending) {
+      delay_usecs = polling_active_delay_usecs_;
+    }
     FreeMemory(to_free);
     to_free.clear();
 
     if (events_still_pending) {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+      Env::Default()->SleepForMicroseconds(delay_usecs);
+      delay_usecs = std::min<int64_t>(
+          2 * delay_usecs, kMaxPollingBackoff * polling_active_delay_usecs_);
     }
   }
   polling_stopped_->Notify();
@@ -243,6 +272,37 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
   }
 }
 
+/* static */ void EventMgr::RecordCompletionLatency(bool host_callback,
+                                                   uint64 latency_usecs) {
+  static const string* const kPolling = new string("polling");
+  static const string* const kHostCallback = new string("host_callback");
+  metrics::UpdateDeviceEventCompletionLatency(
+      host_callback ? *kHostCallback : *kPolling, latency_usecs);
+}
+
+void EventMgr::ThenExecuteHostCallback(se::Stream* stream,
+                                       std::function<void()> func) {
+  {
+    mutex_lock l(mu_);
+    ++pending_host_callbacks_;
+  }
+  const uint64 queued_micros = Env::Default()->NowMicros();
+  // The callback runs on a driver thread, which must not call back into the
+  // device API, so func itself runs on threadpool_.
+  stream->ThenDoHostCallback(
+      [this, func = std::move(func), queued_micros]() mutable {
+        RecordCompletionLatency(/*host_callback=*/true,
+                                Env::Default()->NowMicros() - queued_micros);
+        if (func != nullptr) threadpool_.Schedule(std::move(func));
+        mutex_lock l(mu_);
+        if (--pending_host_callbacks_ == 0) {
+          host_callbacks_done_.notify_all();
+        }
+      });
+  // As with events that fail to record, there is no way to recover func.
+  CHECK(stream->ok()) << "Failed to entrain an EventMgr host callback";
+}
+
 EventMgrFactory* EventMgrFactory::Singleton() {
   static EventMgrFactory* instance = new EventMgrFactory;
   return instance;
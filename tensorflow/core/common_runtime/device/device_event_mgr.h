@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -71,6 +72,10 @@ class EventMgr {
   // func must be brief and non-blocking since it executes in the one
   // thread used for all such callbacks and also buffer deletions.
   inline void ThenExecute(se::Stream* stream, std::function<void()> func) {
+    if (use_host_callbacks_ && stream->ok()) {
+      ThenExecuteHostCallback(stream, std::move(func));
+      return;
+    }
     ToFreeVector to_free;
     {
       mutex_lock l(mu_);
@@ -86,12 +91,17 @@ class EventMgr {
   friend class EventMgrFactory;
   se::StreamExecutor* const exec_;
   const int32 polling_active_delay_usecs_;
+  // If true, completions are signaled by stream host callbacks instead of
+  // being polled for.  Set from TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS.
+  bool use_host_callbacks_ = false;
   mutex mu_;
   condition_variable events_pending_ TF_GUARDED_BY(mu_);
 
   struct InUse {
     se::Event* event;
     std::function<void()> func;
+    // Env::NowMicros() when func was queued, to export completion latency.
+    uint64 queued_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
@@ -99,12 +109,25 @@ class EventMgr {
   EventMgr(se::StreamExecutor* se, const GPUOptions& gpu_options);
 
   void FreeMemory(const ToFreeVector& to_free) {
+    if (to_free.empty()) return;
+    const uint64 now_micros = Env::Default()->NowMicros();
     for (const auto& iu : to_free) {
+      RecordCompletionLatency(/*host_callback=*/false,
+                              now_micros - iu.queued_micros);
       // The function must be called in another thread.
       if (iu.func != nullptr) threadpool_.Schedule(iu.func);
     }
   }
 
+  // Exports the delay between queueing a func and its dispatch.
+  static void RecordCompletionLatency(bool host_callback,
+                                      uint64 latency_usecs);
+
+  // Entrains a host callback onto stream that hands func to threadpool_, so
+  // that func is dispatched as soon as the device reaches it rather than at
+  // the next poll.
+  void ThenExecuteHostCallback(se::Stream* stream, std::function<void()> func);
+
   // Stream-enqueue an unused Event and save with it a collection of
   // Tensors and/or a BufRec to be deleted only after the Event
   // records.
@@ -113,7 +136,8 @@ class EventMgr {
 
   void QueueFunc(se::Stream* stream, std::function<void()> func)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, std::move(func)});
+    QueueInUse(stream,
+               {nullptr, std::move(func), Env::Default()->NowMicros()});
   }
 
   // This function should be called at roughly the same tempo as
@@ -138,6 +162,10 @@ class EventMgr {
   // A FIFO queue of InUse events and associated tensors.
   std::deque<InUse> used_events_ TF_GUARDED_BY(mu_);
 
+  // The number of host callbacks entrained but not yet run.
+  int64_t pending_host_callbacks_ TF_GUARDED_BY(mu_) = 0;
+  condition_variable host_callbacks_done_ TF_GUARDED_BY(mu_);
+
   bool stop_polling_ TF_GUARDED_BY(mu_);
   std::unique_ptr<Notification> polling_stopped_;
 
@@ -138,6 +138,34 @@ TEST(EventMgr, WarnIfInCallback) {
   note.WaitForNotification();
   EXPECT_TRUE(hit);
 }
+
+// Tests that with host callbacks, funcs run without polling or any event.
+TEST(EventMgr, HostCallbacks) {
+  setenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS", "true", 1);
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  TEST_EventMgr em(stream_exec, GPUOptions());
+  unsetenv("TF_GPU_EVENT_MGR_USE_HOST_CALLBACKS");
+  TEST_EventMgrHelper th(&em);
+  std::unique_ptr<se::Stream> stream(new se::Stream(stream_exec));
+  CHECK(stream);
+  stream->Init();
+  se::DeviceMemory<float> mem = stream_exec->AllocateArray<float>(1 << 20);
+  constexpr int kNumFuncs = 16;
+  std::atomic_int_fast64_t num_done(0);
+  Notification note;
+  for (int i = 0; i < kNumFuncs; ++i) {
+    stream->ThenMemZero(&mem, mem.size());
+    em.ThenExecute(stream.get(), [&num_done, &note]() {
+      if (++num_done == kNumFuncs) note.Notify();
+    });
+  }
+  note.WaitForNotification();
+  EXPECT_EQ(kNumFuncs, num_done);
+  EXPECT_EQ(0, th.queue_size());
+  EXPECT_EQ(0, th.free_size());
+  TF_ASSERT_OK(stream->BlockHostUntilDone());
+  stream_exec->Deallocate(&mem);
+}
 }  // namespace
 
 // Provides access to private resources of BaseGPUDevice.
@@ -0,0 +1,104 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/device/prefetching_sub_allocator.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+PrefetchingSubAllocator::PrefetchingSubAllocator(
+    std::unique_ptr<SubAllocator> sub_allocator, int numa_node,
+    size_t max_prefetch_bytes)
+    : SubAllocator({}, {}),
+      sub_allocator_(std::move(sub_allocator)),
+      numa_node_(numa_node),
+      max_prefetch_bytes_(max_prefetch_bytes),
+      thread_(new thread::ThreadPool(Env::Default(),
+                                     "prefetching_sub_allocator",
+                                     /*num_threads=*/1)) {}
+
+PrefetchingSubAllocator::~PrefetchingSubAllocator() {
+  mutex_lock l(mu_);
+  while (pending_bytes_ > 0) {
+    prefetch_done_.wait(l);
+  }
+  FreePrefetched();
+}
+
+void* PrefetchingSubAllocator::Alloc(size_t alignment, size_t num_bytes,
+                                     size_t* bytes_received) {
+  if (num_bytes == 0) {
+    return sub_allocator_->Alloc(alignment, num_bytes, bytes_received);
+  }
+  mutex_lock l(mu_);
+  // Wait for the region being prefetched if it has the requested size.
+  while (pending_bytes_ == num_bytes) {
+    prefetch_done_.wait(l);
+  }
+  void* ptr;
+  if (prefetched_ != nullptr && prefetched_bytes_ == num_bytes) {
+    ptr = prefetched_;
+    *bytes_received = prefetched_bytes_;
+    prefetched_ = nullptr;
+    prefetched_bytes_ = 0;
+    VLOG(2) << "Returning a prefetched region of " << num_bytes << " bytes";
+  } else {
+    FreePrefetched();
+    ptr = sub_allocator_->Alloc(alignment, num_bytes, bytes_received);
+  }
+  if (ptr != nullptr && pending_bytes_ == 0 &&
+      2 * *bytes_received <= max_prefetch_bytes_) {
+    Prefetch(alignment, 2 * *bytes_received);
+  }
+  return ptr;
+}
+
+void PrefetchingSubAllocator::Free(void* ptr, size_t num_bytes) {
+  sub_allocator_->Free(ptr, num_bytes);
+}
+
+void PrefetchingSubAllocator::Prefetch(size_t alignment, size_t num_bytes) {
+  pending_bytes_ = num_bytes;
+  thread_->Schedule([this, alignment, num_bytes]() {
+    if (numa_node_ != port::kNUMANoAffinity) {
+      port::NUMASetThreadNodeAffinity(numa_node_);
+    }
+    size_t bytes_received;
+    void* ptr = sub_allocator_->Alloc(alignment, num_bytes, &bytes_received);
+    mutex_lock l(mu_);
+    pending_bytes_ = 0;
+    if (ptr != nullptr) {
+      FreePrefetched();
+      prefetched_ = ptr;
+      prefetched_bytes_ = bytes_received;
+    }
+    prefetch_done_.notify_all();
+  });
+}
+
+void PrefetchingSubAllocator::FreePrefetched() {
+  if (prefetched_ != nullptr) {
+    sub_allocator_->Free(prefetched_, prefetched_bytes_);
+    prefetched_ = nullptr;
+    prefetched_bytes_ = 0;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,89 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_PREFETCHING_SUB_ALLOCATOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_PREFETCHING_SUB_ALLOCATOR_H_
+
+#include <memory>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+
+// A SubAllocator that allocates the next region of another SubAllocator on a
+// background thread, so that a growing BFCAllocator does not wait for it.
+//
+// This is meant for pinned host memory, whose allocation is slow because the
+// driver pins every page. After each allocation of `n` bytes, a region of
+// `2 * n` bytes is allocated in the background, which is the size that a
+// growing BFCAllocator asks for next, unless it is larger than
+// `max_prefetch_bytes`. The next allocation of that size returns the region;
+// one of another size frees it and allocates synchronously instead, so that
+// the caller never receives more memory than it asked for.
+//
+// The background thread is bound to `numa_node`, so that the prefetched
+// regions are first touched there.
+class PrefetchingSubAllocator : public SubAllocator {
+ public:
+  PrefetchingSubAllocator(std::unique_ptr<SubAllocator> sub_allocator,
+                          int numa_node, size_t max_prefetch_bytes);
+  ~PrefetchingSubAllocator() override;
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override;
+
+  void Free(void* ptr, size_t num_bytes) override;
+
+  bool SupportsCoalescing() const override {
+    return sub_allocator_->SupportsCoalescing();
+  }
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return sub_allocator_->GetMemoryType();
+  }
+
+ private:
+  // Starts allocating a region of `num_bytes` in the background.
+  void Prefetch(size_t alignment, size_t num_bytes)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Frees the prefetched region, if any.
+  void FreePrefetched() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<SubAllocator> sub_allocator_;
+  const int numa_node_;
+  const size_t max_prefetch_bytes_;
+
+  mutex mu_;
+  condition_variable prefetch_done_;
+  // Size of the region being allocated in the background, or 0.
+  size_t pending_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // The prefetched region, if not null.
+  void* prefetched_ TF_GUARDED_BY(mu_) = nullptr;
+  size_t prefetched_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  // Declared last, so that it is destroyed first.
+  std::unique_ptr<thread::ThreadPool> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PrefetchingSubAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_DEVICE_PREFETCHING_SUB_ALLOCATOR_H_
@@ -0,0 +1,108 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/device/prefetching_sub_allocator.h"
+
+#include <atomic>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+struct Counts {
+  std::atomic<int> num_allocs{0};
+  std::atomic<int> num_live{0};
+};
+
+// Allocates aligned host memory and counts the allocations.
+class CountingSubAllocator : public SubAllocator {
+ public:
+  explicit CountingSubAllocator(Counts* counts)
+      : SubAllocator({}, {}), counts_(counts) {}
+
+  void* Alloc(size_t alignment, size_t num_bytes,
+              size_t* bytes_received) override {
+    ++counts_->num_allocs;
+    ++counts_->num_live;
+    *bytes_received = num_bytes;
+    return port::AlignedMalloc(num_bytes, 64);
+  }
+
+  void Free(void* ptr, size_t num_bytes) override {
+    --counts_->num_live;
+    port::AlignedFree(ptr);
+  }
+
+  bool SupportsCoalescing() const override { return false; }
+
+ private:
+  Counts* counts_;
+};
+
+TEST(PrefetchingSubAllocatorTest, ReturnsPrefetchedRegions) {
+  Counts counts;
+  PrefetchingSubAllocator allocator(
+      absl::make_unique<CountingSubAllocator>(&counts), port::kNUMANoAffinity,
+      /*max_prefetch_bytes=*/2048);
+  size_t bytes_received;
+  void* first = allocator.Alloc(64, 1024, &bytes_received);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(bytes_received, 1024);
+
+  // The next region of 2048 bytes was allocated in the background.
+  void* second = allocator.Alloc(64, 2048, &bytes_received);
+  ASSERT_NE(second, nullptr);
+  EXPECT_EQ(bytes_received, 2048);
+  EXPECT_EQ(counts.num_allocs, 2);
+
+  // The next one would exceed max_prefetch_bytes, so is not prefetched.
+  void* third = allocator.Alloc(64, 4096, &bytes_received);
+  ASSERT_NE(third, nullptr);
+  EXPECT_EQ(bytes_received, 4096);
+  EXPECT_EQ(counts.num_allocs, 3);
+
+  allocator.Free(first, 1024);
+  allocator.Free(second, 2048);
+  allocator.Free(third, 4096);
+  EXPECT_EQ(counts.num_live, 0);
+}
+
+TEST(PrefetchingSubAllocatorTest, FreesUnusedRegions) {
+  Counts counts;
+  {
+    PrefetchingSubAllocator allocator(
+        absl::make_unique<CountingSubAllocator>(&counts),
+        port::kNUMANoAffinity, /*max_prefetch_bytes=*/1 << 20);
+    size_t bytes_received;
+    void* first = allocator.Alloc(64, 1024, &bytes_received);
+    ASSERT_NE(first, nullptr);
+    // A request of another size does not use the prefetched region.
+    void* second = allocator.Alloc(64, 1000, &bytes_received);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(bytes_received, 1000);
+    allocator.Free(first, 1024);
+    allocator.Free(second, 1000);
+  }
+  // The last prefetched region is freed with the allocator.
+  EXPECT_EQ(counts.num_live, 0);
+}
+
+}  // namespace
+}  // namespace tensorflow
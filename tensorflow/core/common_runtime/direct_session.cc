@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -334,6 +335,19 @@ DirectSession::DirectSession(const SessionOptions& options,
           &owned));
       thread_pools_.emplace_back(pool, owned);
     }
+  } else if (UseNUMAThreadPools(options_)) {
+    // Pin the session to one NUMA node, so that its inter op threads and
+    // the tensors it feeds and fetches stay local to that node.
+    numa_node_ = NextNUMANode();
+    VLOG(1) << "Pinning session to NUMA node " << numa_node_;
+    if (options_.config.use_per_session_threads()) {
+      thread_pools_.emplace_back(
+          NewThreadPoolFromSessionOptions(options_, numa_node_),
+          true /* owned */);
+    } else {
+      thread_pools_.emplace_back(NUMAComputePool(options_, numa_node_),
+                                 false /* owned */);
+    }
   } else if (options_.config.use_per_session_threads()) {
     thread_pools_.emplace_back(NewThreadPoolFromSessionOptions(options_),
                                true /* owned */);
@@ -382,6 +396,17 @@ DirectSession::DirectSession(const SessionOptions& options,
     }
     ++devices_added;
   }
+  if (numa_node_ != port::kNUMANoAffinity) {
+    // Feed and fetch through the CPU device of the session's NUMA node, if
+    // there is one.
+    for (Device* d : devices_) {
+      if (d->device_type() == DEVICE_CPU &&
+          d->attributes().locality().numa_node() == numa_node_) {
+        device_set_.set_client_device(d);
+        break;
+      }
+    }
+  }
 }
 
 DirectSession::~DirectSession() {
@@ -730,6 +755,18 @@ Status DirectSession::RunInternal(
         }
       };
 
+  // Attributes the CPU time of the closures scheduled for this step, and of
+  // the closures they schedule in turn, to `cpu_time_accumulator`. The time is
+  // also added to the accumulator of the caller, if any.
+  std::shared_ptr<thread::CpuTimeAccumulator> cpu_time_accumulator;
+  absl::optional<thread::ScopedCpuTimeAccumulator> cpu_time_scope;
+  if (run_metadata != nullptr &&
+      run_options.experimental().collect_cpu_time()) {
+    cpu_time_accumulator = std::make_shared<thread::CpuTimeAccumulator>(
+        thread::CpuTimeAccumulator::Current());
+    cpu_time_scope.emplace(cpu_time_accumulator);
+  }
+
   if (can_execute_synchronously) {
     PrivateIntraProcessRendezvous rendezvous(device_mgr_.get());
     args.rendezvous = &rendezvous;
@@ -771,6 +808,11 @@ Status DirectSession::RunInternal(
     run_status.Update(errors::Cancelled("Run call was cancelled"));
   }
 
+  if (cpu_time_accumulator != nullptr) {
+    cpu_time_scope.reset();
+    run_metadata->set_cpu_time_nanos(cpu_time_accumulator->total_nanos());
+  }
+
   if (device_profiler_session) {
     TF_RETURN_IF_ERROR(device_profiler_session->CollectData(
         run_metadata->mutable_step_stats()));
@@ -1688,6 +1730,7 @@ Status DirectSession::CreateGraphs(
 
   std::unordered_map<string, GraphDef> partitions;
   TF_RETURN_IF_ERROR(Partition(popts, &client_graph->graph, &partitions));
+  AssignRendezvousSlots(&partitions);
 
   std::vector<string> device_names;
   for (auto device : devices_) {
@@ -801,6 +801,35 @@ TEST_F(DirectSessionMinusAXTest, UseRunHandlerPool) {
   EXPECT_FLOAT_EQ(5.0, mat(0, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, CollectCpuTime) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<Tensor> outputs;
+
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(session->Run(RunOptions(), {}, output_names, {}, &outputs,
+                            &run_metadata));
+  EXPECT_EQ(run_metadata.cpu_time_nanos(), 0);
+
+  // The CPU time of the step is also added to the accumulator of the caller.
+  auto caller_accumulator = std::make_shared<thread::CpuTimeAccumulator>();
+  RunOptions run_options;
+  run_options.mutable_experimental()->set_collect_cpu_time(true);
+  {
+    thread::ScopedCpuTimeAccumulator scope(caller_accumulator);
+    TF_ASSERT_OK(session->Run(run_options, {}, output_names, {}, &outputs,
+                              &run_metadata));
+  }
+  EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+  if (thread::CpuTimeAccumulator::ThreadCpuNanos() > 0) {
+    EXPECT_GT(run_metadata.cpu_time_nanos(), 0);
+  }
+  EXPECT_GE(caller_accumulator->total_nanos(), run_metadata.cpu_time_nanos());
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -87,6 +87,18 @@ bool ReadBoolFromEnvVar(StringPiece env_var_name, bool default_val) {
   return default_val;
 }
 
+// Maximum number of independent nodes that the default executor runs
+// concurrently in async mode. The default of 1 runs nodes in order.
+int64_t MaxConcurrentAsyncNodes() {
+  int64_t val;
+  if (tensorflow::ReadInt64FromEnvVar("TF_EAGER_ASYNC_MAX_CONCURRENT_NODES", 1,
+                                      &val)
+          .ok()) {
+    return val;
+  }
+  return 1;
+}
+
 auto* eager_context_created =
     monitoring::Gauge<bool, 0>::New("/tensorflow/core/eager_context_created",
                                     "True if an eager context was created.");
@@ -184,6 +196,10 @@ EagerContext::EagerContext(
   runner_ = [this](std::function<void()> closure) {
     this->thread_pool_->Schedule(std::move(closure));
   };
+  const int64_t max_concurrent_nodes = MaxConcurrentAsyncNodes();
+  if (async && max_concurrent_nodes > 1) {
+    default_executor_.EnableConcurrentDispatch(max_concurrent_nodes, runner_);
+  }
 
   run_metadata_ = std::make_unique<RunMetadata>();
 
@@ -245,11 +261,6 @@ AbstractTensorInterface* EagerContext::CreateBoolScalar(bool value) {
   return new TensorInterface(Tensor(value));
 }
 
-AbstractTensorInterface* EagerContext::CreateTensor(
-    DataType dtype, absl::Span<const int64_t> dim_sizes) {
-  return new TensorInterface(Tensor(dtype, TensorShape(dim_sizes)));
-}
-
 AbstractTensorInterface* EagerContext::CreateTensor(
     DataType dtype, const int64_t* dims, int num_dims, void* data, size_t len,
     MemoryReleaser memory_releaser, void* memory_releaser_arg) {
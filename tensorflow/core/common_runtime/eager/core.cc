@@ -136,6 +136,14 @@ ImmediateExecutionTensorHandle* EagerContext::CreateLocalHandle(
                                          /*op_device=*/nullptr, this);
 }
 
+// This function also lives here because of the circular dependency, since
+// small host tensors are allocated by `TensorHandle`.
+AbstractTensorInterface* EagerContext::CreateTensor(
+    DataType dtype, absl::Span<const int64_t> dim_sizes) {
+  return new TensorInterface(
+      TensorHandle::AllocateHostTensor(dtype, TensorShape(dim_sizes)));
+}
+
 ImmediateExecutionTensorHandle* EagerContext::CreateLocalHandleFromTFTensor(
     tensorflow::Tensor& t, const char* d_name) {
   // If device name is not specified, create the TensorHandle on host cpu.
@@ -212,13 +212,15 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
   DVLOG(3) << "Node Done: [id " << item->id << "] " << item->node->DebugString()
            << " with status: " << status.ToString();
   DCHECK(item->state != NodeState::kDONE);
+  // Async nodes, and nodes dispatched concurrently, are scheduled and moved to
+  // the unfinished nodes before they run.
+  bool scheduled = item->state == NodeState::kSCHEDULED;
   item->state = NodeState::kDONE;
 
-  bool async = item->node->AsAsync() != nullptr;
   // If executing synchronously we don't need to notify if status is OK since
   // the node  was never added to the unfinished_nodes_ list and nobody should
   // ever be waiting for it.
-  if (status.ok() && !from_queue && !async) {
+  if (status.ok() && !from_queue && !scheduled) {
     return;
   }
 
@@ -232,7 +234,7 @@ void EagerExecutor::NodeDone(const core::RefCountPtr<NodeItem>& item,
       // Since this was from the async queue, pop it from the front of the queue
       DCHECK(!node_queue_.empty() && item.get() == node_queue_.front().get());
       node_queue_.pop();
-    } else if (async) {
+    } else if (scheduled) {
       // If it is an Async node then we will find the node in the unfinished
       // nodes list. However we only notify if we are at the front of the list
       // since we don't want to notify any waiters of earlier nodes.
@@ -322,10 +324,17 @@ void EagerExecutor::Run() {
       gtl::MakeCleanup([this] { thread_exited_notification_.Notify(); });
   while (true) {
     core::RefCountPtr<NodeItem> curr_item;
+    DispatchMode mode = DispatchMode::kInOrder;
+    gtl::InlinedVector<TensorHandle*, 2> outputs;
     {
       tensorflow::mutex_lock l(node_queue_mutex_);
       while (node_queue_.empty() || !status_.ok()) {
-        if (state_ == ExecutorState::kShutDown) return;
+        if (state_ == ExecutorState::kShutDown) {
+          // Nodes dispatched concurrently refer to this executor until they
+          // are done.
+          while (num_concurrent_nodes_ > 0) nodes_pending_.wait(l);
+          return;
+        }
         nodes_pending_.wait(l);
       }
       // Obtain raw pointer since we don't want to remove from the queue until
@@ -337,6 +346,14 @@ void EagerExecutor::Run() {
       // and register a notification for its completion.
       curr_item.reset(node_queue_.front().get());
       curr_item->Ref();
+      if (max_concurrent_nodes_ > 1 && curr_item->node->AsAsync() == nullptr) {
+        mode = WaitForDispatchLocked(curr_item.get(), &outputs, &l);
+      }
+    }
+    if (mode == DispatchMode::kRetry) continue;
+    if (mode == DispatchMode::kConcurrent) {
+      RunConcurrently(std::move(curr_item), std::move(outputs));
+      continue;
     }
     Status status = RunItem(std::move(curr_item), /*from_queue=*/true);
     if (!status.ok()) {
@@ -388,6 +405,9 @@ Status EagerExecutor::RunItem(core::RefCountPtr<NodeItem> item,
   async_ref->Ref();
 
   TF_RETURN_IF_ERROR(MoveToUnfinished(std::move(item), from_queue));
+  if (async_remote_node != nullptr && from_queue) {
+    CoalesceQueuedNodes(async_remote_node);
+  }
 
   async_node->RunAsync([this, async_ref](const Status& status) {
     core::RefCountPtr<NodeItem> async_item(async_ref);
@@ -417,6 +437,115 @@ Status EagerExecutor::MoveToUnfinished(core::RefCountPtr<NodeItem> item,
   return OkStatus();
 }
 
+void EagerExecutor::CoalesceQueuedNodes(AsyncRemoteExecuteNode* node) {
+  tensorflow::mutex_lock l(node_queue_mutex_);
+  while (status_.ok() && !node_queue_.empty()) {
+    NodeItem* next_item = node_queue_.front().get();
+    AsyncRemoteExecuteNode* next_node =
+        next_item->node->AsAsyncRemoteExecuteNode();
+    // The callback is not run before `node` runs, so it does not need the
+    // lock. It holds a reference on the item, like the callback passed to
+    // `RunAsync()` in `RunItem()`.
+    if (next_node == nullptr ||
+        !node->TryCoalesce(next_node, [this, next_item](const Status& status) {
+          core::RefCountPtr<NodeItem> async_item(next_item);
+          NodeDone(async_item, status, false);
+        })) {
+      return;
+    }
+    next_item->Ref();
+    DVLOG(3) << "Coalesce Node: [id " << next_item->id << "] into unfinished "
+             << "map.";
+    next_item->state = NodeState::kSCHEDULED;
+    core::RefCountPtr<NodeItem> item = std::move(node_queue_.front());
+    node_queue_.pop();
+    unfinished_nodes_.emplace_hint(unfinished_nodes_.end(), item->id,
+                                   std::move(item));
+  }
+}
+
+EagerExecutor::DispatchMode EagerExecutor::WaitForDispatchLocked(
+    NodeItem* item, gtl::InlinedVector<TensorHandle*, 2>* outputs,
+    mutex_lock* lock) {
+  // Returns false if `item` is no longer at the front of the queue, e.g.
+  // because another node failed and the queue was cleared while waiting.
+  auto at_front = [this, item]() TF_EXCLUSIVE_LOCKS_REQUIRED(
+                      node_queue_mutex_) {
+    return status_.ok() && !node_queue_.empty() &&
+           node_queue_.front().get() == item;
+  };
+  gtl::InlinedVector<TensorHandle*, 4> inputs;
+  if (item->node->GetDataDependencies(&inputs, outputs)) {
+    auto can_dispatch = [this, &inputs]() TF_EXCLUSIVE_LOCKS_REQUIRED(
+                            node_queue_mutex_) {
+      if (num_concurrent_nodes_ >= max_concurrent_nodes_) return false;
+      for (const TensorHandle* input : inputs) {
+        if (concurrent_outputs_.count(input) != 0) return false;
+      }
+      return true;
+    };
+    while (!can_dispatch()) {
+      nodes_pending_.wait(*lock);
+      if (!at_front()) return DispatchMode::kRetry;
+    }
+    // The inputs may be produced by an async node that is still running, in
+    // which case the node runs in order, and blocks until they are ready.
+    if (item->node->InputsReady()) {
+      ++num_concurrent_nodes_;
+      concurrent_outputs_.insert(outputs->begin(), outputs->end());
+      DVLOG(3) << "Dispatch Node: [id " << item->id << "] concurrently.";
+      item->state = NodeState::kSCHEDULED;
+      core::RefCountPtr<NodeItem> queued_item = std::move(node_queue_.front());
+      node_queue_.pop();
+      unfinished_nodes_.emplace_hint(unfinished_nodes_.end(), queued_item->id,
+                                     std::move(queued_item));
+      return DispatchMode::kConcurrent;
+    }
+  }
+  while (num_concurrent_nodes_ > 0) {
+    nodes_pending_.wait(*lock);
+    if (!at_front()) return DispatchMode::kRetry;
+  }
+  outputs->clear();
+  return DispatchMode::kInOrder;
+}
+
+void EagerExecutor::RunConcurrently(
+    core::RefCountPtr<NodeItem> item,
+    gtl::InlinedVector<TensorHandle*, 2> outputs) {
+  std::function<void(std::function<void()>)> runner;
+  {
+    tf_shared_lock l(node_queue_mutex_);
+    runner = concurrent_runner_;
+  }
+  NodeItem* item_ref = item.release();
+  runner([this, item_ref, outputs = std::move(outputs)]() {
+    {
+      core::RefCountPtr<NodeItem> item(item_ref);
+      DVLOG(3) << "Running Node: [id " << item->id << "] "
+               << item->node->DebugString();
+      Status status = item->node->Run();
+      NodeDone(item, status, /*from_queue=*/false);
+      // The item is released before the executor thread may exit below, since
+      // destroying the node may add nodes to this executor.
+    }
+    mutex_lock l(node_queue_mutex_);
+    for (const TensorHandle* output : outputs) {
+      concurrent_outputs_.erase(output);
+    }
+    --num_concurrent_nodes_;
+    nodes_pending_.notify_all();
+  });
+}
+
+void EagerExecutor::EnableConcurrentDispatch(
+    int max_concurrent_nodes,
+    std::function<void(std::function<void()>)> runner) {
+  mutex_lock l(node_queue_mutex_);
+  max_concurrent_nodes_ = std::max(max_concurrent_nodes, 1);
+  concurrent_runner_ = std::move(runner);
+}
+
 void EagerExecutor::AddCleanup(intptr_t key, std::function<void()> callback) {
   cleanups_[key].push_back(callback);
 }
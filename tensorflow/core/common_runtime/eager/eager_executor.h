@@ -17,10 +17,12 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <memory>
 #include <queue>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
@@ -40,9 +42,11 @@ namespace tensorflow {
 
 class AsyncEagerNode;
 class AsyncRemoteExecuteNode;
+class TensorHandle;
 namespace eager {
 class EagerClient;
-}
+class RemoteExecuteNode;
+}  // namespace eager
 
 // A unit of execution for the EagerExecutor class below. Example subclasses
 // encapsulate execution of a TFE_Op, or copying a TFE_TensorHandle from one
@@ -75,6 +79,22 @@ class EagerNode {
 
   // Indicates whether a node failure should make the executor unusable.
   virtual bool Fatal() const { return true; }
+
+  // Returns true if this node may run concurrently with the nodes around it,
+  // as long as the nodes that produce its inputs are done, and appends to
+  // `inputs` and `outputs` the tensor handles it reads and produces. Returns
+  // false if the node must run in order with respect to all other nodes, for
+  // example because it is stateful. Only called for synchronous nodes.
+  virtual bool GetDataDependencies(
+      gtl::InlinedVector<TensorHandle*, 4>* inputs,
+      gtl::InlinedVector<TensorHandle*, 2>* outputs) const {
+    return false;
+  }
+
+  // Returns true if all the inputs of this node are ready, so that running it
+  // does not block. Only called for nodes whose `GetDataDependencies()`
+  // returned true, once the nodes producing their inputs are done.
+  virtual bool InputsReady() const { return true; }
 };
 
 class AsyncEagerNode : public EagerNode {
@@ -99,6 +119,17 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
   virtual bool needs_remote_inputs() const = 0;
   virtual bool allow_multiple_pending_requests() const = 0;
   virtual Status SyncExecutors() = 0;
+
+  virtual eager::RemoteExecuteNode* AsRemoteExecuteNode() { return nullptr; }
+
+  // Called by the executor before `RunAsync()` for each node queued right
+  // after this one, until it returns false. Returning true means that the
+  // work of `next` has been appended to the request of this node, so that
+  // both are sent together, and that this node calls `done` with the status
+  // of `next` once the request completes; `next` is then never run.
+  virtual bool TryCoalesce(AsyncRemoteExecuteNode* next, StatusCallback done) {
+    return false;
+  }
 };
 
 // A class for handling async execution (see TFE_ContextSetAsync).
@@ -106,9 +137,17 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
 // device of the input handle. Fix that.
 // TODO(agarwal): Implement support for control dependencies.
-// TODO(agarwal): Support out-of-order execution and dispatching multiple
-// EagerNode in parallel.
 // TODO(agarwal): Implement optimizations over EagerNode traces.
+//
+// In async mode, nodes run one at a time on the executor thread, in the order
+// in which they were added, unless `EnableConcurrentDispatch()` was called. In
+// that case, nodes that report their data dependencies are dispatched to a
+// thread pool as soon as the nodes producing their inputs are done, and run
+// concurrently with the nodes queued around them. Nodes that do not report
+// their dependencies still wait for all earlier nodes to be done, and later
+// nodes are not dispatched before they are done, so stateful nodes keep their
+// program order. Nodes are always dispatched in the order in which they were
+// added.
 class EagerExecutor {
  public:
   explicit EagerExecutor(bool async, bool enable_streaming_enqueue = true);
@@ -145,6 +184,13 @@ class EagerExecutor {
   // Clears all currently set errors which re-enables async execution.
   void ClearError();
 
+  // In async mode, allows up to `max_concurrent_nodes` nodes to run
+  // concurrently by passing them to `runner`, which may run them on any
+  // thread. A value of 1 or less restores in-order execution.
+  void EnableConcurrentDispatch(
+      int max_concurrent_nodes,
+      std::function<void(std::function<void()>)> runner);
+
   // Returns Status based on any errors that occurred during async execution.
   Status status() const {
     if (ok()) return OkStatus();
@@ -207,6 +253,29 @@ class EagerExecutor {
 
   Status RunItem(core::RefCountPtr<NodeItem> item, bool from_queue);
   Status MoveToUnfinished(core::RefCountPtr<NodeItem> item, bool from_queue);
+  // Moves the nodes at the front of the queue that `node` accepts in
+  // `AsyncRemoteExecuteNode::TryCoalesce()` to the unfinished nodes.
+  void CoalesceQueuedNodes(AsyncRemoteExecuteNode* node);
+
+  // How `Run()` dispatches the node at the front of the queue.
+  enum class DispatchMode {
+    // The node runs on the executor thread, like without concurrent dispatch.
+    kInOrder,
+    // The node has been moved to the unfinished nodes, and must be passed to
+    // `RunConcurrently()`.
+    kConcurrent,
+    // The queue has changed while waiting, e.g. because of an error.
+    kRetry,
+  };
+  // Waits until `item`, at the front of the queue, can be dispatched when
+  // concurrent dispatch is enabled. `item->node` must not be async.
+  DispatchMode WaitForDispatchLocked(
+      NodeItem* item, gtl::InlinedVector<TensorHandle*, 2>* outputs,
+      mutex_lock* lock) TF_EXCLUSIVE_LOCKS_REQUIRED(node_queue_mutex_);
+  // Runs `item` with `concurrent_runner_`. `outputs` are the handles produced
+  // by the node, as returned by `WaitForDispatchLocked()`.
+  void RunConcurrently(core::RefCountPtr<NodeItem> item,
+                       gtl::InlinedVector<TensorHandle*, 2> outputs);
 
   // The impl of WaitForAllPendingNodes
   // `lock` is the lock that holds node_queue_mutex_.
@@ -219,7 +288,8 @@ class EagerExecutor {
 
   mutable mutex node_queue_mutex_;
 
-  // Used to signal that some EagerNodes are pending execution.
+  // Used to signal that some EagerNodes are pending execution, or that a node
+  // dispatched concurrently is done.
   condition_variable nodes_pending_ TF_GUARDED_BY(node_queue_mutex_);
 
   // Queue of pending NodeItems. Ordered by NodeItem::id.
@@ -263,6 +333,16 @@ class EagerExecutor {
   // Enable sending remote executions through streaming enqueue.
   const bool enable_streaming_enqueue_;
 
+  // Set by `EnableConcurrentDispatch()`.
+  int max_concurrent_nodes_ TF_GUARDED_BY(node_queue_mutex_) = 1;
+  std::function<void(std::function<void()>)> concurrent_runner_
+      TF_GUARDED_BY(node_queue_mutex_);
+  // Number of nodes dispatched concurrently that are not done, and the
+  // handles they produce.
+  int num_concurrent_nodes_ TF_GUARDED_BY(node_queue_mutex_) = 0;
+  std::unordered_set<const TensorHandle*> concurrent_outputs_
+      TF_GUARDED_BY(node_queue_mutex_);
+
   // Callbacks to run on destruction.
   std::unordered_map<intptr_t, std::vector<std::function<void()>>> cleanups_;
 };
@@ -0,0 +1,213 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int64_t kTimeoutUs = 10 * 1000 * 1000;
+
+// A synchronous node that runs `fn`. If `concurrent` is true, it reports
+// `inputs` and `outputs` as its data dependencies.
+class TestNode : public EagerNode {
+ public:
+  TestNode(std::function<Status()> fn, bool concurrent,
+           std::vector<TensorHandle*> inputs = {},
+           std::vector<TensorHandle*> outputs = {},
+           std::atomic<int>* num_aborted = nullptr)
+      : fn_(std::move(fn)),
+        concurrent_(concurrent),
+        inputs_(std::move(inputs)),
+        outputs_(std::move(outputs)),
+        num_aborted_(num_aborted) {}
+
+  Status Run() override { return fn_(); }
+
+  void Abort(Status status) override {
+    if (num_aborted_ != nullptr) num_aborted_->fetch_add(1);
+  }
+
+  bool GetDataDependencies(
+      gtl::InlinedVector<TensorHandle*, 4>* inputs,
+      gtl::InlinedVector<TensorHandle*, 2>* outputs) const override {
+    if (!concurrent_) return false;
+    inputs->insert(inputs->end(), inputs_.begin(), inputs_.end());
+    outputs->insert(outputs->end(), outputs_.begin(), outputs_.end());
+    return true;
+  }
+
+  string DebugString() const override { return "[TestNode]"; }
+
+ private:
+  std::function<Status()> fn_;
+  const bool concurrent_;
+  std::vector<TensorHandle*> inputs_;
+  std::vector<TensorHandle*> outputs_;
+  std::atomic<int>* num_aborted_;
+};
+
+class EagerExecutorConcurrencyTest : public ::testing::Test {
+ protected:
+  EagerExecutorConcurrencyTest()
+      : pool_(Env::Default(), "test", 4), executor_(/*async=*/true) {
+    executor_.EnableConcurrentDispatch(
+        4, [this](std::function<void()> fn) { pool_.Schedule(std::move(fn)); });
+  }
+
+  ~EagerExecutorConcurrencyTest() override {
+    executor_.ShutDown().IgnoreError();
+    for (TensorHandle* h : handles_) h->Unref();
+  }
+
+  // Returns a handle that is only used to identify a data dependency.
+  TensorHandle* NewHandle() {
+    handles_.push_back(
+        TensorHandle::CreateLocalHandle(test::AsScalar<float>(0.0f)));
+    return handles_.back();
+  }
+
+  thread::ThreadPool pool_;
+  EagerExecutor executor_;
+  std::vector<TensorHandle*> handles_;
+};
+
+TEST_F(EagerExecutorConcurrencyTest, IndependentNodesRunConcurrently) {
+  // The first node only completes once the second one has started.
+  Notification second_started;
+  bool first_saw_second = false;
+  TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+      [&]() {
+        first_saw_second =
+            WaitForNotificationWithTimeout(&second_started, kTimeoutUs);
+        return OkStatus();
+      },
+      /*concurrent=*/true, std::vector<TensorHandle*>{},
+      std::vector<TensorHandle*>{NewHandle()})));
+  TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+      [&]() {
+        second_started.Notify();
+        return OkStatus();
+      },
+      /*concurrent=*/true, std::vector<TensorHandle*>{},
+      std::vector<TensorHandle*>{NewHandle()})));
+  TF_ASSERT_OK(executor_.WaitForAllPendingNodes());
+  EXPECT_TRUE(first_saw_second);
+}
+
+TEST_F(EagerExecutorConcurrencyTest, DependentNodesRunInOrder) {
+  constexpr int kLength = 20;
+  std::vector<int> order;
+  TensorHandle* input = NewHandle();
+  for (int i = 0; i < kLength; ++i) {
+    TensorHandle* output = NewHandle();
+    TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+        [&, i]() {
+          Env::Default()->SleepForMicroseconds(100);
+          order.push_back(i);
+          return OkStatus();
+        },
+        /*concurrent=*/true, std::vector<TensorHandle*>{input},
+        std::vector<TensorHandle*>{output})));
+    input = output;
+  }
+  TF_ASSERT_OK(executor_.WaitForAllPendingNodes());
+  ASSERT_EQ(order.size(), kLength);
+  for (int i = 0; i < kLength; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST_F(EagerExecutorConcurrencyTest, StatefulNodesWaitForEarlierNodes) {
+  constexpr int kNumNodes = 8;
+  std::atomic<int> num_done{0};
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < kNumNodes; ++i) {
+      TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+          [&]() {
+            Env::Default()->SleepForMicroseconds(100);
+            num_done.fetch_add(1);
+            return OkStatus();
+          },
+          /*concurrent=*/true, std::vector<TensorHandle*>{},
+          std::vector<TensorHandle*>{NewHandle()})));
+    }
+    // A node that does not report its dependencies sees all earlier nodes
+    // done, and later nodes are not started before it is done.
+    const int expected = (round + 1) * kNumNodes;
+    TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+        [&num_done, expected]() {
+          EXPECT_EQ(num_done.load(), expected);
+          Env::Default()->SleepForMicroseconds(1000);
+          EXPECT_EQ(num_done.load(), expected);
+          return OkStatus();
+        },
+        /*concurrent=*/false)));
+  }
+  TF_ASSERT_OK(executor_.WaitForAllPendingNodes());
+  EXPECT_EQ(num_done.load(), 3 * kNumNodes);
+}
+
+TEST_F(EagerExecutorConcurrencyTest, ErrorAbortsPendingNodes) {
+  std::atomic<int> num_aborted{0};
+  Notification failed;
+  TensorHandle* output = NewHandle();
+  TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+      [&]() {
+        failed.Notify();
+        return errors::Internal("Failed");
+      },
+      /*concurrent=*/true, std::vector<TensorHandle*>{},
+      std::vector<TensorHandle*>{output}, &num_aborted)));
+  // Depends on the failed node, so it is still queued when the error occurs.
+  TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+      []() { return OkStatus(); }, /*concurrent=*/true,
+      std::vector<TensorHandle*>{output},
+      std::vector<TensorHandle*>{NewHandle()}, &num_aborted)));
+  Status status = executor_.WaitForAllPendingNodes();
+  EXPECT_TRUE(errors::IsInternal(status)) << status;
+  EXPECT_TRUE(failed.HasBeenNotified());
+  EXPECT_LE(num_aborted.load(), 1);
+
+  executor_.ClearError();
+  bool ran = false;
+  TF_ASSERT_OK(executor_.AddOrExecute(std::make_unique<TestNode>(
+      [&]() {
+        ran = true;
+        return OkStatus();
+      },
+      /*concurrent=*/true, std::vector<TensorHandle*>{},
+      std::vector<TensorHandle*>{NewHandle()})));
+  TF_ASSERT_OK(executor_.WaitForAllPendingNodes());
+  EXPECT_TRUE(ran);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <optional>
 #include <vector>
 
@@ -1823,6 +1824,152 @@ Status EagerExecute(EagerOperation* op, TensorHandle** retvals,
 #endif  // !IS_MOBILE_PLATFORM
 }
 
+Status EagerPrepareOp(EagerOperation* op,
+                      core::RefCountPtr<EagerPreparedOp>* prepared) {
+  profiler::TraceMe activity(
+      [&] { return absl::StrCat("EagerPrepareOp: ", op->Name()); },
+      profiler::TraceMeLevel::kInfo);
+  if (!op->IsLocal()) {
+    return errors::Unimplemented("Cannot prepare remote operation ",
+                                 op->Name(), " on device ", op->DeviceName());
+  }
+  // The rewrite passes may replace the operation on every call, so they
+  // cannot be skipped.
+  std::unique_ptr<tensorflow::EagerOperation> out_op;
+  TF_RETURN_IF_ERROR(EagerOpRewriteRegistry::Global()->RunRewrite(
+      EagerOpRewriteRegistry::PRE_EXECUTION, op, &out_op));
+  if (out_op) {
+    return errors::Unimplemented("Cannot prepare operation ", op->Name(),
+                                 ", which is rewritten before execution");
+  }
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  TF_RETURN_IF_ERROR(op->TensorHandleInputs(&inputs));
+  for (int i = 0; i < inputs->size(); ++i) {
+    if ((*inputs)[i]->Type() == TensorHandle::PACKED) {
+      return errors::Unimplemented("Cannot prepare operation ", op->Name(),
+                                   ", whose input #", i, " is packed");
+    }
+  }
+
+  core::RefCountPtr<KernelAndDevice> kernel;
+  int num_retvals = std::numeric_limits<int>::max();
+  TF_RETURN_IF_ERROR(
+      GetOrCreateKernelAndDevice(op, /*retvals=*/nullptr, &num_retvals,
+                                 &kernel));
+  TF_RETURN_IF_ERROR(EagerOpRewriteRegistry::Global()->RunRewrite(
+      EagerOpRewriteRegistry::POST_PLACEMENT, op, &out_op));
+  if (out_op) {
+    return errors::Unimplemented("Cannot prepare operation ", op->Name(),
+                                 ", which is rewritten after placement");
+  }
+  if (kernel->IsCrossProcess()) {
+    return errors::Unimplemented("Cannot prepare cross-process function ",
+                                 op->Name());
+  }
+  if (kernel->num_inputs() != inputs->size()) {
+    return errors::InvalidArgument("expected ", kernel->num_inputs(),
+                                   " inputs, got ", inputs->size());
+  }
+  prepared->reset(new EagerPreparedOp(&op->EagerContext(), std::move(kernel)));
+  return OkStatus();
+}
+
+Status EagerExecutePrepared(const EagerPreparedOp& prepared,
+                            absl::Span<TensorHandle* const> inputs,
+                            TensorHandle** retvals, int* num_retvals) {
+  profiler::TraceMe activity(
+      [&] {
+        return absl::StrCat("EagerExecutePrepared: ",
+                            prepared.kernel()->name());
+      },
+      profiler::TraceMeLevel::kInfo);
+  EagerContext& ctx = *prepared.context();
+  const core::RefCountPtr<KernelAndDevice>& kernel = prepared.kernel();
+  const int num_outputs = kernel->num_outputs();
+  if (num_outputs > *num_retvals) {
+    return errors::InvalidArgument("Expecting ", num_outputs,
+                                   " outputs, but *num_retvals is ",
+                                   *num_retvals);
+  }
+  if (kernel->num_inputs() != inputs.size()) {
+    return errors::InvalidArgument("expected ", kernel->num_inputs(),
+                                   " inputs, got ", inputs.size());
+  }
+  const DataTypeVector& input_dtypes = kernel->input_dtypes();
+  for (int i = 0; i < inputs.size(); ++i) {
+    TensorHandle* handle = inputs[i];
+    if (handle->dtype != input_dtypes[i]) {
+      return errors::InvalidArgument(
+          "cannot compute ", kernel->name(), " as input #", i, "(zero-based)",
+          " was expected to be a ", DataTypeString(input_dtypes[i]),
+          " tensor but is a ", DataTypeString(handle->dtype), " tensor");
+    }
+    Device* expected_device = kernel->InputDevice(i);
+    Device* handle_device = handle->DeviceOrHostCPU(ctx);
+    if (handle_device != expected_device) {
+      return errors::InvalidArgument(
+          "cannot compute prepared operation ", kernel->name(), " as input #",
+          i, "(zero-based) was expected to be on ",
+          DeviceNameOrUnspecified(expected_device), " but is on ",
+          DeviceNameOrUnspecified(handle_device));
+    }
+  }
+  *num_retvals = num_outputs;
+
+  EagerExecutor& executor = ctx.Executor();
+  if (!executor.Async()) {
+    // In sync mode, always clear error to maintain the same behavior as
+    // `EagerExecute`.
+    executor.ClearError();
+  }
+  TF_RETURN_IF_ERROR(executor.status());
+  GraphCollector* graph_collector = nullptr;
+  if (ctx.ShouldStoreGraphs()) {
+    graph_collector = ctx.GetGraphCollector();
+  }
+  const absl::InlinedVector<TensorHandle*, 4> handles(inputs.begin(),
+                                                      inputs.end());
+  Status s;
+  if (executor.Async()) {
+    const DataTypeVector& output_dtypes = kernel->output_dtypes();
+    for (int i = 0; i < num_outputs; ++i) {
+      retvals[i] = TensorHandle::CreateEmptyLocalHandle(
+          /* d= */ ctx.CanonicalDevice(kernel->OutputDevice(i)),
+          /* op_device= */ kernel->device(),
+          /* resource_device= */ kernel->OutputResourceDevice(i),
+          output_dtypes[i], &ctx);
+    }
+    kernel->Ref();  // Ownership of reference is passed to the node.
+    auto node = std::make_unique<AsyncExecuteNode>(
+        &ctx, handles, /*eager_func_params=*/absl::nullopt,
+        core::RefCountPtr<KernelAndDevice>(kernel.get()), graph_collector,
+        /*cancellation_manager=*/nullptr,
+        absl::Span<TensorHandle*>(retvals, num_outputs),
+        /*stack_trace=*/absl::nullopt);
+    s = executor.AddOrExecute(std::move(node));
+  } else {
+    for (int i = 0; i < num_outputs; ++i) {
+      retvals[i] = nullptr;
+    }
+    ExecuteNode node(&ctx, handles, /*eager_func_params=*/absl::nullopt,
+                     kernel, graph_collector, /*cancellation_manager=*/nullptr,
+                     {retvals, static_cast<size_t>(num_outputs)},
+                     /*stack_trace=*/absl::nullopt);
+    s = executor.SyncExecute(&node);
+  }
+  // Since the operation failed, we need to Unref any outputs if they were
+  // allocated.
+  if (!s.ok()) {
+    for (int i = 0; i < num_outputs; ++i) {
+      if (retvals[i] != nullptr) {
+        retvals[i]->Unref();
+        retvals[i] = nullptr;
+      }
+    }
+  }
+  return s;
+}
+
 // TODO(gjn): Consider moving into ExecuteNode class
 Status EagerKernelExecute(
     EagerContext* ctx, const absl::InlinedVector<TensorHandle*, 4>& op_inputs,
@@ -45,6 +45,54 @@ namespace tensorflow {
 Status EagerExecute(EagerOperation* op, TensorHandle** retvals,
                     int* num_retvals);
 
+// A kernel resolved once by `EagerPrepareOp()` for an operation with fixed
+// attributes, device and input placement. `EagerExecutePrepared()` runs it
+// without rebuilding the NodeDef, hashing the attributes, selecting a device
+// or looking up the kernel cache, which dominate the cost of executing small
+// ops. A prepared op may be executed concurrently from several threads.
+class EagerPreparedOp : public core::RefCounted {
+ public:
+  EagerPreparedOp(EagerContext* ctx, core::RefCountPtr<KernelAndDevice> kernel)
+      : ctx_(ctx), kernel_(std::move(kernel)) {
+    ctx_->Ref();
+  }
+  ~EagerPreparedOp() override { ctx_->Unref(); }
+
+  EagerContext* context() const { return ctx_; }
+  const core::RefCountPtr<KernelAndDevice>& kernel() const { return kernel_; }
+  Device* device() const { return kernel_->device(); }
+  int num_inputs() const { return kernel_->num_inputs(); }
+  int num_outputs() const { return kernel_->num_outputs(); }
+  const DataTypeVector& input_dtypes() const { return kernel_->input_dtypes(); }
+  const DataTypeVector& output_dtypes() const {
+    return kernel_->output_dtypes();
+  }
+
+ private:
+  EagerContext* const ctx_;
+  const core::RefCountPtr<KernelAndDevice> kernel_;
+};
+
+// Places `op` and resolves its kernel as `EagerExecute` would, and returns it
+// in `prepared` for use with `EagerExecutePrepared()`. The inputs of `op` must
+// have been added, since they determine the placement and the kernel.
+//
+// Returns an Unimplemented error for operations that cannot skip the per-call
+// work, i.e. remote operations, operations with packed inputs or that are
+// rewritten by an `EagerOpRewriteRegistry` pass, and cross-process functions.
+Status EagerPrepareOp(EagerOperation* op,
+                      core::RefCountPtr<EagerPreparedOp>* prepared);
+
+// Executes `prepared` with `inputs` on the executor of its context, in sync or
+// async mode as configured. The inputs must have the dtypes of the prepared
+// operation and be placed on the devices expected by its kernel; they are not
+// copied automatically.
+//
+// 'retvals' and '*num_retvals' are as for `EagerExecute`.
+Status EagerExecutePrepared(const EagerPreparedOp& prepared,
+                            absl::Span<TensorHandle* const> inputs,
+                            TensorHandle** retvals, int* num_retvals);
+
 // Low-level utility to execute the kernel specified by `kernel` on
 // `kernel->device()`, with the inputs op_inputs, in the context 'ctx'.
 Status EagerKernelExecute(
@@ -222,6 +222,27 @@ class AsyncExecuteNode : public EagerNode {
     }
   }
 
+  // Primitive stateless ops only read their inputs, so they can run
+  // concurrently with the other nodes when concurrent dispatch is enabled.
+  bool GetDataDependencies(
+      gtl::InlinedVector<TensorHandle*, 4>* inputs,
+      gtl::InlinedVector<TensorHandle*, 2>* outputs) const override {
+    if (kernel_->IsFunction() || kernel_->IsStateful() ||
+        eager_func_params_.has_value() || graph_collector_ != nullptr) {
+      return false;
+    }
+    inputs->insert(inputs->end(), inputs_.begin(), inputs_.end());
+    outputs->insert(outputs->end(), retvals_.begin(), retvals_.end());
+    return true;
+  }
+
+  bool InputsReady() const override {
+    for (const TensorHandle* h : inputs_) {
+      if (!h->IsReady()) return false;
+    }
+    return true;
+  }
+
   std::string DebugString() const override {
     std::string out = "[AsyncExecuteNode]";
     strings::StrAppend(&out, " kernel: ", kernel_->name());
@@ -0,0 +1,213 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/eager/execute.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class EagerPreparedOpTest : public ::testing::TestWithParam<bool> {
+ protected:
+  EagerPreparedOpTest()
+      : device_mgr_(DeviceFactory::NewDevice(
+            "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0")),
+        ctx_(new EagerContext(
+            SessionOptions(),
+            ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+            /*async=*/GetParam(), &device_mgr_, /*device_mgr_owned=*/false,
+            /*rendezvous=*/nullptr)) {}
+
+  ~EagerPreparedOpTest() override { ctx_->Unref(); }
+
+  // Prepares `AddV2` for two float inputs.
+  core::RefCountPtr<EagerPreparedOp> PrepareAdd() {
+    core::RefCountPtr<TensorHandle> x(Scalar(0.0f));
+    core::RefCountPtr<TensorHandle> y(Scalar(0.0f));
+    std::unique_ptr<EagerOperation> op(new EagerOperation(ctx_));
+    TF_CHECK_OK(op->Reset("AddV2", nullptr));
+    op->MutableAttrs()->Set("T", DT_FLOAT);
+    TF_CHECK_OK(op->AddInput(x.get()));
+    TF_CHECK_OK(op->AddInput(y.get()));
+    core::RefCountPtr<EagerPreparedOp> prepared;
+    TF_CHECK_OK(EagerPrepareOp(op.get(), &prepared));
+    return prepared;
+  }
+
+  TensorHandle* Scalar(float value) {
+    return TensorHandle::CreateLocalHandle(test::AsScalar<float>(value));
+  }
+
+  StaticDeviceMgr device_mgr_;
+  EagerContext* ctx_;
+};
+
+TEST_P(EagerPreparedOpTest, ExecutesRepeatedly) {
+  core::RefCountPtr<EagerPreparedOp> prepared = PrepareAdd();
+  EXPECT_EQ(prepared->num_inputs(), 2);
+  EXPECT_EQ(prepared->num_outputs(), 1);
+  EXPECT_EQ(prepared->device()->name(),
+            "/job:localhost/replica:0/task:0/device:CPU:0");
+  for (int i = 0; i < 10; ++i) {
+    core::RefCountPtr<TensorHandle> x(Scalar(i));
+    core::RefCountPtr<TensorHandle> y(Scalar(2.0f));
+    TensorHandle* inputs[] = {x.get(), y.get()};
+    TensorHandle* retvals[2];
+    int num_retvals = 2;
+    TF_ASSERT_OK(
+        EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals));
+    ASSERT_EQ(num_retvals, 1);
+    core::RefCountPtr<TensorHandle> result(retvals[0]);
+    const Tensor* t;
+    TF_ASSERT_OK(result->Tensor(&t));
+    test::ExpectTensorEqual<float>(*t, test::AsScalar<float>(i + 2.0f));
+  }
+}
+
+TEST_P(EagerPreparedOpTest, RejectsInvalidInputs) {
+  core::RefCountPtr<EagerPreparedOp> prepared = PrepareAdd();
+  core::RefCountPtr<TensorHandle> x(Scalar(1.0f));
+  core::RefCountPtr<TensorHandle> i(
+      TensorHandle::CreateLocalHandle(test::AsScalar<int32>(1)));
+  TensorHandle* retvals[1];
+  int num_retvals = 1;
+
+  std::vector<TensorHandle*> inputs = {x.get()};
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals)));
+  inputs = {x.get(), i.get()};
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals)));
+  inputs = {x.get(), x.get()};
+  num_retvals = 0;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals)));
+}
+
+TEST_P(EagerPreparedOpTest, ReturnsKernelErrors) {
+  // Reshaping a scalar to two elements fails when the kernel runs.
+  core::RefCountPtr<TensorHandle> x(Scalar(1.0f));
+  core::RefCountPtr<TensorHandle> shape(
+      TensorHandle::CreateLocalHandle(test::AsTensor<int32>({2})));
+  std::unique_ptr<EagerOperation> op(new EagerOperation(ctx_));
+  TF_ASSERT_OK(op->Reset("Reshape", nullptr));
+  op->MutableAttrs()->Set("T", DT_FLOAT);
+  op->MutableAttrs()->Set("Tshape", DT_INT32);
+  TF_ASSERT_OK(op->AddInput(x.get()));
+  TF_ASSERT_OK(op->AddInput(shape.get()));
+  core::RefCountPtr<EagerPreparedOp> prepared;
+  TF_ASSERT_OK(EagerPrepareOp(op.get(), &prepared));
+
+  TensorHandle* inputs[] = {x.get(), shape.get()};
+  TensorHandle* retvals[1];
+  int num_retvals = 1;
+  Status s = EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals);
+  if (s.ok()) {
+    // In async mode, the error is reported by the output handle.
+    core::RefCountPtr<TensorHandle> result(retvals[0]);
+    const Tensor* t;
+    s = result->Tensor(&t);
+  }
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST_P(EagerPreparedOpTest, ConcurrentDispatch) {
+  if (!GetParam()) GTEST_SKIP() << "Concurrent dispatch requires async mode.";
+  ctx_->Executor().EnableConcurrentDispatch(4, *ctx_->runner());
+  core::RefCountPtr<EagerPreparedOp> prepared = PrepareAdd();
+  core::RefCountPtr<TensorHandle> one(Scalar(1.0f));
+  // Independent chains of additions, interleaved in the executor queue.
+  constexpr int kNumChains = 4;
+  constexpr int kLength = 16;
+  std::vector<core::RefCountPtr<TensorHandle>> chains;
+  for (int c = 0; c < kNumChains; ++c) chains.emplace_back(Scalar(c));
+  for (int i = 0; i < kLength; ++i) {
+    for (int c = 0; c < kNumChains; ++c) {
+      TensorHandle* inputs[] = {chains[c].get(), one.get()};
+      TensorHandle* retvals[1];
+      int num_retvals = 1;
+      TF_ASSERT_OK(
+          EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals));
+      chains[c].reset(retvals[0]);
+    }
+  }
+  for (int c = 0; c < kNumChains; ++c) {
+    const Tensor* t;
+    TF_ASSERT_OK(chains[c]->Tensor(&t));
+    test::ExpectTensorEqual<float>(*t, test::AsScalar<float>(c + kLength));
+  }
+  TF_ASSERT_OK(ctx_->Executor().WaitForAllPendingNodes());
+}
+
+INSTANTIATE_TEST_SUITE_P(SyncAndAsync, EagerPreparedOpTest, ::testing::Bool());
+
+void BM_EagerExecute(::testing::benchmark::State& state) {
+  const bool prepare = state.range(0);
+  StaticDeviceMgr device_mgr(DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0/device:CPU:0"));
+  EagerContext* ctx = new EagerContext(
+      SessionOptions(), ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+      /*async=*/false, &device_mgr, /*device_mgr_owned=*/false,
+      /*rendezvous=*/nullptr);
+  core::RefCountPtr<TensorHandle> x(
+      TensorHandle::CreateLocalHandle(test::AsScalar<float>(1.0f)));
+  std::unique_ptr<EagerOperation> op(new EagerOperation(ctx));
+  auto reset_op = [&]() {
+    TF_CHECK_OK(op->Reset("AddV2", nullptr));
+    op->MutableAttrs()->Set("T", DT_FLOAT);
+    TF_CHECK_OK(op->AddInput(x.get()));
+    TF_CHECK_OK(op->AddInput(x.get()));
+  };
+  reset_op();
+  core::RefCountPtr<EagerPreparedOp> prepared;
+  TF_CHECK_OK(EagerPrepareOp(op.get(), &prepared));
+  op->Clear();
+
+  TensorHandle* inputs[] = {x.get(), x.get()};
+  for (auto s : state) {
+    TensorHandle* retvals[1];
+    int num_retvals = 1;
+    if (prepare) {
+      TF_CHECK_OK(
+          EagerExecutePrepared(*prepared, inputs, retvals, &num_retvals));
+    } else {
+      reset_op();
+      TF_CHECK_OK(EagerExecute(op.get(), retvals, &num_retvals));
+    }
+    retvals[0]->Unref();
+  }
+  prepared.reset();
+  op.reset();
+  ctx->Unref();
+}
+BENCHMARK(BM_EagerExecute)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
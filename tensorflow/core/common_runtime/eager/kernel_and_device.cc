@@ -116,6 +116,7 @@ Status KernelAndDeviceOp::Init(const bool log_device_placement,
   if (op_reg_data != nullptr) {
     is_distributed_communication_op_ =
         op_reg_data->op_def.is_distributed_communication();
+    is_stateful_ = op_reg_data->op_def.is_stateful();
   }
 
   input_alloc_attrs_.resize(kernel_->num_inputs());
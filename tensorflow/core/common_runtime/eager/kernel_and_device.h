@@ -133,6 +133,10 @@ class KernelAndDevice : public core::RefCounted {
 
   virtual bool IsCrossProcess() { return false; }
 
+  // Returns true if the kernel may have side effects, or may produce outputs
+  // that depend on state other than its inputs.
+  virtual bool IsStateful() const { return true; }
+
   // TODO(ashankar): Handle list-valued inputs.
   virtual Status Run(
       ScopedStepContainer* step_container, const EagerKernelArgs& inputs,
@@ -234,6 +238,8 @@ class KernelAndDeviceOp final : public KernelAndDevice {
 
   const OpKernel* kernel() const override { return kernel_.get(); }
 
+  bool IsStateful() const override { return is_stateful_; }
+
   Device* InputDevice(int i) const override;
   Device* OutputDevice(int idx) const override;
   Device* OutputResourceDevice(int idx) const override;
@@ -251,6 +257,7 @@ class KernelAndDeviceOp final : public KernelAndDevice {
  private:
   std::unique_ptr<OpKernel> kernel_;
   bool is_distributed_communication_op_;
+  bool is_stateful_ = true;
   gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs_;
   std::vector<Device*> input_devices_;
   gtl::InlinedVector<AllocatorAttributes, 1> output_alloc_attrs_;
@@ -38,12 +38,15 @@ limitations under the License.
 #if !defined(IS_MOBILE_PLATFORM)
 #include "tensorflow/core/distributed_runtime/eager/remote_tensor_handle_data.h"
 #endif  // IS_MOBILE_PLATFORM
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 
@@ -55,6 +58,77 @@ int64_t GetRemoteDeviceIncarnation(Device* device) {
   return device->attributes().incarnation();
 }
 
+// A host tensor buffer that stores its data after itself, in one allocation.
+class InlineHostTensorBuffer : public TensorBuffer {
+ public:
+  static InlineHostTensorBuffer* New(size_t size) {
+    void* ptr = port::AlignedMalloc(DataOffset() + size, EIGEN_MAX_ALIGN_BYTES);
+    return new (ptr)
+        InlineHostTensorBuffer(static_cast<char*>(ptr) + DataOffset(), size);
+  }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name(cpu_allocator()->Name());
+  }
+  bool GetAllocatedBytes(size_t* out_bytes) const override {
+    *out_bytes = size_;
+    return true;
+  }
+
+  // Frees the allocation made by `New()` when `core::RefCounted::Unref()`
+  // calls `delete this`.
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+  static void operator delete(void*, void*) {}
+
+ private:
+  InlineHostTensorBuffer(void* data, size_t size)
+      : TensorBuffer(data), size_(size) {}
+  ~InlineHostTensorBuffer() override = default;
+
+  // Offset of the data from the start of the allocation, so that the data is
+  // aligned as required by Eigen.
+  static constexpr size_t DataOffset() {
+    return (sizeof(InlineHostTensorBuffer) + EIGEN_MAX_ALIGN_BYTES - 1) /
+           EIGEN_MAX_ALIGN_BYTES * EIGEN_MAX_ALIGN_BYTES;
+  }
+
+  const size_t size_;
+};
+
+// Memory of destroyed `TensorHandle` objects, which is reused for new handles
+// created on the same thread.
+class TensorHandleFreeList {
+ public:
+  ~TensorHandleFreeList() {
+    for (int i = 0; i < size_; ++i) {
+      ::operator delete(blocks_[i]);
+    }
+  }
+
+  static TensorHandleFreeList& ForCurrentThread() {
+    static thread_local TensorHandleFreeList free_list;
+    return free_list;
+  }
+
+  void* Pop() { return size_ > 0 ? blocks_[--size_] : nullptr; }
+
+  // Returns false if the list is full.
+  bool Push(void* block) {
+    if (size_ == kMaxSize) return false;
+    blocks_[size_++] = block;
+    return true;
+  }
+
+ private:
+  static constexpr int kMaxSize = 1024;
+  void* blocks_[kMaxSize];
+  int size_ = 0;
+};
+
 string SafeDeviceDebugString(Device* device) {
   if (device == nullptr) {
     return "[]";
@@ -416,6 +490,36 @@ TensorHandle::TensorHandle(int64_t op_id, int32_t output_num,
 }
 #endif
 
+tensorflow::Tensor TensorHandle::AllocateHostTensor(tensorflow::DataType dtype,
+                                                   const TensorShape& shape) {
+  if (DataTypeCanUseMemcpy(dtype)) {
+    const int64_t size = shape.num_elements() * DataTypeSize(dtype);
+    if (size > 0 && size <= kMaxInlineTensorBytes) {
+      TensorBuffer* buf = InlineHostTensorBuffer::New(size);
+      tensorflow::Tensor t(dtype, shape, buf);
+      buf->Unref();
+      return t;
+    }
+  }
+  return tensorflow::Tensor(dtype, shape);
+}
+
+void* TensorHandle::operator new(size_t size) {
+  if (size == sizeof(TensorHandle)) {
+    void* block = TensorHandleFreeList::ForCurrentThread().Pop();
+    if (block != nullptr) return block;
+  }
+  return ::operator new(size);
+}
+
+void TensorHandle::operator delete(void* ptr, size_t size) {
+  if (size == sizeof(TensorHandle) &&
+      TensorHandleFreeList::ForCurrentThread().Push(ptr)) {
+    return;
+  }
+  ::operator delete(ptr);
+}
+
 TensorHandle::~TensorHandle() { DVLOG(3) << "Deleting tensor handle " << this; }
 
 void TensorHandle::Release() {
@@ -119,6 +119,22 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
                                               EagerContext* ctx);
 #endif  // IS_MOBILE_PLATFORM
 
+  // Host tensors of plain-old-data types with at most this many bytes are
+  // allocated by `AllocateHostTensor()` with their data inline.
+  static constexpr size_t kMaxInlineTensorBytes = 64;
+
+  // Returns an uninitialized host tensor of `dtype` and `shape`. The data of a
+  // small tensor lives in the same allocation as its buffer, as for scalars
+  // created with `Tensor(T value)`, rather than in a separate allocation from
+  // the CPU allocator.
+  static tensorflow::Tensor AllocateHostTensor(tensorflow::DataType dtype,
+                                               const TensorShape& shape);
+
+  // Handles are allocated from a per-thread free list, since eager code
+  // creates and destroys many short-lived handles.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   void Release() override;
 
   tensorflow::DataType DataType() const override;
@@ -230,6 +246,10 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // tensor for a specific device.
   void Poison(Status status, const Device* d);
 
+  // Returns true if the handle has been set with SetTensor, SetRemoteShape or
+  // Poison, so that accessing its tensor or shape does not block.
+  bool IsReady() const;
+
   // TODO(b/154282629): Consider moving it to EagerContext.
   // Copies to the tensor on the given device `d`, or to host iff `d` is null.
   Status CopyToDevice(const EagerContext& ctx, tensorflow::Device* d,
@@ -284,7 +304,6 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // Further, it can be in a non-ready state. It would become ready with a call
   // to either SetTensor or SetRemoteShape which replaces the underlying data
   // with a ready version of the tensor handle data.
-  bool IsReady() const;
   Status WaitReady(const char* caller) const;
 
   tensorflow::Device* device_;
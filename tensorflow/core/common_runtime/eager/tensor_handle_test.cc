@@ -66,6 +66,38 @@ TEST(TensorHandle_ShapeTest, AsyncShape) {
   ctx->Unref();
 }
 
+TEST(TensorHandle_AllocateHostTensorTest, SmallTensorsAreInline) {
+  Tensor small = TensorHandle::AllocateHostTensor(DT_FLOAT, TensorShape({4}));
+  EXPECT_EQ(small.NumElements(), 4);
+  EXPECT_TRUE(small.IsAligned());
+  EXPECT_EQ(small.AllocatedBytes(), 4 * sizeof(float));
+  small.flat<float>().setConstant(1.0f);
+  Tensor copy = small;
+  small = Tensor();
+  EXPECT_EQ(copy.flat<float>()(3), 1.0f);
+
+  // Large tensors and tensors of non-POD types use the CPU allocator.
+  Tensor large = TensorHandle::AllocateHostTensor(
+      DT_FLOAT, TensorShape({TensorHandle::kMaxInlineTensorBytes}));
+  EXPECT_EQ(large.NumElements(), TensorHandle::kMaxInlineTensorBytes);
+  Tensor strings = TensorHandle::AllocateHostTensor(DT_STRING, {2});
+  EXPECT_EQ(strings.flat<tstring>()(1), "");
+  Tensor empty = TensorHandle::AllocateHostTensor(DT_INT32, {0});
+  EXPECT_EQ(empty.NumElements(), 0);
+}
+
+TEST(TensorHandle_AllocateTest, ReusesHandles) {
+  TensorHandle* first = TensorHandle::CreateLocalHandle(Tensor(1.0f));
+  void* address = first;
+  first->Unref();
+  TensorHandle* second = TensorHandle::CreateLocalHandle(Tensor(2.0f));
+  EXPECT_EQ(address, second);
+  const Tensor* t;
+  TF_ASSERT_OK(second->Tensor(&t));
+  EXPECT_EQ(t->scalar<float>()(), 2.0f);
+  second->Unref();
+}
+
 static Device* CreateDevice(const char* type, const char* name,
                             bool is_local = true) {
   class FakeDevice : public Device {
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <vector>
 
@@ -33,7 +34,9 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/propagator_state.h"
 #include "tensorflow/core/common_runtime/renamed_device.h"
 #include "tensorflow/core/common_runtime/simple_propagator_state.h"
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_ready_queues.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/collective.h"
@@ -60,6 +63,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/context.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
@@ -76,6 +80,7 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/util/determinism.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/managed_stack_trace.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
 
@@ -137,22 +142,87 @@ struct KernelTimer {
   }
 };
 
+// Returns true if the TF_EXECUTOR_DISPATCH_BY_MEASURED_COST environment
+// variable enables `LocalExecutorParams::dispatch_by_measured_cost` for all
+// executors in the process.
+bool DispatchByMeasuredCostFromEnv() {
+  static const bool dispatch_by_measured_cost = [] {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_EXECUTOR_DISPATCH_BY_MEASURED_COST",
+                                  /*default_val=*/false, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      value = false;
+    }
+    return value;
+  }();
+  return dispatch_by_measured_cost;
+}
+
+// Returns true if the TF_EXECUTOR_STATIC_MEMORY_PLAN environment variable
+// enables `LocalExecutorParams::use_static_memory_plan` for all executors in
+// the process.
+bool UseStaticMemoryPlanFromEnv() {
+  static const bool use_static_memory_plan = [] {
+    bool value;
+    Status s = ReadBoolFromEnvVar("TF_EXECUTOR_STATIC_MEMORY_PLAN",
+                                  /*default_val=*/false, &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      value = false;
+    }
+    return value;
+  }();
+  return use_static_memory_plan;
+}
+
 // TODO(b/152925936): Re-evaluate these constants with current usage patterns.
 typedef gtl::InlinedVector<TensorValue, 4> TensorValueVec;
 typedef gtl::InlinedVector<AllocatorAttributes, 4> AllocatorAttributeVec;
 
+// Identifies the work-stealing ready queue owned by the current thread, if the
+// thread is running a worker of a work-stealing `ExecutorState`.
+struct WorkStealingWorker {
+  const void* queues = nullptr;
+  int queue_id = -1;
+};
+thread_local WorkStealingWorker current_work_stealing_worker;
+
 class ExecutorImpl : public Executor {
  public:
-  explicit ExecutorImpl(const LocalExecutorParams& p) : immutable_state_(p) {}
+  // If `max_work_stealing_workers` is positive, ready nodes are scheduled on
+  // per-worker queues with work stealing, using at most that many concurrent
+  // closures on the inter-op `runner` per step, instead of one closure per
+  // expensive node.
+  explicit ExecutorImpl(const LocalExecutorParams& p,
+                        int max_work_stealing_workers = 0)
+      : immutable_state_(p),
+        max_work_stealing_workers_(max_work_stealing_workers) {}
 
   Status Initialize(const Graph& graph) {
     TF_RETURN_IF_ERROR(immutable_state_.Initialize(graph));
-    kernel_stats_.Initialize(immutable_state_.graph_view());
+    kernel_stats_.Initialize(
+        immutable_state_.graph_view(),
+        immutable_state_.params().dispatch_by_measured_cost ||
+            DispatchByMeasuredCostFromEnv());
+    // Static plans assume that every node runs once per step, which does not
+    // hold with v1 control flow.
+    if ((immutable_state_.params().use_static_memory_plan ||
+         UseStaticMemoryPlanFromEnv()) &&
+        !immutable_state_.requires_control_flow_support()) {
+      static_memory_arena_.reset(StaticMemoryArena::CreateForGraph(
+          graph, immutable_state_.graph_view(),
+          immutable_state_.params().device->GetAllocator(
+              AllocatorAttributes())));
+    }
     return OkStatus();
   }
 
   void RunAsync(const Args& args, DoneCallback done) override;
 
+  void ExportCostEstimates(const Graph& graph,
+                           CostModel* cost_model) const override;
+
  private:
   template <class PropagatorStateType>
   friend class ExecutorState;
@@ -162,15 +232,28 @@ class ExecutorImpl : public Executor {
    public:
     KernelStats() = default;
 
-    void Initialize(const GraphView& gview) {
+    // If `use_measured_costs` is true, the cost of every synchronous kernel is
+    // measured, and kernels whose IsExpensive() returns false are dispatched
+    // asynchronously once their measured cost exceeds the threshold.
+    // Otherwise, only kernels whose IsExpensive() returns true are measured,
+    // and they can only become inexpensive.
+    void Initialize(const GraphView& gview, bool use_measured_costs) {
       is_expensive_.resize(gview.num_nodes());
+      is_cost_tracked_.resize(gview.num_nodes());
       cost_estimates_ =
           std::make_unique<std::atomic_uint_fast64_t[]>(gview.num_nodes());
       for (int32_t i = 0; i < gview.num_nodes(); ++i) {
-        if (gview.node(i)) {
-          is_expensive_[i] =
-              gview.node(i)->kernel && gview.node(i)->kernel->IsExpensive();
-          cost_estimates_[i] = kInitialCostEstimateCycles;
+        const NodeItem* item = gview.node(i);
+        if (item) {
+          is_expensive_[i] = item->kernel && item->kernel->IsExpensive();
+          // The latency of asynchronous kernels is not measured, so they
+          // always keep their static marker.
+          is_cost_tracked_[i] =
+              is_expensive_[i] ||
+              (use_measured_costs && item->kernel && !item->kernel_is_async);
+          // Operations without the marker start out inexpensive.
+          cost_estimates_[i] =
+              is_expensive_[i] ? kInitialCostEstimateCycles : 0;
         }
       }
     }
@@ -179,7 +262,7 @@ class ExecutorImpl : public Executor {
     // executor uses this flag to optimize graph execution, for example
     // by "inlining" inexpensive kernels.
     bool IsExpensive(const NodeItem& node) const {
-      return is_expensive_[node.node_id] &&
+      return is_cost_tracked_[node.node_id] &&
              (cost_estimates_[node.node_id].load(std::memory_order_relaxed) >
               kOpIsExpensiveThresholdCycles);
     }
@@ -189,10 +272,20 @@ class ExecutorImpl : public Executor {
       return is_expensive_[node.node_id];
     }
 
+    // Returns true iff the executor measures the cost of the given node.
+    bool IsCostTracked(const NodeItem& node) const {
+      return is_cost_tracked_[node.node_id];
+    }
+
+    // Returns the current cost estimate of the given node, in CPU cycles.
+    uint64 CostEstimate(const NodeItem& node) const {
+      return cost_estimates_[node.node_id].load(std::memory_order_relaxed);
+    }
+
     // Updates the dynamic cost estimate, which is used to determine whether the
     // given node is expensive. The new cost estimate is a weighted average of
     // the old cost estimate and the latest cost. We only update cost estimates
-    // for kernels for which IsExpensive() return true.
+    // for kernels for which IsCostTracked() returns true.
     void UpdateCostEstimate(const NodeItem& node, uint64 elapsed_cycles) {
       // N.B. Updates to `cost_estimate` are atomic but unlocked.  Simultaneous
       // updates may result in one or more updates being ignored.  This does not
@@ -215,12 +308,16 @@ class ExecutorImpl : public Executor {
     static constexpr uint64 kCostDecay = 10;
 
     std::vector<bool> is_expensive_;
+    std::vector<bool> is_cost_tracked_;
     // std::unique_ptr<std::atomic<bool>[]> is_expensive_;
     std::unique_ptr<std::atomic_uint_fast64_t[]> cost_estimates_;
   };
 
   ImmutableExecutorState immutable_state_;
   KernelStats kernel_stats_;
+  const int max_work_stealing_workers_;
+  // Serves the outputs of the kernels from a preplanned arena, if enabled.
+  core::RefCountPtr<StaticMemoryArena> static_memory_arena_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
@@ -279,7 +376,9 @@ class ExecutorState {
  public:
   ExecutorState(const Executor::Args& args,
                 const ImmutableExecutorState& immutable_state_,
-                ExecutorImpl::KernelStats* kernel_stats_);
+                ExecutorImpl::KernelStats* kernel_stats_,
+                int max_work_stealing_workers = 0,
+                const StaticMemoryArena* static_memory_arena = nullptr);
   ~ExecutorState();
 
   void RunAsync(Executor::DoneCallback done);
@@ -290,6 +389,7 @@ class ExecutorState {
   typedef
       typename PropagatorStateType::TaggedNodeReadyQueue TaggedNodeReadyQueue;
   typedef typename PropagatorStateType::TaggedNodeSeq TaggedNodeSeq;
+  typedef WorkStealingReadyQueues<TaggedNode> WorkQueues;
 
   struct AsyncState;
 
@@ -335,6 +435,28 @@ class ExecutorState {
   // REQUIRES: `!ready->empty()`.
   void ScheduleReady(TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready);
 
+  // Implementation of `ScheduleReady()` in work-stealing mode. Inexpensive
+  // nodes are added to `inline_ready` as usual, and the remaining nodes are
+  // pushed onto the work-stealing queue of the current worker thread (or of
+  // an arbitrary worker if the current thread is not a worker).
+  void ScheduleReadyWorkStealing(TaggedNodeSeq* ready,
+                                 TaggedNodeReadyQueue* inline_ready,
+                                 int64_t scheduled_nsec);
+
+  // Starts up to `num_nodes` new workers on `runner_`, bounded by the maximum
+  // number of active workers.
+  void MaybeStartWorkers(size_t num_nodes, int64_t scheduled_nsec);
+
+  // Runs nodes from the work-stealing queue `queue_id`, stealing from the
+  // other queues when it is empty, until all queues are empty.
+  //
+  // NOTE: This is a static method because `state` may be deleted while the
+  // worker is running, when the last node of the step completes. `queues` is
+  // kept alive by the worker.
+  static void RunWorker(ExecutorState* state,
+                        std::shared_ptr<WorkQueues> queues, int queue_id,
+                        int64_t scheduled_nsec);
+
   // A wrapper for runner_ to keep track of the pending queue length. Op
   // execution should dispatch work using this function instead of using runner_
   // directly.
@@ -383,6 +505,8 @@ class ExecutorState {
   CallFrameInterface* call_frame_;
   const ImmutableExecutorState& immutable_state_;
   ExecutorImpl::KernelStats* const kernel_stats_;
+  // Not owned. Null unless static memory planning is enabled.
+  const StaticMemoryArena* const static_memory_arena_;
   CancellationManager* cancellation_manager_;
   CoordinationServiceAgent* coordination_service_agent_;
   absl::optional<ManagedStackTrace> stack_trace_ = absl::nullopt;
@@ -394,6 +518,10 @@ class ExecutorState {
 
   PropagatorStateType propagator_;
 
+  // Ready queues of the workers that run this step in work-stealing mode, or
+  // null if nodes are dispatched individually through `RunTask()`.
+  std::shared_ptr<WorkQueues> work_queues_;
+
   // Invoked when the execution finishes.
   Executor::DoneCallback done_cb_;
 
@@ -412,7 +540,8 @@ class ExecutorState {
 template <class PropagatorStateType>
 ExecutorState<PropagatorStateType>::ExecutorState(
     const Executor::Args& args, const ImmutableExecutorState& immutable_state,
-    ExecutorImpl::KernelStats* kernel_stats)
+    ExecutorImpl::KernelStats* kernel_stats, int max_work_stealing_workers,
+    const StaticMemoryArena* static_memory_arena)
     : vlog_(VLOG_IS_ON(1)),
       log_memory_(LogMemory::IsEnabled()),
       step_id_(args.step_id),
@@ -433,6 +562,7 @@ ExecutorState<PropagatorStateType>::ExecutorState(
       call_frame_(args.call_frame),
       immutable_state_(immutable_state),
       kernel_stats_(kernel_stats),
+      static_memory_arena_(static_memory_arena),
       cancellation_manager_(args.cancellation_manager),
       coordination_service_agent_(args.coordination_service_agent),
       stack_trace_(args.stack_trace),
@@ -446,6 +576,13 @@ ExecutorState<PropagatorStateType>::ExecutorState(
     user_device_ = RenamedDevice::NewRenamedDevice(
         device->name(), device, false, false, args.user_intra_op_threadpool);
   }
+  if (max_work_stealing_workers > 0) {
+    // There is no benefit in having more queues than nodes in the graph.
+    const int num_queues = std::min(max_work_stealing_workers,
+                                    immutable_state.graph_view().num_nodes());
+    work_queues_ =
+        std::make_shared<WorkQueues>(num_queues, max_work_stealing_workers);
+  }
 }
 
 template <class PropagatorStateType>
@@ -594,7 +731,7 @@ Status ExecutorState<PropagatorStateType>::ProcessSync(
         },
         profiler::GetTFTraceMeLevel(is_expensive));
     device->Compute(op_kernel, &ctx);
-  } else if (kernel_stats_->HasExpensiveMarker(item)) {
+  } else if (kernel_stats_->IsCostTracked(item)) {
     KernelTimer timer;
     device->Compute(op_kernel, &ctx);
     // For expensive kernels, always update the cost estimate. For inexpensive
@@ -856,6 +993,10 @@ void ExecutorState<PropagatorStateType>::ProcessInline(
       params.output_attr_array = item.output_attrs();
       params.forward_from_array = item.forward_from();
       params.outputs_required_array = item.outputs_required.get();
+      if (static_memory_arena_) {
+        params.output_allocator_array =
+            static_memory_arena_->output_allocators(id);
+      }
       params.inputs = inputs;
       params.input_alloc_attrs = input_alloc_attrs;
 
@@ -1220,7 +1361,9 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
     scheduled_nsec = nodestats::NowInNsec();
   }
 
-  if (run_all_kernels_inline_) {
+  if (work_queues_ && !run_all_kernels_inline_) {
+    ScheduleReadyWorkStealing(ready, inline_ready, scheduled_nsec);
+  } else if (run_all_kernels_inline_) {
     if (inline_ready == nullptr) {
       // Schedule all ready kernels from a single closure. This ensure that,
       // regardless of the `runner_` implementation, all kernels will run
@@ -1313,6 +1456,83 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
   ready->clear();
 }
 
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::ScheduleReadyWorkStealing(
+    TaggedNodeSeq* ready, TaggedNodeReadyQueue* inline_ready,
+    int64_t scheduled_nsec) {
+  // Nodes produced by a worker of this step stay on that worker's queue.
+  // Nodes produced elsewhere (the roots, or the successors of an asynchronous
+  // kernel) are spread across the queues.
+  const WorkStealingWorker& worker = current_work_stealing_worker;
+  const int queue_id = worker.queues == work_queues_.get()
+                           ? worker.queue_id
+                           : work_queues_->NextQueueId();
+  size_t num_pushed = 0;
+  if (inline_ready == nullptr) {
+    work_queues_->PushBack(queue_id, ready->begin(), ready->end());
+    num_pushed = ready->size();
+  } else {
+    const TaggedNode* curr_expensive_node = nullptr;
+    for (auto& tagged_node : *ready) {
+      const NodeItem& item = *tagged_node.node_item;
+      if (tagged_node.get_is_dead() || !kernel_stats_->IsExpensive(item)) {
+        // Inline this inexpensive node.
+        inline_ready->push_back(tagged_node);
+      } else {
+        if (curr_expensive_node) {
+          work_queues_->PushBack(queue_id, *curr_expensive_node);
+          ++num_pushed;
+        }
+        curr_expensive_node = &tagged_node;
+      }
+    }
+    if (curr_expensive_node) {
+      if (inline_ready->empty()) {
+        inline_ready->push_back(*curr_expensive_node);
+      } else {
+        // Leave the expensive node on this worker's queue. It runs after the
+        // inline nodes, unless an idle worker steals it first.
+        work_queues_->PushBack(queue_id, *curr_expensive_node);
+        ++num_pushed;
+      }
+    }
+  }
+  if (num_pushed > 0) MaybeStartWorkers(num_pushed, scheduled_nsec);
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::MaybeStartWorkers(
+    size_t num_nodes, int64_t scheduled_nsec) {
+  for (size_t i = 0; i < num_nodes && work_queues_->TryStartWorker(); ++i) {
+    RunTask(
+        [this, queues = work_queues_, queue_id = work_queues_->NextQueueId(),
+         scheduled_nsec]() mutable {
+          RunWorker(this, std::move(queues), queue_id, scheduled_nsec);
+        },
+        /*sample_rate=*/num_nodes);
+  }
+}
+
+template <class PropagatorStateType>
+void ExecutorState<PropagatorStateType>::RunWorker(
+    ExecutorState* state, std::shared_ptr<WorkQueues> queues, int queue_id,
+    int64_t scheduled_nsec) {
+  // Restore the previous worker on exit, in case this worker runs inline in a
+  // kernel of another work-stealing executor.
+  const WorkStealingWorker prev_worker = current_work_stealing_worker;
+  current_work_stealing_worker.queues = queues.get();
+  current_work_stealing_worker.queue_id = queue_id;
+  do {
+    absl::optional<TaggedNode> tagged_node;
+    while ((tagged_node = queues->PopBack(queue_id)) ||
+           (tagged_node = queues->Steal(queue_id))) {
+      // A node is outstanding, so `state` has not been deleted yet.
+      state->Process(*tagged_node, scheduled_nsec);
+    }
+  } while (!queues->RetireWorker());
+  current_work_stealing_worker = prev_worker;
+}
+
 template <class PropagatorStateType>
 void ExecutorState<PropagatorStateType>::ScheduleFinish() {
   // Checks condition to decide if needs to invoke Finish(). If there are
@@ -1448,17 +1668,47 @@ void ExecutorState<PropagatorStateType>::Finish() {
   }
 }
 
+void ExecutorImpl::ExportCostEstimates(const Graph& graph,
+                                       CostModel* cost_model) const {
+  const GraphView& gview = immutable_state_.graph_view();
+  for (const Node* n : graph.nodes()) {
+    if (n->id() >= gview.num_nodes()) continue;
+    const NodeItem* item = gview.node(n->id());
+    if (item == nullptr || !kernel_stats_.IsCostTracked(*item)) continue;
+    const auto estimate = profile_utils::CpuUtils::ConvertClockCycleToTime(
+        kernel_stats_.CostEstimate(*item));
+    cost_model->RecordCount(n, 1);
+    cost_model->RecordTime(
+        n, Microseconds(
+               std::chrono::duration_cast<std::chrono::microseconds>(estimate)
+                   .count()));
+  }
+}
+
 void ExecutorImpl::RunAsync(const Args& args, DoneCallback done) {
   if (OpOrderDeterminismRequired()) {
+    // Work stealing would not preserve the deterministic op order.
     (new ExecutorState<OrderedPropagatorState>(args, immutable_state_,
                                                &kernel_stats_))
         ->RunAsync(std::move(done));
   } else if (immutable_state_.requires_control_flow_support()) {
-    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
+    (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_,
+                                        max_work_stealing_workers_))
         ->RunAsync(std::move(done));
+  } else if (static_memory_arena_) {
+    // The arena plans the outputs once enough steps have completed.
+    StaticMemoryArena* arena = static_memory_arena_.get();
+    (new ExecutorState<SimplePropagatorState>(
+         args, immutable_state_, &kernel_stats_, max_work_stealing_workers_,
+         arena))
+        ->RunAsync([arena, done = std::move(done)](const Status& s) {
+          arena->StepDone();
+          done(s);
+        });
   } else {
     (new ExecutorState<SimplePropagatorState>(args, immutable_state_,
-                                              &kernel_stats_))
+                                              &kernel_stats_,
+                                              max_work_stealing_workers_))
         ->RunAsync(std::move(done));
   }
 }
@@ -1477,6 +1727,40 @@ Status NewLocalExecutor(const LocalExecutorParams& params, const Graph& graph,
   return s;
 }
 
+namespace {
+
+// Returns the maximum number of concurrent workers per step of a
+// work-stealing executor. Defaults to the number of schedulable CPUs, and can
+// be overridden with the TF_WORK_STEALING_EXECUTOR_MAX_WORKERS environment
+// variable.
+int MaxWorkStealingWorkers() {
+  static const int max_workers = [] {
+    int64_t value;
+    Status s = ReadInt64FromEnvVar("TF_WORK_STEALING_EXECUTOR_MAX_WORKERS",
+                                   port::MaxParallelism(), &value);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+      value = port::MaxParallelism();
+    }
+    return static_cast<int>(std::max<int64_t>(value, 1));
+  }();
+  return max_workers;
+}
+
+}  // namespace
+
+Status NewWorkStealingLocalExecutor(const LocalExecutorParams& params,
+                                    const Graph& graph, Executor** executor) {
+  ExecutorImpl* impl = new ExecutorImpl(params, MaxWorkStealingWorkers());
+  const Status s = impl->Initialize(graph);
+  if (s.ok()) {
+    *executor = impl;
+  } else {
+    delete impl;
+  }
+  return s;
+}
+
 Status CreateNonCachedKernel(Device* device, FunctionLibraryRuntime* flib,
                              const std::shared_ptr<const NodeProperties>& props,
                              int graph_def_version, OpKernel** kernel) {
@@ -1512,6 +1796,25 @@ class DefaultExecutorRegistrar {
 };
 static DefaultExecutorRegistrar registrar;
 
+class WorkStealingExecutorRegistrar {
+ public:
+  WorkStealingExecutorRegistrar() {
+    ExecutorFactory::Register("WORK_STEALING", new Factory);
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret = nullptr;
+      TF_RETURN_IF_ERROR(NewWorkStealingLocalExecutor(params, graph, &ret));
+      out_executor->reset(ret);
+      return OkStatus();
+    }
+  };
+};
+static WorkStealingExecutorRegistrar work_stealing_registrar;
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -34,6 +34,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class CostModel;
 class StepStatsCollector;
 
 // Executor runs a graph computation.
@@ -122,6 +123,13 @@ class Executor {
   typedef std::function<void(const Status&)> DoneCallback;
   virtual void RunAsync(const Args& args, DoneCallback done) = 0;
 
+  // Records the executor's current estimate of the execution time of the
+  // nodes of "graph", which must be the graph this executor was created
+  // from, in "cost_model". Executors that do not measure kernel costs record
+  // nothing.
+  virtual void ExportCostEstimates(const Graph& graph,
+                                   CostModel* cost_model) const {}
+
   // Synchronous wrapper for RunAsync().
   virtual Status Run(const Args& args) {
     Status ret;
@@ -145,6 +153,14 @@ class Executor {
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph& graph, Executor** executor);
 
+// Like `NewLocalExecutor()`, but the returned executor keeps one queue of ready
+// nodes per worker thread and lets idle workers steal nodes from the other
+// queues, instead of dispatching each expensive node as a separate closure on
+// the inter-op thread pool. Also available as the "WORK_STEALING" executor
+// type through `ExecutorFactory`.
+::tensorflow::Status NewWorkStealingLocalExecutor(
+    const LocalExecutorParams& params, const Graph& graph, Executor** executor);
+
 // A class to help run multiple executors in parallel and wait until
 // all of them are complete.
 //
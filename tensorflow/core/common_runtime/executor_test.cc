@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/common_runtime/lower_functional_ops.h"
@@ -37,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/graph/testlib.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
@@ -86,9 +88,16 @@ class ExecutorTest : public ::testing::Test {
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
+    params.dispatch_by_measured_cost = dispatch_by_measured_cost_;
     rendez_ = NewLocalRendezvous();
     delete exec_;
-    TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    if (executor_type_.empty()) {
+      TF_CHECK_OK(NewLocalExecutor(params, *graph, &exec_));
+    } else {
+      std::unique_ptr<Executor> executor;
+      TF_CHECK_OK(NewExecutor(executor_type_, params, *graph, &executor));
+      exec_ = executor.release();
+    }
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
   }
 
@@ -101,6 +110,11 @@ class ExecutorTest : public ::testing::Test {
   }
 
   thread::ThreadPool* thread_pool_ = nullptr;
+  // If non-empty, `Create()` uses the `ExecutorFactory` registered for this
+  // type instead of `NewLocalExecutor()`.
+  string executor_type_;
+  // Value of `LocalExecutorParams::dispatch_by_measured_cost` in `Create()`.
+  bool dispatch_by_measured_cost_ = false;
   std::unique_ptr<Device> device_;
   Executor* exec_ = nullptr;
   StepStatsCollector step_stats_collector_;
@@ -211,6 +225,51 @@ TEST_F(ExecutorTest, SelfAdd) {
   EXPECT_EQ(1024.0, V(out));  // b=v10=2*v9=4*v8=...=1024*a=1024.0
 }
 
+// Builds "b <- 2^N * a" as a chain of N additions.
+void BuildSelfAddChain(int N, Graph* g) {
+  auto v = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g, v, v);
+  }
+  test::graph::Send(g, v, "b", BOB, 1, ALICE);
+}
+
+TEST_F(ExecutorTest, DispatchByMeasuredCost) {
+  dispatch_by_measured_cost_ = true;
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildSelfAddChain(10, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(1024.0, V(out));
+    rendez->Unref();
+  }
+
+  // The executor graph was consumed by `Create()`, so rebuild an identical
+  // graph to look up the nodes in the cost model.
+  Graph graph(OpRegistry::Global());
+  BuildSelfAddChain(10, &graph);
+  CostModel cost_model(/*is_global=*/false);
+  cost_model.InitFromGraph(graph);
+  exec_->ExportCostEstimates(graph, &cost_model);
+  int num_add_nodes = 0;
+  for (const Node* n : graph.op_nodes()) {
+    if (n->type_string() != "Add") continue;
+    ++num_add_nodes;
+    EXPECT_EQ(cost_model.TotalCount(n), 1) << n->name();
+    EXPECT_GE(cost_model.TotalTime(n), Microseconds(0)) << n->name();
+  }
+  EXPECT_EQ(num_add_nodes, 10);
+}
+
 // Builds a graph which adds N copies of one variable "in". I.e.,
 //     a + a + a + ... + a
 // The returned graph is parenthesized ramdonly. I.e.,
@@ -298,6 +357,67 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
 }
 #endif
 
+class WorkStealingExecutorTest : public ExecutorTest {
+ protected:
+  WorkStealingExecutorTest() { executor_type_ = "WORK_STEALING"; }
+};
+
+TEST_F(WorkStealingExecutorTest, RandomTree) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 4; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+#ifndef THREAD_SANITIZER
+TEST_F(WorkStealingExecutorTest, ConcurrentAddAssign) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildConcurrentAddAssign(g.get());
+  Create(std::move(g));
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
+#endif
+
+TEST_F(WorkStealingExecutorTest, SimpleSwitchDead) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Constant(g.get(), VB(true));
+  auto tmp = test::graph::Switch(g.get(), in0, in1);
+  test::graph::Send(g.get(), tmp, "c", BOB, 1, ALICE);
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));  // in0 = 1.0
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_TRUE(is_dead);
+}
+
 TEST_F(ExecutorTest, SimpleSwitchLive) {
   auto g = std::make_unique<Graph>(OpRegistry::Global());
   auto in0 = test::graph::Recv(g.get(), "a", "float", ALICE, 1, BOB);
@@ -90,6 +90,12 @@ GPUBFCAllocator::GPUBFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
           o.garbage_collection = GetGarbageCollectionValue();
         }
         o.fragmentation_fraction = opts.fragmentation_fraction;
+        o.small_chunk_cache = opts.small_chunk_cache;
+        o.allocation_timeline_size = opts.allocation_timeline_size;
+        o.fragmentation_sampling_interval_micros =
+            opts.fragmentation_sampling_interval_micros;
+        o.release_free_memory_interval_micros =
+            opts.release_free_memory_interval_micros;
         return o;
       }()) {}
 
@@ -50,6 +50,12 @@ class GPUBFCAllocator : public BFCAllocator {
 
     double fragmentation_fraction = 0;
     bool allow_retry_on_failure = true;
+
+    // See BFCAllocator::Options.
+    bool small_chunk_cache = false;
+    int64_t allocation_timeline_size = 0;
+    int64_t fragmentation_sampling_interval_micros = 0;
+    int64_t release_free_memory_interval_micros = 0;
   };
 
   GPUBFCAllocator(std::unique_ptr<SubAllocator> sub_allocator,
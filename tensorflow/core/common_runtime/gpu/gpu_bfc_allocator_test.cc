@@ -21,6 +21,7 @@ limitations under the License.
 #include <algorithm>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/compiler/xla/stream_executor/gpu/gpu_driver.h"
 #include "tensorflow/core/common_runtime/device/device_id.h"
 #include "tensorflow/core/common_runtime/device/device_id_utils.h"
@@ -31,7 +32,9 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/platform/test.h"
@@ -329,9 +332,227 @@ TEST_P(GPUBFCAllocatorTest, DISABLED_AllocatorReceivesZeroMemory) {
   b.DeallocateRaw(bmem);
 }
 
+TEST_P(GPUBFCAllocatorTest, SmallChunkCache) {
+  GPUBFCAllocator::Options options;
+  options.small_chunk_cache = true;
+  GPUBFCAllocator a(GetParam()(1ull << 32), 1 << 30, "GPU_0_bfc", options);
+
+  void* first_ptr = a.AllocateRaw(1, 1000);
+  a.DeallocateRaw(first_ptr);
+  // The cached chunk is not counted as in use.
+  CheckStats(&a, 1, 0, 1024, 1024);
+
+  // An allocation of the same rounded size reuses the cached chunk.
+  void* second_ptr = a.AllocateRaw(1, 1024);
+  EXPECT_EQ(first_ptr, second_ptr);
+  CheckStats(&a, 2, 1024, 1024, 1024);
+
+  // Allocations of other sizes, or above the cacheable size, use the bins.
+  void* other_ptr = a.AllocateRaw(1, 2048);
+  void* large_ptr = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(first_ptr, other_ptr);
+  EXPECT_NE(first_ptr, large_ptr);
+
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->num_cache_hits, 1);
+  EXPECT_EQ(stats->num_cache_misses, 2);
+
+  a.DeallocateRaw(second_ptr);
+  a.DeallocateRaw(other_ptr);
+  a.DeallocateRaw(large_ptr);
+  EXPECT_EQ(a.GetStats()->bytes_in_use, 0);
+}
+
+TEST_P(GPUBFCAllocatorTest, SmallChunkCacheIsFlushedBeforeFailing) {
+  GPUBFCAllocator::Options options;
+  options.small_chunk_cache = true;
+  // Configure a 2MiB byte limit.
+  GPUBFCAllocator a(GetParam()(1ull << 32), 2 << 20, "GPU_0_bfc", options);
+
+  // Fill most of the memory with small chunks, and cache all of them.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 32; ++i) {
+    void* raw = a.AllocateRaw(1, 60 << 10);
+    ASSERT_NE(nullptr, raw);
+    ptrs.push_back(raw);
+  }
+  for (void* raw : ptrs) {
+    a.DeallocateRaw(raw);
+  }
+
+  // The cached chunks are merged back to satisfy a large allocation.
+  void* large_ptr = a.AllocateRaw(1, 1 << 20);
+  EXPECT_NE(nullptr, large_ptr);
+  a.DeallocateRaw(large_ptr);
+}
+
+TEST_P(GPUBFCAllocatorTest, SmallChunkCacheConcurrentAllocations) {
+  GPUBFCAllocator::Options options;
+  options.small_chunk_cache = true;
+  GPUBFCAllocator a(GetParam()(1ull << 32), 1 << 30, "GPU_0_bfc", options);
+
+  constexpr int kNumThreads = 8;
+  constexpr int kNumIterations = 1000;
+  mutex mu;
+  absl::flat_hash_set<void*> live_ptrs;
+  {
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&a, &mu, &live_ptrs, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < kNumIterations; ++i) {
+          if (ptrs.empty() || rand.Uniform(2) == 0) {
+            void* raw = a.AllocateRaw(1, 256 * (1 + rand.Uniform(8)));
+            CHECK(raw != nullptr);
+            mutex_lock l(mu);
+            CHECK(live_ptrs.insert(raw).second) << "Duplicate pointer " << raw;
+            ptrs.push_back(raw);
+          } else {
+            void* raw = ptrs.back();
+            ptrs.pop_back();
+            {
+              mutex_lock l(mu);
+              live_ptrs.erase(raw);
+            }
+            a.DeallocateRaw(raw);
+          }
+        }
+        for (void* raw : ptrs) {
+          {
+            mutex_lock l(mu);
+            live_ptrs.erase(raw);
+          }
+          a.DeallocateRaw(raw);
+        }
+      });
+    }
+  }
+  EXPECT_TRUE(live_ptrs.empty());
+  absl::optional<AllocatorStats> stats = a.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->bytes_in_use, 0);
+  EXPECT_GT(stats->num_cache_hits, 0);
+}
+
+TEST_P(GPUBFCAllocatorTest, AllocationTimeline) {
+  GPUBFCAllocator::Options options;
+  options.allocation_timeline_size = 3;
+  GPUBFCAllocator a(GetParam()(1ull << 32), 1 << 30, "GPU_0_bfc", options);
+
+  void* first_ptr = a.AllocateRaw(1, 1000);
+  void* second_ptr = a.AllocateRaw(1, 5000);
+  a.DeallocateRaw(first_ptr);
+  a.DeallocateRaw(second_ptr);
+
+  // Only the last three events are kept.
+  std::vector<BFCAllocator::AllocationEvent> events =
+      a.GetAllocationTimeline();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_TRUE(events[0].is_allocation);
+  EXPECT_EQ(events[0].chunk_bytes, 5120);
+  EXPECT_EQ(events[0].requested_bytes, 5000);
+  EXPECT_EQ(events[0].bytes_in_use, 1024 + 5120);
+  EXPECT_FALSE(events[1].is_allocation);
+  EXPECT_EQ(events[1].chunk_bytes, 1024);
+  EXPECT_EQ(events[1].bin_num, 2);
+  EXPECT_EQ(events[1].bytes_in_use, 5120);
+  EXPECT_FALSE(events[2].is_allocation);
+  EXPECT_EQ(events[2].bytes_in_use, 0);
+  EXPECT_LE(events[0].timestamp_micros, events[2].timestamp_micros);
+}
+
+TEST_P(GPUBFCAllocatorTest, RegionFragmentation) {
+  GPUBFCAllocator::Options options;
+  options.fragmentation_sampling_interval_micros = 1;
+  // Configure a 2MiB byte limit, so there is a single region.
+  GPUBFCAllocator a(GetParam()(1ull << 32), 2 << 20, "GPU_0_bfc", options);
+
+  // Free every other chunk, so the free memory is split into small chunks.
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 8; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 64 << 10));
+  }
+  for (int i = 0; i < 8; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+
+  std::vector<BFCAllocator::RegionFragmentation> regions =
+      a.GetRegionFragmentation();
+  ASSERT_EQ(regions.size(), 1);
+  EXPECT_EQ(regions[0].region_bytes, 2 << 20);
+  EXPECT_EQ(regions[0].free_bytes, (2 << 20) - 4 * (64 << 10));
+  // The tail of the region is the largest free chunk.
+  EXPECT_EQ(regions[0].largest_free_chunk_bytes, (2 << 20) - 8 * (64 << 10));
+  EXPECT_EQ(regions[0].num_free_chunks, 5);
+
+  for (int i = 1; i < 8; i += 2) {
+    a.DeallocateRaw(ptrs[i]);
+  }
+  regions = a.GetRegionFragmentation();
+  ASSERT_EQ(regions.size(), 1);
+  EXPECT_EQ(regions[0].free_bytes, 2 << 20);
+  EXPECT_EQ(regions[0].largest_free_chunk_bytes, 2 << 20);
+  EXPECT_EQ(regions[0].num_free_chunks, 1);
+}
+
 INSTANTIATE_TEST_SUITE_P(GPUBFCAllocatorTestSuite, GPUBFCAllocatorTest,
                          TestSuiteValues());
 
+#if CUDA_VERSION >= 10020
+TEST(GPUBFCAllocatorReleaseTest, ReleasesFreeMemory) {
+  constexpr size_t k2MiB = 2 << 20;
+  PlatformDeviceId gpu_id(0);
+  auto executor =
+      DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(), gpu_id)
+          .ValueOrDie();
+  auto* gpu_context = reinterpret_cast<stream_executor::gpu::GpuContext*>(
+      executor->implementation()->GpuContextHack());
+  std::unique_ptr<SubAllocator> sub_allocator =
+      GpuVirtualMemAllocator::Create({}, {}, *gpu_context, gpu_id,
+                                     /*virtual_address_space_size=*/64 * k2MiB,
+                                     {}, /*decommit_granularity=*/k2MiB)
+          .ValueOrDie();
+  if (sub_allocator->DecommitGranularity() != k2MiB) {
+    GTEST_SKIP() << "The allocation granularity is larger than 2MiB.";
+  }
+  GPUBFCAllocator::Options options;
+  // Only release free memory on demand.
+  options.release_free_memory_interval_micros = 3600 * 1000000LL;
+  options.allow_retry_on_failure = false;
+  // A single 8MiB region.
+  GPUBFCAllocator a(std::move(sub_allocator), 4 * k2MiB, "GPU_0_bfc",
+                    options);
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, k2MiB));
+    ASSERT_NE(ptrs.back(), nullptr);
+  }
+  // Leave two free chunks that are not contiguous.
+  a.DeallocateRaw(ptrs[0]);
+  a.DeallocateRaw(ptrs[2]);
+
+  // No free chunk fits, but their memory backs a new region.
+  void* large = a.AllocateRaw(1, 2 * k2MiB);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(a.GetStats()->bytes_in_use, 4 * k2MiB);
+  EXPECT_EQ(a.ReleaseFreeMemory(), 0);
+
+  // Freed chunks are committed again when reused.
+  a.DeallocateRaw(ptrs[1]);
+  EXPECT_EQ(a.ReleaseFreeMemory(), k2MiB);
+  EXPECT_EQ(a.AllocateRaw(1, k2MiB), ptrs[0]);
+  EXPECT_EQ(a.AllocateRaw(1, 3 * k2MiB), nullptr);
+
+  a.DeallocateRaw(ptrs[0]);
+  a.DeallocateRaw(ptrs[3]);
+  a.DeallocateRaw(large);
+}
+#endif
+
 static void BM_Allocation(::testing::benchmark::State& state) {
   GPUBFCAllocator a(CreateSubAllocator(1ul << 36), 1uLL << 33, "GPU_0_bfc", {});
   // Exercise a few different allocation sizes
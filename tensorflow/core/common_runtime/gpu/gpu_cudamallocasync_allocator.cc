@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <utility>
+
 #include "absl/types/optional.h"
 #ifdef GOOGLE_CUDA
 #include "third_party/gpus/cuda/include/cuda.h"
@@ -41,6 +44,32 @@ static std::string GetCudaErrorMessage(CUresult result) {
 }
 #endif  // GOOGLE_CUDA
 
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+// The pools of all the instantiated allocators and their GPUs, so that each
+// new pool gets access to the other GPUs.
+static std::vector<CUmemoryPool*>* AllPools() {
+  static auto* all_pools = new std::vector<CUmemoryPool*>();
+  return all_pools;
+}
+static std::vector<PlatformDeviceId>* AllPoolIds() {
+  static auto* all_ids = new std::vector<PlatformDeviceId>();
+  return all_ids;
+}
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+// Returns the value of a statistic of `pool`, or 0 on error.
+static int64_t GetPoolStatistic(CUmemoryPool pool, CUmemPool_attribute attr) {
+  cuuint64_t value = 0;
+  if (auto result = cuMemPoolGetAttribute(pool, attr, &value)) {
+    LOG(ERROR) << "Error while fetching extra cudaMallocAsync pool attribute: "
+               << GetCudaErrorMessage(result);
+    return 0;
+  }
+  return static_cast<int64_t>(value);
+}
+#endif
+
 void GpuCudaMallocAsyncAllocator::PrintAllocatorStatistics() {
   mutex_lock lock(lock_);
 
@@ -100,6 +129,12 @@ std::atomic<int> GpuCudaMallocAsyncAllocator::number_instantiated_(0);
 GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
     PlatformDeviceId platform_device_id, size_t pool_size, bool reserve_memory,
     bool compute_stats)
+    : GpuCudaMallocAsyncAllocator(platform_device_id, pool_size, Options(),
+                                  reserve_memory, compute_stats) {}
+
+GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
+    PlatformDeviceId platform_device_id, size_t pool_size,
+    const Options& options, bool reserve_memory, bool compute_stats)
     : name_(absl::StrCat("gpu_async_", platform_device_id.value())),
       reserve_memory_(reserve_memory) {
   ++number_instantiated_;
@@ -164,15 +199,26 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
            "old, "
         << " OS not supported, CUDA version too old(request CUDA11.2+).";
 
-  if (auto status =
-          cuDeviceGetDefaultMemPool(&pool_, platform_device_id.value()))
+  if (options.private_pool) {
+    CUmemPoolProps props = {};
+    props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+    props.handleTypes = CU_MEM_HANDLE_TYPE_NONE;
+    props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    props.location.id = platform_device_id.value();
+    if (auto status = cuMemPoolCreate(&pool_, &props))
+      LOG(FATAL) <<  // Crash OK.
+          "Failed to create a CUDA pool: " << GetCudaErrorMessage(status);
+    owns_pool_ = true;
+  } else if (auto status = cuDeviceGetDefaultMemPool(
+                 &pool_, platform_device_id.value())) {
     LOG(FATAL) <<  // Crash OK.
         "Failed to get default CUDA pool: " << GetCudaErrorMessage(status);
+  }
 
   VLOG(1) << Name() << " CudaMallocAsync initialized on platform: "
           << platform_device_id.value() << " with pool size of: " << pool_size
-          << " this ptr: " << this;
-  uint64_t pool_size_64 = pool_size;
+          << (owns_pool_ ? " in a private pool" : "") << " this ptr: " << this;
+  uint64_t pool_size_64 = options.release_threshold.value_or(pool_size);
   if (auto status = cuMemPoolSetAttribute(
           pool_, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD, &pool_size_64))
     LOG(FATAL) <<  // Crash OK.
@@ -189,24 +235,28 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
   TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar("TF_DETERMINISTIC_ALLOCATOR",
                                              /*default_val=*/false,
                                              &deterministic));
-  if (deterministic) {
+  // The driver enables all the reuse policies by default, so only the
+  // disabled ones are set.
+  const std::pair<CUmemPool_attribute, bool> reuse_policies[] = {
+      {CU_MEMPOOL_ATTR_REUSE_FOLLOW_EVENT_DEPENDENCIES,
+       options.reuse_follow_event_dependencies},
+      {CU_MEMPOOL_ATTR_REUSE_ALLOW_OPPORTUNISTIC,
+       options.reuse_allow_opportunistic && !deterministic},
+      {CU_MEMPOOL_ATTR_REUSE_ALLOW_INTERNAL_DEPENDENCIES,
+       options.reuse_allow_internal_dependencies && !deterministic},
+  };
+  for (const auto& policy : reuse_policies) {
+    if (policy.second) continue;
     int disable = 0;
-    if (auto status = cuMemPoolSetAttribute(
-            pool_, CU_MEMPOOL_ATTR_REUSE_ALLOW_OPPORTUNISTIC, &disable)) {
-      LOG(FATAL) <<  // Crash OK.
-          "Failed to set CUDA pool attribute: " << GetCudaErrorMessage(status);
-    }
-    if (auto status = cuMemPoolSetAttribute(
-            pool_, CU_MEMPOOL_ATTR_REUSE_ALLOW_INTERNAL_DEPENDENCIES,
-            &disable)) {
+    if (auto status = cuMemPoolSetAttribute(pool_, policy.first, &disable)) {
       LOG(FATAL) <<  // Crash OK.
           "Failed to set CUDA pool attribute: " << GetCudaErrorMessage(status);
     }
   }
 
   // Set read/write access to all GPUs.
-  static auto* all_pools_ = new std::vector<CUmemoryPool*>();
-  static auto* all_ids_ = new std::vector<PlatformDeviceId>();
+  auto* all_pools_ = AllPools();
+  auto* all_ids_ = AllPoolIds();
   DCHECK(all_pools_->size() == all_ids_->size());
   for (int i = 0; i < all_pools_->size(); ++i) {
     // Set the current pool access to the previous GPUs.
@@ -266,7 +316,23 @@ GpuCudaMallocAsyncAllocator::GpuCudaMallocAsyncAllocator(
 #endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
 }
 
-GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {}
+GpuCudaMallocAsyncAllocator::~GpuCudaMallocAsyncAllocator() {
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED
+  auto* all_pools = AllPools();
+  auto it = std::find(all_pools->begin(), all_pools->end(), &pool_);
+  if (it != all_pools->end()) {
+    AllPoolIds()->erase(AllPoolIds()->begin() + (it - all_pools->begin()));
+    all_pools->erase(it);
+  }
+  // The driver releases the pool once its outstanding allocations are freed.
+  if (owns_pool_ && pool_ != nullptr) {
+    if (auto status = cuMemPoolDestroy(pool_)) {
+      LOG(ERROR) << "Failed to destroy the CUDA pool of " << Name() << ": "
+                 << GetCudaErrorMessage(status);
+    }
+  }
+#endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
+}
 
 void* GpuCudaMallocAsyncAllocator::AllocateRaw(size_t alignment,
                                                size_t num_bytes) {
@@ -372,7 +438,20 @@ size_t GpuCudaMallocAsyncAllocator::AllocatedSize(const void* ptr) const {
 absl::optional<AllocatorStats> GpuCudaMallocAsyncAllocator::GetStats() {
   if (!stats_) return absl::nullopt;
   mutex_lock l(lock_);
-  return *stats_;
+  AllocatorStats stats = *stats_;
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  if (pool_ != nullptr) {
+    stats.bytes_reserved =
+        GetPoolStatistic(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT);
+    stats.peak_bytes_reserved =
+        GetPoolStatistic(pool_, CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH);
+    stats.pool_bytes_in_use =
+        GetPoolStatistic(pool_, CU_MEMPOOL_ATTR_USED_MEM_CURRENT);
+    stats.peak_pool_bytes_in_use =
+        GetPoolStatistic(pool_, CU_MEMPOOL_ATTR_USED_MEM_HIGH);
+  }
+#endif
+  return stats;
 }
 
 bool GpuCudaMallocAsyncAllocator::ClearStats() {
@@ -381,6 +460,20 @@ bool GpuCudaMallocAsyncAllocator::ClearStats() {
   stats_->num_allocs = 0;
   stats_->peak_bytes_in_use = stats_->bytes_in_use;
   stats_->largest_alloc_size = 0;
+#if TF_CUDA_MALLOC_ASYNC_SUPPORTED && CUDA_VERSION >= 11030
+  // Setting the high watermarks of the pool to 0 resets them to the current
+  // values.
+  if (pool_ != nullptr) {
+    for (CUmemPool_attribute attr :
+         {CU_MEMPOOL_ATTR_RESERVED_MEM_HIGH, CU_MEMPOOL_ATTR_USED_MEM_HIGH}) {
+      cuuint64_t zero = 0;
+      if (auto result = cuMemPoolSetAttribute(pool_, attr, &zero)) {
+        LOG(ERROR) << "Error while resetting a cudaMallocAsync pool attribute: "
+                   << GetCudaErrorMessage(result);
+      }
+    }
+  }
+#endif
   return true;
 }
 
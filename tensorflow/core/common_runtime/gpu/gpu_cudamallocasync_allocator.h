@@ -23,6 +23,7 @@ limitations under the License.
 #endif  // GOOGLE_CUDA
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_id.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/macros.h"
@@ -62,12 +63,39 @@ namespace tensorflow {
 // Here, the pool_size isn't the absolute max as for [Gpu]BFCAllocator.
 // The pool can grow above that up to the total GPU memory.  But the
 // driver can return the excess memory to other processes.
+//
+// By default, all the allocators of a GPU share its default pool. With
+// `Options::private_pool`, an allocator creates its own, so that the
+// allocators of different streams or tenants on one GPU have their own
+// release threshold, reuse policies and pool statistics.
 class GpuCudaMallocAsyncAllocator : public Allocator {
  public:
+  struct Options {
+    // If true, allocates from a pool created for this allocator instead of
+    // the default pool of the GPU.
+    bool private_pool = false;
+
+    // The number of bytes that the pool keeps reserved when memory is freed
+    // instead of releasing them to the driver. If not set, pool_size.
+    absl::optional<size_t> release_threshold;
+
+    // The CU_MEMPOOL_ATTR_REUSE_* policies of the pool. The last two are
+    // disabled if TF_DETERMINISTIC_ALLOCATOR is set. As the default pool is
+    // shared, disabling a policy there also disables it for the other
+    // allocators of the GPU.
+    bool reuse_follow_event_dependencies = true;
+    bool reuse_allow_opportunistic = true;
+    bool reuse_allow_internal_dependencies = true;
+  };
+
   explicit GpuCudaMallocAsyncAllocator(PlatformDeviceId platform_device_id,
                                        size_t pool_size,
                                        bool reserve_memory = false,
                                        bool compute_stats = true);
+  GpuCudaMallocAsyncAllocator(PlatformDeviceId platform_device_id,
+                              size_t pool_size, const Options& options,
+                              bool reserve_memory = false,
+                              bool compute_stats = true);
   ~GpuCudaMallocAsyncAllocator() override;
   string Name() override { return name_; }
   void* AllocateRaw(size_t alignment, size_t num_bytes) override;
@@ -79,6 +107,9 @@ class GpuCudaMallocAsyncAllocator : public Allocator {
 
   size_t AllocatedSize(const void* ptr) const override;
 
+  // If CUDA_VERSION >= 11030, bytes_reserved, pool_bytes_in_use and their
+  // peaks are those of the pool, so include the allocations of the other
+  // allocators that share the default pool.
   absl::optional<AllocatorStats> GetStats() override;
 
   bool ClearStats() override;
@@ -108,10 +139,12 @@ class GpuCudaMallocAsyncAllocator : public Allocator {
   // Not owned.
   CUstream cuda_stream_;
 
-  // Not owned. The default pool of the associated GPU.
+  // The default pool of the associated GPU, not owned, or the private pool
+  // of this allocator, owned.
   // If null, then the instanciation failed and the first allocation
   // will return an error.
   CUmemoryPool pool_;
+  bool owns_pool_ = false;
 #endif  // TF_CUDA_MALLOC_ASYNC_SUPPORTED
 
   // Just a counter for the number of time this class is instantiated.
@@ -28,8 +28,10 @@ limitations under the License.
 #include <string.h>
 
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include <map>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -384,6 +386,144 @@ class BaseGPUDevice::StreamGroupFactory {
   TF_DISALLOW_COPY_AND_ASSIGN(StreamGroupFactory);
 };
 
+namespace {
+
+// The maximum value of TF_GPU_NUM_COMPUTE_STREAMS.
+constexpr int kMaxComputeStreams = 8;
+
+// Wraps the GPU allocator of a device that runs kernels on several compute
+// streams. The allocator does not know which streams use a buffer, so a buffer
+// freed once its last use is queued on one stream could be handed out to a
+// kernel of another stream while the first stream still runs. Instead, freed
+// buffers go back to the allocator once every compute stream has completed
+// the work queued before they were freed. Frees are batched, so that at most
+// one set of events is pending at a time.
+class MultiStreamAllocator : public Allocator {
+ public:
+  MultiStreamAllocator(Allocator* base_allocator, EventMgr* em,
+                       std::vector<se::Stream*> streams)
+      : base_allocator_(base_allocator),
+        em_(em),
+        streams_(std::move(streams)) {}
+
+  ~MultiStreamAllocator() override {
+    mutex_lock l(mu_);
+    while (flush_in_flight_) flush_done_.wait(l);
+  }
+
+  string Name() override { return base_allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return base_allocator_->AllocateRaw(alignment, num_bytes);
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    return base_allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == nullptr) return;
+    {
+      mutex_lock l(mu_);
+      pending_.push_back(ptr);
+      if (flush_in_flight_) return;
+      flush_in_flight_ = true;
+    }
+    Flush();
+  }
+
+  bool TracksAllocationSizes() const override {
+    return base_allocator_->TracksAllocationSizes();
+  }
+  size_t RequestedSize(const void* ptr) const override {
+    return base_allocator_->RequestedSize(ptr);
+  }
+  size_t AllocatedSize(const void* ptr) const override {
+    return base_allocator_->AllocatedSize(ptr);
+  }
+  int64_t AllocationId(const void* ptr) const override {
+    return base_allocator_->AllocationId(ptr);
+  }
+  absl::optional<AllocatorStats> GetStats() override {
+    return base_allocator_->GetStats();
+  }
+  bool ClearStats() override { return base_allocator_->ClearStats(); }
+  AllocatorMemoryType GetMemoryType() const override {
+    return base_allocator_->GetMemoryType();
+  }
+
+ private:
+  struct Batch {
+    std::vector<void*> buffers;
+    std::atomic<int> num_pending_streams{0};
+  };
+
+  // Returns the pending buffers to the base allocator once all the streams
+  // have completed the work queued so far, then flushes the buffers freed in
+  // the meantime, if any.
+  void Flush() {
+    auto batch = std::make_shared<Batch>();
+    {
+      mutex_lock l(mu_);
+      batch->buffers.swap(pending_);
+    }
+    batch->num_pending_streams = streams_.size();
+    for (se::Stream* stream : streams_) {
+      em_->ThenExecute(stream, [this, batch]() {
+        if (batch->num_pending_streams.fetch_sub(1) != 1) return;
+        for (void* ptr : batch->buffers) base_allocator_->DeallocateRaw(ptr);
+        {
+          mutex_lock l(mu_);
+          if (pending_.empty()) {
+            flush_in_flight_ = false;
+            flush_done_.notify_all();
+            return;
+          }
+        }
+        Flush();
+      });
+    }
+  }
+
+  Allocator* const base_allocator_;  // not owned
+  EventMgr* const em_;               // not owned
+  const std::vector<se::Stream*> streams_;
+
+  mutex mu_;
+  std::vector<void*> pending_ TF_GUARDED_BY(mu_);
+  bool flush_in_flight_ TF_GUARDED_BY(mu_) = false;
+  condition_variable flush_done_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MultiStreamAllocator);
+};
+
+}  // namespace
+
+// The context of an executor in multi-stream mode, which releases its compute
+// stream when the executor is done.
+class BaseGPUDevice::ExecutorDeviceContext : public GPUDeviceContext {
+ public:
+  ExecutorDeviceContext(BaseGPUDevice* device, int stream_id,
+                        const StreamGroup* group,
+                        Allocator* host_memory_allocator)
+      : GPUDeviceContext(stream_id, group->compute,
+#if TENSORFLOW_USE_ROCM
+                         group->nccl,
+#endif
+                         group->host_to_device, group->device_to_host,
+                         group->device_to_device, host_memory_allocator),
+        device_(device) {
+  }
+
+  ~ExecutorDeviceContext() override {
+    device_->ReleaseComputeStream(stream_id());
+  }
+
+ private:
+  BaseGPUDevice* device_;  // not owned
+};
+
 BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
                              Bytes memory_limit, const DeviceLocality& locality,
                              TfDeviceId tf_device_id,
@@ -406,29 +546,45 @@ BaseGPUDevice::BaseGPUDevice(const SessionOptions& options, const string& name,
 
 BaseGPUDevice::~BaseGPUDevice() {
   delete accelerator_device_info_;
-  if (scratch_) gpu_allocator_->DeallocateRaw(scratch_);
+  for (char* scratch : scratch_) {
+    if (scratch) gpu_allocator_->DeallocateRaw(scratch);
+  }
   device_context_->Unref();
+  // Waits for the deferred frees.
+  multi_stream_allocator_.reset();
 }
 
 // This should be idempotent if already initialized.
 Status BaseGPUDevice::InitScratchBuffers() {
   mutex_lock l(scratch_init_mutex_);
-  if (!scratch_) {
+  if (scratch_.empty()) {
     DCHECK(stream_);
-    size_t scratch_buffer_size = Eigen::kGpuScratchSize + sizeof(unsigned int);
-    profiler::ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
-    void* scratch_buffer = gpu_allocator_->AllocateRaw(
-        Allocator::kAllocatorAlignment, scratch_buffer_size);
-    if (scratch_buffer == nullptr) {
-      return errors::FailedPrecondition(
-          "Failed to allocate scratch buffer for device ",
-          tf_device_id_.value());
-    }
-    se::DeviceMemory<char> mem(
-        se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
-    TF_RETURN_IF_ERROR(executor_->SynchronousMemZero(
-        &mem, Eigen::kGpuScratchSize + sizeof(unsigned int)));
-    scratch_ = static_cast<char*>(scratch_buffer);
+    // Kernels of different streams may run concurrently, so each stream has
+    // its own scratch buffer.
+    for (int i = 0; i < streams_.size(); ++i) {
+      size_t scratch_buffer_size =
+          Eigen::kGpuScratchSize + sizeof(unsigned int);
+      profiler::ScopedMemoryDebugAnnotation op_annotation("ScratchBuffer");
+      void* scratch_buffer = gpu_allocator_->AllocateRaw(
+          Allocator::kAllocatorAlignment, scratch_buffer_size);
+      if (scratch_buffer == nullptr) {
+        for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
+        scratch_.clear();
+        return errors::FailedPrecondition(
+            "Failed to allocate scratch buffer for device ",
+            tf_device_id_.value());
+      }
+      se::DeviceMemory<char> mem(
+          se::DeviceMemoryBase(scratch_buffer, scratch_buffer_size));
+      Status status = executor_->SynchronousMemZero(
+          &mem, Eigen::kGpuScratchSize + sizeof(unsigned int));
+      scratch_.push_back(static_cast<char*>(scratch_buffer));
+      if (!status.ok()) {
+        for (char* scratch : scratch_) gpu_allocator_->DeallocateRaw(scratch);
+        scratch_.clear();
+        return status;
+      }
+    }
   }
   return OkStatus();
 }
@@ -443,8 +599,26 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
 
   executor_ = executor_status.ValueOrDie();
 
-  stream_ = StreamGroupFactory::Global().GetOrCreate(
-      tf_device_id_, 0, executor_, options.config.gpu_options());
+  // The number of compute streams. Above 1, each executor running on the
+  // device, e.g. the executor of a step or of a function call, uses one of
+  // the compute streams, so that the kernels of concurrent steps can run
+  // concurrently. This mode is experimental. Kernels that use the stream of
+  // tensorflow_accelerator_device_info() rather than that of their
+  // OpKernelContext are not supported.
+  int64_t num_compute_streams = 1;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_GPU_NUM_COMPUTE_STREAMS", 1,
+                                         &num_compute_streams));
+  if (num_compute_streams < 1 || num_compute_streams > kMaxComputeStreams) {
+    LOG(ERROR) << "Illegal TF_GPU_NUM_COMPUTE_STREAMS=" << num_compute_streams
+               << " set to 1 instead.";
+    num_compute_streams = 1;
+  }
+  for (int i = 0; i < num_compute_streams; ++i) {
+    streams_.push_back(StreamGroupFactory::Global().GetOrCreate(
+        tf_device_id_, i, executor_, options.config.gpu_options()));
+  }
+  stream_ = streams_[0];
+  num_executors_.resize(streams_.size(), 0);
 
   // Get an allocator that allocates pinned memory on host.
   AllocatorAttributes attr;
@@ -463,6 +637,18 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   em_ = EventMgrFactory::Singleton()->GetEventMgr(executor_,
                                                   options.config.gpu_options());
 
+  if (streams_.size() > 1) {
+    std::vector<se::Stream*> compute_streams;
+    for (const StreamGroup* group : streams_) {
+      compute_streams.push_back(group->compute);
+    }
+    multi_stream_allocator_ = std::make_unique<MultiStreamAllocator>(
+        gpu_allocator_, em_, std::move(compute_streams));
+    gpu_allocator_ = multi_stream_allocator_.get();
+    VLOG(1) << "GPU " << tf_device_id_.value() << " runs executors on "
+            << streams_.size() << " compute streams";
+  }
+
   GPUKernelTracker::Params tracker_params(
       options.config.gpu_options().experimental().kernel_tracker_max_interval(),
       options.config.gpu_options().experimental().kernel_tracker_max_bytes(),
@@ -735,7 +921,62 @@ Status BaseGPUDevice::Sync() {
   // enqueued the operation has completed.  We do use other streams for copies
   // and collectives, but in those cases the (Async)OpKernels themselves block
   // until the queued operation has finished.
-  return stream_->compute->BlockHostUntilDone();
+  for (StreamGroup* group : streams_) {
+    TF_RETURN_IF_ERROR(group->compute->BlockHostUntilDone());
+  }
+  return OkStatus();
+}
+
+Status BaseGPUDevice::TryGetDeviceContext(DeviceContext** out_context) {
+  if (streams_.size() <= 1) {
+    *out_context = nullptr;
+    return OkStatus();
+  }
+  const int stream_id = AcquireComputeStream();
+  *out_context =
+      new ExecutorDeviceContext(this, stream_id, streams_[stream_id],
+                                device_context_->host_memory_allocator());
+  return OkStatus();
+}
+
+// Executors on different streams exchange tensors without synchronizing: the
+// arguments and results of function calls, and the variables and other
+// resources shared by steps. So when an executor starts, its stream waits for
+// the work already queued on the other streams, and when it is done, the other
+// streams wait for the work it queued. Only these waits are serializing: the
+// kernels that concurrent executors queue in the meantime overlap, which is
+// what helps when the kernels are too small to fill the GPU.
+int BaseGPUDevice::AcquireComputeStream() {
+  int stream_id;
+  {
+    mutex_lock l(executors_mu_);
+    const int num_streams = streams_.size();
+    stream_id = next_stream_;
+    for (int i = 1; i < num_streams; ++i) {
+      const int candidate = (next_stream_ + i) % num_streams;
+      if (num_executors_[candidate] < num_executors_[stream_id]) {
+        stream_id = candidate;
+      }
+    }
+    next_stream_ = (stream_id + 1) % num_streams;
+    ++num_executors_[stream_id];
+  }
+  se::Stream* stream = streams_[stream_id]->compute;
+  for (int i = 0; i < streams_.size(); ++i) {
+    if (i != stream_id) stream->ThenWaitFor(streams_[i]->compute);
+  }
+  return stream_id;
+}
+
+void BaseGPUDevice::ReleaseComputeStream(int stream_id) {
+  {
+    mutex_lock l(executors_mu_);
+    --num_executors_[stream_id];
+  }
+  se::Stream* stream = streams_[stream_id]->compute;
+  for (int i = 0; i < streams_.size(); ++i) {
+    if (i != stream_id) streams_[i]->compute->ThenWaitFor(stream);
+  }
 }
 
 void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
@@ -1161,11 +1402,12 @@ void BaseGPUDevice::ReinitializeDevice(OpKernelContext* context,
   ConcretePerOpGpuDevice* concrete_device =
       static_cast<ConcretePerOpGpuDevice*>(device);
   DCHECK(concrete_device);
-  DCHECK_EQ(stream_id, 0);
+  DCHECK_GE(stream_id, 0);
+  DCHECK_LT(stream_id, num_compute_streams());
   const gpuStream_t* gpu_stream = reinterpret_cast<const gpuStream_t*>(
-      stream_->compute->implementation()->GpuStreamMemberHack());
+      streams_[stream_id]->compute->implementation()->GpuStreamMemberHack());
   concrete_device->Reinitialize(context, gpu_stream, tf_device_id_, allocator,
-                                scratch_);
+                                scratch_[stream_id]);
 }
 
 PerOpGpuDevice* BaseGPUDevice::MakeGpuDevice() {
@@ -1182,7 +1424,6 @@ Status BaseGPUDevice::ReinitializeGpuDevice(OpKernelContext* context,
     const int stream_id = gpu_dc->stream_id();
     VLOG(1) << "  eigen_gpu_device(" << dc << ") => stream[" << stream_id
             << "]";
-    CHECK_EQ(stream_id, 0);
     ReinitializeDevice(context, device, stream_id, allocator);
   } else {
     ReinitializeDevice(context, device, 0, allocator);
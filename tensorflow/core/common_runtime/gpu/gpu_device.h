@@ -90,6 +90,11 @@ class BaseGPUDevice : public LocalDevice {
 
   Status Sync() override;
 
+  // In multi-stream mode, returns a context on one of the compute streams of
+  // the device for each executor; otherwise all executors use the default
+  // context. See TF_GPU_NUM_COMPUTE_STREAMS.
+  Status TryGetDeviceContext(DeviceContext** out_context) override;
+
   void ComputeAsync(AsyncOpKernel* op_kernel, OpKernelContext* context,
                     AsyncOpKernel::DoneCallback done) override;
 
@@ -141,6 +146,10 @@ class BaseGPUDevice : public LocalDevice {
 
   int priority() const { return stream_->priority; }
 
+  // Returns the number of compute streams of this device, which is above 1 in
+  // multi-stream mode.
+  int num_compute_streams() const { return streams_.size(); }
+
   // Helper method for unit tests to reset the streams. Never use in production.
   static void TestOnlyReset();
 
@@ -168,10 +177,23 @@ class BaseGPUDevice : public LocalDevice {
     int priority = 0;
   };
   class StreamGroupFactory;
+  class ExecutorDeviceContext;
 
+  // The stream group of the default device context, i.e. streams_[0].
   StreamGroup* stream_;
+  // One stream group per compute stream.
+  gtl::InlinedVector<StreamGroup*, 4> streams_;
   mutex scratch_init_mutex_;
-  char* scratch_ = nullptr;
+  // The Eigen scratch buffer of each compute stream.
+  gtl::InlinedVector<char*, 4> scratch_;
+  // In multi-stream mode, the number of executors running on each compute
+  // stream.
+  mutex executors_mu_;
+  gtl::InlinedVector<int, 4> num_executors_ TF_GUARDED_BY(executors_mu_);
+  int next_stream_ TF_GUARDED_BY(executors_mu_) = 0;
+  // In multi-stream mode, wraps the allocator passed to the constructor to
+  // defer frees until all compute streams are done with the memory.
+  std::unique_ptr<Allocator> multi_stream_allocator_;
   GPUDeviceContext* device_context_;
   DeviceBase::AcceleratorDeviceInfo* accelerator_device_info_ = nullptr;
   mutex trace_mu_;
@@ -187,6 +209,14 @@ class BaseGPUDevice : public LocalDevice {
   // Initialize scratch buffers used by Eigen.
   Status InitScratchBuffers();
 
+  // Returns the least busy compute stream for a new executor, which is ordered
+  // after the work already queued on the other streams.
+  int AcquireComputeStream();
+
+  // Called when the executor of a stream returned by AcquireComputeStream()
+  // is done. Orders later work of other streams after the work it queued.
+  void ReleaseComputeStream(int stream_id);
+
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
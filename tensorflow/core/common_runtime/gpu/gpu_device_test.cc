@@ -202,6 +202,60 @@ TEST_F(GPUDeviceTest, DISABLED_ON_GPU_ROCM(CudaMallocAsyncPreallocate)) {
   EXPECT_EQ(status.code(), error::OK);
 }
 
+TEST_F(GPUDeviceTest, DISABLED_ON_GPU_ROCM(CudaMallocAsyncPrivatePools)) {
+  // Pool statistics are supported only when cuda toolkit and driver support
+  // CUDA 11.3+
+#ifndef GOOGLE_CUDA
+  return;
+#elif CUDA_VERSION < 11030
+  LOG(INFO) << "CUDA toolkit too old, skipping this test: " << CUDA_VERSION;
+  return;
+#else
+  int driverVersion;
+  cuDriverGetVersion(&driverVersion);
+  if (driverVersion < 11030) {
+    LOG(INFO) << "Driver version too old, skipping this test: "
+              << driverVersion;
+    return;
+  }
+
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  ASSERT_THAT(devices, SizeIs(1));
+  auto* device = static_cast<BaseGPUDevice*>(devices[0].get());
+
+  GpuCudaMallocAsyncAllocator::Options options;
+  options.private_pool = true;
+  options.release_threshold = 0;
+  GpuCudaMallocAsyncAllocator first(PlatformDeviceId(0), 1 << 20, options);
+  GpuCudaMallocAsyncAllocator second(PlatformDeviceId(0), 1 << 20, options);
+  first.SetStreamAndPreallocateMemory(device->GetStream());
+  second.SetStreamAndPreallocateMemory(device->GetStream());
+
+  void* ptr = first.AllocateRaw(Allocator::kAllocatorAlignment, 1 << 20);
+  ASSERT_NE(ptr, nullptr);
+  absl::optional<AllocatorStats> stats = first.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_GE(stats->pool_bytes_in_use, 1 << 20);
+  EXPECT_GE(stats->bytes_reserved, 1 << 20);
+  // The pools are separate.
+  stats = second.GetStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(stats->pool_bytes_in_use, 0);
+  EXPECT_EQ(stats->bytes_reserved, 0);
+
+  first.DeallocateRaw(ptr);
+  TF_ASSERT_OK(device->Sync());
+  stats = first.GetStats();
+  EXPECT_EQ(stats->pool_bytes_in_use, 0);
+  EXPECT_GE(stats->peak_pool_bytes_in_use, 1 << 20);
+  first.ClearStats();
+  EXPECT_EQ(first.GetStats()->peak_pool_bytes_in_use, 0);
+#endif
+}
+
 TEST_F(GPUDeviceTest, FailedToParseVisibleDeviceList) {
   SessionOptions opts = MakeSessionOptions("0,abc");
   std::vector<std::unique_ptr<Device>> devices;
@@ -555,6 +609,62 @@ TEST_F(GPUDeviceTest, CopyTensorInSameDevice) {
   }
 }
 
+TEST_F(GPUDeviceTest, SingleComputeStream) {
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  auto* device = static_cast<BaseGPUDevice*>(devices[0].get());
+  EXPECT_EQ(device->num_compute_streams(), 1);
+  // Executors use the default context.
+  DeviceContext* device_context;
+  TF_ASSERT_OK(device->TryGetDeviceContext(&device_context));
+  EXPECT_EQ(device_context, nullptr);
+}
+
+TEST_F(GPUDeviceTest, MultipleComputeStreams) {
+  setenv("TF_GPU_NUM_COMPUTE_STREAMS", "2", 1);
+  SessionOptions opts = MakeSessionOptions("0");
+  std::vector<std::unique_ptr<Device>> devices;
+  TF_ASSERT_OK(DeviceFactory::GetFactory("GPU")->CreateDevices(
+      opts, kDeviceNamePrefix, &devices));
+  unsetenv("TF_GPU_NUM_COMPUTE_STREAMS");
+  auto* device = static_cast<BaseGPUDevice*>(devices[0].get());
+  ASSERT_EQ(device->num_compute_streams(), 2);
+
+  // Concurrent executors get the least busy stream.
+  DeviceContext* contexts[3];
+  for (DeviceContext*& device_context : contexts) {
+    TF_ASSERT_OK(device->TryGetDeviceContext(&device_context));
+    ASSERT_NE(device_context, nullptr);
+  }
+  EXPECT_NE(contexts[0]->stream(), contexts[1]->stream());
+  EXPECT_EQ(contexts[0]->stream(), contexts[2]->stream());
+  contexts[1]->Unref();
+  TF_ASSERT_OK(device->TryGetDeviceContext(&contexts[1]));
+  EXPECT_NE(contexts[0]->stream(), contexts[1]->stream());
+
+  // A tensor written through the context of one stream can be read through
+  // the other, and its memory is reused once both streams are done with it.
+  Allocator* allocator = device->GetAllocator(AllocatorAttributes());
+  constexpr int kNumElements = 1024;
+  Tensor cpu_tensor(cpu_allocator(), DT_FLOAT, TensorShape({kNumElements}));
+  Tensor output_cpu_tensor(cpu_allocator(), DT_FLOAT,
+                           TensorShape({kNumElements}));
+  for (int i = 0; i < 2; ++i) {
+    Tensor gpu_tensor(allocator, DT_FLOAT, TensorShape({kNumElements}));
+    InitCPUTensor(&cpu_tensor, kNumElements, i + 1);
+    CopyCPUToGPU(&cpu_tensor, &gpu_tensor, device, contexts[0]);
+    CopyGPUToCPU(&gpu_tensor, &output_cpu_tensor, device, contexts[1]);
+    auto output = output_cpu_tensor.tensor<float, 1>();
+    for (int j = 0; j < kNumElements; ++j) {
+      ASSERT_EQ(output(j), i + 1) << " for index " << j;
+    }
+  }
+  TF_ASSERT_OK(device->Sync());
+  for (DeviceContext* device_context : contexts) device_context->Unref();
+}
+
 TEST_F(GPUDeviceTest, DeviceDetails) {
   DeviceFactory* factory = DeviceFactory::GetFactory("GPU");
   std::vector<string> devices;
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/device/device_host_allocator.h"
 #include "tensorflow/core/common_runtime/device/device_id_utils.h"
+#include "tensorflow/core/common_runtime/device/prefetching_sub_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_bfc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamalloc_allocator.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_cudamallocasync_allocator.h"
@@ -132,10 +133,18 @@ static std::unique_ptr<SubAllocator> CreateSubAllocator(
     // collection.
     // TODO(imintz): Update BFC allocator to ensure it doesn't create holes in
     // the va space.
+    // When the BFC allocator releases free memory, map the physical memory in
+    // pages that can be decommitted on their own.
+    int64_t release_interval_micros;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_GPU_BFC_RELEASE_FREE_MEMORY_INTERVAL_MICROS", /*default_val=*/0,
+        &release_interval_micros));
     return GpuVirtualMemAllocator::Create(
                alloc_visitors, {}, *gpu_context, platform_device_id,
                /*virtual_address_space_size=*/total_bytes * 2,
-               platform_peer_gpu_ids_vec)
+               platform_peer_gpu_ids_vec,
+               /*decommit_granularity=*/release_interval_micros > 0 ? 2 << 20
+                                                                    : 0)
         .ValueOrDie()
         .release();
   }
@@ -193,6 +202,30 @@ Allocator* GPUProcessState::GetGPUAllocator(
               !options.experimental().disallow_retry_on_allocation_failure();
           o.fragmentation_fraction =
               options.experimental().internal_fragmentation_fraction();
+          Status status = ReadBoolFromEnvVar("TF_GPU_BFC_SMALL_CHUNK_CACHE",
+                                             /*default_val=*/false,
+                                             &o.small_chunk_cache);
+          if (!status.ok()) {
+            LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+          }
+          status = ReadInt64FromEnvVar("TF_BFC_ALLOCATION_TIMELINE_SIZE",
+                                       /*default_val=*/0,
+                                       &o.allocation_timeline_size);
+          if (!status.ok()) {
+            LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+          }
+          status = ReadInt64FromEnvVar(
+              "TF_BFC_FRAGMENTATION_SAMPLING_INTERVAL_MICROS",
+              /*default_val=*/0, &o.fragmentation_sampling_interval_micros);
+          if (!status.ok()) {
+            LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+          }
+          status = ReadInt64FromEnvVar(
+              "TF_GPU_BFC_RELEASE_FREE_MEMORY_INTERVAL_MICROS",
+              /*default_val=*/0, &o.release_free_memory_interval_micros);
+          if (!status.ok()) {
+            LOG(ERROR) << "GetGPUAllocator: " << status.error_message();
+          }
           return o;
         }());
     Allocator* gpu_allocator = gpu_bfc_allocator.get();
@@ -226,8 +259,21 @@ Allocator* GPUProcessState::GetGPUAllocator(
       // compute-sanitizer.
       // TODO: **WARNING** probably will not work in a multi-gpu scenario
       gpu_bfc_allocator.reset();
-      gpu_allocator =
-          new GpuCudaMallocAsyncAllocator(platform_device_id, total_bytes);
+      // A private pool keeps the memory of TF apart from the other users of
+      // the default pool of the GPU in the process.
+      GpuCudaMallocAsyncAllocator::Options async_options;
+      TF_CHECK_OK(ReadBoolFromEnvVar("TF_CUDA_MALLOC_ASYNC_PRIVATE_POOL",
+                                     /*default_val=*/false,
+                                     &async_options.private_pool));
+      int64_t release_threshold;
+      TF_CHECK_OK(ReadInt64FromEnvVar("TF_CUDA_MALLOC_ASYNC_RELEASE_THRESHOLD",
+                                      /*default_val=*/-1,
+                                      &release_threshold));
+      if (release_threshold >= 0) {
+        async_options.release_threshold = release_threshold;
+      }
+      gpu_allocator = new GpuCudaMallocAsyncAllocator(
+          platform_device_id, total_bytes, async_options);
     }
 
     Allocator* recording_allocator = nullptr;
@@ -304,13 +350,13 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     // we take a unique lock and populate these vectors.
     tf_shared_lock lock(mu_);
 
-    if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
-        !gpu_host_allocators_.empty() &&
-        gpu_host_allocators_[0].recording_allocator != nullptr) {
-      return gpu_host_allocators_[0].recording_allocator.get();
-    }
     if (static_cast<int>(gpu_host_allocators_.size()) > numa_node) {
-      return gpu_host_allocators_[0].allocator.get();
+      AllocatorParts& allocator_parts = gpu_host_allocators_[numa_node];
+      if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types &&
+          allocator_parts.recording_allocator != nullptr) {
+        return allocator_parts.recording_allocator.get();
+      }
+      return allocator_parts.allocator.get();
     }
   }
 
@@ -334,16 +380,19 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
 
   CHECK_NE(nullptr, se);
 
+  // Each NUMA node has its own pool, whose regions are pinned from that node
+  // when they are prefetched.
   while (static_cast<int>(gpu_host_allocators_.size()) <= numa_node) {
-    while (gpu_host_alloc_visitors_.size() <= numa_node) {
+    const int node = gpu_host_allocators_.size();
+    while (gpu_host_alloc_visitors_.size() <= node) {
       gpu_host_alloc_visitors_.push_back({});
     }
-    while (gpu_host_free_visitors_.size() <= numa_node) {
+    while (gpu_host_free_visitors_.size() <= node) {
       gpu_host_free_visitors_.push_back({});
     }
-    SubAllocator* sub_allocator = new DeviceHostAllocator(
-        se, numa_node, gpu_host_alloc_visitors_[numa_node],
-        gpu_host_free_visitors_[numa_node]);
+    SubAllocator* sub_allocator =
+        new DeviceHostAllocator(se, node, gpu_host_alloc_visitors_[node],
+                                gpu_host_free_visitors_[node]);
     // TODO(zheng-xq): evaluate whether 64GB by default is the best choice.
     int64_t gpu_host_mem_limit_in_mb = -1;
     Status status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_LIMIT_IN_MB",
@@ -354,6 +403,21 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
     int64_t gpu_host_mem_limit = gpu_host_mem_limit_in_mb * (1LL << 20);
 
+    // If set, the next region of the pool is pinned in the background, up to
+    // this size.
+    int64_t gpu_host_prefetch_limit_in_mb = 0;
+    status = ReadInt64FromEnvVar("TF_GPU_HOST_MEM_PREFETCH_LIMIT_IN_MB",
+                                 /*default_val=*/0,
+                                 &gpu_host_prefetch_limit_in_mb);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetGpuHostAllocator: " << status.error_message();
+    }
+    if (gpu_host_prefetch_limit_in_mb > 0) {
+      sub_allocator = new PrefetchingSubAllocator(
+          absl::WrapUnique(sub_allocator), node,
+          gpu_host_prefetch_limit_in_mb * (1LL << 20));
+    }
+
     BFCAllocator::Options allocator_opts;
     allocator_opts.allow_growth = true;
     Allocator* allocator =
@@ -383,9 +447,9 @@ Allocator* GPUProcessState::GetGpuHostAllocator(int numa_node) {
     }
   }
   if (process_state_->ProcessState::FLAGS_brain_gpu_record_mem_types) {
-    return gpu_host_allocators_[0].recording_allocator.get();
+    return gpu_host_allocators_[numa_node].recording_allocator.get();
   } else {
-    return gpu_host_allocators_[0].allocator.get();
+    return gpu_host_allocators_[numa_node].allocator.get();
   }
 }
 
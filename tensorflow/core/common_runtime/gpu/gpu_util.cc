@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
 #include "tensorflow/core/common_runtime/gpu_device_context.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_reference.h"
@@ -288,21 +289,42 @@ void GPUUtil::CopyGPUTensorToCPU(Device* gpu_device,
   send_device_to_host_stream->ThenWaitFor(send_stream);
 
   const int64_t total_bytes = gpu_tensor->TotalBytes();
+  void* dst_ptr = nullptr;
+  void* staging_buffer = nullptr;
+  Allocator* host_memory_allocator = device_context->host_memory_allocator();
   if (total_bytes > 0) {
     void* src_ptr = GetBase(gpu_tensor);
     DeviceMemoryBase gpu_src_ptr(src_ptr, total_bytes);
-    void* dst_ptr = GetBase(cpu_tensor);
-    send_device_to_host_stream->ThenMemcpy(dst_ptr, gpu_src_ptr, total_bytes);
+    dst_ptr = GetBase(cpu_tensor);
+    // Copy to pinned memory then to the pageable tensor, rather than letting
+    // the driver stage the copy synchronously.
+    if (NeedStaging(cpu_tensor)) {
+      if (host_memory_allocator != nullptr) {
+        staging_buffer = host_memory_allocator->AllocateRaw(
+            tensorflow::Allocator::kAllocatorAlignment, total_bytes);
+      }
+      if (staging_buffer == nullptr) {
+        metrics::UpdateGpuPageableCopyBytes("device_to_host", total_bytes);
+      }
+    }
+    send_device_to_host_stream->ThenMemcpy(
+        staging_buffer != nullptr ? staging_buffer : dst_ptr, gpu_src_ptr,
+        total_bytes);
   }
   // Use of the input may outlive stack scope, so keep a ref.
   TensorReference input_ref(*gpu_tensor);
   dev_info->event_mgr->ThenExecute(
       send_device_to_host_stream,
-      [send_device_to_host_stream, done, input_ref]() {
+      [send_device_to_host_stream, done, input_ref, dst_ptr, staging_buffer,
+       total_bytes, host_memory_allocator]() {
         if (!send_device_to_host_stream->ok()) {
           LOG(FATAL) << "GPU->CPU Memcpy failed";
         }
         input_ref.Unref();
+        if (staging_buffer != nullptr) {
+          std::memcpy(dst_ptr, staging_buffer, total_bytes);
+          host_memory_allocator->DeallocateRaw(staging_buffer);
+        }
         done(OkStatus());
       });
 }
@@ -362,6 +384,15 @@ void GPUUtil::CopyCPUTensorToGPU(const Tensor* cpu_tensor,
     if (do_staging) {
       staging_buffer = host_memory_allocator->AllocateRaw(
           tensorflow::Allocator::kAllocatorAlignment, total_bytes);
+      // Let the driver copy from pageable memory when the pinned pool is
+      // exhausted.
+      do_staging = staging_buffer != nullptr;
+    }
+    if (NeedStaging(cpu_tensor) && !do_staging) {
+      metrics::UpdateGpuPageableCopyBytes("host_to_device", total_bytes);
+    }
+
+    if (do_staging) {
       std::memcpy(staging_buffer, src_ptr, total_bytes);
       input_ref.Unref();
 
@@ -38,6 +38,13 @@ size_t AlignUp(size_t value, size_t alignment) {
   return (value + alignment - 1) & ~(alignment - 1);
 }
 
+// Rounds value down to the specified power of two alignment.
+size_t AlignDown(size_t value, size_t alignment) {
+  DCHECK_EQ(alignment & (alignment - 1), 0)
+      << "Alignment must be a power of two; alignment=" << alignment;
+  return value & ~(alignment - 1);
+}
+
 StatusOr<bool> SupportsVirtualAddressManagement(GpuDeviceHandle device) {
   return GpuDriver::GetDeviceAttribute(
       CU_DEVICE_ATTRIBUTE_VIRTUAL_ADDRESS_MANAGEMENT_SUPPORTED, device);
@@ -63,7 +70,8 @@ GpuVirtualMemAllocator::Create(
     const std::vector<Visitor>& alloc_visitors,
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id, size_t virtual_address_space_size,
-    const std::vector<PlatformDeviceId>& peer_gpu_ids) {
+    const std::vector<PlatformDeviceId>& peer_gpu_ids,
+    size_t decommit_granularity) {
   std::vector<GpuDeviceHandle> access_gpu_handles;
   access_gpu_handles.reserve(peer_gpu_ids.size() + 1);
 
@@ -92,20 +100,28 @@ GpuVirtualMemAllocator::Create(
     max_granularity = std::max(max_granularity, granularity);
   }
 
+  size_t page_bytes = 0;
+  if (decommit_granularity > 0) {
+    page_bytes = max_granularity;
+    while (page_bytes < decommit_granularity) page_bytes *= 2;
+  }
+  size_t reserved_bytes = AlignUp(virtual_address_space_size, max_granularity);
+  // Pages are aligned to their size, so leave room to align the first one.
+  if (page_bytes > max_granularity) reserved_bytes += page_bytes;
+
   // Create the virtual memory reservation. Must be aligned to system page size,
   // and larger than the CUDA min granularity. Empirically, the granularity
   // check is sufficient as the granularity is some multiple of the page size.
   // TODO(imintz): Create OS agnostic page size utility for completeness.
   TF_ASSIGN_OR_RETURN(
       GpuDriver::VmemSpan vmem,
-      GpuDriver::ReserveVirtualMemory(
-          &gpu_context, AlignUp(virtual_address_space_size, max_granularity)));
+      GpuDriver::ReserveVirtualMemory(&gpu_context, reserved_bytes));
   VLOG(1) << "Reserved GPU virtual memory at " << vmem.base << " of size "
           << strings::HumanReadableNumBytes(vmem.size_bytes) << " bytes";
 
   return std::unique_ptr<GpuVirtualMemAllocator>(new GpuVirtualMemAllocator(
       alloc_visitors, free_visitors, gpu_context, gpu_id,
-      std::move(access_gpu_handles), vmem, max_granularity));
+      std::move(access_gpu_handles), vmem, max_granularity, page_bytes));
 }
 
 GpuVirtualMemAllocator::GpuVirtualMemAllocator(
@@ -113,13 +129,22 @@ GpuVirtualMemAllocator::GpuVirtualMemAllocator(
     const std::vector<Visitor>& free_visitors, GpuContext& gpu_context,
     PlatformDeviceId gpu_id,
     const std::vector<GpuDeviceHandle> access_gpu_handles,
-    GpuDriver::VmemSpan vmem, size_t granularity)
+    GpuDriver::VmemSpan vmem, size_t granularity, size_t page_bytes)
     : SubAllocator(alloc_visitors, free_visitors),
       gpu_context_(gpu_context),
       gpu_id_(gpu_id),
       access_gpu_handles_(access_gpu_handles),
       vmem_(vmem),
-      granularity_(granularity) {}
+      next_alloc_offset_(page_bytes > 0 ? AlignUp(vmem.base, page_bytes) -
+                                              vmem.base
+                                        : 0),
+      granularity_(granularity),
+      page_bytes_(page_bytes) {
+  if (page_bytes_ > 0) {
+    VLOG(1) << "Mapping GPU virtual memory in pages of "
+            << strings::HumanReadableNumBytes(page_bytes_);
+  }
+}
 
 GpuVirtualMemAllocator::~GpuVirtualMemAllocator() {
   for (const auto mapping : mappings_) {
@@ -132,7 +157,8 @@ GpuVirtualMemAllocator::~GpuVirtualMemAllocator() {
 void* GpuVirtualMemAllocator::Alloc(size_t alignment, size_t num_bytes,
                                     size_t* bytes_received) {
   if (num_bytes == 0) return nullptr;
-  size_t padded_bytes = (num_bytes + granularity_ - 1) & ~(granularity_ - 1);
+  size_t padded_bytes =
+      AlignUp(num_bytes, page_bytes_ > 0 ? page_bytes_ : granularity_);
 
   GpuDevicePtr next_va = vmem_.base + next_alloc_offset_;
 
@@ -147,33 +173,108 @@ void* GpuVirtualMemAllocator::Alloc(size_t alignment, size_t num_bytes,
     return nullptr;
   }
 
-  // Create physical memory backing allocation.
-  auto maybe_handle =
-      GpuDriver::CreateMemoryHandle(&gpu_context_, padded_bytes);
-  if (!maybe_handle.ok()) {
-    LOG(ERROR) << maybe_handle.status();
-    return nullptr;
-  }
-  GpuDriver::GenericMemoryHandle handle = std::move(maybe_handle).ValueOrDie();
-
-  // Map VAs for this physical memory.
-  auto status =
-      GpuDriver::MapMemory(&gpu_context_, next_va, handle, access_gpu_handles_);
-  if (!status.ok()) {
-    LOG(ERROR) << status;
-    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
+  // Allocations always come at the end, after all existing mappings.
+  if (!MapRange(next_va, padded_bytes, &mappings_)) {
     return nullptr;
   }
-  next_alloc_offset_ += handle.bytes;
-  mappings_.push_back({next_va, std::move(handle)});
+  next_alloc_offset_ += padded_bytes;
   VisitAlloc(reinterpret_cast<void*>(next_va), gpu_id_.value(), padded_bytes);
   *bytes_received = padded_bytes;
   return reinterpret_cast<void*>(next_va);
 }
 
+bool GpuVirtualMemAllocator::MapRange(GpuDevicePtr va, size_t num_bytes,
+                                      std::vector<Mapping>* mappings) {
+  const size_t num_mappings = mappings->size();
+  const size_t piece_bytes = page_bytes_ > 0 ? page_bytes_ : num_bytes;
+  for (GpuDevicePtr piece_va = va; piece_va < va + num_bytes;
+       piece_va += piece_bytes) {
+    // Create physical memory backing allocation.
+    auto maybe_handle =
+        GpuDriver::CreateMemoryHandle(&gpu_context_, piece_bytes);
+    Status status = maybe_handle.status();
+    if (status.ok()) {
+      GpuDriver::GenericMemoryHandle handle =
+          std::move(maybe_handle).ValueOrDie();
+      // Map VAs for this physical memory.
+      status = GpuDriver::MapMemory(&gpu_context_, piece_va, handle,
+                                    access_gpu_handles_);
+      if (status.ok()) {
+        mappings->push_back({piece_va, std::move(handle)});
+        continue;
+      }
+      GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(handle));
+    }
+    LOG(ERROR) << status;
+    for (auto it = mappings->begin() + num_mappings; it != mappings->end();
+         ++it) {
+      GpuDriver::UnmapMemory(&gpu_context_, it->va, it->physical.bytes);
+      GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(it->physical));
+    }
+    mappings->erase(mappings->begin() + num_mappings, mappings->end());
+    return false;
+  }
+  return true;
+}
+
+size_t GpuVirtualMemAllocator::UnmapRange(
+    std::vector<Mapping>::iterator begin, std::vector<Mapping>::iterator end) {
+  size_t total_bytes = 0;
+  GpuDevicePtr range_va = 0;
+  size_t range_bytes = 0;
+  for (auto it = begin; it != end; ++it) {
+    if (range_bytes > 0 && range_va + range_bytes != it->va) {
+      VisitFree(reinterpret_cast<void*>(range_va), gpu_id_.value(),
+                range_bytes);
+      range_bytes = 0;
+    }
+    if (range_bytes == 0) range_va = it->va;
+    range_bytes += it->physical.bytes;
+    total_bytes += it->physical.bytes;
+  }
+  if (range_bytes > 0) {
+    VisitFree(reinterpret_cast<void*>(range_va), gpu_id_.value(), range_bytes);
+  }
+  for (auto it = begin; it != end; ++it) {
+    GpuDriver::UnmapMemory(&gpu_context_, it->va, it->physical.bytes);
+    GpuDriver::ReleaseMemoryHandle(&gpu_context_, std::move(it->physical));
+  }
+  mappings_.erase(begin, end);
+  return total_bytes;
+}
+
+std::vector<GpuVirtualMemAllocator::Mapping>::iterator
+GpuVirtualMemAllocator::FirstMappingAtOrAfter(GpuDevicePtr va) {
+  return std::lower_bound(
+      mappings_.begin(), mappings_.end(), va,
+      [](const Mapping& mapping, GpuDevicePtr va) { return mapping.va < va; });
+}
+
+std::vector<GpuVirtualMemAllocator::Mapping>::const_iterator
+GpuVirtualMemAllocator::FirstMappingAtOrAfter(GpuDevicePtr va) const {
+  return std::lower_bound(
+      mappings_.begin(), mappings_.end(), va,
+      [](const Mapping& mapping, GpuDevicePtr va) { return mapping.va < va; });
+}
+
 void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   if (ptr == nullptr) return;
 
+  if (page_bytes_ > 0) {
+    // Some pages of the range may have been decommitted already.
+    const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+    const size_t freed_bytes = UnmapRange(
+        FirstMappingAtOrAfter(va), FirstMappingAtOrAfter(va + num_bytes));
+    VLOG(1) << "Freeing " << strings::HumanReadableNumBytes(num_bytes)
+            << " of which " << strings::HumanReadableNumBytes(freed_bytes)
+            << " were mapped";
+    // Move back the next_alloc_offset_ if this free was at the end.
+    if (va + num_bytes == vmem_.base + next_alloc_offset_) {
+      next_alloc_offset_ = va - vmem_.base;
+    }
+    return;
+  }
+
   auto mapping_it =
       std::lower_bound(mappings_.begin(), mappings_.end(), ptr,
                        [](const Mapping& mapping, const void* ptr) {
@@ -216,6 +317,88 @@ void GpuVirtualMemAllocator::Free(void* ptr, size_t num_bytes) {
   VisitFree(ptr, gpu_id_.value(), num_bytes);
 }
 
+size_t GpuVirtualMemAllocator::Decommit(void* ptr, size_t num_bytes) {
+  if (page_bytes_ == 0 || num_bytes == 0) return 0;
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  DCHECK_EQ(va % page_bytes_, 0);
+  DCHECK_EQ(num_bytes % page_bytes_, 0);
+  auto begin = FirstMappingAtOrAfter(va);
+  auto end = FirstMappingAtOrAfter(va + num_bytes);
+  if (begin == end) return 0;
+  // Unlike freeing device memory, unmapping it does not wait for the pending
+  // work that may still access the pages.
+  if (!GpuDriver::SynchronizeContext(&gpu_context_)) {
+    LOG(ERROR) << "Failed to synchronize before decommitting GPU memory";
+    return 0;
+  }
+  const size_t decommitted_bytes = UnmapRange(begin, end);
+  VLOG(2) << "Decommitted " << strings::HumanReadableNumBytes(decommitted_bytes)
+          << " at " << ptr;
+  return decommitted_bytes;
+}
+
+size_t GpuVirtualMemAllocator::DecommittedBytes(const void* ptr,
+                                                size_t num_bytes) const {
+  if (page_bytes_ == 0 || num_bytes == 0) return 0;
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  const GpuDevicePtr begin = AlignDown(va, page_bytes_);
+  const GpuDevicePtr end = AlignUp(va + num_bytes, page_bytes_);
+  size_t mapped_bytes = 0;
+  for (auto it = FirstMappingAtOrAfter(begin);
+       it != mappings_.end() && it->va < end; ++it) {
+    mapped_bytes += it->physical.bytes;
+  }
+  return (end - begin) - mapped_bytes;
+}
+
+bool GpuVirtualMemAllocator::Commit(void* ptr, size_t num_bytes,
+                                    size_t* bytes_committed) {
+  *bytes_committed = 0;
+  if (page_bytes_ == 0 || num_bytes == 0) return true;
+  const GpuDevicePtr va = reinterpret_cast<GpuDevicePtr>(ptr);
+  const GpuDevicePtr end = AlignUp(va + num_bytes, page_bytes_);
+
+  // Map the gaps between the existing mappings of the range.
+  std::vector<Mapping> new_mappings;
+  std::vector<std::pair<GpuDevicePtr, size_t>> new_ranges;
+  GpuDevicePtr gap_va = AlignDown(va, page_bytes_);
+  for (auto it = FirstMappingAtOrAfter(gap_va); gap_va < end; ++it) {
+    const GpuDevicePtr gap_end =
+        (it != mappings_.end() && it->va < end) ? it->va : end;
+    if (gap_va < gap_end) {
+      if (!MapRange(gap_va, gap_end - gap_va, &new_mappings)) {
+        for (auto& mapping : new_mappings) {
+          GpuDriver::UnmapMemory(&gpu_context_, mapping.va,
+                                 mapping.physical.bytes);
+          GpuDriver::ReleaseMemoryHandle(&gpu_context_,
+                                         std::move(mapping.physical));
+        }
+        return false;
+      }
+      new_ranges.emplace_back(gap_va, gap_end - gap_va);
+      *bytes_committed += gap_end - gap_va;
+    }
+    if (gap_end == end) break;
+    gap_va = gap_end + it->physical.bytes;
+  }
+  if (new_mappings.empty()) return true;
+
+  const size_t num_mappings = mappings_.size();
+  mappings_.insert(mappings_.end(),
+                   std::make_move_iterator(new_mappings.begin()),
+                   std::make_move_iterator(new_mappings.end()));
+  std::inplace_merge(
+      mappings_.begin(), mappings_.begin() + num_mappings, mappings_.end(),
+      [](const Mapping& a, const Mapping& b) { return a.va < b.va; });
+  for (const auto& range : new_ranges) {
+    VisitAlloc(reinterpret_cast<void*>(range.first), gpu_id_.value(),
+               range.second);
+  }
+  VLOG(2) << "Committed " << strings::HumanReadableNumBytes(*bytes_committed)
+          << " at " << ptr;
+  return true;
+}
+
 }  // namespace tensorflow
 
 #endif
@@ -37,6 +37,11 @@ namespace tensorflow {
 // reserving a large chunk of virtual addresses at construction and then mapping
 // physical memory pages to this virtual address range as requested.
 //
+// If created with a non-zero decommit_granularity, the physical memory is
+// instead created and mapped in pages of that many bytes, which lets the
+// BFCAllocator release the pages under its free chunks with Decommit() and
+// map new physical memory under them with Commit() once they are reused.
+//
 // This class is not thread-safe.
 class GpuVirtualMemAllocator : public SubAllocator {
  public:
@@ -46,7 +51,8 @@ class GpuVirtualMemAllocator : public SubAllocator {
          const std::vector<Visitor>& free_visitors,
          stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
          size_t virtual_address_space_size,
-         const std::vector<PlatformDeviceId>& peer_gpu_ids);
+         const std::vector<PlatformDeviceId>& peer_gpu_ids,
+         size_t decommit_granularity = 0);
   ~GpuVirtualMemAllocator() override;
 
   // Allocates memory at least as large as requested by num_bytes. Will be
@@ -70,13 +76,26 @@ class GpuVirtualMemAllocator : public SubAllocator {
 
   bool SupportsCoalescing() const override { return true; }
 
+  // The page size, a power of two multiple of the min allocation granularity
+  // at least as large as the decommit_granularity passed to Create(), or 0 if
+  // decommitting is disabled.
+  size_t DecommitGranularity() const override { return page_bytes_; }
+
+  // Synchronizes the device before unmapping the pages of the range.
+  size_t Decommit(void* ptr, size_t num_bytes) override;
+
+  size_t DecommittedBytes(const void* ptr, size_t num_bytes) const override;
+
+  bool Commit(void* ptr, size_t num_bytes, size_t* bytes_committed) override;
+
  private:
   GpuVirtualMemAllocator(
       const std::vector<Visitor>& alloc_visitors,
       const std::vector<Visitor>& free_visitors,
       stream_executor::gpu::GpuContext& gpu_context, PlatformDeviceId gpu_id,
       std::vector<stream_executor::gpu::GpuDeviceHandle> access_device_handles,
-      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity);
+      stream_executor::gpu::GpuDriver::VmemSpan vmem, size_t granularity,
+      size_t page_bytes);
 
   stream_executor::gpu::GpuContext& gpu_context_;
   PlatformDeviceId gpu_id_;
@@ -97,6 +116,9 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // Smallest allocation as determined by CUDA.
   const size_t granularity_;
 
+  // See DecommitGranularity().
+  const size_t page_bytes_;
+
   struct Mapping {
     stream_executor::gpu::GpuDevicePtr va;
     stream_executor::gpu::GpuDriver::GenericMemoryHandle physical;
@@ -104,6 +126,25 @@ class GpuVirtualMemAllocator : public SubAllocator {
   // List of mappings, sorted by va.
   std::vector<Mapping> mappings_;
 
+  // Creates physical memory for the unmapped range [va, va + num_bytes), in
+  // one piece or in pages if page_bytes_ is set, maps it and appends the new
+  // mappings to *mappings. On failure, unmaps what this call mapped and
+  // returns false.
+  bool MapRange(stream_executor::gpu::GpuDevicePtr va, size_t num_bytes,
+                std::vector<Mapping>* mappings);
+
+  // Unmaps and releases the physical memory of the mappings in [begin, end),
+  // visits each contiguous range freed and erases the mappings. Returns the
+  // number of bytes freed.
+  size_t UnmapRange(std::vector<Mapping>::iterator begin,
+                    std::vector<Mapping>::iterator end);
+
+  // Returns the first mapping whose address is not before va.
+  std::vector<Mapping>::iterator FirstMappingAtOrAfter(
+      stream_executor::gpu::GpuDevicePtr va);
+  std::vector<Mapping>::const_iterator FirstMappingAtOrAfter(
+      stream_executor::gpu::GpuDevicePtr va) const;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GpuVirtualMemAllocator);
 };
 
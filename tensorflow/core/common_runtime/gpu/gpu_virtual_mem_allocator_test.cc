@@ -179,6 +179,49 @@ TEST(GpuVirtualMemAllocatorTest, FreeRange) {
   ASSERT_EQ(re_alloc, first_alloc);
 }
 
+TEST(GpuVirtualMemAllocatorTest, DecommitAndCommit) {
+  PlatformDeviceId gpu_id(0);
+  auto executor =
+      DeviceIdUtil::ExecutorForPlatformDeviceId(GPUMachineManager(), gpu_id)
+          .ValueOrDie();
+  GpuContext* gpu_context = reinterpret_cast<GpuContext*>(
+      executor->implementation()->GpuContextHack());
+  auto allocator = GpuVirtualMemAllocator::Create(
+                       {}, {}, *gpu_context, gpu_id,
+                       /*virtual_address_space_size=*/8 * k2MiB, {},
+                       /*decommit_granularity=*/k2MiB)
+                       .ValueOrDie();
+  const size_t page_bytes = allocator->DecommitGranularity();
+  ASSERT_GE(page_bytes, k2MiB);
+  size_t bytes_received;
+  char* alloc = static_cast<char*>(allocator->Alloc(
+      /*alignment=*/0, /*num_bytes=*/3 * page_bytes, &bytes_received));
+  ASSERT_NE(alloc, nullptr);
+  EXPECT_EQ(bytes_received, 3 * page_bytes);
+  EXPECT_EQ(allocator->DecommittedBytes(alloc, 3 * page_bytes), 0);
+
+  // Decommit the middle page, twice.
+  EXPECT_EQ(allocator->Decommit(alloc + page_bytes, page_bytes), page_bytes);
+  EXPECT_EQ(allocator->Decommit(alloc + page_bytes, page_bytes), 0);
+  EXPECT_EQ(allocator->DecommittedBytes(alloc, 3 * page_bytes), page_bytes);
+
+  size_t bytes_committed;
+  ASSERT_TRUE(allocator->Commit(alloc, 3 * page_bytes, &bytes_committed));
+  EXPECT_EQ(bytes_committed, page_bytes);
+  EXPECT_EQ(allocator->DecommittedBytes(alloc, 3 * page_bytes), 0);
+  ASSERT_TRUE(GpuDriver::SynchronousMemsetUint8(
+                  gpu_context, reinterpret_cast<GpuDevicePtr>(alloc), 'a',
+                  3 * page_bytes)
+                  .ok());
+
+  // Freeing a range with decommitted pages only unmaps the others.
+  EXPECT_EQ(allocator->Decommit(alloc, page_bytes), page_bytes);
+  allocator->Free(alloc, 3 * page_bytes);
+  void* re_alloc =
+      allocator->Alloc(/*alignment=*/0, page_bytes, &bytes_received);
+  EXPECT_EQ(re_alloc, alloc);
+}
+
 }  // namespace
 }  // namespace tensorflow
 
@@ -48,6 +48,8 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/public/version.h"
 
 namespace tensorflow {
@@ -98,7 +100,8 @@ class GraphConstructor {
           importing(false),
           validate_nodes(in.validate_nodes),
           validate_colocation_constraints(false),
-          add_default_attributes(in.add_default_attributes) {}
+          add_default_attributes(in.add_default_attributes),
+          thread_pool(in.thread_pool) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
@@ -151,6 +154,9 @@ class GraphConstructor {
     bool add_default_attributes = true;
 
     string default_device;
+
+    // Only used when `importing` is false.
+    thread::ThreadPool* thread_pool = nullptr;
   };
 
   typedef gtl::ArraySlice<const NodeDef*> NodeDefSlice;
@@ -210,6 +216,9 @@ class GraphConstructor {
   Status ValidateInputMapAndControlDependencies();
   Status BuildNodeIndex();
   Status InitFromEdges();
+  // Creates the properties of every node in `prepared_nodes_`, in parallel on
+  // `opts_.thread_pool`.
+  Status PrepareNodesInParallel();
   Status Convert();
   Status AddBackEdges();
   Status UpdateVersionDef();
@@ -387,6 +396,11 @@ class GraphConstructor {
   };
   std::vector<EdgeInfo> back_edges_;
 
+  // Indexed by position in node_defs_. If non-empty, holds the prepared
+  // properties of the nodes that have not been converted yet, and replaces
+  // consume_node_def().
+  std::vector<std::shared_ptr<NodeProperties>> prepared_nodes_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GraphConstructor);
 };
 
@@ -453,7 +467,9 @@ class NodeDefMovingGraphConstructor : public GraphConstructor {
   }
 
   GraphDef graph_def_;
-  std::vector<bool> is_consumed_;
+  // Not a std::vector<bool>, so that PrepareNodesInParallel() may consume
+  // distinct nodes concurrently.
+  std::vector<char> is_consumed_;
 };
 
 bool ForwardCompatibilityWindowPassed(const VersionDef& versions) {
@@ -750,6 +766,39 @@ Status GraphConstructor::InitFromEdges() {
   return OkStatus();
 }
 
+Status GraphConstructor::PrepareNodesInParallel() {
+  const int num_nodes = node_def_count();
+  prepared_nodes_.resize(num_nodes);
+  std::vector<Status> statuses(num_nodes);
+  auto prepare = [this, &statuses](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      NodeDef node_def = consume_node_def(i);
+      const OpDef* op_def;
+      Status s = g_->op_registry()->LookUpOpDef(node_def.op(), &op_def);
+      if (s.ok()) {
+        if (opts_.add_default_attributes) {
+          AddDefaultsToNodeDef(*op_def, &node_def);
+        }
+        if (opts_.validate_nodes) s = ValidateNodeDef(node_def, *op_def);
+      }
+      if (s.ok()) {
+        StatusOr<std::shared_ptr<NodeProperties>> props =
+            g_->CreateNodeProperties(std::move(node_def));
+        if (props.ok()) {
+          prepared_nodes_[i] = std::move(props).value();
+        } else {
+          s = props.status();
+        }
+      }
+      statuses[i] = std::move(s);
+    }
+  };
+  // Validating a NodeDef and inferring its types costs a few microseconds.
+  opts_.thread_pool->ParallelFor(num_nodes, /*cost_per_unit=*/10000, prepare);
+  for (const Status& s : statuses) TF_RETURN_IF_ERROR(s);
+  return OkStatus();
+}
+
 Status GraphConstructor::ValidateColocationConstraints(
     const NodeDef& node_def) {
   if (!opts_.validate_colocation_constraints || !opts_.importing)
@@ -1123,6 +1172,10 @@ Status GraphConstructor::Convert() {
     TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library()));
   }
 
+  if (opts_.thread_pool != nullptr && !opts_.importing) {
+    TF_RETURN_IF_ERROR(PrepareNodesInParallel());
+  }
+
   std::vector<InputInfo> inputs;
   int processed = 0;
 
@@ -1139,7 +1192,16 @@ Status GraphConstructor::Convert() {
     inputs.clear();
     bool has_data_back_edge = false;
 
-    NodeDef node_def = consume_node_def(o);
+    // The prepared properties own the NodeDef, which is not modified below
+    // since `opts_.importing` is false.
+    std::shared_ptr<NodeProperties> props;
+    NodeDef consumed_node_def;
+    if (!prepared_nodes_.empty()) {
+      props = std::move(prepared_nodes_[o]);
+    } else {
+      consumed_node_def = consume_node_def(o);
+    }
+    NodeDef& node_def = props ? props->node_def : consumed_node_def;
 
     // input_already_exists[i] is true iff the i-th input of the node we're
     // importing refers to a preexisting node in g_ (i.e. input[i] existed prior
@@ -1233,7 +1295,9 @@ Status GraphConstructor::Convert() {
       }
     }
 
-    if (opts_.importing) {
+    if (props) {
+      // Validated by PrepareNodesInParallel().
+    } else if (opts_.importing) {
       TF_RETURN_IF_ERROR(ModifyNodeDefForImport(&node_def));
     } else {
       const OpDef* op_def;
@@ -1247,7 +1311,14 @@ Status GraphConstructor::Convert() {
       }
     }
 
-    TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    if (props) {
+      TF_ASSIGN_OR_RETURN(node, g_->AddNode(std::move(props)));
+      if (opts_.expect_device_spec) {
+        node->set_assigned_device_name(node->def().device());
+      }
+    } else {
+      TF_RETURN_IF_ERROR(MakeNode(std::move(node_def), &node));
+    }
 
     gdef_nodes_[node_name].node = node;
 
@@ -1284,7 +1355,10 @@ Status GraphConstructor::Convert() {
                  << " NODES IN A CYCLE";
     for (int64_t i = 0; i < node_def_count(); i++) {
       if (pending_count_[i] != 0) {
-        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(get_node_def(i))
+        const NodeDef& node_def = prepared_nodes_.empty()
+                                      ? get_node_def(i)
+                                      : prepared_nodes_[i]->node_def;
+        LOG(WARNING) << "PENDING: " << SummarizeNodeDef(node_def)
                      << " WITH PENDING COUNT = " << pending_count_[i];
       }
     }
@@ -1466,6 +1540,66 @@ Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      /*missing_unused_input_map_keys=*/nullptr);
 }
 
+Status ConvertSerializedGraphDefToGraph(const GraphConstructorOptions& opts,
+                                        StringPiece serialized_graph_def,
+                                        Graph* g) {
+  using protobuf::internal::WireFormatLite;
+  const char* const data = serialized_graph_def.data();
+  protobuf::io::CodedInputStream input(reinterpret_cast<const uint8*>(data),
+                                       serialized_graph_def.size());
+
+  // Find the serialized NodeDefs, and copy the other fields of the GraphDef,
+  // which are parsed on their own.
+  std::vector<StringPiece> serialized_nodes;
+  std::string other_fields;
+  while (true) {
+    const int start = input.CurrentPosition();
+    const uint32 tag = input.ReadTag();
+    if (tag == 0) break;
+    if (WireFormatLite::GetTagFieldNumber(tag) == GraphDef::kNodeFieldNumber &&
+        WireFormatLite::GetTagWireType(tag) ==
+            WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      uint32 length;
+      if (!input.ReadVarint32(&length)) break;
+      const int offset = input.CurrentPosition();
+      if (!input.Skip(length)) break;
+      serialized_nodes.emplace_back(data + offset, length);
+    } else {
+      if (!WireFormatLite::SkipField(&input, tag)) break;
+      other_fields.append(data + start, input.CurrentPosition() - start);
+    }
+  }
+  GraphDef gdef;
+  const int size = serialized_graph_def.size();
+  if (input.CurrentPosition() != size || !gdef.ParseFromString(other_fields)) {
+    return errors::InvalidArgument("Invalid serialized GraphDef");
+  }
+
+  const int num_nodes = serialized_nodes.size();
+  gdef.mutable_node()->Reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) gdef.add_node();
+  std::vector<char> parsed(num_nodes, false);
+  auto parse = [&gdef, &serialized_nodes, &parsed](int64_t begin,
+                                                   int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      parsed[i] = gdef.mutable_node(i)->ParseFromArray(
+          serialized_nodes[i].data(), serialized_nodes[i].size());
+    }
+  };
+  if (opts.thread_pool != nullptr) {
+    opts.thread_pool->ParallelFor(num_nodes, /*cost_per_unit=*/10000, parse);
+  } else {
+    parse(0, num_nodes);
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    if (!parsed[i]) {
+      return errors::InvalidArgument("Invalid NodeDef at index ", i,
+                                     " of the serialized GraphDef");
+    }
+  }
+  return ConvertGraphDefToGraph(opts, std::move(gdef), g);
+}
+
 Status ConvertNodeDefsToGraph(const GraphConstructorOptions& opts,
                               gtl::ArraySlice<NodeDef> nodes, Graph* g) {
   ShapeRefiner refiner(TF_GRAPH_DEF_VERSION, g->op_registry());
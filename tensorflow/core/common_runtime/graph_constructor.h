@@ -20,9 +20,13 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 
 namespace tensorflow {
 class ShapeRefiner;
+namespace thread {
+class ThreadPool;
+}  // namespace thread
 
 // Construct a Graph *g out of a GraphDef gdef. Returns non-OK on
 // error, in which case *g is left in an incomplete state.
@@ -52,12 +56,27 @@ struct GraphConstructorOptions {
   // If true, GraphConstructor will add attributes with their default
   // value to the Node when they are missing from the NodeDef.
   bool add_default_attributes = true;
+
+  // If set, the per-node work that does not depend on other nodes (adding
+  // default attributes, NodeDef validation, op registry lookups and type
+  // inference) runs in parallel on this threadpool, before the nodes are
+  // added to the graph and connected in topological order. Not owned.
+  thread::ThreadPool* thread_pool = nullptr;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      GraphDef&& gdef, Graph* g);
 
+// Same as ConvertGraphDefToGraph, but reads a serialized GraphDef, e.g. the
+// contents of a file mapped with Env::NewReadOnlyMemoryRegionFromFile().
+// The NodeDefs are parsed directly from `serialized_graph_def`, in parallel
+// if `opts.thread_pool` is set, instead of first parsing a GraphDef and then
+// copying it.
+extern Status ConvertSerializedGraphDefToGraph(
+    const GraphConstructorOptions& opts, StringPiece serialized_graph_def,
+    Graph* g);
+
 // Same as ConvertGraphDefToGraph, but takes just nodes.  Used by function
 // instantiation.
 // TODO(irving): This will turn into std::vector<NodeInfoPtr> soon.
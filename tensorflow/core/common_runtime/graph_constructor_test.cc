@@ -28,8 +28,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
@@ -914,6 +916,87 @@ TEST_F(GraphConstructorTest, SimpleModelWithControlEdges) {
   EXPECT_TRUE(HasControlEdge("t1", "t2"));
 }
 
+// Returns a chain of `n` TestMul nodes, with control edges between every
+// other node, in reverse topological order.
+GraphDef MakeChainGraphDef(int n) {
+  GraphDef gdef;
+  *gdef.mutable_versions() = Graph(OpRegistry::Global()).versions();
+  for (int i = n - 1; i >= 0; --i) {
+    NodeDef* node = gdef.add_node();
+    node->set_name(strings::StrCat("t", i));
+    node->set_op("TestMul");
+    node->add_input("W1");
+    node->add_input(i == 0 ? "input:1" : strings::StrCat("t", i - 1));
+    if (i >= 2 && i % 2 == 0) node->add_input(strings::StrCat("^t", i - 2));
+  }
+  NodeDef* w1 = gdef.add_node();
+  w1->set_name("W1");
+  w1->set_op("TestParams");
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, ParallelConvert) {
+  const GraphDef gdef = MakeChainGraphDef(1000);
+  GraphConstructorOptions opts;
+  opts.validate_nodes = true;
+  Graph expected(OpRegistry::Global());
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &expected));
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  opts.thread_pool = &pool;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &graph_));
+  EXPECT_EQ(expected.ToGraphDefDebug().DebugString(), GraphDebugString());
+
+  Graph moved(OpRegistry::Global());
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, GraphDef(gdef), &moved));
+  EXPECT_EQ(expected.ToGraphDefDebug().DebugString(),
+            moved.ToGraphDefDebug().DebugString());
+}
+
+TEST_F(GraphConstructorTest, ParallelConvertErrors) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  GraphConstructorOptions opts;
+  opts.thread_pool = &pool;
+
+  GraphDef gdef = MakeChainGraphDef(100);
+  gdef.mutable_node(50)->set_op("NoSuchOp");
+  Status s = ConvertGraphDefToGraph(opts, gdef, &graph_);
+  EXPECT_NE(s.error_message().find("NoSuchOp"), string::npos) << s;
+  EXPECT_EQ(graph_.num_op_nodes(), 0);
+
+  // Node 99 is "t0".
+  gdef = MakeChainGraphDef(100);
+  gdef.mutable_node(99)->add_input("^t99");
+  s = ConvertGraphDefToGraph(opts, gdef, &graph_);
+  EXPECT_NE(s.error_message().find("cycle"), string::npos) << s;
+  EXPECT_EQ(graph_.num_op_nodes(), 0);
+}
+
+TEST_F(GraphConstructorTest, ConvertSerializedGraphDef) {
+  GraphDef gdef = MakeChainGraphDef(100);
+  FunctionDef* fdef = gdef.mutable_library()->add_function();
+  fdef->mutable_signature()->set_name("EmptyFunction");
+  GraphConstructorOptions opts;
+  Graph expected(OpRegistry::Global());
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &expected));
+
+  const string serialized = gdef.SerializeAsString();
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  opts.thread_pool = &pool;
+  TF_ASSERT_OK(ConvertSerializedGraphDefToGraph(opts, serialized, &graph_));
+  EXPECT_EQ(expected.ToGraphDefDebug().DebugString(), GraphDebugString());
+  EXPECT_NE(graph_.flib_def().Find("EmptyFunction"), nullptr);
+
+  Graph truncated(OpRegistry::Global());
+  Status s = ConvertSerializedGraphDefToGraph(
+      opts, StringPiece(serialized).substr(0, serialized.size() / 2),
+      &truncated);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
 TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
   ExpectError(
       "node { name: 'W1' op: 'TestParams' }"
@@ -23,8 +23,28 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/optimizer_cse.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
+namespace {
+
+// Returns the threadpool on which independent constant subgraphs are folded,
+// or nullptr if constant folding runs on the calling thread. The pool is
+// enabled by setting TF_CONSTANT_FOLDING_NUM_THREADS to more than one thread.
+thread::ThreadPool* ConstantFoldingThreadPool() {
+  static thread::ThreadPool* pool = []() -> thread::ThreadPool* {
+    int64_t num_threads;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_CONSTANT_FOLDING_NUM_THREADS",
+                                    /*default_val=*/0, &num_threads));
+    if (num_threads <= 1) return nullptr;
+    return new thread::ThreadPool(Env::Default(), "constant_folding",
+                                  num_threads);
+  }();
+  return pool;
+}
+
+}  // namespace
 
 GraphOptimizer::GraphOptimizer(const OptimizerOptions& opts) : opts_(opts) {
   if (opts_.opt_level() >= OptimizerOptions::L1) {
@@ -75,6 +95,7 @@ void GraphOptimizer::Optimize(FunctionLibraryRuntime* runtime, Env* env,
       ConstantFoldingOptions cf_opts;
       cf_opts.shape_map = options.shape_map;
       cf_opts.consider = options.cf_consider_fn;
+      cf_opts.thread_pool = ConstantFoldingThreadPool();
       if (opts_.max_folded_constant_in_bytes() > 0) {
         cf_opts.max_constant_size_in_bytes =
             opts_.max_folded_constant_in_bytes();
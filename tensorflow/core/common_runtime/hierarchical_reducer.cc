@@ -0,0 +1,330 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/collective_rma_local.h"
+#include "tensorflow/core/common_runtime/collective_util.h"
+#include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+
+namespace {
+// Phases of the algorithm, used in the keys of the transfers.
+enum Phase {
+  kLocalReduceScatter = 0,
+  kGlobalReduceScatter = 1,
+  kGlobalAllGather = 2,
+  kLocalAllGather = 3,
+};
+
+// Key to be used for BufRendezvous by HierarchicalReducer.
+string HierarchicalReduceBufKey(const string& exec_key, int phase, int step,
+                                int src_idx, int dst_idx) {
+  return strings::StrCat(exec_key, ":", phase, ":", step, ":", src_idx, ":",
+                         dst_idx);
+}
+}  // namespace
+
+HierarchicalReducer::HierarchicalReducer()
+    : col_ctx_(nullptr),
+      col_params_(nullptr),
+      num_tasks_(0),
+      devices_per_task_(0),
+      chunk_elts_(0) {}
+
+/* static */
+Status HierarchicalReducer::DevicesPerTask(const CollGroupParams& group,
+                                           int* devices_per_task) {
+  if (group.members.empty()) {
+    return errors::Internal("Collective group ", group.group_key,
+                            " has no members");
+  }
+  std::vector<int> dev_per_task;
+  const string* prior_task_name = &group.members[0].task;
+  int dev_count = 1;
+  for (int di = 1; di < group.members.size(); ++di) {
+    if (group.members[di].task != *prior_task_name) {
+      dev_per_task.push_back(dev_count);
+      dev_count = 1;
+      prior_task_name = &group.members[di].task;
+    } else {
+      ++dev_count;
+    }
+  }
+  dev_per_task.push_back(dev_count);
+  if (dev_per_task.size() != group.num_tasks) {
+    return errors::Internal("Collective group ", group.group_key, " has ",
+                            group.num_tasks, " tasks but the devices of ",
+                            dev_per_task.size(), " tasks are adjacent");
+  }
+  for (int count : dev_per_task) {
+    if (count != dev_per_task[0]) {
+      return errors::InvalidArgument(
+          "HierarchicalReduce requires the same number of devices in every "
+          "task of collective group ",
+          group.group_key);
+    }
+  }
+  *devices_per_task = dev_per_task[0];
+  return OkStatus();
+}
+
+Status HierarchicalReducer::InitializeCollectiveParams(
+    CollectiveParams* col_params) {
+  CHECK_EQ(col_params->instance.type, REDUCTION_COLLECTIVE);
+  CHECK_EQ(col_params->instance.impl_details.collective_name,
+           "HierarchicalReduce");
+  int devices_per_task;
+  return DevicesPerTask(col_params->group, &devices_per_task);
+}
+
+Status HierarchicalReducer::InitializeCollectiveContext(
+    std::shared_ptr<CollectiveContext> col_ctx) {
+  CHECK(col_ctx->dev_mgr);
+  col_ctx_ = col_ctx;
+  col_params_ = col_ctx->col_params.get();
+  return collective_util::InitializeDeviceAndLocality(
+      col_ctx->dev_mgr, col_ctx->device_name, &col_ctx->device,
+      &col_ctx->device_locality);
+}
+
+void HierarchicalReducer::Run(StatusCallback done) {
+  CHECK(col_ctx_);
+  CHECK(col_params_);
+  // Like `RingReducer`, this doesn't require non-overlapping collectives.
+  col_ctx_->col_exec->UnblockDependencies(*col_params_);
+
+  num_tasks_ = col_params_->group.num_tasks;
+  Status status = DevicesPerTask(col_params_->group, &devices_per_task_);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+
+  // Start by copying input to output if they're not already the same.
+  if ((col_ctx_->input != col_ctx_->output) &&
+      (DMAHelper::base(col_ctx_->input) != DMAHelper::base(col_ctx_->output))) {
+    Notification note;
+    profiler::TraceMe activity("MemCpyAsync", profiler::TraceMeLevel::kInfo);
+    CollectiveRemoteAccessLocal::MemCpyAsync(
+        col_ctx_->op_ctx->op_device_context(),
+        col_ctx_->op_ctx->op_device_context(), col_ctx_->device,
+        col_ctx_->device, col_ctx_->op_ctx->input_alloc_attr(0),
+        col_ctx_->op_ctx->output_alloc_attr(0), col_ctx_->input,
+        col_ctx_->output, 0 /*dev_to_dev_stream_index*/,
+        [&note, &status](const Status& s) {
+          status.Update(s);
+          note.Notify();
+        });
+    note.WaitForNotification();
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+  }
+  if (col_ctx_->output->NumElements() == 0) {
+    done(OkStatus());
+    return;
+  }
+
+  const int num_chunks = num_tasks_ * devices_per_task_;
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  chunk_elts_ = CollectiveAdapter::AlignedChunkElts(
+      DataTypeSize(col_ctx_->output->dtype()),
+      col_ctx_->output->NumElements(), num_chunks);
+  ca_.reset(MakeCollectiveAdapter(col_ctx_->output, num_chunks,
+                                  col_ctx_->device->GetAllocator(attr)));
+
+  // The members of the group are ordered by task, so the device at position
+  // `local_rank` of task `task` has index `task * devices_per_task_ +
+  // local_rank`.
+  const int task = col_params_->default_rank / devices_per_task_;
+  const int local_rank = col_params_->default_rank % devices_per_task_;
+  Ring local_ring;
+  local_ring.my_pos = local_rank;
+  std::vector<int> shards;
+  for (int di = 0; di < devices_per_task_; ++di) {
+    local_ring.members.push_back(task * devices_per_task_ + di);
+    shards.push_back(di * num_tasks_);
+  }
+  // After the local reduce-scatter, this device holds the shard after its
+  // local rank, which it all-reduces with the devices of the same local rank
+  // in the other tasks.
+  const int shard = (local_rank + 1) % devices_per_task_;
+  Ring global_ring;
+  global_ring.my_pos = task;
+  std::vector<int> shard_chunks;
+  for (int ti = 0; ti < num_tasks_; ++ti) {
+    global_ring.members.push_back(ti * devices_per_task_ + local_rank);
+    shard_chunks.push_back(shard * num_tasks_ + ti);
+  }
+
+  status = ReduceScatter(kLocalReduceScatter, local_ring, shards, num_tasks_);
+  if (status.ok()) {
+    status = ReduceScatter(kGlobalReduceScatter, global_ring, shard_chunks, 1);
+  }
+  if (status.ok() && col_params_->final_op) {
+    // This device holds the final reduction of one chunk of the value.
+    const int chunk = shard_chunks[(task + 1) % num_tasks_];
+    Tensor t = Chunks(chunk, chunk + 1);
+    status = Finalize(&t);
+  }
+  if (status.ok()) {
+    status = AllGather(kGlobalAllGather, global_ring, shard_chunks, 1);
+  }
+  if (status.ok()) {
+    status = AllGather(kLocalAllGather, local_ring, shards, num_tasks_);
+  }
+  ca_->ConsumeFinalValue(col_ctx_->output);
+  ca_.reset();
+  if (!status.ok()) {
+    // Abort the transfers that other devices are waiting for, unless this is
+    // already a cancellation.
+    CancellationManager* cancel_mgr = col_ctx_->op_ctx->cancellation_manager();
+    if (cancel_mgr == nullptr ||
+        (!cancel_mgr->IsCancelled() && !cancel_mgr->IsCancelling())) {
+      col_ctx_->col_exec->StartAbort(status);
+    }
+  }
+  VLOG(2) << "device=" << col_ctx_->device_name << " return status " << status;
+  done(status);
+}
+
+Tensor HierarchicalReducer::Chunks(int begin, int end) const {
+  const Tensor& value = ca_->Value();
+  const int64_t num_elts = value.NumElements();
+  const int64_t start = std::min(num_elts, begin * chunk_elts_);
+  const int64_t limit = std::min(num_elts, end * chunk_elts_);
+  // Take empty slices from the front of the tensor, like the adapter.
+  return (limit > start) ? value.Slice(start, limit) : value.Slice(0, 0);
+}
+
+Status HierarchicalReducer::ReduceScatter(int phase, const Ring& ring,
+                                          const std::vector<int>& parts,
+                                          int width) {
+  const int n = ring.size();
+  AllocatorAttributes attr = col_ctx_->op_ctx->output_alloc_attr(0);
+  for (int step = 0; step < n - 1; ++step) {
+    const int send_part = parts[(ring.my_pos + n - step) % n];
+    const int recv_part = parts[(ring.my_pos + 2 * n - step - 1) % n];
+    Tensor send = Chunks(send_part, send_part + width);
+    Tensor acc = Chunks(recv_part, recv_part + width);
+    Tensor recv(col_ctx_->device->GetAllocator(attr), acc.dtype(),
+                acc.shape());
+    TF_RETURN_IF_ERROR(
+        SendRecv(phase, step, ring.next(), &send, ring.prev(), &recv));
+    TF_RETURN_IF_ERROR(collective_util::ComputeBinOp(
+        col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+        col_params_->merge_op, &acc, &recv));
+  }
+  return OkStatus();
+}
+
+Status HierarchicalReducer::AllGather(int phase, const Ring& ring,
+                                      const std::vector<int>& parts,
+                                      int width) {
+  const int n = ring.size();
+  for (int step = 0; step < n - 1; ++step) {
+    const int send_part = parts[(ring.my_pos + 1 + n - step) % n];
+    const int recv_part = parts[(ring.my_pos + n - step) % n];
+    Tensor send = Chunks(send_part, send_part + width);
+    Tensor recv = Chunks(recv_part, recv_part + width);
+    TF_RETURN_IF_ERROR(
+        SendRecv(phase, step, ring.next(), &send, ring.prev(), &recv));
+  }
+  return OkStatus();
+}
+
+Status HierarchicalReducer::SendRecv(int phase, int step, int dst_idx,
+                                     const Tensor* send, int src_idx,
+                                     Tensor* recv) {
+  profiler::TraceMe activity(
+      [&] { return strings::StrCat("SendRecv:", phase, ":", step); },
+      profiler::TraceMeLevel::kInfo);
+  const int my_idx = col_params_->default_rank;
+  const CollGroupMember& dst = col_params_->group.members[dst_idx];
+  const CollGroupMember& src = col_params_->group.members[src_idx];
+  mutex mu;
+  Status status;
+  BlockingCounter pending(2);
+  auto done = [&mu, &status, &pending](const Status& s) {
+    {
+      mutex_lock l(mu);
+      status.Update(s);
+    }
+    pending.DecrementCount();
+  };
+  col_ctx_->col_exec->remote_access()->PostToPeer(
+      dst.device.name(), dst.task,
+      HierarchicalReduceBufKey(col_ctx_->exec_key, phase, step, my_idx,
+                               dst_idx),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), send,
+      col_ctx_->device_locality, col_ctx_->op_ctx->cancellation_manager(),
+      done);
+  col_ctx_->col_exec->remote_access()->RecvFromPeer(
+      src.device.name(), src.task, src.is_local,
+      HierarchicalReduceBufKey(col_ctx_->exec_key, phase, step, src_idx,
+                               my_idx),
+      col_ctx_->device, col_ctx_->op_ctx->op_device_context(),
+      col_ctx_->op_ctx->output_alloc_attr(0), recv, col_ctx_->device_locality,
+      0 /*dev_to_dev_stream_index*/, col_ctx_->op_ctx->cancellation_manager(),
+      done);
+  pending.Wait();
+  mutex_lock l(mu);
+  return status;
+}
+
+Status HierarchicalReducer::Finalize(Tensor* chunk) {
+  Tensor group_size = ca_->Scalar(col_params_->group.group_size);
+  if (col_params_->group.device_type != DEVICE_CPU) {
+    Tensor host_group_size = group_size;
+    group_size = ca_->Scalar(
+        col_ctx_->device->GetAllocator(col_ctx_->op_ctx->input_alloc_attr(0)),
+        AllocationAttributes());
+    Notification note;
+    Status status;
+    col_ctx_->op_ctx->op_device_context()->CopyCPUTensorToDevice(
+        &host_group_size, col_ctx_->device, &group_size,
+        [&note, &status](const Status& s) {
+          status = s;
+          note.Notify();
+        });
+    note.WaitForNotification();
+    TF_RETURN_IF_ERROR(status);
+  }
+  return collective_util::ComputeBinOp(
+      col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
+      col_params_->final_op, chunk, &group_size);
+}
+
+namespace {
+REGISTER_COLLECTIVE(HierarchicalReduce, HierarchicalReducer);
+}  // namespace
+
+}  // namespace tensorflow
@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/base_collective_executor.h"
+#include "tensorflow/core/framework/collective.h"
+
+namespace tensorflow {
+
+// Two-level implementation of collective all-reduce, for groups whose devices
+// span several tasks with the same number of devices each.
+//
+// With T tasks of D devices, the tensor is split into D shards, and each shard
+// into T chunks.  The reduction runs in three phases:
+//  1. A ring reduce-scatter between the devices of each task, after which
+//     each device holds one shard reduced over its task.
+//  2. For each shard, a ring all-reduce between the devices that hold it, one
+//     per task, which is the only phase that crosses tasks.
+//  3. A ring all-gather of the shards between the devices of each task.
+// Compared to a flat ring over all T * D devices, each device sends the same
+// number of bytes, but only 2 * (T - 1) of its messages cross tasks instead
+// of 2 * (T * D - 1).
+class HierarchicalReducer : public CollectiveImplementationInterface {
+ public:
+  HierarchicalReducer();
+  ~HierarchicalReducer() override = default;
+
+  // Checks that the devices of each task are adjacent in the group and that
+  // every task has the same number of devices.
+  Status InitializeCollectiveParams(CollectiveParams* col_params) override;
+
+  // Initializes members of CollectiveContext not yet initialized, i.e. device
+  // and device_locality.  Also saves the CollectiveContext in this object.
+  Status InitializeCollectiveContext(
+      std::shared_ptr<CollectiveContext> col_ctx) override;
+
+  // Begins execution of the hierarchical all-reduce.
+  // Must be called in a blockable thread.
+  void Run(StatusCallback done) override;
+
+  // Returns the number of devices per task of `group`, or an error if its
+  // tasks do not have the same number of adjacent devices.
+  static Status DevicesPerTask(const CollGroupParams& group,
+                               int* devices_per_task);
+
+ private:
+  // A ring of devices, by index in the group members.
+  struct Ring {
+    std::vector<int> members;
+    int my_pos;
+
+    int size() const { return static_cast<int>(members.size()); }
+    int next() const { return members[(my_pos + 1) % size()]; }
+    int prev() const { return members[(my_pos + size() - 1) % size()]; }
+  };
+
+  // Returns the part of the value made of chunks [begin, end).
+  Tensor Chunks(int begin, int end) const;
+
+  // Reduce-scatters the parts of the value between the devices of `ring`,
+  // where part i is the range of chunks [parts[i], parts[i] + width).
+  // Afterwards, the device at position p holds part (p + 1) % ring.size()
+  // reduced over the ring.
+  Status ReduceScatter(int phase, const Ring& ring,
+                       const std::vector<int>& parts, int width);
+
+  // Inverse of `ReduceScatter()`: starting from the device at position p
+  // holding part (p + 1) % ring.size(), sends each part to every device.
+  Status AllGather(int phase, const Ring& ring, const std::vector<int>& parts,
+                   int width);
+
+  // Sends `send` to the device at group index `dst_idx` while receiving
+  // `recv` from the device at group index `src_idx`, and waits for both.
+  Status SendRecv(int phase, int step, int dst_idx, const Tensor* send,
+                  int src_idx, Tensor* recv);
+
+  // Applies the final op of the reduction to `chunk`.
+  Status Finalize(Tensor* chunk);
+
+  std::shared_ptr<CollectiveContext> col_ctx_;
+  const CollectiveParams* col_params_;  // Not owned
+  std::unique_ptr<CollectiveAdapter> ca_;
+  int num_tasks_;
+  int devices_per_task_;
+  int64_t chunk_elts_;
+};
+
+}  // namespace tensorflow
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_HIERARCHICAL_REDUCER_H_
@@ -0,0 +1,160 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/hierarchical_reducer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/collective_test_util.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/framework/collective.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/version.h"
+
+namespace tensorflow {
+namespace {
+
+std::unique_ptr<OpKernel> GetBinOp(const string& op, DataType dtype,
+                                   const DeviceType& device_type,
+                                   DeviceBase* device) {
+  NodeDef node_def;
+  TF_CHECK_OK(NodeDefBuilder("bin_op", op)
+                  .Attr("T", dtype)
+                  .Input(FakeInput(dtype))
+                  .Input(FakeInput(dtype))
+                  .Finalize(&node_def));
+  Status status;
+  std::unique_ptr<OpKernel> k = CreateOpKernel(
+      device_type, device, device->GetAllocator(AllocatorAttributes()),
+      node_def, TF_GRAPH_DEF_VERSION, &status);
+  TF_CHECK_OK(status);
+  return k;
+}
+
+class HierarchicalReducerTest : public ::testing::Test {
+ protected:
+  struct DeviceInstance {
+    Tensor tensor;
+    Device* device;
+    core::RefCountPtr<CollectiveParams> col_params;
+    std::unique_ptr<OpKernel> merge_op;
+    std::unique_ptr<OpKernel> final_op;
+    Status status;
+  };
+
+  // Computes the mean over `num_workers` * `num_devices` devices of a tensor
+  // of `tensor_len` elements, and checks the result on every device.
+  template <typename T>
+  void RunTest(DataType dtype, int num_workers, int num_devices,
+               int tensor_len) {
+    test_env_ = CreateCollectiveTestEnv(num_workers, num_devices, DEVICE_CPU);
+    const int group_size = num_workers * num_devices;
+    std::vector<T> expected(tensor_len);
+    std::vector<DeviceInstance> instances(group_size);
+    for (int rank = 0; rank < group_size; ++rank) {
+      DeviceInstance& instance = instances[rank];
+      instance.col_params = CreateCollectiveParams(
+          *test_env_, rank, "HierarchicalReduce", REDUCTION_COLLECTIVE, dtype,
+          TensorShape({tensor_len}));
+      const string& dev_name =
+          instance.col_params->group.members[rank].device.name();
+      TF_CHECK_OK(
+          test_env_->device_mgr->LookupDevice(dev_name, &instance.device));
+      instance.merge_op = GetBinOp("Add", dtype, DEVICE_CPU, instance.device);
+      instance.final_op = GetBinOp("Div", dtype, DEVICE_CPU, instance.device);
+      instance.col_params->merge_op = instance.merge_op.get();
+      instance.col_params->final_op = instance.final_op.get();
+      instance.tensor = Tensor(dtype, TensorShape({tensor_len}));
+      for (int i = 0; i < tensor_len; ++i) {
+        const T value = static_cast<T>(rank * 10 + i);
+        instance.tensor.flat<T>()(i) = value;
+        expected[i] += value;
+      }
+    }
+    for (int i = 0; i < tensor_len; ++i) {
+      expected[i] /= static_cast<T>(group_size);
+    }
+
+    std::atomic<int> done(0);
+    for (DeviceInstance& instance : instances) {
+      SchedClosure([this, &instance, &done] {
+        instance.status =
+            RunCollective(test_env_.get(), instance.col_params.get(),
+                          instance.device, &instance.tensor, &instance.tensor);
+        ++done;
+      });
+    }
+    while (done < group_size) {
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    for (const DeviceInstance& instance : instances) {
+      TF_EXPECT_OK(instance.status);
+      test::ExpectTensorEqual<T>(test::AsTensor<T>(expected), instance.tensor);
+    }
+  }
+
+  std::unique_ptr<CollectiveTestEnv> test_env_;
+};
+
+TEST_F(HierarchicalReducerTest, OneWorker) {
+  RunTest<float>(DT_FLOAT, 1, 4, 1001);
+}
+
+TEST_F(HierarchicalReducerTest, OneDevicePerWorker) {
+  RunTest<float>(DT_FLOAT, 4, 1, 1001);
+}
+
+TEST_F(HierarchicalReducerTest, MultipleWorkers) {
+  RunTest<float>(DT_FLOAT, 2, 4, 128);
+  RunTest<float>(DT_FLOAT, 3, 4, 4095);
+  RunTest<double>(DT_DOUBLE, 4, 2, 9408);
+  RunTest<int64_t>(DT_INT64, 2, 3, 1001);
+}
+
+TEST_F(HierarchicalReducerTest, FewerElementsThanChunks) {
+  RunTest<float>(DT_FLOAT, 2, 4, 3);
+}
+
+TEST(HierarchicalReducerDevicesPerTaskTest, RequiresSameDevicesPerTask) {
+  CollGroupParams group;
+  group.num_tasks = 2;
+  for (const char* task : {"/job:worker/task:0", "/job:worker/task:0",
+                           "/job:worker/task:1", "/job:worker/task:1"}) {
+    CollGroupMember member;
+    member.task = task;
+    group.members.push_back(member);
+  }
+  int devices_per_task = 0;
+  TF_EXPECT_OK(
+      HierarchicalReducer::DevicesPerTask(group, &devices_per_task));
+  EXPECT_EQ(devices_per_task, 2);
+
+  group.members.pop_back();
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      HierarchicalReducer::DevicesPerTask(group, &devices_per_task)));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -50,6 +50,22 @@ struct LocalExecutorParams {
 
   // Whether control flow nodes are allowed to be executed synchronously.
   bool allow_control_flow_sync_execution = false;
+
+  // If true, the executor measures the cost of every synchronous kernel, and
+  // decides whether to run it inline or on another thread based on the
+  // measurements from previous executions, instead of only trusting
+  // `OpKernel::IsExpensive()`. The measurements are kept for the lifetime of
+  // the executor. Can also be enabled for all executors by setting the
+  // TF_EXECUTOR_DISPATCH_BY_MEASURED_COST environment variable to true.
+  bool dispatch_by_measured_cost = false;
+
+  // If true, and the graph does not use v1 control flow, the executor records
+  // the sizes of the kernel outputs during the first steps, then plans the
+  // outputs with static sizes into one arena based on their lifetimes in a
+  // topological order, and serves them from the arena instead of the device
+  // allocator in later steps. Can also be enabled for all executors by
+  // setting the TF_EXECUTOR_STATIC_MEMORY_PLAN environment variable to true.
+  bool use_static_memory_plan = false;
 };
 
 }  // end namespace tensorflow
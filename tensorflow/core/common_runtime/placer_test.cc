@@ -37,11 +37,13 @@ limitations under the License.
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
@@ -3112,5 +3114,57 @@ TEST_F(NestedPlacerTest, IndirectRecursion) {
       << s.ToString();
 }
 
+// Builds a synthetic graph of `num_nodes` nodes: chains of TestRelu nodes
+// joined by TestAdd nodes, one in four of which requests a GPU.
+void BuildLargeGraph(int num_nodes, Graph* graph) {
+  Node* input;
+  TF_CHECK_OK(NodeBuilder("in", "TestInput").Finalize(graph, &input));
+  Node* prev = input;
+  for (int i = 1; i < num_nodes; ++i) {
+    const string name = strings::StrCat("n", i);
+    NodeBuilder builder = i % 3 == 0
+                              ? NodeBuilder(name, "TestAdd")
+                                    .Input(prev)
+                                    .Input(input, i % 2)
+                              : NodeBuilder(name, "TestRelu").Input(prev);
+    if (i % 4 == 0) {
+      builder.Device("/job:a/replica:0/task:0/device:FakeGPU:0");
+    }
+    TF_CHECK_OK(builder.Finalize(graph, &prev));
+    // Start a new chain every 100 nodes.
+    if (i % 100 == 0) prev = input;
+  }
+}
+
+static void BM_PlaceLargeGraph(::testing::benchmark::State& state) {
+  const int num_nodes = state.range(0);
+
+  std::vector<std::unique_ptr<Device>> local_devices;
+  DeviceSet devices;
+  for (int i = 0; i < 10; ++i) {
+    local_devices.emplace_back(FakeDevice::MakeCPU(
+        strings::StrCat("/job:a/replica:0/task:0/device:FakeCPU:", i)));
+    devices.AddDevice(local_devices.back().get());
+    local_devices.emplace_back(FakeDevice::MakeGPU(
+        strings::StrCat("/job:a/replica:0/task:0/device:FakeGPU:", i)));
+    devices.AddDevice(local_devices.back().get());
+  }
+
+  std::unique_ptr<Graph> graph;
+  for (auto s : state) {
+    // Building (and destroying) the graph is not timed.
+    state.PauseTiming();
+    graph = std::make_unique<Graph>(OpRegistry::Global());
+    BuildLargeGraph(num_nodes, graph.get());
+    state.ResumeTiming();
+
+    Placer placer(graph.get(), "", &graph->flib_def(), &devices);
+    TF_CHECK_OK(placer.Run());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_nodes);
+}
+BENCHMARK(BM_PlaceLargeGraph)->Arg(100000)->Arg(1000000)->Arg(5000000);
+
 }  // namespace
 }  // namespace tensorflow
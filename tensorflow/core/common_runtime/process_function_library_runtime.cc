@@ -50,9 +50,12 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/reffed_status_callback.h"
 #if !defined(IS_MOBILE_PLATFORM)
@@ -671,8 +674,87 @@ Status ValidateMultiDeviceOptions(
   return OkStatus();
 }
 
+// Returns the key of the optimized and partitioned graphs of a multi-device
+// function in `PartitionedFunctionGraphCache`. `graph_def` is the body of the
+// instantiated function, including its reachable function library, so equal
+// functions loaded by different sessions or eager contexts share a key.
+string PartitionedFunctionGraphCacheKey(
+    const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    const GraphDef& graph_def, const DeviceSet& device_set) {
+  // The library and state handle only identify the runtime that instantiates
+  // the function, and do not change its graphs.
+  FunctionLibraryRuntime::InstantiateOptions key_options = options;
+  key_options.lib_def = nullptr;
+  key_options.state_handle.clear();
+  string graph_def_serialized;
+  SerializeToStringDeterministic(graph_def, &graph_def_serialized);
+  string key = strings::StrCat(
+      Canonicalize(function_name, attrs, key_options), ";graph=",
+      Fingerprint64(graph_def_serialized), ";xla=",
+      options.xla_compile_device_type,
+      ";default_device_to_target=", options.default_device_to_target,
+      ";component=", options.is_component_function,
+      ";optimize_graph_fn=", options.optimize_graph_fn != nullptr,
+      ";devices=");
+  std::vector<string> devices;
+  for (const Device* d : device_set.devices()) {
+    devices.push_back(strings::StrCat(d->name(), ":", d->device_type()));
+  }
+  std::sort(devices.begin(), devices.end());
+  absl::StrAppend(&key, absl::StrJoin(devices, ","), ";composite_devices=");
+  std::vector<string> composite_devices;
+  for (const auto& composite : options.composite_devices) {
+    composite_devices.push_back(strings::StrCat(
+        composite.first, ":", absl::StrJoin(*composite.second, ",")));
+  }
+  std::sort(composite_devices.begin(), composite_devices.end());
+  absl::StrAppend(&key, absl::StrJoin(composite_devices, ";"));
+  return key;
+}
+
 }  // anonymous namespace
 
+PartitionedFunctionGraphCache::PartitionedFunctionGraphCache() {
+  bool enabled;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_ENABLE_PERSISTENT_FUNCTION_GRAPH_CACHE",
+                                 /*default_val=*/false, &enabled));
+  enabled_ = enabled;
+}
+
+/* static */
+PartitionedFunctionGraphCache* PartitionedFunctionGraphCache::Global() {
+  static PartitionedFunctionGraphCache* cache =
+      new PartitionedFunctionGraphCache;
+  return cache;
+}
+
+std::shared_ptr<const PartitionedFunctionGraphCache::Entry>
+PartitionedFunctionGraphCache::Lookup(const string& key) const {
+  tf_shared_lock l(mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) return nullptr;
+  num_hits_.fetch_add(1);
+  return it->second;
+}
+
+void PartitionedFunctionGraphCache::Insert(const string& key,
+                                           std::shared_ptr<const Entry> entry) {
+  mutex_lock l(mu_);
+  if (entries_.size() >= kMaxEntries) return;
+  entries_.emplace(key, std::move(entry));
+}
+
+int64_t PartitionedFunctionGraphCache::size() const {
+  tf_shared_lock l(mu_);
+  return entries_.size();
+}
+
+void PartitionedFunctionGraphCache::Clear() {
+  mutex_lock l(mu_);
+  entries_.clear();
+}
+
 ProcessFunctionLibraryRuntime::AsyncAttributes::Summary
 ProcessFunctionLibraryRuntime::AsyncAttributes::Summarize(const Graph* graph) {
   bool has_send_op = false;
@@ -752,102 +834,19 @@ Status GetGraphAndArgRets(
   return OkStatus();
 }
 
-Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
-    const string& function_name, AttrSlice attrs,
+Status ProcessFunctionLibraryRuntime::OptimizeAndPartitionMultiDeviceFunction(
+    const string& function_name,
     const FunctionLibraryRuntime::InstantiateOptions& options,
-    FunctionLibraryRuntime::Handle* handle) {
-  // Check if this function has already been instantiated.
-  const string& function_key = Canonicalize(function_name, attrs, options);
-
-  {
-    mutex_lock l(mu_);
-    const auto& it = table_.find(function_key);
-    if (it != table_.end()) {
-      *handle = it->second;
-      ++mdevice_data_[*handle]->instantiation_counter_;
-      return OkStatus();
-    }
-  }
-
-  VLOG(1) << "Instantiating MultiDevice function \"" << function_name
-          << "\" on default device \"" << options.target << "\"";
-  if (VLOG_IS_ON(3)) {
-    int index = 0;
-    VLOG(3) << "Requested input devices:";
-    for (const string& device : options.input_devices) {
-      VLOG(3) << "    [input " << index++ << "] " << device;
-    }
-    index = 0;
-    VLOG(3) << "Requested output devices:";
-    for (const string& device : options.output_devices) {
-      VLOG(3) << "    [output " << index++ << "] " << device;
-    }
-  }
-
-  const FunctionLibraryDefinition* lib_def =
-      options.lib_def == nullptr ? lib_def_ : options.lib_def;
-
-  const FunctionDef* fdef = lib_def->Find(function_name);
-  if (fdef == nullptr) {
-    return errors::InvalidArgument("Failed to find function \"", function_name,
-                                   "\" in function library: ", lib_def);
-  }
-
-  TF_RETURN_IF_ERROR(ValidateMultiDeviceOptions(*fdef, options));
-
-  std::unique_ptr<Graph> graph;
-  std::vector<Node*> arg_nodes, ret_nodes;
-  std::vector<string> ret_node_names;
-  DataTypeVector ret_types;
-  std::vector<string> control_ret_node_names;
-
-  TF_RETURN_IF_ERROR(GetGraphAndArgRets(
-      function_name, attrs, fdef, lib_def, &graph, &arg_nodes, &ret_nodes,
-      &ret_node_names, &ret_types, &control_ret_node_names));
-
-  GraphDef graph_def;
-  graph->ToGraphDef(&graph_def);
-  FunctionLibraryDefinition reachable_lib_def =
-      lib_def->ReachableDefinitions(graph_def);
-  *graph_def.mutable_library() = reachable_lib_def.ToProto();
-  if (options.graph_collector != nullptr) {
-    options.graph_collector->CollectRawGraph(graph_def);
-  }
-
-  Device* default_device = nullptr;
-  if (options.default_device_to_target && !options.target.empty()) {
-    // Make the `target` device the default device if nothing else is hard
-    // coded. This allows the same function definition to be specialized to
-    // different devices depending on the `PartitionedCallOp` device.
-    FunctionLibraryRuntime* flr = GetFLR(options.target);
-    if (flr == nullptr) {
-      return errors::InvalidArgument(
-          "Cannot instantiate multi-device function with target device ",
-          options.target);
-    }
-    default_device = flr->device();
-  }
-
-  // Mark each node in the graph to be compiled by specified device.
-  if (!options.xla_compile_device_type.empty()) {
-    for (Node* node : graph->op_nodes()) {
-      node->AddAttr("_xla_compile_device_type",
-                    options.xla_compile_device_type);
-    }
-  }
-
-  const std::shared_ptr<DeviceSet> dev_set = device_set();
-
-  TF_RETURN_IF_ERROR(
-      SetArgShape(options.input_resource_dtypes_and_shapes, arg_nodes));
-  TF_RETURN_IF_ERROR(PinArgsAndRets(
-      options.input_devices, options.output_devices, *dev_set, arg_nodes,
-      ret_nodes, lib_def_,
-      options.config_proto.allow_soft_placement() ? default_device : nullptr));
-
-  auto data = std::make_unique<MultiDeviceFunctionData>(
-      function_name, function_key, ret_node_names.size(),
-      std::move(reachable_lib_def), std::move(ret_types));
+    const FunctionDef* fdef, const FunctionLibraryDefinition* lib_def,
+    Device* default_device, const std::shared_ptr<DeviceSet>& dev_set,
+    std::unique_ptr<Graph> graph, std::vector<string> ret_node_names,
+    std::vector<string> control_ret_node_names, MultiDeviceFunctionData* data,
+    std::unordered_map<string, string>* node_name_to_control_ret_ptr,
+    std::unordered_map<string, std::unique_ptr<Graph>>* subgraphs_ptr) {
+  std::unordered_map<string, string>& node_name_to_control_ret =
+      *node_name_to_control_ret_ptr;
+  std::unordered_map<string, std::unique_ptr<Graph>>& subgraphs =
+      *subgraphs_ptr;
 
   // The runtime shouldn't depend on duplication between the function library
   // owned by the graph and the one owned by the runtime. To ensure this, for
@@ -865,9 +864,6 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
             << function_name;
   }
 
-  // Mapping from a function body node name to the control output name.
-  std::unordered_map<string, string> node_name_to_control_ret;
-
   bool control_rets_updated = false;
   if (should_run_optimization_passes) {
     TF_RETURN_IF_ERROR(FunctionOptimizationPassRegistry::Global().Run(
@@ -968,7 +964,6 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
   VLOG(4) << "Main function graph to be partitioned:";
   VLOG(4) << DebugString(graph->ToGraphDefDebug());
 
-  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
   TF_RETURN_IF_ERROR(
       PartitionFunctionGraph(*dev_set, std::move(graph), &subgraphs));
 
@@ -1009,6 +1004,152 @@ Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
       options.graph_collector->CollectPartitionedGraph(def);
     }
   }
+  return OkStatus();
+}
+
+Status ProcessFunctionLibraryRuntime::InstantiateMultiDevice(
+    const string& function_name, AttrSlice attrs,
+    const FunctionLibraryRuntime::InstantiateOptions& options,
+    FunctionLibraryRuntime::Handle* handle) {
+  // Check if this function has already been instantiated.
+  const string& function_key = Canonicalize(function_name, attrs, options);
+
+  {
+    mutex_lock l(mu_);
+    const auto& it = table_.find(function_key);
+    if (it != table_.end()) {
+      *handle = it->second;
+      ++mdevice_data_[*handle]->instantiation_counter_;
+      return OkStatus();
+    }
+  }
+
+  VLOG(1) << "Instantiating MultiDevice function \"" << function_name
+          << "\" on default device \"" << options.target << "\"";
+  if (VLOG_IS_ON(3)) {
+    int index = 0;
+    VLOG(3) << "Requested input devices:";
+    for (const string& device : options.input_devices) {
+      VLOG(3) << "    [input " << index++ << "] " << device;
+    }
+    index = 0;
+    VLOG(3) << "Requested output devices:";
+    for (const string& device : options.output_devices) {
+      VLOG(3) << "    [output " << index++ << "] " << device;
+    }
+  }
+
+  const FunctionLibraryDefinition* lib_def =
+      options.lib_def == nullptr ? lib_def_ : options.lib_def;
+
+  const FunctionDef* fdef = lib_def->Find(function_name);
+  if (fdef == nullptr) {
+    return errors::InvalidArgument("Failed to find function \"", function_name,
+                                   "\" in function library: ", lib_def);
+  }
+
+  TF_RETURN_IF_ERROR(ValidateMultiDeviceOptions(*fdef, options));
+
+  std::unique_ptr<Graph> graph;
+  std::vector<Node*> arg_nodes, ret_nodes;
+  std::vector<string> ret_node_names;
+  DataTypeVector ret_types;
+  std::vector<string> control_ret_node_names;
+
+  TF_RETURN_IF_ERROR(GetGraphAndArgRets(
+      function_name, attrs, fdef, lib_def, &graph, &arg_nodes, &ret_nodes,
+      &ret_node_names, &ret_types, &control_ret_node_names));
+
+  GraphDef graph_def;
+  graph->ToGraphDef(&graph_def);
+  FunctionLibraryDefinition reachable_lib_def =
+      lib_def->ReachableDefinitions(graph_def);
+  *graph_def.mutable_library() = reachable_lib_def.ToProto();
+  if (options.graph_collector != nullptr) {
+    options.graph_collector->CollectRawGraph(graph_def);
+  }
+
+  Device* default_device = nullptr;
+  if (options.default_device_to_target && !options.target.empty()) {
+    // Make the `target` device the default device if nothing else is hard
+    // coded. This allows the same function definition to be specialized to
+    // different devices depending on the `PartitionedCallOp` device.
+    FunctionLibraryRuntime* flr = GetFLR(options.target);
+    if (flr == nullptr) {
+      return errors::InvalidArgument(
+          "Cannot instantiate multi-device function with target device ",
+          options.target);
+    }
+    default_device = flr->device();
+  }
+
+  // Mark each node in the graph to be compiled by specified device.
+  if (!options.xla_compile_device_type.empty()) {
+    for (Node* node : graph->op_nodes()) {
+      node->AddAttr("_xla_compile_device_type",
+                    options.xla_compile_device_type);
+    }
+  }
+
+  const std::shared_ptr<DeviceSet> dev_set = device_set();
+
+  TF_RETURN_IF_ERROR(
+      SetArgShape(options.input_resource_dtypes_and_shapes, arg_nodes));
+  TF_RETURN_IF_ERROR(PinArgsAndRets(
+      options.input_devices, options.output_devices, *dev_set, arg_nodes,
+      ret_nodes, lib_def_,
+      options.config_proto.allow_soft_placement() ? default_device : nullptr));
+
+  std::shared_ptr<const PartitionedFunctionGraphCache::Entry> cached_graphs;
+  string cache_key;
+  if (PartitionedFunctionGraphCache::Global()->enabled() &&
+      options.graph_collector == nullptr) {
+    cache_key = PartitionedFunctionGraphCacheKey(function_name, attrs, options,
+                                                 graph_def, *dev_set);
+    cached_graphs = PartitionedFunctionGraphCache::Global()->Lookup(cache_key);
+  }
+
+  auto data = std::make_unique<MultiDeviceFunctionData>(
+      function_name, function_key, ret_node_names.size(),
+      cached_graphs != nullptr
+          ? FunctionLibraryDefinition(lib_def->default_registry(),
+                                      cached_graphs->library)
+          : std::move(reachable_lib_def),
+      std::move(ret_types));
+
+  // Mapping from a function body node name to the control output name.
+  std::unordered_map<string, string> node_name_to_control_ret;
+  std::unordered_map<string, std::unique_ptr<Graph>> subgraphs;
+  if (cached_graphs != nullptr) {
+    VLOG(1) << "Reusing the optimized and partitioned graphs of \""
+            << function_name << "\" from a previous instantiation";
+    node_name_to_control_ret = cached_graphs->node_name_to_control_ret;
+    for (const auto& pair : cached_graphs->subgraphs) {
+      auto subgraph = std::make_unique<Graph>(&data->lib_def_);
+      GraphConstructorOptions opts;
+      opts.allow_internal_ops = true;
+      opts.expect_device_spec = true;
+      TF_RETURN_IF_ERROR(
+          ConvertGraphDefToGraph(opts, pair.second, subgraph.get()));
+      subgraphs.emplace(pair.first, std::move(subgraph));
+    }
+  } else {
+    TF_RETURN_IF_ERROR(OptimizeAndPartitionMultiDeviceFunction(
+        function_name, options, fdef, lib_def, default_device, dev_set,
+        std::move(graph), std::move(ret_node_names),
+        std::move(control_ret_node_names), data.get(),
+        &node_name_to_control_ret, &subgraphs));
+    if (!cache_key.empty()) {
+      auto entry = std::make_shared<PartitionedFunctionGraphCache::Entry>();
+      for (const auto& pair : subgraphs) {
+        pair.second->ToGraphDef(&entry->subgraphs[pair.first]);
+      }
+      entry->library = data->lib_def_.ToProto();
+      entry->node_name_to_control_ret = node_name_to_control_ret;
+      PartitionedFunctionGraphCache::Global()->Insert(cache_key,
+                                                      std::move(entry));
+    }
+  }
 
   // We must preserve control returns in each of the function components,
   // otherwise after function inlining we might prune side-effectful nodes.
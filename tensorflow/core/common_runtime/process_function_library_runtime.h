@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_FUNCTION_LIBRARY_RUNTIME_H_
 #define TENSORFLOW_CORE_COMMON_RUNTIME_PROCESS_FUNCTION_LIBRARY_RUNTIME_H_
 
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 // clang-format off
@@ -23,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/platform/platform.h"
 // clang-format on
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "tensorflow/core/common_runtime/composite_device.h"
@@ -30,7 +33,10 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #if !defined(IS_MOBILE_PLATFORM)
 #include "tensorflow/core/protobuf/remote_tensor_handle.pb.h"
@@ -58,6 +64,58 @@ class FunctionArgsInterface {
 #endif  // IS_MOBILE_PLATFORM
 };
 
+// A process-wide cache of the optimized and partitioned graphs of multi-device
+// functions, shared by all the ProcessFunctionLibraryRuntime instances of the
+// process. Entries are keyed by the content of the instantiated function body
+// and its function library, the instantiation options and the target device
+// set, so loading the same model several times runs the function and graph
+// optimization passes, the placer and the partitioner only once.
+//
+// The cache is disabled unless TF_ENABLE_PERSISTENT_FUNCTION_GRAPH_CACHE is
+// set to true. It assumes that the `optimize_graph_fn` of the instantiation
+// options only depends on the other options, which holds for the functions
+// optimized with Grappler.
+class PartitionedFunctionGraphCache {
+ public:
+  // Maximum number of cached functions. Functions instantiated once the cache
+  // is full are not cached.
+  static constexpr int kMaxEntries = 1024;
+
+  struct Entry {
+    // Partitioned graphs by device, after all the optimization passes.
+    std::unordered_map<string, GraphDef> subgraphs;
+    // Function library of the function after the optimization passes.
+    FunctionDefLibrary library;
+    // Mapping from a function body node name to the control output name.
+    std::unordered_map<string, string> node_name_to_control_ret;
+  };
+
+  static PartitionedFunctionGraphCache* Global();
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+
+  // Returns the entry for `key`, or nullptr if there is none.
+  std::shared_ptr<const Entry> Lookup(const string& key) const
+      TF_LOCKS_EXCLUDED(mu_);
+  void Insert(const string& key, std::shared_ptr<const Entry> entry)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int64_t size() const TF_LOCKS_EXCLUDED(mu_);
+  // Number of successful lookups since the process started.
+  int64_t num_hits() const { return num_hits_.load(); }
+  void Clear() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  PartitionedFunctionGraphCache();
+
+  std::atomic<bool> enabled_;
+  mutable std::atomic<int64_t> num_hits_{0};
+  mutable mutex mu_;
+  absl::flat_hash_map<string, std::shared_ptr<const Entry>> entries_
+      TF_GUARDED_BY(mu_);
+};
+
 // A class that stores all the FunctionLibraryRuntime objects, one per device.
 class ProcessFunctionLibraryRuntime {
  public:
@@ -388,6 +446,21 @@ class ProcessFunctionLibraryRuntime {
       const FunctionLibraryRuntime::InstantiateOptions& options,
       FunctionLibraryRuntime::Handle* handle);
 
+  // Runs the function and graph optimization passes and the placer on
+  // `graph`, the body of the multi-device function `function_name`, adding the
+  // functions they create to `data->lib_def_`, and partitions it into
+  // `subgraphs` by device.
+  Status OptimizeAndPartitionMultiDeviceFunction(
+      const string& function_name,
+      const FunctionLibraryRuntime::InstantiateOptions& options,
+      const FunctionDef* fdef, const FunctionLibraryDefinition* lib_def,
+      Device* default_device, const std::shared_ptr<DeviceSet>& dev_set,
+      std::unique_ptr<Graph> graph, std::vector<string> ret_node_names,
+      std::vector<string> control_ret_node_names,
+      MultiDeviceFunctionData* data,
+      std::unordered_map<string, string>* node_name_to_control_ret,
+      std::unordered_map<string, std::unique_ptr<Graph>>* subgraphs);
+
   void InstantiateRemote(
       const string& function_name, AttrSlice attrs,
       const FunctionLibraryRuntime::InstantiateOptions& options,
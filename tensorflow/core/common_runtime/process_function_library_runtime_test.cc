@@ -1310,6 +1310,30 @@ TEST_F(ProcessFunctionLibraryRuntimeTest, UnsafeOpRequiresAsync) {
   EXPECT_GT(async_unsafe_op.Get(), 0);
 }
 
+TEST_F(ProcessFunctionLibraryRuntimeTest, MultiDevice_PersistentGraphCache) {
+  PartitionedFunctionGraphCache* cache =
+      PartitionedFunctionGraphCache::Global();
+  const bool was_enabled = cache->enabled();
+  cache->Clear();
+  cache->set_enabled(true);
+  const int64_t num_hits = cache->num_hits();
+
+  const FunctionLibraryRuntime::InstantiateOptions opts =
+      MakeOptions("CPU:0", {"CPU:1"}, {"CPU:1"});
+  TestControlFlow(this, opts);
+  EXPECT_EQ(cache->size(), 1);
+  EXPECT_EQ(cache->num_hits(), num_hits);
+
+  // `TestControlFlow()` creates a new runtime, which reuses the graphs
+  // optimized and partitioned by the previous one.
+  TestControlFlow(this, opts);
+  EXPECT_EQ(cache->size(), 1);
+  EXPECT_EQ(cache->num_hits(), num_hits + 1);
+
+  cache->Clear();
+  cache->set_enabled(was_enabled);
+}
+
 TEST_F(ProcessFunctionLibraryRuntimeTest, PartitionedGraphRequiresAsync) {
   if (gpu_device_ == nullptr) {
     GTEST_SKIP() << "No GPUs available";
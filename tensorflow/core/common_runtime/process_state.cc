@@ -103,6 +103,25 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
 
       BFCAllocator::Options allocator_opts;
       allocator_opts.allow_growth = true;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_SMALL_CHUNK_CACHE",
+                                  /*default_val=*/false,
+                                  &allocator_opts.small_chunk_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      status = ReadInt64FromEnvVar("TF_BFC_ALLOCATION_TIMELINE_SIZE",
+                                   /*default_val=*/0,
+                                   &allocator_opts.allocation_timeline_size);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      status = ReadInt64FromEnvVar(
+          "TF_BFC_FRAGMENTATION_SAMPLING_INTERVAL_MICROS",
+          /*default_val=*/0,
+          &allocator_opts.fragmentation_sampling_interval_micros);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       allocator = new BFCAllocator(
           absl::WrapUnique(sub_allocator), cpu_mem_limit,
           /*name=*/"bfc_cpu_allocator_for_gpu", allocator_opts);
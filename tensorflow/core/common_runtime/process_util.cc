@@ -22,10 +22,16 @@ limitations under the License.
 #endif  // defined(ENABLE_MKL) && defined(ENABLE_ONEDNN_OPENMP)
 #include <string.h>
 
+#include <atomic>
+#include <vector>
+
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/util.h"
@@ -163,6 +169,48 @@ thread::ThreadPool* NewThreadPoolFromSessionOptions(
       /*allocator=*/nullptr);
 }
 
+bool UseNUMAThreadPools(const SessionOptions& options) {
+  return options.config.experimental().use_numa_affinity() &&
+         port::NUMAEnabled() && port::NUMANumNodes() > 1;
+}
+
+int NextNUMANode() {
+  static std::atomic<uint32> next_numa_node{0};
+  return next_numa_node.fetch_add(1, std::memory_order_relaxed) %
+         port::NUMANumNodes();
+}
+
+thread::ThreadPool* NewThreadPoolFromSessionOptions(
+    const SessionOptions& options, int numa_node) {
+  int32_t num_threads = options.config.inter_op_parallelism_threads();
+  if (num_threads <= 0) num_threads = GetEnvNumInterOpThreads();
+  if (num_threads <= 0) num_threads = port::MaxParallelism(numa_node);
+  VLOG(1) << "Session inter op parallelism threads for NUMA node "
+          << numa_node << ": " << num_threads;
+  ThreadOptions thread_options;
+  thread_options.numa_node = numa_node;
+  return new thread::ThreadPool(
+      options.env, thread_options,
+      strings::StrCat("numa_", numa_node, "_Compute"), num_threads,
+      !options.config.experimental().disable_thread_spinning(),
+      /*allocator=*/nullptr);
+}
+
+thread::ThreadPool* NUMAComputePool(const SessionOptions& options,
+                                    int numa_node) {
+  static mutex* mu = new mutex();
+  static std::vector<thread::ThreadPool*>* pools =
+      new std::vector<thread::ThreadPool*>;
+  mutex_lock l(*mu);
+  if (pools->size() <= static_cast<size_t>(numa_node)) {
+    pools->resize(numa_node + 1, nullptr);
+  }
+  if ((*pools)[numa_node] == nullptr) {
+    (*pools)[numa_node] = NewThreadPoolFromSessionOptions(options, numa_node);
+  }
+  return (*pools)[numa_node];
+}
+
 void SchedClosure(std::function<void()> closure) {
   if (!tracing::EventCollector::IsEnabled()) {
     return Env::Default()->SchedClosure(std::move(closure));
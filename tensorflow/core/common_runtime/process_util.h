@@ -48,6 +48,25 @@ int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options);
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options);
 
+// Returns true if `options` enable NUMA affinity and the process runs on more
+// than one NUMA node.
+bool UseNUMAThreadPools(const SessionOptions& options);
+
+// Returns the NUMA node to which a new session or request is pinned when
+// `UseNUMAThreadPools()` is true. Nodes are assigned round-robin.
+int NextNUMANode();
+
+// Creates a thread pool of inter op threads bound to `numa_node`. Unless a
+// number of threads is specified by `options` or TF_NUM_INTEROP_THREADS, the
+// pool has one thread per schedulable CPU of the node.
+thread::ThreadPool* NewThreadPoolFromSessionOptions(
+    const SessionOptions& options, int numa_node);
+
+// Returns a process-wide ThreadPool of inter op threads bound to `numa_node`.
+// Caller does not take ownership over threadpool.
+thread::ThreadPool* NUMAComputePool(const SessionOptions& options,
+                                    int numa_node);
+
 // Schedule "closure" in the default thread queue.
 void SchedClosure(std::function<void()> closure);
 
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/common_runtime/process_util.h"
 
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -34,5 +35,26 @@ TEST(ProcessUtilTest, ThreadPool) {
   delete pool;
 }
 
+TEST(ProcessUtilTest, NUMAThreadPool) {
+  SessionOptions opts;
+  opts.config.set_inter_op_parallelism_threads(3);
+
+  thread::ThreadPool* pool = NewThreadPoolFromSessionOptions(opts, 0);
+  EXPECT_EQ(3, pool->NumThreads());
+  delete pool;
+
+  // The process-wide pools are created once per node.
+  EXPECT_EQ(NUMAComputePool(opts, 0), NUMAComputePool(opts, 0));
+  EXPECT_EQ(3, NUMAComputePool(opts, 0)->NumThreads());
+}
+
+TEST(ProcessUtilTest, NextNUMANode) {
+  for (int i = 0; i < 10; ++i) {
+    const int numa_node = NextNUMANode();
+    EXPECT_GE(numa_node, 0);
+    EXPECT_LT(numa_node, port::NUMANumNodes());
+  }
+}
+
 }  // anonymous namespace
 }  // namespace tensorflow
@@ -209,9 +209,16 @@ bool RingReducer::RunAsyncParts() {
     }
   }
 
+  // On CPU, reductions run synchronously in the calling thread.  Run them as
+  // separate closures instead, so that this thread keeps dispatching the
+  // transfers of the other fields while a received chunk is being reduced.
+  // On GPU, ComputeBinOp only enqueues the reduction on a stream.
+  const bool async_reduce = (gpu_info == nullptr);
+
   int field_done_count = 0;
   int send_pending_count = 0;
   int recv_pending_count = 0;
+  int reduce_pending_count = 0;
   std::atomic<bool> aborted(false);
 
   {
@@ -254,6 +261,23 @@ bool RingReducer::RunAsyncParts() {
             --recv_pending_count;
             if (!rf->second_pass) {
               rf->action = RF_REDUCE;
+              if (async_reduce) {
+                col_ctx_->col_exec->RunClosure(
+                    [this, rf, &ready_queue, &aborted]() {
+                      Status s = collective_util::ComputeBinOp(
+                          col_ctx_->op_ctx, col_ctx_->op_params,
+                          col_ctx_->device, col_params_->merge_op, &rf->chunk,
+                          &rf->tmp_chunk);
+                      if (!s.ok()) {
+                        aborted = true;
+                        StartAbort(s);
+                      }
+                      ready_queue.Enqueue(rf);
+                    });
+                dispatched = true;
+                ++reduce_pending_count;
+                break;
+              }
               Status s = collective_util::ComputeBinOp(
                   col_ctx_->op_ctx, col_ctx_->op_params, col_ctx_->device,
                   col_params_->merge_op, &rf->chunk, &rf->tmp_chunk);
@@ -266,6 +290,10 @@ bool RingReducer::RunAsyncParts() {
             }
             break;
           case RF_REDUCE:
+            if (async_reduce) {
+              CHECK_GT(reduce_pending_count, 0);
+              --reduce_pending_count;
+            }
             if (!rf->second_pass && col_params_->final_op && rf->is_final) {
               rf->action = RF_FINALIZE;
               group_size_tensor_ready_.WaitForNotification();
@@ -324,12 +352,16 @@ bool RingReducer::RunAsyncParts() {
     if (aborted) {
       // All of the pending data actions should be aborted; field the
       // callbacks and clear the queue before quitting.
-      while ((send_pending_count > 0) || (recv_pending_count > 0)) {
+      while ((send_pending_count > 0) || (recv_pending_count > 0) ||
+             (reduce_pending_count > 0)) {
         RingField* rf = ready_queue.Dequeue();
         switch (rf->action) {
           case RF_RECV:
             --recv_pending_count;
             break;
+          case RF_REDUCE:
+            if (async_reduce) --reduce_pending_count;
+            break;
           case RF_SEND:
             --send_pending_count;
             break;
@@ -342,6 +374,7 @@ bool RingReducer::RunAsyncParts() {
 
   CHECK_EQ(send_pending_count, 0);
   CHECK_EQ(recv_pending_count, 0);
+  CHECK_EQ(reduce_pending_count, 0);
 
   VLOG(2) << this << " device=" << col_ctx_->device_name << " finish;"
           << " final value " << TensorDebugString(ca_->Value());
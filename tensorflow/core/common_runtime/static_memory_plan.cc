@@ -0,0 +1,373 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/common_runtime/graph_view.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+int64_t RoundUp(int64_t size, int64_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+bool LifetimesOverlap(const PlannedBuffer& a, const PlannedBuffer& b) {
+  return a.first_use <= b.last_use && b.first_use <= a.last_use;
+}
+
+}  // namespace
+
+StaticMemoryPlan PlanStaticMemory(absl::Span<const PlannedBuffer> buffers,
+                                  int64_t alignment) {
+  StaticMemoryPlan plan;
+  plan.offsets.resize(buffers.size(), 0);
+
+  // Place the largest buffers first, breaking ties by producer position so
+  // that the plan is deterministic.
+  std::vector<int> order(buffers.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&buffers](int a, int b) {
+    if (buffers[a].size != buffers[b].size) {
+      return buffers[a].size > buffers[b].size;
+    }
+    if (buffers[a].first_use != buffers[b].first_use) {
+      return buffers[a].first_use < buffers[b].first_use;
+    }
+    return a < b;
+  });
+
+  std::vector<int> placed;
+  std::vector<int> overlapping;
+  for (int index : order) {
+    const PlannedBuffer& buffer = buffers[index];
+    const int64_t size = RoundUp(buffer.size, alignment);
+    if (size == 0) continue;
+
+    overlapping.clear();
+    for (int other : placed) {
+      if (LifetimesOverlap(buffer, buffers[other])) {
+        overlapping.push_back(other);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [&plan](int a, int b) {
+      return plan.offsets[a] < plan.offsets[b];
+    });
+
+    // Find the smallest gap between live buffers that fits `buffer`, or place
+    // it after all of them.
+    int64_t best_offset = -1;
+    int64_t best_gap = std::numeric_limits<int64_t>::max();
+    int64_t current = 0;
+    for (int other : overlapping) {
+      const int64_t other_offset = plan.offsets[other];
+      if (other_offset >= current) {
+        const int64_t gap = other_offset - current;
+        if (gap >= size && gap < best_gap) {
+          best_gap = gap;
+          best_offset = current;
+        }
+      }
+      current = std::max(
+          current, other_offset + RoundUp(buffers[other].size, alignment));
+    }
+    if (best_offset < 0) best_offset = current;
+
+    plan.offsets[index] = best_offset;
+    plan.arena_size = std::max(plan.arena_size, best_offset + size);
+    placed.push_back(index);
+  }
+  return plan;
+}
+
+// The allocator for one buffer of the arena.
+class StaticMemoryArena::BufferAllocator : public Allocator {
+ public:
+  BufferAllocator(StaticMemoryArena* arena, int buffer)
+      : arena_(arena), buffer_(buffer) {}
+
+  std::string Name() override { return "static_memory_arena"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    return arena_->Allocate(buffer_, alignment, num_bytes,
+                            AllocationAttributes());
+  }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes,
+                    const AllocationAttributes& allocation_attr) override {
+    return arena_->Allocate(buffer_, alignment, num_bytes, allocation_attr);
+  }
+
+  void DeallocateRaw(void* ptr) override { arena_->Deallocate(buffer_, ptr); }
+
+  AllocatorMemoryType GetMemoryType() const override {
+    return arena_->allocator_->GetMemoryType();
+  }
+
+ private:
+  StaticMemoryArena* const arena_;  // Not owned.
+  const int buffer_;
+};
+
+StaticMemoryArena::StaticMemoryArena(Allocator* allocator,
+                                     absl::Span<const int> num_outputs,
+                                     const std::vector<BufferInfo>& buffers)
+    : allocator_(allocator),
+      buffers_(buffers),
+      buffer_states_(new BufferState[buffers.size()]),
+      node_output_allocators_(num_outputs.size()) {
+  buffer_allocators_.reserve(buffers_.size());
+  for (int i = 0; i < buffers_.size(); ++i) {
+    const BufferInfo& info = buffers_[i];
+    std::vector<Allocator*>& allocators = node_output_allocators_[info.node_id];
+    if (allocators.empty()) {
+      allocators.resize(num_outputs[info.node_id], nullptr);
+    }
+    buffer_allocators_.push_back(std::make_unique<BufferAllocator>(this, i));
+    allocators[info.output_index] = buffer_allocators_.back().get();
+  }
+}
+
+StaticMemoryArena::~StaticMemoryArena() {
+  char* base = base_.load();
+  if (base != nullptr) allocator_->DeallocateRaw(base);
+}
+
+StaticMemoryArena* StaticMemoryArena::CreateForGraph(const Graph& graph,
+                                                     const GraphView& gview,
+                                                     Allocator* allocator) {
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  std::vector<int> position(graph.num_node_ids(), -1);
+  for (int i = 0; i < order.size(); ++i) {
+    position[order[i]->id()] = i;
+  }
+
+  std::vector<int> num_outputs(gview.num_nodes(), 0);
+  std::vector<BufferInfo> buffers;
+  for (const Node* n : order) {
+    if (n->id() >= gview.num_nodes()) continue;
+    const NodeItem* item = gview.node(n->id());
+    if (item == nullptr || item->kernel == nullptr || item->is_noop ||
+        item->const_tensor != nullptr) {
+      continue;
+    }
+    num_outputs[item->node_id] = item->num_outputs;
+    for (int i = 0; i < item->num_outputs; ++i) {
+      const DataType dtype = item->output_type(i);
+      if (IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype) ||
+          item->output_attrs()[i].value != 0) {
+        continue;
+      }
+      int last_use = position[n->id()];
+      bool escapes = false;
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || e->src_output() != i) continue;
+        // Tensors returned from the step are expected to outlive it.
+        if (e->dst()->IsRetval() || e->dst()->IsSend()) {
+          escapes = true;
+          break;
+        }
+        last_use = std::max(last_use, position[e->dst()->id()]);
+      }
+      if (escapes) continue;
+      buffers.push_back({n->id(), i, position[n->id()], last_use});
+    }
+  }
+  if (buffers.empty()) return nullptr;
+  return new StaticMemoryArena(allocator, num_outputs, buffers);
+}
+
+bool StaticMemoryArena::TryAcquire(int buffer) {
+  BufferState& state = buffer_states_[buffer];
+  // The previous allocation of this buffer may still be alive, for example if
+  // the tensor was returned from an earlier step.
+  if (state.live.exchange(true)) return false;
+  for (int conflict : state.conflicts) {
+    // NOTE: Sequentially consistent accesses to `live` guarantee that at most
+    // one of two concurrently acquired conflicting buffers succeeds.
+    if (buffer_states_[conflict].live.load()) {
+      state.live.store(false);
+      return false;
+    }
+  }
+  return true;
+}
+
+void* StaticMemoryArena::Allocate(int buffer, size_t alignment,
+                                  size_t num_bytes,
+                                  const AllocationAttributes& allocation_attr) {
+  BufferState& state = buffer_states_[buffer];
+  const State arena_state = state_.load(std::memory_order_acquire);
+  if (arena_state == State::kPlanned && state.planned) {
+    if (num_bytes <= state.size &&
+        alignment <= Allocator::kAllocatorAlignment &&
+        TryAcquire(buffer)) {
+      Ref();
+      num_hits_.fetch_add(1, std::memory_order_relaxed);
+      return base_.load(std::memory_order_relaxed) + state.offset;
+    }
+    num_misses_.fetch_add(1, std::memory_order_relaxed);
+  } else if (arena_state == State::kRecording) {
+    const int64_t size = num_bytes;
+    state.num_allocations.fetch_add(1, std::memory_order_relaxed);
+    int64_t min_size = state.min_size.load(std::memory_order_relaxed);
+    while (size < min_size &&
+           !state.min_size.compare_exchange_weak(min_size, size)) {
+    }
+    int64_t max_size = state.max_size.load(std::memory_order_relaxed);
+    while (size > max_size &&
+           !state.max_size.compare_exchange_weak(max_size, size)) {
+    }
+    const int64_t bytes = recorded_bytes_.fetch_add(size) + size;
+    int64_t peak = recorded_peak_bytes_.load(std::memory_order_relaxed);
+    while (bytes > peak &&
+           !recorded_peak_bytes_.compare_exchange_weak(peak, bytes)) {
+    }
+  }
+  void* ptr = allocator_->AllocateRaw(alignment, num_bytes, allocation_attr);
+  if (ptr != nullptr) Ref();
+  return ptr;
+}
+
+void StaticMemoryArena::Deallocate(int buffer, void* ptr) {
+  char* base = base_.load(std::memory_order_acquire);
+  char* p = static_cast<char*>(ptr);
+  if (base != nullptr && p >= base && p < base + arena_bytes_) {
+    buffer_states_[buffer].live.store(false);
+  } else {
+    if (state_.load(std::memory_order_relaxed) == State::kRecording) {
+      // All recorded allocations of a buffer are assumed to have the same
+      // size; buffers for which this is not true are not planned.
+      recorded_bytes_.fetch_sub(
+          buffer_states_[buffer].max_size.load(std::memory_order_relaxed));
+    }
+    allocator_->DeallocateRaw(ptr);
+  }
+  Unref();
+}
+
+void StaticMemoryArena::StepDone() {
+  mutex_lock l(mu_);
+  if (state_.load(std::memory_order_relaxed) != State::kRecording) return;
+  if (++num_steps_done_ == kNumRecordingSteps) MakePlan();
+}
+
+void StaticMemoryArena::MakePlan() {
+  std::vector<int> planned;
+  std::vector<PlannedBuffer> planned_buffers;
+  for (int i = 0; i < buffers_.size(); ++i) {
+    const BufferState& state = buffer_states_[i];
+    const int64_t size = state.max_size.load();
+    if (state.num_allocations.load() != num_steps_done_ ||
+        state.min_size.load() != size || size == 0) {
+      continue;
+    }
+    planned.push_back(i);
+    planned_buffers.push_back(
+        {size, buffers_[i].first_use, buffers_[i].last_use});
+  }
+  if (absl::optional<AllocatorStats> stats = allocator_->GetStats()) {
+    allocator_peak_bytes_ = stats->peak_bytes_in_use;
+  }
+  if (planned.empty()) {
+    VLOG(1) << "No outputs with static sizes to plan in the static memory "
+               "arena.";
+    state_.store(State::kDisabled);
+    return;
+  }
+
+  const StaticMemoryPlan plan =
+      PlanStaticMemory(planned_buffers, Allocator::kAllocatorAlignment);
+  char* base = static_cast<char*>(
+      allocator_->AllocateRaw(Allocator::kAllocatorAlignment, plan.arena_size));
+  if (base == nullptr) {
+    LOG(WARNING) << "Failed to allocate a static memory arena of "
+                 << plan.arena_size << " bytes; using the allocator "
+                 << allocator_->Name() << " for all outputs.";
+    state_.store(State::kDisabled);
+    return;
+  }
+
+  for (int i = 0; i < planned.size(); ++i) {
+    BufferState& state = buffer_states_[planned[i]];
+    state.planned = true;
+    state.size = planned_buffers[i].size;
+    state.offset = plan.offsets[i];
+  }
+  // Find the planned buffers that share memory. These have disjoint
+  // lifetimes in the topological order, but not necessarily at run time.
+  std::vector<int> by_offset(planned.size());
+  std::iota(by_offset.begin(), by_offset.end(), 0);
+  std::sort(by_offset.begin(), by_offset.end(), [&plan](int a, int b) {
+    return plan.offsets[a] < plan.offsets[b];
+  });
+  for (int i = 0; i < by_offset.size(); ++i) {
+    const int a = by_offset[i];
+    const int64_t end = plan.offsets[a] + planned_buffers[a].size;
+    for (int j = i + 1;
+         j < by_offset.size() && plan.offsets[by_offset[j]] < end; ++j) {
+      const int b = by_offset[j];
+      buffer_states_[planned[a]].conflicts.push_back(planned[b]);
+      buffer_states_[planned[b]].conflicts.push_back(planned[a]);
+    }
+  }
+
+  num_planned_buffers_ = planned.size();
+  arena_bytes_ = plan.arena_size;
+  base_.store(base, std::memory_order_release);
+  state_.store(State::kPlanned, std::memory_order_release);
+  VLOG(1) << "Planned " << num_planned_buffers_ << " outputs in a static "
+          << "memory arena of " << arena_bytes_ << " bytes. Peak bytes "
+          << "allocated for these outputs while recording: "
+          << recorded_peak_bytes_.load() << ", peak bytes in use in "
+          << allocator_->Name() << ": " << allocator_peak_bytes_;
+}
+
+StaticMemoryArena::Report StaticMemoryArena::GetReport() const {
+  Report report;
+  if (state_.load(std::memory_order_acquire) == State::kPlanned) {
+    report.arena_bytes = arena_bytes_;
+  }
+  report.recorded_peak_bytes = recorded_peak_bytes_.load();
+  report.num_hits = num_hits_.load();
+  report.num_misses = num_misses_.load();
+  tf_shared_lock l(mu_);
+  report.num_planned_buffers = num_planned_buffers_;
+  report.allocator_peak_bytes = allocator_peak_bytes_;
+  return report;
+}
+
+std::string StaticMemoryArena::Report::DebugString() const {
+  return absl::StrCat(
+      "num_planned_buffers=", num_planned_buffers,
+      " arena_bytes=", arena_bytes,
+      " recorded_peak_bytes=", recorded_peak_bytes,
+      " allocator_peak_bytes=", allocator_peak_bytes, " num_hits=", num_hits,
+      " num_misses=", num_misses);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,199 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+class Graph;
+class GraphView;
+
+// A buffer whose placement is computed by `PlanStaticMemory()`. Lifetimes are
+// expressed as positions in a topological order of the graph: the buffer is
+// live from the node at position `first_use` (its producer) until the node at
+// position `last_use` (its last consumer), inclusive.
+struct PlannedBuffer {
+  int64_t size;
+  int first_use;
+  int last_use;
+};
+
+// The result of `PlanStaticMemory()`.
+struct StaticMemoryPlan {
+  // Offset of each buffer in the arena, in the order of the input buffers.
+  std::vector<int64_t> offsets;
+  // Total size of the arena in bytes.
+  int64_t arena_size = 0;
+};
+
+// Assigns an offset in a single arena to each of `buffers`, such that buffers
+// with overlapping lifetimes do not overlap in memory. Every offset is a
+// multiple of `alignment`.
+//
+// Buffers are placed in decreasing order of size, each in the smallest gap
+// left by the already placed buffers with overlapping lifetimes, similar to
+// the TFLite `ArenaPlanner`.
+StaticMemoryPlan PlanStaticMemory(absl::Span<const PlannedBuffer> buffers,
+                                  int64_t alignment);
+
+// Serves the outputs of the kernels of a graph from one preallocated arena,
+// using a static plan of buffer lifetimes, so that steps with static shapes
+// perform almost no calls to the device allocator.
+//
+// The arena starts out recording the sizes requested for each output through
+// `output_allocators()`, and forwards the allocations to the underlying
+// allocator. After `kNumRecordingSteps` steps, the outputs that were allocated
+// once per step with a constant size are planned with `PlanStaticMemory()`,
+// and later allocations of these outputs return a fixed offset in the arena.
+//
+// Since nodes may run in a different order than the topological order used
+// for planning, and kernels may forward buffers or retain them past their last
+// consumer, every planned allocation checks that no buffer sharing memory with
+// it is still alive, and falls back to the underlying allocator otherwise.
+// Each successful allocation holds a reference on the arena, so tensors that
+// outlive the executor remain valid.
+class StaticMemoryArena : public core::RefCounted {
+ public:
+  // Number of steps for which sizes are recorded before planning.
+  static constexpr int kNumRecordingSteps = 2;
+
+  // Describes an output that may be served from the arena.
+  struct BufferInfo {
+    int node_id;
+    int output_index;
+    // Lifetime, in positions of a topological order.
+    int first_use;
+    int last_use;
+  };
+
+  // Statistics about the arena.
+  struct Report {
+    // Number of outputs served from the arena.
+    int num_planned_buffers = 0;
+    // Size of the arena in bytes.
+    int64_t arena_bytes = 0;
+    // Peak number of bytes concurrently allocated for the planned outputs
+    // while recording, through the underlying allocator.
+    int64_t recorded_peak_bytes = 0;
+    // Peak bytes in use reported by the underlying allocator when the plan
+    // was made, or -1 if the allocator does not collect statistics.
+    int64_t allocator_peak_bytes = -1;
+    // Number of planned allocations served from the arena, and number that
+    // fell back to the underlying allocator.
+    int64_t num_hits = 0;
+    int64_t num_misses = 0;
+
+    std::string DebugString() const;
+  };
+
+  // `num_outputs[i]` is the number of outputs of node `i`, and `buffers` lists
+  // the outputs that may be served from the arena. Allocations not served from
+  // the arena use `allocator`, which must outlive the arena.
+  StaticMemoryArena(Allocator* allocator, absl::Span<const int> num_outputs,
+                    const std::vector<BufferInfo>& buffers);
+  ~StaticMemoryArena() override;
+
+  // Returns an arena for the outputs of the nodes of `graph` that produce
+  // plain-old-data tensors with default allocator attributes, or nullptr if
+  // there are no such outputs. `gview` must be the view of `graph` used by the
+  // executor.
+  static StaticMemoryArena* CreateForGraph(const Graph& graph,
+                                           const GraphView& gview,
+                                           Allocator* allocator);
+
+  // Returns an array indexed by output number of the allocators to use for
+  // the outputs of node `node_id`, with nullptr entries for outputs that are
+  // not served from the arena, or nullptr if none of its outputs are.
+  Allocator* const* output_allocators(int node_id) const {
+    return node_output_allocators_[node_id].empty()
+               ? nullptr
+               : node_output_allocators_[node_id].data();
+  }
+
+  // Must be called when a step that uses `output_allocators()` completes.
+  void StepDone();
+
+  Report GetReport() const;
+
+ private:
+  class BufferAllocator;
+
+  enum class State { kRecording, kPlanned, kDisabled };
+
+  struct BufferState {
+    // Set after planning.
+    bool planned = false;
+    int64_t size = 0;
+    int64_t offset = 0;
+    // Planned buffers that share memory with this one.
+    std::vector<int> conflicts;
+    // True while the memory of this buffer is handed out.
+    std::atomic<bool> live{false};
+
+    // Recorded while in `State::kRecording`.
+    std::atomic<int64_t> num_allocations{0};
+    std::atomic<int64_t> min_size{kint64max};
+    std::atomic<int64_t> max_size{0};
+  };
+
+  void* Allocate(int buffer, size_t alignment, size_t num_bytes,
+                 const AllocationAttributes& allocation_attr);
+  void Deallocate(int buffer, void* ptr);
+
+  // Marks `buffer` live if neither it nor a conflicting buffer is live.
+  bool TryAcquire(int buffer);
+
+  // Plans the buffers whose size was constant during the recording steps,
+  // and allocates the arena.
+  void MakePlan() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Allocator* const allocator_;
+  const std::vector<BufferInfo> buffers_;
+  std::unique_ptr<BufferState[]> buffer_states_;
+  std::vector<std::unique_ptr<BufferAllocator>> buffer_allocators_;
+  std::vector<std::vector<Allocator*>> node_output_allocators_;
+
+  std::atomic<State> state_{State::kRecording};
+  // Set before `state_` becomes `State::kPlanned`.
+  std::atomic<char*> base_{nullptr};
+  int64_t arena_bytes_ = 0;
+
+  // Bytes concurrently allocated for the buffers while recording.
+  std::atomic<int64_t> recorded_bytes_{0};
+  std::atomic<int64_t> recorded_peak_bytes_{0};
+  std::atomic<int64_t> num_hits_{0};
+  std::atomic<int64_t> num_misses_{0};
+
+  mutable mutex mu_;
+  int num_steps_done_ TF_GUARDED_BY(mu_) = 0;
+  int num_planned_buffers_ TF_GUARDED_BY(mu_) = 0;
+  int64_t allocator_peak_bytes_ TF_GUARDED_BY(mu_) = -1;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_MEMORY_PLAN_H_
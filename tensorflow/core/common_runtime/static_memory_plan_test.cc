@@ -0,0 +1,189 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_memory_plan.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(PlanStaticMemoryTest, DisjointLifetimesShareMemory) {
+  // a: [0, 1], b: [1, 2], c: [2, 3]. `a` and `c` can share memory.
+  std::vector<PlannedBuffer> buffers = {
+      {/*size=*/100, /*first_use=*/0, /*last_use=*/1},
+      {/*size=*/200, /*first_use=*/1, /*last_use=*/2},
+      {/*size=*/100, /*first_use=*/2, /*last_use=*/3},
+  };
+  StaticMemoryPlan plan = PlanStaticMemory(buffers, /*alignment=*/64);
+  ASSERT_EQ(plan.offsets.size(), 3);
+  EXPECT_EQ(plan.offsets[1], 0);
+  EXPECT_EQ(plan.offsets[0], 256);
+  EXPECT_EQ(plan.offsets[2], 256);
+  EXPECT_EQ(plan.arena_size, 384);
+}
+
+TEST(PlanStaticMemoryTest, FillsSmallestGap) {
+  std::vector<PlannedBuffer> buffers = {
+      {/*size=*/256, /*first_use=*/0, /*last_use=*/4},
+      {/*size=*/128, /*first_use=*/0, /*last_use=*/1},
+      {/*size=*/128, /*first_use=*/0, /*last_use=*/4},
+      // These fit in the gap left by buffer 1 between buffers 0 and 2.
+      {/*size=*/64, /*first_use=*/2, /*last_use=*/3},
+      {/*size=*/64, /*first_use=*/2, /*last_use=*/3},
+  };
+  StaticMemoryPlan plan = PlanStaticMemory(buffers, /*alignment=*/64);
+  EXPECT_EQ(plan.offsets[0], 0);
+  EXPECT_EQ(plan.offsets[1], 256);
+  EXPECT_EQ(plan.offsets[2], 384);
+  EXPECT_EQ(plan.offsets[3], 256);
+  EXPECT_EQ(plan.offsets[4], 320);
+  EXPECT_EQ(plan.arena_size, 512);
+}
+
+TEST(PlanStaticMemoryTest, OverlappingLifetimesDoNotShareMemory) {
+  std::vector<PlannedBuffer> buffers;
+  for (int i = 0; i < 10; ++i) {
+    buffers.push_back({/*size=*/10 * (i + 1), /*first_use=*/i,
+                       /*last_use=*/20});
+  }
+  StaticMemoryPlan plan = PlanStaticMemory(buffers, /*alignment=*/1);
+  EXPECT_EQ(plan.arena_size, 550);
+  for (int i = 0; i < buffers.size(); ++i) {
+    for (int j = i + 1; j < buffers.size(); ++j) {
+      const bool disjoint =
+          plan.offsets[i] + buffers[i].size <= plan.offsets[j] ||
+          plan.offsets[j] + buffers[j].size <= plan.offsets[i];
+      EXPECT_TRUE(disjoint) << i << " " << j;
+    }
+  }
+}
+
+class StaticMemoryArenaTest : public ::testing::Test {
+ protected:
+  static constexpr int kSize = 1024;
+
+  StaticMemoryArenaTest() {
+    // Three nodes with one output each, where the output of node 0 and the
+    // output of node 2 have disjoint lifetimes.
+    std::vector<int> num_outputs = {1, 1, 1};
+    std::vector<StaticMemoryArena::BufferInfo> buffers = {
+        {/*node_id=*/0, /*output_index=*/0, /*first_use=*/0, /*last_use=*/1},
+        {/*node_id=*/1, /*output_index=*/0, /*first_use=*/1, /*last_use=*/2},
+        {/*node_id=*/2, /*output_index=*/0, /*first_use=*/2, /*last_use=*/2},
+    };
+    arena_.reset(new StaticMemoryArena(cpu_allocator(), num_outputs, buffers));
+  }
+
+  Allocator* output_allocator(int node_id) {
+    return arena_->output_allocators(node_id)[0];
+  }
+
+  void* Allocate(int node_id) {
+    return output_allocator(node_id)->AllocateRaw(
+        Allocator::kAllocatorAlignment, kSize);
+  }
+
+  void Deallocate(int node_id, void* ptr) {
+    output_allocator(node_id)->DeallocateRaw(ptr);
+  }
+
+  // Runs one step in topological order.
+  void RunStep() {
+    void* a = Allocate(0);
+    void* b = Allocate(1);
+    Deallocate(0, a);
+    void* c = Allocate(2);
+    Deallocate(1, b);
+    Deallocate(2, c);
+    arena_->StepDone();
+  }
+
+  core::RefCountPtr<StaticMemoryArena> arena_;
+};
+
+TEST_F(StaticMemoryArenaTest, PlansAfterRecordingSteps) {
+  for (int i = 0; i < StaticMemoryArena::kNumRecordingSteps; ++i) {
+    EXPECT_EQ(arena_->GetReport().num_planned_buffers, 0);
+    RunStep();
+  }
+  StaticMemoryArena::Report report = arena_->GetReport();
+  EXPECT_EQ(report.num_planned_buffers, 3);
+  EXPECT_EQ(report.arena_bytes, 2 * kSize);
+  EXPECT_EQ(report.recorded_peak_bytes, 2 * kSize);
+
+  // In topological order, nodes 0 and 2 reuse the same memory.
+  void* a = Allocate(0);
+  void* b = Allocate(1);
+  Deallocate(0, a);
+  void* c = Allocate(2);
+  EXPECT_EQ(a, c);
+  EXPECT_NE(a, b);
+  Deallocate(1, b);
+  Deallocate(2, c);
+  report = arena_->GetReport();
+  EXPECT_EQ(report.num_hits, 3);
+  EXPECT_EQ(report.num_misses, 0);
+}
+
+TEST_F(StaticMemoryArenaTest, FallsBackWhenMemoryIsInUse) {
+  for (int i = 0; i < StaticMemoryArena::kNumRecordingSteps; ++i) {
+    RunStep();
+  }
+  // The output of node 0 is still alive when node 2 runs, so node 2 must not
+  // reuse its memory.
+  void* a = Allocate(0);
+  void* c = Allocate(2);
+  EXPECT_NE(a, c);
+  // The output of node 0 is allocated twice concurrently, for example by two
+  // concurrent steps.
+  void* a2 = Allocate(0);
+  EXPECT_NE(a, a2);
+  Deallocate(0, a2);
+  Deallocate(2, c);
+  Deallocate(0, a);
+  StaticMemoryArena::Report report = arena_->GetReport();
+  EXPECT_EQ(report.num_hits, 1);
+  EXPECT_EQ(report.num_misses, 2);
+}
+
+TEST_F(StaticMemoryArenaTest, DoesNotPlanDynamicSizes) {
+  for (int i = 0; i < StaticMemoryArena::kNumRecordingSteps; ++i) {
+    void* a = output_allocator(0)->AllocateRaw(Allocator::kAllocatorAlignment,
+                                               kSize * (i + 1));
+    Deallocate(0, a);
+    arena_->StepDone();
+  }
+  EXPECT_EQ(arena_->GetReport().num_planned_buffers, 0);
+}
+
+TEST_F(StaticMemoryArenaTest, OutlivesOwner) {
+  for (int i = 0; i < StaticMemoryArena::kNumRecordingSteps; ++i) {
+    RunStep();
+  }
+  Allocator* allocator = output_allocator(0);
+  void* a = Allocate(0);
+  // Tensors allocated from the arena keep it alive.
+  arena_.reset();
+  memset(a, 0, kSize);
+  allocator->DeallocateRaw(a);
+}
+
+}  // namespace
+}  // namespace tensorflow
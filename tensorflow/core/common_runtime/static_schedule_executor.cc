@@ -0,0 +1,560 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/entry.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/local_executor_params.h"
+#include "tensorflow/core/common_runtime/renamed_device.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace {
+
+static const string& kStaticScheduleExecutor =
+    *new string("STATIC_SCHEDULE");
+
+Status ValidateNodeForStaticSchedule(const Node& n) {
+  if (n.IsControlFlow()) {
+    return errors::Unimplemented(
+        "The static-schedule executor does not support control flow, but saw "
+        "node ",
+        n.name());
+  }
+  if (n.IsRecv()) {
+    return errors::Unimplemented(
+        "The static-schedule executor does not support receiving tensors "
+        "that may be dead, but saw node ",
+        n.name());
+  }
+  return OkStatus();
+}
+
+class StaticScheduleExecutorImpl : public Executor {
+ public:
+  explicit StaticScheduleExecutorImpl(const LocalExecutorParams& params)
+      : params_(params) {}
+
+  ~StaticScheduleExecutorImpl() override {
+    for (const KernelState& kernel_state : kernels_) {
+      params_.delete_kernel(kernel_state.kernel);
+    }
+    for (const ConstTensorKernelState& kernel_state : const_tensor_kernels_) {
+      params_.delete_kernel(kernel_state.kernel);
+    }
+  }
+
+  Status Initialize(const Graph& graph) {
+    if (params_.device->tensorflow_accelerator_device_info() != nullptr) {
+      return errors::Unimplemented(
+          "The static-schedule executor only supports CPU devices, but got ",
+          params_.device->name());
+    }
+    for (const Node* n : graph.op_nodes()) {
+      TF_RETURN_IF_ERROR(ValidateNodeForStaticSchedule(*n));
+    }
+
+    // The static schedule is a topological order of the graph. Since all
+    // kernels run on one thread, any topological order has the same latency.
+    std::vector<Node*> ordered_nodes;
+    ordered_nodes.reserve(graph.num_nodes());
+    GetReversePostOrder(graph, &ordered_nodes);
+    if (ordered_nodes.size() != graph.num_nodes()) {
+      return errors::InvalidArgument("Graph had ", graph.num_nodes(),
+                                     " but reverse post-order had ",
+                                     ordered_nodes.size());
+    }
+
+    std::vector<const Node*> nodes_with_kernels;
+    std::vector<const Node*> nodes_with_const_tensor_kernels;
+    std::map<int, const Node*> arg_index_to_node;
+    absl::flat_hash_map<const Node*, int> node_to_kernel_index;
+    int num_inputs = 0;
+    for (const Node* n : ordered_nodes) {
+      if (!n->IsOp()) continue;
+      if (n->IsArg()) {
+        int32_t arg_index;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->attrs(), "index", &arg_index));
+        if (arg_index < 0) {
+          return errors::InvalidArgument("Invalid argument index ", arg_index,
+                                         " in node ", n->name());
+        }
+        // Arguments are forwarded directly to the input slots of their
+        // consumers, without running a kernel.
+        arg_index_to_node[arg_index] = n;
+        continue;
+      }
+
+      OpKernel* kernel;
+      TF_RETURN_IF_ERROR(params_.create_kernel(n->properties(), &kernel));
+      const Tensor* const_tensor;
+      if (n->num_outputs() == 1 && (const_tensor = kernel->const_tensor())) {
+        // A kernel that produces a single constant tensor runs once, here,
+        // and its consumers receive a `const Tensor*` to the result.
+        const_tensor_kernels_.push_back({kernel, *const_tensor, {}});
+        nodes_with_const_tensor_kernels.push_back(n);
+        continue;
+      }
+      node_to_kernel_index[n] = kernels_.size();
+      nodes_with_kernels.push_back(n);
+      KernelState kernel_state;
+      kernel_state.kernel = kernel;
+      kernel_state.input_start = num_inputs;
+      kernel_state.num_inputs = n->num_inputs();
+      kernel_state.num_outputs = n->num_outputs();
+      kernels_.push_back(kernel_state);
+      num_inputs += n->num_inputs();
+    }
+    num_inputs_ = num_inputs;
+    input_expects_ref_.resize(num_inputs_);
+    input_alloc_attrs_.resize(num_inputs_);
+    for (int i = 0; i < kernels_.size(); ++i) {
+      const Node* n = nodes_with_kernels[i];
+      kernels_[i].allows_uninitialized_input =
+          n->op_def().allows_uninitialized_input();
+      for (int j = 0; j < n->num_inputs(); ++j) {
+        input_expects_ref_[kernels_[i].input_start + j] =
+            IsRefType(n->input_type(j));
+      }
+    }
+
+    // Returns the input slots of `n` that receive its output `output_index`.
+    auto destinations = [&](const Node* n, int output_index,
+                            std::vector<int>* slots) -> Status {
+      for (const Edge* e : n->out_edges()) {
+        if (e->IsControlEdge() || e->src_output() != output_index) continue;
+        auto it = node_to_kernel_index.find(e->dst());
+        if (it == node_to_kernel_index.end()) {
+          return errors::Internal("Node ", e->dst()->name(),
+                                  " consumes an output of ", n->name(),
+                                  " but has no kernel");
+        }
+        slots->push_back(kernels_[it->second].input_start + e->dst_input());
+      }
+      return OkStatus();
+    };
+
+    if (!arg_index_to_node.empty()) {
+      arg_destinations_.resize(arg_index_to_node.rbegin()->first + 1);
+      for (const auto& it : arg_index_to_node) {
+        TF_RETURN_IF_ERROR(
+            destinations(it.second, 0, &arg_destinations_[it.first]));
+      }
+    }
+
+    for (int i = 0; i < const_tensor_kernels_.size(); ++i) {
+      ConstTensorKernelState& kernel_state = const_tensor_kernels_[i];
+      TF_RETURN_IF_ERROR(destinations(nodes_with_const_tensor_kernels[i], 0,
+                                      &kernel_state.destinations));
+      AllocatorAttributes attr;
+      attr.set_on_host(kernel_state.kernel->output_memory_types()[0] ==
+                       HOST_MEMORY);
+      for (int slot : kernel_state.destinations) {
+        input_alloc_attrs_[slot] = attr;
+      }
+    }
+
+    // The destinations of all the outputs of all the kernels are stored in
+    // one flat array, so that forwarding outputs does not chase pointers.
+    std::vector<int> slots;
+    for (int i = 0; i < kernels_.size(); ++i) {
+      const Node* n = nodes_with_kernels[i];
+      KernelState& kernel_state = kernels_[i];
+      kernel_state.output_start = output_offsets_.size();
+      kernel_state.output_alloc_attrs_start = output_alloc_attrs_.size();
+      for (int j = 0; j < n->num_outputs(); ++j) {
+        output_offsets_.push_back(destinations_.size());
+        slots.clear();
+        TF_RETURN_IF_ERROR(destinations(n, j, &slots));
+        destinations_.insert(destinations_.end(), slots.begin(), slots.end());
+
+        AllocatorAttributes attr;
+        if (kernel_state.kernel->output_memory_types()[j] == HOST_MEMORY) {
+          attr.set_on_host(true);
+        }
+        output_alloc_attrs_.push_back(attr);
+        for (int slot : slots) {
+          input_alloc_attrs_[slot] = attr;
+        }
+      }
+    }
+    output_offsets_.push_back(destinations_.size());
+    return OkStatus();
+  }
+
+  Status Run(const Args& args) override {
+    std::unique_ptr<RunState> run_state = AcquireRunState();
+    Entry* const entries = run_state->entries.get();
+    TensorValue* const input_values = run_state->input_values.get();
+    // On success, every input slot is cleared once its consumer has run. On
+    // failure, the remaining slots are cleared before the state is reused.
+    bool completed = false;
+    auto release_run_state = gtl::MakeCleanup([&]() {
+      if (!completed) {
+        for (int i = 0; i < num_inputs_; ++i) entries[i].ClearVal();
+      }
+      ReleaseRunState(std::move(run_state));
+    });
+
+    // Override intra op thread pool if requested.
+    Device* device = params_.device;
+    std::unique_ptr<Device> user_device;
+    if (args.user_intra_op_threadpool != nullptr) {
+      user_device = RenamedDevice::NewRenamedDevice(
+          device->name(), device, /*owns_underlying=*/false,
+          /*isolate_session_state=*/false, args.user_intra_op_threadpool);
+      device = user_device.get();
+    }
+
+    // Prepare the parameters that are the same for all kernels.
+    OpKernelContext::Params params;
+    params.step_id = args.step_id;
+    params.device = device;
+    params.log_memory = false;
+    params.rendezvous = args.rendezvous;
+    params.session_state = args.session_state;
+    params.session_metadata = params_.session_metadata;
+    params.tensor_store = args.tensor_store;
+    params.cancellation_manager = args.cancellation_manager;
+    params.call_frame = args.call_frame;
+    params.function_library = params_.function_library;
+    params.resource_manager = device->resource_manager();
+    params.step_container = args.step_container;
+    params.collective_executor = args.collective_executor;
+    params.stack_trace = args.stack_trace;
+    params.slice_reader_cache = nullptr;
+    Args::Runner runner_copy = args.runner;
+    params.runner = &runner_copy;
+    params.run_all_kernels_inline = args.run_all_kernels_inline;
+    params.executor_type = &kStaticScheduleExecutor;
+    // The graph has no control flow, so all kernels run in the root frame and
+    // no input is ever dead.
+    params.frame_iter = FrameAndIter(0, 0);
+    params.is_input_dead = false;
+    // Outputs may be forwarded from any input with a reference count of one.
+    params.forward_from_array = nullptr;
+
+    device->TryGetDeviceContext(&params.op_device_context).IgnoreError();
+    auto context_cleanup = gtl::MakeCleanup([&params] {
+      if (params.op_device_context != nullptr) {
+        params.op_device_context->Unref();
+      }
+    });
+
+    const size_t num_args = args.call_frame ? args.call_frame->num_args() : 0;
+    if (TF_PREDICT_FALSE(arg_destinations_.size() > num_args)) {
+      return errors::InvalidArgument("Expected ", arg_destinations_.size(),
+                                     " arguments, but only received ",
+                                     num_args, ".");
+    }
+    for (int i = 0; i < arg_destinations_.size(); ++i) {
+      const std::vector<int>& slots = arg_destinations_[i];
+      if (slots.empty()) continue;
+      if (args.call_frame->CanConsumeArg(i)) {
+        // The first destination consumes the argument, and the others get a
+        // shallow copy of it.
+        Entry& first = entries[slots[0]];
+        first.state = Entry::State::HAS_VALUE;
+        first.val.Init();
+        args.call_frame->ConsumeArg(i, first.val.get());
+        for (int j = 1; j < slots.size(); ++j) {
+          Entry& entry = entries[slots[j]];
+          entry.state = Entry::State::HAS_VALUE;
+          entry.val.Init(*first.val);
+        }
+      } else {
+        // Each destination holds a shallow copy, which keeps the reference
+        // count of the argument above one and prevents forwarding its
+        // buffer.
+        const Tensor* arg;
+        TF_RETURN_IF_ERROR(args.call_frame->GetArg(i, &arg));
+        for (int slot : slots) {
+          Entry& entry = entries[slot];
+          entry.state = Entry::State::HAS_VALUE;
+          entry.val.Init(*arg);
+        }
+      }
+    }
+    for (const ConstTensorKernelState& kernel_state : const_tensor_kernels_) {
+      for (int slot : kernel_state.destinations) {
+        entries[slot].state = Entry::State::HAS_CONST_TENSOR;
+        entries[slot].const_tensor = &kernel_state.const_tensor;
+      }
+    }
+
+    for (const KernelState& kernel_state : kernels_) {
+      const int input_start = kernel_state.input_start;
+      for (int i = input_start; i < input_start + kernel_state.num_inputs;
+           ++i) {
+        TF_RETURN_IF_ERROR(
+            PrepareInput(kernel_state, i, &entries[i], &input_values[i]));
+      }
+      params.inputs = absl::MakeConstSpan(input_values + input_start,
+                                          kernel_state.num_inputs);
+      params.input_alloc_attrs = absl::MakeConstSpan(
+          input_alloc_attrs_.data() + input_start, kernel_state.num_inputs);
+      params.op_kernel = kernel_state.kernel;
+      params.output_attr_array =
+          output_alloc_attrs_.data() + kernel_state.output_alloc_attrs_start;
+      OpKernelContext ctx(&params, kernel_state.num_outputs);
+      device->Compute(kernel_state.kernel, &ctx);
+      TF_RETURN_IF_ERROR(ctx.status());
+
+      for (int i = input_start; i < input_start + kernel_state.num_inputs;
+           ++i) {
+        entries[i].ClearVal();
+      }
+      for (int j = 0; j < kernel_state.num_outputs; ++j) {
+        ForwardOutput(kernel_state, j, ctx.release_output(j), entries);
+      }
+    }
+    completed = true;
+    return OkStatus();
+  }
+
+  // Runs the kernels on a closure of `args.runner`, since callers may expect
+  // expensive work to be done on that thread.
+  void RunAsync(const Args& args, DoneCallback done) override {
+    args.runner([this, args, done]() { done(Run(args)); });
+  }
+
+ private:
+  struct KernelState {
+    // Managed by `params_.create_kernel()` and `params_.delete_kernel()`.
+    OpKernel* kernel;
+    // The inputs of the kernel are the slots
+    // [input_start, input_start + num_inputs).
+    int input_start;
+    int num_inputs;
+    int num_outputs;
+    // The destinations of output `j` are `destinations_[output_offsets_[
+    // output_start + j]]` up to `destinations_[output_offsets_[output_start +
+    // j + 1]]`.
+    int output_start;
+    // Index of the attributes of the first output in `output_alloc_attrs_`.
+    int output_alloc_attrs_start;
+    bool allows_uninitialized_input = false;
+  };
+
+  struct ConstTensorKernelState {
+    // Managed by `params_.create_kernel()` and `params_.delete_kernel()`.
+    OpKernel* kernel;
+    // A copy of `kernel->const_tensor()`, which keeps the reference count of
+    // the buffer above one, so that consumers cannot forward it.
+    Tensor const_tensor;
+    std::vector<int> destinations;
+  };
+
+  // The per-run storage for the input slots.
+  struct RunState {
+    explicit RunState(int num_inputs)
+        : entries(new Entry[num_inputs]),
+          input_values(new TensorValue[num_inputs]) {}
+
+    std::unique_ptr<Entry[]> entries;
+    std::unique_ptr<TensorValue[]> input_values;
+  };
+
+  std::unique_ptr<RunState> AcquireRunState() {
+    {
+      mutex_lock l(run_states_mu_);
+      if (!run_states_.empty()) {
+        std::unique_ptr<RunState> run_state = std::move(run_states_.back());
+        run_states_.pop_back();
+        return run_state;
+      }
+    }
+    return std::make_unique<RunState>(num_inputs_);
+  }
+
+  void ReleaseRunState(std::unique_ptr<RunState> run_state) {
+    mutex_lock l(run_states_mu_);
+    run_states_.push_back(std::move(run_state));
+  }
+
+  Status PrepareInput(const KernelState& kernel_state, int slot, Entry* entry,
+                      TensorValue* value) {
+    const bool expect_ref = input_expects_ref_[slot];
+    switch (entry->state) {
+      case Entry::State::HAS_VALUE:
+        if (TF_PREDICT_FALSE(expect_ref)) break;
+        *value = TensorValue(entry->val.get());
+        return OkStatus();
+      case Entry::State::HAS_CONST_TENSOR:
+        if (TF_PREDICT_FALSE(expect_ref)) break;
+        // NOTE: The `const_cast` is safe because the `OpKernelContext`
+        // accessors prevent using an immutable tensor as a mutable tensor.
+        *value = TensorValue(const_cast<Tensor*>(entry->const_tensor));
+        return OkStatus();
+      case Entry::State::HAS_REF_TENSOR: {
+        mutex* ref_mu = entry->ref_tensor.mu;
+        Tensor* ref_tensor = entry->ref_tensor.tensor;
+        tf_shared_lock l(*ref_mu);
+        if (TF_PREDICT_FALSE(!ref_tensor->IsInitialized() &&
+                             !kernel_state.allows_uninitialized_input)) {
+          return AttachDef(
+              errors::FailedPrecondition(
+                  "Attempting to use uninitialized value ",
+                  kernel_state.kernel->requested_input(
+                      slot - kernel_state.input_start)),
+              kernel_state.kernel->def());
+        }
+        if (expect_ref) {
+          *value = TensorValue(ref_mu, ref_tensor);
+        } else {
+          // Automatically dereference the tensor when the kernel expects a
+          // value.
+          entry->val.Init(*ref_tensor);
+          entry->state = Entry::State::HAS_VALUE;
+          *value = TensorValue(entry->val.get());
+        }
+        return OkStatus();
+      }
+      case Entry::State::NO_VALUE:
+        return errors::Internal("Input ", slot - kernel_state.input_start,
+                                " of ", kernel_state.kernel->name(),
+                                " has no value");
+    }
+    return AttachDef(errors::InvalidArgument(slot - kernel_state.input_start,
+                                             "-th input expects a ref type"),
+                     kernel_state.kernel->def());
+  }
+
+  void ForwardOutput(const KernelState& kernel_state, int output_index,
+                     TensorValue val, Entry* entries) {
+    const int* begin =
+        destinations_.data() +
+        output_offsets_[kernel_state.output_start + output_index];
+    const int* end =
+        destinations_.data() +
+        output_offsets_[kernel_state.output_start + output_index + 1];
+    if (val.is_ref()) {
+      for (const int* slot = begin; slot != end; ++slot) {
+        Entry& entry = entries[*slot];
+        entry.state = Entry::State::HAS_REF_TENSOR;
+        entry.ref_tensor.tensor = val.tensor;
+        entry.ref_tensor.mu = val.mutex_if_ref;
+      }
+      return;
+    }
+    if (begin != end) {
+      Tensor* const tensor = val.tensor;
+      for (const int* slot = begin; slot != end - 1; ++slot) {
+        Entry& entry = entries[*slot];
+        entry.state = Entry::State::HAS_VALUE;
+        if (tensor != nullptr) {
+          entry.val.Init(*tensor);
+        } else {
+          entry.val.Init(
+              Tensor(kernel_state.kernel->output_type(output_index)));
+        }
+      }
+      // The last consumer receives the tensor itself, which lets it forward
+      // the buffer when it is the only reference.
+      Entry& entry = entries[*(end - 1)];
+      entry.state = Entry::State::HAS_VALUE;
+      if (tensor != nullptr) {
+        entry.val.Init(std::move(*tensor));
+      } else {
+        entry.val.Init(Tensor(kernel_state.kernel->output_type(output_index)));
+      }
+    }
+    delete val.tensor;
+  }
+
+  const LocalExecutorParams params_;
+
+  // All following members are read-only after `Initialize()`.
+
+  // The kernels, in the order in which they run.
+  std::vector<KernelState> kernels_;
+  std::vector<ConstTensorKernelState> const_tensor_kernels_;
+  // For the `i`th argument, the input slots that receive it.
+  std::vector<std::vector<int>> arg_destinations_;
+
+  // Total number of input slots.
+  int num_inputs_ = 0;
+  // Indexed by input slot.
+  std::vector<bool> input_expects_ref_;
+  std::vector<AllocatorAttributes> input_alloc_attrs_;
+
+  // Destination slots of the outputs of all kernels. See `KernelState`.
+  std::vector<int> destinations_;
+  std::vector<int> output_offsets_;
+  // Attributes of the outputs of all kernels.
+  std::vector<AllocatorAttributes> output_alloc_attrs_;
+
+  // Run states that are not in use. There is usually at most one, unless the
+  // executor runs concurrently.
+  mutex run_states_mu_;
+  std::vector<std::unique_ptr<RunState>> run_states_
+      TF_GUARDED_BY(run_states_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StaticScheduleExecutorImpl);
+};
+
+class StaticScheduleExecutorRegistrar {
+ public:
+  StaticScheduleExecutorRegistrar() {
+    ExecutorFactory::Register(kStaticScheduleExecutor, new Factory());
+  }
+
+ private:
+  class Factory : public ExecutorFactory {
+    Status NewExecutor(const LocalExecutorParams& params, const Graph& graph,
+                       std::unique_ptr<Executor>* out_executor) override {
+      Executor* ret;
+      Status s = NewStaticScheduleExecutor(params, graph, &ret);
+      if (errors::IsUnimplemented(s)) {
+        VLOG(1) << "Falling back to the default executor: " << s;
+        TF_RETURN_IF_ERROR(NewLocalExecutor(params, graph, &ret));
+      } else {
+        TF_RETURN_IF_ERROR(s);
+      }
+      out_executor->reset(ret);
+      return OkStatus();
+    }
+  };
+};
+static StaticScheduleExecutorRegistrar registrar;
+
+}  // namespace
+
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph, Executor** executor) {
+  auto impl = std::make_unique<StaticScheduleExecutorImpl>(params);
+  TF_RETURN_IF_ERROR(impl->Initialize(graph));
+  *executor = impl.release();
+  return OkStatus();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,50 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
+
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+
+// Creates a new `Executor` that runs `graph` on the caller thread, following
+// an execution order computed once when the executor is created.
+//
+// The executor is intended for latency-sensitive graphs of a few hundred
+// small ops on the CPU. Compared to the default executor, it does not
+// maintain pending counts or a ready queue: kernels run from a flat array in
+// topological order, and their inputs are stored in slots that are allocated
+// once and reused across runs. Unlike `NewSingleThreadedExecutor()`, it
+// supports reference-typed edges, so it can run graphs that use
+// `VariableV2`.
+//
+// Returns an `Unimplemented` error if `graph` cannot be run with a static
+// schedule, i.e. if it contains control-flow nodes ("Switch", "Merge",
+// "Enter", "Exit", "NextIteration") or "_Recv" nodes, which may produce dead
+// tensors, or if the device is not a CPU device. The "STATIC_SCHEDULE"
+// executor type of `ExecutorFactory` falls back to `NewLocalExecutor()` for
+// such graphs.
+//
+// Like the single-threaded executor, the returned executor does not collect
+// step stats or log memory.
+Status NewStaticScheduleExecutor(const LocalExecutorParams& params,
+                                 const Graph& graph, Executor** executor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_STATIC_SCHEDULE_EXECUTOR_H_
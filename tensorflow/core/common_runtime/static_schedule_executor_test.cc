@@ -0,0 +1,303 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/static_schedule_executor.h"
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/executor_factory.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace {
+
+class StaticScheduleExecutorTest : public ::testing::Test {
+ protected:
+  StaticScheduleExecutorTest()
+      : device_(DeviceFactory::NewDevice("CPU", {},
+                                         "/job:localhost/replica:0/task:0")) {}
+
+  LocalExecutorParams Params(int version) {
+    LocalExecutorParams params;
+    params.device = device_.get();
+    params.create_kernel =
+        [this, version](const std::shared_ptr<const NodeProperties>& props,
+                        OpKernel** kernel) {
+          return CreateNonCachedKernel(device_.get(), nullptr, props, version,
+                                       kernel);
+        };
+    params.delete_kernel = [](OpKernel* kernel) {
+      DeleteNonCachedKernel(kernel);
+    };
+    return params;
+  }
+
+  // Resets exec_ with a new "STATIC_SCHEDULE" executor for `graph`.
+  void Create(std::unique_ptr<const Graph> graph) {
+    TF_CHECK_OK(NewExecutor("STATIC_SCHEDULE",
+                            Params(graph->versions().producer()), *graph,
+                            &exec_));
+  }
+
+  Status Run(CallFrameInterface* call_frame) {
+    Executor::Args args;
+    args.call_frame = call_frame;
+    args.runner = [](const std::function<void()>& fn) { fn(); };
+    return exec_->Run(args);
+  }
+
+  std::unique_ptr<Device> device_;
+  std::unique_ptr<Executor> exec_;
+};
+
+// A float val -> Tensor<float>
+Tensor V(const float val) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = val;
+  return tensor;
+}
+
+// Tensor<float> -> a float val.
+float V(const Tensor& tensor) {
+  CHECK_EQ(tensor.dtype(), DT_FLOAT);
+  CHECK(TensorShapeUtils::IsScalar(tensor.shape()));
+  return tensor.scalar<float>()();
+}
+
+TEST_F(StaticScheduleExecutorTest, SimpleAdd) {
+  // c = a + b
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in0 = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto in1 = test::graph::Arg(g.get(), 1, DT_FLOAT);
+  auto tmp = test::graph::Add(g.get(), in0, in1);
+  auto ret = test::graph::Retval(g.get(), 0, tmp);
+  g->AddControlEdge(in1, ret);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT, DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0), V(2.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(3.0, V(retvals[0]));  // out = 1.0 + 2.0 = 3.0
+
+  // Verify that the argument values are unchanged.
+  const Tensor* arg_0;
+  TF_ASSERT_OK(call_frame.GetArg(0, &arg_0));
+  EXPECT_EQ(1.0, V(*arg_0));
+  const Tensor* arg_1;
+  TF_ASSERT_OK(call_frame.GetArg(1, &arg_1));
+  EXPECT_EQ(2.0, V(*arg_1));
+}
+
+TEST_F(StaticScheduleExecutorTest, SelfAdd) {
+  // v0 <- a
+  // v1 = v0 + v0
+  // ... ...
+  // v10 = v9 + v9
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto v = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  const int N = 10;
+  for (int i = 1; i <= N; ++i) {
+    v = test::graph::Add(g.get(), v, v);
+  }
+  test::graph::Retval(g.get(), 0, v);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(1024.0, V(retvals[0]));
+}
+
+// Builds a graph which adds N copies of the argument, parenthesized randomly.
+void BuildTree(int N, Graph* g) {
+  CHECK_GT(N, 1);
+  auto in = test::graph::Arg(g, 0, DT_FLOAT);
+  std::vector<Node*> nodes;
+  for (int i = 0; i < N; ++i) {
+    nodes.push_back(test::graph::Identity(g, in, 0));
+  }
+  random::PhiloxRandom philox(0, 17);
+  random::SimplePhilox rnd(&philox);
+  while (nodes.size() > 1) {
+    int x = rnd.Uniform(nodes.size());
+    auto in0 = nodes[x];
+    nodes[x] = nodes.back();
+    nodes.resize(nodes.size() - 1);
+    x = rnd.Uniform(nodes.size());
+    auto in1 = nodes[x];
+    nodes[x] = test::graph::Add(g, in0, in1);
+  }
+  test::graph::Retval(g, 0, nodes.back());
+  FixupSourceAndSinkEdges(g);
+}
+
+TEST_F(StaticScheduleExecutorTest, RandomTree) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(4096.0, V(retvals[0]));
+}
+
+TEST_F(StaticScheduleExecutorTest, ReusesRunStateAfterError) {
+  // out = CheckNumerics(1 / a) * 2, which fails when a = 0.
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  auto inv = test::graph::Unary(g.get(), "Reciprocal", in);
+  auto check = test::graph::CheckNumerics(g.get(), inv, "message");
+  auto two = test::graph::Constant(g.get(), V(2.0));
+  auto mul = test::graph::Binary(g.get(), "Mul", check, two);
+  test::graph::Retval(g.get(), 0, mul);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  for (int i = 0; i < 3; ++i) {
+    FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame.SetArgs({V(0.0)}));
+    EXPECT_TRUE(errors::IsInvalidArgument(Run(&call_frame)));
+
+    FunctionCallFrame call_frame_2({DT_FLOAT}, {DT_FLOAT});
+    TF_ASSERT_OK(call_frame_2.SetArgs({V(4.0)}));
+    TF_ASSERT_OK(Run(&call_frame_2));
+    std::vector<Tensor> retvals;
+    TF_ASSERT_OK(call_frame_2.ConsumeRetvals(&retvals, false));
+    EXPECT_EQ(0.5, V(retvals[0]));
+  }
+}
+
+TEST_F(StaticScheduleExecutorTest, RefVariable) {
+  // var = 3
+  // out = var + var
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({}));
+  auto three = test::graph::Constant(g.get(), V(3.0));
+  auto assign = test::graph::Assign(g.get(), var, three);
+  auto add = test::graph::Add(g.get(), assign, assign);
+  test::graph::Retval(g.get(), 0, add);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({}, {DT_FLOAT});
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(6.0, V(retvals[0]));
+}
+
+TEST_F(StaticScheduleExecutorTest, UninitializedRefVariable) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto var = test::graph::Var(g.get(), DT_FLOAT, TensorShape({}));
+  auto add = test::graph::Add(g.get(), var, var);
+  test::graph::Retval(g.get(), 0, add);
+  FixupSourceAndSinkEdges(g.get());
+  Create(std::move(g));
+  FunctionCallFrame call_frame({}, {DT_FLOAT});
+  Status s = Run(&call_frame);
+  EXPECT_TRUE(errors::IsFailedPrecondition(s)) << s;
+}
+
+TEST_F(StaticScheduleExecutorTest, FallsBackForControlFlow) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  auto in = test::graph::Arg(g.get(), 0, DT_FLOAT);
+  Tensor pred(DT_BOOL, TensorShape({}));
+  pred.scalar<bool>()() = true;
+  test::graph::Switch(g.get(), in, test::graph::Constant(g.get(), pred));
+  test::graph::Retval(g.get(), 0, test::graph::Identity(g.get(), in));
+  FixupSourceAndSinkEdges(g.get());
+
+  Executor* exec;
+  EXPECT_TRUE(errors::IsUnimplemented(NewStaticScheduleExecutor(
+      Params(g->versions().producer()), *g, &exec)));
+
+  // The registered factory falls back to the default executor.
+  Create(std::move(g));
+  FunctionCallFrame call_frame({DT_FLOAT}, {DT_FLOAT});
+  TF_ASSERT_OK(call_frame.SetArgs({V(1.0)}));
+  TF_ASSERT_OK(Run(&call_frame));
+  std::vector<Tensor> retvals;
+  TF_ASSERT_OK(call_frame.ConsumeRetvals(&retvals, false));
+  EXPECT_EQ(1.0, V(retvals[0]));
+}
+
+void BM_const_identity(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int outputs_per_const = state.range(1);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  for (int i = 0; i < width; ++i) {
+    Tensor i_t(i);
+    Node* const_node = test::graph::Constant(g, i_t);
+    for (int j = 0; j < outputs_per_const; ++j) {
+      test::graph::Identity(g, const_node);
+    }
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, "STATIC_SCHEDULE",
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetLabel(strings::StrCat("Nodes = ", (1 + outputs_per_const) * width));
+  state.SetItemsProcessed((1 + outputs_per_const) * width *
+                          static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_const_identity)->UseRealTime()->ArgPair(1, 1);
+BENCHMARK(BM_const_identity)->UseRealTime()->ArgPair(1, 100);
+BENCHMARK(BM_const_identity)->UseRealTime()->ArgPair(100, 1);
+BENCHMARK(BM_const_identity)->UseRealTime()->ArgPair(100, 100);
+
+void BM_add_chain(::testing::benchmark::State& state) {
+  const int depth = state.range(0);
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* v = test::graph::Constant(g, V(1.0));
+  for (int i = 0; i < depth; ++i) {
+    v = test::graph::Add(g, v, v);
+  }
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, nullptr, nullptr, nullptr, "STATIC_SCHEDULE",
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(depth * static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_add_chain)->UseRealTime()->Arg(10)->Arg(100)->Arg(1000);
+
+}  // namespace
+}  // namespace tensorflow
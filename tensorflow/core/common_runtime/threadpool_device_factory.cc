@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -38,6 +39,16 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<std::unique_ptr<Device>>* devices) override {
     int num_numa_nodes = port::NUMANumNodes();
+    if (options.config.experimental().use_numa_affinity() &&
+        port::NUMAEnabled()) {
+      // Allocate the memory of each device on its NUMA node.
+      ProcessState::singleton()->EnableNUMA();
+    }
+    // An optional network location of this host, such as "/zone1/rack3",
+    // used to order the tasks of collective rings.
+    string network_location;
+    TF_RETURN_IF_ERROR(ReadStringFromEnvVar("TF_NETWORK_LOCATION", "",
+                                            &network_location));
     int n = 1;
     auto iter = options.config.device_count().find("CPU");
     if (iter != options.config.device_count().end()) {
@@ -46,6 +57,8 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
     for (int i = 0; i < n; i++) {
       string name = strings::StrCat(name_prefix, "/device:CPU:", i);
       std::unique_ptr<ThreadPoolDevice> tpd;
+      DeviceLocality dev_locality;
+      dev_locality.set_network_location(network_location);
       if (options.config.experimental().use_numa_affinity()) {
         int numa_node = i % num_numa_nodes;
         if (numa_node != i) {
@@ -54,14 +67,13 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
                     << " assigning device " << name << " to NUMA node "
                     << numa_node;
         }
-        DeviceLocality dev_locality;
         dev_locality.set_numa_node(numa_node);
         tpd = std::make_unique<ThreadPoolDevice>(
             options, name, Bytes(256 << 20), dev_locality,
             ProcessState::singleton()->GetCPUAllocator(numa_node));
       } else {
         tpd = std::make_unique<ThreadPoolDevice>(
-            options, name, Bytes(256 << 20), DeviceLocality(),
+            options, name, Bytes(256 << 20), dev_locality,
             ProcessState::singleton()->GetCPUAllocator(port::kNUMANoAffinity));
       }
       devices->push_back(std::move(tpd));
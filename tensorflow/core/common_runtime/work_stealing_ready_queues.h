@@ -0,0 +1,183 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A fixed set of double-ended queues of ready nodes, one per executor worker,
+// used by the work-stealing executor.
+//
+// A worker pushes the nodes that became ready after running one of its nodes
+// onto the back of its own queue, and pops from the back of that queue, so
+// recently produced successors (whose inputs are likely still in cache) are
+// run by the thread that produced them. A worker whose queue is empty steals
+// from the front of the other queues.
+//
+// The class also keeps track of the number of active workers, so that the
+// executor can start new workers when work becomes available, and retire them
+// when there is no more work, without losing nodes in between. The protocol
+// is:
+//
+// * After pushing work, the producer calls `TryStartWorker()`, and starts a
+//   new worker if it returns true.
+// * When a worker finds no work, it calls `RetireWorker()` and exits iff the
+//   call returns true. Otherwise it must continue looking for work.
+//
+// `T` must be copyable. All methods are thread-safe.
+template <typename T>
+class WorkStealingReadyQueues {
+ public:
+  // Creates `num_queues` empty queues and allows at most `max_workers`
+  // concurrently active workers.
+  WorkStealingReadyQueues(int num_queues, int max_workers)
+      : num_queues_(std::max(num_queues, 1)),
+        max_workers_(std::max(max_workers, 1)),
+        queues_(new Queue[num_queues_]) {}
+
+  int num_queues() const { return num_queues_; }
+  int max_workers() const { return max_workers_; }
+
+  // Returns the number of workers that are currently active.
+  int num_active_workers() const {
+    return num_active_workers_.load(std::memory_order_relaxed);
+  }
+
+  // Returns a queue identifier for a new worker, or for nodes produced by a
+  // thread that is not a worker. Identifiers are assigned round-robin.
+  int NextQueueId() {
+    return next_queue_id_.fetch_add(1, std::memory_order_relaxed) %
+           num_queues_;
+  }
+
+  // Appends `node` to the back of the queue `queue_id`.
+  void PushBack(int queue_id, const T& node) {
+    Queue& queue = queues_[queue_id];
+    mutex_lock l(queue.mu);
+    queue.nodes.push_back(node);
+    queue.size.fetch_add(1);
+  }
+
+  // Appends the nodes in [begin, end) to the back of the queue `queue_id`.
+  template <typename Iterator>
+  void PushBack(int queue_id, Iterator begin, Iterator end) {
+    Queue& queue = queues_[queue_id];
+    mutex_lock l(queue.mu);
+    const size_t old_size = queue.nodes.size();
+    queue.nodes.insert(queue.nodes.end(), begin, end);
+    queue.size.fetch_add(queue.nodes.size() - old_size);
+  }
+
+  // Removes and returns the most recently pushed node from the queue
+  // `queue_id`. Returns `absl::nullopt` if that queue is empty.
+  absl::optional<T> PopBack(int queue_id) {
+    Queue& queue = queues_[queue_id];
+    if (queue.size.load(std::memory_order_relaxed) == 0) return absl::nullopt;
+    mutex_lock l(queue.mu);
+    if (queue.nodes.empty()) return absl::nullopt;
+    absl::optional<T> node(queue.nodes.back());
+    queue.nodes.pop_back();
+    queue.size.fetch_sub(1);
+    return node;
+  }
+
+  // Removes and returns the least recently pushed node from one of the queues
+  // other than `thief_id`. Queues are visited starting after `thief_id`, so
+  // that concurrent thieves spread out across victims. Returns `absl::nullopt`
+  // if all other queues are empty.
+  absl::optional<T> Steal(int thief_id) {
+    for (int i = 1; i < num_queues_; ++i) {
+      Queue& queue = queues_[(thief_id + i) % num_queues_];
+      if (queue.size.load(std::memory_order_relaxed) == 0) continue;
+      mutex_lock l(queue.mu);
+      if (queue.nodes.empty()) continue;
+      absl::optional<T> node(queue.nodes.front());
+      queue.nodes.pop_front();
+      queue.size.fetch_sub(1);
+      return node;
+    }
+    return absl::nullopt;
+  }
+
+  // Returns true if all queues are empty.
+  bool Empty() const {
+    for (int i = 0; i < num_queues_; ++i) {
+      if (queues_[i].size.load() != 0) return false;
+    }
+    return true;
+  }
+
+  // Registers a new active worker if fewer than `max_workers()` workers are
+  // active. Returns true if the caller must start a new worker.
+  bool TryStartWorker() {
+    int num_active = num_active_workers_.load();
+    while (num_active < max_workers_) {
+      if (num_active_workers_.compare_exchange_weak(num_active,
+                                                    num_active + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Unregisters an active worker that has found all the queues empty. Returns
+  // true if the worker may exit. Returns false if work was pushed
+  // concurrently, in which case the worker has been re-registered and must
+  // continue.
+  //
+  // NOTE: The sequentially consistent accesses to `num_active_workers_` and
+  // the queue sizes guarantee that either this method observes a concurrent
+  // push, or the pushing thread observes the decremented number of active
+  // workers in `TryStartWorker()`.
+  bool RetireWorker() {
+    num_active_workers_.fetch_sub(1);
+    if (Empty()) return true;
+    return !TryStartWorker();
+  }
+
+ private:
+  // Aligned to avoid false sharing between the queues of different workers.
+  struct alignas(64) Queue {
+    mutex mu;
+    std::deque<T> nodes TF_GUARDED_BY(mu);
+    // Mirrors `nodes.size()`, so idle workers can skip empty queues without
+    // acquiring `mu`.
+    std::atomic<int64_t> size{0};
+  };
+
+  const int num_queues_;
+  const int max_workers_;
+  std::unique_ptr<Queue[]> queues_;
+  std::atomic<int> num_active_workers_{0};
+  std::atomic<uint32> next_queue_id_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingReadyQueues);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_WORK_STEALING_READY_QUEUES_H_
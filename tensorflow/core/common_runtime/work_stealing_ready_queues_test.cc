@@ -0,0 +1,131 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_ready_queues.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingReadyQueues, OwnerPopsInLifoOrder) {
+  WorkStealingReadyQueues<int> queues(/*num_queues=*/2, /*max_workers=*/2);
+  std::vector<int> nodes = {1, 2, 3};
+  queues.PushBack(0, nodes.begin(), nodes.end());
+  queues.PushBack(0, 4);
+  EXPECT_FALSE(queues.Empty());
+  EXPECT_FALSE(queues.PopBack(1).has_value());
+
+  EXPECT_EQ(*queues.PopBack(0), 4);
+  EXPECT_EQ(*queues.PopBack(0), 3);
+  EXPECT_EQ(*queues.PopBack(0), 2);
+  EXPECT_EQ(*queues.PopBack(0), 1);
+  EXPECT_FALSE(queues.PopBack(0).has_value());
+  EXPECT_TRUE(queues.Empty());
+}
+
+TEST(WorkStealingReadyQueues, ThiefStealsInFifoOrder) {
+  WorkStealingReadyQueues<int> queues(/*num_queues=*/3, /*max_workers=*/3);
+  queues.PushBack(2, 1);
+  queues.PushBack(2, 2);
+
+  // A worker never steals from its own queue.
+  EXPECT_FALSE(queues.Steal(2).has_value());
+  EXPECT_EQ(*queues.Steal(0), 1);
+  EXPECT_EQ(*queues.Steal(1), 2);
+  EXPECT_FALSE(queues.Steal(0).has_value());
+  EXPECT_TRUE(queues.Empty());
+}
+
+TEST(WorkStealingReadyQueues, WorkerAccounting) {
+  WorkStealingReadyQueues<int> queues(/*num_queues=*/2, /*max_workers=*/2);
+  EXPECT_TRUE(queues.TryStartWorker());
+  EXPECT_TRUE(queues.TryStartWorker());
+  EXPECT_FALSE(queues.TryStartWorker());
+  EXPECT_EQ(queues.num_active_workers(), 2);
+
+  // With no pending work, a worker may retire.
+  EXPECT_TRUE(queues.RetireWorker());
+  EXPECT_EQ(queues.num_active_workers(), 1);
+
+  // With pending work, the retiring worker is re-registered.
+  queues.PushBack(0, 1);
+  EXPECT_FALSE(queues.RetireWorker());
+  EXPECT_EQ(queues.num_active_workers(), 1);
+  EXPECT_EQ(*queues.PopBack(0), 1);
+  EXPECT_TRUE(queues.RetireWorker());
+  EXPECT_EQ(queues.num_active_workers(), 0);
+}
+
+// Runs a tree of tasks, where each task produces two children until a given
+// depth is reached, on workers that follow the protocol used by the executor.
+// Checks that every task runs exactly once.
+TEST(WorkStealingReadyQueues, ConcurrentTree) {
+  constexpr int kNumThreads = 8;
+  constexpr int kDepth = 14;
+  constexpr int kNumTasks = (1 << (kDepth + 1)) - 1;
+
+  WorkStealingReadyQueues<int> queues(kNumThreads, kNumThreads);
+  std::vector<std::atomic<int>> runs(kNumTasks);
+  std::atomic<int> num_completed{0};
+  BlockingCounter all_done(kNumTasks);
+  {
+    // Destroying the pool waits for the workers that are still retiring.
+    thread::ThreadPool pool(Env::Default(), "test", kNumThreads);
+    std::function<void()> start_workers;
+    auto run_worker = [&](int queue_id) {
+      do {
+        absl::optional<int> task;
+        while ((task = queues.PopBack(queue_id)) ||
+               (task = queues.Steal(queue_id))) {
+          runs[*task].fetch_add(1);
+          const int first_child = 2 * *task + 1;
+          if (first_child < kNumTasks) {
+            queues.PushBack(queue_id, first_child);
+            queues.PushBack(queue_id, first_child + 1);
+            start_workers();
+          }
+          num_completed.fetch_add(1);
+          all_done.DecrementCount();
+        }
+      } while (!queues.RetireWorker());
+    };
+    start_workers = [&]() {
+      for (int i = 0; i < 2 && queues.TryStartWorker(); ++i) {
+        const int queue_id = queues.NextQueueId();
+        pool.Schedule([&run_worker, queue_id]() { run_worker(queue_id); });
+      }
+    };
+
+    queues.PushBack(0, 0);
+    start_workers();
+    all_done.Wait();
+  }
+
+  EXPECT_EQ(num_completed.load(), kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    EXPECT_EQ(runs[i].load(), 1) << "task " << i;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -75,6 +75,7 @@ constexpr char kShuffleAndRepeatFusionOpt[] = "shuffle_and_repeat_fusion";
 constexpr char kFilterFusionOpt[] = "filter_fusion";
 constexpr char kMapAndFilterFusionOpt[] = "map_and_filter_fusion";
 constexpr char kMapFusionOpt[] = "map_fusion";
+constexpr char kMapVectorizationOpt[] = "map_vectorization";
 constexpr char kParallelBatchOpt[] = "parallel_batch";
 constexpr char kAutotuneBufferSizesOpt[] = "autotune_buffer_sizes";
 constexpr char kDisablePrefetchLegacyAutotuneOpt[] =
@@ -89,6 +90,9 @@ constexpr char kSlackOpt[] = "slack";
 constexpr char kSlackPeriodOpt[] = "slack_period";
 constexpr char kMakeDeterministicOpt[] = "make_deterministic";
 constexpr char kFilterParallelizationOpt[] = "filter_parallelization";
+constexpr char kChooseFastestOptimizationsOpt[] =
+    "choose_fastest_optimizations";
+constexpr char kTFDataMetaOptimizer[] = "tf_data_meta_optimizer";
 
 void DefaultOptimizationGraphRewrites(
     const Options& options, absl::flat_hash_set<tstring>* optimization_enabled,
@@ -170,6 +174,14 @@ void DefaultOptimizationGraphRewrites(
       optimization_disabled->insert(kMapFusionOpt);
     }
   }
+  if (optimization_options.optional_map_vectorization_case() ==
+      OptimizationOptions::kMapVectorization) {
+    if (optimization_options.map_vectorization()) {
+      optimization_enabled->insert(kMapVectorizationOpt);
+    } else {
+      optimization_disabled->insert(kMapVectorizationOpt);
+    }
+  }
   if (optimization_options.optional_noop_elimination_case() ==
       OptimizationOptions::kNoopElimination) {
     if (optimization_options.noop_elimination()) {
@@ -561,6 +573,16 @@ void GetOptimizations(const Options& options,
       optimizations_disabled->insert(kSlackOpt);
     }
   }
+  if (ShouldUseSymbolicCheckpoint(options)) {
+    // These rewrites replace checkpoint-compatible datasets with ones that
+    // do not support symbolic checkpoints, so they are only applied when
+    // requested explicitly.
+    for (const char* optimization :
+         {kMapAndBatchFusionOpt, kMapParallelizationOpt,
+          kShuffleAndRepeatFusionOpt, kMapVectorizationOpt}) {
+      optimizations_default->erase(optimization);
+    }
+  }
 }
 
 Tensor MaybeCopySubSlice(const Tensor& tensor, int64 index) {
@@ -855,6 +877,10 @@ absl::flat_hash_set<tstring> CreateGraphRewriteConfigs(const Options& options) {
     configs.insert(
         absl::StrCat(kSlackOpt, ":", kSlackPeriodOpt, ":", num_devices));
   }
+  if (GetExperiments().contains(kChooseFastestOptimizationsOpt)) {
+    configs.insert(absl::StrCat(kTFDataMetaOptimizer, ":",
+                                kChooseFastestOptimizationsOpt, ":true"));
+  }
   return configs;
 }
 
@@ -874,6 +900,12 @@ bool ShouldUseAutotuning(const Options& options) {
          options.autotune_options().enabled();
 }
 
+bool ShouldUseSymbolicCheckpoint(const Options& options) {
+  return options.optional_symbolic_checkpoint_case() ==
+             Options::kSymbolicCheckpoint &&
+         options.symbolic_checkpoint();
+}
+
 bool ShouldApplyOptimizations(
     const Options& options,
     const absl::flat_hash_set<tstring>& optimizations_enabled,
@@ -906,11 +938,14 @@ namespace {
 
 REGISTER_DATASET_EXPERIMENT("allow_small_function_optimizations", 0);
 REGISTER_DATASET_EXPERIMENT("autotune_buffer_optimization", 0);
+REGISTER_DATASET_EXPERIMENT(kChooseFastestOptimizationsOpt, 0);
 REGISTER_DATASET_EXPERIMENT(kFilterParallelizationOpt, 0);
 REGISTER_DATASET_EXPERIMENT("inject_prefetch", 100);
 REGISTER_DATASET_EXPERIMENT("min_outer_interleave_parallelism", 0);
+REGISTER_DATASET_EXPERIMENT("numa_shared_threadpool", 0);
 REGISTER_DATASET_EXPERIMENT("reduce_interleave_prefetch", 0);
 REGISTER_DATASET_EXPERIMENT("serialize_input_cycle_length", 0);
+REGISTER_DATASET_EXPERIMENT("shared_threadpool", 0);
 REGISTER_DATASET_EXPERIMENT("stage_based_autotune", 0);
 }  // namespace
 }  // namespace data
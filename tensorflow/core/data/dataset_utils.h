@@ -345,6 +345,10 @@ bool ShouldUsePrivateThreadPool(const Options& options);
 // Determines whether autotuning should be used.
 bool ShouldUseAutotuning(const Options& options);
 
+// Determines whether iterators should be checkpointed symbolically. See
+// `IteratorContext::symbolic_checkpoint()`.
+bool ShouldUseSymbolicCheckpoint(const Options& options);
+
 // Determines whether optimizations should be applied.
 bool ShouldApplyOptimizations(
     const Options& options,
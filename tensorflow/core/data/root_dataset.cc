@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
 #include "tensorflow/core/data/rewrite_utils.h"
+#include "tensorflow/core/data/shared_thread_pool.h"
 #include "tensorflow/core/framework/model.pb.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/host_info.h"
@@ -44,14 +45,38 @@ constexpr char kMemBandwidth[] = "mem_bw_used_megabytes_per_sec";
 constexpr char kPrivateThreadpoolSize[] = "threadpool_size";
 constexpr char kRamBudget[] = "ram_budget_megabytes";
 constexpr char kRamUsage[] = "ram_usage_megabytes";
+constexpr char kSharedThreadpool[] = "shared_threadpool";
 constexpr char kMaxBufferBytes[] = "max_buffered_megabytes";
+constexpr char kSymbolicCheckpoint[] = "symbolic_checkpoint";
 
 // If value `x` matches `y`, returns default value `z`. Otherwise, return `x`.
 inline int64_t value_or_default(int64_t x, int64_t y, int64_t z) {
   return x == y ? z : x;
 }
 
-void SetRootDatasetParams(const Options& options, RootDataset::Params* params) {
+// Returns the first dataset of the pipeline rooted at `dataset` that does not
+// support symbolic checkpoints, or nullptr if all of them do.
+const DatasetBase* FindSymbolicCheckpointIncompatible(
+    const DatasetBase* dataset) {
+  if (!dataset->SymbolicCheckpointCompatible()) {
+    return dataset;
+  }
+  std::vector<const DatasetBase*> inputs;
+  if (!dataset->InputDatasets(&inputs).ok()) {
+    return dataset;
+  }
+  for (const DatasetBase* input : inputs) {
+    const DatasetBase* incompatible = FindSymbolicCheckpointIncompatible(input);
+    if (incompatible != nullptr) {
+      return incompatible;
+    }
+  }
+  return nullptr;
+}
+
+void SetRootDatasetParams(const DatasetBase* input,
+                          RootDataset::Params* params) {
+  const Options& options = input->options();
   if (ShouldConfigureMaxIntraOpParallelism(options)) {
     params->max_intra_op_parallelism =
         options.threading_options().max_intra_op_parallelism();
@@ -59,6 +84,8 @@ void SetRootDatasetParams(const Options& options, RootDataset::Params* params) {
   if (ShouldUsePrivateThreadPool(options)) {
     params->private_threadpool_size =
         options.threading_options().private_threadpool_size();
+  } else if (GetExperiments().contains(kSharedThreadpool)) {
+    params->shared_threadpool = true;
   }
   params->autotune = ShouldUseAutotuning(options);
   if (params->autotune) {
@@ -71,12 +98,27 @@ void SetRootDatasetParams(const Options& options, RootDataset::Params* params) {
       params->autotune_algorithm =
           options.autotune_options().autotune_algorithm();
     }
+    // With a shared thread pool, the parallelism is bounded by the size of
+    // the pool rather than by the number of cores.
     params->autotune_cpu_budget = value_or_default(
-        options.autotune_options().cpu_budget(), 0, GetCpuBudget());
+        options.autotune_options().cpu_budget(), 0,
+        params->shared_threadpool ? SharedThreadPool::Get()->NumThreads()
+                                  : GetCpuBudget());
     params->autotune_ram_budget =
         value_or_default(options.autotune_options().ram_budget(), 0,
                          model::kRamBudgetShare * port::AvailableRam());
   }
+  if (ShouldUseSymbolicCheckpoint(options)) {
+    const DatasetBase* incompatible = FindSymbolicCheckpointIncompatible(input);
+    if (incompatible == nullptr) {
+      params->symbolic_checkpoint = true;
+    } else {
+      LOG(WARNING) << "Symbolic checkpoints were requested, but dataset "
+                   << incompatible->DebugString()
+                   << " does not support them. Falling back to checkpointing "
+                      "the full iterator state.";
+    }
+  }
 }
 
 void AddTraceMetadata(const RootDataset::Params& params,
@@ -99,13 +141,20 @@ void AddTraceMetadata(const RootDataset::Params& params,
                                     params.max_intra_op_parallelism, 0,
                                     port::MaxParallelism())))));
   }
-  if (params.private_threadpool_size >= 0) {
+  if (params.shared_threadpool) {
+    trace_metadata->push_back(std::make_pair(
+        kSharedThreadpool,
+        strings::Printf("%d", SharedThreadPool::Get()->NumThreads())));
+  } else if (params.private_threadpool_size >= 0) {
     trace_metadata->push_back(std::make_pair(
         kPrivateThreadpoolSize,
         strings::Printf("%lld", static_cast<long long>(value_or_default(
                                     params.private_threadpool_size, 0,
                                     port::MaxParallelism())))));
   }
+  if (params.symbolic_checkpoint) {
+    trace_metadata->push_back(std::make_pair(kSymbolicCheckpoint, "true"));
+  }
   auto experiments = GetExperiments();
   if (!experiments.empty()) {
     trace_metadata->push_back(
@@ -118,7 +167,7 @@ void AddTraceMetadata(const RootDataset::Params& params,
 Status RootDataset::FromOptions(const DatasetBase* input,
                                 DatasetBase** output) {
   Params params;
-  SetRootDatasetParams(input->options(), &params);
+  SetRootDatasetParams(input, &params);
   *output = new RootDataset(input, params);
   (*output)->Initialize(/*metadata=*/{});
   return OkStatus();
@@ -127,7 +176,7 @@ Status RootDataset::FromOptions(const DatasetBase* input,
 Status RootDataset::FromOptions(core::RefCountPtr<DatasetBase> input,
                                 DatasetBase** output) {
   Params params;
-  SetRootDatasetParams(input->options(), &params);
+  SetRootDatasetParams(input.get(), &params);
   *output = new RootDataset(std::move(input), params);
   (*output)->Initialize(/*metadata=*/{});
   return OkStatus();
@@ -148,7 +197,9 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
           value_or_default(dataset()->params_.max_intra_op_parallelism, 0,
                            port::MaxParallelism());
     }
-    if (dataset()->params_.private_threadpool_size >= 0) {
+    if (dataset()->params_.shared_threadpool) {
+      threadpool_size_ = SharedThreadPool::Get()->NumThreads();
+    } else if (dataset()->params_.private_threadpool_size >= 0) {
       threadpool_size_ =
           value_or_default(dataset()->params_.private_threadpool_size, 0,
                            port::MaxParallelism());
@@ -239,7 +290,13 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
     if (dataset()->params_.autotune) {
       params.model = model_;
     }
-    if (dataset()->params_.private_threadpool_size >= 0) {
+    if (dataset()->params_.shared_threadpool) {
+      SharedThreadPool* pool = SharedThreadPool::Get();
+      params.runner = [pool](std::function<void()> c) {
+        pool->Schedule(std::move(c));
+      };
+      params.runner_threadpool_size = threadpool_size_;
+    } else if (dataset()->params_.private_threadpool_size >= 0) {
       params.runner = [pool = thread_pool_.get()](std::function<void()> c) {
         pool->Schedule(std::move(c));
       };
@@ -250,6 +307,7 @@ class RootDataset::Iterator : public DatasetIterator<RootDataset> {
           RunnerWithMaxParallelism(params.runner, max_intra_op_parallelism_);
     }
     params.options = &dataset()->options();
+    params.symbolic_checkpoint = dataset()->params_.symbolic_checkpoint;
     return params;
   }
 
@@ -34,6 +34,10 @@ class RootDataset : public DatasetBase {
     int64_t autotune_ram_budget = 0;
     int64_t max_intra_op_parallelism = 1;
     int64_t private_threadpool_size = 0;
+    // If set, functions run on the process-wide `SharedThreadPool` instead of
+    // a private thread pool.
+    bool shared_threadpool = false;
+    bool symbolic_checkpoint = false;
   };
 
   static Status FromOptions(const DatasetBase* input, DatasetBase** output);
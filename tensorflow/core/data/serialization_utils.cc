@@ -417,6 +417,81 @@ Status VariantTensorDataWriter::WriteDatasetInternal(
   return OkStatus();
 }
 
+Status MemoryCheckpoint::WriteScalar(StringPiece key, const int64_t val) {
+  Entry entry{Entry::Kind::kInt, /*has_name=*/false, "", string(key)};
+  entry.int_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::WriteScalar(StringPiece name, StringPiece key,
+                                     const int64_t val) {
+  Entry entry{Entry::Kind::kInt, /*has_name=*/true, string(name), string(key)};
+  entry.int_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::WriteScalar(StringPiece key, const tstring& val) {
+  Entry entry{Entry::Kind::kString, /*has_name=*/false, "", string(key)};
+  entry.string_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::WriteScalar(StringPiece name, StringPiece key,
+                                     const tstring& val) {
+  Entry entry{Entry::Kind::kString, /*has_name=*/true, string(name),
+              string(key)};
+  entry.string_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::WriteTensor(StringPiece key, const Tensor& val) {
+  Entry entry{Entry::Kind::kTensor, /*has_name=*/false, "", string(key)};
+  entry.tensor_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::WriteTensor(StringPiece name, StringPiece key,
+                                     const Tensor& val) {
+  Entry entry{Entry::Kind::kTensor, /*has_name=*/true, string(name),
+              string(key)};
+  entry.tensor_value = val;
+  entries_.push_back(std::move(entry));
+  return OkStatus();
+}
+
+Status MemoryCheckpoint::Save(IteratorStateWriter* writer) const {
+  for (const Entry& entry : entries_) {
+    switch (entry.kind) {
+      case Entry::Kind::kInt:
+        TF_RETURN_IF_ERROR(
+            entry.has_name
+                ? writer->WriteScalar(entry.name, entry.key, entry.int_value)
+                : writer->WriteScalar(entry.key, entry.int_value));
+        break;
+      case Entry::Kind::kString:
+        TF_RETURN_IF_ERROR(
+            entry.has_name
+                ? writer->WriteScalar(entry.name, entry.key,
+                                      entry.string_value)
+                : writer->WriteScalar(entry.key, entry.string_value));
+        break;
+      case Entry::Kind::kTensor:
+        TF_RETURN_IF_ERROR(
+            entry.has_name
+                ? writer->WriteTensor(entry.name, entry.key,
+                                      entry.tensor_value)
+                : writer->WriteTensor(entry.key, entry.tensor_value));
+        break;
+    }
+  }
+  return OkStatus();
+}
+
 Status AsGraphDefForRewrite(OpKernelContext* ctx, const DatasetBase* input,
                             std::vector<std::pair<string, Tensor>>* input_list,
                             GraphDef* result, string* dataset_node) {
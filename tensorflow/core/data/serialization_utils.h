@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERIALIZATION_UTILS_H_
 
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -120,6 +121,53 @@ class VariantTensorDataWriter : public IteratorStateWriter {
   std::map<string, std::vector<string>> keys_;
 };
 
+// An iterator state writer that keeps the written state in memory, so that it
+// can be written to another writer later. This is used by iterators that
+// checkpoint symbolically (see `IteratorContext::symbolic_checkpoint()`) to
+// capture the state of their input at the time an element was produced:
+//
+// auto checkpoint = std::make_shared<MemoryCheckpoint>();
+// TF_RETURN_IF_ERROR(SaveInput(ctx, checkpoint.get(), input_impl_));
+// ...
+// TF_RETURN_IF_ERROR(checkpoint->Save(writer));
+class MemoryCheckpoint : public IteratorStateWriter {
+ public:
+  Status WriteScalar(StringPiece key, const int64_t val) override;
+  Status WriteScalar(StringPiece name, StringPiece key,
+                     const int64_t val) override;
+
+  Status WriteScalar(StringPiece key, const tstring& val) override;
+  Status WriteScalar(StringPiece name, StringPiece key,
+                     const tstring& val) override;
+
+  Status WriteTensor(StringPiece key, const Tensor& val) override;
+  Status WriteTensor(StringPiece name, StringPiece key,
+                     const Tensor& val) override;
+
+  // Writes the state held by this checkpoint to `writer`, in the order in
+  // which it was written.
+  Status Save(IteratorStateWriter* writer) const;
+
+  // Returns the number of values held by this checkpoint.
+  size_t size() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    enum class Kind { kInt, kString, kTensor };
+
+    Kind kind;
+    // Whether the value was written with an explicit iterator name.
+    bool has_name;
+    string name;
+    string key;
+    int64_t int_value = 0;
+    tstring string_value;
+    Tensor tensor_value;
+  };
+
+  std::vector<Entry> entries_;
+};
+
 // Returns a GraphDef representation of the given dataset.
 Status AsGraphDef(const DatasetBase* dataset,
                   SerializationContext&& serialization_ctx,
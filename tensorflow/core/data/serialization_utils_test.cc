@@ -212,6 +212,33 @@ TEST(SerializationUtilsTest, VariantTensorDataWriteAfterFlushing) {
             writer.WriteTensor(full_name("Tensor"), input_tensor).code());
 }
 
+TEST(SerializationUtilsTest, MemoryCheckpointRoundtrip) {
+  MemoryCheckpoint checkpoint;
+  TF_ASSERT_OK(checkpoint.WriteScalar(full_name("Int64"), 24));
+  TF_ASSERT_OK(checkpoint.WriteScalar("Iterator", "String", "hello"));
+  Tensor input_tensor(DT_FLOAT, {1});
+  input_tensor.flat<float>()(0) = 2.0f;
+  TF_ASSERT_OK(checkpoint.WriteTensor(full_name("Tensor"), input_tensor));
+  EXPECT_EQ(checkpoint.size(), 3);
+
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(checkpoint.Save(&writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+
+  VariantTensorDataReader reader(data);
+  int64_t val_int64;
+  TF_ASSERT_OK(reader.ReadScalar(full_name("Int64"), &val_int64));
+  EXPECT_EQ(val_int64, 24);
+  tstring val_string;
+  TF_ASSERT_OK(reader.ReadScalar("Iterator", "String", &val_string));
+  EXPECT_EQ(val_string, "hello");
+  Tensor val_tensor;
+  TF_ASSERT_OK(reader.ReadTensor(full_name("Tensor"), &val_tensor));
+  EXPECT_EQ(input_tensor.NumElements(), val_tensor.NumElements());
+  EXPECT_EQ(input_tensor.flat<float>()(0), val_tensor.flat<float>()(0));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_CROSS_TRAINER_CACHE_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_CROSS_TRAINER_CACHE_H_
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <limits>
@@ -24,9 +26,12 @@ limitations under the License.
 #include <utility>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
 #include "tensorflow/core/data/service/logging_utils.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/statusor.h"
@@ -46,6 +51,12 @@ namespace data {
 // collected when the cache becomes full. Consequently, trainers read from a
 // sliding window through the dataset and may not read the full dataset.
 //
+// Optionally, elements evicted from memory are spilled to a
+// `CrossTrainerCacheSpill` on local disk, which extends the sliding window so
+// that slow trainers skip fewer elements. Evicted elements stay in memory until
+// they have been written to disk, so the memory usage may briefly exceed
+// `max_cache_size_bytes` while the cache is being extended.
+//
 // The `CrossTrainerCache` class is thread-safe.
 //
 // Example usage:
@@ -78,7 +89,8 @@ namespace data {
 // To use the cache, the user needs to define a `CachableSequence` to generate
 // an infinite sequence of data. It should implement a `GetNext` method to
 // produce elements, and a `GetElementSizeBytes` method to estimate the element
-// size in bytes.
+// size in bytes. To spill elements to disk, it should also implement
+// `SerializeElement` and `DeserializeElement`.
 template <class ElementType>
 class CachableSequence {
  public:
@@ -89,18 +101,49 @@ class CachableSequence {
 
   // Returns the estimated size of the element in bytes.
   virtual size_t GetElementSizeBytes(const ElementType&) const = 0;
+
+  // Serializes `element` into `output` to be spilled to disk.
+  virtual Status SerializeElement(const ElementType& element,
+                                  std::string& output) const {
+    return errors::Unimplemented(
+        "This cachable sequence does not support spilling to disk.");
+  }
+
+  // Deserializes an element written by `SerializeElement`. May be called
+  // concurrently with itself and with `GetNext`.
+  virtual StatusOr<ElementType> DeserializeElement(
+      absl::string_view data) const {
+    return errors::Unimplemented(
+        "This cachable sequence does not support spilling to disk.");
+  }
 };
 
 // Sliding-window cache shared across concurrent trainers.
 template <class ElementType>
 class CrossTrainerCache {
  public:
+  // Statistics about the reads of one trainer.
+  struct TrainerStats {
+    // Number of elements read from memory.
+    int64_t num_memory_hits = 0;
+    // Number of elements read from the spill tier.
+    int64_t num_spill_hits = 0;
+    // Number of elements the trainer had to produce.
+    int64_t num_misses = 0;
+    // Number of spilled elements the trainer failed to read and skipped.
+    int64_t num_skipped = 0;
+    // Number of cached elements the trainer has not read yet.
+    int64_t lag = 0;
+  };
+
   // Creates a `CrossTrainerCache` with `max_cache_size_bytes` of memory budget.
   // The cache should be able to hold at least one element, i.e.:
   // REQUIRES: `max_cache_size_bytes >= max(GetElementSizeBytes(*))`
+  // If `spill` is not null, elements evicted from memory are spilled to it.
   explicit CrossTrainerCache(
       size_t max_cache_size_bytes,
-      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence);
+      std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+      std::unique_ptr<CrossTrainerCacheSpill> spill = nullptr);
   virtual ~CrossTrainerCache() = default;
   CrossTrainerCache(const CrossTrainerCache&) = delete;
   CrossTrainerCache& operator=(const CrossTrainerCache&) = delete;
@@ -120,24 +163,38 @@ class CrossTrainerCache {
   // Returns true if the cache has been cancelled.
   bool IsCancelled() const;
 
+  // Returns the statistics about the reads of `trainer_id`.
+  TrainerStats GetTrainerStats(const std::string& trainer_id) const;
+
  private:
+  enum class QueryResult { kMemoryHit, kSpillHit, kMiss };
+
   struct CacheQueryResult {
     std::shared_ptr<const ElementType> element;
-    bool cache_hit;
+    QueryResult result;
   };
 
   // Returns the next element and metrics about this query.
   StatusOr<CacheQueryResult> GetCacheQueryResult(const std::string& trainer_id);
 
   // Returns true if element is ready for `trainer_id`. An element is ready if
-  // other trainers have read the data and the data remains in the cache. If the
-  // data is not ready, one of the trainers need to extend the cache.
+  // other trainers have read the data and the data remains in memory. If the
+  // data is not ready, it may be read from the spill tier, or one of the
+  // trainers need to extend the cache.
   bool IsElementReady(const std::string& trainer_id);
 
+  // Returns true if the element with index `element_index` may be read from
+  // the spill tier.
+  bool IsElementSpilled(size_t element_index);
+
   // Returns the absolute element index relative to the dataset (not relative to
-  // the cached elements).
+  // the cached elements). Trainers that fell behind the oldest element skip to
+  // it.
   size_t GetElementIndex(const std::string& trainer_id);
 
+  // Returns the index of the oldest element in memory.
+  size_t MemoryStartIndex() const;
+
   // Returns the next element for `trainer_id`.
   StatusOr<std::shared_ptr<const ElementType>> GetElement(
       const std::string& trainer_id);
@@ -145,12 +202,20 @@ class CrossTrainerCache {
   // Reads a new element and writes it into the cache.
   Status ExtendCache();
 
+  // Writes the evicted elements in `spilling_` to the spill tier.
+  void SpillElements();
+
+  // Reads the element with index `element_index` from the spill tier.
+  StatusOr<std::shared_ptr<const ElementType>> ReadSpilledElement(
+      size_t element_index);
+
   // Frees old elements to keep the cache size below `max_cache_size_bytes_`.
   // `new_element_size_bytes` is the size of the new element being inserted.
   void FreeSpace(size_t new_element_size_bytes);
 
-  // Records the cache hit rate and cache size.
-  void RecordMetrics(const CacheQueryResult& result);
+  // Records the cache hit rate, cache size, and trainer statistics.
+  void RecordMetrics(const std::string& trainer_id,
+                     const CacheQueryResult& result);
 
   // Maximum cache size in bytes.
   const size_t max_cache_size_bytes_;
@@ -158,6 +223,9 @@ class CrossTrainerCache {
   // The element sequence over which the sliding window cache operates.
   std::unique_ptr<CachableSequence<ElementType>> cachable_sequence_;
 
+  // Optional disk tier for the evicted elements.
+  const std::unique_ptr<CrossTrainerCacheSpill> spill_;
+
   mutable mutex mu_;
   mutable condition_variable cv_;
 
@@ -170,6 +238,10 @@ class CrossTrainerCache {
   size_t cache_size_bytes_ TF_GUARDED_BY(mu_) = 0;
   size_t cache_start_index_ TF_GUARDED_BY(mu_) = 0;
 
+  // Elements evicted from `cache_` that are being written to `spill_`. They
+  // precede `cache_start_index_`.
+  std::deque<std::shared_ptr<const ElementType>> spilling_ TF_GUARDED_BY(mu_);
+
   // True if one thread is extending the cache.
   bool extending_cache_ TF_GUARDED_BY(mu_) = false;
 
@@ -178,18 +250,24 @@ class CrossTrainerCache {
   // `trainer_to_element_index_map_[trainer_id] - cache_start_index_`.
   absl::flat_hash_map<std::string, size_t> trainer_to_element_index_map_
       TF_GUARDED_BY(mu_);
+
+  absl::flat_hash_map<std::string, TrainerStats> trainer_stats_
+      TF_GUARDED_BY(mu_);
 };
 
 template <class ElementType>
 CrossTrainerCache<ElementType>::CrossTrainerCache(
     size_t max_cache_size_bytes,
-    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence)
+    std::unique_ptr<CachableSequence<ElementType>> cachable_sequence,
+    std::unique_ptr<CrossTrainerCacheSpill> spill)
     : max_cache_size_bytes_(max_cache_size_bytes),
-      cachable_sequence_(std::move(cachable_sequence)) {
+      cachable_sequence_(std::move(cachable_sequence)),
+      spill_(std::move(spill)) {
   DCHECK_GT(max_cache_size_bytes, 0)
       << "CrossTrainerCache size must be greater than 0.";
   VLOG(2) << "Initialized tf.data service cross-trainer cache with "
-          << FormatBytes(max_cache_size_bytes) << " of memory.";
+          << FormatBytes(max_cache_size_bytes) << " of memory"
+          << (spill_ ? " and a spill tier." : ".");
 }
 
 template <class ElementType>
@@ -202,7 +280,7 @@ CrossTrainerCache<ElementType>::Get(const std::string& trainer_id)
   }
 
   TF_ASSIGN_OR_RETURN(CacheQueryResult result, GetCacheQueryResult(trainer_id));
-  RecordMetrics(result);
+  RecordMetrics(trainer_id, result);
   return result.element;
 }
 
@@ -212,20 +290,29 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
     const std::string& trainer_id) {
   bool should_extend_cache = false;
   while (true) {
+    bool should_read_spill = false;
+    size_t spilled_element_index = 0;
     {
       mutex_lock l(mu_);
       TF_RETURN_IF_ERROR(status_);
       if (IsElementReady(trainer_id)) {
         TF_ASSIGN_OR_RETURN(std::shared_ptr<const ElementType> element,
                             GetElement(trainer_id));
-        return CacheQueryResult{element,
-                                /*is_cache_hit=*/!should_extend_cache};
+        return CacheQueryResult{element, should_extend_cache
+                                             ? QueryResult::kMiss
+                                             : QueryResult::kMemoryHit};
       }
 
+      // Reads the element from the spill tier without holding the lock.
       // Extends the cache or waits for another thread to extend the cache. When
       // concurrent trainers wait for the next element, only one of them should
       // extend the cache.
-      if (extending_cache_) {
+      spilled_element_index = GetElementIndex(trainer_id);
+      if (IsElementSpilled(spilled_element_index)) {
+        should_read_spill = true;
+        should_extend_cache = false;
+        trainer_to_element_index_map_[trainer_id] = spilled_element_index + 1;
+      } else if (extending_cache_) {
         should_extend_cache = false;
         cv_.wait(l);
       } else {
@@ -234,6 +321,24 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
       }
     }
 
+    if (should_read_spill) {
+      StatusOr<std::shared_ptr<const ElementType>> element =
+          ReadSpilledElement(spilled_element_index);
+      if (element.ok()) {
+        return CacheQueryResult{*std::move(element), QueryResult::kSpillHit};
+      }
+      // The element has been evicted from the spill tier since it was looked
+      // up, or it could not be read. The trainer skips it.
+      if (!errors::IsNotFound(element.status())) {
+        LOG(WARNING) << "Failed to read element " << spilled_element_index
+                     << " from the tf.data service cross-trainer cache spill "
+                     << "tier: " << element.status();
+      }
+      mutex_lock l(mu_);
+      ++trainer_stats_[trainer_id].num_skipped;
+      continue;
+    }
+
     if (should_extend_cache) {
       Status s = ExtendCache();
       mutex_lock l(mu_);
@@ -247,7 +352,16 @@ CrossTrainerCache<ElementType>::GetCacheQueryResult(
 template <class ElementType>
 bool CrossTrainerCache<ElementType>::IsElementReady(
     const std::string& trainer_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-  return GetElementIndex(trainer_id) < cache_start_index_ + cache_.size();
+  size_t element_index = GetElementIndex(trainer_id);
+  return element_index >= MemoryStartIndex() &&
+         element_index < cache_start_index_ + cache_.size();
+}
+
+template <class ElementType>
+bool CrossTrainerCache<ElementType>::IsElementSpilled(size_t element_index)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  return spill_ && element_index >= spill_->start_index() &&
+         element_index < spill_->end_index();
 }
 
 template <class ElementType>
@@ -262,7 +376,9 @@ CrossTrainerCache<ElementType>::GetElement(const std::string& trainer_id)
   }
 
   std::shared_ptr<const ElementType> result =
-      cache_[element_index - cache_start_index_];
+      element_index < cache_start_index_
+          ? spilling_[element_index - MemoryStartIndex()]
+          : cache_[element_index - cache_start_index_];
   trainer_to_element_index_map_[trainer_id] = element_index + 1;
   return result;
 }
@@ -271,10 +387,20 @@ template <class ElementType>
 size_t CrossTrainerCache<ElementType>::GetElementIndex(
     const std::string& trainer_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   size_t element_index = trainer_to_element_index_map_[trainer_id];
-  if (element_index < cache_start_index_) {
-    element_index = cache_start_index_;
+  const size_t memory_start_index = MemoryStartIndex();
+  if (element_index >= memory_start_index) {
+    return element_index;
+  }
+  if (spill_ && element_index < spill_->end_index()) {
+    return std::max(element_index, spill_->start_index());
   }
-  return element_index;
+  return memory_start_index;
+}
+
+template <class ElementType>
+size_t CrossTrainerCache<ElementType>::MemoryStartIndex() const
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  return cache_start_index_ - spilling_.size();
 }
 
 template <class ElementType>
@@ -289,14 +415,61 @@ Status CrossTrainerCache<ElementType>::ExtendCache() TF_LOCKS_EXCLUDED(mu_) {
         " and cache size: ", max_cache_size_bytes_);
   }
 
-  mutex_lock l(mu_);
-  TF_RETURN_IF_ERROR(status_);
-  FreeSpace(new_element_size_bytes);
-  cache_.push_back(std::make_shared<ElementType>(std::move(element)));
-  cache_size_bytes_ += new_element_size_bytes;
+  {
+    mutex_lock l(mu_);
+    TF_RETURN_IF_ERROR(status_);
+    FreeSpace(new_element_size_bytes);
+    cache_.push_back(std::make_shared<ElementType>(std::move(element)));
+    cache_size_bytes_ += new_element_size_bytes;
+  }
+  SpillElements();
   return OkStatus();
 }
 
+template <class ElementType>
+void CrossTrainerCache<ElementType>::SpillElements() TF_LOCKS_EXCLUDED(mu_) {
+  if (!spill_) {
+    return;
+  }
+  // Only the thread extending the cache adds elements to `spilling_`, so the
+  // elements can be written without holding the lock.
+  std::deque<std::shared_ptr<const ElementType>> elements;
+  size_t start_index = 0;
+  {
+    mutex_lock l(mu_);
+    elements = spilling_;
+    start_index = MemoryStartIndex();
+  }
+  for (size_t i = 0; i < elements.size(); ++i) {
+    std::string data;
+    Status s = cachable_sequence_->SerializeElement(*elements[i], data);
+    if (s.ok()) {
+      s = spill_->Append(start_index + i, data);
+    }
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to spill element " << start_index + i
+                   << " of the tf.data service cross-trainer cache: " << s;
+      continue;
+    }
+    metrics::RecordTFDataServiceCrossTrainerCacheSpillBytes("write",
+                                                            data.size());
+  }
+  mutex_lock l(mu_);
+  spilling_.erase(spilling_.begin(), spilling_.begin() + elements.size());
+}
+
+template <class ElementType>
+StatusOr<std::shared_ptr<const ElementType>>
+CrossTrainerCache<ElementType>::ReadSpilledElement(size_t element_index)
+    TF_LOCKS_EXCLUDED(mu_) {
+  TF_ASSIGN_OR_RETURN(std::string data, spill_->Read(element_index));
+  metrics::RecordTFDataServiceCrossTrainerCacheSpillBytes("read", data.size());
+  TF_ASSIGN_OR_RETURN(ElementType element,
+                      cachable_sequence_->DeserializeElement(data));
+  return std::shared_ptr<const ElementType>(
+      std::make_shared<ElementType>(std::move(element)));
+}
+
 template <class ElementType>
 void CrossTrainerCache<ElementType>::FreeSpace(size_t new_element_size_bytes)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -305,6 +478,9 @@ void CrossTrainerCache<ElementType>::FreeSpace(size_t new_element_size_bytes)
          cache_size_bytes_ + new_element_size_bytes > max_cache_size_bytes_) {
     size_t free_bytes =
         cachable_sequence_->GetElementSizeBytes(*cache_.front());
+    if (spill_) {
+      spilling_.push_back(std::move(cache_.front()));
+    }
     cache_.pop_front();
     cache_size_bytes_ -= free_bytes;
     ++cache_start_index_;
@@ -336,16 +512,48 @@ bool CrossTrainerCache<ElementType>::IsCancelled() const
   return !status_.ok();
 }
 
+template <class ElementType>
+typename CrossTrainerCache<ElementType>::TrainerStats
+CrossTrainerCache<ElementType>::GetTrainerStats(
+    const std::string& trainer_id) const TF_LOCKS_EXCLUDED(mu_) {
+  mutex_lock l(mu_);
+  auto it = trainer_stats_.find(trainer_id);
+  return it == trainer_stats_.end() ? TrainerStats() : it->second;
+}
+
 template <class ElementType>
 void CrossTrainerCache<ElementType>::RecordMetrics(
-    const CacheQueryResult& result) {
-  metrics::RecordTFDataServiceCrossTrainerCacheQuery(result.cache_hit);
+    const std::string& trainer_id, const CacheQueryResult& result) {
+  metrics::RecordTFDataServiceCrossTrainerCacheQuery(
+      /*cache_hit=*/result.result != QueryResult::kMiss);
   size_t cache_size_bytes = 0;
+  int64_t lag = 0;
   {
     mutex_lock l(mu_);
     cache_size_bytes = cache_size_bytes_;
+    TrainerStats& stats = trainer_stats_[trainer_id];
+    switch (result.result) {
+      case QueryResult::kMemoryHit:
+        ++stats.num_memory_hits;
+        break;
+      case QueryResult::kSpillHit:
+        ++stats.num_spill_hits;
+        break;
+      case QueryResult::kMiss:
+        ++stats.num_misses;
+        break;
+    }
+    const size_t next_index = trainer_to_element_index_map_[trainer_id];
+    const size_t end_index = cache_start_index_ + cache_.size();
+    stats.lag = next_index < end_index ? end_index - next_index : 0;
+    lag = stats.lag;
   }
   metrics::RecordTFDataServiceCrossTrainerCacheSizeBytes(cache_size_bytes);
+  metrics::RecordTFDataServiceCrossTrainerCacheTrainerQuery(
+      trainer_id, result.result == QueryResult::kMemoryHit  ? "memory"
+                  : result.result == QueryResult::kSpillHit ? "spill"
+                                                            : "miss");
+  metrics::RecordTFDataServiceCrossTrainerCacheTrainerLag(trainer_id, lag);
 }
 
 }  // namespace data
@@ -0,0 +1,200 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Number of segments the spill budget is divided into. The spill tier frees
+// space one segment at a time.
+constexpr size_t kNumSegments = 8;
+
+}  // namespace
+
+CrossTrainerCacheSpill::CrossTrainerCacheSpill(Env* env,
+                                               const std::string& directory,
+                                               size_t max_size_bytes)
+    : env_(env),
+      directory_(directory),
+      max_size_bytes_(max_size_bytes),
+      max_segment_size_bytes_(
+          std::max<size_t>(max_size_bytes / kNumSegments, 1)),
+      file_prefix_(absl::StrCat("cross_trainer_cache_",
+                                absl::Hex(random::New64()), "_")) {}
+
+CrossTrainerCacheSpill::~CrossTrainerCacheSpill() {
+  mutex_lock l(mu_);
+  Clear();
+}
+
+Status CrossTrainerCacheSpill::Append(size_t index, absl::string_view data) {
+  mutex_lock l(mu_);
+  if (!segments_.empty() && segments_.back().end_index() != index) {
+    VLOG(2) << "Dropping spilled cross-trainer cache elements before element "
+            << index << ".";
+    Clear();
+  }
+  if (data.size() > max_size_bytes_) {
+    return OkStatus();
+  }
+  if (segments_.empty() ||
+      segments_.back().size_bytes() >= max_segment_size_bytes_) {
+    TF_RETURN_IF_ERROR(StartSegment(index));
+  }
+  Segment& segment = segments_.back();
+  Status s = segment.writer->Append(data);
+  if (s.ok()) {
+    // Makes the element visible to `Read`.
+    s = segment.writer->Flush();
+  }
+  if (!s.ok()) {
+    Clear();
+    return s;
+  }
+  segment.offsets.push_back(segment.size_bytes() + data.size());
+  segment.checksums.push_back(crc32c::Value(data.data(), data.size()));
+  size_bytes_ += data.size();
+  while (size_bytes_ > max_size_bytes_ && segments_.size() > 1) {
+    DeleteOldestSegment();
+  }
+  return OkStatus();
+}
+
+StatusOr<std::string> CrossTrainerCacheSpill::Read(size_t index) const {
+  std::shared_ptr<RandomAccessFile> reader;
+  uint64_t offset, size;
+  uint32_t checksum;
+  std::string filename;
+  {
+    mutex_lock l(mu_);
+    auto it = std::find_if(segments_.begin(), segments_.end(),
+                           [index](const Segment& segment) {
+                             return index >= segment.start_index &&
+                                    index < segment.end_index();
+                           });
+    if (it == segments_.end()) {
+      return errors::NotFound("Element ", index,
+                              " is not in the cross-trainer cache spill.");
+    }
+    const size_t position = index - it->start_index;
+    reader = it->reader;
+    offset = it->offsets[position];
+    size = it->offsets[position + 1] - offset;
+    checksum = it->checksums[position];
+    filename = it->filename;
+  }
+  // Deleting the segment does not invalidate `reader`.
+  std::string data(size, '\0');
+  StringPiece result;
+  TF_RETURN_IF_ERROR(reader->Read(offset, size, &result, &data[0]));
+  if (result.size() != size ||
+      crc32c::Value(result.data(), result.size()) != checksum) {
+    return errors::DataLoss("Corrupted cross-trainer cache spill file ",
+                            filename, " at offset ", offset, ".");
+  }
+  if (result.data() != data.data()) {
+    data.assign(result.data(), result.size());
+  }
+  return data;
+}
+
+size_t CrossTrainerCacheSpill::start_index() const {
+  mutex_lock l(mu_);
+  return segments_.empty() ? 0 : segments_.front().start_index;
+}
+
+size_t CrossTrainerCacheSpill::end_index() const {
+  mutex_lock l(mu_);
+  return segments_.empty() ? 0 : segments_.back().end_index();
+}
+
+size_t CrossTrainerCacheSpill::size_bytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+Status CrossTrainerCacheSpill::StartSegment(size_t index)
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  if (!directory_created_) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(directory_));
+    directory_created_ = true;
+  }
+  if (!segments_.empty()) {
+    Segment& last = segments_.back();
+    Status s = last.writer->Close();
+    last.writer.reset();
+    if (!s.ok()) {
+      Clear();
+      return s;
+    }
+  }
+  Segment segment;
+  segment.filename = io::JoinPath(
+      directory_, absl::StrCat(file_prefix_, next_segment_id_++));
+  segment.start_index = index;
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(segment.filename, &segment.writer));
+  std::unique_ptr<RandomAccessFile> reader;
+  Status s = env_->NewRandomAccessFile(segment.filename, &reader);
+  if (!s.ok()) {
+    segment.writer.reset();
+    env_->DeleteFile(segment.filename).IgnoreError();
+    return s;
+  }
+  segment.reader = std::move(reader);
+  segments_.push_back(std::move(segment));
+  return OkStatus();
+}
+
+void CrossTrainerCacheSpill::DeleteOldestSegment()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  Segment& segment = segments_.front();
+  if (segment.writer) {
+    segment.writer->Close().IgnoreError();
+  }
+  Status s = env_->DeleteFile(segment.filename);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to delete cross-trainer cache spill file "
+                 << segment.filename << ": " << s;
+  }
+  size_bytes_ -= segment.size_bytes();
+  segments_.pop_front();
+}
+
+void CrossTrainerCacheSpill::Clear() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  while (!segments_.empty()) {
+    DeleteOldestSegment();
+  }
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_CROSS_TRAINER_CACHE_SPILL_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_CROSS_TRAINER_CACHE_SPILL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// Disk tier for the elements evicted from a `CrossTrainerCache`, so that
+// trainers which fall behind the in-memory window read the elements from local
+// disk instead of missing them.
+//
+// Serialized elements are appended, in order of their indices, to segment files
+// in `directory`. When the spilled elements exceed `max_size_bytes`, the oldest
+// segment is deleted, so the spill tier is a sliding window that extends the
+// window of the in-memory cache. All files are deleted when the spill tier is
+// destroyed.
+//
+// The `CrossTrainerCacheSpill` class is thread-safe. Reads are performed
+// without blocking appends.
+class CrossTrainerCacheSpill {
+ public:
+  CrossTrainerCacheSpill(Env* env, const std::string& directory,
+                         size_t max_size_bytes);
+  ~CrossTrainerCacheSpill();
+  CrossTrainerCacheSpill(const CrossTrainerCacheSpill&) = delete;
+  CrossTrainerCacheSpill& operator=(const CrossTrainerCacheSpill&) = delete;
+
+  // Appends the serialized element with index `index`. If `index` is not
+  // `end_index()`, the previously spilled elements are dropped.
+  Status Append(size_t index, absl::string_view data);
+
+  // Reads the serialized element with index `index`. Returns NOT_FOUND if the
+  // element is not in [`start_index()`, `end_index()`).
+  StatusOr<std::string> Read(size_t index) const;
+
+  // Returns the range of indices of the spilled elements.
+  size_t start_index() const;
+  size_t end_index() const;
+
+  // Returns the size of the spilled elements in bytes.
+  size_t size_bytes() const;
+
+ private:
+  struct Segment {
+    std::string filename;
+    // Index of the first element in the segment.
+    size_t start_index = 0;
+    // Offset of each element within the file, followed by the file size.
+    std::vector<uint64_t> offsets = {0};
+    // Checksum of each element.
+    std::vector<uint32_t> checksums;
+    // Only set for the segment being written.
+    std::unique_ptr<WritableFile> writer;
+    std::shared_ptr<RandomAccessFile> reader;
+
+    size_t end_index() const { return start_index + checksums.size(); }
+    uint64_t size_bytes() const { return offsets.back(); }
+  };
+
+  // Starts a new segment whose first element has index `index`.
+  Status StartSegment(size_t index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Deletes the oldest segment.
+  void DeleteOldestSegment() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Deletes all segments.
+  void Clear() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const std::string directory_;
+  const size_t max_size_bytes_;
+  // Segments are closed once they reach this size.
+  const size_t max_segment_size_bytes_;
+  // Prefix of the segment file names, unique to this spill tier.
+  const std::string file_prefix_;
+
+  mutable mutex mu_;
+  bool directory_created_ TF_GUARDED_BY(mu_) = false;
+  int64_t next_segment_id_ TF_GUARDED_BY(mu_) = 0;
+  std::deque<Segment> segments_ TF_GUARDED_BY(mu_);
+  size_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_CROSS_TRAINER_CACHE_SPILL_H_
@@ -0,0 +1,105 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/status_matchers.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tensorflow::testing::IsOkAndHolds;
+using ::tensorflow::testing::StatusIs;
+using ::testing::IsEmpty;
+
+std::string LocalTempDirectory(const std::string& name) {
+  std::string directory = io::JoinPath(testing::TmpDir(), name);
+  Env::Default()->RecursivelyCreateDir(directory).IgnoreError();
+  return directory;
+}
+
+std::vector<std::string> ListFiles(const std::string& directory) {
+  std::vector<std::string> files;
+  TF_CHECK_OK(Env::Default()->GetChildren(directory, &files));
+  return files;
+}
+
+TEST(CrossTrainerCacheSpillTest, AppendAndRead) {
+  CrossTrainerCacheSpill spill(Env::Default(), LocalTempDirectory("read"),
+                               /*max_size_bytes=*/1024);
+  EXPECT_EQ(spill.start_index(), 0);
+  EXPECT_EQ(spill.end_index(), 0);
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(spill.Append(i, std::string(i + 1, 'a' + i)));
+  }
+  EXPECT_EQ(spill.start_index(), 0);
+  EXPECT_EQ(spill.end_index(), 10);
+  EXPECT_EQ(spill.size_bytes(), 55);
+  for (int i = 9; i >= 0; --i) {
+    EXPECT_THAT(spill.Read(i), IsOkAndHolds(std::string(i + 1, 'a' + i)));
+  }
+  EXPECT_THAT(spill.Read(10), StatusIs(error::NOT_FOUND));
+}
+
+TEST(CrossTrainerCacheSpillTest, EvictsOldestSegments) {
+  // Each segment holds up to 100 / 8 bytes, i.e. two elements of 10 bytes.
+  CrossTrainerCacheSpill spill(Env::Default(), LocalTempDirectory("evict"),
+                               /*max_size_bytes=*/100);
+  for (int i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(spill.Append(i, std::string(10, 'a' + i % 26)));
+    EXPECT_LE(spill.size_bytes(), 100);
+  }
+  EXPECT_GT(spill.start_index(), 90);
+  EXPECT_EQ(spill.end_index(), 100);
+  EXPECT_THAT(spill.Read(0), StatusIs(error::NOT_FOUND));
+  EXPECT_THAT(spill.Read(99), IsOkAndHolds(std::string(10, 'a' + 99 % 26)));
+}
+
+TEST(CrossTrainerCacheSpillTest, GapDropsSpilledElements) {
+  CrossTrainerCacheSpill spill(Env::Default(), LocalTempDirectory("gap"),
+                               /*max_size_bytes=*/1024);
+  TF_ASSERT_OK(spill.Append(0, "zero"));
+  TF_ASSERT_OK(spill.Append(1, "one"));
+  TF_ASSERT_OK(spill.Append(5, "five"));
+  EXPECT_EQ(spill.start_index(), 5);
+  EXPECT_EQ(spill.end_index(), 6);
+  EXPECT_THAT(spill.Read(0), StatusIs(error::NOT_FOUND));
+  EXPECT_THAT(spill.Read(5), IsOkAndHolds("five"));
+}
+
+TEST(CrossTrainerCacheSpillTest, DeletesFiles) {
+  const std::string directory = LocalTempDirectory("delete");
+  {
+    CrossTrainerCacheSpill spill(Env::Default(), directory,
+                                 /*max_size_bytes=*/1024);
+    for (int i = 0; i < 100; ++i) {
+      TF_ASSERT_OK(spill.Append(i, std::string(100, 'a')));
+    }
+    EXPECT_THAT(ListFiles(directory), ::testing::Not(IsEmpty()));
+  }
+  EXPECT_THAT(ListFiles(directory), IsEmpty());
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
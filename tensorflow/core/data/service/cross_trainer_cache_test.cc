@@ -22,14 +22,18 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
@@ -44,8 +48,10 @@ namespace {
 using ::tensorflow::monitoring::testing::CellReader;
 using ::tensorflow::testing::IsOkAndHolds;
 using ::tensorflow::testing::StatusIs;
+using ::testing::AllOf;
 using ::testing::Gt;
 using ::testing::HasSubstr;
+using ::testing::Lt;
 using ::testing::Pointee;
 using ::testing::UnorderedElementsAreArray;
 
@@ -61,6 +67,30 @@ class InfiniteRange : public CachableSequence<int64_t> {
   int64_t next_ = 0;
 };
 
+// `InfiniteRange` that can be spilled to disk.
+class SpillableRange : public InfiniteRange {
+ public:
+  Status SerializeElement(const int64_t& element,
+                          std::string& output) const override {
+    output = absl::StrCat(element);
+    return OkStatus();
+  }
+
+  StatusOr<int64_t> DeserializeElement(absl::string_view data) const override {
+    int64_t element;
+    if (!absl::SimpleAtoi(data, &element)) {
+      return errors::DataLoss("Invalid element: ", data);
+    }
+    return element;
+  }
+};
+
+std::unique_ptr<CrossTrainerCacheSpill> CreateSpill(
+    const std::string& name, size_t max_size_bytes) {
+  return std::make_unique<CrossTrainerCacheSpill>(
+      Env::Default(), io::JoinPath(testing::TmpDir(), name), max_size_bytes);
+}
+
 class TensorDataset : public CachableSequence<Tensor> {
  public:
   StatusOr<Tensor> GetNext() override { return Tensor("Test Tensor"); }
@@ -190,6 +220,47 @@ TEST(CrossTrainerCacheTest, SlowTrainersSkipData) {
   EXPECT_THAT(cache.Get("Slow trainer 2"), IsOkAndHolds(Pointee(Gt(94))));
 }
 
+TEST(CrossTrainerCacheTest, SlowTrainersReadSpilledData) {
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<SpillableRange>(),
+      CreateSpill("slow_trainers", /*max_size_bytes=*/1024));
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  // Elements 0 to 14 have been evicted from memory and are read from disk.
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(i)));
+  }
+  CrossTrainerCache<int64_t>::TrainerStats stats =
+      cache.GetTrainerStats("Slow trainer");
+  EXPECT_EQ(stats.num_spill_hits, 15);
+  EXPECT_EQ(stats.num_memory_hits, 5);
+  EXPECT_EQ(stats.num_misses, 0);
+  EXPECT_EQ(stats.num_skipped, 0);
+  EXPECT_EQ(stats.lag, 0);
+  EXPECT_EQ(cache.GetTrainerStats("Fast trainer").num_misses, 20);
+}
+
+TEST(CrossTrainerCacheTest, SlowTrainersSkipEvictedSpilledData) {
+  // Each spilled element takes two bytes.
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<SpillableRange>(),
+      CreateSpill("evicted", /*max_size_bytes=*/20));
+  EXPECT_THAT(cache.Get("Slow trainer"), IsOkAndHolds(Pointee(0)));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_THAT(cache.Get("Fast trainer"), IsOkAndHolds(Pointee(i)));
+  }
+
+  // When 99 is cached, 94 is the newest spilled element, and at most 10
+  // elements fit in the spill tier.
+  EXPECT_THAT(cache.Get("Slow trainer"),
+              IsOkAndHolds(Pointee(AllOf(Gt(84), Lt(95)))));
+  EXPECT_EQ(cache.GetTrainerStats("Slow trainer").num_spill_hits, 1);
+}
+
 TEST(CrossTrainerCacheTest, NewTrainersStartLate) {
   CrossTrainerCache<int64_t> cache(
       /*max_cache_size_bytes=*/5 * sizeof(int64_t),
@@ -285,6 +356,38 @@ TEST(CrossTrainerCacheTest, CacheSizeMetrics) {
   }
 }
 
+TEST(CrossTrainerCacheTest, TrainerMetrics) {
+  CellReader<int64_t> queries(
+      "/tensorflow/data/service/cross_trainer_cache_trainer_queries");
+  CellReader<int64_t> lag(
+      "/tensorflow/data/service/cross_trainer_cache_trainer_lag");
+  CellReader<int64_t> spill_bytes(
+      "/tensorflow/data/service/cross_trainer_cache_spill_bytes");
+
+  CrossTrainerCache<int64_t> cache(
+      /*max_cache_size_bytes=*/5 * sizeof(int64_t),
+      std::make_unique<SpillableRange>(),
+      CreateSpill("metrics", /*max_size_bytes=*/1024));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_THAT(cache.Get("Trainer 1"), IsOkAndHolds(Pointee(i)));
+  }
+  EXPECT_EQ(queries.Delta("Trainer 1", "miss"), 10);
+  EXPECT_EQ(lag.Read("Trainer 1"), 0);
+  // Elements 0 to 4 are spilled.
+  EXPECT_EQ(spill_bytes.Delta("write"), 5);
+
+  EXPECT_THAT(cache.Get("Trainer 2"), IsOkAndHolds(Pointee(0)));
+  EXPECT_EQ(queries.Delta("Trainer 2", "spill"), 1);
+  EXPECT_EQ(spill_bytes.Delta("read"), 1);
+  EXPECT_EQ(lag.Read("Trainer 2"), 9);
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_THAT(cache.Get("Trainer 2"), IsOkAndHolds(Pointee(i)));
+  }
+  EXPECT_EQ(queries.Delta("Trainer 2", "spill"), 4);
+  EXPECT_EQ(queries.Delta("Trainer 2", "memory"), 5);
+  EXPECT_EQ(lag.Read("Trainer 2"), 0);
+}
+
 TEST(CrossTrainerCacheTest, ConcurrentReaders) {
   size_t num_trainers = 10;
   size_t num_elements_to_read = 200;
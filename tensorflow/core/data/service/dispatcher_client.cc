@@ -249,6 +249,20 @@ Status DataServiceDispatcherClient::GetWorkers(
   return OkStatus();
 }
 
+Status DataServiceDispatcherClient::GetWorkerCountRecommendation(
+    GetWorkerCountRecommendationResponse& recommendation) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  GetWorkerCountRecommendationRequest req;
+  grpc::ClientContext ctx;
+  grpc::Status s =
+      stub_->GetWorkerCountRecommendation(&ctx, req, &recommendation);
+  if (!s.ok()) {
+    return grpc_util::WrapError("Failed to get worker count recommendation",
+                                s);
+  }
+  return OkStatus();
+}
+
 Status DataServiceDispatcherClient::GetDataServiceMetadata(
     const std::string& dataset_id, DataServiceMetadata& metadata) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
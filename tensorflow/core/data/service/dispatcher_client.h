@@ -108,6 +108,11 @@ class DataServiceDispatcherClient : public DataServiceClientBase {
   // stored in `workers`.
   Status GetWorkers(std::vector<WorkerInfo>& workers);
 
+  // Queries the dispatcher for the number of workers the cluster needs, based
+  // on the load reported by clients and workers.
+  Status GetWorkerCountRecommendation(
+      GetWorkerCountRecommendationResponse& recommendation);
+
   // Returns data service metadata for the registered dataset.
   Status GetDataServiceMetadata(const std::string& dataset_id,
                                 DataServiceMetadata& metadata);
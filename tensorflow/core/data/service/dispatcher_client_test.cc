@@ -21,6 +21,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/test_cluster.h"
 #include "tensorflow/core/data/service/test_util.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -172,6 +173,55 @@ TEST_F(DispatcherClientTest, EnableCrossTrainerCache) {
   EXPECT_TRUE(worker_heartbeat_response.new_tasks(0).use_cross_trainer_cache());
 }
 
+TEST_F(DispatcherClientTest, GetWorkerCountRecommendation) {
+  GetWorkerCountRecommendationResponse recommendation;
+  TF_ASSERT_OK(
+      dispatcher_client_->GetWorkerCountRecommendation(recommendation));
+  EXPECT_EQ(recommendation.num_workers(), 1);
+  EXPECT_EQ(recommendation.recommended_num_workers(), 1);
+  EXPECT_EQ(recommendation.iteration_loads_size(), 0);
+
+  DataServiceMetadata metadata = GetDefaultMetadata();
+  metadata.set_cardinality(kInfiniteCardinality);
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id,
+                          RegisterDataset(InfiniteDataset(), metadata));
+  ProcessingModeDef processing_mode;
+  processing_mode.set_sharding_policy(ProcessingModeDef::OFF);
+  int64_t job_id;
+  TF_ASSERT_OK(dispatcher_client_->GetOrCreateJob(
+      dataset_id, processing_mode, /*job_name=*/std::nullopt,
+      /*num_consumers=*/std::nullopt,
+      /*use_cross_trainer_cache=*/false, TARGET_WORKERS_AUTO, job_id));
+  int64_t iteration_client_id;
+  TF_ASSERT_OK(dispatcher_client_->GetOrCreateIteration(
+      job_id, /*repetition=*/0, iteration_client_id));
+
+  // The client waits for data half of the time.
+  ClientHeartbeatRequest heartbeat_request;
+  heartbeat_request.set_iteration_client_id(iteration_client_id);
+  ClientConsumptionMetrics* metrics =
+      heartbeat_request.mutable_consumption_metrics();
+  metrics->set_elapsed_time_us(1000000);
+  metrics->set_stall_time_us(500000);
+  ClientHeartbeatResponse heartbeat_response;
+  TF_ASSERT_OK(dispatcher_client_->ClientHeartbeat(heartbeat_request,
+                                                   heartbeat_response));
+
+  TF_ASSERT_OK(
+      dispatcher_client_->GetWorkerCountRecommendation(recommendation));
+  EXPECT_EQ(recommendation.num_workers(), 1);
+  EXPECT_EQ(recommendation.recommended_num_workers(), 2);
+  ASSERT_EQ(recommendation.iteration_loads_size(), 1);
+  EXPECT_EQ(recommendation.iteration_loads(0).num_workers(), 1);
+  EXPECT_DOUBLE_EQ(recommendation.iteration_loads(0).stall_fraction(), 0.5);
+
+  // Released clients no longer contribute to the recommendation.
+  TF_ASSERT_OK(dispatcher_client_->ReleaseIterationClient(iteration_client_id));
+  TF_ASSERT_OK(
+      dispatcher_client_->GetWorkerCountRecommendation(recommendation));
+  EXPECT_EQ(recommendation.recommended_num_workers(), 1);
+}
+
 TEST_F(DispatcherClientTest, CreateNamedJob) {
   DataServiceMetadata metadata = GetDefaultMetadata();
   metadata.set_cardinality(10);
@@ -46,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 #include "tensorflow/core/data/service/validate_utils.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_count_policy.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -81,6 +82,7 @@ constexpr int64_t kDefaultIterationGcCheckIntervalMs =
     10 * 60 * 1000;                                              // 10 minutes.
 constexpr int64_t kDefaultIterationGcTimeoutMs = 5 * 60 * 1000;  // 5 minutes.
 constexpr int64_t kDefaultClientTimeoutMs = 2 * 60 * 1000;       // 2 minutes.
+constexpr int64_t kDefaultJournalSnapshotInterval = 10000;
 
 constexpr std::array<const char*, 8> kNodeNameSharingOps = {
     "HashTable",
@@ -153,6 +155,9 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
   if (new_config.client_timeout_ms() == 0) {
     new_config.set_client_timeout_ms(kDefaultClientTimeoutMs);
   }
+  if (new_config.journal_snapshot_interval() == 0) {
+    new_config.set_journal_snapshot_interval(kDefaultJournalSnapshotInterval);
+  }
   return new_config;
 }
 
@@ -169,6 +174,7 @@ DataServiceDispatcherImpl::DataServiceDispatcherImpl(
     const DispatcherConfig& config)
     : config_(ApplyConfigDefaults(config)),
       env_(Env::Default()),
+      worker_count_policy_(std::make_unique<DefaultWorkerCountPolicy>()),
       state_(config_) {
   if (config_.work_dir().empty()) {
     dataset_store_ = std::make_unique<MemoryDatasetStore>();
@@ -212,17 +218,33 @@ Status DataServiceDispatcherImpl::Start() {
       std::make_unique<FileJournalWriter>(env_, JournalDir(config_.work_dir()));
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
             << JournalDir(config_.work_dir());
+  DispatcherStateSnapshot snapshot;
+  int64_t journal_sequence_number = 0;
+  Status s = ReadLatestJournalSnapshot(env_, JournalDir(config_.work_dir()),
+                                       snapshot, journal_sequence_number);
+  if (s.ok()) {
+    TF_RETURN_IF_ERROR(state_.Restore(snapshot));
+    LOG(INFO) << "Restored dispatcher state from snapshot. Replaying journal "
+              << "from file " << journal_sequence_number << ".";
+  } else if (!errors::IsNotFound(s)) {
+    return s;
+  }
   Update update;
   bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
-  Status s = reader.Read(update, end_of_journal);
+  FileJournalReader reader(env_, JournalDir(config_.work_dir()),
+                           journal_sequence_number);
+  s = reader.Read(update, end_of_journal);
   if (errors::IsNotFound(s)) {
-    LOG(INFO) << "No journal found. Starting dispatcher from new state.";
+    LOG(INFO) << "No journal found. Starting dispatcher from "
+              << (journal_sequence_number > 0 ? "snapshot." : "new state.");
   } else if (!s.ok()) {
     return s;
   } else {
     while (!end_of_journal) {
       TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+      // The replayed updates count towards the next snapshot, so that a long
+      // journal is compacted soon after a restart.
+      ++num_updates_since_journal_snapshot_;
       TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
     }
   }
@@ -336,6 +358,8 @@ Status DataServiceDispatcherImpl::WorkerHeartbeat(
           << request->worker_address();
   mutex_lock l(mu_);
   const std::string& worker_address = request->worker_address();
+  load_tracker_.RecordWorkerCpuUtilization(worker_address,
+                                           request->cpu_utilization());
   // Assigned tasks from the perspective of the dispatcher.
   std::vector<std::shared_ptr<const Task>> assigned_tasks;
   Status s = state_.TasksForWorker(worker_address, assigned_tasks);
@@ -690,6 +714,7 @@ Status DataServiceDispatcherImpl::ReleaseIterationClient(
   release_iteration_client->set_iteration_client_id(iteration_client_id);
   release_iteration_client->set_time_micros(env_->NowMicros());
   TF_RETURN_IF_ERROR(Apply(update));
+  load_tracker_.RemoveClient(iteration_client_id);
   return OkStatus();
 }
 
@@ -955,6 +980,11 @@ Status DataServiceDispatcherImpl::ClientHeartbeat(
         "Consider configuring the dispatcher with a higher "
         "`iteration_gc_timeout_ms`.");
   }
+  if (request->has_consumption_metrics()) {
+    load_tracker_.RecordClientMetrics(request->iteration_client_id(),
+                                      iteration->iteration_id,
+                                      request->consumption_metrics());
+  }
   if (request->optional_current_round_case() ==
       ClientHeartbeatRequest::kCurrentRound) {
     round_robin_rounds_[request->iteration_client_id()] =
@@ -1039,6 +1069,49 @@ Status DataServiceDispatcherImpl::GetWorkers(const GetWorkersRequest* request,
   return OkStatus();
 }
 
+Status DataServiceDispatcherImpl::GetWorkerCountRecommendation(
+    const GetWorkerCountRecommendationRequest* request,
+    GetWorkerCountRecommendationResponse* response) {
+  TF_RETURN_IF_ERROR(CheckStarted());
+  mutex_lock l(mu_);
+  const int64_t num_workers = state_.ListWorkers().size();
+  response->set_num_workers(num_workers);
+  std::optional<int64_t> recommended_num_workers;
+  for (const auto& iteration : state_.ListIterations()) {
+    if (iteration->finished || iteration->garbage_collected ||
+        !load_tracker_.HasClientMetrics(iteration->iteration_id)) {
+      continue;
+    }
+    std::vector<std::shared_ptr<const Task>> tasks;
+    TF_RETURN_IF_ERROR(
+        state_.TasksForIteration(iteration->iteration_id, tasks));
+    std::vector<std::string> worker_addresses;
+    worker_addresses.reserve(tasks.size());
+    for (const auto& task : tasks) {
+      worker_addresses.push_back(task->worker_address);
+    }
+    IterationLoad* load = response->add_iteration_loads();
+    *load = load_tracker_.GetIterationLoad(iteration->iteration_id,
+                                           worker_addresses);
+    load->set_recommended_num_workers(
+        worker_count_policy_->RecommendWorkerCount(*load));
+    recommended_num_workers = std::max(recommended_num_workers.value_or(0),
+                                       load->recommended_num_workers());
+  }
+  response->set_recommended_num_workers(
+      recommended_num_workers.value_or(num_workers));
+  VLOG(3) << "Recommending " << response->recommended_num_workers()
+          << " workers for " << response->iteration_loads_size()
+          << " iterations. Current number of workers: " << num_workers;
+  return OkStatus();
+}
+
+void DataServiceDispatcherImpl::SetWorkerCountPolicy(
+    std::unique_ptr<WorkerCountPolicy> policy) TF_LOCKS_EXCLUDED(mu_) {
+  mutex_lock l(mu_);
+  worker_count_policy_ = std::move(policy);
+}
+
 Status DataServiceDispatcherImpl::PopulateTaskDef(
     std::shared_ptr<const Task> task, TaskDef* task_def) const
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1107,10 +1180,31 @@ Status DataServiceDispatcherImpl::ApplyWithoutJournaling(const Update& update)
 
 Status DataServiceDispatcherImpl::Apply(const Update& update)
     TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-  if (journal_writer_.has_value()) {
-    TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+  if (!journal_writer_.has_value()) {
+    return state_.Apply(update);
+  }
+  TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  ++num_updates_since_journal_snapshot_;
+  if (config_.journal_snapshot_interval() > 0 &&
+      num_updates_since_journal_snapshot_ >=
+          config_.journal_snapshot_interval()) {
+    WriteJournalSnapshot();
+  }
+  return OkStatus();
+}
+
+void DataServiceDispatcherImpl::WriteJournalSnapshot()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  num_updates_since_journal_snapshot_ = 0;
+  DispatcherStateSnapshot snapshot;
+  state_.Snapshot(snapshot);
+  // The update is already durable in the journal, so failing to write the
+  // snapshot only delays compaction.
+  Status s = journal_writer_.value()->WriteSnapshot(snapshot);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to write dispatcher state snapshot: " << s;
   }
-  return state_.Apply(update);
 }
 
 void DataServiceDispatcherImpl::IterationGcThread() {
@@ -1157,6 +1251,7 @@ Status DataServiceDispatcherImpl::ReleaseMissingClients()
       release_client->set_iteration_client_id(client_id);
       release_client->set_time_micros(now);
       TF_RETURN_IF_ERROR(Apply(update));
+      load_tracker_.RemoveClient(client_id);
     }
   }
   return OkStatus();
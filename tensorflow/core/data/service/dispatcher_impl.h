@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/export.pb.h"
 #include "tensorflow/core/data/service/task_remover.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
+#include "tensorflow/core/data/service/worker_count_policy.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
@@ -143,6 +144,11 @@ class DataServiceDispatcherImpl {
   // Returns the number of active iterations.
   size_t NumActiveIterations() TF_LOCKS_EXCLUDED(mu_);
 
+  // Replaces the policy used by `GetWorkerCountRecommendation`, which defaults
+  // to `DefaultWorkerCountPolicy`.
+  void SetWorkerCountPolicy(std::unique_ptr<WorkerCountPolicy> policy)
+      TF_LOCKS_EXCLUDED(mu_);
+
   // See dispatcher.proto for API documentation.
 
   /// Worker-facing API.
@@ -175,6 +181,9 @@ class DataServiceDispatcherImpl {
                          ClientHeartbeatResponse* response);
   Status GetWorkers(const GetWorkersRequest* request,
                     GetWorkersResponse* response);
+  Status GetWorkerCountRecommendation(
+      const GetWorkerCountRecommendationRequest* request,
+      GetWorkerCountRecommendationResponse* response);
 
   // Exports the dispatcher state for debugging.
   DispatcherStateExport ExportState() const;
@@ -299,6 +308,8 @@ class DataServiceDispatcherImpl {
   // used when recovering state when the dispatcher starts.
   Status ApplyWithoutJournaling(const Update& update)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Writes a snapshot of the state, which replaces the journal written so far.
+  void WriteJournalSnapshot() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // A thread which periodically checks for iterations to clean up.
   void IterationGcThread();
   // Releases iteration clients that haven't heartbeated recently.
@@ -341,9 +352,15 @@ class DataServiceDispatcherImpl {
   // Map from client id to the time of the client's last heartbeat.
   absl::flat_hash_map<int64_t, absl::Time> latest_client_heartbeats_time_
       TF_GUARDED_BY(mu_);
+  // Load reported by client and worker heartbeats, used to recommend the
+  // number of workers. It is not journaled.
+  IterationLoadTracker load_tracker_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<WorkerCountPolicy> worker_count_policy_ TF_GUARDED_BY(mu_);
 
   std::optional<std::unique_ptr<JournalWriter>> journal_writer_
       TF_GUARDED_BY(mu_);
+  // Number of updates applied since the last snapshot of the state.
+  int64_t num_updates_since_journal_snapshot_ TF_GUARDED_BY(mu_) = 0;
   DispatcherState state_ TF_GUARDED_BY(mu_);
   // Condition variable for waking up the iteration gc thread.
   condition_variable iteration_gc_thread_cv_;
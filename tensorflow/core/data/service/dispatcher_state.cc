@@ -17,6 +17,7 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <optional>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -113,6 +114,7 @@ void DispatcherState::RegisterWorker(
   std::string address = register_worker.worker_address();
   DCHECK(!workers_.contains(address));
   workers_[address] = std::make_shared<Worker>(register_worker);
+  workers_in_registration_order_.push_back(workers_[address]);
   tasks_by_worker_[address] =
       absl::flat_hash_map<int64_t, std::shared_ptr<Task>>();
   worker_index_resolver_.AddWorker(address);
@@ -315,6 +317,255 @@ void DispatcherState::FinishTask(const FinishTaskUpdate& finish_task) {
   iterations_[task->iteration->iteration_id]->finished = all_finished;
 }
 
+void DispatcherState::Snapshot(DispatcherStateSnapshot& snapshot) const {
+  snapshot.Clear();
+  snapshot.set_next_available_dataset_id(next_available_dataset_id_);
+  snapshot.set_next_available_job_id(next_available_job_id_);
+  snapshot.set_next_available_iteration_id(next_available_iteration_id_);
+  snapshot.set_next_available_iteration_client_id(
+      next_available_iteration_client_id_);
+  snapshot.set_next_available_task_id(next_available_task_id_);
+
+  for (const auto& it : datasets_by_id_) {
+    const Dataset& dataset = *it.second;
+    RegisterDatasetUpdate* register_dataset = snapshot.add_datasets();
+    register_dataset->set_dataset_id(dataset.dataset_id);
+    register_dataset->set_fingerprint(dataset.fingerprint);
+    *register_dataset->mutable_metadata() = dataset.metadata;
+    auto fingerprint_it = datasets_by_fingerprint_.find(dataset.fingerprint);
+    register_dataset->set_dedupe_by_dataset_id(
+        fingerprint_it == datasets_by_fingerprint_.end() ||
+        fingerprint_it->second != it.second);
+  }
+
+  for (const auto& worker : workers_in_registration_order_) {
+    RegisterWorkerUpdate* register_worker = snapshot.add_workers();
+    register_worker->set_worker_address(worker->address);
+    register_worker->set_transfer_address(worker->transfer_address);
+    *register_worker->mutable_worker_tags() = {worker->tags.begin(),
+                                               worker->tags.end()};
+    register_worker->set_worker_uid(worker->uid);
+  }
+
+  for (const auto& it : jobs_by_id_) {
+    const Job& job = *it.second;
+    CreateJobUpdate* create_job = snapshot.add_jobs();
+    create_job->set_job_id(job.id);
+    create_job->set_job_name(job.job_name);
+    create_job->set_dataset_id(job.dataset_id);
+    *create_job->mutable_processing_mode_def() = job.processing_mode;
+    if (job.num_consumers.has_value()) {
+      create_job->set_num_consumers(job.num_consumers.value());
+    }
+    create_job->set_target_workers(job.target_workers);
+    create_job->set_use_cross_trainer_cache(job.use_cross_trainer_cache);
+  }
+
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> client_ids_by_iteration;
+  for (const auto& it : iterations_for_client_ids_) {
+    if (it.second) {
+      client_ids_by_iteration[it.second->iteration_id].push_back(it.first);
+    }
+  }
+  // Tasks that were removed while pending are only referenced by their
+  // iteration.
+  std::vector<std::shared_ptr<Task>> removed_tasks;
+  std::vector<int64_t> iteration_ids;
+  iteration_ids.reserve(iterations_.size());
+  for (const auto& it : iterations_) {
+    iteration_ids.push_back(it.first);
+  }
+  // Restoring iterations in order of creation restores `iterations_by_key_`.
+  std::sort(iteration_ids.begin(), iteration_ids.end());
+  for (int64_t iteration_id : iteration_ids) {
+    const Iteration& iteration = *iterations_.at(iteration_id);
+    IterationSnapshot* iteration_snapshot = snapshot.add_iterations();
+    CreateIterationUpdate* create_iteration =
+        iteration_snapshot->mutable_create_iteration();
+    create_iteration->set_iteration_id(iteration_id);
+    create_iteration->set_job_id(iteration.job->id);
+    create_iteration->set_repetition(iteration.iteration_key.repetition);
+    if (iteration.distributed_epoch_state.has_value()) {
+      const DistributedEpochState& state =
+          iteration.distributed_epoch_state.value();
+      create_iteration->set_num_split_providers(state.repetitions.size());
+      *iteration_snapshot->mutable_split_repetitions() = {
+          state.repetitions.begin(), state.repetitions.end()};
+      *iteration_snapshot->mutable_split_indices() = {state.indices.begin(),
+                                                      state.indices.end()};
+    }
+    std::queue<PendingTask> pending_tasks = iteration.pending_tasks;
+    for (; !pending_tasks.empty(); pending_tasks.pop()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      PendingTaskSnapshot* pending_task_snapshot =
+          iteration_snapshot->add_pending_tasks();
+      pending_task_snapshot->set_task_id(pending_task.task->task_id);
+      pending_task_snapshot->set_target_round(pending_task.target_round);
+      *pending_task_snapshot->mutable_ready_consumers() = {
+          pending_task.ready_consumers.begin(),
+          pending_task.ready_consumers.end()};
+      pending_task_snapshot->set_failures(pending_task.failures);
+      if (pending_task.task->removed) {
+        removed_tasks.push_back(pending_task.task);
+      }
+    }
+    auto tasks_it = tasks_by_iteration_.find(iteration_id);
+    if (tasks_it != tasks_by_iteration_.end()) {
+      for (const auto& task : tasks_it->second) {
+        iteration_snapshot->add_task_ids(task->task_id);
+      }
+    }
+    std::vector<int64_t>& client_ids = client_ids_by_iteration[iteration_id];
+    std::sort(client_ids.begin(), client_ids.end());
+    *iteration_snapshot->mutable_iteration_client_ids() = {client_ids.begin(),
+                                                           client_ids.end()};
+    iteration_snapshot->set_last_client_released_micros(
+        iteration.last_client_released_micros);
+    iteration_snapshot->set_finished(iteration.finished);
+    iteration_snapshot->set_garbage_collected(iteration.garbage_collected);
+  }
+
+  auto add_task = [&snapshot](const Task& task) {
+    TaskSnapshot* task_snapshot = snapshot.add_tasks();
+    CreateTaskUpdate* create_task = task_snapshot->mutable_create_task();
+    create_task->set_task_id(task.task_id);
+    create_task->set_iteration_id(task.iteration->iteration_id);
+    create_task->set_worker_address(task.worker_address);
+    create_task->set_transfer_address(task.transfer_address);
+    *create_task->mutable_worker_tags() = {task.worker_tags.begin(),
+                                           task.worker_tags.end()};
+    create_task->set_worker_uid(task.worker_uid);
+    task_snapshot->set_starting_round(task.starting_round);
+    task_snapshot->set_finished(task.finished);
+    task_snapshot->set_removed(task.removed);
+  };
+  for (const auto& it : tasks_) {
+    add_task(*it.second);
+  }
+  for (const auto& task : removed_tasks) {
+    add_task(*task);
+  }
+}
+
+Status DispatcherState::Restore(const DispatcherStateSnapshot& snapshot) {
+  if (!datasets_by_id_.empty() || !workers_.empty() || !jobs_by_id_.empty() ||
+      !iterations_.empty() || !tasks_.empty()) {
+    return errors::FailedPrecondition(
+        "The dispatcher state must be empty to be restored from a snapshot.");
+  }
+  for (const RegisterDatasetUpdate& register_dataset : snapshot.datasets()) {
+    RegisterDataset(register_dataset);
+  }
+  for (const RegisterWorkerUpdate& register_worker : snapshot.workers()) {
+    RegisterWorker(register_worker);
+  }
+  for (const CreateJobUpdate& create_job : snapshot.jobs()) {
+    CreateJob(create_job);
+  }
+  for (const IterationSnapshot& iteration_snapshot : snapshot.iterations()) {
+    const CreateIterationUpdate& create_iteration =
+        iteration_snapshot.create_iteration();
+    if (!jobs_by_id_.contains(create_iteration.job_id())) {
+      return errors::DataLoss("Iteration ", create_iteration.iteration_id(),
+                              " of the dispatcher state snapshot refers to "
+                              "unknown job ",
+                              create_iteration.job_id());
+    }
+    CreateIteration(create_iteration);
+    Iteration& iteration = *iterations_[create_iteration.iteration_id()];
+    if (iteration.distributed_epoch_state.has_value()) {
+      DistributedEpochState& state = iteration.distributed_epoch_state.value();
+      if (iteration_snapshot.split_repetitions_size() !=
+              state.repetitions.size() ||
+          iteration_snapshot.split_indices_size() != state.indices.size()) {
+        return errors::DataLoss(
+            "Invalid distributed epoch state for iteration ",
+            create_iteration.iteration_id(),
+            " in the dispatcher state snapshot.");
+      }
+      state.repetitions.assign(iteration_snapshot.split_repetitions().begin(),
+                               iteration_snapshot.split_repetitions().end());
+      state.indices.assign(iteration_snapshot.split_indices().begin(),
+                           iteration_snapshot.split_indices().end());
+    }
+    for (int64_t client_id : iteration_snapshot.iteration_client_ids()) {
+      iterations_for_client_ids_[client_id] =
+          iterations_[create_iteration.iteration_id()];
+      iteration.num_clients++;
+    }
+    iteration.last_client_released_micros =
+        iteration_snapshot.last_client_released_micros();
+    iteration.finished = iteration_snapshot.finished();
+    iteration.garbage_collected = iteration_snapshot.garbage_collected();
+  }
+
+  TasksById all_tasks;
+  for (const TaskSnapshot& task_snapshot : snapshot.tasks()) {
+    const CreateTaskUpdate& create_task = task_snapshot.create_task();
+    auto iteration_it = iterations_.find(create_task.iteration_id());
+    if (iteration_it == iterations_.end()) {
+      return errors::DataLoss("Task ", create_task.task_id(),
+                              " of the dispatcher state snapshot refers to "
+                              "unknown iteration ",
+                              create_task.iteration_id());
+    }
+    auto task = std::make_shared<Task>(create_task, iteration_it->second);
+    task->starting_round = task_snapshot.starting_round();
+    task->finished = task_snapshot.finished();
+    task->removed = task_snapshot.removed();
+    all_tasks[task->task_id] = task;
+    if (task->removed) {
+      continue;
+    }
+    tasks_[task->task_id] = task;
+    if (!task->finished) {
+      tasks_by_worker_[task->worker_address][task->task_id] = task;
+    }
+  }
+  auto get_task = [&all_tasks](int64_t task_id,
+                               std::shared_ptr<Task>& task) -> Status {
+    auto it = all_tasks.find(task_id);
+    if (it == all_tasks.end()) {
+      return errors::DataLoss("Unknown task ", task_id,
+                              " in the dispatcher state snapshot.");
+    }
+    task = it->second;
+    return OkStatus();
+  };
+  for (const IterationSnapshot& iteration_snapshot : snapshot.iterations()) {
+    const int64_t iteration_id =
+        iteration_snapshot.create_iteration().iteration_id();
+    std::vector<std::shared_ptr<Task>>& tasks =
+        tasks_by_iteration_[iteration_id];
+    for (int64_t task_id : iteration_snapshot.task_ids()) {
+      std::shared_ptr<Task> task;
+      TF_RETURN_IF_ERROR(get_task(task_id, task));
+      tasks.push_back(std::move(task));
+    }
+    Iteration& iteration = *iterations_[iteration_id];
+    for (const PendingTaskSnapshot& pending_task_snapshot :
+         iteration_snapshot.pending_tasks()) {
+      std::shared_ptr<Task> task;
+      TF_RETURN_IF_ERROR(get_task(pending_task_snapshot.task_id(), task));
+      PendingTask pending_task(std::move(task),
+                               pending_task_snapshot.target_round());
+      pending_task.ready_consumers.insert(
+          pending_task_snapshot.ready_consumers().begin(),
+          pending_task_snapshot.ready_consumers().end());
+      pending_task.failures = pending_task_snapshot.failures();
+      iteration.pending_tasks.push(std::move(pending_task));
+    }
+  }
+
+  next_available_dataset_id_ = snapshot.next_available_dataset_id();
+  next_available_job_id_ = snapshot.next_available_job_id();
+  next_available_iteration_id_ = snapshot.next_available_iteration_id();
+  next_available_iteration_client_id_ =
+      snapshot.next_available_iteration_client_id();
+  next_available_task_id_ = snapshot.next_available_task_id();
+  return OkStatus();
+}
+
 std::string DispatcherState::NextAvailableDatasetId() const {
   return absl::StrCat(next_available_dataset_id_);
 }
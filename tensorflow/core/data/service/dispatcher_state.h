@@ -72,6 +72,12 @@ class DispatcherState {
   // Applies the given update to the dispatcher's state.
   Status Apply(const Update& update);
 
+  // Stores a compacted representation of the state in `snapshot`.
+  void Snapshot(DispatcherStateSnapshot& snapshot) const;
+  // Restores the state from `snapshot`. The state must be empty. Further
+  // updates can be applied to the restored state.
+  Status Restore(const DispatcherStateSnapshot& snapshot);
+
   // A dataset registered with the dispatcher.
   struct Dataset {
     explicit Dataset(const std::string& dataset_id, int64_t fingerprint,
@@ -323,6 +329,9 @@ class DispatcherState {
 
   // Registered workers, keyed by address.
   absl::flat_hash_map<std::string, std::shared_ptr<Worker>> workers_;
+  // Registered workers, in order of registration. The order determines the
+  // indices assigned by `worker_index_resolver_`.
+  std::vector<std::shared_ptr<Worker>> workers_in_registration_order_;
 
   // Assigns an index to each worker according to worker addresses list
   // specified in the dispatcher config.
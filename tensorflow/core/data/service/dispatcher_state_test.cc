@@ -692,5 +692,79 @@ TEST(DispatcherState, ListActiveClients) {
   EXPECT_THAT(state.ListActiveClientIds(), UnorderedElementsAre(6, 8));
 }
 
+TEST(DispatcherState, SnapshotAndRestore) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset("dataset_id", /*fingerprint=*/10, state));
+  TF_ASSERT_OK(RegisterDataset("named_dataset", /*fingerprint=*/10,
+                               /*dedupe_by_dataset_id=*/true, state));
+  TF_ASSERT_OK(RegisterWorker("worker_a", state));
+  TF_ASSERT_OK(RegisterWorker("worker_b", state));
+  TF_ASSERT_OK(CreateIteration(/*iteration_id=*/3, "dataset_id",
+                               IterationKey("job", /*repetition=*/0), state));
+  TF_ASSERT_OK(
+      CreateTask(/*task_id=*/8, /*iteration_id=*/3, "worker_a", state));
+  TF_ASSERT_OK(
+      CreateTask(/*task_id=*/9, /*iteration_id=*/3, "worker_b", state));
+  TF_ASSERT_OK(FinishTask(/*task_id=*/8, state));
+  TF_ASSERT_OK(AcquireIterationClientId(/*iteration_id=*/3,
+                                        /*iteration_client_id=*/6, state));
+  TF_ASSERT_OK(AcquireIterationClientId(/*iteration_id=*/3,
+                                        /*iteration_client_id=*/7, state));
+  TF_ASSERT_OK(ReleaseIterationClientId(/*iteration_client_id=*/7,
+                                        /*release_time=*/100, state));
+
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+  DispatcherState restored;
+  TF_ASSERT_OK(restored.Restore(snapshot));
+
+  EXPECT_EQ(restored.NextAvailableDatasetId(), state.NextAvailableDatasetId());
+  EXPECT_EQ(restored.NextAvailableJobId(), state.NextAvailableJobId());
+  EXPECT_EQ(restored.NextAvailableIterationId(),
+            state.NextAvailableIterationId());
+  EXPECT_EQ(restored.NextAvailableIterationClientId(),
+            state.NextAvailableIterationClientId());
+  EXPECT_EQ(restored.NextAvailableTaskId(), state.NextAvailableTaskId());
+
+  std::shared_ptr<const Dataset> dataset;
+  TF_ASSERT_OK(restored.DatasetFromFingerprint(10, dataset));
+  EXPECT_EQ(dataset->dataset_id, "dataset_id");
+  TF_EXPECT_OK(restored.DatasetFromId("named_dataset", dataset));
+  EXPECT_THAT(restored.ListWorkers(), SizeIs(2));
+
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(restored.IterationByKey(IterationKey("job", /*repetition=*/0),
+                                       iteration));
+  EXPECT_EQ(iteration->iteration_id, 3);
+  EXPECT_EQ(iteration->num_clients, 1);
+  EXPECT_EQ(iteration->last_client_released_micros, 100);
+  EXPECT_FALSE(iteration->finished);
+  EXPECT_THAT(restored.ListActiveClientIds(), UnorderedElementsAre(6));
+
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_ASSERT_OK(restored.TasksForIteration(/*iteration_id=*/3, tasks));
+  ASSERT_THAT(tasks, SizeIs(2));
+  EXPECT_EQ(tasks[0]->task_id, 8);
+  EXPECT_TRUE(tasks[0]->finished);
+  EXPECT_EQ(tasks[1]->task_id, 9);
+  TF_ASSERT_OK(restored.TasksForWorker("worker_a", tasks));
+  EXPECT_THAT(tasks, IsEmpty());
+  TF_ASSERT_OK(restored.TasksForWorker("worker_b", tasks));
+  EXPECT_THAT(tasks, SizeIs(1));
+
+  // Updates apply to the restored state as to the original state.
+  TF_ASSERT_OK(FinishTask(/*task_id=*/9, restored));
+  TF_ASSERT_OK(restored.IterationFromId(/*iteration_id=*/3, iteration));
+  EXPECT_TRUE(iteration->finished);
+}
+
+TEST(DispatcherState, RestoreRequiresEmptyState) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset("dataset_id", state));
+  DispatcherStateSnapshot snapshot;
+  state.Snapshot(snapshot);
+  EXPECT_THAT(state.Restore(snapshot), StatusIs(error::FAILED_PRECONDITION));
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -21,6 +21,8 @@ limitations under the License.
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -34,6 +36,9 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kSnapshot = "snapshot";
+// Suffix of snapshots that are being written.
+constexpr StringPiece kTempSuffix = ".tmp";
 
 Status ParseSequenceNumber(const std::string& journal_file,
                            int64_t* sequence_number) {
@@ -43,6 +48,14 @@ Status ParseSequenceNumber(const std::string& journal_file,
   }
   return OkStatus();
 }
+
+bool IsSnapshotFile(const std::string& file) {
+  return absl::StartsWith(file, kSnapshot);
+}
+
+bool IsTempFile(const std::string& file) {
+  return absl::EndsWith(file, kTempSuffix);
+}
 }  // namespace
 
 std::string DataServiceJournalFile(const std::string& journal_dir,
@@ -51,6 +64,45 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kSnapshot, "_", sequence_number));
+}
+
+Status ReadLatestJournalSnapshot(Env* env, const std::string& journal_dir,
+                                 DispatcherStateSnapshot& snapshot,
+                                 int64_t& sequence_number) {
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  int64_t latest_sequence_number = -1;
+  for (const auto& file : files) {
+    if (!IsSnapshotFile(file) || IsTempFile(file)) {
+      continue;
+    }
+    int64_t snapshot_sequence_number;
+    TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &snapshot_sequence_number));
+    latest_sequence_number =
+        std::max(latest_sequence_number, snapshot_sequence_number);
+  }
+  if (latest_sequence_number < 0) {
+    return errors::NotFound("No dispatcher state snapshot in ", journal_dir);
+  }
+  std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir, latest_sequence_number);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(snapshot_file, &file));
+  io::SequentialRecordReader reader(file.get());
+  tstring record;
+  TF_RETURN_IF_ERROR(reader.ReadRecord(&record));
+  if (!snapshot.ParseFromString(record)) {
+    return errors::DataLoss("Failed to parse dispatcher state snapshot ",
+                            snapshot_file);
+  }
+  sequence_number = latest_sequence_number;
+  return OkStatus();
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -63,18 +115,87 @@ Status FileJournalWriter::EnsureInitialized() {
   TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
   int64_t latest_sequence_number = -1;
   for (const auto& file : journal_files) {
+    if (IsTempFile(file)) {
+      continue;
+    }
     int64_t sequence_number;
     TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
+    if (IsSnapshotFile(file)) {
+      // The snapshot covers the journal files before it.
+      --sequence_number;
+    }
     latest_sequence_number = std::max(latest_sequence_number, sequence_number);
   }
+  return OpenJournalFile(latest_sequence_number + 1);
+}
+
+Status FileJournalWriter::OpenJournalFile(int64_t sequence_number) {
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = std::make_unique<io::RecordWriter>(file_.get());
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return OkStatus();
 }
 
+Status FileJournalWriter::WriteSnapshot(
+    const DispatcherStateSnapshot& snapshot) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  // Closes the current journal file, which the snapshot covers. If writing the
+  // snapshot fails, the next write opens a new journal file.
+  Status s = writer_->Close();
+  if (s.ok()) {
+    s = file_->Close();
+  }
+  writer_.reset();
+  file_.reset();
+  TF_RETURN_IF_ERROR(s);
+
+  const int64_t snapshot_sequence_number = sequence_number_ + 1;
+  const std::string snapshot_file =
+      DataServiceJournalSnapshotFile(journal_dir_, snapshot_sequence_number);
+  const std::string temp_file = absl::StrCat(snapshot_file, kTempSuffix);
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(temp_file, &file));
+    io::RecordWriter writer(file.get());
+    TF_RETURN_IF_ERROR(writer.WriteRecord(snapshot.SerializeAsString()));
+    TF_RETURN_IF_ERROR(writer.Close());
+    TF_RETURN_IF_ERROR(file->Sync());
+    TF_RETURN_IF_ERROR(file->Close());
+  }
+  TF_RETURN_IF_ERROR(env_->RenameFile(temp_file, snapshot_file));
+  VLOG(1) << "Wrote dispatcher state snapshot " << snapshot_file;
+  TF_RETURN_IF_ERROR(OpenJournalFile(snapshot_sequence_number));
+  DeleteCompactedFiles(snapshot_sequence_number);
+  return OkStatus();
+}
+
+void FileJournalWriter::DeleteCompactedFiles(
+    int64_t snapshot_sequence_number) {
+  std::vector<std::string> files;
+  Status s = env_->GetChildren(journal_dir_, &files);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to list journal directory " << journal_dir_ << ": "
+                 << s;
+    return;
+  }
+  for (const auto& file : files) {
+    int64_t sequence_number;
+    if (!IsTempFile(file) &&
+        (!ParseSequenceNumber(file, &sequence_number).ok() ||
+         sequence_number >= snapshot_sequence_number)) {
+      continue;
+    }
+    s = env_->DeleteFile(io::JoinPath(journal_dir_, file));
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete compacted journal file " << file
+                   << ": " << s;
+    }
+  }
+}
+
 Status FileJournalWriter::Write(const Update& update) {
   TF_RETURN_IF_ERROR(EnsureInitialized());
   std::string s = update.SerializeAsString();
@@ -91,14 +212,17 @@ Status FileJournalWriter::Write(const Update& update) {
   return OkStatus();
 }
 
-FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
-    : env_(env), journal_dir_(journal_dir) {}
+FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir,
+                                     int64_t start_sequence_number)
+    : env_(env),
+      journal_dir_(journal_dir),
+      sequence_number_(start_sequence_number) {}
 
 Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return OkStatus();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  return UpdateFile(DataServiceJournalFile(journal_dir_, sequence_number_));
 }
 
 Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
@@ -31,6 +31,18 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the state snapshot within the journal directory that
+// covers the journal files with sequence numbers below `sequence_number`.
+std::string DataServiceJournalSnapshotFile(const std::string& journal_dir,
+                                           int64_t sequence_number);
+
+// Reads the latest state snapshot in `journal_dir`, and sets
+// `sequence_number` to the sequence number of the first journal file to replay
+// after restoring it. Returns NOT_FOUND if there is no snapshot.
+Status ReadLatestJournalSnapshot(Env* env, const std::string& journal_dir,
+                                 DispatcherStateSnapshot& snapshot,
+                                 int64_t& sequence_number);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
@@ -39,6 +51,9 @@ class JournalWriter {
   virtual Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual Status EnsureInitialized() = 0;
+  // Durably stores `snapshot`, which must reflect all updates written so far,
+  // and discards the journal it replaces.
+  virtual Status WriteSnapshot(const DispatcherStateSnapshot& snapshot) = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -57,6 +72,10 @@ class JournalWriter {
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
 // can be stored durably in case of machine failure.
+//
+// `WriteSnapshot` compacts the journal: it closes the current journal file,
+// say "journal_3", writes the snapshot to "snapshot_4", deletes the journal
+// files and snapshots it replaces, and continues writing to "journal_4".
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -68,10 +87,19 @@ class FileJournalWriter : public JournalWriter {
 
   Status Write(const Update& update) override;
   Status EnsureInitialized() override;
+  Status WriteSnapshot(const DispatcherStateSnapshot& snapshot) override;
 
  private:
+  // Opens the journal file with the given sequence number for writing.
+  Status OpenJournalFile(int64_t sequence_number);
+  // Deletes the journal files and snapshots covered by the snapshot with the
+  // given sequence number.
+  void DeleteCompactedFiles(int64_t snapshot_sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of the current journal file.
+  int64_t sequence_number_ = 0;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -89,10 +117,12 @@ class JournalReader {
 // used by multiple threads.
 //
 // The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// directory, in order of their sequence numbers, starting from
+// `start_sequence_number`. See FileJournalWriter above.
 class FileJournalReader : public JournalReader {
  public:
-  explicit FileJournalReader(Env* env, StringPiece journal_dir);
+  explicit FileJournalReader(Env* env, StringPiece journal_dir,
+                             int64_t start_sequence_number = 0);
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
@@ -107,7 +137,7 @@ class FileJournalReader : public JournalReader {
   Env* env_;
   const std::string journal_dir_;
   // Sequence number of current journal file.
-  int64_t sequence_number_ = 0;
+  int64_t sequence_number_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::SequentialRecordReader> reader_;
 };
@@ -67,8 +67,9 @@ Update MakeRegisterDatasetUpdate() {
 }
 
 Status CheckJournalContent(StringPiece journal_dir,
-                           const std::vector<Update>& expected) {
-  FileJournalReader reader(Env::Default(), journal_dir);
+                           const std::vector<Update>& expected,
+                           int64_t start_sequence_number = 0) {
+  FileJournalReader reader(Env::Default(), journal_dir, start_sequence_number);
   for (const auto& update : expected) {
     Update result;
     bool end_of_journal = true;
@@ -114,6 +115,63 @@ TEST(Journal, AppendExistingJournal) {
   TF_EXPECT_OK(CheckJournalContent(journal_dir, updates));
 }
 
+TEST(Journal, SnapshotReplacesJournal) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_ASSERT_OK(writer.Write(MakeCreateIterationUpdate()));
+  TF_ASSERT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+  DispatcherStateSnapshot snapshot;
+  snapshot.set_next_available_task_id(42);
+  TF_ASSERT_OK(writer.WriteSnapshot(snapshot));
+  TF_ASSERT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(
+      DataServiceJournalFile(journal_dir, /*sequence_number=*/0))));
+  DispatcherStateSnapshot restored;
+  int64_t sequence_number;
+  TF_ASSERT_OK(ReadLatestJournalSnapshot(Env::Default(), journal_dir, restored,
+                                         sequence_number));
+  EXPECT_EQ(restored.next_available_task_id(), 42);
+  EXPECT_EQ(sequence_number, 1);
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, {MakeFinishTaskUpdate()},
+                                   sequence_number));
+}
+
+TEST(Journal, AppendAfterSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeCreateIterationUpdate()));
+    TF_ASSERT_OK(writer.WriteSnapshot(DispatcherStateSnapshot()));
+    TF_ASSERT_OK(writer.WriteSnapshot(DispatcherStateSnapshot()));
+  }
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    TF_ASSERT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+  }
+
+  DispatcherStateSnapshot snapshot;
+  int64_t sequence_number;
+  TF_ASSERT_OK(ReadLatestJournalSnapshot(Env::Default(), journal_dir, snapshot,
+                                         sequence_number));
+  EXPECT_EQ(sequence_number, 2);
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, {MakeRegisterDatasetUpdate()},
+                                   sequence_number));
+}
+
+TEST(Journal, NoSnapshot) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_ASSERT_OK(writer.Write(MakeCreateIterationUpdate()));
+  DispatcherStateSnapshot snapshot;
+  int64_t sequence_number;
+  EXPECT_TRUE(errors::IsNotFound(ReadLatestJournalSnapshot(
+      Env::Default(), journal_dir, snapshot, sequence_number)));
+}
+
 TEST(Journal, MissingFile) {
   std::string journal_dir;
   EXPECT_TRUE(NewJournalDir(journal_dir));
@@ -152,7 +152,10 @@ WorkerGrpcDataServer::WorkerGrpcDataServer(
                          std::move(options)),
       config_(config) {}
 
-WorkerGrpcDataServer::~WorkerGrpcDataServer() { delete service_; }
+WorkerGrpcDataServer::~WorkerGrpcDataServer() {
+  shared_memory_transfer_server_.reset();
+  delete service_;
+}
 
 void WorkerGrpcDataServer::AddDataServiceToBuilder(
     ::grpc::ServerBuilder& builder) {
@@ -180,11 +183,27 @@ Status WorkerGrpcDataServer::StartServiceInternal() {
         absl::StrCat(transfer_server_->get_port()),
         /*replace_all=*/false);
   }
+  if ((transfer_protocol.empty() || transfer_protocol == "grpc") &&
+      SharedMemoryTransferEnabled()) {
+    // Serves the clients on this host, which prefer shared memory to gRPC.
+    shared_memory_transfer_server_ =
+        std::make_unique<SharedMemoryDataTransferServer>(
+            worker_address, service_->get_element_getter());
+    Status s = shared_memory_transfer_server_->Start();
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to start the shared memory transfer server for "
+                   << "worker " << worker_address << ": " << s;
+      shared_memory_transfer_server_.reset();
+    }
+  }
   TF_RETURN_IF_ERROR(service_->Start(worker_address, transfer_address));
   return OkStatus();
 }
 
-void WorkerGrpcDataServer::StopServiceInternal() { service_->Stop(); }
+void WorkerGrpcDataServer::StopServiceInternal() {
+  service_->Stop();
+  shared_memory_transfer_server_.reset();
+}
 
 Status WorkerGrpcDataServer::NumTasks(int* num_tasks) {
   GetWorkerTasksRequest req;
@@ -24,6 +24,7 @@ limitations under the License.
 #include "grpcpp/server_builder.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/export.pb.h"
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/profiler/rpc/profiler_service_impl.h"
 #include "tensorflow/core/protobuf/service_config.pb.h"
@@ -135,6 +136,9 @@ class WorkerGrpcDataServer : public GrpcDataServerBase {
   // Owned. We use a raw pointer because GrpcWorkerImpl is forward-declared.
   GrpcWorkerImpl* service_;
   std::shared_ptr<DataTransferServer> transfer_server_;
+  // Serves clients on the same host when the data transfer protocol is gRPC.
+  std::unique_ptr<SharedMemoryDataTransferServer>
+      shared_memory_transfer_server_;
 };
 
 // Creates a dispatch tf.data server and stores it in `out_server`.
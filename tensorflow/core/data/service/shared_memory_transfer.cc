@@ -0,0 +1,929 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif  // defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace data {
+
+bool SharedMemoryTransferEnabled() {
+#if defined(__linux__)
+  static const bool enabled = [] {
+    bool enabled = true;
+    Status s = ReadBoolFromEnvVar("TF_DATA_SERVICE_SHARED_MEMORY_TRANSFER",
+                                  /*default_val=*/true, &enabled);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to read TF_DATA_SERVICE_SHARED_MEMORY_TRANSFER: "
+                   << s;
+    }
+    return enabled;
+  }();
+  return enabled;
+#else
+  return false;
+#endif  // defined(__linux__)
+}
+
+#if defined(__linux__)
+namespace {
+
+// Offsets of the components within a segment are multiples of this, so that
+// the client can use them as tensor buffers.
+constexpr size_t kComponentAlignment = 64;
+// Segments are allocated in multiples of this.
+constexpr size_t kMinSegmentSize = 64 << 10;
+// A free segment is only reused for an element if the element uses at least
+// 1 / kMaxSegmentWaste of it.
+constexpr size_t kMaxSegmentWaste = 4;
+// Maximum number of free segments the worker keeps per connection.
+constexpr int kMaxCachedSegments = 16;
+// Maximum size of a message exchanged over the socket. Messages only describe
+// the elements, whose contents are in the segments.
+constexpr size_t kMaxMessageSize = 64 << 10;
+// Error messages sent to the client are truncated to this size.
+constexpr size_t kMaxErrorMessageSize = 32 << 10;
+
+// How a component is stored within a segment.
+enum ComponentEncoding : uint8 {
+  // The tensor contents, for types that can be copied with memcpy.
+  kRaw = 0,
+  // A serialized `TensorProto`.
+  kProto = 1,
+};
+
+size_t RoundUp(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+// Returns the abstract socket address of the worker at `worker_address`.
+std::string GetSocketName(const std::string& worker_address) {
+  // Abstract socket names start with a null byte.
+  return absl::StrCat(std::string(1, '\0'), "tf_data_service_shm_",
+                      absl::Hex(Hash64(worker_address)));
+}
+
+Status IoError(absl::string_view context) {
+  return errors::Unavailable(context, ": ", strerror(errno));
+}
+
+void FillSocketAddress(const std::string& name, sockaddr_un* addr,
+                       socklen_t* len) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  memcpy(addr->sun_path, name.data(), name.size());
+  *len = offsetof(sockaddr_un, sun_path) + name.size();
+}
+
+// Checks that the process on the other end of `fd` runs as the same user.
+Status VerifyPeer(int fd) {
+  ucred cred;
+  socklen_t len = sizeof(cred);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+    return IoError("Failed to get the credentials of the peer");
+  }
+  if (cred.uid != geteuid()) {
+    return errors::PermissionDenied("Peer runs as user ", cred.uid,
+                                    " instead of user ", geteuid(), ".");
+  }
+  return OkStatus();
+}
+
+// Sends `message`, along with `fd_to_send` if it is not negative.
+Status SendMessage(int fd, const std::string& message, int fd_to_send) {
+  iovec iov;
+  iov.iov_base = const_cast<char*>(message.data());
+  iov.iov_len = message.size();
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  if (fd_to_send >= 0) {
+    memset(control, 0, sizeof(control));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd_to_send, sizeof(int));
+  }
+  ssize_t sent;
+  do {
+    sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  } while (sent < 0 && errno == EINTR);
+  if (sent < 0) {
+    return IoError("Failed to send a shared memory transfer message");
+  }
+  return OkStatus();
+}
+
+// Receives a message into `buffer`, which holds `kMaxMessageSize` bytes, and
+// points `message` to it. Sets `*received_fd` to the file descriptor sent with
+// the message, or to -1. Returns `Cancelled` if the peer closed the connection.
+Status ReceiveMessage(int fd, char* buffer, StringPiece* message,
+                      int* received_fd) {
+  iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len = kMaxMessageSize;
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  char control[CMSG_SPACE(sizeof(int))];
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t received;
+  do {
+    received = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (received < 0 && errno == EINTR);
+  if (received < 0) {
+    return IoError("Failed to receive a shared memory transfer message");
+  }
+  *received_fd = -1;
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      memcpy(received_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+  }
+  if (received == 0) {
+    return errors::Cancelled("The shared memory transfer peer disconnected.");
+  }
+  if (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+    if (*received_fd >= 0) close(*received_fd);
+    return errors::DataLoss("Shared memory transfer message was truncated.");
+  }
+  *message = StringPiece(buffer, received);
+  return OkStatus();
+}
+
+bool GetByte(StringPiece* input, uint8* value) {
+  if (input->empty()) return false;
+  *value = static_cast<uint8>((*input)[0]);
+  input->remove_prefix(1);
+  return true;
+}
+
+bool GetLengthPrefixed(StringPiece* input, StringPiece* value) {
+  uint64 length;
+  if (!core::GetVarint64(input, &length) || input->size() < length) {
+    return false;
+  }
+  *value = StringPiece(input->data(), length);
+  input->remove_prefix(length);
+  return true;
+}
+
+void PutLengthPrefixed(std::string* dst, StringPiece value) {
+  core::PutVarint64(dst, value.size());
+  dst->append(value.data(), value.size());
+}
+
+Status MalformedMessage() {
+  return errors::DataLoss("Malformed shared memory transfer message.");
+}
+
+// A shared memory segment mapped in the address space of the client. Deleted
+// once the worker retires the segment and no tensor points into it.
+class ClientMapping : public core::RefCounted {
+ public:
+  ClientMapping(char* data, size_t size) : data_(data), size_(size) {}
+  ~ClientMapping() override { munmap(data_, size_); }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  char* const data_;
+  const size_t size_;
+};
+
+// Segments whose element is no longer used by the client, to return to the
+// worker with the next request.
+struct ReleasedSegments {
+  mutex mu;
+  std::vector<uint64> ids TF_GUARDED_BY(mu);
+};
+
+// Holds the segment of an element while tensors of the element are alive.
+class ElementLease : public core::RefCounted {
+ public:
+  ElementLease(ClientMapping* mapping, uint64 segment_id,
+               std::shared_ptr<ReleasedSegments> released)
+      : mapping_(mapping),
+        segment_id_(segment_id),
+        released_(std::move(released)) {
+    mapping_->Ref();
+  }
+  ~ElementLease() override {
+    {
+      mutex_lock l(released_->mu);
+      released_->ids.push_back(segment_id_);
+    }
+    mapping_->Unref();
+  }
+
+ private:
+  ClientMapping* const mapping_;
+  const uint64 segment_id_;
+  const std::shared_ptr<ReleasedSegments> released_;
+};
+
+// A tensor buffer pointing into a shared memory segment.
+class SharedMemoryTensorBuffer : public TensorBuffer {
+ public:
+  SharedMemoryTensorBuffer(ElementLease* lease, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), lease_(lease), size_(size) {
+    lease_->Ref();
+  }
+  ~SharedMemoryTensorBuffer() override { lease_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("shared_memory_transfer");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  ElementLease* const lease_;
+  const size_t size_;
+};
+
+// Receives elements from a `SharedMemoryDataTransferServer`.
+class SharedMemoryDataTransferClient : public DataTransferClient {
+ public:
+  explicit SharedMemoryDataTransferClient(std::string worker_address)
+      : worker_address_(std::move(worker_address)) {
+    VLOG(2) << "Create SharedMemoryDataTransferClient for worker "
+            << worker_address_ << ".";
+  }
+
+  ~SharedMemoryDataTransferClient() override {
+    for (auto& connection : connections_) {
+      close(connection->fd);
+      for (auto& segment : connection->segments) {
+        segment.second->Unref();
+      }
+    }
+  }
+
+  // Connects to the worker, so that the factory fails if the worker does not
+  // run on this host.
+  Status Initialize() {
+    Connection* connection;
+    TF_RETURN_IF_ERROR(AcquireConnection(&connection));
+    ReleaseConnection(connection);
+    return OkStatus();
+  }
+
+  Status GetElement(const GetElementRequest& req,
+                    GetElementResult& result) override {
+    VLOG(3) << "GetElement for task " << req.task_id()
+            << " from shared memory worker " << worker_address_ << ".";
+    Connection* connection;
+    TF_RETURN_IF_ERROR(AcquireConnection(&connection));
+    Status s = GetElement(connection, req, result);
+    ReleaseConnection(connection);
+    if (!s.ok()) {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client for worker ", worker_address_,
+                                 " has been cancelled.");
+      }
+    }
+    return s;
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel SharedMemoryDataTransferClient for worker "
+            << worker_address_ << ".";
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (auto& connection : connections_) {
+      shutdown(connection->fd, SHUT_RDWR);
+    }
+  }
+
+ private:
+  struct Connection {
+    int fd = -1;
+    // Segments received on this connection, by id.
+    absl::flat_hash_map<uint64, ClientMapping*> segments;
+    std::shared_ptr<ReleasedSegments> released =
+        std::make_shared<ReleasedSegments>();
+    // Set if the connection failed, in which case it is not reused.
+    bool failed = false;
+    std::unique_ptr<char[]> buffer{new char[kMaxMessageSize]};
+  };
+
+  Status AcquireConnection(Connection** out) TF_LOCKS_EXCLUDED(mu_) {
+    {
+      mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client for worker ", worker_address_,
+                                 " has been cancelled.");
+      }
+      if (!idle_connections_.empty()) {
+        *out = idle_connections_.back();
+        idle_connections_.pop_back();
+        return OkStatus();
+      }
+    }
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+      return IoError("Failed to create a shared memory transfer socket");
+    }
+    sockaddr_un addr;
+    socklen_t addr_len;
+    FillSocketAddress(GetSocketName(worker_address_), &addr, &addr_len);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0) {
+      Status s = IoError(absl::StrCat(
+          "Failed to connect to the shared memory transfer server of worker ",
+          worker_address_));
+      close(fd);
+      return s;
+    }
+    Status s = VerifyPeer(fd);
+    if (!s.ok()) {
+      close(fd);
+      return s;
+    }
+    auto connection = std::make_unique<Connection>();
+    connection->fd = fd;
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      shutdown(fd, SHUT_RDWR);
+    }
+    *out = connection.get();
+    connections_.push_back(std::move(connection));
+    return OkStatus();
+  }
+
+  void ReleaseConnection(Connection* connection) TF_LOCKS_EXCLUDED(mu_) {
+    if (connection->failed) return;
+    mutex_lock l(mu_);
+    idle_connections_.push_back(connection);
+  }
+
+  Status GetElement(Connection* connection, const GetElementRequest& req,
+                    GetElementResult& result) {
+    std::string request;
+    std::vector<uint64> released;
+    {
+      mutex_lock l(connection->released->mu);
+      released.swap(connection->released->ids);
+    }
+    core::PutVarint64(&request, released.size());
+    for (uint64 id : released) {
+      core::PutVarint64(&request, id);
+    }
+    request.append(req.SerializeAsString());
+
+    StringPiece response;
+    int segment_fd = -1;
+    Status element_status;
+    Status s = SendMessage(connection->fd, request, /*fd_to_send=*/-1);
+    if (s.ok()) {
+      s = ReceiveMessage(connection->fd, connection->buffer.get(), &response,
+                         &segment_fd);
+    }
+    if (s.ok()) {
+      s = ParseResponse(connection, response, segment_fd, result,
+                        element_status);
+    }
+    if (segment_fd >= 0) {
+      close(segment_fd);
+    }
+    if (!s.ok()) {
+      // The state of the connection is unknown, so it is not reused.
+      connection->failed = true;
+      return s;
+    }
+    return element_status;
+  }
+
+  // Parses `response` into `result`, or into `element_status` if the worker
+  // failed to produce the element. Returns an error if `response` is invalid.
+  Status ParseResponse(Connection* connection, StringPiece response,
+                       int segment_fd, GetElementResult& result,
+                       Status& element_status) {
+    uint32 code;
+    if (!core::GetVarint32(&response, &code)) return MalformedMessage();
+    if (code != error::OK) {
+      StringPiece message;
+      if (!GetLengthPrefixed(&response, &message)) return MalformedMessage();
+      element_status = Status(static_cast<error::Code>(code), message);
+      return OkStatus();
+    }
+    uint8 flags;
+    uint64 element_index, num_retired, segment_id;
+    if (!GetByte(&response, &flags) ||
+        !core::GetVarint64(&response, &element_index) ||
+        !core::GetVarint64(&response, &num_retired)) {
+      return MalformedMessage();
+    }
+    for (uint64 i = 0; i < num_retired; ++i) {
+      uint64 id;
+      if (!core::GetVarint64(&response, &id)) return MalformedMessage();
+      auto it = connection->segments.find(id);
+      if (it != connection->segments.end()) {
+        it->second->Unref();
+        connection->segments.erase(it);
+      }
+    }
+    if (!core::GetVarint64(&response, &segment_id)) return MalformedMessage();
+    ClientMapping* mapping = nullptr;
+    if (segment_id != 0) {
+      uint64 size;
+      uint8 is_new;
+      if (!core::GetVarint64(&response, &size) ||
+          !GetByte(&response, &is_new)) {
+        return MalformedMessage();
+      }
+      if (is_new) {
+        if (segment_fd < 0) return MalformedMessage();
+        void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, segment_fd,
+                          /*offset=*/0);
+        if (data == MAP_FAILED) {
+          return IoError("Failed to map a shared memory segment");
+        }
+        mapping = new ClientMapping(static_cast<char*>(data), size);
+        ClientMapping*& slot = connection->segments[segment_id];
+        if (slot != nullptr) slot->Unref();
+        slot = mapping;
+      } else {
+        auto it = connection->segments.find(segment_id);
+        if (it == connection->segments.end()) return MalformedMessage();
+        mapping = it->second;
+      }
+    }
+
+    result.components.clear();
+    result.element_index = element_index;
+    result.end_of_sequence = flags & 1;
+    result.skip = flags & 2;
+    uint64 num_components;
+    if (!core::GetVarint64(&response, &num_components)) {
+      return MalformedMessage();
+    }
+    if (num_components > 0 && mapping == nullptr) return MalformedMessage();
+    core::RefCountPtr<ElementLease> lease;
+    if (mapping != nullptr) {
+      lease.reset(
+          new ElementLease(mapping, segment_id, connection->released));
+    }
+    result.components.reserve(num_components);
+    for (uint64 i = 0; i < num_components; ++i) {
+      uint32 dtype, num_dims;
+      uint8 encoding;
+      uint64 offset, size;
+      if (!core::GetVarint32(&response, &dtype) ||
+          !GetByte(&response, &encoding) ||
+          !core::GetVarint64(&response, &offset) ||
+          !core::GetVarint64(&response, &size) ||
+          !core::GetVarint32(&response, &num_dims) ||
+          offset + size > mapping->size()) {
+        return MalformedMessage();
+      }
+      TensorShape shape;
+      for (uint32 d = 0; d < num_dims; ++d) {
+        uint64 dim;
+        if (!core::GetVarint64(&response, &dim)) return MalformedMessage();
+        TF_RETURN_IF_ERROR(shape.AddDimWithStatus(dim));
+      }
+      const char* data = mapping->data() + offset;
+      if (encoding == kProto) {
+        TensorProto proto;
+        Tensor tensor;
+        if (!proto.ParseFromArray(data, size) || !tensor.FromProto(proto)) {
+          return errors::DataLoss("Failed to parse component ", i,
+                                  " of a shared memory transfer element.");
+        }
+        result.components.push_back(std::move(tensor));
+      } else if (encoding == kRaw) {
+        const DataType type = static_cast<DataType>(dtype);
+        if (!DataTypeCanUseMemcpy(type) ||
+            size != shape.num_elements() * DataTypeSize(type)) {
+          return MalformedMessage();
+        }
+        if (size == 0) {
+          result.components.emplace_back(type, shape);
+          continue;
+        }
+        auto* buffer = new SharedMemoryTensorBuffer(lease.get(), data, size);
+        result.components.emplace_back(type, shape, buffer);
+        buffer->Unref();
+      } else {
+        return MalformedMessage();
+      }
+    }
+    return OkStatus();
+  }
+
+  const std::string worker_address_;
+
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::vector<std::unique_ptr<Connection>> connections_ TF_GUARDED_BY(mu_);
+  std::vector<Connection*> idle_connections_ TF_GUARDED_BY(mu_);
+};
+
+class SharedMemoryTransferClientRegistrar {
+ public:
+  SharedMemoryTransferClientRegistrar() {
+    DataTransferClient::Register(
+        kSharedMemoryTransferProtocol,
+        [](DataTransferClient::Config config,
+           std::unique_ptr<DataTransferClient>* out) {
+          auto client =
+              std::make_unique<SharedMemoryDataTransferClient>(config.address);
+          TF_RETURN_IF_ERROR(client->Initialize());
+          *out = std::move(client);
+          return OkStatus();
+        });
+  }
+};
+static SharedMemoryTransferClientRegistrar shared_memory_client_registrar;
+
+}  // namespace
+
+// Serves the requests of one client.
+class SharedMemoryDataTransferServer::Connection {
+ public:
+  Connection(int fd, const GetElementT& get_element)
+      : fd_(fd), get_element_(get_element) {
+    thread_.reset(Env::Default()->StartThread(
+        {}, "tf_data_shared_memory_transfer", [this]() { Serve(); }));
+  }
+
+  ~Connection() {
+    shutdown(fd_, SHUT_RDWR);
+    thread_.reset();
+    close(fd_);
+    for (auto& segment : segments_) {
+      munmap(segment.second.data, segment.second.size);
+      close(segment.second.fd);
+    }
+  }
+
+  bool done() const { return done_.load(); }
+
+  // Wakes up the serving thread if it waits for a request.
+  void Cancel() { shutdown(fd_, SHUT_RDWR); }
+
+ private:
+  struct Segment {
+    int fd = -1;
+    char* data = nullptr;
+    size_t size = 0;
+    bool sent = false;
+    bool in_use = false;
+  };
+
+  struct Layout {
+    uint8 encoding;
+    size_t offset;
+    size_t size;
+    std::string proto;
+  };
+
+  void Serve() {
+    std::unique_ptr<char[]> buffer(new char[kMaxMessageSize]);
+    while (true) {
+      StringPiece request;
+      int unused_fd;
+      Status s = ReceiveMessage(fd_, buffer.get(), &request, &unused_fd);
+      if (unused_fd >= 0) close(unused_fd);
+      if (s.ok()) {
+        s = HandleRequest(request);
+      }
+      if (!s.ok()) {
+        VLOG(2) << "Closing shared memory transfer connection: " << s;
+        break;
+      }
+    }
+    done_.store(true);
+  }
+
+  // Returns an error only if the connection can no longer be used. Errors from
+  // `get_element_` are sent to the client.
+  Status HandleRequest(StringPiece request) {
+    uint64 num_released;
+    if (!core::GetVarint64(&request, &num_released)) return MalformedMessage();
+    for (uint64 i = 0; i < num_released; ++i) {
+      uint64 id;
+      if (!core::GetVarint64(&request, &id)) return MalformedMessage();
+      auto it = segments_.find(id);
+      if (it == segments_.end() || !it->second.in_use) {
+        return MalformedMessage();
+      }
+      it->second.in_use = false;
+      free_segments_.push_back(id);
+    }
+    std::vector<uint64> retired;
+    while (free_segments_.size() > kMaxCachedSegments) {
+      const uint64 id = free_segments_.front();
+      free_segments_.pop_front();
+      Segment& segment = segments_[id];
+      munmap(segment.data, segment.size);
+      close(segment.fd);
+      segments_.erase(id);
+      retired.push_back(id);
+    }
+
+    GetElementRequest req;
+    if (!req.ParseFromArray(request.data(), request.size())) {
+      return MalformedMessage();
+    }
+    GetElementResult result;
+    Status s = get_element_(&req, &result);
+    std::string response;
+    if (!s.ok()) {
+      core::PutVarint32(&response, s.code());
+      PutLengthPrefixed(&response, StringPiece(s.error_message())
+                                       .substr(0, kMaxErrorMessageSize));
+      return SendMessage(fd_, response, /*fd_to_send=*/-1);
+    }
+
+    std::vector<Layout> layouts(result.components.size());
+    size_t total_size = 0;
+    for (int i = 0; i < result.components.size(); ++i) {
+      const Tensor& tensor = result.components[i];
+      Layout& layout = layouts[i];
+      if (DataTypeCanUseMemcpy(tensor.dtype())) {
+        layout.encoding = kRaw;
+        layout.size = tensor.TotalBytes();
+      } else {
+        TensorProto proto;
+        tensor.AsProtoTensorContent(&proto);
+        layout.encoding = kProto;
+        layout.proto = proto.SerializeAsString();
+        layout.size = layout.proto.size();
+      }
+      layout.offset = RoundUp(total_size, kComponentAlignment);
+      total_size = layout.offset + layout.size;
+    }
+
+    uint64 segment_id = 0;
+    Segment* segment = nullptr;
+    if (total_size > 0) {
+      TF_RETURN_IF_ERROR(AllocateSegment(total_size, &segment_id));
+      segment = &segments_[segment_id];
+      for (int i = 0; i < layouts.size(); ++i) {
+        char* dst = segment->data + layouts[i].offset;
+        if (layouts[i].encoding == kRaw) {
+          memcpy(dst, result.components[i].tensor_data().data(),
+                 layouts[i].size);
+        } else {
+          memcpy(dst, layouts[i].proto.data(), layouts[i].size);
+        }
+      }
+    }
+
+    core::PutVarint32(&response, error::OK);
+    response.push_back(static_cast<char>((result.end_of_sequence ? 1 : 0) |
+                                         (result.skip ? 2 : 0)));
+    core::PutVarint64(&response, result.element_index);
+    core::PutVarint64(&response, retired.size());
+    for (uint64 id : retired) {
+      core::PutVarint64(&response, id);
+    }
+    core::PutVarint64(&response, segment_id);
+    int fd_to_send = -1;
+    if (segment != nullptr) {
+      core::PutVarint64(&response, segment->size);
+      response.push_back(segment->sent ? 0 : 1);
+      if (!segment->sent) {
+        fd_to_send = segment->fd;
+        segment->sent = true;
+      }
+    }
+    core::PutVarint64(&response, layouts.size());
+    for (int i = 0; i < layouts.size(); ++i) {
+      const Tensor& tensor = result.components[i];
+      core::PutVarint32(&response, tensor.dtype());
+      response.push_back(static_cast<char>(layouts[i].encoding));
+      core::PutVarint64(&response, layouts[i].offset);
+      core::PutVarint64(&response, layouts[i].size);
+      core::PutVarint32(&response, tensor.dims());
+      for (int d = 0; d < tensor.dims(); ++d) {
+        core::PutVarint64(&response, tensor.dim_size(d));
+      }
+    }
+    if (response.size() > kMaxMessageSize) {
+      return errors::ResourceExhausted(
+          "Shared memory transfer response of ", response.size(),
+          " bytes exceeds the maximum of ", kMaxMessageSize, " bytes.");
+    }
+    return SendMessage(fd_, response, fd_to_send);
+  }
+
+  // Marks a segment of at least `size` bytes in use, preferring the smallest
+  // free segment that is not too large.
+  Status AllocateSegment(size_t size, uint64* id) {
+    auto best = free_segments_.end();
+    for (auto it = free_segments_.begin(); it != free_segments_.end(); ++it) {
+      const size_t segment_size = segments_[*it].size;
+      if (segment_size >= size &&
+          segment_size <= kMaxSegmentWaste * std::max(size, kMinSegmentSize) &&
+          (best == free_segments_.end() ||
+           segment_size < segments_[*best].size)) {
+        best = it;
+      }
+    }
+    if (best != free_segments_.end()) {
+      *id = *best;
+      free_segments_.erase(best);
+      segments_[*id].in_use = true;
+      return OkStatus();
+    }
+
+    Segment segment;
+    segment.size = RoundUp(size, kMinSegmentSize);
+    segment.fd = syscall(SYS_memfd_create, "tf_data_service_element",
+                         /*flags=*/1 /* MFD_CLOEXEC */);
+    if (segment.fd < 0) {
+      return IoError("Failed to create a shared memory segment");
+    }
+    if (ftruncate(segment.fd, segment.size) != 0) {
+      Status s = IoError("Failed to resize a shared memory segment");
+      close(segment.fd);
+      return s;
+    }
+    void* data = mmap(nullptr, segment.size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, segment.fd, /*offset=*/0);
+    if (data == MAP_FAILED) {
+      Status s = IoError("Failed to map a shared memory segment");
+      close(segment.fd);
+      return s;
+    }
+    segment.data = static_cast<char*>(data);
+    segment.in_use = true;
+    *id = next_segment_id_++;
+    segments_[*id] = segment;
+    return OkStatus();
+  }
+
+  const int fd_;
+  const GetElementT get_element_;
+  std::atomic<bool> done_{false};
+  // Only accessed by `thread_`.
+  absl::flat_hash_map<uint64, Segment> segments_;
+  std::deque<uint64> free_segments_;
+  uint64 next_segment_id_ = 1;
+  std::unique_ptr<Thread> thread_;
+};
+
+SharedMemoryDataTransferServer::SharedMemoryDataTransferServer(
+    const std::string& worker_address, GetElementT get_element)
+    : worker_address_(worker_address), get_element_(std::move(get_element)) {}
+
+SharedMemoryDataTransferServer::~SharedMemoryDataTransferServer() {
+  {
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (auto& connection : connections_) {
+      connection->Cancel();
+    }
+  }
+  if (listen_fd_ >= 0) {
+    // Wakes up `accept()` in `AcceptLoop()`.
+    shutdown(listen_fd_, SHUT_RDWR);
+  }
+  accept_thread_.reset();
+  connections_.clear();
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+  }
+}
+
+Status SharedMemoryDataTransferServer::Start() {
+  listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    return IoError("Failed to create a shared memory transfer socket");
+  }
+  sockaddr_un addr;
+  socklen_t addr_len;
+  FillSocketAddress(GetSocketName(worker_address_), &addr, &addr_len);
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0) {
+    return IoError(absl::StrCat(
+        "Failed to bind the shared memory transfer socket of worker ",
+        worker_address_));
+  }
+  if (listen(listen_fd_, SOMAXCONN) != 0) {
+    return IoError("Failed to listen on the shared memory transfer socket");
+  }
+  accept_thread_.reset(Env::Default()->StartThread(
+      {}, "tf_data_shared_memory_accept", [this]() { AcceptLoop(); }));
+  VLOG(1) << "Started shared memory transfer server for worker "
+          << worker_address_ << ".";
+  return OkStatus();
+}
+
+void SharedMemoryDataTransferServer::AcceptLoop() {
+  while (true) {
+    int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      mutex_lock l(mu_);
+      if (!cancelled_) {
+        LOG(ERROR) << "Shared memory transfer server of worker "
+                   << worker_address_ << " stopped accepting connections: "
+                   << strerror(errno);
+      }
+      return;
+    }
+    Status s = VerifyPeer(fd);
+    if (!s.ok()) {
+      LOG(WARNING) << "Rejected shared memory transfer connection: " << s;
+      close(fd);
+      continue;
+    }
+    mutex_lock l(mu_);
+    if (cancelled_) {
+      close(fd);
+      return;
+    }
+    connections_.erase(
+        std::remove_if(connections_.begin(), connections_.end(),
+                       [](const std::unique_ptr<Connection>& connection) {
+                         return connection->done();
+                       }),
+        connections_.end());
+    connections_.push_back(std::make_unique<Connection>(fd, get_element_));
+  }
+}
+
+#else  // defined(__linux__)
+
+class SharedMemoryDataTransferServer::Connection {};
+
+SharedMemoryDataTransferServer::SharedMemoryDataTransferServer(
+    const std::string& worker_address, GetElementT get_element)
+    : worker_address_(worker_address), get_element_(std::move(get_element)) {}
+
+SharedMemoryDataTransferServer::~SharedMemoryDataTransferServer() = default;
+
+Status SharedMemoryDataTransferServer::Start() {
+  return errors::Unimplemented(
+      "Shared memory transfer is only supported on Linux.");
+}
+
+void SharedMemoryDataTransferServer::AcceptLoop() {}
+
+#endif  // defined(__linux__)
+
+}  // namespace data
+}  // namespace tensorflow
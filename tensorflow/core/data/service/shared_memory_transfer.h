@@ -0,0 +1,85 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+
+// Transfers elements from a tf.data service worker to the clients on the same
+// host through shared memory instead of gRPC.
+//
+// The worker listens on an abstract Unix socket named after its address, so
+// only clients in the same network namespace, running as the same user, can
+// connect. For each element, the worker copies the tensor contents into a
+// shared memory segment, and sends the layout of the element over the socket,
+// along with the file descriptor of the segment the first time it is used. The
+// client constructs tensors that point into its mapping of the segment, and
+// returns the segment to the worker with its next request once these tensors
+// are destroyed. Tensors whose type cannot be copied with memcpy are stored as
+// serialized `TensorProto`s.
+//
+// The protocol is only available on Linux.
+constexpr const char kSharedMemoryTransferProtocol[] = "shared_memory";
+
+// Returns true if workers should serve, and clients should prefer, the shared
+// memory transfer protocol. This is the default on Linux, and can be disabled
+// by setting the environment variable TF_DATA_SERVICE_SHARED_MEMORY_TRANSFER
+// to false.
+bool SharedMemoryTransferEnabled();
+
+// Serves elements to the clients on the same host of the worker at
+// `worker_address`. `DataTransferClient::Build()` with
+// `kSharedMemoryTransferProtocol` and the same address connects to it.
+class SharedMemoryDataTransferServer : public DataTransferServer {
+ public:
+  SharedMemoryDataTransferServer(const std::string& worker_address,
+                                 GetElementT get_element);
+  ~SharedMemoryDataTransferServer() override;
+
+  Status Start() override;
+
+  // The server listens on a Unix socket rather than on a port.
+  int get_port() override { return 0; }
+
+ private:
+  class Connection;
+
+  void AcceptLoop();
+
+  const std::string worker_address_;
+  const GetElementT get_element_;
+  int listen_fd_ = -1;
+
+  mutex mu_;
+  bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  std::vector<std::unique_ptr<Connection>> connections_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<Thread> accept_thread_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_SHARED_MEMORY_TRANSFER_H_
@@ -0,0 +1,160 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/data/service/data_transfer.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+#if defined(__linux__)
+
+// Returns the element `{[task_id, task_id + 1, task_id + 2], "element"}`, ends
+// the sequence for task 100, and fails for task 200.
+Status GetTestElement(const GetElementRequest* request,
+                      GetElementResult* result) {
+  if (request->task_id() == 100) {
+    result->end_of_sequence = true;
+    return OkStatus();
+  }
+  if (request->task_id() == 200) {
+    return errors::NotFound("No task 200.");
+  }
+  const float value = request->task_id();
+  result->components.push_back(
+      test::AsTensor<float>({value, value + 1, value + 2}, {3}));
+  result->components.push_back(test::AsScalar<tstring>("element"));
+  result->element_index = request->task_id();
+  return OkStatus();
+}
+
+class SharedMemoryTransferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    address_ = absl::StrCat(
+        "localhost:",
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    server_ = std::make_unique<SharedMemoryDataTransferServer>(address_,
+                                                               GetTestElement);
+    TF_ASSERT_OK(server_->Start());
+    TF_ASSERT_OK(DataTransferClient::Build(
+        kSharedMemoryTransferProtocol, {/*protocol=*/"grpc", address_},
+        &client_));
+  }
+
+  Status GetElement(int64_t task_id, GetElementResult& result) {
+    GetElementRequest request;
+    request.set_task_id(task_id);
+    return client_->GetElement(request, result);
+  }
+
+  std::string address_;
+  std::unique_ptr<SharedMemoryDataTransferServer> server_;
+  std::unique_ptr<DataTransferClient> client_;
+};
+
+TEST_F(SharedMemoryTransferTest, GetElements) {
+  for (int64_t task_id = 0; task_id < 10; ++task_id) {
+    GetElementResult result;
+    TF_ASSERT_OK(GetElement(task_id, result));
+    EXPECT_FALSE(result.end_of_sequence);
+    EXPECT_EQ(result.element_index, task_id);
+    ASSERT_EQ(result.components.size(), 2);
+    test::ExpectEqual(result.components[0],
+                      test::AsTensor<float>(
+                          {1.0f * task_id, task_id + 1.0f, task_id + 2.0f}));
+    test::ExpectEqual(result.components[1],
+                      test::AsScalar<tstring>("element"));
+  }
+}
+
+TEST_F(SharedMemoryTransferTest, EndOfSequence) {
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(100, result));
+  EXPECT_TRUE(result.end_of_sequence);
+  EXPECT_TRUE(result.components.empty());
+}
+
+TEST_F(SharedMemoryTransferTest, PropagatesErrors) {
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsNotFound(GetElement(200, result)));
+  // The connection remains usable.
+  TF_ASSERT_OK(GetElement(1, result));
+  EXPECT_EQ(result.element_index, 1);
+}
+
+TEST_F(SharedMemoryTransferTest, ReusesReleasedSegments) {
+  const char* data;
+  {
+    GetElementResult result;
+    TF_ASSERT_OK(GetElement(1, result));
+    data = result.components[0].tensor_data().data();
+  }
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(2, result));
+  EXPECT_EQ(result.components[0].tensor_data().data(), data);
+
+  // A segment is not reused while the element is alive.
+  GetElementResult other_result;
+  TF_ASSERT_OK(GetElement(3, other_result));
+  EXPECT_NE(other_result.components[0].tensor_data().data(), data);
+  test::ExpectEqual(result.components[0],
+                    test::AsTensor<float>({2.0f, 3.0f, 4.0f}));
+}
+
+TEST_F(SharedMemoryTransferTest, ElementsOutliveClientAndServer) {
+  GetElementResult result;
+  TF_ASSERT_OK(GetElement(5, result));
+  client_.reset();
+  server_.reset();
+  test::ExpectEqual(result.components[0],
+                    test::AsTensor<float>({5.0f, 6.0f, 7.0f}));
+}
+
+TEST_F(SharedMemoryTransferTest, Cancel) {
+  client_->TryCancel();
+  GetElementResult result;
+  EXPECT_TRUE(errors::IsCancelled(GetElement(1, result)));
+}
+
+TEST(SharedMemoryTransferClientTest, FailsWithoutServer) {
+  std::unique_ptr<DataTransferClient> client;
+  EXPECT_FALSE(DataTransferClient::Build(kSharedMemoryTransferProtocol,
+                                         {/*protocol=*/"grpc",
+                                          "localhost:no_server"},
+                                         &client)
+                   .ok());
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -16,11 +16,15 @@ limitations under the License.
 
 #include <algorithm>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/data/dataset.pb.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/logging_utils.h"
 #include "tensorflow/core/data/service/thread_safe_buffer.h"
@@ -28,7 +32,9 @@ limitations under the License.
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
@@ -45,6 +51,9 @@ namespace {
 constexpr int64_t kWaitBeforeSkipUs = 100 * 1000;  // 100ms.
 constexpr size_t kDefaultCrossTrainerCacheSizeBytes =
     10 * (size_t{1} << 30);  // 10GB
+// Default size of the cross-trainer cache spill tier, relative to the size of
+// the cache.
+constexpr size_t kDefaultCrossTrainerCacheSpillSizeMultiplier = 4;
 
 }  // namespace
 
@@ -84,8 +93,19 @@ Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
         worker_config.cross_trainer_cache_size_bytes() > 0
             ? worker_config.cross_trainer_cache_size_bytes()
             : kDefaultCrossTrainerCacheSizeBytes;
-    out = std::make_unique<CachingTaskRunner>(std::move(iterator),
-                                              max_cache_size_bytes);
+    std::unique_ptr<CrossTrainerCacheSpill> spill;
+    if (!worker_config.cross_trainer_cache_spill_dir().empty()) {
+      const size_t max_spill_size_bytes =
+          worker_config.cross_trainer_cache_spill_size_bytes() > 0
+              ? worker_config.cross_trainer_cache_spill_size_bytes()
+              : kDefaultCrossTrainerCacheSpillSizeMultiplier *
+                    max_cache_size_bytes;
+      spill = std::make_unique<CrossTrainerCacheSpill>(
+          Env::Default(), worker_config.cross_trainer_cache_spill_dir(),
+          max_spill_size_bytes);
+    }
+    out = std::make_unique<CachingTaskRunner>(
+        std::move(iterator), max_cache_size_bytes, std::move(spill));
   } else {
     out = std::make_unique<FirstComeFirstServedTaskRunner>(std::move(iterator));
   }
@@ -153,11 +173,13 @@ void FirstComeFirstServedTaskRunner::Cancel() {
   buffer_.Cancel(errors::Cancelled("tf.data service FCFS task is cancelled."));
 }
 
-CachingTaskRunner::CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                                     size_t max_cache_size_bytes)
+CachingTaskRunner::CachingTaskRunner(
+    std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+    std::unique_ptr<CrossTrainerCacheSpill> spill)
     : fcfs_task_runner_(std::move(iterator)),
       cache_(max_cache_size_bytes,
-             std::make_unique<GetElementResultSequence>(fcfs_task_runner_)) {
+             std::make_unique<GetElementResultSequence>(fcfs_task_runner_),
+             std::move(spill)) {
   LOG(INFO) << "Initialized tf.data service cross-trainer cache with "
             << FormatBytes(max_cache_size_bytes) << " of memory.";
 }
@@ -193,6 +215,69 @@ size_t CachingTaskRunner::GetElementResultSequence::GetElementSizeBytes(
   return element.EstimatedMemoryUsageBytes();
 }
 
+Status CachingTaskRunner::GetElementResultSequence::SerializeElement(
+    const GetElementResult& element, std::string& output) const {
+  GetElementResponse response;
+  response.set_element_index(element.element_index);
+  const std::vector<Tensor>& components = element.components;
+  if (components.size() == 1 && components[0].dtype() == DT_VARIANT &&
+      TensorShapeUtils::IsScalar(components[0].shape())) {
+    const CompressedElement* compressed =
+        components[0].scalar<Variant>()().get<CompressedElement>();
+    if (compressed == nullptr) {
+      return errors::Unimplemented(
+          "Spilling the cross-trainer cache requires elements to be "
+          "CompressedElement variants or non-variant tensors, but got ",
+          components[0].scalar<Variant>()().TypeName());
+    }
+    *response.mutable_compressed() = *compressed;
+  } else {
+    UncompressedElement* uncompressed = response.mutable_uncompressed();
+    for (const Tensor& component : components) {
+      component.AsProtoTensorContent(uncompressed->add_components());
+    }
+  }
+  if (!response.SerializeToString(&output)) {
+    return errors::Internal("Failed to serialize element ",
+                            element.element_index,
+                            " of the cross-trainer cache.");
+  }
+  return OkStatus();
+}
+
+StatusOr<GetElementResult>
+CachingTaskRunner::GetElementResultSequence::DeserializeElement(
+    absl::string_view data) const {
+  GetElementResponse response;
+  if (!response.ParseFromArray(data.data(), data.size())) {
+    return errors::DataLoss("Failed to parse a spilled element of the "
+                            "cross-trainer cache.");
+  }
+  GetElementResult result;
+  result.element_index = response.element_index();
+  switch (response.element_case()) {
+    case GetElementResponse::kCompressed: {
+      Tensor tensor(DT_VARIANT, TensorShape{});
+      tensor.scalar<Variant>()() = std::move(*response.mutable_compressed());
+      result.components.push_back(std::move(tensor));
+      break;
+    }
+    case GetElementResponse::kUncompressed:
+      for (const TensorProto& proto : response.uncompressed().components()) {
+        Tensor tensor;
+        if (!tensor.FromProto(proto)) {
+          return errors::DataLoss("Failed to parse a spilled tensor of the "
+                                  "cross-trainer cache.");
+        }
+        result.components.push_back(std::move(tensor));
+      }
+      break;
+    case GetElementResponse::ELEMENT_NOT_SET:
+      break;
+  }
+  return result;
+}
+
 void CachingTaskRunner::Cancel() {
   VLOG(2) << "Cancelling tf.data service cross-trainer cache task.";
   if (!cache_.IsCancelled()) {
@@ -16,10 +16,13 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERVICE_TASK_RUNNER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/cross_trainer_cache.h"
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/thread_safe_buffer.h"
 #include "tensorflow/core/data/service/worker.pb.h"
@@ -122,8 +125,10 @@ class FirstComeFirstServedTaskRunner : public TaskRunner {
 // read the full dataset.
 class CachingTaskRunner : public TaskRunner {
  public:
-  explicit CachingTaskRunner(std::unique_ptr<TaskIterator> iterator,
-                             size_t max_cache_size_bytes);
+  // If `spill` is not null, elements evicted from the cache are spilled to it.
+  explicit CachingTaskRunner(
+      std::unique_ptr<TaskIterator> iterator, size_t max_cache_size_bytes,
+      std::unique_ptr<CrossTrainerCacheSpill> spill = nullptr);
   ~CachingTaskRunner() override;
 
   // Gets the next element from the cross-trainer cache, blocking if the data is
@@ -146,6 +151,11 @@ class CachingTaskRunner : public TaskRunner {
         FirstComeFirstServedTaskRunner& fcfs_task_runner);
     StatusOr<GetElementResult> GetNext() override;
     size_t GetElementSizeBytes(const GetElementResult& element) const override;
+    // Elements are spilled as serialized `GetElementResponse`s.
+    Status SerializeElement(const GetElementResult& element,
+                            std::string& output) const override;
+    StatusOr<GetElementResult> DeserializeElement(
+        absl::string_view data) const override;
 
    private:
     FirstComeFirstServedTaskRunner& fcfs_task_runner_;
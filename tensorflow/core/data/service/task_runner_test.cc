@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "tensorflow/core/data/dataset.pb.h"
+#include "tensorflow/core/data/service/cross_trainer_cache_spill.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -32,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/statusor.h"
@@ -356,6 +358,29 @@ TEST(CachingTaskRunnerTest, SlowClientSkipsData) {
   EXPECT_THAT(slow_trainer_output[0], Gt(0));
 }
 
+TEST(CachingTaskRunnerTest, SlowClientReadsSpilledData) {
+  size_t range = 1000;
+  CachingTaskRunner runner(
+      std::make_unique<InfiniteRangeIterator>(),
+      /*max_cache_size_bytes=*/kSmallCache,
+      std::make_unique<CrossTrainerCacheSpill>(
+          Env::Default(), io::JoinPath(testing::TmpDir(), "spill"),
+          /*max_size_bytes=*/kLargeCache));
+
+  GetElementRequest request;
+  request.set_trainer_id("Fast trainer");
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> fast_trainer_output,
+      GetElementsFromTaskRunner<int64_t>(runner, request, range));
+  EXPECT_THAT(fast_trainer_output, ElementsAreArray(GetRange(range)));
+
+  request.set_trainer_id("Slow trainer");
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<int64_t> slow_trainer_output,
+      GetElementsFromTaskRunner<int64_t>(runner, request, range));
+  EXPECT_THAT(slow_trainer_output, ElementsAreArray(GetRange(range)));
+}
+
 TEST(CachingTaskRunnerTest, ConcurrentTrainers) {
   size_t range = 100;
   size_t num_readers = 10;
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/credentials_factory.h"
 #include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/grpc_util.h"
+#include "tensorflow/core/data/service/shared_memory_transfer.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
 #include "tensorflow/core/data/service/worker.pb.h"
 #include "tensorflow/core/data/service/worker_impl.h"
@@ -71,8 +72,20 @@ Status DataServiceWorkerClient::EnsureInitialized() {
   if (client_) {
     return OkStatus();
   }
+  std::string transfer_protocol = GetDataTransferProtocol();
+  if (transfer_protocol == kGrpcTransferProtocol &&
+      SharedMemoryTransferEnabled()) {
+    // Connecting only succeeds if the worker runs on the same host.
+    Status s = DataTransferClient::Build(kSharedMemoryTransferProtocol,
+                                         {protocol_, address_}, &client_);
+    if (s.ok()) {
+      return OkStatus();
+    }
+    VLOG(2) << "Not using shared memory transfer for worker " << address_
+            << ": " << s;
+  }
   TF_RETURN_IF_ERROR(DataTransferClient::Build(
-      GetDataTransferProtocol(), {protocol_, address_}, &client_));
+      transfer_protocol, {protocol_, address_}, &client_));
   return OkStatus();
 }
 
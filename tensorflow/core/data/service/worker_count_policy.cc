@@ -0,0 +1,161 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_count_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/data/service/dispatcher.pb.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+// Weight of the latest report in the moving averages.
+constexpr double kSmoothingFactor = 0.3;
+// Maximum scale-up factor of a single recommendation.
+constexpr double kMaxScaleUpFactor = 10.0;
+// Tolerance for rounding errors when counting workers.
+constexpr double kEpsilon = 1e-6;
+
+double Smooth(double average, double value) {
+  return kSmoothingFactor * value + (1 - kSmoothingFactor) * average;
+}
+
+}  // namespace
+
+DefaultWorkerCountPolicy::DefaultWorkerCountPolicy(
+    double max_stall_fraction, double target_cpu_utilization)
+    : max_stall_fraction_(max_stall_fraction),
+      target_cpu_utilization_(target_cpu_utilization) {}
+
+int64_t DefaultWorkerCountPolicy::RecommendWorkerCount(
+    const IterationLoad& load) const {
+  const int64_t num_workers = load.num_workers();
+  if (num_workers == 0) {
+    // The iteration is waiting for its first worker.
+    return load.stall_fraction() > max_stall_fraction_ ? 1 : 0;
+  }
+  if (load.stall_fraction() > max_stall_fraction_) {
+    const double scale_up_factor =
+        load.stall_fraction() >= 1
+            ? kMaxScaleUpFactor
+            : std::min(1 / (1 - load.stall_fraction()), kMaxScaleUpFactor);
+    const int64_t needed = std::ceil(num_workers * scale_up_factor - kEpsilon);
+    return std::max(num_workers + 1, needed);
+  }
+  if (load.worker_cpu_utilization() < 0) {
+    return num_workers;
+  }
+  const int64_t needed =
+      std::ceil(num_workers * load.worker_cpu_utilization() /
+                    target_cpu_utilization_ -
+                kEpsilon);
+  return std::clamp<int64_t>(needed, 1, num_workers);
+}
+
+void IterationLoadTracker::RecordClientMetrics(
+    int64_t iteration_client_id, int64_t iteration_id,
+    const ClientConsumptionMetrics& metrics) {
+  if (metrics.elapsed_time_us() <= 0) {
+    return;
+  }
+  const double stall_fraction = std::clamp(
+      static_cast<double>(metrics.stall_time_us()) / metrics.elapsed_time_us(),
+      0.0, 1.0);
+  auto [it, inserted] = client_loads_.try_emplace(iteration_client_id);
+  ClientLoad& load = it->second;
+  load.iteration_id = iteration_id;
+  load.stall_fraction =
+      inserted ? stall_fraction : Smooth(load.stall_fraction, stall_fraction);
+  if (metrics.num_get_element_requests() > 0) {
+    const double latency_us =
+        static_cast<double>(metrics.total_get_element_latency_us()) /
+        metrics.num_get_element_requests();
+    load.get_element_latency_us =
+        load.get_element_latency_us < 0
+            ? latency_us
+            : Smooth(load.get_element_latency_us, latency_us);
+  }
+}
+
+void IterationLoadTracker::RecordWorkerCpuUtilization(
+    const std::string& worker_address, double cpu_utilization) {
+  if (cpu_utilization < 0) {
+    return;
+  }
+  auto [it, inserted] =
+      worker_cpu_utilization_.try_emplace(worker_address, cpu_utilization);
+  if (!inserted) {
+    it->second = Smooth(it->second, cpu_utilization);
+  }
+}
+
+void IterationLoadTracker::RemoveClient(int64_t iteration_client_id) {
+  client_loads_.erase(iteration_client_id);
+}
+
+bool IterationLoadTracker::HasClientMetrics(int64_t iteration_id) const {
+  return std::any_of(client_loads_.begin(), client_loads_.end(),
+                     [iteration_id](const auto& client_load) {
+                       return client_load.second.iteration_id == iteration_id;
+                     });
+}
+
+IterationLoad IterationLoadTracker::GetIterationLoad(
+    int64_t iteration_id,
+    const std::vector<std::string>& worker_addresses) const {
+  IterationLoad load;
+  load.set_iteration_id(iteration_id);
+  load.set_num_workers(worker_addresses.size());
+
+  // Synchronous training proceeds at the pace of the most starved client.
+  double latency_sum = 0.0;
+  int64_t num_latencies = 0;
+  for (const auto& [client_id, client_load] : client_loads_) {
+    if (client_load.iteration_id != iteration_id) {
+      continue;
+    }
+    load.set_stall_fraction(
+        std::max(load.stall_fraction(), client_load.stall_fraction));
+    if (client_load.get_element_latency_us >= 0) {
+      latency_sum += client_load.get_element_latency_us;
+      ++num_latencies;
+    }
+  }
+  if (num_latencies > 0) {
+    load.set_get_element_latency_us(latency_sum / num_latencies);
+  }
+
+  double cpu_utilization_sum = 0.0;
+  int64_t num_cpu_utilizations = 0;
+  for (const std::string& worker_address : worker_addresses) {
+    auto it = worker_cpu_utilization_.find(worker_address);
+    if (it != worker_cpu_utilization_.end()) {
+      cpu_utilization_sum += it->second;
+      ++num_cpu_utilizations;
+    }
+  }
+  load.set_worker_cpu_utilization(
+      num_cpu_utilizations > 0 ? cpu_utilization_sum / num_cpu_utilizations
+                               : -1.0);
+  return load;
+}
+
+}  // namespace data
+}  // namespace tensorflow
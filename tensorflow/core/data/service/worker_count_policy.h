@@ -0,0 +1,107 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_COUNT_POLICY_H_
+#define TENSORFLOW_CORE_DATA_SERVICE_WORKER_COUNT_POLICY_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/data/service/dispatcher.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// Computes the number of workers an iteration needs from its load. The
+// dispatcher uses it to answer `GetWorkerCountRecommendation` requests.
+class WorkerCountPolicy {
+ public:
+  virtual ~WorkerCountPolicy() = default;
+
+  // Returns the number of workers `load` needs.
+  virtual int64_t RecommendWorkerCount(const IterationLoad& load) const = 0;
+};
+
+// Scales up when clients stall, and scales down when clients do not stall and
+// workers are underutilized.
+//
+// If the clients spend more than `max_stall_fraction` of their time waiting for
+// data, they would consume 1 / (1 - stall_fraction) times faster with enough
+// workers, so the current number of workers is multiplied by this factor, up to
+// 10.
+// Otherwise, the number of workers is reduced so that the remaining workers
+// reach `target_cpu_utilization`.
+class DefaultWorkerCountPolicy : public WorkerCountPolicy {
+ public:
+  static constexpr double kDefaultMaxStallFraction = 0.05;
+  static constexpr double kDefaultTargetCpuUtilization = 0.8;
+
+  explicit DefaultWorkerCountPolicy(
+      double max_stall_fraction = kDefaultMaxStallFraction,
+      double target_cpu_utilization = kDefaultTargetCpuUtilization);
+
+  int64_t RecommendWorkerCount(const IterationLoad& load) const override;
+
+ private:
+  const double max_stall_fraction_;
+  const double target_cpu_utilization_;
+};
+
+// Aggregates the consumption metrics reported by clients and the CPU
+// utilization reported by workers into `IterationLoad`s. Reports are smoothed
+// with an exponential moving average.
+//
+// This class is thread-compatible.
+class IterationLoadTracker {
+ public:
+  // Records metrics reported by client `iteration_client_id` of iteration
+  // `iteration_id`.
+  void RecordClientMetrics(int64_t iteration_client_id, int64_t iteration_id,
+                           const ClientConsumptionMetrics& metrics);
+
+  // Records the CPU utilization reported by a worker. Negative values are
+  // ignored.
+  void RecordWorkerCpuUtilization(const std::string& worker_address,
+                                  double cpu_utilization);
+
+  // Forgets the metrics of `iteration_client_id`.
+  void RemoveClient(int64_t iteration_client_id);
+
+  // Returns true if a client of `iteration_id` has reported metrics.
+  bool HasClientMetrics(int64_t iteration_id) const;
+
+  // Returns the load of `iteration_id`, which has tasks on `worker_addresses`.
+  // `recommended_num_workers` is not set.
+  IterationLoad GetIterationLoad(
+      int64_t iteration_id,
+      const std::vector<std::string>& worker_addresses) const;
+
+ private:
+  struct ClientLoad {
+    int64_t iteration_id = 0;
+    double stall_fraction = 0.0;
+    // Negative until the client reports a GetElement request.
+    double get_element_latency_us = -1.0;
+  };
+
+  absl::flat_hash_map<int64_t, ClientLoad> client_loads_;
+  absl::flat_hash_map<std::string, double> worker_cpu_utilization_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SERVICE_WORKER_COUNT_POLICY_H_
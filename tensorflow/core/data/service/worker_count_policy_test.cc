@@ -0,0 +1,120 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/service/worker_count_policy.h"
+
+#include "tensorflow/core/data/service/dispatcher.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+IterationLoad CreateLoad(int64_t num_workers, double stall_fraction,
+                         double worker_cpu_utilization) {
+  IterationLoad load;
+  load.set_num_workers(num_workers);
+  load.set_stall_fraction(stall_fraction);
+  load.set_worker_cpu_utilization(worker_cpu_utilization);
+  return load;
+}
+
+ClientConsumptionMetrics CreateMetrics(int64_t elapsed_time_us,
+                                       int64_t stall_time_us,
+                                       int64_t num_get_element_requests = 0,
+                                       int64_t total_latency_us = 0) {
+  ClientConsumptionMetrics metrics;
+  metrics.set_elapsed_time_us(elapsed_time_us);
+  metrics.set_stall_time_us(stall_time_us);
+  metrics.set_num_get_element_requests(num_get_element_requests);
+  metrics.set_total_get_element_latency_us(total_latency_us);
+  return metrics;
+}
+
+TEST(DefaultWorkerCountPolicyTest, ScalesUpWhenClientsStall) {
+  DefaultWorkerCountPolicy policy;
+  // Clients wait half of the time, so they need twice as many workers.
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.5, 1.0)), 20);
+  // Scales up by at least one worker.
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.06, 1.0)), 11);
+  // Scales up by at most 10x.
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 1.0, 1.0)), 100);
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(0, 1.0, -1.0)), 1);
+}
+
+TEST(DefaultWorkerCountPolicyTest, ScalesDownWhenWorkersAreUnderutilized) {
+  DefaultWorkerCountPolicy policy;
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.0, 0.4)), 5);
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.01, 0.01)), 1);
+  // Does not scale up because of the CPU utilization alone.
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.0, 1.0)), 10);
+  // Keeps the workers if the CPU utilization is unknown.
+  EXPECT_EQ(policy.RecommendWorkerCount(CreateLoad(10, 0.0, -1.0)), 10);
+}
+
+TEST(IterationLoadTrackerTest, AggregatesClients) {
+  IterationLoadTracker tracker;
+  EXPECT_FALSE(tracker.HasClientMetrics(/*iteration_id=*/1));
+  tracker.RecordClientMetrics(/*iteration_client_id=*/10, /*iteration_id=*/1,
+                              CreateMetrics(1000, 100, 10, 5000));
+  tracker.RecordClientMetrics(/*iteration_client_id=*/11, /*iteration_id=*/1,
+                              CreateMetrics(1000, 500, 10, 1000));
+  tracker.RecordClientMetrics(/*iteration_client_id=*/12, /*iteration_id=*/2,
+                              CreateMetrics(1000, 1000));
+  EXPECT_TRUE(tracker.HasClientMetrics(/*iteration_id=*/1));
+
+  IterationLoad load =
+      tracker.GetIterationLoad(/*iteration_id=*/1, {"worker_0", "worker_1"});
+  EXPECT_EQ(load.iteration_id(), 1);
+  EXPECT_EQ(load.num_workers(), 2);
+  EXPECT_DOUBLE_EQ(load.stall_fraction(), 0.5);
+  EXPECT_DOUBLE_EQ(load.get_element_latency_us(), 300);
+  EXPECT_LT(load.worker_cpu_utilization(), 0);
+
+  tracker.RemoveClient(/*iteration_client_id=*/11);
+  load = tracker.GetIterationLoad(/*iteration_id=*/1, {"worker_0"});
+  EXPECT_DOUBLE_EQ(load.stall_fraction(), 0.1);
+  EXPECT_DOUBLE_EQ(load.get_element_latency_us(), 500);
+}
+
+TEST(IterationLoadTrackerTest, SmoothsReports) {
+  IterationLoadTracker tracker;
+  tracker.RecordClientMetrics(/*iteration_client_id=*/10, /*iteration_id=*/1,
+                              CreateMetrics(1000, 0));
+  tracker.RecordClientMetrics(/*iteration_client_id=*/10, /*iteration_id=*/1,
+                              CreateMetrics(1000, 1000));
+  IterationLoad load = tracker.GetIterationLoad(/*iteration_id=*/1, {});
+  EXPECT_GT(load.stall_fraction(), 0.0);
+  EXPECT_LT(load.stall_fraction(), 1.0);
+
+  // Reports without elapsed time are ignored.
+  tracker.RecordClientMetrics(/*iteration_client_id=*/13, /*iteration_id=*/3,
+                              CreateMetrics(0, 0));
+  EXPECT_FALSE(tracker.HasClientMetrics(/*iteration_id=*/3));
+}
+
+TEST(IterationLoadTrackerTest, WorkerCpuUtilization) {
+  IterationLoadTracker tracker;
+  tracker.RecordWorkerCpuUtilization("worker_0", 0.2);
+  tracker.RecordWorkerCpuUtilization("worker_1", 0.6);
+  tracker.RecordWorkerCpuUtilization("worker_2", -1.0);
+  IterationLoad load = tracker.GetIterationLoad(
+      /*iteration_id=*/1, {"worker_0", "worker_1", "worker_2"});
+  EXPECT_EQ(load.num_workers(), 3);
+  EXPECT_DOUBLE_EQ(load.worker_cpu_utilization(), 0.4);
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
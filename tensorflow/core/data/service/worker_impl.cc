@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/data/service/worker_impl.h"
 
+#include <algorithm>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <utility>
@@ -51,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/zlib_outputbuffer.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/host_info.h"
@@ -515,11 +518,13 @@ void DataServiceWorkerImpl::HeartbeatThread() TF_LOCKS_EXCLUDED(mu_) {
 
 Status DataServiceWorkerImpl::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
   std::vector<int64_t> current_tasks;
+  double cpu_utilization;
   {
     mutex_lock l(mu_);
     for (const auto& task : tasks_) {
       current_tasks.push_back(task.first);
     }
+    cpu_utilization = CpuUtilization();
   }
   WorkerHeartbeatRequest request;
   request.set_worker_address(worker_address_);
@@ -528,6 +533,7 @@ Status DataServiceWorkerImpl::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
   request.set_worker_uid(worker_uid_);
   *request.mutable_current_tasks() = {current_tasks.begin(),
                                       current_tasks.end()};
+  request.set_cpu_utilization(cpu_utilization);
   TF_ASSIGN_OR_RETURN(WorkerHeartbeatResponse response,
                       dispatcher_->WorkerHeartbeat(request));
 
@@ -563,6 +569,28 @@ Status DataServiceWorkerImpl::Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
   return OkStatus();
 }
 
+double DataServiceWorkerImpl::CpuUtilization()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // `std::clock` measures the CPU time of all threads of the process, which
+  // includes the trainer when the worker runs in the same process.
+  const int64_t wall_time_us = Env::Default()->NowMicros();
+  const std::clock_t cpu_time = std::clock();
+  const int64_t elapsed_us = wall_time_us - last_cpu_utilization_wall_time_us_;
+  const bool known = last_cpu_utilization_wall_time_us_ >= 0 &&
+                     cpu_time != static_cast<std::clock_t>(-1) &&
+                     elapsed_us > 0;
+  const double cpu_time_us =
+      static_cast<double>(cpu_time - last_cpu_utilization_cpu_time_) * 1e6 /
+      CLOCKS_PER_SEC;
+  last_cpu_utilization_wall_time_us_ = wall_time_us;
+  last_cpu_utilization_cpu_time_ = cpu_time;
+  if (!known) {
+    return -1.0;
+  }
+  return std::min(
+      cpu_time_us / (elapsed_us * port::NumSchedulableCPUs()), 1.0);
+}
+
 void DataServiceWorkerImpl::DeleteLocalTask(const TaskInfo& task_info)
     TF_LOCKS_EXCLUDED(mu_) {
   std::shared_ptr<Task> task;
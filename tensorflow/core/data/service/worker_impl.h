@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_WORKER_IMPL_H_
 
+#include <ctime>
 #include <memory>
 #include <string>
 #include <utility>
@@ -113,6 +114,9 @@ class DataServiceWorkerImpl {
   void HeartbeatThread() TF_LOCKS_EXCLUDED(mu_);
   // Performs a heartbeat to the dispatcher.
   Status Heartbeat() TF_LOCKS_EXCLUDED(mu_);
+  // Returns the fraction of the host's CPU capacity used by this process since
+  // the previous call, or a negative value on the first call or if unknown.
+  double CpuUtilization() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Gets the DatasetDef for `task_def`.
   StatusOr<DatasetDef> GetDatasetDef(const TaskDef& task_def) const;
   // Creates a dataset from `dataset_def`.
@@ -146,6 +150,9 @@ class DataServiceWorkerImpl {
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
   // Whether the worker has registered with the dispatcher yet.
   bool registered_ TF_GUARDED_BY(mu_) = false;
+  // Wall time and process CPU time of the previous `CpuUtilization` call.
+  int64_t last_cpu_utilization_wall_time_us_ TF_GUARDED_BY(mu_) = -1;
+  std::clock_t last_cpu_utilization_cpu_time_ TF_GUARDED_BY(mu_) = 0;
   condition_variable task_completion_cv_ TF_GUARDED_BY(mu_);
   condition_variable heartbeat_cv_ TF_GUARDED_BY(mu_);
   CancellationManager cancellation_manager_;
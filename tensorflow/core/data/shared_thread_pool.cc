@@ -0,0 +1,103 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/data/shared_thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
+#include "tensorflow/core/platform/resource.h"
+
+namespace tensorflow {
+namespace data {
+
+SharedThreadPool::SharedThreadPool(Env* env, const std::string& name,
+                                   const Options& options) {
+  num_threads_ = options.num_threads > 0 ? options.num_threads
+                                         : port::NumSchedulableCPUs();
+  int num_partitions = 1;
+  if (options.numa_partitioned && port::NUMAEnabled()) {
+    num_partitions = std::max(1, std::min(port::NUMANumNodes(), num_threads_));
+  }
+  int offset = 0;
+  for (int i = 0; i < num_partitions; ++i) {
+    // Spread the threads as evenly as possible over the partitions.
+    const int partition_size =
+        num_threads_ / num_partitions + (i < num_threads_ % num_partitions);
+    ThreadOptions thread_options;
+    if (num_partitions > 1) {
+      thread_options.numa_node = i;
+    }
+    partition_offsets_.push_back(offset);
+    offset += partition_size;
+    partitions_.push_back(std::make_unique<thread::ThreadPool>(
+        env, thread_options, name, partition_size,
+        /*low_latency_hint=*/false));
+  }
+  VLOG(1) << "Created tf.data shared thread pool with " << num_threads_
+          << " threads in " << num_partitions << " partition(s)";
+}
+
+// static
+SharedThreadPool* SharedThreadPool::Get() {
+  static SharedThreadPool* pool = []() {
+    Options options;
+    options.numa_partitioned =
+        GetExperiments().contains("numa_shared_threadpool");
+    return new SharedThreadPool(Env::Default(), "tf_data_shared", options);
+  }();
+  return pool;
+}
+
+void SharedThreadPool::Schedule(std::function<void()> fn) {
+  auto tagged_fn = [fn = std::move(fn)]() {
+    tensorflow::ResourceTagger tag(kTFDataResourceTag, "SharedThreadPool");
+    fn();
+  };
+  int partition = CurrentPartition();
+  if (partition < 0) {
+    partition = next_partition_.fetch_add(1, std::memory_order_relaxed) %
+                partitions_.size();
+  }
+  partitions_[partition]->Schedule(std::move(tagged_fn));
+}
+
+int SharedThreadPool::NumThreads() const { return num_threads_; }
+
+int SharedThreadPool::CurrentThreadId() const {
+  for (int i = 0; i < partitions_.size(); ++i) {
+    const int id = partitions_[i]->CurrentThreadId();
+    if (id >= 0) {
+      return partition_offsets_[i] + id;
+    }
+  }
+  return -1;
+}
+
+int SharedThreadPool::CurrentPartition() const {
+  for (int i = 0; i < partitions_.size(); ++i) {
+    if (partitions_[i]->CurrentThreadId() >= 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace data
+}  // namespace tensorflow
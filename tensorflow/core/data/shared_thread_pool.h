@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
+#define TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data {
+
+// A bounded thread pool that is shared by the input pipelines of a process,
+// instead of giving each iterator a private thread pool with one thread per
+// core.
+//
+// The pool is split into one or more partitions, each of which is a
+// `thread::ThreadPool` whose workers steal work from each other. When the pool
+// is partitioned by NUMA node, the threads of each partition are pinned to
+// their node, and work scheduled from a thread of a partition stays in that
+// partition so that it runs close to the memory of its producer. Work
+// scheduled from other threads is spread over the partitions round-robin.
+//
+// NOTE: Only short-lived work, such as function invocations, should be
+// scheduled on this pool. Long-running threads that block, such as the
+// background threads of `prefetch`, must use `UnboundedThreadPool` instead,
+// since blocking them on a bounded pool can deadlock.
+class SharedThreadPool : public thread::ThreadPoolInterface {
+ public:
+  struct Options {
+    // Total number of threads. If not positive, defaults to the number of
+    // schedulable CPUs.
+    int num_threads = 0;
+    // Whether to create one partition per NUMA node, if NUMA is supported.
+    bool numa_partitioned = false;
+  };
+
+  SharedThreadPool(Env* env, const std::string& name, const Options& options);
+  ~SharedThreadPool() override = default;
+
+  // Returns the pool shared by the input pipelines of the process. The pool
+  // is partitioned by NUMA node if the `numa_shared_threadpool` experiment is
+  // enabled.
+  static SharedThreadPool* Get();
+
+  void Schedule(std::function<void()> fn) override;
+
+  // Returns the total number of threads of the pool.
+  int NumThreads() const override;
+
+  // Returns an id between 0 and `NumThreads() - 1` if called from a thread of
+  // the pool, and -1 otherwise.
+  int CurrentThreadId() const override;
+
+  int num_partitions() const { return partitions_.size(); }
+
+  // Returns the partition of the current thread, or -1 if it does not belong
+  // to the pool.
+  int CurrentPartition() const;
+
+ private:
+  std::vector<std::unique_ptr<thread::ThreadPool>> partitions_;
+  // The first thread id of each partition.
+  std::vector<int> partition_offsets_;
+  int num_threads_ = 0;
+  std::atomic<uint64_t> next_partition_{0};
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_SHARED_THREAD_POOL_H_
@@ -0,0 +1,88 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/data/shared_thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(SharedThreadPool, RunsAllWork) {
+  SharedThreadPool::Options options;
+  options.num_threads = 4;
+  SharedThreadPool pool(Env::Default(), "test", options);
+  EXPECT_EQ(pool.NumThreads(), 4);
+  EXPECT_EQ(pool.CurrentThreadId(), -1);
+  EXPECT_EQ(pool.CurrentPartition(), -1);
+
+  constexpr int kNumTasks = 1000;
+  std::atomic<int> num_done(0);
+  BlockingCounter counter(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    pool.Schedule([&]() {
+      ++num_done;
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  EXPECT_EQ(num_done, kNumTasks);
+}
+
+TEST(SharedThreadPool, ThreadIdsAreBounded) {
+  SharedThreadPool::Options options;
+  options.num_threads = 3;
+  options.numa_partitioned = true;
+  SharedThreadPool pool(Env::Default(), "test", options);
+  EXPECT_GE(pool.num_partitions(), 1);
+  EXPECT_LE(pool.num_partitions(), 3);
+
+  constexpr int kNumTasks = 100;
+  mutex mu;
+  std::vector<int> thread_ids;
+  std::vector<bool> same_partitions;
+  BlockingCounter counter(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    pool.Schedule([&]() {
+      // Work scheduled from a thread of the pool stays in its partition.
+      const int partition = pool.CurrentPartition();
+      pool.Schedule([&, partition]() {
+        mutex_lock l(mu);
+        thread_ids.push_back(pool.CurrentThreadId());
+        same_partitions.push_back(partition == pool.CurrentPartition());
+        counter.DecrementCount();
+      });
+    });
+  }
+  counter.Wait();
+  for (int id : thread_ids) {
+    EXPECT_GE(id, 0);
+    EXPECT_LT(id, 3);
+  }
+  for (bool same_partition : same_partitions) {
+    EXPECT_TRUE(same_partition);
+  }
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
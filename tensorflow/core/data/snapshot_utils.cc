@@ -57,6 +57,7 @@ constexpr const char* const kVersion = "version";
 constexpr const char* const kCurrentCheckpointID = "current_checkpoint_id";
 constexpr const char* const kIndex = "index";
 constexpr const char* const kStartIndex = "start_index";
+constexpr const char* const kElementIndexSuffix = ".index";
 
 }  // namespace
 
@@ -95,6 +96,10 @@ std::string GetCheckpointFileName(const std::string& shard_directory,
                       static_cast<unsigned long long>(checkpoint_id)));
 }
 
+std::string GetElementIndexFileName(const std::string& snapshot_filename) {
+  return absl::StrCat(snapshot_filename, kElementIndexSuffix);
+}
+
 Status Writer::Create(Env* env, const std::string& filename,
                       const std::string& compression_type, int version,
                       const DataTypeVector& dtypes,
@@ -181,7 +186,13 @@ CustomWriter::CustomWriter(const std::string& filename,
       dtypes_(dtypes) {}
 
 Status CustomWriter::Initialize(tensorflow::Env* env) {
+  env_ = env;
   TF_RETURN_IF_ERROR(env->NewAppendableFile(filename_, &dest_));
+  // With gzip, the records are not at fixed offsets of the file.
+  if (compression_type_ != io::compression::kGzip &&
+      dest_->Tell(&bytes_written_).ok()) {
+    write_element_index_ = true;
+  }
 #if defined(IS_SLIM_BUILD)
   if (compression_type_ != io::compression::kNone) {
     LOG(ERROR) << "Compression is unsupported on mobile platforms. Turning "
@@ -215,6 +226,9 @@ Status CustomWriter::Initialize(tensorflow::Env* env) {
 }
 
 Status CustomWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  if (write_element_index_) {
+    element_offsets_.push_back(bytes_written_);
+  }
   if (compression_type_ != io::compression::kSnappy) {
     experimental::SnapshotRecord record;
     for (const auto& tensor : tensors) {
@@ -303,6 +317,9 @@ Status CustomWriter::Close() {
   if (dest_ != nullptr) {
     TF_RETURN_IF_ERROR(dest_->Close());
     dest_ = nullptr;
+    if (write_element_index_) {
+      TF_RETURN_IF_ERROR(WriteElementIndex());
+    }
   }
   if (zlib_underlying_dest_ != nullptr) {
     TF_RETURN_IF_ERROR(zlib_underlying_dest_->Close());
@@ -322,6 +339,7 @@ Status CustomWriter::WriteRecord(const StringPiece& data) {
   char header[kHeaderSize];
   core::EncodeFixed64(header, data.size());
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+  bytes_written_ += kHeaderSize + data.size();
   return dest_->Append(data);
 }
 
@@ -330,13 +348,39 @@ Status CustomWriter::WriteRecord(const absl::Cord& data) {
   char header[kHeaderSize];
   core::EncodeFixed64(header, data.size());
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+  bytes_written_ += kHeaderSize + data.size();
   return dest_->Append(data);
 }
 #endif  // TF_CORD_SUPPORT
 
+Status CustomWriter::WriteElementIndex() {
+  Tensor offsets(DT_INT64, TensorShape({static_cast<int64_t>(
+                               element_offsets_.size() + 1)}));
+  auto offsets_flat = offsets.flat<int64_t>();
+  std::copy(element_offsets_.begin(), element_offsets_.end(),
+            offsets_flat.data());
+  offsets_flat(element_offsets_.size()) = bytes_written_;
+  TensorProto proto;
+  offsets.AsProtoTensorContent(&proto);
+  const std::string index_filename = GetElementIndexFileName(filename_);
+  std::string tmp_filename =
+      absl::StrCat(index_filename, "-tmp-", random::New64());
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env_, tmp_filename, proto));
+  return env_->RenameFile(tmp_filename, index_filename);
+}
+
+Status Reader::Create(Env* env, const std::string& filename,
+                      const string& compression_type, int version,
+                      const DataTypeVector& dtypes,
+                      std::unique_ptr<Reader>* out_reader) {
+  return Create(env, filename, compression_type, version, dtypes,
+                /*num_parallel_decodes=*/1, out_reader);
+}
+
 Status Reader::Create(Env* env, const std::string& filename,
                       const string& compression_type, int version,
                       const DataTypeVector& dtypes,
+                      int64_t num_parallel_decodes,
                       std::unique_ptr<Reader>* out_reader) {
   switch (version) {
     // CustomReader is able to read a legacy snapshot file format (v0) though
@@ -344,8 +388,8 @@ Status Reader::Create(Env* env, const std::string& filename,
     // strictly worse than V1.
     case 0:
     case 1:
-      *out_reader = std::make_unique<CustomReader>(filename, compression_type,
-                                                   version, dtypes);
+      *out_reader = std::make_unique<CustomReader>(
+          filename, compression_type, version, dtypes, num_parallel_decodes);
       break;
     case 2:
       *out_reader =
@@ -500,13 +544,8 @@ class Reader::Dataset : public DatasetBase {
                                    current_checkpoint_id_);
     }
 
-    // TODO(frankchn): Optimize this to not parse every single element.
     Status AdvanceToStartIndex(IteratorContext* ctx) {
-      for (int64_t i = 0; i < start_index_; ++i) {
-        std::vector<Tensor> unused;
-        TF_RETURN_IF_ERROR(reader_->ReadTensors(&unused));
-      }
-      return OkStatus();
+      return reader_->SkipRecords(start_index_);
     }
 
     std::unique_ptr<Reader> reader_;
@@ -742,13 +781,27 @@ Status TFRecordReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   return OkStatus();
 }
 
+Status TFRecordReader::SkipRecords(int64_t num_records) {
+  // Each element is stored as one record per component.
+  int64_t num_to_skip = num_records * dtypes_.size();
+  while (num_to_skip > 0) {
+    int num_skipped;
+    TF_RETURN_IF_ERROR(record_reader_->SkipRecords(
+        &offset_, std::min<int64_t>(num_to_skip, kint32max), &num_skipped));
+    num_to_skip -= num_skipped;
+  }
+  return OkStatus();
+}
+
 CustomReader::CustomReader(const std::string& filename,
                            const string& compression_type, const int version,
-                           const DataTypeVector& dtypes)
+                           const DataTypeVector& dtypes,
+                           int64_t num_parallel_decodes)
     : filename_(filename),
       compression_type_(compression_type),
       version_(version),
-      dtypes_(dtypes) {}
+      dtypes_(dtypes),
+      num_parallel_decodes_(num_parallel_decodes) {}
 
 Status CustomReader::Initialize(Env* env) {
   TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename_, &file_));
@@ -789,15 +842,66 @@ Status CustomReader::Initialize(Env* env) {
     }
   }
 
+  if (version_ == 1 && compression_type_ == io::compression::kSnappy &&
+      num_parallel_decodes_ > 1) {
+    thread_pool_ = std::make_unique<thread::ThreadPool>(
+        env, ThreadOptions(), "snapshot_decode", num_parallel_decodes_);
+  }
+  // Only version 1 files are written with an element index.
+  if (version_ == 1 && compression_type_ != io::compression::kGzip) {
+    TF_RETURN_IF_ERROR(LoadElementIndex(env));
+  }
+  return OkStatus();
+}
+
+Status CustomReader::LoadElementIndex(Env* env) {
+  const std::string index_filename = GetElementIndexFileName(filename_);
+  if (!env->FileExists(index_filename).ok()) {
+    return OkStatus();
+  }
+  TensorProto proto;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, index_filename, &proto));
+  Tensor offsets;
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(env->GetFileSize(filename_, &file_size));
+  if (!offsets.FromProto(proto) || offsets.dtype() != DT_INT64 ||
+      offsets.dims() != 1 || offsets.NumElements() == 0 ||
+      offsets.flat<int64_t>()(offsets.NumElements() - 1) !=
+          static_cast<int64_t>(file_size)) {
+    LOG(WARNING) << "Ignoring invalid element index " << index_filename
+                 << " of snapshot file " << filename_;
+    return OkStatus();
+  }
+  auto offsets_flat = offsets.flat<int64_t>();
+  element_offsets_.assign(offsets_flat.data(),
+                          offsets_flat.data() + offsets_flat.size());
   return OkStatus();
 }
 
+Status CustomReader::SkipRecords(int64_t num_records) {
+  if (element_offsets_.empty() || !pending_elements_.empty()) {
+    return Reader::SkipRecords(num_records);
+  }
+  const int64_t num_elements = element_offsets_.size() - 1;
+  if (num_elements_read_ + num_records > num_elements) {
+    return errors::OutOfRange("Cannot skip ", num_records,
+                              " elements: snapshot file ", filename_,
+                              " has ", num_elements - num_elements_read_,
+                              " elements left.");
+  }
+  num_elements_read_ += num_records;
+  return input_stream_->SkipNBytes(element_offsets_[num_elements_read_] -
+                                   input_stream_->Tell());
+}
+
 Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   profiler::TraceMe activity(
       [&]() { return absl::StrCat(kClassName, kSeparator, "ReadTensors"); },
       profiler::TraceMeLevel::kInfo);
   if (version_ == 0 || compression_type_ != io::compression::kSnappy) {
-    return ReadTensorsV0(read_tensors);
+    TF_RETURN_IF_ERROR(ReadTensorsV0(read_tensors));
+    ++num_elements_read_;
+    return OkStatus();
   }
   if (version_ != 1) {
     return errors::InvalidArgument("Version: ", version_, " is not supported.");
@@ -806,10 +910,66 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
     return errors::InvalidArgument("Compression ", compression_type_,
                                    " is not supported.");
   }
+  if (thread_pool_ != nullptr) {
+    return ReadTensorsParallel(read_tensors);
+  }
 
-  experimental::SnapshotTensorMetadata metadata;
   tstring metadata_str;
-  TF_RETURN_IF_ERROR(ReadRecord(&metadata_str));
+  tstring compressed;
+  TF_RETURN_IF_ERROR(ReadElement(&metadata_str, &compressed));
+  ++num_elements_read_;
+  return DecodeElement(metadata_str, compressed, read_tensors);
+}
+
+Status CustomReader::ReadTensorsParallel(std::vector<Tensor>* read_tensors) {
+  // Keeps enough elements in flight for every decoding thread to have one
+  // while the next ones are read.
+  while (read_status_.ok() &&
+         static_cast<int64_t>(pending_elements_.size()) <
+             2 * num_parallel_decodes_) {
+    auto element = std::make_shared<PendingElement>();
+    read_status_ = ReadElement(&element->metadata, &element->compressed);
+    if (!read_status_.ok()) {
+      break;
+    }
+    pending_elements_.push_back(element);
+    thread_pool_->Schedule([this, element]() {
+      std::vector<Tensor> tensors;
+      Status s = DecodeElement(element->metadata, element->compressed,
+                               &tensors);
+      mutex_lock l(mu_);
+      element->tensors = std::move(tensors);
+      element->status = s;
+      element->done = true;
+      cond_var_.notify_all();
+    });
+  }
+  if (pending_elements_.empty()) {
+    return read_status_;
+  }
+  std::shared_ptr<PendingElement> element = pending_elements_.front();
+  pending_elements_.pop_front();
+  ++num_elements_read_;
+  mutex_lock l(mu_);
+  while (!element->done) {
+    cond_var_.wait(l);
+  }
+  TF_RETURN_IF_ERROR(element->status);
+  for (Tensor& tensor : element->tensors) {
+    read_tensors->push_back(std::move(tensor));
+  }
+  return OkStatus();
+}
+
+Status CustomReader::ReadElement(tstring* metadata, tstring* compressed) {
+  TF_RETURN_IF_ERROR(ReadRecord(metadata));
+  return ReadRecord(compressed);
+}
+
+Status CustomReader::DecodeElement(const tstring& metadata_str,
+                                   const tstring& compressed,
+                                   std::vector<Tensor>* read_tensors) const {
+  experimental::SnapshotTensorMetadata metadata;
   if (!metadata.ParseFromArray(metadata_str.data(), metadata_str.size())) {
     return errors::DataLoss("Could not parse SnapshotTensorMetadata");
   }
@@ -819,8 +979,8 @@ Status CustomReader::ReadTensors(std::vector<Tensor>* read_tensors) {
   simple_tensors.reserve(num_simple_);
   std::vector<std::pair<std::unique_ptr<char[]>, size_t>> tensor_proto_strs;
   tensor_proto_strs.reserve(num_complex_);
-  TF_RETURN_IF_ERROR(
-      SnappyUncompress(&metadata, &simple_tensors, &tensor_proto_strs));
+  TF_RETURN_IF_ERROR(SnappyUncompress(compressed, &metadata, &simple_tensors,
+                                      &tensor_proto_strs));
 
   int simple_index = 0;
   int complex_index = 0;
@@ -868,12 +1028,11 @@ Status CustomReader::ReadTensorsV0(std::vector<Tensor>* read_tensors) {
 }
 
 Status CustomReader::SnappyUncompress(
+    const tstring& compressed,
     const experimental::SnapshotTensorMetadata* metadata,
     std::vector<Tensor>* simple_tensors,
     std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
-        tensor_proto_strs) {
-  tstring compressed;
-  TF_RETURN_IF_ERROR(ReadRecord(&compressed));
+        tensor_proto_strs) const {
   size_t size;
   if (!port::Snappy_GetUncompressedLength(compressed.data(), compressed.size(),
                                           &size)) {
@@ -16,10 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SNAPSHOT_UTILS_H_
 #define TENSORFLOW_CORE_DATA_SNAPSHOT_UTILS_H_
 
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/record_reader.h"
@@ -70,6 +76,12 @@ std::string ShardDirectory(const std::string& run_directory, int64_t shard_id);
 std::string GetCheckpointFileName(const std::string& shard_directory,
                                   const uint64 checkpoint_id);
 
+// Returns the name of the element index of the given snapshot file. The index
+// holds the offset of each element in the file, which lets readers skip
+// elements without reading them. It is written by `CustomWriter` for files
+// without stream compression.
+std::string GetElementIndexFileName(const std::string& snapshot_filename);
+
 // This is a interface class that exposes snapshot writing functionality.
 class Writer {
  public:
@@ -151,6 +163,10 @@ class CustomWriter : public Writer {
   Status WriteRecord(const absl::Cord& data);
 #endif  // TF_CORD_SUPPORT
 
+  // Writes `element_offsets_` to the element index of the file.
+  Status WriteElementIndex();
+
+  Env* env_ = nullptr;
   std::unique_ptr<WritableFile> dest_;
   const std::string filename_;
   const std::string compression_type_;
@@ -162,6 +178,11 @@ class CustomWriter : public Writer {
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
   int num_simple_ = 0;
   int num_complex_ = 0;
+  // Whether an element index is written, and the offset in the file of each
+  // element written so far.
+  bool write_element_index_ = false;
+  int64_t bytes_written_ = 0;
+  std::vector<int64_t> element_offsets_;
 };
 
 // Interface class for reading snapshot files previous written with Writer.
@@ -205,6 +226,15 @@ class Reader {
                        const DataTypeVector& dtypes,
                        std::unique_ptr<Reader>* out_reader);
 
+  // Same as above, but for version 1 files with snappy compression, up to
+  // `num_parallel_decodes` elements are decompressed and parsed in parallel
+  // while the next ones are read.
+  static Status Create(Env* env, const std::string& filename,
+                       const string& compression_type, int version,
+                       const DataTypeVector& dtypes,
+                       int64_t num_parallel_decodes,
+                       std::unique_ptr<Reader>* out_reader);
+
   // Returns a nested dataset for a set of given snapshot file names.
   //
   // This function takes a vector of snapshot files, and returns a nested
@@ -242,6 +272,9 @@ class TFRecordReader : public Reader {
 
   Status ReadTensors(std::vector<Tensor>* read_tensors) override;
 
+  // Skips the records of `num_records` elements without parsing them.
+  Status SkipRecords(int64_t num_records) override;
+
   ~TFRecordReader() override {}
 
  protected:
@@ -276,23 +309,51 @@ class CustomReader : public Reader {
   static constexpr const char* const kSeparator = "::";
 
   CustomReader(const std::string& filename, const string& compression_type,
-               const int version, const DataTypeVector& dtypes);
+               const int version, const DataTypeVector& dtypes,
+               int64_t num_parallel_decodes = 1);
 
   Status ReadTensors(std::vector<Tensor>* read_tensors) override;
 
+  // Seeks past `num_records` elements if the file has an element index, and
+  // reads them otherwise.
+  Status SkipRecords(int64_t num_records) override;
+
   ~CustomReader() override {}
 
  protected:
   Status Initialize(Env* env) override;
 
  private:
+  // A version 1 snappy element read from the file and being decoded.
+  struct PendingElement {
+    tstring metadata;
+    tstring compressed;
+    // Guarded by `mu_` of the reader.
+    bool done = false;
+    Status status;
+    std::vector<Tensor> tensors;
+  };
+
   Status ReadTensorsV0(std::vector<Tensor>* read_tensors);
 
+  // Reads the records of the next version 1 snappy element, and decodes them
+  // with `DecodeElement()`, which is thread-safe.
+  Status ReadElement(tstring* metadata, tstring* compressed);
+  Status DecodeElement(const tstring& metadata_str, const tstring& compressed,
+                       std::vector<Tensor>* read_tensors) const;
+
+  // Reads the next element through `pending_elements_`.
+  Status ReadTensorsParallel(std::vector<Tensor>* read_tensors);
+
   Status SnappyUncompress(
+      const tstring& compressed,
       const experimental::SnapshotTensorMetadata* metadata,
       std::vector<Tensor>* simple_tensors,
       std::vector<std::pair<std::unique_ptr<char[]>, size_t>>*
-          tensor_proto_strs);
+          tensor_proto_strs) const;
+
+  // Loads the element index of the file, if it has a valid one.
+  Status LoadElementIndex(Env* env);
 
   Status ReadRecord(tstring* record);
 
@@ -309,6 +370,24 @@ class CustomReader : public Reader {
   int num_simple_ = 0;
   int num_complex_ = 0;
   std::vector<bool> simple_tensor_mask_;  // true for simple, false for complex.
+
+  // Offsets of the elements in the file, followed by the size of the file, or
+  // empty if the file has no element index.
+  std::vector<int64_t> element_offsets_;
+  // Number of elements read or skipped.
+  int64_t num_elements_read_ = 0;
+
+  const int64_t num_parallel_decodes_;
+  // Elements read from the file in order, while they are being decoded.
+  std::deque<std::shared_ptr<PendingElement>> pending_elements_;
+  // The status of the last read from the file, in parallel mode.
+  Status read_status_;
+  mutex mu_;
+  condition_variable cond_var_;
+
+  // This has to be last, so that the decoding threads are joined before the
+  // other members are destroyed.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
 };
 
 // Writes snapshot metadata to the given directory.
@@ -79,6 +79,7 @@ void SnapshotRoundTrip(std::string compression_type, int version) {
   }
 
   TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  Env::Default()->DeleteFile(GetElementIndexFileName(filename)).IgnoreError();
 }
 
 TEST(SnapshotUtilTest, CombinationRoundTripTest) {
@@ -91,6 +92,102 @@ TEST(SnapshotUtilTest, CombinationRoundTripTest) {
   SnapshotRoundTrip(io::compression::kSnappy, 2);
 }
 
+// Writes `num_elements` elements whose first component is the element index,
+// and returns the name of the file.
+std::string WriteIndexedElements(const std::string& compression_type,
+                                 int version, int num_elements) {
+  const DataTypeVector dtypes = {DT_INT64, DT_STRING};
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  std::unique_ptr<Writer> writer;
+  TF_CHECK_OK(Writer::Create(Env::Default(), filename, compression_type,
+                             version, dtypes, &writer));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TF_CHECK_OK(writer->WriteTensors(
+        {Tensor(i), Tensor(tstring(std::string(i % 7, 'x')))}));
+  }
+  TF_CHECK_OK(writer->Close());
+  return filename;
+}
+
+void ExpectElement(Reader* reader, int64_t index) {
+  std::vector<Tensor> read_tensors;
+  TF_ASSERT_OK(reader->ReadTensors(&read_tensors));
+  ASSERT_EQ(read_tensors.size(), 2);
+  EXPECT_EQ(read_tensors[0].scalar<int64_t>()(), index);
+  EXPECT_EQ(read_tensors[1].scalar<tstring>()(), std::string(index % 7, 'x'));
+}
+
+void SnapshotSkipRecords(const std::string& compression_type, int version,
+                         bool delete_element_index) {
+  const DataTypeVector dtypes = {DT_INT64, DT_STRING};
+  const std::string filename =
+      WriteIndexedElements(compression_type, version, /*num_elements=*/100);
+  if (delete_element_index) {
+    Env::Default()
+        ->DeleteFile(GetElementIndexFileName(filename))
+        .IgnoreError();
+  }
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename, compression_type,
+                              version, dtypes, &reader));
+  TF_ASSERT_OK(reader->SkipRecords(37));
+  ExpectElement(reader.get(), 37);
+  TF_ASSERT_OK(reader->SkipRecords(10));
+  ExpectElement(reader.get(), 48);
+  EXPECT_TRUE(errors::IsOutOfRange(reader->SkipRecords(100)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  Env::Default()->DeleteFile(GetElementIndexFileName(filename)).IgnoreError();
+}
+
+TEST(SnapshotUtilTest, SkipRecords) {
+  for (bool delete_element_index : {false, true}) {
+    SnapshotSkipRecords(io::compression::kNone, 1, delete_element_index);
+    SnapshotSkipRecords(io::compression::kGzip, 1, delete_element_index);
+    SnapshotSkipRecords(io::compression::kSnappy, 1, delete_element_index);
+
+    SnapshotSkipRecords(io::compression::kNone, 2, delete_element_index);
+    SnapshotSkipRecords(io::compression::kSnappy, 2, delete_element_index);
+  }
+}
+
+TEST(SnapshotUtilTest, WritesElementIndex) {
+  const std::string filename = WriteIndexedElements(
+      io::compression::kSnappy, /*version=*/1, /*num_elements=*/10);
+  TF_EXPECT_OK(Env::Default()->FileExists(GetElementIndexFileName(filename)));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(GetElementIndexFileName(filename)));
+
+  // Gzip streams cannot be read from an offset.
+  const std::string gzip_filename = WriteIndexedElements(
+      io::compression::kGzip, /*version=*/1, /*num_elements=*/10);
+  EXPECT_TRUE(errors::IsNotFound(
+      Env::Default()->FileExists(GetElementIndexFileName(gzip_filename))));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(gzip_filename));
+}
+
+TEST(SnapshotUtilTest, ParallelDecode) {
+  const DataTypeVector dtypes = {DT_INT64, DT_STRING};
+  const std::string filename = WriteIndexedElements(
+      io::compression::kSnappy, /*version=*/1, /*num_elements=*/100);
+
+  std::unique_ptr<Reader> reader;
+  TF_ASSERT_OK(Reader::Create(Env::Default(), filename,
+                              io::compression::kSnappy, /*version=*/1, dtypes,
+                              /*num_parallel_decodes=*/4, &reader));
+  TF_ASSERT_OK(reader->SkipRecords(5));
+  for (int64_t i = 5; i < 100; ++i) {
+    ExpectElement(reader.get(), i);
+  }
+  std::vector<Tensor> read_tensors;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->ReadTensors(&read_tensors)));
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  TF_ASSERT_OK(Env::Default()->DeleteFile(GetElementIndexFileName(filename)));
+}
+
 void SnapshotReaderBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
   tensorflow::DataTypeVector dtypes;
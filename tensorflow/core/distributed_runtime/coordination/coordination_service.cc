@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/coordination/coordination_service.h"
 
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <string>
 #include <utility>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/coordination/coordination_service_error_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/random.h"
@@ -53,6 +55,8 @@ constexpr absl::Duration kDevicePropagationTimeout = absl::Hours(1);
 constexpr int kDefaultHeartbeatTimeoutMs = 10 * 1000;  // 10 seconds
 constexpr int kServiceToClientTimeoutMs = 10 * 1000;   // 10 seconds
 constexpr size_t kOngoingBarriersSoftLimit = 20;
+// Number of independently locked shards of the key-value store.
+constexpr int kNumKeyValueShards = 16;
 constexpr char kHealthCheckThread[] = "CoordinationServiceHealthCheck";
 
 std::string GetTaskName(absl::string_view job_name, int task_id) {
@@ -250,11 +254,21 @@ class CoordinationServiceStandaloneImpl : public CoordinationServiceInterface {
       TF_GUARDED_BY(state_mu_);
   CoordinationServiceDeviceInfo cluster_devices_ TF_GUARDED_BY(state_mu_);
 
-  mutex kv_mu_;
-  // Ordered map to store config key-values
-  std::map<std::string, std::string> kv_store_ TF_GUARDED_BY(kv_mu_);
-  absl::flat_hash_map<std::string, std::vector<StatusOrValueCallback>> get_cb_
-      TF_GUARDED_BY(kv_mu_);
+  // The key-value store is sharded by key, so that tasks accessing different
+  // keys do not contend on a single lock. Directory operations visit every
+  // shard.
+  struct KeyValueShard {
+    mutex mu;
+    // Ordered map to store config key-values
+    std::map<std::string, std::string> kv_store TF_GUARDED_BY(mu);
+    absl::flat_hash_map<std::string, std::vector<StatusOrValueCallback>>
+        get_cb TF_GUARDED_BY(mu);
+  };
+  KeyValueShard& GetKeyValueShard(absl::string_view norm_key) {
+    return kv_shards_[Hash64(norm_key.data(), norm_key.size()) %
+                      kNumKeyValueShards];
+  }
+  std::array<KeyValueShard, kNumKeyValueShards> kv_shards_;
 
   mutex check_staleness_thread_shutdown_mu_;
   condition_variable check_staleness_thread_cv_;
@@ -394,7 +408,10 @@ void CoordinationServiceStandaloneImpl::StartCheckStaleness() {
           // Heartbeat check.
           Status status = OkStatus();
           {
-            mutex_lock l(state_mu_);
+            // Scan the tasks under a shared lock so that the scan does not
+            // block incoming heartbeats, and only take the exclusive lock
+            // when some task has become stale.
+            tf_shared_lock l(state_mu_);
             for (const auto& [task_name, task_state] : cluster_state_) {
               // Skip tasks that are not registered or in error state
               if (task_state->GetState() !=
@@ -407,14 +424,35 @@ void CoordinationServiceStandaloneImpl::StartCheckStaleness() {
                       << " stale?=" << is_stale;
               if (is_stale) {
                 stale_task_names.push_back(task_name);
-                status = MakeCoordinationError(errors::Unavailable(
-                    "Task ", task_name,
-                    " heartbeat timeout. This indicates that the remote task "
-                    "has failed, got preempted, or crashed unexpectedly."));
-                SetTaskError(task_name, status);
               }
             }
           }
+          if (!stale_task_names.empty()) {
+            mutex_lock l(state_mu_);
+            // Tasks may have sent a heartbeat or changed state since the scan.
+            auto still_stale = [&](absl::string_view task_name) {
+              auto it = cluster_state_.find(task_name);
+              return it != cluster_state_.end() &&
+                     it->second->GetState() ==
+                         CoordinatedTaskState::TASKSTATE_CONNECTED &&
+                     it->second->TimeSinceLastHeartbeatMs() >
+                         heartbeat_timeout_ms_;
+            };
+            stale_task_names.erase(
+                std::remove_if(stale_task_names.begin(),
+                               stale_task_names.end(),
+                               [&](absl::string_view task_name) {
+                                 return !still_stale(task_name);
+                               }),
+                stale_task_names.end());
+            for (const auto& stale_task_name : stale_task_names) {
+              status = MakeCoordinationError(errors::Unavailable(
+                  "Task ", stale_task_name,
+                  " heartbeat timeout. This indicates that the remote task "
+                  "has failed, got preempted, or crashed unexpectedly."));
+              SetTaskError(stale_task_name, status);
+            }
+          }
           // Propagate heartbeat timeout errors to other connected tasks.
           if (!stale_task_names.empty()) {
             if (!has_service_to_client_connection) {
@@ -472,9 +510,9 @@ void CoordinationServiceStandaloneImpl::StartCheckStaleness() {
 }
 
 void CoordinationServiceStandaloneImpl::Stop(bool shut_staleness_thread) {
-  {
-    mutex_lock l(kv_mu_);
-    for (const auto& [key, get_kv_callbacks] : get_cb_) {
+  for (KeyValueShard& shard : kv_shards_) {
+    mutex_lock l(shard.mu);
+    for (const auto& [key, get_kv_callbacks] : shard.get_cb) {
       for (const auto& get_kv_callback : get_kv_callbacks) {
         get_kv_callback(errors::Cancelled(
             absl::StrCat("Coordination service is shutting down. Cancelling "
@@ -482,7 +520,7 @@ void CoordinationServiceStandaloneImpl::Stop(bool shut_staleness_thread) {
                          key)));
       }
     }
-    get_cb_.clear();
+    shard.get_cb.clear();
   }
   {
     mutex_lock l(state_mu_);
@@ -647,26 +685,29 @@ Status CoordinationServiceStandaloneImpl::RecordHeartbeat(
   const std::string& task_name = GetTaskName(task);
   Status s = OkStatus();
   {
-    mutex_lock l(state_mu_);
-    if (!cluster_state_.contains(task_name)) {
+    // Heartbeats only update the timestamp of the sending task, which has its
+    // own lock, so they share `state_mu_` and do not serialize on each other.
+    tf_shared_lock l(state_mu_);
+    auto it = cluster_state_.find(task_name);
+    if (it == cluster_state_.end()) {
       return MakeCoordinationError(errors::InvalidArgument(
           "Unexpected task request with task_name=", task_name));
     }
-    if (!cluster_state_[task_name]->GetStatus().ok()) {
-      return cluster_state_[task_name]->GetStatus();
-    } else if (cluster_state_[task_name]->GetState() ==
+    TaskState* task_state = it->second.get();
+    if (!task_state->GetStatus().ok()) {
+      return task_state->GetStatus();
+    } else if (task_state->GetState() ==
                    CoordinatedTaskState::TASKSTATE_DISCONNECTED &&
                // We accept heartbeats for a short grace period to account for
                // the lag time between the service recording the state change
                // and the agent stopping heartbeats.
                Env::Default()->NowMicros() >
-                   cluster_state_[task_name]
-                       ->GetDisconnectedGracePeriodMicros()) {
+                   task_state->GetDisconnectedGracePeriodMicros()) {
       return MakeCoordinationError(errors::InvalidArgument(
           "Task with task_name=", task_name,
           " must be registered before sending heartbeat messages"));
     }
-    s = cluster_state_[task_name]->RecordHeartbeat(incarnation);
+    s = task_state->RecordHeartbeat(incarnation);
   }
 
   // Set and propagate any heartbeat errors.
@@ -809,18 +850,19 @@ std::string NormalizeKey(const StringPiece orig_key) {
 Status CoordinationServiceStandaloneImpl::InsertKeyValue(
     const std::string& key, const std::string& value) {
   const std::string& norm_key = NormalizeKey(key);
-  mutex_lock l(kv_mu_);
-  if (kv_store_.find(norm_key) != kv_store_.end()) {
+  KeyValueShard& shard = GetKeyValueShard(norm_key);
+  mutex_lock l(shard.mu);
+  if (shard.kv_store.find(norm_key) != shard.kv_store.end()) {
     return MakeCoordinationError(
         errors::AlreadyExists("Config key ", key, " already exists."));
   }
-  kv_store_.emplace(norm_key, value);
-  auto iter = get_cb_.find(norm_key);
-  if (iter != get_cb_.end()) {
+  shard.kv_store.emplace(norm_key, value);
+  auto iter = shard.get_cb.find(norm_key);
+  if (iter != shard.get_cb.end()) {
     for (const auto& cb : iter->second) {
       cb(value);
     }
-    get_cb_.erase(iter);
+    shard.get_cb.erase(iter);
   }
   return OkStatus();
 }
@@ -828,16 +870,18 @@ Status CoordinationServiceStandaloneImpl::InsertKeyValue(
 void CoordinationServiceStandaloneImpl::GetKeyValueAsync(
     const std::string& key, StatusOrValueCallback done) {
   const std::string& norm_key = NormalizeKey(key);
-  mutex_lock l(kv_mu_);
-  const auto& iter = kv_store_.find(norm_key);
-  if (iter != kv_store_.end()) {
+  KeyValueShard& shard = GetKeyValueShard(norm_key);
+  mutex_lock l(shard.mu);
+  const auto& iter = shard.kv_store.find(norm_key);
+  if (iter != shard.kv_store.end()) {
     done(iter->second);
     return;
   }
-  auto cb_iter = get_cb_.find(norm_key);
-  if (cb_iter == get_cb_.end()) {
+  auto cb_iter = shard.get_cb.find(norm_key);
+  if (cb_iter == shard.get_cb.end()) {
     cb_iter =
-        get_cb_.emplace(norm_key, std::vector<StatusOrValueCallback>()).first;
+        shard.get_cb.emplace(norm_key, std::vector<StatusOrValueCallback>())
+            .first;
   }
   cb_iter->second.emplace_back(std::move(done));
 }
@@ -845,9 +889,10 @@ void CoordinationServiceStandaloneImpl::GetKeyValueAsync(
 StatusOr<std::string> CoordinationServiceStandaloneImpl::TryGetKeyValue(
     const std::string& key) {
   const std::string& norm_key = NormalizeKey(key);
-  mutex_lock l(kv_mu_);
-  const auto& iter = kv_store_.find(norm_key);
-  if (iter == kv_store_.end()) {
+  KeyValueShard& shard = GetKeyValueShard(norm_key);
+  mutex_lock l(shard.mu);
+  const auto& iter = shard.kv_store.find(norm_key);
+  if (iter == shard.kv_store.end()) {
     return errors::NotFound("Config key ", key, " not found.");
   }
   return iter->second;
@@ -859,23 +904,30 @@ std::vector<KeyValueEntry> CoordinationServiceStandaloneImpl::GetKeyValueDir(
   const std::string norm_key = NormalizeKey(directory_key);
   const std::string dir = absl::StrCat(norm_key, "/");
 
-  mutex_lock l(kv_mu_);
-  // Find first key in ordered map that has the directory prefix.
-  auto begin = kv_store_.lower_bound(dir);
-  std::map<std::string, std::string>::iterator it;
-  // Iterate through key range that match directory prefix.
-  for (it = begin; it != kv_store_.end(); ++it) {
-    // Stop once the next key does not have the directory prefix. Since keys are
-    // ordered, none of the other keys would have a matching prefix.
-    if (std::mismatch(dir.begin(), dir.end(), it->first.begin()).first !=
-        dir.end()) {
-      break;
+  for (KeyValueShard& shard : kv_shards_) {
+    mutex_lock l(shard.mu);
+    // Find first key in ordered map that has the directory prefix.
+    auto begin = shard.kv_store.lower_bound(dir);
+    std::map<std::string, std::string>::iterator it;
+    // Iterate through key range that match directory prefix.
+    for (it = begin; it != shard.kv_store.end(); ++it) {
+      // Stop once the next key does not have the directory prefix. Since keys
+      // are ordered, none of the other keys would have a matching prefix.
+      if (std::mismatch(dir.begin(), dir.end(), it->first.begin()).first !=
+          dir.end()) {
+        break;
+      }
+      KeyValueEntry kv;
+      kv.set_key(it->first);
+      kv.set_value(it->second);
+      kvs_in_directory.push_back(kv);
     }
-    KeyValueEntry kv;
-    kv.set_key(it->first);
-    kv.set_value(it->second);
-    kvs_in_directory.push_back(kv);
   }
+  // Return the entries in key order, as if they came from a single map.
+  std::sort(kvs_in_directory.begin(), kvs_in_directory.end(),
+            [](const KeyValueEntry& a, const KeyValueEntry& b) {
+              return a.key() < b.key();
+            });
 
   return kvs_in_directory;
 }
@@ -883,20 +935,24 @@ std::vector<KeyValueEntry> CoordinationServiceStandaloneImpl::GetKeyValueDir(
 Status CoordinationServiceStandaloneImpl::DeleteKeyValue(
     const std::string& key) {
   const std::string& norm_key = NormalizeKey(key);
-  mutex_lock l(kv_mu_);
   // Delete directory: find key range that match directory prefix
   const std::string& dir = strings::StrCat(norm_key, "/");
-  auto begin = kv_store_.lower_bound(dir);
-  std::map<std::string, std::string>::iterator end;
-  for (end = begin; end != kv_store_.end(); end++) {
-    if (std::mismatch(dir.begin(), dir.end(), end->first.begin()).first !=
-        dir.end())
-      break;
+  for (KeyValueShard& shard : kv_shards_) {
+    mutex_lock l(shard.mu);
+    auto begin = shard.kv_store.lower_bound(dir);
+    std::map<std::string, std::string>::iterator end;
+    for (end = begin; end != shard.kv_store.end(); end++) {
+      if (std::mismatch(dir.begin(), dir.end(), end->first.begin()).first !=
+          dir.end())
+        break;
+    }
+    shard.kv_store.erase(begin, end);
   }
-  kv_store_.erase(begin, end);
-  auto iter = kv_store_.find(norm_key);
-  if (iter != kv_store_.end()) {
-    kv_store_.erase(iter);
+  KeyValueShard& shard = GetKeyValueShard(norm_key);
+  mutex_lock l(shard.mu);
+  auto iter = shard.kv_store.find(norm_key);
+  if (iter != shard.kv_store.end()) {
+    shard.kv_store.erase(iter);
   }
   return OkStatus();
 }
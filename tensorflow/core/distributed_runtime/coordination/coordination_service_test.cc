@@ -28,11 +28,14 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/coordination/coordination_client.h"
 #include "tensorflow/core/distributed_runtime/test_utils.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/cluster.pb.h"
@@ -613,6 +616,133 @@ TEST_F(CoordinateTwoTasksTest,
   EXPECT_THAT(result, IsEmpty());
 }
 
+TEST_F(CoordinateTwoTasksTest, GetKeyValueDir_ManyKeys_ReturnsSortedEntries) {
+  EnableCoordinationService();
+  // Enough keys to be spread over all shards of the store.
+  const int kNumKeys = 100;
+  for (int i = kNumKeys - 1; i >= 0; --i) {
+    TF_ASSERT_OK(coord_service_->InsertKeyValue(
+        absl::StrCat("dir/key_", absl::Dec(i, absl::kZeroPad3)),
+        absl::StrCat("value", i)));
+  }
+  TF_ASSERT_OK(coord_service_->InsertKeyValue("other_dir/key", "value"));
+
+  std::vector<KeyValueEntry> result = coord_service_->GetKeyValueDir("dir");
+
+  ASSERT_EQ(result.size(), kNumKeys);
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_EQ(result[i].key(),
+              absl::StrCat("dir/key_", absl::Dec(i, absl::kZeroPad3)));
+    EXPECT_EQ(result[i].value(), absl::StrCat("value", i));
+  }
+
+  TF_ASSERT_OK(coord_service_->DeleteKeyValue("dir"));
+  EXPECT_THAT(coord_service_->GetKeyValueDir("dir"), IsEmpty());
+  TF_EXPECT_OK(coord_service_->TryGetKeyValue("other_dir/key").status());
+}
+
+// Returns a coordination service for a single job with `num_tasks` registered
+// tasks, without service-to-client connections.
+std::unique_ptr<CoordinationServiceInterface> CreateServiceForBenchmark(
+    int num_tasks, std::vector<CoordinatedTask>* tasks) {
+  ServerDef server_def;
+  server_def.set_protocol("grpc");
+  server_def.set_job_name("worker");
+  server_def.set_task_index(0);
+  JobDef* job_def = server_def.mutable_cluster()->add_job();
+  job_def->set_name("worker");
+  for (int i = 0; i < num_tasks; ++i) {
+    job_def->mutable_tasks()->insert({i, absl::StrCat("worker", i, ":1234")});
+  }
+  auto coord_config = server_def.mutable_default_session_config()
+                          ->mutable_experimental()
+                          ->mutable_coordination_config();
+  coord_config->set_service_type(kCoordinationServiceType);
+  // Tasks that are not sending heartbeats must not time out while the
+  // benchmark runs.
+  coord_config->set_heartbeat_timeout_in_ms(absl::Hours(1) /
+                                            absl::Milliseconds(1));
+  auto coord_service = CoordinationServiceInterface::EnableCoordinationService(
+      kCoordinationServiceType, Env::Default(), server_def,
+      /*cache=*/nullptr);
+  for (int i = 0; i < num_tasks; ++i) {
+    CoordinatedTask task;
+    task.set_job_name("worker");
+    task.set_task_id(i);
+    TF_CHECK_OK(coord_service->RegisterTask(task, /*incarnation=*/0));
+    tasks->push_back(task);
+  }
+  return coord_service;
+}
+
+// Requires the service to handle one heartbeat from each of the tasks per
+// iteration, from `kNumThreads` concurrent callers.
+void BM_Heartbeat(::testing::benchmark::State& state) {
+  const int num_tasks = state.range(0);
+  const int kNumThreads = 16;
+  std::vector<CoordinatedTask> tasks;
+  auto coord_service = CreateServiceForBenchmark(num_tasks, &tasks);
+  thread::ThreadPool pool(Env::Default(), "heartbeat", kNumThreads);
+  for (auto s : state) {
+    BlockingCounter counter(kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&, t]() {
+        for (int i = t; i < num_tasks; i += kNumThreads) {
+          TF_CHECK_OK(coord_service->RecordHeartbeat(tasks[i],
+                                                     /*incarnation=*/0));
+        }
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_Heartbeat)->Arg(1024)->Arg(4096)->Arg(16384);
+
+// Passes one barrier over all the tasks per iteration.
+void BM_Barrier(::testing::benchmark::State& state) {
+  const int num_tasks = state.range(0);
+  std::vector<CoordinatedTask> tasks;
+  auto coord_service = CreateServiceForBenchmark(num_tasks, &tasks);
+  int barrier_id = 0;
+  for (auto s : state) {
+    const std::string id = absl::StrCat("barrier_", barrier_id++);
+    BlockingCounter counter(num_tasks);
+    for (const CoordinatedTask& task : tasks) {
+      coord_service->BarrierAsync(id, absl::Seconds(60), task,
+                                  /*participating_tasks=*/{},
+                                  [&counter](Status s) {
+                                    TF_CHECK_OK(s);
+                                    counter.DecrementCount();
+                                  });
+    }
+    counter.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_Barrier)->Arg(1024)->Arg(4096)->Arg(16384);
+
+// Each task publishes one key per iteration, which is then read back as a
+// directory, as done when exchanging addresses at startup.
+void BM_KeyValueExchange(::testing::benchmark::State& state) {
+  const int num_tasks = state.range(0);
+  std::vector<CoordinatedTask> tasks;
+  auto coord_service = CreateServiceForBenchmark(num_tasks, &tasks);
+  int round = 0;
+  for (auto s : state) {
+    const std::string dir = absl::StrCat("round_", round++);
+    for (int i = 0; i < num_tasks; ++i) {
+      TF_CHECK_OK(coord_service->InsertKeyValue(
+          absl::StrCat(dir, "/task:", i), "address"));
+    }
+    CHECK_EQ(coord_service->GetKeyValueDir(dir).size(), num_tasks);
+    TF_CHECK_OK(coord_service->DeleteKeyValue(dir));
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_KeyValueExchange)->Arg(1024)->Arg(4096)->Arg(16384);
+
 }  // namespace
 
 // Verify that coordination service can gather each task's device info and
@@ -20,12 +20,91 @@ limitations under the License.
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 namespace eager {
+namespace {
+
+int64_t MaxCoalescedOps() {
+  static const int64_t max_coalesced_ops = []() {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_EAGER_MAX_COALESCED_REMOTE_OPS",
+                                    /*default_val=*/1, &value));
+    return value;
+  }();
+  return max_coalesced_ops;
+}
+
+// Sets the remote shapes and devices of `retvals` from `queue_response` if
+// `status` is OK, and poisons them otherwise.
+void SetRemoteOutputs(const Status& status, const QueueResponse* queue_response,
+                      absl::Span<TensorHandle* const> retvals, Device* device,
+                      uint64 context_view_id) {
+  for (size_t i = 0; i < retvals.size(); ++i) {
+    if (status.ok()) {
+      const string output_device = queue_response->device().empty()
+                                       ? ""
+                                       : queue_response->device(i);
+      Status s = retvals[i]->SetRemoteShapeAndDevice(
+          queue_response->shape(i), device, context_view_id, output_device);
+
+      if (!s.ok()) {
+        LOG(ERROR) << "Ignoring an error encountered when setting "
+                      "remote shape of tensor handle: "
+                   << retvals[i]
+                   << " with execute status: " << status.ToString()
+                   << " and SetRemoteShape status: " << s.ToString()
+                   << "\nThis should never happen. "
+                      "Please file an issue with the TensorFlow Team.";
+      }
+    } else {
+      retvals[i]->PoisonRemote(status, device, context_view_id);
+    }
+  }
+}
+
+}  // namespace
+
+bool RemoteExecuteNode::TryCoalesce(AsyncRemoteExecuteNode* next,
+                                    StatusCallback done) {
+  RemoteExecuteNode* node = next->AsRemoteExecuteNode();
+  if (node == nullptr || node->eager_client_ != eager_client_ ||
+      request_->queue_size() + node->request_->queue_size() >
+          MaxCoalescedOps()) {
+    return false;
+  }
+  // Requests with cancellation are sent on their own so that cancelling an
+  // operation does not cancel the others. Nodes with inputs on other workers
+  // are sent on their own since the executor may need to sync before them.
+  if (cancellation_manager_ != nullptr ||
+      node->cancellation_manager_ != nullptr || needs_remote_inputs_ ||
+      node->needs_remote_inputs_ ||
+      node->request_->context_id() != request_->context_id() ||
+      node->request_->queue_size() != 1 ||
+      !node->request_->queue(0).has_operation()) {
+    return false;
+  }
+  CoalescedNode coalesced;
+  coalesced.queue_index = request_->queue_size();
+  coalesced.device = node->device_;
+  coalesced.context_view_id = node->context_view_id_;
+  for (TensorHandle* handle : node->retvals_) {
+    handle->Ref();
+    coalesced.retvals.push_back(handle);
+  }
+  coalesced.done = std::move(done);
+  request_->add_queue()->Swap(node->request_->mutable_queue(0));
+  coalesced_nodes_.push_back(std::move(coalesced));
+  return true;
+}
+
 
 void RemoteExecuteNode::RunAsync(StatusCallback done) {
   auto response = std::make_shared<EnqueueResponse>();
+  auto coalesced_nodes =
+      std::make_shared<std::vector<CoalescedNode>>(std::move(coalesced_nodes_));
 
   const gtl::InlinedVector<TensorHandle*, 4>& inputs = inputs_;
   const gtl::InlinedVector<TensorHandle*, 2>& retvals = retvals_;
@@ -79,7 +158,7 @@ void RemoteExecuteNode::RunAsync(StatusCallback done) {
   eager_client_->StreamingEnqueueAsync(
       eager_context_->Executor().StreamingEnqueue(), call_opts.get(),
       request_.get(), response.get(),
-      [inputs, retvals, call_opts, response, device,
+      [inputs, retvals, call_opts, response, coalesced_nodes, device,
        context_view_id = context_view_id_, rpc_description, cm, token,
        done](const Status& status) {
         if (cm != nullptr) {
@@ -94,29 +173,30 @@ void RemoteExecuteNode::RunAsync(StatusCallback done) {
           VLOG(3) << "Failed: " << rpc_description << " with status "
                   << status.ToString();
         }
-        for (size_t i = 0; i < retvals.size(); ++i) {
-          if (status.ok()) {
-            const string output_device =
-                response->queue_response(0).device().empty()
-                    ? ""
-                    : response->queue_response(0).device(i);
-            Status s = retvals[i]->SetRemoteShapeAndDevice(
-                response->queue_response(0).shape(i), device, context_view_id,
-                output_device);
-
-            if (!s.ok()) {
-              LOG(ERROR) << "Ignoring an error encountered when setting "
-                            "remote shape of tensor handle: "
-                         << retvals[i]
-                         << " with execute status: " << status.ToString()
-                         << " and SetRemoteShape status: " << s.ToString()
-                         << "\nThis should never happen. "
-                            "Please file an issue with the TensorFlow Team.";
-            }
-          } else {
-            retvals[i]->PoisonRemote(status, device, context_view_id);
+        SetRemoteOutputs(status,
+                         status.ok() ? &response->queue_response(0) : nullptr,
+                         retvals, device, context_view_id);
+        for (auto handle : retvals) {
+          handle->Unref();
+        }
+        for (CoalescedNode& node : *coalesced_nodes) {
+          Status node_status = status;
+          if (node_status.ok() &&
+              node.queue_index >= response->queue_response_size()) {
+            node_status = errors::Internal(
+                "Expected a response for coalesced operation ",
+                node.queue_index, " but got only ",
+                response->queue_response_size());
+          }
+          SetRemoteOutputs(node_status,
+                           node_status.ok()
+                               ? &response->queue_response(node.queue_index)
+                               : nullptr,
+                           node.retvals, node.device, node.context_view_id);
+          for (auto handle : node.retvals) {
+            handle->Unref();
           }
-          retvals[i]->Unref();
+          node.done(node_status);
         }
         done(status);
       });
@@ -19,6 +19,7 @@ limitations under the License.
 #include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/eager/eager_executor.h"
@@ -115,6 +116,19 @@ class RemoteExecuteNode : public AsyncRemoteExecuteNode {
     return eager_client_->allow_multiple_pending_requests();
   }
 
+  RemoteExecuteNode* AsRemoteExecuteNode() override { return this; }
+
+  // Coalesces a following `RemoteExecuteNode` for the same client, so that a
+  // chain of small remote ops is sent in one `EnqueueRequest` rather than one
+  // RPC per op. The remote worker runs the operations in order, so the later
+  // ones can consume the outputs of the earlier ones. Since the executor only
+  // coalesces nodes that are already queued, the request is sent as soon as
+  // the executor runs out of queued nodes, e.g. at a sync point.
+  //
+  // At most TF_EAGER_MAX_COALESCED_REMOTE_OPS operations are coalesced into a
+  // request. The default of 1 disables coalescing.
+  bool TryCoalesce(AsyncRemoteExecuteNode* next, StatusCallback done) override;
+
   string DebugString() const override {
     string out = "[RemoteExecuteNode]";
     strings::StrAppend(&out, " request: ", request_->DebugString());
@@ -134,6 +148,18 @@ class RemoteExecuteNode : public AsyncRemoteExecuteNode {
   const FunctionLibraryDefinition* lib_def_;
   gtl::InlinedVector<TensorHandle*, 4> inputs_;
   gtl::InlinedVector<TensorHandle*, 2> retvals_;
+
+  // A node whose operation was appended to `request_` by `TryCoalesce()`.
+  struct CoalescedNode {
+    // Index of the operation in `request_->queue()`.
+    int queue_index;
+    Device* device;
+    uint64 context_view_id;
+    // Referenced until the request completes.
+    gtl::InlinedVector<TensorHandle*, 2> retvals;
+    StatusCallback done;
+  };
+  std::vector<CoalescedNode> coalesced_nodes_;
 };
 
 }  // namespace eager
@@ -42,7 +42,9 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -56,6 +58,27 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+auto* register_graph_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/graph_mgr/register_graph_usecs",
+    "The time spent registering graphs on the worker, in microseconds, for "
+    "each phase of the registration.",
+    "phase");
+
+// Records the time elapsed since `*start_usecs` for `phase`, and resets
+// `*start_usecs` to the current time.
+void RecordRegisterPhase(const char* phase, uint64* start_usecs) {
+  const uint64 now_usecs = Env::Default()->NowMicros();
+  const uint64 elapsed_usecs = now_usecs - *start_usecs;
+  register_graph_usecs->GetCell(phase)->IncrementBy(elapsed_usecs);
+  VLOG(1) << "RegisterGraph phase " << phase << " took " << elapsed_usecs
+          << " us";
+  *start_usecs = now_usecs;
+}
+
+}  // namespace
+
 GraphMgr::GraphMgr(const WorkerEnv* worker_env, const DeviceMgr* device_mgr)
     : worker_env_(worker_env), device_mgr_(device_mgr), table_(5) {
   // The default value of sync_on_finish will be flipped soon and this
@@ -156,6 +179,8 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
             return OkStatus();
           }}));
 
+  uint64 phase_start_usecs = Env::Default()->NowMicros();
+
   // Constructs the graph out of "gdef".
   Graph graph(OpRegistry::Global());
   GraphConstructorOptions opts;
@@ -163,6 +188,7 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
   opts.expect_device_spec = true;
   opts.validate_nodes = true;
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
+  RecordRegisterPhase("convert", &phase_start_usecs);
 
   // Splits "graph" into multiple subgraphs by device names.
   std::unordered_map<string, GraphDef> partitions;
@@ -188,6 +214,7 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
   if (popts.scheduling_for_recvs) {
     TF_RETURN_IF_ERROR(AddControlEdges(popts, &partitions));
   }
+  AssignRendezvousSlots(&partitions);
 
   std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
   for (auto& partition : partitions) {
@@ -207,91 +234,143 @@ Status GraphMgr::InitItem(const string& handle, const GraphDef& gdef,
   TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
       OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
 
-  LocalExecutorParams params;
+  RecordRegisterPhase("partition", &phase_start_usecs);
 
-  item->units.reserve(partitions.size());
+  // Creates one unit per partition, so that the rest of the initialization of
+  // the partitions can run concurrently.
+  item->units.reserve(partition_graphs.size());
   item->graph_mgr = this;
-  const auto& optimizer_opts = graph_options.optimizer_options();
-  GraphOptimizer optimizer(optimizer_opts);
+  std::vector<std::unique_ptr<Graph>*> subgraphs;
+  subgraphs.reserve(partition_graphs.size());
   for (auto& p : partition_graphs) {
-    const string& device_name = p.first;
-    std::unique_ptr<Graph>& subgraph = p.second;
+    // Find the device.
+    Device* device = nullptr;
+    TF_RETURN_IF_ERROR(device_mgr_->LookupDevice(p.first, &device));
+    // The item destructor wants all units to have valid devices.
     item->units.resize(item->units.size() + 1);
     ExecutionUnit* unit = &(item->units.back());
-
-    // Find the device.
-    Status s = device_mgr_->LookupDevice(device_name, &unit->device);
-    if (!s.ok()) {
-      // Remove the empty unit from the item as the item destructor wants all
-      // units to have valid devices.
-      item->units.pop_back();
-      return s;
-    }
-
-    // Give the device an opportunity to rewrite its subgraph.
-    TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+    unit->device = device;
 
     // Top-level nodes in the graph uses the op segment to cache
     // kernels. Therefore, as long as the executor is alive, we need
     // to ensure the kernels cached for the session are alive.
-    auto opseg = unit->device->op_segment();
-    opseg->AddHold(handle);
-
-    // Function library runtime.
-    FunctionLibraryRuntime* lib = item->proc_flr->GetFLR(unit->device->name());
-    if (lib == nullptr) {
-      return errors::InvalidArgument("Cannot find FLR for device: ",
-                                     unit->device->name());
+    unit->device->op_segment()->AddHold(handle);
+    subgraphs.push_back(&p.second);
+  }
+
+  const int num_units = item->units.size();
+  std::vector<Status> unit_status(num_units);
+  auto init_unit = [&](int i) {
+    unit_status[i] =
+        InitUnit(handle, graph_options, debug_options, item->proc_flr.get(),
+                 std::move(*subgraphs[i]), &item->units[i]);
+  };
+  thread::ThreadPool* pool = num_units > 1 ? GetInitPool() : nullptr;
+  if (pool == nullptr) {
+    for (int i = 0; i < num_units; ++i) {
+      init_unit(i);
+    }
+  } else {
+    BlockingCounter pending(num_units - 1);
+    for (int i = 1; i < num_units; ++i) {
+      pool->Schedule([&init_unit, &pending, i]() {
+        init_unit(i);
+        pending.DecrementCount();
+      });
+    }
+    init_unit(0);
+    pending.Wait();
+  }
+  RecordRegisterPhase("instantiate", &phase_start_usecs);
+  for (const Status& s : unit_status) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  for (const ExecutionUnit& unit : item->units) {
+    if (unit.build_cost_model > 0) {
+      skip_cost_models_ = false;
     }
+  }
+  return OkStatus();
+}
+
+Status GraphMgr::InitUnit(const string& handle,
+                          const GraphOptions& graph_options,
+                          const DebugOptions& debug_options,
+                          ProcessFunctionLibraryRuntime* proc_flr,
+                          std::unique_ptr<Graph> subgraph,
+                          ExecutionUnit* unit) {
+  // Give the device an opportunity to rewrite its subgraph.
+  TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(&subgraph));
+
+  auto opseg = unit->device->op_segment();
+
+  // Function library runtime.
+  FunctionLibraryRuntime* lib = proc_flr->GetFLR(unit->device->name());
+  if (lib == nullptr) {
+    return errors::InvalidArgument("Cannot find FLR for device: ",
+                                   unit->device->name());
+  }
 
-    // Construct the root executor for the subgraph.
-    params.device = unit->device;
-    params.function_library = lib;
-    params.create_kernel =
-        [handle, lib, opseg](const std::shared_ptr<const NodeProperties>& props,
-                             OpKernel** kernel) {
-          // NOTE(mrry): We must not share function kernels (implemented
-          // using `CallOp`) between subgraphs, because `CallOp::handle_`
-          // is tied to a particular subgraph. Even if the function itself
-          // is stateful, the `CallOp` that invokes it is not.
-          if (!OpSegment::ShouldOwnKernel(lib, props->node_def.op())) {
-            return lib->CreateKernel(props, kernel);
-          }
-          auto create_fn = [lib, &props](OpKernel** kernel) {
-            return lib->CreateKernel(props, kernel);
-          };
-          // Kernels created for subgraph nodes need to be cached.  On
-          // cache miss, create_fn() is invoked to create a kernel based
-          // on the function library here + global op registry.
-          return opseg->FindOrCreate(handle, props->node_def.name(), kernel,
-                                     create_fn);
+  // Construct the root executor for the subgraph.
+  LocalExecutorParams params;
+  params.device = unit->device;
+  params.function_library = lib;
+  params.create_kernel =
+      [handle, lib, opseg](const std::shared_ptr<const NodeProperties>& props,
+                           OpKernel** kernel) {
+        // NOTE(mrry): We must not share function kernels (implemented
+        // using `CallOp`) between subgraphs, because `CallOp::handle_`
+        // is tied to a particular subgraph. Even if the function itself
+        // is stateful, the `CallOp` that invokes it is not.
+        if (!OpSegment::ShouldOwnKernel(lib, props->node_def.op())) {
+          return lib->CreateKernel(props, kernel);
+        }
+        auto create_fn = [lib, &props](OpKernel** kernel) {
+          return lib->CreateKernel(props, kernel);
         };
-    params.delete_kernel = [lib](OpKernel* kernel) {
-      if (kernel && !OpSegment::ShouldOwnKernel(lib, kernel->type_string())) {
-        delete kernel;
-      }
-    };
+        // Kernels created for subgraph nodes need to be cached.  On
+        // cache miss, create_fn() is invoked to create a kernel based
+        // on the function library here + global op registry.
+        return opseg->FindOrCreate(handle, props->node_def.name(), kernel,
+                                   create_fn);
+      };
+  params.delete_kernel = [lib](OpKernel* kernel) {
+    if (kernel && !OpSegment::ShouldOwnKernel(lib, kernel->type_string())) {
+      delete kernel;
+    }
+  };
 
-    optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph,
-                       GraphOptimizer::Options());
+  GraphOptimizer optimizer(graph_options.optimizer_options());
+  optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph,
+                     GraphOptimizer::Options());
 
-    // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
-    if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, subgraph.get(), params.device));
-    }
+  // TensorFlow Debugger (tfdbg) inserts debug nodes in the graph.
+  if (!debug_options.debug_tensor_watch_opts().empty()) {
+    TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
+        debug_options, subgraph.get(), params.device));
+  }
 
-    TF_RETURN_IF_ERROR(
-        EnsureMemoryTypes(DeviceType(unit->device->device_type()),
-                          unit->device->name(), subgraph.get()));
-    unit->graph = std::move(subgraph);
-    unit->build_cost_model = graph_options.build_cost_model();
-    if (unit->build_cost_model > 0) {
-      skip_cost_models_ = false;
-    }
-    TF_RETURN_IF_ERROR(NewLocalExecutor(params, *unit->graph, &unit->root));
+  TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(unit->device->device_type()),
+                                       unit->device->name(), subgraph.get()));
+  unit->graph = std::move(subgraph);
+  unit->build_cost_model = graph_options.build_cost_model();
+  return NewLocalExecutor(params, *unit->graph, &unit->root);
+}
+
+thread::ThreadPool* GraphMgr::GetInitPool() {
+  static const int64_t num_threads = []() {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_GRAPH_MGR_INIT_THREADS",
+                                    /*default_val=*/8, &value));
+    return value;
+  }();
+  if (num_threads <= 1) return nullptr;
+  mutex_lock l(mu_);
+  if (init_pool_ == nullptr) {
+    init_pool_ = std::make_unique<thread::ThreadPool>(
+        worker_env_->env, "graph_mgr_init", num_threads - 1);
   }
-  return OkStatus();
+  return init_pool_.get();
 }
 
 Status GraphMgr::Register(const string& handle, const GraphDef& gdef,
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -156,6 +157,12 @@ class GraphMgr {
   mutex mu_;
   int64_t next_id_ TF_GUARDED_BY(mu_) = 0;
 
+  // Initializes the partitions of a graph concurrently in `InitItem()`.
+  // Created on first use. Its size is set by `TF_GRAPH_MGR_INIT_THREADS`,
+  // which counts the registering thread, and a value of 1 or less initializes
+  // the partitions one after the other.
+  std::unique_ptr<thread::ThreadPool> init_pool_ TF_GUARDED_BY(mu_);
+
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
 
@@ -188,6 +195,18 @@ class GraphMgr {
                   WorkerSession* session,
                   DistributedFunctionLibraryRuntime* cluster_flr, Item* item);
 
+  // Optimizes `subgraph`, the partition of the graph `handle` for the device
+  // of `unit`, and creates its executor. May run concurrently for the units
+  // of an item.
+  Status InitUnit(const string& handle, const GraphOptions& graph_options,
+                  const DebugOptions& debug_options,
+                  ProcessFunctionLibraryRuntime* proc_flr,
+                  std::unique_ptr<Graph> subgraph, ExecutionUnit* unit);
+
+  // Returns the pool for `InitItem()`, or nullptr if partitions are
+  // initialized serially.
+  thread::ThreadPool* GetInitPool();
+
   Status DecorateAndPublishGraphForDebug(const DebugOptions& debug_options,
                                          Graph* graph, Device* device);
 
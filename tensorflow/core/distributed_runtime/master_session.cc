@@ -41,6 +41,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_description.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
@@ -64,6 +65,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/coordination_config.pb.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/device_name_utils.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -103,6 +105,9 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
                       strings::StrCat(
                           "(", absl::StrJoin(n->requested_inputs(), ", "))));
     }
+    if (!is_partial_) {
+      FindSideEffectFreeFetches();
+    }
   }
 
   ~ReffedClientGraph() override {
@@ -121,6 +126,13 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
 
   int64_t collective_graph_key() { return collective_graph_key_; }
 
+  // Returns true if a step with the feeds, fetches and targets of `opts` can
+  // run this graph instead of building its own: the feeds, targets and other
+  // options match, and the fetches of this graph are a superset of those of
+  // `opts`. The extra fetches are computed and ignored, so this is only the
+  // case when they do not depend on operations with side effects.
+  bool Subsumes(const BuildGraphOptions& opts) const;
+
   std::unique_ptr<ProfileHandler> GetProfileHandler(uint64 step,
                                                     int64_t execution_count,
                                                     const RunOptions& ropts) {
@@ -255,6 +267,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   const int64_t collective_graph_key_;
   std::atomic<int64_t> execution_count_ = {0};
 
+  // Names of the fetched nodes that do not depend on stateful operations,
+  // other than reading variables and feeds. Computed at construction.
+  std::unordered_set<string> side_effect_free_fetch_nodes_;
+
   // Graph partitioned into per-location subgraphs.
   struct Part {
     // Worker name.
@@ -335,9 +351,78 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // destructor and does not wait for the rpc completion.
   void DeregisterPartitions();
 
+  // Fills in `side_effect_free_fetch_nodes_`.
+  void FindSideEffectFreeFetches();
+
   TF_DISALLOW_COPY_AND_ASSIGN(ReffedClientGraph);
 };
 
+void MasterSession::ReffedClientGraph::FindSideEffectFreeFetches() {
+  // Stateful operations that only read state, and may run once more than
+  // requested without changing the results of the session.
+  static const auto* const kReadOnlyStatefulOps =
+      new std::unordered_set<string>({"_Arg", "_HostRecv", "_Recv",
+                                      "ReadVariableOp", "VarHandleOp",
+                                      "Variable", "VariableV2"});
+  std::unordered_set<string> fetch_nodes;
+  for (const string& fetch : callable_opts_.fetch()) {
+    fetch_nodes.insert(string(ParseTensorName(fetch).node()));
+  }
+  const Graph& graph = client_graph_before_register_->graph;
+  std::vector<Node*> order;
+  GetReversePostOrder(graph, &order);
+  // `has_side_effects[id]` is true if the node with that id or one of its
+  // transitive inputs has side effects.
+  std::vector<bool> has_side_effects(graph.num_node_ids(), false);
+  for (const Node* n : order) {
+    bool side_effects = n->IsOp() && n->op_def().is_stateful() &&
+                        !kReadOnlyStatefulOps->count(n->type_string());
+    for (const Edge* e : n->in_edges()) {
+      side_effects = side_effects || has_side_effects[e->src()->id()];
+    }
+    has_side_effects[n->id()] = side_effects;
+    if (!side_effects && fetch_nodes.count(n->name())) {
+      side_effect_free_fetch_nodes_.insert(n->name());
+    }
+  }
+}
+
+bool MasterSession::ReffedClientGraph::Subsumes(
+    const BuildGraphOptions& opts) const {
+  const CallableOptions& other = opts.callable_options;
+  auto equal = [](const protobuf::RepeatedPtrField<string>& a,
+                  const protobuf::RepeatedPtrField<string>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+  };
+  if (is_partial_ ||
+      opts.collective_graph_key != bg_opts_.collective_graph_key ||
+      opts.collective_order != bg_opts_.collective_order ||
+      opts.use_function_convention != bg_opts_.use_function_convention ||
+      callable_opts_.run_options().has_debug_options() ||
+      other.run_options().has_debug_options() ||
+      !equal(callable_opts_.feed(), other.feed()) ||
+      !equal(callable_opts_.target(), other.target())) {
+    return false;
+  }
+  // The fetches of both `BuildGraphOptions` are sorted.
+  std::vector<string> extra_fetches;
+  if (!std::includes(callable_opts_.fetch().begin(),
+                     callable_opts_.fetch().end(), other.fetch().begin(),
+                     other.fetch().end())) {
+    return false;
+  }
+  std::set_difference(callable_opts_.fetch().begin(),
+                      callable_opts_.fetch().end(), other.fetch().begin(),
+                      other.fetch().end(), std::back_inserter(extra_fetches));
+  for (const string& fetch : extra_fetches) {
+    if (!side_effect_free_fetch_nodes_.count(
+            string(ParseTensorName(fetch).node()))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status MasterSession::ReffedClientGraph::RegisterPartitions(
     PartitionOptions popts) {
   {  // Ensure register once.
@@ -670,6 +755,14 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
     pss->step_stats.resize(partitions_.size());
   }
 
+  // When this graph subsumes the step, which then requests fewer fetches,
+  // holds the names of the requested fetches.
+  std::unordered_set<string> requested_fetches;
+  if (!is_partial_ && static_cast<int>(fetches.size()) !=
+                          callable_opts_.fetch_size()) {
+    requested_fetches.insert(fetches.begin(), fetches.end());
+  }
+
   const int num = partitions_.size();
   RunManyGraphs calls(num);
 
@@ -730,6 +823,11 @@ Status MasterSession::ReffedClientGraph::RunPartitionsHelper(
             AddSendFromClientRequest(req, c->req.get(), feed_index, key));
       }
       for (const auto& key_fetch : part.key_fetch) {
+        // Outputs of a graph that subsumes the step are not returned.
+        if (!requested_fetches.empty() &&
+            !requested_fetches.count(key_fetch.second)) {
+          continue;
+        }
         const string& key = key_fetch.first;
         c->req->add_recv_key(key);
       }
@@ -1541,6 +1639,7 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
                                 ReffedClientGraph** out_rcg,
                                 int64_t* out_count) {
   const uint64 hash = HashBuildGraphOptions(opts);
+  std::vector<ReffedClientGraph*> to_unref;
   {
     mutex_lock l(mu_);
     // TODO(suharshs): We cache partial run graphs and run graphs separately
@@ -1548,6 +1647,16 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
     // run calls.
     RCGMap* m = is_partial ? &partial_run_graphs_ : &run_graphs_;
     auto iter = m->find(hash);
+    if (iter == m->end() && !is_partial) {
+      // Reuse a graph that computes more fetches than requested, if any.
+      ReffedClientGraph* subsuming = FindSubsumingRunGraph(opts);
+      if (subsuming != nullptr) {
+        VLOG(1) << "Reusing a subsuming graph for hash " << hash;
+        EvictRunGraphs(&to_unref);
+        subsuming->Ref();
+        iter = m->insert({hash, subsuming}).first;
+      }
+    }
     if (iter == m->end()) {
       // We have not seen this subgraph before. Build the subgraph and
       // cache it.
@@ -1561,16 +1670,64 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, bool is_partial,
           handle_, opts, std::move(client_graph), session_opts_,
           stats_publisher_factory_, is_partial, worker_cache,
           !should_delete_worker_sessions_);
+      if (!is_partial) {
+        EvictRunGraphs(&to_unref);
+      }
       iter = m->insert({hash, entry}).first;
       VLOG(1) << "Preparing to execute new graph";
     }
+    if (!is_partial) {
+      run_graphs_last_use_[hash] = ++run_graphs_clock_;
+    }
     *out_rcg = iter->second;
     (*out_rcg)->Ref();
     *out_count = (*out_rcg)->get_and_increment_execution_count();
   }
+  // Evicted graphs may deregister their partitions, which is done outside of
+  // the lock.
+  for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   return OkStatus();
 }
 
+MasterSession::ReffedClientGraph* MasterSession::FindSubsumingRunGraph(
+    const BuildGraphOptions& opts) {
+  ReffedClientGraph* best = nullptr;
+  for (const auto& entry : run_graphs_) {
+    ReffedClientGraph* rcg = entry.second;
+    // Prefer the graph with the fewest extra fetches.
+    if (rcg->Subsumes(opts) &&
+        (best == nullptr || rcg->callable_options().fetch_size() <
+                                best->callable_options().fetch_size())) {
+      best = rcg;
+    }
+  }
+  return best;
+}
+
+void MasterSession::EvictRunGraphs(std::vector<ReffedClientGraph*>* to_unref) {
+  static const int64_t max_cached_graphs = []() {
+    int64_t value;
+    TF_CHECK_OK(ReadInt64FromEnvVar("TF_MASTER_SESSION_MAX_CACHED_GRAPHS",
+                                    /*default_val=*/1024, &value));
+    return value;
+  }();
+  if (max_cached_graphs <= 0) return;
+  while (run_graphs_.size() >= max_cached_graphs) {
+    auto lru = std::min_element(
+        run_graphs_last_use_.begin(), run_graphs_last_use_.end(),
+        [](const std::pair<const uint64, uint64>& a,
+           const std::pair<const uint64, uint64>& b) {
+          return a.second < b.second;
+        });
+    // Steps that are still running hold their own reference to the graph.
+    auto iter = run_graphs_.find(lru->first);
+    VLOG(1) << "Evicting graph for hash " << lru->first;
+    to_unref->push_back(iter->second);
+    run_graphs_.erase(iter);
+    run_graphs_last_use_.erase(lru);
+  }
+}
+
 void MasterSession::ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                                    RCGMap* rcg_map) {
   VLOG(1) << "Discarding all reffed graphs";
@@ -2136,6 +2293,7 @@ Status MasterSession::Close() {
       num_running_is_zero_.wait(l);
     }
     ClearRunsTable(&to_unref, &run_graphs_);
+    run_graphs_last_use_.clear();
     ClearRunsTable(&to_unref, &partial_run_graphs_);
     ClearRunsTable(&to_unref, &callables_);
   }
@@ -154,6 +154,11 @@ class MasterSession : public core::RefCounted {
   typedef std::unordered_map<uint64, ReffedClientGraph*> RCGMap;
   RCGMap run_graphs_ TF_GUARDED_BY(mu_);
   RCGMap partial_run_graphs_ TF_GUARDED_BY(mu_);
+  // `run_graphs_` is bounded in size by evicting the least recently used
+  // entries, whose last use is recorded here. An entry may also refer to a
+  // graph that was built for another entry and computes more fetches.
+  std::unordered_map<uint64, uint64> run_graphs_last_use_ TF_GUARDED_BY(mu_);
+  uint64 run_graphs_clock_ TF_GUARDED_BY(mu_) = 0;
   int64_t next_callable_handle_ TF_GUARDED_BY(mu_) = 0;
   RCGMap callables_ TF_GUARDED_BY(mu_);
 
@@ -226,6 +231,14 @@ class MasterSession : public core::RefCounted {
                    ReffedClientGraph** out_rcg, int64_t* out_count);
   void ClearRunsTable(std::vector<ReffedClientGraph*>* to_unref,
                       RCGMap* rcg_map) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns a graph in `run_graphs_` that can run the steps described by
+  // `opts`, or nullptr if there is none.
+  ReffedClientGraph* FindSubsumingRunGraph(const BuildGraphOptions& opts)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Evicts the least recently used entries of `run_graphs_` to make room for
+  // a new one, and appends the graphs to unref to `to_unref`.
+  void EvictRunGraphs(std::vector<ReffedClientGraph*>* to_unref)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   void FillPerStepState(MasterSession::ReffedClientGraph* rcg,
                         const RunOptions& run_options, uint64 step_id,
                         int64_t count, PerStepState* out_pss,
@@ -422,4 +422,42 @@ TEST_F(MasterTest, EigenProblem) {
   TF_EXPECT_OK(CloseSession(handle));
 }
 
+TEST_F(MasterTest, RunSubsetOfPreviousFetches) {
+  Graph graph(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&a_tensor, {1, 2, 3, 4});
+  Node* a_node = test::graph::Constant(&graph, a_tensor);
+  Tensor b_tensor(DT_FLOAT, TensorShape({2, 2}));
+  test::FillValues<float>(&b_tensor, {0, 1, 1, 0});
+  Node* b_node = test::graph::Constant(&graph, b_tensor);
+  Node* c_node = test::graph::Matmul(&graph, a_node, b_node, false, false);
+  Node* d_node = test::graph::Matmul(&graph, c_node, b_node, false, false);
+
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  string handle;
+  int64_t initial_version;
+  TF_ASSERT_OK(CreateSession(def, &handle, &initial_version));
+
+  Tensor c(DT_FLOAT, TensorShape({2, 2}));
+  Tensor d(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(RunStep(
+      handle, {}, {{c_node->name() + ":0", &c}, {d_node->name() + ":0", &d}}));
+  test::ExpectTensorEqual<float>(
+      c, test::AsTensor<float>({2, 1, 4, 3}, TensorShape({2, 2})));
+  test::ExpectTensorEqual<float>(d, a_tensor);
+
+  // The graph built for the first step computes `c`, and may be reused, but
+  // only the requested fetch must be returned.
+  Tensor c2(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(RunStep(handle, {}, {{c_node->name() + ":0", &c2}}));
+  test::ExpectTensorEqual<float>(c2, c);
+
+  Tensor d2(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(RunStep(handle, {}, {{d_node->name() + ":0", &d2}}));
+  test::ExpectTensorEqual<float>(d2, a_tensor);
+  TF_EXPECT_OK(CloseSession(handle));
+}
+
 }  // namespace tensorflow
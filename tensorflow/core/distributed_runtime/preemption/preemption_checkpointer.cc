@@ -0,0 +1,168 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/preemption/preemption_checkpointer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr char kIndexSuffix[] = ".index";
+
+// Returns the prefix of the bundle of `task_name` for `shard`.
+std::string ShardPrefix(const std::string& directory,
+                        const std::string& task_name, int shard,
+                        int num_shards) {
+  const std::string task = absl::StrReplaceAll(task_name, {{"/", "_"},
+                                                           {":", "_"}});
+  return io::JoinPath(directory, absl::StrCat("emergency_", task, "-", shard,
+                                              "-of-", num_shards));
+}
+
+}  // namespace
+
+PreemptionCheckpointer::PreemptionCheckpointer(Env* env, Options options,
+                                               TensorProvider provider)
+    : env_(env), options_(std::move(options)), provider_(std::move(provider)) {}
+
+PreemptionCheckpointer::~PreemptionCheckpointer() {
+  mutex_lock l(mu_);
+  while (save_requested_ && !save_done_) {
+    cv_.wait(l);
+  }
+}
+
+void PreemptionCheckpointer::SaveOnPreemption(PreemptionNotifier* notifier) {
+  notifier->WillBePreemptedAtAsync([this](StatusOr<absl::Time> death_time) {
+    {
+      mutex_lock l(mu_);
+      save_requested_ = true;
+      if (!death_time.ok()) {
+        save_status_ = death_time.status();
+        save_done_ = true;
+        cv_.notify_all();
+        return;
+      }
+    }
+    LOG(INFO) << "Writing emergency checkpoint of " << options_.task_name
+              << " before preemption at " << death_time.value();
+    // Listener callbacks must return quickly, so save on another thread.
+    env_->SchedClosure([this]() {
+      const Status s = Save();
+      if (!s.ok()) {
+        LOG(ERROR) << "Failed to write emergency checkpoint: " << s;
+      }
+      mutex_lock l(mu_);
+      save_status_ = s;
+      save_done_ = true;
+      cv_.notify_all();
+    });
+  });
+}
+
+Status PreemptionCheckpointer::WaitForSave() {
+  mutex_lock l(mu_);
+  while (!save_done_) {
+    cv_.wait(l);
+  }
+  return save_status_;
+}
+
+Status PreemptionCheckpointer::Save() {
+  const uint64 start_micros = env_->NowMicros();
+  TF_ASSIGN_OR_RETURN(auto tensors, provider_());
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(options_.directory));
+
+  // Balances the bytes written by each shard, assigning the largest tensors
+  // first.
+  const int num_shards = std::max(
+      1, std::min<int>(options_.num_shards, std::max<int>(tensors.size(), 1)));
+  std::vector<int> order(tensors.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&tensors](int a, int b) {
+    return tensors[a].second.TotalBytes() > tensors[b].second.TotalBytes();
+  });
+  std::vector<std::vector<int>> shards(num_shards);
+  std::vector<int64_t> shard_bytes(num_shards, 0);
+  for (int i : order) {
+    const int shard =
+        std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+        shard_bytes.begin();
+    shards[shard].push_back(i);
+    shard_bytes[shard] += tensors[i].second.TotalBytes();
+  }
+
+  std::vector<Status> shard_status(num_shards);
+  auto write_shard = [&](int shard) {
+    BundleWriter writer(env_, ShardPrefix(options_.directory,
+                                          options_.task_name, shard,
+                                          num_shards));
+    for (int i : shards[shard]) {
+      // Errors are also returned by `Finish()`.
+      if (!writer.Add(tensors[i].first, tensors[i].second).ok()) break;
+    }
+    shard_status[shard] = writer.Finish();
+  };
+  BlockingCounter pending(num_shards - 1);
+  for (int shard = 1; shard < num_shards; ++shard) {
+    env_->SchedClosure([&write_shard, &pending, shard]() {
+      write_shard(shard);
+      pending.DecrementCount();
+    });
+  }
+  write_shard(0);
+  pending.Wait();
+  for (const Status& s : shard_status) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  VLOG(1) << "Wrote emergency checkpoint of " << tensors.size()
+          << " tensors in " << num_shards << " shards in "
+          << env_->NowMicros() - start_micros << " us";
+  return OkStatus();
+}
+
+Status PreemptionCheckpointer::MergeCheckpoints(
+    Env* env, const std::string& directory, const std::string& merged_prefix) {
+  std::vector<std::string> index_files;
+  TF_RETURN_IF_ERROR(env->GetMatchingPaths(
+      io::JoinPath(directory, absl::StrCat("emergency*", kIndexSuffix)),
+      &index_files));
+  if (index_files.empty()) {
+    return errors::NotFound("No emergency checkpoint found in ", directory);
+  }
+  std::vector<tstring> prefixes;
+  prefixes.reserve(index_files.size());
+  for (const std::string& index_file : index_files) {
+    prefixes.emplace_back(absl::string_view(index_file)
+                              .substr(0, index_file.size() -
+                                             strlen(kIndexSuffix)));
+  }
+  return MergeBundles(env, prefixes, merged_prefix);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PREEMPTION_PREEMPTION_CHECKPOINTER_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PREEMPTION_PREEMPTION_CHECKPOINTER_H_
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/distributed_runtime/preemption/preemption_notifier.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+
+// Writes an emergency checkpoint of the variables owned by the local task as
+// soon as a preemption notice is received.
+//
+// A regular checkpoint after the preemption sync point often does not finish
+// within the grace period of preemptible VMs. Instead, each task writes only
+// the tensors it owns, straight to a directory on local disk (or any file
+// system reachable from the task), split into several tensor bundles that
+// are written in parallel. After the restart, `MergeCheckpoints()` merges the
+// bundles written by all tasks into a single checkpoint, which can be restored
+// like any other.
+//
+// Example:
+//
+//    PreemptionCheckpointer checkpointer(
+//        env, {/*directory=*/"/local/emergency", /*task_name=*/task_name},
+//        [&]() { return SnapshotLocalVariables(); });
+//    checkpointer.SaveOnPreemption(notifier);
+//    ...
+//    // After the restart, on one of the tasks:
+//    TF_RETURN_IF_ERROR(PreemptionCheckpointer::MergeCheckpoints(
+//        env, "/local/emergency", "/local/emergency/merged"));
+class PreemptionCheckpointer {
+ public:
+  struct Options {
+    // Directory the bundles of all tasks are written to.
+    std::string directory;
+    // Name of the local task, which must be unique among the tasks writing to
+    // `directory`.
+    std::string task_name;
+    // Number of bundles written in parallel by the local task.
+    int num_shards = 4;
+  };
+
+  // Returns the tensors to save, keyed by checkpoint key. Called on a
+  // background thread once a save starts, so it must take care of reading the
+  // variables consistently.
+  using TensorProvider =
+      std::function<StatusOr<std::vector<std::pair<std::string, Tensor>>>()>;
+
+  PreemptionCheckpointer(Env* env, Options options, TensorProvider provider);
+  // Waits for any save triggered by a preemption notice to finish.
+  ~PreemptionCheckpointer();
+
+  // Starts a save on a background thread when `notifier` receives a
+  // preemption notice. `notifier` must outlive this object, or be reset
+  // before it is destroyed. Must be called at most once.
+  void SaveOnPreemption(PreemptionNotifier* notifier);
+
+  // Saves the tensors returned by the provider now, and blocks until the
+  // bundles are written.
+  Status Save();
+
+  // Blocks until the save triggered by a preemption notice is done, and
+  // returns its status. Returns errors::Cancelled if the notifier is reset
+  // before a notice is received.
+  Status WaitForSave();
+
+  // Merges the bundles written to `directory` by all tasks into a single
+  // checkpoint with prefix `merged_prefix`. Bundles whose write did not
+  // complete are skipped.
+  static Status MergeCheckpoints(Env* env, const std::string& directory,
+                                 const std::string& merged_prefix);
+
+ private:
+  Env* const env_;  // Not owned.
+  const Options options_;
+  const TensorProvider provider_;
+
+  mutex mu_;
+  condition_variable cv_;
+  bool save_requested_ TF_GUARDED_BY(mu_) = false;
+  bool save_done_ TF_GUARDED_BY(mu_) = false;
+  Status save_status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PreemptionCheckpointer);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_PREEMPTION_PREEMPTION_CHECKPOINTER_H_
@@ -0,0 +1,131 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/distributed_runtime/preemption/preemption_checkpointer.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "tensorflow/core/distributed_runtime/preemption/preemption_notifier.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+// Delivers preemption notices on demand.
+class TestPreemptionNotifier : public PreemptionNotifier {
+ public:
+  explicit TestPreemptionNotifier(Env* env) : PreemptionNotifier(env) {}
+  void Notify(StatusOr<absl::Time> death_time) {
+    NotifyRegisteredListeners(death_time);
+  }
+};
+
+// Returns `num_tensors` tensors with keys and values that depend on `task`.
+PreemptionCheckpointer::TensorProvider TensorsOfTask(int task,
+                                                     int num_tensors) {
+  return [task, num_tensors]() {
+    std::vector<std::pair<std::string, Tensor>> tensors;
+    for (int i = 0; i < num_tensors; ++i) {
+      tensors.emplace_back(absl::StrCat("task", task, "/var", i),
+                           test::AsTensor<float>({1.0f * task, 1.0f * i}));
+    }
+    return tensors;
+  };
+}
+
+void ExpectTensorsOfTask(BundleReader* reader, int task, int num_tensors) {
+  for (int i = 0; i < num_tensors; ++i) {
+    Tensor value;
+    TF_ASSERT_OK(reader->Lookup(absl::StrCat("task", task, "/var", i), &value));
+    test::ExpectTensorEqual<float>(
+        value, test::AsTensor<float>({1.0f * task, 1.0f * i}));
+  }
+}
+
+TEST(PreemptionCheckpointerTest, SaveAndMergeTasks) {
+  Env* env = Env::Default();
+  const std::string dir = io::JoinPath(testing::TmpDir(), "save_and_merge");
+  for (int task = 0; task < 2; ++task) {
+    PreemptionCheckpointer checkpointer(
+        env,
+        {/*directory=*/dir,
+         /*task_name=*/absl::StrCat("/job:worker/replica:0/task:", task),
+         /*num_shards=*/3},
+        TensorsOfTask(task, /*num_tensors=*/10));
+    TF_ASSERT_OK(checkpointer.Save());
+  }
+
+  const std::string merged = io::JoinPath(dir, "merged");
+  TF_ASSERT_OK(PreemptionCheckpointer::MergeCheckpoints(env, dir, merged));
+  BundleReader reader(env, merged);
+  TF_ASSERT_OK(reader.status());
+  ExpectTensorsOfTask(&reader, /*task=*/0, /*num_tensors=*/10);
+  ExpectTensorsOfTask(&reader, /*task=*/1, /*num_tensors=*/10);
+}
+
+TEST(PreemptionCheckpointerTest, SavesOnPreemptionNotice) {
+  Env* env = Env::Default();
+  const std::string dir = io::JoinPath(testing::TmpDir(), "on_preemption");
+  TestPreemptionNotifier notifier(env);
+  PreemptionCheckpointer checkpointer(
+      env, {/*directory=*/dir, /*task_name=*/"worker0"},
+      TensorsOfTask(/*task=*/0, /*num_tensors=*/2));
+  checkpointer.SaveOnPreemption(&notifier);
+
+  notifier.Notify(absl::Now() + absl::Minutes(1));
+  TF_ASSERT_OK(checkpointer.WaitForSave());
+
+  const std::string merged = io::JoinPath(dir, "merged");
+  TF_ASSERT_OK(PreemptionCheckpointer::MergeCheckpoints(env, dir, merged));
+  BundleReader reader(env, merged);
+  TF_ASSERT_OK(reader.status());
+  ExpectTensorsOfTask(&reader, /*task=*/0, /*num_tensors=*/2);
+}
+
+TEST(PreemptionCheckpointerTest, NotifierCancelled) {
+  Env* env = Env::Default();
+  TestPreemptionNotifier notifier(env);
+  PreemptionCheckpointer checkpointer(
+      env,
+      {/*directory=*/io::JoinPath(testing::TmpDir(), "cancelled"),
+       /*task_name=*/"worker0"},
+      TensorsOfTask(/*task=*/0, /*num_tensors=*/2));
+  checkpointer.SaveOnPreemption(&notifier);
+
+  notifier.Notify(errors::Cancelled("Notifier is shutting down."));
+  EXPECT_TRUE(errors::IsCancelled(checkpointer.WaitForSave()));
+}
+
+TEST(PreemptionCheckpointerTest, MergeWithoutCheckpoint) {
+  Env* env = Env::Default();
+  const std::string dir = io::JoinPath(testing::TmpDir(), "empty");
+  TF_ASSERT_OK(env->RecursivelyCreateDir(dir));
+  EXPECT_TRUE(errors::IsNotFound(PreemptionCheckpointer::MergeCheckpoints(
+      env, dir, io::JoinPath(dir, "merged"))));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -163,6 +163,21 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
   };
 }
 
+ChannelCreationFunction ConvertToChannelCreationFunction(
+    const std::function<Status(string, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr,
+    const RPCOptions& rpc_options) {
+  return [new_channel_func_ptr,
+          rpc_options](const string& target) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel_ptr;
+    if (new_channel_func_ptr(target, &rpc_options, &channel_ptr).ok()) {
+      return channel_ptr;
+    } else {
+      return nullptr;
+    }
+  };
+}
+
 Status GrpcChannelSpec::AddHostPortsJob(const string& job_id,
                                         const std::vector<string>& host_ports) {
   std::map<int, string> host_ports_map;
@@ -195,8 +210,11 @@ using CachingGrpcChannelCache = GenericCachingChannelCache<GrpcChannelCache>;
 class MultiGrpcChannelCache : public CachingGrpcChannelCache {
  public:
   explicit MultiGrpcChannelCache(const std::vector<GrpcChannelCache*>& caches,
-                                 int num_channels_per_target)
-      : CachingGrpcChannelCache(num_channels_per_target), caches_(caches) {}
+                                 int num_channels_per_target,
+                                 int num_bulk_channels_per_target)
+      : CachingGrpcChannelCache(num_channels_per_target,
+                                num_bulk_channels_per_target),
+        caches_(caches) {}
 
   ~MultiGrpcChannelCache() override {
     for (GrpcChannelCache* cache : caches_) {
@@ -248,6 +266,18 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
     return nullptr;
   }
 
+  SharedGrpcChannelPtr FindBulkChannelOnce(const string& target) override {
+    for (GrpcChannelCache* cache : caches_) {
+      SharedGrpcChannelPtr ch(cache->FindWorkerBulkChannel(target));
+      if (ch) {
+        mutex_lock l(mu_);
+        target_caches_.insert({target, cache});
+        return ch;
+      }
+    }
+    return nullptr;
+  }
+
  private:
   // List of channels used by this MultiGrpcChannelCache.
   const std::vector<GrpcChannelCache*> caches_;
@@ -264,11 +294,15 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   SparseGrpcChannelCache(const string& job_id,
                          const std::map<int, string>& host_ports,
                          ChannelCreationFunction channel_func,
-                         int num_channels_per_target)
-      : CachingGrpcChannelCache(num_channels_per_target),
+                         int num_channels_per_target,
+                         ChannelCreationFunction bulk_channel_func = nullptr,
+                         int num_bulk_channels_per_target = 0)
+      : CachingGrpcChannelCache(num_channels_per_target,
+                                num_bulk_channels_per_target),
         job_id_(job_id),
         host_ports_(host_ports),
-        channel_func_(std::move(channel_func)) {
+        channel_func_(std::move(channel_func)),
+        bulk_channel_func_(std::move(bulk_channel_func)) {
     VLOG(2) << "Initialize GrpcChannelCache for job " << ToString();
   }
   ~SparseGrpcChannelCache() override {}
@@ -324,6 +358,21 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
     return chan_ptr;
   }
 
+  SharedGrpcChannelPtr FindBulkChannelOnce(const string& target) override {
+    if (!bulk_channel_func_) {
+      return FindChannelOnce(target);
+    }
+    const string host_port = TranslateTask(target);
+    if (host_port.empty()) {
+      return nullptr;
+    }
+    auto chan_ptr = bulk_channel_func_(host_port);
+    VLOG(5) << "Bulk channel created for: job: " << job_id_
+            << " host_port: " << host_port << " target : " << target
+            << " Ptr: " << chan_ptr.get();
+    return chan_ptr;
+  }
+
  private:
   string ToString() {
     std::vector<string> task_strings;
@@ -339,14 +388,15 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   const string job_id_;
   const std::map<int, string> host_ports_;
   const ChannelCreationFunction channel_func_;
+  const ChannelCreationFunction bulk_channel_func_;
   TF_DISALLOW_COPY_AND_ASSIGN(SparseGrpcChannelCache);
 };
 
 }  // namespace
 
-GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
-                                      ChannelCreationFunction channel_func,
-                                      const RPCOptions& options) {
+GrpcChannelCache* NewGrpcChannelCache(
+    const GrpcChannelSpec& spec, ChannelCreationFunction channel_func,
+    const RPCOptions& options, ChannelCreationFunction bulk_channel_func) {
   const int num_jobs = spec.host_ports_jobs().size();
   if (!num_jobs) {
     LOG(ERROR) << "Empty channel spec.";
@@ -356,13 +406,16 @@ GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
   caches.reserve(num_jobs);
   for (auto& job : spec.host_ports_jobs()) {
     VLOG(2) << "Creating Grpc Channel Cache for: " << job.job_id;
-    caches.push_back(
-        new SparseGrpcChannelCache(job.job_id, job.host_ports, channel_func,
-                                   options.num_channels_per_target()));
+    caches.push_back(new SparseGrpcChannelCache(
+        job.job_id, job.host_ports, channel_func,
+        options.num_channels_per_target(), bulk_channel_func,
+        options.num_bulk_channels_per_target()));
   }
-  return caches.size() == 1 ? caches[0]
-                            : new MultiGrpcChannelCache(
-                                  caches, options.num_channels_per_target());
+  return caches.size() == 1
+             ? caches[0]
+             : new MultiGrpcChannelCache(
+                   caches, options.num_channels_per_target(),
+                   options.num_bulk_channels_per_target());
 }
 
 }  // end namespace tensorflow
@@ -75,15 +75,25 @@ class GrpcChannelCache {
   // E.g., /job:mnist/task:2
   virtual SharedGrpcChannelPtr FindWorkerChannel(const string& target) = 0;
 
+  // Returns a gRPC channel to 'target' for bulk tensor transfers. By default
+  // this is the same as FindWorkerChannel().
+  virtual SharedGrpcChannelPtr FindWorkerBulkChannel(const string& target) {
+    return FindWorkerChannel(target);
+  }
+
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
 };
 
 typedef std::function<SharedGrpcChannelPtr(string)> ChannelCreationFunction;
 
+// If `rpc_options.num_bulk_channels_per_target()` is positive, the channels
+// returned by FindWorkerBulkChannel() are created with `bulk_channel_func`, or
+// with `channel_func` if it is nullptr.
 GrpcChannelCache* NewGrpcChannelCache(
     const GrpcChannelSpec& channel_spec, ChannelCreationFunction channel_func,
-    const RPCOptions& rpc_options = RPCOptions());
+    const RPCOptions& rpc_options = RPCOptions(),
+    ChannelCreationFunction bulk_channel_func = nullptr);
 
 // Below here are internal-only functions.
 
@@ -93,6 +103,12 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
     const std::function<Status(string, const RPCOptions*,
                                SharedGrpcChannelPtr*)>& new_channel_func_ptr);
 
+// As above, but passes a copy of `rpc_options` to `new_channel_func_ptr`.
+ChannelCreationFunction ConvertToChannelCreationFunction(
+    const std::function<Status(string, const RPCOptions*,
+                               SharedGrpcChannelPtr*)>& new_channel_func_ptr,
+    const RPCOptions& rpc_options);
+
 Status NewHostPortGrpcChannel(const string& target,
                               const RPCOptions* rpc_options,
                               SharedGrpcChannelPtr* channel_pointer);
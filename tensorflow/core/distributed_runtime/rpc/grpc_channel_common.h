@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_COMMON_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_COMMON_H_
 
+#include <algorithm>
+#include <functional>
 #include <unordered_map>
 #include <vector>
 
@@ -32,36 +34,80 @@ namespace tensorflow {
 // same target to provide throughput gains. When multiple channels exist for
 // the same target they are chosen in a simple round robin fashion on each call
 // to FindWorkerChannel.
+//
+// If `num_bulk_channels_per_target` is positive, FindWorkerBulkChannel()
+// round robins over a separate set of channels created by
+// FindBulkChannelOnce(), so that bulk tensor transfers do not share channels
+// with control RPCs.
 template <typename ChannelCacheT>
 class GenericCachingChannelCache : public ChannelCacheT {
  public:
-  explicit GenericCachingChannelCache(int num_channels_per_target)
+  explicit GenericCachingChannelCache(int num_channels_per_target,
+                                      int num_bulk_channels_per_target = 0)
       : num_channels_per_target_(
-            num_channels_per_target > 0 ? num_channels_per_target : 1) {}
+            num_channels_per_target > 0 ? num_channels_per_target : 1),
+        num_bulk_channels_per_target_(std::max(num_bulk_channels_per_target,
+                                               0)) {}
 
   ~GenericCachingChannelCache() override {}
 
   SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
+    return FindOrCreateChannel(
+        target, num_channels_per_target_, &channels_,
+        [this](const string& target) { return FindChannelOnce(target); });
+  }
+
+  SharedGrpcChannelPtr FindWorkerBulkChannel(const string& target) override {
+    if (num_bulk_channels_per_target_ == 0) {
+      return FindWorkerChannel(target);
+    }
+    return FindOrCreateChannel(
+        target, num_bulk_channels_per_target_, &bulk_channels_,
+        [this](const string& target) { return FindBulkChannelOnce(target); });
+  }
+
+ protected:
+  // Find the ClientChannel for "target".  Only called when no channel was
+  // found in the channels_ cache for "target".  A non nullptr result will be
+  // cached in channels_.
+  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
+
+  // Like FindChannelOnce(), for the channels returned by
+  // FindWorkerBulkChannel(). Defaults to FindChannelOnce().
+  virtual SharedGrpcChannelPtr FindBulkChannelOnce(const string& target) {
+    return FindChannelOnce(target);
+  }
+
+ private:
+  struct ChannelState {
+    std::vector<SharedGrpcChannelPtr> channels;
+    int last_used;
+  };
+  using ChannelMap = absl::flat_hash_map<string, ChannelState>;
+
+  SharedGrpcChannelPtr FindOrCreateChannel(
+      const string& target, int num_channels, ChannelMap* channels,
+      const std::function<SharedGrpcChannelPtr(const string&)>& create_fn) {
     {
       mutex_lock l(mu_);
-      auto iter = channels_.find(target);
-      if (iter != channels_.end()) {
+      auto iter = channels->find(target);
+      if (iter != channels->end()) {
         return GetNextChannelPtrAndUpdateState(iter->second);
       }
     }
     ChannelState new_chan_state;
-    for (int indx = 0; indx < num_channels_per_target_; indx++) {
-      auto ch = FindChannelOnce(target);
+    for (int indx = 0; indx < num_channels; indx++) {
+      auto ch = create_fn(target);
       if (!ch) return nullptr;
       new_chan_state.channels.push_back(ch);
     }
-    new_chan_state.last_used = num_channels_per_target_ - 1;
+    new_chan_state.last_used = num_channels - 1;
 
     {
       mutex_lock l(mu_);
-      typename absl::flat_hash_map<string, ChannelState>::iterator iter;
+      typename ChannelMap::iterator iter;
       bool was_inserted;
-      std::tie(iter, was_inserted) = channels_.insert({target, new_chan_state});
+      std::tie(iter, was_inserted) = channels->insert({target, new_chan_state});
       VLOG(2) << "Channel cache for target: " << target
               << " Size: " << new_chan_state.channels.size()
               << " insertion: " << was_inserted;
@@ -69,33 +115,23 @@ class GenericCachingChannelCache : public ChannelCacheT {
     }
   }
 
- protected:
-  // Find the ClientChannel for "target".  Only called when no channel was
-  // found in the channels_ cache for "target".  A non nullptr result will be
-  // cached in channels_.
-  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
-
- private:
-  struct ChannelState {
-    std::vector<SharedGrpcChannelPtr> channels;
-    int last_used;
-  };
-
   // Should be called with mu_ held.
   SharedGrpcChannelPtr GetNextChannelPtrAndUpdateState(
       ChannelState& chan_state) {
     // Following statement is marked as Crash OK as this is an invariant of
     // code flow in this class.
-    CHECK_EQ(chan_state.channels.size(), num_channels_per_target_);  // Crash OK
+    CHECK(!chan_state.channels.empty());  // Crash OK
     chan_state.last_used =
-        (chan_state.last_used + 1) % num_channels_per_target_;
+        (chan_state.last_used + 1) % chan_state.channels.size();
     return chan_state.channels[chan_state.last_used];
   }
 
   const int num_channels_per_target_;
+  const int num_bulk_channels_per_target_;
   // TODO(zhifengc): Eviction when the map becomes too big.
   mutex mu_;
-  absl::flat_hash_map<string, ChannelState> channels_ TF_GUARDED_BY(mu_);
+  ChannelMap channels_ TF_GUARDED_BY(mu_);
+  ChannelMap bulk_channels_ TF_GUARDED_BY(mu_);
 };
 
 }  // namespace tensorflow
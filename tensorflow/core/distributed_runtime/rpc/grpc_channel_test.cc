@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -288,6 +289,57 @@ TEST(GrpcChannelTest, HostPortsMultiGrpcMultiChannelPerTarget) {
   }
 }
 
+TEST(GrpcChannelTest, HostPortsBulkChannelsPerTarget) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(
+      spec.AddHostPortsJob("mnist", std::vector<string>({"a:1", "b:2"})));
+  TF_EXPECT_OK(spec.AddHostPortsJob("other", std::vector<string>({"c:3"})));
+  ChannelCreationFunction channel_func =
+      ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
+  int num_bulk_channels_created = 0;
+  ChannelCreationFunction bulk_channel_func =
+      [&num_bulk_channels_created, &channel_func](const string& target) {
+        ++num_bulk_channels_created;
+        return channel_func(target);
+      };
+  RPCOptions rpc_options;
+  rpc_options.set_num_channels_per_target(2);
+  rpc_options.set_num_bulk_channels_per_target(3);
+  std::unique_ptr<GrpcChannelCache> cc(NewGrpcChannelCache(
+      spec, channel_func, rpc_options, bulk_channel_func));
+
+  EXPECT_EQ(nullptr, cc->FindWorkerBulkChannel("invalid_target"));
+  EXPECT_EQ(nullptr, cc->FindWorkerBulkChannel("/job:mnist/replica:0/task:2"));
+
+  for (const string& target :
+       {"/job:mnist/replica:0/task:0", "/job:other/replica:0/task:0"}) {
+    std::set<::grpc::Channel*> channels, bulk_channels;
+    for (int i = 0; i < 6; ++i) {
+      channels.insert(cc->FindWorkerChannel(target).get());
+      bulk_channels.insert(cc->FindWorkerBulkChannel(target).get());
+    }
+    EXPECT_EQ(channels.size(), 2) << target;
+    EXPECT_EQ(bulk_channels.size(), 3) << target;
+    for (::grpc::Channel* ch : bulk_channels) {
+      EXPECT_EQ(channels.count(ch), 0) << target;
+    }
+  }
+  EXPECT_EQ(num_bulk_channels_created, 6);
+}
+
+TEST(GrpcChannelTest, HostPortsNoBulkChannels) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(spec.AddHostPortsJob("mnist", std::vector<string>({"a:1"})));
+  ChannelCreationFunction channel_func =
+      ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
+  std::unique_ptr<GrpcChannelCache> cc(
+      NewGrpcChannelCache(spec, channel_func, RPCOptions()));
+
+  // Without bulk channels, tensor transfers use the regular channel.
+  EXPECT_EQ(cc->FindWorkerChannel("/job:mnist/replica:0/task:0").get(),
+            cc->FindWorkerBulkChannel("/job:mnist/replica:0/task:0").get());
+}
+
 TEST(GrpcChannelTest, SparseHostPorts) {
   GrpcChannelSpec spec;
   TF_EXPECT_OK(
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
 
+#include <atomic>
+#include <functional>
 #include <utility>
 
+#include "absl/container/flat_hash_map.h"
 #include "grpcpp/generic/generic_stub.h"
 #include "grpcpp/grpcpp.h"
 #include "tensorflow/core/common_runtime/process_util.h"
@@ -31,23 +34,138 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/tracing.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/protobuf/transport_options.pb.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 #include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* inflight_rpcs = monitoring::Gauge<std::function<int64_t()>, 2>::New(
+    "/tensorflow/core/grpc_remote_worker/inflight_rpcs",
+    "The number of in-flight RPCs on the channels to a worker.", "target",
+    "channel");
+
+auto* request_bytes = monitoring::Counter<2>::New(
+    "/tensorflow/core/grpc_remote_worker/request_bytes",
+    "The number of bytes of the requests sent on the channels to a worker.",
+    "target", "channel");
+
+auto* response_bytes = monitoring::Counter<2>::New(
+    "/tensorflow/core/grpc_remote_worker/response_bytes",
+    "The number of bytes of the responses received on the channels to a "
+    "worker.",
+    "target", "channel");
+
+auto* rpc_queue_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/grpc_remote_worker/rpc_queue_usecs",
+     "Microseconds between the completion of an RPC to a worker and the start "
+     "of the processing of its response.",
+     "target"},
+    // Power of 2 with bucket count 24 (> 8 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 24)});
+
+auto* rpc_retries = monitoring::Counter<1>::New(
+    "/tensorflow/core/grpc_remote_worker/rpc_retries",
+    "The number of retries of the RPCs to a worker.", "target");
+
+auto* transfer_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/grpc_remote_worker/transfer_usecs",
+     "Microseconds spent receiving a tensor from a worker.", "target",
+     "method"},
+    // Power of 2 with bucket count 27 (> 67 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 27)});
+
+auto* transfer_bytes = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/grpc_remote_worker/transfer_bytes",
+     "The size in bytes of a tensor received from a worker.", "target",
+     "method"},
+    // Power of 4 with bucket count 17 (4GB)
+    {monitoring::Buckets::Exponential(1, 4, 17)});
+
+// Latency and size histograms of one kind of tensor transfer from a target.
+struct TransferStats {
+  monitoring::SamplerCell* usecs;
+  monitoring::SamplerCell* bytes;
+
+  void Record(int64_t usecs_value, int64_t bytes_value) const {
+    usecs->Add(usecs_value);
+    bytes->Add(bytes_value);
+  }
+};
+
+// Statistics of one class of channels ("control" or "bulk") to a target,
+// shared by all the GrpcRemoteWorker objects for that target. Never deleted.
+struct ChannelStats {
+  std::atomic<int64_t> inflight_rpcs{0};
+  monitoring::CounterCell* request_bytes;
+  monitoring::CounterCell* response_bytes;
+  monitoring::SamplerCell* rpc_queue_usecs;
+  monitoring::CounterCell* rpc_retries;
+  TransferStats recv_tensor;
+  TransferStats recv_buf;
+};
+
+ChannelStats* GetChannelStats(const string& target, const string& channel) {
+  static mutex* mu = new mutex;
+  static auto* stats =
+      new absl::flat_hash_map<std::pair<string, string>, ChannelStats*>;
+  mutex_lock l(*mu);
+  ChannelStats*& s = (*stats)[{target, channel}];
+  if (s == nullptr) {
+    s = new ChannelStats;
+    s->request_bytes = request_bytes->GetCell(target, channel);
+    s->response_bytes = response_bytes->GetCell(target, channel);
+    s->rpc_queue_usecs = rpc_queue_usecs->GetCell(target);
+    s->rpc_retries = rpc_retries->GetCell(target);
+    s->recv_tensor = {transfer_usecs->GetCell(target, "RecvTensor"),
+                      transfer_bytes->GetCell(target, "RecvTensor")};
+    s->recv_buf = {transfer_usecs->GetCell(target, "RecvBuf"),
+                   transfer_bytes->GetCell(target, "RecvBuf")};
+    inflight_rpcs->GetCell(target, channel)->Set([s]() -> int64_t {
+      return s->inflight_rpcs.load(std::memory_order_relaxed);
+    });
+  }
+  return s;
+}
+
+int64_t ResponseBytes(const protobuf::Message& response) {
+  return response.ByteSizeLong();
+}
+
+int64_t ResponseBytes(const TensorResponse& response) {
+  return response.tensor().TotalBytes();
+}
+
+}  // namespace
+
 class GrpcRemoteWorker : public WorkerInterface {
  public:
+  // If `bulk_channel` is not nullptr, tensor transfers (RecvTensor,
+  // RecvTensorBatch and RecvBuf) are issued on it instead of on `channel`.
   explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
                             ::grpc::CompletionQueue* completion_queue,
                             thread::ThreadPool* callback_threadpool,
-                            WorkerCacheLogger* logger, const string& target)
+                            WorkerCacheLogger* logger, const string& target,
+                            SharedGrpcChannelPtr bulk_channel = nullptr)
       : channel_(std::move(channel)),
         stub_(channel_),
+        bulk_channel_(bulk_channel ? std::move(bulk_channel) : channel_),
+        bulk_stub_(bulk_channel_),
+        control_stats_(GetChannelStats(target, "control")),
+        bulk_stats_(bulk_channel_ == channel_
+                        ? control_stats_
+                        : GetChannelStats(target, "bulk")),
         cq_(completion_queue),
         callback_threadpool_(callback_threadpool),
         getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
@@ -66,6 +184,7 @@ class GrpcRemoteWorker : public WorkerInterface {
         instancesource_(Method(GrpcWorkerMethod::kCompleteInstance)),
         getstepsequence_(Method(GrpcWorkerMethod::kGetStepSequence)),
         markrecvfinished_(Method(GrpcWorkerMethod::kMarkRecvFinished)),
+        recvtensorbatch_(Method(GrpcWorkerMethod::kRecvTensorBatch)),
         logger_(logger),
         target_(target) {}
 
@@ -130,14 +249,25 @@ class GrpcRemoteWorker : public WorkerInterface {
   void RecvBufAsync(CallOptions* call_opts, const RecvBufRequest* request,
                     RecvBufResponse* response, StatusCallback done) override {
     int64_t start_usec = Env::Default()->NowMicros();
+    int64_t trace_id = profiler::TraceMe::ActivityStart([this, request]() {
+      return profiler::TraceMeEncode(
+          "RecvBuf",
+          {{"peer", target_}, {"key", request->buf_rendezvous_key()}});
+    });
     // Type-specialized logging for this method.
     bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
 
-    auto callback = [this, request, response, done, start_usec,
+    auto callback = [this, request, response, done, start_usec, trace_id,
                      logging_active](Status s) {
+      profiler::TraceMe::ActivityEnd(trace_id);
+      int64_t end_usec = Env::Default()->NowMicros();
+      if (s.ok()) {
+        bulk_stats_->recv_buf.Record(
+            end_usec - start_usec,
+            response->transport_options().value().size());
+      }
       if (logging_active) {
         if (logger_->LoggingActive()) {
-          int64_t end_usec = Env::Default()->NowMicros();
           int64_t step_id = request->step_id();
           RecvBufRespExtra extra;
           response->transport_options().UnpackTo(&extra);
@@ -170,7 +300,7 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvbuf_, callback, call_opts);
+    IssueBulkRequest(request, response, recvbuf_, callback, call_opts);
   }
 
   void CompleteGroupAsync(CallOptions* call_opts,
@@ -199,14 +329,24 @@ class GrpcRemoteWorker : public WorkerInterface {
                        TensorResponse* response, StatusCallback done) override {
     VLOG(1) << "RecvTensorAsync req: " << request->DebugString();
     int64_t start_usec = Env::Default()->NowMicros();
+    int64_t trace_id = profiler::TraceMe::ActivityStart([this, request]() {
+      return profiler::TraceMeEncode(
+          "RecvTensor",
+          {{"peer", target_}, {"key", request->rendezvous_key()}});
+    });
     // Type-specialized logging for this method.
     bool logging_active = logger_->LoggingActive() || VLOG_IS_ON(2);
 
-    auto callback = [this, request, response, done, start_usec,
+    auto callback = [this, request, response, done, start_usec, trace_id,
                      logging_active](Status s) {
+      profiler::TraceMe::ActivityEnd(trace_id);
+      int64_t end_usec = Env::Default()->NowMicros();
+      if (s.ok()) {
+        bulk_stats_->recv_tensor.Record(end_usec - start_usec,
+                                        response->tensor().TotalBytes());
+      }
       if (logging_active) {
         if (logger_->LoggingActive()) {
-          int64_t end_usec = Env::Default()->NowMicros();
           int64_t step_id = request->step_id();
           int64_t bytes = response->tensor().TotalBytes();
           int64_t send_start_usec = start_usec;
@@ -253,7 +393,34 @@ class GrpcRemoteWorker : public WorkerInterface {
       done(s);
     };
 
-    IssueRequest(request, response, recvtensor_, callback, call_opts);
+    IssueBulkRequest(request, response, recvtensor_, callback, call_opts);
+  }
+
+  void RecvTensorBatchAsync(CallOptions* call_opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    VLOG(1) << "RecvTensorBatchAsync for " << request->requests_size()
+            << " tensors";
+    auto callback = [this, request, response, done](Status s) {
+      if (s.ok() && response->responses_size() != request->requests_size()) {
+        s = errors::Internal("RecvTensorBatch returned ",
+                             response->responses_size(), " tensors, expected ",
+                             request->requests_size());
+      }
+      if (s.ok()) {
+        for (int i = 0; i < response->responses_size(); ++i) {
+          if (response->responses(i).require_ack()) {
+            IssueMarkRecvFinishedRequest(request->requests(i).request_id());
+          }
+        }
+      }
+      // Note done() can delete this worker object, so we need to call done()
+      // last.
+      done(s);
+    };
+
+    IssueBulkRequest(request, response, recvtensorbatch_, callback, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -273,18 +440,46 @@ class GrpcRemoteWorker : public WorkerInterface {
                     protobuf::Message* response, const ::grpc::string& method,
                     StatusCallback done, CallOptions* call_opts = nullptr,
                     bool fail_fast = true) {
-    new RPCState<protobuf::Message>(
-        &stub_, cq_, method, *request, response, std::move(done), call_opts,
-        callback_threadpool_, MaxRetries(), fail_fast, &target_);
+    IssueRequestOnChannel(&stub_, control_stats_, request, response, method,
+                          std::move(done), call_opts, fail_fast);
+  }
+
+  // Like IssueRequest(), on the channel used for tensor transfers.
+  template <typename Response>
+  void IssueBulkRequest(const protobuf::Message* request, Response* response,
+                        const ::grpc::string& method, StatusCallback done,
+                        CallOptions* call_opts) {
+    IssueRequestOnChannel(&bulk_stub_, bulk_stats_, request, response, method,
+                          std::move(done), call_opts, /*fail_fast=*/true);
   }
 
-  void IssueRequest(const protobuf::Message* request, TensorResponse* response,
-                    const ::grpc::string& method, StatusCallback done,
-                    CallOptions* call_opts = nullptr) {
-    new RPCState<TensorResponse>(&stub_, cq_, method, *request, response,
-                                 std::move(done), call_opts,
-                                 callback_threadpool_, MaxRetries(),
-                                 /*fail_fast=*/true, &target_);
+  template <typename Response>
+  void IssueRequestOnChannel(::grpc::GenericStub* stub, ChannelStats* stats,
+                             const protobuf::Message* request,
+                             Response* response, const ::grpc::string& method,
+                             StatusCallback done, CallOptions* call_opts,
+                             bool fail_fast) {
+    stats->inflight_rpcs.fetch_add(1, std::memory_order_relaxed);
+    stats->request_bytes->IncrementBy(request->ByteSizeLong());
+    auto rpc_stats = std::make_shared<RPCStats>();
+    RPCStats* rpc_stats_ptr = rpc_stats.get();
+    // `done` may delete this worker, so the callback must not use `this`.
+    auto callback = [stats, response, rpc_stats = std::move(rpc_stats),
+                     done = std::move(done)](Status s) {
+      if (s.ok()) {
+        stats->response_bytes->IncrementBy(ResponseBytes(*response));
+        stats->rpc_queue_usecs->Add(rpc_stats->queue_usecs);
+      }
+      if (rpc_stats->num_retries > 0) {
+        stats->rpc_retries->IncrementBy(rpc_stats->num_retries);
+      }
+      stats->inflight_rpcs.fetch_sub(1, std::memory_order_relaxed);
+      done(s);
+    };
+    new RPCState<Response>(stub, cq_, method, *request, response,
+                           std::move(callback), call_opts,
+                           callback_threadpool_, MaxRetries(), fail_fast,
+                           &target_, rpc_stats_ptr);
   }
 
   void IssueMarkRecvFinishedRequest(int64_t request_id) {
@@ -310,6 +505,12 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   SharedGrpcChannelPtr channel_;
   ::grpc::GenericStub stub_;
+  // Channel for tensor transfers, which is `channel_` if no separate channel
+  // was provided.
+  SharedGrpcChannelPtr bulk_channel_;
+  ::grpc::GenericStub bulk_stub_;
+  ChannelStats* const control_stats_;
+  ChannelStats* const bulk_stats_;
   ::grpc::CompletionQueue* cq_;
   thread::ThreadPool* callback_threadpool_;
 
@@ -329,6 +530,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::string instancesource_;
   const ::grpc::string getstepsequence_;
   const ::grpc::string markrecvfinished_;
+  const ::grpc::string recvtensorbatch_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -341,9 +543,11 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      thread::ThreadPool* callback_threadpool,
                                      WorkerCacheLogger* logger,
-                                     const string& target) {
+                                     const string& target,
+                                     SharedGrpcChannelPtr bulk_channel) {
   return new GrpcRemoteWorker(std::move(channel), completion_queue,
-                              callback_threadpool, logger, target);
+                              callback_threadpool, logger, target,
+                              std::move(bulk_channel));
 }
 
 }  // namespace tensorflow
@@ -26,11 +26,12 @@ namespace tensorflow {
 class WorkerCacheLogger;
 class WorkerInterface;
 
-WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
-                                     ::grpc::CompletionQueue* completion_queue,
-                                     thread::ThreadPool* callback_threadpool,
-                                     WorkerCacheLogger* logger,
-                                     const string& target);
+// If `bulk_channel` is not nullptr, tensor transfers are issued on it instead
+// of on `channel`.
+WorkerInterface* NewGrpcRemoteWorker(
+    SharedGrpcChannelPtr channel, ::grpc::CompletionQueue* completion_queue,
+    thread::ThreadPool* callback_threadpool, WorkerCacheLogger* logger,
+    const string& target, SharedGrpcChannelPtr bulk_channel = nullptr);
 
 }  // namespace tensorflow
 
@@ -392,7 +392,8 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
         "rpc_options not set in WorkerCacheFactoryOptions");
   }
   std::shared_ptr<GrpcChannelCache> channel_cache(NewGrpcChannelCache(
-      channel_spec, GetChannelCreationFunction(), *options.rpc_options));
+      channel_spec, GetChannelCreationFunction(), *options.rpc_options,
+      GetBulkChannelCreationFunction()));
 
   string name_prefix = strings::StrCat("/job:", *options.job_name, "/replica:0",
                                        "/task:", options.task_index);
@@ -571,6 +572,12 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+ChannelCreationFunction GrpcServer::GetBulkChannelCreationFunction() const {
+  RPCOptions rpc_options;
+  rpc_options.set_disable_session_connection_sharing(true);
+  return ConvertToChannelCreationFunction(NewHostPortGrpcChannel, rpc_options);
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
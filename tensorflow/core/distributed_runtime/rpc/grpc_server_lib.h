@@ -132,6 +132,13 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Returns the function used to create the channels for bulk tensor
+  // transfers when `RPCOptions.num_bulk_channels_per_target` is positive. By
+  // default these channels do not share TCP connections with other channels.
+  // A subclass that overrides GetChannelCreationFunction() should override
+  // this method too.
+  virtual ChannelCreationFunction GetBulkChannelCreationFunction() const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
@@ -36,9 +36,20 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Statistics about a unary RPC issued through RPCState, filled in before the
+// done callback is called.
+struct RPCStats {
+  // Number of times the call was retried.
+  int num_retries = 0;
+  // Microseconds between the completion of the call and the start of the
+  // processing of its response on the callback thread pool.
+  int64_t queue_usecs = 0;
+};
+
 // Object allocated per active RPC.
 // Manage the state of a single asynchronous RPC request.  If `max_retries`
 // is greater than 0, the request will be retried for any transient failures.
+// If `stats` is not nullptr, it is filled in before `done` is called.
 template <class Response>
 class RPCState : public GrpcClientCQTag {
  public:
@@ -46,7 +57,8 @@ class RPCState : public GrpcClientCQTag {
            const ::grpc::string& method, const protobuf::Message& request,
            Response* response, StatusCallback done, CallOptions* call_opts,
            thread::ThreadPool* threadpool, int32_t max_retries = 0,
-           bool fail_fast = true, const string* target = nullptr)
+           bool fail_fast = true, const string* target = nullptr,
+           RPCStats* stats = nullptr)
       : RPCState(
             stub, cq, method, request, response, std::move(done), call_opts,
             threadpool,
@@ -80,14 +92,15 @@ class RPCState : public GrpcClientCQTag {
               }
             }(),
             (call_opts != nullptr ? call_opts->GetTimeout() : 0), max_retries,
-            target) {}
+            target, stats) {}
 
   template <typename Request>
   RPCState(::grpc::GenericStub* stub, ::grpc::CompletionQueue* cq,
            const ::grpc::string& method, const Request& request,
            Response* response, StatusCallback done, CallOptions* call_opts,
            thread::ThreadPool* threadpool, bool fail_fast,
-           int64_t timeout_in_ms, int32_t max_retries, const string* target)
+           int64_t timeout_in_ms, int32_t max_retries, const string* target,
+           RPCStats* stats = nullptr)
       : call_opts_(call_opts),
         threadpool_(threadpool),
         done_(std::move(done)),
@@ -97,7 +110,8 @@ class RPCState : public GrpcClientCQTag {
         stub_(stub),
         method_(method),
         fail_fast_(fail_fast),
-        target_(target) {
+        target_(target),
+        stats_(stats) {
     response_ = response;
     ::grpc::Status s = GrpcMaybeUnparseProto(request, &request_buf_);
     if (!s.ok()) {
@@ -146,6 +160,10 @@ class RPCState : public GrpcClientCQTag {
     }
 
     if (s.ok()) {
+      if (stats_ != nullptr) {
+        stats_->num_retries = num_retries_;
+        completed_usecs_ = Env::Default()->NowMicros();
+      }
       if (threadpool_) {
         // Run parse and callback in another thread, returning this
         // one to service more RPCs.
@@ -186,12 +204,18 @@ class RPCState : public GrpcClientCQTag {
         s = StatusGroup::MakeDerived(s);
       }
 
+      if (stats_ != nullptr) {
+        stats_->num_retries = num_retries_ - 1;
+      }
       done_(s);
       delete this;
     }
   }
 
   void ParseAndCallDone() {
+    if (stats_ != nullptr) {
+      stats_->queue_usecs = Env::Default()->NowMicros() - completed_usecs_;
+    }
     Status s;
     if (!GrpcMaybeParseProto(&response_buf_, response_)) {
       s.Update(errors::Internal("could not parse rpc response"));
@@ -233,6 +257,8 @@ class RPCState : public GrpcClientCQTag {
   ::grpc::string method_;
   bool fail_fast_;
   const string* target_;
+  RPCStats* stats_;
+  int64_t completed_usecs_ = 0;
 };
 
 // Represents state associated with one streaming RPC call.
@@ -249,5 +249,31 @@ void EncodeTensorToByteBuffer(bool is_dead, const Tensor& val, bool require_ack,
   }
 }
 
+void EncodeRecvTensorBatchResponseToByteBuffer(
+    const std::vector<::grpc::ByteBuffer>& responses,
+    ::grpc::ByteBuffer* result) {
+  std::vector<::grpc::Slice> slices;
+  slices.reserve(2 * responses.size());
+  for (const ::grpc::ByteBuffer& response : responses) {
+    // The tag and length of each element of the repeated field are followed
+    // by the slices of the encoded response.
+    const size_t num_bytes = response.Length();
+    char header[2 * core::kMaxVarint32Bytes];
+    io::ProtoEncodeHelper e(header, sizeof(header));
+    e.WriteVarlengthBeginning(RecvTensorBatchResponse::kResponsesFieldNumber,
+                              num_bytes);
+    slices.emplace_back(e.data(), e.size());
+    std::vector<::grpc::Slice> response_slices;
+    if (num_bytes > 0) {
+      CHECK(response.Dump(&response_slices).ok());
+    }
+    for (::grpc::Slice& slice : response_slices) {
+      slices.push_back(std::move(slice));
+    }
+  }
+  ::grpc::ByteBuffer tmp(slices.data(), slices.size());
+  result->Swap(&tmp);
+}
+
 }  // namespace grpc
 }  // namespace tensorflow
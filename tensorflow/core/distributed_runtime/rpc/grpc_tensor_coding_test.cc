@@ -100,4 +100,39 @@ TEST_F(GrpcTensorCodingTest, Simple) {
 
 TEST_F(GrpcTensorCodingTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST_F(GrpcTensorCodingTest, BatchResponse) {
+  std::vector<Tensor> tensors;
+  tensors.push_back(test::AsTensor<float>({1.0, 2.0, 3.0}));
+  tensors.push_back(Tensor(DT_INT32, TensorShape({0})));
+  // Large enough for its content to be shared rather than copied.
+  Tensor large(DT_FLOAT, TensorShape({4096}));
+  test::FillFn<float>(&large, [](int i) { return static_cast<float>(i); });
+  tensors.push_back(large);
+  tensors.push_back(test::AsTensor<tstring>({"a", "bc"}));
+
+  std::vector<::grpc::ByteBuffer> responses(tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    grpc::EncodeTensorToByteBuffer(/*is_dead=*/i == 1, tensors[i],
+                                   /*require_ack=*/false, &responses[i]);
+  }
+  ::grpc::ByteBuffer buf;
+  grpc::EncodeRecvTensorBatchResponseToByteBuffer(responses, &buf);
+
+  std::vector<::grpc::Slice> slices;
+  (void)buf.Dump(&slices);
+  string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  RecvTensorBatchResponse batch;
+  ASSERT_TRUE(batch.ParseFromString(tmp));
+  ASSERT_EQ(batch.responses_size(), tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(batch.responses(i).is_dead(), i == 1);
+    Tensor result_tensor;
+    EXPECT_TRUE(result_tensor.FromProto(batch.responses(i).tensor()));
+    EXPECT_EQ(tensors[i].DebugString(), result_tensor.DebugString());
+  }
+}
+
 }  // namespace tensorflow
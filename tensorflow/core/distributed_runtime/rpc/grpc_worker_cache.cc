@@ -59,10 +59,12 @@ class GrpcWorkerCache : public WorkerCachePartial {
       if (!channel) {
         return nullptr;
       }
+      SharedGrpcChannelPtr bulk_channel =
+          channel_cache_->FindWorkerBulkChannel(target);
       size_t index = AssignWorkerToThread(target);
       return NewGrpcRemoteWorker(
           channel, worker_env_->GetCompletionQueue(index),
-          worker_env_->GetThreadPool(), &logger_, target);
+          worker_env_->GetThreadPool(), &logger_, target, bulk_channel);
     }
   }
 
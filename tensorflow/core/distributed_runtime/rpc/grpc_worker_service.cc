@@ -39,6 +39,8 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_util.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_service_impl.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_transport.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_session.h"
@@ -148,6 +150,13 @@ class GrpcWorkerServiceThread {
     SETUP_FOR_REQUEST(RunGraph, 100, true);
     SETUP_FOR_REQUEST(CleanupGraph, 100, false);
     SETUP_FOR_REQUEST(MarkRecvFinished, 10, false);
+    for (int i = 0;
+         i < gtl::FindWithDefault(
+                 queue_depth_,
+                 static_cast<int>(GrpcWorkerMethod::kRecvTensorBatch), 100);
+         ++i) {
+      EnqueueRecvTensorBatchRequestRaw();
+    }
 
     // TODO(ncteisen): Determine a better policy for enqueuing the
     // appropriate number of each request type.
@@ -284,6 +293,26 @@ class GrpcWorkerServiceThread {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorBatchHandlerRaw(
+      WorkerCall<RecvTensorBatchRequest, ::grpc::ByteBuffer>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+
+      worker_->GrpcRecvTensorBatchAsync(
+          call_opts, &call->request, &call->response,
+          [call, call_opts](const Status& s) {
+            call->ClearCancelCallback();
+            delete call_opts;
+            if (!s.ok()) {
+              VLOG(3) << "Bad response from RecvTensorBatch:" << s;
+            }
+            call->SendResponse(ToGrpcStatus(s));
+          });
+    });
+    EnqueueRecvTensorBatchRequestRaw();
+  }
+
   void RecvBufHandler(WorkerCall<RecvBufRequest, RecvBufResponse>* call) {
     Schedule([this, call]() {
       CallOptions* call_opts = new CallOptions;
@@ -353,6 +382,19 @@ class GrpcWorkerServiceThread {
     }
   }
 
+  void EnqueueRecvTensorBatchRequestRaw() {
+    mutex_lock l(shutdown_mu_);
+    if (!is_shutdown_) {
+      Call<GrpcWorkerServiceThread, grpc::WorkerService::AsyncService,
+           RecvTensorBatchRequest, ::grpc::ByteBuffer>::
+          EnqueueRequestForMethod(
+              worker_service_, cq_.get(),
+              static_cast<int>(GrpcWorkerMethod::kRecvTensorBatch),
+              &GrpcWorkerServiceThread::RecvTensorBatchHandlerRaw,
+              true /* supports cancel*/);
+    }
+  }
+
   GrpcWorker* const worker_ = nullptr;  // Not owned.
   std::unique_ptr<::grpc::ServerCompletionQueue> cq_;
   std::unique_ptr<Thread> thread_;
@@ -435,6 +477,59 @@ void GrpcWorker::EnableResponseCache() {
   response_cache_ = std::make_unique<GrpcResponseCache>();
 }
 
+namespace {
+// Returns true if the receiver that sent `request` accepts the tensor content
+// through shared memory, and shares memory with this process.
+bool UseSharedMemory(const RecvTensorRequest& request) {
+  SharedMemoryRecvRequestExtra extra;
+  return request.has_transport_options() &&
+         request.transport_options().UnpackTo(&extra) &&
+         IsSharedMemoryPeer(extra.endpoint());
+}
+
+// Writes the content of `tensor` to shared memory, and encodes a response
+// describing the segment into `*result`. Returns false if shared memory could
+// not be used, in which case `*result` is unchanged.
+bool EncodeTensorToSharedMemory(const Tensor& tensor, bool require_ack,
+                                ::grpc::ByteBuffer* result) {
+  SharedMemoryRecvResponseExtra extra;
+  Status s = WriteTensorToSharedMemory(tensor, &extra);
+  if (!s.ok()) {
+    VLOG(1) << "Sending tensor in the RPC response instead: " << s;
+    return false;
+  }
+  RecvTensorResponse response;
+  response.set_require_ack(require_ack);
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  response.mutable_tensor()->set_dtype(tensor.dtype());
+  tensor.shape().AsProto(response.mutable_tensor()->mutable_tensor_shape());
+  response.mutable_transport_options()->PackFrom(extra);
+  grpc::EncodeRecvTensorResponseToByteBuffer(response, result);
+  return true;
+}
+
+// Encodes a response holding `tensor` with one of the `accepted` wire
+// encodings into `*result`, and records the bytes sent. Returns false if no
+// encoding applies, in which case `*result` is unchanged.
+bool EncodeTensorWithWireEncoding(const Tensor& tensor,
+                                  const protobuf::RepeatedField<int>& accepted,
+                                  bool require_ack,
+                                  ::grpc::ByteBuffer* result) {
+  if (accepted.empty()) return false;
+  RecvTensorResponse response;
+  const TensorWireEncoding encoding =
+      EncodeTensorForWire(tensor, accepted, response.mutable_tensor());
+  if (encoding == WIRE_ENCODING_NONE) return false;
+  RecordRecvTensorWireBytes(encoding, tensor.TotalBytes(),
+                            response.tensor().tensor_content().size());
+  response.set_wire_encoding(encoding);
+  response.set_require_ack(require_ack);
+  response.set_send_start_micros(Env::Default()->NowMicros());
+  grpc::EncodeRecvTensorResponseToByteBuffer(response, result);
+  return true;
+}
+}  // namespace
+
 // GrpcRecvTensorAsync: unlike the other Worker methods, which use protocol
 // buffers for a response object, to avoid extra protocol buffer serialization
 // overhead we generate our response directly into a ::grpc::ByteBuffer object
@@ -447,12 +542,25 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
   const int64_t step_id = request->step_id();
 
   bool cache_enabled = (response_cache_ != nullptr && request_id != 0);
+  const bool use_shared_memory = UseSharedMemory(*request);
 
-  auto do_response = [response, done, cache_enabled](const Tensor& tensor,
-                                                     bool is_dead,
-                                                     const Status& status) {
+  auto do_response = [response, done, cache_enabled, use_shared_memory,
+                      accepted_encodings = request->accepted_wire_encodings()](
+                         const Tensor& tensor, bool is_dead,
+                         const Status& status) {
     if (status.ok()) {
-      grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled, response);
+      const bool sent_through_shared_memory =
+          !is_dead && use_shared_memory && CanSendThroughSharedMemory(tensor) &&
+          EncodeTensorToSharedMemory(tensor, cache_enabled, response);
+      if (!sent_through_shared_memory &&
+          (is_dead ||
+           !EncodeTensorWithWireEncoding(tensor, accepted_encodings,
+                                         cache_enabled, response))) {
+        grpc::EncodeTensorToByteBuffer(is_dead, tensor, cache_enabled,
+                                       response);
+        RecordRecvTensorWireBytes(WIRE_ENCODING_NONE, tensor.TotalBytes(),
+                                  tensor.TotalBytes());
+      }
     }
     done(status);
   };
@@ -560,6 +668,77 @@ void GrpcWorker::GrpcRecvTensorAsync(CallOptions* opts,
       });
 }
 
+void GrpcWorker::GrpcRecvTensorBatchAsync(
+    CallOptions* opts, const RecvTensorBatchRequest* request,
+    ::grpc::ByteBuffer* response, StatusCallback done) {
+  const int num_tensors = request->requests_size();
+  if (num_tensors == 0) {
+    grpc::EncodeRecvTensorBatchResponseToByteBuffer({}, response);
+    done(OkStatus());
+    return;
+  }
+  const int64_t step_id = request->requests(0).step_id();
+  for (const RecvTensorRequest& r : request->requests()) {
+    if (r.step_id() != step_id) {
+      done(errors::InvalidArgument(
+          "All the tensors of a RecvTensorBatch must be in the same step, got ",
+          step_id, " and ", r.step_id()));
+      return;
+    }
+  }
+
+  struct BatchState {
+    explicit BatchState(int num_tensors)
+        : call_opts(new CallOptions[num_tensors]),
+          responses(num_tensors),
+          num_pending(num_tensors) {}
+
+    // The per-tensor calls are never cancelled: cancelling the batch aborts
+    // the step, which fails the pending receives.
+    std::unique_ptr<CallOptions[]> call_opts;
+    std::vector<::grpc::ByteBuffer> responses;
+    mutex mu;
+    Status status TF_GUARDED_BY(mu);
+    int num_pending TF_GUARDED_BY(mu);
+  };
+  auto* state = new BatchState(num_tensors);
+
+  opts->SetCancelCallback([this, step_id]() {
+    LOG(WARNING) << "RecvTensorBatch cancelled for " << step_id;
+    AbortStep(step_id);
+  });
+  for (int i = 0; i < num_tensors; ++i) {
+    GrpcRecvTensorAsync(
+        &state->call_opts[i], &request->requests(i), &state->responses[i],
+        [this, opts, response, done, state, step_id](const Status& s) {
+          Status status;
+          bool first_error;
+          int num_pending;
+          {
+            mutex_lock l(state->mu);
+            first_error = !s.ok() && state->status.ok();
+            state->status.Update(s);
+            num_pending = --state->num_pending;
+            status = state->status;
+          }
+          if (num_pending > 0) {
+            // The receiver would abort the step on the first error, but it
+            // only sees the error once the whole batch completes, so abort
+            // here rather than wait for tensors that may never be produced.
+            if (first_error) AbortStep(step_id);
+            return;
+          }
+          opts->ClearCancelCallback();
+          if (status.ok()) {
+            grpc::EncodeRecvTensorBatchResponseToByteBuffer(state->responses,
+                                                            response);
+          }
+          delete state;
+          done(status);
+        });
+  }
+}
+
 namespace {
 // If RecvBufRespExtra.tensor_content is a single large string, then gRPC
 // can stall on the recv side when the string buffer needs to be enlarged,
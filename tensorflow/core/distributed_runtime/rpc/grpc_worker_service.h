@@ -46,6 +46,13 @@ class GrpcWorker : public Worker {
                                    ::grpc::ByteBuffer* response,
                                    StatusCallback done);
 
+  // Receives the tensors of `request` with `GrpcRecvTensorAsync()`, and
+  // sends them in a single response once all of them are available.
+  virtual void GrpcRecvTensorBatchAsync(CallOptions* opts,
+                                        const RecvTensorBatchRequest* request,
+                                        ::grpc::ByteBuffer* response,
+                                        StatusCallback done);
+
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
                     StatusCallback done) override;
 
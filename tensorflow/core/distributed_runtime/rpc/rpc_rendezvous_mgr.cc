@@ -15,11 +15,16 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/distributed_runtime/request_id.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_transport.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
@@ -31,15 +36,33 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Maximum number of tensors requested in one RecvTensorBatch call.
+constexpr int kMaxRecvTensorBatchSize = 128;
+
+// Returns true if the receives issued together for the same remote worker
+// should be sent in a single RecvTensorBatch call, which is enabled by setting
+// the environment variable TF_RPC_BATCH_RECV_TENSOR to true.
+bool RecvTensorBatchingEnabled() {
+  bool enabled;
+  TF_CHECK_OK(ReadBoolFromEnvVar("TF_RPC_BATCH_RECV_TENSOR", false, &enabled));
+  return enabled;
+}
+
+class RpcRecvTensorBatchCall;
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id)
-      : BaseRemoteRendezvous(env, step_id) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64_t step_id,
+                      bool batch_recv_tensor)
+      : BaseRemoteRendezvous(env, step_id),
+        batch_recv_tensor_(batch_recv_tensor) {}
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -49,6 +72,37 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Receives the tensor for `parsed` with a RecvTensor call, or adds it to a
+  // pending RecvTensorBatch call if `allow_batching` is true.
+  void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                           const Rendezvous::Args& args, bool allow_batching,
+                           DoneCallback done);
+
+  // Adds the receive of `parsed` from `src_worker` to the pending batch for
+  // that worker, creating the batch if needed. Takes ownership of the `rwi`
+  // reference.
+  void AddToBatch(const string& src_worker, WorkerInterface* rwi,
+                  std::shared_ptr<WorkerCacheInterface> worker_cache,
+                  const Rendezvous::ParsedKey& parsed, Device* dst_device,
+                  const Rendezvous::Args& recv_args, DoneCallback done);
+
+  // Sends the pending batch for `src_worker` and `cm`, if it has id
+  // `batch_id`.
+  void FlushBatch(const string& src_worker, CancellationManager* cm,
+                  int64_t batch_id);
+
+  void StartBatch(RpcRecvTensorBatchCall* call);
+
+  // Receives are only batched if they use the same cancellation manager, so
+  // that the batch can be registered as a single call.
+  using BatchKey = std::pair<string, CancellationManager*>;
+
+  const bool batch_recv_tensor_;
+  mutex batch_mu_;
+  int64_t next_batch_id_ TF_GUARDED_BY(batch_mu_) = 0;
+  absl::flat_hash_map<BatchKey, RpcRecvTensorBatchCall*> pending_batches_
+      TF_GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -68,6 +122,7 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
     req_.set_step_id(step_id);
     req_.set_rendezvous_key(key.data(), key.size());
     req_.set_request_id(GetUniqueRequestId());
+    AddAcceptedWireEncodings(&req_);
   }
 
   void Reset() {
@@ -135,6 +190,14 @@ class RpcRecvTensorCall : public BaseRecvTensorCall {
   // Start the main RecvTensor call, checking for an async abort.
   void StartRTCall(std::function<void()> recv_done) {
     resp_.InitAlloc(dst_device_, alloc_attrs_);
+    std::string endpoint;
+    if (SharedMemoryRecvEnabled() && resp_.AcceptsSharedMemory() &&
+        GetSharedMemoryEndpoint(&endpoint).ok()) {
+      // Let a co-located sender write the tensor content to shared memory.
+      SharedMemoryRecvRequestExtra extra;
+      extra.set_endpoint(endpoint);
+      req_.mutable_transport_options()->PackFrom(extra);
+    }
     auto abort_checked = std::make_shared<Notification>();
     auto cb = [this, abort_checked,
                recv_done = std::move(recv_done)](const Status& s) {
@@ -228,9 +291,170 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// Used to retrieve several tensors produced in the same step by the same
+// remote process with a single RecvTensorBatch call.
+class RpcRecvTensorBatchCall : public BaseRecvTensorCall {
+ public:
+  struct Item {
+    Device* dst_device;
+    Rendezvous::Args recv_args;
+    Rendezvous::DoneCallback done;
+  };
+
+  RpcRecvTensorBatchCall(int64_t batch_id, const string& src_worker,
+                         WorkerInterface* wi,
+                         std::shared_ptr<WorkerCacheInterface> worker_cache)
+      : batch_id_(batch_id),
+        src_worker_(src_worker),
+        wi_(wi),
+        worker_cache_(std::move(worker_cache)) {}
+
+  ~RpcRecvTensorBatchCall() override {
+    CHECK_EQ(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "Leaking WorkerInterface in RpcRecvTensorBatchCall destructor.";
+  }
+
+  void Add(int64_t step_id, StringPiece key, Device* dst_device,
+           const Rendezvous::Args& recv_args, Rendezvous::DoneCallback done) {
+    RecvTensorRequest* req = req_.add_requests();
+    req->set_step_id(step_id);
+    req->set_rendezvous_key(key.data(), key.size());
+    req->set_request_id(GetUniqueRequestId());
+    AddAcceptedWireEncodings(req);
+    items_.push_back({dst_device, recv_args, std::move(done)});
+  }
+
+  int64_t batch_id() const { return batch_id_; }
+  const string& src_worker() const { return src_worker_; }
+  int size() const { return items_.size(); }
+  const std::vector<Item>& items() const { return items_; }
+  const RecvTensorBatchRequest& request() const { return req_; }
+
+  void Start(std::function<void()> recv_done) override {
+    auto abort_checked = std::make_shared<Notification>();
+    auto cb = [this, abort_checked,
+               recv_done = std::move(recv_done)](const Status& s) {
+      // Make sure the Rendezvous abort checking is finished before running the
+      // callback, which might destroy the current call object.
+      abort_checked->WaitForNotification();
+      if (!s.ok()) {
+        mutex_lock l(mu_);
+        status_.Update(s);
+      }
+      recv_done();
+    };
+    wi_->RecvTensorBatchAsync(&opts_, &req_, &resp_, std::move(cb));
+
+    // See `RpcRecvTensorCall::StartRTCall()` for the ordering of the abort
+    // check.
+    Status s;
+    {
+      mutex_lock l(mu_);
+      s = status_;
+    }
+    if (!s.ok()) {
+      opts_.StartCancel();
+    }
+    abort_checked->Notify();
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  void ReleaseWorker() {
+    DCHECK_NE(static_cast<WorkerInterface*>(nullptr), wi_)
+        << "RpcRecvTensorBatchCall::ReleaseWorker() called twice.";
+    worker_cache_->ReleaseWorker(src_worker_, wi_);
+    wi_ = nullptr;
+  }
+
+  // Runs the callback of every item, with its received tensor if `s` is OK.
+  void RunCallbacks(const Status& s) {
+    for (int i = 0; i < items_.size(); ++i) {
+      const Item& item = items_[i];
+      if (!s.ok()) {
+        item.done(s, Rendezvous::Args(), item.recv_args, Tensor(), false);
+        continue;
+      }
+      RecvTensorResponse* response = resp_.mutable_responses(i);
+      Status decode_status = DecodeTensorFromWire(response);
+      if (!decode_status.ok()) {
+        item.done(decode_status, Rendezvous::Args(), item.recv_args, Tensor(),
+                  false);
+        continue;
+      }
+      Tensor tensor;
+      if (!tensor.FromProto(
+              item.dst_device->GetAllocator(item.recv_args.alloc_attrs),
+              response->tensor())) {
+        item.done(errors::Internal("Cannot parse tensor ",
+                                   req_.requests(i).rendezvous_key(),
+                                   " from RecvTensorBatch response"),
+                  Rendezvous::Args(), item.recv_args, Tensor(), false);
+        continue;
+      }
+      item.done(OkStatus(), Rendezvous::Args(), item.recv_args, tensor,
+                response->is_dead());
+    }
+  }
+
+ private:
+  const int64_t batch_id_;
+  const string src_worker_;
+  WorkerInterface* wi_;  // Not owned.
+  std::shared_ptr<WorkerCacheInterface> worker_cache_;
+  CallOptions opts_;
+  RecvTensorBatchRequest req_;
+  RecvTensorBatchResponse resp_;
+  std::vector<Item> items_;
+
+  mutable mutex mu_;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorBatchCall);
+};
+
+// Remote workers that do not implement RecvTensorBatch.
+mutex unbatched_workers_mu(LINKER_INITIALIZED);
+absl::flat_hash_set<string>* unbatched_workers()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(unbatched_workers_mu) {
+  static auto* workers = new absl::flat_hash_set<string>();
+  return workers;
+}
+
+bool SupportsRecvTensorBatch(const string& worker) {
+  mutex_lock l(unbatched_workers_mu);
+  return !unbatched_workers()->contains(worker);
+}
+
+// Batches skip the shared memory transport and the parsing into device memory
+// of `TensorResponse`, so they are only used for tensors received in host
+// memory.
+bool CanBatchRecv(const Device* dst_device,
+                  const Rendezvous::Args& recv_args) {
+  return recv_args.alloc_attrs.on_host() ||
+         dst_device->tensorflow_accelerator_device_info() == nullptr;
+}
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
+  RecvFromRemoteAsync(parsed, recv_args, batch_recv_tensor_, std::move(done));
+}
+
+void RpcRemoteRendezvous::RecvFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    bool allow_batching, DoneCallback done) {
   CHECK(is_initialized());
   Status s;
 
@@ -267,6 +491,15 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
     return;
   }
 
+  if (allow_batching && CanBatchRecv(dst_device, recv_args) &&
+      SupportsRecvTensorBatch(call->src_worker_)) {
+    const string src_worker = call->src_worker_;
+    get_call_freelist()->Release(call);
+    AddToBatch(src_worker, rwi, std::move(worker_cache), parsed, dst_device,
+               recv_args, std::move(done));
+    return;
+  }
+
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
 
@@ -303,14 +536,114 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::AddToBatch(
+    const string& src_worker, WorkerInterface* rwi,
+    std::shared_ptr<WorkerCacheInterface> worker_cache,
+    const Rendezvous::ParsedKey& parsed, Device* dst_device,
+    const Rendezvous::Args& recv_args, DoneCallback done) {
+  const BatchKey key(src_worker, recv_args.cancellation_manager);
+  RpcRecvTensorBatchCall* full_batch = nullptr;
+  {
+    mutex_lock l(batch_mu_);
+    RpcRecvTensorBatchCall*& batch = pending_batches_[key];
+    if (batch == nullptr) {
+      batch = new RpcRecvTensorBatchCall(next_batch_id_++, src_worker, rwi,
+                                         worker_cache);
+      // The receives issued before the closure runs, typically by the same
+      // executor burst, join this batch.
+      Ref();
+      env_->compute_pool->Schedule(
+          [this, key, batch_id = batch->batch_id()]() {
+            FlushBatch(key.first, key.second, batch_id);
+            Unref();
+          });
+    } else {
+      worker_cache->ReleaseWorker(src_worker, rwi);
+    }
+    batch->Add(step_id_, parsed.FullKey(), dst_device, recv_args,
+               std::move(done));
+    if (batch->size() >= kMaxRecvTensorBatchSize) {
+      full_batch = batch;
+      pending_batches_.erase(key);
+    }
+  }
+  if (full_batch != nullptr) {
+    StartBatch(full_batch);
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker,
+                                     CancellationManager* cm,
+                                     int64_t batch_id) {
+  RpcRecvTensorBatchCall* batch;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(BatchKey(src_worker, cm));
+    // The batch may have been started when it became full.
+    if (it == pending_batches_.end() || it->second->batch_id() != batch_id) {
+      return;
+    }
+    batch = it->second;
+    pending_batches_.erase(it);
+  }
+  StartBatch(batch);
+}
+
+void RpcRemoteRendezvous::StartBatch(RpcRecvTensorBatchCall* call) {
+  // All the items share the cancellation manager the call is registered with.
+  const Rendezvous::Args& recv_args = call->items().front().recv_args;
+  RegisterCall(call, recv_args);
+  if (!call->status().ok()) {
+    DeregisterCall(call, recv_args);
+    call->ReleaseWorker();
+    call->RunCallbacks(call->status());
+    delete call;
+    return;
+  }
+
+  Ref();
+  call->Start([this, call]() {
+    DeregisterCall(call, call->items().front().recv_args);
+    Status s = call->status();
+    call->ReleaseWorker();
+    if (errors::IsUnimplemented(s)) {
+      // The remote worker does not support batching, so receive each tensor
+      // with its own call instead.
+      VLOG(1) << "Falling back to RecvTensor for " << call->src_worker()
+              << ": " << s;
+      {
+        mutex_lock l(unbatched_workers_mu);
+        unbatched_workers()->insert(call->src_worker());
+      }
+      for (int i = 0; i < call->size(); ++i) {
+        const RpcRecvTensorBatchCall::Item& item = call->items()[i];
+        Rendezvous::ParsedKey parsed;
+        Status parse_status = Rendezvous::ParseKey(
+            call->request().requests(i).rendezvous_key(), &parsed);
+        if (!parse_status.ok()) {
+          item.done(parse_status, Args(), item.recv_args, Tensor(), false);
+          continue;
+        }
+        RecvFromRemoteAsync(parsed, item.recv_args, /*allow_batching=*/false,
+                            item.done);
+      }
+    } else {
+      call->RunCallbacks(s);
+    }
+    delete call;
+    Unref();
+  });
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : BaseRendezvousMgr(env),
+      batch_recv_tensor_(RecvTensorBatchingEnabled()) {}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64_t step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id, batch_recv_tensor_);
 }
 
 }  // end namespace tensorflow
@@ -42,6 +42,10 @@ class DeviceMgr;
 //
 // Tensors sent and recved through rendezvous managed by this
 // RendezvousMgr must have keys generated by Rendezvous::CreateKey.
+//
+// If the environment variable TF_RPC_BATCH_RECV_TENSOR is true when the
+// RendezvousMgr is created, the receives issued together for the same step
+// and remote worker are sent in a single RecvTensorBatch RPC.
 class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
@@ -50,6 +54,8 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
   BaseRemoteRendezvous* Create(int64_t step_id, const WorkerEnv* worker_env);
 
  private:
+  const bool batch_recv_tensor_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
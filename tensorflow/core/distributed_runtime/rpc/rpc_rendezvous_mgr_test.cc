@@ -26,7 +26,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -68,12 +70,47 @@ class DummyWorker : public TestWorkerInterface {
   }
 };
 
+// A worker that implements RecvTensorBatch, and returns the edge name of each
+// requested key as the tensor.
+class BatchingWorker : public TestWorkerInterface {
+ public:
+  void RecvTensorBatchAsync(CallOptions* opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    {
+      mutex_lock l(mu_);
+      batch_sizes_.push_back(request->requests_size());
+    }
+    for (const RecvTensorRequest& r : request->requests()) {
+      Rendezvous::ParsedKey parsed;
+      TF_CHECK_OK(Rendezvous::ParseKey(r.rendezvous_key(), &parsed));
+      V(string(parsed.edge_name))
+          .AsProtoTensorContent(response->add_responses()->mutable_tensor());
+    }
+    SchedClosure([done = std::move(done)]() { done(OkStatus()); });
+  }
+
+  std::vector<int> batch_sizes() {
+    mutex_lock l(mu_);
+    return batch_sizes_;
+  }
+
+ private:
+  mutex mu_;
+  std::vector<int> batch_sizes_ TF_GUARDED_BY(mu_);
+};
+
 // Fake cache implementation for WorkerEnv.
 class DummyWorkerCache : public WorkerCacheInterface {
+ public:
   void ListWorkers(std::vector<string>* workers) const override {}
   void ListWorkersInJob(const string& job_name,
                         std::vector<string>* workers) const override {}
   WorkerInterface* GetOrCreateWorker(const string& target) override {
+    if (target == "/job:batching/replica:0/task:0") {
+      return &batching_worker_;
+    }
     if (dummy_remote_worker_ == nullptr) {
       // Ownership transferred to WorkerFreeList
       dummy_remote_worker_ = new DummyWorker;
@@ -95,8 +132,11 @@ class DummyWorkerCache : public WorkerCacheInterface {
   void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
                               StatusCallback done) override {}
 
+  BatchingWorker* batching_worker() { return &batching_worker_; }
+
  private:
   DummyWorker* dummy_remote_worker_ = nullptr;
+  BatchingWorker batching_worker_;
 };
 
 static Device* CreateDevice(const char* type, const char* name) {
@@ -104,7 +144,9 @@ static Device* CreateDevice(const char* type, const char* name) {
    public:
     explicit FakeDevice(const DeviceAttributes& attr) : Device(nullptr, attr) {}
     Status Sync() override { return OkStatus(); }
-    Allocator* GetAllocator(AllocatorAttributes) override { return nullptr; }
+    Allocator* GetAllocator(AllocatorAttributes) override {
+      return cpu_allocator();
+    }
   };
   DeviceAttributes attr;
   attr.set_name(name);
@@ -348,4 +390,76 @@ TEST_F(RpcRendezvousMgrTest, RemoteRecvAsyncMany) {
   rmgr_.Cleanup(step_id);
 }
 
+class RpcRendezvousMgrBatchingTest : public RpcRendezvousMgrTest {
+ protected:
+  RpcRendezvousMgrBatchingTest() : pool_(Env::Default(), "compute", 1) {
+    env.compute_pool = &pool_;
+    setenv("TF_RPC_BATCH_RECV_TENSOR", "true", /*overwrite=*/1);
+    batching_rmgr_ = std::make_unique<RpcRendezvousMgr>(&env);
+    unsetenv("TF_RPC_BATCH_RECV_TENSOR");
+  }
+
+  // Receives `num_tensors` tensors from `src_task` while the compute pool is
+  // blocked, so that all of them are issued before a batch is flushed, and
+  // returns the received values.
+  std::vector<string> RecvMany(const string& src_task, int num_tensors) {
+    const int64_t step_id = 123;
+    std::vector<string> values(num_tensors);
+    RemoteRendezvous* rendez = batching_rmgr_->Find(step_id);
+    TF_CHECK_OK(rendez->Initialize(&worker_session_));
+    Notification unblock;
+    pool_.Schedule([&unblock]() { unblock.WaitForNotification(); });
+
+    mutex mu;
+    Status status;
+    BlockingCounter counter(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+          strings::StrCat(src_task, "/cpu:0"), 7890,
+          "/job:mnist/replica:1/task:2/cpu:1", strings::StrCat("t", i),
+          FrameAndIter(0, 0)));
+      rendez->RecvAsync(key, Rendezvous::Args(),
+                        [&, i](const Status& s, const Rendezvous::Args&,
+                               const Rendezvous::Args&, const Tensor& val,
+                               const bool) {
+                          {
+                            mutex_lock l(mu);
+                            status.Update(s);
+                          }
+                          if (s.ok() && val.dtype() == DT_STRING) {
+                            values[i] = V(val);
+                          }
+                          counter.DecrementCount();
+                        });
+    }
+    unblock.Notify();
+    counter.Wait();
+    TF_CHECK_OK(status);
+    rendez->Unref();
+    batching_rmgr_->Cleanup(step_id);
+    return values;
+  }
+
+  thread::ThreadPool pool_;
+  std::unique_ptr<RpcRendezvousMgr> batching_rmgr_;
+};
+
+TEST_F(RpcRendezvousMgrBatchingTest, RemoteRecvBatched) {
+  std::vector<string> values = RecvMany("/job:batching/replica:0/task:0", 300);
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], strings::StrCat("t", i));
+  }
+  // Full batches are sent immediately, and the rest once the compute pool
+  // runs the flush.
+  EXPECT_EQ(cache_->batching_worker()->batch_sizes(),
+            std::vector<int>({128, 128, 44}));
+}
+
+TEST_F(RpcRendezvousMgrBatchingTest, FallsBackWithoutBatchSupport) {
+  // `DummyWorker` does not implement RecvTensorBatch, so each tensor is
+  // received with its own RecvTensor call.
+  RecvMany("/job:worker/replica:1/task:2", 10);
+  EXPECT_TRUE(cache_->batching_worker()->batch_sizes().empty());
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,285 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_transport.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/random.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace {
+
+// Smaller tensors are sent in the RPC response, where the cost of creating a
+// segment is not amortized.
+constexpr int64_t kMinSharedMemoryBytes = 1 << 20;
+
+// Segments that have not been mapped by their receiver after this time, for
+// example because the RPC was cancelled, are removed by their sender.
+constexpr uint64 kSegmentTimeoutMicros = 60 * 1000 * 1000;
+
+constexpr char kSegmentPrefix[] = "/tf_rpc_";
+
+#if defined(__linux__)
+
+// A tensor buffer backed by a private mapping of a segment, so that kernels
+// may update the tensor in place.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(void* data, size_t size)
+      : TensorBuffer(data), size_(size) {}
+  ~MappedTensorBuffer() override { munmap(data(), size_); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("shared_memory");
+  }
+
+ private:
+  const size_t size_;
+};
+
+// The segments created by this process.
+class SharedMemoryState {
+ public:
+  static SharedMemoryState* Get() {
+    static SharedMemoryState* state = new SharedMemoryState();
+    return state;
+  }
+
+  const Status& endpoint_status() const { return endpoint_status_; }
+  const std::string& endpoint() const { return endpoint_; }
+
+  bool IsPeer(const std::string& endpoint) {
+    mutex_lock l(mu_);
+    auto it = peers_.find(endpoint);
+    if (it == peers_.end()) {
+      bool is_peer = false;
+      if (absl::StartsWith(endpoint, kSegmentPrefix)) {
+        const int fd = shm_open(endpoint.c_str(), O_RDONLY, 0);
+        if (fd >= 0) {
+          close(fd);
+          is_peer = true;
+        }
+      }
+      it = peers_.emplace(endpoint, is_peer).first;
+    }
+    return it->second;
+  }
+
+  // Returns the name of a new segment, and removes the segments that were
+  // created more than `kSegmentTimeoutMicros` ago.
+  std::string NewSegmentName() {
+    const uint64 now = Env::Default()->NowMicros();
+    mutex_lock l(mu_);
+    while (!segments_.empty() &&
+           segments_.front().second + kSegmentTimeoutMicros < now) {
+      // Fails with ENOENT if the receiver already removed the segment.
+      shm_unlink(segments_.front().first.c_str());
+      segments_.pop_front();
+    }
+    std::string name = absl::StrCat(prefix_, "_", next_segment_id_++);
+    segments_.emplace_back(name, now);
+    return name;
+  }
+
+ private:
+  SharedMemoryState()
+      : prefix_(absl::StrCat(kSegmentPrefix, getpid(), "_", random::New64())),
+        endpoint_(absl::StrCat(prefix_, "_endpoint")) {
+    const int fd =
+        shm_open(endpoint_.c_str(), O_CREAT | O_EXCL | O_RDONLY, 0600);
+    if (fd < 0) {
+      endpoint_status_ =
+          errors::Unavailable("Failed to create shared memory segment ",
+                              endpoint_, ": ", strerror(errno));
+      return;
+    }
+    close(fd);
+    std::atexit([]() { shm_unlink(Get()->endpoint_.c_str()); });
+  }
+
+  const std::string prefix_;
+  const std::string endpoint_;
+  Status endpoint_status_;
+
+  mutex mu_;
+  absl::flat_hash_map<std::string, bool> peers_ TF_GUARDED_BY(mu_);
+  // Names and creation times of the segments, in order of creation.
+  std::deque<std::pair<std::string, uint64>> segments_ TF_GUARDED_BY(mu_);
+  int64_t next_segment_id_ TF_GUARDED_BY(mu_) = 0;
+};
+
+#endif  // defined(__linux__)
+
+}  // namespace
+
+bool SharedMemoryRecvEnabled() {
+  static const bool enabled = []() {
+    bool enabled;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_RPC_SHARED_MEMORY", false, &enabled));
+    return enabled;
+  }();
+  return enabled;
+}
+
+bool CanSendThroughSharedMemory(const Tensor& tensor) {
+  return DataTypeCanUseMemcpy(tensor.dtype()) &&
+         tensor.TotalBytes() >= kMinSharedMemoryBytes;
+}
+
+#if defined(__linux__)
+
+Status GetSharedMemoryEndpoint(std::string* endpoint) {
+  SharedMemoryState* state = SharedMemoryState::Get();
+  TF_RETURN_IF_ERROR(state->endpoint_status());
+  *endpoint = state->endpoint();
+  return OkStatus();
+}
+
+bool IsSharedMemoryPeer(const std::string& endpoint) {
+  return SharedMemoryState::Get()->IsPeer(endpoint);
+}
+
+Status WriteTensorToSharedMemory(const Tensor& tensor,
+                                 SharedMemoryRecvResponseExtra* extra) {
+  const StringPiece data = tensor.tensor_data();
+  const std::string name = SharedMemoryState::Get()->NewSegmentName();
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return errors::Internal("Failed to create shared memory segment ", name,
+                            ": ", strerror(errno));
+  }
+  Status s;
+  // Unlike ftruncate(), fails instead of raising SIGBUS on first access when
+  // there is not enough shared memory.
+  const int error = posix_fallocate(fd, 0, data.size());
+  if (error != 0) {
+    s = errors::ResourceExhausted("Failed to allocate ", data.size(),
+                                  " bytes of shared memory: ",
+                                  strerror(error));
+  } else {
+    void* mapped =
+        mmap(nullptr, data.size(), PROT_WRITE, MAP_SHARED, fd, /*offset=*/0);
+    if (mapped == MAP_FAILED) {
+      s = errors::Internal("Failed to map shared memory segment ", name, ": ",
+                           strerror(errno));
+    } else {
+      memcpy(mapped, data.data(), data.size());
+      munmap(mapped, data.size());
+    }
+  }
+  close(fd);
+  if (!s.ok()) {
+    shm_unlink(name.c_str());
+    return s;
+  }
+  extra->set_segment_name(name);
+  extra->set_num_bytes(data.size());
+  return OkStatus();
+}
+
+Status MapTensorFromSharedMemory(const SharedMemoryRecvResponseExtra& extra,
+                                 DataType dtype, const TensorShape& shape,
+                                 Tensor* tensor) {
+  const std::string& name = extra.segment_name();
+  if (!absl::StartsWith(name, kSegmentPrefix)) {
+    return errors::InvalidArgument("Invalid shared memory segment: ", name);
+  }
+  if (!DataTypeCanUseMemcpy(dtype) ||
+      shape.num_elements() * DataTypeSize(dtype) != extra.num_bytes()) {
+    // The segment cannot be used, so release it now rather than waiting for
+    // the sender to time it out.
+    shm_unlink(name.c_str());
+    return errors::InvalidArgument("Shared memory segment ", name, " has ",
+                                   extra.num_bytes(), " bytes, expected a ",
+                                   DataTypeString(dtype), " tensor of shape ",
+                                   shape.DebugString());
+  }
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return errors::Internal("Failed to open shared memory segment ", name,
+                            ": ", strerror(errno));
+  }
+  // The mapping remains valid after the name is removed.
+  shm_unlink(name.c_str());
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size != extra.num_bytes()) {
+    close(fd);
+    return errors::Internal("Shared memory segment ", name,
+                            " does not have the expected size ",
+                            extra.num_bytes());
+  }
+  void* mapped = mmap(nullptr, extra.num_bytes(), PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE, fd, /*offset=*/0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return errors::Internal("Failed to map shared memory segment ", name, ": ",
+                            strerror(errno));
+  }
+  auto* buffer = new MappedTensorBuffer(mapped, extra.num_bytes());
+  *tensor = Tensor(dtype, shape, buffer);
+  buffer->Unref();
+  return OkStatus();
+}
+
+#else  // defined(__linux__)
+
+Status GetSharedMemoryEndpoint(std::string* endpoint) {
+  return errors::Unimplemented(
+      "Shared memory transport is not supported on this platform.");
+}
+
+bool IsSharedMemoryPeer(const std::string& endpoint) { return false; }
+
+Status WriteTensorToSharedMemory(const Tensor& tensor,
+                                 SharedMemoryRecvResponseExtra* extra) {
+  return errors::Unimplemented(
+      "Shared memory transport is not supported on this platform.");
+}
+
+Status MapTensorFromSharedMemory(const SharedMemoryRecvResponseExtra& extra,
+                                 DataType dtype, const TensorShape& shape,
+                                 Tensor* tensor) {
+  return errors::Unimplemented(
+      "Shared memory transport is not supported on this platform.");
+}
+
+#endif  // defined(__linux__)
+
+}  // namespace tensorflow
@@ -0,0 +1,72 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TRANSPORT_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TRANSPORT_H_
+
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+
+// Moves the content of tensors between tasks running on the same host through
+// POSIX shared memory, while the RecvTensor RPC only carries the metadata.
+//
+// A receiver that accepts shared memory sends its endpoint, the name of a
+// segment it created, in `RecvTensorRequest.transport_options`. If the sender
+// can open that segment, the two tasks share memory, and the sender writes
+// large tensors to a new segment described in
+// `RecvTensorResponse.transport_options`. The receiver maps that segment as
+// the buffer of the received tensor, so that the content is copied once
+// instead of being serialized, sent over a socket and parsed.
+
+// Returns true if tensors should be received through shared memory when the
+// sender is co-located, which is enabled by setting the environment variable
+// TF_RPC_SHARED_MEMORY to true.
+bool SharedMemoryRecvEnabled();
+
+// Returns the endpoint of this process in `*endpoint`, or an error if shared
+// memory is not supported on this platform.
+Status GetSharedMemoryEndpoint(std::string* endpoint);
+
+// Returns true if `endpoint` was created by a process that shares memory with
+// this process. The result is cached.
+bool IsSharedMemoryPeer(const std::string& endpoint);
+
+// Returns true if `tensor` is large enough, and of a type that may be sent
+// through shared memory.
+bool CanSendThroughSharedMemory(const Tensor& tensor);
+
+// Writes the content of `tensor` to a new segment described by `*extra`.
+// Segments that have not been mapped by their receiver after a timeout are
+// removed.
+Status WriteTensorToSharedMemory(const Tensor& tensor,
+                                 SharedMemoryRecvResponseExtra* extra);
+
+// Maps the segment described by `extra` as the buffer of a new tensor of type
+// `dtype` and shape `shape`, which is returned in `*tensor`, and removes the
+// name of the segment.
+Status MapTensorFromSharedMemory(const SharedMemoryRecvResponseExtra& extra,
+                                 DataType dtype, const TensorShape& shape,
+                                 Tensor* tensor);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_SHARED_MEMORY_TRANSPORT_H_
@@ -0,0 +1,84 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/shared_memory_transport.h"
+
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/transport_options.pb.h"
+
+namespace tensorflow {
+namespace {
+
+#if defined(__linux__)
+
+Tensor LargeTensor() {
+  // 4MB, above the threshold for shared memory.
+  Tensor tensor(DT_FLOAT, TensorShape({1024, 1024}));
+  test::FillFn<float>(&tensor, [](int i) { return static_cast<float>(i); });
+  return tensor;
+}
+
+TEST(SharedMemoryTransportTest, RoundTrip) {
+  Tensor tensor = LargeTensor();
+  ASSERT_TRUE(CanSendThroughSharedMemory(tensor));
+  SharedMemoryRecvResponseExtra extra;
+  TF_ASSERT_OK(WriteTensorToSharedMemory(tensor, &extra));
+  EXPECT_EQ(extra.num_bytes(), tensor.TotalBytes());
+
+  Tensor received;
+  TF_ASSERT_OK(MapTensorFromSharedMemory(extra, tensor.dtype(),
+                                         tensor.shape(), &received));
+  test::ExpectTensorEqual<float>(tensor, received);
+
+  // The segment is removed once it is mapped.
+  Tensor again;
+  EXPECT_FALSE(
+      MapTensorFromSharedMemory(extra, tensor.dtype(), tensor.shape(), &again)
+          .ok());
+}
+
+TEST(SharedMemoryTransportTest, MismatchedSize) {
+  Tensor tensor = LargeTensor();
+  SharedMemoryRecvResponseExtra extra;
+  TF_ASSERT_OK(WriteTensorToSharedMemory(tensor, &extra));
+  Tensor received;
+  Status s = MapTensorFromSharedMemory(extra, DT_FLOAT, TensorShape({1024}),
+                                       &received);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+TEST(SharedMemoryTransportTest, Peers) {
+  std::string endpoint;
+  TF_ASSERT_OK(GetSharedMemoryEndpoint(&endpoint));
+  EXPECT_TRUE(IsSharedMemoryPeer(endpoint));
+  EXPECT_FALSE(IsSharedMemoryPeer("/tf_rpc_no_such_endpoint"));
+  EXPECT_FALSE(IsSharedMemoryPeer(""));
+}
+
+#endif  // defined(__linux__)
+
+TEST(SharedMemoryTransportTest, SmallOrStringTensors) {
+  EXPECT_FALSE(CanSendThroughSharedMemory(Tensor(DT_FLOAT, TensorShape({16}))));
+  EXPECT_FALSE(
+      CanSendThroughSharedMemory(Tensor(DT_STRING, TensorShape({1 << 20}))));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,14 +15,51 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <algorithm>
+
 #include "google/protobuf/any.pb.h"
 
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/shared_memory_transport.h"
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/snappy.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* recv_tensor_logical_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/recv_tensor_logical_bytes",
+    "The number of bytes of the tensors sent in RecvTensor responses.",
+    "wire_encoding");
+
+auto* recv_tensor_wire_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc/recv_tensor_wire_bytes",
+    "The number of bytes of tensor content sent in RecvTensor responses, "
+    "after applying the wire encoding.",
+    "wire_encoding");
+
+// Smaller tensors are not worth compressing.
+constexpr int64_t kMinCompressedBytes = 4096;
+
+bool ReadBoolFromEnv(const char* name) {
+  bool value;
+  TF_CHECK_OK(ReadBoolFromEnvVar(name, false, &value));
+  return value;
+}
+
+bool Accepts(const protobuf::RepeatedField<int>& accepted,
+             TensorWireEncoding encoding) {
+  return std::find(accepted.begin(), accepted.end(), encoding) !=
+         accepted.end();
+}
+
+}  // namespace
+
 TensorResponse::Source::~Source() {}
 
 void TensorResponse::Clear() {
@@ -30,6 +67,9 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  accel_device_ = nullptr;
+  device_context_ = nullptr;
+  host_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -50,9 +90,25 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
   allocator_ = device_->GetAllocator(alloc_attrs_);
 }
 
+void TensorResponse::InitAlloc(Device* d, const AllocatorAttributes& aa) {
+  InitAlloc(static_cast<DeviceBase*>(d), aa);
+  const DeviceBase::AcceleratorDeviceInfo* info =
+      d->tensorflow_accelerator_device_info();
+  if (on_host_ || info == nullptr || info->default_context == nullptr) {
+    return;
+  }
+  accel_device_ = d;
+  device_context_ = info->default_context;
+  AllocatorAttributes host_attrs;
+  host_attrs.set_on_host(true);
+  host_attrs.set_gpu_compatible(true);
+  host_allocator_ = d->GetAllocator(host_attrs);
+}
+
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
+  TF_RETURN_IF_ERROR(DecodeTensorFromWire(&meta_));
   if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
@@ -80,6 +136,19 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response,
 }
 
 Status TensorResponse::ParseFrom(Source* source) {
+  if (host_allocator_ != nullptr) {
+    // Parse the tensor content directly into pinned host memory, from which
+    // it can be copied to the device without going through a TensorProto.
+    if (already_used_) {
+      ClearTensor();
+    }
+    already_used_ = true;
+    if (ParseFast(source, host_allocator_)) {
+      TF_RETURN_IF_ERROR(MaybeMapSharedMemory());
+      return CopyTensorToDevice();
+    }
+    meta_.Clear();
+  }
   if (!on_host_) {
     protobuf::io::CodedInputStream input(source->contents());
 
@@ -87,6 +156,7 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    TF_RETURN_IF_ERROR(DecodeTensorFromWire(&meta_));
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -101,8 +171,9 @@ Status TensorResponse::ParseFrom(Source* source) {
     ClearTensor();
   }
   already_used_ = true;
-  if (ParseFast(source)) return OkStatus();
+  if (ParseFast(source, allocator_)) return MaybeMapSharedMemory();
   meta_.Clear();
+  // Tensors with a wire encoding are only handled by the slow path.
   if (ParseSlow(source)) return OkStatus();
   return errors::InvalidArgument("Cannot parse tensor from response");
 }
@@ -144,7 +215,8 @@ bool ReadNestedMessage(protobuf::io::CodedInputStream* input,
 }  // namespace
 
 bool TensorResponse::ParseTensorSubmessage(
-    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta) {
+    protobuf::io::CodedInputStream* input, TensorProto* tensor_meta,
+    Allocator* allocator) {
   bool seen_tensor_content = false;
   while (true) {
     auto p = input->ReadTagWithCutoff(127);
@@ -155,7 +227,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -195,7 +267,7 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(allocator, tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -215,7 +287,7 @@ bool TensorResponse::ParseTensorSubmessage(
   }
 }
 
-bool TensorResponse::ParseFast(Source* source) {
+bool TensorResponse::ParseFast(Source* source, Allocator* allocator) {
   protobuf::io::CodedInputStream input(source->contents());
   while (true) {
     auto p = input.ReadTagWithCutoff(127);
@@ -233,7 +305,8 @@ bool TensorResponse::ParseFast(Source* source) {
         std::pair<protobuf::io::CodedInputStream::Limit, int> p =
             input.IncrementRecursionDepthAndPushLimit(length);
         if (p.second < 0 ||
-            !ParseTensorSubmessage(&input, meta_.mutable_tensor())) {
+            !ParseTensorSubmessage(&input, meta_.mutable_tensor(),
+                                   allocator)) {
           return false;
         }
         if (!input.DecrementRecursionDepthAndPopLimit(p.first)) {
@@ -275,10 +348,40 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
+Status TensorResponse::CopyTensorToDevice() {
+  Tensor host_tensor = std::move(tensor_);
+  Tensor device_tensor(allocator_, host_tensor.dtype(), host_tensor.shape());
+  if (host_tensor.NumElements() > 0) {
+    TF_RETURN_IF_ERROR(device_context_->CopyCPUTensorToDeviceSync(
+        &host_tensor, accel_device_, &device_tensor));
+  }
+  tensor_ = std::move(device_tensor);
+  return OkStatus();
+}
+
+Status TensorResponse::MaybeMapSharedMemory() {
+  if (!meta_.has_transport_options() ||
+      !meta_.transport_options().Is<SharedMemoryRecvResponseExtra>()) {
+    return OkStatus();
+  }
+  SharedMemoryRecvResponseExtra extra;
+  if (!meta_.transport_options().UnpackTo(&extra)) {
+    return errors::InvalidArgument("Cannot parse shared memory segment");
+  }
+  meta_.clear_transport_options();
+  return MapTensorFromSharedMemory(extra, tensor_.dtype(), tensor_.shape(),
+                                   &tensor_);
+}
+
 bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
   }
+  Status s = DecodeTensorFromWire(&meta_);
+  if (!s.ok()) {
+    LOG(ERROR) << "Cannot decode tensor from response: " << s;
+    return false;
+  }
 
   Tensor parsed(meta_.tensor().dtype());
   if (!parsed.FromProto(allocator_, meta_.tensor())) {
@@ -296,4 +399,107 @@ bool TensorResponse::ParseSlow(Source* source) {
   return true;
 }
 
+void AddAcceptedWireEncodings(RecvTensorRequest* request) {
+  static const bool accept_snappy =
+      ReadBoolFromEnv("TF_RPC_TENSOR_COMPRESSION");
+  static const bool accept_bfloat16 =
+      ReadBoolFromEnv("TF_RPC_TENSOR_BFLOAT16");
+  if (accept_snappy) {
+    request->add_accepted_wire_encodings(WIRE_ENCODING_SNAPPY);
+  }
+  if (accept_bfloat16) {
+    request->add_accepted_wire_encodings(WIRE_ENCODING_BFLOAT16);
+  }
+}
+
+TensorWireEncoding EncodeTensorForWire(
+    const Tensor& val, const protobuf::RepeatedField<int>& accepted,
+    TensorProto* proto) {
+  const int64_t num_elements = val.NumElements();
+  if (val.dtype() == DT_FLOAT && num_elements > 0 &&
+      Accepts(accepted, WIRE_ENCODING_BFLOAT16)) {
+    std::string* content = proto->mutable_tensor_content();
+    content->resize(num_elements * sizeof(bfloat16));
+    RoundFloatToBFloat16(val.flat<float>().data(),
+                         reinterpret_cast<bfloat16*>(&(*content)[0]),
+                         num_elements);
+    proto->set_dtype(DT_BFLOAT16);
+    val.shape().AsProto(proto->mutable_tensor_shape());
+    return WIRE_ENCODING_BFLOAT16;
+  }
+  if ((DataTypeIsInteger(val.dtype()) || val.dtype() == DT_BOOL) &&
+      val.TotalBytes() >= kMinCompressedBytes &&
+      Accepts(accepted, WIRE_ENCODING_SNAPPY)) {
+    const StringPiece data = val.tensor_data();
+    std::string compressed;
+    // Snappy_Compress() fails if snappy is not available.
+    if (!port::Snappy_Compress(data.data(), data.size(), &compressed) ||
+        compressed.size() >= data.size()) {
+      return WIRE_ENCODING_NONE;
+    }
+    proto->set_dtype(val.dtype());
+    val.shape().AsProto(proto->mutable_tensor_shape());
+    *proto->mutable_tensor_content() = std::move(compressed);
+    return WIRE_ENCODING_SNAPPY;
+  }
+  return WIRE_ENCODING_NONE;
+}
+
+Status DecodeTensorFromWire(RecvTensorResponse* response) {
+  const TensorWireEncoding encoding = response->wire_encoding();
+  if (encoding == WIRE_ENCODING_NONE) {
+    return OkStatus();
+  }
+  TensorProto* proto = response->mutable_tensor();
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(proto->tensor_shape(),
+                                                   &shape));
+  const int64_t num_elements = shape.num_elements();
+  const std::string& content = proto->tensor_content();
+  std::string decoded;
+  switch (encoding) {
+    case WIRE_ENCODING_SNAPPY: {
+      size_t num_bytes;
+      if (!DataTypeCanUseMemcpy(proto->dtype()) ||
+          !port::Snappy_GetUncompressedLength(content.data(), content.size(),
+                                              &num_bytes) ||
+          num_bytes != num_elements * DataTypeSize(proto->dtype())) {
+        return errors::InvalidArgument(
+            "Invalid snappy-compressed tensor content");
+      }
+      decoded.resize(num_bytes);
+      if (!port::Snappy_Uncompress(content.data(), content.size(),
+                                   &decoded[0])) {
+        return errors::InvalidArgument(
+            "Cannot uncompress snappy-compressed tensor content");
+      }
+      break;
+    }
+    case WIRE_ENCODING_BFLOAT16: {
+      if (proto->dtype() != DT_BFLOAT16 ||
+          content.size() != num_elements * sizeof(bfloat16)) {
+        return errors::InvalidArgument("Invalid bfloat16 tensor content");
+      }
+      decoded.resize(num_elements * sizeof(float));
+      BFloat16ToFloat(reinterpret_cast<const bfloat16*>(content.data()),
+                      reinterpret_cast<float*>(&decoded[0]), num_elements);
+      proto->set_dtype(DT_FLOAT);
+      break;
+    }
+    default:
+      return errors::InvalidArgument("Unknown tensor wire encoding ",
+                                     encoding);
+  }
+  *proto->mutable_tensor_content() = std::move(decoded);
+  response->clear_wire_encoding();
+  return OkStatus();
+}
+
+void RecordRecvTensorWireBytes(TensorWireEncoding encoding,
+                               int64_t logical_bytes, int64_t wire_bytes) {
+  const std::string& label = TensorWireEncoding_Name(encoding);
+  recv_tensor_logical_bytes->GetCell(label)->IncrementBy(logical_bytes);
+  recv_tensor_wire_bytes->GetCell(label)->IncrementBy(wire_bytes);
+}
+
 }  // namespace tensorflow
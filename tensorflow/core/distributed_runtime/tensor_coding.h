@@ -26,7 +26,9 @@ limitations under the License.
 namespace tensorflow {
 
 class Allocator;
+class Device;
 class DeviceBase;
+class DeviceContext;
 class TensorProto;
 
 // TensorResponse can be used as the destination of an RPC that returns
@@ -46,6 +48,11 @@ class TensorResponse {
   // Initialize memory allocation related members.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
+  // Same as above, but if `d` is an accelerator device, the tensor content is
+  // parsed straight into pinned host memory and copied from there to `d`,
+  // instead of going through an intermediate TensorProto.
+  void InitAlloc(Device* d, const AllocatorAttributes& aa);
+
   // Source provides a way for a particular RPC implementation to provide
   // received data to ParseFrom.
   class Source {
@@ -91,21 +98,61 @@ class TensorResponse {
   // Return pointer to the device hosting the tensor.
   DeviceBase* device() const { return device_; }
 
+  // Returns true if the tensor content may be received through shared memory,
+  // which requires it to be parsed into host memory.
+  bool AcceptsSharedMemory() const {
+    return on_host_ || host_allocator_ != nullptr;
+  }
+
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
-                             TensorProto* tensor_meta);
-  bool ParseFast(Source* source);
+                             TensorProto* tensor_meta, Allocator* allocator);
+  bool ParseFast(Source* source, Allocator* allocator);
   bool ParseSlow(Source* source);
 
+  // Replaces tensor_, which is in host memory, with a copy on accel_device_.
+  Status CopyTensorToDevice();
+
+  // If the tensor content was sent through shared memory, replaces tensor_
+  // with a tensor backed by the shared memory segment.
+  Status MaybeMapSharedMemory();
+
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Set when tensors for an accelerator device are staged in host memory.
+  Device* accel_device_ = nullptr;
+  DeviceContext* device_context_ = nullptr;
+  Allocator* host_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
 };
 
+// Adds the wire encodings that this process accepts for received tensors to
+// `request`. Snappy compression of integer and boolean tensors is accepted if
+// the environment variable TF_RPC_TENSOR_COMPRESSION is true, and the lossy
+// bfloat16 encoding of float tensors if TF_RPC_TENSOR_BFLOAT16 is true.
+void AddAcceptedWireEncodings(RecvTensorRequest* request);
+
+// Encodes `val` into `*proto` with one of the `accepted` wire encodings that
+// applies to its dtype, and returns the encoding. Returns WIRE_ENCODING_NONE,
+// leaving `*proto` unchanged, if no accepted encoding applies or reduces the
+// size of `val`.
+TensorWireEncoding EncodeTensorForWire(
+    const Tensor& val, const protobuf::RepeatedField<int>& accepted,
+    TensorProto* proto);
+
+// Reverts the wire encoding of `response->tensor()`, and clears
+// `response->wire_encoding()`.
+Status DecodeTensorFromWire(RecvTensorResponse* response);
+
+// Records that a RecvTensor response sent a tensor of `logical_bytes` with
+// `wire_bytes` of content.
+void RecordRecvTensorWireBytes(TensorWireEncoding encoding,
+                               int64_t logical_bytes, int64_t wire_bytes);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_CODING_H_
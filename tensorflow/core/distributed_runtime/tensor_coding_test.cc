@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include <cstring>
+
+#include "tensorflow/core/framework/device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -46,6 +50,65 @@ class DummyDevice : public DeviceBase {
   DeviceAttributes attr_;
 };
 
+// Copies tensors "to the device" with memcpy and counts the copies.
+class FakeAcceleratorContext : public DeviceContext {
+ public:
+  void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
+                             Tensor* device_tensor, StatusCallback done,
+                             bool sync_dst_compute) const override {
+    ++num_copies;
+    StringPiece src = cpu_tensor->tensor_data();
+    memcpy(const_cast<char*>(device_tensor->tensor_data().data()), src.data(),
+           src.size());
+    done(OkStatus());
+  }
+
+  mutable int num_copies = 0;
+};
+
+class FakeAcceleratorDevice : public Device {
+ public:
+  explicit FakeAcceleratorDevice(Env* env)
+      : Device(env, MakeAttributes()), context_(new FakeAcceleratorContext) {
+    info_.default_context = context_;
+    set_tensorflow_accelerator_device_info(&info_);
+  }
+  ~FakeAcceleratorDevice() override { context_->Unref(); }
+
+  Status Sync() override { return OkStatus(); }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+
+  Status MakeTensorFromProto(const TensorProto& tensor_proto,
+                             const AllocatorAttributes alloc_attrs,
+                             Tensor* tensor) override {
+    ++num_protos;
+    Tensor parsed(tensor_proto.dtype());
+    if (!parsed.FromProto(cpu_allocator(), tensor_proto)) {
+      return errors::InvalidArgument("Cannot parse tensor from proto");
+    }
+    *tensor = std::move(parsed);
+    return OkStatus();
+  }
+
+  const FakeAcceleratorContext* context() const { return context_; }
+
+  int num_protos = 0;
+
+ private:
+  static DeviceAttributes MakeAttributes() {
+    DeviceAttributes attr;
+    attr.set_name("/job:a/replica:0/task:0/device:FAKE_GPU:0");
+    attr.set_device_type("FAKE_GPU");
+    return attr;
+  }
+
+  FakeAcceleratorContext* context_;
+  AcceleratorDeviceInfo info_;
+};
+
 class StringSource : public TensorResponse::Source {
  public:
   explicit StringSource(const string* s, int block_size)
@@ -156,6 +219,124 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+TEST(TensorResponseAcceleratorTest, ParsesIntoHostMemoryAndCopies) {
+  Tensor src = test::AsTensor<float>({1.0, 2.0, 3.0, 4.0}, {2, 2});
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  StringSource source(&encoded, 3);
+
+  FakeAcceleratorDevice device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(response.metadata().send_start_micros(), 123456);
+  test::ExpectTensorEqual<float>(response.tensor(), src);
+  EXPECT_EQ(device.context()->num_copies, 1);
+  EXPECT_EQ(device.num_protos, 0);
+}
+
+TEST(TensorResponseAcceleratorTest, FallsBackToTensorProto) {
+  Tensor src = test::AsTensor<tstring>({"a", "b"}, {2});
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+  StringSource source(&encoded, 1024);
+
+  FakeAcceleratorDevice device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&device, AllocatorAttributes());
+  TF_ASSERT_OK(response.ParseFrom(&source));
+  test::ExpectTensorEqual<tstring>(response.tensor(), src);
+  EXPECT_EQ(device.context()->num_copies, 0);
+  EXPECT_EQ(device.num_protos, 1);
+}
+
+class TensorWireEncodingTest : public ::testing::Test {
+ protected:
+  // Encodes `src` with one of `accepted`, and parses it back into
+  // `*response_`. Returns the encoding used and the encoded content size.
+  TensorWireEncoding RoundTrip(const Tensor& src,
+                               std::vector<TensorWireEncoding> accepted,
+                               size_t* encoded_bytes) {
+    RecvTensorRequest request;
+    for (TensorWireEncoding encoding : accepted) {
+      request.add_accepted_wire_encodings(encoding);
+    }
+    RecvTensorResponse proto;
+    const TensorWireEncoding encoding = EncodeTensorForWire(
+        src, request.accepted_wire_encodings(), proto.mutable_tensor());
+    if (encoding == WIRE_ENCODING_NONE) {
+      src.AsProtoTensorContent(proto.mutable_tensor());
+    }
+    *encoded_bytes = proto.tensor().tensor_content().size();
+    proto.set_wire_encoding(encoding);
+    string encoded;
+    proto.AppendToString(&encoded);
+    StringSource source(&encoded, 1024);
+    response_.InitAlloc(&cpu_device_, AllocatorAttributes());
+    TF_CHECK_OK(response_.ParseFrom(&source));
+    EXPECT_EQ(response_.metadata().wire_encoding(), WIRE_ENCODING_NONE);
+    return encoding;
+  }
+
+  DummyDevice cpu_device_{Env::Default()};
+  TensorResponse response_;
+};
+
+TEST_F(TensorWireEncodingTest, BFloat16) {
+  // These values are exactly representable as bfloat16.
+  Tensor src = test::AsTensor<float>({1.0, -2.5, 0.125, 384.0}, {2, 2});
+  size_t encoded_bytes;
+  EXPECT_EQ(RoundTrip(src, {WIRE_ENCODING_BFLOAT16}, &encoded_bytes),
+            WIRE_ENCODING_BFLOAT16);
+  EXPECT_EQ(encoded_bytes, src.TotalBytes() / 2);
+  test::ExpectTensorEqual<float>(response_.tensor(), src);
+}
+
+TEST_F(TensorWireEncodingTest, Snappy) {
+  Tensor src(DT_INT64, TensorShape({4096}));
+  test::FillFn<int64_t>(&src, [](int i) { return i % 16; });
+  size_t encoded_bytes;
+  const TensorWireEncoding encoding =
+      RoundTrip(src, {WIRE_ENCODING_SNAPPY}, &encoded_bytes);
+  // The tensor is sent as is if snappy is not available.
+  if (encoding == WIRE_ENCODING_SNAPPY) {
+    EXPECT_LT(encoded_bytes, src.TotalBytes());
+  } else {
+    EXPECT_EQ(encoding, WIRE_ENCODING_NONE);
+  }
+  test::ExpectTensorEqual<int64_t>(response_.tensor(), src);
+}
+
+TEST_F(TensorWireEncodingTest, OnlyAcceptedEncodingsForTheDtype) {
+  Tensor floats(DT_FLOAT, TensorShape({4096}));
+  floats.flat<float>().setZero();
+  Tensor small_ints = test::AsTensor<int32>({1, 2, 3});
+  size_t encoded_bytes;
+  EXPECT_EQ(RoundTrip(floats, {}, &encoded_bytes), WIRE_ENCODING_NONE);
+  EXPECT_EQ(RoundTrip(floats, {WIRE_ENCODING_SNAPPY}, &encoded_bytes),
+            WIRE_ENCODING_NONE);
+  EXPECT_EQ(RoundTrip(small_ints,
+                      {WIRE_ENCODING_SNAPPY, WIRE_ENCODING_BFLOAT16},
+                      &encoded_bytes),
+            WIRE_ENCODING_NONE);
+  test::ExpectTensorEqual<int32>(response_.tensor(), small_ints);
+}
+
+TEST(DecodeTensorFromWireTest, RejectsInvalidContent) {
+  RecvTensorResponse response;
+  test::AsTensor<float>({1.0, 2.0}).AsProtoTensorContent(
+      response.mutable_tensor());
+  response.set_wire_encoding(WIRE_ENCODING_BFLOAT16);
+  EXPECT_TRUE(errors::IsInvalidArgument(DecodeTensorFromWire(&response)));
+  response.set_wire_encoding(WIRE_ENCODING_SNAPPY);
+  EXPECT_TRUE(errors::IsInvalidArgument(DecodeTensorFromWire(&response)));
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
@@ -86,6 +86,22 @@ struct AllocatorStats {
 
   int64_t largest_free_block_bytes;  // Largest free block's size in heap.
 
+  // For allocators that keep a cache of free blocks in front of their main
+  // pool (e.g. BFCAllocator with `small_chunk_cache`), the number of
+  // allocations served from the cache, and the number of cacheable
+  // allocations that missed it. These are not part of
+  // stream_executor::AllocatorStats.
+  int64_t num_cache_hits;
+  int64_t num_cache_misses;
+
+  // For allocators backed by a driver memory pool (e.g. cudaMallocAsync),
+  // the bytes of the pool used by allocations, as reported by the driver, and
+  // their peak. Unlike bytes_in_use, they include the memory of frees that
+  // are not yet complete on their stream. These are not part of
+  // stream_executor::AllocatorStats.
+  int64_t pool_bytes_in_use;
+  int64_t peak_pool_bytes_in_use;
+
   AllocatorStats()
       : num_allocs(0),
         bytes_in_use(0),
@@ -93,7 +109,11 @@ struct AllocatorStats {
         largest_alloc_size(0),
         bytes_reserved(0),
         peak_bytes_reserved(0),
-        largest_free_block_bytes(0) {}
+        largest_free_block_bytes(0),
+        num_cache_hits(0),
+        num_cache_misses(0),
+        pool_bytes_in_use(0),
+        peak_pool_bytes_in_use(0) {}
 
   std::string DebugString() const;
 };
@@ -403,6 +423,32 @@ class SubAllocator {
     return AllocatorMemoryType::kUnknown;
   }
 
+  // Returns the granularity at which Decommit() can release the physical
+  // memory backing allocations, or 0 if this allocator does not support it.
+  virtual size_t DecommitGranularity() const { return 0; }
+
+  // Releases the physical memory backing [ptr, ptr + num_bytes) while keeping
+  // these addresses reserved. The range must be aligned to
+  // DecommitGranularity() and lie within memory returned by Alloc(). Parts of
+  // the range that are already decommitted are skipped. Returns the number of
+  // bytes released.
+  virtual size_t Decommit(void* ptr, size_t num_bytes) { return 0; }
+
+  // Returns the number of bytes that Commit(ptr, num_bytes) would back with
+  // physical memory. The range need not be aligned.
+  virtual size_t DecommittedBytes(const void* ptr, size_t num_bytes) const {
+    return 0;
+  }
+
+  // Backs the decommitted parts of the DecommitGranularity() aligned range
+  // around [ptr, ptr + num_bytes) with physical memory again, and returns the
+  // number of bytes committed in bytes_committed. Returns false, leaving the
+  // range unchanged, if that fails.
+  virtual bool Commit(void* ptr, size_t num_bytes, size_t* bytes_committed) {
+    *bytes_committed = 0;
+    return true;
+  }
+
  protected:
   // Implementation of Alloc() method must call this on newly allocated
   // value.
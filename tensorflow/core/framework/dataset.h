@@ -408,6 +408,7 @@ class IteratorContext {
           runner_threadpool_size(ctx->runner_threadpool_size()),
           split_providers(ctx->split_providers()),
           stats_aggregator(ctx->stats_aggregator()),
+          symbolic_checkpoint(ctx->symbolic_checkpoint()),
           thread_factory(ctx->thread_factory()),
           thread_pool(ctx->thread_pool()) {}
 
@@ -492,6 +493,13 @@ class IteratorContext {
     // using C++ based implementation for tf.data options (on 4/12/2021).
     std::shared_ptr<StatsAggregator> stats_aggregator = nullptr;
 
+    // Whether iterators should be checkpointed symbolically, i.e. by recording
+    // the positions of their inputs instead of the contents of their buffers.
+    // Set by the root of input pipelines that opted in through
+    // `Options.symbolic_checkpoint` and whose datasets all return true from
+    // `DatasetBase::SymbolicCheckpointCompatible()`.
+    bool symbolic_checkpoint = false;
+
     // A factory for creating threads to perform blocking work.
     std::shared_ptr<ThreadFactory> thread_factory = nullptr;
 
@@ -539,6 +547,8 @@ class IteratorContext {
 
   ResourceMgr* resource_mgr() { return params_.resource_mgr; }
 
+  bool symbolic_checkpoint() { return params_.symbolic_checkpoint; }
+
   std::function<void(std::function<void()>)>* runner() {
     return &params_.runner;
   }
@@ -654,7 +664,7 @@ class SerializationContext {
     bool is_graph_rewrite = false;
 
     // A resource manager for looking up resources during serialization.
-    ResourceMgr* resource_mgr;
+    ResourceMgr* resource_mgr = nullptr;
 
     // The name of the device doing the serialization.
     std::string device_name;
@@ -1020,6 +1030,14 @@ class DatasetBase : public core::RefCounted {
   // state. Otherwise, the method returns `Status::OK()`.
   virtual Status CheckExternalState() const = 0;
 
+  // Indicates whether iterators of the dataset support symbolic checkpoints
+  // (see `IteratorContext::symbolic_checkpoint()`). In a symbolic checkpoint,
+  // an iterator saves only what is needed to recompute its state from the
+  // state of its inputs, e.g. element indices, file offsets or random number
+  // generator states, and iterators that buffer elements of their input save
+  // the state that their input had before producing the buffered elements.
+  virtual bool SymbolicCheckpointCompatible() const { return false; }
+
   // Indicates whether the dataset is compatible with random access.
   Status CheckRandomAccessCompatible(const int64 index) const;
 
@@ -64,6 +64,9 @@ struct LocalRendezvous::Item {
   // Link to next item in an ItemQueue.
   Item* next = nullptr;
 
+  // Hash of the key, set for items deposited in a slot.
+  uint64 key_hash = 0;
+
   // The validity of `send_state` or `recv_state` is determined by `type ==
   // kSend` or `type == kRecv` respectively.
   union {
@@ -102,7 +105,8 @@ LocalRendezvous::~LocalRendezvous() {
   // calls have finished and the tensors have been released from the queue.
   {
     mutex_lock l(mu_);
-    while (pending_callback_counter_ != 0) {
+    while (pending_callback_counter_ != 0 ||
+           pending_slot_callbacks_.load(std::memory_order_acquire) != 0) {
       pending_callback_cond_var_.wait_for(l, std::chrono::milliseconds(50));
     }
   }
@@ -110,12 +114,198 @@ LocalRendezvous::~LocalRendezvous() {
   if (!table_.empty()) {
     StartAbort(errors::Cancelled("LocalRendezvous deleted"));
   }
+  AbortSlots(errors::Cancelled("LocalRendezvous deleted"));
+  for (auto& block : slot_blocks_) {
+    delete block.load(std::memory_order_relaxed);
+  }
 }
 
 namespace {
 uint64 KeyHash(const StringPiece& k) { return Hash64(k.data(), k.size()); }
+
+Status SlotRecvCancelledStatus() {
+  return StatusGroup::MakeDerived(errors::Cancelled("RecvAsync is cancelled."));
+}
 }  // namespace
 
+LocalRendezvous::Item* LocalRendezvous::ConsumedSlot() {
+  return reinterpret_cast<Item*>(1);
+}
+
+std::atomic<LocalRendezvous::Item*>* LocalRendezvous::GetSlot(
+    int64_t slot_id) {
+  const int64_t block_index = slot_id / kSlotsPerBlock;
+  if (block_index >= kMaxSlotBlocks) return nullptr;
+  SlotBlock* block = slot_blocks_[block_index].load(std::memory_order_acquire);
+  if (block == nullptr) {
+    SlotBlock* new_block = new SlotBlock;
+    if (slot_blocks_[block_index].compare_exchange_strong(
+            block, new_block, std::memory_order_acq_rel)) {
+      block = new_block;
+    } else {
+      delete new_block;
+    }
+  }
+  return &block->items[slot_id % kSlotsPerBlock];
+}
+
+bool LocalRendezvous::TrySendThroughSlot(int64_t slot_id, uint64 key_hash,
+                                         const Rendezvous::Args& send_args,
+                                         const Tensor& val, bool is_dead) {
+  std::atomic<Item*>* slot = GetSlot(slot_id);
+  if (slot == nullptr) return false;
+  Item* item = slot->load(std::memory_order_acquire);
+  if (item == nullptr) {
+    // There is no waiter yet. Leave the value in the slot.
+    Item* new_item = new Item(send_args, val, is_dead);
+    new_item->key_hash = key_hash;
+    if (slot->compare_exchange_strong(item, new_item,
+                                      std::memory_order_acq_rel)) {
+      return true;
+    }
+    delete new_item;
+  }
+  if (item == ConsumedSlot() || item->type != Item::kRecv ||
+      item->key_hash != key_hash) {
+    return false;
+  }
+  if (!slot->compare_exchange_strong(item, ConsumedSlot(),
+                                     std::memory_order_acq_rel)) {
+    // The waiter was cancelled or aborted concurrently.
+    return false;
+  }
+
+  // Keep the rendezvous alive while the done-callback runs, as in Send().
+  core::RefCountPtr<const Rendezvous> rc_owner_ref;
+  if (rc_owner_) {
+    rc_owner_ref.reset(rc_owner_);
+    rc_owner_->Ref();
+  }
+  pending_slot_callbacks_.fetch_add(1, std::memory_order_relaxed);
+  InvokeSlotWaiter(item, OkStatus(), send_args, val, is_dead);
+  pending_slot_callbacks_.fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+bool LocalRendezvous::TryRecvThroughSlot(int64_t slot_id, uint64 key_hash,
+                                         const Rendezvous::Args& recv_args,
+                                         Rendezvous::DoneCallback* done) {
+  std::atomic<Item*>* slot = GetSlot(slot_id);
+  if (slot == nullptr) return false;
+  Item* item = slot->load(std::memory_order_acquire);
+  if (item != nullptr) {
+    if (item == ConsumedSlot() || item->type != Item::kSend ||
+        item->key_hash != key_hash ||
+        !slot->compare_exchange_strong(item, ConsumedSlot(),
+                                       std::memory_order_acq_rel)) {
+      return false;
+    }
+    (*done)(OkStatus(), item->args, recv_args, *item->send_state.value,
+            item->send_state.is_dead);
+    delete item;
+    return true;
+  }
+
+  // There is no value yet. Leave a waiter in the slot. Unlike in RecvAsync(),
+  // the waiter is not wrapped: whoever takes it from the slot deregisters its
+  // cancellation callback in InvokeSlotWaiter().
+  CancellationManager* cm = recv_args.cancellation_manager;
+  CancellationToken token = CancellationManager::kInvalidToken;
+  if (cm != nullptr) token = cm->get_cancellation_token();
+  Item* new_item = new Item(recv_args, std::move(*done), token);
+  new_item->key_hash = key_hash;
+  if (cm != nullptr) {
+    // The reference is dropped as in RecvAsync(), either by the cancellation
+    // callback or after deregistering it.
+    if (rc_owner_) rc_owner_->Ref();
+    if (!cm->RegisterCallback(token, [this, slot, new_item]() {
+          CancelSlotRecv(slot, new_item);
+        })) {
+      if (rc_owner_) rc_owner_->Unref();
+      (*new_item->recv_state.waiter)(SlotRecvCancelledStatus(),
+                                     Rendezvous::Args(), recv_args, Tensor(),
+                                     /*is_dead=*/false);
+      delete new_item;
+      return true;
+    }
+  }
+
+  Item* expected = nullptr;
+  if (!slot->compare_exchange_strong(expected, new_item,
+                                     std::memory_order_acq_rel)) {
+    // The slot was filled concurrently. Take the waiter back and start over,
+    // which either consumes the value in the slot or uses the table.
+    if (cm != nullptr && !cm->TryDeregisterCallback(token)) {
+      // `cm` is being cancelled, and the callback will drop the reference.
+      (*new_item->recv_state.waiter)(SlotRecvCancelledStatus(),
+                                     Rendezvous::Args(), recv_args, Tensor(),
+                                     /*is_dead=*/false);
+      delete new_item;
+      return true;
+    }
+    if (cm != nullptr && rc_owner_) rc_owner_->Unref();
+    *done = std::move(*new_item->recv_state.waiter);
+    delete new_item;
+    return TryRecvThroughSlot(slot_id, key_hash, recv_args, done);
+  }
+
+  if (TF_PREDICT_FALSE(aborted_.load(std::memory_order_acquire))) {
+    // StartAbort() may have swept the slots before the waiter was deposited.
+    if (slot->compare_exchange_strong(expected, ConsumedSlot(),
+                                      std::memory_order_acq_rel)) {
+      core::RefCountPtr<const Rendezvous> rc_owner_ref;
+      if (rc_owner_) {
+        rc_owner_ref.reset(rc_owner_);
+        rc_owner_->Ref();
+      }
+      InvokeSlotWaiter(new_item, status(), Rendezvous::Args(), Tensor(),
+                       /*is_dead=*/false);
+    }
+  }
+  return true;
+}
+
+void LocalRendezvous::InvokeSlotWaiter(Item* item, const Status& status,
+                                       const Rendezvous::Args& send_args,
+                                       const Tensor& val, bool is_dead) {
+  DCHECK_EQ(item->type, Item::kRecv);
+  CancellationManager* cm = item->args.cancellation_manager;
+  if (cm != nullptr &&
+      cm->TryDeregisterCallback(item->recv_state.cancellation_token)) {
+    if (rc_owner_) rc_owner_->Unref();
+  }
+  (*item->recv_state.waiter)(status, send_args, item->args, val, is_dead);
+  delete item;
+}
+
+void LocalRendezvous::CancelSlotRecv(std::atomic<Item*>* slot, Item* item) {
+  Item* expected = item;
+  if (slot->compare_exchange_strong(expected, ConsumedSlot(),
+                                    std::memory_order_acq_rel)) {
+    (*item->recv_state.waiter)(SlotRecvCancelledStatus(), Rendezvous::Args(),
+                               item->args, Tensor(), /*is_dead=*/false);
+    delete item;
+  }
+  if (rc_owner_) rc_owner_->Unref();
+}
+
+void LocalRendezvous::AbortSlots(const Status& status) {
+  for (auto& block_ptr : slot_blocks_) {
+    SlotBlock* block = block_ptr.load(std::memory_order_acquire);
+    if (block == nullptr) continue;
+    for (std::atomic<Item*>& slot : block->items) {
+      Item* item = slot.exchange(ConsumedSlot(), std::memory_order_acq_rel);
+      if (item == nullptr || item == ConsumedSlot()) continue;
+      if (item->type == Item::kRecv) {
+        InvokeSlotWaiter(item, status, Rendezvous::Args(), Tensor(),
+                         /*is_dead=*/false);
+      } else {
+        delete item;
+      }
+    }
+  }
+}
+
 Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
                              const Rendezvous::Args& send_args,
                              const Tensor& val, const bool is_dead) {
@@ -132,6 +322,13 @@ Status LocalRendezvous::Send(const Rendezvous::ParsedKey& key,
         ->IncrementBy(1);
   }
 
+  if (send_args.rendezvous_slot >= 0 &&
+      !aborted_.load(std::memory_order_acquire) &&
+      TrySendThroughSlot(send_args.rendezvous_slot, key_hash, send_args, val,
+                         is_dead)) {
+    return OkStatus();
+  }
+
   mu_.lock();
   if (!status_.ok()) {
     // Rendezvous has been aborted.
@@ -196,6 +393,13 @@ void LocalRendezvous::RecvAsync(const Rendezvous::ParsedKey& key,
   uint64 key_hash = KeyHash(key.FullKey());
   DVLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
 
+  if (recv_args.rendezvous_slot >= 0 &&
+      !aborted_.load(std::memory_order_acquire) &&
+      TryRecvThroughSlot(recv_args.rendezvous_slot, key_hash, recv_args,
+                         &done)) {
+    return;
+  }
+
   mu_.lock();
   if (!status_.ok()) {
     // Rendezvous has been aborted.
@@ -360,6 +564,7 @@ void LocalRendezvous::StartAbort(const Status& status) {
   {
     mutex_lock l(mu_);
     status_.Update(status);
+    aborted_.store(true, std::memory_order_release);
     table_.swap(table);
   }
   for (auto& p : table) {
@@ -374,6 +579,7 @@ void LocalRendezvous::StartAbort(const Status& status) {
       delete to_delete;
     }
   }
+  AbortSlots(status);
 }
 
 Status LocalRendezvous::status() {
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 #define TENSORFLOW_CORE_FRAMEWORK_LOCAL_RENDEZVOUS_H_
 
+#include <atomic>
+
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -29,6 +31,13 @@ namespace tensorflow {
 // Implements the basic logic of matching Send and Recv operations. See
 // RendezvousInterface for more details.
 //
+// A Send and a Recv whose `Rendezvous::Args::rendezvous_slot` is set meet
+// through a pre-assigned atomic slot instead of the mutex-protected table.
+// Each slot holds at most one item per rendezvous: it goes from empty, to
+// holding a sent value or a waiter, to consumed. A Send or Recv falls back to
+// the table when its slot is consumed, or holds an item for a different key,
+// so slot ids only need to be unique within a graph.
+//
 // NOTE: Most users will use a class that wraps LocalRendezvous, such as
 // IntraProcessRendezvous or RemoteRendezvous. This class does not implement
 // RendezvousInterface because virtual dispatch to LocalRendezvous methods
@@ -40,7 +49,11 @@ class LocalRendezvous {
   // can make sure it outlives the async recv requests.
   // Pass in nullptr if the wrapping class is not refcounted.
   explicit LocalRendezvous(Rendezvous* owner)
-      : rc_owner_(owner), pending_callback_counter_(0) {}
+      : rc_owner_(owner), pending_callback_counter_(0) {
+    for (auto& block : slot_blocks_) {
+      block.store(nullptr, std::memory_order_relaxed);
+    }
+  }
   ~LocalRendezvous();
 
   Status Send(const Rendezvous::ParsedKey& key,
@@ -68,6 +81,46 @@ class LocalRendezvous {
 
   typedef gtl::FlatMap<uint64, ItemQueue> Table;
 
+  static constexpr int kSlotsPerBlock = 1024;
+  static constexpr int kMaxSlotBlocks = 64;
+
+  // Slots are allocated in blocks on first use. Slot ids beyond
+  // `kSlotsPerBlock * kMaxSlotBlocks` use the table.
+  struct SlotBlock {
+    SlotBlock() {
+      for (auto& item : items) item.store(nullptr, std::memory_order_relaxed);
+    }
+    std::atomic<Item*> items[kSlotsPerBlock];
+  };
+
+  // The value of a slot whose item has been consumed.
+  static Item* ConsumedSlot();
+
+  // Returns the slot `slot_id`, or nullptr if it is out of range.
+  std::atomic<Item*>* GetSlot(int64_t slot_id);
+
+  // Try to complete a Send or a Recv through a slot. Return false if the
+  // caller must use the table instead, in which case `done` is left intact.
+  bool TrySendThroughSlot(int64_t slot_id, uint64 key_hash,
+                          const Rendezvous::Args& send_args, const Tensor& val,
+                          bool is_dead);
+  bool TryRecvThroughSlot(int64_t slot_id, uint64 key_hash,
+                          const Rendezvous::Args& recv_args,
+                          Rendezvous::DoneCallback* done);
+
+  // Invokes the waiter of a Recv item taken from a slot, after deregistering
+  // its cancellation callback.
+  void InvokeSlotWaiter(Item* item, const Status& status,
+                        const Rendezvous::Args& send_args, const Tensor& val,
+                        bool is_dead);
+
+  // Cancellation callback of a Recv item deposited in `slot`.
+  void CancelSlotRecv(std::atomic<Item*>* slot, Item* item);
+
+  // Marks every allocated slot consumed, failing the pending Recvs with
+  // `status` and dropping the sent values.
+  void AbortSlots(const Status& status);
+
   // Pointer to the owner class of this LocalRendezvous if it is refcounted.
   const Rendezvous* rc_owner_;
 
@@ -79,6 +132,12 @@ class LocalRendezvous {
   int pending_callback_counter_ TF_GUARDED_BY(mu_);
   condition_variable pending_callback_cond_var_ TF_GUARDED_BY(mu_);
 
+  std::atomic<SlotBlock*> slot_blocks_[kMaxSlotBlocks];
+  // Set once `status_` is not OK.
+  std::atomic<bool> aborted_{false};
+  // Number of callbacks invoked from the slot fast path that are running.
+  std::atomic<int> pending_slot_callbacks_{0};
+
   TF_DISALLOW_COPY_AND_ASSIGN(LocalRendezvous);
 };
 
@@ -163,6 +163,27 @@ auto* tf_data_service_cross_trainer_cache_size_bytes =
         "/tensorflow/data/service/cross_trainer_cache_size_bytes",
         "tf.data service cross-trainer cache memory usage in bytes.");
 
+auto* tf_data_service_cross_trainer_cache_trainer_queries_counter =
+    monitoring::Counter<2>::New(
+        "/tensorflow/data/service/cross_trainer_cache_trainer_queries",
+        "tf.data service cross-trainer cache queries by trainer. The result "
+        "can be memory, spill, or miss.",
+        "trainer_id", "result");
+
+auto* tf_data_service_cross_trainer_cache_trainer_lag =
+    monitoring::Gauge<int64_t, 1>::New(
+        "/tensorflow/data/service/cross_trainer_cache_trainer_lag",
+        "Number of tf.data service cross-trainer cache elements a trainer has "
+        "not read yet.",
+        "trainer_id");
+
+auto* tf_data_service_cross_trainer_cache_spill_bytes_counter =
+    monitoring::Counter<1>::New(
+        "/tensorflow/data/service/cross_trainer_cache_spill_bytes",
+        "Bytes written to or read from the tf.data service cross-trainer "
+        "cache spill tier.",
+        "operation");
+
 auto* tf_data_filename_counter = monitoring::Counter<2>::New(
     "/tensorflow/data/filename", "The file name read by a tf.data Dataset.",
     "name", "filename");
@@ -242,6 +263,20 @@ auto* bfc_allocator_delay =
                                 "The total time spent running each graph "
                                 "optimization pass in microseconds.");
 
+auto* device_event_completion_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/device_event_completion_latency_usecs",
+     "The time between queueing a callback with a device EventMgr and its "
+     "dispatch, in microseconds.",
+     "mode"},
+    // Power of 2 with bucket count 20 (> 0.5 seconds)
+    {monitoring::Buckets::Exponential(1, 2, 20)});
+
+auto* gpu_pageable_copy_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/gpu_pageable_copy_bytes",
+    "The number of bytes copied between a GPU and pageable host memory "
+    "without staging them in pinned host memory.",
+    "direction");
+
 auto* tpu_variable_distribution_time_usecs = monitoring::Counter<0>::New(
     "/tensorflow/tpu/variable_distribution_time",
     "Time spent sending variables from primary task to other worker tasks "
@@ -394,6 +429,25 @@ void RecordTFDataServiceCrossTrainerCacheSizeBytes(size_t bytes) {
       static_cast<int64_t>(bytes));
 }
 
+void RecordTFDataServiceCrossTrainerCacheTrainerQuery(
+    const string& trainer_id, const string& result) {
+  tf_data_service_cross_trainer_cache_trainer_queries_counter
+      ->GetCell(trainer_id, result)
+      ->IncrementBy(1);
+}
+
+void RecordTFDataServiceCrossTrainerCacheTrainerLag(const string& trainer_id,
+                                                    int64_t lag) {
+  tf_data_service_cross_trainer_cache_trainer_lag->GetCell(trainer_id)->Set(
+      lag);
+}
+
+void RecordTFDataServiceCrossTrainerCacheSpillBytes(const string& operation,
+                                                    int64_t bytes) {
+  tf_data_service_cross_trainer_cache_spill_bytes_counter->GetCell(operation)
+      ->IncrementBy(bytes);
+}
+
 void RecordTFDataFilename(const string& name, const string& filename) {
   tf_data_filename_counter->GetCell(name, filename)->IncrementBy(1);
 }
@@ -507,6 +561,15 @@ void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs) {
   }
 }
 
+void UpdateDeviceEventCompletionLatency(const string& mode,
+                                        const uint64 latency_usecs) {
+  device_event_completion_latency_usecs->GetCell(mode)->Add(latency_usecs);
+}
+
+void UpdateGpuPageableCopyBytes(const string& direction, int64_t num_bytes) {
+  gpu_pageable_copy_bytes->GetCell(direction)->IncrementBy(num_bytes);
+}
+
 void RecordUnusedOutput(const string& op_name) {
   graph_unused_outputs->GetCell(op_name)->IncrementBy(1);
 }
@@ -129,6 +129,21 @@ void RecordTFDataServiceCrossTrainerCacheQuery(bool cache_hit);
 // Records tf.data service cross-trainer cache memory usage in bytes.
 void RecordTFDataServiceCrossTrainerCacheSizeBytes(size_t bytes);
 
+// Records a tf.data service cross-trainer cache query by `trainer_id`. The
+// `result` is "memory" or "spill" if the element was read from memory or from
+// the spill tier, and "miss" if the trainer had to produce a new element.
+void RecordTFDataServiceCrossTrainerCacheTrainerQuery(
+    const string& trainer_id, const string& result);
+
+// Records the number of cached elements that `trainer_id` has not read yet.
+void RecordTFDataServiceCrossTrainerCacheTrainerLag(const string& trainer_id,
+                                                    int64_t lag);
+
+// Records bytes written to (`operation` is "write") or read from ("read") the
+// tf.data service cross-trainer cache spill tier.
+void RecordTFDataServiceCrossTrainerCacheSpillBytes(const string& operation,
+                                                    int64_t bytes);
+
 // Records the file name read by a tf.data Dataset.
 //
 // The `name` argument identifies the Dataset type (e.g. "TFRecordDataset").
@@ -323,6 +338,18 @@ void UpdateXlaCompilationTime(const uint64 compilation_time_usecs);
 // Updates the metrics stored about time BFC allocator spents during delay.
 void UpdateBfcAllocatorDelayTime(const uint64 delay_usecs);
 
+// Updates the metrics stored about the time between queueing a callback with
+// a device EventMgr and its dispatch, once the device work queued before it has
+// completed. `mode` is the way the completion was detected, "polling" or
+// "host_callback".
+void UpdateDeviceEventCompletionLatency(const string& mode,
+                                        const uint64 latency_usecs);
+
+// Updates the number of bytes copied between a GPU and pageable host memory
+// because no pinned staging buffer was available. `direction` is
+// "host_to_device" or "device_to_host".
+void UpdateGpuPageableCopyBytes(const string& direction, int64_t num_bytes);
+
 // Increments (by 1) a simple integer counter that is exposed for testing.
 void IncrementTestCounter(const string& name, const string& label);
 
@@ -191,6 +191,64 @@ void RecordAutotuneRamUsage(int64 ram_budget, double max_buffered_bytes) {
       max_buffered_bytes / static_cast<double>(ram_budget));
 }
 
+// A model is assumed to be able to use up to this multiple of the resources it
+// currently uses, so that its share leaves it room to grow.
+constexpr double kBudgetDemandGrowthFactor = 2.0;
+
+// Divides `total` between consumers with the given demands and weights, with
+// weighted max-min fairness, then divides what is left once all demands are
+// met in proportion to the weights. Every consumer gets at least `min_share`.
+std::vector<int64_t> DivideBudget(const std::vector<int64_t>& demands,
+                                  const std::vector<double>& weights,
+                                  int64_t total, int64_t min_share) {
+  const int n = demands.size();
+  std::vector<double> shares(n, 0.0);
+  std::vector<bool> satisfied(n, false);
+  double remaining = static_cast<double>(total);
+  int num_unsatisfied = n;
+  while (num_unsatisfied > 0 && remaining > 0) {
+    double weight_sum = 0;
+    for (int i = 0; i < n; ++i) {
+      if (!satisfied[i]) weight_sum += weights[i];
+    }
+    // Satisfies the consumers whose unmet demand is below their fair share of
+    // what remains, and repeats with the others.
+    bool any_satisfied = false;
+    double newly_allocated = 0;
+    for (int i = 0; i < n; ++i) {
+      if (satisfied[i]) continue;
+      const double fair_share = remaining * weights[i] / weight_sum;
+      const double unmet = demands[i] - shares[i];
+      if (unmet <= fair_share) {
+        shares[i] += unmet;
+        newly_allocated += unmet;
+        satisfied[i] = true;
+        --num_unsatisfied;
+        any_satisfied = true;
+      }
+    }
+    remaining -= newly_allocated;
+    if (!any_satisfied) {
+      for (int i = 0; i < n; ++i) {
+        if (!satisfied[i]) shares[i] += remaining * weights[i] / weight_sum;
+      }
+      remaining = 0;
+    }
+  }
+  if (remaining > 0) {
+    double weight_sum = 0;
+    for (int i = 0; i < n; ++i) weight_sum += weights[i];
+    for (int i = 0; i < n; ++i) {
+      shares[i] += remaining * weights[i] / weight_sum;
+    }
+  }
+  std::vector<int64_t> result(n);
+  for (int i = 0; i < n; ++i) {
+    result[i] = std::max(static_cast<int64_t>(shares[i]), min_share);
+  }
+  return result;
+}
+
 // Helper function for node traversal that doesn't skip any nodes.
 inline bool IsAnyNode(const std::shared_ptr<Node> node) { return true; }
 
@@ -596,11 +654,12 @@ class AsyncInterleaveMany : public Node {
 
   // The output time is the sum of self processing time and expected wait time
   // from the buffer model estimated using `ComputeWaitTime(producer_time,
-  // consumer_time, parallelism, ...)`, where `producer_time` is the average
+  // consumer_time, buffer_size, ...)`, where `producer_time` is the average
   // output time of inputs comprising the interleave "cycle" divided by
   // `parallelism`, `consumer_time` is the `input_time` specified through
-  // `input_times` divided by `num_inputs() - 1`, and if the node has
-  // parallelism parameter, then `buffer_size` is derived from `parallelism`.
+  // `input_times` divided by `num_inputs() - 1`, and `buffer_size` is
+  // `parallelism`, multiplied by the number of results buffered per input if
+  // the node has a `buffer_output_elements` parameter.
   void OutputTimeLocked(const NodeValues& input_times,
                         ParameterGradients* gradients, NodeValues* output_times,
                         NodeValues* output_time_gradients) const override
@@ -624,6 +683,13 @@ class AsyncInterleaveMany : public Node {
     if (parameter) {
       parallelism = std::min(parallelism, (*parameter)->value);
     }
+    double buffer_output_elements = 1.0;
+    auto* buffer_output_elements_parameter =
+        gtl::FindOrNull(parameters_, kBufferOutputElements);
+    if (buffer_output_elements_parameter) {
+      buffer_output_elements = (*buffer_output_elements_parameter)->value;
+    }
+    const double buffer_size = parallelism * buffer_output_elements;
     double output_time_for_inputs =
         OutputTimeForInputs(*output_times) -
         (*output_times)[inputs_.front()->long_name()];
@@ -634,7 +700,7 @@ class AsyncInterleaveMany : public Node {
       double producer_time_der = 0.0L;
       double consumer_time_der = 0.0L;
       double buffer_size_der = 0.0L;
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   &producer_time_der, &consumer_time_der,
                                   &buffer_size_der);
       double inputs_time_der_sum =
@@ -661,10 +727,19 @@ class AsyncInterleaveMany : public Node {
       // Add derivative w.r.t. own parallelism parameter.
       if (parameter && (*parameter)->state->tunable) {
         (*gradients)[std::make_pair(long_name(), (*parameter)->name)] =
-            buffer_size_der - producer_time_der * producer_time / parallelism;
+            buffer_size_der * buffer_output_elements -
+            producer_time_der * producer_time / parallelism;
+      }
+      // Add derivative w.r.t. own buffer output elements parameter.
+      if (buffer_output_elements_parameter &&
+          (*buffer_output_elements_parameter)->state->tunable) {
+        (*gradients)[std::make_pair(long_name(),
+                                    (*buffer_output_elements_parameter)
+                                        ->name)] =
+            buffer_size_der * parallelism;
       }
     } else {
-      wait_time = ComputeWaitTime(producer_time, consumer_time, parallelism,
+      wait_time = ComputeWaitTime(producer_time, consumer_time, buffer_size,
                                   /*producer_time_derivative=*/nullptr,
                                   /*consumer_time_derivative=*/nullptr,
                                   /*buffer_size_derivative=*/nullptr);
@@ -695,6 +770,17 @@ class AsyncInterleaveMany : public Node {
   }
 
   double MaximumBufferedBytes() const TF_SHARED_LOCKS_REQUIRED(mu_) {
+    // If the number of results buffered per input is tuned, every current
+    // and prefetched input may buffer that many results.
+    auto* buffer_output_elements =
+        gtl::FindOrNull(parameters_, kBufferOutputElements);
+    auto* cycle_length = gtl::FindOrNull(parameters_, kCycleLength);
+    auto* prefetch_input_elements =
+        gtl::FindOrNull(parameters_, kPrefetchInputElements);
+    if (buffer_output_elements && cycle_length && prefetch_input_elements) {
+      return ((*cycle_length)->value + (*prefetch_input_elements)->value) *
+             (*buffer_output_elements)->value * AverageBufferedElementSize();
+    }
     auto* parameter = gtl::FindOrNull(parameters_, kMaxBufferedElements);
     if (parameter == nullptr) {
       parameter = gtl::FindOrNull(parameters_, kParallelism);
@@ -2165,6 +2251,79 @@ void Model::FlushMetrics() {
   }
 }
 
+ModelBudgetManager* ModelBudgetManager::Global() {
+  static ModelBudgetManager* manager = new ModelBudgetManager();
+  return manager;
+}
+
+void ModelBudgetManager::Register(const Model* model) {
+  mutex_lock l(mu_);
+  demands_.emplace(model, Demand());
+}
+
+void ModelBudgetManager::Unregister(const Model* model) {
+  mutex_lock l(mu_);
+  demands_.erase(model);
+}
+
+ModelBudgetManager::Budget ModelBudgetManager::UpdateDemand(
+    const Model* model, const Demand& demand, int64_t cpu_budget,
+    int64_t ram_budget) {
+  mutex_lock l(mu_);
+  demands_[model] = demand;
+  const int64_t num_models = demands_.size();
+  if (num_models == 1) {
+    return {cpu_budget, ram_budget};
+  }
+  std::vector<int64_t> cpu_demands, ram_demands;
+  std::vector<double> weights;
+  int index = 0;
+  for (const auto& it : demands_) {
+    if (it.first == model) index = weights.size();
+    cpu_demands.push_back(it.second.cpu);
+    ram_demands.push_back(it.second.ram_bytes);
+    weights.push_back(std::max(it.second.benefit, 1e-9));
+  }
+  Budget budget;
+  budget.cpu = DivideBudget(cpu_demands, weights, cpu_budget,
+                            /*min_share=*/1)[index];
+  budget.ram_bytes = DivideBudget(ram_demands, weights, ram_budget,
+                                  /*min_share=*/0)[index];
+  VLOG(2) << "Budget share of model " << model << " among " << num_models
+          << " models: " << budget.cpu << " CPUs, " << budget.ram_bytes
+          << " bytes of RAM.";
+  return budget;
+}
+
+int ModelBudgetManager::num_models() const {
+  mutex_lock l(mu_);
+  return demands_.size();
+}
+
+ModelBudgetManager::Demand Model::GetBudgetDemand() {
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock l(mu_);
+    snapshot = output_->Snapshot();
+  }
+  ModelBudgetManager::Demand demand;
+  double parallelism = 0;
+  for (const auto& pair : CollectTunableParameters(snapshot)) {
+    if (pair.second->name == kParallelism) {
+      parallelism += pair.second->value;
+    }
+  }
+  demand.cpu = static_cast<int64_t>(
+      std::ceil(std::max(parallelism, 1.0) * kBudgetDemandGrowthFactor));
+  demand.ram_bytes = static_cast<int64_t>(TotalMaximumBufferedBytes(snapshot) *
+                                          kBudgetDemandGrowthFactor);
+  // The output time of a pipeline is the time its consumer waits for, so the
+  // slowest pipelines benefit the most from resources.
+  demand.benefit = OutputTime(snapshot, /*model_input_time=*/0.0,
+                              /*gradients=*/nullptr);
+  return demand;
+}
+
 void Model::Optimize(AutotuneAlgorithm algorithm, int64_t cpu_budget,
                      int64_t ram_budget, double model_input_time,
                      CancellationManager* cancellation_manager) {
@@ -2286,6 +2445,11 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
       },
       /*deregister_fn=*/&unused));
 
+  ModelBudgetManager* budget_manager = ModelBudgetManager::Global();
+  budget_manager->Register(this);
+  auto unregister = gtl::MakeCleanup(
+      [this, budget_manager]() { budget_manager->Unregister(this); });
+
   int64_t last_optimization_ms = 0;
   int64_t current_time_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
   while (true) {
@@ -2313,7 +2477,9 @@ Status Model::OptimizeLoop(AutotuneAlgorithm algorithm, int64_t cpu_budget,
     if (algorithm == AutotuneAlgorithm::STAGE_BASED) {
       model_input_time = ComputeTargetTimeNsec();
     }
-    Optimize(algorithm, cpu_budget, ram_budget, model_input_time,
+    const ModelBudgetManager::Budget budget = budget_manager->UpdateDemand(
+        this, GetBudgetDemand(), cpu_budget, ram_budget);
+    Optimize(algorithm, budget.cpu, budget.ram_bytes, model_input_time,
              cancellation_manager);
     int64_t end_ms = EnvTime::NowMicros() / EnvTime::kMillisToMicros;
     VLOG(2) << "Optimized for " << end_ms - start_ms << " ms.";
@@ -2503,6 +2669,98 @@ double Model::ComputeTargetTimeNsec() {
          1.0e3;
 }
 
+Status Model::ComputeProfile(PipelineProfile* profile) {
+  profile->Clear();
+  profile->set_critical_stage_index(-1);
+  std::shared_ptr<Node> snapshot;
+  {
+    tf_shared_lock l(mu_);
+    if (output_ == nullptr) {
+      return errors::FailedPrecondition("The model has no output node.");
+    }
+    snapshot = output_->Snapshot();
+  }
+  const double target_time_nsec = ComputeTargetTimeNsec();
+  profile->set_target_time_nsec(target_time_nsec);
+
+  ModelTiming model_timing(snapshot);
+  std::shared_ptr<Node> critical_root;
+  double critical_time_nsec = 0.0;
+  for (const auto& root : model_timing.GetStageRoots()) {
+    const ModelTiming::NodeTiming* root_timing =
+        model_timing.GetTiming(root.get());
+    PipelineProfile::Stage* stage = profile->add_stages();
+    stage->set_root_id(root->id());
+    stage->set_root_name(root->name());
+    for (const auto& node : model_timing.GetStageNodes(root)) {
+      stage->add_node_ids(node->id());
+    }
+    // Stages are compared the same way as in stage-based optimization, i.e.
+    // by the time needed to produce the inputs of one pipeline output element.
+    const double time_nsec =
+        root_timing->total_time_nsec * root_timing->pipeline_ratio;
+    stage->set_time_nsec(time_nsec);
+    if (target_time_nsec > 0.0) {
+      stage->set_utilization(time_nsec / target_time_nsec);
+    }
+    stage->set_buffered_elements(root->buffered_elements());
+    stage->set_buffered_bytes(root->buffered_bytes());
+    auto buffer_size = root->ParameterValue(kBufferSize);
+    if (buffer_size.ok() && buffer_size.ValueOrDie() > 0.0) {
+      stage->set_buffer_occupancy(root->buffered_elements() /
+                                  buffer_size.ValueOrDie());
+    }
+    if (root->num_elements() > 0) {
+      stage->set_average_element_bytes(
+          static_cast<double>(root->bytes_produced()) / root->num_elements());
+    }
+    if (time_nsec > critical_time_nsec) {
+      critical_time_nsec = time_nsec;
+      critical_root = root;
+      profile->set_critical_stage_index(profile->stages_size() - 1);
+    }
+  }
+  if (critical_root == nullptr) {
+    return OkStatus();
+  }
+
+  std::vector<int64_t> path_to_critical_root;
+  for (const Node* node = critical_root->output(); node != nullptr;
+       node = node->output()) {
+    path_to_critical_root.push_back(node->id());
+  }
+  for (auto it = path_to_critical_root.rbegin();
+       it != path_to_critical_root.rend(); ++it) {
+    profile->add_critical_path(*it);
+  }
+  // Within the critical stage, follow the synchronous input that contributes
+  // the most time.
+  const Node* node = critical_root.get();
+  while (node != nullptr) {
+    profile->add_critical_path(node->id());
+    const Node* slowest_input = nullptr;
+    double slowest_time_nsec = 0.0;
+    for (const auto& input : node->inputs()) {
+      if (input->IsAsync() || !input->autotune()) {
+        continue;
+      }
+      const ModelTiming::NodeTiming* input_timing =
+          model_timing.GetTiming(input.get());
+      if (input_timing == nullptr) {
+        continue;
+      }
+      const double input_time_nsec =
+          input_timing->total_time_nsec * input_timing->pipeline_ratio;
+      if (input_time_nsec > slowest_time_nsec) {
+        slowest_time_nsec = input_time_nsec;
+        slowest_input = input.get();
+      }
+    }
+    node = slowest_input;
+  }
+  return OkStatus();
+}
+
 void Model::OptimizeStageBased(std::shared_ptr<Node> snapshot,
                                const OptimizationParams& optimization_params,
                                CancellationManager* cancellation_manager) {
@@ -52,6 +52,8 @@ constexpr char kBufferSize[] = "buffer_size";
 constexpr char kCycleLength[] = "cycle_length";
 constexpr char kDeterministic[] = "deterministic";
 constexpr char kMaxBufferedElements[] = "max_buffered_elements";
+constexpr char kBufferOutputElements[] = "buffer_output_elements";
+constexpr char kPrefetchInputElements[] = "prefetch_input_elements";
 
 // A key used to identify the input time of the model.
 constexpr char kModelInputTimeKey[] = "model_input_time";
@@ -752,6 +754,54 @@ std::shared_ptr<Node> MakeAsyncUnknownRatioNode(
 // as pass-through between inputs and output.
 std::shared_ptr<Node> MakeUnknownNode(Node::Args args);
 
+class Model;
+
+// Divides the process-wide CPU and RAM budgets between the models of the input
+// pipelines that are optimized concurrently, so that together they stay within
+// the budgets that each of them would otherwise use on its own.
+//
+// Before each optimization, a model reports how much of each resource it
+// could use and how much it would benefit from resources. Each budget is
+// divided with weighted max-min fairness: models whose demand is below their
+// share, in proportion to benefit, get their demand, and the rest is divided
+// among the others in proportion to benefit. What is left once all demands
+// are met is divided in proportion to benefit, so that a single model gets the
+// whole budget. Shares are recomputed on every report, and rebalance as
+// pipelines start and stop.
+class ModelBudgetManager {
+ public:
+  struct Demand {
+    // Resources the model could use if it was not constrained.
+    int64_t cpu = 0;
+    int64_t ram_bytes = 0;
+    // Relative benefit of resources to the model.
+    double benefit = 1.0;
+  };
+
+  struct Budget {
+    int64_t cpu = 0;
+    int64_t ram_bytes = 0;
+  };
+
+  // Returns the manager shared by all models of the process.
+  static ModelBudgetManager* Global();
+
+  void Register(const Model* model) TF_LOCKS_EXCLUDED(mu_);
+  void Unregister(const Model* model) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the demand of a registered `model` and returns its share of the
+  // given process-wide budgets.
+  Budget UpdateDemand(const Model* model, const Demand& demand,
+                      int64_t cpu_budget, int64_t ram_budget)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  int num_models() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<const Model*, Demand> demands_ TF_GUARDED_BY(mu_);
+};
+
 // Abstract representation of a TensorFlow input pipeline that can be used
 // for collecting runtime information and optimizing performance. It collects
 // runtime information about execution of the input pipeline that is used to
@@ -796,7 +846,9 @@ class Model {
   std::string DebugString();
 
   // Uses the given algorithm and resource budgets to periodically perform the
-  // autotuning optimization.
+  // autotuning optimization. The budgets are process-wide: the model is
+  // registered with `ModelBudgetManager::Global()` for the duration of the
+  // loop, and each optimization uses the share of the budgets it is given.
   //
   // To terminate the execution of the optimization loop, the caller needs to
   // invoke `cancellation_mgr->StartCancel()`.
@@ -849,6 +901,11 @@ class Model {
   // algorithm.
   double ComputeTargetTimeNsec();
 
+  // Computes a profile of the pipeline from a snapshot of this model, with the
+  // timing, utilization, and buffer statistics of each stage, and the critical
+  // path of the pipeline.
+  Status ComputeProfile(PipelineProfile* profile);
+
  private:
   // Determines whether optimization should stop given total processing time,
   // estimated output time, and estimated number of buffers bytes.
@@ -863,6 +920,10 @@ class Model {
   // a vector which contains pairs of node names and tunable parameters.
   ModelParameters CollectTunableParameters(std::shared_ptr<Node> node);
 
+  // Estimates the resources the current pipeline could use and its benefit
+  // from them, for `ModelBudgetManager`.
+  ModelBudgetManager::Demand GetBudgetDemand();
+
   // Downsizes buffers that are too large for all nodes rooted at `snapshot`.
   // Returns true if any buffer is downsized.
   bool DownsizeBuffers(std::shared_ptr<Node> snapshot);
@@ -34,6 +34,7 @@ namespace {
 
 using ::tensorflow::monitoring::testing::CellReader;
 using ::testing::AllOf;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
 int64_t CountParametersOnNode(const string& node_name,
@@ -804,6 +805,82 @@ TEST(AsyncInterleaveManyGradientTest, Model) {
       (new_output_time - output_time) / kParameterStep, kComparisonPrecision);
 }
 
+TEST(AsyncInterleaveManyBufferOutputElementsTest, Model) {
+  const double input_time = 100;
+  std::shared_ptr<Parameter> parallelism_parameter =
+      model::MakeParameter(kParallelism,
+                           std::make_shared<SharedState>(
+                               /*value=*/model::kAutotune, nullptr, nullptr),
+                           /*min=*/1, /*max=*/2);
+  std::shared_ptr<Parameter> buffer_parameter =
+      model::MakeParameter(kBufferOutputElements,
+                           std::make_shared<SharedState>(
+                               /*value=*/model::kAutotune, nullptr, nullptr),
+                           /*min=*/1, /*max=*/10);
+  std::shared_ptr<Node> async_interleave_many =
+      model::MakeAsyncInterleaveManyNode(
+          {0, "async_interleave_many", nullptr},
+          {parallelism_parameter, buffer_parameter,
+           model::MakeNonTunableParameter(kCycleLength, 2),
+           model::MakeNonTunableParameter(kPrefetchInputElements, 4)});
+  std::shared_ptr<Node> meta_source =
+      model::MakeSourceNode({1, "meta_source", async_interleave_many});
+  async_interleave_many->add_input(meta_source);
+  auto cleanup_meta = gtl::MakeCleanup([async_interleave_many, meta_source]() {
+    async_interleave_many->remove_input(meta_source);
+  });
+  std::shared_ptr<Node> source1 =
+      model::MakeSourceNode({2, "source1", async_interleave_many});
+  async_interleave_many->add_input(source1);
+  auto cleanup1 = gtl::MakeCleanup([async_interleave_many, source1]() {
+    async_interleave_many->remove_input(source1);
+  });
+  std::shared_ptr<Node> source2 =
+      model::MakeSourceNode({3, "source2", async_interleave_many});
+  async_interleave_many->add_input(source2);
+  auto cleanup2 = gtl::MakeCleanup([async_interleave_many, source2]() {
+    async_interleave_many->remove_input(source2);
+  });
+  Model::NodeValues input_times;
+  input_times[kModelInputTimeKey] = input_time;
+  async_interleave_many->record_element();
+  async_interleave_many->add_processing_time(10);
+  source1->record_element();
+  source1->add_processing_time(100);
+  source2->record_element();
+  source2->add_processing_time(300);
+
+  parallelism_parameter->value = 1;
+  buffer_parameter->value = 3;
+
+  // Every current and prefetched input buffers `buffer_output_elements`
+  // results.
+  async_interleave_many->record_buffer_event(110, 10);
+  EXPECT_EQ(async_interleave_many->TotalMaximumBufferedBytes(),
+            (2 + 4) * 3 * 11);
+
+  // Buffering more results per input does not increase the output time.
+  Model::ParameterGradients gradients;
+  double output_time =
+      async_interleave_many->OutputTime(&input_times, &gradients);
+  buffer_parameter->value += kParameterStep;
+  double new_output_time =
+      async_interleave_many->OutputTime(&input_times, nullptr);
+  EXPECT_LE(new_output_time, output_time);
+  EXPECT_NEAR(gradients[std::make_pair(async_interleave_many->long_name(),
+                                       buffer_parameter->name)],
+              (new_output_time - output_time) / kParameterStep,
+              kComparisonPrecision);
+
+  buffer_parameter->value -= kParameterStep;
+  parallelism_parameter->value += kParameterStep;
+  new_output_time = async_interleave_many->OutputTime(&input_times, nullptr);
+  EXPECT_NEAR(gradients[std::make_pair(async_interleave_many->long_name(),
+                                       parallelism_parameter->name)],
+              (new_output_time - output_time) / kParameterStep,
+              kComparisonPrecision);
+}
+
 class AsyncKnownRatioGradientTest : public ::testing::TestWithParam<string> {};
 
 TEST_P(AsyncKnownRatioGradientTest, Model) {
@@ -2521,6 +2598,188 @@ TEST_F(ModelTimingTest, SelfTime) {
   EXPECT_DOUBLE_EQ(910, node_2->ComputeSelfTime());
 }
 
+TEST_F(ModelTimingTest, ComputeProfile) {
+  BuildModelFromProto(R"pb(
+    nodes: {
+      key: 1
+      value: {
+        id: 1
+        name: "ParallelMapV2"
+        autotune: true
+        buffered_bytes: 300
+        buffered_elements: 3
+        num_elements: 100
+        processing_time: 25000
+        bytes_produced: 10000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 2
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+        parameters: {
+          name: "buffer_size"
+          value: 4
+          min: 1
+          max: 16
+          tunable: false
+        }
+      }
+    }
+    nodes: {
+      key: 2
+      value: {
+        id: 2
+        name: "ParallelMapV2"
+        autotune: true
+        num_elements: 100
+        processing_time: 20000
+        bytes_produced: 20000
+        node_class: ASYNC_KNOWN_RATIO
+        ratio: 1
+        inputs: 3
+        parameters: {
+          name: "parallelism"
+          value: 4
+          min: 1
+          max: 16
+          tunable: true
+        }
+      }
+    }
+    nodes: {
+      key: 3
+      value: {
+        id: 3
+        name: "SSTable"
+        autotune: true
+        num_elements: 100
+        processing_time: 2000
+        node_class: KNOWN_RATIO
+        ratio: 2
+      }
+    }
+    output: 1
+  )pb");
+  for (int i = 0; i < 5; ++i) {
+    model_->RecordIteratorGapTime(1);
+  }
+
+  PipelineProfile profile;
+  TF_ASSERT_OK(model_->ComputeProfile(&profile));
+  EXPECT_DOUBLE_EQ(1000, profile.target_time_nsec());
+  ASSERT_EQ(2, profile.stages_size());
+
+  const PipelineProfile::Stage& first_stage = profile.stages(0);
+  EXPECT_EQ(1, first_stage.root_id());
+  EXPECT_EQ("ParallelMapV2", first_stage.root_name());
+  EXPECT_THAT(first_stage.node_ids(), ElementsAre(1));
+  EXPECT_DOUBLE_EQ(62.5, first_stage.time_nsec());
+  EXPECT_DOUBLE_EQ(0.0625, first_stage.utilization());
+  EXPECT_EQ(3, first_stage.buffered_elements());
+  EXPECT_EQ(300, first_stage.buffered_bytes());
+  EXPECT_DOUBLE_EQ(0.75, first_stage.buffer_occupancy());
+  EXPECT_DOUBLE_EQ(100, first_stage.average_element_bytes());
+
+  const PipelineProfile::Stage& second_stage = profile.stages(1);
+  EXPECT_EQ(2, second_stage.root_id());
+  EXPECT_THAT(second_stage.node_ids(), ElementsAre(2, 3));
+  EXPECT_DOUBLE_EQ(70, second_stage.time_nsec());
+  EXPECT_DOUBLE_EQ(0.07, second_stage.utilization());
+  EXPECT_DOUBLE_EQ(0, second_stage.buffer_occupancy());
+  EXPECT_DOUBLE_EQ(200, second_stage.average_element_bytes());
+
+  EXPECT_EQ(1, profile.critical_stage_index());
+  EXPECT_THAT(profile.critical_path(), ElementsAre(1, 2, 3));
+}
+
+TEST(ModelTest, ComputeProfileWithoutNodes) {
+  Model model;
+  PipelineProfile profile;
+  EXPECT_EQ(error::FAILED_PRECONDITION, model.ComputeProfile(&profile).code());
+}
+
+TEST(ModelBudgetManagerTest, SingleModelGetsWholeBudget) {
+  ModelBudgetManager manager;
+  Model model;
+  manager.Register(&model);
+  ModelBudgetManager::Budget budget = manager.UpdateDemand(
+      &model, {/*cpu=*/2, /*ram_bytes=*/100, /*benefit=*/1.0},
+      /*cpu_budget=*/8, /*ram_budget=*/1000);
+  EXPECT_EQ(budget.cpu, 8);
+  EXPECT_EQ(budget.ram_bytes, 1000);
+  manager.Unregister(&model);
+  EXPECT_EQ(manager.num_models(), 0);
+}
+
+TEST(ModelBudgetManagerTest, DividesBudgetByBenefit) {
+  ModelBudgetManager manager;
+  Model model_1, model_2;
+  manager.Register(&model_1);
+  manager.Register(&model_2);
+  manager.UpdateDemand(&model_1,
+                       {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/3.0},
+                       /*cpu_budget=*/8, /*ram_budget=*/1000);
+  ModelBudgetManager::Budget budget_2 = manager.UpdateDemand(
+      &model_2, {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/1.0},
+      /*cpu_budget=*/8, /*ram_budget=*/1000);
+  EXPECT_EQ(budget_2.cpu, 2);
+  EXPECT_EQ(budget_2.ram_bytes, 250);
+  ModelBudgetManager::Budget budget_1 = manager.UpdateDemand(
+      &model_1, {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/3.0},
+      /*cpu_budget=*/8, /*ram_budget=*/1000);
+  EXPECT_EQ(budget_1.cpu, 6);
+  EXPECT_EQ(budget_1.ram_bytes, 750);
+}
+
+TEST(ModelBudgetManagerTest, RedistributesUnusedShares) {
+  ModelBudgetManager manager;
+  Model model_1, model_2, model_3;
+  manager.Register(&model_1);
+  manager.Register(&model_2);
+  manager.Register(&model_3);
+  // `model_1` needs less than its fair share, so the other models divide the
+  // rest.
+  manager.UpdateDemand(&model_1,
+                       {/*cpu=*/1, /*ram_bytes=*/100, /*benefit=*/1.0},
+                       /*cpu_budget=*/9, /*ram_budget=*/900);
+  manager.UpdateDemand(&model_2,
+                       {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/1.0},
+                       /*cpu_budget=*/9, /*ram_budget=*/900);
+  ModelBudgetManager::Budget budget = manager.UpdateDemand(
+      &model_3, {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/1.0},
+      /*cpu_budget=*/9, /*ram_budget=*/900);
+  EXPECT_EQ(budget.cpu, 4);
+  EXPECT_EQ(budget.ram_bytes, 400);
+
+  // Once `model_2` stops, `model_3` gets everything `model_1` does not need.
+  manager.Unregister(&model_2);
+  budget = manager.UpdateDemand(
+      &model_3, {/*cpu=*/100, /*ram_bytes=*/10000, /*benefit=*/1.0},
+      /*cpu_budget=*/9, /*ram_budget=*/900);
+  EXPECT_EQ(budget.cpu, 8);
+  EXPECT_EQ(budget.ram_bytes, 800);
+}
+
+TEST(ModelBudgetManagerTest, DividesLeftoverBudget) {
+  ModelBudgetManager manager;
+  Model model_1, model_2;
+  manager.Register(&model_1);
+  manager.Register(&model_2);
+  manager.UpdateDemand(&model_1,
+                       {/*cpu=*/1, /*ram_bytes=*/100, /*benefit=*/1.0},
+                       /*cpu_budget=*/10, /*ram_budget=*/1000);
+  ModelBudgetManager::Budget budget = manager.UpdateDemand(
+      &model_2, {/*cpu=*/1, /*ram_bytes=*/100, /*benefit=*/1.0},
+      /*cpu_budget=*/10, /*ram_budget=*/1000);
+  EXPECT_EQ(budget.cpu, 5);
+  EXPECT_EQ(budget.ram_bytes, 500);
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace data
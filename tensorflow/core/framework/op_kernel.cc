@@ -750,7 +750,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor_with_allocator(get_allocator(attr), type, shape,
+                                        out_tensor, allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor_with_allocator(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   Tensor new_tensor(
       a, type, shape,
       AllocationAttributes(
@@ -809,7 +815,17 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
       op_kernel().name_view().data(), step_id(), "output", type,
       [&shape]() { return shape.DebugString(); });
   auto output_tensor = MakeUnique<Tensor>();
-  Status s = allocate_tensor(type, shape, output_tensor.get(), attr);
+  Allocator* output_allocator = nullptr;
+  if (TF_PREDICT_FALSE(params_->output_allocator_array != nullptr) &&
+      attr.value == output_alloc_attr(index).value && attr.scope_id == 0 &&
+      !track_allocations()) {
+    output_allocator = params_->output_allocator_array[index];
+  }
+  Status s = output_allocator != nullptr
+                 ? allocate_tensor_with_allocator(output_allocator, type, shape,
+                                                  output_tensor.get(),
+                                                  AllocationAttributes())
+                 : allocate_tensor(type, shape, output_tensor.get(), attr);
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor.release());
     *output = outputs_[index].tensor;
@@ -609,6 +609,12 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not null, array indexed by output number for this node of the
+    // allocators that `allocate_output()` uses instead of the device allocator
+    // when called with the output's default attributes. Null entries select
+    // the device allocator. Used by executors that preplan output buffers.
+    Allocator* const* output_allocator_array = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -1245,6 +1251,10 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  Status allocate_tensor_with_allocator(
+      Allocator* a, DataType type, const TensorShape& shape,
+      Tensor* out_tensor, const AllocationAttributes& allocation_attr);
+
   // Helpers for `set_output()`.
 
   // Returns `true` if the tensor was copied into an allocated output.
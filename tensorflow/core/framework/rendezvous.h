@@ -52,6 +52,10 @@ class RendezvousInterface {
     DeviceContext* device_context = nullptr;
     AllocatorAttributes alloc_attrs;
     CancellationManager* cancellation_manager = nullptr;  // not owned.
+    // If non-negative, a slot assigned to this key at graph partition time,
+    // through which a Send and a Recv in the same process may meet without
+    // taking the rendezvous lock. See LocalRendezvous.
+    int64_t rendezvous_slot = -1;
   };
 
   // Parses the key constructed by CreateKey and parse src/dst device
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -394,6 +395,122 @@ TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
       errors::IsAborted(rendez_->Recv(KeyFoo(), args, &val, &val_dead)));
 }
 
+TEST_F(LocalRendezvousTest, SlotSendRecv) {
+  Rendezvous::Args args;
+  args.rendezvous_slot = 1234;
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("hello"), false));
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), args, &val, &is_dead));
+  EXPECT_EQ("hello", V(val));
+}
+
+TEST_F(LocalRendezvousTest, SlotRecvSend) {
+  SchedClosure([this]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    Rendezvous::Args args;
+    args.rendezvous_slot = 0;
+    TF_CHECK_OK(rendez_->Send(KeyFoo(), args, V("hello"), false));
+  });
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  Rendezvous::Args args;
+  args.rendezvous_slot = 0;
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), args, &val, &is_dead));
+  EXPECT_EQ("hello", V(val));
+}
+
+TEST_F(LocalRendezvousTest, SlotFallsBackToTable) {
+  // Two keys that share a slot, and a key that is sent twice.
+  Rendezvous::Args args;
+  args.rendezvous_slot = 7;
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("foo0"), false));
+  TF_ASSERT_OK(rendez_->Send(KeyBar(), args, V("bar"), false));
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("foo1"), false));
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  TF_ASSERT_OK(rendez_->Recv(KeyBar(), args, &val, &is_dead));
+  EXPECT_EQ("bar", V(val));
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), args, &val, &is_dead));
+  EXPECT_EQ("foo0", V(val));
+  // A Recv without a slot only sees the table.
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), Rendezvous::Args(), &val, &is_dead));
+  EXPECT_EQ("foo1", V(val));
+  // Slots beyond the supported range use the table.
+  args.rendezvous_slot = int64_t{1} << 40;
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("far"), false));
+  TF_ASSERT_OK(rendez_->Recv(KeyFoo(), Rendezvous::Args(), &val, &is_dead));
+  EXPECT_EQ("far", V(val));
+}
+
+TEST_F(LocalRendezvousTest, SlotCancelAfterRecv) {
+  auto* cm = new CancellationManager();
+  Notification n;
+  SchedClosure([cm, &n]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    cm->StartCancel();
+    n.Notify();
+  });
+  Tensor val(DT_STRING);
+  bool is_dead = false;
+  Rendezvous::Args args;
+  args.cancellation_manager = cm;
+  args.rendezvous_slot = 3;
+  auto s = rendez_->Recv(KeyFoo(), args, &val, &is_dead);
+  EXPECT_TRUE(errors::IsCancelled(s));
+  EXPECT_EQ("RecvAsync is cancelled.", s.error_message());
+  n.WaitForNotification();
+  delete cm;
+  // A later Send of the same key goes to the table.
+  args.cancellation_manager = nullptr;
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("hello"), false));
+}
+
+TEST_F(LocalRendezvousTest, SlotRecvAbort) {
+  rendez_->Ref();
+  SchedClosure([this]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    rendez_->StartAbort(errors::Aborted(""));
+    rendez_->Unref();
+  });
+  CancellationManager cm;
+  Tensor val(DT_STRING);
+  bool val_dead = false;
+  Rendezvous::Args args;
+  args.cancellation_manager = &cm;
+  args.rendezvous_slot = 5;
+  Status status = rendez_->Recv(KeyFoo(), args, &val, &val_dead);
+  EXPECT_TRUE(errors::IsAborted(status));
+  EXPECT_TRUE(errors::IsAborted(rendez_->Send(KeyFoo(), args, val, false)));
+}
+
+TEST_F(LocalRendezvousTest, SlotRandomSendRecv) {
+  // Each key uses its own slot, and is sent and received from different
+  // threads in random order.
+  static const int N = 1000;
+  BlockingCounter counter(N);
+  for (int i = 0; i < N; ++i) {
+    Rendezvous::Args args;
+    args.rendezvous_slot = i;
+    SchedClosure([this, args, i]() {
+      TF_CHECK_OK(rendez_->Send(MakeKey(strings::StrCat(i)), args,
+                                V(strings::StrCat(i)), false));
+    });
+    SchedClosure([this, args, i, &counter]() {
+      rendez_->RecvAsync(
+          MakeKey(strings::StrCat(i)), args,
+          [i, &counter](const Status& s, const Rendezvous::Args& send_args,
+                        const Rendezvous::Args& recv_args, const Tensor& val,
+                        bool is_dead) {
+            TF_CHECK_OK(s);
+            CHECK_EQ(strings::StrCat(i), V(val));
+            counter.DecrementCount();
+          });
+    });
+  }
+  counter.Wait();
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
@@ -17,9 +17,98 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+int64_t DefaultSnapshotMaxStaleness() {
+  static const int64_t max_staleness = [] {
+    int64_t value;
+    Status status = ReadInt64FromEnvVar(
+        "TF_RESOURCE_VARIABLE_SNAPSHOT_MAX_STALENESS", -1, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return int64_t{-1};
+    }
+    return value;
+  }();
+  return max_staleness;
+}
+
+bool DefaultTrackDirtyRows() {
+  static const bool track_dirty_rows = [] {
+    bool value;
+    Status status = ReadBoolFromEnvVar("TF_RESOURCE_VARIABLE_TRACK_DIRTY_ROWS",
+                                       false, &value);
+    if (!status.ok()) {
+      LOG(ERROR) << status;
+      return false;
+    }
+    return value;
+  }();
+  return track_dirty_rows;
+}
+
+template <typename Index>
+void MarkRows(const Tensor& indices, std::vector<bool>* rows) {
+  const auto indices_flat = indices.flat<Index>();
+  const int64_t num_rows = rows->size();
+  for (int64_t i = 0; i < indices_flat.size(); ++i) {
+    const int64_t row = indices_flat(i);
+    if (row >= 0 && row < num_rows) (*rows)[row] = true;
+  }
+}
+
+}  // namespace
+
+Var::Var(DataType dtype)
+    : tensor_(dtype),
+      snapshot_max_staleness_(DefaultSnapshotMaxStaleness()),
+      track_dirty_rows_(DefaultTrackDirtyRows()) {}
+
+void Var::MarkRowsDirty(const Tensor& indices) {
+  if (!track_dirty_rows_) return;
+  mutex_lock l(dirty_rows_mu_);
+  if (dirty_rows_base_.empty()) return;
+  if (indices.dtype() == DT_INT32) {
+    MarkRows<int32>(indices, &dirty_rows_);
+  } else if (indices.dtype() == DT_INT64) {
+    MarkRows<int64_t>(indices, &dirty_rows_);
+  } else {
+    dirty_rows_base_.clear();
+  }
+}
+
+void Var::MarkAllRowsDirty() {
+  if (!track_dirty_rows_) return;
+  mutex_lock l(dirty_rows_mu_);
+  dirty_rows_base_.clear();
+}
+
+bool Var::TakeDirtyRows(const std::string& base_prefix,
+                        const std::string& prefix,
+                        std::vector<int64_t>* rows) {
+  rows->clear();
+  mutex_lock l(dirty_rows_mu_);
+  const int64_t num_rows = tensor_.dims() > 0 ? tensor_.dim_size(0) : 0;
+  const bool known = track_dirty_rows_ && !dirty_rows_base_.empty() &&
+                     dirty_rows_base_ == base_prefix &&
+                     static_cast<int64_t>(dirty_rows_.size()) == num_rows;
+  if (known) {
+    for (int64_t row = 0; row < num_rows; ++row) {
+      if (dirty_rows_[row]) rows->push_back(row);
+    }
+  }
+  if (track_dirty_rows_ && tensor_.dims() > 0) {
+    dirty_rows_base_ = prefix;
+    dirty_rows_.assign(num_rows, false);
+  }
+  return known;
+}
+
 Status Var::AsGraphDef(GraphDefBuilder* builder, Node** out) const {
   Node* var = ops::SourceOp(
       "VarHandleOp",
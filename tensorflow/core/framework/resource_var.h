@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 #define TENSORFLOW_CORE_FRAMEWORK_RESOURCE_VAR_H_
 
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/framework/resource_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -63,9 +66,37 @@ namespace tensorflow {
 // mutex as desired. To access the variable in dense mode grab the mutex either
 // directly or via `MaybeLockVariableInputMutexesInOrder` on all variables being
 // modified and then call `PrepareToUpdateVariable` on them in any order.
+//
+// Variables can also operate in snapshot mode, an RCU-style variant of
+// copy-on-write mode meant for parameter servers with many asynchronous
+// readers. Writers publish the variable's tensor as an immutable snapshot,
+// under the exclusive lock, through `PublishSnapshot()` or
+// `MaybePublishSnapshot()`. Readers alias the last published snapshot with
+// `ReadSnapshot()` without acquiring `mu()`, so they never wait for writers.
+// Since a snapshot aliases the tensor, the next write copies it as in
+// copy-on-write mode, and never modifies a published buffer. To bound the cost
+// of these copies, `MaybePublishSnapshot()` only publishes once more than
+// `max_staleness` updates were made since the last snapshot, so readers may
+// miss up to `max_staleness` of the latest updates. Sparse operations do not
+// switch variables in snapshot mode to copy-on-read mode: sparse writes acquire
+// the exclusive lock and copy the tensor if it is aliased. If a variable is
+// switched to copy-on-read mode anyway, snapshots are no longer published and
+// readers fall back to locking the variable.
+//
+// Snapshot mode is enabled for all the variables created by the process when
+// the TF_RESOURCE_VARIABLE_SNAPSHOT_MAX_STALENESS environment variable is set
+// to a non-negative value, or with `EnableSnapshots()`.
+//
+// Variables can also track the rows updated since their last checkpoint, so
+// that delta checkpoints only write these rows. Sparse updates (the resource
+// scatter ops and the sparse training ops) record their indices with
+// `MarkRowsDirty()` and dense updates call `MarkAllRowsDirty()`. Tracking is
+// enabled for all the variables created by the process when the
+// TF_RESOURCE_VARIABLE_TRACK_DIRTY_ROWS environment variable is true, or with
+// `EnableDirtyRowTracking()`.
 class Var : public ResourceBase {
  public:
-  explicit Var(DataType dtype) : tensor_(dtype) {}
+  explicit Var(DataType dtype);
 
   // When locking multiple variables, the locks must be acquired in order of
   // increasing mu() address.
@@ -79,8 +110,76 @@ class Var : public ResourceBase {
     // move frees the buffer of the tensor after unused goes out of scope.
     Tensor unused = std::move(tensor_);
     is_initialized = false;
+    ClearSnapshot();
+    MarkAllRowsDirty();
+  }
+
+  // Enables snapshot mode, where readers may miss up to `max_staleness`
+  // updates. Must be called before the variable is shared.
+  void EnableSnapshots(int64_t max_staleness) {
+    DCHECK_GE(max_staleness, 0);
+    snapshot_max_staleness_ = max_staleness;
+  }
+  bool snapshot_mode() const { return snapshot_max_staleness_ >= 0; }
+
+  // Sets `*out` to the last published snapshot and returns true, or returns
+  // false if the variable is not in snapshot mode or no snapshot was published
+  // yet. Does not acquire `mu()`.
+  bool ReadSnapshot(Tensor* out) const {
+    if (!snapshot_mode() || copy_on_read_mode.load()) return false;
+    mutex_lock l(snapshot_mu_);
+    if (!has_snapshot_) return false;
+    *out = snapshot_;
+    return true;
+  }
+
+  // Publishes the current value of the variable as a snapshot.
+  // REQUIRES: `mu()` is held exclusively.
+  void PublishSnapshot() {
+    if (!snapshot_mode()) return;
+    if (copy_on_read_mode.load()) {
+      // No tensor may alias the variable in copy-on-read mode.
+      ClearSnapshot();
+      return;
+    }
+    num_unpublished_updates_ = 0;
+    mutex_lock l(snapshot_mu_);
+    snapshot_ = tensor_;
+    has_snapshot_ = is_initialized;
   }
 
+  // Records an update of the variable, and publishes a snapshot if more than
+  // `max_staleness` updates were not published.
+  // REQUIRES: `mu()` is held exclusively.
+  void MaybePublishSnapshot() {
+    if (!snapshot_mode()) return;
+    if (++num_unpublished_updates_ > snapshot_max_staleness_) {
+      PublishSnapshot();
+    }
+  }
+
+  // Enables tracking of the rows updated since the last checkpoint. Must be
+  // called before the variable is shared.
+  void EnableDirtyRowTracking() { track_dirty_rows_ = true; }
+  bool tracks_dirty_rows() const { return track_dirty_rows_; }
+
+  // Records an update of the rows of the variable listed in `indices`, an
+  // int32 or int64 tensor. Indices that are out of range are ignored.
+  // REQUIRES: `mu()` is held, in shared or exclusive mode.
+  void MarkRowsDirty(const Tensor& indices);
+
+  // Records an update of the whole variable.
+  void MarkAllRowsDirty();
+
+  // Starts tracking the rows updated after the variable is saved to the
+  // checkpoint at `prefix`. If the checkpoint at `base_prefix` was the last
+  // one started for the variable, and only tracked sparse updates were made
+  // since, sets `*rows` to the sorted rows updated since and returns true.
+  // Otherwise returns false, and the variable must be saved in full.
+  // REQUIRES: `mu()` is held exclusively.
+  bool TakeDirtyRows(const std::string& base_prefix, const std::string& prefix,
+                     std::vector<int64_t>* rows);
+
   Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override;
 
   std::string DebugString() const override {
@@ -104,9 +203,33 @@ class Var : public ResourceBase {
   std::atomic<bool> copy_on_read_mode{false};
 
  private:
+  void ClearSnapshot() {
+    num_unpublished_updates_ = 0;
+    mutex_lock l(snapshot_mu_);
+    snapshot_ = Tensor();
+    has_snapshot_ = false;
+  }
+
   mutex mu_;
   Tensor tensor_;
 
+  // Snapshot mode is disabled when negative.
+  int64_t snapshot_max_staleness_;
+  // Fake-guarded by mu_.
+  int64_t num_unpublished_updates_ = 0;
+  // Only held to copy the snapshot, never while acquiring mu_.
+  mutable mutex snapshot_mu_;
+  Tensor snapshot_ TF_GUARDED_BY(snapshot_mu_);
+  bool has_snapshot_ TF_GUARDED_BY(snapshot_mu_) = false;
+
+  bool track_dirty_rows_;
+  // Only held to update the dirty rows, never while acquiring mu_.
+  mutable mutex dirty_rows_mu_;
+  // Prefix of the last checkpoint, or empty if the rows updated since are
+  // unknown.
+  std::string dirty_rows_base_ TF_GUARDED_BY(dirty_rows_mu_);
+  std::vector<bool> dirty_rows_ TF_GUARDED_BY(dirty_rows_mu_);
+
   ~Var() override {}
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
 };
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/framework/resource_var.h"
 
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -34,5 +37,113 @@ TEST(ResourceVarTest, Uninitialize) {
   EXPECT_FALSE(var->is_initialized);
   EXPECT_TRUE(var->tensor()->data() == nullptr);
 }
+
+TEST(ResourceVarTest, SnapshotsDisabledByDefault) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  EXPECT_FALSE(var->snapshot_mode());
+  *(var->tensor()) = Tensor(1);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+  Tensor snapshot;
+  EXPECT_FALSE(var->ReadSnapshot(&snapshot));
+}
+
+TEST(ResourceVarTest, ReadSnapshot) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  var->EnableSnapshots(/*max_staleness=*/0);
+  Tensor snapshot;
+  EXPECT_FALSE(var->ReadSnapshot(&snapshot));
+
+  mutex_lock l(*var->mu());
+  *(var->tensor()) = Tensor(1);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+  ASSERT_TRUE(var->ReadSnapshot(&snapshot));
+  EXPECT_EQ(snapshot.scalar<int32>()(), 1);
+  // The snapshot aliases the variable, so writers must copy it.
+  EXPECT_FALSE(var->tensor()->RefCountIsOne());
+
+  // A writer replaces the tensor and publishes it.
+  *(var->tensor()) = Tensor(2);
+  var->MaybePublishSnapshot();
+  Tensor new_snapshot;
+  ASSERT_TRUE(var->ReadSnapshot(&new_snapshot));
+  EXPECT_EQ(new_snapshot.scalar<int32>()(), 2);
+  EXPECT_EQ(snapshot.scalar<int32>()(), 1);
+
+  var->Uninitialize();
+  EXPECT_FALSE(var->ReadSnapshot(&snapshot));
+}
+
+TEST(ResourceVarTest, SnapshotStaleness) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  var->EnableSnapshots(/*max_staleness=*/2);
+  mutex_lock l(*var->mu());
+  *(var->tensor()) = Tensor(0);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+
+  Tensor snapshot;
+  for (int i = 1; i <= 3; ++i) {
+    *(var->tensor()) = Tensor(i);
+    var->MaybePublishSnapshot();
+    ASSERT_TRUE(var->ReadSnapshot(&snapshot));
+    // Only every third update is published.
+    EXPECT_EQ(snapshot.scalar<int32>()(), i < 3 ? 0 : 3);
+  }
+}
+
+TEST(ResourceVarTest, CopyOnReadModeDisablesSnapshots) {
+  RefCountPtr<Var> var{new Var(DT_INT32)};
+  var->EnableSnapshots(/*max_staleness=*/0);
+  mutex_lock l(*var->mu());
+  *(var->tensor()) = Tensor(1);
+  var->is_initialized = true;
+  var->PublishSnapshot();
+  var->copy_on_read_mode.store(true);
+  Tensor snapshot;
+  EXPECT_FALSE(var->ReadSnapshot(&snapshot));
+  var->PublishSnapshot();
+  EXPECT_FALSE(var->ReadSnapshot(&snapshot));
+}
+
+TEST(ResourceVarTest, DirtyRows) {
+  RefCountPtr<Var> var{new Var(DT_FLOAT)};
+  var->EnableDirtyRowTracking();
+  mutex_lock l(*var->mu());
+  *(var->tensor()) = Tensor(DT_FLOAT, TensorShape({10, 2}));
+  var->is_initialized = true;
+
+  // The rows updated before the first checkpoint are unknown.
+  std::vector<int64_t> rows;
+  EXPECT_FALSE(var->TakeDirtyRows("", "ckpt-1", &rows));
+
+  var->MarkRowsDirty(test::AsTensor<int32>({7, 2, 7}));
+  var->MarkRowsDirty(test::AsTensor<int64_t>({4, -1, 10}));
+  ASSERT_TRUE(var->TakeDirtyRows("ckpt-1", "ckpt-2", &rows));
+  EXPECT_EQ(rows, std::vector<int64_t>({2, 4, 7}));
+  ASSERT_TRUE(var->TakeDirtyRows("ckpt-2", "ckpt-3", &rows));
+  EXPECT_TRUE(rows.empty());
+
+  // Deltas are only known relative to the last checkpoint.
+  var->MarkRowsDirty(test::AsTensor<int32>({1}));
+  EXPECT_FALSE(var->TakeDirtyRows("ckpt-2", "ckpt-4", &rows));
+
+  var->MarkRowsDirty(test::AsTensor<int32>({1}));
+  var->MarkAllRowsDirty();
+  EXPECT_FALSE(var->TakeDirtyRows("ckpt-4", "ckpt-5", &rows));
+  ASSERT_TRUE(var->TakeDirtyRows("ckpt-5", "ckpt-6", &rows));
+  EXPECT_TRUE(rows.empty());
+}
+
+TEST(ResourceVarTest, DirtyRowsNotTrackedByDefault) {
+  RefCountPtr<Var> var{new Var(DT_FLOAT)};
+  EXPECT_FALSE(var->tracks_dirty_rows());
+  mutex_lock l(*var->mu());
+  *(var->tensor()) = Tensor(DT_FLOAT, TensorShape({10, 2}));
+  std::vector<int64_t> rows;
+  EXPECT_FALSE(var->TakeDirtyRows("", "ckpt-1", &rows));
+  EXPECT_FALSE(var->TakeDirtyRows("ckpt-1", "ckpt-2", &rows));
+}
 }  // namespace core
 }  // namespace tensorflow
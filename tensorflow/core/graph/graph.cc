@@ -493,22 +493,27 @@ StatusOr<Node*> Graph::AddNode(NodeDef node_def) {
 }
 
 Node* Graph::AddNode(NodeDef node_def, Status* status) {
+  StatusOr<std::shared_ptr<NodeProperties>> props =
+      CreateNodeProperties(std::move(node_def));
+  if (!props.ok()) {
+    status->Update(props.status());
+    return nullptr;
+  }
+  StatusOr<Node*> node = AddNode(std::move(props).value());
+  status->Update(node.status());
+  return node.ok() ? node.value() : nullptr;
+}
+
+StatusOr<std::shared_ptr<NodeProperties>> Graph::CreateNodeProperties(
+    NodeDef node_def) const {
   const OpRegistrationData* op_reg_data;
-  status->Update(ops_.LookUp(node_def.op(), &op_reg_data));
-  if (!status->ok()) return nullptr;
+  TF_RETURN_IF_ERROR(ops_.LookUp(node_def.op(), &op_reg_data));
 
   DataTypeVector inputs;
   DataTypeVector outputs;
-  status->Update(
-      InOutTypesForNode(node_def, op_reg_data->op_def, &inputs, &outputs));
-  if (!status->ok()) {
-    *status = AttachDef(*status, node_def);
-    return nullptr;
-  }
-
-  Node::NodeClass node_class = op_reg_data->is_function_op
-                                   ? Node::NC_FUNCTION_OP
-                                   : Node::GetNodeClassForOp(node_def.op());
+  Status status =
+      InOutTypesForNode(node_def, op_reg_data->op_def, &inputs, &outputs);
+  if (!status.ok()) return AttachDef(status, node_def);
 
   if (node_def.has_experimental_type()) {
     VLOG(3) << "AddNode: node has type set, skipping type constructor "
@@ -520,21 +525,27 @@ Node* Graph::AddNode(NodeDef node_def, Status* status) {
           full_type::SpecializeType(AttrSlice(node_def), op_reg_data->op_def,
                                     *(node_def.mutable_experimental_type()));
       if (!s.ok()) {
-        *status = errors::InvalidArgument("type error: ", s.ToString());
         VLOG(3) << "AddNode: type inference failed for " << node_def.name()
                 << ": " << s;
-        return nullptr;
+        return errors::InvalidArgument("type error: ", s.ToString());
       }
     } else {
       VLOG(3) << "AddNode: no type constructor for " << node_def.name();
     }
   }
 
-  Node* node = AllocateNode(
-      std::make_shared<NodeProperties>(&op_reg_data->op_def,
-                                       std::move(node_def), inputs, outputs),
-      nullptr, node_class);
-  return node;
+  return std::make_shared<NodeProperties>(&op_reg_data->op_def,
+                                          std::move(node_def), inputs, outputs);
+}
+
+StatusOr<Node*> Graph::AddNode(std::shared_ptr<NodeProperties> props) {
+  const string& op = props->node_def.op();
+  const OpRegistrationData* op_reg_data;
+  TF_RETURN_IF_ERROR(ops_.LookUp(op, &op_reg_data));
+  Node::NodeClass node_class = op_reg_data->is_function_op
+                                   ? Node::NC_FUNCTION_OP
+                                   : Node::GetNodeClassForOp(op);
+  return AllocateNode(std::move(props), nullptr, node_class);
 }
 
 Node* Graph::CopyNode(const Node* node) {
@@ -553,6 +553,15 @@ class Graph {
   // Same as above, but using StatusOr. This method is always preferred.
   StatusOr<Node*> AddNode(NodeDef node_def);
 
+  // Infers the Op and input/output types for `node_def` as AddNode() does,
+  // without adding a node to the graph. Unlike AddNode(), may be called
+  // concurrently, e.g. to prepare the nodes of a large graph in parallel.
+  StatusOr<std::shared_ptr<NodeProperties>> CreateNodeProperties(
+      NodeDef node_def) const;
+
+  // Adds a new node with properties returned by CreateNodeProperties().
+  StatusOr<Node*> AddNode(std::shared_ptr<NodeProperties> props);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 
 #include <deque>
+#include <map>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -1261,4 +1262,47 @@ Status Partition(const PartitionOptions& opts, Graph* g,
   return OkStatus();
 }
 
+void AssignRendezvousSlots(std::unordered_map<string, GraphDef>* partitions) {
+  struct Endpoints {
+    std::vector<NodeDef*> sends;
+    std::vector<NodeDef*> recvs;
+  };
+  // Ordered by key, so that slots are assigned deterministically.
+  std::map<string, Endpoints> endpoints;
+  for (auto& it : *partitions) {
+    for (NodeDef& ndef : *it.second.mutable_node()) {
+      const bool is_send = ndef.op() == "_Send" || ndef.op() == "_HostSend";
+      const bool is_recv = ndef.op() == "_Recv" || ndef.op() == "_HostRecv";
+      if (!is_send && !is_recv) continue;
+      bool client_terminated = false;
+      if (TryGetNodeAttr(ndef, "client_terminated", &client_terminated) &&
+          client_terminated) {
+        // The other end is the client, which does not know about slots.
+        continue;
+      }
+      string send_device, recv_device, tensor_name;
+      int64_t incarnation = PartitionOptions::kIllegalIncarnation;
+      if (!TryGetNodeAttr(ndef, "send_device", &send_device) ||
+          !TryGetNodeAttr(ndef, "recv_device", &recv_device) ||
+          !TryGetNodeAttr(ndef, "tensor_name", &tensor_name) ||
+          !TryGetNodeAttr(ndef, "send_device_incarnation", &incarnation)) {
+        continue;
+      }
+      Endpoints& e = endpoints[strings::StrCat(
+          send_device, ";", incarnation, ";", recv_device, ";", tensor_name)];
+      (is_send ? e.sends : e.recvs).push_back(&ndef);
+    }
+  }
+
+  int64_t next_slot = 0;
+  for (auto& it : endpoints) {
+    Endpoints& e = it.second;
+    if (e.sends.size() != 1 || e.recvs.size() != 1) continue;
+    SetAttrValue(next_slot, &(*e.sends[0]->mutable_attr())["_rendezvous_slot"]);
+    SetAttrValue(next_slot, &(*e.recvs[0]->mutable_attr())["_rendezvous_slot"]);
+    ++next_slot;
+  }
+  VLOG(1) << "Assigned " << next_slot << " rendezvous slots";
+}
+
 }  // namespace tensorflow
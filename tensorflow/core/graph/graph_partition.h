@@ -97,6 +97,13 @@ Status Partition(const PartitionOptions& opts, Graph* input,
 Status AddControlEdges(const PartitionOptions& opts,
                        std::unordered_map<string, GraphDef>* partitions);
 
+// Assigns a distinct "_rendezvous_slot" attr to every Send/Recv pair in
+// `partitions` whose rendezvous key has exactly one sender and one receiver
+// in the partitions, so that they meet through a pre-assigned slot of the
+// local rendezvous instead of its hash table. Must be called with all the
+// partitions that run in the same process and share a rendezvous.
+void AssignRendezvousSlots(std::unordered_map<string, GraphDef>* partitions);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_GRAPH_GRAPH_PARTITION_H_
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <utility>
 
@@ -523,6 +525,53 @@ TEST_F(GraphPartitionTest, SetIncarnation) {
   }
 }
 
+TEST_F(GraphPartitionTest, AssignRendezvousSlots) {
+  auto a1 = FloatInput(in_.WithOpName("A1"));
+  auto a2 = FloatInput(in_.WithOpName("A2"));
+  auto a3 = FloatInput(in_.WithOpName("A3"));
+  auto b1 = Combine(in_.WithOpName("B1"), a1, a2);
+  Combine(in_.WithOpName("B2"), b1, a3);
+
+  Partition(ToGraphDef(), &partitions_);
+  EXPECT_EQ(2, partitions_.size());
+
+  // Duplicate the Send of one edge, so that its key has two senders.
+  const string a = "/job:a/replica:0/task:0/cpu:0";
+  const NodeDef* duplicated_send = nullptr;
+  for (const NodeDef& ndef : partitions_[a].node()) {
+    if (ndef.op() == "_Send") duplicated_send = &ndef;
+  }
+  ASSERT_NE(duplicated_send, nullptr);
+  const string duplicated_tensor =
+      GetNodeAttrString(*duplicated_send, "tensor_name");
+  *partitions_["extra"].add_node() = *duplicated_send;
+
+  AssignRendezvousSlots(&partitions_);
+
+  // tensor_name -> slots of its Send and Recv nodes.
+  std::map<string, std::vector<int64_t>> slots;
+  for (const auto& kv : partitions_) {
+    for (const NodeDef& ndef : kv.second.node()) {
+      if (ndef.op() != "_Send" && ndef.op() != "_Recv") continue;
+      int64_t slot = -1;
+      TryGetNodeAttr(ndef, "_rendezvous_slot", &slot);
+      slots[GetNodeAttrString(ndef, "tensor_name")].push_back(slot);
+    }
+  }
+  ASSERT_EQ(3, slots.size());
+  std::set<int64_t> assigned;
+  for (const auto& kv : slots) {
+    if (kv.first == duplicated_tensor) {
+      EXPECT_EQ(kv.second, std::vector<int64_t>({-1, -1, -1}));
+    } else {
+      ASSERT_EQ(2, kv.second.size());
+      EXPECT_EQ(kv.second[0], kv.second[1]);
+      assigned.insert(kv.second[0]);
+    }
+  }
+  EXPECT_EQ(assigned, std::set<int64_t>({0, 1}));
+}
+
 TEST(TopologicalSortNodesWithTimePriorityTest, NoDependencies) {
   // Create placeholders, shuffle them so the order in the graph is not strictly
   // increasing.
@@ -488,6 +488,59 @@ uint64 NumElementsFromTensorProto(const TensorProto& tensor_proto) {
   return num_elements;
 }
 
+// Makes a node that produces a tensor with the properties `prop`, to stand in
+// for a fanin of the nodes re-inferred by GraphProperties::UpdateStatically().
+// Returns false if such a tensor can't be produced by a Const or Placeholder.
+bool MakeBoundaryNode(const string& name, const OpInfo::TensorProperties& prop,
+                      NodeDef* node) {
+  const DataType dtype = prop.dtype();
+  if (dtype == DT_INVALID || IsRefType(dtype) || dtype == DT_RESOURCE ||
+      dtype == DT_VARIANT) {
+    return false;
+  }
+  node->set_name(name);
+  (*node->mutable_attr())["dtype"].set_type(dtype);
+  if (prop.has_value()) {
+    node->set_op("Const");
+    *(*node->mutable_attr())["value"].mutable_tensor() = prop.value();
+  } else {
+    node->set_op("Placeholder");
+    TensorShapeProto* shape = (*node->mutable_attr())["shape"].mutable_shape();
+    *shape = prop.shape();
+    // Symbolic dimensions are only meaningful within a single inference.
+    for (auto& dim : *shape->mutable_dim()) {
+      if (dim.size() < -1) dim.set_size(-1);
+    }
+  }
+  return true;
+}
+
+// Returns the smallest symbolic dimension in `properties`, or -1 if there are
+// none.
+int64_t MinSymbolicDim(
+    const absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>&
+        properties) {
+  int64_t min_dim = -1;
+  for (const auto& node_properties : properties) {
+    for (const OpInfo::TensorProperties& prop : node_properties.second) {
+      for (const auto& dim : prop.shape().dim()) {
+        min_dim = std::min(min_dim, dim.size());
+      }
+    }
+  }
+  return min_dim;
+}
+
+// Adds `offset` to the symbolic dimensions of `props`.
+void ShiftSymbolicDims(int64_t offset,
+                       std::vector<OpInfo::TensorProperties>* props) {
+  for (OpInfo::TensorProperties& prop : *props) {
+    for (auto& dim : *prop.mutable_shape()->mutable_dim()) {
+      if (dim.size() < -1) dim.set_size(dim.size() + offset);
+    }
+  }
+}
+
 }  // namespace
 
 // Note that tensor_as_shape input should not include kUnknownDimFromConst.
@@ -2516,6 +2569,11 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
                                         bool aggressive_shape_inference,
                                         bool include_input_tensor_values,
                                         bool include_output_tensor_values) {
+  assume_valid_feeds_ = assume_valid_feeds;
+  aggressive_shape_inference_ = aggressive_shape_inference;
+  include_input_tensor_values_ = include_input_tensor_values;
+  include_output_tensor_values_ = include_output_tensor_values;
+
   FunctionLibraryDefinition function_library(OpRegistry::Global(),
                                              item_.graph.library());
   absl::flat_hash_map<string, absl::flat_hash_set<int>> fed_ports;
@@ -2754,6 +2812,171 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   TF_RETURN_IF_ERROR(VerboseShapeInferenceLogging(item_.graph, refiner.get(),
                                                   shape_manager.get()));
 
+  inferred_statically_ = true;
+  return OkStatus();
+}
+
+Status GraphProperties::UpdateStatically(
+    const absl::flat_hash_set<string>& mutated_nodes) {
+  if (!inferred_statically_) {
+    return errors::FailedPrecondition(
+        "UpdateStatically() requires properties inferred by "
+        "InferStatically()");
+  }
+  const auto infer_from_scratch = [this]() {
+    VLOG(2) << "Re-inferring the properties of the whole graph";
+    Clear();
+    incompatible_shape_nodes_.clear();
+    return InferStatically(assume_valid_feeds_, aggressive_shape_inference_,
+                           include_input_tensor_values_,
+                           include_output_tensor_values_);
+  };
+
+  // Drop the properties of the nodes removed from the graph.
+  absl::flat_hash_set<absl::string_view> node_names;
+  bool has_queues = false;
+  for (const NodeDef& node : item_.graph.node()) {
+    node_names.insert(node.name());
+    has_queues |= IsQueue(node);
+  }
+  const auto drop_removed_nodes = [&node_names](auto* properties) {
+    for (auto it = properties->begin(); it != properties->end();) {
+      if (node_names.contains(it->first)) {
+        ++it;
+      } else {
+        properties->erase(it++);
+      }
+    }
+  };
+  drop_removed_nodes(&input_properties_);
+  drop_removed_nodes(&output_properties_);
+  for (auto it = incompatible_shape_nodes_.begin();
+       it != incompatible_shape_nodes_.end();) {
+    if (node_names.contains(*it)) {
+      ++it;
+    } else {
+      it = incompatible_shape_nodes_.erase(it);
+    }
+  }
+
+  // Queues link their enqueue and dequeue nodes outside of the regular
+  // fanout.
+  if (has_queues) return infer_from_scratch();
+
+  // Collect the mutated nodes and their transitive fanout.
+  GraphView graph_view(&item_.graph);
+  absl::flat_hash_set<const NodeDef*> affected;
+  std::vector<const NodeDef*> stack;
+  for (const string& node_name : mutated_nodes) {
+    const NodeDef* node = graph_view.GetNode(node_name);
+    if (node != nullptr && affected.insert(node).second) {
+      stack.push_back(node);
+    }
+  }
+  while (!stack.empty()) {
+    const NodeDef* node = stack.back();
+    stack.pop_back();
+    for (const GraphView::InputPort& fanout :
+         graph_view.GetFanouts(*node, /*include_controlled_nodes=*/false)) {
+      if (affected.insert(fanout.node).second) {
+        stack.push_back(fanout.node);
+      }
+    }
+  }
+  if (affected.empty()) return OkStatus();
+  if (2 * affected.size() > item_.graph.node_size()) {
+    return infer_from_scratch();
+  }
+
+  // Extract the affected nodes, and replace their fanins outside of the
+  // subgraph with nodes producing tensors with the known properties.
+  GrapplerItem subgraph_item;
+  subgraph_item.id = item_.id;
+  *subgraph_item.graph.mutable_versions() = item_.graph.versions();
+  *subgraph_item.graph.mutable_library() = item_.graph.library();
+  absl::flat_hash_map<string, string> boundary_nodes;
+  for (const NodeDef& node : item_.graph.node()) {
+    if (!affected.contains(&node)) continue;
+    NodeDef* subgraph_node = subgraph_item.graph.add_node();
+    *subgraph_node = node;
+    subgraph_node->clear_input();
+    for (const string& input : node.input()) {
+      const TensorId tensor_id = ParseTensorName(input);
+      const NodeDef* fanin = graph_view.GetNode(tensor_id.node());
+      if (fanin == nullptr) return infer_from_scratch();
+      if (affected.contains(fanin)) {
+        subgraph_node->add_input(input);
+        continue;
+      }
+      // Control dependencies don't carry any properties.
+      if (tensor_id.index() < 0) continue;
+
+      const string tensor_name = tensor_id.ToString();
+      auto it = boundary_nodes.find(tensor_name);
+      if (it == boundary_nodes.end()) {
+        const auto fanin_properties = output_properties_.find(fanin->name());
+        if (fanin_properties == output_properties_.end() ||
+            fanin_properties->second.size() <=
+                static_cast<size_t>(tensor_id.index())) {
+          return infer_from_scratch();
+        }
+        const string boundary_name = strings::StrCat(
+            fanin->name(), "/_incremental_input_", tensor_id.index());
+        if (node_names.contains(boundary_name) ||
+            !MakeBoundaryNode(boundary_name,
+                              fanin_properties->second[tensor_id.index()],
+                              subgraph_item.graph.add_node())) {
+          return infer_from_scratch();
+        }
+        it = boundary_nodes.emplace(tensor_name, boundary_name).first;
+      }
+      subgraph_node->add_input(it->second);
+    }
+  }
+  for (const auto& feed : item_.feed) {
+    const NodeDef* node =
+        graph_view.GetNode(ParseTensorName(feed.first).node());
+    if (node != nullptr && affected.contains(node)) {
+      subgraph_item.feed.push_back(feed);
+    }
+  }
+
+  VLOG(2) << "Re-inferring the properties of " << affected.size() << " of "
+          << item_.graph.node_size() << " nodes";
+  GraphProperties subgraph_properties(subgraph_item);
+  TF_RETURN_IF_ERROR(subgraph_properties.InferStatically(
+      assume_valid_feeds_, aggressive_shape_inference_,
+      include_input_tensor_values_, include_output_tensor_values_));
+
+  // Keep the symbolic dimensions of the subgraph distinct from the ones
+  // already known for the rest of the graph.
+  const int64_t offset = std::min(MinSymbolicDim(input_properties_),
+                                  MinSymbolicDim(output_properties_)) +
+                         1;
+  for (const NodeDef* node : affected) {
+    const string& node_name = node->name();
+    input_properties_.erase(node_name);
+    output_properties_.erase(node_name);
+    incompatible_shape_nodes_.erase(node_name);
+
+    auto inputs = subgraph_properties.input_properties_.find(node_name);
+    if (inputs != subgraph_properties.input_properties_.end()) {
+      std::vector<OpInfo::TensorProperties>& props =
+          input_properties_[node_name];
+      props = std::move(inputs->second);
+      ShiftSymbolicDims(offset, &props);
+    }
+    auto outputs = subgraph_properties.output_properties_.find(node_name);
+    if (outputs != subgraph_properties.output_properties_.end()) {
+      std::vector<OpInfo::TensorProperties>& props =
+          output_properties_[node_name];
+      props = std::move(outputs->second);
+      ShiftSymbolicDims(offset, &props);
+    }
+    if (subgraph_properties.CheckShapeIncompatible(node_name)) {
+      incompatible_shape_nodes_.insert(node_name);
+    }
+  }
   return OkStatus();
 }
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -114,6 +115,17 @@ class GraphProperties {
                            /*aggressive_shape_inference=*/false,
                            /*include_tensor_values=*/true);
   }
+  // Updates the properties inferred by a previous call to InferStatically()
+  // after the graph of the item was mutated, with the same options. The nodes
+  // in `mutated_nodes` are the nodes that were added or modified: only them
+  // and their transitive fanout are re-inferred, starting from the properties
+  // already known for their fanins, and the properties of the nodes removed
+  // from the graph are dropped. Symbolic dimensions are not unified across the
+  // boundary of the re-inferred subgraph, so the result may be less precise
+  // than a full inference. Falls back to a full inference when the mutations
+  // affect most of the graph, or when the graph has queues or the fanins of
+  // the re-inferred nodes have no known properties or carry resources.
+  Status UpdateStatically(const absl::flat_hash_set<string>& mutated_nodes);
   // Infer the shape by running the graph on the specified cluster and recording
   // the shapes of the processed tensors.
   Status InferDynamically(Cluster* cluster);
@@ -156,6 +168,7 @@ class GraphProperties {
   void Clear() {
     input_properties_.clear();
     output_properties_.clear();
+    inferred_statically_ = false;
   }
 
  private:
@@ -211,6 +224,14 @@ class GraphProperties {
   // Nodes with output shape incompatible between shape inference and
   // annotation.
   std::unordered_set<string> incompatible_shape_nodes_;
+
+  // Options of the last call to InferStatically(), reused by
+  // UpdateStatically().
+  bool inferred_statically_ = false;
+  bool assume_valid_feeds_ = false;
+  bool aggressive_shape_inference_ = false;
+  bool include_input_tensor_values_ = false;
+  bool include_output_tensor_values_ = false;
 };
 
 // Helper function for GraphProperties.
@@ -233,6 +233,80 @@ TEST_F(GraphPropertiesTest, Clear) {
   EXPECT_FALSE(properties.has_properties());
 }
 
+TEST_F(GraphPropertiesTest, UpdateStatically) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape(TensorShape({2, 3})));
+  Output b = ops::Identity(s.WithOpName("b"), a);
+  Output c = ops::Neg(s.WithOpName("c"), b);
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape(TensorShape({5})));
+  Output y = ops::Identity(s.WithOpName("y"), x);
+  Output z = ops::Neg(s.WithOpName("z"), y);
+  Output w = ops::Sqrt(s.WithOpName("w"), z);
+
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  GraphProperties properties(item);
+  TF_ASSERT_OK(properties.InferStatically(false));
+  EXPECT_EQ("float: [2,3]",
+            PropToString(properties.GetOutputProperties("c").at(0)));
+
+  // Change the shape of `a`, which only affects `b` and `c`.
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "a") {
+      TensorShape({4, 3}).AsProto(
+          (*node.mutable_attr())["shape"].mutable_shape());
+    }
+  }
+  TF_ASSERT_OK(properties.UpdateStatically({"a"}));
+  EXPECT_EQ("float: [4,3]",
+            PropToString(properties.GetOutputProperties("a").at(0)));
+  EXPECT_EQ("float: [4,3]",
+            PropToString(properties.GetInputProperties("c").at(0)));
+  EXPECT_EQ("float: [4,3]",
+            PropToString(properties.GetOutputProperties("c").at(0)));
+  EXPECT_EQ("float: [5]",
+            PropToString(properties.GetOutputProperties("w").at(0)));
+
+  // Replace `w` with a new node consuming `c`.
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "w") {
+      node.set_name("v");
+      node.set_op("Square");
+      node.set_input(0, "c");
+    }
+  }
+  TF_ASSERT_OK(properties.UpdateStatically({"v"}));
+  EXPECT_FALSE(properties.HasOutputProperties("w"));
+  EXPECT_EQ("float: [4,3]",
+            PropToString(properties.GetOutputProperties("v").at(0)));
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyUsesFaninValues) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape(TensorShape({6})));
+  Output shape = ops::Const(s.WithOpName("shape"), {2, 3}, {2});
+  Output r = ops::Reshape(s.WithOpName("r"), x, shape);
+
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  GraphProperties properties(item);
+  TF_ASSERT_OK(properties.InferStatically(false));
+
+  // Only `r` is re-inferred, from the known value of `shape`.
+  TF_ASSERT_OK(properties.UpdateStatically({"r"}));
+  EXPECT_EQ("float: [2,3]",
+            PropToString(properties.GetOutputProperties("r").at(0)));
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyRequiresInferStatically) {
+  GrapplerItem item;
+  GraphProperties properties(item);
+  EXPECT_TRUE(errors::IsFailedPrecondition(properties.UpdateStatically({})));
+}
+
 TEST_F(GraphPropertiesTest, DynamicProperties) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false,
                                           cluster_->GetDeviceNames());
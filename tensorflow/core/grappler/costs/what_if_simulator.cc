@@ -0,0 +1,318 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/what_if_simulator.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/costs/analytical_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measuring_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+Costs::Duration Scale(Costs::Duration duration, double factor) {
+  return Costs::Duration(static_cast<int64_t>(duration.count() * factor));
+}
+
+// Scales the costs predicted by the OpLevelCostEstimator with the calibration
+// factor of the op type.
+class CalibratedOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  CalibratedOpLevelCostEstimator(const std::map<string, double>& op_calibration,
+                                 double default_calibration)
+      : op_calibration_(op_calibration),
+        default_calibration_(default_calibration) {}
+
+  Costs PredictCosts(const OpContext& op_context) const override {
+    Costs costs = OpLevelCostEstimator::PredictCosts(op_context);
+    auto it = op_calibration_.find(op_context.op_info.op());
+    const double factor =
+        it == op_calibration_.end() ? default_calibration_ : it->second;
+    if (factor != 1.0) {
+      costs.execution_time = Scale(costs.execution_time, factor);
+      costs.compute_time = Scale(costs.compute_time, factor);
+      costs.memory_time = Scale(costs.memory_time, factor);
+    }
+    return costs;
+  }
+
+ private:
+  const std::map<string, double>& op_calibration_;
+  const double default_calibration_;
+};
+
+void SetLeadingDimension(int64_t size, TensorShapeProto* shape) {
+  if (!shape->unknown_rank() && shape->dim_size() > 0) {
+    shape->mutable_dim(0)->set_size(size);
+  }
+}
+
+void ReplaceFloatType(DataType dtype, AttrValue* attr) {
+  if (attr->value_case() == AttrValue::kType) {
+    if (attr->type() == DT_FLOAT) attr->set_type(dtype);
+  } else if (attr->has_list()) {
+    auto* types = attr->mutable_list()->mutable_type();
+    for (int i = 0; i < types->size(); ++i) {
+      if (types->Get(i) == DT_FLOAT) types->Set(i, dtype);
+    }
+  }
+}
+
+}  // namespace
+
+std::unordered_map<string, DeviceProperties> WhatIfConfig::MakeDevices(
+    const DeviceProperties& properties, int num_devices) {
+  std::unordered_map<string, DeviceProperties> devices;
+  for (int i = 0; i < num_devices; ++i) {
+    devices[strings::StrCat("/job:localhost/replica:0/task:0/device:",
+                            properties.type(), ":", i)] = properties;
+  }
+  return devices;
+}
+
+string WhatIfResult::DebugString() const {
+  string result = strings::StrCat(
+      "step time: ", step_time.count() / 1e6, " ms, inaccurate nodes: ",
+      num_inaccurate_nodes, ", peak memory:");
+  for (const auto& device : peak_memory_bytes) {
+    strings::StrAppend(&result, " ", device.first, ": ",
+                       device.second / (1024.0 * 1024.0), " MiB");
+  }
+  return result;
+}
+
+Status WhatIfSimulator::Calibrate(Cluster* cluster, int measurement_steps) {
+  MeasuringCostEstimator measuring_estimator(cluster, measurement_steps,
+                                             /*measurement_threads=*/0);
+  TF_RETURN_IF_ERROR(measuring_estimator.Initialize(item_));
+  RunMetadata measured;
+  Costs measured_costs;
+  TF_RETURN_IF_ERROR(measuring_estimator.PredictCosts(item_.graph, &measured,
+                                                      &measured_costs));
+
+  AnalyticalCostEstimator analytical_estimator(
+      cluster, /*use_static_shapes=*/true,
+      /*use_aggressive_shape_inference=*/true);
+  TF_RETURN_IF_ERROR(analytical_estimator.Initialize(item_));
+  RunMetadata estimated;
+  Costs estimated_costs;
+  TF_RETURN_IF_ERROR(analytical_estimator.PredictCosts(item_.graph, &estimated,
+                                                       &estimated_costs));
+
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : item_.graph.node()) {
+    nodes[node.name()] = &node;
+  }
+  std::unordered_map<string, int64_t> measured_micros;
+  for (const auto& node : measured.cost_graph().node()) {
+    measured_micros[node.name()] = node.compute_cost();
+  }
+
+  // Total measured and estimated microseconds of each op type.
+  std::map<string, std::pair<int64_t, int64_t>> op_micros;
+  int64_t total_measured = 0;
+  int64_t total_estimated = 0;
+  for (const auto& node : estimated.cost_graph().node()) {
+    auto node_it = nodes.find(node.name());
+    auto measured_it = measured_micros.find(node.name());
+    if (node_it == nodes.end() || measured_it == measured_micros.end() ||
+        node.compute_cost() <= 0) {
+      continue;
+    }
+    auto& micros = op_micros[node_it->second->op()];
+    micros.first += measured_it->second;
+    micros.second += node.compute_cost();
+    total_measured += measured_it->second;
+    total_estimated += node.compute_cost();
+  }
+
+  op_calibration_.clear();
+  for (const auto& op : op_micros) {
+    op_calibration_[op.first] =
+        static_cast<double>(op.second.first) / op.second.second;
+    VLOG(1) << "Calibration of " << op.first << ": "
+            << op_calibration_[op.first];
+  }
+  default_calibration_ =
+      total_estimated > 0
+          ? static_cast<double>(total_measured) / total_estimated
+          : 1.0;
+  VLOG(1) << "Measured step time: " << measured_costs.execution_time.count()
+          << " ns, estimated: " << estimated_costs.execution_time.count()
+          << " ns, default calibration: " << default_calibration_;
+  return OkStatus();
+}
+
+StatusOr<GrapplerItem> WhatIfSimulator::ApplyConfig(
+    const WhatIfConfig& config) const {
+  GrapplerItem item = item_;
+  if (config.batch_size > 0) {
+    for (auto& feed : item.feed) {
+      const Tensor& tensor = feed.second;
+      if (tensor.dims() == 0) continue;
+      TensorShape shape = tensor.shape();
+      shape.set_dim(0, config.batch_size);
+      feed.second = Tensor(tensor.dtype(), shape);
+    }
+    for (NodeDef& node : *item.graph.mutable_node()) {
+      auto* attrs = node.mutable_attr();
+      if (IsPlaceholder(node) && attrs->count("shape")) {
+        SetLeadingDimension(config.batch_size,
+                            (*attrs)["shape"].mutable_shape());
+      } else if (node.op() == "IteratorGetNext" ||
+                 node.op() == "IteratorGetNextSync") {
+        for (auto& shape :
+             *(*attrs)["output_shapes"].mutable_list()->mutable_shape()) {
+          SetLeadingDimension(config.batch_size, &shape);
+        }
+      }
+      // The shapes inferred for the original batch size are stale.
+      attrs->erase("_output_shapes");
+    }
+  }
+
+  if (config.activation_dtype != DT_FLOAT) {
+    if (config.activation_dtype != DT_HALF &&
+        config.activation_dtype != DT_BFLOAT16) {
+      return errors::InvalidArgument(
+          "Unsupported activation data type: ",
+          DataTypeString(config.activation_dtype));
+    }
+    for (NodeDef& node : *item.graph.mutable_node()) {
+      // Inputs, constants and variables stay in float32, like the master
+      // weights of mixed precision training.
+      if (IsPlaceholder(node) || IsConstant(node) || IsVariable(node)) {
+        continue;
+      }
+      for (auto& attr : *node.mutable_attr()) {
+        ReplaceFloatType(config.activation_dtype, &attr.second);
+      }
+    }
+  }
+  return item;
+}
+
+Status WhatIfSimulator::Estimate(
+    const GrapplerItem& item,
+    const std::unordered_map<string, DeviceProperties>& devices,
+    RunMetadata* run_metadata, WhatIfResult* result) const {
+  VirtualCluster cluster(devices);
+  AnalyticalCostEstimator estimator(
+      &cluster,
+      std::make_unique<CalibratedOpLevelCostEstimator>(op_calibration_,
+                                                       default_calibration_),
+      ReadyNodeManagerFactory("FirstReady"), /*use_static_shapes=*/true,
+      /*use_aggressive_shape_inference=*/true);
+  TF_RETURN_IF_ERROR(estimator.Initialize(item));
+  Costs costs;
+  TF_RETURN_IF_ERROR(estimator.PredictCosts(item.graph, run_metadata, &costs));
+
+  result->step_time = costs.execution_time;
+  const VirtualScheduler* scheduler = estimator.GetScheduler();
+  const auto persistent_memory = scheduler->GetPersistentMemoryUsage();
+  for (const auto& device : scheduler->GetPeakMemoryUsage()) {
+    // Skip the channels the scheduler adds between devices.
+    if (!devices.count(device.first)) continue;
+    auto it = persistent_memory.find(device.first);
+    result->peak_memory_bytes[device.first] =
+        device.second + (it == persistent_memory.end() ? 0 : it->second);
+  }
+  result->num_inaccurate_nodes = 0;
+  for (const auto& node : run_metadata->cost_graph().node()) {
+    if (node.inaccurate()) ++result->num_inaccurate_nodes;
+  }
+  return OkStatus();
+}
+
+StatusOr<WhatIfResult> WhatIfSimulator::Simulate(
+    const WhatIfConfig& config) const {
+  if (config.devices.empty()) {
+    return errors::InvalidArgument("The configuration has no devices");
+  }
+  TF_ASSIGN_OR_RETURN(GrapplerItem item, ApplyConfig(config));
+
+  if (config.placement != WhatIfConfig::Placement::kAsRequested) {
+    std::vector<string> targets;
+    for (const auto& device : config.devices) {
+      if (device.second.type() != "CPU") targets.push_back(device.first);
+    }
+    if (targets.empty()) {
+      for (const auto& device : config.devices) {
+        targets.push_back(device.first);
+      }
+    }
+    std::sort(targets.begin(), targets.end());
+    for (NodeDef& node : *item.graph.mutable_node()) {
+      node.set_device(targets[0]);
+    }
+
+    if (config.placement == WhatIfConfig::Placement::kPipeline &&
+        targets.size() > 1) {
+      // Balance the stages with the costs of the nodes on a single device.
+      RunMetadata run_metadata;
+      WhatIfResult single_device_result;
+      TF_RETURN_IF_ERROR(Estimate(item, config.devices, &run_metadata,
+                                  &single_device_result));
+      std::unordered_map<string, int64_t> node_micros;
+      int64_t total_micros = 0;
+      for (const auto& node : run_metadata.cost_graph().node()) {
+        node_micros[node.name()] = node.compute_cost();
+        total_micros += node.compute_cost();
+      }
+      std::vector<const NodeDef*> topo_order;
+      TF_RETURN_IF_ERROR(ComputeTopologicalOrder(item.graph, &topo_order));
+      std::unordered_map<string, int> stages;
+      int64_t prefix_micros = 0;
+      const int num_stages = targets.size();
+      for (int i = 0; i < topo_order.size(); ++i) {
+        const string& name = topo_order[i]->name();
+        // Without costs, balance the number of nodes instead.
+        const int stage =
+            total_micros > 0 ? prefix_micros * num_stages / total_micros
+                             : static_cast<int64_t>(i) * num_stages /
+                                   topo_order.size();
+        stages[name] = std::min(stage, num_stages - 1);
+        prefix_micros += node_micros[name];
+      }
+      for (NodeDef& node : *item.graph.mutable_node()) {
+        node.set_device(targets[stages[node.name()]]);
+      }
+    }
+  }
+
+  RunMetadata run_metadata;
+  WhatIfResult result;
+  TF_RETURN_IF_ERROR(Estimate(item, config.devices, &run_metadata, &result));
+  return result;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,134 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_WHAT_IF_SIMULATOR_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_WHAT_IF_SIMULATOR_H_
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+class Cluster;
+
+// A hypothetical configuration to run a model with.
+struct WhatIfConfig {
+  // How to assign the nodes of the graph to the devices of the configuration.
+  enum class Placement {
+    // Keep the devices requested by the nodes, and place the nodes that do not
+    // request one of the devices of the configuration with the VirtualPlacer.
+    kAsRequested,
+    // Place all the nodes on the first accelerator, or on the first CPU if
+    // there are none.
+    kSingleDevice,
+    // Split the graph in topological order into one stage per accelerator (or
+    // per CPU if there are none) with about the same compute time each. The
+    // stages of consecutive steps do not overlap in the simulation.
+    kPipeline,
+  };
+
+  // Devices of the simulated machine, indexed by their fully qualified name.
+  std::unordered_map<string, DeviceProperties> devices;
+  Placement placement = Placement::kAsRequested;
+  // If positive, the size of the leading dimension of the inputs of the model.
+  int batch_size = 0;
+  // The data type of float32 activations. DT_HALF or DT_BFLOAT16 simulate
+  // mixed precision: only the bytes moved and stored by the ops change,
+  // variables and constants stay in float32, and the compute throughput of the
+  // devices is the one in their properties.
+  DataType activation_dtype = DT_FLOAT;
+
+  // Returns `num_devices` devices of type `properties.type()` with the given
+  // properties, named like the devices of a local session.
+  static std::unordered_map<string, DeviceProperties> MakeDevices(
+      const DeviceProperties& properties, int num_devices);
+};
+
+// Predicted performance of a model in a `WhatIfConfig`.
+struct WhatIfResult {
+  // Time of one step.
+  Costs::Duration step_time;
+  // Peak memory of each device, in bytes, including the persistent memory.
+  std::map<string, int64_t> peak_memory_bytes;
+  // Number of nodes whose cost could not be estimated accurately, for example
+  // because of unknown shapes or ops without a cost model.
+  int num_inaccurate_nodes = 0;
+
+  string DebugString() const;
+};
+
+// Predicts the step time and the peak memory of a model in configurations that
+// may not be available, such as other devices, batch sizes, placements or
+// precisions, with the AnalyticalCostEstimator.
+//
+// The analytical estimates are calibrated by running the model once on a real
+// cluster with the MeasuringCostEstimator: the predicted time of each op is
+// multiplied by the ratio of the measured and analytical times of the ops of
+// the same type. Calibrating on the hardware closest to the simulated one gives
+// the best predictions, since the ratio captures the efficiency of kernels that
+// the roofline model of the OpLevelCostEstimator does not.
+//
+// Usage:
+//   WhatIfSimulator simulator(item);
+//   TF_RETURN_IF_ERROR(simulator.Calibrate(&cluster, 10));
+//   WhatIfConfig config;
+//   config.devices = WhatIfConfig::MakeDevices(gpu_properties, 8);
+//   config.batch_size = 256;
+//   TF_ASSIGN_OR_RETURN(WhatIfResult result, simulator.Simulate(config));
+class WhatIfSimulator {
+ public:
+  explicit WhatIfSimulator(const GrapplerItem& item) : item_(item) {}
+
+  // Measures the model on `cluster`, which must be provisioned, and computes
+  // the calibration factors. Simulate() uses the uncalibrated analytical
+  // estimates until this is called.
+  Status Calibrate(Cluster* cluster, int measurement_steps);
+
+  StatusOr<WhatIfResult> Simulate(const WhatIfConfig& config) const;
+
+  // Ratio of the measured and analytical time of each op type, and of all the
+  // ops, which is used for the op types that were not measured.
+  const std::map<string, double>& op_calibration() const {
+    return op_calibration_;
+  }
+  double default_calibration() const { return default_calibration_; }
+
+ private:
+  // Returns `item_` modified according to `config`, except for the placement.
+  StatusOr<GrapplerItem> ApplyConfig(const WhatIfConfig& config) const;
+
+  // Runs the calibrated analytical estimator on `item`.
+  Status Estimate(const GrapplerItem& item,
+                  const std::unordered_map<string, DeviceProperties>& devices,
+                  RunMetadata* run_metadata, WhatIfResult* result) const;
+
+  const GrapplerItem item_;
+  std::map<string, double> op_calibration_;
+  double default_calibration_ = 1.0;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_WHAT_IF_SIMULATOR_H_
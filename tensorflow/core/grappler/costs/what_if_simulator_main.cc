@@ -0,0 +1,213 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Predicts the step time and the peak memory of a model in hypothetical
+// configurations, for example:
+//
+//   what_if_simulator --metagraph=model.meta --num_devices=1,4,8 \
+//     --batch_sizes=64,256 --activation_types=float,half
+//
+// simulates every combination of the device counts, batch sizes and
+// activation types, after calibrating the cost model on the local machine.
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/single_machine.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/what_if_simulator.h"
+#include "tensorflow/core/grappler/devices.h"
+#include "tensorflow/core/grappler/grappler_item_builder.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Status ParseInts(const string& str, std::vector<int>* values) {
+  for (const string& value : str_util::Split(str, ',', str_util::SkipEmpty())) {
+    int parsed;
+    if (!strings::safe_strto32(value, &parsed) || parsed < 0) {
+      return errors::InvalidArgument("Invalid integer: ", value);
+    }
+    values->push_back(parsed);
+  }
+  return OkStatus();
+}
+
+Status ParsePlacement(const string& str, WhatIfConfig::Placement* placement) {
+  if (str == "as_requested") {
+    *placement = WhatIfConfig::Placement::kAsRequested;
+  } else if (str == "single_device") {
+    *placement = WhatIfConfig::Placement::kSingleDevice;
+  } else if (str == "pipeline") {
+    *placement = WhatIfConfig::Placement::kPipeline;
+  } else {
+    return errors::InvalidArgument("Invalid placement: ", str);
+  }
+  return OkStatus();
+}
+
+Status RunWhatIfSimulator(const string& metagraph,
+                          const string& device_properties,
+                          const std::vector<int>& num_devices,
+                          const std::vector<int>& batch_sizes,
+                          const std::vector<DataType>& activation_types,
+                          WhatIfConfig::Placement placement, bool calibrate,
+                          int measurement_steps) {
+  std::unique_ptr<GrapplerItem> item =
+      GrapplerItemFromMetaGraphDefFile("what_if", metagraph, ItemConfig());
+  if (!item) {
+    return errors::InvalidArgument("Failed to load the model from ",
+                                   metagraph);
+  }
+
+  const int num_gpus = GetNumAvailableGPUs();
+  DeviceProperties properties;
+  if (!device_properties.empty()) {
+    TF_RETURN_IF_ERROR(
+        ReadTextProto(Env::Default(), device_properties, &properties));
+  } else if (num_gpus > 0) {
+    properties = GetLocalGPUInfo(PlatformDeviceId(0));
+  } else {
+    properties = GetLocalCPUInfo();
+  }
+
+  WhatIfSimulator simulator(*item);
+  if (calibrate) {
+    SingleMachine cluster(/*timeout_s=*/600, GetNumAvailableLogicalCPUCores(),
+                          num_gpus);
+    TF_RETURN_IF_ERROR(cluster.Provision());
+    TF_RETURN_IF_ERROR(cluster.Initialize(*item));
+    TF_RETURN_IF_ERROR(simulator.Calibrate(&cluster, measurement_steps));
+    TF_RETURN_IF_ERROR(cluster.Shutdown());
+  }
+
+  std::cout << absl::StrFormat("%-8s %-10s %-10s %14s %16s %16s\n", "devices",
+                               "batch", "type", "step time (ms)",
+                               "max peak (MiB)", "total peak (MiB)");
+  for (int count : num_devices) {
+    for (int batch_size : batch_sizes) {
+      for (DataType activation_type : activation_types) {
+        WhatIfConfig config;
+        config.devices = WhatIfConfig::MakeDevices(properties, count);
+        config.placement = placement;
+        config.batch_size = batch_size;
+        config.activation_dtype = activation_type;
+        TF_ASSIGN_OR_RETURN(WhatIfResult result, simulator.Simulate(config));
+        VLOG(1) << result.DebugString();
+
+        int64_t max_peak = 0;
+        int64_t total_peak = 0;
+        for (const auto& device : result.peak_memory_bytes) {
+          max_peak = std::max(max_peak, device.second);
+          total_peak += device.second;
+        }
+        std::cout << absl::StrFormat(
+            "%-8d %-10s %-10s %14.3f %16.1f %16.1f\n", count,
+            batch_size > 0 ? std::to_string(batch_size) : "model",
+            DataTypeString(activation_type), result.step_time.count() / 1e6,
+            max_peak / (1024.0 * 1024.0), total_peak / (1024.0 * 1024.0));
+      }
+    }
+  }
+  return OkStatus();
+}
+
+int ParseFlagsAndRun(int argc, char* argv[]) {
+  string metagraph;
+  string device_properties;
+  string num_devices = "1";
+  string batch_sizes;
+  string activation_types = "float";
+  string placement = "as_requested";
+  bool calibrate = true;
+  int measurement_steps = 10;
+  std::vector<Flag> flag_list = {
+      Flag("metagraph", &metagraph, "MetaGraphDef of the model"),
+      Flag("device_properties", &device_properties,
+           "DeviceProperties text proto of the simulated devices. Defaults "
+           "to the first local GPU, or the local CPU if there are none"),
+      Flag("num_devices", &num_devices,
+           "Comma separated numbers of devices to simulate"),
+      Flag("batch_sizes", &batch_sizes,
+           "Comma separated batch sizes to simulate. Defaults to the batch "
+           "size of the model"),
+      Flag("activation_types", &activation_types,
+           "Comma separated types of the float32 activations to simulate: "
+           "float, half or bfloat16"),
+      Flag("placement", &placement,
+           "How to place the nodes: as_requested, single_device or pipeline"),
+      Flag("calibrate", &calibrate,
+           "Whether to calibrate the cost model by running the model on the "
+           "local machine"),
+      Flag("measurement_steps", &measurement_steps,
+           "Number of steps to measure for the calibration"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc > 1 || metagraph.empty()) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+
+  std::vector<int> parsed_num_devices;
+  std::vector<int> parsed_batch_sizes;
+  std::vector<DataType> parsed_activation_types;
+  WhatIfConfig::Placement parsed_placement;
+  Status status = ParseInts(num_devices, &parsed_num_devices);
+  if (status.ok()) status = ParseInts(batch_sizes, &parsed_batch_sizes);
+  if (parsed_batch_sizes.empty()) parsed_batch_sizes.push_back(0);
+  for (const string& type :
+       str_util::Split(activation_types, ',', str_util::SkipEmpty())) {
+    DataType dtype;
+    if (!DataTypeFromString(type, &dtype)) {
+      status.Update(errors::InvalidArgument("Invalid type: ", type));
+      break;
+    }
+    parsed_activation_types.push_back(dtype);
+  }
+  if (status.ok()) status = ParsePlacement(placement, &parsed_placement);
+  if (status.ok()) {
+    status = RunWhatIfSimulator(metagraph, device_properties,
+                                parsed_num_devices, parsed_batch_sizes,
+                                parsed_activation_types, parsed_placement,
+                                calibrate, measurement_steps);
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::grappler::ParseFlagsAndRun(argc, argv);
+}
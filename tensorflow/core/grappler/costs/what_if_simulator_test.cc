@@ -0,0 +1,147 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/what_if_simulator.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class WhatIfSimulatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    gpu_.set_type("GPU");
+    gpu_.set_num_cores(12);
+    gpu_.set_frequency(1100);
+    gpu_.set_bandwidth(180 * 1024 * 1024);
+    (*gpu_.mutable_environment())["architecture"] = "6";
+  }
+
+  // Two fully connected layers on a batch of 32.
+  GrapplerItem CreateItem() {
+    const int batch = 32;
+    const int width = 512;
+    Scope s = Scope::NewRootScope();
+    auto input = ops::Placeholder(s.WithOpName("input"), DT_FLOAT,
+                                  ops::Placeholder::Shape({batch, width}));
+    auto w1 = ops::Variable(s.WithOpName("w1"), {width, width}, DT_FLOAT);
+    auto w2 = ops::Variable(s.WithOpName("w2"), {width, width}, DT_FLOAT);
+    auto matmul1 = ops::MatMul(s.WithOpName("matmul1"), input, w1);
+    auto relu1 = ops::Relu(s.WithOpName("relu1"), matmul1);
+    auto matmul2 = ops::MatMul(s.WithOpName("matmul2"), relu1, w2);
+    auto relu2 = ops::Relu(s.WithOpName("relu2"), matmul2);
+
+    GrapplerItem item;
+    item.fetch.push_back("relu2");
+    item.feed.emplace_back("input", Tensor(DT_FLOAT, {batch, width}));
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+
+  WhatIfResult Simulate(const WhatIfSimulator& simulator,
+                        const WhatIfConfig& config) {
+    StatusOr<WhatIfResult> result = simulator.Simulate(config);
+    TF_CHECK_OK(result.status());
+    VLOG(1) << result->DebugString();
+    return std::move(result).value();
+  }
+
+  static int64_t TotalPeakMemory(const WhatIfResult& result) {
+    int64_t total = 0;
+    for (const auto& device : result.peak_memory_bytes) {
+      total += device.second;
+    }
+    return total;
+  }
+
+  DeviceProperties gpu_;
+};
+
+TEST_F(WhatIfSimulatorTest, BatchSize) {
+  WhatIfSimulator simulator(CreateItem());
+  WhatIfConfig config;
+  config.devices = WhatIfConfig::MakeDevices(gpu_, 1);
+  const WhatIfResult model_batch = Simulate(simulator, config);
+  config.batch_size = 512;
+  const WhatIfResult large_batch = Simulate(simulator, config);
+
+  ASSERT_EQ(model_batch.peak_memory_bytes.size(), 1);
+  EXPECT_GT(model_batch.step_time, Costs::Duration(0));
+  EXPECT_GT(large_batch.step_time, model_batch.step_time);
+  EXPECT_GT(TotalPeakMemory(large_batch), TotalPeakMemory(model_batch));
+}
+
+TEST_F(WhatIfSimulatorTest, ActivationType) {
+  WhatIfSimulator simulator(CreateItem());
+  WhatIfConfig config;
+  config.devices = WhatIfConfig::MakeDevices(gpu_, 1);
+  config.batch_size = 512;
+  const WhatIfResult fp32 = Simulate(simulator, config);
+  config.activation_dtype = DT_HALF;
+  const WhatIfResult fp16 = Simulate(simulator, config);
+
+  EXPECT_LE(fp16.step_time, fp32.step_time);
+  EXPECT_LT(TotalPeakMemory(fp16), TotalPeakMemory(fp32));
+
+  config.activation_dtype = DT_INT32;
+  EXPECT_TRUE(errors::IsInvalidArgument(simulator.Simulate(config).status()));
+}
+
+TEST_F(WhatIfSimulatorTest, Placement) {
+  WhatIfSimulator simulator(CreateItem());
+  WhatIfConfig config;
+  config.devices = WhatIfConfig::MakeDevices(gpu_, 2);
+  config.placement = WhatIfConfig::Placement::kSingleDevice;
+  const WhatIfResult single_device = Simulate(simulator, config);
+  EXPECT_EQ(single_device.peak_memory_bytes.size(), 1);
+
+  config.placement = WhatIfConfig::Placement::kPipeline;
+  const WhatIfResult pipeline = Simulate(simulator, config);
+  ASSERT_EQ(pipeline.peak_memory_bytes.size(), 2);
+  for (const auto& device : pipeline.peak_memory_bytes) {
+    EXPECT_GT(device.second, 0) << device.first;
+  }
+}
+
+TEST_F(WhatIfSimulatorTest, CalibrateOnVirtualCluster) {
+  // The measurements of a virtual cluster are the analytical estimates, so the
+  // calibration factors are about 1.
+  VirtualCluster cluster(WhatIfConfig::MakeDevices(gpu_, 1));
+  TF_ASSERT_OK(cluster.Provision());
+  const GrapplerItem item = CreateItem();
+  TF_ASSERT_OK(cluster.Initialize(item));
+  WhatIfSimulator simulator(item);
+  TF_ASSERT_OK(simulator.Calibrate(&cluster, /*measurement_steps=*/2));
+
+  EXPECT_NEAR(simulator.default_calibration(), 1.0, 0.05);
+  ASSERT_EQ(simulator.op_calibration().count("MatMul"), 1);
+  EXPECT_NEAR(simulator.op_calibration().at("MatMul"), 1.0, 0.05);
+}
+
+TEST_F(WhatIfSimulatorTest, NoDevices) {
+  WhatIfSimulator simulator(CreateItem());
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      simulator.Simulate(WhatIfConfig()).status()));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -16,12 +16,15 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
 #include <fstream>
+#include <map>
 #include <memory>
 #include <unordered_map>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -41,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/util/env_var.h"
@@ -951,6 +955,72 @@ bool HasInputOrOutputRefs(const NodeDef& node) {
   return false;
 }
 
+using NativeCpuIsa = AutoMixedPrecisionListsNativeCpu::Isa;
+
+// Returns the low precision instructions of the host CPU used by the
+// NATIVE_CPU mode, preferring the fastest ones, or nullopt if there are none.
+// TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA overrides the detection with
+// one of AMX_BF16, AVX512_BF16, ARM_BF16 or ARM_FP16.
+Status GetNativeCpuIsa(absl::optional<NativeCpuIsa>* isa) {
+  string isa_str;
+  TF_RETURN_IF_ERROR(ReadStringFromEnvVar(
+      "TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA", "", &isa_str));
+  isa_str = absl::AsciiStrToUpper(isa_str);
+  if (isa_str.empty()) {
+    if (port::TestCPUFeature(port::CPUFeature::AMX_TILE) &&
+        port::TestCPUFeature(port::CPUFeature::AMX_BF16)) {
+      *isa = NativeCpuIsa::kAmxBf16;
+    } else if (port::TestCPUFeature(port::CPUFeature::AVX512_BF16)) {
+      *isa = NativeCpuIsa::kAvx512Bf16;
+    } else if (port::TestCPUFeature(port::CPUFeature::ARM_BF16)) {
+      *isa = NativeCpuIsa::kArmBf16;
+    } else if (port::TestCPUFeature(port::CPUFeature::ARM_FP16)) {
+      *isa = NativeCpuIsa::kArmFp16;
+    } else {
+      *isa = absl::nullopt;
+    }
+  } else if (isa_str == "AMX_BF16") {
+    *isa = NativeCpuIsa::kAmxBf16;
+  } else if (isa_str == "AVX512_BF16") {
+    *isa = NativeCpuIsa::kAvx512Bf16;
+  } else if (isa_str == "ARM_BF16") {
+    *isa = NativeCpuIsa::kArmBf16;
+  } else if (isa_str == "ARM_FP16") {
+    *isa = NativeCpuIsa::kArmFp16;
+  } else {
+    return errors::InvalidArgument(
+        "Invalid value for TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA: ",
+        isa_str,
+        ". Expected one of AMX_BF16, AVX512_BF16, ARM_BF16 or ARM_FP16");
+  }
+  return OkStatus();
+}
+
+const char* NativeCpuIsaString(NativeCpuIsa isa) {
+  switch (isa) {
+    case NativeCpuIsa::kAmxBf16:
+      return "AMX_BF16";
+    case NativeCpuIsa::kAvx512Bf16:
+      return "AVX512_BF16";
+    case NativeCpuIsa::kArmBf16:
+      return "ARM_BF16";
+    case NativeCpuIsa::kArmFp16:
+      return "ARM_FP16";
+  }
+}
+
+DataType GetTargetDataType(AutoMixedPrecisionMode mode, NativeCpuIsa isa) {
+  switch (mode) {
+    case AutoMixedPrecisionMode::CUDA:
+    case AutoMixedPrecisionMode::CPU:
+      return DT_HALF;
+    case AutoMixedPrecisionMode::BF16:
+      return DT_BFLOAT16;
+    case AutoMixedPrecisionMode::NATIVE_CPU:
+      return isa == NativeCpuIsa::kArmFp16 ? DT_HALF : DT_BFLOAT16;
+  }
+}
+
 // See TF issue 25977 for no-FP16 on SCEWL
 bool CanForceFP16(const NodeDef& node) {
   return node.op() != "Const" && node.op() != "SoftmaxCrossEntropyWithLogits" &&
@@ -1035,7 +1105,8 @@ class AutoMixedPrecisionImpl {
   AutoMixedPrecisionImpl(Cluster* cluster,
                          const std::unordered_set<string>& nodes_to_preserve,
                          GraphDef* graph, string id,
-                         AutoMixedPrecisionMode mode)
+                         AutoMixedPrecisionMode mode,
+                         NativeCpuIsa native_cpu_isa = NativeCpuIsa::kAmxBf16)
       : devices_(GetDevices(cluster)),
         virtual_placer_(devices_),
         nodes_to_preserve_(nodes_to_preserve),
@@ -1047,10 +1118,8 @@ class AutoMixedPrecisionImpl {
         cudnn_version_(GetCudnnVersion(devices_)),
         num_nonvar_casts_to_f16_(0),
         mode_(mode),
-        target_dtype_((mode_ == AutoMixedPrecisionMode::CUDA ||
-                       mode_ == AutoMixedPrecisionMode::CPU)
-                          ? DT_HALF
-                          : DT_BFLOAT16) {}
+        native_cpu_isa_(native_cpu_isa),
+        target_dtype_(GetTargetDataType(mode, native_cpu_isa)) {}
 
   Status Optimize();
 
@@ -1070,6 +1139,9 @@ class AutoMixedPrecisionImpl {
         return std::make_unique<AutoMixedPrecisionListsCuda>(
             /*cuda_version=*/10000,   // Hardcode cuda and cudnn version so
             /*cudnn_version=*/8000);  // CPU emulates the same ops on GPU.
+      case AutoMixedPrecisionMode::NATIVE_CPU:
+        return std::make_unique<AutoMixedPrecisionListsNativeCpu>(
+            native_cpu_isa_);
     }
   }
   Status PrintDebugLogs(bool preop, size_t timestamp);
@@ -1139,6 +1211,7 @@ class AutoMixedPrecisionImpl {
   bool force_all_fp16_;
   bool treat_infer_as_deny_;
   AutoMixedPrecisionMode mode_;
+  NativeCpuIsa native_cpu_isa_;  // Only used by the NATIVE_CPU mode.
   gtl::FlatSet<string> f16_allowlist_;
   gtl::FlatSet<string> f16_denylist_;
   gtl::FlatSet<string> f16_inferlist_;
@@ -1420,6 +1493,7 @@ Status AutoMixedPrecisionImpl::Optimize() {
         break;
       case AutoMixedPrecisionMode::BF16:
       case AutoMixedPrecisionMode::CPU:
+      case AutoMixedPrecisionMode::NATIVE_CPU:
         device_type = DEVICE_CPU;
         should_process = !MustPreserve(node) && IsOnDevice(node, device_type);
         break;
@@ -1848,8 +1922,9 @@ void AutoMixedPrecisionImpl::PropagateAllowThroughClear(
 void AutoMixedPrecisionImpl::AddInferToAllowIfFollowAllow(
     const absl::flat_hash_set<int>& deny_set,
     absl::flat_hash_set<int>* allow_set) const {
-  // Currently only target for oneDNN
-  if (mode_ != AutoMixedPrecisionMode::BF16) {
+  // Currently only target for oneDNN and the native CPU kernels
+  if (mode_ != AutoMixedPrecisionMode::BF16 &&
+      mode_ != AutoMixedPrecisionMode::NATIVE_CPU) {
     return;
   }
   for (int item_idx = 0; item_idx < graph_type_view_.num_nodes(); ++item_idx) {
@@ -2157,6 +2232,8 @@ void AutoMixedPrecisionImpl::CollectOutputPorts(
 Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
     const absl::flat_hash_set<int>& allow_set) {
   int num_nodes_changed = 0;
+  // Ordered so that the report is stable.
+  std::map<string, int> num_nodes_changed_by_op;
   const int num_nodes_preop = graph_->node_size();
 
   bool emulate_f16 = false;
@@ -2222,6 +2299,7 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
             return errors::Internal("Failed to set type attribute");
           }
           ++num_nodes_changed;
+          ++num_nodes_changed_by_op[node->op()];
           CollectOutputPorts(type_attr, node, output_ports);
         }
       } else {
@@ -2247,6 +2325,11 @@ Status AutoMixedPrecisionImpl::ChangeTypeAttrsAndAddCasts(
             << " nodes to " << type_str << " precision using "
             << num_nonvar_casts_to_f16_ << " cast(s) to " << type_str
             << " (excluding Const and Variable casts)";
+  if (!num_nodes_changed_by_op.empty()) {
+    LOG(INFO) << "Converted to " << type_str << " by op type: "
+              << absl::StrJoin(num_nodes_changed_by_op, ", ",
+                               absl::PairFormatter(": "));
+  }
   return OkStatus();
 }
 
@@ -2302,9 +2385,22 @@ Status AutoMixedPrecision::Optimize(Cluster* cluster, const GrapplerItem& item,
                  << " graph optimizer configured for BFloat16 on CPUs";
   }
 
+  absl::optional<NativeCpuIsa> native_cpu_isa;
+  if (mode_ == AutoMixedPrecisionMode::NATIVE_CPU) {
+    TF_RETURN_IF_ERROR(GetNativeCpuIsa(&native_cpu_isa));
+    if (!native_cpu_isa.has_value()) {
+      LOG(WARNING) << "No bfloat16 or float16 support detected on the CPU, "
+                   << "skipping " << name() << " graph optimizer";
+      return OkStatus();
+    }
+    VLOG(1) << "Using the " << NativeCpuIsaString(*native_cpu_isa)
+            << " lists in " << name();
+  }
+
   // Optimize the output graph in-place.
-  AutoMixedPrecisionImpl optimizer(cluster, item.NodesToPreserve(), output,
-                                   item.id, mode_);
+  AutoMixedPrecisionImpl optimizer(
+      cluster, item.NodesToPreserve(), output, item.id, mode_,
+      native_cpu_isa.value_or(NativeCpuIsa::kAmxBf16));
   if (item.id == "tf_graph") {
     LOG(INFO) << "Running " << name() << " graph optimizer";
   } else {
@@ -26,7 +26,9 @@ namespace grappler {
 // CUDA: convert to float16 on GPU
 // BF16: convert to bfloat16 on CPU
 // CPU: emulate float16 on CPU without changing operator kernel
-enum class AutoMixedPrecisionMode { CUDA, BF16, CPU };
+// NATIVE_CPU: convert to bfloat16 or float16 on CPU, depending on the low
+//   precision instructions of the host CPU, without oneDNN
+enum class AutoMixedPrecisionMode { CUDA, BF16, CPU, NATIVE_CPU };
 
 // Convert data types to float16 or bfloat16 where appropriate to improve
 // performance on GPUs or CPUs.
@@ -34,7 +36,9 @@ class AutoMixedPrecision : public GraphOptimizer {
  public:
   // If 'mode' is CUDA, converts nodes to float16 on Nvidia GPUs. If BF16,
   // converts nodes to bfloat16 on CPUs in order to take advantage of oneDNN
-  // performance improvements with bfloat16.
+  // performance improvements with bfloat16. If NATIVE_CPU, picks the data type
+  // and the lists of ops to convert from the AMX, AVX512_BF16 or Arm half
+  // precision support of the host CPU.
   explicit AutoMixedPrecision(
       AutoMixedPrecisionMode mode = AutoMixedPrecisionMode::CUDA)
       : mode_(mode) {}
@@ -49,6 +53,8 @@ class AutoMixedPrecision : public GraphOptimizer {
         return "auto_mixed_precision_onednn_bfloat16";
       case AutoMixedPrecisionMode::CPU:
         return "auto_mixed_precision_cpu";
+      case AutoMixedPrecisionMode::NATIVE_CPU:
+        return "auto_mixed_precision_native_cpu";
       default:
         LOG(FATAL) << "Invalid value for AutoMixedPrecisionMode: "  // Crash Ok
                    << static_cast<int>(mode_);
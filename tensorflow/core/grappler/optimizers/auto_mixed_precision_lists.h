@@ -551,6 +551,114 @@ class AutoMixedPrecisionListsMkl : public AutoMixedPrecisionLists {
   }
 };
 
+// Lists for the default CPU kernels, which depend on the low precision
+// instructions of the host CPU. AMX-BF16 speeds up convolutions and matrix
+// multiplications enough that most elementwise ops around them are worth
+// running in bfloat16 too, whereas with the AVX512_BF16 or Arm dot product
+// instructions only the compute bound ops and the cheapest elementwise ops are.
+// Ops whose results need the range of float32 stay in float32 with ARM_FP16.
+// The clear list is shared with oneDNN, since it only contains ops that move
+// or select data.
+class AutoMixedPrecisionListsNativeCpu : public AutoMixedPrecisionListsMkl {
+ public:
+  enum class Isa { kAmxBf16, kAvx512Bf16, kArmBf16, kArmFp16 };
+
+  explicit AutoMixedPrecisionListsNativeCpu(Isa isa) : isa_(isa) {}
+
+  gtl::FlatSet<string> AllowList() override {
+    auto list = gtl::FlatSet<string>{
+        "BatchMatMul",
+        "BatchMatMulV2",
+        "BatchMatMulV3",
+        "Conv2D",
+        "Conv2DBackpropFilter",
+        "Conv2DBackpropInput",
+        "Einsum",
+        "MatMul",
+    };
+    if (isa_ == Isa::kAmxBf16) {
+      list.insert("Conv3D");
+      list.insert("Conv3DBackpropFilterV2");
+      list.insert("Conv3DBackpropInputV2");
+      list.insert("DepthwiseConv2dNative");
+      list.insert("DepthwiseConv2dNativeBackpropFilter");
+      list.insert("DepthwiseConv2dNativeBackpropInput");
+    }
+    UpdateList("ALLOWLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> InferList() override {
+    auto list = gtl::FlatSet<string>{
+        "Add",
+        "AddN",
+        "AddV2",
+        "AvgPool",
+        "AvgPoolGrad",
+        "BiasAdd",
+        "BiasAddGrad",
+        "BiasAddV1",
+        "Elu",
+        "EluGrad",
+        "FusedBatchNormV2",
+        "FusedBatchNormGradV2",
+        "FusedBatchNormV3",
+        "FusedBatchNormGradV3",
+        "_FusedBatchNormEx",
+        "LeakyRelu",
+        "LeakyReluGrad",
+        "Mul",
+        "Sigmoid",
+        "SigmoidGrad",
+        "Sub",
+        "Tanh",
+        "TanhGrad",
+    };
+    if (isa_ != Isa::kArmFp16) {
+      for (const char* op :
+           {"LogSoftmax", "RealDiv", "Rsqrt", "Softmax", "Sqrt"}) {
+        list.insert(op);
+      }
+    }
+    if (isa_ == Isa::kAmxBf16) {
+      for (const char* op :
+           {"AvgPool3D", "AvgPool3DGrad", "Erf", "Erfc", "Log", "Log1p",
+            "Reciprocal", "Selu", "SeluGrad", "Softplus", "SoftplusGrad",
+            "Softsign", "SoftsignGrad", "Square", "SquaredDifference"}) {
+        list.insert(op);
+      }
+    }
+    UpdateList("INFERLIST", &list);
+    return list;
+  }
+
+  gtl::FlatSet<string> DenyList() override {
+    auto list = gtl::FlatSet<string>{
+        "Exp",
+        "Expm1",
+        "L2Loss",
+        "Mean",
+        "Pow",
+        "SaveV2",
+        "SoftmaxCrossEntropyWithLogits",
+        "SparseSoftmaxCrossEntropyWithLogits",
+        "Sum",
+    };
+    if (isa_ == Isa::kArmFp16) {
+      for (const char* op :
+           {"Log", "Log1p", "LogSoftmax", "Reciprocal", "Rsqrt", "Softmax",
+            "Square", "SquaredDifference"}) {
+        list.insert(op);
+      }
+    }
+    UpdateList("DENYLIST", &list);
+    return list;
+  }
+
+ private:
+  const Isa isa_;
+};
+
 }  // end namespace grappler
 }  // end namespace tensorflow
 
@@ -13,8 +13,6 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM || INTEL_MKL
-
 #include "tensorflow/core/grappler/optimizers/auto_mixed_precision.h"
 
 #include <utility>
@@ -23,6 +21,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/control_flow_ops_internal.h"
 #include "tensorflow/cc/ops/list_ops.h"
 #include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def_util.h"
@@ -1709,8 +1708,102 @@ TEST_F(AutoMixedPrecisionMklTest, InferFollowUpStreamDeny) {
 }
 #endif  // INTEL_MKL
 
+class AutoMixedPrecisionNativeCpuTest : public GrapplerTest {
+ protected:
+  void SetUp() override {
+    virtual_cluster_.reset(new SingleMachine(/* timeout_s = */ 10, 1, 0));
+    TF_CHECK_OK(virtual_cluster_->Provision());
+  }
+  void TearDown() override {
+    unsetenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA");
+    TF_CHECK_OK(virtual_cluster_->Shutdown());
+  }
+
+  // Converts a MatMul reading a float32 variable, followed by Square and
+  // Softmax, using the lists for `isa`.
+  GraphDef Optimize(const string& isa) {
+    setenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA", isa.c_str(),
+           1 /* replace */);
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+        "/job:localhost/replica:0/task:0/device:CPU:0");
+    Output input = ops::Const(s.WithOpName("input"), 1.f / 32, {32, 32});
+    Output var = ops::VarHandleOp(s.WithOpName("var"), DT_FLOAT, {32, 32});
+    Output weights = ops::ReadVariableOp(s.WithOpName("weights"), var,
+                                         DT_FLOAT);
+    Output allow1 = ops::MatMul(s.WithOpName("allow1"), input, weights);
+    Output infer1 = ops::Square(s.WithOpName("infer1"), allow1);
+    Output infer2 = ops::Softmax(s.WithOpName("infer2"), allow1);
+    Output clr1 = ops::Relu(s.WithOpName("clr1"), infer2);
+    Output fetch1 = ops::Identity(s.WithOpName("fetch1"), infer1);
+    Output fetch2 = ops::Identity(s.WithOpName("fetch2"), clr1);
+
+    GrapplerItem item;
+    item.fetch = {"fetch1", "fetch2"};
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+    AutoMixedPrecision optimizer{AutoMixedPrecisionMode::NATIVE_CPU};
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(virtual_cluster_.get(), item, &output));
+    VLOG(1) << output.DebugString();
+    return output;
+  }
+
+  std::unique_ptr<Cluster> virtual_cluster_;
+};
+
+TEST_F(AutoMixedPrecisionNativeCpuTest, AmxBf16) {
+  GraphDef output = Optimize("AMX_BF16");
+  GraphView output_view(&output);
+  // The master weights stay in float32.
+  EXPECT_EQ(output_view.GetNode("var")->attr().at("dtype").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("weights")->attr().at("dtype").type(),
+            DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("infer1")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("infer2")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("clr1")->attr().at("T").type(), DT_BFLOAT16);
+}
+
+TEST_F(AutoMixedPrecisionNativeCpuTest, Avx512Bf16) {
+  GraphDef output = Optimize("AVX512_BF16");
+  GraphView output_view(&output);
+  EXPECT_EQ(output_view.GetNode("weights")->attr().at("dtype").type(),
+            DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_BFLOAT16);
+  // Square is only worth converting with AMX.
+  EXPECT_EQ(output_view.GetNode("infer1")->attr().at("T").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("infer2")->attr().at("T").type(), DT_BFLOAT16);
+  EXPECT_EQ(output_view.GetNode("clr1")->attr().at("T").type(), DT_BFLOAT16);
+}
+
+TEST_F(AutoMixedPrecisionNativeCpuTest, ArmFp16) {
+  GraphDef output = Optimize("ARM_FP16");
+  GraphView output_view(&output);
+  EXPECT_EQ(output_view.GetNode("weights")->attr().at("dtype").type(),
+            DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("allow1")->attr().at("T").type(), DT_HALF);
+  // Square and Softmax need the range of float32.
+  EXPECT_EQ(output_view.GetNode("infer1")->attr().at("T").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("infer2")->attr().at("T").type(), DT_FLOAT);
+  EXPECT_EQ(output_view.GetNode("clr1")->attr().at("T").type(), DT_FLOAT);
+}
+
+TEST_F(AutoMixedPrecisionNativeCpuTest, InvalidIsa) {
+  setenv("TF_AUTO_MIXED_PRECISION_GRAPH_REWRITE_CPU_ISA", "SSE2",
+         1 /* replace */);
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output input = ops::Const(s.WithOpName("input"), 1.f, {32, 32});
+  Output allow1 = ops::MatMul(s.WithOpName("allow1"), input, input);
+  GrapplerItem item;
+  item.fetch = {"allow1"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  AutoMixedPrecision optimizer{AutoMixedPrecisionMode::NATIVE_CPU};
+  GraphDef output;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      optimizer.Optimize(virtual_cluster_.get(), item, &output)));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
-
-#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM || INTEL_MKL
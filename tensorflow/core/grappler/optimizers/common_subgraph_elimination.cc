@@ -15,7 +15,6 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/common_subgraph_elimination.h"
 
-#include <set>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -94,6 +93,12 @@ class UniqueNodes {
   absl::flat_hash_map<const NodeDef*, uint64> memoized_signatures_;
 };
 
+// The signature is a structural hash of the node: since the graph is visited
+// in topological order and the inputs of the consumers of a duplicate are
+// renamed to its representative, the input names identify the deduplicated
+// inputs. Inputs are canonicalized, so they are hashed in order, which keeps
+// nodes that only differ by the order of their inputs (e.g. `Sub(x, y)` and
+// `Sub(y, x)`) in different buckets.
 uint64 UniqueNodes::ComputeSignature(const NodeDef& node) {
   auto it = memoized_signatures_.find(&node);
   if (it != memoized_signatures_.end()) return it->second;
@@ -106,7 +111,7 @@ uint64 UniqueNodes::ComputeSignature(const NodeDef& node) {
     uint64 input_hash = Hash64Combine(
         Hash64(input_tensor.node().data(), input_tensor.node().size()),
         std::hash<int>()(input_tensor.index()));
-    h = Hash64CombineUnordered(input_hash, h);
+    h = Hash64Combine(input_hash, h);
   }
   for (const auto& attr : node.attr()) {
     uint64 attr_hash =
@@ -208,14 +213,26 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
                    CanDedup(node);
   }
 
-  bool stop = true;
-  std::set<int> duplicates;
+  absl::flat_hash_map<const NodeDef*, int> node_index;
+  node_index.reserve(optimized_graph->node_size());
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    node_index.emplace(&optimized_graph->node(i), i);
+  }
+
+  // The graph is topologically sorted, so the inputs of a node are
+  // deduplicated before the node itself, and a single pass finds all the
+  // duplicates. Another pass is only needed if the consumer of a duplicate
+  // was visited before it, which only happens through the back edges of
+  // loops.
+  bool revisit = true;
+  std::vector<bool> is_duplicate(optimized_graph->node_size(), false);
+  std::vector<int> duplicates;
   UniqueNodes nodes;
   NodeMap node_map(optimized_graph);
-  do {
-    stop = true;
+  while (revisit) {
+    revisit = false;
     for (int i = 0; i < optimized_graph->node_size(); ++i) {
-      if (!can_dedup[i] || duplicates.find(i) != duplicates.end()) {
+      if (!can_dedup[i] || is_duplicate[i]) {
         continue;
       }
       NodeDef* node = optimized_graph->mutable_node(i);
@@ -255,19 +272,20 @@ Status CommonSubgraphElimination::DedupComputations(GraphDef* optimized_graph) {
         if (updated_fanout) {
           node_map.UpdateInput(fanout->name(), node->name(), rep->name());
           CanonicalizeNode(fanout);
+          if (node_index[fanout] < i) revisit = true;
         }
       }
       if (fetch_nodes_known_) {
         node->Clear();
       }
-      duplicates.insert(i);
-      stop = false;
+      is_duplicate[i] = true;
+      duplicates.push_back(i);
     }
-  } while (!stop);
+  }
 
   // Delete duplicates
   if (fetch_nodes_known_ && !duplicates.empty()) {
-    EraseNodesFromGraph(duplicates, optimized_graph);
+    EraseNodesFromGraph(std::move(duplicates), optimized_graph);
   }
 
   return OkStatus();
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -174,5 +175,86 @@ TEST_F(CommonSubgraphEliminationTest, OpDedupCommutative) {
   test::ExpectTensorNear<float>(tensors[0], tensors_expected[0], 1e-6);
 }
 
+// Builds a graph of per-feature preprocessing, where each of `num_features`
+// placeholders goes through `num_copies` identical scale-and-shift chains.
+GrapplerItem CreatePreprocessingItem(int num_features, int num_copies) {
+  GrapplerItem item;
+  AttrValue type;
+  type.set_type(DT_FLOAT);
+  for (const char* name : {"scale", "shift"}) {
+    NodeDef* node = item.graph.add_node();
+    node->set_name(name);
+    node->set_op("Const");
+    (*node->mutable_attr())["dtype"] = type;
+    test::AsScalar<float>(1.0f).AsProtoTensorContent(
+        (*node->mutable_attr())["value"].mutable_tensor());
+  }
+  AttrValue num_inputs;
+  num_inputs.set_i(num_copies);
+  for (int i = 0; i < num_features; ++i) {
+    const string feature = absl::StrCat("feature", i);
+    NodeDef* placeholder = item.graph.add_node();
+    placeholder->set_name(feature);
+    placeholder->set_op("Placeholder");
+    (*placeholder->mutable_attr())["dtype"] = type;
+    NodeDef* sum = item.graph.add_node();
+    sum->set_name(absl::StrCat(feature, "/sum"));
+    sum->set_op("AddN");
+    (*sum->mutable_attr())["T"] = type;
+    (*sum->mutable_attr())["N"] = num_inputs;
+    for (int j = 0; j < num_copies; ++j) {
+      NodeDef* mul = item.graph.add_node();
+      mul->set_name(absl::StrCat(feature, "/mul", j));
+      mul->set_op("Mul");
+      mul->add_input(feature);
+      mul->add_input("scale");
+      (*mul->mutable_attr())["T"] = type;
+      NodeDef* add = item.graph.add_node();
+      add->set_name(absl::StrCat(feature, "/add", j));
+      add->set_op("Add");
+      add->add_input(mul->name());
+      add->add_input("shift");
+      (*add->mutable_attr())["T"] = type;
+      sum->add_input(add->name());
+    }
+    item.fetch.push_back(sum->name());
+  }
+  return item;
+}
+
+TEST_F(CommonSubgraphEliminationTest, DedupsPerFeatureChains) {
+  const GrapplerItem item = CreatePreprocessingItem(/*num_features=*/3,
+                                                    /*num_copies=*/4);
+  CommonSubgraphElimination optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Two constants, and a placeholder, a sum and one chain per feature.
+  EXPECT_EQ(output.node_size(), 2 + 3 * 4);
+  NodeMap node_map(&output);
+  for (int i = 0; i < 3; ++i) {
+    const NodeDef* sum = node_map.GetNode(absl::StrCat("feature", i, "/sum"));
+    ASSERT_NE(sum, nullptr);
+    ASSERT_EQ(sum->input_size(), 4);
+    for (const string& input : sum->input()) {
+      EXPECT_EQ(input, sum->input(0));
+    }
+  }
+}
+
+static void BM_DedupComputations(::testing::benchmark::State& state) {
+  const int num_features = state.range(0);
+  const GrapplerItem item = CreatePreprocessingItem(num_features,
+                                                    /*num_copies=*/8);
+  for (auto s : state) {
+    CommonSubgraphElimination optimizer;
+    GraphDef output;
+    Status status = optimizer.Optimize(nullptr, item, &output);
+    CHECK(status.ok()) << status;
+  }
+  state.SetItemsProcessed(state.iterations() * item.graph.node_size());
+}
+BENCHMARK(BM_DedupComputations)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
 }  // namespace grappler
 }  // namespace tensorflow
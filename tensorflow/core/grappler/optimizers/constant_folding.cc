@@ -19,10 +19,13 @@ limitations under the License.
 
 #include <cmath>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/op.h"
@@ -184,6 +187,42 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
   }
 }
 
+// Returns the names of the nodes of `graph` that were added or modified since
+// `previous_graph`.
+absl::flat_hash_set<string> MutatedNodes(const GraphDef& previous_graph,
+                                         const GraphDef& graph) {
+  absl::flat_hash_map<absl::string_view, const NodeDef*> previous_nodes;
+  for (const NodeDef& node : previous_graph.node()) {
+    previous_nodes.emplace(node.name(), &node);
+  }
+  const auto same_node = [](const NodeDef& a, const NodeDef& b) {
+    if (a.op() != b.op() || a.device() != b.device() ||
+        a.input_size() != b.input_size() || a.attr_size() != b.attr_size()) {
+      return false;
+    }
+    for (int i = 0; i < a.input_size(); ++i) {
+      if (a.input(i) != b.input(i)) return false;
+    }
+    for (const auto& attr : a.attr()) {
+      auto it = b.attr().find(attr.first);
+      if (it == b.attr().end() ||
+          !AreAttrValuesEqual(attr.second, it->second,
+                              /*allow_false_negatives=*/true)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  absl::flat_hash_set<string> mutated_nodes;
+  for (const NodeDef& node : graph.node()) {
+    auto it = previous_nodes.find(node.name());
+    if (it == previous_nodes.end() || !same_node(*it->second, node)) {
+      mutated_nodes.insert(node.name());
+    }
+  }
+  return mutated_nodes;
+}
+
 }  // namespace
 
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
@@ -4064,11 +4103,23 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
   *optimized_graph = GraphDef();
   item_to_optimize.graph.Swap(optimized_graph);
   int64_t node_count;
+  bool first_pass = true;
 
   do {
     GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
     graph_modified_ = false;
     item_to_optimize.graph.Swap(optimized_graph);
+    // Only re-infer the properties of the nodes modified by the previous pass,
+    // which is now in `optimized_graph`.
+    if (!first_pass && properties.has_properties()) {
+      if (!properties
+               .UpdateStatically(
+                   MutatedNodes(*optimized_graph, item_to_optimize.graph))
+               .ok()) {
+        properties.Clear();
+      }
+    }
+    first_pass = false;
     node_count = item_to_optimize.graph.node_size();
     TF_RETURN_IF_ERROR(RunOptimizationPass(cluster, &item_to_optimize,
                                            &properties, optimized_graph));
@@ -0,0 +1,385 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDataset[] = "ParallelMapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+constexpr char kOutputShapes[] = "output_shapes";
+constexpr char kOutputTypes[] = "output_types";
+constexpr char kShapeAttr[] = "_output_shapes";
+
+// Element-wise ops with a single input.
+const auto* kUnaryOps = new absl::flat_hash_set<std::string>{
+    "Abs",        "Acos",       "Acosh",      "Asin",       "Asinh",
+    "Atan",       "Atanh",      "Cast",       "Ceil",       "Cos",
+    "Cosh",       "Digamma",    "Elu",        "Erf",        "Erfc",
+    "Exp",        "Expm1",      "Floor",      "Identity",   "Inv",
+    "IsFinite",   "IsInf",      "IsNan",      "Lgamma",     "Log",
+    "Log1p",      "LogicalNot", "Neg",        "Reciprocal", "Relu",
+    "Relu6",      "Rint",       "Round",      "Rsqrt",      "Selu",
+    "Sigmoid",    "Sign",       "Sin",        "Sinh",       "Softplus",
+    "Softsign",   "Sqrt",       "Square",     "Tan",        "Tanh"};
+
+// Element-wise ops with two inputs that are broadcast against each other.
+// `Equal` and `NotEqual` are not included, because they return a scalar for
+// inputs of incompatible shapes when `incompatible_shape_error` is false.
+const auto* kBinaryOps = new absl::flat_hash_set<std::string>{
+    "Add",               "AddV2",             "Atan2",
+    "BitwiseAnd",        "BitwiseOr",         "BitwiseXor",
+    "Div",               "DivNoNan",          "FloorDiv",
+    "FloorMod",          "Greater",           "GreaterEqual",
+    "Less",              "LessEqual",         "LogicalAnd",
+    "LogicalOr",         "Maximum",           "Minimum",
+    "Mod",               "Mul",               "MulNoNan",
+    "Pow",               "RealDiv",           "SquaredDifference",
+    "Sub",               "TruncateDiv",       "TruncateMod",
+    "Xdivy",             "Xlogy"};
+
+bool IsMap(const NodeDef& node) {
+  return node.op() == kMapDataset || node.op() == kParallelMapDataset ||
+         node.op() == kParallelMapDatasetV2;
+}
+
+// Returns the number of inputs of `map_node` captured by its function.
+int NumCapturedInputs(const NodeDef& map_node) {
+  // Parallel maps have a trailing `num_parallel_calls` input.
+  return map_node.input_size() - (map_node.op() == kMapDataset ? 1 : 2);
+}
+
+// A value computed by a map function.
+struct ValueInfo {
+  // Whether the value depends on the function arguments, and thus has a
+  // leading batch dimension in the vectorized function.
+  bool batched = false;
+  // Rank of the value for a single element, or -1 if unknown.
+  int rank = -1;
+};
+
+// Returns the name of the argument or node that produces the value referenced
+// by the function node input `input`.
+Status GetInputSource(const std::string& input, std::string* source) {
+  if (absl::StartsWith(input, "^")) {
+    return errors::Unimplemented("Control input ", input,
+                                 " is not supported");
+  }
+  *source = std::string(input.substr(0, input.find(':')));
+  return OkStatus();
+}
+
+Status GetInputInfo(
+    const absl::flat_hash_map<std::string, ValueInfo>& values,
+    const std::string& input, const ValueInfo** info) {
+  std::string source;
+  TF_RETURN_IF_ERROR(GetInputSource(input, &source));
+  *info = gtl::FindOrNull(values, source);
+  return OkStatus();
+}
+
+// Computes the value produced by the function node `node`, or returns an error
+// if `node` may not be vectorized. Sets `*ready` to false if some of the
+// inputs of `node` have not been visited yet.
+Status VisitNode(const NodeDef& node,
+                 const absl::flat_hash_map<std::string, ValueInfo>& values,
+                 bool* ready, ValueInfo* result) {
+  *ready = true;
+  if (node.op() == "Const") {
+    if (node.input_size() != 0) {
+      return errors::Unimplemented("Control input ", node.input(0),
+                                   " is not supported");
+    }
+    const AttrValue* value = gtl::FindOrNull(node.attr(), "value");
+    if (value == nullptr) {
+      return errors::InvalidArgument("Const node ", node.name(),
+                                     " has no value");
+    }
+    result->batched = false;
+    result->rank = value->tensor().tensor_shape().dim_size();
+    return OkStatus();
+  }
+  const bool unary = kUnaryOps->contains(node.op());
+  if (!unary && !kBinaryOps->contains(node.op())) {
+    return errors::Unimplemented("Op ", node.op(), " of node ", node.name(),
+                                 " is not vectorized");
+  }
+  if (node.input_size() != (unary ? 1 : 2)) {
+    return errors::Unimplemented("Node ", node.name(), " has ",
+                                 node.input_size(), " inputs");
+  }
+  std::vector<const ValueInfo*> inputs(node.input_size());
+  for (int i = 0; i < node.input_size(); ++i) {
+    TF_RETURN_IF_ERROR(GetInputInfo(values, node.input(i), &inputs[i]));
+    if (inputs[i] == nullptr) {
+      *ready = false;
+      return OkStatus();
+    }
+  }
+  if (unary) {
+    *result = *inputs[0];
+    return OkStatus();
+  }
+  const ValueInfo& x = *inputs[0];
+  const ValueInfo& y = *inputs[1];
+  if (x.batched && y.batched) {
+    // The batch dimensions are only aligned if the ranks are equal.
+    if (x.rank < 0 || x.rank != y.rank) {
+      return errors::Unimplemented("Inputs of node ", node.name(),
+                                   " have different ranks");
+    }
+    *result = x;
+  } else if (x.batched || y.batched) {
+    // An unbatched value is only broadcast along the element dimensions if it
+    // does not have more dimensions than the batched value.
+    const ValueInfo& batched = x.batched ? x : y;
+    const ValueInfo& unbatched = x.batched ? y : x;
+    if (batched.rank < 0 || unbatched.rank < 0 ||
+        unbatched.rank > batched.rank) {
+      return errors::Unimplemented("Unbatched input of node ", node.name(),
+                                   " would be broadcast along the batch "
+                                   "dimension");
+    }
+    *result = batched;
+  } else {
+    result->batched = false;
+    result->rank =
+        x.rank < 0 || y.rank < 0 ? -1 : std::max(x.rank, y.rank);
+  }
+  return OkStatus();
+}
+
+// Returns an error if `function` may not be vectorized, given the shapes of the
+// elements of its arguments.
+Status CheckVectorizable(const FunctionDef& function,
+                         const std::vector<PartialTensorShape>& arg_shapes) {
+  const OpDef& signature = function.signature();
+  if (signature.is_stateful()) {
+    return errors::Unimplemented("Function is stateful");
+  }
+  if (signature.input_arg_size() != arg_shapes.size()) {
+    return errors::InvalidArgument("Function has ", signature.input_arg_size(),
+                                   " arguments, but the input dataset has ",
+                                   arg_shapes.size(), " components");
+  }
+  absl::flat_hash_map<std::string, ValueInfo> values;
+  for (int i = 0; i < signature.input_arg_size(); ++i) {
+    // With partially defined shapes, the inputs in a batch could have
+    // different shapes although the outputs have the same shapes.
+    if (!arg_shapes[i].IsFullyDefined()) {
+      return errors::Unimplemented("Shape ", arg_shapes[i].DebugString(),
+                                   " of argument ", i,
+                                   " is not fully defined");
+    }
+    values[signature.input_arg(i).name()] = {/*batched=*/true,
+                                             arg_shapes[i].dims()};
+  }
+
+  // Nodes of a function are not necessarily in topological order.
+  std::vector<const NodeDef*> pending;
+  for (const NodeDef& node : function.node_def()) pending.push_back(&node);
+  while (!pending.empty()) {
+    std::vector<const NodeDef*> not_ready;
+    for (const NodeDef* node : pending) {
+      bool ready;
+      ValueInfo info;
+      TF_RETURN_IF_ERROR(VisitNode(*node, values, &ready, &info));
+      if (ready) {
+        values[node->name()] = info;
+      } else {
+        not_ready.push_back(node);
+      }
+    }
+    if (not_ready.size() == pending.size()) {
+      return errors::InvalidArgument("Function has a cycle or an undefined "
+                                     "input");
+    }
+    pending = std::move(not_ready);
+  }
+
+  for (const auto& output : signature.output_arg()) {
+    const std::string* ret = gtl::FindOrNull(function.ret(), output.name());
+    if (ret == nullptr) {
+      return errors::InvalidArgument("Output ", output.name(),
+                                     " is not defined");
+    }
+    const ValueInfo* info;
+    TF_RETURN_IF_ERROR(GetInputInfo(values, *ret, &info));
+    if (info == nullptr || !info->batched) {
+      return errors::Unimplemented("Output ", output.name(),
+                                   " does not depend on the arguments");
+    }
+  }
+  return OkStatus();
+}
+
+// Returns a copy of `function` without the shapes recorded for its arguments
+// and nodes, which do not account for the batch dimension.
+FunctionDef MakeVectorizedFunction(const FunctionDef& function,
+                                   const FunctionDefLibrary& library) {
+  FunctionDef vectorized = function;
+  graph_utils::SetUniqueGraphFunctionName(
+      strings::StrCat("vectorized_", function.signature().name()), &library,
+      &vectorized);
+  for (auto& arg_attr : *vectorized.mutable_arg_attr()) {
+    arg_attr.second.mutable_attr()->erase(kShapeAttr);
+  }
+  for (NodeDef& node : *vectorized.mutable_node_def()) {
+    node.mutable_attr()->erase(kShapeAttr);
+  }
+  return vectorized;
+}
+
+// Returns the element shapes of the batch dataset whose elements are batches
+// of `shapes`, with the batch dimension of `batch_node`.
+AttrValue MakeBatchedShapes(const std::vector<PartialTensorShape>& shapes,
+                            const NodeDef& batch_node) {
+  int64_t batch_dim = -1;
+  const AttrValue& batch_shapes = batch_node.attr().at(kOutputShapes);
+  if (batch_shapes.list().shape_size() > 0 &&
+      batch_shapes.list().shape(0).dim_size() > 0) {
+    batch_dim = batch_shapes.list().shape(0).dim(0).size();
+  }
+  AttrValue result;
+  for (const PartialTensorShape& shape : shapes) {
+    PartialTensorShape({batch_dim})
+        .Concatenate(shape)
+        .AsProto(result.mutable_list()->add_shape());
+  }
+  return result;
+}
+
+}  // namespace
+
+Status MapVectorization::OptimizeAndCollectStats(Cluster* cluster,
+                                                 const GrapplerItem& item,
+                                                 GraphDef* output,
+                                                 OptimizationStats* stats) {
+  vectorized_functions_.clear();
+  *output = item.graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != "BatchDataset" && node.op() != "BatchDatasetV2") {
+      continue;
+    }
+    const NodeDef& batch_node = node;
+    NodeDef* map_node = graph_utils::GetInputNode(batch_node, graph);
+    if (map_node == nullptr || !IsMap(*map_node)) continue;
+    const std::string& function_name = map_node->attr().at("f").func().name();
+
+    const NodeDef* input_node = nullptr;
+    std::vector<PartialTensorShape> input_shapes;
+    auto vectorizable = [&]() -> Status {
+      if (NumCapturedInputs(*map_node) != 0) {
+        return errors::Unimplemented("Function has captured inputs");
+      }
+      if (graph.GetFanouts(*map_node, /*include_controlling_fanouts=*/true)
+              .size() != 1) {
+        return errors::Unimplemented("Map dataset has other consumers");
+      }
+      input_node = graph_utils::GetInputNode(*map_node, graph);
+      if (input_node == nullptr ||
+          !input_node->attr().contains(kOutputShapes) ||
+          !input_node->attr().contains(kOutputTypes) ||
+          !batch_node.attr().contains(kOutputShapes)) {
+        return errors::Unimplemented("Element shapes are unknown");
+      }
+      const FunctionDef* function = function_library.Find(function_name);
+      if (function == nullptr) {
+        return errors::NotFound("Function is not in the library");
+      }
+      for (const auto& shape :
+           input_node->attr().at(kOutputShapes).list().shape()) {
+        input_shapes.emplace_back(shape);
+      }
+      return CheckVectorizable(*function, input_shapes);
+    };
+    Status status = vectorizable();
+    if (!status.ok()) {
+      VLOG(1) << "Not vectorizing map function " << function_name << ": "
+              << status.error_message();
+      continue;
+    }
+
+    NodeDef new_batch_node = batch_node;
+    graph_utils::SetUniqueGraphNodeName("vectorized_batch", graph.graph(),
+                                        &new_batch_node);
+    new_batch_node.set_input(0, map_node->input(0));
+    (*new_batch_node.mutable_attr())[kOutputShapes] =
+        MakeBatchedShapes(input_shapes, batch_node);
+    graph_utils::CopyAttribute(kOutputTypes, *input_node, &new_batch_node);
+    const NodeDef* batch = graph.AddNode(std::move(new_batch_node));
+
+    FunctionDef vectorized = MakeVectorizedFunction(
+        *function_library.Find(function_name), output->library());
+    FunctionDef* vectorized_function =
+        output->mutable_library()->add_function();
+    *vectorized_function = std::move(vectorized);
+    TF_RETURN_IF_ERROR(function_library.AddFunctionDef(*vectorized_function));
+
+    NodeDef new_map_node = *map_node;
+    graph_utils::SetUniqueGraphNodeName("vectorized_map", graph.graph(),
+                                        &new_map_node);
+    new_map_node.set_input(0, batch->name());
+    (*new_map_node.mutable_attr())["f"].mutable_func()->set_name(
+        vectorized_function->signature().name());
+    graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_map_node);
+    const NodeDef* map = graph.AddNode(std::move(new_map_node));
+    TF_RETURN_IF_ERROR(graph.UpdateFanouts(batch_node.name(), map->name()));
+
+    VLOG(1) << "Vectorized map function " << function_name << " as "
+            << vectorized_function->signature().name();
+    vectorized_functions_.push_back(function_name);
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // namespace grappler
+}  // namespace tensorflow
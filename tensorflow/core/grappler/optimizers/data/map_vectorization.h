@@ -0,0 +1,68 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_MAP_VECTORIZATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_MAP_VECTORIZATION_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/grappler/optimizers/data/optimizer_base.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Rewrites `map(f).batch(n)` into `batch(n).map(vectorized_f)`, so that `f` is
+// invoked once per batch rather than once per element.
+//
+// Only map functions without captured inputs that consist of element-wise ops
+// whose kernels accept a leading batch dimension are vectorized, in which case
+// `vectorized_f` is `f` with the shapes of its arguments left unspecified. A
+// map function is left unchanged if any of its ops may not be vectorized, if
+// the shapes of its inputs are not fully defined, since the batch of inputs
+// could otherwise fail although the batch of outputs would succeed, or if
+// broadcasting against a constant would no longer align with the element
+// dimensions.
+class MapVectorization : public TFDataOptimizerBase {
+ public:
+  MapVectorization() = default;
+  ~MapVectorization() override = default;
+
+  string name() const override { return "map_vectorization"; };
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Init(
+      const tensorflow::RewriterConfig_CustomGraphOptimizer* config) override {
+    return OkStatus();
+  }
+
+  Status OptimizeAndCollectStats(Cluster* cluster, const GrapplerItem& item,
+                                 GraphDef* output,
+                                 OptimizationStats* stats) override;
+
+  // Names of the map functions vectorized by the last call to `Optimize()`.
+  const std::vector<std::string>& vectorized_functions() const {
+    return vectorized_functions_;
+  }
+
+ private:
+  std::vector<std::string> vectorized_functions_;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_MAP_VECTORIZATION_H_
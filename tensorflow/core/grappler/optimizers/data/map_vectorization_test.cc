@@ -0,0 +1,218 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+NodeDef MakeRangeNode(StringPiece name, const PartialTensorShape& shape) {
+  return NDef(name, "RangeDataset", {"start", "stop", "step"},
+              {{"output_shapes", gtl::ArraySlice<PartialTensorShape>{shape}},
+               {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}});
+}
+
+NodeDef MakeMapNode(StringPiece name, StringPiece input_node_name,
+                    StringPiece function_name) {
+  return NDef(name, "MapDataset", {string(input_node_name)},
+              {{"f", FunctionDefHelper::FunctionRef(string(function_name),
+                                                    {{"T", DT_INT64}})},
+               {"Targuments", gtl::ArraySlice<DataType>{}},
+               {"output_shapes", gtl::ArraySlice<TensorShape>{{}}},
+               {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}});
+}
+
+NodeDef MakeBatchNode(StringPiece name, StringPiece input_node_name) {
+  return NDef(name, "BatchDatasetV2",
+              {string(input_node_name), "batch_size", "drop_remainder"},
+              {{"parallel_copy", false},
+               {"output_shapes",
+                gtl::ArraySlice<PartialTensorShape>{PartialTensorShape({-1})}},
+               {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}});
+}
+
+GrapplerItem MakeItem(const std::vector<NodeDef>& dataset_nodes,
+                      const std::vector<FunctionDef>& functions) {
+  std::vector<NodeDef> nodes = {
+      NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+      NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+      NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+      NDef("batch_size", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+      NDef("drop_remainder", "Const", {},
+           {{"value", false}, {"dtype", DT_BOOL}})};
+  nodes.insert(nodes.end(), dataset_nodes.begin(), dataset_nodes.end());
+  GrapplerItem item;
+  item.graph = test::function::GDef(nodes, functions);
+  return item;
+}
+
+TEST(MapVectorizationTest, VectorizesMapFollowedByBatch) {
+  GrapplerItem item = MakeItem(
+      {MakeRangeNode("range", PartialTensorShape({})),
+       MakeMapNode("map", "range", "XTimesTwo"),
+       MakeBatchNode("batch", "map"),
+       NDef("sink", "Identity", {"batch"}, {})},
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), ElementsAre("XTimesTwo"));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+
+  const NodeDef& sink =
+      output.node(graph_utils::FindGraphNodeWithName("sink", output));
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithName(sink.input(0), output));
+  EXPECT_EQ(map_node.op(), "MapDataset");
+  const std::string& function_name = map_node.attr().at("f").func().name();
+  EXPECT_NE(function_name, "XTimesTwo");
+  EXPECT_GE(graph_utils::FindGraphFunctionWithName(function_name,
+                                                   output.library()),
+            0);
+  EXPECT_EQ(map_node.attr().at("output_shapes").list().shape(0).dim(0).size(),
+            -1);
+
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithName(map_node.input(0), output));
+  EXPECT_EQ(batch_node.op(), "BatchDatasetV2");
+  EXPECT_EQ(batch_node.input(0), "range");
+  EXPECT_EQ(batch_node.input(1), "batch_size");
+  EXPECT_EQ(batch_node.input(2), "drop_remainder");
+  EXPECT_EQ(
+      PartialTensorShape(batch_node.attr().at("output_shapes").list().shape(0))
+          .DebugString(),
+      "[?]");
+}
+
+TEST(MapVectorizationTest, PreservesParallelism) {
+  GrapplerItem item = MakeItem(
+      {MakeRangeNode("range", PartialTensorShape({3})),
+       NDef("num_parallel_calls", "Const", {},
+            {{"value", 2}, {"dtype", DT_INT64}}),
+       NDef("map", "ParallelMapDatasetV2", {"range", "num_parallel_calls"},
+            {{"f", FunctionDefHelper::FunctionRef("XTimesTwo",
+                                                  {{"T", DT_INT64}})},
+             {"Targuments", gtl::ArraySlice<DataType>{}},
+             {"output_shapes", gtl::ArraySlice<TensorShape>{{3}}},
+             {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}}),
+       MakeBatchNode("batch", "map")},
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), ElementsAre("XTimesTwo"));
+  const NodeDef& map_node = output.node(
+      graph_utils::FindGraphNodeWithOp("ParallelMapDatasetV2", output));
+  EXPECT_EQ(map_node.input(1), "num_parallel_calls");
+  const NodeDef& batch_node = output.node(
+      graph_utils::FindGraphNodeWithName(map_node.input(0), output));
+  EXPECT_EQ(
+      PartialTensorShape(batch_node.attr().at("output_shapes").list().shape(0))
+          .DebugString(),
+      "[?,3]");
+}
+
+TEST(MapVectorizationTest, DoesNotVectorizeUnsupportedOps) {
+  // `XTimesFour` calls the `XTimesTwo` function.
+  GrapplerItem item = MakeItem(
+      {MakeRangeNode("range", PartialTensorShape({})),
+       MakeMapNode("map", "range", "XTimesFour"),
+       MakeBatchNode("batch", "map")},
+      {test::function::XTimesTwo(), test::function::XTimesFour()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), IsEmpty());
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, DoesNotVectorizePartiallyDefinedShapes) {
+  GrapplerItem item = MakeItem(
+      {MakeRangeNode("range", PartialTensorShape({-1})),
+       MakeMapNode("map", "range", "XTimesTwo"),
+       MakeBatchNode("batch", "map")},
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), IsEmpty());
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+}
+
+TEST(MapVectorizationTest, DoesNotBroadcastAlongBatchDimension) {
+  // Adding a matrix to a scalar element yields a matrix per element, which
+  // would be misaligned with a batch of scalars.
+  FunctionDef add_matrix = FunctionDefHelper::Define(
+      "AddMatrix", {"x: int64"}, {"y: int64"}, {},
+      {{{"m"},
+        "Const",
+        {},
+        {{"value", test::AsTensor<int64_t>({1, 2, 3, 4}, {2, 2})},
+         {"dtype", DT_INT64}}},
+       {{"y"}, "AddV2", {"x", "m"}, {{"T", DT_INT64}}}});
+  GrapplerItem item = MakeItem({MakeRangeNode("range", PartialTensorShape({})),
+                                MakeMapNode("map", "range", "AddMatrix"),
+                                MakeBatchNode("batch", "map")},
+                               {add_matrix});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), IsEmpty());
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+}
+
+TEST(MapVectorizationTest, DoesNotVectorizeCapturedInputs) {
+  GrapplerItem item = MakeItem(
+      {MakeRangeNode("range", PartialTensorShape({})),
+       NDef("captured", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("map", "MapDataset", {"range", "captured"},
+            {{"f", FunctionDefHelper::FunctionRef("XAddY", {{"T", DT_INT64}})},
+             {"Targuments", gtl::ArraySlice<DataType>{DT_INT64}},
+             {"output_shapes", gtl::ArraySlice<TensorShape>{{}}},
+             {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}}),
+       MakeBatchNode("batch", "map")},
+      {test::function::XAddY()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_THAT(optimizer.vectorized_functions(), IsEmpty());
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/data/meta_optimizer.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -22,9 +24,13 @@ limitations under the License.
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
 #include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -36,7 +42,7 @@ using ConfigMap =
     std::map<string, tensorflow::RewriterConfig_CustomGraphOptimizer>;
 
 // tf.data optimizations, in the order we want to perform them.
-constexpr std::array<const char*, 19> kTFDataOptimizations = {
+constexpr std::array<const char*, 20> kTFDataOptimizations = {
     "noop_elimination",
     "disable_intra_op_parallelism",
     "use_private_thread_pool",
@@ -45,6 +51,7 @@ constexpr std::array<const char*, 19> kTFDataOptimizations = {
     "filter_fusion",
     "map_and_filter_fusion",
     "map_parallelization",
+    "map_vectorization",
     "map_and_batch_fusion",
     "batch_parallelization",
     "filter_parallelization",
@@ -57,6 +64,31 @@ constexpr std::array<const char*, 19> kTFDataOptimizations = {
     "enable_gradient_descent",
     "make_deterministic"};
 
+// tf.data optimizations that only affect the performance of the input
+// pipeline, and not the elements it produces. With the
+// `choose_fastest_optimizations` config, the pipelines with and without these
+// optimizations are compared at runtime.
+constexpr std::array<const char*, 10> kChooseFastestOptimizations = {
+    "map_fusion",
+    "filter_fusion",
+    "map_and_filter_fusion",
+    "map_parallelization",
+    "map_vectorization",
+    "map_and_batch_fusion",
+    "batch_parallelization",
+    "filter_parallelization",
+    "parallel_batch",
+    "inject_prefetch"};
+
+constexpr char kOptimizerName[] = "tf_data_meta_optimizer";
+constexpr char kChooseFastestOptimizationsConfig[] =
+    "choose_fastest_optimizations";
+constexpr char kChooseFastestDatasetOp[] = "ChooseFastestDataset";
+constexpr char kOptimizedSuffix[] = "/choose_fastest_optimized";
+
+// Number of elements produced by both pipelines before the faster one is kept.
+constexpr int64_t kChooseFastestNumExperiments = 100;
+
 // Parses a list of string optimizer configurations into a map from
 // optimizer name -> rewriter config for that optimizer.
 Status ToConfigMap(
@@ -94,21 +126,119 @@ Status ToConfigMap(
   return OkStatus();
 }
 
+// Returns true if any node of `graph` or function of its library is stateful.
+bool IsGraphStateful(const GraphDef& graph) {
+  FunctionLibraryDefinition flib(OpRegistry::Global(), graph.library());
+  for (const NodeDef& node : graph.node()) {
+    if (function_utils::IsNodeStateful(flib, node)) return true;
+  }
+  for (const FunctionDef& function : graph.library().function()) {
+    if (function_utils::IsFunctionStateful(flib, function)) return true;
+  }
+  return false;
+}
+
+// Returns `input` with the name of the node it refers to replaced according
+// to `renamed_nodes`.
+string RenameInput(const string& input,
+                   const absl::flat_hash_map<string, string>& renamed_nodes) {
+  const bool is_control = absl::StartsWith(input, "^");
+  const size_t begin = is_control ? 1 : 0;
+  const size_t end = input.find(':');
+  const string node_name = input.substr(begin, end - begin);
+  const string* new_name = gtl::FindOrNull(renamed_nodes, node_name);
+  if (new_name == nullptr) return input;
+  return absl::StrCat(is_control ? "^" : "", *new_name,
+                      end == string::npos ? "" : input.substr(end));
+}
+
+// Adds the nodes of `optimized` other than `fetch_name` to `baseline` under
+// new names, and makes `fetch_name` consume a `ChooseFastestDataset` of the
+// pipeline it consumes in `baseline` and the one it consumes in `optimized`.
+// Returns false and leaves `baseline` unchanged if the two graphs cannot be
+// merged.
+bool MergeWithChooseFastest(const GraphDef& optimized,
+                            const string& fetch_name, GraphDef* baseline) {
+  // Functions are shared by name, so the libraries must agree.
+  for (const FunctionDef& function : optimized.library().function()) {
+    const int index = graph_utils::FindGraphFunctionWithName(
+        function.signature().name(), baseline->library());
+    if (index >= 0 &&
+        !FunctionDefsEqual(baseline->library().function(index), function)) {
+      return false;
+    }
+  }
+  const int baseline_fetch_index =
+      graph_utils::FindGraphNodeWithName(fetch_name, *baseline);
+  const int optimized_fetch_index =
+      graph_utils::FindGraphNodeWithName(fetch_name, optimized);
+  if (baseline_fetch_index < 0 || optimized_fetch_index < 0 ||
+      baseline->node(baseline_fetch_index).input_size() != 1 ||
+      optimized.node(optimized_fetch_index).input_size() != 1) {
+    return false;
+  }
+  const string baseline_input = baseline->node(baseline_fetch_index).input(0);
+  const int baseline_input_index = graph_utils::FindGraphNodeWithName(
+      baseline_input.substr(0, baseline_input.find(':')), *baseline);
+  if (baseline_input_index < 0) return false;
+  NodeDef choose_fastest_node;
+  choose_fastest_node.set_op(kChooseFastestDatasetOp);
+  if (!graph_utils::CopyShapesAndTypesAttrs(
+          baseline->node(baseline_input_index), &choose_fastest_node)) {
+    return false;
+  }
+
+  GraphDef merged = *baseline;
+  const int first_added_node = merged.node_size();
+  absl::flat_hash_map<string, string> renamed_nodes;
+  for (const NodeDef& node : optimized.node()) {
+    if (node.name() == fetch_name) continue;
+    NodeDef* added_node = merged.add_node();
+    *added_node = node;
+    graph_utils::SetUniqueGraphNodeName(
+        absl::StrCat(node.name(), kOptimizedSuffix), &merged, added_node);
+    renamed_nodes[node.name()] = added_node->name();
+  }
+  for (int i = first_added_node; i < merged.node_size(); ++i) {
+    NodeDef* node = merged.mutable_node(i);
+    for (int j = 0; j < node->input_size(); ++j) {
+      node->set_input(j, RenameInput(node->input(j), renamed_nodes));
+    }
+  }
+  for (const FunctionDef& function : optimized.library().function()) {
+    if (!graph_utils::ContainsGraphFunctionWithName(
+            function.signature().name(), merged.library())) {
+      *merged.mutable_library()->add_function() = function;
+    }
+  }
+
+  graph_utils::SetUniqueGraphNodeName(kChooseFastestDatasetOp, &merged,
+                                      &choose_fastest_node);
+  choose_fastest_node.add_input(baseline_input);
+  choose_fastest_node.add_input(RenameInput(
+      optimized.node(optimized_fetch_index).input(0), renamed_nodes));
+  (*choose_fastest_node.mutable_attr())["N"].set_i(2);
+  (*choose_fastest_node.mutable_attr())["num_experiments"].set_i(
+      kChooseFastestNumExperiments);
+  merged.mutable_node(baseline_fetch_index)
+      ->set_input(0, choose_fastest_node.name());
+  *merged.add_node() = std::move(choose_fastest_node);
+
+  baseline->Swap(&merged);
+  return true;
+}
+
 }  // namespace
 
 Status TFDataMetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                      GraphDef* output) {
   // Stores the optimized item so far.
   GrapplerItem optimized_item = item;
-
-  // Perform optimizations in a meaningful order.
-  for (const auto& optimization : kTFDataOptimizations) {
-    tensorflow::metrics::ScopedCounter<2> timings(
-        tensorflow::metrics::GetGraphOptimizationCounter(),
-        {"TFData", optimization});
-    Status status = ApplyOptimization(optimization, cluster, &optimized_item);
-    timings.ReportAndStop();
-    if (!status.ok()) return status;
+  TF_RETURN_IF_ERROR(ApplyOptimizations(
+      cluster, /*skipped_optimizations=*/{}, &optimized_item));
+  if (choose_fastest_optimizations_) {
+    TF_RETURN_IF_ERROR(
+        ChooseFastestOptimizations(cluster, item, &optimized_item));
   }
 
   // Store the final result of all the optimizations in `output`.
@@ -159,6 +289,22 @@ Status TFDataMetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   return OkStatus();
 }
 
+Status TFDataMetaOptimizer::ApplyOptimizations(
+    Cluster* cluster, const absl::flat_hash_set<string>& skipped_optimizations,
+    GrapplerItem* item) const {
+  // Perform optimizations in a meaningful order.
+  for (const auto& optimization : kTFDataOptimizations) {
+    if (skipped_optimizations.contains(optimization)) continue;
+    tensorflow::metrics::ScopedCounter<2> timings(
+        tensorflow::metrics::GetGraphOptimizationCounter(),
+        {"TFData", optimization});
+    Status status = ApplyOptimization(optimization, cluster, item);
+    timings.ReportAndStop();
+    if (!status.ok()) return status;
+  }
+  return OkStatus();
+}
+
 Status TFDataMetaOptimizer::ApplyOptimization(const string& name,
                                               Cluster* cluster,
                                               GrapplerItem* item) const {
@@ -185,6 +331,56 @@ Status TFDataMetaOptimizer::ApplyOptimization(const string& name,
   return status;
 }
 
+Status TFDataMetaOptimizer::ChooseFastestOptimizations(
+    Cluster* cluster, const GrapplerItem& item,
+    GrapplerItem* optimized_item) const {
+  absl::flat_hash_set<string> skipped_optimizations;
+  for (const auto& optimization : kChooseFastestOptimizations) {
+    if (enabled_optimizers_.contains(optimization)) {
+      skipped_optimizations.insert(optimization);
+    }
+  }
+  if (skipped_optimizations.empty() || item.fetch.size() != 1) {
+    return OkStatus();
+  }
+  {
+    MutableGraphView graph(&optimized_item->graph);
+    // Nested dataset functions are optimized as part of their pipeline.
+    if (graph_utils::IsItemDerivedFromFunctionDef(*optimized_item, graph)) {
+      return OkStatus();
+    }
+  }
+  // The pipelines are iterated independently while they are compared, so they
+  // must produce the same elements, and must not share state.
+  if (IsGraphStateful(item.graph)) {
+    VLOG(1) << "Not choosing the fastest optimizations of a stateful input "
+               "pipeline.";
+    return OkStatus();
+  }
+
+  GrapplerItem baseline_item = item;
+  TF_RETURN_IF_ERROR(
+      ApplyOptimizations(cluster, skipped_optimizations, &baseline_item));
+  string baseline_graph, optimized_graph;
+  if (!SerializeToStringDeterministic(baseline_item.graph, &baseline_graph) ||
+      !SerializeToStringDeterministic(optimized_item->graph,
+                                      &optimized_graph)) {
+    return errors::Internal("Failed to serialize the input pipeline.");
+  }
+  if (baseline_graph == optimized_graph) {
+    // The optimizations did not rewrite the pipeline.
+    return OkStatus();
+  }
+  if (!MergeWithChooseFastest(optimized_item->graph, item.fetch.at(0),
+                              &baseline_item.graph)) {
+    VLOG(1) << "Failed to merge the input pipelines with and without "
+               "optimizations, keeping the optimized pipeline.";
+    return OkStatus();
+  }
+  optimized_item->graph.Swap(&baseline_item.graph);
+  return OkStatus();
+}
+
 Status TFDataMetaOptimizer::Init(
     const tensorflow::RewriterConfig_CustomGraphOptimizer* config) {
   if (!config) return OkStatus();
@@ -194,6 +390,15 @@ Status TFDataMetaOptimizer::Init(
   ConfigMap optimizer_configs;
   TF_RETURN_IF_ERROR(ToConfigMap(config, &optimizer_configs));
 
+  // Configs of the meta optimizer itself use its name as optimizer name.
+  if (const auto* meta_config = gtl::FindOrNull(optimizer_configs,
+                                                kOptimizerName)) {
+    const auto* choose_fastest = gtl::FindOrNull(
+        meta_config->parameter_map(), kChooseFastestOptimizationsConfig);
+    choose_fastest_optimizations_ =
+        choose_fastest != nullptr && choose_fastest->s() == "true";
+  }
+
   for (const auto& optimizer_name : optimizers) {
     auto optimizer =
         CustomGraphOptimizerRegistry::CreateByNameOrNull(optimizer_name);
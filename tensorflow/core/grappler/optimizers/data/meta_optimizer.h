@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_DATA_META_OPTIMIZER_H_
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
 
 namespace tensorflow {
@@ -43,10 +44,31 @@ class TFDataMetaOptimizer : public CustomGraphOptimizer {
   absl::flat_hash_map<string, std::unique_ptr<GraphOptimizer>>
       enabled_optimizers_;
 
+  // If true, the input pipeline is rewritten into a `ChooseFastestDataset` of
+  // the pipelines with and without the optimizations that only affect
+  // performance, so that the faster one is kept at runtime.
+  bool choose_fastest_optimizations_ = false;
+
+  // Applies the enabled optimizations other than `skipped_optimizations` on
+  // `item`, in order, and stores the result in `item.graph`.
+  Status ApplyOptimizations(
+      Cluster* cluster,
+      const absl::flat_hash_set<string>& skipped_optimizations,
+      GrapplerItem* item) const;
+
   // Applies an optimization with the specified name on `item`, and stores
   // the result in `item.graph`
   Status ApplyOptimization(const string& name, Cluster* cluster,
                            GrapplerItem* item) const;
+
+  // Replaces the input pipeline of `optimized_item`, the result of applying
+  // all enabled optimizations on `item`, with a `ChooseFastestDataset` that
+  // picks between it and the pipeline without the optimizations that only
+  // affect performance. Leaves `optimized_item` unchanged if these
+  // optimizations did not rewrite the pipeline, or if the pipeline is stateful
+  // and the two pipelines could thus produce different elements.
+  Status ChooseFastestOptimizations(Cluster* cluster, const GrapplerItem& item,
+                                    GrapplerItem* optimized_item) const;
 };
 
 }  // namespace grappler
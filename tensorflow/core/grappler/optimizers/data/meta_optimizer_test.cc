@@ -0,0 +1,164 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/meta_optimizer.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_test_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+GrapplerItem MakeMapAndBatchItem(StringPiece function_name,
+                                 const FunctionDef& function) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT64}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT64}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT64}}),
+       NDef("range", "RangeDataset", {"start", "stop", "step"},
+            {{"output_shapes", gtl::ArraySlice<TensorShape>{{}}},
+             {"output_types", gtl::ArraySlice<DataType>{DT_INT64}}}),
+       graph_tests_utils::MakeMapNode("map", "range", function_name),
+       NDef("batch_size", "Const", {}, {{"value", 5}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       graph_tests_utils::MakeBatchV2Node("batch", "map", "batch_size",
+                                          "drop_remainder",
+                                          /*parallel_copy=*/false),
+       NDef("Sink", "Identity", {"batch"}, {})},
+      {function});
+  item.fetch.push_back("Sink");
+  return item;
+}
+
+RewriterConfig_CustomGraphOptimizer MakeConfig(
+    const std::vector<std::string>& optimizers,
+    const std::vector<std::string>& optimizer_configs) {
+  RewriterConfig_CustomGraphOptimizer config;
+  auto& parameter_map = *config.mutable_parameter_map();
+  for (const auto& optimizer : optimizers) {
+    parameter_map["optimizers"].mutable_list()->add_s(optimizer);
+  }
+  for (const auto& optimizer_config : optimizer_configs) {
+    parameter_map["optimizer_configs"].mutable_list()->add_s(optimizer_config);
+  }
+  return config;
+}
+
+TEST(TFDataMetaOptimizerTest, AppliesOptimizations) {
+  GrapplerItem item =
+      MakeMapAndBatchItem("XTimesTwo", test::function::XTimesTwo());
+  TFDataMetaOptimizer optimizer;
+  RewriterConfig_CustomGraphOptimizer config =
+      MakeConfig({"map_and_batch_fusion"}, {});
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsNodeWithOp("ChooseFastestDataset", output));
+  const NodeDef& sink =
+      output.node(graph_utils::FindGraphNodeWithName("Sink", output));
+  EXPECT_EQ(
+      output.node(graph_utils::FindGraphNodeWithName(sink.input(0), output))
+          .op(),
+      "MapAndBatchDataset");
+}
+
+TEST(TFDataMetaOptimizerTest, ChoosesFastestOptimizations) {
+  GrapplerItem item =
+      MakeMapAndBatchItem("XTimesTwo", test::function::XTimesTwo());
+  TFDataMetaOptimizer optimizer;
+  RewriterConfig_CustomGraphOptimizer config = MakeConfig(
+      {"map_and_batch_fusion"},
+      {"tf_data_meta_optimizer:choose_fastest_optimizations:true"});
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef& sink =
+      output.node(graph_utils::FindGraphNodeWithName("Sink", output));
+  const NodeDef& choose_fastest =
+      output.node(graph_utils::FindGraphNodeWithName(sink.input(0), output));
+  EXPECT_EQ(choose_fastest.op(), "ChooseFastestDataset");
+  EXPECT_EQ(choose_fastest.attr().at("N").i(), 2);
+  EXPECT_GT(choose_fastest.attr().at("num_experiments").i(), 0);
+  EXPECT_EQ(choose_fastest.attr().at("output_types").list().type(0),
+            DT_INT64);
+  ASSERT_EQ(choose_fastest.input_size(), 2);
+
+  // The first input is the unoptimized pipeline.
+  EXPECT_EQ(choose_fastest.input(0), "batch");
+  const NodeDef& map =
+      output.node(graph_utils::FindGraphNodeWithName("map", output));
+  EXPECT_EQ(map.input(0), "range");
+
+  // The second input is the optimized pipeline, which has its own nodes.
+  const NodeDef& map_and_batch = output.node(
+      graph_utils::FindGraphNodeWithName(choose_fastest.input(1), output));
+  EXPECT_EQ(map_and_batch.op(), "MapAndBatchDataset");
+  EXPECT_NE(map_and_batch.input(0), "range");
+  const NodeDef& optimized_range = output.node(
+      graph_utils::FindGraphNodeWithName(map_and_batch.input(0), output));
+  EXPECT_EQ(optimized_range.op(), "RangeDataset");
+  EXPECT_NE(optimized_range.input(0), "start");
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName(optimized_range.input(0),
+                                                     output));
+}
+
+TEST(TFDataMetaOptimizerTest, DoesNotChooseFastestForStatefulPipelines) {
+  GrapplerItem item =
+      MakeMapAndBatchItem("RandomUniform", test::function::RandomUniform());
+  TFDataMetaOptimizer optimizer;
+  RewriterConfig_CustomGraphOptimizer config = MakeConfig(
+      {"map_and_batch_fusion"},
+      {"tf_data_meta_optimizer:choose_fastest_optimizations:true"});
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsNodeWithOp("ChooseFastestDataset", output));
+  EXPECT_TRUE(graph_utils::ContainsNodeWithOp("MapAndBatchDataset", output));
+}
+
+TEST(TFDataMetaOptimizerTest, DoesNotChooseFastestWithoutRewrites) {
+  GrapplerItem item =
+      MakeMapAndBatchItem("XTimesTwo", test::function::XTimesTwo());
+  TFDataMetaOptimizer optimizer;
+  RewriterConfig_CustomGraphOptimizer config = MakeConfig(
+      {"map_fusion"},
+      {"tf_data_meta_optimizer:choose_fastest_optimizations:true"});
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsNodeWithOp("ChooseFastestDataset", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
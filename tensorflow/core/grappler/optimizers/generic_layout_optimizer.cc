@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer.h"
 #include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_transposer_factory.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -406,7 +407,7 @@ Status EraseOutputShapeAttrs(TransposeContext* context) {
 // When there is a GPU, the computation graph is converted to NCHW format.
 // When there is only CPU, there will be no conversion by default, unless user
 // chose to convert the graph to a desired format. Currently, NCHW -> NHWC
-// format conversion is available on CPU.
+// and NHWC -> blocked NCHWc format conversions are available on CPU.
 Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
                                         const GrapplerItem& item,
                                         GraphDef* output) {
@@ -439,6 +440,9 @@ Status GenericLayoutOptimizer::Optimize(Cluster* cluster,
     context.AssignDeviceAndDataFormats(kGPU, src_dst_formats.first,
                                        src_dst_formats.second);
   } else {
+    if (cpu_layout_conversion_ == RewriterConfig::NHWC_TO_NCHWC) {
+      return ConvertToNchwcLayout(item, NchwcBlockSize(), output);
+    }
     TF_RETURN_IF_ERROR(TransposeContext::InitializeTransposeContext(
         /*assume_valid_feeds=*/is_aggressive, item, cluster, &context));
     switch (cpu_layout_conversion_) {
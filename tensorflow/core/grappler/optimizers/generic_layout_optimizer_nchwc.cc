@@ -0,0 +1,587 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/graph_view.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kNchwcConv2D[] = "_NchwcConv2D";
+constexpr char kNchwcFilter[] = "_NchwcFilter";
+constexpr char kNchwcPool[] = "_NchwcPool";
+constexpr char kNchwcToNhwc[] = "_NchwcToNhwc";
+constexpr char kNhwcToNchwc[] = "_NhwcToNchwc";
+constexpr char kOutputShapesAttr[] = "_output_shapes";
+
+// How a node is rewritten to consume and produce tensors in NCHWc.
+enum class NchwcKind {
+  kNone,
+  kConv,
+  kPool,
+  kBiasAdd,
+  kBatchNorm,
+  kUnary,
+  kBinary,
+};
+
+struct NchwcNode {
+  NchwcKind kind = NchwcKind::kNone;
+  // Number of channels of the output in NHWC.
+  int64_t channels = 0;
+  // For a convolution, the BiasAdd and the activation folded into the
+  // _NchwcConv2D, or -1.
+  int bias_add = -1;
+  int activation = -1;
+  // For a folded BiasAdd or activation, the convolution.
+  int folded_into = -1;
+};
+
+// Returns the name of a node added for the node `name`.
+string NchwcNodeName(absl::string_view name, absl::string_view suffix) {
+  return absl::StrCat(name, "/nchwc_", suffix);
+}
+
+bool IsUnaryNchwcOp(const NodeDef& node) {
+  return IsRelu(node) || IsRelu6(node) || IsElu(node) || node.op() == "Selu" ||
+         IsLeakyRelu(node) || IsTanh(node) || IsSigmoid(node);
+}
+
+bool IsBinaryNchwcOp(const NodeDef& node) {
+  return IsAdd(node) || IsSub(node) || IsMul(node) || IsMaximum(node) ||
+         IsMinimum(node);
+}
+
+bool HasNhwcDataFormat(const NodeDef& node) {
+  const AttrValue* data_format = AttrSlice(node).Find("data_format");
+  return data_format == nullptr || data_format->s() == "NHWC";
+}
+
+// Returns true if the attribute `name` of `node` is of the form
+// [1, rows, cols, 1].
+bool HasNhwcWindowAttr(const NodeDef& node, const string& name) {
+  const AttrValue* attr = AttrSlice(node).Find(name);
+  if (attr == nullptr) return false;
+  const auto& list = attr->list().i();
+  return list.size() == 4 && list[0] == 1 && list[3] == 1 && list[1] >= 1 &&
+         list[2] >= 1;
+}
+
+bool HasValidPadding(const NodeDef& node) {
+  const AttrValue* padding = AttrSlice(node).Find("padding");
+  return padding != nullptr &&
+         (padding->s() == "SAME" || padding->s() == "VALID");
+}
+
+bool HasFloatType(const NodeDef& node) {
+  const AttrValue* type = AttrSlice(node).Find("T");
+  return type != nullptr && type->type() == DT_FLOAT;
+}
+
+// Returns the number of channels of a 4-D NHWC shape, or -1 if it is unknown.
+int64_t NumChannels(const TensorShapeProto& shape) {
+  if (shape.unknown_rank() || shape.dim_size() != 4) return -1;
+  return shape.dim(3).size();
+}
+
+bool IsFullyDefined(const TensorShapeProto& shape) {
+  if (shape.unknown_rank()) return false;
+  for (const auto& dim : shape.dim()) {
+    if (dim.size() < 0) return false;
+  }
+  return true;
+}
+
+bool SameShape(const TensorShapeProto& a, const TensorShapeProto& b) {
+  if (!IsFullyDefined(a) || !IsFullyDefined(b)) return false;
+  if (a.dim_size() != b.dim_size()) return false;
+  for (int i = 0; i < a.dim_size(); ++i) {
+    if (a.dim(i).size() != b.dim(i).size()) return false;
+  }
+  return true;
+}
+
+class NchwcConverter {
+ public:
+  NchwcConverter(const GrapplerItem& item, int block_size)
+      : item_(item),
+        block_size_(block_size),
+        nodes_to_preserve_(item.NodesToPreserve()) {}
+
+  Status Convert(GraphDef* output) {
+    sorted_item_ = item_.WithGraph(GraphDef(item_.graph));
+    if (!TopologicalSort(&sorted_item_.graph).ok()) {
+      VLOG(1) << "NCHWc layout: the graph cannot be sorted topologically.";
+      *output = item_.graph;
+      return OkStatus();
+    }
+    Status status;
+    view_ = std::make_unique<utils::GraphView>(&sorted_item_.graph, &status);
+    TF_RETURN_IF_ERROR(status);
+    properties_ = std::make_unique<GraphProperties>(sorted_item_);
+    TF_RETURN_IF_ERROR(properties_->InferStatically(
+        /*assume_valid_feeds=*/false,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/false,
+        /*include_output_tensor_values=*/false));
+
+    nodes_.resize(view_->NumNodes());
+    int num_convs = 0;
+    for (int i = 0; i < view_->NumNodes(); ++i) {
+      nodes_[i].kind = GetKind(i);
+      if (nodes_[i].kind == NchwcKind::kConv) ++num_convs;
+    }
+    if (num_convs == 0) {
+      *output = item_.graph;
+      return OkStatus();
+    }
+    for (int i = 0; i < view_->NumNodes(); ++i) {
+      if (nodes_[i].kind == NchwcKind::kConv) FoldIntoConv(i);
+    }
+
+    output_.Clear();
+    *output_.mutable_versions() = sorted_item_.graph.versions();
+    *output_.mutable_library() = sorted_item_.graph.library();
+    for (int i = 0; i < view_->NumNodes(); ++i) {
+      TF_RETURN_IF_ERROR(EmitNode(i));
+    }
+    VLOG(1) << "NCHWc layout: converted " << num_convs
+            << " convolutions, with " << entry_conversions_.size()
+            << " conversions to NCHWc and " << exit_conversions_.size()
+            << " conversions to NHWC.";
+    *output = std::move(output_);
+    return OkStatus();
+  }
+
+ private:
+  const NodeDef& node(int i) const { return *view_->GetNode(i)->node(); }
+
+  const TensorShapeProto* OutputShape(int i) const {
+    const auto& props = properties_->GetOutputProperties(node(i).name());
+    return props.empty() ? nullptr : &props[0].shape();
+  }
+
+  const TensorShapeProto* InputShape(int i, int port) const {
+    const auto& props = properties_->GetInputProperties(node(i).name());
+    return port < props.size() ? &props[port].shape() : nullptr;
+  }
+
+  // Returns true if regular fanin `port` of node `i` is produced in NCHWc.
+  bool IsNchwcFanin(int i, int port) const {
+    const auto* node_view = view_->GetNode(i);
+    if (port >= node_view->NumRegularFanins()) return false;
+    const auto& fanin = node_view->GetRegularFanin(port);
+    return fanin.index() == 0 &&
+           nodes_[fanin.node_index()].kind != NchwcKind::kNone;
+  }
+
+  // Returns true if only the first output of node `i` has fanouts.
+  bool OnlyFirstOutputIsUsed(int i) const {
+    const auto* node_view = view_->GetNode(i);
+    return node_view->NumRegularFanouts() ==
+           node_view->GetRegularFanout(0).size();
+  }
+
+  NchwcKind GetKind(int i) {
+    const NodeDef& node_def = node(i);
+    if (nodes_to_preserve_.count(node_def.name()) > 0) return NchwcKind::kNone;
+    if (!node_def.device().empty() && !NodeIsOnCpu(&node_def)) {
+      return NchwcKind::kNone;
+    }
+    if (!HasFloatType(node_def)) return NchwcKind::kNone;
+    const TensorShapeProto* output_shape = OutputShape(i);
+    if (output_shape == nullptr) return NchwcKind::kNone;
+    const int64_t channels = NumChannels(*output_shape);
+    if (channels <= 0) return NchwcKind::kNone;
+    nodes_[i].channels = channels;
+
+    if (IsConv2D(node_def)) {
+      // The output channels are not padded, so that the ops that consume the
+      // output in NCHWc see the same number of channels as in NHWC.
+      const TensorShapeProto* input_shape = InputShape(i, 0);
+      if (input_shape != nullptr && NumChannels(*input_shape) > 0 &&
+          channels % block_size_ == 0 && HasNhwcDataFormat(node_def) &&
+          HasValidPadding(node_def) && HasNhwcWindowAttr(node_def, "strides") &&
+          (!HasNodeAttr(node_def, "dilations") ||
+           HasNhwcWindowAttr(node_def, "dilations"))) {
+        return NchwcKind::kConv;
+      }
+      return NchwcKind::kNone;
+    }
+    if (IsBinaryNchwcOp(node_def)) {
+      if (!IsNchwcFanin(i, 0) && !IsNchwcFanin(i, 1)) return NchwcKind::kNone;
+      // The other input is either in NCHWc, a scalar, or a tensor of the shape
+      // of the output which is converted to NCHWc.
+      for (int port = 0; port < 2; ++port) {
+        if (IsNchwcFanin(i, port)) continue;
+        const TensorShapeProto* shape = InputShape(i, port);
+        if (shape == nullptr) return NchwcKind::kNone;
+        const bool is_scalar =
+            !shape->unknown_rank() && shape->dim_size() == 0;
+        if (!is_scalar && !SameShape(*shape, *output_shape)) {
+          return NchwcKind::kNone;
+        }
+      }
+      for (int port = 0; port < 2; ++port) {
+        if (!IsNchwcFanin(i, port)) continue;
+        const TensorShapeProto* shape = InputShape(i, port);
+        if (shape == nullptr || !SameShape(*shape, *output_shape)) {
+          return NchwcKind::kNone;
+        }
+      }
+      return NchwcKind::kBinary;
+    }
+    // The other ops only stay in NCHWc if their input already is.
+    if (!IsNchwcFanin(i, 0)) return NchwcKind::kNone;
+    if (node_def.op() == "MaxPool" || node_def.op() == "AvgPool") {
+      if (HasNhwcDataFormat(node_def) && HasValidPadding(node_def) &&
+          HasNhwcWindowAttr(node_def, "ksize") &&
+          HasNhwcWindowAttr(node_def, "strides")) {
+        return NchwcKind::kPool;
+      }
+      return NchwcKind::kNone;
+    }
+    if (IsBiasAdd(node_def)) {
+      return HasNhwcDataFormat(node_def) ? NchwcKind::kBiasAdd
+                                         : NchwcKind::kNone;
+    }
+    if (IsFusedBatchNorm(node_def)) {
+      const AttrValue* is_training = AttrSlice(node_def).Find("is_training");
+      if (is_training != nullptr && !is_training->b() &&
+          HasNhwcDataFormat(node_def) && OnlyFirstOutputIsUsed(i)) {
+        return NchwcKind::kBatchNorm;
+      }
+      return NchwcKind::kNone;
+    }
+    if (IsUnaryNchwcOp(node_def)) return NchwcKind::kUnary;
+    return NchwcKind::kNone;
+  }
+
+  // Returns the only regular fanout of node `i` if it is the only consumer of
+  // its output, or -1.
+  int SingleConsumer(int i) const {
+    const auto* node_view = view_->GetNode(i);
+    if (node_view->NumControlledFanouts() > 0 ||
+        node_view->NumRegularFanouts() != 1 ||
+        node_view->GetRegularFanout(0).size() != 1) {
+      return -1;
+    }
+    const auto& fanout = node_view->GetRegularFanout(0)[0];
+    return fanout.index() == 0 ? fanout.node_index() : -1;
+  }
+
+  // Folds a BiasAdd and a Relu or Relu6 that consume the output of the
+  // convolution `conv` into it.
+  void FoldIntoConv(int conv) {
+    int last = conv;
+    int consumer = SingleConsumer(last);
+    if (consumer >= 0 && nodes_[consumer].kind == NchwcKind::kBiasAdd) {
+      nodes_[conv].bias_add = consumer;
+      nodes_[consumer].folded_into = conv;
+      last = consumer;
+      consumer = SingleConsumer(last);
+    }
+    if (consumer >= 0 && nodes_[consumer].kind == NchwcKind::kUnary &&
+        (IsRelu(node(consumer)) || IsRelu6(node(consumer)))) {
+      nodes_[conv].activation = consumer;
+      nodes_[consumer].folded_into = conv;
+    }
+  }
+
+  // Returns the name of the node that produces the output of the convolution
+  // `conv` with the ops folded into it.
+  const string& ConvOutputName(int conv) const {
+    const NchwcNode& info = nodes_[conv];
+    if (info.activation >= 0) return node(info.activation).name();
+    if (info.bias_add >= 0) return node(info.bias_add).name();
+    return node(conv).name();
+  }
+
+  NodeDef* AddNode(const string& name, const string& op,
+                   const string& device) {
+    NodeDef* new_node = output_.add_node();
+    new_node->set_name(name);
+    new_node->set_op(op);
+    new_node->set_device(device);
+    return new_node;
+  }
+
+  NodeDef* AddConst(const string& name, const string& device,
+                    const Tensor& value) {
+    NodeDef* new_node = AddNode(name, "Const", device);
+    AddNodeAttr("dtype", value.dtype(), new_node);
+    value.AsProtoTensorContent(
+        (*new_node->mutable_attr())["value"].mutable_tensor());
+    return new_node;
+  }
+
+  NodeDef* AddFloatOp(const string& name, const string& op,
+                      const string& device, const std::vector<string>& inputs) {
+    NodeDef* new_node = AddNode(name, op, device);
+    for (const string& input : inputs) new_node->add_input(input);
+    AddNodeAttr("T", DT_FLOAT, new_node);
+    return new_node;
+  }
+
+  // Returns `input`, a vector of channels, reshaped to [blocks, 1, 1, block],
+  // which broadcasts over the channels of a tensor in NCHWc.
+  string ReshapeToBlocks(const string& input, const string& name,
+                         int64_t channels, const string& device) {
+    Tensor shape(DT_INT32, TensorShape({4}));
+    auto values = shape.vec<int32>();
+    values(0) = channels / block_size_;
+    values(1) = 1;
+    values(2) = 1;
+    values(3) = block_size_;
+    const string shape_name = absl::StrCat(name, "_shape");
+    AddConst(shape_name, device, shape);
+    NodeDef* reshape =
+        AddFloatOp(name, "Reshape", device, {input, shape_name});
+    AddNodeAttr("Tshape", DT_INT32, reshape);
+    return name;
+  }
+
+  // Returns the input for the tensor `input` of an op that consumes it in
+  // NCHWc if `nchwc` is true, and in NHWC otherwise, adding a layout
+  // conversion if needed.
+  string Input(const string& input, bool nchwc) {
+    const TensorId tensor = ParseTensorName(input);
+    const auto* producer = view_->GetNode(tensor.node());
+    const bool is_nchwc =
+        producer != nullptr && tensor.index() == 0 &&
+        nodes_[producer->node_index()].kind != NchwcKind::kNone;
+    if (nchwc == is_nchwc) return input;
+    const string device = producer == nullptr ? "" : producer->GetDevice();
+    if (is_nchwc) {
+      const int p = producer->node_index();
+      auto it = exit_conversions_.find(p);
+      if (it != exit_conversions_.end()) return it->second;
+      const string name = NchwcNodeName(tensor.node(), "to_nhwc");
+      NodeDef* conversion = AddFloatOp(name, kNchwcToNhwc, device, {input});
+      AddNodeAttr("channels", nodes_[p].channels, conversion);
+      exit_conversions_[p] = name;
+      return name;
+    }
+    const string key = tensor.ToString();
+    auto it = entry_conversions_.find(key);
+    if (it != entry_conversions_.end()) return it->second;
+    string name = NchwcNodeName(tensor.node(), "from_nhwc");
+    if (tensor.index() > 0) absl::StrAppend(&name, "_", tensor.index());
+    NodeDef* conversion = AddFloatOp(name, kNhwcToNchwc, device, {input});
+    AddNodeAttr("block_size", block_size_, conversion);
+    entry_conversions_[key] = name;
+    return name;
+  }
+
+  // Appends the control inputs of node `i` to `new_node`.
+  void AddControlInputs(int i, NodeDef* new_node) {
+    for (const string& input : node(i).input()) {
+      if (IsControlInput(input)) new_node->add_input(input);
+    }
+  }
+
+  Status EmitNode(int i) {
+    const NodeDef& node_def = node(i);
+    const NchwcNode& info = nodes_[i];
+    if (info.folded_into >= 0) return OkStatus();
+    switch (info.kind) {
+      case NchwcKind::kNone: {
+        NodeDef* new_node = output_.add_node();
+        *new_node = node_def;
+        for (int k = 0; k < new_node->input_size(); ++k) {
+          if (IsControlInput(new_node->input(k))) break;
+          new_node->set_input(k, Input(new_node->input(k), /*nchwc=*/false));
+        }
+        return OkStatus();
+      }
+      case NchwcKind::kConv:
+        return EmitConv(i);
+      case NchwcKind::kPool: {
+        NodeDef* pool =
+            AddFloatOp(node_def.name(), kNchwcPool, node_def.device(),
+                       {Input(node_def.input(0), /*nchwc=*/true)});
+        AddNodeAttr("pooling_type",
+                    node_def.op() == "MaxPool" ? "MAX" : "AVG", pool);
+        for (const char* attr : {"ksize", "strides", "padding"}) {
+          (*pool->mutable_attr())[attr] = node_def.attr().at(attr);
+        }
+        AddControlInputs(i, pool);
+        return OkStatus();
+      }
+      case NchwcKind::kBiasAdd: {
+        const string bias = ReshapeToBlocks(
+            Input(node_def.input(1), /*nchwc=*/false),
+            NchwcNodeName(node_def.name(), "bias"), info.channels,
+            node_def.device());
+        NodeDef* add = AddFloatOp(
+            node_def.name(), "AddV2", node_def.device(),
+            {Input(node_def.input(0), /*nchwc=*/true), bias});
+        AddControlInputs(i, add);
+        return OkStatus();
+      }
+      case NchwcKind::kBatchNorm:
+        return EmitBatchNorm(i);
+      case NchwcKind::kUnary:
+      case NchwcKind::kBinary: {
+        NodeDef* new_node = output_.add_node();
+        *new_node = node_def;
+        new_node->mutable_attr()->erase(kOutputShapesAttr);
+        const int num_inputs = info.kind == NchwcKind::kUnary ? 1 : 2;
+        for (int k = 0; k < num_inputs; ++k) {
+          const TensorShapeProto* shape = InputShape(i, k);
+          const bool is_scalar = shape != nullptr && !shape->unknown_rank() &&
+                                 shape->dim_size() == 0;
+          if (!is_scalar) {
+            new_node->set_input(k, Input(node_def.input(k), /*nchwc=*/true));
+          }
+        }
+        return OkStatus();
+      }
+    }
+    return errors::Internal("Unexpected NCHWc kind for ", node_def.name());
+  }
+
+  Status EmitConv(int i) {
+    const NodeDef& conv = node(i);
+    const NchwcNode& info = nodes_[i];
+    const string filter = NchwcNodeName(conv.name(), "filter");
+    NodeDef* filter_node =
+        AddFloatOp(filter, kNchwcFilter, conv.device(),
+                   {Input(conv.input(1), /*nchwc=*/false)});
+    AddNodeAttr("block_size", block_size_, filter_node);
+
+    NodeDef* new_conv =
+        AddFloatOp(ConvOutputName(i), kNchwcConv2D, conv.device(),
+                   {Input(conv.input(0), /*nchwc=*/true), filter});
+    for (const char* attr : {"strides", "padding", "dilations"}) {
+      auto it = conv.attr().find(attr);
+      if (it != conv.attr().end()) {
+        (*new_conv->mutable_attr())[attr] = it->second;
+      }
+    }
+    int num_bias = 0;
+    if (info.bias_add >= 0) {
+      new_conv->add_input(
+          Input(node(info.bias_add).input(1), /*nchwc=*/false));
+      num_bias = 1;
+    }
+    AddNodeAttr("num_bias", num_bias, new_conv);
+    const char* activation = "None";
+    if (info.activation >= 0) {
+      activation = IsRelu(node(info.activation)) ? "Relu" : "Relu6";
+    }
+    AddNodeAttr("activation", activation, new_conv);
+    for (int folded : {i, info.bias_add, info.activation}) {
+      if (folded >= 0) AddControlInputs(folded, new_conv);
+    }
+    return OkStatus();
+  }
+
+  // Computes an inference batch normalization as `x * multiplier + shift`,
+  // where the per-channel `multiplier = scale * rsqrt(variance + epsilon)` and
+  // `shift = offset - mean * multiplier` are reshaped to the blocks.
+  Status EmitBatchNorm(int i) {
+    const NodeDef& bn = node(i);
+    const NchwcNode& info = nodes_[i];
+    const string& device = bn.device();
+    float epsilon;
+    TF_RETURN_IF_ERROR(GetNodeAttr(bn, "epsilon", &epsilon));
+    auto name = [&bn](absl::string_view suffix) {
+      return NchwcNodeName(bn.name(), suffix);
+    };
+    std::vector<string> inputs;
+    for (int k = 1; k < 5; ++k) {
+      inputs.push_back(Input(bn.input(k), /*nchwc=*/false));
+    }
+    Tensor epsilon_value(DT_FLOAT, TensorShape({}));
+    epsilon_value.scalar<float>()() = epsilon;
+    AddConst(name("epsilon"), device, epsilon_value);
+    AddFloatOp(name("variance_plus_epsilon"), "AddV2", device,
+               {inputs[3], name("epsilon")});
+    AddFloatOp(name("rsqrt"), "Rsqrt", device,
+               {name("variance_plus_epsilon")});
+    AddFloatOp(name("multiplier"), "Mul", device,
+               {inputs[0], name("rsqrt")});
+    AddFloatOp(name("mean_times_multiplier"), "Mul", device,
+               {inputs[2], name("multiplier")});
+    AddFloatOp(name("shift"), "Sub", device,
+               {inputs[1], name("mean_times_multiplier")});
+    const string multiplier = ReshapeToBlocks(
+        name("multiplier"), name("blocked_multiplier"), info.channels, device);
+    const string shift = ReshapeToBlocks(name("shift"), name("blocked_shift"),
+                                         info.channels, device);
+    AddFloatOp(name("scaled"), "Mul", device,
+               {Input(bn.input(0), /*nchwc=*/true), multiplier});
+    NodeDef* add =
+        AddFloatOp(bn.name(), "AddV2", device, {name("scaled"), shift});
+    AddControlInputs(i, add);
+    return OkStatus();
+  }
+
+  const GrapplerItem& item_;
+  const int block_size_;
+  const std::unordered_set<string> nodes_to_preserve_;
+  // `item_` with a topologically sorted graph.
+  GrapplerItem sorted_item_;
+  std::unique_ptr<utils::GraphView> view_;
+  std::unique_ptr<GraphProperties> properties_;
+  std::vector<NchwcNode> nodes_;
+  GraphDef output_;
+  // Conversions to NCHWc by tensor, and to NHWC by producer.
+  absl::flat_hash_map<string, string> entry_conversions_;
+  absl::flat_hash_map<int, string> exit_conversions_;
+};
+
+}  // namespace
+
+int NchwcBlockSize() {
+  return port::TestCPUFeature(port::CPUFeature::AVX512F) ? 16 : 8;
+}
+
+Status ConvertToNchwcLayout(const GrapplerItem& item, int block_size,
+                            GraphDef* output) {
+  if (block_size != 8 && block_size != 16) {
+    return errors::InvalidArgument(
+        "The NCHWc layout supports blocks of 8 or 16 channels, got ",
+        block_size);
+  }
+  return NchwcConverter(item, block_size).Convert(output);
+}
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,48 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Returns the number of channels per block of the NCHWc layout on this CPU,
+// which is the number of floats in a vector register: 16 with AVX-512, and 8
+// otherwise.
+int NchwcBlockSize();
+
+// Converts the chains of float NHWC convolutions of `item` that run on CPU to
+// the blocked NCHWc layout, with `block_size` channels per block.
+//
+// Conv2D, MaxPool and AvgPool become _NchwcConv2D and _NchwcPool. The ops that
+// consume a tensor in NCHWc keep it in NCHWc: BiasAdd and inference
+// FusedBatchNorm become a broadcast of per-channel vectors reshaped to the
+// blocks, activations and elementwise ops of tensors of the same shape run
+// unchanged, and a BiasAdd and a Relu or Relu6 that follow a convolution are
+// folded into it. Layout conversions are only inserted where a tensor enters
+// the chain, and where it is consumed by an op without NCHWc support. Fetched
+// nodes keep the NHWC layout.
+Status ConvertToNchwcLayout(const GrapplerItem& item, int block_size,
+                            GraphDef* output);
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
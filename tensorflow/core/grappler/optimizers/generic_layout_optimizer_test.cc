@@ -674,6 +674,118 @@ TEST_F(GenericLayoutOptimizerTest, PreserveInputShapes) {
             output_shapes.DebugString());
 }
 
+TEST_F(GenericLayoutOptimizerTest, NchwcLayoutOnCpu) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "The NCHWc layout is only used without GPUs";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 8, 8, 5}));
+  auto filter1 = ops::Const(s.WithOpName("filter1"),
+                            GenerateRandomTensor<DT_FLOAT>({3, 3, 5, 16}));
+  auto bias1 = ops::Const(s.WithOpName("bias1"),
+                          GenerateRandomTensor<DT_FLOAT>({16}));
+  auto filter2 = ops::Const(s.WithOpName("filter2"),
+                            GenerateRandomTensor<DT_FLOAT>({1, 1, 16, 16}));
+  auto conv1 = ops::Conv2D(s.WithOpName("conv1"), x, filter1, {1, 1, 1, 1},
+                           "SAME");
+  auto bias_add = ops::BiasAdd(s.WithOpName("bias_add"), conv1, bias1);
+  auto relu1 = ops::Relu(s.WithOpName("relu1"), bias_add);
+  auto pool = ops::MaxPool(s.WithOpName("pool"), relu1, {1, 3, 3, 1},
+                           {1, 2, 2, 1}, "SAME");
+  auto conv2 = ops::Conv2D(s.WithOpName("conv2"), pool, filter2,
+                           {1, 1, 1, 1}, "VALID");
+  auto channel_vector = [this, &s](const string& name, float offset) {
+    Tensor value = GenerateRandomTensor<DT_FLOAT>({16});
+    value.flat<float>() = value.flat<float>() + offset;
+    return ops::Const(s.WithOpName(name), value);
+  };
+  auto bn = ops::FusedBatchNorm(
+      s.WithOpName("bn"), conv2, channel_vector("scale", 0),
+      channel_vector("offset", 0), channel_vector("mean", 0),
+      channel_vector("variance", 2), ops::FusedBatchNorm::IsTraining(false));
+  auto add = ops::AddV2(s.WithOpName("add"), bn.y, pool);
+  auto relu2 = ops::Relu(s.WithOpName("relu2"), add);
+  auto output = ops::Identity(s.WithOpName("output"), relu2);
+
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHWC);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &optimized));
+
+  Status status;
+  utils::GraphView graph_view(&optimized, &status);
+  TF_ASSERT_OK(status);
+  // The BiasAdd and the Relu are folded into the first convolution, which
+  // takes the name of the Relu.
+  EXPECT_EQ(graph_view.GetNode("conv1"), nullptr);
+  EXPECT_EQ(graph_view.GetNode("bias_add"), nullptr);
+  auto* conv1_node = graph_view.GetNode("relu1");
+  ASSERT_NE(conv1_node, nullptr);
+  EXPECT_EQ(conv1_node->GetOp(), "_NchwcConv2D");
+  EXPECT_EQ(conv1_node->GetAttr("activation")->s(), "Relu");
+  ASSERT_EQ(conv1_node->NumRegularFanins(), 3);
+  VerifyRegularFaninMatch(conv1_node, 0, "x/nchwc_from_nhwc", 0);
+  VerifyRegularFaninMatch(conv1_node, 1, "conv1/nchwc_filter", 0);
+  VerifyRegularFaninMatch(conv1_node, 2, "bias1", 0);
+
+  auto* pool_node = graph_view.GetNode("pool");
+  ASSERT_NE(pool_node, nullptr);
+  EXPECT_EQ(pool_node->GetOp(), "_NchwcPool");
+  auto* conv2_node = graph_view.GetNode("conv2");
+  ASSERT_NE(conv2_node, nullptr);
+  EXPECT_EQ(conv2_node->GetOp(), "_NchwcConv2D");
+  EXPECT_EQ(conv2_node->GetAttr("activation")->s(), "None");
+  auto* bn_node = graph_view.GetNode("bn");
+  ASSERT_NE(bn_node, nullptr);
+  EXPECT_EQ(bn_node->GetOp(), "AddV2");
+
+  // The only conversion to NHWC is for the Identity.
+  auto* output_node = graph_view.GetNode("output");
+  ASSERT_NE(output_node, nullptr);
+  VerifyRegularFaninMatch(output_node, 0, "relu2/nchwc_to_nhwc", 0);
+  int num_conversions = 0;
+  for (const NodeDef& node : optimized.node()) {
+    if (node.op() == "_NchwcToNhwc" || node.op() == "_NhwcToNchwc") {
+      ++num_conversions;
+    }
+  }
+  EXPECT_EQ(num_conversions, 2);
+
+  Tensor x_value = GenerateRandomTensor<DT_FLOAT>({2, 8, 8, 5});
+  auto expected = EvaluateNodes(item.graph, item.fetch, {{"x", x_value}});
+  auto actual = EvaluateNodes(optimized, item.fetch, {{"x", x_value}});
+  ASSERT_EQ(expected.size(), 1);
+  ASSERT_EQ(actual.size(), 1);
+  test::ExpectTensorNear<float>(expected[0], actual[0], 1e-4);
+}
+
+TEST_F(GenericLayoutOptimizerTest, NchwcLayoutPreservesFetchedConv) {
+#if (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  GTEST_SKIP() << "The NCHWc layout is only used without GPUs";
+#endif  // (GOOGLE_CUDA || TENSORFLOW_USE_ROCM)
+  Scope s = Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({1, 4, 4, 16}));
+  auto filter = ops::Const(s.WithOpName("filter"),
+                           GenerateRandomTensor<DT_FLOAT>({2, 2, 16, 16}));
+  auto conv = ops::Conv2D(s.WithOpName("conv"), x, filter, {1, 1, 1, 1},
+                          "SAME");
+  GrapplerItem item;
+  item.fetch = {"conv"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GenericLayoutOptimizer optimizer(RewriterConfig::DEFAULT,
+                                   RewriterConfig::NHWC_TO_NCHWC);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(virtual_cluster_.get(), item, &optimized));
+  CompareGraphs(item.graph, optimized);
+}
+
 // TODO(yanzha): Add more complex Graph for test.
 
 }  // namespace grappler
@@ -18,11 +18,16 @@ limitations under the License.
 #include <algorithm>
 #include <deque>
 #include <limits>
+#include <map>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/allocator.h"
@@ -31,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/mutable_graph_view.h"
@@ -38,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 #include "tensorflow/core/grappler/optimizers/evaluation_utils.h"
 #include "tensorflow/core/grappler/utils/frame.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/traversal.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -56,10 +63,98 @@ namespace {
 
 using TensorVector = gtl::InlinedVector<TensorValue, 4>;
 
+// Outputs of at most this many bytes are always hoisted out of loops.
+constexpr int64_t kMaxUncheckedHoistedOutputBytes = 1 << 20;
+
+// The size of a tensor, as the number of bytes of its known dimensions and
+// the number of its unknown dimensions.
+struct TensorSizeEstimate {
+  bool known_rank = false;
+  int64_t known_bytes = 0;
+  int num_unknown_dims = 0;
+};
+
+TensorSizeEstimate EstimateTensorSize(
+    const OpInfo::TensorProperties& properties) {
+  TensorSizeEstimate estimate;
+  if (properties.shape().unknown_rank()) return estimate;
+  estimate.known_rank = true;
+  estimate.known_bytes = DataTypeSize(properties.dtype());
+  for (const auto& dim : properties.shape().dim()) {
+    if (dim.size() < 0) {
+      ++estimate.num_unknown_dims;
+    } else {
+      estimate.known_bytes *= dim.size();
+    }
+  }
+  return estimate;
+}
+
+// Returns true if hoisting `node` out of a loop may increase the memory
+// usage: the inputs of an invariant node are live for the whole loop, but its
+// outputs are only live during one iteration until the node is hoisted. The
+// outputs are therefore only hoisted if they are small, or no larger than one
+// of the inputs, assuming that unknown dimensions are equal.
+bool HoistingMayIncreaseMemory(const NodeDef& node,
+                               const GraphProperties* properties) {
+  if (properties == nullptr || !properties->HasOutputProperties(node.name())) {
+    return false;
+  }
+  const auto& inputs = properties->GetInputProperties(node.name());
+  for (const auto& output : properties->GetOutputProperties(node.name())) {
+    const TensorSizeEstimate output_size = EstimateTensorSize(output);
+    if (!output_size.known_rank) {
+      for (const auto& input : inputs) {
+        if (!input.shape().unknown_rank()) return true;
+      }
+      continue;
+    }
+    if (output_size.num_unknown_dims == 0 &&
+        output_size.known_bytes <= kMaxUncheckedHoistedOutputBytes) {
+      continue;
+    }
+    bool fits = false;
+    for (const auto& input : inputs) {
+      const TensorSizeEstimate input_size = EstimateTensorSize(input);
+      if (input_size.known_rank &&
+          input_size.num_unknown_dims >= output_size.num_unknown_dims &&
+          input_size.known_bytes >= output_size.known_bytes) {
+        fits = true;
+        break;
+      }
+    }
+    if (!fits) return true;
+  }
+  return false;
+}
+
+// Returns true if `node` may be hoisted out of a loop once its inputs are
+// known to be loop invariant.
+bool IsHoistable(const NodeDef& node,
+                 const std::unordered_set<string>& nodes_to_preserve,
+                 const GraphProperties* properties) {
+  if (nodes_to_preserve.count(node.name()) > 0 || IsControlFlow(node) ||
+      !IsFreeOfSideEffect(node)) {
+    return false;
+  }
+  if (HoistingMayIncreaseMemory(node, properties)) {
+    VLOG(2) << "Not hoisting " << node.name()
+            << " out of its loop, since its outputs are too large";
+    return false;
+  }
+  return true;
+}
+
 class LoopInvariantNodeMotionOptimizer {
  public:
-  explicit LoopInvariantNodeMotionOptimizer(GraphDef* optimized_graph)
-      : optimized_graph_(optimized_graph) {}
+  // `properties` may be nullptr, in which case the size of the outputs of
+  // the invariant nodes is not checked.
+  LoopInvariantNodeMotionOptimizer(
+      const std::unordered_set<string>& nodes_to_preserve,
+      const GraphProperties* properties, GraphDef* optimized_graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        properties_(properties),
+        optimized_graph_(optimized_graph) {}
   virtual ~LoopInvariantNodeMotionOptimizer() = default;
   Status Optimize();
 
@@ -72,7 +167,9 @@ class LoopInvariantNodeMotionOptimizer {
   Status HandleConst(NodeDef* node, const int num_outputs, const int frame_id);
   Status HandleInvariantEnter(NodeDef* node, const int num_outputs);
 
-  GraphDef* optimized_graph_;  // Not owned.
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const GraphProperties* properties_;  // Not owned.
+  GraphDef* optimized_graph_;          // Not owned.
   std::unique_ptr<NodeMap> node_map_;
   std::map<NodeDef*, int> invariant_nodes_;
   std::set<int> empty_set_;
@@ -189,11 +286,11 @@ Status LoopInvariantNodeMotionOptimizer::HandleInvariantNode(
     NodeDef* node, const int num_outputs, const int frame_id) {
   // have to remove control inputs to the invariant node from the same frame
   // when moving this node out of this frame
-  for (int i = 0; i < node->input_size(); ++i) {
-    if (IsControlInput(node->input(i))) {
-      node->mutable_input()->SwapElements(i, node->input_size() - 1);
-      node->mutable_input()->RemoveLast();
-    }
+  while (node->input_size() > 0 &&
+         IsControlInput(node->input(node->input_size() - 1))) {
+    node_map_->RemoveOutput(NodeName(node->input(node->input_size() - 1)),
+                            node->name());
+    node->mutable_input()->RemoveLast();
   }
   if (num_outputs == 0) {
     return OkStatus();
@@ -340,7 +437,8 @@ Status LoopInvariantNodeMotionOptimizer::FindInvariantNodes(
     auto consumers = node_map_->GetOutputs(node->name());
     invariant_nodes_.emplace(node, consumers.size());
     for (auto* consumer : consumers) {
-      if (invariant_nodes_.count(consumer) || ModifiesFrameInfo(*consumer)) {
+      if (invariant_nodes_.count(consumer) || ModifiesFrameInfo(*consumer) ||
+          !IsHoistable(*consumer, nodes_to_preserve_, properties_)) {
         continue;
       }
       bool is_invariant = true;
@@ -452,6 +550,408 @@ Status LoopInvariantNodeMotionOptimizer::Optimize() {
   return OkStatus();
 }
 
+// Hoists loop invariant computations out of the bodies of the functional
+// While ops (`While` and `StatelessWhile`) of the graph.
+//
+// A loop variable is invariant if the body returns it unchanged. The pure
+// nodes of the body that only depend on invariant loop variables and on
+// constants are copied in front of the While op, and those of their outputs
+// that are used by the rest of the body are passed in as new invariant loop
+// variables. The body and the condition are replaced by copies with the new
+// arguments, so that other callers of the original functions are unaffected.
+class FunctionalWhileInvariantMotion {
+ public:
+  // `properties` may be nullptr, in which case the size of the outputs of
+  // the invariant nodes is not checked.
+  FunctionalWhileInvariantMotion(
+      const std::unordered_set<string>& nodes_to_preserve,
+      const GraphProperties* properties, GraphDef* optimized_graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        properties_(properties),
+        optimized_graph_(optimized_graph) {}
+
+  Status Optimize();
+
+ private:
+  // Hoists the invariant nodes out of the body of `while_node`, and sets
+  // `optimized` to true if there were any.
+  Status OptimizeWhile(NodeDef* while_node, FunctionLibraryDefinition* flib,
+                       bool* optimized);
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const GraphProperties* properties_;  // Not owned.
+  GraphDef* optimized_graph_;          // Not owned.
+};
+
+// Returns the name of the node or argument referenced by `ref`, a control
+// input or an input of the form `arg` or `node:output:index` of a function
+// body.
+string FunctionRefName(const string& ref) {
+  const size_t begin = IsControlInput(ref) ? 1 : 0;
+  return ref.substr(begin, ref.find(':') - begin);
+}
+
+// Returns the output port of `node` referenced by `ref`, of the form
+// `node:output:index`, and its data type.
+Status FunctionRefPort(const NodeDef& node, const string& ref, int* port,
+                       DataType* type) {
+  const OpDef* op_def = nullptr;
+  TF_RETURN_IF_ERROR(OpRegistry::Global()->LookUpOpDef(node.op(), &op_def));
+  NameRangeMap outputs;
+  TF_RETURN_IF_ERROR(NameRangesForNode(node, *op_def, nullptr, &outputs));
+  const std::vector<string> parts = absl::StrSplit(ref, ':');
+  int index = 0;
+  if (parts.size() < 2 || parts.size() > 3 ||
+      (parts.size() == 3 && !absl::SimpleAtoi(parts[2], &index))) {
+    return errors::InvalidArgument("Invalid function body input ", ref);
+  }
+  auto it = outputs.find(parts[1]);
+  if (it == outputs.end() || index >= it->second.second - it->second.first) {
+    return errors::InvalidArgument("Function body input ", ref,
+                                   " does not match an output of ",
+                                   node.name());
+  }
+  *port = it->second.first + index;
+  DataTypeVector input_types;
+  DataTypeVector output_types;
+  TF_RETURN_IF_ERROR(
+      InOutTypesForNode(node, *op_def, &input_types, &output_types));
+  *type = output_types[*port];
+  return OkStatus();
+}
+
+// Appends an argument of unknown shape to the `_input_shapes` attribute of
+// `func`, if it has one.
+void AppendUnknownInputShape(FunctionDef* func) {
+  auto it = func->mutable_attr()->find("_input_shapes");
+  if (it != func->mutable_attr()->end()) {
+    it->second.mutable_list()->add_shape()->set_unknown_rank(true);
+  }
+}
+
+Status FunctionalWhileInvariantMotion::Optimize() {
+  FunctionLibraryDefinition flib(OpRegistry::Global(),
+                                 optimized_graph_->library());
+  bool optimized = false;
+  const int num_nodes = optimized_graph_->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph_->mutable_node(i);
+    if (!IsWhile(*node) || nodes_to_preserve_.count(node->name()) > 0) {
+      continue;
+    }
+    bool optimized_while = false;
+    TF_RETURN_IF_ERROR(OptimizeWhile(node, &flib, &optimized_while));
+    optimized |= optimized_while;
+  }
+  if (optimized) {
+    *optimized_graph_->mutable_library() = flib.ToProto();
+  }
+  return OkStatus();
+}
+
+Status FunctionalWhileInvariantMotion::OptimizeWhile(
+    NodeDef* while_node, FunctionLibraryDefinition* flib, bool* optimized) {
+  const AttrValue* body_attr = AttrSlice(*while_node).Find("body");
+  const AttrValue* cond_attr = AttrSlice(*while_node).Find("cond");
+  if (body_attr == nullptr || cond_attr == nullptr) return OkStatus();
+  const FunctionDef* body = flib->Find(body_attr->func().name());
+  const FunctionDef* cond = flib->Find(cond_attr->func().name());
+  if (body == nullptr || cond == nullptr || IsParametrized(*body) ||
+      IsParametrized(*cond)) {
+    return OkStatus();
+  }
+  const OpDef& signature = body->signature();
+  const int num_vars = signature.input_arg_size();
+  int num_data_inputs = 0;
+  while (num_data_inputs < while_node->input_size() &&
+         !IsControlInput(while_node->input(num_data_inputs))) {
+    ++num_data_inputs;
+  }
+  if (signature.output_arg_size() != num_vars ||
+      num_data_inputs != num_vars ||
+      cond->signature().input_arg_size() != num_vars) {
+    return OkStatus();
+  }
+
+  absl::flat_hash_map<string, const NodeDef*> body_nodes;
+  for (const NodeDef& node : body->node_def()) {
+    body_nodes[node.name()] = &node;
+  }
+  absl::flat_hash_map<string, int> arg_index;
+  for (int i = 0; i < num_vars; ++i) {
+    arg_index[signature.input_arg(i).name()] = i;
+  }
+
+  // A loop variable is invariant if the body returns its argument, possibly
+  // through a chain of Identity nodes.
+  std::vector<bool> invariant_args(num_vars, false);
+  bool has_invariant_args = false;
+  for (int i = 0; i < num_vars; ++i) {
+    const auto ret = body->ret().find(signature.output_arg(i).name());
+    if (ret == body->ret().end()) continue;
+    string ref = ret->second;
+    while (true) {
+      const auto arg = arg_index.find(ref);
+      if (arg != arg_index.end()) {
+        invariant_args[i] = arg->second == i;
+        break;
+      }
+      const auto node = body_nodes.find(FunctionRefName(ref));
+      if (node == body_nodes.end() || !IsIdentity(*node->second) ||
+          node->second->input_size() == 0 ||
+          IsControlInput(node->second->input(0))) {
+        break;
+      }
+      ref = node->second->input(0);
+    }
+    has_invariant_args |= invariant_args[i];
+  }
+  if (!has_invariant_args) return OkStatus();
+
+  // Infer the shapes of the body, to check the size of the hoisted outputs.
+  GrapplerFunctionItem body_item;
+  std::unique_ptr<GraphProperties> body_properties;
+  if (properties_ != nullptr &&
+      properties_->HasInputProperties(while_node->name()) &&
+      MakeGrapplerFunctionItem(*body, *flib,
+                               optimized_graph_->versions().producer(),
+                               &body_item)
+          .ok()) {
+    const auto& inputs = properties_->GetInputProperties(while_node->name());
+    for (NodeDef& node : *body_item.graph.mutable_node()) {
+      const auto arg = arg_index.find(node.name());
+      if (arg == arg_index.end() || !invariant_args[arg->second] ||
+          arg->second >= static_cast<int>(inputs.size())) {
+        continue;
+      }
+      AttrValue output_shapes;
+      *output_shapes.mutable_list()->add_shape() = inputs[arg->second].shape();
+      (*node.mutable_attr())["_output_shapes"] = output_shapes;
+    }
+    body_properties = absl::make_unique<GraphProperties>(body_item);
+    if (!body_properties->InferStatically(/*assume_valid_feeds=*/false).ok()) {
+      body_properties.reset();
+    }
+  }
+
+  // Find the hoistable nodes. Nodes that are control outputs of the body
+  // must run on every iteration.
+  absl::flat_hash_set<string> control_outputs;
+  for (const auto& control_ret : body->control_ret()) {
+    control_outputs.insert(control_ret.second);
+  }
+  absl::flat_hash_set<string> hoisted;
+  const auto is_invariant = [&](const string& ref) {
+    const string name = FunctionRefName(ref);
+    const auto arg = arg_index.find(name);
+    if (arg != arg_index.end()) return bool(invariant_args[arg->second]);
+    const auto node = body_nodes.find(name);
+    if (node == body_nodes.end()) return false;
+    return hoisted.count(name) > 0 ||
+           (IsConstant(*node->second) && node->second->input_size() == 0);
+  };
+  static const auto* const kNoNodesToPreserve = new std::unordered_set<string>;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : body->node_def()) {
+      if (hoisted.count(node.name()) > 0 || IsConstant(node) ||
+          control_outputs.count(node.name()) > 0 ||
+          !std::all_of(node.input().begin(), node.input().end(),
+                       is_invariant) ||
+          !IsHoistable(node, *kNoNodesToPreserve, body_properties.get())) {
+        continue;
+      }
+      hoisted.insert(node.name());
+      changed = true;
+    }
+  }
+  // Nodes with control outputs to nodes that stay in the body stay too, and
+  // so do the nodes that depend on them.
+  changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef& node : body->node_def()) {
+      if (hoisted.count(node.name()) > 0) {
+        if (!std::all_of(node.input().begin(), node.input().end(),
+                         is_invariant)) {
+          hoisted.erase(node.name());
+          changed = true;
+        }
+        continue;
+      }
+      for (const string& input : node.input()) {
+        if (IsControlInput(input) && hoisted.erase(FunctionRefName(input))) {
+          changed = true;
+        }
+      }
+    }
+  }
+  // Hoisting a chain of Identity nodes only adds loop variables.
+  if (std::all_of(hoisted.begin(), hoisted.end(), [&](const string& name) {
+        return IsIdentity(*body_nodes[name]);
+      })) {
+    return OkStatus();
+  }
+
+  // Returns a name that is not used by the arguments or the nodes of the
+  // body.
+  absl::flat_hash_set<string> used_names;
+  for (const auto& node : body_nodes) used_names.insert(node.first);
+  for (const auto& arg : signature.input_arg()) used_names.insert(arg.name());
+  for (const auto& arg : signature.output_arg()) used_names.insert(arg.name());
+  const auto unique_name = [&](const string& prefix) {
+    string name = prefix;
+    for (int i = 0; used_names.count(name) > 0; ++i) {
+      name = StrCat(prefix, "_", i);
+    }
+    used_names.insert(name);
+    return name;
+  };
+
+  // Replace the uses of the hoisted outputs by the rest of the body with new
+  // arguments.
+  struct HoistedOutput {
+    string node;
+    int port;
+    DataType type;
+    string arg_name;
+  };
+  std::vector<HoistedOutput> hoisted_outputs;
+  std::map<std::pair<string, int>, int> hoisted_output_index;
+  const auto replace_hoisted_ref = [&](string* ref) -> Status {
+    const string name = FunctionRefName(*ref);
+    if (IsControlInput(*ref) || hoisted.count(name) == 0) return OkStatus();
+    int port;
+    DataType type;
+    TF_RETURN_IF_ERROR(FunctionRefPort(*body_nodes[name], *ref, &port, &type));
+    auto it = hoisted_output_index.find({name, port});
+    if (it == hoisted_output_index.end()) {
+      it = hoisted_output_index.insert({{name, port}, hoisted_outputs.size()})
+               .first;
+      hoisted_outputs.push_back(
+          {name, port, type, unique_name(StrCat(name, "_", port, "_licm"))});
+    }
+    *ref = hoisted_outputs[it->second].arg_name;
+    return OkStatus();
+  };
+
+  FunctionDef new_body = *body;
+  new_body.clear_node_def();
+  for (const NodeDef& node : body->node_def()) {
+    if (hoisted.count(node.name()) > 0) continue;
+    NodeDef* new_node = new_body.add_node_def();
+    *new_node = node;
+    for (string& input : *new_node->mutable_input()) {
+      TF_RETURN_IF_ERROR(replace_hoisted_ref(&input));
+    }
+  }
+  for (auto& ret : *new_body.mutable_ret()) {
+    TF_RETURN_IF_ERROR(replace_hoisted_ref(&ret.second));
+  }
+  if (hoisted_outputs.empty()) return OkStatus();
+
+  FunctionDef new_cond = *cond;
+  new_body.mutable_signature()->set_name(
+      flib->UniqueFunctionName(StrCat(signature.name(), "_licm_")));
+  new_cond.mutable_signature()->set_name(
+      flib->UniqueFunctionName(StrCat(cond->signature().name(), "_licm_")));
+  for (const HoistedOutput& output : hoisted_outputs) {
+    OpDef::ArgDef* input_arg = new_body.mutable_signature()->add_input_arg();
+    input_arg->set_name(output.arg_name);
+    input_arg->set_type(output.type);
+    OpDef::ArgDef* output_arg = new_body.mutable_signature()->add_output_arg();
+    output_arg->set_name(unique_name(StrCat(output.arg_name, "_out")));
+    output_arg->set_type(output.type);
+    (*new_body.mutable_ret())[output_arg->name()] = output.arg_name;
+    AppendUnknownInputShape(&new_body);
+
+    *new_cond.mutable_signature()->add_input_arg() = *input_arg;
+    AppendUnknownInputShape(&new_cond);
+  }
+
+  // Copy the hoisted nodes and the constants they use in front of the loop.
+  const auto outer_name = [&](const string& name) {
+    return AddPrefixToNodeName(StrCat(while_node->name(), "/", name),
+                               kLoopOptimizer);
+  };
+  absl::flat_hash_set<string> copied_consts;
+  for (const NodeDef& node : body->node_def()) {
+    if (hoisted.count(node.name()) == 0) continue;
+    NodeDef* new_node = optimized_graph_->add_node();
+    *new_node = node;
+    new_node->set_name(outer_name(node.name()));
+    if (new_node->device().empty()) {
+      new_node->set_device(while_node->device());
+    }
+    new_node->clear_input();
+    for (const string& input : node.input()) {
+      const bool is_control = IsControlInput(input);
+      const string name = FunctionRefName(input);
+      const auto arg = arg_index.find(name);
+      if (arg != arg_index.end()) {
+        const string& outer_input = while_node->input(arg->second);
+        new_node->add_input(is_control ? AsControlDependency(outer_input)
+                                       : outer_input);
+        continue;
+      }
+      const NodeDef* producer = body_nodes[name];
+      if (IsConstant(*producer) && copied_consts.insert(name).second) {
+        NodeDef* new_const = optimized_graph_->add_node();
+        *new_const = *producer;
+        new_const->set_name(outer_name(name));
+        if (new_const->device().empty()) {
+          new_const->set_device(while_node->device());
+        }
+      }
+      if (is_control) {
+        new_node->add_input(AsControlDependency(outer_name(name)));
+        continue;
+      }
+      int port;
+      DataType type;
+      TF_RETURN_IF_ERROR(FunctionRefPort(*producer, input, &port, &type));
+      new_node->add_input(port == 0 ? outer_name(name)
+                                    : StrCat(outer_name(name), ":", port));
+    }
+  }
+
+  // Pass the hoisted outputs to the loop.
+  std::vector<string> control_inputs(
+      while_node->input().begin() + num_data_inputs,
+      while_node->input().end());
+  while_node->mutable_input()->DeleteSubrange(
+      num_data_inputs, control_inputs.size());
+  auto* attr = while_node->mutable_attr();
+  for (const HoistedOutput& output : hoisted_outputs) {
+    const string outer_node = outer_name(output.node);
+    while_node->add_input(output.port == 0
+                              ? outer_node
+                              : StrCat(outer_node, ":", output.port));
+    (*attr)["T"].mutable_list()->add_type(output.type);
+    if (attr->count("output_shapes") > 0) {
+      (*attr)["output_shapes"].mutable_list()->add_shape()->set_unknown_rank(
+          true);
+    }
+  }
+  for (const string& control_input : control_inputs) {
+    while_node->add_input(control_input);
+  }
+  if (attr->count("_num_original_outputs") > 0) {
+    (*attr)["_num_original_outputs"].set_i(num_vars + hoisted_outputs.size());
+  }
+  attr->erase("_output_shapes");
+  (*attr)["body"].mutable_func()->set_name(new_body.signature().name());
+  (*attr)["cond"].mutable_func()->set_name(new_cond.signature().name());
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_body));
+  TF_RETURN_IF_ERROR(flib->AddFunctionDef(new_cond));
+
+  VLOG(1) << "Hoisted " << hoisted.size() << " nodes out of the body of "
+          << while_node->name();
+  *optimized = true;
+  return OkStatus();
+}
+
 std::vector<int> GetStackPushNodesToConvert(
     const GraphTopologyView& graph_view,
     const std::unordered_set<string>& nodes_to_preserve, int stack_node_idx) {
@@ -725,7 +1225,7 @@ LoopOptimizer::LoopOptimizer(RewriterConfig::Toggle opt_level,
                              DeviceBase* cpu_device)
     : opt_level_(opt_level),
       cpu_device_(cpu_device),
-      options_(LoopOptimizerOptions::Default(RewriterConfig::ON)) {
+      options_(LoopOptimizerOptions::Default(opt_level)) {
   resource_mgr_.reset(new ResourceMgr());
 }
 
@@ -739,8 +1239,24 @@ Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   *optimized_graph = item.graph;
   // Set up helper data structures.
   if (options_.enable_loop_invariant_node_motion) {
-    LoopInvariantNodeMotionOptimizer linm_optimizer(optimized_graph);
+    const std::unordered_set<string> nodes_to_preserve =
+        item.NodesToPreserve();
+    GraphProperties properties(item);
+    const Status inferred =
+        properties.InferStatically(/*assume_valid_feeds=*/false);
+    if (!inferred.ok()) {
+      VLOG(1) << "Not checking the size of loop invariant outputs, since "
+                 "shape inference failed: "
+              << inferred;
+    }
+    const GraphProperties* maybe_properties =
+        inferred.ok() ? &properties : nullptr;
+    LoopInvariantNodeMotionOptimizer linm_optimizer(
+        nodes_to_preserve, maybe_properties, optimized_graph);
     TF_RETURN_IF_ERROR(linm_optimizer.Optimize());
+    FunctionalWhileInvariantMotion functional_linm_optimizer(
+        nodes_to_preserve, maybe_properties, optimized_graph);
+    TF_RETURN_IF_ERROR(functional_linm_optimizer.Optimize());
   }
   if (options_.enable_stack_push_removal) {
     TF_RETURN_IF_ERROR(RemoveStackOps(item.NodesToPreserve(), optimized_graph));
@@ -40,7 +40,10 @@ class LoopOptimizer : public GraphOptimizer {
 
   string name() const override { return "loop_optimizer"; };
 
-  bool UsesFunctionLibrary() const override { return false; }
+  // Loop invariant node motion rewrites the bodies of functional loops.
+  bool UsesFunctionLibrary() const override {
+    return options_.enable_loop_invariant_node_motion;
+  }
 
   Status Optimize(Cluster* cluster, const GrapplerItem& item,
                   GraphDef* optimized_graph) override;
@@ -50,12 +53,16 @@ class LoopOptimizer : public GraphOptimizer {
 
   // Granular control for loop optimizer stages.
   struct LoopOptimizerOptions {
+    // Hoists pure loop invariant nodes out of while loops and functional
+    // While ops, if their outputs are not larger than their inputs.
     bool enable_loop_invariant_node_motion = false;
     bool enable_stack_push_removal = true;
     bool enable_dead_branch_removal = true;
 
     static LoopOptimizerOptions Default(RewriterConfig::Toggle opt_level) {
       LoopOptimizerOptions options;
+      options.enable_loop_invariant_node_motion =
+          opt_level == RewriterConfig::AGGRESSIVE;
       return options;
     }
   };
@@ -16,6 +16,8 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/grappler/grappler_item.h"
@@ -628,6 +630,200 @@ void VerifyGraphsEqual(const GraphDef& original_graph,
   }
 }
 
+TEST_F(LoopOptimizerTest, StatefulNodeIsNotHoisted) {
+  GraphDef graph;
+  AddSimpleNode("In", "Identity", {}, &graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AddSimpleNode("InvariantNeg", "Neg", {"InvariantEnter"}, &graph);
+  AddSimpleNode("Random", "RandomUniform", {"InvariantNeg"}, &graph);
+  AddSimpleNode("VariantAdd", "Add", {"Random", "Identity"}, &graph);
+  AddEnterNode("VariantEnter", "while/while_context", false, 1, {"In"}, &graph);
+  AddSimpleNode("Merge", "Merge", {"VariantEnter", "NextIteration"}, &graph);
+  AddSimpleNode("Less/y", "Const", {"^Identity"}, &graph);
+  AddSimpleNode("Less", "Less", {"VariantAdd", "Less/y"}, &graph);
+  AddSimpleNode("LoopCond", "LoopCond", {"Less"}, &graph);
+  AddSimpleNode("Switch", "Switch", {"Merge", "LoopCond"}, &graph);
+  AddSimpleNode("Identity", "Identity", {"Switch:1"}, &graph);
+  AddSimpleNode("NextIteration", "NextIteration", {"VariantAdd"}, &graph);
+  AddSimpleNode("Exit", "Exit", {"Switch"}, &graph);
+  AddSimpleNode("Out", "Identity", {"Exit"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  Status status;
+  utils::GraphView view(&output, &status);
+  TF_ASSERT_OK(status);
+  FrameView frames;
+  TF_EXPECT_OK(frames.InferFromGraphView(view));
+
+  // The negation is hoisted, but new random numbers must be generated on
+  // every iteration.
+  const auto* neg_node = view.GetNode("InvariantNeg");
+  ASSERT_NE(neg_node, nullptr);
+  EXPECT_EQ(frames.Frames(*neg_node->node()).size(), 0);
+  const auto* random_node = view.GetNode("Random");
+  ASSERT_NE(random_node, nullptr);
+  EXPECT_EQ(frames.Frames(*random_node->node()).size(), 1);
+}
+
+TEST_F(LoopOptimizerTest, LargeOutputIsNotHoisted) {
+  const auto type_attr = [](DataType type) {
+    AttrValue attr;
+    attr.set_type(type);
+    return attr;
+  };
+  const auto tensor_attr = [](const Tensor& tensor) {
+    AttrValue attr;
+    tensor.AsProtoTensorContent(attr.mutable_tensor());
+    return attr;
+  };
+  const auto add_const = [&](const string& name, const Tensor& value,
+                             const std::vector<string>& inputs,
+                             GraphDef* graph) {
+    AddNode(name, "Const", inputs,
+            {{"dtype", type_attr(value.dtype())},
+             {"value", tensor_attr(value)}},
+            graph);
+  };
+
+  GraphDef graph;
+  add_const("In", test::AsTensor<float>(std::vector<float>(16, 1.0f)), {},
+            &graph);
+  add_const("Multiples", test::AsTensor<int32>({100000}), {}, &graph);
+  add_const("Zero", test::AsScalar<float>(0.0f), {}, &graph);
+  AddEnterNode("InvariantEnter", "while/while_context", true, 1, {"In"},
+               &graph);
+  AddEnterNode("MultiplesEnter", "while/while_context", true, 1,
+               {"Multiples"}, &graph);
+  (*graph.mutable_node(graph.node_size() - 1)->mutable_attr())["T"] =
+      type_attr(DT_INT32);
+  // The tiled tensor is 100000 times larger than its input.
+  AddNode("InvariantTile", "Tile", {"InvariantEnter", "MultiplesEnter"},
+          {{"T", type_attr(DT_FLOAT)}, {"Tmultiples", type_attr(DT_INT32)}},
+          &graph);
+  AddSimpleNode("InvariantNeg", "Neg", {"InvariantEnter"}, &graph);
+  AddSimpleNode("VariantTileAdd", "Add", {"InvariantTile", "Identity"},
+                &graph);
+  AddSimpleNode("VariantAdd", "Add", {"InvariantNeg", "Identity"}, &graph);
+  AddEnterNode("VariantEnter", "while/while_context", false, 1, {"Zero"},
+               &graph);
+  AddSimpleNode("Merge", "Merge", {"VariantEnter", "NextIteration"}, &graph);
+  add_const("Less/y", test::AsScalar<float>(10.0f), {"^Identity"}, &graph);
+  AddSimpleNode("Less", "Less", {"Identity", "Less/y"}, &graph);
+  AddNode("LoopCond", "LoopCond", {"Less"}, {}, &graph);
+  AddSimpleNode("Switch", "Switch", {"Merge", "LoopCond"}, &graph);
+  AddSimpleNode("Identity", "Identity", {"Switch:1"}, &graph);
+  AddSimpleNode("NextIteration", "NextIteration", {"VariantAdd"}, &graph);
+  AddSimpleNode("Exit", "Exit", {"Switch"}, &graph);
+  AddSimpleNode("Out", "Identity", {"Exit"}, &graph);
+
+  GrapplerItem item;
+  item.graph = graph;
+  item.fetch = {"Out"};
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  Status status;
+  utils::GraphView view(&output, &status);
+  TF_ASSERT_OK(status);
+  FrameView frames;
+  TF_EXPECT_OK(frames.InferFromGraphView(view));
+
+  const auto* neg_node = view.GetNode("InvariantNeg");
+  ASSERT_NE(neg_node, nullptr);
+  EXPECT_EQ(frames.Frames(*neg_node->node()).size(), 0);
+  const auto* tile_node = view.GetNode("InvariantTile");
+  ASSERT_NE(tile_node, nullptr);
+  EXPECT_EQ(frames.Frames(*tile_node->node()).size(), 1);
+}
+
+TEST_F(LoopOptimizerTest, FunctionalWhile) {
+  using test::function::NDef;
+  using FDH = FunctionDefHelper;
+
+  // The body computes `(i + 1, x + w * w, w)`, where `w * w` is invariant.
+  const FunctionDef body = FDH::Create(
+      "Body", {"i: int32", "x: float", "w: float"},
+      {"i_out: int32", "x_out: float", "w_out: float"}, {},
+      {{{"one"}, "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}},
+       {{"i_next"}, "Add", {"i", "one:output:0"}, {{"T", DT_INT32}}},
+       {{"w_squared"}, "Square", {"w"}, {{"T", DT_FLOAT}}},
+       {{"x_next"}, "Add", {"x", "w_squared:y:0"}, {{"T", DT_FLOAT}}}},
+      {{"i_out", "i_next:z:0"}, {"x_out", "x_next:z:0"}, {"w_out", "w"}});
+  const FunctionDef cond = FDH::Create(
+      "Cond", {"i: int32", "x: float", "w: float"}, {"done: bool"}, {},
+      {{{"three"}, "Const", {}, {{"value", 3}, {"dtype", DT_INT32}}},
+       {{"less"}, "Less", {"i", "three:output:0"}, {{"T", DT_INT32}}}},
+      {{"done", "less:z:0"}});
+
+  const TensorShape shape({2, 2});
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("i", "Placeholder", {}, {{"dtype", DT_INT32}, {"shape", {}}}),
+       NDef("x", "Placeholder", {}, {{"dtype", DT_FLOAT}, {"shape", shape}}),
+       NDef("w", "Placeholder", {}, {{"dtype", DT_FLOAT}, {"shape", shape}}),
+       NDef("while", "While", {"i", "x", "w"},
+            {{"T", DataTypeSlice{DT_INT32, DT_FLOAT, DT_FLOAT}},
+             {"body", FDH::FunctionRef("Body")},
+             {"cond", FDH::FunctionRef("Cond")}}),
+       NDef("out", "Identity", {"while:1"}, {{"T", DT_FLOAT}})},
+      {body, cond});
+  item.fetch = {"out"};
+  item.feed = {{"i", test::AsScalar<int32>(0)},
+               {"x", test::AsTensor<float>({1, 2, 3, 4}, shape)},
+               {"w", test::AsTensor<float>({1, 2, 3, 4}, shape)}};
+
+  LoopOptimizer optimizer;
+  EnableOnlyLoopInvariantNodeMotion(&optimizer);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* hoisted = node_map.GetNode("LoopOptimizer/while/w_squared");
+  ASSERT_NE(hoisted, nullptr);
+  EXPECT_EQ(hoisted->op(), "Square");
+  ASSERT_EQ(hoisted->input_size(), 1);
+  EXPECT_EQ(hoisted->input(0), "w");
+
+  const NodeDef* while_node = node_map.GetNode("while");
+  ASSERT_NE(while_node, nullptr);
+  ASSERT_EQ(while_node->input_size(), 4);
+  EXPECT_EQ(while_node->input(3), "LoopOptimizer/while/w_squared");
+  EXPECT_EQ(while_node->attr().at("T").list().type_size(), 4);
+
+  FunctionLibraryDefinition flib(OpRegistry::Global(), output.library());
+  const FunctionDef* new_body =
+      flib.Find(while_node->attr().at("body").func().name());
+  ASSERT_NE(new_body, nullptr);
+  EXPECT_NE(new_body->signature().name(), "Body");
+  EXPECT_EQ(new_body->signature().input_arg_size(), 4);
+  EXPECT_EQ(new_body->signature().output_arg_size(), 4);
+  for (const NodeDef& node : new_body->node_def()) {
+    EXPECT_NE(node.op(), "Square");
+  }
+  const FunctionDef* new_cond =
+      flib.Find(while_node->attr().at("cond").func().name());
+  ASSERT_NE(new_cond, nullptr);
+  EXPECT_EQ(new_cond->signature().input_arg_size(), 4);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectTensorEqual<float>(
+      tensors[0], test::AsTensor<float>({4, 14, 30, 52}, shape));
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 TEST_F(LoopOptimizerTest, NoOp) {
   // This trivial graph is so basic there's nothing to optimize.
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <numeric>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -968,6 +969,47 @@ static bool IsSwappable(MutableGraphView::InputPort input) {
   return !IsRefType(dtype);
 }
 
+// Timing of a node in a simulated run of the graph.
+struct NodeTiming {
+  Costs::NanoSeconds completion_time;
+  Costs::NanoSeconds compute_time;
+};
+
+// Runs `item` on a virtual copy of `cluster`, and records the timing of every
+// node that ran.
+static bool SimulateNodeTimings(
+    Cluster* cluster, const GrapplerItem& item,
+    std::unordered_map<string, NodeTiming>* timings) {
+  VirtualCluster vcluster(cluster->GetDevices());
+  if (!vcluster.Provision().ok()) {
+    return false;
+  }
+  if (!vcluster.Initialize(item).ok()) {
+    return false;
+  }
+  RunMetadata metadata;
+  Status s = vcluster.Run(item.graph, item.feed, item.fetch, &metadata);
+  if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
+    return false;
+  }
+
+  for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      NodeTiming timing;
+      timing.completion_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.all_start_micros() +
+                              node_stats.op_end_rel_micros());
+      timing.compute_time =
+          Costs::NanoSeconds(1) +
+          Costs::MicroSeconds(node_stats.op_end_rel_micros() -
+                              node_stats.op_start_rel_micros());
+      timings->emplace(node_stats.node_name(), timing);
+    }
+  }
+  return true;
+}
+
 struct MemInfo {
   MutableGraphView::OutputPort port;
   int64_t memory_used;
@@ -1011,30 +1053,9 @@ static bool IdentifySwappingCandidates(
     }
     int64_t required_savings = mem_usage.used_memory - prop.memory_size();
 
-    std::unordered_map<string, Costs::NanoSeconds> op_completion_times;
-    {
-      VirtualCluster vcluster(cluster->GetDevices());
-      if (!vcluster.Provision().ok()) {
-        return false;
-      }
-      if (!vcluster.Initialize(*item).ok()) {
-        return false;
-      }
-      RunMetadata metadata;
-      Status s = vcluster.Run(item->graph, item->feed, item->fetch, &metadata);
-      if (!s.ok() && s.code() != error::RESOURCE_EXHAUSTED) {
-        return false;
-      }
-
-      for (const auto& dev_stats : metadata.step_stats().dev_stats()) {
-        for (const auto& node_stats : dev_stats.node_stats()) {
-          Costs::NanoSeconds exec_time =
-              Costs::NanoSeconds(1) +
-              Costs::MicroSeconds(node_stats.all_start_micros() +
-                                  node_stats.op_end_rel_micros());
-          op_completion_times.emplace(node_stats.node_name(), exec_time);
-        }
-      }
+    std::unordered_map<string, NodeTiming> timings;
+    if (!SimulateNodeTimings(cluster, *item, &timings)) {
+      return false;
     }
 
     Costs::Duration peak_time = -1;
@@ -1075,12 +1096,12 @@ static bool IdentifySwappingCandidates(
       bool valid = true;
       for (MutableGraphView::InputPort input : graph.GetFanout(port)) {
         // Get execution time.
-        auto it = op_completion_times.find(input.node->name());
-        if (it == op_completion_times.end()) {
+        auto it = timings.find(input.node->name());
+        if (it == timings.end()) {
           valid = false;
           break;
         }
-        if (it->second <= peak_time) {
+        if (it->second.completion_time <= peak_time) {
           continue;
         }
 
@@ -1101,7 +1122,7 @@ static bool IdentifySwappingCandidates(
 
         // Set earliest use time that's after peak.
         mem_info.uses_left.emplace_back(input);
-        earliest_use = std::min(earliest_use, it->second);
+        earliest_use = std::min(earliest_use, it->second.completion_time);
       }
       if (valid && !mem_info.uses_left.empty()) {
         // Compute the fitness: we need the tensor to be generated way away of
@@ -1150,9 +1171,10 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
                   Cluster* cluster, std::unique_ptr<GraphMemory>* memory,
                   GrapplerItem* item, std::unordered_set<string>* skip_list) {
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
+  // With HEURISTICS, the tensors to swap are picked together with the tensors
+  // to recompute by PeakMemoryPlanningPass().
   if (optimization_level == RewriterConfig::DEFAULT_MEM_OPT ||
-      optimization_level == RewriterConfig::SWAPPING_HEURISTICS ||
-      optimization_level == RewriterConfig::HEURISTICS) {
+      optimization_level == RewriterConfig::SWAPPING_HEURISTICS) {
     // Use heuristics to figure out what needs to be swapped;
     IdentifySwappingCandidates(cluster, item, memory, skip_list,
                                &nodes_to_swap);
@@ -1270,6 +1292,368 @@ bool SwappingPass(RewriterConfig::MemOptType optimization_level,
   return updated_graph;
 }
 
+// A tensor that is live at the peak memory usage of a device, and the ways to
+// free its memory until the uses that remain after the peak.
+struct PeakMemorySaving {
+  MutableGraphView::OutputPort port;
+  int64_t memory_used;
+  std::vector<MutableGraphView::InputPort> uses_left;
+  // Estimated increase of the step time if the tensor is swapped to the host
+  // or recomputed, or infinity if that is not possible.
+  Costs::NanoSeconds swap_cost = Costs::NanoSeconds::infinity();
+  Costs::NanoSeconds recompute_cost = Costs::NanoSeconds::infinity();
+  // Node after which the recomputation runs.
+  const NodeDef* recompute_trigger = nullptr;
+  // Tensors live at the peak that the recomputation reads, which must not be
+  // freed in turn.
+  std::vector<string> recompute_inputs;
+  // Set when the saving is selected.
+  bool recompute = false;
+
+  Costs::NanoSeconds cost() const {
+    return std::min(swap_cost, recompute_cost);
+  }
+};
+
+// Returns the input of `use` that completes last, if it completes after
+// `peak_time`, so that a recomputation of the input of `use` produced by
+// `producer` can be delayed until after the peak.
+const NodeDef* FindRecomputeTrigger(
+    const NodeDef& use, const string& producer, Costs::Duration peak_time,
+    const std::unordered_map<string, const NodeDef*>& name_map,
+    const std::unordered_map<const NodeDef*, Costs::NanoSeconds>&
+        completion_times) {
+  const NodeDef* trigger = nullptr;
+  Costs::NanoSeconds trigger_time(0);
+  for (const string& input : use.input()) {
+    const string input_node_name = NodeName(input);
+    if (input_node_name == producer) {
+      continue;
+    }
+    auto node_it = name_map.find(input_node_name);
+    if (node_it == name_map.end()) {
+      continue;
+    }
+    const NodeDef* input_node = node_it->second;
+    // Don't add control dependencies across frames or from branches.
+    if (ModifiesFrameInfo(*input_node) || IsSwitch(*input_node) ||
+        IsMerge(*input_node)) {
+      continue;
+    }
+    auto time_it = completion_times.find(input_node);
+    if (time_it != completion_times.end() && time_it->second > peak_time &&
+        time_it->second > trigger_time) {
+      trigger = input_node;
+      trigger_time = time_it->second;
+    }
+  }
+  return trigger;
+}
+
+// Selects savings that free at least `required_savings` bytes with the lowest
+// total cost. This is a minimum-cost covering problem: savings are taken in
+// order of cost per byte, and the most expensive ones that turn out to be
+// redundant are dropped. Returns the indices of the selected savings.
+std::vector<int> SelectPeakMemorySavings(
+    int64_t required_savings, std::vector<PeakMemorySaving>* savings) {
+  auto tensor_name = [](const MutableGraphView::OutputPort& port) {
+    return strings::StrCat(port.node->name(), ":", port.port_id);
+  };
+  std::vector<int> order(savings->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    const PeakMemorySaving& lhs = (*savings)[a];
+    const PeakMemorySaving& rhs = (*savings)[b];
+    const double lhs_cost =
+        static_cast<double>(lhs.cost().count()) / lhs.memory_used;
+    const double rhs_cost =
+        static_cast<double>(rhs.cost().count()) / rhs.memory_used;
+    if (lhs_cost != rhs_cost) return lhs_cost < rhs_cost;
+    return lhs.memory_used > rhs.memory_used;
+  });
+
+  std::unordered_set<string> selected_tensors;
+  // Tensors read by selected recomputations.
+  std::unordered_map<string, int> pinned_tensors;
+  std::vector<int> selected;
+  int64_t saved = 0;
+  for (int i : order) {
+    if (saved >= required_savings) break;
+    PeakMemorySaving& saving = (*savings)[i];
+    if (pinned_tensors.count(tensor_name(saving.port))) continue;
+    bool can_recompute = saving.recompute_cost < saving.swap_cost;
+    for (const string& input : saving.recompute_inputs) {
+      if (selected_tensors.count(input)) can_recompute = false;
+    }
+    if (!can_recompute && saving.swap_cost == Costs::NanoSeconds::infinity()) {
+      continue;
+    }
+    saving.recompute = can_recompute;
+    if (can_recompute) {
+      for (const string& input : saving.recompute_inputs) {
+        pinned_tensors[input]++;
+      }
+    }
+    selected_tensors.insert(tensor_name(saving.port));
+    selected.push_back(i);
+    saved += saving.memory_used;
+  }
+
+  // Drop the most expensive savings that are not needed to reach the target.
+  std::sort(selected.begin(), selected.end(), [&](int a, int b) {
+    return (*savings)[a].cost() > (*savings)[b].cost();
+  });
+  std::vector<int> result;
+  for (int i : selected) {
+    const PeakMemorySaving& saving = (*savings)[i];
+    if (saved - saving.memory_used >= required_savings) {
+      saved -= saving.memory_used;
+      continue;
+    }
+    result.push_back(i);
+  }
+  return result;
+}
+
+// Uses the cost model to find a set of tensors to swap to the host or to
+// recompute after the point of peak memory usage, so that the peak memory
+// usage of every device drops to `target_peak_memory` (or to the memory size
+// of the device if it is not positive) at the lowest estimated cost in step
+// time. Swaps are requested through the `_swap_to_host` attribute and
+// performed by SwappingPass(). Recomputations copy the node that produces the
+// tensor, and delay the copy with a control dependency on a node that runs
+// after the peak. `planned_tensors` holds the tensors considered in previous
+// passes.
+bool PeakMemoryPlanningPass(Cluster* cluster, int64_t target_peak_memory,
+                            std::unique_ptr<GraphMemory>* memory_ptr,
+                            GrapplerItem* item,
+                            std::unordered_set<string>* planned_tensors) {
+  if ((*memory_ptr) == nullptr) {
+    memory_ptr->reset(new GraphMemory(*item));
+    Status s = (*memory_ptr)->InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      memory_ptr->reset();
+      VLOG(1) << "Failed to infer memory usage: " << s.error_message();
+      return false;
+    }
+  }
+  const GraphMemory& memory = **memory_ptr;
+
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+  std::unordered_map<string, const NodeDef*> name_map;
+  for (const auto& node : item->graph.node()) {
+    name_map[node.name()] = &node;
+  }
+  std::unordered_map<string, NodeTiming> timings;
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> completion_times;
+  MutableGraphView graph(&item->graph);
+
+  std::vector<PeakMemorySaving> selected_savings;
+  for (const auto& device : cluster->GetDevices()) {
+    const string& name = device.first;
+    const DeviceProperties& prop = device.second;
+    const int64_t target =
+        target_peak_memory > 0 ? target_peak_memory : prop.memory_size();
+    if (target <= 0) {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& mem_usage = memory.GetPeakMemoryUsage(name);
+    if (mem_usage.used_memory <= target) {
+      continue;
+    }
+    const int64_t required_savings = mem_usage.used_memory - target;
+
+    if (timings.empty()) {
+      if (!SimulateNodeTimings(cluster, *item, &timings)) {
+        return false;
+      }
+      for (const auto& node : item->graph.node()) {
+        auto it = timings.find(node.name());
+        if (it != timings.end()) {
+          completion_times[&node] = it->second.completion_time;
+        }
+      }
+    }
+
+    Costs::Duration peak_time = -1;
+    std::unordered_map<string, const GraphMemory::LiveTensor*> live_tensors;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      peak_time = std::max(peak_time, live_tensor.allocation_time);
+      live_tensors[strings::StrCat(live_tensor.node, ":",
+                                   live_tensor.output_id)] = &live_tensor;
+    }
+
+    std::vector<PeakMemorySaving> savings;
+    for (const auto& live_tensor : mem_usage.live_tensors) {
+      const string tensor_name =
+          strings::StrCat(live_tensor.node, ":", live_tensor.output_id);
+      if (live_tensor.memory_used <= 1024 ||
+          planned_tensors->count(tensor_name)) {
+        // Don't bother with small tensors.
+        continue;
+      }
+      if (live_tensor.allocation_time >= peak_time) {
+        // Allocated by the node that runs at the peak.
+        continue;
+      }
+      PeakMemorySaving saving;
+      saving.port =
+          graph.GetOutputPort(live_tensor.node, live_tensor.output_id);
+      if (saving.port.node == nullptr) {
+        continue;
+      }
+      saving.memory_used = live_tensor.memory_used;
+
+      // Find the uses after the peak. The tensor can't be freed if one of its
+      // uses runs at the peak.
+      const NodeDef* earliest_use = nullptr;
+      Costs::NanoSeconds earliest_use_time = Costs::NanoSeconds::infinity();
+      bool valid = true;
+      for (MutableGraphView::InputPort input : graph.GetFanout(saving.port)) {
+        auto it = timings.find(input.node->name());
+        if (it == timings.end() || input.port_id < 0) {
+          valid = false;
+          break;
+        }
+        const NodeTiming& timing = it->second;
+        if (timing.completion_time <= peak_time) {
+          continue;
+        }
+        if (timing.completion_time - timing.compute_time <= peak_time) {
+          valid = false;
+          break;
+        }
+        saving.uses_left.push_back(input);
+        if (timing.completion_time < earliest_use_time) {
+          earliest_use_time = timing.completion_time;
+          earliest_use = input.node;
+        }
+      }
+      if (!valid || saving.uses_left.empty()) {
+        continue;
+      }
+
+      // Copies to and from the host overlap with the computation done between
+      // the allocation of the tensor and its next use. Let's assume we're going
+      // to swap over PCIe running at 16 GBps.
+      bool swappable = prop.type() == "GPU" && IsSwappable(graph, saving.port);
+      for (const auto& input : saving.uses_left) {
+        swappable = swappable && IsSwappable(input);
+      }
+      if (swappable) {
+        const Costs::NanoSeconds time_to_swap(2 * saving.memory_used / 16);
+        const Costs::NanoSeconds slack(
+            (earliest_use_time - live_tensor.allocation_time).count());
+        saving.swap_cost = std::max(Costs::NanoSeconds(0),
+                                    Costs::NanoSeconds(time_to_swap - slack));
+      }
+
+      // Recomputing the tensor costs the execution time of its producer, which
+      // must be deterministic and read tensors that are in memory anyway at
+      // the time of the uses left.
+      const NodeDef& producer = *saving.port.node;
+      bool recomputable =
+          !IsPersistent(producer) && !IsStateful(producer) &&
+          !ModifiesFrameInfo(producer) && !IsSwitch(producer) &&
+          !IsMerge(producer) && !feeds.count(producer.name()) &&
+          !name_map.count(
+              AddPrefixToNodeName(producer.name(), kRecomputedNodePrefix));
+      for (int i = 0; recomputable && i < producer.input_size(); ++i) {
+        if (IsControlInput(producer.input(i))) {
+          continue;
+        }
+        const TensorId input = ParseTensorName(producer.input(i));
+        auto node_it = name_map.find(string(input.node()));
+        if (node_it == name_map.end()) {
+          recomputable = false;
+          break;
+        }
+        if (IsConstant(*node_it->second) || IsPersistent(*node_it->second)) {
+          continue;
+        }
+        const string input_name = strings::StrCat(input.node(), ":",
+                                                  input.index());
+        auto live_it = live_tensors.find(input_name);
+        if (live_it == live_tensors.end() ||
+            live_it->second->deallocation_time < earliest_use_time) {
+          recomputable = false;
+          break;
+        }
+        saving.recompute_inputs.push_back(input_name);
+      }
+      auto timing_it = timings.find(producer.name());
+      if (recomputable && timing_it != timings.end()) {
+        saving.recompute_trigger =
+            FindRecomputeTrigger(*earliest_use, producer.name(), peak_time,
+                                 name_map, completion_times);
+        if (saving.recompute_trigger != nullptr) {
+          saving.recompute_cost = timing_it->second.compute_time;
+        }
+      }
+
+      if (saving.cost() < Costs::NanoSeconds::infinity()) {
+        savings.push_back(std::move(saving));
+      }
+    }
+
+    for (int i : SelectPeakMemorySavings(required_savings, &savings)) {
+      selected_savings.push_back(std::move(savings[i]));
+    }
+  }
+
+  for (const PeakMemorySaving& saving : selected_savings) {
+    NodeDef* producer = saving.port.node;
+    planned_tensors->insert(
+        strings::StrCat(producer->name(), ":", saving.port.port_id));
+    if (!saving.recompute) {
+      VLOG(1) << "Will swap tensor " << producer->name() << ":"
+              << saving.port.port_id << " of size " << saving.memory_used
+              << " at an estimated cost of " << saving.swap_cost.count()
+              << "ns";
+      for (const auto& input : saving.uses_left) {
+        AttrValue& val = (*input.node->mutable_attr())["_swap_to_host"];
+        if (!val.has_list()) {
+          const bool has_value = val.value_case() == AttrValue::kI;
+          const int64_t input_id = val.i();
+          val.mutable_list();
+          if (has_value) val.mutable_list()->add_i(input_id);
+        }
+        val.mutable_list()->add_i(input.port_id);
+      }
+      continue;
+    }
+
+    VLOG(1) << "Will recompute tensor " << producer->name() << ":"
+            << saving.port.port_id << " of size " << saving.memory_used
+            << " at an estimated cost of " << saving.recompute_cost.count()
+            << "ns";
+    const string recomputed_name =
+        AddPrefixToNodeName(producer->name(), kRecomputedNodePrefix);
+    if (!name_map.emplace(recomputed_name, nullptr).second) {
+      // The same node was selected on two devices.
+      continue;
+    }
+    NodeDef* recomputed_node = item->graph.add_node();
+    recomputed_node->set_name(recomputed_name);
+    recomputed_node->set_op(producer->op());
+    *recomputed_node->mutable_attr() = producer->attr();
+    recomputed_node->set_device(producer->device());
+    *recomputed_node->mutable_input() = producer->input();
+    *recomputed_node->add_input() =
+        strings::StrCat("^", saving.recompute_trigger->name());
+    for (const auto& input : saving.uses_left) {
+      *input.node->mutable_input(input.port_id) =
+          saving.port.port_id == 0
+              ? recomputed_name
+              : strings::StrCat(recomputed_name, ":", saving.port.port_id);
+    }
+  }
+  return !selected_savings.empty();
+}
+
 bool CrossesTaskOrCpuGpuBoundary(const NodeDef& node1, const NodeDef& node2) {
   string task1;
   string device1;
@@ -1401,6 +1785,7 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   std::unordered_set<string> skip_list;
+  std::unordered_set<string> planned_tensors;
   // Bound the number of rewrite passes to avoid long processing times on graphs
   // that simply won't fit in memory.
   // SchedulingPass() and SwappingPass() rely on defined fetches in order to
@@ -1422,6 +1807,15 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
         }
       }
 
+      GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
+      if (optimization_level_ == RewriterConfig::HEURISTICS &&
+          PeakMemoryPlanningPass(cluster, target_peak_memory_, &memory,
+                                 &optimized_item, &planned_tensors)) {
+        // Reset the inferred memory usage since the graph changed.
+        memory.reset();
+        updated_graph = true;
+      }
+
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
       if ((optimization_level_ == RewriterConfig::DEFAULT_MEM_OPT ||
            optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS ||
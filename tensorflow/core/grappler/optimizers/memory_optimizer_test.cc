@@ -393,6 +393,78 @@ TEST_F(MemoryOptimizerTest, UnswappableInputs) {
 #endif
 }
 
+TEST_F(MemoryOptimizerTest, PeakMemoryPlanning) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  // `a` is live at the peak memory usage, while `c` is computed, but only used
+  // after. It is cheaper to recompute it from `v` than to swap it.
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Exp(
+      s.WithOpName("b").WithDevice("/gpu:0").WithControlDependencies(a), v);
+  Output c = ops::Log(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::Add(s.WithOpName("d").WithDevice("/gpu:0"), c, a);
+
+  Output constant = ops::Const(s.WithOpName("constant"), 0.0f, {128, 128, 8});
+  Output init = ops::Assign(s.WithOpName("init"), v, constant);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"d"};
+  item.init_ops = {init.name()};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  NodeMap node_map(&output);
+  const NodeDef* new_d = node_map.GetNode("d");
+  ASSERT_NE(new_d, nullptr);
+  EXPECT_EQ(2, new_d->input_size());
+  EXPECT_EQ("c", new_d->input(0));
+  EXPECT_EQ("Recomputed/a", new_d->input(1));
+  const NodeDef* recomputed_a = node_map.GetNode("Recomputed/a");
+  ASSERT_NE(recomputed_a, nullptr);
+  EXPECT_EQ("Square", recomputed_a->op());
+  ASSERT_EQ(2, recomputed_a->input_size());
+  EXPECT_EQ("v", recomputed_a->input(0));
+  // The recomputation waits until after the peak.
+  EXPECT_EQ("^c", recomputed_a->input(1));
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  auto tensors_expected = EvaluateFetchNodes(item);
+  GrapplerItem optimized = item.WithGraph(std::move(output));
+  auto tensors = EvaluateFetchNodes(optimized);
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+#endif
+}
+
+TEST_F(MemoryOptimizerTest, PeakMemoryPlanningBelowTarget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v").WithDevice("/gpu:0"),
+                           {128, 128, 8}, DT_FLOAT);
+  Output a = ops::Square(s.WithOpName("a").WithDevice("/gpu:0"), v);
+  Output b = ops::Exp(s.WithOpName("b").WithDevice("/gpu:0"), v);
+  Output c = ops::Log(s.WithOpName("c").WithDevice("/gpu:0"), b);
+  Output d = ops::Add(s.WithOpName("d").WithDevice("/gpu:0"), c, a);
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"d"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  // The peak memory usage is already below the target.
+  MemoryOptimizer optimizer(RewriterConfig::HEURISTICS, "gradients/",
+                            /*target_peak_memory=*/int64_t{1} << 30);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  CompareGraphs(item.graph, output);
+}
+
 TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   tensorflow::Scope s = tensorflow::Scope::NewRootScope();
   Output a = ops::RandomNormal(s.WithOpName("a").WithDevice("/cpu:0"),
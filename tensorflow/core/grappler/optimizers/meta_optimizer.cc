@@ -57,10 +57,19 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/grappler/utils/tpu.h"
 #include "tensorflow/core/grappler/verifiers/structure_verifier.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/public/version.h"
 #include "tensorflow/core/util/dump_graph.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/ptr_util.h"
 #include "tensorflow/core/util/util.h"
 #include "tensorflow/core/util/xla_config_registry.h"
@@ -126,6 +135,20 @@ FunctionDefLibrary GetFunctionDefLibraryStub(
   return stub;
 }
 
+// Returns the number of threads used to optimize the functions of the library,
+// which can be overridden with TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS. A
+// value of 1 optimizes them one after another.
+int NumFunctionOptimizationThreads() {
+  static const int num_threads = [] {
+    int64_t num_threads;
+    TF_CHECK_OK(ReadInt64FromEnvVar(
+        "TF_GRAPPLER_FUNCTION_OPTIMIZATION_THREADS",
+        std::min(4, port::MaxParallelism()), &num_threads));
+    return static_cast<int>(std::max<int64_t>(num_threads, 1));
+  }();
+  return num_threads;
+}
+
 uint64 DeadlineMicroSeconds(const RewriterConfig& cfg) {
   if (cfg.meta_optimizer_timeout_ms() <= 0) return 0;  // no deadline
   return Env::Default()->NowMicros() + cfg.meta_optimizer_timeout_ms() * 1000;
@@ -184,6 +207,99 @@ Status GetGraphDevice(const GraphDef& g_def, std::set<std::string>* devices) {
   return OkStatus();
 }
 
+// Returns the key of the optimized graph cache for `item`. The graph is
+// fingerprinted like `tensorflow::saved_model::fingerprinting::ComputeHash()`,
+// and combined with everything else that affects the optimized graph.
+uint64 OptimizedGraphCacheKey(const GrapplerItem& item, const ConfigProto& cfg,
+                              Cluster* cluster) {
+  string serialized;
+  SerializeToStringDeterministic(item.graph, &serialized);
+  uint64 key = Fingerprint64(serialized);
+
+  key = FingerprintCat64(key, Fingerprint64(TF_VERSION_STRING));
+  key = FingerprintCat64(key, TF_GRAPH_DEF_VERSION);
+
+  GraphOptions graph_options = cfg.graph_options();
+  graph_options.mutable_rewrite_options()
+      ->clear_experimental_optimized_graph_cache_dir();
+  SerializeToStringDeterministic(graph_options, &serialized);
+  key = FingerprintCat64(key, Fingerprint64(serialized));
+
+  std::vector<string> names;
+  for (const string& fetch : item.fetch) names.push_back(fetch);
+  key = FingerprintCat64(key, Fingerprint64(absl::StrJoin(names, ",")));
+  names.assign(item.keep_ops.begin(), item.keep_ops.end());
+  key = FingerprintCat64(key, Fingerprint64(absl::StrJoin(names, ",")));
+  names.clear();
+  for (const auto& feed : item.feed) names.push_back(feed.first);
+  key = FingerprintCat64(key, Fingerprint64(absl::StrJoin(names, ",")));
+
+  const GrapplerItem::OptimizationOptions& options =
+      item.optimization_options();
+  const uint64 option_bits =
+      static_cast<uint64>(options.allow_non_differentiable_rewrites) |
+      static_cast<uint64>(options.allow_pruning_stateful_and_dataset_ops) << 1 |
+      static_cast<uint64>(options.optimize_function_library) << 2 |
+      static_cast<uint64>(options.is_eager_mode) << 3;
+  key = FingerprintCat64(key, option_bits);
+
+  names.assign(item.devices().begin(), item.devices().end());
+  std::sort(names.begin(), names.end());
+  key = FingerprintCat64(key, Fingerprint64(absl::StrJoin(names, ",")));
+  if (cluster != nullptr) {
+    std::map<string, DeviceProperties> devices(cluster->GetDevices().begin(),
+                                               cluster->GetDevices().end());
+    for (const auto& device : devices) {
+      SerializeToStringDeterministic(device.second, &serialized);
+      key = FingerprintCat64(key, Fingerprint64(device.first));
+      key = FingerprintCat64(key, Fingerprint64(serialized));
+    }
+  }
+  return key;
+}
+
+string OptimizedGraphCachePath(const string& cache_dir, uint64 key) {
+  return io::JoinPath(
+      cache_dir,
+      strings::StrCat(strings::Hex(key, strings::kZeroPad16), ".pb"));
+}
+
+// Reads the optimized graph cached under `key`, and returns whether there was
+// one.
+bool LookupOptimizedGraph(const string& cache_dir, uint64 key,
+                          GraphDef* optimized_graph) {
+  Env* env = Env::Default();
+  const string path = OptimizedGraphCachePath(cache_dir, key);
+  if (!env->FileExists(path).ok()) return false;
+  GraphDef graph;
+  Status s = ReadBinaryProto(env, path, &graph);
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to read the optimized graph cache entry " << path
+                 << ": " << s;
+    return false;
+  }
+  *optimized_graph = std::move(graph);
+  return true;
+}
+
+// Writes `optimized_graph` to the cache. The entry is written to a temporary
+// file and renamed, so that concurrent readers never see a partial graph.
+Status StoreOptimizedGraph(const string& cache_dir, uint64 key,
+                           const GraphDef& optimized_graph) {
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(cache_dir));
+  const string path = OptimizedGraphCachePath(cache_dir, key);
+  string tmp_path = absl::StrCat(path, ".");
+  if (!env->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file name for ",
+                            path);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, optimized_graph));
+  Status s = env->RenameFile(tmp_path, path);
+  if (!s.ok()) env->DeleteFile(tmp_path).IgnoreError();
+  return s;
+}
+
 }  // namespace
 
 #define MK_OPT(NAME, CONFIG, VALUE)                                    \
@@ -238,6 +354,8 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::MakeNewOptimizer(
 #endif
   MK_OPT("auto_mixed_precision_cpu", "auto_mixed_precision_cpu",
          new AutoMixedPrecision(AutoMixedPrecisionMode::CPU));
+  MK_OPT("auto_mixed_precision_native_cpu", "auto_mixed_precision_native_cpu",
+         new AutoMixedPrecision(AutoMixedPrecisionMode::NATIVE_CPU));
   MK_OPT("memory", "memory_optimization",
          new MemoryOptimizer(RewriterConfig::MANUAL));
   MK_OPT("common_subgraph_elimination", "common_subgraph_elimination",
@@ -398,6 +516,12 @@ Status MetaOptimizer::InitializeOptimizers(
     optimizers->push_back(
         MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::CPU));
   }
+  if (AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_native_cpu()) &&
+      AutoMixedPrecisionEnabled(
+          plugin_configs.toggle_config["auto_mixed_precision_native_cpu"])) {
+    optimizers->push_back(
+        MakeUnique<AutoMixedPrecision>(AutoMixedPrecisionMode::NATIVE_CPU));
+  }
   if (BOTH_ARE_ON(pin_to_host_optimization))
     optimizers->push_back(MakeUnique<PinToHostOptimizer>());
   else if (BOTH_ARE_EXPERIMENTAL_MLIR(pin_to_host_optimization) ||
@@ -647,6 +771,10 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_cpu())
             ? RewriterConfig::ON
             : RewriterConfig::OFF;
+    user_cfg.toggle_config["auto_mixed_precision_native_cpu"] =
+        AutoMixedPrecisionEnabled(cfg_.auto_mixed_precision_native_cpu())
+            ? RewriterConfig::ON
+            : RewriterConfig::OFF;
     user_cfg.toggle_config["memory_optimization"] =
         MemoryOptimizerEnabled(cfg_.memory_optimization(),
                                config_proto_.graph_options()
@@ -677,6 +805,8 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
                 "auto_mixed_precision_onednn_bfloat16")
       PRINT_CFG("auto_mixed_precision_mkl", "auto_mixed_precision_mkl")
       PRINT_CFG("auto_mixed_precision_cpu", "auto_mixed_precision_cpu")
+      PRINT_CFG("auto_mixed_precision_native_cpu",
+                "auto_mixed_precision_native_cpu")
       PRINT_CFG("pin_to_host", "pin_to_host_optimization")
       PRINT_CFG("layout", "layout_optimizer")
       PRINT_CFG("remap", "remapping")
@@ -718,6 +848,7 @@ void MetaOptimizer::PrintUserAndPluginConfigs(
         pair.first == "auto_mixed_precision_onednn_bfloat16" ||
         pair.first == "auto_mixed_precision_mkl" ||
         pair.first == "auto_mixed_precision_cpu" ||
+        pair.first == "auto_mixed_precision_native_cpu" ||
         pair.first == "pin_to_host_optimization" ||
         pair.first == "scoped_allocator_optimization") {
       // These optimizers are turned off by default.
@@ -877,7 +1008,10 @@ Status MetaOptimizer::OptimizeGraph(
                                    }) != optimization_result.results.end();
 
   // Record graph optimization result.
-  optimization_results_.push_back(optimization_result);
+  {
+    mutex_lock l(results_mu_);
+    optimization_results_.push_back(optimization_result);
+  }
 
   if (is_optimized) {
     TF_RETURN_IF_ERROR(TopologicalSort(optimized_graph));
@@ -979,6 +1113,57 @@ Status MetaOptimizer::RunOptimizer(
   return OkStatus();
 }
 
+bool MetaOptimizer::CanOptimizeFunctionsInParallel(
+    const GraphDef& graph) const {
+  // Custom and plugin optimizers are not known to be thread-safe.
+  if (!cfg_.custom_optimizers().empty()) return false;
+  const std::vector<string> custom_optimizers =
+      CustomGraphOptimizerRegistry::GetRegisteredOptimizers();
+  for (const string& optimizer_name : cfg_.optimizers()) {
+    if (std::find(custom_optimizers.begin(), custom_optimizers.end(),
+                  optimizer_name) != custom_optimizers.end()) {
+      return false;
+    }
+  }
+  if (cfg_.use_plugin_optimizers() != RewriterConfig::OFF) {
+    std::set<string> device_types;
+    if (!GetGraphDevice(graph, &device_types).ok() ||
+        !PluginGraphOptimizerRegistry::CreateOptimizers(device_types).empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MetaOptimizer::RecordFunctionOptimizationTime(const string& func_name,
+                                                   uint64 usecs) {
+  VLOG(2) << "Optimized function " << func_name << " in " << usecs / 1000.0f
+          << "ms";
+  function_optimization_usecs_[func_name] = usecs;
+  tensorflow::metrics::GetGraphOptimizationCounter()
+      ->GetCell(kGrapplerCategory, "OptimizeFunction")
+      ->IncrementBy(usecs);
+}
+
+void MetaOptimizer::SortOptimizationResults(
+    size_t first_result, const std::vector<GrapplerFunctionItem>& func_items) {
+  absl::flat_hash_map<string, size_t> order;
+  for (size_t i = 0; i < func_items.size(); ++i) {
+    order.emplace(func_items[i].id, i);
+  }
+  const auto position = [&order](const GraphOptimizationResult& result) {
+    auto it = order.find(result.id);
+    return it == order.end() ? order.size() : it->second;
+  };
+  mutex_lock l(results_mu_);
+  std::stable_sort(optimization_results_.begin() + first_result,
+                   optimization_results_.end(),
+                   [&](const GraphOptimizationResult& a,
+                       const GraphOptimizationResult& b) {
+                     return position(a) < position(b);
+                   });
+}
+
 // Propagates `_tf_data_function` attributes from functions to their callees.
 void PropagateTFDataAttrs(const FunctionLibraryDefinition& flib,
                           FunctionDefLibrary& fdef_lib) {
@@ -1043,7 +1228,11 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       {kGrapplerCategory, "*"});
 
   VLOG(1) << "Starting optimization for grappler item: " << item.id;
-  optimization_results_.clear();
+  {
+    mutex_lock l(results_mu_);
+    optimization_results_.clear();
+  }
+  function_optimization_usecs_.clear();
 
   // Constructs a FunctionLibraryDefinition with functions that are reachable
   // from the nodes of the graph.
@@ -1152,11 +1341,79 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
   // True if this is a TPU graph using the old bridge.
   bool is_tpu_graph = IsLegacyTPUBridgeGraphDef(*optimized_graph);
 
+  // Optimizes the body of `func_item` into `optimized_func_graph`.
+  const auto optimize_function_body =
+      [&](GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> Status {
+    if (is_tpu_graph) {
+      // Skip optimizing functions if this is a TPU graph. Currently, Grappler
+      // passes do not handle TPU functions correctly in a variety of ways
+      // (Note that due to the pre-placement TPU graph rewriting passes, the
+      // TPU-related ops are encapsulated away into functions). For example,
+      // TPU graphs contain TPUReplicateMetadata node that carries relevant
+      // TPU metadata and Grappler passes could prune that away. Grappler
+      // passes could also cause issues around shape inference. Since the
+      // desired and existing behavior is to not optimize TPU functions with
+      // Grappler, this check preserves that. The only exception is
+      // implementation selector what is required to swap in some TPU specific
+      // lowering code and is verified the work correctly on TPUs.
+      ImplementationSelector implementation_selector;
+
+      // Implementation selector needs to have access to valid function
+      // signature and attributes, and it doesn't need actual function body.
+      std::unique_ptr<FunctionDefLibrary> func_item_function_library(
+          func_item->graph.release_library());
+      *func_item->graph.mutable_library() =
+          GetFunctionDefLibraryStub(*func_item_function_library);
+
+      return implementation_selector.Optimize(cluster, *func_item,
+                                              optimized_func_graph);
+    }
+    GrapplerFunctionItem func_item_copy = *func_item;
+    return OptimizeGraph(cluster, std::move(func_item_copy),
+                         optimized_func_graph);
+  };
+
+  // Replaces the function of `func_item` in `flib` with its optimized body.
+  const auto replace_function =
+      [&](GrapplerFunctionItem* func_item,
+          GraphDef* optimized_func_graph) -> Status {
+    // Function body optimization might have created new specialized
+    // functions for each instantiation context. Add them to the library.
+    for (const FunctionDef& func_def :
+         optimized_func_graph->library().function()) {
+      if (flib.Find(func_def.signature().name()) == nullptr) {
+        TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
+      }
+    }
+
+    // Convert optimized graph back to FunctionDef.
+    FunctionDef optimized_func;
+    const string func_name = func_item->id;
+    func_item->SwapFunctionBody(std::move(*optimized_func_graph));
+    TF_RETURN_IF_ERROR(MakeFunctionDef(*func_item, flib, &optimized_func));
+
+    // Replace optimized function with a new FunctionDef.
+    return flib.ReplaceFunction(func_name, optimized_func);
+  };
+
+  // Functions of one pass over the library are optimized concurrently when
+  // possible. Each of them only sees the library as it was at the start of
+  // the pass, and they are added back to the library in library order, so
+  // the result does not depend on the scheduling.
+  const int num_threads =
+      CanOptimizeFunctionsInParallel(*optimized_graph)
+          ? NumFunctionOptimizationThreads()
+          : 1;
+  std::unique_ptr<thread::ThreadPool> function_pool;
+
   // Optimize each function only once.
   absl::flat_hash_set<string> optimized_funcs;
   while (optimize_function_library) {
     optimize_function_library = false;
 
+    // Functions to optimize concurrently in this pass.
+    std::vector<GrapplerFunctionItem> func_items;
     int function_idx = 0;
     for (const FunctionDef& func : optimized_graph->library().function()) {
       GRAPPLER_RETURN_IF_DEADLINE_EXCEEDED();
@@ -1214,53 +1471,59 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
       func_item.optimization_options().allow_pruning_stateful_and_dataset_ops =
           false;
 
+      if (num_threads > 1) {
+        func_items.push_back(std::move(func_item));
+        continue;
+      }
+
       // Optimize function body graph.
       GraphDef optimized_func_graph;
-      if (is_tpu_graph) {
-        // Skip optimizing functions if this is a TPU graph. Currently, Grappler
-        // passes do not handle TPU functions correctly in a variety of ways
-        // (Note that due to the pre-placement TPU graph rewriting passes, the
-        // TPU-related ops are encapsulated away into functions). For example,
-        // TPU graphs contain TPUReplicateMetadata node that carries relevant
-        // TPU metadata and Grappler passes could prune that away. Grappler
-        // passes could also cause issues around shape inference. Since the
-        // desired and existing behavior is to not optimize TPU functions with
-        // Grappler, this check preserves that. The only exception is
-        // implementation selector what is required to swap in some TPU specific
-        // lowering code and is verified the work correctly on TPUs.
-        ImplementationSelector implementation_selector;
-
-        // Implementation selector needs to have access to valid function
-        // signature and attributes, and it doesn't need actual function body.
-        std::unique_ptr<FunctionDefLibrary> func_item_function_library(
-            func_item.graph.release_library());
-        *func_item.graph.mutable_library() =
-            GetFunctionDefLibraryStub(*func_item_function_library);
-
-        TF_RETURN_IF_ERROR(implementation_selector.Optimize(
-            cluster, func_item, &optimized_func_graph));
-      } else {
-        GrapplerFunctionItem func_item_copy = func_item;
-        TF_RETURN_IF_ERROR(OptimizeGraph(cluster, std::move(func_item_copy),
-                                         &optimized_func_graph));
-      }
+      const uint64 start_usecs = Env::Default()->NowMicros();
+      TF_RETURN_IF_ERROR(
+          optimize_function_body(&func_item, &optimized_func_graph));
+      RecordFunctionOptimizationTime(func_name,
+                                     Env::Default()->NowMicros() - start_usecs);
+      TF_RETURN_IF_ERROR(
+          replace_function(&func_item, &optimized_func_graph));
+    }
 
-      // Function body optimization might have created new specialized
-      // functions for each instantiation context. Add them to the library.
-      for (const FunctionDef& func_def :
-           optimized_func_graph.library().function()) {
-        if (flib.Find(func_def.signature().name()) == nullptr) {
-          TF_RETURN_IF_ERROR(flib.AddFunctionDef(func_def));
-        }
+    if (!func_items.empty()) {
+      if (function_pool == nullptr) {
+        function_pool = std::make_unique<thread::ThreadPool>(
+            Env::Default(), "grappler_function_optimizer", num_threads);
       }
+      size_t first_result;
+      {
+        mutex_lock l(results_mu_);
+        first_result = optimization_results_.size();
+      }
+      std::vector<GraphDef> optimized_func_graphs(func_items.size());
+      std::vector<Status> statuses(func_items.size());
+      std::vector<uint64> durations_usecs(func_items.size());
+      BlockingCounter counter(func_items.size());
+      for (size_t i = 0; i < func_items.size(); ++i) {
+        function_pool->Schedule([&, i]() {
+          if (DeadlineExceeded()) {
+            statuses[i] =
+                errors::DeadlineExceeded(name(), " exceeded deadline.");
+          } else {
+            const uint64 start_usecs = Env::Default()->NowMicros();
+            statuses[i] = optimize_function_body(&func_items[i],
+                                                 &optimized_func_graphs[i]);
+            durations_usecs[i] = Env::Default()->NowMicros() - start_usecs;
+          }
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
 
-      // Convert optimized graph back to FunctionDef.
-      FunctionDef optimized_func;
-      func_item.SwapFunctionBody(std::move(optimized_func_graph));
-      TF_RETURN_IF_ERROR(MakeFunctionDef(func_item, flib, &optimized_func));
-
-      // Replace optimized function with a new FunctionDef.
-      TF_RETURN_IF_ERROR(flib.ReplaceFunction(func_name, optimized_func));
+      SortOptimizationResults(first_result, func_items);
+      for (size_t i = 0; i < func_items.size(); ++i) {
+        TF_RETURN_IF_ERROR(statuses[i]);
+        RecordFunctionOptimizationTime(func_items[i].id, durations_usecs[i]);
+        TF_RETURN_IF_ERROR(
+            replace_function(&func_items[i], &optimized_func_graphs[i]));
+      }
     }
 
     // If optimized at least one function, update the graph library.
@@ -1309,10 +1572,16 @@ Status MetaOptimizer::OptimizeConsumeItem(Cluster* cluster, GrapplerItem&& item,
 
 string MetaOptimizer::GetResultString() const {
   std::string result_string;
+  mutex_lock l(results_mu_);
   for (const GraphOptimizationResult& graph_result : optimization_results_) {
-    absl::StrAppend(&result_string,
-                    "Optimization results for grappler item: ", graph_result.id,
-                    "\n");
+    absl::StrAppend(&result_string, "Optimization results for grappler item: ",
+                    graph_result.id);
+    const uint64* usecs =
+        gtl::FindOrNull(function_optimization_usecs_, graph_result.id);
+    if (usecs != nullptr) {
+      absl::StrAppend(&result_string, " (time = ", *usecs / 1000.0f, "ms)");
+    }
+    absl::StrAppend(&result_string, "\n");
     for (const OptimizerResult& result : graph_result.results) {
       absl::StrAppend(&result_string, "  ", result.optimizer_name, ": ",
                       result.message, "\n");
@@ -1350,6 +1619,8 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
              rewrite_cfg.auto_mixed_precision_onednn_bfloat16()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_mkl()) ||
          AutoMixedPrecisionEnabled(rewrite_cfg.auto_mixed_precision_cpu()) ||
+         AutoMixedPrecisionEnabled(
+             rewrite_cfg.auto_mixed_precision_native_cpu()) ||
          !rewrite_cfg.optimizers().empty() ||
          !rewrite_cfg.custom_optimizers().empty();
 }
@@ -1357,11 +1628,35 @@ bool MetaOptimizerEnabled(const ConfigProto& cfg) {
 Status RunMetaOptimizer(GrapplerItem&& item, const ConfigProto& cfg,
                         DeviceBase* cpu_device, Cluster* cluster,
                         GraphDef* optimized_graph) {
+  const string& cache_dir = cfg.graph_options()
+                                .rewrite_options()
+                                .experimental_optimized_graph_cache_dir();
+  uint64 cache_key = 0;
+  if (!cache_dir.empty()) {
+    cache_key = OptimizedGraphCacheKey(item, cfg, cluster);
+    if (LookupOptimizedGraph(cache_dir, cache_key, optimized_graph)) {
+      VLOG(1) << "Optimized graph cache hit for " << item.id << " in "
+              << cache_dir;
+      return OkStatus();
+    }
+    VLOG(1) << "Optimized graph cache miss for " << item.id << " in "
+            << cache_dir;
+  }
+
   MetaOptimizer optimizer(cpu_device, cfg);
   optimizer.set_deadline_usec(
       DeadlineMicroSeconds(cfg.graph_options().rewrite_options()));
-  return optimizer.OptimizeConsumeItem(cluster, std::move(item),
-                                       optimized_graph);
+  TF_RETURN_IF_ERROR(optimizer.OptimizeConsumeItem(cluster, std::move(item),
+                                                   optimized_graph));
+
+  if (!cache_dir.empty()) {
+    Status s = StoreOptimizedGraph(cache_dir, cache_key, *optimized_graph);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to write the optimized graph cache entry in "
+                   << cache_dir << ": " << s;
+    }
+  }
+  return OkStatus();
 }
 
 Status OptimizeGraph(
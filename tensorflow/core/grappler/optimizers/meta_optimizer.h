@@ -16,14 +16,18 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 #define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_META_OPTIMIZER_H_
 
+#include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/verifiers/graph_verifier.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/protobuf/verifier_config.pb.h"
@@ -118,7 +122,24 @@ class MetaOptimizer : public GraphOptimizer {
                       GrapplerItem* optimized_item, GraphDef* optimized_graph,
                       GraphOptimizationResult* optimization_result);
 
-  std::vector<GraphOptimizationResult> optimization_results_;
+  // Returns true if the functions in the library of `graph` can be optimized
+  // concurrently, i.e. if all the configured optimizers are built-in ones.
+  bool CanOptimizeFunctionsInParallel(const GraphDef& graph) const;
+
+  // Records the time spent optimizing the body of function `func_name`.
+  void RecordFunctionOptimizationTime(const string& func_name, uint64 usecs);
+
+  // Sorts the results recorded from index `first_result` in the order of
+  // `func_items`, since they are recorded in completion order when the
+  // functions are optimized concurrently.
+  void SortOptimizationResults(
+      size_t first_result, const std::vector<GrapplerFunctionItem>& func_items);
+
+  mutable mutex results_mu_;
+  std::vector<GraphOptimizationResult> optimization_results_
+      TF_GUARDED_BY(results_mu_);
+  // Time spent optimizing each function of the library, in microseconds.
+  absl::flat_hash_map<string, uint64> function_optimization_usecs_;
 };
 
 bool MetaOptimizerEnabled(const ConfigProto& cfg);
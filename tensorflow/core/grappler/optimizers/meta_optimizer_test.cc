@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/grappler_test.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -420,6 +421,73 @@ TEST_F(MetaOptimizerTest, OptimizeFunctionLibrary) {
   test::ExpectTensorEqual<int>(tensors_expected[1], tensors[1]);
 }
 
+TEST_F(MetaOptimizerTest, OptimizeManyFunctionsDeterministically) {
+  using test::function::NDef;
+
+  ConfigProto config_proto;
+  auto& rewriter_config =
+      *config_proto.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.set_meta_optimizer_iterations(RewriterConfig::TWO);
+  rewriter_config.set_function_optimization(RewriterConfig::ON);
+  rewriter_config.add_optimizers("function");
+  rewriter_config.add_optimizers("arithmetic");
+  rewriter_config.set_min_graph_nodes(-1);
+
+  // Define independent noinline functions MySquare_i(x) = x * x, which are
+  // optimized concurrently, and call each of them from the graph.
+  constexpr int kNumFunctions = 16;
+  std::vector<FunctionDef> funcs;
+  std::vector<NodeDef> nodes = {
+      NDef("a", "Placeholder", {}, {{"dtype", DT_FLOAT}}, kDevice)};
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const string func_name = absl::StrCat("MySquare_", i);
+    FunctionDef func = FunctionDefHelper::Create(
+        func_name, {"x:float"}, {"z:float"}, {},
+        {{{"mul"}, "Mul", {"x", "x"}, {{"T", DT_FLOAT}}}},
+        /*ret_def=*/
+        {{"z", "mul:z:0"}});
+    (*func.mutable_attr())["_noinline"].set_b(true);
+    funcs.push_back(func);
+    nodes.push_back(
+        NDef(absl::StrCat("call_", i), func_name, {"a"}, {}, kDevice));
+  }
+
+  GrapplerItem item;
+  item.id = "tf_graph";
+  item.graph = test::function::GDef(nodes, funcs);
+
+  GraphDef output;
+  MetaOptimizer optimizer(nullptr, config_proto);
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // Optimizing the same graph again gives the same result.
+  GraphDef output_again;
+  MetaOptimizer optimizer_again(nullptr, config_proto);
+  TF_EXPECT_OK(optimizer_again.Optimize(nullptr, item, &output_again));
+  EXPECT_EQ(output.library().DebugString(),
+            output_again.library().DebugString());
+
+  // Every function body is optimized and reported with its time.
+  const string result = optimizer.GetResultString();
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const string header = absl::StrCat(
+        "Optimization results for grappler item: MySquare_", i, " (time = ");
+    EXPECT_TRUE(absl::StrContains(result, header)) << result;
+  }
+  FunctionLibraryDefinition optimized_flib(OpRegistry::Global(),
+                                           output.library());
+  for (int i = 0; i < kNumFunctions; ++i) {
+    const FunctionDef* func = optimized_flib.Find(absl::StrCat("MySquare_", i));
+    ASSERT_NE(func, nullptr);
+    // Arithmetic optimizer rewrites `x * x` into `Square(x)`.
+    bool has_mul = false;
+    for (const NodeDef& node : func->node_def()) {
+      if (node.op() == "Mul") has_mul = true;
+    }
+    EXPECT_FALSE(has_mul);
+  }
+}
+
 TEST_F(MetaOptimizerTest, OptimizeFunctionLibraryPruneUnusedOutputs) {
   using test::function::NDef;
 
@@ -749,6 +817,52 @@ TEST_F(MetaOptimizerTest, OptimizerTimesOut) {
   CompareGraphs(original, output);
 }
 
+TEST_F(MetaOptimizerTest, CachesOptimizedGraph) {
+  TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
+  GrapplerItem item;
+  ASSERT_TRUE(fake_input.NextItem(&item));
+
+  ConfigProto config;
+  RewriterConfig& rewriter_config =
+      *config.mutable_graph_options()->mutable_rewrite_options();
+  rewriter_config.add_optimizers("TestOptimizer");
+  rewriter_config.set_min_graph_nodes(-1);
+  rewriter_config.set_experimental_optimized_graph_cache_dir(
+      io::JoinPath(testing::TmpDir(), "optimized_graph_cache"));
+
+  // The first run misses and fills the cache.
+  TestOptimizer::SetOptimized(false);
+  GrapplerItem item_copy = item;
+  GraphDef first;
+  TF_EXPECT_OK(
+      RunMetaOptimizer(std::move(item_copy), config, nullptr, nullptr, &first));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // The second run hits and does not run the optimizers.
+  TestOptimizer::SetOptimized(false);
+  item_copy = item;
+  GraphDef second;
+  TF_EXPECT_OK(RunMetaOptimizer(std::move(item_copy), config, nullptr, nullptr,
+                                &second));
+  EXPECT_FALSE(TestOptimizer::IsOptimized());
+  CompareGraphs(first, second);
+
+  // A different configuration misses.
+  rewriter_config.set_constant_folding(RewriterConfig::OFF);
+  item_copy = item;
+  TF_EXPECT_OK(RunMetaOptimizer(std::move(item_copy), config, nullptr, nullptr,
+                                &second));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+
+  // So does a different set of fetch nodes.
+  TestOptimizer::SetOptimized(false);
+  item_copy = item;
+  item_copy.fetch.clear();
+  TF_EXPECT_OK(RunMetaOptimizer(std::move(item_copy), config, nullptr, nullptr,
+                                &second));
+  EXPECT_TRUE(TestOptimizer::IsOptimized());
+}
+
 TEST_F(MetaOptimizerTest, MetaOptimizerTimesOut) {
   TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {kDevice});
   GrapplerItem item;
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
+#include <functional>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
@@ -60,6 +63,14 @@ namespace grappler {
 //
 // Sigmoid + Mul -> _MklSwish  // This fusion only works on Intel CPU.
 //
+// CropAndResize + ... -> _FusedCropAndResize:
+//   (1) CropAndResize + Sub + {Mul, RealDiv} + <Cast>
+//
+// Independent ResourceApply{GradientDescent,Adagrad,Adam} with the same
+// hyperparameters -> _FusedResourceApply{GradientDescent,Adagrad,Adam}
+//
+// Chains of elementwise ops on CPU -> _FusedElementwise
+//
 //
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
@@ -74,6 +85,7 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedCropAndResize[] = "_FusedCropAndResize";
 
 constexpr char kDataFormat[] = "data_format";
 constexpr char kIsTraining[] = "is_training";
@@ -144,6 +156,34 @@ struct TensorToHashBucket {
   int string_to_hash_bucket = kMissingIndex;
 };
 
+// Gather of the rows of an embedding table, reduced by a
+// SparseSegment{Sum,Mean,SqrtN}[WithNumSegments]. The gather can be applied to
+// the ids instead of the table, so that the reduction reads the rows straight
+// from the table, and the gathered rows are not materialized.
+struct SparseSegmentReductionOfGather {
+  SparseSegmentReductionOfGather() = default;
+  SparseSegmentReductionOfGather(int gather, int sparse_segment_reduction)
+      : gather(gather), sparse_segment_reduction(sparse_segment_reduction) {}
+
+  int gather = kMissingIndex;
+  int sparse_segment_reduction = kMissingIndex;
+};
+
+// CropAndResize followed by the normalization of the crops, (crops - mean) *
+// scale or (crops - mean) / scale, and optionally by a Cast to a narrower float
+// type, as in image preprocessing pipelines.
+struct CropAndResizeWithNormalization {
+  CropAndResizeWithNormalization() = default;
+
+  int crop_and_resize = kMissingIndex;
+  int sub = kMissingIndex;
+  // Mul or RealDiv.
+  int scale = kMissingIndex;
+  // Input port of the scale operand of `scale`.
+  int scale_port = 1;
+  int cast = kMissingIndex;
+};
+
 // Pad followed by Conv3D/FusedConv3D
 struct PadWithConv3D {
   PadWithConv3D() = default;
@@ -1582,6 +1622,487 @@ bool FindMklLayerNorm(RemapperContext* ctx, int node_index,
   return found_op_type_match;
 }
 
+// Returns the value of a Const node holding a single float.
+bool GetScalarFloatConst(const NodeDef& node, float* value) {
+  Tensor tensor;
+  if (node.op() != "Const" || !node.attr().count("value") ||
+      !tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.dtype() != DT_FLOAT || tensor.NumElements() != 1) {
+    return false;
+  }
+  *value = tensor.flat<float>()(0);
+  return true;
+}
+
+// Returns the input of `node` that is not produced by the node at
+// `other_index`, if `node` is a binary op with exactly one such input.
+int OtherFaninIndex(const utils::MutableNodeView& node_view, int other_index) {
+  if (node_view.NumRegularFanins() != 2) return kMissingIndex;
+  const bool first = node_view.GetRegularFanin(0).node_index() == other_index;
+  const bool second = node_view.GetRegularFanin(1).node_index() == other_index;
+  if (first == second) return kMissingIndex;
+  return first ? 1 : 0;
+}
+
+// Layer normalization over the last dimension, as written by `tf.nn.moments`
+// followed by `tf.nn.batch_normalization`, optionally applied to the sum of
+// two tensors as in a residual connection. Here * means any type of op.
+//
+//   mean = Mean(*(input), axes)
+//   variance = Mean(SquaredDifference(input, [StopGradient](mean)), axes)
+//   inv = Mul(Rsqrt(AddV2(variance, Const(epsilon))), *(gamma))
+//   output = AddV2(Mul(input, inv), Sub(*(beta), Mul(mean, inv)))
+//
+// where `input` is either any op or AddV2(*(residual_x), *(residual)).
+bool FindLayerNorm(RemapperContext* ctx, int node_index,
+                   std::map<string, int>* matched_nodes_map,
+                   std::set<int>* remove_node_indices) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  using utils::OpTypePattern;
+
+  const auto* node_def = ctx->graph_view.GetNode(node_index)->node();
+  if (!IsAdd(*node_def) || !NodeIsOnCpu(node_def) ||
+      !HasDataType(node_def, DT_FLOAT)) {
+    return false;
+  }
+
+  const auto make_pattern = [](const OpTypePattern& input,
+                               bool stop_gradient) -> OpTypePattern {
+    const OpTypePattern mean = {"Mean", "mean", NodeStatus::kRemove,
+                                {input,
+                                 {"Const", "mean_axes", NodeStatus::kRemain}}};
+    const OpTypePattern centered_mean =
+        stop_gradient ? OpTypePattern{"StopGradient", "stop_gradient",
+                                      NodeStatus::kRemove, {mean}}
+                      : mean;
+    // clang-format off
+    const OpTypePattern inv =
+      {"Mul", "inv", NodeStatus::kRemove,
+        {
+          {"Rsqrt", "rsqrt", NodeStatus::kRemove,
+            {
+              {"AddV2", "variance_plus_epsilon", NodeStatus::kRemove,
+                {
+                  {"Mean", "variance", NodeStatus::kRemove,
+                    {
+                      {"SquaredDifference", "squared_difference",
+                       NodeStatus::kRemove,
+                        {
+                          input,
+                          centered_mean
+                        }
+                      },
+                      {"Const", "variance_axes", NodeStatus::kRemain}
+                    }
+                  },
+                  {"Const", "epsilon", NodeStatus::kRemain}
+                }
+              }
+            }
+          },
+          {"*", "gamma", NodeStatus::kRemain}
+        }
+      };
+    return
+      {"AddV2", "output", NodeStatus::kReplace,
+        {
+          {"Mul", "input_times_inv", NodeStatus::kRemove,
+            {
+              input,
+              inv
+            }
+          },
+          {"Sub", "beta_minus_mean_times_inv", NodeStatus::kRemove,
+            {
+              {"*", "beta", NodeStatus::kRemain},
+              {"Mul", "mean_times_inv", NodeStatus::kRemove,
+                {
+                  mean,
+                  inv
+                }
+              }
+            }
+          }
+        }
+      };
+    // clang-format on
+  };
+  const OpTypePattern input = {"*", "input", NodeStatus::kRemain};
+  const OpTypePattern residual_input = {
+      "AddV2",
+      "input",
+      NodeStatus::kRemove,
+      {{"*", "residual_x", NodeStatus::kRemain},
+       {"*", "residual", NodeStatus::kRemain}}};
+
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  bool found_op_type_match = false;
+  // Prefer folding the residual connection, which is only possible when the
+  // sum has no other consumers.
+  for (const OpTypePattern* input_pattern : {&residual_input, &input}) {
+    for (bool stop_gradient : {true, false}) {
+      matched_nodes_map->clear();
+      remove_node_indices->clear();
+      found_op_type_match = graph_matcher.GetMatchedNodes(
+          make_pattern(*input_pattern, stop_gradient), ctx->nodes_to_preserve,
+          ctx->graph_view.GetNode(node_index), matched_nodes_map,
+          remove_node_indices);
+      if (found_op_type_match) break;
+    }
+    if (found_op_type_match) break;
+  }
+  if (!found_op_type_match) return false;
+
+  const auto get_node = [&](const string& label) {
+    return ctx->graph_view.GetNode(matched_nodes_map->at(label))->node();
+  };
+
+  // Both reductions keep the reduced dimension.
+  for (const char* label : {"mean", "variance"}) {
+    bool keep_dims = false;
+    if (!TryGetNodeAttr(*get_node(label), "keep_dims", &keep_dims) ||
+        !keep_dims) {
+      return false;
+    }
+  }
+
+  // The input has a known last dimension, which is the only reduced one.
+  if (!ctx->inferred_graph_properties) return false;
+  const auto& mean_props =
+      ctx->graph_properties.GetInputProperties(get_node("mean")->name());
+  if (mean_props.empty() || mean_props[0].dtype() != DT_FLOAT) return false;
+  const TensorShapeProto& input_shape = mean_props[0].shape();
+  if (input_shape.unknown_rank() || input_shape.dim_size() < 1) return false;
+  const int rank = input_shape.dim_size();
+  const int64_t depth = input_shape.dim(rank - 1).size();
+  if (depth <= 0) return false;
+  for (const char* label : {"mean_axes", "variance_axes"}) {
+    Tensor axes;
+    if (!axes.FromProto(get_node(label)->attr().at("value").tensor()) ||
+        axes.NumElements() != 1) {
+      return false;
+    }
+    int64_t axis;
+    if (axes.dtype() == DT_INT32) {
+      axis = axes.flat<int32>()(0);
+    } else if (axes.dtype() == DT_INT64) {
+      axis = axes.flat<int64_t>()(0);
+    } else {
+      return false;
+    }
+    if (axis != -1 && axis != rank - 1) return false;
+  }
+
+  float epsilon;
+  if (!GetScalarFloatConst(*get_node("epsilon"), &epsilon) || epsilon <= 0) {
+    return false;
+  }
+
+  // Gamma and beta hold one value per element of the last dimension, so that
+  // they do not broadcast the output to a larger shape.
+  const auto is_vector_of_depth = [depth](const OpInfo::TensorProperties& p) {
+    return p.dtype() == DT_FLOAT && !p.shape().unknown_rank() &&
+           p.shape().dim_size() == 1 && p.shape().dim(0).size() == depth;
+  };
+  const auto* inv_view = ctx->graph_view.GetNode(matched_nodes_map->at("inv"));
+  const int gamma_port =
+      OtherFaninIndex(*inv_view, matched_nodes_map->at("rsqrt"));
+  if (gamma_port == kMissingIndex) return false;
+  const auto& inv_props =
+      ctx->graph_properties.GetInputProperties(inv_view->GetName());
+  const auto& sub_props = ctx->graph_properties.GetInputProperties(
+      get_node("beta_minus_mean_times_inv")->name());
+  if (inv_props.size() != 2 || sub_props.size() != 2 ||
+      !is_vector_of_depth(inv_props[gamma_port]) ||
+      !is_vector_of_depth(sub_props[0])) {
+    return false;
+  }
+
+  // The residual has the same shape as the other operand of the sum.
+  if (matched_nodes_map->count("residual")) {
+    const auto& add_props =
+        ctx->graph_properties.GetInputProperties(get_node("input")->name());
+    if (add_props.size() != 2 || add_props[1].dtype() != DT_FLOAT ||
+        !ShapesSymbolicallyEqual(add_props[0].shape(), input_shape) ||
+        !ShapesSymbolicallyEqual(add_props[1].shape(), input_shape)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Gelu that is not preceded by a contraction that FindMatMulBiasAddAndGelu
+// fuses. Matches the same subgraphs as FindMatMulBiasAddAndGelu, with any op
+// as input.
+bool FindGelu(RemapperContext* ctx, int node_index,
+              std::map<string, int>* matched_nodes_map,
+              std::set<int>* remove_node_indices, bool* is_gelu_approximate) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+
+  const auto* node_def = ctx->graph_view.GetNode(node_index)->node();
+  if (!IsMul(*node_def) || !NodeIsOnCpu(node_def) ||
+      !HasDataType(node_def, DT_FLOAT)) {
+    return false;
+  }
+
+  // clang-format off
+  utils::OpTypePattern gelu_exact_pattern =
+    {"Mul", "output", NodeStatus::kReplace,
+      {
+        {"Mul", "erf_plus_one_times_one_half", NodeStatus::kRemove,
+          {
+            {"AddV2", "erf_plus_one", NodeStatus::kRemove,
+              {
+                {"Erf", "erf", NodeStatus::kRemove,
+                  {
+                    {"Mul", "input_times_square_root_one_half",
+                     NodeStatus::kRemove,
+                      {
+                        {"*", "input", NodeStatus::kRemain},
+                        {"Const", "square_root_one_half", NodeStatus::kRemain}
+                      }
+                    }
+                  }
+                },
+                {"Const", "one", NodeStatus::kRemain}
+              }
+            },
+            {"Const", "one_half", NodeStatus::kRemain}
+          }
+        },
+        {"*", "input", NodeStatus::kRemain}
+      }
+    };
+  // Pow(x, 3) is either kept, or rewritten as Mul(x, Square(x)) by the
+  // arithmetic optimizer.
+  utils::OpTypePattern subgraph_pow =
+    {"Mul", "mul", NodeStatus::kRemove,
+      {
+        {"Pow", "pow", NodeStatus::kRemove,
+          {
+            {"*", "input", NodeStatus::kRemain},
+            {"Const", "three", NodeStatus::kRemain}
+          }
+        },
+        {"Const", "empirical_const", NodeStatus::kRemain}
+      }
+    };
+  utils::OpTypePattern subgraph_square =
+    {"Mul", "mul", NodeStatus::kRemove,
+      {
+        {"Mul", "empirical_const_times_input", NodeStatus::kRemove,
+          {
+            {"Const", "empirical_const", NodeStatus::kRemain},
+            {"*", "input", NodeStatus::kRemain}
+          }
+        },
+        {"Square", "square", NodeStatus::kRemove,
+          {
+            {"*", "input", NodeStatus::kRemain}
+          }
+        }
+      }
+    };
+  // clang-format on
+  const auto make_approximate_pattern =
+      [](const utils::OpTypePattern& subgraph) -> utils::OpTypePattern {
+    // clang-format off
+    return
+      {"Mul", "output", NodeStatus::kReplace,
+        {
+          {"Mul", "tanh_plus_one_times_one_half", NodeStatus::kRemove,
+            {
+              {"AddV2", "tanh_plus_one", NodeStatus::kRemove,
+                {
+                  {"Tanh", "tanh", NodeStatus::kRemove,
+                    {
+                      {"Mul", "input_plus_mul_times_square_root_two_over_pi",
+                       NodeStatus::kRemove,
+                        {
+                          {"AddV2", "input_plus_mul", NodeStatus::kRemove,
+                            {
+                              {"*", "input", NodeStatus::kRemain},
+                              subgraph
+                            }
+                          },
+                          {"Const", "square_root_two_over_pi",
+                           NodeStatus::kRemain}
+                        }
+                      }
+                    }
+                  },
+                  {"Const", "one", NodeStatus::kRemain}
+                }
+              },
+              {"Const", "one_half", NodeStatus::kRemain}
+            }
+          },
+          {"*", "input", NodeStatus::kRemain}
+        }
+      };
+    // clang-format on
+  };
+
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  const auto match = [&](const utils::OpTypePattern& pattern) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    return graph_matcher.GetMatchedNodes(
+        pattern, ctx->nodes_to_preserve, ctx->graph_view.GetNode(node_index),
+        matched_nodes_map, remove_node_indices);
+  };
+
+  std::map<string, float> values_map;
+  if (match(gelu_exact_pattern)) {
+    *is_gelu_approximate = false;
+    values_map = {
+        {"square_root_one_half", 0.707106}, {"one", 1.0}, {"one_half", 0.5}};
+  } else {
+    *is_gelu_approximate = true;
+    values_map = {{"square_root_two_over_pi", 0.797884},
+                  {"one", 1.0},
+                  {"one_half", 0.5},
+                  {"empirical_const", 0.044715}};
+    if (match(make_approximate_pattern(subgraph_pow))) {
+      values_map["three"] = 3.0;
+    } else if (!match(make_approximate_pattern(subgraph_square))) {
+      return false;
+    }
+  }
+  if (!VerifyConstants(ctx, matched_nodes_map, &values_map)) return false;
+
+  // With oneDNN, leave Gelu after MatMul + BiasAdd to the contraction fusion.
+  const auto* input_node_def =
+      ctx->graph_view.GetNode(matched_nodes_map->at("input"))->node();
+  if (IsMKLEnabled() &&
+      (IsBiasAdd(*input_node_def) || input_node_def->op() == "_FusedMatMul")) {
+    return false;
+  }
+  return true;
+}
+
+// Softmax over scaled logits and an additive mask, as in the attention of
+// transformers. Here * means any type of op.
+//
+//   output = Softmax(AddV2(Mul|RealDiv(*(logits), Const(scale)), *(mask)))
+//   output = Softmax(AddV2(*(logits), *(mask)))
+//   output = Softmax(Mul|RealDiv(*(logits), Const(scale)))
+//
+// The mask may be broadcast to the shape of the logits.
+bool FindScaledMaskedSoftmax(RemapperContext* ctx, int node_index,
+                             std::map<string, int>* matched_nodes_map,
+                             std::set<int>* remove_node_indices) {
+  using utils::MatchingDirection;
+  using utils::NodeStatus;
+  using utils::OpTypePattern;
+
+  const auto* node_def = ctx->graph_view.GetNode(node_index)->node();
+  if (!IsSoftmax(*node_def) || !NodeIsOnCpu(node_def) ||
+      !HasDataType(node_def, DT_FLOAT)) {
+    return false;
+  }
+
+  const auto make_scaled = [](const char* op) -> OpTypePattern {
+    return {op,
+            "scaled",
+            NodeStatus::kRemove,
+            {{"*", "logits", NodeStatus::kRemain},
+             {"Const", "scale", NodeStatus::kRemain}}};
+  };
+  const auto make_masked = [](const OpTypePattern& logits) -> OpTypePattern {
+    return {"AddV2",
+            "masked",
+            NodeStatus::kRemove,
+            {logits, {"*", "mask", NodeStatus::kRemain}}};
+  };
+  const auto make_softmax = [](const OpTypePattern& input) -> OpTypePattern {
+    return {"Softmax", "output", NodeStatus::kReplace, {input}};
+  };
+  const OpTypePattern patterns[] = {
+      make_softmax(make_masked(make_scaled("Mul"))),
+      make_softmax(make_masked(make_scaled("RealDiv"))),
+      make_softmax(make_scaled("Mul")),
+      make_softmax(make_scaled("RealDiv")),
+      make_softmax(make_masked({"*", "logits", NodeStatus::kRemain})),
+  };
+
+  utils::SubGraphMatcher<MatchingDirection::kFollowInputs> graph_matcher(
+      &(ctx->graph_view));
+  bool found_op_type_match = false;
+  for (const OpTypePattern& pattern : patterns) {
+    matched_nodes_map->clear();
+    remove_node_indices->clear();
+    found_op_type_match = graph_matcher.GetMatchedNodes(
+        pattern, ctx->nodes_to_preserve, ctx->graph_view.GetNode(node_index),
+        matched_nodes_map, remove_node_indices);
+    if (found_op_type_match) break;
+  }
+  if (!found_op_type_match) return false;
+
+  if (matched_nodes_map->count("scaled")) {
+    const auto* scaled_view =
+        ctx->graph_view.GetNode(matched_nodes_map->at("scaled"));
+    float scale;
+    if (!HasDataType(scaled_view->node(), DT_FLOAT) ||
+        !GetScalarFloatConst(
+            *ctx->graph_view.GetNode(matched_nodes_map->at("scale"))->node(),
+            &scale)) {
+      return false;
+    }
+    // The divisor of RealDiv must be the constant.
+    if (IsRealDiv(*scaled_view->node()) &&
+        OtherFaninIndex(*scaled_view, matched_nodes_map->at("scale")) != 0) {
+      return false;
+    }
+  }
+  if (!matched_nodes_map->count("mask")) return true;
+
+  // The mask broadcasts to the shape of the logits, so that the result of the
+  // sum has the shape of the logits.
+  if (!ctx->inferred_graph_properties) return false;
+  const auto* masked_view =
+      ctx->graph_view.GetNode(matched_nodes_map->at("masked"));
+  if (!HasDataType(masked_view->node(), DT_FLOAT)) return false;
+  const auto& masked_props =
+      ctx->graph_properties.GetInputProperties(masked_view->GetName());
+  if (masked_props.size() != 2) return false;
+  const bool scaled = matched_nodes_map->count("scaled") > 0;
+  const int mask_port = OtherFaninIndex(
+      *masked_view, matched_nodes_map->at(scaled ? "scaled" : "logits"));
+  if (mask_port == kMissingIndex) return false;
+  const auto broadcasts_to = [](const TensorShapeProto& mask_shape,
+                                const TensorShapeProto& logits_shape) {
+    if (logits_shape.unknown_rank() || mask_shape.unknown_rank() ||
+        logits_shape.dim_size() < 1 ||
+        mask_shape.dim_size() > logits_shape.dim_size()) {
+      return false;
+    }
+    const int rank_offset = logits_shape.dim_size() - mask_shape.dim_size();
+    for (int i = 0; i < mask_shape.dim_size(); ++i) {
+      const int64_t mask_dim = mask_shape.dim(i).size();
+      const int64_t logits_dim = logits_shape.dim(i + rank_offset).size();
+      // Unknown dimensions are -1, other negative sizes are symbolic.
+      if (mask_dim != 1 && (mask_dim == -1 || mask_dim != logits_dim)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  const TensorShapeProto& logits_shape = masked_props[1 - mask_port].shape();
+  const TensorShapeProto& mask_shape = masked_props[mask_port].shape();
+  if (broadcasts_to(mask_shape, logits_shape)) return true;
+  // Without a scale, either operand of the sum may be the mask.
+  if (!scaled && broadcasts_to(logits_shape, mask_shape)) {
+    std::swap((*matched_nodes_map)["logits"], (*matched_nodes_map)["mask"]);
+    return true;
+  }
+  return false;
+}
+
 bool FindFusedBatchNorm(const RemapperContext& ctx, int node_index,
                         FusedBatchNorm* matched) {
   const auto* node_view = ctx.graph_view.GetNode(node_index);
@@ -1967,6 +2488,181 @@ bool FindTensorToHashBucket(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+bool FindSparseSegmentReductionOfGather(
+    const RemapperContext& ctx, int node_index,
+    SparseSegmentReductionOfGather* matched) {
+  // Root of the pattern must be a SparseSegment reduction on CPU.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsAnySparseSegmentReduction(*node_def) || !NodeIsOnCpu(node_def) ||
+      HasControlFaninOrFanout(*node_view) ||
+      node_view->NumRegularFanins() < 3) {
+    return false;
+  }
+
+  // Its data input must be a Gather or GatherV2 on CPU, consumed only by the
+  // reduction.
+  const auto* gather_node_view = node_view->GetRegularFanin(0).node_view();
+  const auto* gather_node_def = gather_node_view->node();
+  const bool is_gather_v2 = gather_node_def->op() == "GatherV2";
+  if ((!is_gather_v2 && gather_node_def->op() != "Gather") ||
+      !NodeIsOnCpu(gather_node_def) ||
+      HasControlFaninOrFanout(*gather_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*gather_node_view) ||
+      IsInPreserveSet(ctx, gather_node_def)) {
+    return false;
+  }
+
+  // The ids must be a vector, so that the gathered rows are the rows of the
+  // table, and GatherV2 must gather along the first axis.
+  const auto& props =
+      ctx.graph_properties.GetInputProperties(gather_node_def->name());
+  if (props.size() < (is_gather_v2 ? 3 : 2) ||
+      props[1].shape().unknown_rank() || props[1].shape().dim_size() != 1) {
+    return false;
+  }
+  if (is_gather_v2) {
+    int batch_dims = 0;
+    if (TryGetNodeAttr(*gather_node_def, "batch_dims", &batch_dims) &&
+        batch_dims != 0) {
+      return false;
+    }
+    Tensor axis;
+    if (!props[2].has_value() || !axis.FromProto(props[2].value()) ||
+        axis.NumElements() != 1) {
+      return false;
+    }
+    const int64_t axis_value = axis.dtype() == DT_INT32
+                                   ? axis.flat<int32>()(0)
+                                   : axis.flat<int64_t>()(0);
+    if (axis_value != 0) return false;
+  }
+
+  *matched = SparseSegmentReductionOfGather(gather_node_view->node_index(),
+                                            node_index);
+  return true;
+}
+
+bool FindCropAndResizeWithNormalization(
+    const RemapperContext& ctx, int node_index,
+    CropAndResizeWithNormalization* matched) {
+  // Root of the pattern is either a Cast of the normalized crops, or the Mul or
+  // RealDiv node that scales them.
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (HasControlFaninOrFanout(*node_view)) return false;
+
+  CropAndResizeWithNormalization pattern;
+  const auto* scale_node_view = node_view;
+  if (IsCast(*node_def)) {
+    if (!HasDataType(node_def, DT_FLOAT, "SrcT") ||
+        (!HasDataType(node_def, DT_HALF, "DstT") &&
+         !HasDataType(node_def, DT_BFLOAT16, "DstT")) ||
+        node_view->NumRegularFanins() < 1) {
+      return false;
+    }
+    bool truncate = false;
+    if (TryGetNodeAttr(*node_def, "Truncate", &truncate) && truncate) {
+      return false;
+    }
+    pattern.cast = node_index;
+    scale_node_view = node_view->GetRegularFanin(0).node_view();
+  }
+
+  // The crops are scaled by Mul(sub, scale), Mul(scale, sub) or
+  // RealDiv(sub, scale).
+  const auto* scale_node_def = scale_node_view->node();
+  const bool is_mul = IsMul(*scale_node_def);
+  if ((!is_mul && !IsRealDiv(*scale_node_def)) ||
+      !HasDataType(scale_node_def, DT_FLOAT) ||
+      scale_node_view->NumRegularFanins() != 2 ||
+      HasControlFaninOrFanout(*scale_node_view)) {
+    return false;
+  }
+  if (pattern.cast != kMissingIndex &&
+      (!HasAtMostOneFanoutAtPort0(*scale_node_view) ||
+       IsInPreserveSet(ctx, scale_node_def))) {
+    return false;
+  }
+  const auto is_sub = [](const utils::MutableNodeView* view) {
+    return IsSub(*view->node());
+  };
+  int sub_port = 0;
+  if (!is_sub(scale_node_view->GetRegularFanin(0).node_view())) {
+    if (!is_mul || !is_sub(scale_node_view->GetRegularFanin(1).node_view())) {
+      return false;
+    }
+    sub_port = 1;
+  }
+  pattern.scale = scale_node_view->node_index();
+  pattern.scale_port = 1 - sub_port;
+
+  // The Sub node subtracts the mean from the crops.
+  const auto* sub_node_view =
+      scale_node_view->GetRegularFanin(sub_port).node_view();
+  const auto* sub_node_def = sub_node_view->node();
+  if (!HasDataType(sub_node_def, DT_FLOAT) ||
+      sub_node_view->NumRegularFanins() != 2 ||
+      HasControlFaninOrFanout(*sub_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*sub_node_view) ||
+      IsInPreserveSet(ctx, sub_node_def)) {
+    return false;
+  }
+  pattern.sub = sub_node_view->node_index();
+
+  const auto* crop_node_view = sub_node_view->GetRegularFanin(0).node_view();
+  const auto* crop_node_def = crop_node_view->node();
+  if (crop_node_def->op() != "CropAndResize" ||
+      HasControlFaninOrFanout(*crop_node_view) ||
+      !HasAtMostOneFanoutAtPort0(*crop_node_view) ||
+      IsInPreserveSet(ctx, crop_node_def) ||
+      (!NodeIsOnCpu(crop_node_def) && !NodeIsOnGpu(crop_node_def))) {
+    return false;
+  }
+  const DataType image_dtype = GetDataTypeFromAttr(*crop_node_def, "T");
+  if (image_dtype != DT_UINT8 && image_dtype != DT_UINT16 &&
+      image_dtype != DT_HALF && image_dtype != DT_FLOAT) {
+    return false;
+  }
+  pattern.crop_and_resize = crop_node_view->node_index();
+
+  // The mean and the scale must hold either one value, or one value per
+  // channel broadcast along the last dimension of the crops.
+  if (!ctx.inferred_graph_properties) return false;
+  const auto& crop_props =
+      ctx.graph_properties.GetInputProperties(crop_node_def->name());
+  if (crop_props.empty() || crop_props[0].shape().unknown_rank() ||
+      crop_props[0].shape().dim_size() != 4) {
+    return false;
+  }
+  const int64_t depth = crop_props[0].shape().dim(3).size();
+  const auto is_per_channel = [depth](const OpInfo::TensorProperties& props) {
+    const TensorShapeProto& shape = props.shape();
+    if (props.dtype() != DT_FLOAT || shape.unknown_rank() ||
+        shape.dim_size() > 4) {
+      return false;
+    }
+    for (int i = 0; i < shape.dim_size(); ++i) {
+      const int64_t size = shape.dim(i).size();
+      const bool is_last = i == shape.dim_size() - 1;
+      if (size != 1 && !(is_last && depth > 0 && size == depth)) return false;
+    }
+    return true;
+  };
+  const auto& sub_props =
+      ctx.graph_properties.GetInputProperties(sub_node_def->name());
+  const auto& scale_props =
+      ctx.graph_properties.GetInputProperties(scale_node_def->name());
+  if (sub_props.size() != 2 || scale_props.size() != 2 ||
+      !is_per_channel(sub_props[1]) ||
+      !is_per_channel(scale_props[pattern.scale_port])) {
+    return false;
+  }
+
+  *matched = pattern;
+  return true;
+}
+
 bool FindFusedBatchMatMul(RemapperContext* ctx, int node_index,
                           std::map<string, int>* matched_nodes_map,
                           std::set<int>* remove_node_indices) {
@@ -2220,8 +2916,8 @@ Status AddFusedContractionNode(RemapperContext* ctx,
   NodeDef fused_op;
   fused_op.set_name(bias_add.name());
   fused_op.set_device(contraction.device());
-  fused_op.add_input(contraction.input(0));               // 0: input
-  fused_op.add_input(contraction.input(1));               // 1: filter
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
   fused_op.add_input(bias_add.input(matched.bias_port));  // 2: bias
   if (IsConv2D(contraction)) {
     fused_op.set_op(kFusedConv2D);
@@ -2269,8 +2965,8 @@ Status AddFusedContractionNode(
   NodeDef fused_op;
   fused_op.set_name(activation.name());
   fused_op.set_device(contraction.device());
-  fused_op.add_input(contraction.input(0));               // 0: input
-  fused_op.add_input(contraction.input(1));               // 1: filter
+  fused_op.add_input(contraction.input(0));  // 0: input
+  fused_op.add_input(contraction.input(1));  // 1: filter
   fused_op.add_input(bias_add.input(matched.bias_port));  // 2: bias
 
   if (IsConv2D(contraction)) {
@@ -2673,6 +3369,165 @@ Status AddMklLayerNorm(RemapperContext* ctx,
   return OkStatus();
 }
 
+Status AddFusedLayerNorm(RemapperContext* ctx,
+                         const std::map<string, int>& matched_nodes_map,
+                         const std::set<int>& remove_node_indices,
+                         std::vector<bool>* invalidated_nodes,
+                         std::vector<bool>* nodes_to_delete) {
+  const auto get_node = [&](const string& label) {
+    return ctx->graph_view.GetNode(matched_nodes_map.at(label))->node();
+  };
+  const NodeDef* output_node = get_node("output");
+  const NodeDef* mean_node = get_node("mean");
+  const NodeDef* inv_node = get_node("inv");
+  const NodeDef* sub_node = get_node("beta_minus_mean_times_inv");
+  const int gamma_port =
+      OtherFaninIndex(*ctx->graph_view.GetNode(matched_nodes_map.at("inv")),
+                      matched_nodes_map.at("rsqrt"));
+  float epsilon;
+  if (gamma_port == kMissingIndex ||
+      !GetScalarFloatConst(*get_node("epsilon"), &epsilon)) {
+    return errors::Internal("Unexpected layer normalization subgraph at ",
+                            output_node->name());
+  }
+  const bool has_residual = matched_nodes_map.count("residual") > 0;
+
+  NodeDef fused_node;
+  fused_node.set_name(output_node->name());
+  fused_node.set_op("_FusedLayerNorm");
+  fused_node.set_device(output_node->device());
+  if (has_residual) {
+    const NodeDef* residual_add_node = get_node("input");
+    fused_node.add_input(residual_add_node->input(0));
+    fused_node.add_input(inv_node->input(gamma_port));
+    fused_node.add_input(sub_node->input(0));
+    fused_node.add_input(residual_add_node->input(1));
+  } else {
+    fused_node.add_input(mean_node->input(0));
+    fused_node.add_input(inv_node->input(gamma_port));
+    fused_node.add_input(sub_node->input(0));
+  }
+  auto* attr = fused_node.mutable_attr();
+  (*attr)["T"] = output_node->attr().at("T");
+  SetAttrValue(has_residual ? 1 : 0, &(*attr)["num_residual"]);
+  SetAttrValue(epsilon, &(*attr)["epsilon"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map.at("output")] = true;
+
+  for (const auto& node_idx : remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return OkStatus();
+}
+
+Status AddFusedGelu(RemapperContext* ctx,
+                    const std::map<string, int>& matched_nodes_map,
+                    const std::set<int>& remove_node_indices,
+                    std::vector<bool>* invalidated_nodes,
+                    std::vector<bool>* nodes_to_delete,
+                    bool is_gelu_approximate) {
+  const auto* output_view =
+      ctx->graph_view.GetNode(matched_nodes_map.at("output"));
+  const NodeDef* output_node = output_view->node();
+  // The input feeds the outer Mul directly.
+  const int input_port = OtherFaninIndex(
+      *output_view, matched_nodes_map.at(is_gelu_approximate
+                                             ? "tanh_plus_one_times_one_half"
+                                             : "erf_plus_one_times_one_half"));
+  if (input_port == kMissingIndex) {
+    return errors::Internal("Unexpected Gelu subgraph at ",
+                            output_node->name());
+  }
+
+  NodeDef fused_node;
+  fused_node.set_name(output_node->name());
+  fused_node.set_op("_FusedGelu");
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(output_node->input(input_port));
+  auto* attr = fused_node.mutable_attr();
+  (*attr)["T"] = output_node->attr().at("T");
+  SetAttrValue(is_gelu_approximate, &(*attr)["approximate"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map.at("output")] = true;
+
+  for (const auto& node_idx : remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return OkStatus();
+}
+
+Status AddFusedScaledMaskedSoftmax(
+    RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
+    const std::set<int>& remove_node_indices,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const NodeDef* output_node =
+      ctx->graph_view.GetNode(matched_nodes_map.at("output"))->node();
+
+  float scale = 1.0f;
+  string logits = output_node->input(0);
+  if (matched_nodes_map.count("scaled")) {
+    const NodeDef* scaled_node =
+        ctx->graph_view.GetNode(matched_nodes_map.at("scaled"))->node();
+    const auto* scale_view =
+        ctx->graph_view.GetNode(matched_nodes_map.at("scale"));
+    if (!GetScalarFloatConst(*scale_view->node(), &scale)) {
+      return errors::Internal("Unexpected softmax subgraph at ",
+                              output_node->name());
+    }
+    if (IsRealDiv(*scaled_node)) scale = 1.0f / scale;
+    const auto* scaled_view =
+        ctx->graph_view.GetNode(matched_nodes_map.at("scaled"));
+    logits = scaled_node->input(
+        OtherFaninIndex(*scaled_view, scale_view->node_index()));
+  }
+  string mask;
+  if (matched_nodes_map.count("mask")) {
+    const auto* masked_view =
+        ctx->graph_view.GetNode(matched_nodes_map.at("masked"));
+    const int mask_port = OtherFaninIndex(
+        *masked_view, matched_nodes_map.count("scaled")
+                          ? matched_nodes_map.at("scaled")
+                          : matched_nodes_map.at("logits"));
+    mask = masked_view->node()->input(mask_port);
+    if (!matched_nodes_map.count("scaled")) {
+      logits = masked_view->node()->input(1 - mask_port);
+    }
+  }
+
+  NodeDef fused_node;
+  fused_node.set_name(output_node->name());
+  fused_node.set_op("_FusedScaledMaskedSoftmax");
+  fused_node.set_device(output_node->device());
+  fused_node.add_input(logits);
+  if (!mask.empty()) fused_node.add_input(mask);
+  auto* attr = fused_node.mutable_attr();
+  (*attr)["T"] = output_node->attr().at("T");
+  SetAttrValue(mask.empty() ? 0 : 1, &(*attr)["num_mask"]);
+  SetAttrValue(scale, &(*attr)["scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  (*invalidated_nodes)[matched_nodes_map.at("output")] = true;
+
+  for (const auto& node_idx : remove_node_indices) {
+    (*nodes_to_delete)[node_idx] = true;
+  }
+  return OkStatus();
+}
+
 Status ReplaceMulMaximumWithLeakyRelu(
     RemapperContext* ctx, const std::map<string, int>& matched_nodes_map,
     const std::set<int>& remove_node_indices,
@@ -2855,14 +3710,14 @@ Status AddFusedBatchNormGradExNode(RemapperContext* ctx,
   fused_op.set_name(fused_batch_norm_grad.name());
   fused_op.set_device(fused_batch_norm_grad.device());
 
-  fused_op.add_input(activation_grad.input(0));        // 0: y_backprop
+  fused_op.add_input(activation_grad.input(0));  // 0: y_backprop
   fused_op.add_input(fused_batch_norm_grad.input(1));  // 1: x
   fused_op.add_input(fused_batch_norm_grad.input(2));  // 2: scale
   fused_op.add_input(fused_batch_norm_grad.input(3));  // 3: reserve_space_1
   fused_op.add_input(fused_batch_norm_grad.input(4));  // 4: reserve_space_2
   fused_op.add_input(fused_batch_norm_grad.input(5));  // 5: reserve_space_3
-  fused_op.add_input(fwd_fused_batch_norm.input(2));   // 6: offset
-  fused_op.add_input(activation_grad.input(1));        // 7: y
+  fused_op.add_input(fwd_fused_batch_norm.input(2));  // 6: offset
+  fused_op.add_input(activation_grad.input(1));  // 7: y
 
   CopyFusedBatchNormGradAttributes(fused_batch_norm_grad, &fused_op);
 
@@ -3136,6 +3991,104 @@ Status AddTensorToHashBucketNode(RemapperContext* ctx,
   return OkStatus();
 }
 
+Status AddSparseSegmentReductionOfGatheredIds(
+    RemapperContext* ctx, const SparseSegmentReductionOfGather& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& gather = graph->node(matched.gather);
+  const NodeDef& reduction = graph->node(matched.sparse_segment_reduction);
+  VLOG(2) << "Gather ids of " << reduction.op() << ":"
+          << " gather=" << gather.name() << " reduction=" << reduction.name();
+
+  // The gather node now gathers the ids selected by the reduction indices.
+  NodeDef gathered_ids;
+  gathered_ids.set_name(gather.name());
+  gathered_ids.set_op(gather.op());
+  gathered_ids.set_device(gather.device());
+  gathered_ids.add_input(gather.input(1));     // 0: ids
+  gathered_ids.add_input(reduction.input(1));  // 1: indices
+  if (gather.op() == "GatherV2") {
+    gathered_ids.add_input(gather.input(2));  // 2: axis
+  }
+  auto* gather_attr = gathered_ids.mutable_attr();
+  *gather_attr = gather.attr();
+  (*gather_attr)["Tparams"] = gather.attr().at("Tindices");
+  (*gather_attr)["Tindices"] = reduction.attr().at("Tidx");
+
+  // The reduction reads the rows of the table through the gathered ids.
+  NodeDef fused_reduction = reduction;
+  fused_reduction.set_input(0, gather.input(0));
+  fused_reduction.set_input(1, gather.name());
+  (*fused_reduction.mutable_attr())["Tidx"] = gather.attr().at("Tindices");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(gathered_ids), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(fused_reduction), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.gather] = true;
+  (*invalidated_nodes)[matched.sparse_segment_reduction] = true;
+
+  return OkStatus();
+}
+
+Status AddFusedCropAndResizeNode(
+    RemapperContext* ctx, const CropAndResizeWithNormalization& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& crop_and_resize = graph->node(matched.crop_and_resize);
+  const NodeDef& sub = graph->node(matched.sub);
+  const NodeDef& scale = graph->node(matched.scale);
+  const int root = matched.cast != kMissingIndex ? matched.cast : matched.scale;
+  const NodeDef& root_node = graph->node(root);
+  VLOG(2) << "Fuse " << sub.op() << " and " << scale.op()
+          << " with CropAndResize:"
+          << " crop_and_resize=" << crop_and_resize.name()
+          << " sub=" << sub.name() << " scale=" << scale.name()
+          << " root=" << root_node.name();
+
+  NodeDef fused_op;
+  fused_op.set_name(root_node.name());
+  fused_op.set_op(kFusedCropAndResize);
+  fused_op.set_device(crop_and_resize.device());
+  fused_op.add_input(crop_and_resize.input(0));         // 0: image
+  fused_op.add_input(crop_and_resize.input(1));         // 1: boxes
+  fused_op.add_input(crop_and_resize.input(2));         // 2: box_ind
+  fused_op.add_input(crop_and_resize.input(3));         // 3: crop_size
+  fused_op.add_input(sub.input(1));                     // 4: mean
+  fused_op.add_input(scale.input(matched.scale_port));  // 5: scale
+
+  auto* attr = fused_op.mutable_attr();
+  auto& src_attr = crop_and_resize.attr();
+  (*attr)["T"] = src_attr.at("T");
+  (*attr)["method"] = src_attr.at("method");
+  (*attr)["extrapolation_value"] = src_attr.at("extrapolation_value");
+  if (matched.cast != kMissingIndex) {
+    (*attr)["out_type"] = root_node.attr().at("DstT");
+  } else {
+    SetAttrValue(DT_FLOAT, &(*attr)["out_type"]);
+  }
+  SetAttrValue(IsRealDiv(scale), &(*attr)["divide_by_scale"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[root] = true;
+  (*nodes_to_delete)[matched.crop_and_resize] = true;
+  (*nodes_to_delete)[matched.sub] = true;
+  if (matched.cast != kMissingIndex) {
+    (*nodes_to_delete)[matched.scale] = true;
+  }
+
+  return OkStatus();
+}
+
 Status AddFusedBatchMatMul(RemapperContext* ctx,
                            const std::map<string, int>& matched_nodes_map,
                            const std::set<int>& remove_node_indices,
@@ -3440,14 +4393,440 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
     return false;
   };
 
+  // Candidate for gathering the ids of a SparseSegment reduction.
+  const auto is_sparse_segment_reduction_of_gather_candidate = [&]() -> bool {
+    if (!IsAnySparseSegmentReduction(*node_def)) return false;
+    if (node_view->NumRegularFanins() < 1) return false;
+    const auto* fanin_0_node_def =
+        node_view->GetRegularFanin(0).node_view()->node();
+    return fanin_0_node_def->op() == "Gather" ||
+           fanin_0_node_def->op() == "GatherV2";
+  };
+
+  // Candidate for a CropAndResize fusion.
+  const auto is_crop_and_resize_normalization_candidate = [&]() -> bool {
+    const auto* scale_node_view = node_view;
+    if (IsCast(*node_def)) {
+      if (node_view->NumRegularFanins() < 1) return false;
+      scale_node_view = node_view->GetRegularFanin(0).node_view();
+    }
+    const auto* scale_node_def = scale_node_view->node();
+    if (!IsMul(*scale_node_def) && !IsRealDiv(*scale_node_def)) return false;
+    for (int i = 0; i < scale_node_view->NumRegularFanins(); ++i) {
+      const auto* sub_node_view =
+          scale_node_view->GetRegularFanin(i).node_view();
+      if (IsSub(*sub_node_view->node()) &&
+          sub_node_view->NumRegularFanins() > 0 &&
+          sub_node_view->GetRegularFanin(0).node_view()->node()->op() ==
+              "CropAndResize") {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Candidate for a layer normalization fusion.
+  const auto is_layer_norm_candidate = [&]() -> bool {
+    if (!IsAdd(*node_def) || node_view->NumRegularFanins() != 2) return false;
+    for (int i = 0; i < 2; ++i) {
+      if (IsSub(*node_view->GetRegularFanin(i).node_view()->node())) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Candidate for a masked softmax fusion.
+  const auto is_masked_softmax_candidate = [&]() -> bool {
+    if (!IsSoftmax(*node_def) || node_view->NumRegularFanins() < 1) {
+      return false;
+    }
+    return IsAdd(*node_view->GetRegularFanin(0).node_view()->node());
+  };
+
   if (IsMKLEnabled())
     return is_batch_norm_candidate() || is_batch_norm_fusion_candidate() ||
            IsContractionWithAdd(ctx, node_index) ||
-           is_act_biasadd_conv_candidate();
+           is_act_biasadd_conv_candidate() ||
+           is_sparse_segment_reduction_of_gather_candidate() ||
+           is_crop_and_resize_normalization_candidate() ||
+           is_layer_norm_candidate() || is_masked_softmax_candidate();
 
   return is_act_biasadd_conv_candidate() || is_batch_norm_candidate() ||
          is_batch_norm_fusion_candidate() ||
-         is_batch_norm_grad_fusion_candidate();
+         is_batch_norm_grad_fusion_candidate() ||
+         is_sparse_segment_reduction_of_gather_candidate() ||
+         is_crop_and_resize_normalization_candidate() ||
+         is_layer_norm_candidate() || is_masked_softmax_candidate();
+}
+
+// Dense resource apply ops that have a multi-tensor _FusedResourceApply*
+// variant, with the layout of their inputs.
+struct ResourceApplyOpInfo {
+  const char* op;
+  const char* fused_op;
+  // Number of resource inputs (the variable and its slots), followed by the
+  // scalar hyperparameters and the gradient.
+  int num_resources;
+  int num_scalars;
+};
+
+const ResourceApplyOpInfo* GetResourceApplyOpInfo(const NodeDef& node) {
+  static constexpr ResourceApplyOpInfo kOps[] = {
+      {"ResourceApplyGradientDescent", "_FusedResourceApplyGradientDescent",
+       1, 1},
+      {"ResourceApplyAdagrad", "_FusedResourceApplyAdagrad", 2, 1},
+      {"ResourceApplyAdam", "_FusedResourceApplyAdam", 3, 6},
+  };
+  for (const ResourceApplyOpInfo& info : kOps) {
+    if (node.op() == info.op) return &info;
+  }
+  return nullptr;
+}
+
+// Groups the ResourceApply{GradientDescent,Adagrad,Adam} nodes that run on the
+// same device with the same attributes, hyperparameters and control inputs,
+// and replaces each group with a single _FusedResourceApply* node that updates
+// all its variables at once. Nodes of a group that depend on each other are
+// not fused, since it would create a cycle.
+Status FuseResourceApplyOps(const GrapplerItem& item, GraphDef* graph) {
+  const auto nodes_to_preserve = item.NodesToPreserve();
+  absl::flat_hash_map<string, std::vector<int>> groups;
+  std::vector<string> group_keys;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    const NodeDef& node = graph->node(i);
+    const ResourceApplyOpInfo* info = GetResourceApplyOpInfo(node);
+    if (info == nullptr || nodes_to_preserve.count(node.name()) > 0) continue;
+    DataType dtype;
+    if (!TryGetNodeAttr(node, "T", &dtype) ||
+        (dtype != DT_HALF && dtype != DT_FLOAT && dtype != DT_DOUBLE)) {
+      continue;
+    }
+    const int num_data_inputs = info->num_resources + info->num_scalars + 1;
+    if (node.input_size() < num_data_inputs) continue;
+
+    string key = strings::StrCat(node.op(), ";", node.device());
+    std::map<string, string> attrs;
+    for (const auto& attr : node.attr()) {
+      attrs[attr.first] = attr.second.SerializeAsString();
+    }
+    for (const auto& attr : attrs) {
+      strings::StrAppend(&key, ";", attr.first, "=", attr.second);
+    }
+    for (int j = info->num_resources; j < num_data_inputs - 1; ++j) {
+      strings::StrAppend(&key, ";", node.input(j));
+    }
+    std::vector<string> control_inputs(node.input().begin() + num_data_inputs,
+                                       node.input().end());
+    std::sort(control_inputs.begin(), control_inputs.end());
+    for (const string& control_input : control_inputs) {
+      strings::StrAppend(&key, ";", control_input);
+    }
+
+    auto it = groups.find(key);
+    if (it == groups.end()) {
+      group_keys.push_back(key);
+      it = groups.emplace(key, std::vector<int>()).first;
+    }
+    it->second.push_back(i);
+  }
+
+  NodeMap node_map(graph);
+  absl::flat_hash_map<string, string> fused_names;
+  std::vector<NodeDef> fused_nodes;
+  for (const string& key : group_keys) {
+    const std::vector<int>& group = groups[key];
+    if (group.size() < 2) continue;
+
+    // Nodes reachable from each node of the group.
+    std::vector<absl::flat_hash_set<const NodeDef*>> reachable(group.size());
+    for (int g = 0; g < group.size(); ++g) {
+      std::vector<const NodeDef*> queue = {&graph->node(group[g])};
+      while (!queue.empty()) {
+        const NodeDef* node = queue.back();
+        queue.pop_back();
+        for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+          if (reachable[g].insert(output).second) queue.push_back(output);
+        }
+      }
+    }
+    std::vector<int> members;
+    for (int g = 0; g < group.size(); ++g) {
+      const NodeDef* node = &graph->node(group[g]);
+      bool independent = true;
+      for (int m : members) {
+        if (reachable[m].contains(node) ||
+            reachable[g].contains(&graph->node(group[m]))) {
+          independent = false;
+          break;
+        }
+      }
+      if (independent) members.push_back(g);
+    }
+    if (members.size() < 2) continue;
+
+    const NodeDef& first = graph->node(group[members[0]]);
+    const ResourceApplyOpInfo* info = GetResourceApplyOpInfo(first);
+    const int num_data_inputs = info->num_resources + info->num_scalars + 1;
+    VLOG(2) << "Fuse " << members.size() << " " << first.op()
+            << " nodes into " << info->fused_op << ": first=" << first.name();
+
+    NodeDef fused_op;
+    const string base_name =
+        AddPrefixToNodeName(first.name(), "FusedResourceApply");
+    string name = base_name;
+    for (int suffix = 1; node_map.NodeExists(name); ++suffix) {
+      name = strings::StrCat(base_name, "_", suffix);
+    }
+    fused_op.set_name(name);
+    fused_op.set_op(info->fused_op);
+    fused_op.set_device(first.device());
+    for (int j = 0; j < info->num_resources; ++j) {
+      for (int m : members) {
+        fused_op.add_input(graph->node(group[m]).input(j));
+      }
+    }
+    for (int j = info->num_resources; j < num_data_inputs - 1; ++j) {
+      fused_op.add_input(first.input(j));
+    }
+    for (int m : members) {
+      fused_op.add_input(graph->node(group[m]).input(num_data_inputs - 1));
+    }
+    for (int j = num_data_inputs; j < first.input_size(); ++j) {
+      fused_op.add_input(first.input(j));
+    }
+    *fused_op.mutable_attr() = first.attr();
+    SetAttrValue(static_cast<int>(members.size()),
+                 &(*fused_op.mutable_attr())["N"]);
+
+    for (int m : members) {
+      fused_names[graph->node(group[m]).name()] = name;
+    }
+    fused_nodes.push_back(std::move(fused_op));
+  }
+  if (fused_nodes.empty()) return OkStatus();
+
+  // Remove the fused nodes, and redirect their control outputs to the nodes
+  // that replace them. Apply ops on resources have no data outputs.
+  GraphDef result;
+  if (graph->has_versions()) *result.mutable_versions() = graph->versions();
+  if (graph->has_library()) *result.mutable_library() = graph->library();
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (fused_names.contains(node.name())) continue;
+    NodeDef* new_node = result.add_node();
+    new_node->Swap(&node);
+    std::vector<string> inputs(new_node->input().begin(),
+                               new_node->input().end());
+    new_node->clear_input();
+    absl::flat_hash_set<string> control_inputs;
+    for (const string& input : inputs) {
+      if (IsControlInput(input)) {
+        auto it = fused_names.find(NodeName(input));
+        const string control_input =
+            it == fused_names.end() ? input : AsControlDependency(it->second);
+        if (!control_inputs.insert(control_input).second) continue;
+        new_node->add_input(control_input);
+      } else {
+        new_node->add_input(input);
+      }
+    }
+  }
+  for (NodeDef& fused_op : fused_nodes) {
+    result.add_node()->Swap(&fused_op);
+  }
+  graph->Swap(&result);
+  return OkStatus();
+}
+
+// Returns the number of inputs of the elementwise ops that _FusedElementwise
+// can evaluate, or 0 for other ops.
+int FusedElementwiseArity(const NodeDef& node) {
+  static const auto* arities = new absl::flat_hash_map<string, int>({
+      {"Add", 2},     {"AddV2", 2},   {"Sub", 2},
+      {"Mul", 2},     {"RealDiv", 2}, {"Maximum", 2},
+      {"Minimum", 2}, {"SquaredDifference", 2},
+      {"Neg", 1},     {"Abs", 1},     {"Square", 1},
+      {"Sqrt", 1},    {"Rsqrt", 1},   {"Reciprocal", 1},
+      {"Exp", 1},     {"Log", 1},     {"Tanh", 1},
+      {"Sigmoid", 1}, {"Relu", 1},    {"Relu6", 1},
+  });
+  auto it = arities->find(node.op());
+  return it == arities->end() ? 0 : it->second;
+}
+
+// Replaces each maximal tree of elementwise ops on CPU, where every op but the
+// root only feeds the next one, with a single _FusedElementwise node that
+// evaluates the tree in one pass over memory. The fused node takes the name of
+// the root, so that its consumers are unchanged. Every input of an op must be a
+// scalar or have the shape of its output.
+Status FuseElementwiseChains(const GrapplerItem& item, GraphDef* graph) {
+  // Upper bound on the number of ops of a fused node.
+  constexpr int kMaxFusedElementwiseOps = 32;
+
+  auto is_candidate_op = [](const NodeDef& node) {
+    DataType dtype;
+    return FusedElementwiseArity(node) > 0 && NodeIsOnCpu(&node) &&
+           TryGetNodeAttr(node, "T", &dtype) &&
+           (dtype == DT_FLOAT || dtype == DT_DOUBLE) &&
+           node.input_size() >= FusedElementwiseArity(node);
+  };
+  NodeMap node_map(graph);
+  bool has_chain = false;
+  for (const NodeDef& node : graph->node()) {
+    if (!is_candidate_op(node)) continue;
+    for (int i = 0; i < FusedElementwiseArity(node) && !has_chain; ++i) {
+      const NodeDef* input = node_map.GetNode(node.input(i));
+      has_chain = input != nullptr && is_candidate_op(*input);
+    }
+    if (has_chain) break;
+  }
+  if (!has_chain) return OkStatus();
+
+  GrapplerItem shape_item = item.WithGraph(GraphDef(*graph));
+  GraphProperties properties(shape_item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false, /*aggressive_shape_inference=*/false,
+      /*include_input_tensor_values=*/false,
+      /*include_output_tensor_values=*/false));
+
+  auto is_candidate = [&](const NodeDef& node) {
+    if (!is_candidate_op(node)) return false;
+    const auto& inputs = properties.GetInputProperties(node.name());
+    const auto& outputs = properties.GetOutputProperties(node.name());
+    if (outputs.size() != 1 ||
+        inputs.size() != FusedElementwiseArity(node) ||
+        !ShapeIsSymbolicallyDefined(outputs[0])) {
+      return false;
+    }
+    for (const OpInfo::TensorProperties& input : inputs) {
+      const bool is_scalar =
+          !input.shape().unknown_rank() && input.shape().dim_size() == 0;
+      if (!is_scalar && !ShapesSymbolicallyEqual(input, outputs[0])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  const auto nodes_to_preserve = item.NodesToPreserve();
+  absl::flat_hash_map<const NodeDef*, bool> candidates;
+  for (const NodeDef& node : graph->node()) {
+    candidates[&node] = is_candidate(node);
+  }
+  // Returns true if `node` can be evaluated as part of the fused node of its
+  // only consumer.
+  auto is_absorbable = [&](const NodeDef& node) {
+    if (!candidates[&node] || nodes_to_preserve.count(node.name()) > 0) {
+      return false;
+    }
+    const auto& outputs = node_map.GetOutputs(node.name());
+    if (outputs.size() != 1) return false;
+    const NodeDef* consumer = *outputs.begin();
+    if (!candidates[consumer] || consumer->device() != node.device() ||
+        consumer->attr().at("T").type() != node.attr().at("T").type()) {
+      return false;
+    }
+    for (const string& input : consumer->input()) {
+      if (IsControlInput(input) && NodeName(input) == node.name()) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  absl::flat_hash_set<const NodeDef*> fused;
+  std::vector<NodeDef> fused_nodes;
+  for (const NodeDef& root : graph->node()) {
+    if (!candidates[&root] || is_absorbable(root)) continue;
+
+    // Collect the tree of absorbable ops in post order, and the arguments of
+    // the fused node.
+    std::vector<const NodeDef*> ops;
+    std::vector<string> args;
+    absl::flat_hash_map<string, int> arg_indices;
+    std::vector<std::pair<int, int>> operands;
+    int num_ops = 1;
+    std::function<int(const NodeDef&)> add_op = [&](const NodeDef& node) {
+      std::pair<int, int> node_operands = {-1, -1};
+      for (int i = 0; i < FusedElementwiseArity(node); ++i) {
+        const string& input = node.input(i);
+        int port;
+        const NodeDef* producer = node_map.GetNode(input);
+        ParseNodeName(input, &port);
+        int operand;
+        if (producer != nullptr && port == 0 &&
+            num_ops < kMaxFusedElementwiseOps && !fused.contains(producer) &&
+            is_absorbable(*producer)) {
+          fused.insert(producer);
+          ++num_ops;
+          // Refers to the result of the op, offset by the number of args once
+          // they are known.
+          operand = -2 - add_op(*producer);
+        } else {
+          auto it = arg_indices.find(input);
+          if (it == arg_indices.end()) {
+            it = arg_indices.emplace(input, args.size()).first;
+            args.push_back(input);
+          }
+          operand = it->second;
+        }
+        (i == 0 ? node_operands.first : node_operands.second) = operand;
+      }
+      ops.push_back(&node);
+      operands.push_back(node_operands);
+      return static_cast<int>(ops.size()) - 1;
+    };
+    add_op(root);
+    if (ops.size() < 2) continue;
+    VLOG(2) << "Fuse " << ops.size()
+            << " elementwise ops into _FusedElementwise: root=" << root.name();
+
+    NodeDef fused_op;
+    fused_op.set_name(root.name());
+    fused_op.set_op("_FusedElementwise");
+    fused_op.set_device(root.device());
+    for (const string& arg : args) fused_op.add_input(arg);
+    absl::flat_hash_set<string> control_inputs;
+    for (const NodeDef* node : ops) {
+      for (int i = FusedElementwiseArity(*node); i < node->input_size(); ++i) {
+        if (control_inputs.insert(node->input(i)).second) {
+          fused_op.add_input(node->input(i));
+        }
+      }
+    }
+    std::vector<string> fused_ops;
+    std::vector<int> fused_operands;
+    const int num_args = args.size();
+    for (int i = 0; i < ops.size(); ++i) {
+      fused_ops.push_back(ops[i]->op());
+      for (int operand : {operands[i].first, operands[i].second}) {
+        if (operand <= -2) operand = num_args + (-2 - operand);
+        fused_operands.push_back(operand);
+      }
+    }
+    auto* attr = fused_op.mutable_attr();
+    (*attr)["T"] = root.attr().at("T");
+    SetAttrValue(num_args, &(*attr)["num_args"]);
+    SetAttrValue(fused_ops, &(*attr)["fused_ops"]);
+    SetAttrValue(fused_operands, &(*attr)["operands"]);
+    fused.insert(&root);
+    fused_nodes.push_back(std::move(fused_op));
+  }
+  if (fused_nodes.empty()) return OkStatus();
+
+  // The absorbed ops have no other consumers, so only the roots need to be
+  // replaced.
+  GraphDef result;
+  if (graph->has_versions()) *result.mutable_versions() = graph->versions();
+  if (graph->has_library()) *result.mutable_library() = graph->library();
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (fused.contains(&node)) continue;
+    result.add_node()->Swap(&node);
+  }
+  for (NodeDef& fused_op : fused_nodes) {
+    result.add_node()->Swap(&fused_op);
+  }
+  graph->Swap(&result);
+  return OkStatus();
 }
 }  // namespace
 
@@ -3593,6 +4972,42 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap the gelu-subgraph of any other input into the _FusedGelu.
+    matched_nodes_map.clear();
+    remove_node_indices.clear();
+    if (allow_non_differentiable_rewrites &&
+        FindGelu(&ctx, i, &matched_nodes_map, &remove_node_indices,
+                 &is_gelu_approximate)) {
+      TF_RETURN_IF_ERROR(AddFusedGelu(&ctx, matched_nodes_map,
+                                      remove_node_indices, &invalidated_nodes,
+                                      &nodes_to_delete, is_gelu_approximate));
+      continue;
+    }
+
+    // Remap the moments and batch normalization of the last dimension, with
+    // an optional residual sum, into the _FusedLayerNorm.
+    matched_nodes_map.clear();
+    remove_node_indices.clear();
+    if (allow_non_differentiable_rewrites &&
+        FindLayerNorm(&ctx, i, &matched_nodes_map, &remove_node_indices)) {
+      TF_RETURN_IF_ERROR(
+          AddFusedLayerNorm(&ctx, matched_nodes_map, remove_node_indices,
+                            &invalidated_nodes, &nodes_to_delete));
+      continue;
+    }
+
+    // Remap {Mul,RealDiv}+AddV2+Softmax into the _FusedScaledMaskedSoftmax.
+    matched_nodes_map.clear();
+    remove_node_indices.clear();
+    if (allow_non_differentiable_rewrites &&
+        FindScaledMaskedSoftmax(&ctx, i, &matched_nodes_map,
+                                &remove_node_indices)) {
+      TF_RETURN_IF_ERROR(AddFusedScaledMaskedSoftmax(
+          &ctx, matched_nodes_map, remove_node_indices, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // Remap {Conv2D,DepthwiseConv2D,MatMul}+BiasAdd into the
     // _Fused{Conv2D,DepthwiseConv2dNative,MatMul}
     ContractionWithBiasAdd contract_with_bias;
@@ -3680,6 +5095,28 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
       continue;
     }
 
+    // Remap CropAndResize+Sub+{Mul,RealDiv}+<Cast> into _FusedCropAndResize.
+    CropAndResizeWithNormalization crop_and_resize_with_normalization;
+    if (allow_non_differentiable_rewrites &&
+        FindCropAndResizeWithNormalization(
+            ctx, i, &crop_and_resize_with_normalization)) {
+      TF_RETURN_IF_ERROR(AddFusedCropAndResizeNode(
+          &ctx, crop_and_resize_with_normalization, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
+    // Remap Gather+SparseSegment{Sum,Mean,SqrtN} into a Gather of the ids and
+    // a SparseSegment reduction of the table. Both are differentiable.
+    SparseSegmentReductionOfGather sparse_segment_reduction_of_gather;
+    if (FindSparseSegmentReductionOfGather(
+            ctx, i, &sparse_segment_reduction_of_gather)) {
+      TF_RETURN_IF_ERROR(AddSparseSegmentReductionOfGatheredIds(
+          &ctx, sparse_segment_reduction_of_gather, &invalidated_nodes,
+          &nodes_to_delete));
+      continue;
+    }
+
     // During inference, most of the inputs to FusedBatchNorm are constant, and
     // we can therefore replace the op with a much cheaper set of primitives.
     FusedBatchNorm fused_batch_norm;
@@ -3698,6 +5135,15 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
   TF_RETURN_IF_ERROR(mutation->Apply());
 
+  // Fuse the updates of independent variables into multi-tensor apply ops.
+  TF_RETURN_IF_ERROR(FuseResourceApplyOps(item, &mutable_item.graph));
+
+  // Evaluate chains of elementwise ops in one pass, unless XLA is expected to
+  // cluster them.
+  if (allow_non_differentiable_rewrites && !xla_auto_clustering_on_) {
+    TF_RETURN_IF_ERROR(FuseElementwiseChains(item, &mutable_item.graph));
+  }
+
   *optimized_graph = std::move(mutable_item.graph);
 
   return OkStatus();
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/remapper.h"
 
 #include "tensorflow/cc/ops/nn_ops_internal.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
@@ -1414,6 +1415,715 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+class RemapperSparseSegmentReductionOfGatherTest : public RemapperTest {
+ public:
+  // Builds GatherV2 followed by SparseSegment`combiner`, and checks that the
+  // reduction is rewritten to read from the table iff the gathered rows are
+  // not used elsewhere.
+  template <DataType DTYPE>
+  void RunTest(const string& combiner, bool fetch_gathered = false) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto params = ops::Placeholder(s.WithOpName("params"), DTYPE,
+                                   ops::Placeholder::Shape({100, 16}));
+    auto ids = ops::Const<int64_t>(s.WithOpName("ids"),
+                                   {3, 7, 7, 42, 99, 0, 15, 64}, {8});
+    auto axis = ops::Const(s.WithOpName("axis"), 0, {});
+    auto gather = ops::GatherV2(s.WithOpName("gather"), params, ids, axis);
+    auto indices =
+        ops::Const(s.WithOpName("indices"), {0, 1, 2, 3, 7, 4, 5, 6, 1}, {9});
+    auto segment_ids = ops::Const(s.WithOpName("segment_ids"),
+                                  {0, 0, 0, 1, 1, 3, 3, 3, 3}, {9});
+    Output reduction;
+    const Scope reduction_scope = s.WithOpName("reduction");
+    if (combiner == "Sum") {
+      reduction =
+          ops::SparseSegmentSum(reduction_scope, gather, indices, segment_ids);
+    } else if (combiner == "Mean") {
+      reduction =
+          ops::SparseSegmentMean(reduction_scope, gather, indices, segment_ids);
+    } else {
+      reduction = ops::SparseSegmentSqrtN(reduction_scope, gather, indices,
+                                          segment_ids);
+    }
+    auto fetch = ops::Identity(s.WithOpName("fetch"), reduction);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    if (fetch_gathered) item.fetch.push_back("gather");
+    item.feed = {{"params", GenerateRandomTensor<DTYPE>({100, 16})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      if (node.name() == "reduction") {
+        EXPECT_EQ(node.op(), "SparseSegment" + combiner);
+        ASSERT_EQ(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), fetch_gathered ? "gather" : "params");
+        EXPECT_EQ(node.input(1), fetch_gathered ? "indices" : "gather");
+        EXPECT_EQ(node.attr().at("Tidx").type(),
+                  fetch_gathered ? DT_INT32 : DT_INT64);
+        found++;
+      } else if (node.name() == "gather") {
+        ASSERT_EQ(node.input_size(), 3);
+        EXPECT_EQ(node.input(0), fetch_gathered ? "params" : "ids");
+        EXPECT_EQ(node.input(1), fetch_gathered ? "ids" : "indices");
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 2);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), tensors_expected.size());
+    for (int i = 0; i < tensors.size(); ++i) {
+      test::ExpectClose(tensors[i], tensors_expected[i]);
+    }
+  }
+};
+
+TEST_F(RemapperSparseSegmentReductionOfGatherTest, Sum) {
+  RunTest<DT_FLOAT>("Sum");
+}
+
+TEST_F(RemapperSparseSegmentReductionOfGatherTest, Mean) {
+  RunTest<DT_FLOAT>("Mean");
+}
+
+TEST_F(RemapperSparseSegmentReductionOfGatherTest, SqrtN) {
+  RunTest<DT_FLOAT>("SqrtN");
+}
+
+TEST_F(RemapperSparseSegmentReductionOfGatherTest, MeanBF16) {
+  RunTest<DT_BFLOAT16>("Mean");
+}
+
+TEST_F(RemapperSparseSegmentReductionOfGatherTest, GatheredRowsAreFetched) {
+  RunTest<DT_FLOAT>("Sum", /*fetch_gathered=*/true);
+}
+
+class RemapperCropAndResizeWithNormalizationTest : public RemapperTest {
+ public:
+  // Builds CropAndResize + Sub + {Mul, RealDiv} + <Cast to `OUT_DTYPE`>, and
+  // checks that it is rewritten into a _FusedCropAndResize.
+  template <DataType OUT_DTYPE>
+  void RunTest(bool divide, bool scale_first = false) {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto image = ops::Placeholder(s.WithOpName("image"), DT_UINT8,
+                                  ops::Placeholder::Shape({2, 16, 16, 3}));
+    auto boxes = ops::Const(s.WithOpName("boxes"),
+                            {0.0f, 0.0f, 1.0f, 1.0f, 0.1f, 0.2f, 0.7f, 0.9f,
+                             -0.1f, 0.5f, 1.2f, 0.6f},
+                            {3, 4});
+    auto box_ind = ops::Const(s.WithOpName("box_ind"), {0, 1, 1}, {3});
+    auto crop_size = ops::Const(s.WithOpName("crop_size"), {8, 12}, {2});
+    auto mean = ops::Const(s.WithOpName("mean"), {123.7f, 116.3f, 103.5f}, {3});
+    auto scale = ops::Const(s.WithOpName("scale"), {58.4f, 57.1f, 57.4f},
+                            {1, 1, 1, 3});
+
+    auto crop = ops::CropAndResize(s.WithOpName("crop"), image, boxes, box_ind,
+                                   crop_size);
+    auto sub = ops::Sub(s.WithOpName("sub"), crop, mean);
+    const string scale_name = OUT_DTYPE == DT_FLOAT ? "normalized" : "scale_op";
+    Output normalized;
+    if (divide) {
+      normalized = ops::RealDiv(s.WithOpName(scale_name), sub, scale);
+    } else if (scale_first) {
+      normalized = ops::Mul(s.WithOpName(scale_name), scale, sub);
+    } else {
+      normalized = ops::Mul(s.WithOpName(scale_name), sub, scale);
+    }
+    if (OUT_DTYPE != DT_FLOAT) {
+      normalized = ops::Cast(s.WithOpName("normalized"), normalized, OUT_DTYPE);
+    }
+    auto fetch = ops::Identity(s.WithOpName("fetch"), normalized);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"image", GenerateRandomTensor<DT_UINT8>({2, 16, 16, 3})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+    int found = 0;
+    for (const NodeDef& node : output.node()) {
+      EXPECT_NE(node.name(), "crop");
+      EXPECT_NE(node.name(), "sub");
+      EXPECT_NE(node.name(), "scale_op");
+      if (node.name() == "normalized") {
+        EXPECT_EQ(node.op(), "_FusedCropAndResize");
+        ASSERT_EQ(node.input_size(), 6);
+        EXPECT_EQ(node.input(0), "image");
+        EXPECT_EQ(node.input(1), "boxes");
+        EXPECT_EQ(node.input(2), "box_ind");
+        EXPECT_EQ(node.input(3), "crop_size");
+        EXPECT_EQ(node.input(4), "mean");
+        EXPECT_EQ(node.input(5), "scale");
+        EXPECT_EQ(node.attr().at("T").type(), DT_UINT8);
+        EXPECT_EQ(node.attr().at("out_type").type(), OUT_DTYPE);
+        EXPECT_EQ(node.attr().at("divide_by_scale").b(), divide);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    if (OUT_DTYPE == DT_FLOAT) {
+      test::ExpectClose(tensors[0], tensors_expected[0], 1e-5);
+    } else {
+      test::ExpectClose(tensors[0], tensors_expected[0], 1e-2, 1e-2);
+    }
+  }
+};
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, Mul) {
+  RunTest<DT_FLOAT>(/*divide=*/false);
+}
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, MulScaleFirst) {
+  RunTest<DT_FLOAT>(/*divide=*/false, /*scale_first=*/true);
+}
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, RealDiv) {
+  RunTest<DT_FLOAT>(/*divide=*/true);
+}
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, CastToHalf) {
+  RunTest<DT_HALF>(/*divide=*/true);
+}
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, CastToBF16) {
+  RunTest<DT_BFLOAT16>(/*divide=*/false);
+}
+
+TEST_F(RemapperCropAndResizeWithNormalizationTest, CropsAreFetched) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto image = ops::Placeholder(s.WithOpName("image"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 4, 4, 1}));
+  auto boxes = ops::Const(s.WithOpName("boxes"), {0.0f, 0.0f, 1.0f, 1.0f},
+                          {1, 4});
+  auto box_ind = ops::Const(s.WithOpName("box_ind"), {0}, {1});
+  auto crop_size = ops::Const(s.WithOpName("crop_size"), {2, 2}, {2});
+  auto crop = ops::CropAndResize(s.WithOpName("crop"), image, boxes, box_ind,
+                                 crop_size);
+  auto sub = ops::Sub(s.WithOpName("sub"), crop, 0.5f);
+  auto mul = ops::Mul(s.WithOpName("mul"), sub, 2.0f);
+
+  GrapplerItem item;
+  // The crops are used by another fetch node, so they can not be fused.
+  item.fetch = {"mul", "crop"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedCropAndResize");
+  }
+}
+
+class RemapperFuseResourceApplyTest : public RemapperTest {
+ protected:
+  RemapperFuseResourceApplyTest()
+      : scope_(Scope::NewRootScope()),
+        lr_(ops::Const(scope_.WithOpName("lr"), 0.1f)) {}
+
+  Output Variable(const string& name) {
+    return ops::VarHandleOp(scope_.WithOpName(name), DT_FLOAT, {2, 3});
+  }
+
+  Output Grad(const string& name) {
+    return ops::Placeholder(scope_.WithOpName(name), DT_FLOAT,
+                            ops::Placeholder::Shape({2, 3}));
+  }
+
+  GraphDef Optimize(const std::vector<string>& fetch) {
+    GrapplerItem item;
+    item.fetch = fetch;
+    TF_CHECK_OK(scope_.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+    return output;
+  }
+
+  Scope scope_;
+  Output lr_;
+};
+
+TEST_F(RemapperFuseResourceApplyTest, GradientDescent) {
+  std::vector<Operation> updates;
+  for (const string& name : {"a", "b", "c"}) {
+    updates.push_back(ops::ResourceApplyGradientDescent(
+                          scope_.WithOpName("update_" + name), Variable(name),
+                          lr_, Grad("grad_" + name))
+                          .operation);
+  }
+  ops::NoOp(scope_.WithOpName("train").WithControlDependencies(updates));
+
+  GraphDef output = Optimize({"train"});
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "ResourceApplyGradientDescent");
+    if (node.name() == "FusedResourceApply/update_a") {
+      EXPECT_EQ(node.op(), "_FusedResourceApplyGradientDescent");
+      EXPECT_EQ(node.attr().at("N").i(), 3);
+      EXPECT_EQ(node.attr().at("T").type(), DT_FLOAT);
+      ASSERT_EQ(node.input_size(), 7);
+      EXPECT_EQ(node.input(0), "a");
+      EXPECT_EQ(node.input(1), "b");
+      EXPECT_EQ(node.input(2), "c");
+      EXPECT_EQ(node.input(3), "lr");
+      EXPECT_EQ(node.input(4), "grad_a");
+      EXPECT_EQ(node.input(5), "grad_b");
+      EXPECT_EQ(node.input(6), "grad_c");
+      found++;
+    } else if (node.name() == "train") {
+      ASSERT_EQ(node.input_size(), 1);
+      EXPECT_EQ(node.input(0), "^FusedResourceApply/update_a");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+}
+
+TEST_F(RemapperFuseResourceApplyTest, Adam) {
+  auto beta1_power = ops::Const(scope_.WithOpName("beta1_power"), 0.9f);
+  auto beta2_power = ops::Const(scope_.WithOpName("beta2_power"), 0.999f);
+  auto beta1 = ops::Const(scope_.WithOpName("beta1"), 0.9f);
+  auto beta2 = ops::Const(scope_.WithOpName("beta2"), 0.999f);
+  auto epsilon = ops::Const(scope_.WithOpName("epsilon"), 1e-7f);
+  std::vector<Operation> updates;
+  for (const string& name : {"a", "b"}) {
+    updates.push_back(
+        ops::ResourceApplyAdam(scope_.WithOpName("update_" + name),
+                               Variable(name), Variable("m_" + name),
+                               Variable("v_" + name), beta1_power, beta2_power,
+                               lr_, beta1, beta2, epsilon, Grad("grad_" + name))
+            .operation);
+  }
+  ops::NoOp(scope_.WithOpName("train").WithControlDependencies(updates));
+
+  GraphDef output = Optimize({"train"});
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "ResourceApplyAdam");
+    if (node.op() == "_FusedResourceApplyAdam") {
+      EXPECT_EQ(node.attr().at("N").i(), 2);
+      ASSERT_EQ(node.input_size(), 14);
+      EXPECT_EQ(node.input(0), "a");
+      EXPECT_EQ(node.input(1), "b");
+      EXPECT_EQ(node.input(2), "m_a");
+      EXPECT_EQ(node.input(3), "m_b");
+      EXPECT_EQ(node.input(4), "v_a");
+      EXPECT_EQ(node.input(5), "v_b");
+      EXPECT_EQ(node.input(6), "beta1_power");
+      EXPECT_EQ(node.input(11), "epsilon");
+      EXPECT_EQ(node.input(12), "grad_a");
+      EXPECT_EQ(node.input(13), "grad_b");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+}
+
+TEST_F(RemapperFuseResourceApplyTest, IncompatibleOrDependentUpdatesNotFused) {
+  auto update_a = ops::ResourceApplyGradientDescent(
+      scope_.WithOpName("update_a"), Variable("a"), lr_, Grad("grad_a"));
+  // Different learning rate.
+  auto other_lr = ops::Const(scope_.WithOpName("other_lr"), 0.2f);
+  auto update_b = ops::ResourceApplyGradientDescent(
+      scope_.WithOpName("update_b"), Variable("b"), other_lr, Grad("grad_b"));
+  // Runs after `update_a`, through a read of the updated variable.
+  auto read = ops::ReadVariableOp(
+      scope_.WithOpName("read").WithControlDependencies(update_a.operation),
+      Variable("c"), DT_FLOAT);
+  auto update_c = ops::ResourceApplyGradientDescent(
+      scope_.WithOpName("update_c"), Variable("d"), lr_, read);
+  ops::NoOp(scope_.WithOpName("train").WithControlDependencies(
+      {update_a.operation, update_b.operation, update_c.operation}));
+
+  GraphDef output = Optimize({"train"});
+  int num_updates = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.op(), "_FusedResourceApplyGradientDescent");
+    if (node.op() == "ResourceApplyGradientDescent") num_updates++;
+  }
+  EXPECT_EQ(num_updates, 3);
+}
+
+class RemapperFuseLayerNormTest : public GrapplerTest {
+ public:
+  void RunTest(bool with_residual, bool with_stop_gradient) {
+    using ::tensorflow::ops::Placeholder;
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto shape = Placeholder::Shape({4, 6, 32});
+    auto x = Placeholder(s.WithOpName("x"), DT_FLOAT, shape);
+    auto residual = Placeholder(s.WithOpName("residual"), DT_FLOAT, shape);
+    auto gamma = Placeholder(s.WithOpName("gamma"), DT_FLOAT,
+                             Placeholder::Shape({32}));
+    auto beta =
+        Placeholder(s.WithOpName("beta"), DT_FLOAT, Placeholder::Shape({32}));
+
+    // tf.nn.moments followed by tf.nn.batch_normalization.
+    Output input = x;
+    if (with_residual) {
+      input = ops::AddV2(s.WithOpName("residual_add"), x, residual);
+    }
+    auto mean = ops::Mean(s.WithOpName("mean"), input,
+                          ops::Const(s.WithOpName("mean_axes"), {-1}),
+                          ops::Mean::KeepDims(true));
+    Output centered_mean = mean;
+    if (with_stop_gradient) {
+      centered_mean = ops::StopGradient(s.WithOpName("stop_gradient"), mean);
+    }
+    auto squared_difference = ops::SquaredDifference(
+        s.WithOpName("squared_difference"), input, centered_mean);
+    auto variance = ops::Mean(s.WithOpName("variance"), squared_difference,
+                              ops::Const(s.WithOpName("variance_axes"), {-1}),
+                              ops::Mean::KeepDims(true));
+    auto variance_plus_epsilon =
+        ops::AddV2(s.WithOpName("variance_plus_epsilon"), variance,
+                   ops::Const(s.WithOpName("epsilon"), 1e-6f));
+    auto rsqrt = ops::Rsqrt(s.WithOpName("rsqrt"), variance_plus_epsilon);
+    auto inv = ops::Mul(s.WithOpName("inv"), rsqrt, gamma);
+    auto input_times_inv =
+        ops::Mul(s.WithOpName("input_times_inv"), input, inv);
+    auto mean_times_inv = ops::Mul(s.WithOpName("mean_times_inv"), mean, inv);
+    auto offset = ops::Sub(s.WithOpName("offset"), beta, mean_times_inv);
+    auto output = ops::AddV2(s.WithOpName("output"), input_times_inv, offset);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), output);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"x", GenerateRandomTensor<DT_FLOAT>({4, 6, 32})},
+                 {"residual", GenerateRandomTensor<DT_FLOAT>({4, 6, 32})},
+                 {"gamma", GenerateRandomTensor<DT_FLOAT>({32})},
+                 {"beta", GenerateRandomTensor<DT_FLOAT>({32})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef optimized;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+    int found = 0;
+    for (const NodeDef& node : optimized.node()) {
+      EXPECT_NE(node.name(), "mean");
+      EXPECT_NE(node.name(), "rsqrt");
+      EXPECT_NE(node.name(), "residual_add");
+      if (node.name() == "output") {
+        EXPECT_EQ(node.op(), "_FusedLayerNorm");
+        ASSERT_EQ(node.input_size(), with_residual ? 4 : 3);
+        EXPECT_EQ(node.input(0), "x");
+        EXPECT_EQ(node.input(1), "gamma");
+        EXPECT_EQ(node.input(2), "beta");
+        if (with_residual) EXPECT_EQ(node.input(3), "residual");
+        EXPECT_EQ(node.attr().at("num_residual").i(), with_residual ? 1 : 0);
+        EXPECT_FLOAT_EQ(node.attr().at("epsilon").f(), 1e-6f);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(optimized, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectClose(tensors[0], tensors_expected[0], 1e-5, /*rtol=*/1e-5);
+  }
+};
+
+TEST_F(RemapperFuseLayerNormTest, LayerNorm) {
+  RunTest(/*with_residual=*/false, /*with_stop_gradient=*/true);
+}
+
+TEST_F(RemapperFuseLayerNormTest, LayerNormWithoutStopGradient) {
+  RunTest(/*with_residual=*/false, /*with_stop_gradient=*/false);
+}
+
+TEST_F(RemapperFuseLayerNormTest, LayerNormWithResidual) {
+  RunTest(/*with_residual=*/true, /*with_stop_gradient=*/true);
+}
+
+class RemapperFuseGeluTest : public GrapplerTest {
+ public:
+  void RunTest(bool approximate) {
+    using ::tensorflow::ops::Placeholder;
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+    auto x = Placeholder(s.WithOpName("x"), DT_FLOAT,
+                         Placeholder::Shape({16, 64}));
+    auto one = ops::Const(s.WithOpName("one"), 1.0f);
+    auto one_half = ops::Const(s.WithOpName("one_half"), 0.5f);
+    Output inner;
+    if (approximate) {
+      // 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))).
+      auto pow = ops::Pow(s.WithOpName("pow"), x,
+                          ops::Const(s.WithOpName("three"), 3.0f));
+      auto mul =
+          ops::Mul(s.WithOpName("mul"), pow,
+                   ops::Const(s.WithOpName("empirical_const"), 0.044715f));
+      auto input_plus_mul = ops::AddV2(s.WithOpName("input_plus_mul"), x, mul);
+      auto scaled = ops::Mul(
+          s.WithOpName("scaled"), input_plus_mul,
+          ops::Const(s.WithOpName("square_root_two_over_pi"), 0.7978846f));
+      inner = ops::Tanh(s.WithOpName("tanh"), scaled);
+    } else {
+      // 0.5 * x * (1 + erf(x / sqrt(2))).
+      auto scaled = ops::Mul(
+          s.WithOpName("scaled"), x,
+          ops::Const(s.WithOpName("square_root_one_half"), 0.7071068f));
+      inner = ops::Erf(s.WithOpName("erf"), scaled);
+    }
+    auto inner_plus_one =
+        ops::AddV2(s.WithOpName("inner_plus_one"), inner, one);
+    auto times_one_half =
+        ops::Mul(s.WithOpName("times_one_half"), inner_plus_one, one_half);
+    auto output = ops::Mul(s.WithOpName("output"), times_one_half, x);
+    auto fetch = ops::Identity(s.WithOpName("fetch"), output);
+
+    GrapplerItem item;
+    item.fetch = {"fetch"};
+    item.feed = {{"x", GenerateRandomTensor<DT_FLOAT>({16, 64})}};
+    TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+    for (int i = 0; i < item.graph.node_size(); ++i) {
+      item.graph.mutable_node(i)->set_device("/device:CPU:0");
+    }
+
+    Remapper optimizer(RewriterConfig::ON);
+    GraphDef optimized;
+    TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+    int found = 0;
+    for (const NodeDef& node : optimized.node()) {
+      EXPECT_NE(node.name(), "scaled");
+      EXPECT_NE(node.name(), "times_one_half");
+      if (node.name() == "output") {
+        EXPECT_EQ(node.op(), "_FusedGelu");
+        ASSERT_EQ(node.input_size(), 1);
+        EXPECT_EQ(node.input(0), "x");
+        EXPECT_EQ(node.attr().at("approximate").b(), approximate);
+        found++;
+      }
+    }
+    EXPECT_EQ(found, 1);
+
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+    ASSERT_EQ(tensors_expected.size(), 1);
+    auto tensors = EvaluateNodes(optimized, item.fetch, item.feed);
+    ASSERT_EQ(tensors.size(), 1);
+    test::ExpectClose(tensors[0], tensors_expected[0], 1e-5, /*rtol=*/1e-5);
+  }
+};
+
+TEST_F(RemapperFuseGeluTest, Exact) { RunTest(/*approximate=*/false); }
+
+TEST_F(RemapperFuseGeluTest, Approximate) { RunTest(/*approximate=*/true); }
+
+TEST_F(RemapperTest, FuseScaledMaskedSoftmax) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // Attention scores of shape [batch, heads, queries, keys], masked along the
+  // keys.
+  auto scores = Placeholder(s.WithOpName("scores"), DT_FLOAT,
+                            Placeholder::Shape({2, 4, 8, 8}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          Placeholder::Shape({2, 1, 1, 8}));
+  auto scaled = ops::RealDiv(s.WithOpName("scaled"), scores,
+                             ops::Const(s.WithOpName("scale"), 4.0f));
+  auto masked = ops::AddV2(s.WithOpName("masked"), mask, scaled);
+  auto output = ops::Softmax(s.WithOpName("output"), masked);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), output);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"scores", GenerateRandomTensor<DT_FLOAT>({2, 4, 8, 8})},
+               {"mask", GenerateRandomTensor<DT_FLOAT>({2, 1, 1, 8})}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+  int found = 0;
+  for (const NodeDef& node : optimized.node()) {
+    EXPECT_NE(node.name(), "scaled");
+    EXPECT_NE(node.name(), "masked");
+    if (node.name() == "output") {
+      EXPECT_EQ(node.op(), "_FusedScaledMaskedSoftmax");
+      ASSERT_EQ(node.input_size(), 2);
+      EXPECT_EQ(node.input(0), "scores");
+      EXPECT_EQ(node.input(1), "mask");
+      EXPECT_EQ(node.attr().at("num_mask").i(), 1);
+      EXPECT_FLOAT_EQ(node.attr().at("scale").f(), 0.25f);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(optimized, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6, /*rtol=*/1e-5);
+}
+
+TEST_F(RemapperTest, ScaledSoftmaxWithMaskOfOutputShapeNotFused) {
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  // The mask broadcasts the scores to a larger shape.
+  auto scores = Placeholder(s.WithOpName("scores"), DT_FLOAT,
+                            Placeholder::Shape({1, 8}));
+  auto mask = Placeholder(s.WithOpName("mask"), DT_FLOAT,
+                          Placeholder::Shape({4, 8}));
+  auto scaled = ops::Mul(s.WithOpName("scaled"), scores,
+                         ops::Const(s.WithOpName("scale"), 0.5f));
+  auto masked = ops::AddV2(s.WithOpName("masked"), scaled, mask);
+  auto output = ops::Softmax(s.WithOpName("output"), masked);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), output);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+  for (const NodeDef& node : optimized.node()) {
+    if (node.name() == "output") EXPECT_EQ(node.op(), "Softmax");
+  }
+}
+
+TEST_F(RemapperTest, FuseElementwiseChain) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto shape = ops::Placeholder::Shape({8, 16});
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT, shape);
+  auto c = ops::Placeholder(s.WithOpName("c"), DT_FLOAT, shape);
+  auto a = ops::Const(s.WithOpName("a"), 0.5f);
+  auto b = ops::Const(s.WithOpName("b"), 0.25f);
+  // tanh(x * a + b) * c.
+  auto mul = ops::Mul(s.WithOpName("mul"), x, a);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, b);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  auto output = ops::Mul(s.WithOpName("output"), tanh, c);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), output);
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", GenerateRandomTensor<DT_FLOAT>({8, 16})},
+               {"c", GenerateRandomTensor<DT_FLOAT>({8, 16})}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+  int found = 0;
+  for (const NodeDef& node : optimized.node()) {
+    EXPECT_NE(node.name(), "mul");
+    EXPECT_NE(node.name(), "add");
+    EXPECT_NE(node.name(), "tanh");
+    if (node.name() == "output") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 4);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "a");
+      EXPECT_EQ(node.input(2), "b");
+      EXPECT_EQ(node.input(3), "c");
+      EXPECT_EQ(node.attr().at("num_args").i(), 4);
+      const auto& fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 4);
+      EXPECT_EQ(fused_ops[0], "Mul");
+      EXPECT_EQ(fused_ops[1], "AddV2");
+      EXPECT_EQ(fused_ops[2], "Tanh");
+      EXPECT_EQ(fused_ops[3], "Mul");
+      const auto& operands = node.attr().at("operands").list().i();
+      EXPECT_EQ(std::vector<int64_t>(operands.begin(), operands.end()),
+                std::vector<int64_t>({0, 1, 4, 2, 5, -1, 6, 3}));
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(optimized, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseElementwiseChainStopsAtSharedOrBroadcastInputs) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({8, 16}));
+  auto bias = ops::Placeholder(s.WithOpName("bias"), DT_FLOAT,
+                               ops::Placeholder::Shape({16}));
+  // `exp` has two consumers, and the bias is broadcast along rows.
+  auto exp = ops::Exp(s.WithOpName("exp"), x);
+  auto neg = ops::Neg(s.WithOpName("neg"), exp);
+  auto add = ops::AddV2(s.WithOpName("add"), neg, bias);
+  auto relu = ops::Relu(s.WithOpName("relu"), add);
+  auto output = ops::Mul(s.WithOpName("output"), relu, exp);
+
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef optimized;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &optimized));
+
+  // Only `relu` can be fused into `output`: `add` broadcasts its input.
+  std::map<string, string> ops;
+  for (const NodeDef& node : optimized.node()) ops[node.name()] = node.op();
+  EXPECT_EQ(ops["exp"], "Exp");
+  EXPECT_EQ(ops["neg"], "Neg");
+  EXPECT_EQ(ops["add"], "AddV2");
+  EXPECT_EQ(ops.count("relu"), 0);
+  EXPECT_EQ(ops["output"], "_FusedElementwise");
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
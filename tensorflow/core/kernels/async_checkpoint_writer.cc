@@ -0,0 +1,102 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace checkpoint {
+
+namespace {
+
+// Number of checkpoints written concurrently by the global writer, e.g. the
+// shards of a sharded save.
+constexpr int kNumGlobalWriterThreads = 8;
+
+}  // namespace
+
+AsyncCheckpointWriter::AsyncCheckpointWriter(int num_threads)
+    : pool_(new thread::ThreadPool(Env::Default(), "async_checkpoint_writer",
+                                   num_threads)) {}
+
+AsyncCheckpointWriter::~AsyncCheckpointWriter() {
+  WaitForAll().IgnoreError();
+}
+
+AsyncCheckpointWriter* AsyncCheckpointWriter::Global() {
+  static AsyncCheckpointWriter* writer =
+      new AsyncCheckpointWriter(kNumGlobalWriterThreads);
+  return writer;
+}
+
+Status AsyncCheckpointWriter::Schedule(const std::string& prefix,
+                                       std::function<Status()> write) {
+  auto pending = std::make_shared<Write>();
+  {
+    mutex_lock lock(mu_);
+    TF_RETURN_IF_ERROR(WaitLocked(prefix, lock));
+    writes_[prefix] = pending;
+  }
+  pool_->Schedule([this, prefix, pending, write = std::move(write)]() {
+    Status status = write();
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to write checkpoint " << prefix << ": " << status;
+    }
+    mutex_lock lock(mu_);
+    pending->done = true;
+    pending->status = status;
+    // Successful writes are forgotten right away, failed ones are kept until
+    // their error is returned by a wait.
+    if (status.ok()) {
+      auto it = writes_.find(prefix);
+      if (it != writes_.end() && it->second == pending) writes_.erase(it);
+    }
+    done_cv_.notify_all();
+  });
+  return OkStatus();
+}
+
+Status AsyncCheckpointWriter::Wait(const std::string& prefix) {
+  mutex_lock lock(mu_);
+  return WaitLocked(prefix, lock);
+}
+
+Status AsyncCheckpointWriter::WaitLocked(const std::string& prefix,
+                                         mutex_lock& lock) {
+  auto it = writes_.find(prefix);
+  if (it == writes_.end()) return OkStatus();
+  std::shared_ptr<Write> write = it->second;
+  while (!write->done) done_cv_.wait(lock);
+  it = writes_.find(prefix);
+  if (it != writes_.end() && it->second == write) writes_.erase(it);
+  return write->status;
+}
+
+Status AsyncCheckpointWriter::WaitForAll() {
+  mutex_lock lock(mu_);
+  Status status;
+  while (!writes_.empty()) {
+    const std::string prefix = writes_.begin()->first;
+    status.Update(WaitLocked(prefix, lock));
+  }
+  return status;
+}
+
+}  // namespace checkpoint
+}  // namespace tensorflow
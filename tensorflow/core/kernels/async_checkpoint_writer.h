@@ -0,0 +1,83 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
+#define TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace checkpoint {
+
+// Runs the checkpoint writes of SaveV2 ops with `async_write` on background
+// threads, and tracks them by checkpoint prefix so that later ops using the
+// same files can wait for them.
+//
+// A write that fails is logged, and its error is returned by the next wait
+// on its prefix.
+class AsyncCheckpointWriter {
+ public:
+  explicit AsyncCheckpointWriter(int num_threads);
+  // Waits for all pending writes.
+  ~AsyncCheckpointWriter();
+
+  AsyncCheckpointWriter(const AsyncCheckpointWriter&) = delete;
+  AsyncCheckpointWriter& operator=(const AsyncCheckpointWriter&) = delete;
+
+  // Returns the writer shared by the checkpointing ops of this process.
+  static AsyncCheckpointWriter* Global();
+
+  // Runs `write`, which writes the checkpoint at `prefix`, on a background
+  // thread. A pending write of the same prefix is waited for first, and its
+  // error is returned instead of scheduling `write` if it failed.
+  Status Schedule(const std::string& prefix, std::function<Status()> write);
+
+  // Waits for the pending write of `prefix`, if any, and returns its status.
+  Status Wait(const std::string& prefix);
+
+  // Waits for all pending writes, and returns the first error among them.
+  Status WaitForAll();
+
+ private:
+  struct Write {
+    bool done = false;
+    Status status;
+  };
+
+  // Waits for the write of `prefix` and forgets it. Returns OK if there is
+  // no such write.
+  Status WaitLocked(const std::string& prefix, mutex_lock& lock)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  condition_variable done_cv_;
+  // Pending writes, and failed writes that were not waited for yet.
+  absl::flat_hash_map<std::string, std::shared_ptr<Write>> writes_
+      TF_GUARDED_BY(mu_);
+  std::unique_ptr<thread::ThreadPool> pool_;
+};
+
+}  // namespace checkpoint
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_ASYNC_CHECKPOINT_WRITER_H_
@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace checkpoint {
+namespace {
+
+TEST(AsyncCheckpointWriterTest, WaitBlocksUntilWriteIsDone) {
+  AsyncCheckpointWriter writer(/*num_threads=*/2);
+  Notification start_write;
+  std::atomic<bool> written{false};
+  TF_ASSERT_OK(writer.Schedule("ckpt", [&]() {
+    start_write.WaitForNotification();
+    written = true;
+    return OkStatus();
+  }));
+  EXPECT_FALSE(written);
+  start_write.Notify();
+  TF_EXPECT_OK(writer.Wait("ckpt"));
+  EXPECT_TRUE(written);
+  // Waiting for a prefix without writes returns right away.
+  TF_EXPECT_OK(writer.Wait("other"));
+}
+
+TEST(AsyncCheckpointWriterTest, ErrorsAreReturnedOnce) {
+  AsyncCheckpointWriter writer(/*num_threads=*/2);
+  TF_ASSERT_OK(writer.Schedule(
+      "ckpt", []() { return errors::Internal("write failed"); }));
+  Status status = writer.Wait("ckpt");
+  EXPECT_TRUE(errors::IsInternal(status));
+  TF_EXPECT_OK(writer.Wait("ckpt"));
+
+  // A failed write is also reported instead of scheduling the next write of
+  // the same prefix.
+  TF_ASSERT_OK(writer.Schedule(
+      "ckpt", []() { return errors::Internal("write failed"); }));
+  bool scheduled = false;
+  status = writer.Schedule("ckpt", [&scheduled]() {
+    scheduled = true;
+    return OkStatus();
+  });
+  EXPECT_TRUE(errors::IsInternal(status));
+  TF_EXPECT_OK(writer.WaitForAll());
+  EXPECT_FALSE(scheduled);
+}
+
+TEST(AsyncCheckpointWriterTest, WritesOfSamePrefixAreSerialized) {
+  AsyncCheckpointWriter writer(/*num_threads=*/4);
+  std::atomic<int> num_running{0};
+  std::atomic<int> max_running{0};
+  auto write = [&]() {
+    const int running = ++num_running;
+    int max = max_running;
+    while (running > max && !max_running.compare_exchange_weak(max, running)) {
+    }
+    Env::Default()->SleepForMicroseconds(1000);
+    --num_running;
+    return OkStatus();
+  };
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(writer.Schedule("ckpt", write));
+  }
+  TF_EXPECT_OK(writer.WaitForAll());
+  EXPECT_EQ(max_running, 1);
+}
+
+TEST(AsyncCheckpointWriterTest, WaitForAll) {
+  AsyncCheckpointWriter writer(/*num_threads=*/4);
+  std::atomic<int> num_written{0};
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(writer.Schedule(strings::StrCat("ckpt-", i), [&, i]() {
+      ++num_written;
+      return i == 3 ? errors::DataLoss("write failed") : OkStatus();
+    }));
+  }
+  EXPECT_TRUE(errors::IsDataLoss(writer.WaitForAll()));
+  EXPECT_EQ(num_written, 10);
+  TF_EXPECT_OK(writer.WaitForAll());
+}
+
+}  // namespace
+}  // namespace checkpoint
+}  // namespace tensorflow
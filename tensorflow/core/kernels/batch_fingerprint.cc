@@ -0,0 +1,247 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_fingerprint.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(TENSORFLOW_DISABLE_BATCH_FINGERPRINT_SIMD)
+#define TENSORFLOW_USE_BATCH_FINGERPRINT_SIMD (1)
+#include <immintrin.h>
+#define TF_FINGERPRINT_TARGET \
+  __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,bmi2")))
+#endif
+
+namespace tensorflow {
+
+namespace {
+
+std::atomic<bool> g_simd_enabled{true};
+
+#ifdef TENSORFLOW_USE_BATCH_FINGERPRINT_SIMD
+
+// The SIMD codepath reimplements the short string cases of FarmHash's
+// Fingerprint64 (farmhashna::Hash64), which Fingerprint64() is guaranteed to
+// be. Each of the 8 lanes of a vector holds one string.
+constexpr int kLanes = 8;
+constexpr int64_t kMaxSimdLength = 32;
+// Every string of a group is copied to a row of this many bytes, so that all
+// the loads below, including those of the cases that do not apply to the
+// string, stay within the row.
+constexpr int64_t kRowBytes = 64;
+
+constexpr uint64 k0 = 0xc3a5c85c97cb3127ULL;
+constexpr uint64 k1 = 0xb492b66fbe98f273ULL;
+constexpr uint64 k2 = 0x9ae16a3b2f90404fULL;
+
+bool IsSupported() {
+  static const bool supported =
+      port::TestCPUFeature(port::CPUFeature::AVX512F) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512DQ) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512BW) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512VL) &&
+      port::TestCPUFeature(port::CPUFeature::BMI2);
+  return supported;
+}
+
+TF_FINGERPRINT_TARGET inline __m512i ShiftMix(__m512i v) {
+  return _mm512_xor_si512(v, _mm512_srli_epi64(v, 47));
+}
+
+TF_FINGERPRINT_TARGET inline __m512i Mul(__m512i a, __m512i b) {
+  return _mm512_mullo_epi64(a, b);
+}
+
+// HashLen16(u, v, mul) of FarmHash.
+TF_FINGERPRINT_TARGET inline __m512i HashLen16(__m512i u, __m512i v,
+                                               __m512i mul) {
+  __m512i a = ShiftMix(Mul(_mm512_xor_si512(u, v), mul));
+  __m512i b = ShiftMix(Mul(_mm512_xor_si512(v, a), mul));
+  return Mul(b, mul);
+}
+
+// Loads the 8 bytes at offset max(`offsets`, 0) of the row of each lane.
+TF_FINGERPRINT_TARGET inline __m512i Fetch64(const uint8* rows,
+                                             __m512i row_starts,
+                                             __m512i offsets) {
+  offsets = _mm512_max_epi64(offsets, _mm512_setzero_si512());
+  return _mm512_i64gather_epi64(_mm512_add_epi64(row_starts, offsets), rows,
+                                1);
+}
+
+// Fingerprints the `lengths` bytes at the start of each of the kLanes rows of
+// `rows`. All lengths are at most kMaxSimdLength.
+TF_FINGERPRINT_TARGET __m512i FingerprintRows(const uint8* rows,
+                                              __m512i lengths) {
+  const __m512i row_starts = _mm512_set_epi64(
+      7 * kRowBytes, 6 * kRowBytes, 5 * kRowBytes, 4 * kRowBytes,
+      3 * kRowBytes, 2 * kRowBytes, kRowBytes, 0);
+  const __m512i zero = _mm512_setzero_si512();
+  const __m512i low8 = _mm512_set1_epi64(0xff);
+  const __m512i low32 = _mm512_set1_epi64(0xffffffffULL);
+  const __m512i vk0 = _mm512_set1_epi64(k0);
+  const __m512i vk1 = _mm512_set1_epi64(k1);
+  const __m512i vk2 = _mm512_set1_epi64(k2);
+
+  // Masks of the lanes handled by each case of FarmHash.
+  const __mmask8 len_ge_4 =
+      _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(4));
+  const __mmask8 len_ge_8 =
+      _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(8));
+  const __mmask8 len_ge_17 =
+      _mm512_cmpge_epu64_mask(lengths, _mm512_set1_epi64(17));
+  const __mmask8 len_gt_0 = _mm512_cmpgt_epu64_mask(lengths, zero);
+  const __mmask8 len_1_to_3 = len_gt_0 & ~len_ge_4;
+
+  const __m512i mul =
+      _mm512_add_epi64(vk2, _mm512_add_epi64(lengths, lengths));
+  const __m512i first = Fetch64(rows, row_starts, zero);
+  const __m512i last8 = Fetch64(
+      rows, row_starts, _mm512_sub_epi64(lengths, _mm512_set1_epi64(8)));
+
+  // Lengths 4 to 7.
+  __m512i u = _mm512_add_epi64(
+      lengths, _mm512_slli_epi64(_mm512_and_si512(first, low32), 3));
+  __m512i v = _mm512_and_si512(
+      Fetch64(rows, row_starts,
+              _mm512_sub_epi64(lengths, _mm512_set1_epi64(4))),
+      low32);
+
+  // Lengths 8 to 16.
+  const __mmask8 len_8_to_16 = len_ge_8 & ~len_ge_17;
+  if (len_8_to_16) {
+    const __m512i a = _mm512_add_epi64(first, vk2);
+    const __m512i b = last8;
+    const __m512i c = _mm512_add_epi64(Mul(_mm512_ror_epi64(b, 37), mul), a);
+    const __m512i d = Mul(_mm512_add_epi64(_mm512_ror_epi64(a, 25), b), mul);
+    u = _mm512_mask_mov_epi64(u, len_8_to_16, c);
+    v = _mm512_mask_mov_epi64(v, len_8_to_16, d);
+  }
+
+  // Lengths 17 to 32.
+  if (len_ge_17) {
+    const __m512i a = Mul(first, vk1);
+    const __m512i b = Fetch64(rows, row_starts, _mm512_set1_epi64(8));
+    const __m512i c = Mul(last8, mul);
+    const __m512i d = Mul(
+        Fetch64(rows, row_starts,
+                _mm512_sub_epi64(lengths, _mm512_set1_epi64(16))),
+        vk2);
+    const __m512i x = _mm512_add_epi64(
+        _mm512_add_epi64(_mm512_ror_epi64(_mm512_add_epi64(a, b), 43),
+                         _mm512_ror_epi64(c, 30)),
+        d);
+    const __m512i y = _mm512_add_epi64(
+        _mm512_add_epi64(a, _mm512_ror_epi64(_mm512_add_epi64(b, vk2), 18)),
+        c);
+    u = _mm512_mask_mov_epi64(u, len_ge_17, x);
+    v = _mm512_mask_mov_epi64(v, len_ge_17, y);
+  }
+
+  // Lengths 0 to 3.
+  __m512i result = _mm512_mask_mov_epi64(vk2, len_ge_4, HashLen16(u, v, mul));
+  if (len_1_to_3) {
+    const __m512i a = _mm512_and_si512(first, low8);
+    const __m512i b = _mm512_and_si512(
+        Fetch64(rows, row_starts, _mm512_srli_epi64(lengths, 1)), low8);
+    const __m512i c = _mm512_and_si512(
+        Fetch64(rows, row_starts,
+                _mm512_sub_epi64(lengths, _mm512_set1_epi64(1))),
+        low8);
+    const __m512i y = _mm512_add_epi64(a, _mm512_slli_epi64(b, 8));
+    const __m512i z = _mm512_add_epi64(lengths, _mm512_slli_epi64(c, 2));
+    const __m512i h =
+        Mul(ShiftMix(_mm512_xor_si512(Mul(y, vk2), Mul(z, vk0))), vk2);
+    result = _mm512_mask_mov_epi64(result, len_1_to_3, h);
+  }
+  return result;
+}
+
+TF_FINGERPRINT_TARGET void BatchFingerprint64Simd(const tstring* strings,
+                                                  int64_t n,
+                                                  uint64* fingerprints) {
+  // The strings are copied in blocks of kBlockGroups groups of kLanes strings
+  // before any of them is fingerprinted, so that the vector loads of a group
+  // do not wait for the stores that copied it.
+  constexpr int kBlockGroups = 16;
+  constexpr int kBlockSize = kBlockGroups * kLanes;
+  alignas(64) uint8 rows[kBlockSize * kRowBytes] = {};
+  alignas(64) int64_t lengths[kBlockSize];
+  for (int64_t block_start = 0; block_start < n; block_start += kBlockSize) {
+    const int block_size = std::min<int64_t>(kBlockSize, n - block_start);
+    const tstring* block_strings = strings + block_start;
+    bool has_long_strings = false;
+    for (int i = 0; i < block_size; ++i) {
+      const int64_t length = block_strings[i].size();
+      if (length > kMaxSimdLength) {
+        has_long_strings = true;
+        lengths[i] = 0;
+        continue;
+      }
+      // The masked load does not read past the end of the string.
+      _mm256_store_si256(
+          reinterpret_cast<__m256i*>(rows + i * kRowBytes),
+          _mm256_maskz_loadu_epi8(_bzhi_u32(~0u, length),
+                                  block_strings[i].data()));
+      lengths[i] = length;
+    }
+    const int num_groups = (block_size + kLanes - 1) / kLanes;
+    for (int i = block_size; i < num_groups * kLanes; ++i) lengths[i] = 0;
+
+    uint64* block_fingerprints = fingerprints + block_start;
+    for (int group = 0; group < num_groups; ++group) {
+      const int num_lanes = std::min(kLanes, block_size - group * kLanes);
+      const __m512i result =
+          FingerprintRows(rows + group * kLanes * kRowBytes,
+                          _mm512_load_si512(lengths + group * kLanes));
+      _mm512_mask_storeu_epi64(block_fingerprints + group * kLanes,
+                               (1u << num_lanes) - 1, result);
+    }
+    if (has_long_strings) {
+      for (int i = 0; i < block_size; ++i) {
+        if (block_strings[i].size() > kMaxSimdLength) {
+          block_fingerprints[i] = Fingerprint64(block_strings[i]);
+        }
+      }
+    }
+  }
+}
+
+#endif  // TENSORFLOW_USE_BATCH_FINGERPRINT_SIMD
+
+}  // namespace
+
+void SetBatchFingerprintSimdEnabled(bool enabled) { g_simd_enabled = enabled; }
+
+void BatchFingerprint64(const tstring* strings, int64_t n,
+                        uint64* fingerprints) {
+#ifdef TENSORFLOW_USE_BATCH_FINGERPRINT_SIMD
+  if (g_simd_enabled && IsSupported()) {
+    BatchFingerprint64Simd(strings, n, fingerprints);
+    return;
+  }
+#endif
+  for (int64_t i = 0; i < n; ++i) {
+    fingerprints[i] = Fingerprint64(strings[i]);
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,39 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
+#define TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
+
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Sets `fingerprints[i]` to Fingerprint64(strings[i]) for i in [0, n).
+//
+// On x86 CPUs with AVX-512 (F, DQ, BW and VL) and BMI2, strings of up to 32
+// bytes are fingerprinted 8 at a time with SIMD instructions, which avoids
+// both the latency of the dependent multiplications and the branches on the
+// length of each string. Longer strings, and all strings on other CPUs, use
+// Fingerprint64(). The results are identical in all cases.
+void BatchFingerprint64(const tstring* strings, int64_t n,
+                        uint64* fingerprints);
+
+// Toggles the SIMD codepath. Enabled by default (true) on supported platforms.
+void SetBatchFingerprintSimdEnabled(bool enabled);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCH_FINGERPRINT_H_
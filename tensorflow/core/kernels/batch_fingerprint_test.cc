@@ -0,0 +1,93 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batch_fingerprint.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class BatchFingerprintTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override { SetBatchFingerprintSimdEnabled(GetParam()); }
+  void TearDown() override { SetBatchFingerprintSimdEnabled(true); }
+};
+
+TEST_P(BatchFingerprintTest, KnownValues) {
+  std::vector<tstring> strings = {"", "a", "Hello"};
+  std::vector<uint64> fingerprints(strings.size());
+  BatchFingerprint64(strings.data(), strings.size(), fingerprints.data());
+  EXPECT_EQ(fingerprints[0], Fingerprint64(""));
+  EXPECT_EQ(fingerprints[1], 12917804110809363939ULL);
+  EXPECT_EQ(fingerprints[2], 15404698994557526151ULL);
+}
+
+TEST_P(BatchFingerprintTest, MatchesFingerprint64) {
+  std::mt19937 rng(42);
+  // Covers every length case of the SIMD codepath, strings that are too long
+  // for it, and batches that are not a multiple of the SIMD width.
+  for (int n : {0, 1, 7, 8, 9, 100, 1000}) {
+    std::vector<tstring> strings(n);
+    for (auto& s : strings) {
+      std::string value(rng() % 65, '\0');
+      for (char& c : value) c = static_cast<char>(rng());
+      s = value;
+    }
+    std::vector<uint64> fingerprints(n);
+    BatchFingerprint64(strings.data(), n, fingerprints.data());
+    for (int i = 0; i < n; ++i) {
+      EXPECT_EQ(fingerprints[i], Fingerprint64(strings[i]))
+          << "length " << strings[i].size();
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Simd, BatchFingerprintTest, ::testing::Bool());
+
+void BM_BatchFingerprint64(::testing::benchmark::State& state) {
+  const int n = state.range(0);
+  const int max_length = state.range(1);
+  const bool simd = state.range(2);
+  std::mt19937 rng(42);
+  std::vector<tstring> strings(n);
+  for (auto& s : strings) {
+    s = std::string(1 + rng() % max_length, 'a' + rng() % 26);
+  }
+  std::vector<uint64> fingerprints(n);
+  SetBatchFingerprintSimdEnabled(simd);
+  for (auto s : state) {
+    BatchFingerprint64(strings.data(), n, fingerprints.data());
+  }
+  SetBatchFingerprintSimdEnabled(true);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+}
+
+BENCHMARK(BM_BatchFingerprint64)
+    ->Args({1 << 14, 12, 0})
+    ->Args({1 << 14, 12, 1})
+    ->Args({1 << 14, 31, 0})
+    ->Args({1 << 14, 31, 1})
+    ->Args({1 << 20, 12, 0})
+    ->Args({1 << 20, 12, 1});
+
+}  // namespace
+}  // namespace tensorflow
@@ -48,6 +48,8 @@ constexpr char kMinInflightBatchesAttr[] = "_min_inflight_batches";
 constexpr char kInitialInflightBatchesAttr[] = "_initial_inflight_batches";
 constexpr char kMaxInflightBatchesAttr[] = "_max_inflight_batches";
 constexpr char kBatchesToAverageOverAttr[] = "_batches_to_average_over";
+constexpr char kBatchLatencyTargetMicrosAttr[] =
+    "_batch_latency_target_micros";
 
 // Default thread count in the per-process batching thread pool.
 constexpr int64_t kBatchThreadPoolSize = 128;
@@ -138,19 +140,31 @@ class BatchResource : public serving::BatchResourceBase {
                        FunctionLibraryRuntime::Handle fhandle,
                        FunctionLibraryRuntime* flib,
                        bool enable_large_batch_splitting,
+                       int64_t batch_latency_target_micros,
                        std::unique_ptr<BatchResource>* resource) {
     BatcherT::Options batcher_options;
     batcher_options.num_batch_threads = num_batch_threads;
     std::shared_ptr<BatcherT> batcher;
     TF_RETURN_IF_ERROR(BatcherT::Create(batcher_options, &batcher));
 
+    // Learns the latency of each padded batch size to decide when to close
+    // batches, if a latency target is set.
+    std::shared_ptr<serving::BatchLatencyModel> latency_model;
+    if (batch_latency_target_micros > 0) {
+      latency_model = std::make_shared<serving::BatchLatencyModel>(
+          allowed_batch_sizes.empty()
+              ? std::vector<int32>({max_execution_batch_size})
+              : allowed_batch_sizes,
+          batch_latency_target_micros);
+    }
+
     resource->reset(new BatchResource(
         fhandle, flib, std::move(batcher),
         GetBatcherQueueOptions(num_batch_threads, max_execution_batch_size,
                                batch_timeout_micros, max_enqueued_batches,
                                allowed_batch_sizes,
-                               enable_large_batch_splitting),
-        allowed_batch_sizes));
+                               enable_large_batch_splitting, latency_model),
+        allowed_batch_sizes, std::move(latency_model)));
     return OkStatus();
   }
 
@@ -180,11 +194,12 @@ class BatchResource : public serving::BatchResourceBase {
   BatchResource(FunctionLibraryRuntime::Handle fhandle,
                 FunctionLibraryRuntime* flib, std::shared_ptr<BatcherT> batcher,
                 const BatcherT::QueueOptions& batcher_queue_options,
-                std::vector<int32> allowed_batch_sizes)
+                std::vector<int32> allowed_batch_sizes,
+                std::shared_ptr<serving::BatchLatencyModel> latency_model)
       : BatchResourceBase(
             /*has_process_batch_function=*/fhandle != kInvalidHandle,
             std::move(batcher), batcher_queue_options,
-            std::move(allowed_batch_sizes)),
+            std::move(allowed_batch_sizes), std::move(latency_model)),
         fhandle_(fhandle),
         flib_(flib) {}
 
@@ -257,6 +272,11 @@ BatchFunctionKernel::BatchFunctionKernel(OpKernelConstruction* c)
     has_attribute_enable_large_batch_splitting_ = false;
   }
 
+  if (c->HasAttr(kBatchLatencyTargetMicrosAttr)) {
+    OP_REQUIRES_OK(c, c->GetAttr(kBatchLatencyTargetMicrosAttr,
+                                 &batch_latency_target_micros_));
+  }
+
   // Helper function `SetAdaptiveBatchSchedulerOptions` calls
   // `OP_REQUIRES_OK`, which exits the current function upon error.
   // So validate status of `op-kernel-construction`.
@@ -342,7 +362,8 @@ void BatchFunctionKernel::ComputeAsync(OpKernelContext* c, DoneCallback done) {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, handle, flib_,
-          enable_large_batch_splitting_, &new_resource));
+          enable_large_batch_splitting_, batch_latency_target_micros_,
+          &new_resource));
       *r = new_resource.release();
       return OkStatus();
     };
@@ -564,7 +585,8 @@ class BatchKernel : public AsyncOpKernel {
       TF_RETURN_IF_ERROR(BatchResource::Create(
           num_batch_threads_, max_batch_size_, batch_timeout_micros_,
           max_enqueued_batches_, allowed_batch_sizes_, kInvalidHandle,
-          /*flib=*/nullptr, false, &new_resource));
+          /*flib=*/nullptr, false, /*batch_latency_target_micros=*/0,
+          &new_resource));
       *r = new_resource.release();
       return OkStatus();
     };
@@ -95,6 +95,11 @@ class BatchFunctionKernel : public AsyncOpKernel {
   bool enable_large_batch_splitting_;
   bool has_attribute_enable_large_batch_splitting_;
   bool enable_adaptive_batch_threads_ = false;
+  // If positive, batches are closed before `batch_timeout_micros_` using a
+  // model of the latency of each allowed batch size, learned online, to
+  // maximize throughput under this latency. Ignored by the adaptive
+  // scheduler.
+  int64_t batch_latency_target_micros_ = 0;
 
   mutex mu_;
 
@@ -30,6 +30,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/platform/byte_order.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
@@ -74,6 +76,14 @@ class ASBSQueue;
 // CPU utilization - If the batch processing is cpu dominated, you can reap
 //   latency gains when underutilized by increasing the processing rate, but
 //   back the rate off when the load increases to avoid overload.
+//
+// Alternatively, if `Options::target_latency_p99_micros` is set, ASBS tunes
+// the in flight batch limit and the maximum batch size together to keep the
+// p99 batch latency below the target while maximizing throughput: once per
+// `slo_adjustment_interval_micros`, it shrinks whichever of the two dominates
+// latency if the target is missed, and grows one of them if there is enough
+// headroom. The state of this controller and its decisions are exported
+// through monitoring, labeled with `Options::thread_pool_name`.
 
 template <typename TaskType>
 class AdaptiveSharedBatchScheduler
@@ -132,6 +142,14 @@ class AdaptiveSharedBatchScheduler
     // full_batch_scheduling_boost_micros==zero) for backward compatibility of
     // API.
     bool fifo_scheduling = false;
+
+    // If positive, in_flight_batches_limit_ and the maximum batch size are
+    // tuned to keep the p99 latency of batches, from their creation to the
+    // end of their processing, below this value. `batches_to_average_over`
+    // is then ignored.
+    int64_t target_latency_p99_micros = 0;
+    // Time between adjustments made to meet target_latency_p99_micros.
+    int64_t slo_adjustment_interval_micros = 1000 * 1000;
   };
 
   // Ownership is shared between the caller of Create() and any queues created
@@ -182,6 +200,12 @@ class AdaptiveSharedBatchScheduler
     return in_flight_batches_limit_;
   }
 
+  // Fraction of QueueOptions::max_batch_size that batches may currently
+  // reach. Always 1 unless Options::target_latency_p99_micros is set.
+  double batch_size_scale() const {
+    return batch_size_scale_.load(std::memory_order_relaxed);
+  }
+
  private:
   // access to AddBatch, MaybeScheduleClosedBatches, RemoveQueue, GetEnv.
   friend class internal::ASBSQueue<TaskType>;
@@ -211,6 +235,11 @@ class AdaptiveSharedBatchScheduler
 
   void MaybeAdjustInflightLimit() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Adjusts in_flight_batches_limit_ and batch_size_scale_ to meet
+  // options_.target_latency_p99_micros, once per adjustment interval.
+  void MaybeAdjustForLatencyTarget(int64_t now_micros)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Notifies scheduler of non-empty batch which is eligible for processing.
   void AddBatch(const internal::ASBSBatch<TaskType>* batch);
 
@@ -281,6 +310,25 @@ class AdaptiveSharedBatchScheduler
   // Current adjustment size (as a fraction of in_flight_batches_limit_).
   double step_size_multiplier_ TF_GUARDED_BY(mu_) = kMaxStepSizeMultiplier;
 
+  // Fields controlling the adjustments made to meet
+  // options_.target_latency_p99_micros.
+  // Latencies of the batches processed since the last adjustment.
+  std::vector<int64_t> slo_batch_latencies_micros_ TF_GUARDED_BY(mu_);
+  // Number of those batches that were full.
+  int64_t slo_num_full_batches_ TF_GUARDED_BY(mu_) = 0;
+  int64_t slo_last_adjustment_micros_ TF_GUARDED_BY(mu_) = 0;
+  // Read by the queues without holding mu_.
+  std::atomic<double> batch_size_scale_{1.0};
+
+  // The p99 latency must be below this fraction of the target to grow.
+  constexpr static double kSloHeadroom = 0.8;
+  // Multiplier applied to in_flight_batches_limit_ or batch_size_scale_ when
+  // the target is missed.
+  constexpr static double kSloDecreaseMultiplier = 0.75;
+  // Additive increase of batch_size_scale_ when there is headroom.
+  constexpr static double kSloBatchSizeScaleStep = 0.125;
+  constexpr static double kMinBatchSizeScale = 1.0 / 64;
+
   TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveSharedBatchScheduler);
 };
 
@@ -322,6 +370,10 @@ class ASBSQueue : public BatchScheduler<TaskType> {
   // Number of size 1 tasks which could currently be scheduled without failing.
   size_t SchedulingCapacityLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Size at which batches are currently closed, at most
+  // options_.max_batch_size.
+  int CurrentMaxBatchSize() const;
+
   // Returns uint64 one greater than was returned by the previous call.
   // Context id is reused after std::numeric_limits<uint64>::max is exhausted.
   static uint64 NewTraceMeContextIdForBatch();
@@ -341,11 +393,13 @@ template <typename TaskType>
 class ASBSBatch : public Batch<TaskType> {
  public:
   ASBSBatch(ASBSQueue<TaskType>* queue, int64_t creation_time_micros,
-            int64_t batch_timeout_micros, uint64 traceme_context_id)
+            int64_t batch_timeout_micros, uint64 traceme_context_id,
+            int max_batch_size = 0)
       : queue_(queue),
         creation_time_micros_(creation_time_micros),
         schedulable_time_micros_(creation_time_micros + batch_timeout_micros),
-        traceme_context_id_(traceme_context_id) {}
+        traceme_context_id_(traceme_context_id),
+        max_batch_size_(max_batch_size) {}
 
   ~ASBSBatch() override {}
 
@@ -357,13 +411,63 @@ class ASBSBatch : public Batch<TaskType> {
 
   uint64 traceme_context_id() const { return traceme_context_id_; }
 
+  // Whether the batch reached the maximum batch size in effect when it was
+  // created.
+  bool is_full() const {
+    return max_batch_size_ > 0 && this->size() >= max_batch_size_;
+  }
+
  private:
   ASBSQueue<TaskType>* queue_;
   const int64_t creation_time_micros_;
   const int64_t schedulable_time_micros_;
   const uint64 traceme_context_id_;
+  const int max_batch_size_;
   TF_DISALLOW_COPY_AND_ASSIGN(ASBSBatch);
 };
+
+inline monitoring::GaugeCell<int64_t>* GetInFlightBatchesLimitGauge(
+    const string& scheduler_name) {
+  static auto* gauge = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/adaptive_scheduler/"
+      "in_flight_batches_limit",
+      "Limit on the number of concurrently processed batches chosen to meet "
+      "the p99 latency target, rounded down.",
+      "scheduler");
+  return gauge->GetCell(scheduler_name);
+}
+
+inline monitoring::GaugeCell<int64_t>* GetMaxBatchSizePercentGauge(
+    const string& scheduler_name) {
+  static auto* gauge = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/adaptive_scheduler/"
+      "max_batch_size_percent",
+      "Percentage of the configured max batch size that batches may reach, "
+      "chosen to meet the p99 latency target.",
+      "scheduler");
+  return gauge->GetCell(scheduler_name);
+}
+
+inline monitoring::GaugeCell<int64_t>* GetObservedP99LatencyGauge(
+    const string& scheduler_name) {
+  static auto* gauge = monitoring::Gauge<int64_t, 1>::New(
+      "/tensorflow/serving/batching/adaptive_scheduler/"
+      "observed_p99_latency_micros",
+      "p99 latency of the batches processed during the last adjustment "
+      "interval, in microseconds.",
+      "scheduler");
+  return gauge->GetCell(scheduler_name);
+}
+
+inline monitoring::CounterCell* GetSloDecisionCounter(
+    const string& scheduler_name, const string& decision) {
+  static auto* counter = monitoring::Counter<2>::New(
+      "/tensorflow/serving/batching/adaptive_scheduler/slo_decisions",
+      "Number of adjustments made to meet the p99 latency target, by "
+      "decision.",
+      "scheduler", "decision");
+  return counter->GetCell(scheduler_name, decision);
+}
 }  // namespace internal
 
 // ---------------- AdaptiveSharedBatchScheduler ----------------
@@ -374,6 +478,18 @@ constexpr double AdaptiveSharedBatchScheduler<TaskType>::kMaxStepSizeMultiplier;
 template <typename TaskType>
 constexpr double AdaptiveSharedBatchScheduler<TaskType>::kMinStepSizeMultiplier;
 
+template <typename TaskType>
+constexpr double AdaptiveSharedBatchScheduler<TaskType>::kSloHeadroom;
+
+template <typename TaskType>
+constexpr double AdaptiveSharedBatchScheduler<TaskType>::kSloDecreaseMultiplier;
+
+template <typename TaskType>
+constexpr double AdaptiveSharedBatchScheduler<TaskType>::kSloBatchSizeScaleStep;
+
+template <typename TaskType>
+constexpr double AdaptiveSharedBatchScheduler<TaskType>::kMinBatchSizeScale;
+
 template <typename TaskType>
 Status AdaptiveSharedBatchScheduler<TaskType>::Create(
     const Options& options,
@@ -417,6 +533,16 @@ Status AdaptiveSharedBatchScheduler<TaskType>::Create(
         "greater than or equal to 1; was ",
         options.batches_to_average_over);
   }
+  if (options.target_latency_p99_micros < 0) {
+    return errors::InvalidArgument(
+        "target_latency_p99_micros can't be negative; was ",
+        options.target_latency_p99_micros);
+  }
+  if (options.slo_adjustment_interval_micros <= 0) {
+    return errors::InvalidArgument(
+        "slo_adjustment_interval_micros must be positive; was ",
+        options.slo_adjustment_interval_micros);
+  }
   scheduler->reset(new AdaptiveSharedBatchScheduler<TaskType>(options));
   return OkStatus();
 }
@@ -437,6 +563,7 @@ AdaptiveSharedBatchScheduler<TaskType>::AdaptiveSharedBatchScheduler(
     owned_batch_thread_pool_ = false;
     batch_thread_pool_ = options.thread_pool;
   }
+  slo_last_adjustment_micros_ = GetEnv()->NowMicros();
 }
 
 template <typename TaskType>
@@ -633,6 +760,7 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
       profiler::ContextType::kAdaptiveSharedBatchScheduler,
       batch->traceme_context_id());
   const int64_t start_time = batch->creation_time_micros();
+  const bool is_full = batch->is_full();
   callback(std::unique_ptr<Batch<TaskType>>(
       const_cast<internal::ASBSBatch<TaskType>*>(batch)));
   int64_t end_time = GetEnv()->NowMicros();
@@ -643,6 +771,13 @@ void AdaptiveSharedBatchScheduler<TaskType>::CallbackWrapper(
     return;
   }
   in_flight_batches_--;
+  if (options_.target_latency_p99_micros > 0) {
+    slo_batch_latencies_micros_.push_back(end_time - start_time);
+    if (is_full) slo_num_full_batches_++;
+    MaybeAdjustForLatencyTarget(end_time);
+    MaybeScheduleNextBatch();
+    return;
+  }
   batch_count_++;
   batch_delay_stats_.batch_latency_sum += end_time - start_time;
 
@@ -694,6 +829,75 @@ void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustInflightLimit() {
   }
 }
 
+template <typename TaskType>
+void AdaptiveSharedBatchScheduler<TaskType>::MaybeAdjustForLatencyTarget(
+    int64_t now_micros) {
+  if (now_micros - slo_last_adjustment_micros_ <
+          options_.slo_adjustment_interval_micros ||
+      slo_batch_latencies_micros_.empty()) {
+    return;
+  }
+  const size_t p99_index = (slo_batch_latencies_micros_.size() - 1) * 99 / 100;
+  std::nth_element(slo_batch_latencies_micros_.begin(),
+                   slo_batch_latencies_micros_.begin() + p99_index,
+                   slo_batch_latencies_micros_.end());
+  const int64_t p99_latency_micros = slo_batch_latencies_micros_[p99_index];
+  // When most batches are full, the batch size rather than the number of
+  // concurrent batches is what limits throughput and drives latency.
+  const bool mostly_full =
+      2 * slo_num_full_batches_ > slo_batch_latencies_micros_.size();
+  const double min_limit =
+      static_cast<double>(options_.min_in_flight_batches_limit);
+  const double max_limit = static_cast<double>(options_.num_batch_threads);
+  double batch_size_scale = batch_size_scale_.load(std::memory_order_relaxed);
+
+  const char* decision = "hold";
+  if (p99_latency_micros > options_.target_latency_p99_micros) {
+    // Missed the target: back off multiplicatively.
+    if ((mostly_full || in_flight_batches_limit_ <= min_limit) &&
+        batch_size_scale > kMinBatchSizeScale) {
+      batch_size_scale =
+          std::max(batch_size_scale * kSloDecreaseMultiplier,
+                   kMinBatchSizeScale);
+      decision = "decrease_batch_size";
+    } else if (in_flight_batches_limit_ > min_limit) {
+      in_flight_batches_limit_ = std::max(
+          in_flight_batches_limit_ * kSloDecreaseMultiplier, min_limit);
+      decision = "decrease_in_flight_batches";
+    }
+  } else if (p99_latency_micros <
+             kSloHeadroom * options_.target_latency_p99_micros) {
+    // Enough headroom: grow additively, preferring larger batches when they
+    // fill up.
+    if (mostly_full && batch_size_scale < 1.0) {
+      batch_size_scale =
+          std::min(batch_size_scale + kSloBatchSizeScaleStep, 1.0);
+      decision = "increase_batch_size";
+    } else if (in_flight_batches_limit_ < max_limit) {
+      in_flight_batches_limit_ =
+          std::min(in_flight_batches_limit_ + 1, max_limit);
+      decision = "increase_in_flight_batches";
+    }
+  }
+  batch_size_scale_.store(batch_size_scale, std::memory_order_relaxed);
+
+  const string& name = options_.thread_pool_name;
+  internal::GetInFlightBatchesLimitGauge(name)->Set(
+      static_cast<int64_t>(in_flight_batches_limit_));
+  internal::GetMaxBatchSizePercentGauge(name)->Set(
+      static_cast<int64_t>(batch_size_scale * 100));
+  internal::GetObservedP99LatencyGauge(name)->Set(p99_latency_micros);
+  internal::GetSloDecisionCounter(name, decision)->IncrementBy(1);
+  VLOG(2) << "Batch p99 latency " << p99_latency_micros << "us (target "
+          << options_.target_latency_p99_micros << "us): " << decision
+          << ", in_flight_batches_limit " << in_flight_batches_limit_
+          << ", batch_size_scale " << batch_size_scale;
+
+  slo_batch_latencies_micros_.clear();
+  slo_num_full_batches_ = 0;
+  slo_last_adjustment_micros_ = now_micros;
+}
+
 // ---------------- ASBSQueue ----------------
 
 namespace internal {
@@ -738,16 +942,24 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
   std::vector<std::unique_ptr<TaskType>> tasks_to_schedule;
   std::vector<ASBSBatch<TaskType>*> new_batches;
   bool closed_batch = false;
+  const int max_batch_size = CurrentMaxBatchSize();
   {
     mutex_lock l(mu_);
     if (size > SchedulingCapacityLocked()) {
       return errors::Unavailable("The batch scheduling queue is full");
     }
 
+    // The maximum batch size may have shrunk since the current batch was
+    // created.
+    if (current_batch_ && current_batch_->size() >= max_batch_size) {
+      current_batch_->Close();
+      closed_batch = true;
+      current_batch_ = nullptr;
+    }
     int remaining_batch_size =
         current_batch_ == nullptr
-            ? options_.max_batch_size
-            : options_.max_batch_size - current_batch_->size();
+            ? max_batch_size
+            : max_batch_size - current_batch_->size();
     if (options_.split_input_task_func == nullptr ||
         size <= remaining_batch_size) {
       // Either we don't allow task splitting or task fits within the current
@@ -758,13 +970,12 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       // Beyond this point Schedule should not fail, as the caller has been
       // promised that all of the split tasks will be scheduled.
       TF_RETURN_IF_ERROR(options_.split_input_task_func(
-          task, remaining_batch_size, options_.max_batch_size,
-          &tasks_to_schedule));
+          task, remaining_batch_size, max_batch_size, &tasks_to_schedule));
     }
     for (auto& task : tasks_to_schedule) {
       // Can't fit within current batch, close it off and try to create another.
       if (current_batch_ &&
-          current_batch_->size() + task->size() > options_.max_batch_size) {
+          current_batch_->size() + task->size() > max_batch_size) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -777,7 +988,8 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
         // are processed in the same batch and should share traceme_context_id.
         current_batch_ = new ASBSBatch<TaskType>(
             this, scheduler_->GetEnv()->NowMicros(),
-            options_.batch_timeout_micros, NewTraceMeContextIdForBatch());
+            options_.batch_timeout_micros, NewTraceMeContextIdForBatch(),
+            max_batch_size);
         new_batches.push_back(current_batch_);
       }
 
@@ -797,8 +1009,7 @@ Status ASBSQueue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
       bool reached_max_tasks =
           (options_.max_tasks_per_batch.has_value() &&
            current_batch_->num_tasks() >= options_.max_tasks_per_batch.value());
-      if (current_batch_->size() == options_.max_batch_size ||
-          reached_max_tasks) {
+      if (current_batch_->size() >= max_batch_size || reached_max_tasks) {
         current_batch_->Close();
         closed_batch = true;
         current_batch_ = nullptr;
@@ -848,6 +1059,13 @@ size_t ASBSQueue<TaskType>::SchedulingCapacityLocked() const {
   return spare_batches * options_.max_batch_size + current_batch_capacity;
 }
 
+template <typename TaskType>
+int ASBSQueue<TaskType>::CurrentMaxBatchSize() const {
+  const double scale = scheduler_->batch_size_scale();
+  if (scale >= 1.0) return options_.max_batch_size;
+  return std::max(static_cast<int>(options_.max_batch_size * scale), 1);
+}
+
 template <typename TaskType>
 // static
 uint64 ASBSQueue<TaskType>::NewTraceMeContextIdForBatch() {
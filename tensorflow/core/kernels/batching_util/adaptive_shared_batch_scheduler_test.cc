@@ -95,6 +95,12 @@ TEST(AdaptiveSharedBatchSchedulerTest, BadOptions) {
   options.min_in_flight_batches_limit = 2;
   options.num_batch_threads = 3;
   EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
+  options = Scheduler::Options();
+  options.target_latency_p99_micros = -1;
+  EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
+  options = Scheduler::Options();
+  options.slo_adjustment_interval_micros = 0;
+  EXPECT_FALSE(Scheduler::Create(options, &scheduler).ok());
 }
 
 TEST(AdaptiveSharedBatchSchedulerTest, InFlightBatchesLimit) {
@@ -199,6 +205,67 @@ TEST(AdaptiveSharedBatchSchedulerTest, InFlightBatchesLimitTuning) {
   stop_teardown.Notify();
 }
 
+TEST(AdaptiveSharedBatchSchedulerTest, LatencyTargetTuning) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+  {
+    AdaptiveSharedBatchScheduler<FakeTask>::Options options;
+    options.env = &env;
+    options.num_batch_threads = 4;
+    options.initial_in_flight_batches_limit = 2;
+    options.target_latency_p99_micros = 100;
+    options.slo_adjustment_interval_micros = 1;
+    std::atomic<int64_t> latency_micros{0};
+    auto queue_callback = [&env,
+                           &latency_micros](std::unique_ptr<Batch<FakeTask>>) {
+      env.AdvanceByMicroseconds(latency_micros);
+    };
+    std::shared_ptr<AdaptiveSharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(
+        AdaptiveSharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    AdaptiveSharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 2;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, queue_callback, &queue));
+
+    // Missing the target with partial batches lowers the in flight limit.
+    latency_micros = 200;
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    while (scheduler->in_flight_batches_limit() == 2) {
+    }
+    EXPECT_EQ(scheduler->in_flight_batches_limit(), 1.5);
+    EXPECT_EQ(scheduler->batch_size_scale(), 1);
+
+    // Headroom raises it again.
+    latency_micros = 10;
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    while (scheduler->in_flight_batches_limit() == 1.5) {
+    }
+    EXPECT_EQ(scheduler->in_flight_batches_limit(), 2.5);
+
+    // Missing the target with full batches lowers the batch size.
+    latency_micros = 200;
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    while (scheduler->batch_size_scale() == 1) {
+    }
+    EXPECT_EQ(scheduler->batch_size_scale(), 0.75);
+    EXPECT_EQ(scheduler->in_flight_batches_limit(), 2.5);
+
+    // Batches are now closed at size 1, so they are full, and headroom raises
+    // the batch size before the in flight limit.
+    latency_micros = 10;
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    while (scheduler->batch_size_scale() == 0.75) {
+    }
+    EXPECT_EQ(scheduler->batch_size_scale(), 0.875);
+    EXPECT_EQ(scheduler->in_flight_batches_limit(), 2.5);
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST(AdaptiveSharedBatchSchedulerTest, FullBatchSchedulingBoostMicros) {
   test_util::FakeClockEnv env(Env::Default());
   Notification start_teardown, stop_teardown;
@@ -0,0 +1,209 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer.h"
+
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A buffer of the pool, returned to it when the last reference goes away.
+class BatchInputBufferPool::PooledTensorBuffer : public TensorBuffer {
+ public:
+  PooledTensorBuffer(core::RefCountPtr<BatchInputBufferPool> pool, void* data)
+      : TensorBuffer(data), pool_(std::move(pool)) {}
+
+  ~PooledTensorBuffer() override { pool_->Release(data()); }
+
+  size_t size() const override { return pool_->buffer_bytes_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name("BatchInputBufferPool");
+  }
+
+ private:
+  const core::RefCountPtr<BatchInputBufferPool> pool_;
+};
+
+/*static*/ Status BatchInputBufferPool::Create(
+    DataType dtype, const TensorShape& row_shape, int64_t max_batch_size,
+    int max_pooled_buffers, core::RefCountPtr<BatchInputBufferPool>* pool) {
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    return errors::InvalidArgument("Batch input buffers do not support ",
+                                   DataTypeString(dtype));
+  }
+  if (max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   max_batch_size);
+  }
+  if (max_pooled_buffers < 0) {
+    return errors::InvalidArgument(
+        "max_pooled_buffers must be non-negative; was ", max_pooled_buffers);
+  }
+  pool->reset(new BatchInputBufferPool(dtype, row_shape, max_batch_size,
+                                       max_pooled_buffers));
+  return OkStatus();
+}
+
+BatchInputBufferPool::BatchInputBufferPool(DataType dtype,
+                                           const TensorShape& row_shape,
+                                           int64_t max_batch_size,
+                                           int max_pooled_buffers)
+    : dtype_(dtype),
+      row_shape_(row_shape),
+      max_batch_size_(max_batch_size),
+      max_pooled_buffers_(max_pooled_buffers),
+      row_bytes_(row_shape.num_elements() * DataTypeSize(dtype)),
+      buffer_bytes_(row_bytes_ * max_batch_size) {}
+
+BatchInputBufferPool::~BatchInputBufferPool() {
+  for (void* data : free_buffers_) {
+    cpu_allocator()->DeallocateRaw(data);
+  }
+}
+
+std::unique_ptr<BatchInputBuffer> BatchInputBufferPool::Acquire() {
+  void* data = nullptr;
+  {
+    mutex_lock l(mu_);
+    if (!free_buffers_.empty()) {
+      data = free_buffers_.back();
+      free_buffers_.pop_back();
+    }
+  }
+  if (data == nullptr) {
+    data = cpu_allocator()->AllocateRaw(Allocator::kAllocatorAlignment,
+                                        buffer_bytes_);
+  }
+  Ref();
+  core::RefCountPtr<TensorBuffer> buffer(
+      new PooledTensorBuffer(core::RefCountPtr<BatchInputBufferPool>(this),
+                             data));
+  return std::unique_ptr<BatchInputBuffer>(
+      new BatchInputBuffer(std::move(buffer), this));
+}
+
+int BatchInputBufferPool::num_pooled_buffers() const {
+  mutex_lock l(mu_);
+  return free_buffers_.size();
+}
+
+void BatchInputBufferPool::Release(void* data) {
+  {
+    mutex_lock l(mu_);
+    if (free_buffers_.size() < max_pooled_buffers_) {
+      free_buffers_.push_back(data);
+      return;
+    }
+  }
+  cpu_allocator()->DeallocateRaw(data);
+}
+
+BatchInputBuffer::BatchInputBuffer(core::RefCountPtr<TensorBuffer> buffer,
+                                   const BatchInputBufferPool* pool)
+    : buffer_(std::move(buffer)), pool_(pool) {}
+
+BatchInputBuffer::~BatchInputBuffer() = default;
+
+Status BatchInputBuffer::Append(const Tensor& input, int64_t* offset) {
+  if (input.dtype() != pool_->dtype() || input.dims() < 1) {
+    return errors::InvalidArgument(
+        "Expected a batch input of type ", DataTypeString(pool_->dtype()),
+        " with at least one dimension; got ", DataTypeString(input.dtype()),
+        " ", input.shape().DebugString());
+  }
+  TensorShape row_shape = input.shape();
+  row_shape.RemoveDim(0);
+  if (row_shape != pool_->row_shape()) {
+    return errors::InvalidArgument("Expected batch input rows of shape ",
+                                   pool_->row_shape().DebugString(), "; got ",
+                                   input.shape().DebugString());
+  }
+  const int64_t rows = input.dim_size(0);
+  {
+    mutex_lock l(mu_);
+    if (num_rows_ + rows > pool_->max_batch_size()) {
+      return errors::ResourceExhausted(
+          "Batch input buffer has room for ",
+          pool_->max_batch_size() - num_rows_, " rows; got ", rows);
+    }
+    *offset = num_rows_;
+    num_rows_ += rows;
+  }
+  StringPiece data = input.tensor_data();
+  std::memcpy(buffer_->base<char>() + *offset * pool_->row_bytes_,
+              data.data(), data.size());
+  return OkStatus();
+}
+
+int64_t BatchInputBuffer::num_rows() const {
+  mutex_lock l(mu_);
+  return num_rows_;
+}
+
+Status BatchInputBuffer::GetBatchedTensor(int64_t padded_size,
+                                          Tensor* output) {
+  const int64_t num_rows = this->num_rows();
+  if (padded_size < num_rows || padded_size > pool_->max_batch_size()) {
+    return errors::InvalidArgument("Cannot pad a batch of ", num_rows,
+                                   " rows to ", padded_size, " rows");
+  }
+  if (num_rows == 0 && padded_size > 0) {
+    return errors::InvalidArgument(
+        "Cannot use an empty batch input buffer as padding");
+  }
+  const int64_t row_bytes = pool_->row_bytes_;
+  char* base = buffer_->base<char>();
+  for (int64_t row = num_rows; row < padded_size; ++row) {
+    std::memcpy(base + row * row_bytes, base, row_bytes);
+  }
+  TensorShape shape = pool_->row_shape();
+  shape.InsertDim(0, padded_size);
+  *output = Tensor(pool_->dtype(), shape, buffer_.get());
+  return OkStatus();
+}
+
+Status SplitIntoViews(const Tensor& input, absl::Span<const int64_t> sizes,
+                      std::vector<Tensor>* outputs) {
+  if (input.dims() < 1) {
+    return errors::InvalidArgument("Cannot split a scalar tensor");
+  }
+  int64_t position = 0;
+  for (const int64_t size : sizes) {
+    if (size < 0 || position + size > input.dim_size(0)) {
+      return errors::InvalidArgument(
+          "Sum of split sizes must not exceed dim0-size of input tensor");
+    }
+    Tensor slice = input.Slice(position, position + size);
+    if (slice.IsAligned()) {
+      outputs->push_back(std::move(slice));
+    } else {
+      outputs->push_back(tensor::DeepCopy(slice));
+    }
+    position += size;
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
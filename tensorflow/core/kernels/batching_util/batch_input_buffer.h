@@ -0,0 +1,132 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+class BatchInputBuffer;
+
+// A pool of preallocated host buffers, each large enough to hold one batched
+// input tensor of up to `max_batch_size` rows of `row_shape`.
+//
+// Instead of concatenating the inputs of the tasks of a batch when the batch
+// is processed, callers can acquire a BatchInputBuffer when a batch is opened,
+// copy the input of each task into its rows as the task is enqueued, and then
+// use the batched tensor in place. The memory returns to the pool once the
+// buffer and all the tensors that refer to it are destroyed.
+//
+// Thread-safe.
+class BatchInputBufferPool : public core::RefCounted {
+ public:
+  // `dtype` must be a type that can be copied with memcpy.
+  static Status Create(DataType dtype, const TensorShape& row_shape,
+                       int64_t max_batch_size, int max_pooled_buffers,
+                       core::RefCountPtr<BatchInputBufferPool>* pool);
+
+  ~BatchInputBufferPool() override;
+
+  // Returns an empty buffer, reusing pooled memory when available.
+  std::unique_ptr<BatchInputBuffer> Acquire();
+
+  DataType dtype() const { return dtype_; }
+  const TensorShape& row_shape() const { return row_shape_; }
+  int64_t max_batch_size() const { return max_batch_size_; }
+
+  // Returns the number of buffers currently held by the pool.
+  int num_pooled_buffers() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  class PooledTensorBuffer;
+
+  BatchInputBufferPool(DataType dtype, const TensorShape& row_shape,
+                       int64_t max_batch_size, int max_pooled_buffers);
+
+  // Returns `data` to the pool, or frees it if the pool is full.
+  void Release(void* data) TF_LOCKS_EXCLUDED(mu_);
+
+  const DataType dtype_;
+  const TensorShape row_shape_;
+  const int64_t max_batch_size_;
+  const int max_pooled_buffers_;
+  // Size in bytes of one row, and of one buffer.
+  const int64_t row_bytes_;
+  const int64_t buffer_bytes_;
+
+  mutable mutex mu_;
+  std::vector<void*> free_buffers_ TF_GUARDED_BY(mu_);
+
+  friend class BatchInputBuffer;
+};
+
+// The rows of one batched input tensor, filled by the tasks of a batch. See
+// BatchInputBufferPool.
+class BatchInputBuffer {
+ public:
+  ~BatchInputBuffer();
+
+  // Reserves the next `input.dim_size(0)` rows and copies `input` into them,
+  // setting `*offset` to the index of the first row. Concurrent calls copy
+  // their inputs in parallel. Returns ResourceExhausted if the rows don't fit.
+  Status Append(const Tensor& input, int64_t* offset) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of rows reserved by Append().
+  int64_t num_rows() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Sets `*output` to a tensor of `padded_size` rows that refers to the
+  // buffer, where the rows past num_rows() are copies of the first row.
+  // Must be called after all calls to Append() returned, and the buffer must
+  // not be appended to afterwards.
+  Status GetBatchedTensor(int64_t padded_size, Tensor* output)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  friend class BatchInputBufferPool;
+
+  explicit BatchInputBuffer(core::RefCountPtr<TensorBuffer> buffer,
+                            const BatchInputBufferPool* pool);
+
+  const core::RefCountPtr<TensorBuffer> buffer_;
+  const BatchInputBufferPool* const pool_;
+
+  mutable mutex mu_;
+  int64_t num_rows_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Splits `input` along the 0th dimension into tensors of `sizes` rows. Unlike
+// `tensor::Split()`, the outputs share the buffer of `input`, and only those
+// that would not be aligned as kernels require are copied. The sum of `sizes`
+// may be less than the 0th dimension of `input`, e.g. to ignore padding.
+Status SplitIntoViews(const Tensor& input, absl::Span<const int64_t> sizes,
+                      std::vector<Tensor>* outputs);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_INPUT_BUFFER_H_
@@ -0,0 +1,152 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+core::RefCountPtr<BatchInputBufferPool> CreatePool(int max_pooled_buffers) {
+  core::RefCountPtr<BatchInputBufferPool> pool;
+  TF_CHECK_OK(BatchInputBufferPool::Create(DT_FLOAT, TensorShape({2}),
+                                           /*max_batch_size=*/4,
+                                           max_pooled_buffers, &pool));
+  return pool;
+}
+
+TEST(BatchInputBufferTest, AppendsRowsInPlace) {
+  core::RefCountPtr<BatchInputBufferPool> pool = CreatePool(1);
+  std::unique_ptr<BatchInputBuffer> buffer = pool->Acquire();
+  int64_t offset;
+  TF_ASSERT_OK(buffer->Append(
+      test::AsTensor<float>({1, 2, 3, 4}, TensorShape({2, 2})), &offset));
+  EXPECT_EQ(offset, 0);
+  TF_ASSERT_OK(
+      buffer->Append(test::AsTensor<float>({5, 6}, TensorShape({1, 2})),
+                     &offset));
+  EXPECT_EQ(offset, 2);
+  EXPECT_EQ(buffer->num_rows(), 3);
+
+  Tensor batched;
+  TF_ASSERT_OK(buffer->GetBatchedTensor(/*padded_size=*/4, &batched));
+  // Padding repeats the first row.
+  test::ExpectTensorEqual<float>(
+      batched,
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 1, 2}, TensorShape({4, 2})));
+
+  EXPECT_TRUE(errors::IsResourceExhausted(
+      buffer->Append(test::AsTensor<float>({7, 8, 9, 10}, TensorShape({2, 2})),
+                     &offset)));
+  EXPECT_TRUE(errors::IsInvalidArgument(buffer->GetBatchedTensor(2, &batched)));
+}
+
+TEST(BatchInputBufferTest, RejectsMismatchedInputs) {
+  core::RefCountPtr<BatchInputBufferPool> pool = CreatePool(1);
+  std::unique_ptr<BatchInputBuffer> buffer = pool->Acquire();
+  int64_t offset;
+  EXPECT_TRUE(errors::IsInvalidArgument(buffer->Append(
+      test::AsTensor<float>({1, 2, 3}, TensorShape({1, 3})), &offset)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      buffer->Append(test::AsTensor<int32>({1, 2}, TensorShape({1, 2})),
+                     &offset)));
+  EXPECT_EQ(buffer->num_rows(), 0);
+
+  core::RefCountPtr<BatchInputBufferPool> string_pool;
+  EXPECT_TRUE(errors::IsInvalidArgument(BatchInputBufferPool::Create(
+      DT_STRING, TensorShape({}), 4, 1, &string_pool)));
+}
+
+TEST(BatchInputBufferTest, ReusesBuffers) {
+  core::RefCountPtr<BatchInputBufferPool> pool = CreatePool(1);
+  const void* data;
+  {
+    std::unique_ptr<BatchInputBuffer> buffer = pool->Acquire();
+    int64_t offset;
+    TF_ASSERT_OK(buffer->Append(
+        test::AsTensor<float>({1, 2}, TensorShape({1, 2})), &offset));
+    Tensor batched;
+    TF_ASSERT_OK(buffer->GetBatchedTensor(1, &batched));
+    data = batched.tensor_data().data();
+    buffer.reset();
+    // The batched tensor keeps the memory alive.
+    EXPECT_EQ(pool->num_pooled_buffers(), 0);
+  }
+  EXPECT_EQ(pool->num_pooled_buffers(), 1);
+
+  std::unique_ptr<BatchInputBuffer> first = pool->Acquire();
+  std::unique_ptr<BatchInputBuffer> second = pool->Acquire();
+  Tensor batched;
+  int64_t offset;
+  TF_ASSERT_OK(first->Append(
+      test::AsTensor<float>({1, 2}, TensorShape({1, 2})), &offset));
+  TF_ASSERT_OK(first->GetBatchedTensor(1, &batched));
+  EXPECT_EQ(batched.tensor_data().data(), data);
+  first.reset();
+  second.reset();
+  batched = Tensor();
+  // Only one buffer is kept.
+  EXPECT_EQ(pool->num_pooled_buffers(), 1);
+}
+
+TEST(BatchInputBufferTest, BufferOutlivesPool) {
+  core::RefCountPtr<BatchInputBufferPool> pool = CreatePool(1);
+  std::unique_ptr<BatchInputBuffer> buffer = pool->Acquire();
+  pool.reset();
+  int64_t offset;
+  TF_ASSERT_OK(buffer->Append(
+      test::AsTensor<float>({1, 2}, TensorShape({1, 2})), &offset));
+  Tensor batched;
+  TF_ASSERT_OK(buffer->GetBatchedTensor(1, &batched));
+  buffer.reset();
+  test::ExpectTensorEqual<float>(
+      batched, test::AsTensor<float>({1, 2}, TensorShape({1, 2})));
+}
+
+TEST(SplitIntoViewsTest, SharesAlignedSlices) {
+  Tensor input(DT_FLOAT, TensorShape({6, 16}));
+  test::FillIota<float>(&input, 0);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(SplitIntoViews(input, {2, 3}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_TRUE(outputs[0].SharesBufferWith(input));
+  EXPECT_TRUE(outputs[1].SharesBufferWith(input));
+  test::ExpectTensorEqual<float>(outputs[1], input.Slice(2, 5));
+}
+
+TEST(SplitIntoViewsTest, CopiesUnalignedSlices) {
+  Tensor input(DT_FLOAT, TensorShape({3, 1}));
+  test::FillIota<float>(&input, 0);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(SplitIntoViews(input, {1, 2}, &outputs));
+  ASSERT_EQ(outputs.size(), 2);
+  EXPECT_TRUE(outputs[0].SharesBufferWith(input));
+  EXPECT_FALSE(outputs[1].SharesBufferWith(input));
+  test::ExpectTensorEqual<float>(
+      outputs[1], test::AsTensor<float>({1, 2}, TensorShape({2, 1})));
+
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(SplitIntoViews(input, {2, 2}, &outputs)));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
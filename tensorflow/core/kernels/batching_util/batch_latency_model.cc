@@ -0,0 +1,144 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Weight of a new measurement in the moving averages.
+constexpr double kSmoothingFactor = 0.1;
+
+void UpdateMovingAverage(double value, double* average) {
+  if (*average < 0) {
+    *average = value;
+  } else {
+    *average += kSmoothingFactor * (value - *average);
+  }
+}
+
+}  // namespace
+
+BatchLatencyModel::BatchLatencyModel(std::vector<int32> allowed_batch_sizes,
+                                     int64_t latency_target_micros)
+    : allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+      latency_target_micros_(latency_target_micros),
+      latency_micros_(allowed_batch_sizes_.size(), -1) {
+  DCHECK(!allowed_batch_sizes_.empty());
+}
+
+int BatchLatencyModel::SizeIndex(int batch_size) const {
+  for (int i = 0; i < allowed_batch_sizes_.size(); ++i) {
+    if (allowed_batch_sizes_[i] >= batch_size) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void BatchLatencyModel::RecordBatchLatency(int padded_batch_size,
+                                           int64_t latency_micros) {
+  const int index = SizeIndex(padded_batch_size);
+  if (index < 0) {
+    return;
+  }
+  mutex_lock l(mu_);
+  UpdateMovingAverage(latency_micros, &latency_micros_[index]);
+}
+
+void BatchLatencyModel::RecordTaskArrival(int task_size, uint64 now_micros) {
+  mutex_lock l(mu_);
+  if (has_arrival_ && now_micros >= last_arrival_micros_) {
+    UpdateMovingAverage(now_micros - last_arrival_micros_,
+                        &interarrival_micros_);
+  }
+  UpdateMovingAverage(task_size, &task_size_);
+  last_arrival_micros_ = now_micros;
+  has_arrival_ = true;
+}
+
+int64_t BatchLatencyModel::LatencyMicros(int padded_batch_size) const {
+  const int index = SizeIndex(padded_batch_size);
+  if (index < 0) {
+    return -1;
+  }
+  mutex_lock l(mu_);
+  return static_cast<int64_t>(latency_micros_[index]);
+}
+
+double BatchLatencyModel::EstimatedLatencyMicros(int index) const {
+  if (latency_micros_[index] >= 0) {
+    return latency_micros_[index];
+  }
+  // Prefer the nearest larger size, whose latency is an upper bound.
+  for (int i = index + 1; i < latency_micros_.size(); ++i) {
+    if (latency_micros_[i] >= 0) {
+      return latency_micros_[i];
+    }
+  }
+  for (int i = index - 1; i >= 0; --i) {
+    if (latency_micros_[i] >= 0) {
+      return latency_micros_[i];
+    }
+  }
+  return -1;
+}
+
+bool BatchLatencyModel::ShouldDispatch(int batch_size,
+                                       int64_t wait_micros) const {
+  const int index = SizeIndex(batch_size);
+  if (index < 0 || batch_size >= allowed_batch_sizes_.back()) {
+    return true;
+  }
+  mutex_lock l(mu_);
+  const double latency_now = EstimatedLatencyMicros(index);
+  if (latency_now < 0) {
+    return false;
+  }
+  if (wait_micros + latency_now >= latency_target_micros_) {
+    return true;
+  }
+  // Without a measured arrival rate the batch can't be expected to grow.
+  if (interarrival_micros_ <= 0 || task_size_ <= 0) {
+    return true;
+  }
+  const double arrival_rate = task_size_ / interarrival_micros_;
+
+  const double throughput_now = batch_size / std::max(latency_now, 1.0);
+  for (int i = index; i < allowed_batch_sizes_.size(); ++i) {
+    const int size = allowed_batch_sizes_[i];
+    if (size <= batch_size) {
+      continue;
+    }
+    const double fill_micros = (size - batch_size) / arrival_rate;
+    const double latency = EstimatedLatencyMicros(i);
+    if (wait_micros + fill_micros + latency > latency_target_micros_) {
+      break;
+    }
+    if (size / std::max(fill_micros + latency, 1.0) > throughput_now) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
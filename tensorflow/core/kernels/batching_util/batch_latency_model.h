@@ -0,0 +1,96 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+#define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
+
+#include <vector>
+
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Learns online the latency of processing a batch padded to each of a set of
+// allowed batch sizes, and the arrival rate of tasks, and uses them to decide
+// whether an open batch should be dispatched now or wait for more tasks.
+//
+// A batch of `batch_size` that has waited `wait_micros` is dispatched now if
+// no allowed size larger than `batch_size` can be reached by waiting, at the
+// current arrival rate, with a higher throughput (batch size over fill time
+// plus latency) than padding the batch to the next allowed size now, without
+// exceeding the latency target. Sizes without measurements are estimated by
+// the nearest measured size, so that waiting for larger batches is explored.
+//
+// Thread-safe.
+class BatchLatencyModel {
+ public:
+  // `allowed_batch_sizes` must be non-empty and increasing.
+  BatchLatencyModel(std::vector<int32> allowed_batch_sizes,
+                    int64_t latency_target_micros);
+
+  // Records that a batch padded to `padded_batch_size` took `latency_micros`
+  // to process.
+  void RecordBatchLatency(int padded_batch_size, int64_t latency_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a task of `task_size` arrived at `now_micros`.
+  void RecordTaskArrival(int task_size, uint64 now_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns true if an open batch of `batch_size`, whose first task was
+  // enqueued `wait_micros` ago, should be dispatched now. Returns false while
+  // the model has no latency measurement yet.
+  bool ShouldDispatch(int batch_size, int64_t wait_micros) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the learned latency of a batch padded to `padded_batch_size`, or
+  // -1 if it was never measured.
+  int64_t LatencyMicros(int padded_batch_size) const TF_LOCKS_EXCLUDED(mu_);
+
+  const std::vector<int32>& allowed_batch_sizes() const {
+    return allowed_batch_sizes_;
+  }
+
+ private:
+  // Returns the index in `allowed_batch_sizes_` of the smallest size that is
+  // greater than or equal to `batch_size`, or -1 if there is none.
+  int SizeIndex(int batch_size) const;
+
+  // Returns the latency of the size at `index`, estimated by the nearest
+  // measured size if it was never measured, or -1 if no size was measured.
+  double EstimatedLatencyMicros(int index) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::vector<int32> allowed_batch_sizes_;
+  const int64_t latency_target_micros_;
+
+  mutable mutex mu_;
+  // Exponential moving average of the latency of each allowed size, or -1.
+  std::vector<double> latency_micros_ TF_GUARDED_BY(mu_);
+  // Exponential moving averages of the time between task arrivals and of the
+  // task sizes, or -1 before the first measurement.
+  double interarrival_micros_ TF_GUARDED_BY(mu_) = -1;
+  double task_size_ TF_GUARDED_BY(mu_) = -1;
+  uint64 last_arrival_micros_ TF_GUARDED_BY(mu_) = 0;
+  bool has_arrival_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_LATENCY_MODEL_H_
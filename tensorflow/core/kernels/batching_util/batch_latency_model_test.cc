@@ -0,0 +1,85 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Records arrivals of tasks of size 1 every `interval_micros`.
+void RecordArrivals(int interval_micros, BatchLatencyModel* model) {
+  for (int i = 0; i < 10; ++i) {
+    model->RecordTaskArrival(1, i * interval_micros);
+  }
+}
+
+TEST(BatchLatencyModelTest, LearnsLatencies) {
+  BatchLatencyModel model({4, 8}, /*latency_target_micros=*/1000);
+  EXPECT_EQ(model.LatencyMicros(3), -1);
+  model.RecordBatchLatency(4, 100);
+  EXPECT_EQ(model.LatencyMicros(3), 100);
+  EXPECT_EQ(model.LatencyMicros(4), 100);
+  EXPECT_EQ(model.LatencyMicros(8), -1);
+  EXPECT_EQ(model.LatencyMicros(9), -1);
+  // Later measurements are averaged in.
+  model.RecordBatchLatency(4, 200);
+  EXPECT_EQ(model.LatencyMicros(4), 110);
+}
+
+TEST(BatchLatencyModelTest, WaitsUntilLatencyIsMeasured) {
+  BatchLatencyModel model({4, 8}, /*latency_target_micros=*/1000);
+  RecordArrivals(10, &model);
+  EXPECT_FALSE(model.ShouldDispatch(2, 0));
+  // Full batches are always dispatched.
+  EXPECT_TRUE(model.ShouldDispatch(8, 0));
+}
+
+TEST(BatchLatencyModelTest, WaitsForLargerBatchesUnderLoad) {
+  BatchLatencyModel model({4, 8}, /*latency_target_micros=*/1000);
+  model.RecordBatchLatency(4, 100);
+  model.RecordBatchLatency(8, 120);
+  // A task arrives every 10us, so a batch of 8 is 60us away from a batch of 2,
+  // and has a much higher throughput.
+  RecordArrivals(10, &model);
+  EXPECT_FALSE(model.ShouldDispatch(2, 0));
+  // Waiting any longer would miss the latency target.
+  EXPECT_TRUE(model.ShouldDispatch(2, 900));
+}
+
+TEST(BatchLatencyModelTest, DispatchesSmallBatchesUnderLowLoad) {
+  BatchLatencyModel model({4, 8}, /*latency_target_micros=*/1000);
+  model.RecordBatchLatency(4, 100);
+  model.RecordBatchLatency(8, 120);
+  // A task arrives every 500us, so larger batches can't be formed in time.
+  RecordArrivals(500, &model);
+  EXPECT_TRUE(model.ShouldDispatch(2, 0));
+}
+
+TEST(BatchLatencyModelTest, ExploresUnmeasuredSizes) {
+  BatchLatencyModel model({4, 8}, /*latency_target_micros=*/1000);
+  model.RecordBatchLatency(4, 100);
+  RecordArrivals(10, &model);
+  // The latency of a batch of 8 is assumed to be the same as that of 4.
+  EXPECT_FALSE(model.ShouldDispatch(4, 0));
+  model.RecordBatchLatency(8, 400);
+  EXPECT_TRUE(model.ShouldDispatch(4, 0));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
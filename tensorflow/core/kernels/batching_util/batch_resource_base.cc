@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/common_runtime/cost_constants.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
@@ -29,12 +32,14 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/request_cost_accessor_registry.h"
 #include "tensorflow/core/framework/ops_util.h"
 #include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/kernels/batching_util/batch_input_buffer.h"
 #include "tensorflow/core/kernels/batching_util/concat_split_util.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/percentile_sampler.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/util/incremental_barrier.h"
@@ -200,6 +205,78 @@ void RecordBatchParamAllowedBatchSizes(const string& allowed_batch_sizes,
   cell->GetCell(model_name, op_name)->Set(allowed_batch_sizes);
 }
 
+void RecordLearnedBatchLatency(int64_t latency_micros,
+                               const string& model_name,
+                               const string& op_name, int32_t batch_size) {
+  static auto* cell = monitoring::Gauge<int64_t, 3>::New(
+      "/tensorflow/serving/batching/learned_batch_latency_micros",
+      "Tracks the latency of processing a batch of each allowed size, as "
+      "learned by the batch latency model.",
+      "model_name", "op_name", "batch_size");
+  cell->GetCell(model_name, op_name, std::to_string(batch_size))
+      ->Set(latency_micros);
+}
+
+void RecordBatchFormationTimeUs(int64_t formation_time_us,
+                                const string& model_name,
+                                const string& op_name) {
+  static auto* cell = tensorflow::monitoring::Sampler<2>::New(
+      {"/tensorflow/serving/batching/batch_formation_time_us",
+       "Tracks the time (in microseconds) from the arrival of the first input "
+       "of a batch until the batch is closed, by model_name (if available).",
+       "model_name", "op_name"},
+      // It's 27 buckets with the last bucket being 2^26 to DBL_MAX;
+      // so the limits are [1, 2, 4, 8, ..., 64 * 1024 * 1024, DBL_MAX].
+      monitoring::Buckets::Exponential(1, 2, 27));
+  cell->GetCell(model_name, op_name)
+      ->Add(static_cast<double>(formation_time_us));
+}
+
+void RecordBatchQueueDelayUs(int64_t queue_delay_us, const string& model_name,
+                             const string& op_name) {
+  static auto* cell = tensorflow::monitoring::Sampler<2>::New(
+      {"/tensorflow/serving/batching/batch_queue_delay_us",
+       "Tracks the time (in microseconds) closed batches wait before being "
+       "processed, by model_name (if available).",
+       "model_name", "op_name"},
+      // It's 27 buckets with the last bucket being 2^26 to DBL_MAX;
+      // so the limits are [1, 2, 4, 8, ..., 64 * 1024 * 1024, DBL_MAX].
+      monitoring::Buckets::Exponential(1, 2, 27));
+  cell->GetCell(model_name, op_name)->Add(static_cast<double>(queue_delay_us));
+}
+
+void RecordPaddingFraction(int32_t padding_size, int32_t execution_batch_size,
+                           const string& model_name, const string& op_name) {
+  static auto* cell = tensorflow::monitoring::Sampler<2>::New(
+      {"/tensorflow/serving/batching/padding_fraction",
+       "Tracks the fraction of each processed batch that is padding, by "
+       "model_name (if available).",
+       "model_name", "op_name"},
+      monitoring::Buckets::Explicit(
+          {0.0, 0.05, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9}));
+  cell->GetCell(model_name, op_name)
+      ->Add(execution_batch_size > 0
+                ? static_cast<double>(padding_size) / execution_batch_size
+                : 0.0);
+}
+
+// `stage` is one of "concat_inputs" and "split_outputs" for the tensors of a
+// batch, and "split_input_task" and "concat_split_task_outputs" for the
+// tensors of a task that is split across batches.
+void RecordSplitConcatTimeUs(int64_t time_us, const string& model_name,
+                             const string& op_name, const string& stage) {
+  static auto* cell = tensorflow::monitoring::Sampler<3>::New(
+      {"/tensorflow/serving/batching/split_concat_time_us",
+       "Tracks the time (in microseconds) spent concatenating and splitting "
+       "tensors, by model_name (if available) and stage.",
+       "model_name", "op_name", "stage"},
+      // It's 24 buckets with the last bucket being 2^23 to DBL_MAX;
+      // so the limits are [1, 2, 4, 8, ..., 8 * 1024 * 1024, DBL_MAX].
+      monitoring::Buckets::Exponential(1, 2, 24));
+  cell->GetCell(model_name, op_name, stage)
+      ->Add(static_cast<double>(time_us));
+}
+
 const string& GetModelName(OpKernelContext* ctx) {
   static string* kModelNameUnset = new string("model_name_unset");
   if (!ctx->session_metadata()) return *kModelNameUnset;
@@ -207,6 +284,42 @@ const string& GetModelName(OpKernelContext* ctx) {
   return ctx->session_metadata()->name();
 }
 
+// How long the tasks of a batch waited before it was processed.
+struct BatchDelays {
+  // From the arrival of the first task until the batch was closed.
+  int64_t formation_time_us = 0;
+  // From the closing of the batch until now.
+  int64_t queue_delay_us = 0;
+};
+
+template <typename BatchType>
+BatchDelays GetBatchDelays(const BatchType& batch) {
+  BatchDelays delays;
+  const uint64 close_time_us = batch.close_time_micros();
+  if (close_time_us == 0) return delays;
+  uint64 first_start_time_ns = kuint64max;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    first_start_time_ns =
+        std::min(first_start_time_ns, batch.task(i).start_time);
+  }
+  const uint64 first_start_time_us = first_start_time_ns / 1000;
+  if (first_start_time_us < close_time_us) {
+    delays.formation_time_us = close_time_us - first_start_time_us;
+  }
+  const uint64 now_us = EnvTime::NowMicros();
+  if (close_time_us < now_us) {
+    delays.queue_delay_us = now_us - close_time_us;
+  }
+  return delays;
+}
+
+void RecordBatchDelays(const BatchDelays& delays, OpKernelContext* context) {
+  const string& model_name = GetModelName(context);
+  const string& op_name = context->op_kernel().name();
+  RecordBatchFormationTimeUs(delays.formation_time_us, model_name, op_name);
+  RecordBatchQueueDelayUs(delays.queue_delay_us, model_name, op_name);
+}
+
 }  // namespace
 
 std::unique_ptr<BatchResourceBase::BatchTask>
@@ -226,6 +339,7 @@ BatchResourceBase::BatchTask::CreateSplitTask(
   task->is_partial = true;
   task->start_time = this->start_time;
   task->request_cost = this->request_cost;
+  task->cpu_time_accumulator = this->cpu_time_accumulator;
 
   return task;
 }
@@ -253,6 +367,8 @@ Status BatchResourceBase::RegisterInput(
   batch_components->start_time = EnvTime::NowNanos();
   batch_components->guid = guid;
   batch_components->propagated_context = Context(ContextKind::kThread);
+  batch_components->cpu_time_accumulator =
+      thread::CpuTimeAccumulator::Current();
   OpInputList tensors;
   TF_RETURN_IF_ERROR(context->input_list("in_tensors", &tensors));
   batch_components->inputs.reserve(tensors.size());
@@ -339,6 +455,10 @@ Status BatchResourceBase::RegisterInput(
   BatcherQueueT* batcher_queue;
   TF_RETURN_IF_ERROR(
       LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+  if (latency_model_) {
+    latency_model_->RecordTaskArrival(batch_components->size(),
+                                      EnvTime::NowMicros());
+  }
   return batcher_queue->Schedule(&batch_components);
 }
 
@@ -347,7 +467,8 @@ BatchResourceBase::GetBatcherQueueOptions(
     int32_t num_batch_threads, int32_t max_batch_size,
     int32_t batch_timeout_micros, int32_t max_enqueued_batches,
     const std::vector<int32>& allowed_batch_sizes,
-    bool enable_large_batch_splitting) {
+    bool enable_large_batch_splitting,
+    std::shared_ptr<BatchLatencyModel> latency_model) {
   BatcherT::QueueOptions batcher_queue_options;
   batcher_queue_options.input_batch_size_limit = max_batch_size;
   batcher_queue_options.max_enqueued_batches = max_enqueued_batches;
@@ -370,6 +491,12 @@ BatchResourceBase::GetBatcherQueueOptions(
           *allowed_batch_sizes.rbegin();
     }
   }
+  if (latency_model) {
+    batcher_queue_options.close_open_batch_func =
+        [latency_model](size_t batch_size, int64_t wait_micros) {
+          return latency_model->ShouldDispatch(batch_size, wait_micros);
+        };
+  }
 
   return batcher_queue_options;
 }
@@ -448,6 +575,14 @@ Status BatchResourceBase::ConcatInputTensors(
         "ConcatInputTensors", {{"batch_size_after_padding", padded_batch_size},
                                {"padding_amount", padding_amount}});
   });
+  const uint64 concat_start_micros = EnvTime::NowMicros();
+  auto record_concat_time = gtl::MakeCleanup([&] {
+    RecordSplitConcatTimeUs(EnvTime::NowMicros() - concat_start_micros,
+                            GetModelName(context), context->op_kernel().name(),
+                            "concat_inputs");
+  });
+  RecordPaddingFraction(padding_amount, padded_batch_size,
+                        GetModelName(context), context->op_kernel().name());
   RecordPaddingSize(padding_amount, GetModelName(context), padded_batch_size,
                     context->op_kernel().name());
   RecordPaddingSizeV2(padding_amount, GetModelName(context), padded_batch_size,
@@ -517,6 +652,7 @@ Status BatchResourceBase::ConcatInputTensors(
   std::function<void()> split_task_done_callback =
       [done_callback = input_task.done_callback, output = input_task.output,
        op_kernel_context = input_task.context, status = shared_status]() {
+        const uint64 concat_start_micros = EnvTime::NowMicros();
         const int num_output = op_kernel_context->num_outputs();
         for (int i = 0; i < num_output; ++i) {
           Tensor output_tensor;
@@ -538,6 +674,10 @@ Status BatchResourceBase::ConcatInputTensors(
 
           op_kernel_context->set_output(i, std::move(output_tensor));
         }
+        RecordSplitConcatTimeUs(EnvTime::NowMicros() - concat_start_micros,
+                                GetModelName(op_kernel_context),
+                                op_kernel_context->op_kernel().name(),
+                                "concat_split_task_outputs");
         op_kernel_context->SetStatus(status->status());
         done_callback();
       };
@@ -565,6 +705,13 @@ Status BatchResourceBase::ConcatInputTensors(
   }
 
   const int num_input_tensors = input_task.inputs.size();
+  const uint64 split_start_micros = EnvTime::NowMicros();
+  auto record_split_time = gtl::MakeCleanup([&] {
+    RecordSplitConcatTimeUs(EnvTime::NowMicros() - split_start_micros,
+                            GetModelName(input_task.context),
+                            input_task.context->op_kernel().name(),
+                            "split_input_task");
+  });
 
   // Splits each input tensor according to `output_task_sizes`, and
   // initializes input of `output_tasks` with split results.
@@ -619,6 +766,14 @@ Status BatchResourceBase::SplitOutputTensors(
   // For each output tensor name, a divided-up tensor with one entry per task.
   std::map<string, std::vector<Tensor>> split_tensors;
 
+  OpKernelContext* context = batch->task(0).context;
+  const uint64 split_start_micros = EnvTime::NowMicros();
+  auto record_split_time = gtl::MakeCleanup([&] {
+    RecordSplitConcatTimeUs(EnvTime::NowMicros() - split_start_micros,
+                            GetModelName(context), context->op_kernel().name(),
+                            "split_outputs");
+  });
+
   DCHECK_EQ(batch->task(0).context->num_outputs(), combined_outputs.size());
   int combined_outputs_size = combined_outputs.size();
   if (combined_outputs_size != batch->task(0).context->num_outputs()) {
@@ -639,23 +794,27 @@ Status BatchResourceBase::SplitOutputTensors(
           "the 0th dimension sizes of the input tensors");
     }
 
+    // The splits are views of the batched output where alignment permits, so
+    // the outputs of the tasks share its buffer instead of being copied. The
+    // padding rows are not split off.
     std::vector<Tensor> split_tensor;
-    const Status split_status = tensor::Split(
-        output_tensor, task_sizes_plus_optional_padding, &split_tensor);
+    const Status split_status = SplitIntoViews(
+        output_tensor,
+        absl::MakeConstSpan(task_sizes_plus_optional_padding)
+            .first(batch->num_tasks()),
+        &split_tensor);
     DCHECK(split_status.ok()) << split_status.ToString();
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
                               split_status.error_message());
     }
-    DCHECK_EQ(split_tensor.size(), task_sizes_plus_optional_padding.size());
-    if (split_tensor.size() != task_sizes_plus_optional_padding.size()) {
+    DCHECK_EQ(split_tensor.size(), batch->num_tasks());
+    if (split_tensor.size() != batch->num_tasks()) {
       return errors::Internal(
           "Tensor split operation did not work as expected; got ",
-          split_tensor.size(), " splits; expected ",
-          task_sizes_plus_optional_padding.size());
+          split_tensor.size(), " splits; expected ", batch->num_tasks());
     }
 
-    // Ignore a possible final split_tensors entry containing the padding.
     for (int j = 0; j < batch->num_tasks(); ++j) {
       BatchTask& task = *(batch->mutable_task(j));
       if (task.is_partial) {
@@ -680,6 +839,14 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   // which are running this Session, of which this BatchOp is a part.
   WithContext wc(batch->task(batch->num_tasks() - 1).propagated_context);
 
+  // Attributes the CPU time of processing the batch, on this thread and on the
+  // threads that run the batch function, to the batch rather than to the task
+  // whose context is used above. SplitBatchCosts() shares it among the tasks.
+  const auto cpu_time_accumulator =
+      std::make_shared<thread::CpuTimeAccumulator>();
+  absl::optional<thread::ScopedCpuTimeAccumulator> cpu_time_scope;
+  cpu_time_scope.emplace(cpu_time_accumulator);
+
   // TODO(b/185852990): Add a unit test to check the context is correctly set.
   // Creates the CostMeasurements within the same context that runs the Session.
   const CostMeasurement::Context batching_context{/*is_per_query=*/false};
@@ -706,6 +873,8 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
     batch_cost_measurements.clear();
     for (int i = 0; i < batch->num_tasks(); ++i) {
       WithContext wc(batch->task(i).propagated_context);
+      thread::ScopedCpuTimeAccumulator cpu_time(
+          batch->task(i).cpu_time_accumulator);
       if (batch->task(i).is_partial) {
         batch->mutable_task(i)->status->Update(status);
       } else {
@@ -716,14 +885,27 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
     cleanup_done = true;
   };
 
-  auto finally =
-      gtl::MakeCleanup([&cleanup_fn, &status] { cleanup_fn(status); });
+  auto finally = gtl::MakeCleanup([&cleanup_fn, &status, &cpu_time_scope] {
+    // Adds the CPU time of this thread to the batch before it is split.
+    cpu_time_scope.reset();
+    cleanup_fn(status);
+  });
 
   status = ValidateBatch(*batch);
   if (!status.ok()) {
     return;
   }
 
+  const BatchDelays delays = GetBatchDelays(*batch);
+  RecordBatchDelays(delays, last_task_context);
+  profiler::TraceMe trace_me([&delays, &batch]() {
+    return profiler::TraceMeEncode(
+        "ProcessFuncBatch",
+        {{"batch_size_before_padding", batch->size()},
+         {"batch_formation_time_us", delays.formation_time_us},
+         {"queue_delay_us", delays.queue_delay_us}});
+  });
+
   std::vector<Tensor> concatenated_tensors;
   status = ConcatInputTensors(*batch, last_task_context, &concatenated_tensors);
   processed_size = RoundToLowestAllowedBatchSize(batch->size());
@@ -751,6 +933,10 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
   // Releases the cleanup method here, because the callback of the function
   // library runtime will handle it now.
   finally.release();
+  // The callback may split the batch costs on another thread before this call
+  // returns, so the CPU time of this thread so far is added to the batch now.
+  cpu_time_scope.emplace(cpu_time_accumulator);
+  const uint64 run_start_micros = EnvTime::NowMicros();
   ProcessFuncBatchImpl(
       last_task, args, &combined_outputs, [&](const Status& run_status) {
         Status final_status;
@@ -767,6 +953,13 @@ void BatchResourceBase::ProcessFuncBatch(std::unique_ptr<BatchT> batch) const {
         if (!final_status.ok()) {
           return;
         }
+        if (latency_model_) {
+          latency_model_->RecordBatchLatency(
+              processed_size, EnvTime::NowMicros() - run_start_micros);
+          RecordLearnedBatchLatency(
+              latency_model_->LatencyMicros(processed_size), model_name,
+              last_task_context->op_kernel().name(), processed_size);
+        }
         final_status = SplitOutputTensors(combined_outputs, batch.get());
       });
 }
@@ -782,6 +975,11 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   // which are running this Session, of which this BatchOp is a part.
   WithContext wc(batch->task(batch->num_tasks() - 1).propagated_context);
 
+  // Attributes the CPU time of processing the batch to the batch rather than
+  // to the task whose context is used above.
+  absl::optional<thread::ScopedCpuTimeAccumulator> cpu_time_scope;
+  cpu_time_scope.emplace(std::make_shared<thread::CpuTimeAccumulator>());
+
   // TODO(b/185852990): Add a unit test to check the context is correctly set.
   // Creates the CostMeasurement within the same context that runs the Session.
   const CostMeasurement::Context batching_context{/*is_per_query=*/false};
@@ -790,6 +988,7 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
 
   int64_t processed_size = batch->size();
   auto batch_cost_split_cleanup = gtl::MakeCleanup([&] {
+    cpu_time_scope.reset();
     SplitBatchCosts(batch_cost_measurements, processed_size, *batch);
   });
 
@@ -801,6 +1000,15 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   OP_REQUIRES_OK_ASYNC(last_task_context, ValidateBatch(*batch),
                        last_task_callback);
 
+  const BatchDelays delays = GetBatchDelays(*batch);
+  RecordBatchDelays(delays, last_task_context);
+  profiler::TraceMe trace_me([&delays, &batch]() {
+    return profiler::TraceMeEncode(
+        "ProcessBatch", {{"batch_size_before_padding", batch->size()},
+                         {"batch_formation_time_us", delays.formation_time_us},
+                         {"queue_delay_us", delays.queue_delay_us}});
+  });
+
   // All tasks should have the same number of input edges.
   const int num_input_edges = batch->task(0).inputs.size();
   std::vector<Tensor> concatenated_tensors;
@@ -852,6 +1060,8 @@ void BatchResourceBase::ProcessBatch(std::unique_ptr<BatchT> batch) const {
   // Signal done for each element of the batch. (At this point, the contexts
   // are no longer guaranteed to remain live.)
   for (int task_idx = 0; task_idx < batch->num_tasks(); ++task_idx) {
+    thread::ScopedCpuTimeAccumulator cpu_time(
+        batch->task(task_idx).cpu_time_accumulator);
     batch->mutable_task(task_idx)->done_callback();
   }
 }
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_BATCHING_UTIL_BATCH_RESOURCE_BASE_H_
 
 #include <map>
+#include <memory>
 
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
@@ -26,12 +27,14 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/kernels/batching_util/adaptive_shared_batch_scheduler.h"
+#include "tensorflow/core/kernels/batching_util/batch_latency_model.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/kernels/batching_util/threadsafe_status.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace serving {
@@ -68,6 +71,10 @@ class BatchResourceBase : public ResourceBase {
 
     Context propagated_context;
 
+    // The CPU time accumulator of the thread that registered the task, under
+    // which the task's done callback is run.
+    std::shared_ptr<thread::CpuTimeAccumulator> cpu_time_accumulator;
+
     std::vector<Tensor> inputs;
     std::vector<Tensor> captured_inputs;
     OpKernelContext* context;
@@ -126,14 +133,19 @@ class BatchResourceBase : public ResourceBase {
   using BatcherQueueT = BatchScheduler<BatchResourceBase::BatchTask>;
   using BatchT = Batch<BatchResourceBase::BatchTask>;
 
+  // If `latency_model` is set, it is trained with the latency of each batch
+  // processed by the batch function, and with the arrival of tasks. It should
+  // be the model passed to GetBatcherQueueOptions().
   BatchResourceBase(bool has_process_batch_function,
                     std::shared_ptr<BatcherT> batcher,
                     const BatcherT::QueueOptions& batcher_queue_options,
-                    std::vector<int32> allowed_batch_sizes)
+                    std::vector<int32> allowed_batch_sizes,
+                    std::shared_ptr<BatchLatencyModel> latency_model = nullptr)
       : has_process_batch_function_(has_process_batch_function),
         batcher_(std::move(batcher)),
         batcher_queue_options_(batcher_queue_options),
-        allowed_batch_sizes_(std::move(allowed_batch_sizes)) {
+        allowed_batch_sizes_(std::move(allowed_batch_sizes)),
+        latency_model_(std::move(latency_model)) {
     allowed_batch_sizes_str_ = absl::StrJoin(allowed_batch_sizes_, ",");
   }
 
@@ -146,11 +158,15 @@ class BatchResourceBase : public ResourceBase {
         adaptive_batcher_queue_options_(batcher_queue_options),
         allowed_batch_sizes_(std::move(allowed_batch_sizes)) {}
 
+  // If `latency_model` is set, open batches are closed before
+  // `batch_timeout_micros` when the model predicts that dispatching them is
+  // better than waiting for more tasks (see BatchLatencyModel).
   static BatcherT::QueueOptions GetBatcherQueueOptions(
       int32_t num_batch_threads, int32_t max_batch_size,
       int32_t batch_timeout_micros, int32_t max_enqueued_batches,
       const std::vector<int32>& allowed_batch_sizes,
-      bool enable_large_batch_splitting);
+      bool enable_large_batch_splitting,
+      std::shared_ptr<BatchLatencyModel> latency_model = nullptr);
 
   static AdaptiveBatcherT::QueueOptions GetAdaptiveBatcherQueueOptions(
       int32_t max_batch_size, int32_t batch_timeout_micros,
@@ -264,6 +280,10 @@ class BatchResourceBase : public ResourceBase {
   // A concatenated string of <allowed_batch_sizes_>, separated by ",". This is
   // used to record batching parameter.
   string allowed_batch_sizes_str_;
+
+  // The model deciding when the batcher queues close their open batch, or
+  // nullptr.
+  std::shared_ptr<BatchLatencyModel> latency_model_;
 };
 
 }  // namespace serving
@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/batching_util/batch_resource_base.h"
 
+#include <memory>
+
 #include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/cost_measurement.h"
 #include "tensorflow/core/common_runtime/cost_measurement_registry.h"
 #include "tensorflow/core/common_runtime/no_op_cost_measurement.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace serving {
@@ -164,6 +167,36 @@ TEST(SplitBatchCostTest, SplitMultiCostTypes) {
                            Pair("test_gcu_no_smear", absl::Milliseconds(90))));
 }
 
+TEST(SplitBatchCostTest, SplitCpuCost) {
+  BatchResourceBase::BatchT batch;
+  RequestCost cost1, cost2;
+  batch.AddTask(MakeBatchTask(/*task_size=*/1, &cost1));
+  batch.AddTask(MakeBatchTask(/*task_size=*/9, &cost2));
+  batch.Close();
+
+  // The CPU cost is the time added to the accumulator of the batch after the
+  // measurement is created.
+  auto accumulator = std::make_shared<thread::CpuTimeAccumulator>();
+  accumulator->Add(absl::ToInt64Nanoseconds(absl::Milliseconds(50)));
+  thread::ScopedCpuTimeAccumulator scope(accumulator);
+  CostMeasurement::Context context{/*is_per_query=*/false};
+  std::vector<std::unique_ptr<CostMeasurement>> batch_cost_measurements;
+  batch_cost_measurements.push_back(
+      CostMeasurementRegistry::CreateByNameOrNull("cpu", context));
+  accumulator->Add(absl::ToInt64Nanoseconds(absl::Milliseconds(100)));
+  BatchResourceBase::SplitBatchCosts(batch_cost_measurements,
+                                     /*processed_size=*/20, batch);
+
+  EXPECT_THAT(
+      batch.task(0).request_cost->GetCosts(),
+      UnorderedElementsAre(Pair("cpu_with_smear", absl::Milliseconds(10)),
+                           Pair("cpu_no_smear", absl::Milliseconds(5))));
+  EXPECT_THAT(
+      batch.task(1).request_cost->GetCosts(),
+      UnorderedElementsAre(Pair("cpu_with_smear", absl::Milliseconds(90)),
+                           Pair("cpu_no_smear", absl::Milliseconds(45))));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
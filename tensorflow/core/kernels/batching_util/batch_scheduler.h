@@ -29,6 +29,7 @@ limitations under the License.
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <utility>
@@ -36,6 +37,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -64,6 +66,18 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the priority of the task. With
+  // `SharedBatchScheduler::QueueOptions::enable_priority_scheduling`, tasks
+  // with a higher priority are placed in batches ahead of tasks with a lower
+  // one. Other schedulers ignore it.
+  virtual int priority() const { return 0; }
+
+  // Returns the time, in microseconds of the scheduler's `Env::NowMicros()`,
+  // after which the result of the task is no longer useful, or kint64max if
+  // the task has no deadline. See
+  // `SharedBatchScheduler::QueueOptions::expired_task_callback`.
+  virtual int64_t deadline_micros() const { return kint64max; }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -122,6 +136,10 @@ class Batch {
   // Marks the batch as closed. Dies if called more than once.
   void Close();
 
+  // Returns the time at which the batch was closed, per EnvTime::NowMicros(),
+  // or 0 if it is still open.
+  uint64 close_time_micros() const;
+
   // Returns the TraceMe context id of this batch.
   uint64 traceme_context_id() const;
 
@@ -139,6 +157,9 @@ class Batch {
   // Whether the batch has been closed.
   Notification closed_;
 
+  // Set before 'closed_' is notified.
+  std::atomic<uint64> close_time_micros_{0};
+
   // The TracMe context id.
   const uint64 traceme_context_id_;
 
@@ -317,9 +338,15 @@ void Batch<TaskType>::WaitUntilClosed() const {
 
 template <typename TaskType>
 void Batch<TaskType>::Close() {
+  close_time_micros_.store(EnvTime::NowMicros(), std::memory_order_relaxed);
   closed_.Notify();
 }
 
+template <typename TaskType>
+uint64 Batch<TaskType>::close_time_micros() const {
+  return close_time_micros_.load(std::memory_order_relaxed);
+}
+
 template <typename TaskType>
 uint64 Batch<TaskType>::traceme_context_id() const {
   return traceme_context_id_;
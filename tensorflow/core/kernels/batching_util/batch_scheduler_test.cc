@@ -80,6 +80,15 @@ TEST(BatchTest, Basic) {
   EXPECT_TRUE(batch.empty());
 }
 
+TEST(BatchTest, CloseTime) {
+  Batch<FakeTask> batch;
+  EXPECT_EQ(0, batch.close_time_micros());
+  const uint64 before_close_micros = EnvTime::NowMicros();
+  batch.Close();
+  EXPECT_LE(before_close_micros, batch.close_time_micros());
+  EXPECT_GE(EnvTime::NowMicros(), batch.close_time_micros());
+}
+
 TEST(BatchTest, WaitUntilClosed) {
   Batch<FakeTask> batch;
   batch.AddTask(std::unique_ptr<FakeTask>(new FakeTask(3)));
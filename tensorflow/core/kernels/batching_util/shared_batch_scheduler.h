@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -83,6 +84,9 @@ namespace serving {
 // from a queue and then moving to the next queue. Each queue behaves like a
 // BasicBatchScheduler instance, in the sense that it has maximum batch size and
 // timeout parameters, which govern when a batch is eligible to be processed.
+// Alternatively, with `SchedulingPolicy::kEarliestDeadlineFirst` the batch
+// threads take the next batch from the queue holding the task with the
+// earliest deadline (see `BatchTask::deadline_micros()`).
 //
 // Each queue is independently configured with a maximum size (in terms of the
 // maximum number of batches worth of enqueued tasks). For online serving, it is
@@ -116,6 +120,16 @@ class SharedBatchScheduler
   using BatchTaskUniqueptr = std::unique_ptr<Batch<TaskType>>;
   using BatchUniquePtr =
       absl::variant<BatchTaskUniqueptr, BatchTaskHandleUniquePtr>;
+
+  // How batch threads choose the queue to take the next batch from.
+  enum class SchedulingPolicy {
+    // Visit the queues in turn, taking one batch from each.
+    kRoundRobin,
+    // Visit the queues in increasing order of the earliest deadline of their
+    // enqueued tasks, and in turn among queues with the same deadline.
+    kEarliestDeadlineFirst,
+  };
+
   // TODO(b/25089730): Tune defaults based on best practices as they develop.
   struct Options {
     // The name to use for the pool of batch threads.
@@ -125,6 +139,8 @@ class SharedBatchScheduler
     // Must be >= 1, and should be tuned carefully.
     int num_batch_threads = port::MaxParallelism();
 
+    SchedulingPolicy scheduling_policy = SchedulingPolicy::kRoundRobin;
+
     // The environment to use.
     // (Typically only overridden by test code.)
     Env* env = Env::Default();
@@ -218,6 +234,37 @@ class SharedBatchScheduler
     // submit batches whose size is in a small set of allowed sizes, that can be
     // done by adding padding in the process-batch callback.
     size_t max_execution_batch_size = 1000;
+
+    // If true, enqueued tasks are placed in batches by priority instead of in
+    // arrival order. Each batch is formed when it is scheduled, from the tasks
+    // of the highest priority (see `BatchTask::priority()`) in increasing
+    // order of deadline, and its spare slots are filled with tasks of lower
+    // priorities. The open batch is also closed as soon as the earliest
+    // deadline of its tasks is less than `batch_timeout_micros` away.
+    //
+    // Must be false if `enable_large_batch_splitting` is true; elsewise errors
+    // will be returned at queue creation time.
+    bool enable_priority_scheduling = false;
+
+    // If set, tasks whose deadline (see `BatchTask::deadline_micros()`) has
+    // passed are dropped instead of being processed: Schedule() returns a
+    // DEADLINE_EXCEEDED error for them, and those that expire while enqueued
+    // are removed from their batch and handed to this callback, from a batch
+    // thread, before the batch is passed to the process-batch callback.
+    //
+    // Must not be set if `enable_lazy_split` is true.
+    std::function<void(std::unique_ptr<TaskType>)> expired_task_callback;
+
+    // If set, called with the size of the open batch and the time (in
+    // microseconds) since its first task was enqueued, when the open batch is
+    // neither full nor past `batch_timeout_micros`. Returning true closes the
+    // batch early so it can be scheduled; `batch_timeout_micros` remains the
+    // upper bound on how long a batch waits.
+    //
+    // Called with the queue's lock held, possibly every time a batch thread
+    // polls the queue, so it must be cheap.
+    std::function<bool(size_t batch_size, int64_t wait_micros)>
+        close_open_batch_func;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -231,6 +278,12 @@ class SharedBatchScheduler
                               BatchUniquePtr* batch_to_process_out)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // A variant of `GetNextWorkItem_Locked` for
+  // `SchedulingPolicy::kEarliestDeadlineFirst`.
+  void GetNextWorkItemByDeadline_Locked(
+      internal::Queue<TaskType>** queue_for_batch_out,
+      BatchUniquePtr* batch_to_process_out) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // The code executed in 'batch_threads_'. Obtains a batch to process from the
   // queue pointed to by 'next_queue_to_schedule_', and processes it. If that
   // queue declines to provide a batch to process, moves onto the next queue. If
@@ -297,6 +350,10 @@ namespace internal {
 // closed. If the front-most batch is open (i.e. the queue contains only one
 // batch) and has reached the timeout, it is immediately closed and returned;
 // otherwise no batch is returned for the request.
+//
+// With `QueueOptions.enable_priority_scheduling`, submitted tasks are instead
+// kept in an unordered list, and a batch is formed from it on each pull
+// request that finds the list schedulable.
 template <typename TaskType>
 class Queue {
  public:
@@ -328,6 +385,10 @@ class Queue {
   // dequeued (out of mutex-protected area).
   Status ScheduleWithLazySplit(std::unique_ptr<TaskType>* task);
 
+  // Enqueue `task` in `prioritized_tasks_`; used iff
+  // `QueueOptions.enable_priority_scheduling` is true.
+  Status ScheduleWithPriority(std::unique_ptr<TaskType>* task);
+
   // Returns the number of enqueued tasks, with the same semantics as
   // BatchScheduler::NumEnqueuedTasks().
   size_t NumEnqueuedTasks() const;
@@ -354,6 +415,17 @@ class Queue {
   // Batches are guaranteed to form at task enqueue time.
   std::unique_ptr<Batch<TaskType>> ScheduleBatchWithEagerSplit();
 
+  // A variant of `ScheduleBatch`.
+  // Batches are formed from `prioritized_tasks_` at dequeue time. The returned
+  // batch may be empty if all the tasks it would contain have expired.
+  std::unique_ptr<Batch<TaskType>> ScheduleBatchWithPriority();
+
+  // Returns the earliest deadline of the tasks next in line to be scheduled,
+  // i.e. those of the front-most batch, or all the enqueued tasks with
+  // `QueueOptions.enable_priority_scheduling`. Returns kint64max if there is
+  // none.
+  int64_t EarliestDeadlineMicros() const;
+
   // Processes a batch that has been returned earlier by ScheduleBatch().
   void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
 
@@ -405,6 +477,25 @@ class Queue {
   bool IsOpenBatchSchedulableAfterEagerSplit() const
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // A variant of `IsOpenBatchSchedulable`; used when batches are formed from
+  // `prioritized_tasks_`.
+  bool IsPrioritizedBatchSchedulable() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns true if an open batch of `batch_size` whose first task was enqueued
+  // at `start_time_micros` has reached the timeout, or should otherwise be
+  // closed according to `QueueOptions.close_open_batch_func`.
+  bool IsOpenBatchDue(size_t batch_size, uint64 start_time_micros) const;
+
+  // Returns true if `task` has a deadline that has passed and expired tasks
+  // are to be dropped.
+  bool IsExpired(const TaskType& task) const;
+
+  // Removes the expired tasks from `batch`, which must be closed, and
+  // appends them to `expired_tasks`.
+  void RemoveExpiredTasks(
+      std::unique_ptr<Batch<TaskType>>* batch,
+      std::vector<std::unique_ptr<TaskType>>* expired_tasks);
+
   // Same as SchedulingCapacity(), but assumes the caller already holds a
   // lock on 'mu_'.
   size_t SchedulingCapacityInternal() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -462,6 +553,27 @@ class Queue {
   std::deque<std::unique_ptr<Batch<BatchInputTaskHandle<TaskType>>>>
       task_handle_batches_ TF_GUARDED_BY(mu_);
 
+  // A task enqueued with `QueueOptions.enable_priority_scheduling`.
+  struct PrioritizedTask {
+    std::unique_ptr<TaskType> task;
+    uint64 enqueue_time_micros;
+  };
+
+  // The tasks not yet placed in a batch.
+  //
+  // Used iff `QueueOptions.enable_priority_scheduling` is true.
+  std::vector<PrioritizedTask> prioritized_tasks_ TF_GUARDED_BY(mu_);
+
+  // The sum of the sizes, the earliest deadline and the earliest enqueue time
+  // of 'prioritized_tasks_'.
+  size_t prioritized_tasks_size_ TF_GUARDED_BY(mu_) = 0;
+  int64_t prioritized_tasks_deadline_micros_ TF_GUARDED_BY(mu_) = kint64max;
+  uint64 prioritized_tasks_start_time_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  // Expired tasks removed from 'prioritized_tasks_' when forming a batch, to
+  // be handed to `QueueOptions.expired_task_callback` by ProcessBatch().
+  std::vector<std::unique_ptr<TaskType>> expired_tasks_ TF_GUARDED_BY(mu_);
+
   // The counter of the TraceMe context ids.
   uint64 traceme_context_id_counter_ TF_GUARDED_BY(mu_) = 0;
 
@@ -603,6 +715,19 @@ Status SharedBatchScheduler<TaskType>::AddQueueAfterRewritingOptions(
         "enable_large_batch_splitting is enabled.");
   }
 
+  if (options.enable_priority_scheduling &&
+      options.enable_large_batch_splitting) {
+    return errors::InvalidArgument(
+        "enable_priority_scheduling cannot be enabled together with "
+        "enable_large_batch_splitting.");
+  }
+
+  if (options.enable_lazy_split && options.expired_task_callback != nullptr) {
+    return errors::InvalidArgument(
+        "expired_task_callback cannot be set when enable_lazy_split is "
+        "enabled.");
+  }
+
   if (options.enable_large_batch_splitting &&
       (options.input_batch_size_limit < options.max_execution_batch_size)) {
     return errors::InvalidArgument(
@@ -702,6 +827,52 @@ void SharedBatchScheduler<TaskType>::GetNextWorkItem_Locked(
   *batch_to_process_out = std::move(batch_to_process);
 }
 
+template <typename TaskType>
+void SharedBatchScheduler<TaskType>::GetNextWorkItemByDeadline_Locked(
+    internal::Queue<TaskType>** queue_for_batch_out,
+    BatchUniquePtr* batch_to_process_out) {
+  // Order the queues by deadline, starting from 'next_queue_to_schedule_' so
+  // that queues without deadlines are still visited in round-robin order.
+  std::vector<std::pair<int64_t, typename QueueList::iterator>> candidates;
+  candidates.reserve(queues_.size());
+  auto it = next_queue_to_schedule_;
+  for (int i = 0; i < queues_.size(); ++i) {
+    candidates.emplace_back((*it)->EarliestDeadlineMicros(), it);
+    if (++it == queues_.end()) {
+      it = queues_.begin();
+    }
+  }
+  std::stable_sort(
+      candidates.begin(), candidates.end(),
+      [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  BatchUniquePtr batch_to_process;
+  internal::Queue<TaskType>* queue_for_batch = nullptr;
+  for (const auto& candidate : candidates) {
+    const typename QueueList::iterator queue = candidate.second;
+    // See GetNextWorkItem_Locked().
+    const bool queue_closed = (*queue)->closed();
+    batch_to_process = (*queue)->ScheduleBatch();
+    if (!BatchExists(batch_to_process)) {
+      queue_for_batch = queue->get();
+      next_queue_to_schedule_ = std::next(queue);
+      break;
+    }
+    if (queue_closed && (*queue)->IsEmpty()) {
+      // Erasing from a std::list doesn't invalidate the other candidates.
+      if (next_queue_to_schedule_ == queue) {
+        ++next_queue_to_schedule_;
+      }
+      queues_.erase(queue);
+    }
+  }
+  if (next_queue_to_schedule_ == queues_.end()) {
+    next_queue_to_schedule_ = queues_.begin();
+  }
+  *queue_for_batch_out = queue_for_batch;
+  *batch_to_process_out = std::move(batch_to_process);
+}
+
 template <typename TaskType>
 void SharedBatchScheduler<TaskType>::ThreadLogic() {
   // A batch to process next (or nullptr if no work to do).
@@ -711,7 +882,12 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
   {
     mutex_lock l(mu_);
     while (true) {
-      GetNextWorkItem_Locked(&queue_for_batch, &batch_to_process);
+      if (options_.scheduling_policy ==
+          SchedulingPolicy::kEarliestDeadlineFirst) {
+        GetNextWorkItemByDeadline_Locked(&queue_for_batch, &batch_to_process);
+      } else {
+        GetNextWorkItem_Locked(&queue_for_batch, &batch_to_process);
+      }
       if (!BatchExists(batch_to_process)) {
         break;
       }
@@ -797,6 +973,13 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
                                    " is larger than maximum input batch size ",
                                    options_.input_batch_size_limit);
   }
+  if (IsExpired(**task)) {
+    return errors::DeadlineExceeded(
+        "The deadline of the task passed before it was scheduled");
+  }
+  if (options_.enable_priority_scheduling) {
+    return ScheduleWithPriority(task);
+  }
   if (options_.enable_lazy_split) {
     return ScheduleWithLazySplit(std::move(task));
   }
@@ -870,6 +1053,49 @@ Status Queue<TaskType>::ScheduleWithLazySplit(std::unique_ptr<TaskType>* task) {
   return OkStatus();
 }
 
+template <typename TaskType>
+Status Queue<TaskType>::ScheduleWithPriority(std::unique_ptr<TaskType>* task) {
+  profiler::TraceMe trace_me([task] {
+    return profiler::TraceMeEncode(
+        "ScheduleWithPriority",
+        {{"batching_input_task_size", (*task)->size()},
+         {"priority", (*task)->priority()}});
+  });
+
+  bool notify_of_schedulable_batch = false;
+  {
+    mutex_lock l(mu_);
+
+    DCHECK(!closed_);
+
+    if (BatchTaskExceedQueueCapacity((*task).get())) {
+      return errors::Unavailable(
+          "The batch scheduling queue to which this task was submitted is "
+          "full");
+    }
+
+    const uint64 now_micros = env_->NowMicros();
+    if (prioritized_tasks_.empty()) {
+      prioritized_tasks_start_time_micros_ = now_micros;
+    }
+    prioritized_tasks_size_ += (*task)->size();
+    prioritized_tasks_deadline_micros_ = std::min(
+        prioritized_tasks_deadline_micros_, (*task)->deadline_micros());
+    prioritized_tasks_.push_back({std::move(*task), now_micros});
+
+    if (!schedulable_batch_ && IsPrioritizedBatchSchedulable()) {
+      schedulable_batch_ = true;
+      notify_of_schedulable_batch = true;
+    }
+  }
+
+  if (notify_of_schedulable_batch) {
+    schedulable_batch_callback_();
+  }
+
+  return OkStatus();
+}
+
 // TODO(b/194294263):
 // Merge `ScheduleWithoutOrEagerSplit` and `ScheduleWithLazySplit` into
 // `Schedule`.
@@ -961,7 +1187,7 @@ size_t Queue<TaskType>::NumEnqueuedTasks() const {
   for (const auto& batch : batches_) {
     num_enqueued_tasks += batch->num_tasks();
   }
-  return num_enqueued_tasks;
+  return num_enqueued_tasks + prioritized_tasks_.size();
 }
 
 template <typename TaskType>
@@ -972,6 +1198,11 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
 
 template <typename TaskType>
 size_t Queue<TaskType>::SchedulingCapacityInternal() const {
+  if (options_.enable_priority_scheduling) {
+    const size_t capacity =
+        options_.max_enqueued_batches * max_execution_batch_size();
+    return capacity - std::min(capacity, prioritized_tasks_size_);
+  }
   const int64 num_new_batches_schedulable =
       static_cast<int64_t>(options_.max_enqueued_batches) -
       this->num_enqueued_batches();
@@ -989,7 +1220,8 @@ bool Queue<TaskType>::BatchTaskExceedQueueCapacity(TaskType* task) const {
   // Queue creation requires that `enable_large_batch_splitting` is true
   // when `enable_lazy_split` is true, so this covers both eager split and
   // lazy split.
-  if (options_.enable_large_batch_splitting) {
+  if (options_.enable_large_batch_splitting ||
+      options_.enable_priority_scheduling) {
     return task->size() > SchedulingCapacityInternal();
   }
 
@@ -1039,9 +1271,88 @@ Queue<TaskType>::ScheduleBatchWithEagerSplit() {
   return batch_to_schedule;
 }
 
+template <typename TaskType>
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatchWithPriority() {
+  std::unique_ptr<Batch<TaskType>> batch_to_schedule;
+
+  {
+    mutex_lock l(mu_);
+
+    if (!IsPrioritizedBatchSchedulable()) {
+      schedulable_batch_ = false;
+      return batch_to_schedule;
+    }
+
+    std::vector<PrioritizedTask> tasks;
+    tasks.swap(prioritized_tasks_);
+    // Expired tasks are handed to `expired_task_callback` by ProcessBatch(),
+    // so that they don't take up slots in the batch.
+    auto expired = std::stable_partition(
+        tasks.begin(), tasks.end(),
+        [this](const PrioritizedTask& t) { return !IsExpired(*t.task); });
+    for (auto it = expired; it != tasks.end(); ++it) {
+      expired_tasks_.push_back(std::move(it->task));
+    }
+    tasks.erase(expired, tasks.end());
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const PrioritizedTask& a, const PrioritizedTask& b) {
+                       if (a.task->priority() != b.task->priority()) {
+                         return a.task->priority() > b.task->priority();
+                       }
+                       return a.task->deadline_micros() <
+                              b.task->deadline_micros();
+                     });
+
+    // Fill the batch in order, letting smaller tasks of lower priorities take
+    // the slots left by the tasks that don't fit.
+    batch_to_schedule =
+        std::make_unique<Batch<TaskType>>(++traceme_context_id_counter_);
+    prioritized_tasks_size_ = 0;
+    prioritized_tasks_deadline_micros_ = kint64max;
+    prioritized_tasks_start_time_micros_ = kuint64max;
+    for (PrioritizedTask& t : tasks) {
+      if (batch_to_schedule->size() + t.task->size() <=
+          max_execution_batch_size()) {
+        batch_to_schedule->AddTask(std::move(t.task));
+        continue;
+      }
+      prioritized_tasks_size_ += t.task->size();
+      prioritized_tasks_deadline_micros_ = std::min(
+          prioritized_tasks_deadline_micros_, t.task->deadline_micros());
+      prioritized_tasks_start_time_micros_ =
+          std::min(prioritized_tasks_start_time_micros_, t.enqueue_time_micros);
+      prioritized_tasks_.push_back(std::move(t));
+    }
+    batch_to_schedule->Close();
+    ++num_batches_being_processed_;
+  }
+
+  return batch_to_schedule;
+}
+
+template <typename TaskType>
+int64_t Queue<TaskType>::EarliestDeadlineMicros() const {
+  mutex_lock l(mu_);
+  if (options_.enable_priority_scheduling) {
+    return prioritized_tasks_deadline_micros_;
+  }
+  int64_t deadline_micros = kint64max;
+  if (!options_.enable_lazy_split) {
+    const Batch<TaskType>& batch = *batches_.front();
+    for (int i = 0; i < batch.num_tasks(); ++i) {
+      deadline_micros =
+          std::min(deadline_micros, batch.task(i).deadline_micros());
+    }
+  }
+  return deadline_micros;
+}
+
 template <typename TaskType>
 typename SharedBatchScheduler<TaskType>::BatchUniquePtr
 Queue<TaskType>::ScheduleBatch() {
+  if (options_.enable_priority_scheduling) {
+    return ScheduleBatchWithPriority();
+  }
   if (!options_.enable_lazy_split) {
     return ScheduleBatchWithEagerSplit();
   }
@@ -1073,15 +1384,34 @@ Queue<TaskType>::ScheduleBatch() {
 
 template <typename TaskType>
 void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
-  profiler::TraceMeConsumer trace_me(
-      [&] {
-        return profiler::TraceMeEncode(
-            "ProcessBatch", {{"batch_size_before_padding", batch->size()},
-                             {"_r", 2} /*root_event*/});
-      },
-      profiler::ContextType::kSharedBatchScheduler,
-      batch->traceme_context_id());
-  process_batch_callback_(std::move(batch));
+  if (options_.expired_task_callback != nullptr) {
+    std::vector<std::unique_ptr<TaskType>> expired_tasks;
+    {
+      mutex_lock l(mu_);
+      expired_tasks.swap(expired_tasks_);
+    }
+    RemoveExpiredTasks(&batch, &expired_tasks);
+    for (auto& task : expired_tasks) {
+      options_.expired_task_callback(std::move(task));
+    }
+  }
+
+  if (!batch->empty()) {
+    // Time the closed batch waited for a batch thread.
+    const uint64 close_time_micros = batch->close_time_micros();
+    const int64_t queue_delay_micros =
+        close_time_micros == 0 ? 0 : EnvTime::NowMicros() - close_time_micros;
+    profiler::TraceMeConsumer trace_me(
+        [&] {
+          return profiler::TraceMeEncode(
+              "ProcessBatch", {{"batch_size_before_padding", batch->size()},
+                               {"queue_delay_us", queue_delay_micros},
+                               {"_r", 2} /*root_event*/});
+        },
+        profiler::ContextType::kSharedBatchScheduler,
+        batch->traceme_context_id());
+    process_batch_callback_(std::move(batch));
+  }
 
   {
     mutex_lock l(mu_);
@@ -1122,7 +1452,8 @@ bool Queue<TaskType>::IsEmptyInternal() const {
            task_handle_batches_.back()->empty();
   }
   return num_batches_being_processed_ == 0 && batches_.size() == 1 &&
-         batches_.back()->empty();
+         batches_.back()->empty() && prioritized_tasks_.empty() &&
+         expired_tasks_.empty();
 }
 
 template <typename TaskType>
@@ -1155,8 +1486,61 @@ bool Queue<TaskType>::IsOpenBatchSchedulableAfterEagerSplit() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchDue(open_batch->size(), open_batch_start_time_micros_);
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsPrioritizedBatchSchedulable() const {
+  if (prioritized_tasks_.empty()) {
+    return false;
+  }
+  return closed_ || prioritized_tasks_size_ >= max_execution_batch_size() ||
+         IsOpenBatchDue(prioritized_tasks_size_,
+                        prioritized_tasks_start_time_micros_) ||
+         static_cast<int64_t>(env_->NowMicros()) >=
+             prioritized_tasks_deadline_micros_ - options_.batch_timeout_micros;
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsOpenBatchDue(size_t batch_size,
+                                     uint64 start_time_micros) const {
+  const uint64 now_micros = env_->NowMicros();
+  if (now_micros >= start_time_micros + options_.batch_timeout_micros) {
+    return true;
+  }
+  return options_.close_open_batch_func != nullptr &&
+         options_.close_open_batch_func(batch_size,
+                                        now_micros - start_time_micros);
+}
+
+template <typename TaskType>
+bool Queue<TaskType>::IsExpired(const TaskType& task) const {
+  return options_.expired_task_callback != nullptr &&
+         static_cast<int64_t>(env_->NowMicros()) > task.deadline_micros();
+}
+
+template <typename TaskType>
+void Queue<TaskType>::RemoveExpiredTasks(
+    std::unique_ptr<Batch<TaskType>>* batch,
+    std::vector<std::unique_ptr<TaskType>>* expired_tasks) {
+  bool has_expired_task = false;
+  for (int i = 0; i < (*batch)->num_tasks() && !has_expired_task; ++i) {
+    has_expired_task = IsExpired((*batch)->task(i));
+  }
+  if (!has_expired_task) {
+    return;
+  }
+  auto remaining_tasks =
+      std::make_unique<Batch<TaskType>>((*batch)->traceme_context_id());
+  for (auto& task : (*batch)->RemoveAllTasks()) {
+    if (IsExpired(*task)) {
+      expired_tasks->push_back(std::move(task));
+    } else {
+      remaining_tasks->AddTask(std::move(task));
+    }
+  }
+  remaining_tasks->Close();
+  *batch = std::move(remaining_tasks);
 }
 
 template <typename TaskType>
@@ -1170,8 +1554,7 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
     return false;
   }
   return closed_ || open_batch->size() >= max_execution_batch_size() ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+         IsOpenBatchDue(open_batch->size(), open_batch_start_time_micros_);
 }
 
 template <typename TaskType>
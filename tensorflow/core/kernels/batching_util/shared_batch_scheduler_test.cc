@@ -42,14 +42,22 @@ namespace {
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size) : size_(size) {}
+  explicit FakeTask(size_t size, int priority = 0,
+                    int64_t deadline_micros = kint64max)
+      : size_(size), priority_(priority), deadline_micros_(deadline_micros) {}
 
   ~FakeTask() override = default;
 
   size_t size() const override { return size_; }
 
+  int priority() const override { return priority_; }
+
+  int64_t deadline_micros() const override { return deadline_micros_; }
+
  private:
   const size_t size_;
+  const int priority_;
+  const int64_t deadline_micros_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
 };
@@ -431,6 +439,41 @@ TEST_P(SharedBatchSchedulerTest, ObeysTimeoutWithRealClock) {
   second_batch_processed.WaitForNotification();
 }
 
+TEST_P(SharedBatchSchedulerTest, ClosesOpenBatchEarly) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      EXPECT_EQ(batch->size(), 3);
+      batch_processed.Notify();
+    };
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    QueueOptions options =
+        CreateQueueOptions(/*max_execution_batch_size=*/10,
+                           /*input_batch_size_limit=*/10,
+                           /*batch_timeout_micros=*/1000 * 1000 * 1000,
+                           /*max_enqueued_batches=*/2);
+    options.close_open_batch_func = [](size_t batch_size,
+                                       int64_t wait_micros) {
+      return batch_size >= 3;
+    };
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    TF_ASSERT_OK(ScheduleTask(2, queue.get()));
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed.HasBeenNotified());
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    batch_processed.WaitForNotification();
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST_P(SharedBatchSchedulerTest,
        WithZeroTimeoutBatchesScheduledAsSoonAsThreadIsAvailable) {
   // Set up a fake clock, and never advance the time.
@@ -791,6 +834,191 @@ TEST_P(SharedBatchSchedulerTest, ZeroQueueRewrittenToOneQueue) {
   }
 }
 
+// Returns the sizes of the tasks in `batch`, in order.
+std::vector<int> TaskSizes(const Batch<FakeTask>& batch) {
+  std::vector<int> sizes;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    sizes.push_back(batch.task(i).size());
+  }
+  return sizes;
+}
+
+TEST(SharedBatchSchedulerPriorityTest, LowPriorityTasksFillSpareSlots) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<std::vector<int>> batches;
+    Notification second_batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      ASSERT_TRUE(batch->IsClosed());
+      mutex_lock l(mu);
+      batches.push_back(TaskSizes(*batch));
+      if (batches.size() == 2) {
+        second_batch_processed.Notify();
+      }
+    };
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    QueueOptions options;
+    options.input_batch_size_limit = 10;
+    options.batch_timeout_micros = 100;
+    options.enable_priority_scheduling = true;
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    // The batch becomes full with the last task. The high-priority tasks go
+    // first, and the low-priority task of size 3 fills the remaining slots.
+    std::vector<std::pair<int, int>> size_and_priority = {
+        {3, 0}, {4, 1}, {2, 0}, {2, 1}};
+    for (const auto& [size, priority] : size_and_priority) {
+      std::unique_ptr<FakeTask> task(new FakeTask(size, priority));
+      TF_ASSERT_OK(queue->Schedule(&task));
+    }
+    // The remaining task is processed at the timeout.
+    env.AdvanceByMicroseconds(100);
+    second_batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(batches, (std::vector<std::vector<int>>{{4, 2, 3}, {2}}));
+    }
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+class SharedBatchSchedulerDeadlineTest : public ::testing::TestWithParam<bool> {
+ protected:
+  bool enable_priority_scheduling() const { return GetParam(); }
+};
+
+TEST_P(SharedBatchSchedulerDeadlineTest, DropsExpiredTasks) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    mutex mu;
+    std::vector<int> processed_sizes;
+    std::vector<int> expired_sizes;
+    Notification batch_processed;
+    auto callback = [&](std::unique_ptr<Batch<FakeTask>> batch) {
+      mutex_lock l(mu);
+      processed_sizes = TaskSizes(*batch);
+      batch_processed.Notify();
+    };
+    auto scheduler = CreateSharedBatchScheduler(1, &env);
+    QueueOptions options;
+    options.input_batch_size_limit = 10;
+    options.batch_timeout_micros = 10;
+    options.enable_priority_scheduling = enable_priority_scheduling();
+    options.expired_task_callback = [&](std::unique_ptr<FakeTask> task) {
+      mutex_lock l(mu);
+      expired_sizes.push_back(task->size());
+    };
+    auto queue = CreateQueue(scheduler, options, callback);
+
+    const int64_t now_micros = env.NowMicros();
+    std::unique_ptr<FakeTask> task(new FakeTask(1, 0, now_micros - 1));
+    EXPECT_THAT(queue->Schedule(&task),
+                testing::StatusIs(error::DEADLINE_EXCEEDED));
+    ASSERT_NE(task, nullptr);
+
+    task.reset(new FakeTask(2, 0, now_micros + 20));
+    TF_ASSERT_OK(queue->Schedule(&task));
+    task.reset(new FakeTask(3));
+    TF_ASSERT_OK(queue->Schedule(&task));
+    // Both the timeout and the deadline of the first task pass before the
+    // batch is scheduled.
+    env.AdvanceByMicroseconds(30);
+    batch_processed.WaitForNotification();
+    {
+      mutex_lock l(mu);
+      EXPECT_EQ(processed_sizes, std::vector<int>({3}));
+      EXPECT_EQ(expired_sizes, std::vector<int>({2}));
+    }
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
+INSTANTIATE_TEST_SUITE_P(PriorityScheduling, SharedBatchSchedulerDeadlineTest,
+                         ::testing::Bool());
+
+TEST(SharedBatchSchedulerPriorityTest, EarliestDeadlineFirst) {
+  for (auto policy : {Scheduler::SchedulingPolicy::kRoundRobin,
+                      Scheduler::SchedulingPolicy::kEarliestDeadlineFirst}) {
+    mutex mu;
+    std::vector<int> processed_queues;
+    Notification first_batch_started, first_batch_proceed;
+    auto callback = [&](int queue_index) {
+      return [&, queue_index](std::unique_ptr<Batch<FakeTask>> batch) {
+        if (!first_batch_started.HasBeenNotified()) {
+          first_batch_started.Notify();
+          first_batch_proceed.WaitForNotification();
+        }
+        mutex_lock l(mu);
+        processed_queues.push_back(queue_index);
+      };
+    };
+    Scheduler::Options options;
+    options.num_batch_threads = 1;
+    options.scheduling_policy = policy;
+    std::shared_ptr<Scheduler> scheduler;
+    TF_ASSERT_OK(Scheduler::Create(options, &scheduler));
+    QueueOptions queue_options;
+    queue_options.input_batch_size_limit = 1;
+    auto queue_0 = CreateQueue(scheduler, queue_options, callback(0));
+    auto queue_1 = CreateQueue(scheduler, queue_options, callback(1));
+
+    // Keep the batch thread busy with a batch of `queue_1`, after which it
+    // would visit `queue_0` next in round-robin order.
+    TF_ASSERT_OK(ScheduleTask(1, queue_1.get()));
+    first_batch_started.WaitForNotification();
+    TF_ASSERT_OK(ScheduleTask(1, queue_0.get()));
+    std::unique_ptr<FakeTask> task(
+        new FakeTask(1, 0, Env::Default()->NowMicros() + 3600000000));
+    TF_ASSERT_OK(queue_1->Schedule(&task));
+    first_batch_proceed.Notify();
+    queue_0.reset();
+    queue_1.reset();
+
+    mutex_lock l(mu);
+    if (policy == Scheduler::SchedulingPolicy::kRoundRobin) {
+      EXPECT_EQ(processed_queues, std::vector<int>({1, 0, 1}));
+    } else {
+      EXPECT_EQ(processed_queues, std::vector<int>({1, 1, 0}));
+    }
+  }
+}
+
+TEST(SharedBatchSchedulerPriorityTest, InvalidOptions) {
+  auto callback = [](std::unique_ptr<Batch<FakeTask>> batch) {};
+  auto scheduler = CreateSharedBatchScheduler(1);
+  std::unique_ptr<Queue> queue;
+
+  QueueOptions options;
+  options.enable_priority_scheduling = true;
+  options.enable_large_batch_splitting = true;
+  options.max_execution_batch_size = options.input_batch_size_limit;
+  options.split_input_task_func =
+      [](std::unique_ptr<FakeTask>* input_task, int first_output_task_size,
+         int max_batch_size,
+         std::vector<std::unique_ptr<FakeTask>>* output_tasks) {
+        return OkStatus();
+      };
+  EXPECT_THAT(scheduler->AddQueue(options, callback, &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT));
+
+  options.enable_priority_scheduling = false;
+  options.enable_lazy_split = true;
+  options.expired_task_callback = [](std::unique_ptr<FakeTask> task) {};
+  EXPECT_THAT(scheduler->AddQueue(options, callback, &queue),
+              testing::StatusIs(error::INVALID_ARGUMENT));
+}
+
 // TODO(b/161857471):
 // Add test coverage when input-split and no-split returns differently.
 INSTANTIATE_TEST_SUITE_P(
@@ -18,6 +18,10 @@ limitations under the License.
 #include "tensorflow/core/platform/errors.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -37,53 +41,174 @@ typedef Eigen::GpuDevice GPUDevice;
 
 namespace functor {
 
-template <typename Tidx, typename T>
-struct BincountFunctor<CPUDevice, Tidx, T, true> {
-  static Status Compute(OpKernelContext* context,
-                        const typename TTypes<Tidx, 1>::ConstTensor& arr,
-                        const typename TTypes<T, 1>::ConstTensor& weights,
-                        typename TTypes<T, 1>::Tensor& output,
-                        const Tidx num_bins) {
-    Tensor all_nonneg_t;
-    TF_RETURN_IF_ERROR(context->allocate_temp(
-        DT_BOOL, TensorShape({}), &all_nonneg_t, AllocatorAttributes()));
-    all_nonneg_t.scalar<bool>().device(context->eigen_cpu_device()) =
-        (arr >= Tidx(0)).all();
-    if (!all_nonneg_t.scalar<bool>()()) {
-      return errors::InvalidArgument("Input arr must be non-negative!");
+namespace {
+
+// Partial histograms per shard of the input are used when a histogram fits in
+// this many bytes, which is about the size of an L2 cache.
+constexpr int64_t kMaxPartialHistogramBytes = 256 << 10;
+// Minimum number of input elements per shard.
+constexpr int64_t kMinBincountShardSize = 16 << 10;
+
+template <bool binary_output, typename Bin, typename T>
+inline void AddToBin(const T* weights, int64_t i, Bin* bin) {
+  if constexpr (binary_output) {
+    *bin = Bin(1);
+  } else if (weights != nullptr) {
+    *bin += weights[i];
+  } else {
+    // Complex numbers don't support "++".
+    *bin += Bin(1);
+  }
+}
+
+// Computes the histogram of the values of 'arr' in [0, num_bins) into
+// 'output', weighted by 'weights' unless it is null, or binary. The input is
+// split into a number of shards that only depends on its size, so that the
+// result is deterministic, and the histogram is computed:
+//  * with a serial loop, if there is a single shard;
+//  * with a partial histogram per shard, summed at the end, if a histogram
+//    fits in the L2 cache;
+//  * otherwise, as in a single pass of a radix sort, by partitioning the
+//    elements into one range of bins per shard, and then accumulating each
+//    range in parallel. This avoids allocating, clearing and summing large
+//    partial histograms, and confines the random accesses of each thread to
+//    a small part of the output.
+template <typename Tidx, typename T, bool binary_output>
+Status ComputeBincount(OpKernelContext* context, const Tidx* arr,
+                       const int64_t arr_size, const T* weights,
+                       const Tidx num_bins, T* output) {
+  // Binary partial histograms only need one byte per bin.
+  typedef typename std::conditional<binary_output, bool, T>::type Bin;
+  ThreadPool* thread_pool =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  const int64_t num_shards =
+      std::min<int64_t>(thread_pool->NumThreads(),
+                        Eigen::divup(arr_size, kMinBincountShardSize));
+  if (num_shards <= 1) {
+    std::fill(output, output + num_bins, T(0));
+    for (int64_t i = 0; i < arr_size; i++) {
+      const Tidx value = arr[i];
+      if (value < num_bins) {
+        AddToBin<binary_output>(weights, i, &output[value]);
+      }
     }
+    return OkStatus();
+  }
+  const int64_t shard_size = Eigen::divup(arr_size, num_shards);
+  const int64_t shard_cost = shard_size * (weights ? 16 : 8);
 
-    // Allocate partial output bin sums for each worker thread. Worker ids in
-    // ParallelForWithWorkerId range from 0 to NumThreads() inclusive.
-    ThreadPool* thread_pool =
-        context->device()->tensorflow_cpu_worker_threads()->workers;
-    const int64_t num_threads = thread_pool->NumThreads() + 1;
+  if (num_bins * sizeof(Bin) <= kMaxPartialHistogramBytes) {
     Tensor partial_bins_t;
     TF_RETURN_IF_ERROR(context->allocate_temp(
-        DT_BOOL, TensorShape({num_threads, num_bins}), &partial_bins_t));
-    auto partial_bins = partial_bins_t.matrix<bool>();
-    partial_bins.setZero();
-    thread_pool->ParallelForWithWorkerId(
-        arr.size(), 8 /* cost */,
-        [&](int64_t start_ind, int64_t limit_ind, int64_t worker_id) {
-          for (int64_t i = start_ind; i < limit_ind; i++) {
-            Tidx value = arr(i);
-            if (value < num_bins) {
-              partial_bins(worker_id, value) = true;
+        DataTypeToEnum<Bin>::value, TensorShape({num_shards, num_bins}),
+        &partial_bins_t));
+    auto partial_bins = partial_bins_t.matrix<Bin>();
+    thread_pool->ParallelFor(
+        num_shards, shard_cost, [&](int64_t first, int64_t last) {
+          for (int64_t shard = first; shard < last; ++shard) {
+            Bin* bins = &partial_bins(shard, 0);
+            std::fill(bins, bins + num_bins, Bin(0));
+            const int64_t limit =
+                std::min(arr_size, (shard + 1) * shard_size);
+            for (int64_t i = shard * shard_size; i < limit; i++) {
+              const Tidx value = arr[i];
+              if (value < num_bins) {
+                AddToBin<binary_output>(weights, i, &bins[value]);
+              }
             }
           }
         });
 
     // Sum the partial bins along the 0th axis.
+    typename TTypes<T>::Flat output_t(output, num_bins);
     Eigen::array<int, 1> reduce_dim({0});
-    output.device(context->eigen_cpu_device()) =
-        partial_bins.any(reduce_dim).cast<T>();
+    if constexpr (binary_output) {
+      output_t.device(context->eigen_cpu_device()) =
+          partial_bins.any(reduce_dim).template cast<T>();
+    } else {
+      output_t.device(context->eigen_cpu_device()) =
+          partial_bins.sum(reduce_dim);
+    }
     return OkStatus();
   }
-};
 
-template <typename Tidx, typename T>
-struct BincountFunctor<CPUDevice, Tidx, T, false> {
+  // Count the elements of each shard in each range of bins.
+  const int64_t num_ranges = num_shards;
+  const int64_t range_size = Eigen::divup<int64_t>(num_bins, num_ranges);
+  std::vector<int64_t> offsets(num_shards * num_ranges, 0);
+  thread_pool->ParallelFor(
+      num_shards, shard_cost, [&](int64_t first, int64_t last) {
+        for (int64_t shard = first; shard < last; ++shard) {
+          int64_t* counts = &offsets[shard * num_ranges];
+          const int64_t limit = std::min(arr_size, (shard + 1) * shard_size);
+          for (int64_t i = shard * shard_size; i < limit; i++) {
+            const Tidx value = arr[i];
+            if (value < num_bins) ++counts[value / range_size];
+          }
+        }
+      });
+  // Turn the counts into the offsets of the elements of each shard, with the
+  // elements of each range in input order.
+  std::vector<int64_t> range_offsets(num_ranges + 1, 0);
+  int64_t num_entries = 0;
+  for (int64_t range = 0; range < num_ranges; ++range) {
+    range_offsets[range] = num_entries;
+    for (int64_t shard = 0; shard < num_shards; ++shard) {
+      const int64_t count = offsets[shard * num_ranges + range];
+      offsets[shard * num_ranges + range] = num_entries;
+      num_entries += count;
+    }
+  }
+  range_offsets[num_ranges] = num_entries;
+
+  // Move the values, and their weights, into their ranges.
+  const bool has_weights = !binary_output && weights != nullptr;
+  Tensor values_t;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataTypeToEnum<Tidx>::value, TensorShape({num_entries}), &values_t));
+  Tensor weights_t;
+  TF_RETURN_IF_ERROR(context->allocate_temp(
+      DataTypeToEnum<T>::value, TensorShape({has_weights ? num_entries : 0}),
+      &weights_t));
+  Tidx* values = values_t.flat<Tidx>().data();
+  T* range_weights = has_weights ? weights_t.flat<T>().data() : nullptr;
+  thread_pool->ParallelFor(
+      num_shards, shard_cost, [&](int64_t first, int64_t last) {
+        for (int64_t shard = first; shard < last; ++shard) {
+          int64_t* shard_offsets = &offsets[shard * num_ranges];
+          const int64_t limit = std::min(arr_size, (shard + 1) * shard_size);
+          for (int64_t i = shard * shard_size; i < limit; i++) {
+            const Tidx value = arr[i];
+            if (value < num_bins) {
+              const int64_t j = shard_offsets[value / range_size]++;
+              values[j] = value;
+              if (has_weights) range_weights[j] = weights[i];
+            }
+          }
+        }
+      });
+
+  // Accumulate each range of bins.
+  thread_pool->ParallelFor(
+      num_ranges, shard_cost, [&](int64_t first, int64_t last) {
+        for (int64_t range = first; range < last; ++range) {
+          std::fill(output + range * range_size,
+                    output + std::min<int64_t>(num_bins,
+                                               (range + 1) * range_size),
+                    T(0));
+          for (int64_t j = range_offsets[range]; j < range_offsets[range + 1];
+               ++j) {
+            AddToBin<binary_output>(range_weights, j, &output[values[j]]);
+          }
+        }
+      });
+  return OkStatus();
+}
+
+}  // namespace
+
+template <typename Tidx, typename T, bool binary_output>
+struct BincountFunctor<CPUDevice, Tidx, T, binary_output> {
   static Status Compute(OpKernelContext* context,
                         const typename TTypes<Tidx, 1>::ConstTensor& arr,
                         const typename TTypes<T, 1>::ConstTensor& weights,
@@ -97,71 +222,14 @@ struct BincountFunctor<CPUDevice, Tidx, T, false> {
     if (!all_nonneg_t.scalar<bool>()()) {
       return errors::InvalidArgument("Input arr must be non-negative!");
     }
-
-    // Allocate partial output bin sums for each worker thread. Worker ids in
-    // ParallelForWithWorkerId range from 0 to NumThreads() inclusive.
-    ThreadPool* thread_pool =
-        context->device()->tensorflow_cpu_worker_threads()->workers;
-    const int64_t num_threads = thread_pool->NumThreads() + 1;
-    const Tidx* arr_data = arr.data();
-    const std::ptrdiff_t arr_size = arr.size();
-    const T* weight_data = weights.data();
-    if (weights.size() && weights.size() != arr_size) {
+    if (!binary_output && weights.size() && weights.size() != arr.size()) {
       return errors::InvalidArgument(
           "Input indices and weights must have the same size.");
     }
-    if (num_threads == 1) {
-      output.setZero();
-      T* output_data = output.data();
-      if (weights.size()) {
-        for (int64_t i = 0; i < arr_size; i++) {
-          const Tidx value = arr_data[i];
-          if (value < num_bins) {
-            output_data[value] += weight_data[i];
-          }
-        }
-      } else {
-        for (int64_t i = 0; i < arr_size; i++) {
-          const Tidx value = arr_data[i];
-          if (value < num_bins) {
-            // Complex numbers don't support "++".
-            output_data[value] += T(1);
-          }
-        }
-      }
-    } else {
-      Tensor partial_bins_t;
-      TF_RETURN_IF_ERROR(context->allocate_temp(
-          DataTypeToEnum<T>::value, TensorShape({num_threads, num_bins}),
-          &partial_bins_t));
-      auto partial_bins = partial_bins_t.matrix<T>();
-      partial_bins.setZero();
-      thread_pool->ParallelForWithWorkerId(
-          arr_size, 8 /* cost */,
-          [&](int64_t start_ind, int64_t limit_ind, int64_t worker_id) {
-            if (weights.size()) {
-              for (int64_t i = start_ind; i < limit_ind; i++) {
-                Tidx value = arr_data[i];
-                if (value < num_bins) {
-                  partial_bins(worker_id, value) += weight_data[i];
-                }
-              }
-            } else {
-              for (int64_t i = start_ind; i < limit_ind; i++) {
-                Tidx value = arr_data[i];
-                if (value < num_bins) {
-                  // Complex numbers don't support "++".
-                  partial_bins(worker_id, value) += T(1);
-                }
-              }
-            }
-          });
-
-      // Sum the partial bins along the 0th axis.
-      Eigen::array<int, 1> reduce_dim({0});
-      output.device(context->eigen_cpu_device()) = partial_bins.sum(reduce_dim);
-    }
-    return OkStatus();
+    return ComputeBincount<Tidx, T, binary_output>(
+        context, arr.data(), arr.size(),
+        !binary_output && weights.size() ? weights.data() : nullptr, num_bins,
+        output.data());
   }
 };
 
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/sorted_search.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -37,13 +38,9 @@ struct BucketizeFunctor<CPUDevice, T> {
                         const typename TTypes<T, 1>::ConstTensor& input,
                         const std::vector<float>& boundaries_vector,
                         typename TTypes<int32, 1>::Tensor& output) {
-    const int N = input.size();
-    for (int i = 0; i < N; i++) {
-      auto first_bigger_it = std::upper_bound(
-          boundaries_vector.begin(), boundaries_vector.end(), input(i));
-      output(i) = first_bigger_it - boundaries_vector.begin();
-    }
-
+    sorted_search::SearchSorted</*kUpper=*/true>(
+        context, boundaries_vector.data(), /*batch_size=*/1,
+        boundaries_vector.size(), input.data(), input.size(), output.data());
     return OkStatus();
   }
 };
@@ -0,0 +1,97 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Tool that builds a table file for the MemmappedHashTable op from a
+// vocabulary text file, so that large vocabularies are converted once offline
+// instead of being inserted into a table each time a model is loaded.
+//
+// bazel build tensorflow/core/kernels:build_memmapped_lookup_table &&
+// bazel-bin/tensorflow/core/kernels/build_memmapped_lookup_table \
+// --vocab_file=vocab.txt \
+// --output=vocab.table
+//
+// By default, each line of `vocab_file` is a string key, mapped to its line
+// number. The `key_index`, `value_index`, `delimiter`, `vocab_size` and
+// `offset` flags have the same meaning as the arguments of
+// `tf.lookup.TextFileInitializer`, where -2 selects the whole line and -1 the
+// line number.
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/memmapped_lookup_table.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+int Main(int argc, char** argv) {
+  string vocab_file;
+  string output;
+  string key_dtype = "string";
+  string value_dtype = "int64";
+  int32_t key_index = -2;
+  int32_t value_index = -1;
+  string delimiter = "\t";
+  int64_t vocab_size = -1;
+  int64_t offset = 0;
+  std::vector<Flag> flag_list = {
+      Flag("vocab_file", &vocab_file, "vocabulary text file to convert"),
+      Flag("output", &output, "table file to write"),
+      Flag("key_dtype", &key_dtype, "type of the keys, string or int64"),
+      Flag("value_dtype", &value_dtype,
+           "type of the values, int32, int64, float or double"),
+      Flag("key_index", &key_index,
+           "column of the keys, -2 for the whole line"),
+      Flag("value_index", &value_index,
+           "column of the values, -1 for the line number"),
+      Flag("delimiter", &delimiter, "column delimiter, a single character"),
+      Flag("vocab_size", &vocab_size,
+           "number of lines to read, -1 for the whole file"),
+      Flag("offset", &offset, "offset added to the line numbers"),
+  };
+  const string usage = Flags::Usage(argv[0], flag_list);
+  if (!Flags::Parse(&argc, argv, flag_list) || vocab_file.empty() ||
+      output.empty() || delimiter.size() != 1) {
+    LOG(ERROR) << usage;
+    return 1;
+  }
+  port::InitMain(usage.c_str(), &argc, &argv);
+
+  DataType key_type;
+  DataType value_type;
+  if (!DataTypeFromString(key_dtype, &key_type) ||
+      !DataTypeFromString(value_dtype, &value_type)) {
+    LOG(ERROR) << "Invalid key_dtype or value_dtype.\n" << usage;
+    return 1;
+  }
+  const Status status = lookup::WriteMemmappedLookupTableFromTextFile(
+      Env::Default(), vocab_file, vocab_size, delimiter[0], key_index,
+      value_index, offset, key_type, value_type, output);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char** argv) { return tensorflow::Main(argc, argv); }
@@ -16,13 +16,66 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/kernels/concat_lib_cpu.h"
+
+#include <cstdint>
+#include <cstring>
 #include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/concat_lib.h"
 
 namespace tensorflow {
 
 namespace {
+
+// Outputs of at least this many bytes, which are much larger than typical
+// last-level caches, are written with non-temporal stores.
+constexpr int64_t kConcatStreamingMinBytes = 64 << 20;
+// Size of the blocks of output copied in parallel for such outputs.
+constexpr int64_t kConcatStreamingBlockBytes = 1 << 20;
+// Smaller copies, such as short rows, use `memcpy`.
+constexpr size_t kNonTemporalMemcpyMinBytes = 1024;
+
+// Copies `n` bytes like `memcpy`, but with non-temporal stores where
+// available, so that the destination does not evict the working set from the
+// caches.
+void NonTemporalMemcpy(void* dst, const void* src, size_t n) {
+#if defined(__SSE2__)
+  if (n >= kNonTemporalMemcpyMinBytes) {
+    char* d = static_cast<char*>(dst);
+    const char* s = static_cast<const char*>(src);
+    // Align the destination for the streaming stores.
+    const size_t head = (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16;
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    for (; n >= 64; n -= 64, d += 64, s += 64) {
+      const __m128i* in = reinterpret_cast<const __m128i*>(s);
+      __m128i* out = reinterpret_cast<__m128i*>(d);
+      const __m128i v0 = _mm_loadu_si128(in);
+      const __m128i v1 = _mm_loadu_si128(in + 1);
+      const __m128i v2 = _mm_loadu_si128(in + 2);
+      const __m128i v3 = _mm_loadu_si128(in + 3);
+      _mm_stream_si128(out, v0);
+      _mm_stream_si128(out + 1, v1);
+      _mm_stream_si128(out + 2, v2);
+      _mm_stream_si128(out + 3, v3);
+    }
+    memcpy(d, s, n);
+    // Non-temporal stores are weakly ordered. Make them visible before the
+    // completion of the copy is signaled to other threads.
+    _mm_sfence();
+    return;
+  }
+#endif  // defined(__SSE2__)
+  memcpy(dst, src, n);
+}
+
 template <typename T>
 struct MemCpyCopier {
   inline void Copy(T* dst, const T* src, int input_index, size_t n) {
@@ -45,6 +98,17 @@ struct MemCpyCopier<ResourceHandle> {
   }
 };
 
+template <typename T>
+struct StreamingCopier {
+  inline void Copy(T* dst, const T* src, int input_index, size_t n) {
+    if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+      NonTemporalMemcpy(dst, src, n * sizeof(T));
+    } else {
+      MemCpyCopier<T>().Copy(dst, src, input_index, n);
+    }
+  }
+};
+
 template <typename T>
 int64_t EstimateBytesPerElement(
     const std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>&
@@ -102,6 +166,14 @@ void ConcatCPU(
         inputs,
     typename TTypes<T, 2>::Matrix* output) {
   int64_t cost_per_unit = EstimateBytesPerElement<T>(inputs);
+  // Large outputs are split evenly by bytes among the threads, and written
+  // with non-temporal stores.
+  if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v()) &&
+      output->size() * sizeof(T) >= kConcatStreamingMinBytes) {
+    ConcatCPUImpl<T>(d, inputs, cost_per_unit, StreamingCopier<T>(), output,
+                     /*block_size=*/kConcatStreamingBlockBytes / sizeof(T));
+    return;
+  }
   ConcatCPUImpl<T>(d, inputs, cost_per_unit, MemCpyCopier<T>(), output);
 }
 
@@ -28,13 +28,18 @@ namespace tensorflow {
 // ElementCopier must be a struct with a single Copy function, which is passed
 // the output pointer, input pointer, input index, and number of elements to
 // copy from input to output.
+//
+// If `block_size` is positive, the output is split into blocks of
+// `block_size` elements that are copied in parallel, regardless of the
+// boundaries of the rows and inputs. Otherwise, the split is chosen by the
+// cost model.
 template <typename T, typename ElementCopier>
 void ConcatCPUImpl(
     DeviceBase* d,
     const std::vector<std::unique_ptr<typename TTypes<T, 2>::ConstMatrix>>&
         inputs,
     int64_t cost_per_unit, ElementCopier copier,
-    typename TTypes<T, 2>::Matrix* output) {
+    typename TTypes<T, 2>::Matrix* output, int64_t block_size = 0) {
   size_t num_inputs = inputs.size();
 
   std::vector<ptrdiff_t> sizes;
@@ -126,6 +131,15 @@ void ConcatCPUImpl(
       }
     }
   };
+  if (block_size > 0) {
+    worker_threads->workers->ParallelFor(
+        output->size(),
+        thread::ThreadPool::SchedulingParams(
+            thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+            absl::nullopt, block_size),
+        work);
+    return;
+  }
   Shard(worker_threads->num_threads, worker_threads->workers, output->size(),
         cost_per_unit, work);
 }
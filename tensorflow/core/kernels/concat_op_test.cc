@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
@@ -86,6 +88,44 @@ static void ConcatHelper(::testing::benchmark::State& state,
                           (in0_bytes + in1_bytes));
 }
 
+class ConcatOpTest : public OpsTestBase {};
+
+// Outputs larger than the last-level cache are copied with streaming stores,
+// in blocks that do not match the boundaries of the rows and inputs.
+TEST_F(ConcatOpTest, LargeOutput) {
+  TF_ASSERT_OK(NodeDefBuilder("concat", "ConcatV2")
+                   .Input(FakeInput(3, DT_FLOAT))
+                   .Input(FakeInput(DT_INT32))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // The output has more than 64MB, and rows that are not a multiple of the
+  // vector size.
+  const int64_t kRows = 9500;
+  const std::vector<int64_t> cols = {1001, 3, 777};
+  for (int64_t i = 0; i < cols.size(); ++i) {
+    AddInput<float>(TensorShape({kRows, cols[i]}), [i](int j) -> float {
+      return i * 1e7 + j;
+    });
+  }
+  AddInputFromArray<int32>(TensorShape({}), {1});
+  TF_ASSERT_OK(RunOpKernel());
+
+  const auto output = GetOutput(0)->matrix<float>();
+  ASSERT_EQ(output.dimension(0), kRows);
+  ASSERT_EQ(output.dimension(1), 1001 + 3 + 777);
+  int64_t mismatches = 0;
+  for (int64_t r = 0; r < kRows; ++r) {
+    int64_t c = 0;
+    for (int64_t i = 0; i < cols.size(); ++i) {
+      for (int64_t j = 0; j < cols[i]; ++j, ++c) {
+        mismatches +=
+            output(r, c) != static_cast<float>(i * 1e7 + r * cols[i] + j);
+      }
+    }
+  }
+  EXPECT_EQ(mismatches, 0);
+}
+
 void BM_ConcatDim0Float(::testing::benchmark::State& state) {
   const int dim2 = state.range(0);
 
@@ -231,6 +271,43 @@ BENCHMARK(BM_MemcpyAlternativeDim1)
     ->Arg(100000)
     ->Arg(1000000);
 
+// Assembles a batch of `num_inputs` inputs of `mb_per_input` MB each, as when
+// batching requests, for outputs much larger than the last-level cache.
+void BM_ConcatBatchAssembly(::testing::benchmark::State& state) {
+  const int num_inputs = state.range(0);
+  const int mb_per_input = state.range(1);
+  const int64_t kCols = 1024;
+  const int64_t rows = (mb_per_input << 20) / (kCols * sizeof(float));
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor concat_dim(DT_INT32, TensorShape({}));
+  concat_dim.scalar<int32>()() = 0;
+  std::vector<NodeBuilder::NodeOut> inputs;
+  for (int i = 0; i < num_inputs; ++i) {
+    Tensor input(DT_FLOAT, TensorShape({rows, kCols}));
+    input.flat<float>().setRandom();
+    inputs.push_back(test::graph::Constant(g, input));
+  }
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Concat")
+                  .Input(test::graph::Constant(g, concat_dim))
+                  .Input(inputs)
+                  .Attr("N", num_inputs)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api=*/false).Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_inputs * rows * kCols * sizeof(float));
+}
+
+BENCHMARK(BM_ConcatBatchAssembly)
+    ->UseRealTime()
+    ->ArgPair(8, 4)
+    ->ArgPair(8, 32)
+    ->ArgPair(2, 128)
+    ->ArgPair(64, 8);
+
 typedef Eigen::TensorMap<Eigen::Tensor<bfloat16, 1, Eigen::RowMajor>,
                          Eigen::Unaligned>
     EigenMap;
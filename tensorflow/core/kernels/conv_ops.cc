@@ -28,9 +28,11 @@ limitations under the License.
 
 #include <atomic>
 #include <map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -43,13 +45,17 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/conv_2d.h"
+#include "tensorflow/core/kernels/conv_ops_cpu_autotune.h"
+#include "tensorflow/core/kernels/conv_ops_using_gemm.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/gemm_functors.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/profiler/lib/scoped_annotation.h"
@@ -393,6 +399,18 @@ class LaunchDeepConvOp<CPUDevice, float> {
       return false;
     }
 
+    Launch(ctx, input, filter, batch, input_rows, input_cols, in_depth,
+           filter_rows, filter_cols, pad_rows, pad_cols, out_rows, out_cols,
+           out_depth, output);
+    return true;
+  }
+
+  // Launches DeepConv2D without checking whether it applies.
+  static void Launch(OpKernelContext* ctx, const Tensor& input,
+                     const Tensor& filter, int batch, int input_rows,
+                     int input_cols, int in_depth, int filter_rows,
+                     int filter_cols, int pad_rows, int pad_cols, int out_rows,
+                     int out_cols, int out_depth, Tensor* output) {
     Conv2DArgs args;
     args.batch = batch;
     args.in_rows = input_rows;
@@ -412,7 +430,6 @@ class LaunchDeepConvOp<CPUDevice, float> {
 
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
                                             output_ptr);
-    return true;
   }
 };
 
@@ -484,6 +501,164 @@ class LaunchXsmmConvOp<CPUDevice, float> {
 };
 #endif
 
+// Selects among the CPU implementations of Conv2D that apply to a problem by
+// timing each of them the first time the problem is seen, and caches the
+// fastest in CpuConvAutotuneMap. Only used if CpuConvUseAutotune() is true.
+template <typename Device, typename T>
+class LaunchCpuConvAutotunedOp {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, const Conv2DParameters& params,
+                  const Conv2DDimensions& dimensions, Tensor* output) {
+    return false;
+  }
+};
+
+template <typename T>
+class LaunchCpuConvAutotunedOp<CPUDevice, T> {
+ public:
+  static bool Run(OpKernelContext* ctx, const Tensor& input,
+                  const Tensor& filter, const Conv2DParameters& params,
+                  const Conv2DDimensions& dimensions, Tensor* output) {
+    absl::InlinedVector<CpuConvAlgorithm, 3> candidates = {
+        CpuConvAlgorithm::kSpatialConvolution};
+    if (CanUseIm2Col(params, dimensions)) {
+      candidates.push_back(CpuConvAlgorithm::kIm2ColGemm);
+    }
+    if (CanUseDeepConv(params, dimensions)) {
+      candidates.push_back(CpuConvAlgorithm::kDeepConv2D);
+    }
+    if (candidates.size() < 2) return false;
+
+    const CpuConvParameters conv_parameters(
+        DataTypeToEnum<T>::value, dimensions, params.padding,
+        ctx->eigen_device<CPUDevice>().numThreads());
+    CpuConvAutotuneMap* autotune_map = CpuConvAutotuneMap::Global();
+    CpuConvAlgorithm best_algorithm;
+    if (autotune_map->Find(conv_parameters, &best_algorithm)) {
+      Launch(ctx, best_algorithm, input, filter, params, dimensions, output);
+      return true;
+    }
+
+    // The first run of each algorithm warms up caches and scratch buffers, so
+    // only the second one is timed.
+    Env* env = Env::Default();
+    uint64 best_time_us = 0;
+    for (CpuConvAlgorithm algorithm : candidates) {
+      uint64 time_us = 0;
+      for (int i = 0; i < 2; ++i) {
+        const uint64 start_us = env->NowMicros();
+        Launch(ctx, algorithm, input, filter, params, dimensions, output);
+        if (!ctx->status().ok()) return true;
+        time_us = env->NowMicros() - start_us;
+      }
+      VLOG(2) << "Conv2D autotuning: " << CpuConvAlgorithmName(algorithm)
+              << " took " << time_us << "us for "
+              << conv_parameters.ToString();
+      if (algorithm == candidates.front() || time_us < best_time_us) {
+        best_algorithm = algorithm;
+        best_time_us = time_us;
+      }
+    }
+    autotune_map->Insert(conv_parameters, best_algorithm);
+    // Leave the output of the selected algorithm, so that this step computes
+    // the same result as the following ones.
+    if (best_algorithm != candidates.back()) {
+      Launch(ctx, best_algorithm, input, filter, params, dimensions, output);
+    }
+    return true;
+  }
+
+ private:
+  static bool CanUseIm2Col(const Conv2DParameters& params,
+                           const Conv2DDimensions& dimensions) {
+    if (!std::is_same<T, float>::value && !std::is_same<T, double>::value) {
+      return false;
+    }
+    if (params.data_format != FORMAT_NHWC || params.padding == EXPLICIT ||
+        dimensions.in_depth != dimensions.patch_depth ||
+        dimensions.dilation_rows != 1 || dimensions.dilation_cols != 1) {
+      return false;
+    }
+    // LaunchGeneric already reduces these to a single matrix multiplication.
+    if (dimensions.filter_rows == 1 && dimensions.filter_cols == 1 &&
+        dimensions.stride_rows == 1 && dimensions.stride_cols == 1) {
+      return false;
+    }
+    if (dimensions.filter_rows == dimensions.input_rows &&
+        dimensions.filter_cols == dimensions.input_cols &&
+        params.padding == VALID) {
+      return false;
+    }
+    const int64_t filter_value_count =
+        static_cast<int64_t>(dimensions.filter_rows) * dimensions.filter_cols *
+        dimensions.in_depth;
+    if (filter_value_count * sizeof(T) > kMaxChunkSize) return false;
+    int filter_top_offset;
+    int filter_left_offset;
+    Im2ColFilterOffsets(params.padding, dimensions.input_rows,
+                        dimensions.input_cols, dimensions.filter_rows,
+                        dimensions.filter_cols, dimensions.stride_rows,
+                        dimensions.stride_cols, dimensions.out_rows,
+                        dimensions.out_cols, &filter_top_offset,
+                        &filter_left_offset);
+    return filter_top_offset == dimensions.pad_rows_before &&
+           filter_left_offset == dimensions.pad_cols_before;
+  }
+
+  static bool CanUseDeepConv(const Conv2DParameters& params,
+                             const Conv2DDimensions& dimensions) {
+    return std::is_same<T, float>::value &&
+           params.data_format == FORMAT_NHWC && params.padding != EXPLICIT &&
+           dimensions.in_depth == dimensions.patch_depth &&
+           dimensions.dilation_rows == 1 && dimensions.dilation_cols == 1 &&
+           IsDeepConv2DSupported(dimensions.stride_rows, dimensions.stride_cols,
+                                 dimensions.filter_rows,
+                                 dimensions.filter_cols);
+  }
+
+  static void Launch(OpKernelContext* ctx, CpuConvAlgorithm algorithm,
+                     const Tensor& input, const Tensor& filter,
+                     const Conv2DParameters& params,
+                     const Conv2DDimensions& dimensions, Tensor* output) {
+    switch (algorithm) {
+      case CpuConvAlgorithm::kIm2ColGemm:
+        if constexpr (std::is_same<T, float>::value ||
+                      std::is_same<T, double>::value) {
+          Im2ColConvFunctor<T, T, T, FastGemmFunctor<T, T, T>>()(
+              ctx, input.flat<T>().data(), dimensions.batch,
+              dimensions.input_rows, dimensions.input_cols,
+              dimensions.in_depth, filter.flat<T>().data(),
+              dimensions.filter_rows, dimensions.filter_cols,
+              dimensions.out_depth, dimensions.stride_rows,
+              dimensions.stride_cols, params.padding, output->flat<T>().data(),
+              dimensions.out_rows, dimensions.out_cols);
+          return;
+        }
+        break;
+      case CpuConvAlgorithm::kDeepConv2D:
+        if constexpr (std::is_same<T, float>::value) {
+          LaunchDeepConvOp<CPUDevice, float>::Launch(
+              ctx, input, filter, dimensions.batch, dimensions.input_rows,
+              dimensions.input_cols, dimensions.in_depth,
+              dimensions.filter_rows, dimensions.filter_cols,
+              dimensions.pad_rows_before, dimensions.pad_cols_before,
+              dimensions.out_rows, dimensions.out_cols, dimensions.out_depth,
+              output);
+          return;
+        }
+        break;
+      case CpuConvAlgorithm::kSpatialConvolution:
+        break;
+    }
+    LaunchConv2DOp<CPUDevice, T>()(
+        ctx, /*use_cudnn=*/false, /*cudnn_use_autotune=*/false, input, filter,
+        dimensions.dilation_rows, dimensions.dilation_cols,
+        dimensions.stride_rows, dimensions.stride_cols, params.padding,
+        params.explicit_paddings, output, params.data_format);
+  }
+};
+
 #define TF_REQUIRES(EXP, STATUS)                \
   do {                                          \
     if (!TF_PREDICT_TRUE(EXP)) return (STATUS); \
@@ -661,6 +836,7 @@ class Conv2DOp : public BinaryOp<T> {
 
     OP_REQUIRES_OK(context, context->GetAttr("use_cudnn_on_gpu", &use_cudnn_));
     cudnn_use_autotune_ = CudnnUseAutotune();
+    cpu_conv_use_autotune_ = CpuConvUseAutotune();
   }
 
   void Compute(OpKernelContext* context) override {
@@ -725,6 +901,12 @@ class Conv2DOp : public BinaryOp<T> {
     }
 #endif
 
+    if (cpu_conv_use_autotune_ &&
+        LaunchCpuConvAutotunedOp<Device, T>::Run(context, input, filter,
+                                                 params_, dimensions, output)) {
+      return;
+    }
+
     if (params_.padding != EXPLICIT &&
         LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, dimensions.batch, dimensions.input_rows,
@@ -747,6 +929,7 @@ class Conv2DOp : public BinaryOp<T> {
   Conv2DParameters params_;
   bool use_cudnn_;
   bool cudnn_use_autotune_;
+  bool cpu_conv_use_autotune_;
 
   LaunchConv2DOp<Device, T> launcher_;
 
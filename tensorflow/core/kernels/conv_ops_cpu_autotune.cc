@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/conv_ops_cpu_autotune.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+string CpuConvAlgorithmName(CpuConvAlgorithm algorithm) {
+  switch (algorithm) {
+    case CpuConvAlgorithm::kSpatialConvolution:
+      return "SpatialConvolution";
+    case CpuConvAlgorithm::kIm2ColGemm:
+      return "Im2ColGemm";
+    case CpuConvAlgorithm::kDeepConv2D:
+      return "DeepConv2D";
+  }
+  return "Unknown";
+}
+
+CpuConvParameters::CpuConvParameters(DataType dtype,
+                                     const Conv2DDimensions& dimensions,
+                                     Padding padding, int num_threads)
+    : dtype_(dtype),
+      padding_(padding),
+      values_({dimensions.batch, dimensions.input_rows, dimensions.input_cols,
+               dimensions.in_depth, dimensions.filter_rows,
+               dimensions.filter_cols, dimensions.patch_depth,
+               dimensions.out_depth, dimensions.stride_rows,
+               dimensions.stride_cols, dimensions.dilation_rows,
+               dimensions.dilation_cols, dimensions.pad_rows_before,
+               dimensions.pad_cols_before, num_threads}) {}
+
+string CpuConvParameters::ToString() const {
+  const char* padding = padding_ == SAME    ? "SAME"
+                        : padding_ == VALID ? "VALID"
+                                            : "EXPLICIT";
+  return absl::StrCat(DataTypeString(dtype_), ", ", padding, ", [",
+                      absl::StrJoin(values_, ", "), "]");
+}
+
+CpuConvAutotuneMap* CpuConvAutotuneMap::Global() {
+  static CpuConvAutotuneMap* map = new CpuConvAutotuneMap;
+  return map;
+}
+
+bool CpuConvAutotuneMap::Find(const CpuConvParameters& params,
+                              CpuConvAlgorithm* algorithm) const {
+  mutex_lock lock(mu_);
+  auto it = map_.find(params);
+  if (it == map_.end()) return false;
+  *algorithm = it->second;
+  return true;
+}
+
+void CpuConvAutotuneMap::Insert(const CpuConvParameters& params,
+                                CpuConvAlgorithm algorithm) {
+  mutex_lock lock(mu_);
+  VLOG(1) << "Conv2D autotuning selects " << CpuConvAlgorithmName(algorithm)
+          << " for " << params.ToString();
+  map_[params] = algorithm;
+}
+
+int64_t CpuConvAutotuneMap::GetMapSize() const {
+  mutex_lock lock(mu_);
+  return map_.size();
+}
+
+void CpuConvAutotuneMap::ClearMap() {
+  mutex_lock lock(mu_);
+  map_.clear();
+}
+
+bool CpuConvUseAutotune() {
+  bool value = false;
+  Status status = ReadBoolFromEnvVar("TF_CPU_CONV_USE_AUTOTUNE",
+                                     /*default_val=*/false, &value);
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+  }
+  return value;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,106 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CONV_OPS_CPU_AUTOTUNE_H_
+#define TENSORFLOW_CORE_KERNELS_CONV_OPS_CPU_AUTOTUNE_H_
+
+#include <array>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/conv_ops.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/padding.h"
+
+namespace tensorflow {
+
+// The implementations of Conv2D on CPU that can be selected by autotuning.
+enum class CpuConvAlgorithm {
+  // Eigen::SpatialConvolution, or a matrix multiplication for the shapes that
+  // the generic launcher reduces to one.
+  kSpatialConvolution,
+  // Im2ColConvFunctor from conv_ops_using_gemm.h, with FastGemmFunctor.
+  kIm2ColGemm,
+  // Winograd-based DeepConv2D from deep_conv2d.h.
+  kDeepConv2D,
+};
+
+string CpuConvAlgorithmName(CpuConvAlgorithm algorithm);
+
+// Uniquely identifies a Conv2D problem on CPU for the purpose of autotuning:
+// data type, shapes, strides, dilations, padding, and the number of threads
+// of the Eigen device that runs it, since the fastest algorithm differs
+// between single-threaded and multi-threaded execution.
+class CpuConvParameters {
+ public:
+  CpuConvParameters(DataType dtype, const Conv2DDimensions& dimensions,
+                    Padding padding, int num_threads);
+
+  bool operator==(const CpuConvParameters& other) const {
+    return dtype_ == other.dtype_ && padding_ == other.padding_ &&
+           values_ == other.values_;
+  }
+  bool operator!=(const CpuConvParameters& other) const {
+    return !(*this == other);
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const CpuConvParameters& params) {
+    return H::combine(std::move(h), params.dtype_, params.padding_,
+                      params.values_);
+  }
+
+  string ToString() const;
+
+ private:
+  DataType dtype_;
+  Padding padding_;
+  // batch, input_rows, input_cols, in_depth, filter_rows, filter_cols,
+  // patch_depth, out_depth, stride_rows, stride_cols, dilation_rows,
+  // dilation_cols, pad_rows_before, pad_cols_before, num_threads.
+  std::array<int64_t, 15> values_;
+};
+
+// Process-wide cache of the fastest CpuConvAlgorithm for each problem. The
+// first Conv2D with given CpuConvParameters measures the candidates and
+// inserts the winner, and later ones reuse it.
+class CpuConvAutotuneMap {
+ public:
+  static CpuConvAutotuneMap* Global();
+
+  bool Find(const CpuConvParameters& params, CpuConvAlgorithm* algorithm) const;
+  void Insert(const CpuConvParameters& params, CpuConvAlgorithm algorithm);
+
+  int64_t GetMapSize() const;
+  void ClearMap();
+
+ private:
+  mutable mutex mu_;
+  absl::flat_hash_map<CpuConvParameters, CpuConvAlgorithm> map_
+      TF_GUARDED_BY(mu_);
+};
+
+// Returns true if Conv2D on CPU should pick its algorithm by autotuning, as
+// requested by the environment variable TF_CPU_CONV_USE_AUTOTUNE. This is
+// off by default, since the algorithms round differently and the choice
+// depends on timing, so results are not reproducible from run to run.
+bool CpuConvUseAutotune();
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CONV_OPS_CPU_AUTOTUNE_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "tensorflow/cc/client/client_session.h"
 #include "tensorflow/cc/ops/const_op.h"
 #include "tensorflow/cc/ops/image_ops.h"
 #include "tensorflow/cc/ops/nn_ops.h"
@@ -27,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/conv_ops_cpu_autotune.h"
 #include "tensorflow/core/kernels/conv_ops_gpu.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
@@ -473,6 +475,83 @@ TEST_F(ConvOpTest, HandwrittenConv) { HandwrittenConv(); }
 
 TEST_F(ConvOpTest, AnisotropicStride) { AnisotropicStrides(); }
 
+// Runs a Conv2D on CPU, with or without autotuning of the algorithm.
+Tensor RunCpuConv2D(const Tensor& input, const Tensor& filter, int stride,
+                    const string& padding, bool use_autotune) {
+  setenv("TF_CPU_CONV_USE_AUTOTUNE", use_autotune ? "1" : "0",
+         1 /* replace */);
+  Scope root = Scope::NewRootScope().WithDevice("/device:CPU:0");
+  auto input_placeholder = ops::Placeholder(root, DT_FLOAT);
+  auto filter_placeholder = ops::Placeholder(root, DT_FLOAT);
+  auto conv = ops::Conv2D(root, input_placeholder, filter_placeholder,
+                          {1, stride, stride, 1}, padding);
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session.Run(
+      {{input_placeholder, input}, {filter_placeholder, filter}}, {conv},
+      &outputs));
+  unsetenv("TF_CPU_CONV_USE_AUTOTUNE");
+  return outputs[0];
+}
+
+TEST(CpuConvAutotuneTest, MatchesDefaultAlgorithm) {
+  struct TestCase {
+    int filter_size;
+    int stride;
+    string padding;
+  };
+  // Candidates are SpatialConvolution, Im2ColGemm, and DeepConv2D for 3x3
+  // filters with stride 1, and the first two for the other cases.
+  const std::vector<TestCase> test_cases = {
+      {3, 1, "SAME"}, {3, 1, "VALID"}, {5, 2, "VALID"}, {2, 2, "SAME"}};
+  CpuConvAutotuneMap::Global()->ClearMap();
+  for (const TestCase& test_case : test_cases) {
+    Tensor input(DT_FLOAT, TensorShape({2, 13, 11, 8}));
+    input.flat<float>().setRandom();
+    Tensor filter(DT_FLOAT, TensorShape({test_case.filter_size,
+                                         test_case.filter_size, 8, 16}));
+    filter.flat<float>().setRandom();
+
+    const Tensor expected =
+        RunCpuConv2D(input, filter, test_case.stride, test_case.padding,
+                     /*use_autotune=*/false);
+    // The first run measures the algorithms, and the second one uses the
+    // cached result.
+    for (int i = 0; i < 2; ++i) {
+      const Tensor output =
+          RunCpuConv2D(input, filter, test_case.stride, test_case.padding,
+                       /*use_autotune=*/true);
+      test::ExpectClose(expected, output, /*atol=*/1e-4, /*rtol=*/1e-4);
+    }
+  }
+  EXPECT_EQ(CpuConvAutotuneMap::Global()->GetMapSize(), test_cases.size());
+}
+
+TEST(CpuConvAutotuneTest, MapKeysOnThreadCount) {
+  Conv2DDimensions dimensions = {};
+  dimensions.batch = 1;
+  dimensions.input_rows = dimensions.input_cols = 32;
+  dimensions.in_depth = dimensions.patch_depth = 8;
+  dimensions.filter_rows = dimensions.filter_cols = 3;
+  dimensions.out_depth = 16;
+  dimensions.stride_rows = dimensions.stride_cols = 1;
+  dimensions.dilation_rows = dimensions.dilation_cols = 1;
+  const CpuConvParameters one_thread(DT_FLOAT, dimensions, SAME, 1);
+  const CpuConvParameters four_threads(DT_FLOAT, dimensions, SAME, 4);
+  EXPECT_NE(one_thread, four_threads);
+
+  CpuConvAutotuneMap map;
+  map.Insert(one_thread, CpuConvAlgorithm::kDeepConv2D);
+  map.Insert(four_threads, CpuConvAlgorithm::kIm2ColGemm);
+  CpuConvAlgorithm algorithm;
+  ASSERT_TRUE(map.Find(one_thread, &algorithm));
+  EXPECT_EQ(algorithm, CpuConvAlgorithm::kDeepConv2D);
+  ASSERT_TRUE(map.Find(four_threads, &algorithm));
+  EXPECT_EQ(algorithm, CpuConvAlgorithm::kIm2ColGemm);
+  EXPECT_FALSE(map.Find(CpuConvParameters(DT_DOUBLE, dimensions, SAME, 1),
+                        &algorithm));
+}
+
 template <typename T>
 class FusedConv2DOpTest : public OpsTestBase {
  protected:
@@ -0,0 +1,120 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
+#define TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <cstdint>
+
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/numbers.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+// Helpers shared by the DecodeCSV op and CsvDataset to scan and convert CSV
+// fields.
+
+namespace tensorflow {
+namespace csv {
+
+// Returns a pointer to the first character in [begin, end) that may end an
+// unquoted field: `delim`, '\n', '\r', or '"' if `use_quote_delim` is true.
+// Returns `end` if there is none. Scans 16 bytes at a time when SSE2 is
+// available.
+inline const char* FindSpecialChar(const char* begin, const char* end,
+                                   char delim, bool use_quote_delim) {
+  const char quote = use_quote_delim ? '"' : delim;
+#ifdef __SSE2__
+  const __m128i delim_v = _mm_set1_epi8(delim);
+  const __m128i quote_v = _mm_set1_epi8(quote);
+  const __m128i cr_v = _mm_set1_epi8('\r');
+  const __m128i lf_v = _mm_set1_epi8('\n');
+  while (end - begin >= 16) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+    const __m128i matches = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, delim_v),
+                     _mm_cmpeq_epi8(chunk, quote_v)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, cr_v), _mm_cmpeq_epi8(chunk, lf_v)));
+    const uint32 mask = _mm_movemask_epi8(matches);
+    if (mask != 0) return begin + Log2Floor(mask & -mask);
+    begin += 16;
+  }
+#endif
+  for (; begin < end; ++begin) {
+    const char c = *begin;
+    if (c == delim || c == quote || c == '\n' || c == '\r') return begin;
+  }
+  return end;
+}
+
+namespace internal {
+
+// Parses an optionally negative integer of at most `kMaxDigits` digits, which
+// cannot overflow `T`. Returns false for anything else, including leading or
+// trailing spaces, which the caller then hands to the general parser.
+template <typename T, int kMaxDigits>
+inline bool ParseShortInteger(StringPiece field, T* value) {
+  const char* p = field.data();
+  const char* const end = p + field.size();
+  const bool negative = p < end && *p == '-';
+  if (negative) ++p;
+  if (p == end || end - p > kMaxDigits) return false;
+  T result = 0;
+  for (; p < end; ++p) {
+    const unsigned digit = static_cast<unsigned char>(*p) - '0';
+    if (digit > 9) return false;
+    result = result * 10 + static_cast<T>(digit);
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+}  // namespace internal
+
+// Converts a non-empty CSV field to a value. Returns false if `field` is not a
+// valid value of the type. Accepts exactly what `strings::safe_strto*` accept.
+inline bool ParseValue(StringPiece field, int32* value) {
+  return internal::ParseShortInteger<int32, 9>(field, value) ||
+         strings::safe_strto32(field, value);
+}
+
+inline bool ParseValue(StringPiece field, int64_t* value) {
+  return internal::ParseShortInteger<int64_t, 18>(field, value) ||
+         strings::safe_strto64(field, value);
+}
+
+inline bool ParseValue(StringPiece field, float* value) {
+  return strings::safe_strtof(field, value);
+}
+
+inline bool ParseValue(StringPiece field, double* value) {
+  return strings::safe_strtod(field, value);
+}
+
+inline bool ParseValue(StringPiece field, tstring* value) {
+  value->assign(field.data(), field.size());
+  return true;
+}
+
+}  // namespace csv
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_CSV_PARSING_H_
@@ -134,6 +134,8 @@ class BatchDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     const int64 cardinality = Cardinality();
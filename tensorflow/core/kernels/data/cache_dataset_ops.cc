@@ -28,11 +28,14 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/cache_ops.h"
 #include "tensorflow/core/kernels/data/iterator_ops.h"
+#include "tensorflow/core/kernels/data/mapped_cache_file.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/numbers.h"
 #include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -46,6 +49,7 @@ namespace data {
 /* static */ constexpr const char* const CacheDatasetOp::kFileName;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputTypes;
 /* static */ constexpr const char* const CacheDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const CacheDatasetOp::kFileFormat;
 
 namespace {
 
@@ -54,6 +58,9 @@ constexpr char kPaddingSizeStrFormat[] = "%zu";
 constexpr char kFileDatasetPrefix[] = "File";
 constexpr char kMode[] = "Mode";
 constexpr char kLockFileSuffix[] = ".lockfile";
+constexpr char kMappedCacheSuffix[] = ".mcache";
+constexpr char kMappedFileFormat[] = "mapped";
+constexpr char kBundleFileFormat[] = "bundle";
 constexpr char kIterationCompleted[] = "iteration_completed";
 constexpr char kCurIndex[] = "cur_index";
 constexpr char kShardId[] = "shard_id";
@@ -134,10 +141,11 @@ class PartialCache {
 class CacheDatasetOp::FileDatasetBase : public DatasetBase {
  public:
   FileDatasetBase(OpKernelContext* ctx, const DatasetBase* input,
-                  string filename, Env* env)
+                  string filename, Env* env, bool mapped_file_format)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         filename_(std::move(filename)),
+        mapped_file_format_(mapped_file_format),
         env_(env),
         num_tensors_(input->output_dtypes().size()),
         tensor_index_padding_size_(StringPaddingSize(num_tensors_)),
@@ -185,10 +193,29 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
   }
 
  protected:
+  // Returns the attrs for `AsGraphDefInternal()`.
+  std::vector<std::pair<StringPiece, AttrValue>> FileFormatAttrs(
+      DatasetGraphDefBuilder* b) const {
+    if (!mapped_file_format_) return {};
+    AttrValue file_format;
+    b->BuildAttrValue(string(kMappedFileFormat), &file_format);
+    return {std::make_pair(kFileFormat, file_format)};
+  }
+
   const DatasetBase* const input_;
   const tstring filename_;
+  // Whether the cache is written with `MappedCacheFileWriter` instead of
+  // `BundleWriter`.
+  const bool mapped_file_format_;
 
  private:
+  // Returns the name of the file whose existence marks the cache, or the
+  // cache shard, with prefix `prefix` as complete.
+  string CompletedFilename(const string& prefix) const {
+    return mapped_file_format_ ? strings::StrCat(prefix, kMappedCacheSuffix)
+                               : MetaFilename(prefix);
+  }
+
   static size_t StringPaddingSize(size_t num_tensors) {
     return strings::Printf(kPaddingSizeStrFormat, num_tensors - 1).size();
   }
@@ -203,7 +230,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
     explicit FileIterator(const Params& params)
         : DatasetIterator<FileDatasetBase>(params) {
       if (params.dataset->env_
-              ->FileExists(MetaFilename(params.dataset->filename_))
+              ->FileExists(
+                  params.dataset->CompletedFilename(params.dataset->filename_))
               .ok()) {
         mode_ = Mode::read;
       } else {
@@ -246,13 +274,14 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       }
       if (mode_ == Mode::write &&
           dataset()
-              ->env_->FileExists(MetaFilename(dataset()->filename_))
+              ->env_
+              ->FileExists(dataset()->CompletedFilename(dataset()->filename_))
               .ok()) {
         // This could happen if the cache was completely written after the
         // checkpoint was saved.
         LOG(WARNING)
             << "It looks like the cache was already completely written("
-            << MetaFilename(dataset()->filename_)
+            << dataset()->CompletedFilename(dataset()->filename_)
             << ") after the last checkpoint was saved. Attempting to read "
             << "the cache instead of continuing to write. If this is a "
             << "mistake, please remove the above file and try running again.";
@@ -292,7 +321,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
             iteration_completed_(false) {}
 
       ~FileWriterIterator() override {
-        if (!dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
+        if (!dataset()
+                 ->env_->FileExists(dataset()->CompletedFilename(filename_))
+                 .ok()) {
           LOG(WARNING) << kIncompleteCacheErrorMessage;
           std::vector<string> cache_files;
           Status s = dataset()->env_->GetMatchingPaths(
@@ -325,7 +356,9 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         if (*end_of_sequence) {
           return OkStatus();
         }
-        TF_RETURN_IF_ERROR(writer_->status());
+        if (!dataset()->mapped_file_format_) {
+          TF_RETURN_IF_ERROR(writer_->status());
+        }
         if (cur_index_ >= kMaxItems) {
           // As a courtesy, close the [truncated] cache file.
           Status s = Finish();
@@ -350,11 +383,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
               "Expected ",
               dataset()->num_tensors_, " got: ", out_tensors->size());
         }
-        size_t tensor_index = 0;
-        for (const Tensor& t : *out_tensors) {
-          DCHECK_LT(tensor_index, dataset()->num_tensors_);
-          string key = dataset()->FormatName(cur_index_, tensor_index++);
-          TF_RETURN_IF_ERROR(writer_->Add(key, t));
+        if (dataset()->mapped_file_format_) {
+          TF_RETURN_IF_ERROR(mapped_writer_->Add(*out_tensors));
+        } else {
+          size_t tensor_index = 0;
+          for (const Tensor& t : *out_tensors) {
+            DCHECK_LT(tensor_index, dataset()->num_tensors_);
+            string key = dataset()->FormatName(cur_index_, tensor_index++);
+            TF_RETURN_IF_ERROR(writer_->Add(key, t));
+          }
         }
         if (*end_of_sequence) {
           TF_RETURN_IF_ERROR(Finish());
@@ -388,8 +425,8 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // about flushing the current shard. This ensures that we never write
         // empty shards.
         if (lockfile_created_) {
-          // Flush the current bundle.
-          TF_RETURN_IF_ERROR(writer_->Finish());
+          // Flush the current shard.
+          TF_RETURN_IF_ERROR(FinishShard());
 
           // Note: We do not delete the lockfile here. We keep lockfiles of
           // all shards around until the entire cache has been written to
@@ -438,8 +475,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         }
         filename_ = strings::StrCat(dataset()->filename_, "_", shard_id_);
         lockfile_ = strings::StrCat(filename_, kLockFileSuffix);
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
-        return OkStatus();
+        return CreateShardWriter();
       }
 
      private:
@@ -458,11 +494,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
 
         // 1. Check that a checkpoint for the shard has not already been
         // written.
-        if (dataset()->env_->FileExists(MetaFilename(filename_)).ok()) {
-          return errors::AlreadyExists("Existing cache files found: \n",
-                                       MetaFilename(filename_), "\n",
-                                       DataFilename(filename_, 0, 1), "\n",
-                                       "To continue delete the above files.");
+        if (dataset()
+                ->env_->FileExists(dataset()->CompletedFilename(filename_))
+                .ok()) {
+          return errors::AlreadyExists(
+              "Existing cache files found: \n",
+              dataset()->CompletedFilename(filename_), "\n",
+              dataset()->mapped_file_format_ ? ""
+                                             : DataFilename(filename_, 0, 1),
+              "\n", "To continue delete the above files.");
         }
 
         // 2. Check that there isn't a concurrent iterator that is writing
@@ -500,15 +540,55 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
         // conditions are not met since BundleWriter's constructor creates
         // new temp files which can delete the temp files created by a
         // BundleWriter in another Session.
-        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        TF_RETURN_IF_ERROR(CreateShardWriter());
         lockfile_created_ = true;
         return OkStatus();
       }
 
+      Status CreateShardWriter() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (dataset()->mapped_file_format_) {
+          return MappedCacheFileWriter::Create(
+              dataset()->env_, dataset()->CompletedFilename(filename_),
+              &mapped_writer_);
+        }
+        writer_ = std::make_unique<BundleWriter>(dataset()->env_, filename_);
+        return OkStatus();
+      }
+
+      Status FinishShard() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (dataset()->mapped_file_format_) {
+          return mapped_writer_->Finish();
+        }
+        return writer_->Finish();
+      }
+
       Status Finish() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         iteration_completed_ = true;
-        // Flush the current bundle.
-        TF_RETURN_IF_ERROR(writer_->Finish());
+        // Flush the current shard.
+        TF_RETURN_IF_ERROR(FinishShard());
+        if (dataset()->mapped_file_format_) {
+          // Mapped cache shards are read in place. The number of shards is
+          // written last, marking the cache as complete.
+          const string completed_filename =
+              dataset()->CompletedFilename(dataset()->filename_);
+          const string temp_filename =
+              strings::StrCat(completed_filename, ".tmp");
+          TF_RETURN_IF_ERROR(WriteStringToFile(
+              dataset()->env_, temp_filename, strings::StrCat(shard_id_ + 1)));
+          TF_RETURN_IF_ERROR(
+              dataset()->env_->RenameFile(temp_filename, completed_filename));
+        } else {
+          TF_RETURN_IF_ERROR(MergeShards());
+        }
+        // Delete all lockfiles.
+        for (size_t i = 0; i <= shard_id_; ++i) {
+          TF_RETURN_IF_ERROR(dataset()->env_->DeleteFile(
+              strings::StrCat(dataset()->filename_, "_", i, kLockFileSuffix)));
+        }
+        return OkStatus();
+      }
+
+      Status MergeShards() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         // Merge all the bundles.
         // Currently there are `shard_id_ + 1` bundles, one for each
         // checkpoint. Each bundle has prefix <filename>_<id> where `id` is an
@@ -526,11 +606,6 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
           TF_RETURN_IF_ERROR(
               MergeBundles(dataset()->env_, prefixes, dataset()->filename_));
         }
-        // Delete all lockfiles.
-        for (size_t i = 0; i <= shard_id_; ++i) {
-          TF_RETURN_IF_ERROR(dataset()->env_->DeleteFile(
-              strings::StrCat(dataset()->filename_, "_", i, kLockFileSuffix)));
-        }
         return OkStatus();
       }
 
@@ -544,6 +619,7 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // `StrCat(dataset()->filename_, "_", shard_id_)`.
       string filename_;
       std::unique_ptr<BundleWriter> writer_ TF_GUARDED_BY(mu_);
+      std::unique_ptr<MappedCacheFileWriter> mapped_writer_ TF_GUARDED_BY(mu_);
       string lockfile_ TF_GUARDED_BY(mu_);
       bool lockfile_created_ TF_GUARDED_BY(mu_);
       bool iteration_completed_ TF_GUARDED_BY(mu_);
@@ -638,6 +714,97 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       bool iterator_restored_ TF_GUARDED_BY(mu_);
     };  // FileReaderIterator
 
+    // Reads a cache written in the mapped file format. The shards of the cache
+    // are mapped into memory, and tensors are returned without copies.
+    class MappedFileReaderIterator : public DatasetIterator<FileDatasetBase> {
+     public:
+      explicit MappedFileReaderIterator(const Params& params)
+          : DatasetIterator<FileDatasetBase>(params) {}
+
+      Status Initialize(IteratorContext* ctx) override {
+        mutex_lock l(mu_);
+        const string completed_filename =
+            dataset()->CompletedFilename(dataset()->filename_);
+        string contents;
+        TF_RETURN_IF_ERROR(
+            ReadFileToString(dataset()->env_, completed_filename, &contents));
+        int64_t num_shards;
+        if (!strings::safe_strto64(contents, &num_shards) || num_shards < 0) {
+          return errors::DataLoss("Corrupted cache file ", completed_filename,
+                                  ".");
+        }
+        std::vector<string> filenames;
+        for (int64_t i = 0; i < num_shards; ++i) {
+          filenames.push_back(dataset()->CompletedFilename(
+              strings::StrCat(dataset()->filename_, "_", i)));
+        }
+        return MappedCacheFileReader::OpenAll(dataset()->env_, filenames,
+                                              *ctx->runner(), &readers_);
+      }
+
+      Status GetNextInternal(IteratorContext* ctx,
+                             std::vector<Tensor>* out_tensors,
+                             bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        while (shard_ < readers_.size() &&
+               shard_index_ >= readers_[shard_]->num_elements()) {
+          ++shard_;
+          shard_index_ = 0;
+        }
+        if (shard_ == readers_.size()) {
+          *end_of_sequence = true;
+          return OkStatus();
+        }
+        *end_of_sequence = false;
+        TF_RETURN_IF_ERROR(readers_[shard_]->Read(shard_index_, out_tensors));
+        if (out_tensors->size() != dataset()->num_tensors_) {
+          return errors::DataLoss("Cache element has ", out_tensors->size(),
+                                  " components, expected ",
+                                  dataset()->num_tensors_, ".");
+        }
+        ++shard_index_;
+        ++cur_index_;
+        return OkStatus();
+      }
+
+     protected:
+      std::shared_ptr<model::Node> CreateNode(
+          IteratorContext* ctx, model::Node::Args args) const override {
+        return model::MakeKnownRatioNode(std::move(args),
+                                         /*ratio=*/1);
+      }
+
+      Status SaveInternal(SerializationContext* ctx,
+                          IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar(full_name(kCurIndex), cur_index_);
+      }
+
+      Status RestoreInternal(IteratorContext* ctx,
+                             IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar(full_name(kCurIndex), &cur_index_));
+        shard_ = 0;
+        shard_index_ = cur_index_;
+        while (shard_ < readers_.size() &&
+               shard_index_ >= readers_[shard_]->num_elements()) {
+          shard_index_ -= readers_[shard_]->num_elements();
+          ++shard_;
+        }
+        return OkStatus();
+      }
+
+     private:
+      mutex mu_;
+      std::vector<std::unique_ptr<MappedCacheFileReader>> readers_
+          TF_GUARDED_BY(mu_);
+      // Index of the next element, overall and in the current shard.
+      int64_t cur_index_ TF_GUARDED_BY(mu_) = 0;
+      size_t shard_ TF_GUARDED_BY(mu_) = 0;
+      int64_t shard_index_ TF_GUARDED_BY(mu_) = 0;
+    };  // MappedFileReaderIterator
+
     Status InitializeIterator(IteratorContext* ctx)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       // We intentionally use the same prefix for both `FileReaderIterator` and
@@ -650,9 +817,15 @@ class CacheDatasetOp::FileDatasetBase : public DatasetBase {
       // `cur_index`.
       switch (mode_) {
         case Mode::read:
-          iterator_ =
-              std::make_unique<FileReaderIterator>(FileReaderIterator::Params{
-                  dataset(), strings::StrCat(prefix(), kImpl)});
+          if (dataset()->mapped_file_format_) {
+            iterator_ = std::make_unique<MappedFileReaderIterator>(
+                MappedFileReaderIterator::Params{
+                    dataset(), strings::StrCat(prefix(), kImpl)});
+          } else {
+            iterator_ = std::make_unique<FileReaderIterator>(
+                FileReaderIterator::Params{dataset(),
+                                           strings::StrCat(prefix(), kImpl)});
+          }
           break;
         case Mode::write:
           iterator_ =
@@ -689,7 +862,8 @@ class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
     TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph));
     Node* filename = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename));
-    TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph, filename}, output));
+    TF_RETURN_IF_ERROR(b->AddDataset(this, {input_graph, filename},
+                                     FileFormatAttrs(b), output));
     return OkStatus();
   }
 };
@@ -697,9 +871,9 @@ class CacheDatasetOp::FileDataset : public CacheDatasetOp::FileDatasetBase {
 class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDatasetBase {
  public:
   explicit FileDatasetV2(OpKernelContext* ctx, const DatasetBase* input,
-                         string filename, Env* env,
+                         string filename, Env* env, bool mapped_file_format,
                          const Tensor& resource_handle)
-      : FileDatasetBase(ctx, input, filename, env),
+      : FileDatasetBase(ctx, input, filename, env, mapped_file_format),
         resource_handle_(resource_handle) {}
 
  protected:
@@ -712,8 +886,9 @@ class CacheDatasetOp::FileDatasetV2 : public CacheDatasetOp::FileDatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(filename_, &filename_node));
     Node* resource_handle_node = nullptr;
     TF_RETURN_IF_ERROR(b->AddTensor(resource_handle_, &resource_handle_node));
-    TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {input_node, filename_node, resource_handle_node}, output));
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {input_node, filename_node, resource_handle_node},
+                      FileFormatAttrs(b), output));
     return OkStatus();
   }
 
@@ -1112,7 +1287,18 @@ class CacheDatasetOp::MemoryDatasetV2
 
 CacheDatasetOp::CacheDatasetOp(OpKernelConstruction* ctx)
     : UnaryDatasetOpKernel(ctx),
-      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {}
+      op_version_(ctx->def().op() == kCacheDataset ? 1 : 2) {
+  if (ctx->HasAttr(kFileFormat)) {
+    string file_format;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kFileFormat, &file_format));
+    OP_REQUIRES(
+        ctx,
+        file_format == kMappedFileFormat || file_format == kBundleFileFormat,
+        errors::InvalidArgument("Unsupported cache file format: ",
+                                file_format));
+    mapped_file_format_ = file_format == kMappedFileFormat;
+  }
+}
 
 void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                  DatasetBase** output) {
@@ -1161,10 +1347,11 @@ void CacheDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     }
   } else {
     if (op_version_ == 2) {
-      *output =
-          new FileDatasetV2(ctx, input, filename, ctx->env(), ctx->input(2));
+      *output = new FileDatasetV2(ctx, input, filename, ctx->env(),
+                                  mapped_file_format_, ctx->input(2));
     } else {
-      *output = new FileDataset(ctx, input, filename, ctx->env());
+      *output = new FileDataset(ctx, input, filename, ctx->env(),
+                                mapped_file_format_);
     }
   }
 }
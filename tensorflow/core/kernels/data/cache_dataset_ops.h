@@ -30,6 +30,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kFileName = "filename";
   static constexpr const char* const kOutputTypes = "output_types";
   static constexpr const char* const kOutputShapes = "output_shapes";
+  // Selects the format of file caches: "bundle" (the default) for tensor
+  // bundles, or "mapped" for the format of `MappedCacheFileWriter`.
+  static constexpr const char* const kFileFormat = "_file_format";
 
   explicit CacheDatasetOp(OpKernelConstruction* ctx);
 
@@ -44,6 +47,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
   class MemoryDatasetV2;
 
   const int op_version_;
+  bool mapped_file_format_ = false;
 };
 
 }  // namespace data
@@ -0,0 +1,173 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/device_element_stager.h"
+
+#include <cstring>
+
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+
+namespace tensorflow {
+namespace data {
+
+int64_t ComputeStagingLayout(const std::vector<Tensor>& element,
+                             std::vector<int64_t>* offsets) {
+  constexpr int64_t kAlignment = Allocator::kAllocatorAlignment;
+  offsets->clear();
+  offsets->reserve(element.size());
+  int64_t size = 0;
+  for (const Tensor& component : element) {
+    if (!DataTypeCanUseMemcpy(component.dtype())) {
+      offsets->push_back(-1);
+      continue;
+    }
+    offsets->push_back(size);
+    size += (component.TotalBytes() + kAlignment - 1) / kAlignment * kAlignment;
+  }
+  return size;
+}
+
+/* static */ Status DeviceElementStager::Create(
+    Device* device, std::unique_ptr<DeviceElementStager>* stager) {
+  const DeviceBase::AcceleratorDeviceInfo* device_info =
+      device->tensorflow_accelerator_device_info();
+  if (device_info == nullptr || device_info->default_context == nullptr) {
+    return errors::InvalidArgument("Device ", device->name(),
+                                   " does not support staging elements.");
+  }
+  AllocatorAttributes host_attr;
+  host_attr.set_on_host(true);
+  host_attr.set_gpu_compatible(true);
+  stager->reset(new DeviceElementStager(
+      device, device_info->default_context, device->GetAllocator(host_attr),
+      device->GetAllocator(AllocatorAttributes())));
+  return OkStatus();
+}
+
+Status DeviceElementStager::Stage(const std::vector<Tensor>& host_element,
+                                  std::vector<Tensor>* device_element) {
+  profiler::TraceMe traceme("DeviceElementStager::Stage");
+  std::vector<int64_t> offsets;
+  const int64_t num_bytes = ComputeStagingLayout(host_element, &offsets);
+  device_element->clear();
+  device_element->reserve(host_element.size());
+  if (num_bytes == 0) {
+    *device_element = host_element;
+    return OkStatus();
+  }
+
+  Tensor staging_buffer = GetStagingBuffer(num_bytes);
+  if (!staging_buffer.IsInitialized()) {
+    return errors::ResourceExhausted("Failed to allocate ", num_bytes,
+                                     " bytes of host memory to stage an "
+                                     "element for ",
+                                     device_->name(), ".");
+  }
+  char* staging_data = static_cast<char*>(staging_buffer.data());
+  for (int i = 0; i < host_element.size(); ++i) {
+    if (offsets[i] < 0) continue;
+    const StringPiece data = host_element[i].tensor_data();
+    std::memcpy(staging_data + offsets[i], data.data(), data.size());
+  }
+
+  Tensor device_buffer(device_allocator_, DT_UINT8, TensorShape({num_bytes}));
+  if (!device_buffer.IsInitialized()) {
+    ReturnStagingBuffer(std::move(staging_buffer));
+    return errors::ResourceExhausted("Failed to allocate ", num_bytes,
+                                     " bytes on ", device_->name(),
+                                     " to stage an element.");
+  }
+  // The staging buffer may be larger than the element. Only copy the part in
+  // use.
+  Tensor staged = staging_buffer.Slice(0, num_bytes);
+  Notification done;
+  Status status;
+  device_context_->CopyCPUTensorToDevice(&staged, device_, &device_buffer,
+                                         [&done, &status](const Status& s) {
+                                           status = s;
+                                           done.Notify();
+                                         });
+  done.WaitForNotification();
+  staged = Tensor();
+  ReturnStagingBuffer(std::move(staging_buffer));
+  TF_RETURN_IF_ERROR(status);
+
+  for (int i = 0; i < host_element.size(); ++i) {
+    const Tensor& component = host_element[i];
+    if (offsets[i] < 0) {
+      device_element->push_back(component);
+      continue;
+    }
+    const int64_t size = component.TotalBytes();
+    Tensor view;
+    TF_RETURN_IF_ERROR(
+        view.BitcastFrom(device_buffer.Slice(offsets[i], offsets[i] + size),
+                         component.dtype(), component.shape()));
+    device_element->push_back(std::move(view));
+  }
+  return OkStatus();
+}
+
+int DeviceElementStager::num_pooled_buffers() const {
+  mutex_lock l(mu_);
+  return staging_buffers_.size();
+}
+
+Tensor DeviceElementStager::GetStagingBuffer(int64_t num_bytes) {
+  {
+    mutex_lock l(mu_);
+    // Uses the smallest pooled buffer that is large enough.
+    int best = -1;
+    for (int i = 0; i < staging_buffers_.size(); ++i) {
+      const int64_t size = staging_buffers_[i].NumElements();
+      if (size >= num_bytes &&
+          (best < 0 || size < staging_buffers_[best].NumElements())) {
+        best = i;
+      }
+    }
+    if (best >= 0) {
+      Tensor buffer = std::move(staging_buffers_[best]);
+      staging_buffers_.erase(staging_buffers_.begin() + best);
+      return buffer;
+    }
+  }
+  return Tensor(host_allocator_, DT_UINT8, TensorShape({num_bytes}));
+}
+
+void DeviceElementStager::ReturnStagingBuffer(Tensor buffer) {
+  mutex_lock l(mu_);
+  if (staging_buffers_.size() < kMaxPooledBuffers) {
+    staging_buffers_.push_back(std::move(buffer));
+    return;
+  }
+  // Replaces the smallest pooled buffer, so that the pool adapts to the
+  // largest elements.
+  int smallest = 0;
+  for (int i = 1; i < staging_buffers_.size(); ++i) {
+    if (staging_buffers_[i].NumElements() <
+        staging_buffers_[smallest].NumElements()) {
+      smallest = i;
+    }
+  }
+  if (staging_buffers_[smallest].NumElements() < buffer.NumElements()) {
+    staging_buffers_[smallest] = std::move(buffer);
+  }
+}
+
+}  // namespace data
+}  // namespace tensorflow
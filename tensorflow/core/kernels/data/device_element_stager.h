@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_DEVICE_ELEMENT_STAGER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_DEVICE_ELEMENT_STAGER_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+class Device;
+class DeviceContext;
+
+namespace data {
+
+// Computes where each component of `element` is placed in a staging buffer.
+// Components whose type can be copied with `memcpy` are packed at offsets
+// aligned to `Allocator::kAllocatorAlignment`. Other components are not staged
+// and get an offset of -1. Returns the size of the staging buffer.
+int64_t ComputeStagingLayout(const std::vector<Tensor>& element,
+                             std::vector<int64_t>* offsets);
+
+// Copies dataset elements from host memory to an accelerator device.
+//
+// The components of an element are packed into a staging buffer in pinned
+// host memory, which is copied to the device with a single asynchronous copy
+// on the host-to-device stream of the device. The outputs are views of the
+// device buffer. Staging buffers are pooled and reused across elements.
+//
+// This class is thread-safe.
+class DeviceElementStager {
+ public:
+  // Maximum number of unused staging buffers kept in the pool.
+  static constexpr int kMaxPooledBuffers = 4;
+
+  // Returns an error if `device` does not support copies from host memory.
+  static Status Create(Device* device,
+                       std::unique_ptr<DeviceElementStager>* stager);
+
+  // Copies `host_element` to the device, blocking until the copy completes.
+  // Components that cannot be staged are returned unchanged.
+  Status Stage(const std::vector<Tensor>& host_element,
+               std::vector<Tensor>* device_element) TF_LOCKS_EXCLUDED(mu_);
+
+  int num_pooled_buffers() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  DeviceElementStager(Device* device, DeviceContext* device_context,
+                      Allocator* host_allocator, Allocator* device_allocator)
+      : device_(device),
+        device_context_(device_context),
+        host_allocator_(host_allocator),
+        device_allocator_(device_allocator) {}
+
+  // Returns a pooled staging buffer of at least `num_bytes` bytes, or
+  // allocates a new one.
+  Tensor GetStagingBuffer(int64_t num_bytes) TF_LOCKS_EXCLUDED(mu_);
+  void ReturnStagingBuffer(Tensor buffer) TF_LOCKS_EXCLUDED(mu_);
+
+  Device* const device_;
+  DeviceContext* const device_context_;
+  Allocator* const host_allocator_;
+  Allocator* const device_allocator_;
+
+  mutable mutex mu_;
+  std::vector<Tensor> staging_buffers_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_DEVICE_ELEMENT_STAGER_H_
@@ -0,0 +1,69 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/device_element_stager.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/framework/device.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+TEST(ComputeStagingLayoutTest, AlignsComponents) {
+  constexpr int64_t kAlignment = Allocator::kAllocatorAlignment;
+  std::vector<Tensor> element = {
+      test::AsTensor<float>({1.0, 2.0, 3.0}),
+      test::AsTensor<tstring>({"a", "b"}),
+      Tensor(DT_INT64, TensorShape({0})),
+      test::AsTensor<int32>(std::vector<int32>(kAlignment, 0)),
+      test::AsScalar<int64_t>(7),
+  };
+  std::vector<int64_t> offsets;
+  const int64_t size = ComputeStagingLayout(element, &offsets);
+  ASSERT_EQ(offsets.size(), element.size());
+  EXPECT_EQ(offsets[0], 0);
+  // Strings cannot be staged.
+  EXPECT_EQ(offsets[1], -1);
+  EXPECT_EQ(offsets[2], kAlignment);
+  EXPECT_EQ(offsets[3], kAlignment);
+  EXPECT_EQ(offsets[4], kAlignment + 4 * kAlignment);
+  EXPECT_EQ(size, 6 * kAlignment);
+}
+
+TEST(ComputeStagingLayoutTest, NothingToStage) {
+  std::vector<Tensor> element = {test::AsScalar<tstring>("a")};
+  std::vector<int64_t> offsets;
+  EXPECT_EQ(ComputeStagingLayout(element, &offsets), 0);
+  EXPECT_EQ(offsets, std::vector<int64_t>({-1}));
+}
+
+TEST(DeviceElementStagerTest, RequiresAcceleratorDevice) {
+  std::unique_ptr<Device> device = DeviceFactory::NewDevice(
+      "CPU", {}, "/job:localhost/replica:0/task:0");
+  std::unique_ptr<DeviceElementStager> stager;
+  Status s = DeviceElementStager::Create(device.get(), &stager);
+  EXPECT_TRUE(errors::IsInvalidArgument(s)) << s;
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,730 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDatasetType;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kInputDataset;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kOtherArguments;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBoundaries;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kBucketBatchSizes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddedShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPaddingValues;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kDropRemainder;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kElementLengthFunc;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kTarguments;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kPadToBucketBoundary;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kToutputTypes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kOutputShapes;
+/* static */ constexpr const char* const
+    BucketBySequenceLengthDatasetOp::kNumPaddedShapes;
+
+namespace {
+
+constexpr char kEndOfInput[] = "end_of_input";
+constexpr char kNumElements[] = "num_elements";
+
+// Maximum number of batch tensors kept per bucket and component by
+// `OutputPool`. This bounds the memory held by idle pooled tensors.
+constexpr int kMaxPooledBatches = 4;
+
+// Recycles the output batches of the buckets, so that producing a batch with
+// the same shape as an earlier one does not allocate. A pooled tensor is handed
+// out again only once its buffer is no longer referenced outside of the pool,
+// i.e. once the consumers of the batch that it was returned in have released
+// it.
+class OutputPool {
+ public:
+  explicit OutputPool(size_t num_slots) : slots_(num_slots) {}
+
+  // Returns a tensor with the given dtype and shape for `slot`.
+  Tensor Get(size_t slot, Allocator* allocator, DataType dtype,
+             const TensorShape& shape) TF_LOCKS_EXCLUDED(mu_) {
+    if (shape.num_elements() == 0) {
+      return Tensor(allocator, dtype, shape);
+    }
+    mutex_lock l(mu_);
+    std::vector<Tensor>& pooled = slots_[slot];
+    Tensor* unused = nullptr;
+    for (Tensor& tensor : pooled) {
+      if (!tensor.RefCountIsOne()) {
+        continue;
+      }
+      if (tensor.dtype() == dtype && tensor.shape() == shape) {
+        return tensor;
+      }
+      unused = &tensor;
+    }
+    Tensor tensor(allocator, dtype, shape);
+    if (pooled.size() < kMaxPooledBatches) {
+      pooled.push_back(tensor);
+    } else if (unused != nullptr) {
+      *unused = tensor;
+    }
+    return tensor;
+  }
+
+ private:
+  mutex mu_;
+  std::vector<std::vector<Tensor>> slots_ TF_GUARDED_BY(mu_);
+};
+
+// Checks that `element` fits in a slice of a batch padded to `padded_shape`.
+Status CheckElementFitsPaddedShape(const Tensor& element,
+                                   size_t component_index,
+                                   const PartialTensorShape& padded_shape) {
+  if (element.dims() != padded_shape.dims()) {
+    return errors::InvalidArgument(
+        "All elements in a batch must have the same rank as the padded shape "
+        "for component",
+        component_index, ": expected rank ", padded_shape.dims(),
+        " but got element with rank ", element.dims());
+  }
+  for (int dim = 0; dim < padded_shape.dims(); ++dim) {
+    if (padded_shape.dim_size(dim) != -1 &&
+        element.dim_size(dim) > padded_shape.dim_size(dim)) {
+      return errors::DataLoss(
+          "Attempted to pad to a smaller size than the input element.");
+    }
+  }
+  return OkStatus();
+}
+
+// Copies `element` into row `index` of `batch`, which has padded all
+// dimensions of its rows to at least the size of `element`.
+Status CopyElementToBatch(const Tensor& element, Tensor* batch, int64_t index) {
+  TensorShape row_shape = batch->shape();
+  row_shape.RemoveDim(0);
+  if (element.shape() == row_shape) {
+    return batch_util::CopyElementToSlice(element, batch, index);
+  }
+  return batch_util::CopyElementToLargerSlice(element, batch, index);
+}
+
+}  // namespace
+
+class BucketBySequenceLengthDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, const DatasetBase* input,
+          std::unique_ptr<CapturedFunction> captured_func,
+          std::vector<int64_t> bucket_boundaries,
+          std::vector<int64_t> bucket_batch_sizes,
+          std::vector<PartialTensorShape> padded_shapes,
+          std::vector<Tensor> padding_values, bool drop_remainder,
+          bool pad_to_bucket_boundary,
+          std::vector<PartialTensorShape> output_shapes)
+      : DatasetBase(DatasetContext(ctx)),
+        input_(input),
+        captured_func_(std::move(captured_func)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary),
+        output_shapes_(std::move(output_shapes)),
+        traceme_metadata_(
+            {{"num_buckets", strings::StrCat(bucket_batch_sizes_.size())},
+             {"drop_remainder", drop_remainder ? "true" : "false"},
+             {"pad_to_bucket_boundary",
+              pad_to_bucket_boundary ? "true" : "false"}}) {
+    input_->Ref();
+    // Resolves the padded shapes of each bucket. When padding to the bucket
+    // boundary, the unknown dimensions of the last bucket remain unknown, but
+    // no element is ever added to that bucket.
+    bucket_padded_shapes_.resize(bucket_batch_sizes_.size());
+    bucket_is_static_.resize(bucket_batch_sizes_.size());
+    for (size_t bucket = 0; bucket < bucket_batch_sizes_.size(); ++bucket) {
+      bool is_static = true;
+      for (const PartialTensorShape& padded_shape : padded_shapes_) {
+        PartialTensorShape shape = padded_shape;
+        for (int dim = 0; dim < shape.dims(); ++dim) {
+          if (shape.dim_size(dim) == -1 && pad_to_bucket_boundary_ &&
+              bucket < bucket_boundaries_.size()) {
+            shape.set_dim(dim, bucket_boundaries_[bucket] - 1);
+          }
+        }
+        is_static = is_static && shape.IsFullyDefined();
+        bucket_padded_shapes_[bucket].push_back(std::move(shape));
+      }
+      bucket_is_static_[bucket] = is_static;
+    }
+  }
+
+  ~Dataset() override { input_->Unref(); }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return std::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return output_shapes_;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal() const override {
+    int64_t n = input_->Cardinality();
+    if (n == kInfiniteCardinality) {
+      return n;
+    }
+    return kUnknownCardinality;
+  }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    inputs->push_back(input_);
+    return OkStatus();
+  }
+
+  Status CheckExternalState() const override {
+    TF_RETURN_IF_ERROR(captured_func_->CheckExternalState());
+    return input_->CheckExternalState();
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* input_graph_node = nullptr;
+    TF_RETURN_IF_ERROR(b->AddInputDataset(ctx, input_, &input_graph_node));
+
+    std::vector<Node*> other_arguments;
+    DataTypeVector other_arguments_types;
+    TF_RETURN_IF_ERROR(captured_func_->AddToGraph(ctx, b, &other_arguments,
+                                                  &other_arguments_types));
+
+    Node* bucket_boundaries = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_boundaries_, &bucket_boundaries));
+    Node* bucket_batch_sizes = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(bucket_batch_sizes_, &bucket_batch_sizes));
+
+    std::vector<Node*> padded_shapes;
+    padded_shapes.reserve(padded_shapes_.size());
+    for (const PartialTensorShape& padded_shape : padded_shapes_) {
+      Node* node;
+      Tensor t(DT_INT64, TensorShape({padded_shape.dims()}));
+      for (int i = 0; i < padded_shape.dims(); ++i) {
+        t.vec<int64_t>()(i) = padded_shape.dim_size(i);
+      }
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padded_shapes.push_back(node);
+    }
+
+    std::vector<Node*> padding_values;
+    padding_values.reserve(padding_values_.size());
+    for (const Tensor& t : padding_values_) {
+      Node* node;
+      TF_RETURN_IF_ERROR(b->AddTensor(t, &node));
+      padding_values.push_back(node);
+    }
+
+    Node* drop_remainder = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(drop_remainder_, &drop_remainder));
+
+    AttrValue element_length_func;
+    b->BuildAttrValue(captured_func_->func(), &element_length_func);
+    AttrValue other_arguments_types_attr;
+    b->BuildAttrValue(other_arguments_types, &other_arguments_types_attr);
+    AttrValue pad_to_bucket_boundary;
+    b->BuildAttrValue(pad_to_bucket_boundary_, &pad_to_bucket_boundary);
+    AttrValue output_types;
+    b->BuildAttrValue(output_dtypes(), &output_types);
+    AttrValue num_padded_shapes;
+    b->BuildAttrValue<int64_t>(padded_shapes_.size(), &num_padded_shapes);
+
+    TF_RETURN_IF_ERROR(b->AddDataset(
+        this,
+        {{0, input_graph_node},
+         {2, bucket_boundaries},
+         {3, bucket_batch_sizes},
+         {6, drop_remainder}},
+        {{1, other_arguments}, {4, padded_shapes}, {5, padding_values}},
+        {{kElementLengthFunc, element_length_func},
+         {kTarguments, other_arguments_types_attr},
+         {kPadToBucketBoundary, pad_to_bucket_boundary},
+         {kToutputTypes, output_types},
+         {kNumPaddedShapes, num_padded_shapes}},
+        output));
+    return OkStatus();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params),
+          buckets_(params.dataset->bucket_batch_sizes_.size()),
+          output_pool_(params.dataset->bucket_batch_sizes_.size() *
+                       params.dataset->padded_shapes_.size()) {}
+
+    Status Initialize(IteratorContext* ctx) override {
+      TF_RETURN_IF_ERROR(
+          dataset()->input_->MakeIterator(ctx, this, prefix(), &input_impl_));
+      return dataset()->captured_func_->Instantiate(ctx, &instantiated_func_);
+    }
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      mutex_lock l(mu_);
+      while (input_impl_) {
+        std::vector<Tensor> element;
+        bool end_of_input = false;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &element, &end_of_input));
+        if (end_of_input) {
+          input_impl_.reset();
+          break;
+        }
+        int64_t bucket_id;
+        TF_RETURN_IF_ERROR(GetBucketId(ctx, element, &bucket_id));
+        TF_RETURN_IF_ERROR(AddToBucket(ctx, bucket_id, std::move(element)));
+        if (buckets_[bucket_id].num_elements ==
+            dataset()->bucket_batch_sizes_[bucket_id]) {
+          *end_of_sequence = false;
+          return FlushBucket(ctx, bucket_id, out_tensors);
+        }
+      }
+      // The input is exhausted, so flush the partial batches in the order of
+      // their buckets.
+      for (int64_t bucket_id = 0; bucket_id < buckets_.size(); ++bucket_id) {
+        if (buckets_[bucket_id].num_elements == 0) {
+          continue;
+        }
+        if (dataset()->drop_remainder_) {
+          buckets_[bucket_id] = Bucket();
+          continue;
+        }
+        *end_of_sequence = false;
+        return FlushBucket(ctx, bucket_id, out_tensors);
+      }
+      *end_of_sequence = true;
+      return OkStatus();
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeUnknownRatioNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      TF_RETURN_IF_ERROR(ctx->HandleCheckExternalStateStatus(
+          dataset()->captured_func_->CheckExternalState()));
+      mutex_lock l(mu_);
+      if (input_impl_) {
+        TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
+      } else {
+        TF_RETURN_IF_ERROR(writer->WriteScalar(full_name(kEndOfInput), ""));
+      }
+      for (size_t bucket_id = 0; bucket_id < buckets_.size(); ++bucket_id) {
+        const Bucket& bucket = buckets_[bucket_id];
+        const string name = full_name(strings::StrCat("buckets[", bucket_id));
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            strings::StrCat(name, "]_", kNumElements), bucket.num_elements));
+        // A static bucket stores its partial batch, other buckets store their
+        // elements.
+        for (size_t i = 0; i < bucket.batch.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteTensor(
+              strings::StrCat(name, "]_batch[", i, "]"), bucket.batch[i]));
+        }
+        for (size_t i = 0; i < bucket.elements.size(); ++i) {
+          for (size_t j = 0; j < bucket.elements[i].size(); ++j) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                strings::StrCat(name, "][", i, "][", j, "]"),
+                bucket.elements[i][j]));
+          }
+        }
+      }
+      return OkStatus();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      if (reader->Contains(full_name(kEndOfInput))) {
+        input_impl_.reset();
+      } else {
+        TF_RETURN_IF_ERROR(RestoreInput(ctx, reader, input_impl_));
+      }
+      const size_t num_components = dataset()->padded_shapes_.size();
+      for (size_t bucket_id = 0; bucket_id < buckets_.size(); ++bucket_id) {
+        Bucket& bucket = buckets_[bucket_id];
+        bucket = Bucket();
+        const string name = full_name(strings::StrCat("buckets[", bucket_id));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            strings::StrCat(name, "]_", kNumElements), &bucket.num_elements));
+        if (bucket.num_elements == 0) {
+          continue;
+        }
+        if (dataset()->bucket_is_static_[bucket_id]) {
+          bucket.batch.resize(num_components);
+          for (size_t i = 0; i < num_components; ++i) {
+            TF_RETURN_IF_ERROR(
+                reader->ReadTensor(ctx->flr(),
+                                   strings::StrCat(name, "]_batch[", i, "]"),
+                                   &bucket.batch[i]));
+          }
+          continue;
+        }
+        bucket.elements.resize(bucket.num_elements);
+        for (size_t i = 0; i < bucket.num_elements; ++i) {
+          bucket.elements[i].resize(num_components);
+          for (size_t j = 0; j < num_components; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                ctx->flr(), strings::StrCat(name, "][", i, "][", j, "]"),
+                &bucket.elements[i][j]));
+          }
+        }
+      }
+      return OkStatus();
+    }
+
+    TraceMeMetadata GetTraceMeMetadata() const override {
+      return dataset()->traceme_metadata_;
+    }
+
+   private:
+    // The elements of a bucket that have not been returned yet.
+    struct Bucket {
+      int64_t num_elements = 0;
+      // For buckets whose padded shapes are fully defined, the batch that the
+      // elements of the bucket are padded into as they arrive.
+      std::vector<Tensor> batch;
+      // For other buckets, the elements, which are padded when the batch is
+      // complete because the padded shape depends on all of them.
+      std::vector<std::vector<Tensor>> elements;
+    };
+
+    // Runs `element_length_func` on `element` and maps its result to the
+    // first bucket whose range contains it.
+    Status GetBucketId(IteratorContext* ctx, const std::vector<Tensor>& element,
+                       int64_t* bucket_id) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      std::vector<Tensor> length_func_output;
+      TF_RETURN_IF_ERROR(instantiated_func_->RunWithBorrowedArgs(
+          ctx, element, &length_func_output, model_node()));
+      if (length_func_output.size() != 1 ||
+          !TensorShapeUtils::IsScalar(length_func_output[0].shape()) ||
+          (length_func_output[0].dtype() != DT_INT32 &&
+           length_func_output[0].dtype() != DT_INT64)) {
+        return errors::InvalidArgument(
+            "`element_length_func` must return a scalar int32 or int64.");
+      }
+      const int64_t length =
+          length_func_output[0].dtype() == DT_INT32
+              ? length_func_output[0].scalar<int32>()()
+              : length_func_output[0].scalar<int64_t>()();
+      // Bucket `i` contains the lengths in `[boundaries[i - 1],
+      // boundaries[i])`, where the first and last buckets are bounded by the
+      // int32 range.
+      const std::vector<int64_t>& boundaries = dataset()->bucket_boundaries_;
+      const size_t num_buckets = boundaries.size() + 1;
+      for (size_t i = 0; i < num_buckets; ++i) {
+        const int64_t min = i == 0 ? kint32min : boundaries[i - 1];
+        const int64_t max = i == boundaries.size() ? kint32max : boundaries[i];
+        if (min <= length && length < max) {
+          *bucket_id = i;
+          break;
+        }
+        if (i == num_buckets - 1) {
+          return errors::InvalidArgument("Element length ", length,
+                                         " does not belong to any bucket.");
+        }
+      }
+      if (dataset()->pad_to_bucket_boundary_ &&
+          *bucket_id == boundaries.size()) {
+        return errors::InvalidArgument(
+            "When pad_to_bucket_boundary=True, elements must have length < "
+            "max(bucket_boundaries).");
+      }
+      return OkStatus();
+    }
+
+    Status AddToBucket(IteratorContext* ctx, int64_t bucket_id,
+                       std::vector<Tensor> element)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const std::vector<PartialTensorShape>& padded_shapes =
+          dataset()->bucket_padded_shapes_[bucket_id];
+      if (element.size() != padded_shapes.size()) {
+        return errors::InvalidArgument("Expected ", padded_shapes.size(),
+                                       " components but got ", element.size(),
+                                       ".");
+      }
+      for (size_t i = 0; i < element.size(); ++i) {
+        TF_RETURN_IF_ERROR(
+            CheckElementFitsPaddedShape(element[i], i, padded_shapes[i]));
+      }
+      Bucket& bucket = buckets_[bucket_id];
+      if (!dataset()->bucket_is_static_[bucket_id]) {
+        bucket.elements.push_back(std::move(element));
+        ++bucket.num_elements;
+        return OkStatus();
+      }
+      if (bucket.batch.empty()) {
+        std::vector<TensorShape> batch_shapes(padded_shapes.size());
+        for (size_t i = 0; i < padded_shapes.size(); ++i) {
+          TensorShape shape({dataset()->bucket_batch_sizes_[bucket_id]});
+          for (int dim = 0; dim < padded_shapes[i].dims(); ++dim) {
+            shape.AddDim(padded_shapes[i].dim_size(dim));
+          }
+          batch_shapes[i] = std::move(shape);
+        }
+        TF_RETURN_IF_ERROR(AllocateBatch(ctx, bucket_id, batch_shapes,
+                                         &bucket.batch));
+      }
+      for (size_t i = 0; i < element.size(); ++i) {
+        TF_RETURN_IF_ERROR(
+            CopyElementToBatch(element[i], &bucket.batch[i],
+                               bucket.num_elements));
+      }
+      ++bucket.num_elements;
+      return OkStatus();
+    }
+
+    // Returns the batch of the given bucket in `out_tensors` and empties the
+    // bucket.
+    Status FlushBucket(IteratorContext* ctx, int64_t bucket_id,
+                       std::vector<Tensor>* out_tensors)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      Bucket bucket = std::move(buckets_[bucket_id]);
+      buckets_[bucket_id] = Bucket();
+      if (!bucket.batch.empty()) {
+        if (bucket.num_elements == dataset()->bucket_batch_sizes_[bucket_id]) {
+          *out_tensors = std::move(bucket.batch);
+          return OkStatus();
+        }
+        // A partial batch, which only happens at the end of the input.
+        out_tensors->clear();
+        for (const Tensor& batch : bucket.batch) {
+          out_tensors->push_back(
+              tensor::DeepCopy(batch.Slice(0, bucket.num_elements)));
+        }
+        return OkStatus();
+      }
+
+      const std::vector<PartialTensorShape>& padded_shapes =
+          dataset()->bucket_padded_shapes_[bucket_id];
+      std::vector<TensorShape> batch_shapes(padded_shapes.size());
+      for (size_t i = 0; i < padded_shapes.size(); ++i) {
+        TensorShape shape({bucket.num_elements});
+        for (int dim = 0; dim < padded_shapes[i].dims(); ++dim) {
+          int64_t size = padded_shapes[i].dim_size(dim);
+          if (size == -1) {
+            // Pad to the largest element in this dimension.
+            size = 0;
+            for (const std::vector<Tensor>& element : bucket.elements) {
+              size = std::max(size, element[i].dim_size(dim));
+            }
+          }
+          shape.AddDim(size);
+        }
+        batch_shapes[i] = std::move(shape);
+      }
+      TF_RETURN_IF_ERROR(
+          AllocateBatch(ctx, bucket_id, batch_shapes, out_tensors));
+      for (size_t i = 0; i < padded_shapes.size(); ++i) {
+        for (int64_t j = 0; j < bucket.num_elements; ++j) {
+          TF_RETURN_IF_ERROR(CopyElementToBatch(bucket.elements[j][i],
+                                                &(*out_tensors)[i], j));
+        }
+      }
+      return OkStatus();
+    }
+
+    // Gets a batch with the given component shapes from `output_pool_`, with
+    // every value set to the padding value of its component.
+    Status AllocateBatch(IteratorContext* ctx, int64_t bucket_id,
+                         const std::vector<TensorShape>& batch_shapes,
+                         std::vector<Tensor>* batch) {
+      const size_t num_components = batch_shapes.size();
+      batch->clear();
+      batch->reserve(num_components);
+      for (size_t i = 0; i < num_components; ++i) {
+        batch->push_back(output_pool_.Get(bucket_id * num_components + i,
+                                          ctx->allocator({}),
+                                          dataset()->output_dtypes()[i],
+                                          batch_shapes[i]));
+        TF_RETURN_IF_ERROR(batch_util::SetElementZero(
+            &batch->back(), dataset()->padding_values_[i]));
+      }
+      return OkStatus();
+    }
+
+    mutex mu_;
+    std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_);
+    std::vector<Bucket> buckets_ TF_GUARDED_BY(mu_);
+    OutputPool output_pool_;
+    std::unique_ptr<InstantiatedCapturedFunction> instantiated_func_;
+  };
+
+  const DatasetBase* const input_;
+  const std::unique_ptr<CapturedFunction> captured_func_;
+  const std::vector<int64_t> bucket_boundaries_;
+  const std::vector<int64_t> bucket_batch_sizes_;
+  const std::vector<PartialTensorShape> padded_shapes_;
+  const std::vector<Tensor> padding_values_;
+  const bool drop_remainder_;
+  const bool pad_to_bucket_boundary_;
+  const std::vector<PartialTensorShape> output_shapes_;
+  const TraceMeMetadata traceme_metadata_;
+  // The padded shapes of the batches of each bucket, and whether they are
+  // fully defined.
+  std::vector<std::vector<PartialTensorShape>> bucket_padded_shapes_;
+  std::vector<bool> bucket_is_static_;
+};
+
+BucketBySequenceLengthDatasetOp::BucketBySequenceLengthDatasetOp(
+    OpKernelConstruction* ctx)
+    : UnaryDatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, FunctionMetadata::Create(ctx, kElementLengthFunc,
+                                               /*params=*/{}, &func_metadata_));
+  OP_REQUIRES_OK(ctx,
+                 ctx->GetAttr(kPadToBucketBoundary, &pad_to_bucket_boundary_));
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kOutputShapes, &output_shapes_));
+}
+
+void BucketBySequenceLengthDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                                  DatasetBase* input,
+                                                  DatasetBase** output) {
+  std::unique_ptr<CapturedFunction> captured_func;
+  OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_metadata_,
+                                               kOtherArguments,
+                                               &captured_func));
+
+  std::vector<int64_t> bucket_boundaries;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBoundaries,
+                                                   &bucket_boundaries));
+  std::vector<int64_t> bucket_batch_sizes;
+  OP_REQUIRES_OK(ctx, ParseVectorArgument<int64_t>(ctx, kBucketBatchSizes,
+                                                   &bucket_batch_sizes));
+  OP_REQUIRES(
+      ctx, bucket_batch_sizes.size() == bucket_boundaries.size() + 1,
+      errors::InvalidArgument(
+          "The number of bucket batch sizes (", bucket_batch_sizes.size(),
+          ") must be one more than the number of bucket boundaries (",
+          bucket_boundaries.size(), ")."));
+  for (const int64_t batch_size : bucket_batch_sizes) {
+    OP_REQUIRES(ctx, batch_size > 0,
+                errors::InvalidArgument(
+                    "Bucket batch sizes must be greater than zero."));
+  }
+  if (pad_to_bucket_boundary_) {
+    for (const int64_t boundary : bucket_boundaries) {
+      OP_REQUIRES(ctx, boundary > 0,
+                  errors::InvalidArgument(
+                      "Bucket boundaries must be greater than zero when "
+                      "padding to the bucket boundary, but got ",
+                      boundary, "."));
+    }
+  }
+
+  bool drop_remainder;
+  OP_REQUIRES_OK(
+      ctx, ParseScalarArgument<bool>(ctx, kDropRemainder, &drop_remainder));
+
+  OpInputList padded_shape_tensors;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddedShapes, &padded_shape_tensors));
+  OP_REQUIRES(ctx, padded_shape_tensors.size() == input->output_shapes().size(),
+              errors::InvalidArgument("Number of padded shapes (",
+                                      padded_shape_tensors.size(),
+                                      ") must match the number of components "
+                                      "in the input dataset's elements (",
+                                      input->output_shapes().size(), ")"));
+  std::vector<PartialTensorShape> padded_shapes;
+  padded_shapes.reserve(padded_shape_tensors.size());
+  for (const Tensor& padded_shape_t : padded_shape_tensors) {
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(padded_shape_t.shape()),
+                errors::InvalidArgument("All padded shapes must be vectors"));
+    PartialTensorShape padded_shape;
+    OP_REQUIRES_OK(ctx, PartialTensorShape::MakePartialShape(
+                            padded_shape_t.vec<int64_t>().data(),
+                            padded_shape_t.NumElements(), &padded_shape));
+    padded_shapes.push_back(std::move(padded_shape));
+  }
+
+  OpInputList padding_values_list;
+  OP_REQUIRES_OK(ctx, ctx->input_list(kPaddingValues, &padding_values_list));
+  OP_REQUIRES(ctx, padding_values_list.size() == input->output_shapes().size(),
+              errors::InvalidArgument(
+                  "Number of padding values (", padding_values_list.size(),
+                  ") must match the number of components in the input "
+                  "dataset's elements (",
+                  input->output_shapes().size(), ")"));
+  std::vector<Tensor> padding_values;
+  for (int i = 0; i < padding_values_list.size(); ++i) {
+    const Tensor& padding_value_t = padding_values_list[i];
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(padding_value_t.shape()),
+                errors::InvalidArgument("All padding values must be scalars"));
+    OP_REQUIRES(ctx, padding_value_t.dtype() == input->output_dtypes()[i],
+                errors::InvalidArgument(
+                    "Mismatched type between padding value ", i,
+                    " and input dataset's component ", i, ": ",
+                    DataTypeString(padding_value_t.dtype()), " vs. ",
+                    DataTypeString(input->output_dtypes()[i])));
+    padding_values.push_back(tensor::DeepCopy(padding_value_t));
+  }
+
+  *output = new Dataset(ctx, input, std::move(captured_func),
+                        std::move(bucket_boundaries),
+                        std::move(bucket_batch_sizes), std::move(padded_shapes),
+                        std::move(padding_values), drop_remainder,
+                        pad_to_bucket_boundary_, output_shapes_);
+}
+
+namespace {
+REGISTER_KERNEL_BUILDER(
+    Name("BucketBySequenceLengthDataset").Device(DEVICE_CPU),
+    BucketBySequenceLengthDatasetOp);
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,354 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/bucket_by_sequence_length_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/framework/function.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "bucket_by_sequence_length_dataset";
+
+class BucketBySequenceLengthDatasetParams : public DatasetParams {
+ public:
+  template <typename T>
+  BucketBySequenceLengthDatasetParams(
+      T input_dataset_params, std::vector<int64_t> bucket_boundaries,
+      std::vector<int64_t> bucket_batch_sizes,
+      std::vector<Tensor> padded_shapes, std::vector<Tensor> padding_values,
+      bool drop_remainder, bool pad_to_bucket_boundary,
+      FunctionDefHelper::AttrValueWrapper element_length_func,
+      std::vector<FunctionDef> func_lib, DataTypeVector output_dtypes,
+      std::vector<PartialTensorShape> output_shapes, string node_name)
+      : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
+                      std::move(node_name)),
+        bucket_boundaries_(std::move(bucket_boundaries)),
+        bucket_batch_sizes_(std::move(bucket_batch_sizes)),
+        padded_shapes_(std::move(padded_shapes)),
+        padding_values_(std::move(padding_values)),
+        drop_remainder_(drop_remainder),
+        pad_to_bucket_boundary_(pad_to_bucket_boundary),
+        element_length_func_(std::move(element_length_func)),
+        func_lib_(std::move(func_lib)) {
+    input_dataset_params_.push_back(std::make_unique<T>(input_dataset_params));
+    iterator_prefix_ =
+        name_utils::IteratorPrefix(input_dataset_params.dataset_type(),
+                                   input_dataset_params.iterator_prefix());
+  }
+
+  std::vector<Tensor> GetInputTensors() const override {
+    std::vector<Tensor> inputs;
+    inputs.push_back(CreateTensor<int64_t>(
+        TensorShape({static_cast<int64_t>(bucket_boundaries_.size())}),
+        bucket_boundaries_));
+    inputs.push_back(CreateTensor<int64_t>(
+        TensorShape({static_cast<int64_t>(bucket_batch_sizes_.size())}),
+        bucket_batch_sizes_));
+    inputs.insert(inputs.end(), padded_shapes_.begin(), padded_shapes_.end());
+    inputs.insert(inputs.end(), padding_values_.begin(),
+                  padding_values_.end());
+    inputs.push_back(CreateTensor<bool>(TensorShape({}), {drop_remainder_}));
+    return inputs;
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    input_names->clear();
+    input_names->emplace_back(BucketBySequenceLengthDatasetOp::kInputDataset);
+    input_names->emplace_back(
+        BucketBySequenceLengthDatasetOp::kBucketBoundaries);
+    input_names->emplace_back(
+        BucketBySequenceLengthDatasetOp::kBucketBatchSizes);
+    for (int i = 0; i < padded_shapes_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddedShapes, "_", i));
+    }
+    for (int i = 0; i < padding_values_.size(); ++i) {
+      input_names->emplace_back(strings::StrCat(
+          BucketBySequenceLengthDatasetOp::kPaddingValues, "_", i));
+    }
+    input_names->emplace_back(BucketBySequenceLengthDatasetOp::kDropRemainder);
+    return OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {
+        {BucketBySequenceLengthDatasetOp::kElementLengthFunc,
+         element_length_func_},
+        {BucketBySequenceLengthDatasetOp::kTarguments, DataTypeVector()},
+        {BucketBySequenceLengthDatasetOp::kPadToBucketBoundary,
+         pad_to_bucket_boundary_},
+        {BucketBySequenceLengthDatasetOp::kToutputTypes, output_dtypes_},
+        {BucketBySequenceLengthDatasetOp::kOutputShapes, output_shapes_},
+        {BucketBySequenceLengthDatasetOp::kNumPaddedShapes,
+         static_cast<int64_t>(padded_shapes_.size())},
+        {"metadata", ""}};
+    return OkStatus();
+  }
+
+  std::vector<FunctionDef> func_lib() const override { return func_lib_; }
+
+  string dataset_type() const override {
+    return BucketBySequenceLengthDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<int64_t> bucket_boundaries_;
+  std::vector<int64_t> bucket_batch_sizes_;
+  std::vector<Tensor> padded_shapes_;
+  std::vector<Tensor> padding_values_;
+  bool drop_remainder_;
+  bool pad_to_bucket_boundary_;
+  FunctionDefHelper::AttrValueWrapper element_length_func_;
+  std::vector<FunctionDef> func_lib_;
+};
+
+class BucketBySequenceLengthDatasetOpTest : public DatasetOpsTestBase {};
+
+// Returns the first of the two components of an element, which is its length.
+FunctionDef GetLength() {
+  return FunctionDefHelper::Define(
+      // Name
+      "GetLength",
+      // Args
+      {"length: int64", "data: int64"},
+      // Return values
+      {"y: int64"},
+      // Attr def
+      {},
+      // Nodes
+      {{{"y"}, "Identity", {"length"}, {{"T", DT_INT64}}}});
+}
+
+// Returns a dataset of elements `(lengths[i], data[i])`, where each `data[i]`
+// has two values.
+TensorSliceDatasetParams LengthAndDataParams(std::vector<int64_t> lengths) {
+  const int64_t n = lengths.size();
+  std::vector<int64_t> data;
+  for (int64_t i = 0; i < n; ++i) {
+    data.push_back(10 * (i + 1));
+    data.push_back(10 * (i + 1) + 1);
+  }
+  return TensorSliceDatasetParams(
+      /*components=*/{CreateTensor<int64_t>(TensorShape({n}), lengths),
+                      CreateTensor<int64_t>(TensorShape({n, 2}), data)},
+      /*node_name=*/"tensor_slice");
+}
+
+BucketBySequenceLengthDatasetParams MakeParams(
+    std::vector<int64_t> lengths, std::vector<int64_t> bucket_boundaries,
+    int64_t padded_size, bool drop_remainder, bool pad_to_bucket_boundary) {
+  std::vector<int64_t> bucket_batch_sizes(bucket_boundaries.size() + 1, 2);
+  return BucketBySequenceLengthDatasetParams(
+      LengthAndDataParams(std::move(lengths)), std::move(bucket_boundaries),
+      std::move(bucket_batch_sizes),
+      /*padded_shapes=*/
+      {CreateTensor<int64_t>(TensorShape({0}), {}),
+       CreateTensor<int64_t>(TensorShape({1}), {padded_size})},
+      /*padding_values=*/
+      {CreateTensor<int64_t>(TensorShape({}), {-1}),
+       CreateTensor<int64_t>(TensorShape({}), {-1})},
+      drop_remainder, pad_to_bucket_boundary,
+      /*element_length_func=*/FunctionDefHelper::FunctionRef("GetLength"),
+      /*func_lib=*/{GetLength()},
+      /*output_dtypes=*/{DT_INT64, DT_INT64},
+      /*output_shapes=*/
+      {PartialTensorShape({-1}), PartialTensorShape({-1, padded_size})},
+      /*node_name=*/kNodeName);
+}
+
+// Elements are padded into batches with a static shape as they arrive.
+BucketBySequenceLengthDatasetParams StaticPaddedShapeParams() {
+  return MakeParams(/*lengths=*/{1, 4, 3, 6, 2, 7},
+                    /*bucket_boundaries=*/{3, 5}, /*padded_size=*/3,
+                    /*drop_remainder=*/false,
+                    /*pad_to_bucket_boundary=*/false);
+}
+
+// Elements are padded to the largest element of their batch.
+BucketBySequenceLengthDatasetParams DynamicPaddedShapeParams() {
+  return MakeParams(/*lengths=*/{1, 4, 3, 6, 2},
+                    /*bucket_boundaries=*/{3, 5}, /*padded_size=*/-1,
+                    /*drop_remainder=*/false,
+                    /*pad_to_bucket_boundary=*/false);
+}
+
+BucketBySequenceLengthDatasetParams PadToBucketBoundaryParams() {
+  return MakeParams(/*lengths=*/{1, 4, 5, 2, 3},
+                    /*bucket_boundaries=*/{4, 6}, /*padded_size=*/-1,
+                    /*drop_remainder=*/false,
+                    /*pad_to_bucket_boundary=*/true);
+}
+
+BucketBySequenceLengthDatasetParams DropRemainderParams() {
+  return MakeParams(/*lengths=*/{1, 4, 5, 2, 3},
+                    /*bucket_boundaries=*/{4, 6}, /*padded_size=*/-1,
+                    /*drop_remainder=*/true,
+                    /*pad_to_bucket_boundary=*/true);
+}
+
+BucketBySequenceLengthDatasetParams LengthOutsideBoundariesParams() {
+  return MakeParams(/*lengths=*/{1, 6}, /*bucket_boundaries=*/{4, 6},
+                    /*padded_size=*/-1, /*drop_remainder=*/false,
+                    /*pad_to_bucket_boundary=*/true);
+}
+
+BucketBySequenceLengthDatasetParams InvalidBucketBatchSizesParams() {
+  return BucketBySequenceLengthDatasetParams(
+      LengthAndDataParams({1, 2}), /*bucket_boundaries=*/{3, 5},
+      /*bucket_batch_sizes=*/{2, 2},
+      /*padded_shapes=*/
+      {CreateTensor<int64_t>(TensorShape({0}), {}),
+       CreateTensor<int64_t>(TensorShape({1}), {3})},
+      /*padding_values=*/
+      {CreateTensor<int64_t>(TensorShape({}), {-1}),
+       CreateTensor<int64_t>(TensorShape({}), {-1})},
+      /*drop_remainder=*/false, /*pad_to_bucket_boundary=*/false,
+      /*element_length_func=*/FunctionDefHelper::FunctionRef("GetLength"),
+      /*func_lib=*/{GetLength()},
+      /*output_dtypes=*/{DT_INT64, DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({-1}), PartialTensorShape({-1, 3})},
+      /*node_name=*/kNodeName);
+}
+
+std::vector<Tensor> StaticPaddedShapeOutputs() {
+  return {CreateTensor<int64_t>(TensorShape({2}), {4, 3}),
+          CreateTensor<int64_t>(TensorShape({2, 3}),
+                                {20, 21, -1, 30, 31, -1}),
+          CreateTensor<int64_t>(TensorShape({2}), {1, 2}),
+          CreateTensor<int64_t>(TensorShape({2, 3}),
+                                {10, 11, -1, 50, 51, -1}),
+          CreateTensor<int64_t>(TensorShape({2}), {6, 7}),
+          CreateTensor<int64_t>(TensorShape({2, 3}),
+                                {40, 41, -1, 60, 61, -1})};
+}
+
+std::vector<Tensor> PadToBucketBoundaryOutputs() {
+  return {CreateTensor<int64_t>(TensorShape({2}), {4, 5}),
+          CreateTensor<int64_t>(TensorShape({2, 5}),
+                                {20, 21, -1, -1, -1, 30, 31, -1, -1, -1}),
+          CreateTensor<int64_t>(TensorShape({2}), {1, 2}),
+          CreateTensor<int64_t>(TensorShape({2, 3}),
+                                {10, 11, -1, 40, 41, -1}),
+          CreateTensor<int64_t>(TensorShape({1}), {3}),
+          CreateTensor<int64_t>(TensorShape({1, 3}), {50, 51, -1})};
+}
+
+std::vector<GetNextTestCase<BucketBySequenceLengthDatasetParams>>
+GetNextTestCases() {
+  return {{/*dataset_params=*/StaticPaddedShapeParams(),
+           /*expected_outputs=*/StaticPaddedShapeOutputs()},
+          // Buckets are flushed in order at the end of the input.
+          {/*dataset_params=*/DynamicPaddedShapeParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({2}), {4, 3}),
+            CreateTensor<int64_t>(TensorShape({2, 2}), {20, 21, 30, 31}),
+            CreateTensor<int64_t>(TensorShape({2}), {1, 2}),
+            CreateTensor<int64_t>(TensorShape({2, 2}), {10, 11, 50, 51}),
+            CreateTensor<int64_t>(TensorShape({1}), {6}),
+            CreateTensor<int64_t>(TensorShape({1, 2}), {40, 41})}},
+          {/*dataset_params=*/PadToBucketBoundaryParams(),
+           /*expected_outputs=*/PadToBucketBoundaryOutputs()},
+          {/*dataset_params=*/DropRemainderParams(),
+           /*expected_outputs=*/
+           {CreateTensor<int64_t>(TensorShape({2}), {4, 5}),
+            CreateTensor<int64_t>(TensorShape({2, 5}),
+                                  {20, 21, -1, -1, -1, 30, 31, -1, -1, -1}),
+            CreateTensor<int64_t>(TensorShape({2}), {1, 2}),
+            CreateTensor<int64_t>(TensorShape({2, 3}),
+                                  {10, 11, -1, 40, 41, -1})}}};
+}
+
+ITERATOR_GET_NEXT_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                         BucketBySequenceLengthDatasetParams,
+                         GetNextTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetNodeName) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetNodeName(dataset_params.node_name()));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetTypeString) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetTypeString(
+      name_utils::OpName(BucketBySequenceLengthDatasetOp::kDatasetType)));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetOutputDtypes) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputDtypes({DT_INT64, DT_INT64}));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, DatasetOutputShapes) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetOutputShapes(
+      {PartialTensorShape({-1}), PartialTensorShape({-1, 3})}));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, Cardinality) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(kUnknownCardinality));
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, IteratorPrefix) {
+  auto dataset_params = StaticPaddedShapeParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckIteratorPrefix(
+      name_utils::IteratorPrefix(BucketBySequenceLengthDatasetOp::kDatasetType,
+                                 dataset_params.iterator_prefix())));
+}
+
+std::vector<IteratorSaveAndRestoreTestCase<BucketBySequenceLengthDatasetParams>>
+IteratorSaveAndRestoreTestCases() {
+  return {{/*dataset_params=*/StaticPaddedShapeParams(),
+           /*breakpoints=*/{0, 1, 2, 5},
+           /*expected_outputs=*/StaticPaddedShapeOutputs()},
+          {/*dataset_params=*/PadToBucketBoundaryParams(),
+           /*breakpoints=*/{0, 1, 2, 5},
+           /*expected_outputs=*/PadToBucketBoundaryOutputs()}};
+}
+
+ITERATOR_SAVE_AND_RESTORE_TEST_P(BucketBySequenceLengthDatasetOpTest,
+                                 BucketBySequenceLengthDatasetParams,
+                                 IteratorSaveAndRestoreTestCases())
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, LengthOutsideBoundaries) {
+  auto dataset_params = LengthOutsideBoundariesParams();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  std::vector<Tensor> out_tensors;
+  bool end_of_sequence = false;
+  EXPECT_EQ(
+      iterator_->GetNext(iterator_ctx_.get(), &out_tensors, &end_of_sequence)
+          .code(),
+      tensorflow::error::INVALID_ARGUMENT);
+}
+
+TEST_F(BucketBySequenceLengthDatasetOpTest, InvalidBucketBatchSizes) {
+  auto dataset_params = InvalidBucketBatchSizesParams();
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
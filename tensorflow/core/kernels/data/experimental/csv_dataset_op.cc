@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/kernels/csv_parsing.h"
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
@@ -641,7 +642,9 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        // Each iter skips to the next delim, quote or CRLF, filling buffer if
+        // necessary
+        while (true) {
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -657,6 +660,14 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
           }
 
+          // Skip to the next character that may end the field.
+          pos_ = csv::FindSpecialChar(buffer_.data() + pos_,
+                                      buffer_.data() + buffer_.size(),
+                                      dataset()->delim_,
+                                      dataset()->use_quote_delim_) -
+                 buffer_.data();
+          if (pos_ >= buffer_.size()) continue;
+
           char ch = buffer_[pos_];
 
           if (ch == dataset()->delim_) {
@@ -730,7 +741,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int32>()(0);
             } else {
               int32_t value;
-              if (!strings::safe_strto32(field, &value)) {
+              if (!csv::ParseValue(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int32: ", field);
@@ -745,7 +756,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<int64_t>()(0);
             } else {
               int64_t value;
-              if (!strings::safe_strto64(field, &value)) {
+              if (!csv::ParseValue(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int64: ", field);
@@ -760,7 +771,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
-              if (!strings::safe_strtof(field, &value)) {
+              if (!csv::ParseValue(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
@@ -775,7 +786,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
-              if (!strings::safe_strtod(field, &value)) {
+              if (!csv::ParseValue(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
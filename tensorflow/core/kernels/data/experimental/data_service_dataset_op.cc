@@ -479,10 +479,19 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
       EnsureThreadsStarted(ctx);
       std::shared_ptr<Result> result;
       do {
+        int64_t wait_start_micros = -1;
         while (!ResultReady() && !Finished() && !cancelled_ && status_.ok()) {
           VLOG(3) << "Blocking in GetNext: " << DebugString();
+          if (wait_start_micros < 0) {
+            wait_start_micros = Env::Default()->NowMicros();
+          }
           get_next_cv_.wait(l);
         }
+        if (wait_start_micros >= 0) {
+          consumption_metrics_.set_stall_time_us(
+              consumption_metrics_.stall_time_us() +
+              Env::Default()->NowMicros() - wait_start_micros);
+        }
         if (cancelled_) {
           VLOG(3) << "Returning from GetNext due to cancellation";
           return errors::Cancelled("Data service iterator was cancelled");
@@ -514,6 +523,8 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
                   << ": Result " << get_next_index_++;
         }
         out_tensors->swap(result->element);
+        consumption_metrics_.set_num_elements(
+            consumption_metrics_.num_elements() + 1);
       }
       return OkStatus();
     }
@@ -744,12 +755,22 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     void Heartbeat() TF_LOCKS_EXCLUDED(mu_) {
       ClientHeartbeatRequest req;
       req.set_iteration_client_id(iteration_client_id_);
-      if (StrictRoundRobin()) {
+      {
         mutex_lock l(mu_);
-        req.set_current_round(current_round_);
-        if (round_robin_round_limit_.has_value()) {
-          req.set_blocked_round(round_robin_round_limit_.value());
+        if (StrictRoundRobin()) {
+          req.set_current_round(current_round_);
+          if (round_robin_round_limit_.has_value()) {
+            req.set_blocked_round(round_robin_round_limit_.value());
+          }
         }
+        const int64_t now_micros = Env::Default()->NowMicros();
+        if (last_heartbeat_micros_ >= 0) {
+          consumption_metrics_.set_elapsed_time_us(now_micros -
+                                                   last_heartbeat_micros_);
+          *req.mutable_consumption_metrics() = consumption_metrics_;
+        }
+        consumption_metrics_.Clear();
+        last_heartbeat_micros_ = now_micros;
       }
       ClientHeartbeatResponse resp;
       Status s = dispatcher_->ClientHeartbeat(req, resp);
@@ -1084,8 +1105,14 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
                {"round_index", task->round}});
         });
       }
+      const int64_t start_micros = Env::Default()->NowMicros();
       Status s = GetElement(task, deadline_micros, enqueue_result, result);
+      const int64_t latency_micros = Env::Default()->NowMicros() - start_micros;
       mutex_lock l(mu_);
+      consumption_metrics_.set_num_get_element_requests(
+          consumption_metrics_.num_get_element_requests() + 1);
+      consumption_metrics_.set_total_get_element_latency_us(
+          consumption_metrics_.total_get_element_latency_us() + latency_micros);
       VLOG(3) << "Got an element for task id " << task->info.task_id();
       return s;
     }
@@ -1248,6 +1275,11 @@ class DataServiceDatasetOp::Dataset : public DatasetBase {
     // The set of worker UIDs that we have already recorded metrics for.
     absl::flat_hash_set<int64_t> worker_uids_ TF_GUARDED_BY(mu_);
 
+    // Consumption since the previous heartbeat, reported to the dispatcher so
+    // that it can recommend the number of workers.
+    ClientConsumptionMetrics consumption_metrics_ TF_GUARDED_BY(mu_);
+    int64_t last_heartbeat_micros_ TF_GUARDED_BY(mu_) = -1;
+
     std::vector<std::unique_ptr<Thread>> worker_threads_ TF_GUARDED_BY(mu_);
     std::unique_ptr<Thread> task_thread_manager_ TF_GUARDED_BY(mu_);
   };
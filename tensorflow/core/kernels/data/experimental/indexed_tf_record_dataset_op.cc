@@ -0,0 +1,309 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/indexed_tf_record_dataset_op.h"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/kernels/random_index_shuffle.h"
+#include "tensorflow/core/lib/io/record_index.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+
+// Constants declared in indexed_tf_record_dataset_op.h and used both here and
+// in test cases.
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kDatasetType;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kFileNames;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kNumShards;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kShardIndex;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kSeed;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kSeed2;
+/* static */ constexpr const char* const IndexedTFRecordDatasetOp::kShuffle;
+
+// Reads the records of uncompressed TFRecord files in the order of a global
+// position in the concatenation of the files. Element `k` of shard `i` out of
+// `n` is the record at position `i + k * n`, or at the image of that position
+// by a pseudorandom permutation of all positions when shuffling. Since the
+// permutation is computed on the fly by `random::index_shuffle()`, the dataset
+// is shuffled across all files without a shuffle buffer.
+class IndexedTFRecordDatasetOp::Dataset : public DatasetBase {
+ public:
+  Dataset(OpKernelContext* ctx, std::vector<string> filenames,
+          std::vector<io::RecordIndex> indexes, int64_t num_shards,
+          int64_t shard_index, bool shuffle, RandomSeeds seeds)
+      : DatasetBase(DatasetContext(ctx)),
+        env_(ctx->env()),
+        filenames_(std::move(filenames)),
+        indexes_(std::move(indexes)),
+        num_shards_(num_shards),
+        shard_index_(shard_index),
+        shuffle_(shuffle),
+        seeds_(std::move(seeds)),
+        key_({static_cast<uint32>(seeds_.seed()),
+              static_cast<uint32>(static_cast<uint64>(seeds_.seed()) >> 32),
+              static_cast<uint32>(seeds_.seed2())}),
+        files_(filenames_.size()) {
+    file_starts_.reserve(indexes_.size() + 1);
+    file_starts_.push_back(0);
+    for (const io::RecordIndex& index : indexes_) {
+      file_starts_.push_back(file_starts_.back() + index.num_records());
+    }
+    const int64_t num_records = file_starts_.back();
+    num_shard_records_ =
+        num_records > shard_index_
+            ? (num_records - shard_index_ + num_shards_ - 1) / num_shards_
+            : 0;
+  }
+
+  std::unique_ptr<IteratorBase> MakeIteratorInternal(
+      const string& prefix) const override {
+    return std::make_unique<Iterator>(Iterator::Params{
+        this, name_utils::IteratorPrefix(kDatasetType, prefix)});
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    static DataTypeVector* dtypes = new DataTypeVector({DT_STRING});
+    return *dtypes;
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    static std::vector<PartialTensorShape>* shapes =
+        new std::vector<PartialTensorShape>({{}});
+    return *shapes;
+  }
+
+  string DebugString() const override {
+    return name_utils::DatasetDebugString(kDatasetType);
+  }
+
+  int64_t CardinalityInternal() const override { return num_shard_records_; }
+
+  Status InputDatasets(std::vector<const DatasetBase*>* inputs) const override {
+    return OkStatus();
+  }
+
+  Status CheckExternalState() const override { return OkStatus(); }
+
+  Status Get(OpKernelContext* ctx, int64 index,
+             std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    return ReadElement(index, out_tensors);
+  }
+
+ protected:
+  Status AsGraphDefInternal(SerializationContext* ctx,
+                            DatasetGraphDefBuilder* b,
+                            Node** output) const override {
+    Node* filenames = nullptr;
+    TF_RETURN_IF_ERROR(b->AddVector(filenames_, &filenames));
+    Node* num_shards = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(num_shards_, &num_shards));
+    Node* shard_index = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(shard_index_, &shard_index));
+    Node* seed = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed(), &seed));
+    Node* seed2 = nullptr;
+    TF_RETURN_IF_ERROR(b->AddScalar(seeds_.input_seed2(), &seed2));
+    AttrValue shuffle;
+    b->BuildAttrValue(shuffle_, &shuffle);
+    TF_RETURN_IF_ERROR(
+        b->AddDataset(this, {filenames, num_shards, shard_index, seed, seed2},
+                      {std::make_pair(kShuffle, shuffle)}, output));
+    return OkStatus();
+  }
+
+ private:
+  class Iterator : public DatasetIterator<Dataset> {
+   public:
+    explicit Iterator(const Params& params)
+        : DatasetIterator<Dataset>(params) {}
+
+    Status GetNextInternal(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence) override {
+      int64_t index;
+      {
+        mutex_lock l(mu_);
+        if (next_index_ >= dataset()->num_shard_records_) {
+          *end_of_sequence = true;
+          return OkStatus();
+        }
+        index = next_index_++;
+      }
+      *end_of_sequence = false;
+      return dataset()->ReadElement(index, out_tensors);
+    }
+
+   protected:
+    std::shared_ptr<model::Node> CreateNode(
+        IteratorContext* ctx, model::Node::Args args) const override {
+      return model::MakeSourceNode(std::move(args));
+    }
+
+    Status SaveInternal(SerializationContext* ctx,
+                        IteratorStateWriter* writer) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(
+          writer->WriteScalar(full_name("next_index"), next_index_));
+      return OkStatus();
+    }
+
+    Status RestoreInternal(IteratorContext* ctx,
+                           IteratorStateReader* reader) override {
+      mutex_lock l(mu_);
+      TF_RETURN_IF_ERROR(
+          reader->ReadScalar(full_name("next_index"), &next_index_));
+      return OkStatus();
+    }
+
+   private:
+    mutex mu_;
+    int64_t next_index_ TF_GUARDED_BY(mu_) = 0;
+  };
+
+  // Reads element `index` of the shard.
+  Status ReadElement(int64_t index, std::vector<Tensor>* out_tensors) const {
+    uint64 position = shard_index_ + index * num_shards_;
+    const uint64 max_position = file_starts_.back() - 1;
+    // `index_shuffle()` requires a non-zero maximum.
+    if (shuffle_ && max_position > 0) {
+      position = random::index_shuffle(position, key_, max_position);
+    }
+    const int file_index =
+        std::upper_bound(file_starts_.begin(), file_starts_.end(), position) -
+        file_starts_.begin() - 1;
+    RandomAccessFile* file;
+    TF_RETURN_IF_ERROR(GetFile(file_index, &file));
+    Tensor record(DT_STRING, TensorShape({}));
+    TF_RETURN_IF_ERROR(indexes_[file_index].ReadRecord(
+        file, position - file_starts_[file_index],
+        &record.scalar<tstring>()()));
+    out_tensors->push_back(std::move(record));
+    return OkStatus();
+  }
+
+  // Returns file `file_index`, which is opened on first use. Reads from a
+  // `RandomAccessFile` are thread-safe, so the file is used outside of `mu_`.
+  Status GetFile(int file_index, RandomAccessFile** file) const {
+    mutex_lock l(mu_);
+    if (files_[file_index] == nullptr) {
+      TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(filenames_[file_index],
+                                                   &files_[file_index]));
+    }
+    *file = files_[file_index].get();
+    return OkStatus();
+  }
+
+  Env* const env_;
+  const std::vector<string> filenames_;
+  const std::vector<io::RecordIndex> indexes_;
+  const int64_t num_shards_;
+  const int64_t shard_index_;
+  const bool shuffle_;
+  const RandomSeeds seeds_;
+  const std::array<uint32, 3> key_;
+  // `file_starts_[i]` is the position of the first record of file `i`, and
+  // the last entry is the total number of records.
+  std::vector<uint64> file_starts_;
+  int64_t num_shard_records_;
+
+  mutable mutex mu_;
+  mutable std::vector<std::unique_ptr<RandomAccessFile>> files_
+      TF_GUARDED_BY(mu_);
+};
+
+IndexedTFRecordDatasetOp::IndexedTFRecordDatasetOp(OpKernelConstruction* ctx)
+    : DatasetOpKernel(ctx) {
+  OP_REQUIRES_OK(ctx, ctx->GetAttr(kShuffle, &shuffle_));
+}
+
+void IndexedTFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
+                                           DatasetBase** output) {
+  const Tensor* filenames_tensor;
+  OP_REQUIRES_OK(ctx, ctx->input(kFileNames, &filenames_tensor));
+  OP_REQUIRES(
+      ctx, filenames_tensor->dims() <= 1,
+      errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+
+  int64_t num_shards;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64_t>(ctx, kNumShards, &num_shards));
+  OP_REQUIRES(ctx, num_shards > 0,
+              errors::InvalidArgument("`num_shards` must be > 0, but got ",
+                                      num_shards));
+  int64_t shard_index;
+  OP_REQUIRES_OK(ctx,
+                 ParseScalarArgument<int64_t>(ctx, kShardIndex, &shard_index));
+  OP_REQUIRES(
+      ctx, shard_index >= 0 && shard_index < num_shards,
+      errors::InvalidArgument("`shard_index` must be in [0, ", num_shards,
+                              "), but got ", shard_index));
+  int64_t seed;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed, &seed));
+  int64_t seed2;
+  OP_REQUIRES_OK(ctx, ParseScalarArgument<int64_t>(ctx, kSeed2, &seed2));
+
+  std::vector<string> filenames;
+  std::vector<io::RecordIndex> indexes;
+  filenames.reserve(filenames_tensor->NumElements());
+  indexes.reserve(filenames_tensor->NumElements());
+  for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+    filenames.push_back(filenames_tensor->flat<tstring>()(i));
+    const string index_filename =
+        io::RecordIndex::SidecarFilename(filenames.back());
+    indexes.emplace_back();
+    if (ctx->env()->FileExists(index_filename).ok()) {
+      OP_REQUIRES_OK(ctx, io::RecordIndex::Read(ctx->env(), index_filename,
+                                                &indexes.back()));
+      continue;
+    }
+    LOG(WARNING) << "No index found for " << filenames.back()
+                 << ", building it by scanning the file. Write the index with "
+                 << "`io::RecordIndex::Write()` to avoid the scan.";
+    std::unique_ptr<RandomAccessFile> file;
+    OP_REQUIRES_OK(ctx,
+                   ctx->env()->NewRandomAccessFile(filenames.back(), &file));
+    OP_REQUIRES_OK(ctx, io::RecordIndex::Build(file.get(), &indexes.back()));
+  }
+
+  *output = new Dataset(ctx, std::move(filenames), std::move(indexes),
+                        num_shards, shard_index, shuffle_,
+                        RandomSeeds(seed, seed2));
+}
+
+namespace {
+
+REGISTER_KERNEL_BUILDER(Name("IndexedTFRecordDataset").Device(DEVICE_CPU),
+                        IndexedTFRecordDatasetOp);
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
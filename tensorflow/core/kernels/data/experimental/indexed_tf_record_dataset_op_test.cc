@@ -0,0 +1,157 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/experimental/indexed_tf_record_dataset_op.h"
+
+#include "tensorflow/core/data/dataset_test_base.h"
+#include "tensorflow/core/lib/io/record_index.h"
+
+namespace tensorflow {
+namespace data {
+namespace experimental {
+namespace {
+
+constexpr char kNodeName[] = "indexed_tf_record_dataset";
+
+class IndexedTFRecordDatasetParams : public DatasetParams {
+ public:
+  IndexedTFRecordDatasetParams(std::vector<tstring> filenames,
+                               int64_t num_shards, int64_t shard_index,
+                               bool shuffle, string node_name)
+      : DatasetParams({DT_STRING}, {PartialTensorShape({})},
+                      std::move(node_name)),
+        filenames_(std::move(filenames)),
+        num_shards_(num_shards),
+        shard_index_(shard_index),
+        shuffle_(shuffle) {}
+
+  std::vector<Tensor> GetInputTensors() const override {
+    int num_files = filenames_.size();
+    return {CreateTensor<tstring>(TensorShape({num_files}), filenames_),
+            CreateTensor<int64_t>(TensorShape({}), {num_shards_}),
+            CreateTensor<int64_t>(TensorShape({}), {shard_index_}),
+            CreateTensor<int64_t>(TensorShape({}), {/*seed=*/42}),
+            CreateTensor<int64_t>(TensorShape({}), {/*seed2=*/7})};
+  }
+
+  Status GetInputNames(std::vector<string>* input_names) const override {
+    *input_names = {IndexedTFRecordDatasetOp::kFileNames,
+                    IndexedTFRecordDatasetOp::kNumShards,
+                    IndexedTFRecordDatasetOp::kShardIndex,
+                    IndexedTFRecordDatasetOp::kSeed,
+                    IndexedTFRecordDatasetOp::kSeed2};
+    return OkStatus();
+  }
+
+  Status GetAttributes(AttributeVector* attr_vector) const override {
+    *attr_vector = {{IndexedTFRecordDatasetOp::kShuffle, shuffle_},
+                    {"metadata", ""}};
+    return OkStatus();
+  }
+
+  string dataset_type() const override {
+    return IndexedTFRecordDatasetOp::kDatasetType;
+  }
+
+ private:
+  std::vector<tstring> filenames_;
+  int64_t num_shards_;
+  int64_t shard_index_;
+  bool shuffle_;
+};
+
+class IndexedTFRecordDatasetOpTest : public DatasetOpsTestBase {};
+
+// Writes two uncompressed TFRecord files. Only the first one gets an index,
+// so the other one is scanned.
+std::vector<tstring> CreateTestFiles() {
+  std::vector<tstring> filenames = {
+      absl::StrCat(testing::TmpDir(), "/indexed_tf_record_1"),
+      absl::StrCat(testing::TmpDir(), "/indexed_tf_record_2")};
+  std::vector<std::vector<absl::string_view>> contents = {
+      {"1", "22", "333"}, {"a", "bb", "ccc", "dddd"}};
+  CompressionParams params;
+  params.compression_type = CompressionType::UNCOMPRESSED;
+  for (int i = 0; i < filenames.size(); ++i) {
+    TF_CHECK_OK(WriteDataToTFRecordFile(filenames[i], contents[i], params));
+  }
+  io::RecordIndex index;
+  for (absl::string_view record : contents[0]) {
+    index.Add(record.size());
+  }
+  TF_CHECK_OK(index.Write(Env::Default(),
+                          io::RecordIndex::SidecarFilename(filenames[0])));
+  Env::Default()
+      ->DeleteFile(io::RecordIndex::SidecarFilename(filenames[1]))
+      .IgnoreError();
+  return filenames;
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, AllRecordsInOrder) {
+  auto dataset_params = IndexedTFRecordDatasetParams(
+      CreateTestFiles(), /*num_shards=*/1, /*shard_index=*/0,
+      /*shuffle=*/false, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(7));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}), {{"1"},
+                                               {"22"},
+                                               {"333"},
+                                               {"a"},
+                                               {"bb"},
+                                               {"ccc"},
+                                               {"dddd"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, ShardSpansFiles) {
+  auto dataset_params = IndexedTFRecordDatasetParams(
+      CreateTestFiles(), /*num_shards=*/3, /*shard_index=*/1,
+      /*shuffle=*/false, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(2));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}), {{"22"}, {"bb"}}),
+      /*compare_order=*/true));
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, ShuffleIsAPermutation) {
+  auto dataset_params = IndexedTFRecordDatasetParams(
+      CreateTestFiles(), /*num_shards=*/1, /*shard_index=*/0,
+      /*shuffle=*/true, kNodeName);
+  TF_ASSERT_OK(Initialize(dataset_params));
+  TF_ASSERT_OK(CheckDatasetCardinality(7));
+  TF_ASSERT_OK(CheckIteratorGetNext(
+      CreateTensors<tstring>(TensorShape({}), {{"1"},
+                                               {"22"},
+                                               {"333"},
+                                               {"a"},
+                                               {"bb"},
+                                               {"ccc"},
+                                               {"dddd"}}),
+      /*compare_order=*/false));
+}
+
+TEST_F(IndexedTFRecordDatasetOpTest, InvalidShardIndex) {
+  auto dataset_params = IndexedTFRecordDatasetParams(
+      CreateTestFiles(), /*num_shards=*/2, /*shard_index=*/2,
+      /*shuffle=*/false, kNodeName);
+  EXPECT_EQ(Initialize(dataset_params).code(),
+            tensorflow::error::INVALID_ARGUMENT);
+}
+
+}  // namespace
+}  // namespace experimental
+}  // namespace data
+}  // namespace tensorflow
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 #include <deque>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/data/dataset_utils.h"
@@ -42,6 +43,70 @@ constexpr char kErrorMessage[] = ".error_message";
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
+// Maximum number of output tensors kept per dense feature by
+// `DenseOutputPool`. This bounds the memory held by idle pooled tensors.
+constexpr int kMaxPooledDenseOutputs = 16;
+
+// Recycles the output tensors of fixed-length dense features across batches,
+// so that parsing a batch does not allocate them. A pooled tensor is handed out
+// again only once its buffer is no longer referenced outside of the pool, i.e.
+// once the consumers of the batch that it was returned in have released it.
+class DenseOutputPool {
+ public:
+  explicit DenseOutputPool(const example::FastParseExampleConfig& config)
+      : config_(config), pool_(config.dense.size()) {}
+
+  // Returns one output tensor per dense feature for a batch of `batch_size`
+  // examples. Entries of variable-length features are left uninitialized.
+  std::vector<Tensor> Get(int64_t batch_size) TF_LOCKS_EXCLUDED(mu_) {
+    std::vector<Tensor> outputs(config_.dense.size());
+    mutex_lock l(mu_);
+    for (size_t d = 0; d < config_.dense.size(); ++d) {
+      if (config_.dense[d].variable_length) {
+        continue;
+      }
+      TensorShape shape({batch_size});
+      for (const int64_t dim : config_.dense[d].shape.dim_sizes()) {
+        shape.AddDim(dim);
+      }
+      if (shape.num_elements() == 0) {
+        continue;
+      }
+      outputs[d] = GetLocked(d, config_.dense[d].dtype, shape);
+    }
+    return outputs;
+  }
+
+ private:
+  Tensor GetLocked(size_t d, DataType dtype, const TensorShape& shape)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    std::vector<Tensor>& pooled = pool_[d];
+    Tensor* unused = nullptr;
+    for (Tensor& tensor : pooled) {
+      if (!tensor.RefCountIsOne()) {
+        continue;
+      }
+      if (tensor.dtype() == dtype && tensor.shape() == shape) {
+        return tensor;
+      }
+      unused = &tensor;
+    }
+    Tensor tensor(dtype, shape);
+    if (pooled.size() < kMaxPooledDenseOutputs) {
+      pooled.push_back(tensor);
+    } else if (unused != nullptr) {
+      // Replaces a tensor of a different shape, e.g. from a final partial
+      // batch.
+      *unused = tensor;
+    }
+    return tensor;
+  }
+
+  const example::FastParseExampleConfig& config_;
+  mutex mu_;
+  std::vector<std::vector<Tensor>> pool_ TF_GUARDED_BY(mu_);
+};
+
 class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
  public:
   static constexpr const char* const kDatasetType = "ParseExample";
@@ -371,8 +436,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
                 params.dataset->num_parallel_calls_, mu_, cond_var_)),
             deterministic_(params.dataset->deterministic_.IsDeterministic() ||
                            params.dataset->deterministic_.IsDefault()),
-            autotune_(params.dataset->num_parallel_calls_ == model::kAutotune) {
-      }
+            autotune_(params.dataset->num_parallel_calls_ == model::kAutotune),
+            dense_output_pool_(params.dataset->config_) {}
 
       ~Iterator() override {
         CancelThreads(/*wait=*/true);
@@ -666,7 +731,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
         }
         example::Result example_result;
         TF_RETURN_IF_ERROR(FastParseExample(
-            config, slice_vec, {}, device_threadpool, &example_result));
+            config, slice_vec, {}, device_threadpool,
+            dense_output_pool_.Get(slice_vec.size()), &example_result));
         (*output).resize(dataset()->key_to_output_index_.size());
         for (int d = 0; d < dataset()->dense_keys_.size(); ++d) {
           int output_index =
@@ -901,6 +967,8 @@ class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
       const std::shared_ptr<model::SharedState> num_parallel_calls_;
       const bool deterministic_;
       const bool autotune_;
+      // Provides the outputs of fixed-length dense features.
+      DenseOutputPool dense_output_pool_;
       // Counts the number of outstanding calls.
       int64_t num_calls_ TF_GUARDED_BY(*mu_) = 0;
       std::unique_ptr<IteratorBase> input_impl_;
@@ -837,6 +837,9 @@ constexpr char kEndOfSequence[] = "end_of_sequence";
 constexpr char kBuffer[] = "buffer";
 constexpr char kNumElementsWritten[] = "num_elements_written";
 constexpr char kNextElem[] = "next_elem";
+// The number of elements that each reader thread of `SnapshotDataset` decodes
+// in parallel. Only applies to snapshot files with snappy compression.
+constexpr char kNumParallelDecodes[] = "_num_parallel_decodes";
 
 class SnapshotDatasetOp : public UnaryDatasetOpKernel {
  public:
@@ -877,6 +880,14 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       OP_REQUIRES_OK(ctx, ctx->GetAttr("snapshot_name", &snapshot_name_));
     }
 
+    if (ctx->HasAttr(kNumParallelDecodes)) {
+      OP_REQUIRES_OK(ctx,
+                     ctx->GetAttr(kNumParallelDecodes, &num_parallel_decodes_));
+      OP_REQUIRES(ctx, num_parallel_decodes_ >= 1,
+                  errors::InvalidArgument(kNumParallelDecodes,
+                                          " must be at least 1."));
+    }
+
     if (shard_size_bytes_ == -1) shard_size_bytes_ = kDefaultShardSizeBytes;
 
     // Default to 1 day expiry for snapshots.
@@ -949,7 +960,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
                           pending_snapshot_expiry_seconds_, num_reader_threads_,
                           reader_buffer_size_, num_writer_threads_,
                           writer_buffer_size_, shuffle_on_read_, seed_, seed2_,
-                          mode_, snapshot_name_);
+                          mode_, snapshot_name_, num_parallel_decodes_);
   }
 
  private:
@@ -963,7 +974,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
             const uint64 num_reader_threads, const uint64 reader_buffer_size,
             const uint64 num_writer_threads, const uint64 writer_buffer_size,
             const bool shuffle_on_read, const uint64 seed, const uint64 seed2,
-            const std::string& mode, const std::string& snapshot_name)
+            const std::string& mode, const std::string& snapshot_name,
+            const int64_t num_parallel_decodes)
         : DatasetBase(DatasetContext(ctx)),
           input_(input),
           dir_(path),
@@ -981,7 +993,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           seed_(seed),
           seed2_(seed2),
           mode_(mode),
-          snapshot_name_(snapshot_name) {
+          snapshot_name_(snapshot_name),
+          num_parallel_decodes_(num_parallel_decodes) {
       input_->Ref();
     }
 
@@ -1076,29 +1089,35 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
       AttrValue snapshot_name_attr;
       b->BuildAttrValue(snapshot_name_, &snapshot_name_attr);
 
+      std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+          {"compression", compression_attr},
+          {"reader_path_prefix", reader_path_prefix_attr},
+          {"writer_path_prefix", writer_path_prefix_attr},
+          {"shard_size_bytes", shard_size_bytes_attr},
+          {"pending_snapshot_expiry_seconds",
+           pending_snapshot_expiry_seconds_attr},
+          {"num_reader_threads", num_reader_threads_attr},
+          {"reader_buffer_size", reader_buffer_size_attr},
+          {"num_writer_threads", num_writer_threads_attr},
+          {"writer_buffer_size", writer_buffer_size_attr},
+          {"shuffle_on_read", shuffle_on_read_attr},
+          {"seed", seed_attr},
+          {"seed2", seed2_attr},
+          {"mode", mode_attr},
+          {"snapshot_name", snapshot_name_attr}};
+      if (num_parallel_decodes_ > 1) {
+        AttrValue num_parallel_decodes_attr;
+        b->BuildAttrValue(num_parallel_decodes_, &num_parallel_decodes_attr);
+        attrs.emplace_back(kNumParallelDecodes, num_parallel_decodes_attr);
+      }
+
       TF_RETURN_IF_ERROR(b->AddDataset(
           this,
           /*inputs=*/
           {std::make_pair(0, input_graph_node), std::make_pair(1, path)},
           /*list_inputs=*/
           {},
-          /*attrs=*/
-          {{"compression", compression_attr},
-           {"reader_path_prefix", reader_path_prefix_attr},
-           {"writer_path_prefix", writer_path_prefix_attr},
-           {"shard_size_bytes", shard_size_bytes_attr},
-           {"pending_snapshot_expiry_seconds",
-            pending_snapshot_expiry_seconds_attr},
-           {"num_reader_threads", num_reader_threads_attr},
-           {"reader_buffer_size", reader_buffer_size_attr},
-           {"num_writer_threads", num_writer_threads_attr},
-           {"writer_buffer_size", writer_buffer_size_attr},
-           {"shuffle_on_read", shuffle_on_read_attr},
-           {"seed", seed_attr},
-           {"seed2", seed2_attr},
-           {"mode", mode_attr},
-           {"snapshot_name", snapshot_name_attr}},
-          output));
+          /*attrs=*/attrs, output));
       return OkStatus();
     }
 
@@ -1491,7 +1510,8 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
           std::unique_ptr<snapshot_util::Reader> reader;
           TF_RETURN_IF_ERROR(snapshot_util::Reader::Create(
               env, filename, dataset()->compression_, version_,
-              dataset()->output_dtypes(), &reader));
+              dataset()->output_dtypes(), dataset()->num_parallel_decodes_,
+              &reader));
           while (true) {
             // Wait for a slot in the buffer.
             {
@@ -2271,6 +2291,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
     const std::string mode_;
     const std::string snapshot_name_;
+    const int64_t num_parallel_decodes_;
   };
 
   Status ComputeDatasetHash(const GraphDef& graph_def, const std::string& path,
@@ -2307,6 +2328,7 @@ class SnapshotDatasetOp : public UnaryDatasetOpKernel {
 
   std::string mode_;
   std::string snapshot_name_;
+  int64_t num_parallel_decodes_ = 1;
 };
 
 REGISTER_KERNEL_BUILDER(Name("SnapshotDataset").Device(DEVICE_CPU),
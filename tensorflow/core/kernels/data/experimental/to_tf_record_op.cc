@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/record_index.h"
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/file_system.h"
 #include "tensorflow/core/platform/resource.h"
@@ -34,7 +35,11 @@ class ToTFRecordOp : public AsyncOpKernel {
  public:
   explicit ToTFRecordOp(OpKernelConstruction* ctx)
       : AsyncOpKernel(ctx),
-        background_worker_(ctx->env(), "tf_data_to_tf_record") {}
+        background_worker_(ctx->env(), "tf_data_to_tf_record") {
+    if (ctx->HasAttr(kWriteIndex)) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr(kWriteIndex, &write_index_));
+    }
+  }
 
   template <typename T>
   Status ParseScalarArgument(OpKernelContext* ctx,
@@ -69,9 +74,16 @@ class ToTFRecordOp : public AsyncOpKernel {
                                                     &compression_type));
     std::unique_ptr<WritableFile> file;
     TF_RETURN_IF_ERROR(ctx->env()->NewWritableFile(filename, &file));
-    auto writer = std::make_unique<io::RecordWriter>(
-        file.get(),
-        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type));
+    const io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type);
+    if (write_index_ &&
+        options.compression_type != io::RecordWriterOptions::NONE) {
+      return errors::InvalidArgument(
+          "`", kWriteIndex, "` requires an uncompressed file, but got ",
+          "compression type \"", compression_type, "\"");
+    }
+    auto writer = std::make_unique<io::RecordWriter>(file.get(), options);
+    io::RecordIndex index;
 
     DatasetBase* dataset;
     TF_RETURN_IF_ERROR(GetDatasetFromVariantTensor(ctx->input(0), &dataset));
@@ -113,15 +125,27 @@ class ToTFRecordOp : public AsyncOpKernel {
           iterator->GetNext(&iter_ctx, &components, &end_of_sequence));
 
       if (!end_of_sequence) {
-        TF_RETURN_IF_ERROR(
-            writer->WriteRecord(components[0].scalar<tstring>()()));
+        const tstring& record = components[0].scalar<tstring>()();
+        TF_RETURN_IF_ERROR(writer->WriteRecord(record));
+        index.Add(record.size());
       }
       components.clear();
     } while (!end_of_sequence);
+    if (write_index_) {
+      TF_RETURN_IF_ERROR(writer->Close());
+      TF_RETURN_IF_ERROR(file->Close());
+      TF_RETURN_IF_ERROR(index.Write(
+          ctx->env(), io::RecordIndex::SidecarFilename(filename)));
+    }
     return OkStatus();
   }
 
+  // If set, an `io::RecordIndex` of the records is written next to the file,
+  // for reading it with `IndexedTFRecordDataset`.
+  static constexpr const char* const kWriteIndex = "_write_index";
+
   BackgroundWorker background_worker_;
+  bool write_index_ = false;
 };
 
 REGISTER_KERNEL_BUILDER(Name("DatasetToTFRecord").Device(DEVICE_CPU),
@@ -85,6 +85,11 @@ class FilterDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override {
+    // Stateful functions may not produce the same elements when replayed.
+    return captured_func_->CheckExternalState().ok();
+  }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -99,6 +99,11 @@ class MapDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override {
+    // Stateful functions may not produce the same elements when replayed.
+    return captured_func_->CheckExternalState().ok();
+  }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
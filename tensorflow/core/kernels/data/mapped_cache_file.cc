@@ -0,0 +1,322 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/mapped_cache_file.h"
+
+#include <cstring>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kMagic[] = "TFMCACHE";
+constexpr int64_t kMagicSize = 8;
+constexpr uint32 kVersion = 1;
+constexpr int64_t kHeaderSize = kMappedCacheAlignment;
+// Index offset, number of elements, version and magic.
+constexpr int64_t kFooterSize = 3 * sizeof(uint64) + kMagicSize;
+
+enum Encoding : uint32 { kRaw = 0, kTensorProto = 1 };
+
+int64_t Align(int64_t position) {
+  return (position + kMappedCacheAlignment - 1) / kMappedCacheAlignment *
+         kMappedCacheAlignment;
+}
+
+// A tensor buffer that references memory of a mapped file. Since the memory
+// is read-only, the buffer does not claim to own it, which prevents kernels
+// from forwarding it to their outputs and writing to it.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(core::RefCounted* region, const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)), region_(region), size_(size) {
+    region_->Ref();
+  }
+  ~MappedTensorBuffer() override { region_->Unref(); }
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("mapped_cache_file");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  core::RefCounted* const region_;
+  const size_t size_;
+};
+
+// Reads fixed-size integers from a record, checking its bounds.
+class RecordParser {
+ public:
+  RecordParser(const char* data, int64_t size) : data_(data), size_(size) {}
+
+  bool ReadFixed32(uint32* value) {
+    if (position_ + 4 > size_) return false;
+    *value = core::DecodeFixed32(data_ + position_);
+    position_ += 4;
+    return true;
+  }
+
+  bool ReadFixed64(int64_t* value) {
+    if (position_ + 8 > size_) return false;
+    *value = core::DecodeFixed64(data_ + position_);
+    position_ += 8;
+    return true;
+  }
+
+ private:
+  const char* const data_;
+  const int64_t size_;
+  int64_t position_ = 0;
+};
+
+}  // namespace
+
+class MappedCacheFileReader::Region : public core::RefCounted {
+ public:
+  explicit Region(std::unique_ptr<ReadOnlyMemoryRegion> region)
+      : region_(std::move(region)) {}
+
+  const char* data() const { return static_cast<const char*>(region_->data()); }
+  int64_t length() const { return region_->length(); }
+
+ private:
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+};
+
+/* static */ Status MappedCacheFileWriter::Create(
+    Env* env, const std::string& filename,
+    std::unique_ptr<MappedCacheFileWriter>* writer) {
+  const std::string temp_filename = strings::StrCat(filename, ".tmp");
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(temp_filename, &file));
+  writer->reset(
+      new MappedCacheFileWriter(env, filename, temp_filename, std::move(file)));
+  std::string header(kMagic, kMagicSize);
+  core::PutFixed32(&header, kVersion);
+  return (*writer)->AppendAligned(header);
+}
+
+Status MappedCacheFileWriter::Add(const std::vector<Tensor>& element) {
+  std::vector<std::string> serialized(element.size());
+  std::vector<StringPiece> data(element.size());
+  int64_t header_size = sizeof(uint32);
+  for (int i = 0; i < element.size(); ++i) {
+    const Tensor& t = element[i];
+    header_size += 3 * sizeof(uint32) + (t.dims() + 2) * sizeof(uint64);
+    if (DataTypeCanUseMemcpy(t.dtype())) {
+      data[i] = t.tensor_data();
+    } else {
+      TensorProto proto;
+      t.AsProtoTensorContent(&proto);
+      if (!proto.SerializeToString(&serialized[i])) {
+        return errors::Internal("Failed to serialize tensor of shape ",
+                                t.shape().DebugString(), " to the cache.");
+      }
+      data[i] = serialized[i];
+    }
+  }
+
+  std::string header;
+  core::PutFixed32(&header, element.size());
+  int64_t data_offset = Align(header_size);
+  for (int i = 0; i < element.size(); ++i) {
+    const Tensor& t = element[i];
+    core::PutFixed32(&header, t.dtype());
+    core::PutFixed32(&header, DataTypeCanUseMemcpy(t.dtype()) ? kRaw
+                                                               : kTensorProto);
+    core::PutFixed32(&header, t.dims());
+    for (int64_t dim : t.shape().dim_sizes()) {
+      core::PutFixed64(&header, dim);
+    }
+    core::PutFixed64(&header, data_offset);
+    core::PutFixed64(&header, data[i].size());
+    data_offset = Align(data_offset + data[i].size());
+  }
+  DCHECK_EQ(header.size(), header_size);
+
+  offsets_.push_back(position_);
+  TF_RETURN_IF_ERROR(AppendAligned(header));
+  for (StringPiece component : data) {
+    TF_RETURN_IF_ERROR(AppendAligned(component));
+  }
+  return OkStatus();
+}
+
+Status MappedCacheFileWriter::Finish() {
+  std::string index;
+  for (int64_t offset : offsets_) {
+    core::PutFixed64(&index, offset);
+  }
+  const int64_t index_offset = position_;
+  core::PutFixed64(&index, index_offset);
+  core::PutFixed64(&index, offsets_.size());
+  core::PutFixed64(&index, kVersion);
+  index.append(kMagic, kMagicSize);
+  TF_RETURN_IF_ERROR(file_->Append(index));
+  TF_RETURN_IF_ERROR(file_->Close());
+  return env_->RenameFile(temp_filename_, filename_);
+}
+
+Status MappedCacheFileWriter::AppendAligned(StringPiece data) {
+  static const char kPadding[kMappedCacheAlignment] = {0};
+  TF_RETURN_IF_ERROR(file_->Append(data));
+  const int64_t padding = Align(data.size()) - data.size();
+  if (padding > 0) {
+    TF_RETURN_IF_ERROR(file_->Append(StringPiece(kPadding, padding)));
+  }
+  position_ += data.size() + padding;
+  return OkStatus();
+}
+
+/* static */ Status MappedCacheFileReader::Open(
+    Env* env, const std::string& filename,
+    std::unique_ptr<MappedCacheFileReader>* reader) {
+  std::unique_ptr<ReadOnlyMemoryRegion> mapping;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(filename, &mapping));
+  core::RefCountPtr<Region> region(new Region(std::move(mapping)));
+  const char* data = region->data();
+  const int64_t length = region->length();
+  if (length < kHeaderSize + kFooterSize ||
+      memcmp(data, kMagic, kMagicSize) != 0 ||
+      memcmp(data + length - kMagicSize, kMagic, kMagicSize) != 0) {
+    return errors::DataLoss(filename, " is not a mapped cache file.");
+  }
+  const char* footer = data + length - kFooterSize;
+  const int64_t index_offset = core::DecodeFixed64(footer);
+  const int64_t num_elements = core::DecodeFixed64(footer + 8);
+  const int64_t version = core::DecodeFixed64(footer + 16);
+  if (version != kVersion) {
+    return errors::FailedPrecondition("Unsupported version ", version,
+                                      " of mapped cache file ", filename, ".");
+  }
+  if (index_offset < kHeaderSize || num_elements < 0 ||
+      index_offset + num_elements * 8 != length - kFooterSize) {
+    return errors::DataLoss("Corrupted index in mapped cache file ", filename,
+                            ".");
+  }
+  reader->reset(new MappedCacheFileReader(filename, region.release(),
+                                          data + index_offset, index_offset,
+                                          num_elements));
+  return OkStatus();
+}
+
+/* static */ Status MappedCacheFileReader::OpenAll(
+    Env* env, const std::vector<std::string>& filenames,
+    const std::function<void(std::function<void()>)>& runner,
+    std::vector<std::unique_ptr<MappedCacheFileReader>>* readers) {
+  readers->clear();
+  readers->resize(filenames.size());
+  std::vector<Status> statuses(filenames.size());
+  BlockingCounter counter(filenames.size());
+  for (int i = 0; i < filenames.size(); ++i) {
+    runner([&, i]() {
+      statuses[i] = Open(env, filenames[i], &(*readers)[i]);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return OkStatus();
+}
+
+MappedCacheFileReader::~MappedCacheFileReader() { region_->Unref(); }
+
+Status MappedCacheFileReader::Read(int64_t index,
+                                   std::vector<Tensor>* element) const {
+  if (index < 0 || index >= num_elements_) {
+    return errors::OutOfRange("Element ", index, " is out of range for ",
+                              filename_, ", which has ", num_elements_,
+                              " elements.");
+  }
+  const int64_t begin = core::DecodeFixed64(index_ + index * 8);
+  const int64_t end = index + 1 < num_elements_
+                          ? core::DecodeFixed64(index_ + (index + 1) * 8)
+                          : index_offset_;
+  if (begin < kHeaderSize || end < begin || end > index_offset_) {
+    return errors::DataLoss("Corrupted index in mapped cache file ", filename_,
+                            ".");
+  }
+  const char* record = region_->data() + begin;
+  const int64_t record_size = end - begin;
+  auto corrupted = [&]() {
+    return errors::DataLoss("Corrupted element ", index,
+                            " in mapped cache file ", filename_, ".");
+  };
+
+  RecordParser parser(record, record_size);
+  uint32 num_components;
+  if (!parser.ReadFixed32(&num_components)) return corrupted();
+  element->clear();
+  element->reserve(num_components);
+  for (uint32 i = 0; i < num_components; ++i) {
+    uint32 dtype, encoding, rank;
+    if (!parser.ReadFixed32(&dtype) || !parser.ReadFixed32(&encoding) ||
+        !parser.ReadFixed32(&rank) || rank > TensorShape::MaxDimensions()) {
+      return corrupted();
+    }
+    int64_t dims[TensorShape::MaxDimensions()];
+    for (uint32 d = 0; d < rank; ++d) {
+      if (!parser.ReadFixed64(&dims[d])) return corrupted();
+    }
+    int64_t offset, length;
+    if (!parser.ReadFixed64(&offset) || !parser.ReadFixed64(&length) ||
+        offset < 0 || length < 0 || offset + length > record_size) {
+      return corrupted();
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(TensorShapeUtils::MakeShape(dims, rank, &shape));
+    const DataType type = static_cast<DataType>(dtype);
+    if (encoding == kRaw) {
+      if (!DataTypeCanUseMemcpy(type) ||
+          length != shape.num_elements() * DataTypeSize(type)) {
+        return corrupted();
+      }
+      if (length == 0) {
+        element->emplace_back(type, shape);
+        continue;
+      }
+      TensorBuffer* buffer =
+          new MappedTensorBuffer(region_, record + offset, length);
+      element->emplace_back(type, shape, buffer);
+      buffer->Unref();
+    } else if (encoding == kTensorProto) {
+      TensorProto proto;
+      element->emplace_back();
+      if (!proto.ParseFromArray(record + offset, length) ||
+          !element->back().FromProto(proto)) {
+        return corrupted();
+      }
+    } else {
+      return corrupted();
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,117 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_MAPPED_CACHE_FILE_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_MAPPED_CACHE_FILE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// A cache file format that can be read without copies through a memory
+// mapping.
+//
+// The file is a header, followed by one record per element, an index of the
+// offsets of the records and a footer. Records and the data of the tensors
+// they contain are aligned to `kMappedCacheAlignment` bytes, so tensors of
+// types that can be copied with `memcpy` are served directly from the mapping.
+// Other tensors are stored as serialized `TensorProto`s.
+constexpr int64_t kMappedCacheAlignment = 64;
+
+// Writes a mapped cache file. The file only appears under its name once
+// `Finish()` succeeds.
+class MappedCacheFileWriter {
+ public:
+  static Status Create(Env* env, const std::string& filename,
+                       std::unique_ptr<MappedCacheFileWriter>* writer);
+
+  Status Add(const std::vector<Tensor>& element);
+
+  // Writes the index and footer, and moves the file to its final name.
+  Status Finish();
+
+  int64_t num_elements() const { return offsets_.size(); }
+
+ private:
+  MappedCacheFileWriter(Env* env, const std::string& filename,
+                        const std::string& temp_filename,
+                        std::unique_ptr<WritableFile> file)
+      : env_(env),
+        filename_(filename),
+        temp_filename_(temp_filename),
+        file_(std::move(file)) {}
+
+  // Appends `data`, followed by padding up to the next aligned position.
+  Status AppendAligned(StringPiece data);
+
+  Env* const env_;
+  const std::string filename_;
+  const std::string temp_filename_;
+  std::unique_ptr<WritableFile> file_;
+  int64_t position_ = 0;
+  std::vector<int64_t> offsets_;
+};
+
+// Reads a mapped cache file. Tensors returned by `Read()` may reference the
+// mapping, which stays alive as long as they do. This class is thread-safe.
+class MappedCacheFileReader {
+ public:
+  static Status Open(Env* env, const std::string& filename,
+                     std::unique_ptr<MappedCacheFileReader>* reader);
+
+  // Opens several files concurrently, using `runner` to schedule the work.
+  static Status OpenAll(
+      Env* env, const std::vector<std::string>& filenames,
+      const std::function<void(std::function<void()>)>& runner,
+      std::vector<std::unique_ptr<MappedCacheFileReader>>* readers);
+
+  ~MappedCacheFileReader();
+
+  int64_t num_elements() const { return num_elements_; }
+
+  Status Read(int64_t index, std::vector<Tensor>* element) const;
+
+ private:
+  class Region;
+
+  MappedCacheFileReader(const std::string& filename, Region* region,
+                        const char* index, int64_t index_offset,
+                        int64_t num_elements)
+      : filename_(filename),
+        region_(region),
+        index_(index),
+        index_offset_(index_offset),
+        num_elements_(num_elements) {}
+
+  const std::string filename_;
+  Region* const region_;  // Owns a reference.
+  const char* const index_;
+  const int64_t index_offset_;
+  const int64_t num_elements_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_MAPPED_CACHE_FILE_H_
@@ -0,0 +1,186 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/mapped_cache_file.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+std::vector<Tensor> MakeElement(int64_t i) {
+  return {test::AsScalar<int64_t>(i),
+          test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i}, {3, 1}),
+          test::AsTensor<tstring>({absl::StrCat("element_", i), ""})};
+}
+
+void ExpectElement(const std::vector<Tensor>& element, int64_t i) {
+  ASSERT_EQ(element.size(), 3);
+  test::ExpectEqual(element[0], test::AsScalar<int64_t>(i));
+  test::ExpectEqual(element[1], test::AsTensor<float>(
+                                    {1.0f * i, 2.0f * i, 3.0f * i}, {3, 1}));
+  test::ExpectEqual(element[2],
+                    test::AsTensor<tstring>({absl::StrCat("element_", i), ""}));
+}
+
+std::string TestFilename(const std::string& suffix) {
+  return io::JoinPath(
+      testing::TmpDir(),
+      absl::StrCat(
+          ::testing::UnitTest::GetInstance()->current_test_info()->name(),
+          suffix, ".mcache"));
+}
+
+Status WriteFile(const std::string& filename, int64_t num_elements) {
+  std::unique_ptr<MappedCacheFileWriter> writer;
+  TF_RETURN_IF_ERROR(
+      MappedCacheFileWriter::Create(Env::Default(), filename, &writer));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    TF_RETURN_IF_ERROR(writer->Add(MakeElement(i)));
+  }
+  return writer->Finish();
+}
+
+TEST(MappedCacheFileTest, RoundTrip) {
+  const std::string filename = TestFilename("");
+  std::unique_ptr<MappedCacheFileWriter> writer;
+  TF_ASSERT_OK(
+      MappedCacheFileWriter::Create(Env::Default(), filename, &writer));
+  for (int64_t i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(writer->Add(MakeElement(i)));
+  }
+  // The file only appears once complete.
+  EXPECT_TRUE(errors::IsNotFound(Env::Default()->FileExists(filename)));
+  TF_ASSERT_OK(writer->Finish());
+  EXPECT_EQ(writer->num_elements(), 10);
+
+  std::unique_ptr<MappedCacheFileReader> reader;
+  TF_ASSERT_OK(MappedCacheFileReader::Open(Env::Default(), filename, &reader));
+  ASSERT_EQ(reader->num_elements(), 10);
+  // Elements can be read in any order.
+  for (int64_t i = 9; i >= 0; --i) {
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(reader->Read(i, &element));
+    ExpectElement(element, i);
+  }
+}
+
+TEST(MappedCacheFileTest, EmptyTensorsAndElements) {
+  const std::string filename = TestFilename("");
+  std::unique_ptr<MappedCacheFileWriter> writer;
+  TF_ASSERT_OK(
+      MappedCacheFileWriter::Create(Env::Default(), filename, &writer));
+  TF_ASSERT_OK(writer->Add({Tensor(DT_FLOAT, TensorShape({0, 4}))}));
+  TF_ASSERT_OK(writer->Add({}));
+  TF_ASSERT_OK(writer->Finish());
+
+  std::unique_ptr<MappedCacheFileReader> reader;
+  TF_ASSERT_OK(MappedCacheFileReader::Open(Env::Default(), filename, &reader));
+  ASSERT_EQ(reader->num_elements(), 2);
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(reader->Read(0, &element));
+  ASSERT_EQ(element.size(), 1);
+  EXPECT_EQ(element[0].dtype(), DT_FLOAT);
+  EXPECT_EQ(element[0].shape(), TensorShape({0, 4}));
+  TF_ASSERT_OK(reader->Read(1, &element));
+  EXPECT_TRUE(element.empty());
+}
+
+TEST(MappedCacheFileTest, TensorsAliasTheMapping) {
+  const std::string filename = TestFilename("");
+  TF_ASSERT_OK(WriteFile(filename, 2));
+
+  std::unique_ptr<MappedCacheFileReader> reader;
+  TF_ASSERT_OK(MappedCacheFileReader::Open(Env::Default(), filename, &reader));
+  std::vector<Tensor> first, second;
+  TF_ASSERT_OK(reader->Read(1, &first));
+  TF_ASSERT_OK(reader->Read(1, &second));
+  // Numeric tensors are not copied out of the file, and are aligned.
+  EXPECT_EQ(first[1].tensor_data().data(), second[1].tensor_data().data());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first[1].tensor_data().data()) %
+                kMappedCacheAlignment,
+            0);
+
+  // Tensors keep the mapping alive.
+  reader.reset();
+  ExpectElement(first, 1);
+}
+
+TEST(MappedCacheFileTest, OutOfRange) {
+  const std::string filename = TestFilename("");
+  TF_ASSERT_OK(WriteFile(filename, 3));
+  std::unique_ptr<MappedCacheFileReader> reader;
+  TF_ASSERT_OK(MappedCacheFileReader::Open(Env::Default(), filename, &reader));
+  std::vector<Tensor> element;
+  EXPECT_TRUE(errors::IsOutOfRange(reader->Read(3, &element)));
+  EXPECT_TRUE(errors::IsOutOfRange(reader->Read(-1, &element)));
+}
+
+TEST(MappedCacheFileTest, Corrupted) {
+  const std::string filename = TestFilename("");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 std::string(256, 'x')));
+  std::unique_ptr<MappedCacheFileReader> reader;
+  EXPECT_TRUE(errors::IsDataLoss(
+      MappedCacheFileReader::Open(Env::Default(), filename, &reader)));
+
+  // A truncated file.
+  TF_ASSERT_OK(WriteFile(filename, 3));
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 contents.substr(0, contents.size() / 2)));
+  EXPECT_TRUE(errors::IsDataLoss(
+      MappedCacheFileReader::Open(Env::Default(), filename, &reader)));
+}
+
+TEST(MappedCacheFileTest, OpenAll) {
+  std::vector<std::string> filenames;
+  for (int i = 0; i < 4; ++i) {
+    filenames.push_back(TestFilename(absl::StrCat("_", i)));
+    TF_ASSERT_OK(WriteFile(filenames.back(), i + 1));
+  }
+  thread::ThreadPool pool(Env::Default(), "test", 2);
+  auto runner = [&pool](std::function<void()> fn) {
+    pool.Schedule(std::move(fn));
+  };
+  std::vector<std::unique_ptr<MappedCacheFileReader>> readers;
+  TF_ASSERT_OK(MappedCacheFileReader::OpenAll(Env::Default(), filenames,
+                                              runner, &readers));
+  ASSERT_EQ(readers.size(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(readers[i]->num_elements(), i + 1);
+  }
+
+  filenames.push_back(TestFilename("_missing"));
+  EXPECT_TRUE(errors::IsNotFound(MappedCacheFileReader::OpenAll(
+      Env::Default(), filenames, runner, &readers)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
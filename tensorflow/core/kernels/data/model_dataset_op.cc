@@ -21,14 +21,18 @@ limitations under the License.
 // dependencies are available there. The op is replaced with a no-op.
 #if !defined(IS_MOBILE_PLATFORM)
 #include "absl/memory/memory.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/util/ptr_util.h"
 
 namespace tensorflow {
@@ -38,6 +42,9 @@ namespace {
 // Default share of available RAM that can be used by model's internal buffers.
 constexpr double kRamBudgetShare = 0.5;
 
+// Period in milliseconds of the computation of the pipeline profile.
+constexpr int64_t kProfilePeriodMs = 1000;
+
 }  // namespace
 
 /* static */ constexpr const char* const ModelDatasetOp::kDatasetType;
@@ -99,6 +106,8 @@ class ModelDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -137,6 +146,13 @@ class ModelDatasetOp::Dataset : public DatasetBase {
 
     ~Iterator() override { cancellation_manager_->StartCancel(); }
 
+    // Returns the most recent profile of the input pipeline, which is
+    // recomputed every `kProfilePeriodMs` once iteration has started.
+    model::PipelineProfile GetProfile() const TF_LOCKS_EXCLUDED(profile_mu_) {
+      tf_shared_lock l(profile_mu_);
+      return profile_;
+    }
+
     Status Initialize(IteratorContext* ctx) override {
       return dataset()->input_->MakeIterator(IteratorContext(CreateParams(ctx)),
                                              this, prefix(), &input_impl_);
@@ -196,18 +212,106 @@ class ModelDatasetOp::Dataset : public DatasetBase {
           }
         });
       }
+      if (!profile_thread_) {
+        profile_thread_ = ctx->StartThread("tf_data_model_profile", [this]() {
+          Status status = ProfileLoop();
+          if (!status.ok()) {
+            LOG(WARNING) << "Profile loop failed: " << status.ToString();
+          }
+        });
+      }
       return OkStatus();
     }
 
+    // Periodically computes the profile of the input pipeline until
+    // `cancellation_manager_` is cancelled.
+    Status ProfileLoop() {
+      std::function<void()> deregister_fn;
+      TF_RETURN_IF_ERROR(RegisterCancellationCallback(
+          cancellation_manager_.get(),
+          [this]() {
+            mutex_lock l(profile_mu_);
+            profile_cond_var_.notify_all();
+          },
+          &deregister_fn));
+      auto cleanup = gtl::MakeCleanup(std::move(deregister_fn));
+      while (true) {
+        {
+          mutex_lock l(profile_mu_);
+          if (!cancellation_manager_->IsCancelled()) {
+            profile_cond_var_.wait_for(
+                l, std::chrono::milliseconds(kProfilePeriodMs));
+          }
+          if (cancellation_manager_->IsCancelled()) {
+            return OkStatus();
+          }
+        }
+        model::PipelineProfile profile;
+        Status status = model_->ComputeProfile(&profile);
+        if (!status.ok()) {
+          VLOG(2) << "Failed to compute the pipeline profile: " << status;
+          continue;
+        }
+        VLOG(3) << "Pipeline profile: " << profile.ShortDebugString();
+        RecordProfileTraceMe(profile);
+        mutex_lock l(profile_mu_);
+        profile_ = std::move(profile);
+      }
+    }
+
+    // Emits `profile` as trace events, so that the stages of the pipeline and
+    // its bottleneck show up in the profiler trace viewer.
+    void RecordProfileTraceMe(const model::PipelineProfile& profile) {
+      if (!profiler::TraceMe::Active()) {
+        return;
+      }
+      std::string critical_stage;
+      if (profile.critical_stage_index() >= 0) {
+        const model::PipelineProfile::Stage& stage =
+            profile.stages(profile.critical_stage_index());
+        critical_stage = strings::StrCat(stage.root_name(),
+                                         "(id:", stage.root_id(), ")");
+      }
+      profiler::TraceMe traceme([&] {
+        return profiler::TraceMeEncode(
+            "ModelProfile",
+            {{"critical_stage", critical_stage},
+             {"critical_path", absl::StrJoin(profile.critical_path(), ",")},
+             {"target_time_nsec", profile.target_time_nsec()}});
+      });
+      for (int i = 0; i < profile.stages_size(); ++i) {
+        const model::PipelineProfile::Stage& stage = profile.stages(i);
+        profiler::TraceMe stage_traceme([&] {
+          return profiler::TraceMeEncode(
+              "ModelProfileStage",
+              {{"root", strings::StrCat(stage.root_name(),
+                                        "(id:", stage.root_id(), ")")},
+               {"critical", i == profile.critical_stage_index()},
+               {"time_nsec", stage.time_nsec()},
+               {"utilization", stage.utilization()},
+               {"buffered_elements", stage.buffered_elements()},
+               {"buffered_bytes", stage.buffered_bytes()},
+               {"buffer_occupancy", stage.buffer_occupancy()},
+               {"average_element_bytes", stage.average_element_bytes()}});
+        });
+      }
+    }
+
     mutex mu_;
     std::shared_ptr<model::Model> model_;
     std::unique_ptr<IteratorBase> input_impl_;
     const int64_t cpu_budget_;
     const int64_t ram_budget_;
-    // Controls cancellation of `model_thread_`. Must be ordered before
-    // `model_thread_` so that `model_thread_` is destroyed first.
+    // Controls cancellation of `model_thread_` and `profile_thread_`. Must be
+    // ordered before the threads so that they are destroyed first.
     std::unique_ptr<CancellationManager> cancellation_manager_;
+    // Guards the most recent pipeline profile. Must be ordered before the
+    // threads, which use them until they are destroyed.
+    mutable mutex profile_mu_;
+    condition_variable profile_cond_var_;
+    model::PipelineProfile profile_ TF_GUARDED_BY(profile_mu_);
     std::unique_ptr<Thread> model_thread_ TF_GUARDED_BY(mu_);
+    std::unique_ptr<Thread> profile_thread_ TF_GUARDED_BY(mu_);
   };
 
   const DatasetBase* input_;
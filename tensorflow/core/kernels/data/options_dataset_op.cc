@@ -91,6 +91,8 @@ class OptionsDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -45,6 +45,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/stringprintf.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
@@ -113,11 +114,24 @@ constexpr char kParallelInterleaveDatasetV4[] = "ParallelInterleaveDatasetV4";
 // a remote file) with other computation.
 constexpr int kDefaultCyclePrefetchFactor = 2;
 
+// When the number of future cycle elements is autotuned, up to
+// `kMaxCyclePrefetchFactor * cycle_length` future cycle elements may be
+// prefetched.
+constexpr int kMaxCyclePrefetchFactor = 4;
+
 // `kPerIteratorPrefetchFactor * block_length + 1` is the default number of
 // per-iterator results that will be prefetched ahead of time. The `+ 1` is to
 // match the behavior of the original implementation.
 constexpr double kDefaultPerIteratorPrefetchFactor = 2.0L;
 
+// When the number of per-iterator results is autotuned, up to
+// `kMaxPerIteratorPrefetchFactor * block_length + 1` results may be prefetched.
+constexpr double kMaxPerIteratorPrefetchFactor = 8.0L;
+
+// Weight of the latest observation in the exponential moving averages of the
+// latency of opening an input and of the interval between exhausted inputs.
+constexpr double kInputLatencyEmaWeight = 0.1;
+
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
@@ -207,6 +221,8 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         input_cycle_length_(cycle_length),
         cycle_length_(ComputeCycleLength(cycle_length, num_parallel_calls)),
         block_length_(block_length),
+        input_buffer_output_elements_(buffer_output_elements),
+        input_prefetch_input_elements_(prefetch_input_elements),
         buffer_output_elements_(
             ComputeBufferOutputElements(buffer_output_elements, block_length)),
         prefetch_input_elements_(ComputePrefetchInputElements(
@@ -306,13 +322,15 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     inputs.emplace_back(input_index++, block_length_node);
 
     if (op_version_ >= 4) {
+      // The configured values are serialized, so that autotuning them is
+      // preserved by graph rewrites.
       Node* buffer_output_elements_node;
-      TF_RETURN_IF_ERROR(
-          b->AddScalar(buffer_output_elements_, &buffer_output_elements_node));
+      TF_RETURN_IF_ERROR(b->AddScalar(input_buffer_output_elements_,
+                                      &buffer_output_elements_node));
       inputs.emplace_back(input_index++, buffer_output_elements_node);
 
       Node* prefetch_input_elements_node;
-      TF_RETURN_IF_ERROR(b->AddScalar(prefetch_input_elements_,
+      TF_RETURN_IF_ERROR(b->AddScalar(input_prefetch_input_elements_,
                                       &prefetch_input_elements_node));
       inputs.emplace_back(input_index++, prefetch_input_elements_node);
     }
@@ -356,8 +374,22 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           num_parallel_calls_(std::make_shared<model::SharedState>(
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
+          buffer_output_elements_cond_var_(
+              std::make_shared<condition_variable>()),
+          buffer_output_elements_(std::make_shared<model::SharedState>(
+              params.dataset->input_buffer_output_elements_, mu_,
+              buffer_output_elements_cond_var_)),
+          max_prefetch_input_elements_(
+              params.dataset->input_prefetch_input_elements_ ==
+                      model::kAutotune
+                  ? std::max(params.dataset->prefetch_input_elements_,
+                             static_cast<int64_t>(
+                                 kMaxCyclePrefetchFactor *
+                                 params.dataset->cycle_length_))
+                  : params.dataset->prefetch_input_elements_),
           deterministic_(deterministic),
-          current_elements_(params.dataset->cycle_length_) {}
+          current_elements_(params.dataset->cycle_length_),
+          future_elements_target_(params.dataset->prefetch_input_elements_) {}
 
     ~ParallelInterleaveIterator() override { CancelThreads(/*wait=*/true); }
 
@@ -374,10 +406,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       //
       // Allocate one thread for the worker manager, one thread for stats
       // collection, `cycle_length_` threads for the current workers, and
-      // `future_elements_prefetch_` for the future workers.
+      // `max_prefetch_input_elements_ + cycle_length_` for the future workers.
       int max_current_workers = dataset()->cycle_length_;
       int future_workers =
-          dataset()->prefetch_input_elements_ + dataset()->cycle_length_;
+          max_prefetch_input_elements_ + dataset()->cycle_length_;
       int num_threads = 1 + max_current_workers + future_workers;
       if (ctx->stats_aggregator()) {
         num_threads++;
@@ -388,6 +420,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         num_parallel_calls_->value = std::min(
             GetAutotuneDefaultParallelism(ctx), dataset()->cycle_length_);
       }
+      if (buffer_output_elements_->value == model::kAutotune) {
+        buffer_output_elements_->value = dataset()->buffer_output_elements_;
+      }
+      // The number of future cycle elements is adapted to the observed
+      // latency of opening inputs only when it is autotuned.
+      adapt_future_elements_ =
+          ctx->model() != nullptr &&
+          dataset()->input_prefetch_input_elements_ == model::kAutotune;
       ctx_ = std::make_unique<IteratorContext>(*ctx);
       cancellation_manager_ = std::make_unique<CancellationManager>();
       IteratorContext::Params params(ctx);
@@ -453,10 +493,18 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                     static_cast<double>(dataset()->cycle_length_),
                     std::ceil(std::pow(27 * dataset()->cycle_length_, 0.5)))
               : 1;
+      const double max_buffer_output_elements = std::max(
+          static_cast<double>(dataset()->buffer_output_elements_),
+          kMaxPerIteratorPrefetchFactor * dataset()->block_length_ + 1);
       return model::MakeAsyncInterleaveManyNode(
           std::move(args),
           {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/min,
                                 /*max=*/dataset()->cycle_length_),
+           model::MakeParameter(model::kBufferOutputElements,
+                                buffer_output_elements_, /*min=*/1,
+                                /*max=*/max_buffer_output_elements),
+           model::MakeNonTunableParameter(model::kPrefetchInputElements,
+                                          dataset()->prefetch_input_elements_),
            model::MakeNonTunableParameter(kCycleLength,
                                           dataset()->cycle_length_),
            model::MakeNonTunableParameter(kDeterministic,
@@ -635,6 +683,11 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // Whether we tried to initialize the element, but the input iterator
       // was exhausted so we could produce no inputs.
       bool no_input TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) = false;
+      // Time at which the element was created, used to measure the latency
+      // of producing its first result. Reset to 0 once that latency has been
+      // recorded.
+      int64_t created_micros TF_GUARDED_BY(&ParallelInterleaveIterator::mu_) =
+          0;
       // Condition variable for communicating between current worker threads
       // and GetNext.
       condition_variable cond_var;
@@ -778,6 +831,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         // We've consumed all results from the element. Get a new element from
         // future_elements, or create a new element if no future elements are
         // available.
+        RecordInputExhausted();
         if (!future_elements_.empty()) {
           std::shared_ptr<Element> future_element =
               std::move(future_elements_.front());
@@ -787,7 +841,9 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
           }
           future_element->cycle_index = cycle_index_;
           current_elements_[cycle_index_] = std::move(future_element);
-          future_workers_cond_var_.notify_one();
+          if (future_elements_.size() < future_elements_target_) {
+            future_workers_cond_var_.notify_one();
+          }
           if (!current_elements_[cycle_index_]->active) {
             current_workers_cond_var_.notify_one();
           }
@@ -822,6 +878,7 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       }
       auto element = std::make_shared<Element>();
       element->id = element_id_counter_++;
+      element->created_micros = EnvTime::NowMicros();
       uninitialized_elements_.push_back(element);
       return element;
     }
@@ -840,10 +897,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       // the future worker which created the element may continue to process
       // the element for some time. That is why we need an additional
       // `cycle_length_` future workers to guarantee that whenever
-      // `future_element_.size() < future_elements_prefetch_`, there will be a
+      // `future_element_.size() < future_elements_target_`, there will be a
       // future worker available to create a new future element.
       int future_workers =
-          dataset()->prefetch_input_elements_ + dataset()->cycle_length_;
+          max_prefetch_input_elements_ + dataset()->cycle_length_;
       {
         mutex_lock l(*mu_);
         initial_current_workers = num_parallel_calls_->value;
@@ -986,9 +1043,9 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               current_workers_cond_var_.notify_one();
             }
           }
-          while (!cancelled_ && (future_elements_.size() >=
-                                     dataset()->prefetch_input_elements_ ||
-                                 wait_for_checkpoint_)) {
+          while (!cancelled_ &&
+                 (future_elements_.size() >= future_elements_target_ ||
+                  wait_for_checkpoint_)) {
             WaitWorkerThread(&future_workers_cond_var_, &l);
           }
           if (cancelled_) {
@@ -1055,9 +1112,13 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferEnqueue(ctx_.get(), result->return_values);
         mutex_lock l(*mu_);
+        if (element->created_micros > 0) {
+          RecordInputLatency(EnvTime::NowMicros() - element->created_micros);
+          element->created_micros = 0;
+        }
         element->results.push_back(std::move(result));
         NotifyElementUpdate(element);
-        if (element->results.size() == dataset()->buffer_output_elements_) {
+        if (element->results.size() >= buffer_output_elements_->value) {
           break;
         }
       }
@@ -1159,7 +1220,54 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         return true;
       }
       return element->iterator &&
-             element->results.size() < dataset()->buffer_output_elements_;
+             element->results.size() < buffer_output_elements_->value;
+    }
+
+    // Records the latency of producing the first result of an input, which
+    // includes opening the input.
+    void RecordInputLatency(int64_t latency_micros)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      input_latency_micros_ema_ =
+          input_latency_micros_ema_ == 0
+              ? latency_micros
+              : (1.0 - kInputLatencyEmaWeight) * input_latency_micros_ema_ +
+                    kInputLatencyEmaWeight * latency_micros;
+    }
+
+    // Records that the consumer exhausted an input of the current cycle, and
+    // adapts the number of future cycle elements to the rate at which inputs
+    // are exhausted.
+    void RecordInputExhausted() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      const int64_t now = EnvTime::NowMicros();
+      if (last_input_exhausted_micros_ > 0) {
+        const double interval = now - last_input_exhausted_micros_;
+        exhausted_interval_micros_ema_ =
+            exhausted_interval_micros_ema_ == 0
+                ? interval
+                : (1.0 - kInputLatencyEmaWeight) *
+                          exhausted_interval_micros_ema_ +
+                      kInputLatencyEmaWeight * interval;
+      }
+      last_input_exhausted_micros_ = now;
+      if (!adapt_future_elements_ || input_latency_micros_ema_ == 0 ||
+          exhausted_interval_micros_ema_ == 0) {
+        return;
+      }
+      // By Little's law, hiding the latency of opening inputs requires as
+      // many inputs to be opened ahead of time as are exhausted during that
+      // latency.
+      const int64_t target = std::min(
+          max_prefetch_input_elements_,
+          std::max<int64_t>(1, std::ceil(input_latency_micros_ema_ /
+                                         exhausted_interval_micros_ema_)));
+      if (target != future_elements_target_) {
+        VLOG(2) << "Changing the number of future cycle elements from "
+                << future_elements_target_ << " to " << target;
+        if (target > future_elements_target_) {
+          future_workers_cond_var_.notify_all();
+        }
+        future_elements_target_ = target;
+      }
     }
 
     inline void IncrementCurrentWorkers() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -1591,6 +1699,17 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Identifies the maximum number of parallel calls.
     const std::shared_ptr<model::SharedState> num_parallel_calls_;
 
+    // Condition variable notified by autotuning when `buffer_output_elements_`
+    // changes. Workers check the new value when they next process an element.
+    std::shared_ptr<condition_variable> buffer_output_elements_cond_var_;
+
+    // Identifies the maximum number of results buffered per cycle element.
+    const std::shared_ptr<model::SharedState> buffer_output_elements_;
+
+    // Upper bound on `future_elements_target_`, for which future worker
+    // threads are created.
+    const int64_t max_prefetch_input_elements_;
+
     // The number of current workers currently alive or scheduled to be started.
     // This includes current workers which are blocked waiting for work.
     int num_current_workers_ TF_GUARDED_BY(mu_) = 0;
@@ -1628,6 +1747,19 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // current element is exhausted.
     std::deque<std::shared_ptr<Element>> future_elements_ TF_GUARDED_BY(mu_);
 
+    // Number of future elements that future workers keep prefetched.
+    int64_t future_elements_target_ TF_GUARDED_BY(mu_);
+
+    // Whether `future_elements_target_` is adapted to the observed latency of
+    // opening inputs and the rate at which the consumer exhausts them.
+    bool adapt_future_elements_ TF_GUARDED_BY(mu_) = false;
+
+    // Exponential moving averages of the latency of producing the first result
+    // of an input, and of the interval between exhausted inputs.
+    double input_latency_micros_ema_ TF_GUARDED_BY(mu_) = 0;
+    double exhausted_interval_micros_ema_ TF_GUARDED_BY(mu_) = 0;
+    int64_t last_input_exhausted_micros_ TF_GUARDED_BY(mu_) = 0;
+
     // Identifies whether the global end of input has been reached.
     bool end_of_input_ TF_GUARDED_BY(mu_) = false;
 
@@ -1666,6 +1798,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
   const int64_t input_cycle_length_;
   const int64_t cycle_length_;
   const int64_t block_length_;
+  // `buffer_output_elements` and `prefetch_input_elements` as configured,
+  // which may be `model::kAutotune`.
+  const int64_t input_buffer_output_elements_;
+  const int64_t input_prefetch_input_elements_;
   const int64_t buffer_output_elements_;
   const int64_t prefetch_input_elements_;
   const int64_t num_parallel_calls_;
@@ -54,6 +54,8 @@ namespace data {
 /* static */ constexpr const char* const ParallelMapDatasetOp::kSloppy;
 /* static */ constexpr const char* const
     ParallelMapDatasetOp::kPreserveCardinality;
+/* static */ constexpr const char* const
+    ParallelMapDatasetOp::kReorderWindowBytes;
 
 namespace {
 
@@ -70,6 +72,10 @@ constexpr char kErrorMessage[] = "error_message";
 // Period between reporting dataset statistics.
 constexpr int kStatsReportingPeriodMillis = 1000;
 
+// With a reorder window, bounds the number of buffered results to this
+// multiple of the parallelism, in case the results are very small.
+constexpr int64_t kMaxReorderWindowElementsPerCall = 16;
+
 }  // namespace
 
 class ParallelMapDatasetOp::Dataset : public DatasetBase {
@@ -79,17 +85,19 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           const std::vector<PartialTensorShape>& output_shapes,
           DeterminismPolicy deterministic,
           std::unique_ptr<CapturedFunction> captured_func,
-          bool preserve_cardinality, int op_version)
+          bool preserve_cardinality, int op_version,
+          int64_t reorder_window_bytes = 0)
       : Dataset(DatasetContext(ctx), input, num_parallel_calls, output_types,
                 output_shapes, deterministic, std::move(captured_func),
-                preserve_cardinality, op_version) {}
+                preserve_cardinality, op_version, reorder_window_bytes) {}
 
   Dataset(DatasetContext dataset_context, const DatasetBase* input,
           int64_t num_parallel_calls, const DataTypeVector& output_types,
           const std::vector<PartialTensorShape>& output_shapes,
           DeterminismPolicy deterministic,
           std::unique_ptr<CapturedFunction> captured_func,
-          bool preserve_cardinality, int op_version)
+          bool preserve_cardinality, int op_version,
+          int64_t reorder_window_bytes = 0)
       : DatasetBase(std::move(dataset_context)),
         input_(input),
         num_parallel_calls_(num_parallel_calls),
@@ -98,7 +106,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         deterministic_(deterministic),
         preserve_cardinality_(preserve_cardinality),
         captured_func_(std::move(captured_func)),
-        op_version_(op_version) {
+        op_version_(op_version),
+        reorder_window_bytes_(reorder_window_bytes) {
     input_->Ref();
   }
 
@@ -222,6 +231,12 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(preserve_cardinality_, &preserve_cardinality_attr);
     attrs.emplace_back(kPreserveCardinality, preserve_cardinality_attr);
 
+    if (reorder_window_bytes_ > 0) {
+      AttrValue reorder_window_bytes_attr;
+      b->BuildAttrValue(reorder_window_bytes_, &reorder_window_bytes_attr);
+      attrs.emplace_back(kReorderWindowBytes, reorder_window_bytes_attr);
+    }
+
     TF_RETURN_IF_ERROR(b->AddDataset(
         this,
         {std::make_pair(0, input_graph_node),
@@ -243,7 +258,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
           deterministic_(params.dataset->deterministic_.IsDeterministic() ||
                          params.dataset->deterministic_.IsDefault()),
           preserve_cardinality_(params.dataset->preserve_cardinality_),
-          autotune_(params.dataset->num_parallel_calls_ == model::kAutotune) {}
+          autotune_(params.dataset->num_parallel_calls_ == model::kAutotune),
+          reorder_window_bytes_(params.dataset->reorder_window_bytes_) {}
 
     ~Iterator() override {
       CancelThreads(/*wait=*/true);
@@ -380,6 +396,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         }
         result.end_of_input = reader->Contains(element_prefix, kEndOfInput);
         RecordBufferEnqueue(ctx, result.return_values);
+        result.num_bytes = GetTotalBytes(result.return_values);
+        completed_bytes_ += result.num_bytes;
         result.notification.Notify();
       }
       return OkStatus();
@@ -417,6 +435,8 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       Status status;
       std::vector<Tensor> return_values;
       bool end_of_input = false;
+      // Size of `return_values`, set when the call completes.
+      int64_t num_bytes = 0;
       const int64_t uid;
     };
 
@@ -451,10 +471,31 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         TF_LOCKS_EXCLUDED(*mu_) {
       mutex_lock l(*mu_);
       num_calls_--;
+      result->num_bytes = GetTotalBytes(result->return_values);
+      completed_bytes_ += result->num_bytes;
       result->notification.Notify();
       cond_var_->notify_all();
     }
 
+    // Whether the results buffered behind an unfinished call have filled the
+    // reorder window, so that no further calls may be issued.
+    bool ReorderWindowFull() const TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      return completed_bytes_ >= reorder_window_bytes_ ||
+             invocation_results_.size() >=
+                 kMaxReorderWindowElementsPerCall * num_parallel_calls_->value;
+    }
+
+    // Removes `it` from `invocation_results_` and returns it in `result`.
+    void TakeResult(
+        std::deque<std::shared_ptr<InvocationResult>>::iterator it,
+        std::shared_ptr<InvocationResult>* result)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      std::swap(*result, *it);
+      invocation_results_.erase(it);
+      completed_bytes_ -= (*result)->num_bytes;
+      cond_var_->notify_all();
+    }
+
     void CallFunction(const std::shared_ptr<IteratorContext>& ctx,
                       const std::shared_ptr<InvocationResult>& result)
         TF_LOCKS_EXCLUDED(*mu_) {
@@ -551,8 +592,11 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
       }
       auto busy = [this]() TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) -> bool {
         int64_t num_parallel_calls = num_parallel_calls_->value;
-        return num_calls_ >= num_parallel_calls ||
-               invocation_results_.size() >= num_parallel_calls;
+        if (num_calls_ >= num_parallel_calls) return true;
+        // With a reorder window, idle call slots keep being filled while
+        // completed results wait behind a slow one, up to the window size.
+        if (reorder_window_bytes_ > 0) return ReorderWindowFull();
+        return invocation_results_.size() >= num_parallel_calls;
       };
       while (true) {
         {
@@ -587,30 +631,53 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
         return false;
       }
       if (!deterministic_) {
-        // Iterate through in-flight results and return the first one that is
-        // found to be available and not end-of-input. If the first result (in
-        // order) is end-of-input, we know that all earlier iterations have
-        // already been completed, so it is safe to return that result for the
-        // caller to process end of iteration.
-        for (auto it = invocation_results_.begin();
-             it != invocation_results_.end(); ++it) {
-          if ((*it)->notification.HasBeenNotified() &&
-              (it == invocation_results_.begin() || !(*it)->end_of_input)) {
-            std::swap(*result, *it);
-            invocation_results_.erase(it);
-            cond_var_->notify_all();
-            return false;
-          }
+        if (TakeFirstCompletedResult(result)) {
+          return false;
         }
+      } else if (reorder_window_bytes_ > 0) {
+        // Results are returned in order, unless the head of the buffer is
+        // still running and the results completed behind it fill the window.
+        if (invocation_results_.empty()) {
+          return true;
+        }
+        if (invocation_results_.front()->notification.HasBeenNotified()) {
+          TakeResult(invocation_results_.begin(), result);
+          return false;
+        }
+        if (!ReorderWindowFull()) {
+          // Wait on `cond_var_`, which is notified whenever a call completes.
+          return true;
+        }
+        if (TakeFirstCompletedResult(result)) {
+          return false;
+        }
+        // The caller waits for the head to complete outside of the lock.
+        TakeResult(invocation_results_.begin(), result);
+        return false;
       } else if (!invocation_results_.empty()) {
-        std::swap(*result, invocation_results_.front());
-        invocation_results_.pop_front();
-        cond_var_->notify_all();
+        TakeResult(invocation_results_.begin(), result);
         return false;
       }
       return true;
     }
 
+    // Iterates through in-flight results and takes the first one that is
+    // available and not end-of-input. If the first result (in order) is
+    // end-of-input, all earlier iterations have already been completed, so it
+    // is safe to take that result for the caller to process end of iteration.
+    bool TakeFirstCompletedResult(std::shared_ptr<InvocationResult>* result)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
+      for (auto it = invocation_results_.begin();
+           it != invocation_results_.end(); ++it) {
+        if ((*it)->notification.HasBeenNotified() &&
+            (it == invocation_results_.begin() || !(*it)->end_of_input)) {
+          TakeResult(it, result);
+          return true;
+        }
+      }
+      return false;
+    }
+
     void StatsThread(const std::shared_ptr<IteratorContext>& ctx) {
       for (int64_t step = 0;; ++step) {
         int num_calls;
@@ -681,8 +748,11 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
     const bool deterministic_;
     const bool preserve_cardinality_;
     const bool autotune_;
+    const int64_t reorder_window_bytes_;
     // Counts the number of outstanding calls.
     int64_t num_calls_ TF_GUARDED_BY(*mu_) = 0;
+    // Total size of the completed results in `invocation_results_`.
+    int64_t completed_bytes_ TF_GUARDED_BY(*mu_) = 0;
     // Controls cancellation of `input_impl_`. Must be ordered before
     // `input_impl_` so that `input_impl_` is destroyed first.
     std::unique_ptr<CancellationManager> cancellation_manager_;
@@ -715,6 +785,7 @@ class ParallelMapDatasetOp::Dataset : public DatasetBase {
   const bool preserve_cardinality_;
   const std::unique_ptr<CapturedFunction> captured_func_;
   const int op_version_;
+  const int64_t reorder_window_bytes_;
   // This is used for random access provided by Get().
   mutable std::unique_ptr<InstantiatedCapturedFunction>
       instantiated_captured_func_;
@@ -747,6 +818,14 @@ ParallelMapDatasetOp::ParallelMapDatasetOp(OpKernelConstruction* ctx)
   }
   OP_REQUIRES_OK(ctx,
                  ctx->GetAttr(kPreserveCardinality, &preserve_cardinality_));
+  if (ctx->HasAttr(kReorderWindowBytes)) {
+    OP_REQUIRES_OK(ctx,
+                   ctx->GetAttr(kReorderWindowBytes, &reorder_window_bytes_));
+    OP_REQUIRES(ctx, reorder_window_bytes_ >= 0,
+                errors::InvalidArgument(kReorderWindowBytes,
+                                        " must be non-negative; got ",
+                                        reorder_window_bytes_));
+  }
 }
 
 void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
@@ -778,7 +857,7 @@ void ParallelMapDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
   *output =
       new Dataset(ctx, input, num_parallel_calls, output_types_, output_shapes_,
                   deterministic_, std::move(captured_func),
-                  preserve_cardinality_, op_version_);
+                  preserve_cardinality_, op_version_, reorder_window_bytes_);
 }
 
 std::unique_ptr<DatasetBase> MakeDataServiceUncompressDataset(
@@ -38,6 +38,12 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kSloppy = "sloppy";
   static constexpr const char* const kPreserveCardinality =
       "preserve_cardinality";
+  // Optional private attr. If positive, deterministic iterators keep issuing
+  // calls while a slow element blocks the head of the buffer, until the
+  // results completed behind it take this many bytes. Only then is the oldest
+  // completed result returned ahead of the slow element.
+  static constexpr const char* const kReorderWindowBytes =
+      "_reorder_window_bytes";
 
   explicit ParallelMapDatasetOp(OpKernelConstruction* ctx);
 
@@ -54,6 +60,7 @@ class ParallelMapDatasetOp : public UnaryDatasetOpKernel {
   bool sloppy_;
   bool preserve_cardinality_;
   DeterminismPolicy deterministic_;
+  int64_t reorder_window_bytes_ = 0;
 
   friend std::unique_ptr<DatasetBase> MakeDataServiceUncompressDataset(
       DatasetBase* input, std::unique_ptr<CapturedFunction> captured_function,
@@ -31,7 +31,8 @@ class ParallelMapDatasetParams : public DatasetParams {
       const DataTypeVector& output_dtypes,
       const std::vector<PartialTensorShape>& output_shapes,
       bool use_inter_op_parallelism, const std::string& deterministic,
-      bool preserve_cardinality, string node_name)
+      bool preserve_cardinality, string node_name,
+      int64_t reorder_window_bytes = 0)
       : DatasetParams(std::move(output_dtypes), std::move(output_shapes),
                       std::move(node_name)),
         other_arguments_(std::move(other_arguments)),
@@ -41,7 +42,8 @@ class ParallelMapDatasetParams : public DatasetParams {
         type_arguments_(std::move(type_arguments)),
         use_inter_op_parallelism_(use_inter_op_parallelism),
         deterministic_(deterministic),
-        preserve_cardinality_(preserve_cardinality) {
+        preserve_cardinality_(preserve_cardinality),
+        reorder_window_bytes_(reorder_window_bytes) {
     input_dataset_params_.push_back(std::make_unique<T>(input_dataset_params));
     op_version_ = kOpVersion;
     name_utils::IteratorPrefixParams params;
@@ -77,6 +79,10 @@ class ParallelMapDatasetParams : public DatasetParams {
                     {"deterministic", deterministic_},
                     {"preserve_cardinality", preserve_cardinality_},
                     {"metadata", ""}};
+    if (reorder_window_bytes_ > 0) {
+      attr_vector->emplace_back(ParallelMapDatasetOp::kReorderWindowBytes,
+                                reorder_window_bytes_);
+    }
     return OkStatus();
   }
 
@@ -95,6 +101,7 @@ class ParallelMapDatasetParams : public DatasetParams {
   bool use_inter_op_parallelism_;
   std::string deterministic_;
   bool preserve_cardinality_;
+  int64_t reorder_window_bytes_;
 };
 
 class ParallelMapDatasetOpTest : public DatasetOpsTestBase {};
@@ -251,6 +258,26 @@ ParallelMapDatasetParams ParallelMapDatasetParams8() {
       /*node_name=*/kNodeName);
 }
 
+// test case 9: num_parallel_calls = 2, use_inter_op_parallelism = false,
+// deterministic = true, preserve_cardinality = true, MapFunc = XTimesTwo,
+// reorder_window_bytes = 1024
+ParallelMapDatasetParams ParallelMapDatasetParams9() {
+  return ParallelMapDatasetParams(
+      RangeDatasetParams(0, 10, 3),
+      /*other_arguments=*/{},
+      /*num_parallel_calls=*/2,
+      /*func=*/MapFunc("XTimesTwo", DT_INT64),
+      /*func_lib*/ {test::function::XTimesTwo()},
+      /*type_arguments=*/{},
+      /*output_dtypes=*/{DT_INT64},
+      /*output_shapes=*/{PartialTensorShape({})},
+      /*use_inter_op_parallelism=*/false,
+      /*deterministic=*/DeterminismPolicy::kDeterministic,
+      /*preserve_cardinality=*/true,
+      /*node_name=*/kNodeName,
+      /*reorder_window_bytes=*/1024);
+}
+
 ParallelMapDatasetParams ParallelMapDatasetParamsWithInvalidNumParallelCalls() {
   return ParallelMapDatasetParams(
       RangeDatasetParams(0, 10, 3),
@@ -292,6 +319,10 @@ std::vector<GetNextTestCase<ParallelMapDatasetParams>> GetNextTestCases() {
            ParallelMapDatasetParams6(),
            /*expected_outputs=*/
            CreateTensors<int64_t>(TensorShape{}, {{0}, {12}, {24}, {36}}),
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams9(),
+           /*expected_outputs=*/
+           CreateTensors<int64_t>(TensorShape{}, {{0}, {6}, {12}, {18}}),
            /*compare_order=*/true}};
 }
 
@@ -398,6 +429,11 @@ IteratorSaveAndRestoreTestCases() {
            /*breakpoints=*/{0, 1, 5},
            /*expected_outputs=*/
            CreateTensors<int64_t>(TensorShape{}, {{0}, {12}, {24}, {36}}),
+           /*compare_order=*/true},
+          {/*dataset_params=*/ParallelMapDatasetParams9(),
+           /*breakpoints=*/{0, 1, 5},
+           /*expected_outputs=*/
+           CreateTensors<int64_t>(TensorShape{}, {{0}, {6}, {12}, {18}}),
            /*compare_order=*/true}};
 }
 
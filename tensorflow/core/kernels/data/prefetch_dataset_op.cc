@@ -19,13 +19,16 @@ limitations under the License.
 
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/data/stats_utils.h"
 #include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/model.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/stats_aggregator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/data/device_element_stager.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
@@ -48,6 +51,7 @@ namespace data {
 /* static */ constexpr const char* const PrefetchDatasetOp::kSlackPeriod;
 /* static */ constexpr const char* const PrefetchDatasetOp::kLegacyAutotune;
 /* static */ constexpr const char* const PrefetchDatasetOp::kBufferSizeMin;
+/* static */ constexpr const char* const PrefetchDatasetOp::kStageToDevice;
 
 namespace {
 
@@ -64,13 +68,15 @@ constexpr char kErrorMessageSuffix[] = ".error_message";
 class PrefetchDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(OpKernelContext* ctx, const DatasetBase* input, int64_t buffer_size,
-          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min)
+          int64_t slack_period, bool legacy_autotune, int64_t buffer_size_min,
+          std::unique_ptr<DeviceElementStager> stager)
       : DatasetBase(DatasetContext(ctx)),
         input_(input),
         buffer_size_(buffer_size),
         slack_period_(slack_period),
         legacy_autotune_(legacy_autotune),
-        buffer_size_min_(buffer_size_min) {
+        buffer_size_min_(buffer_size_min),
+        stager_(std::move(stager)) {
     input_->Ref();
   }
 
@@ -109,6 +115,8 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     return input_->Get(ctx, index, out_tensors);
@@ -128,13 +136,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     b->BuildAttrValue(legacy_autotune_, &legacy_autotune_attr);
     AttrValue buffer_size_min_attr;
     b->BuildAttrValue(buffer_size_min_, &buffer_size_min_attr);
+    std::vector<std::pair<StringPiece, AttrValue>> attrs = {
+        std::make_pair(kSlackPeriod, slack_period_attr),
+        std::make_pair(kLegacyAutotune, legacy_autotune_attr),
+        std::make_pair(kBufferSizeMin, buffer_size_min_attr)};
+    if (stager_) {
+      AttrValue stage_to_device_attr;
+      b->BuildAttrValue(true, &stage_to_device_attr);
+      attrs.push_back(std::make_pair(kStageToDevice, stage_to_device_attr));
+    }
 
     TF_RETURN_IF_ERROR(
-        b->AddDataset(this, {input_graph_node, buffer_size},
-                      {std::make_pair(kSlackPeriod, slack_period_attr),
-                       std::make_pair(kLegacyAutotune, legacy_autotune_attr),
-                       std::make_pair(kBufferSizeMin, buffer_size_min_attr)},
-                      output));
+        b->AddDataset(this, {input_graph_node, buffer_size}, attrs, output));
     return OkStatus();
   }
 
@@ -163,8 +176,10 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     }
 
     Status Initialize(IteratorContext* ctx) override {
+      mutex_lock input_l(input_mu_);
       mutex_lock l(*mu_);
       interleave_depth_ = ctx->interleave_depth();
+      symbolic_checkpoint_ = ctx->symbolic_checkpoint();
 
       if (buffer_size_->value == model::kAutotune) {
         buffer_size_->value = buffer_size_min_;
@@ -175,8 +190,12 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
           &deregister_fn_));
       IteratorContext::Params params(ctx);
       params.cancellation_manager = cancellation_manager_.get();
-      return dataset()->input_->MakeIterator(IteratorContext(params), this,
-                                             prefix(), &input_impl_);
+      TF_RETURN_IF_ERROR(dataset()->input_->MakeIterator(
+          IteratorContext(params), this, prefix(), &input_impl_));
+      if (symbolic_checkpoint_) {
+        TF_RETURN_IF_ERROR(SnapshotInput(&consumed_checkpoint_));
+      }
+      return OkStatus();
     }
 
     Status GetNextInternal(IteratorContext* ctx,
@@ -224,7 +243,15 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         }
         // Release mu_
       }
-      return input_impl_->GetNext(ctx, out_tensors, end_of_sequence);
+      TF_RETURN_IF_ERROR(
+          input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
+      if (symbolic_checkpoint_) {
+        std::shared_ptr<MemoryCheckpoint> checkpoint;
+        TF_RETURN_IF_ERROR(SnapshotInput(&checkpoint));
+        mutex_lock l(*mu_);
+        consumed_checkpoint_ = std::move(checkpoint);
+      }
+      return OkStatus();
     }
 
    protected:
@@ -244,6 +271,12 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       // all GetNext threads are blocked.
       mutex_lock input_l(input_mu_);
       mutex_lock l(*mu_);
+      if (symbolic_checkpoint_) {
+        // Save the state that the input had when it produced the last consumed
+        // element. Restoring it recomputes the buffered elements.
+        TF_RETURN_IF_ERROR(consumed_checkpoint_->Save(writer));
+        return writer->WriteScalar(prefix(), kBufferSize, 0);
+      }
       TF_RETURN_IF_ERROR(SaveInput(ctx, writer, input_impl_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(prefix(), kBufferSize, buffer_.size()));
@@ -300,6 +333,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         }
         RecordBufferEnqueue(ctx, buffer_element.value);
       }
+      if (symbolic_checkpoint_) {
+        TF_RETURN_IF_ERROR(SnapshotInput(&consumed_checkpoint_));
+      }
       return OkStatus();
     }
 
@@ -358,6 +394,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       std::vector<Tensor> value;
       int64_t created_us;
       const uint64 uid;
+      // The state of the input after producing this element, if
+      // `symbolic_checkpoint_` is set.
+      std::shared_ptr<MemoryCheckpoint> checkpoint;
     };
 
     int64_t buffer_limit() const TF_EXCLUSIVE_LOCKS_REQUIRED(*mu_) {
@@ -427,6 +466,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
         auto_tuner_.RecordConsumption(buffer_.size());
         buffer_size_->value = auto_tuner_.buffer_limit();
       }
+      if (symbolic_checkpoint_) {
+        consumed_checkpoint_ = std::move(buffer_.front().checkpoint);
+      }
       buffer_.pop_front();
       *end_of_sequence = false;
 
@@ -500,6 +542,18 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
               profiler::kInfo);
           buffer_element.status = input_impl_->GetNext(
               ctx.get(), &buffer_element.value, &end_of_sequence);
+          if (dataset()->stager_ && buffer_element.status.ok() &&
+              !end_of_sequence) {
+            std::vector<Tensor> host_element = std::move(buffer_element.value);
+            buffer_element.status =
+                dataset()->stager_->Stage(host_element, &buffer_element.value);
+          }
+        }
+        if (symbolic_checkpoint_ && !end_of_sequence) {
+          Status s = SnapshotInput(&buffer_element.checkpoint);
+          if (!s.ok() && buffer_element.status.ok()) {
+            buffer_element.status = s;
+          }
         }
         if (buffer_element.status.ok() && end_of_sequence) {
           mutex_lock l(*mu_);
@@ -552,6 +606,19 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
       return OkStatus();
     }
 
+    // Captures the current state of the input iterator in `checkpoint`.
+    Status SnapshotInput(std::shared_ptr<MemoryCheckpoint>* checkpoint)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(input_mu_) {
+      SerializationContext::Params params;
+      params.external_state_policy =
+          SerializationContext::ExternalStatePolicy::kIgnore;
+      SerializationContext ctx(params);
+      auto result = std::make_shared<MemoryCheckpoint>();
+      TF_RETURN_IF_ERROR(SaveInput(&ctx, result.get(), input_impl_));
+      *checkpoint = std::move(result);
+      return OkStatus();
+    }
+
     string CodeKey() { return absl::StrCat(kStatus, kCodeSuffix); }
 
     string ErrorMessageKey() {
@@ -578,6 +645,11 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
     bool cancelled_ TF_GUARDED_BY(*mu_) = false;
     bool prefetch_thread_finished_ TF_GUARDED_BY(*mu_) = false;
     const bool legacy_autotune_;
+    // Whether the iterator is checkpointed symbolically, in which case the
+    // state of the input is captured along with every buffered element.
+    bool symbolic_checkpoint_ = false;
+    // The state of the input after producing the last consumed element.
+    std::shared_ptr<MemoryCheckpoint> consumed_checkpoint_ TF_GUARDED_BY(*mu_);
 
     std::atomic<int64_t> slack_us_;
 
@@ -609,6 +681,9 @@ class PrefetchDatasetOp::Dataset : public DatasetBase {
   // parameter.
   const int64_t buffer_size_min_ = 0;
 
+  // If set, copies elements to an accelerator device as they are prefetched.
+  const std::unique_ptr<DeviceElementStager> stager_;
+
   TraceMeMetadata traceme_metadata_;
 };
 
@@ -623,6 +698,9 @@ PrefetchDatasetOp::PrefetchDatasetOp(OpKernelConstruction* ctx)
   if (ctx->HasAttr(kBufferSizeMin)) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr(kBufferSizeMin, &buffer_size_min_));
   }
+  if (ctx->HasAttr(kStageToDevice)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kStageToDevice, &stage_to_device_));
+  }
   if (GetExperiments().contains("autotune_buffer_optimization")) {
     legacy_autotune_ = false;
     buffer_size_min_ = std::max(static_cast<int64_t>(1), buffer_size_min_);
@@ -643,8 +721,16 @@ void PrefetchDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
     metrics::RecordTFDataAutotune(kDatasetType);
   }
 
+  // Elements are only staged by kernels placed on an accelerator device, whose
+  // outputs are expected in device memory.
+  std::unique_ptr<DeviceElementStager> stager;
+  Device* device = ctx->function_library()->device();
+  if (stage_to_device_ && device->device_type() != DEVICE_CPU) {
+    OP_REQUIRES_OK(ctx, DeviceElementStager::Create(device, &stager));
+  }
+
   *output = new Dataset(ctx, input, buffer_size, slack_period_,
-                        legacy_autotune_, buffer_size_min_);
+                        legacy_autotune_, buffer_size_min_, std::move(stager));
 }
 
 namespace {
@@ -32,6 +32,9 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
   static constexpr const char* const kSlackPeriod = "slack_period";
   static constexpr const char* const kLegacyAutotune = "legacy_autotune";
   static constexpr const char* const kBufferSizeMin = "buffer_size_min";
+  // If set on a kernel placed on an accelerator device, elements are copied
+  // to the device with `DeviceElementStager` before being buffered.
+  static constexpr const char* const kStageToDevice = "_stage_to_device";
 
   explicit PrefetchDatasetOp(OpKernelConstruction* ctx);
 
@@ -44,6 +47,7 @@ class PrefetchDatasetOp : public UnaryDatasetOpKernel {
   int64_t slack_period_ = 0;
   bool legacy_autotune_ = true;
   int64_t buffer_size_min_ = 0;
+  bool stage_to_device_ = false;
 };
 
 }  // namespace data
@@ -12,6 +12,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/data/prefetch_dataset_op.h"
 
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/data/dataset_test_base.h"
 
 namespace tensorflow {
@@ -326,6 +327,40 @@ IteratorSaveAndRestoreTestCases() {
 ITERATOR_SAVE_AND_RESTORE_TEST_P(PrefetchDatasetOpTest, PrefetchDatasetParams,
                                  IteratorSaveAndRestoreTestCases())
 
+TEST_F(PrefetchDatasetOpTest, SymbolicCheckpoint) {
+  auto dataset_params = PrefetchDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  IteratorContext::Params params(iterator_ctx_.get());
+  params.symbolic_checkpoint = true;
+  IteratorContext iterator_ctx(std::move(params));
+
+  std::unique_ptr<IteratorBase> iterator;
+  TF_ASSERT_OK(dataset_->MakeIterator(&iterator_ctx, /*parent=*/nullptr,
+                                      dataset_params.iterator_prefix(),
+                                      &iterator));
+  std::vector<Tensor> next;
+  bool end_of_sequence = false;
+  TF_ASSERT_OK(iterator->GetNext(&iterator_ctx, &next, &end_of_sequence));
+  std::unique_ptr<SerializationContext> serialization_ctx;
+  TF_ASSERT_OK(CreateSerializationContext(&serialization_ctx));
+  VariantTensorDataWriter writer;
+  TF_ASSERT_OK(iterator->Save(serialization_ctx.get(), &writer));
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  // The buffered elements are not saved.
+  int64_t buffer_size;
+  TF_ASSERT_OK(reader.ReadScalar(iterator->prefix(),
+                                 PrefetchDatasetOp::kBufferSize, &buffer_size));
+  EXPECT_EQ(buffer_size, 0);
+
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_, &iterator_ctx, dataset_params.iterator_prefix(),
+      CreateTensors<int64_t>(
+          TensorShape{1}, {{0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}, {8}, {9}}),
+      /*breakpoints=*/{0, 4, 11}, /*compare_order=*/true));
+}
+
 TEST_F(PrefetchDatasetOpTest, InvalidBufferSize) {
   auto dataset_params = InvalidBufferSizePrefetchDatasetParams();
   EXPECT_EQ(Initialize(dataset_params).code(), error::INVALID_ARGUMENT);
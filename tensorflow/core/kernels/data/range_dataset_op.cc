@@ -222,6 +222,8 @@ class RangeDatasetOp::Dataset : public DatasetBase {
 
   Status CheckExternalState() const override { return OkStatus(); }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
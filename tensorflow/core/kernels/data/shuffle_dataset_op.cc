@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/data/random_seed_ops.h"
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/random.h"
@@ -50,6 +51,7 @@ namespace data {
 /* static */ constexpr const char* const ShuffleDatasetOpBase::kOutputShapes;
 /* static */ constexpr const char* const
     ShuffleDatasetOpBase::kReshuffleEachIteration;
+/* static */ constexpr const char* const ShuffleDatasetOpBase::kSpillDirectory;
 
 /* static */ constexpr const char* const ShuffleDatasetOp::kDatasetType;
 
@@ -70,6 +72,8 @@ constexpr char kSlicesStart[] = "slices_start";
 constexpr char kSlicesEnd[] = "slices_end";
 constexpr char kSeedGenerator[] = "SeedGenerator";
 constexpr char kEpochNumRandomSamples[] = "epoch_num_random_samples";
+constexpr char kInitialNumRandomSamples[] = "initial_num_random_samples";
+constexpr char kSymbolicNumProduced[] = "symbolic_num_produced";
 constexpr char kShuffleDatasetV1[] = "ShuffleDataset";
 constexpr char kShuffleDatasetV2[] = "ShuffleDatasetV2";
 constexpr char kShuffleDatasetV3[] = "ShuffleDatasetV3";
@@ -77,7 +81,11 @@ constexpr char kShuffleAndRepeatDatasetV1[] = "ShuffleAndRepeatDataset";
 constexpr char kShuffleAndRepeatDatasetV2[] = "ShuffleAndRepeatDatasetV2";
 
 ShuffleDatasetOpBase::ShuffleDatasetOpBase(OpKernelConstruction* ctx)
-    : UnaryDatasetOpKernel(ctx) {}
+    : UnaryDatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kSpillDirectory)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kSpillDirectory, &spill_directory_));
+  }
+}
 
 // Abstract base dataset that implements a shuffling iterator.
 class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
@@ -101,6 +109,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
   virtual string op_type() const = 0;
 
+  // Must be called before any iterator is created.
+  void set_spill_directory(const std::string& spill_directory) {
+    spill_directory_ = spill_directory;
+  }
+
   const DataTypeVector& output_dtypes() const override {
     return input_->output_dtypes();
   }
@@ -138,6 +151,10 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     return input_->CheckExternalState();
   }
 
+  // Symbolic checkpoints replay the produced elements on restore, which is
+  // only bounded when the input is shuffled for a single epoch.
+  bool SymbolicCheckpointCompatible() const override { return count_ == 1; }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
@@ -170,6 +187,19 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         seed_generator_.get());
   }
 
+  // Returns `attrs` and, if the buffer is spilled, the spill directory, for
+  // `AsGraphDefInternal()`.
+  std::vector<std::pair<StringPiece, AttrValue>> AttrsWithSpillDirectory(
+      DatasetGraphDefBuilder* b,
+      std::vector<std::pair<StringPiece, AttrValue>> attrs) const {
+    if (!spill_directory_.empty()) {
+      AttrValue spill_directory;
+      b->BuildAttrValue(spill_directory_, &spill_directory);
+      attrs.emplace_back(kSpillDirectory, spill_directory);
+    }
+    return attrs;
+  }
+
   void InitializeRandomAccessIndices() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     const int64 cardinality = Cardinality();
     shuffled_indices_ = std::vector<std::int64_t>(cardinality);
@@ -196,12 +226,24 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
           seed_generator_(seed_generator),
           parent_generator_(seed_generator->seed(), seed_generator->seed2()),
           generator_(&parent_generator_) {
-      buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>(
-          params.dataset->buffer_size_);
+      if (params.dataset->spill_directory_.empty()) {
+        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>(
+            params.dataset->buffer_size_);
+      } else {
+        SpillingShuffleBuffer::Options options;
+        options.directory = params.dataset->spill_directory_;
+        spill_buffer_ = std::make_unique<SpillingShuffleBuffer>(
+            Env::Default(), options, params.dataset->buffer_size_);
+      }
     }
 
     Status Initialize(IteratorContext* ctx) override {
       mutex_lock l(mu_);
+      // Elements are replayed with the input split providers in symbolic
+      // checkpoints, which is not possible once the splits are consumed.
+      symbolic_checkpoint_ =
+          ctx->symbolic_checkpoint() && ctx->split_providers().empty();
+      initial_num_random_samples_ = seed_generator_->num_random_samples();
       seed_generator_->GenerateSeeds(&seed_, &seed2_);
       ResetRngs();
       return OkStatus();
@@ -225,13 +267,22 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       // slice, and then remove the element from the slice.
       int64_t offset =
           Random() % (slices_.front()->end - slices_.front()->start);
-      int64_t index = (slices_.front()->start + offset) % buffer_->size();
-      *out_tensors = std::move(buffer_->at(index));
-      this->RecordBufferDequeue(ctx, *out_tensors);
-      std::swap(buffer_->at(index),
-                buffer_->at(slices_.front()->start % buffer_->size()));
+      const int64_t buffer_size = dataset()->buffer_size_;
+      int64_t index = (slices_.front()->start + offset) % buffer_size;
+      const int64_t start_index = slices_.front()->start % buffer_size;
+      if (spill_buffer_) {
+        // Spilled elements do not use memory, so they are not recorded as
+        // buffered.
+        TF_RETURN_IF_ERROR(spill_buffer_->Take(index, out_tensors));
+        spill_buffer_->Swap(index, start_index);
+      } else {
+        *out_tensors = std::move(buffer_->at(index));
+        this->RecordBufferDequeue(ctx, *out_tensors);
+        std::swap(buffer_->at(index), buffer_->at(start_index));
+      }
       slices_.front()->start++;
       num_elements_--;
+      num_produced_++;
       return OkStatus();
     }
 
@@ -253,6 +304,16 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
     Status SaveInternal(SerializationContext* ctx,
                         IteratorStateWriter* writer) override {
       mutex_lock l(mu_);
+      if (symbolic_checkpoint_) {
+        // The shuffled elements are a deterministic function of the input
+        // and of the seeds, so it suffices to save the number of produced
+        // elements and the state of the seed generator before this iterator
+        // was created.
+        TF_RETURN_IF_ERROR(writer->WriteScalar(
+            full_name(kInitialNumRandomSamples), initial_num_random_samples_));
+        return writer->WriteScalar(full_name(kSymbolicNumProduced),
+                                   num_produced_);
+      }
       // Save state needed to restore the random number generators.
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name(kEpochNumRandomSamples),
@@ -275,7 +336,13 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       TF_RETURN_IF_ERROR(writer->WriteScalar(this->full_name(kEpoch), epoch_));
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kNumElements), num_elements_));
-      TF_RETURN_IF_ERROR(WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      if (spill_buffer_) {
+        // Only the index of the spilled elements is saved.
+        TF_RETURN_IF_ERROR(spill_buffer_->Save(writer, prefix()));
+      } else {
+        TF_RETURN_IF_ERROR(
+            WriteElementsToCheckpoint(writer, prefix(), *buffer_));
+      }
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(this->full_name(kSlicesSize), slices_.size()));
       for (size_t i = 0; i < slices_.size(); ++i) {
@@ -297,6 +364,9 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     Status RestoreInternal(IteratorContext* ctx,
                            IteratorStateReader* reader) override {
+      if (reader->Contains(full_name(kSymbolicNumProduced))) {
+        return RestoreSymbolic(ctx, reader);
+      }
       mutex_lock l(mu_);
       // Restore the random number generators.
       int64_t num_random_samples;
@@ -330,13 +400,17 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
             reader->ReadScalar(this->full_name(kSlicesSize), &temp));
         slices_size = static_cast<size_t>(temp);
       }
-      buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
-      TF_RETURN_IF_ERROR(
-          ReadElementsFromCheckpoint(ctx, reader, prefix(), buffer_.get()));
-      for (const auto& element : *buffer_) {
-        RecordBufferEnqueue(ctx, element);
+      if (spill_buffer_) {
+        TF_RETURN_IF_ERROR(spill_buffer_->Restore(reader, prefix()));
+      } else {
+        buffer_ = std::make_unique<std::vector<std::vector<Tensor>>>();
+        TF_RETURN_IF_ERROR(
+            ReadElementsFromCheckpoint(ctx, reader, prefix(), buffer_.get()));
+        for (const auto& element : *buffer_) {
+          RecordBufferEnqueue(ctx, element);
+        }
+        buffer_->resize(dataset()->buffer_size_);
       }
-      buffer_->resize(dataset()->buffer_size_);
       slices_.clear();
       for (size_t i = 0; i < slices_size; ++i) {
         int64_t start;
@@ -372,6 +446,39 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       int64_t end;
     };
 
+    // Restores a symbolic checkpoint by regenerating the seeds of the
+    // iterator and producing the saved number of elements again.
+    Status RestoreSymbolic(IteratorContext* ctx, IteratorStateReader* reader)
+        TF_LOCKS_EXCLUDED(mu_) {
+      int64_t num_produced;
+      {
+        mutex_lock l(mu_);
+        int64_t initial_num_random_samples;
+        TF_RETURN_IF_ERROR(reader->ReadScalar(
+            full_name(kInitialNumRandomSamples), &initial_num_random_samples));
+        TF_RETURN_IF_ERROR(reader->ReadScalar(full_name(kSymbolicNumProduced),
+                                              &num_produced));
+        seed_generator_->set_num_random_samples(initial_num_random_samples);
+        seed_generator_->Reset();
+        initial_num_random_samples_ = initial_num_random_samples;
+        seed_generator_->GenerateSeeds(&seed_, &seed2_);
+        num_random_samples_ = 0;
+        ResetRngs();
+        input_impl_.reset();
+        epoch_ = 0;
+        num_elements_ = 0;
+        num_produced_ = 0;
+        slices_.clear();
+        data_produced_ = false;
+      }
+      std::vector<Tensor> element;
+      bool end_of_sequence = false;
+      for (int64_t i = 0; i < num_produced && !end_of_sequence; ++i) {
+        TF_RETURN_IF_ERROR(GetNextInternal(ctx, &element, &end_of_sequence));
+      }
+      return OkStatus();
+    }
+
     random::SingleSampleAdapter<random::PhiloxRandom>::ResultType Random()
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       num_random_samples_++;
@@ -398,7 +505,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_RETURN_IF_ERROR(
             input_impl_->GetNext(ctx, &input_element, &end_of_input_sequence));
         if (!end_of_input_sequence) {
-          AddToShuffleBuffer(ctx, std::move(input_element));
+          TF_RETURN_IF_ERROR(AddToShuffleBuffer(ctx, std::move(input_element)));
           continue;
         }
         input_impl_.reset();
@@ -430,7 +537,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         // 1`.
         return false;
       }
-      return num_elements_ < buffer_->size();
+      return num_elements_ < dataset()->buffer_size_;
     }
 
     Status PrepareNextEpoch(IteratorContext* ctx)
@@ -450,18 +557,24 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
       return OkStatus();
     }
 
-    void AddToShuffleBuffer(IteratorContext* ctx, std::vector<Tensor>&& element)
+    Status AddToShuffleBuffer(IteratorContext* ctx,
+                              std::vector<Tensor>&& element)
         TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       data_produced_ = true;
       if (num_elements_ == 0) {
         VLOG(1) << "Starting to fill up shuffle buffer of size: "
                 << BufferSizeString();
       }
-      this->RecordBufferEnqueue(ctx, element);
-      size_t index = slices_.back()->end % buffer_->size();
-      buffer_->at(index) = std::move(element);
+      size_t index = slices_.back()->end % dataset()->buffer_size_;
+      if (spill_buffer_) {
+        TF_RETURN_IF_ERROR(spill_buffer_->Put(index, element));
+      } else {
+        this->RecordBufferEnqueue(ctx, element);
+        buffer_->at(index) = std::move(element);
+      }
       num_elements_++;
       slices_.back()->end++;
+      return OkStatus();
     }
 
     void ClearEmptySlices() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
@@ -481,8 +594,11 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
 
     mutex mu_;
     SeedGenerator* const seed_generator_ TF_GUARDED_BY(mu_);  // Not owned.
+    // Holds the buffered elements, unless they are spilled to
+    // `spill_buffer_`.
     std::unique_ptr<std::vector<std::vector<Tensor>>> buffer_
         TF_GUARDED_BY(mu_);
+    std::unique_ptr<SpillingShuffleBuffer> spill_buffer_ TF_GUARDED_BY(mu_);
     std::unique_ptr<IteratorBase> input_impl_ TF_GUARDED_BY(mu_) = nullptr;
     int64_t epoch_ TF_GUARDED_BY(mu_) = 0;
     int64_t num_elements_ TF_GUARDED_BY(mu_) = 0;
@@ -498,6 +614,12 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
         TF_GUARDED_BY(mu_);
     int64_t num_random_samples_ TF_GUARDED_BY(mu_) = 0;
     bool data_produced_ TF_GUARDED_BY(mu_) = false;
+    // Whether the iterator is checkpointed symbolically.
+    bool symbolic_checkpoint_ TF_GUARDED_BY(mu_) = false;
+    // The number of random samples of the seed generator when the iterator
+    // was initialized, and the number of elements produced since then.
+    int64_t initial_num_random_samples_ TF_GUARDED_BY(mu_) = 0;
+    int64_t num_produced_ TF_GUARDED_BY(mu_) = 0;
   };
 
   const DatasetBase* const input_;
@@ -508,6 +630,7 @@ class ShuffleDatasetOpBase::ShuffleDatasetBase : public DatasetBase {
   // responsible for repeating as well.
   const int64_t count_;
   const TraceMeMetadata traceme_metadata_;
+  std::string spill_directory_;
   mutable mutex mu_;
   mutable std::vector<std::int64_t> shuffled_indices_ TF_GUARDED_BY(mu_);
 };  // ShuffleDatasetBase
@@ -557,8 +680,9 @@ class ShuffleDatasetOp::Dataset : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddDataset(
         this,
         {input_graph_node, buffer_size_node, seed_node, seed2_node},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        AttrsWithSpillDirectory(
+            b, {std::make_pair(kReshuffleEachIteration,
+                               reshuffle_each_iteration)}),
         output));
     return OkStatus();
   }
@@ -613,8 +737,7 @@ class ShuffleDatasetOp::DatasetV2 : public ShuffleDatasetBase {
     TF_RETURN_IF_ERROR(b->AddDataset(
         this,
         {input_graph_node, buffer_size_node, resource_handle_node},  // Inputs
-        {},                                                          // Attrs
-        output));
+        AttrsWithSpillDirectory(b, {}), output));
     return OkStatus();
   }
 
@@ -676,8 +799,9 @@ class ShuffleDatasetOp::DatasetV3 : public ShuffleDatasetBase {
         b->AddDataset(this,
                       {input_graph_node, buffer_size_node, seed_node,
                        seed2_node, resource_handle_node},  // Inputs
-                      {std::make_pair(kReshuffleEachIteration,
-                                      reshuffle_each_iteration)},  // Attrs
+                      AttrsWithSpillDirectory(
+                          b, {std::make_pair(kReshuffleEachIteration,
+                                             reshuffle_each_iteration)}),
                       output));
     return OkStatus();
   }
@@ -820,6 +944,8 @@ void ShuffleDatasetOp::MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                                             std::move(seeds), manager,
                                             std::move(handle));
   }
+  static_cast<ShuffleDatasetBase*>(*output)->set_spill_directory(
+      spill_directory_);
 }
 
 class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
@@ -864,8 +990,9 @@ class ShuffleAndRepeatDatasetOp::Dataset : public ShuffleDatasetBase {
                       &reshuffle_each_iteration);
     TF_RETURN_IF_ERROR(b->AddDataset(
         this, {input_graph_node, buffer_size, seed, seed2, count},  // Inputs
-        {std::make_pair(kReshuffleEachIteration,
-                        reshuffle_each_iteration)},  // Attrs
+        AttrsWithSpillDirectory(
+            b, {std::make_pair(kReshuffleEachIteration,
+                               reshuffle_each_iteration)}),
         output));
     return OkStatus();
   }
@@ -927,8 +1054,9 @@ class ShuffleAndRepeatDatasetOp::DatasetV2 : public ShuffleDatasetBase {
         b->AddDataset(this,
                       {input_graph_node, buffer_size_node, seed_node,
                        seed2_node, count_node, resource_handle_node},  // Inputs
-                      {std::make_pair(kReshuffleEachIteration,
-                                      reshuffle_each_iteration)},  // Attrs
+                      AttrsWithSpillDirectory(
+                          b, {std::make_pair(kReshuffleEachIteration,
+                                             reshuffle_each_iteration)}),
                       output));
     return OkStatus();
   }
@@ -1044,6 +1172,8 @@ void ShuffleAndRepeatDatasetOp::MakeDataset(OpKernelContext* ctx,
     *output = new Dataset(ctx, input, buffer_size, std::move(seeds), manager,
                           count, std::move(handle));
   }
+  static_cast<ShuffleDatasetBase*>(*output)->set_spill_directory(
+      spill_directory_);
 }
 
 namespace {
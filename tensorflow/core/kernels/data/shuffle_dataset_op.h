@@ -30,11 +30,16 @@ class ShuffleDatasetOpBase : public UnaryDatasetOpKernel {
   static constexpr const char* const kOutputShapes = "output_shapes";
   static constexpr const char* const kReshuffleEachIteration =
       "reshuffle_each_iteration";
+  // If set, the shuffle buffer keeps a compact index in memory and spills the
+  // elements to scratch files in this directory.
+  static constexpr const char* const kSpillDirectory = "_spill_directory";
 
   explicit ShuffleDatasetOpBase(OpKernelConstruction* ctx);
 
  protected:
   class ShuffleDatasetBase;
+
+  std::string spill_directory_;
 };
 
 class ShuffleDatasetOp : public ShuffleDatasetOpBase {
@@ -554,6 +554,19 @@ INSTANTIATE_TEST_CASE_P(ShuffleDatasetOpTest,
                         ParameterizedIteratorSaveAndRestoreTest,
                         ::testing::ValuesIn(IteratorSaveAndRestoreTestCases()));
 
+TEST_F(ShuffleDatasetOpTest, SymbolicCheckpoint) {
+  auto dataset_params = ShuffleDatasetParams1();
+  TF_ASSERT_OK(Initialize(dataset_params));
+  IteratorContext::Params params(iterator_ctx_.get());
+  params.symbolic_checkpoint = true;
+  IteratorContext iterator_ctx(std::move(params));
+  TF_ASSERT_OK(CheckIteratorSaveAndRestore(
+      dataset_, &iterator_ctx, dataset_params.iterator_prefix(),
+      CreateTensors<int64_t>(
+          TensorShape({}), {{2}, {3}, {0}, {5}, {6}, {4}, {7}, {8}, {9}, {1}}),
+      /*breakpoints=*/{0, 4, 11}, /*compare_order=*/true));
+}
+
 TEST_F(ShuffleDatasetOpTest, InvalidArguments) {
   std::vector<ShuffleDatasetParams> dataset_params_vec(
       {ShuffleDatasetParamsWithInvalidBufferSize(),
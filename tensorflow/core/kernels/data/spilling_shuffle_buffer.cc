@@ -0,0 +1,391 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/coding.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kSpillNumFiles[] = "spill_num_files";
+constexpr char kSpillFile[] = "spill_file";
+constexpr char kSpillIndex[] = "spill_index";
+
+// Serializes an element as the number of components, followed by the length
+// and serialized `TensorProto` of each component.
+Status EncodeElement(const std::vector<Tensor>& element, std::string* record) {
+  record->clear();
+  core::PutVarint64(record, element.size());
+  std::string serialized;
+  for (const Tensor& component : element) {
+    TensorProto proto;
+    component.AsProtoTensorContent(&proto);
+    if (!proto.SerializeToString(&serialized)) {
+      return errors::Internal("Failed to serialize a tensor of shape ",
+                              component.shape().DebugString(),
+                              " to spill it to disk.");
+    }
+    core::PutVarint64(record, serialized.size());
+    record->append(serialized);
+  }
+  return OkStatus();
+}
+
+Status DecodeElement(StringPiece record, std::vector<Tensor>* element) {
+  uint64 num_components;
+  if (!core::GetVarint64(&record, &num_components)) {
+    return errors::DataLoss("Corrupted element in shuffle spill file.");
+  }
+  element->clear();
+  element->reserve(num_components);
+  for (uint64 i = 0; i < num_components; ++i) {
+    uint64 length;
+    TensorProto proto;
+    if (!core::GetVarint64(&record, &length) || length > record.size() ||
+        !proto.ParseFromArray(record.data(), length)) {
+      return errors::DataLoss("Corrupted element in shuffle spill file.");
+    }
+    record.remove_prefix(length);
+    element->emplace_back();
+    if (!element->back().FromProto(proto)) {
+      return errors::DataLoss("Corrupted tensor in shuffle spill file.");
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+SpillingShuffleBuffer::SpillingShuffleBuffer(Env* env, const Options& options,
+                                             int64_t size)
+    : env_(env), options_(options), slots_(size) {}
+
+SpillingShuffleBuffer::~SpillingShuffleBuffer() { Clear(); }
+
+Status SpillingShuffleBuffer::Put(int64_t slot,
+                                  const std::vector<Tensor>& element) {
+  if (slots_[slot].file >= 0) {
+    return errors::Internal("Slot ", slot, " of the shuffle buffer is in use.");
+  }
+  std::string record;
+  TF_RETURN_IF_ERROR(EncodeElement(element, &record));
+  TF_RETURN_IF_ERROR(Append(record, &slots_[slot]));
+  return MaybeCompact();
+}
+
+Status SpillingShuffleBuffer::Take(int64_t slot, std::vector<Tensor>* element) {
+  const Slot taken = slots_[slot];
+  if (taken.file < 0) {
+    return errors::Internal("Slot ", slot, " of the shuffle buffer is empty.");
+  }
+  std::string record;
+  TF_RETURN_IF_ERROR(Read(taken, &record));
+  slots_[slot] = Slot();
+  File& file = files_[taken.file];
+  file.live_bytes -= taken.length;
+  stats_.live_bytes -= taken.length;
+  if (file.live_bytes == 0 && taken.file != writer_file_) {
+    DropFile(taken.file);
+  }
+  return DecodeElement(record, element);
+}
+
+Status SpillingShuffleBuffer::Save(IteratorStateWriter* writer,
+                                   const std::string& prefix) {
+  TF_RETURN_IF_ERROR(FlushWriter());
+  absl::flat_hash_map<int, int64_t> positions;
+  for (auto& it : files_) {
+    const int64_t position = positions.size();
+    positions[it.first] = position;
+    it.second.pinned = true;
+    TF_RETURN_IF_ERROR(writer->WriteScalar(
+        prefix, strings::StrCat(kSpillFile, "_", position),
+        it.second.filename));
+  }
+  TF_RETURN_IF_ERROR(
+      writer->WriteScalar(prefix, kSpillNumFiles, positions.size()));
+  Tensor index(DT_INT64, TensorShape({size(), 3}));
+  auto index_matrix = index.matrix<int64_t>();
+  for (int64_t i = 0; i < size(); ++i) {
+    const Slot& slot = slots_[i];
+    index_matrix(i, 0) = slot.file < 0 ? -1 : positions[slot.file];
+    index_matrix(i, 1) = slot.offset;
+    index_matrix(i, 2) = slot.length;
+  }
+  return writer->WriteTensor(prefix, kSpillIndex, index);
+}
+
+Status SpillingShuffleBuffer::Restore(IteratorStateReader* reader,
+                                      const std::string& prefix) {
+  const int64_t num_slots = size();
+  Clear();
+  slots_.resize(num_slots);
+  int64_t num_files;
+  TF_RETURN_IF_ERROR(reader->ReadScalar(prefix, kSpillNumFiles, &num_files));
+  std::vector<int> ids;
+  for (int64_t i = 0; i < num_files; ++i) {
+    tstring filename;
+    TF_RETURN_IF_ERROR(reader->ReadScalar(
+        prefix, strings::StrCat(kSpillFile, "_", i), &filename));
+    File file;
+    file.filename = filename;
+    file.pinned = true;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(file.filename, &file.reader));
+    uint64 file_size;
+    TF_RETURN_IF_ERROR(env_->GetFileSize(file.filename, &file_size));
+    file.size = file_size;
+    stats_.file_bytes += file.size;
+    ids.push_back(next_file_id_++);
+    files_[ids.back()] = std::move(file);
+  }
+  Tensor index;
+  TF_RETURN_IF_ERROR(reader->ReadTensor(prefix, kSpillIndex, &index));
+  if (index.dtype() != DT_INT64 ||
+      index.shape() != TensorShape({num_slots, 3})) {
+    return errors::FailedPrecondition(
+        "Shuffle buffer checkpoint has index of shape ",
+        index.shape().DebugString(), ", but the buffer has ", num_slots,
+        " slots.");
+  }
+  auto index_matrix = index.matrix<int64_t>();
+  for (int64_t i = 0; i < num_slots; ++i) {
+    if (index_matrix(i, 0) < 0) continue;
+    if (index_matrix(i, 0) >= num_files) {
+      return errors::DataLoss("Invalid shuffle buffer checkpoint index.");
+    }
+    Slot& slot = slots_[i];
+    slot.file = ids[index_matrix(i, 0)];
+    slot.offset = index_matrix(i, 1);
+    slot.length = index_matrix(i, 2);
+    File& file = files_[slot.file];
+    if (slot.offset + slot.length > file.size) {
+      return errors::DataLoss("Shuffle spill file ", file.filename,
+                              " is shorter than recorded in the checkpoint.");
+    }
+    file.live_bytes += slot.length;
+    stats_.live_bytes += slot.length;
+  }
+  for (int id : ids) {
+    if (files_[id].live_bytes == 0) DropFile(id);
+  }
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::Append(StringPiece data, Slot* slot) {
+  if (writer_ == nullptr) {
+    TF_RETURN_IF_ERROR(NewFile(&writer_file_, &writer_));
+  }
+  File& file = files_[writer_file_];
+  TF_RETURN_IF_ERROR(writer_->Append(data));
+  // The last page of the file may be cached before it was complete.
+  InvalidatePage(writer_file_, file.size / options_.page_size_bytes);
+  slot->file = writer_file_;
+  slot->offset = file.size;
+  slot->length = data.size();
+  file.size += data.size();
+  file.live_bytes += data.size();
+  stats_.file_bytes += data.size();
+  stats_.live_bytes += data.size();
+  writer_dirty_ = true;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::Read(const Slot& slot, std::string* data) {
+  if (slot.file == writer_file_) {
+    TF_RETURN_IF_ERROR(FlushWriter());
+  }
+  const int64_t page_size = options_.page_size_bytes;
+  data->clear();
+  data->reserve(slot.length);
+  int64_t position = slot.offset;
+  const int64_t end = slot.offset + slot.length;
+  while (position < end) {
+    const int64_t page = position / page_size;
+    StringPiece page_data;
+    TF_RETURN_IF_ERROR(ReadPage(slot.file, page, &page_data));
+    const int64_t page_offset = position - page * page_size;
+    const int64_t length =
+        std::min<int64_t>(end - position, page_data.size() - page_offset);
+    if (length <= 0) {
+      return errors::DataLoss("Unexpected end of shuffle spill file ",
+                              files_[slot.file].filename, ".");
+    }
+    data->append(page_data.data() + page_offset, length);
+    position += length;
+  }
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::ReadPage(int file_id, int64_t page,
+                                       StringPiece* data) {
+  const PageKey key(file_id, page);
+  auto it = pages_.find(key);
+  if (it != pages_.end()) {
+    ++stats_.num_cache_hits;
+    lru_.splice(lru_.begin(), lru_, it->second.first);
+    *data = it->second.second;
+    return OkStatus();
+  }
+  ++stats_.num_cache_misses;
+  const File& file = files_[file_id];
+  const int64_t begin = page * options_.page_size_bytes;
+  const int64_t length =
+      std::min(options_.page_size_bytes, file.size - begin);
+  std::string buffer(length, '\0');
+  StringPiece result;
+  Status s = file.reader->Read(begin, length, &result, &buffer[0]);
+  if (!s.ok() && !(errors::IsOutOfRange(s) && result.size() == length)) {
+    return s;
+  }
+  if (result.size() != length) {
+    return errors::DataLoss("Unexpected end of shuffle spill file ",
+                            file.filename, ".");
+  }
+  if (result.data() != buffer.data()) {
+    buffer.assign(result.data(), result.size());
+  }
+  while (!lru_.empty() &&
+         lru_.size() >= std::max<int64_t>(options_.max_cached_pages, 1)) {
+    pages_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  auto& entry = pages_[key];
+  entry.first = lru_.begin();
+  entry.second = std::move(buffer);
+  *data = entry.second;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::MaybeCompact() {
+  const int64_t dead_bytes = stats_.file_bytes - stats_.live_bytes;
+  if (stats_.file_bytes < options_.min_compaction_bytes ||
+      dead_bytes <= stats_.live_bytes) {
+    return OkStatus();
+  }
+  VLOG(2) << "Compacting shuffle spill files: " << stats_.live_bytes
+          << " live bytes out of " << stats_.file_bytes << ".";
+  TF_RETURN_IF_ERROR(FlushWriter());
+  int new_file_id;
+  std::unique_ptr<WritableFile> new_writer;
+  TF_RETURN_IF_ERROR(NewFile(&new_file_id, &new_writer));
+  File& new_file = files_[new_file_id];
+  std::string record;
+  for (Slot& slot : slots_) {
+    if (slot.file < 0) continue;
+    TF_RETURN_IF_ERROR(Read(slot, &record));
+    TF_RETURN_IF_ERROR(new_writer->Append(record));
+    slot.file = new_file_id;
+    slot.offset = new_file.size;
+    new_file.size += slot.length;
+  }
+  new_file.live_bytes = new_file.size;
+  std::vector<int> old_files;
+  for (const auto& it : files_) {
+    if (it.first != new_file_id) old_files.push_back(it.first);
+  }
+  for (int id : old_files) {
+    DropFile(id);
+  }
+  writer_file_ = new_file_id;
+  writer_ = std::move(new_writer);
+  writer_dirty_ = true;
+  stats_.file_bytes = new_file.size;
+  stats_.live_bytes = new_file.size;
+  ++stats_.num_compactions;
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::FlushWriter() {
+  if (writer_dirty_) {
+    TF_RETURN_IF_ERROR(writer_->Flush());
+    writer_dirty_ = false;
+  }
+  return OkStatus();
+}
+
+Status SpillingShuffleBuffer::NewFile(int* file_id,
+                                      std::unique_ptr<WritableFile>* writer) {
+  TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(options_.directory));
+  File file;
+  file.filename = io::JoinPath(
+      options_.directory, strings::StrCat("shuffle_spill_", env_->NowMicros(),
+                                          "_", random::New64(), ".bin"));
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(file.filename, writer));
+  TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(file.filename, &file.reader));
+  *file_id = next_file_id_++;
+  files_[*file_id] = std::move(file);
+  return OkStatus();
+}
+
+void SpillingShuffleBuffer::DropFile(int file_id) {
+  if (file_id == writer_file_) {
+    writer_->Close().IgnoreError();
+    writer_.reset();
+    writer_file_ = -1;
+    writer_dirty_ = false;
+  }
+  for (auto it = lru_.begin(); it != lru_.end();) {
+    if (it->first == file_id) {
+      pages_.erase(*it);
+      it = lru_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  File& file = files_[file_id];
+  stats_.file_bytes -= file.size;
+  stats_.live_bytes -= file.live_bytes;
+  file.reader.reset();
+  if (!file.pinned) {
+    Status s = env_->DeleteFile(file.filename);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to delete shuffle spill file " << file.filename
+                   << ": " << s;
+    }
+  }
+  files_.erase(file_id);
+}
+
+void SpillingShuffleBuffer::InvalidatePage(int file_id, int64_t page) {
+  auto it = pages_.find(PageKey(file_id, page));
+  if (it != pages_.end()) {
+    lru_.erase(it->second.first);
+    pages_.erase(it);
+  }
+}
+
+void SpillingShuffleBuffer::Clear() {
+  std::vector<int> ids;
+  for (const auto& it : files_) ids.push_back(it.first);
+  for (int id : ids) {
+    DropFile(id);
+  }
+  slots_.assign(slots_.size(), Slot());
+  stats_.live_bytes = 0;
+  stats_.file_bytes = 0;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,147 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
+#define TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace data {
+
+// A fixed number of slots holding dataset elements, for shuffle buffers that
+// are too large for host memory.
+//
+// Only a compact index of the slots is kept in memory. Elements are
+// serialized and appended to scratch files in `Options::directory`, and are
+// read back through an LRU cache of file pages, so that recently written
+// elements are usually served from memory. When more than half of the scratch
+// data belongs to taken elements, the live elements are compacted into a new
+// file.
+//
+// Checkpoints only contain the index and the names of the scratch files, which
+// are then kept on disk after the buffer is destroyed so that the checkpoint
+// can be restored. Such files are never deleted by the buffer, and must be
+// removed by the user along with the checkpoint.
+//
+// This class is not thread-safe.
+class SpillingShuffleBuffer {
+ public:
+  struct Options {
+    std::string directory;
+    // Size of the pages cached in memory.
+    int64_t page_size_bytes = 1 << 20;
+    // Maximum number of pages cached in memory.
+    int64_t max_cached_pages = 64;
+    // Scratch files are not compacted while they hold less than this.
+    int64_t min_compaction_bytes = 64 << 20;
+  };
+
+  struct Stats {
+    int64_t live_bytes = 0;
+    int64_t file_bytes = 0;
+    int64_t num_compactions = 0;
+    int64_t num_cache_hits = 0;
+    int64_t num_cache_misses = 0;
+  };
+
+  SpillingShuffleBuffer(Env* env, const Options& options, int64_t size);
+  ~SpillingShuffleBuffer();
+
+  int64_t size() const { return slots_.size(); }
+
+  // Stores `element` in the empty slot `slot`.
+  Status Put(int64_t slot, const std::vector<Tensor>& element);
+
+  // Moves the element in slot `slot` to `element`, leaving the slot empty.
+  Status Take(int64_t slot, std::vector<Tensor>* element);
+
+  // Exchanges the contents of two slots.
+  void Swap(int64_t a, int64_t b) { std::swap(slots_[a], slots_[b]); }
+
+  Status Save(IteratorStateWriter* writer, const std::string& prefix);
+  Status Restore(IteratorStateReader* reader, const std::string& prefix);
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Slot {
+    int file = -1;
+    int64_t offset = 0;
+    int64_t length = 0;
+  };
+
+  struct File {
+    std::string filename;
+    std::unique_ptr<RandomAccessFile> reader;
+    int64_t size = 0;
+    // Bytes of elements in the file that have not been taken.
+    int64_t live_bytes = 0;
+    // Whether the file is referenced by a checkpoint, and must not be
+    // deleted.
+    bool pinned = false;
+  };
+
+  using PageKey = std::pair<int, int64_t>;
+
+  // Appends `data` to the file being written, creating it if needed.
+  Status Append(StringPiece data, Slot* slot);
+  Status Read(const Slot& slot, std::string* data);
+  Status ReadPage(int file, int64_t page, StringPiece* data);
+  // Moves the live elements to a new file if enough of the files is dead.
+  Status MaybeCompact();
+  Status FlushWriter();
+  // Creates a scratch file, returning its id and a writer for it.
+  Status NewFile(int* file, std::unique_ptr<WritableFile>* writer);
+  // Forgets `file`, deleting it unless it is pinned.
+  void DropFile(int file);
+  void InvalidatePage(int file, int64_t page);
+  // Drops all files and empties all slots.
+  void Clear();
+
+  Env* const env_;
+  const Options options_;
+  std::vector<Slot> slots_;
+  absl::flat_hash_map<int, File> files_;
+  int next_file_id_ = 0;
+
+  // The file being appended to, if any.
+  int writer_file_ = -1;
+  std::unique_ptr<WritableFile> writer_;
+  bool writer_dirty_ = false;
+
+  // LRU cache of file pages, most recently used first.
+  std::list<PageKey> lru_;
+  absl::flat_hash_map<PageKey,
+                      std::pair<std::list<PageKey>::iterator, std::string>>
+      pages_;
+
+  Stats stats_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_DATA_SPILLING_SHUFFLE_BUFFER_H_
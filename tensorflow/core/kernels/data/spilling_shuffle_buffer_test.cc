@@ -0,0 +1,154 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/data/spilling_shuffle_buffer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/data/serialization_utils.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kPrefix[] = "Iterator::Shuffle";
+
+std::vector<Tensor> MakeElement(int64_t i) {
+  return {test::AsScalar<int64_t>(i),
+          test::AsTensor<tstring>({absl::StrCat("element_", i), "x"})};
+}
+
+void ExpectElement(const std::vector<Tensor>& element, int64_t i) {
+  ASSERT_EQ(element.size(), 2);
+  test::ExpectEqual(element[0], test::AsScalar<int64_t>(i));
+  test::ExpectEqual(
+      element[1], test::AsTensor<tstring>({absl::StrCat("element_", i), "x"}));
+}
+
+class SpillingShuffleBufferTest : public ::testing::Test {
+ protected:
+  SpillingShuffleBufferTest() {
+    options_.directory = io::JoinPath(
+        testing::TmpDir(), "shuffle_spill",
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    // Small pages, so that elements span several pages.
+    options_.page_size_bytes = 16;
+    options_.max_cached_pages = 4;
+  }
+
+  int64_t NumSpillFiles() {
+    std::vector<std::string> children;
+    TF_CHECK_OK(Env::Default()->GetChildren(options_.directory, &children));
+    return children.size();
+  }
+
+  SpillingShuffleBuffer::Options options_;
+};
+
+TEST_F(SpillingShuffleBufferTest, PutTakeSwap) {
+  SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/10);
+  for (int64_t i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(buffer.Put(i, MakeElement(i)));
+  }
+  EXPECT_FALSE(buffer.Put(3, MakeElement(3)).ok());
+  buffer.Swap(2, 7);
+  std::vector<Tensor> element;
+  TF_ASSERT_OK(buffer.Take(2, &element));
+  ExpectElement(element, 7);
+  TF_ASSERT_OK(buffer.Take(7, &element));
+  ExpectElement(element, 2);
+  EXPECT_FALSE(buffer.Take(7, &element).ok());
+  TF_ASSERT_OK(buffer.Put(7, MakeElement(70)));
+  TF_ASSERT_OK(buffer.Take(7, &element));
+  ExpectElement(element, 70);
+  EXPECT_GT(buffer.stats().num_cache_hits, 0);
+  EXPECT_GT(buffer.stats().num_cache_misses, 0);
+}
+
+TEST_F(SpillingShuffleBufferTest, Compaction) {
+  options_.min_compaction_bytes = 0;
+  {
+    SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/4);
+    std::vector<Tensor> element;
+    for (int64_t i = 0; i < 100; ++i) {
+      const int64_t slot = i % 4;
+      if (i >= 4) {
+        TF_ASSERT_OK(buffer.Take(slot, &element));
+        ExpectElement(element, i - 4);
+      }
+      TF_ASSERT_OK(buffer.Put(slot, MakeElement(i)));
+      EXPECT_LE(buffer.stats().file_bytes, 2 * buffer.stats().live_bytes);
+    }
+    EXPECT_GT(buffer.stats().num_compactions, 0);
+    EXPECT_EQ(NumSpillFiles(), 1);
+  }
+  // Unpinned files are deleted with the buffer.
+  EXPECT_EQ(NumSpillFiles(), 0);
+}
+
+TEST_F(SpillingShuffleBufferTest, SaveAndRestore) {
+  VariantTensorDataWriter writer;
+  {
+    SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/5);
+    for (int64_t i = 0; i < 5; ++i) {
+      TF_ASSERT_OK(buffer.Put(i, MakeElement(i)));
+    }
+    std::vector<Tensor> element;
+    TF_ASSERT_OK(buffer.Take(1, &element));
+    TF_ASSERT_OK(buffer.Save(&writer, kPrefix));
+    // Changes after the checkpoint do not affect it.
+    TF_ASSERT_OK(buffer.Take(3, &element));
+    TF_ASSERT_OK(buffer.Put(1, MakeElement(10)));
+  }
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+
+  SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/5);
+  TF_ASSERT_OK(buffer.Restore(&reader, kPrefix));
+  std::vector<Tensor> element;
+  EXPECT_FALSE(buffer.Take(1, &element).ok());
+  for (int64_t i : {0, 2, 3, 4}) {
+    TF_ASSERT_OK(buffer.Take(i, &element));
+    ExpectElement(element, i);
+  }
+  TF_ASSERT_OK(buffer.Put(1, MakeElement(11)));
+  TF_ASSERT_OK(buffer.Take(1, &element));
+  ExpectElement(element, 11);
+}
+
+TEST_F(SpillingShuffleBufferTest, RestoreWithDifferentSize) {
+  VariantTensorDataWriter writer;
+  {
+    SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/5);
+    TF_ASSERT_OK(buffer.Save(&writer, kPrefix));
+  }
+  std::vector<const VariantTensorData*> data;
+  writer.GetData(&data);
+  VariantTensorDataReader reader(data);
+  SpillingShuffleBuffer buffer(Env::Default(), options_, /*size=*/6);
+  EXPECT_TRUE(errors::IsFailedPrecondition(buffer.Restore(&reader, kPrefix)));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -49,6 +49,8 @@ class TakeDataset : public DatasetBase {
 
   Status CheckExternalState() const override;
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -98,6 +98,8 @@ class TensorSliceDatasetOp::Dataset : public DatasetBase {
 
   Status CheckExternalState() const override { return OkStatus(); }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
   Status Get(OpKernelContext* ctx, int64 index,
              std::vector<Tensor>* out_tensors) const override {
     TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
@@ -36,6 +36,7 @@ namespace data {
 /* static */ constexpr const char* const TFRecordDatasetOp::kFileNames;
 /* static */ constexpr const char* const TFRecordDatasetOp::kCompressionType;
 /* static */ constexpr const char* const TFRecordDatasetOp::kBufferSize;
+/* static */ constexpr const char* const TFRecordDatasetOp::kReadaheadDepth;
 
 constexpr char kCurrentFileIndex[] = "current_file_index";
 constexpr char kOffset[] = "offset";
@@ -55,7 +56,8 @@ bool is_cloud_tpu_gcs_fs() {
 class TFRecordDatasetOp::Dataset : public DatasetBase {
  public:
   explicit Dataset(OpKernelContext* ctx, std::vector<string> filenames,
-                   const string& compression_type, int64_t buffer_size)
+                   const string& compression_type, int64_t buffer_size,
+                   int64_t readahead_depth)
       : DatasetBase(DatasetContext(ctx)),
         filenames_(std::move(filenames)),
         compression_type_(compression_type),
@@ -64,6 +66,12 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     if (buffer_size > 0) {
       options_.buffer_size = buffer_size;
     }
+    if (readahead_depth > 0) {
+      options_.readahead_depth = readahead_depth;
+      if (buffer_size > 0) {
+        options_.readahead_chunk_size = buffer_size;
+      }
+    }
   }
 
   std::unique_ptr<IteratorBase> MakeIteratorInternal(
@@ -93,6 +101,8 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
   Status CheckExternalState() const override { return OkStatus(); }
 
+  bool SymbolicCheckpointCompatible() const override { return true; }
+
  protected:
   Status AsGraphDefInternal(SerializationContext* ctx,
                             DatasetGraphDefBuilder* b,
@@ -103,8 +113,14 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
     TF_RETURN_IF_ERROR(b->AddScalar(compression_type_, &compression_type));
     Node* buffer_size = nullptr;
     TF_RETURN_IF_ERROR(b->AddScalar(options_.buffer_size, &buffer_size));
+    std::vector<std::pair<StringPiece, AttrValue>> attrs;
+    if (options_.readahead_depth > 0) {
+      AttrValue readahead_depth;
+      b->BuildAttrValue<int64_t>(options_.readahead_depth, &readahead_depth);
+      attrs.emplace_back(kReadaheadDepth, readahead_depth);
+    }
     TF_RETURN_IF_ERROR(b->AddDataset(
-        this, {filenames, compression_type, buffer_size}, output));
+        this, {filenames, compression_type, buffer_size}, attrs, output));
     return OkStatus();
   }
 
@@ -276,7 +292,15 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 };
 
 TFRecordDatasetOp::TFRecordDatasetOp(OpKernelConstruction* ctx)
-    : DatasetOpKernel(ctx) {}
+    : DatasetOpKernel(ctx) {
+  if (ctx->HasAttr(kReadaheadDepth)) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr(kReadaheadDepth, &readahead_depth_));
+    OP_REQUIRES(ctx, readahead_depth_ >= 0,
+                errors::InvalidArgument("`", kReadaheadDepth,
+                                        "` must be >= 0, but got ",
+                                        readahead_depth_));
+  }
+}
 
 void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
                                     DatasetBase** output) {
@@ -324,8 +348,8 @@ void TFRecordDatasetOp::MakeDataset(OpKernelContext* ctx,
     buffer_size = kS3BlockSize;
   }
 
-  *output =
-      new Dataset(ctx, std::move(filenames), compression_type, buffer_size);
+  *output = new Dataset(ctx, std::move(filenames), compression_type,
+                        buffer_size, readahead_depth_);
 }
 
 namespace {
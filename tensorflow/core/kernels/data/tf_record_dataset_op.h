@@ -26,6 +26,9 @@ class TFRecordDatasetOp : public DatasetOpKernel {
   static constexpr const char* const kFileNames = "filenames";
   static constexpr const char* const kCompressionType = "compression_type";
   static constexpr const char* const kBufferSize = "buffer_size";
+  // Number of chunks of `buffer_size` bytes to read ahead asynchronously, or 0
+  // to read synchronously.
+  static constexpr const char* const kReadaheadDepth = "_readahead_depth";
 
   explicit TFRecordDatasetOp(OpKernelConstruction* ctx);
 
@@ -34,6 +37,8 @@ class TFRecordDatasetOp : public DatasetOpKernel {
 
  private:
   class Dataset;
+
+  int64_t readahead_depth_ = 0;
 };
 
 }  // namespace data
@@ -14,13 +14,18 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <cstring>
+#include <limits>
 #include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/csv_parsing.h"
 #include "tensorflow/core/lib/core/errors.h"
-#include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -76,129 +81,65 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
+    if (records_size == 0) return;
 
-    for (int64_t i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32_t value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
-          }
-          case DT_INT64: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64_t>()(i) =
-                  record_defaults[f].flat<int64_t>()(0);
-            } else {
-              int64_t value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64_t>()(i) = value;
-            }
-            break;
-          }
-          case DT_FLOAT: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
-            }
-            break;
-          }
-          case DT_DOUBLE: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<double>()(i) =
-                  record_defaults[f].flat<double>()(0);
-            } else {
-              double value;
-              OP_REQUIRES(ctx, strings::safe_strtod(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid double: ", fields[f]));
-              output[f]->flat<double>()(i) = value;
-            }
-            break;
-          }
-          case DT_STRING: {
-            // If this field is empty or NA value, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty() || fields[f] == na_value_) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<tstring>()(i) =
-                  record_defaults[f].flat<tstring>()(0);
-            } else {
-              output[f]->flat<tstring>()(i) = std::move(fields[f]);
-            }
-            break;
+    // Records are parsed independently on the intra-op threads. If several
+    // records are invalid, the error of the first one is reported, as if they
+    // were parsed in order.
+    mutex mu;
+    int64_t first_error_record = records_size;
+    Status first_error;
+    auto parse_records = [&](int64_t begin, int64_t end) {
+      std::vector<Field> fields;
+      for (int64_t i = begin; i < end; ++i) {
+        Status s = ParseRecord(records_t(i), i, record_defaults, outputs,
+                               &fields);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_record) {
+            first_error_record = i;
+            first_error = s;
           }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          return;
         }
       }
+    };
+
+    int64_t total_bytes = 0;
+    for (int64_t i = 0; i < records_size; ++i) {
+      total_bytes += records_t(i).size();
     }
+    const int64_t cost_per_record =
+        kCostPerByte * (total_bytes / records_size) +
+        kCostPerField * static_cast<int64_t>(out_type_.size());
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          cost_per_record, parse_records);
+    OP_REQUIRES_OK(ctx, first_error);
   }
 
  private:
+  // Approximate cost in cycles of scanning one byte of a record and of
+  // converting one field, used to shard the records.
+  static constexpr int64_t kCostPerByte = 4;
+  static constexpr int64_t kCostPerField = 50;
+
+  // A field of a record. Fields without escaped quotes point into the record,
+  // the others are unescaped into `unescaped`.
+  struct Field {
+    StringPiece piece;
+    string unescaped;
+    bool escaped = false;
+
+    StringPiece value() const {
+      return escaped ? StringPiece(unescaped) : piece;
+    }
+  };
+
   std::vector<DataType> out_type_;
   std::vector<int64_t> select_cols_;
   char delim_;
@@ -206,90 +147,166 @@ class DecodeCSVOp : public OpKernel {
   bool select_all_cols_;
   string na_value_;
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64_t current_idx = 0;
+  // Parses record `i` into the `i`-th element of each of `outputs`, using
+  // `fields` as scratch space.
+  Status ParseRecord(StringPiece record, int64_t i,
+                     const OpInputList& record_defaults,
+                     const std::vector<Tensor*>& outputs,
+                     std::vector<Field>* fields) const {
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const StringPiece field = (*fields)[f].value();
+      const DataType& dtype = out_type_[f];
+      switch (dtype) {
+        case DT_INT32:
+          TF_RETURN_IF_ERROR(ConvertField<int32>(field, f, i,
+                                                 record_defaults[f],
+                                                 outputs[f]));
+          break;
+        case DT_INT64:
+          TF_RETURN_IF_ERROR(ConvertField<int64_t>(field, f, i,
+                                                   record_defaults[f],
+                                                   outputs[f]));
+          break;
+        case DT_FLOAT:
+          TF_RETURN_IF_ERROR(ConvertField<float>(field, f, i,
+                                                 record_defaults[f],
+                                                 outputs[f]));
+          break;
+        case DT_DOUBLE:
+          TF_RETURN_IF_ERROR(ConvertField<double>(field, f, i,
+                                                  record_defaults[f],
+                                                  outputs[f]));
+          break;
+        case DT_STRING:
+          TF_RETURN_IF_ERROR(ConvertField<tstring>(field, f, i,
+                                                   record_defaults[f],
+                                                   outputs[f]));
+          break;
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
+      }
+    }
+    return OkStatus();
+  }
+
+  // Converts field `f` of record `i` into the `i`-th element of `output`.
+  template <typename T>
+  Status ConvertField(StringPiece field, int f, int64_t i,
+                      const Tensor& record_default, Tensor* output) const {
+    T* value = &output->flat<T>()(i);
+    // If this field is empty or NA value, check if default is given:
+    // If yes, use default value; Otherwise report error.
+    if (field.empty() || field == na_value_) {
+      if (record_default.NumElements() != 1) {
+        return errors::InvalidArgument("Field ", f,
+                                       " is required but missing in record ",
+                                       i, "!");
+      }
+      *value = record_default.flat<T>()(0);
+      return OkStatus();
+    }
+    if (!csv::ParseValue(field, value)) {
+      return errors::InvalidArgument(
+          "Field ", f, " in record ", i, " is not a valid ",
+          DataTypeString(DataTypeToEnum<T>::value), ": ", field);
+    }
+    return OkStatus();
+  }
+
+  Status ExtractFields(StringPiece input, std::vector<Field>* result) const {
+    result->clear();
+    if (input.empty()) return OkStatus();
+
+    const char* const end = input.data() + input.size();
+    const char* p = input.data();
     int64_t num_fields_parsed = 0;
     int64_t selector_idx = 0;  // Keep track of index into select_cols
 
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+    while (p < end) {
+      if (*p == '\n' || *p == '\r') {
+        ++p;
+        continue;
+      }
 
-        bool quoted = false;
-        bool include =
-            (select_all_cols_ || select_cols_[selector_idx] ==
-                                     static_cast<size_t>(num_fields_parsed));
+      bool include =
+          (select_all_cols_ || select_cols_[selector_idx] == num_fields_parsed);
+      Field* field = nullptr;
+      if (include) {
+        result->emplace_back();
+        field = &result->back();
+      }
 
-        if (use_quote_delim_ && input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+      if (!use_quote_delim_ || *p != '"') {
+        const char* field_end =
+            csv::FindSpecialChar(p, end, delim_, use_quote_delim_);
+        if (field_end < end && *field_end != delim_) {
+          return errors::InvalidArgument(
+              "Unquoted fields cannot have quotes/CRLFs inside");
         }
+        if (include) field->piece = StringPiece(p, field_end - p);
 
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            if (include) field += input[current_idx];
-            current_idx++;
-          }
-
-          // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              if (include) field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              if (include) field += '"';
-              current_idx += 2;
-            }
-          }
+        // Go to next field or the end
+        p = field_end < end ? field_end + 1 : end;
+      } else {
+        TF_RETURN_IF_ERROR(ExtractQuotedField(p + 1, end, &p, field));
+      }
 
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
+      num_fields_parsed++;
+      if (include) {
+        selector_idx++;
+        if (selector_idx == select_cols_.size()) return OkStatus();
+      }
+    }
 
-          current_idx += 2;
-        }
+    bool include =
+        (select_all_cols_ || select_cols_[selector_idx] == num_fields_parsed);
+    // Check if the last field is missing
+    if (include && input[input.size() - 1] == delim_) result->emplace_back();
+    return OkStatus();
+  }
 
-        num_fields_parsed++;
-        if (include) {
-          result->push_back(field);
-          selector_idx++;
-          if (selector_idx == select_cols_.size()) return;
+  // Extracts the quoted field whose body starts at `begin`, just after the
+  // opening quote, into `field` unless it is null. Sets `*next` to the start
+  // of the next field.
+  Status ExtractQuotedField(const char* begin, const char* end,
+                            const char** next, Field* field) const {
+    const char* p = begin;
+    while (true) {
+      // Quoted field needs to be ended with '"' and delim or end
+      const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+      if (quote == nullptr) {
+        return errors::InvalidArgument(
+            "Quoted field has to end with quote followed by delim or end");
+      }
+      if (quote + 1 == end || quote[1] == delim_) {
+        if (field != nullptr) {
+          if (field->escaped) {
+            field->unescaped.append(p, quote - p);
+          } else {
+            field->piece = StringPiece(begin, quote - begin);
+          }
         }
+        *next = quote + 1 == end ? end : quote + 2;
+        return OkStatus();
       }
-
-      bool include =
-          (select_all_cols_ || select_cols_[selector_idx] ==
-                                   static_cast<size_t>(num_fields_parsed));
-      // Check if the last field is missing
-      if (include && input[input.size() - 1] == delim_)
-        result->push_back(string());
+      if (quote[1] != '"') {
+        return errors::InvalidArgument(
+            "Quote inside a string has to be escaped by another quote");
+      }
+      if (field != nullptr) {
+        field->escaped = true;
+        field->unescaped.append(p, quote + 1 - p);
+      }
+      p = quote + 2;
     }
   }
 };
@@ -0,0 +1,145 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class DecodeCSVOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const DataTypeVector& out_type,
+              const std::vector<int64_t>& select_cols = {}) {
+    TF_ASSERT_OK(NodeDefBuilder("decode_csv", "DecodeCSV")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(out_type))
+                     .Attr("select_cols", select_cols)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(DecodeCSVOpTest, QuotesAndDefaults) {
+  MakeOp({DT_INT32, DT_FLOAT, DT_STRING});
+  AddInputFromArray<tstring>(TensorShape({3}),
+                             {"1,2.5,\"a,\"\"b\"\"\"", ",,x", "3,-1,\"\""});
+  AddInputFromArray<int32>(TensorShape({1}), {7});
+  AddInputFromArray<float>(TensorShape({1}), {0.5});
+  AddInputFromArray<tstring>(TensorShape({1}), {"d"});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(0), test::AsTensor<int32>({1, 7, 3}, TensorShape({3})));
+  test::ExpectTensorEqual<float>(
+      *GetOutput(1), test::AsTensor<float>({2.5, 0.5, -1}, TensorShape({3})));
+  test::ExpectTensorEqual<tstring>(
+      *GetOutput(2),
+      test::AsTensor<tstring>({"a,\"b\"", "x", "d"}, TensorShape({3})));
+}
+
+TEST_F(DecodeCSVOpTest, SelectCols) {
+  MakeOp({DT_INT64, DT_STRING}, {1, 3});
+  AddInputFromArray<tstring>(TensorShape({2}),
+                             {"x,10,\"y\",abc,z", "\"x\"\"\",11,y,\"\""});
+  AddInputFromArray<int64_t>(TensorShape({0}), {});
+  AddInputFromArray<tstring>(TensorShape({1}), {"d"});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int64_t>(
+      *GetOutput(0), test::AsTensor<int64_t>({10, 11}, TensorShape({2})));
+  test::ExpectTensorEqual<tstring>(
+      *GetOutput(1), test::AsTensor<tstring>({"abc", "d"}, TensorShape({2})));
+}
+
+TEST_F(DecodeCSVOpTest, IntegerLimits) {
+  MakeOp({DT_INT32, DT_INT64});
+  AddInputFromArray<tstring>(
+      TensorShape({2}), {"-2147483648,9223372036854775807",
+                         " 2147483647 ,-9223372036854775808"});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  AddInputFromArray<int64_t>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  test::ExpectTensorEqual<int32>(
+      *GetOutput(0),
+      test::AsTensor<int32>({kint32min, kint32max}, TensorShape({2})));
+  test::ExpectTensorEqual<int64_t>(
+      *GetOutput(1),
+      test::AsTensor<int64_t>({kint64max, kint64min}, TensorShape({2})));
+}
+
+TEST_F(DecodeCSVOpTest, IntegerOverflow) {
+  MakeOp({DT_INT32});
+  AddInputFromArray<tstring>(TensorShape({1}), {"2147483648"});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(s.error_message(), "not a valid int32")) << s;
+}
+
+// Large enough to be split across threads.
+constexpr int kNumLargeRecords = 100000;
+
+TEST_F(DecodeCSVOpTest, LargeBatch) {
+  MakeOp({DT_INT64, DT_DOUBLE, DT_STRING});
+  std::vector<tstring> records(kNumLargeRecords);
+  for (int i = 0; i < kNumLargeRecords; ++i) {
+    records[i] = strings::StrCat(i, ",", i * 0.5, ",\"s", i, "\"");
+  }
+  AddInputFromArray<tstring>(TensorShape({kNumLargeRecords}), records);
+  AddInputFromArray<int64_t>(TensorShape({0}), {});
+  AddInputFromArray<double>(TensorShape({0}), {});
+  AddInputFromArray<tstring>(TensorShape({0}), {});
+  TF_ASSERT_OK(RunOpKernel());
+
+  auto ints = GetOutput(0)->flat<int64_t>();
+  auto doubles = GetOutput(1)->flat<double>();
+  auto strs = GetOutput(2)->flat<tstring>();
+  for (int i = 0; i < kNumLargeRecords; ++i) {
+    ASSERT_EQ(ints(i), i);
+    ASSERT_EQ(doubles(i), i * 0.5);
+    ASSERT_EQ(strs(i), strings::StrCat("s", i));
+  }
+}
+
+TEST_F(DecodeCSVOpTest, LargeBatchReportsFirstError) {
+  MakeOp({DT_INT32, DT_INT32});
+  std::vector<tstring> records(kNumLargeRecords, "1,2");
+  records[kNumLargeRecords - 10] = "1,x";
+  records[kNumLargeRecords / 2] = "1,2,3";
+  AddInputFromArray<tstring>(TensorShape({kNumLargeRecords}), records);
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  AddInputFromArray<int32>(TensorShape({0}), {});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(absl::StrContains(
+      s.error_message(),
+      strings::StrCat("Expect 2 fields but have 3 in record ",
+                      kNumLargeRecords / 2)))
+      << s;
+}
+
+}  // namespace
+}  // namespace tensorflow
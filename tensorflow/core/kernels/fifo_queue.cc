@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/kernels/ring_buffer_fifo_queue.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -376,6 +377,14 @@ FIFOQueueOp::FIFOQueueOp(OpKernelConstruction* context)
 }
 
 Status FIFOQueueOp::CreateResource(QueueInterface** ret) {
+  // Bounded queues of small, fixed-shape elements use a ring buffer that
+  // avoids taking a lock in enqueues and dequeues that do not block.
+  if (RingBufferFIFOQueue::IsSupported(capacity_, component_types_,
+                                       component_shapes_)) {
+    RingBufferFIFOQueue* queue = new RingBufferFIFOQueue(
+        capacity_, component_types_, component_shapes_, cinfo_.name());
+    return CreateTypedQueue(queue, ret);
+  }
   FIFOQueue* queue = new FIFOQueue(capacity_, component_types_,
                                    component_shapes_, cinfo_.name());
   return CreateTypedQueue(queue, ret);
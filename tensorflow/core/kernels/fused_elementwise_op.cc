@@ -0,0 +1,301 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Evaluates a program of elementwise ops in a single pass over memory. See
+// the documentation of the _FusedElementwise op.
+
+#define EIGEN_USE_THREADS
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+enum class ElementwiseOp {
+  kAdd,
+  kSub,
+  kMul,
+  kRealDiv,
+  kMaximum,
+  kMinimum,
+  kSquaredDifference,
+  kNeg,
+  kAbs,
+  kSquare,
+  kSqrt,
+  kRsqrt,
+  kReciprocal,
+  kExp,
+  kLog,
+  kTanh,
+  kSigmoid,
+  kRelu,
+  kRelu6,
+};
+
+struct ElementwiseOpInfo {
+  ElementwiseOp op;
+  int arity;
+};
+
+// Maps the names of the supported TF ops to their opcode.
+const absl::flat_hash_map<string, ElementwiseOpInfo>& ElementwiseOps() {
+  static const auto* ops = new absl::flat_hash_map<string, ElementwiseOpInfo>({
+      {"Add", {ElementwiseOp::kAdd, 2}},
+      {"AddV2", {ElementwiseOp::kAdd, 2}},
+      {"Sub", {ElementwiseOp::kSub, 2}},
+      {"Mul", {ElementwiseOp::kMul, 2}},
+      {"RealDiv", {ElementwiseOp::kRealDiv, 2}},
+      {"Maximum", {ElementwiseOp::kMaximum, 2}},
+      {"Minimum", {ElementwiseOp::kMinimum, 2}},
+      {"SquaredDifference", {ElementwiseOp::kSquaredDifference, 2}},
+      {"Neg", {ElementwiseOp::kNeg, 1}},
+      {"Abs", {ElementwiseOp::kAbs, 1}},
+      {"Square", {ElementwiseOp::kSquare, 1}},
+      {"Sqrt", {ElementwiseOp::kSqrt, 1}},
+      {"Rsqrt", {ElementwiseOp::kRsqrt, 1}},
+      {"Reciprocal", {ElementwiseOp::kReciprocal, 1}},
+      {"Exp", {ElementwiseOp::kExp, 1}},
+      {"Log", {ElementwiseOp::kLog, 1}},
+      {"Tanh", {ElementwiseOp::kTanh, 1}},
+      {"Sigmoid", {ElementwiseOp::kSigmoid, 1}},
+      {"Relu", {ElementwiseOp::kRelu, 1}},
+      {"Relu6", {ElementwiseOp::kRelu6, 1}},
+  });
+  return *ops;
+}
+
+// Computes `out[0, n) = op(a[0, n), b[0, n))`, with the same functors as the
+// standalone kernels, so that results are identical. `b` is ignored by unary
+// ops.
+template <typename T>
+void EvaluateElementwiseOp(ElementwiseOp op, const T* a, const T* b, int64_t n,
+                           T* out) {
+  typename TTypes<T>::ConstFlat x(a, n);
+  typename TTypes<T>::ConstFlat y(b, b == nullptr ? 0 : n);
+  typename TTypes<T>::Flat z(out, n);
+  switch (op) {
+    case ElementwiseOp::kAdd:
+      z = x.binaryExpr(y, typename functor::add<T>::func());
+      break;
+    case ElementwiseOp::kSub:
+      z = x.binaryExpr(y, typename functor::sub<T>::func());
+      break;
+    case ElementwiseOp::kMul:
+      z = x.binaryExpr(y, typename functor::mul<T>::func());
+      break;
+    case ElementwiseOp::kRealDiv:
+      z = x.binaryExpr(y, typename functor::div<T>::func());
+      break;
+    case ElementwiseOp::kMaximum:
+      z = x.binaryExpr(y, typename functor::maximum<T>::func());
+      break;
+    case ElementwiseOp::kMinimum:
+      z = x.binaryExpr(y, typename functor::minimum<T>::func());
+      break;
+    case ElementwiseOp::kSquaredDifference:
+      z = x.binaryExpr(y, typename functor::squared_difference<T>::func());
+      break;
+    case ElementwiseOp::kNeg:
+      z = x.unaryExpr(typename functor::neg<T>::func());
+      break;
+    case ElementwiseOp::kAbs:
+      z = x.unaryExpr(typename functor::abs<T>::func());
+      break;
+    case ElementwiseOp::kSquare:
+      z = x.unaryExpr(typename functor::square<T>::func());
+      break;
+    case ElementwiseOp::kSqrt:
+      z = x.unaryExpr(typename functor::sqrt<T>::func());
+      break;
+    case ElementwiseOp::kRsqrt:
+      z = x.unaryExpr(typename functor::rsqrt<T>::func());
+      break;
+    case ElementwiseOp::kReciprocal:
+      z = x.unaryExpr(typename functor::inverse<T>::func());
+      break;
+    case ElementwiseOp::kExp:
+      z = x.unaryExpr(typename functor::exp<T>::func());
+      break;
+    case ElementwiseOp::kLog:
+      z = x.unaryExpr(typename functor::log<T>::func());
+      break;
+    case ElementwiseOp::kTanh:
+      z = x.unaryExpr(typename functor::tanh<T>::func());
+      break;
+    case ElementwiseOp::kSigmoid:
+      z = x.unaryExpr(typename functor::sigmoid<T>::func());
+      break;
+    case ElementwiseOp::kRelu:
+      z = x.template cwiseMax<Eigen::PropagateNaN>(static_cast<T>(0));
+      break;
+    case ElementwiseOp::kRelu6:
+      z = x.template cwiseMax<Eigen::PropagateNaN>(static_cast<T>(0))
+              .template cwiseMin<Eigen::PropagateNaN>(static_cast<T>(6));
+      break;
+  }
+}
+
+}  // namespace
+
+// Evaluates the program block by block, keeping the intermediate results of a
+// block in small buffers that stay in cache, so that every input is read and
+// the output is written once. Blocks are evaluated in parallel.
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  // Number of elements of a block.
+  static constexpr int64_t kBlockSize = 1024;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args_));
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    OP_REQUIRES_OK(context, context->GetAttr("operands", &operands_));
+    OP_REQUIRES(context, !fused_ops.empty(),
+                errors::InvalidArgument("fused_ops must not be empty"));
+    OP_REQUIRES(context, operands_.size() == 2 * fused_ops.size(),
+                errors::InvalidArgument(
+                    "operands must have two entries per fused op, got ",
+                    operands_.size(), " for ", fused_ops.size(), " ops"));
+    for (int i = 0; i < fused_ops.size(); ++i) {
+      auto it = ElementwiseOps().find(fused_ops[i]);
+      OP_REQUIRES(context, it != ElementwiseOps().end(),
+                  errors::Unimplemented("Unsupported fused op: ",
+                                        fused_ops[i]));
+      ops_.push_back(it->second.op);
+      for (int j = 0; j < 2; ++j) {
+        const int operand = operands_[2 * i + j];
+        if (j >= it->second.arity) {
+          OP_REQUIRES(context, operand == -1,
+                      errors::InvalidArgument(
+                          "Unused operand of fused op ", i, " (",
+                          fused_ops[i], ") must be -1, got ", operand));
+          continue;
+        }
+        OP_REQUIRES(context, operand >= 0 && operand < num_args_ + i,
+                    errors::InvalidArgument(
+                        "Operand ", j, " of fused op ", i, " (", fused_ops[i],
+                        ") must refer to an argument or an earlier op, got ",
+                        operand));
+      }
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // Every argument is either a scalar, or has the shape of the output.
+    TensorShape shape;
+    std::vector<int> full_args;
+    for (int i = 0; i < num_args_; ++i) {
+      const Tensor& arg = context->input(i);
+      if (TensorShapeUtils::IsScalar(arg.shape())) continue;
+      if (full_args.empty()) {
+        shape = arg.shape();
+      } else {
+        OP_REQUIRES(context, arg.shape() == shape,
+                    errors::InvalidArgument(
+                        "Arguments must be scalars or have the same shape, "
+                        "got ",
+                        shape.DebugString(), " and ",
+                        arg.shape().DebugString(), " for argument ", i));
+      }
+      full_args.push_back(i);
+    }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                full_args, 0, shape, &output));
+    const int64_t size = shape.num_elements();
+    if (size == 0) return;
+
+    // Scalar arguments are read from a block filled with their value.
+    const int64_t block_size = std::min(size, kBlockSize);
+    std::vector<T> scalars(num_args_ * block_size);
+    std::vector<const T*> args(num_args_);
+    std::vector<bool> is_scalar(num_args_, true);
+    for (int i : full_args) is_scalar[i] = false;
+    for (int i = 0; i < num_args_; ++i) {
+      if (is_scalar[i]) {
+        std::fill_n(&scalars[i * block_size], block_size,
+                    context->input(i).scalar<T>()());
+        args[i] = &scalars[i * block_size];
+      } else {
+        args[i] = context->input(i).flat<T>().data();
+      }
+    }
+    T* out = output->flat<T>().data();
+
+    const int num_ops = ops_.size();
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/full_args.size() * sizeof(T) * block_size,
+        /*bytes_stored=*/sizeof(T) * block_size,
+        /*compute_cycles=*/num_ops * 4 * block_size);
+    const CPUDevice& device = context->eigen_cpu_device();
+    device.parallelFor(
+        Eigen::divup(size, block_size), cost,
+        [&](int64_t first_block, int64_t last_block) {
+          // Results of all ops but the last one for the current block.
+          std::unique_ptr<T[]> results(new T[(num_ops - 1) * block_size]);
+          auto operand = [&](int index, int64_t offset) -> const T* {
+            if (index < 0) return nullptr;
+            if (index >= num_args_) {
+              return &results[(index - num_args_) * block_size];
+            }
+            return is_scalar[index] ? args[index] : args[index] + offset;
+          };
+          for (int64_t block = first_block; block < last_block; ++block) {
+            const int64_t offset = block * block_size;
+            const int64_t n = std::min(block_size, size - offset);
+            for (int i = 0; i < num_ops; ++i) {
+              T* result = i == num_ops - 1 ? out + offset
+                                           : &results[i * block_size];
+              EvaluateElementwiseOp<T>(ops_[i],
+                                       operand(operands_[2 * i], offset),
+                                       operand(operands_[2 * i + 1], offset),
+                                       n, result);
+            }
+          }
+        });
+  }
+
+ private:
+  int num_args_;
+  std::vector<ElementwiseOp> ops_;
+  std::vector<int> operands_;
+};
+
+#define REGISTER_CPU_KERNEL(T)                                             \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+TF_CALL_float(REGISTER_CPU_KERNEL);
+TF_CALL_double(REGISTER_CPU_KERNEL);
+#undef REGISTER_CPU_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,114 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status Init(int num_args, const std::vector<string>& fused_ops,
+              const std::vector<int>& operands) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("fused", "_FusedElementwise")
+                           .Input(FakeInput(num_args, DT_FLOAT))
+                           .Attr("fused_ops", fused_ops)
+                           .Attr("operands", operands)
+                           .Finalize(node_def()));
+    return InitOp();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, MulAddTanhMul) {
+  // tanh(x * a + b) * c, with scalars a and b. Large enough to span several
+  // blocks.
+  TF_ASSERT_OK(Init(/*num_args=*/4, {"Mul", "AddV2", "Tanh", "Mul"},
+                    {0, 1, /**/ 4, 2, /**/ 5, -1, /**/ 6, 3}));
+  const int size = 3000;
+  std::vector<float> x(size), c(size), expected_values(size);
+  for (int i = 0; i < size; ++i) {
+    x[i] = (i % 17) * 0.25f - 2.0f;
+    c[i] = (i % 5) - 2.0f;
+    expected_values[i] = std::tanh(x[i] * 0.5f + 0.25f) * c[i];
+  }
+  AddInputFromArray<float>(TensorShape({3, size / 3}), x);
+  AddInputFromArray<float>(TensorShape({}), {0.5f});
+  AddInputFromArray<float>(TensorShape({}), {0.25f});
+  AddInputFromArray<float>(TensorShape({3, size / 3}), c);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({3, size / 3}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+}
+
+TEST_F(FusedElementwiseOpTest, ReusesResults) {
+  // relu6(x) * relu6(x) - x.
+  TF_ASSERT_OK(Init(/*num_args=*/1, {"Relu6", "Mul", "Sub"},
+                    {0, -1, /**/ 1, 1, /**/ 2, 0}));
+  AddInputFromArray<float>(TensorShape({4}), {-1, 2, 3, 8});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({4}));
+  test::FillValues<float>(&expected, {1, 2, 6, 28});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, AllScalars) {
+  TF_ASSERT_OK(Init(/*num_args=*/2, {"Maximum", "Sqrt"}, {0, 1, /**/ 2, -1}));
+  AddInputFromArray<float>(TensorShape({}), {4});
+  AddInputFromArray<float>(TensorShape({}), {9});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({}));
+  test::FillValues<float>(&expected, {3});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, MismatchedShapes) {
+  TF_ASSERT_OK(Init(/*num_args=*/2, {"Mul", "Neg"}, {0, 1, /**/ 2, -1}));
+  AddInputFromArray<float>(TensorShape({2}), {1, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidPrograms) {
+  // Refers to the result of a later op.
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      Init(/*num_args=*/1, {"Neg", "Exp"}, {2, -1, /**/ 0, -1})));
+  // Unary op with a second operand.
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(Init(/*num_args=*/2, {"Exp"}, {0, 1})));
+  // Missing operands.
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(Init(/*num_args=*/1, {"Exp", "Neg"}, {0})));
+  EXPECT_TRUE(
+      errors::IsUnimplemented(Init(/*num_args=*/1, {"Erf"}, {0, -1})));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,518 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernels of the _FusedLayerNorm, _FusedGelu and _FusedScaledMaskedSoftmax
+// ops, which the remapper creates from the subgraphs of transformer models.
+// Each op is computed one row of the last dimension at a time, so that every
+// input is read once and the output is written once, with AVX-512 versions of
+// the row functions on CPUs that support them.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(TENSORFLOW_DISABLE_FUSED_TRANSFORMER_SIMD)
+#define TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD (1)
+#include <immintrin.h>
+#define TF_TRANSFORMER_TARGET __attribute__((target("avx512f")))
+#endif
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+constexpr float kSqrtHalf = 0.70710678118654752f;
+constexpr float kSqrtTwoOverPi = 0.79788456080286536f;
+constexpr float kGeluCoefficient = 0.044715f;
+
+// Computes `y = (z - mean(z)) * rsqrt(variance(z) + epsilon) * scale + offset`
+// for one row of `n` elements, with `z = x + residual`, or `z = x` if
+// `residual` is null. `y` may alias `x`.
+void LayerNormRow(const float* x, const float* residual, const float* scale,
+                  const float* offset, float epsilon, int64_t n, float* y) {
+  const float* z = x;
+  if (residual != nullptr) {
+    for (int64_t i = 0; i < n; ++i) y[i] = x[i] + residual[i];
+    z = y;
+  }
+  double sum = 0;
+  for (int64_t i = 0; i < n; ++i) sum += z[i];
+  const float mean = sum / n;
+  double sum_of_squares = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    const float d = z[i] - mean;
+    sum_of_squares += d * d;
+  }
+  const float inv = 1.0f / std::sqrt(sum_of_squares / n + epsilon);
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] = (z[i] - mean) * (inv * scale[i]) + offset[i];
+  }
+}
+
+// Computes the GELU of `n` elements.
+void GeluRow(const float* x, bool approximate, int64_t n, float* y) {
+  if (approximate) {
+    for (int64_t i = 0; i < n; ++i) {
+      const float u =
+          kSqrtTwoOverPi * (x[i] + kGeluCoefficient * x[i] * x[i] * x[i]);
+      y[i] = 0.5f * x[i] * (1.0f + std::tanh(u));
+    }
+  } else {
+    for (int64_t i = 0; i < n; ++i) {
+      y[i] = 0.5f * x[i] * (1.0f + std::erf(x[i] * kSqrtHalf));
+    }
+  }
+}
+
+// Computes `y = softmax(x * scale + mask)` for one row of `n` elements. `mask`
+// may be null. `y` may alias `x`.
+void SoftmaxRow(const float* x, const float* mask, float scale, int64_t n,
+                float* y) {
+  float max = -std::numeric_limits<float>::infinity();
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] = x[i] * scale + (mask == nullptr ? 0.0f : mask[i]);
+    max = std::max(max, y[i]);
+  }
+  float sum = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] = std::exp(y[i] - max);
+    sum += y[i];
+  }
+  const float inv_sum = 1.0f / sum;
+  for (int64_t i = 0; i < n; ++i) y[i] *= inv_sum;
+}
+
+#ifdef TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD
+
+constexpr int kLanes = 16;
+
+bool IsAvx512Supported() {
+  static const bool supported =
+      port::TestCPUFeature(port::CPUFeature::AVX512F);
+  return supported;
+}
+
+// Mask of the first `n` lanes, for `n <= kLanes`.
+TF_TRANSFORMER_TARGET inline __mmask16 TailMask(int64_t n) {
+  return static_cast<__mmask16>((1u << n) - 1);
+}
+
+// Computes exp(x) with the range reduction and polynomial of Cephes' expf,
+// which Eigen also uses. The result is scaled by 2^n with vscalefps, which
+// also handles the underflow to zero of very negative inputs.
+TF_TRANSFORMER_TARGET inline __m512 Exp(__m512 x) {
+  x = _mm512_min_ps(x, _mm512_set1_ps(88.7228f));
+  x = _mm512_max_ps(x, _mm512_set1_ps(-104.0f));
+  const __m512 n = _mm512_roundscale_ps(
+      _mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+  r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+  __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+  p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r);
+  p = _mm512_add_ps(p, _mm512_set1_ps(1.0f));
+  return _mm512_scalef_ps(p, n);
+}
+
+// Computes 1 + erf(x) with the approximation 7.1.26 of Abramowitz and Stegun,
+// whose absolute error is below 1.5e-7. For negative inputs, the result is
+// computed as erfc(-x) directly, which keeps its relative error small.
+TF_TRANSFORMER_TARGET inline __m512 OnePlusErf(__m512 x) {
+  const __m512 abs_x = _mm512_abs_ps(x);
+  const __m512 t = _mm512_div_ps(
+      _mm512_set1_ps(1.0f),
+      _mm512_fmadd_ps(abs_x, _mm512_set1_ps(0.3275911f), _mm512_set1_ps(1.0f)));
+  __m512 p = _mm512_set1_ps(1.061405429f);
+  p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(-1.453152027f));
+  p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(1.421413741f));
+  p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(-0.284496736f));
+  p = _mm512_fmadd_ps(p, t, _mm512_set1_ps(0.254829592f));
+  p = _mm512_mul_ps(p, t);
+  const __m512 erfc_abs_x = _mm512_mul_ps(
+      p, Exp(_mm512_sub_ps(_mm512_setzero_ps(), _mm512_mul_ps(x, x))));
+  const __mmask16 negative =
+      _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_LT_OQ);
+  return _mm512_mask_blend_ps(
+      negative, _mm512_sub_ps(_mm512_set1_ps(2.0f), erfc_abs_x), erfc_abs_x);
+}
+
+TF_TRANSFORMER_TARGET void LayerNormRowAvx512(const float* x,
+                                              const float* residual,
+                                              const float* scale,
+                                              const float* offset,
+                                              float epsilon, int64_t n,
+                                              float* y) {
+  const float* z = x;
+  __m512 sum = _mm512_setzero_ps();
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    __m512 v = _mm512_maskz_loadu_ps(k, x + i);
+    if (residual != nullptr) {
+      v = _mm512_add_ps(v, _mm512_maskz_loadu_ps(k, residual + i));
+      _mm512_mask_storeu_ps(y + i, k, v);
+    }
+    sum = _mm512_add_ps(sum, v);
+  }
+  if (residual != nullptr) z = y;
+  const float mean_value = _mm512_reduce_add_ps(sum) / n;
+  const __m512 mean = _mm512_set1_ps(mean_value);
+
+  __m512 sum_of_squares = _mm512_setzero_ps();
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    const __m512 d =
+        _mm512_maskz_sub_ps(k, _mm512_maskz_loadu_ps(k, z + i), mean);
+    sum_of_squares = _mm512_fmadd_ps(d, d, sum_of_squares);
+  }
+  const float variance = _mm512_reduce_add_ps(sum_of_squares) / n;
+  const __m512 inv = _mm512_set1_ps(1.0f / std::sqrt(variance + epsilon));
+
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    const __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(k, z + i), mean);
+    const __m512 s = _mm512_mul_ps(inv, _mm512_maskz_loadu_ps(k, scale + i));
+    _mm512_mask_storeu_ps(
+        y + i, k, _mm512_fmadd_ps(d, s, _mm512_maskz_loadu_ps(k, offset + i)));
+  }
+}
+
+TF_TRANSFORMER_TARGET void GeluRowAvx512(const float* x, bool approximate,
+                                         int64_t n, float* y) {
+  const __m512 one = _mm512_set1_ps(1.0f);
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    const __m512 v = _mm512_maskz_loadu_ps(k, x + i);
+    __m512 result;
+    if (approximate) {
+      // 0.5 * (1 + tanh(u)) is sigmoid(2 * u).
+      const __m512 v3 = _mm512_mul_ps(_mm512_mul_ps(v, v), v);
+      const __m512 u = _mm512_mul_ps(
+          _mm512_set1_ps(kSqrtTwoOverPi),
+          _mm512_fmadd_ps(_mm512_set1_ps(kGeluCoefficient), v3, v));
+      const __m512 e =
+          Exp(_mm512_mul_ps(_mm512_set1_ps(-2.0f), u));
+      result = _mm512_div_ps(v, _mm512_add_ps(one, e));
+    } else {
+      result = _mm512_mul_ps(
+          _mm512_mul_ps(_mm512_set1_ps(0.5f), v),
+          OnePlusErf(_mm512_mul_ps(v, _mm512_set1_ps(kSqrtHalf))));
+    }
+    _mm512_mask_storeu_ps(y + i, k, result);
+  }
+}
+
+TF_TRANSFORMER_TARGET void SoftmaxRowAvx512(const float* x, const float* mask,
+                                            float scale, int64_t n, float* y) {
+  const __m512 scale_v = _mm512_set1_ps(scale);
+  __m512 max = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    __m512 v = _mm512_mul_ps(_mm512_maskz_loadu_ps(k, x + i), scale_v);
+    if (mask != nullptr) {
+      v = _mm512_add_ps(v, _mm512_maskz_loadu_ps(k, mask + i));
+    }
+    _mm512_mask_storeu_ps(y + i, k, v);
+    max = _mm512_mask_max_ps(max, k, max, v);
+  }
+  const __m512 row_max = _mm512_set1_ps(_mm512_reduce_max_ps(max));
+
+  __m512 sum = _mm512_setzero_ps();
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    const __m512 e =
+        Exp(_mm512_sub_ps(_mm512_maskz_loadu_ps(k, y + i), row_max));
+    _mm512_mask_storeu_ps(y + i, k, e);
+    sum = _mm512_mask_add_ps(sum, k, sum, e);
+  }
+  const __m512 inv_sum = _mm512_set1_ps(1.0f / _mm512_reduce_add_ps(sum));
+  for (int64_t i = 0; i < n; i += kLanes) {
+    const __mmask16 k = TailMask(std::min<int64_t>(kLanes, n - i));
+    _mm512_mask_storeu_ps(
+        y + i, k, _mm512_mul_ps(_mm512_maskz_loadu_ps(k, y + i), inv_sum));
+  }
+}
+
+#endif  // TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD
+
+using LayerNormRowFn = void (*)(const float*, const float*, const float*,
+                                const float*, float, int64_t, float*);
+using GeluRowFn = void (*)(const float*, bool, int64_t, float*);
+using SoftmaxRowFn = void (*)(const float*, const float*, float, int64_t,
+                              float*);
+
+LayerNormRowFn GetLayerNormRowFn() {
+#ifdef TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD
+  if (IsAvx512Supported()) return LayerNormRowAvx512;
+#endif
+  return LayerNormRow;
+}
+
+GeluRowFn GetGeluRowFn() {
+#ifdef TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD
+  if (IsAvx512Supported()) return GeluRowAvx512;
+#endif
+  return GeluRow;
+}
+
+SoftmaxRowFn GetSoftmaxRowFn() {
+#ifdef TENSORFLOW_USE_FUSED_TRANSFORMER_SIMD
+  if (IsAvx512Supported()) return SoftmaxRowAvx512;
+#endif
+  return SoftmaxRow;
+}
+
+}  // namespace
+
+class FusedLayerNormOp : public OpKernel {
+ public:
+  explicit FusedLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context), row_fn_(GetLayerNormRowFn()) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+    int num_residual;
+    OP_REQUIRES_OK(context, context->GetAttr("num_residual", &num_residual));
+    OP_REQUIRES(context, num_residual <= 1,
+                errors::InvalidArgument(
+                    "_FusedLayerNorm supports at most one residual, got ",
+                    num_residual));
+    has_residual_ = num_residual == 1;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& scale = context->input(1);
+    const Tensor& offset = context->input(2);
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must have rank at least 1, got ",
+                                        x.shape().DebugString()));
+    const int64_t depth = x.dim_size(x.dims() - 1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(scale.shape()) &&
+                    scale.NumElements() == depth,
+                errors::InvalidArgument("scale must be a vector of size ",
+                                        depth, ", got ",
+                                        scale.shape().DebugString()));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(offset.shape()) &&
+                    offset.NumElements() == depth,
+                errors::InvalidArgument("offset must be a vector of size ",
+                                        depth, ", got ",
+                                        offset.shape().DebugString()));
+    const float* residual = nullptr;
+    if (has_residual_) {
+      const Tensor& residual_tensor = context->input(3);
+      OP_REQUIRES(context, residual_tensor.shape() == x.shape(),
+                  errors::InvalidArgument(
+                      "residual must have the shape of x ",
+                      x.shape().DebugString(), ", got ",
+                      residual_tensor.shape().DebugString()));
+      residual = residual_tensor.flat<float>().data();
+    }
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (x.NumElements() == 0) return;
+
+    const float* x_data = x.flat<float>().data();
+    const float* scale_data = scale.flat<float>().data();
+    const float* offset_data = offset.flat<float>().data();
+    float* y_data = y->flat<float>().data();
+    const int64_t num_inputs = has_residual_ ? 2 : 1;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/(num_inputs + 2) * depth * sizeof(float),
+        /*bytes_stored=*/depth * sizeof(float),
+        /*compute_cycles=*/8 * depth);
+    const CPUDevice& device = context->eigen_cpu_device();
+    device.parallelFor(
+        x.NumElements() / depth, cost, [&](int64_t first, int64_t last) {
+          for (int64_t row = first; row < last; ++row) {
+            const int64_t offset = row * depth;
+            row_fn_(x_data + offset,
+                    residual == nullptr ? nullptr : residual + offset,
+                    scale_data, offset_data, epsilon_, depth,
+                    y_data + offset);
+          }
+        });
+  }
+
+ private:
+  const LayerNormRowFn row_fn_;
+  float epsilon_;
+  bool has_residual_;
+};
+
+class FusedGeluOp : public OpKernel {
+ public:
+  explicit FusedGeluOp(OpKernelConstruction* context)
+      : OpKernel(context), row_fn_(GetGeluRowFn()) {
+    OP_REQUIRES_OK(context, context->GetAttr("approximate", &approximate_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& features = context->input(0);
+    Tensor* activations = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->forward_input_or_allocate_output(
+                       {0}, 0, features.shape(), &activations));
+    const int64_t size = features.NumElements();
+    if (size == 0) return;
+
+    const float* x = features.flat<float>().data();
+    float* y = activations->flat<float>().data();
+    const int64_t block_size = std::min(size, kBlockSize);
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/block_size * sizeof(float),
+        /*bytes_stored=*/block_size * sizeof(float),
+        /*compute_cycles=*/20 * block_size);
+    const CPUDevice& device = context->eigen_cpu_device();
+    device.parallelFor(Eigen::divup(size, block_size), cost,
+                       [&](int64_t first_block, int64_t last_block) {
+                         const int64_t first = first_block * block_size;
+                         const int64_t last =
+                             std::min(size, last_block * block_size);
+                         row_fn_(x + first, approximate_, last - first,
+                                 y + first);
+                       });
+  }
+
+ private:
+  static constexpr int64_t kBlockSize = 4096;
+
+  const GeluRowFn row_fn_;
+  bool approximate_;
+};
+
+class FusedScaledMaskedSoftmaxOp : public OpKernel {
+ public:
+  explicit FusedScaledMaskedSoftmaxOp(OpKernelConstruction* context)
+      : OpKernel(context), row_fn_(GetSoftmaxRowFn()) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    int num_mask;
+    OP_REQUIRES_OK(context, context->GetAttr("num_mask", &num_mask));
+    OP_REQUIRES(context, num_mask <= 1,
+                errors::InvalidArgument(
+                    "_FusedScaledMaskedSoftmax supports at most one mask, got ",
+                    num_mask));
+    has_mask_ = num_mask == 1;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& logits = context->input(0);
+    OP_REQUIRES(context, logits.dims() >= 1,
+                errors::InvalidArgument(
+                    "logits must have rank at least 1, got ",
+                    logits.shape().DebugString()));
+    const int rank = logits.dims();
+    const int64_t depth = logits.dim_size(rank - 1);
+
+    // Strides of the mask for each dimension of the logits, which are 0 for
+    // the broadcast dimensions.
+    const float* mask = nullptr;
+    std::vector<int64_t> mask_strides(rank, 0);
+    if (has_mask_) {
+      const Tensor& mask_tensor = context->input(1);
+      OP_REQUIRES(context, mask_tensor.dims() <= rank,
+                  errors::InvalidArgument(
+                      "mask of shape ", mask_tensor.shape().DebugString(),
+                      " does not broadcast to the logits of shape ",
+                      logits.shape().DebugString()));
+      int64_t stride = 1;
+      for (int i = 1; i <= mask_tensor.dims(); ++i) {
+        const int64_t dim = mask_tensor.dim_size(mask_tensor.dims() - i);
+        OP_REQUIRES(context, dim == 1 || dim == logits.dim_size(rank - i),
+                    errors::InvalidArgument(
+                        "mask of shape ", mask_tensor.shape().DebugString(),
+                        " does not broadcast to the logits of shape ",
+                        logits.shape().DebugString()));
+        if (dim != 1) mask_strides[rank - i] = stride;
+        stride *= dim;
+      }
+      mask = mask_tensor.flat<float>().data();
+    }
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, logits.shape(), &output));
+    if (logits.NumElements() == 0) return;
+
+    const float* x = logits.flat<float>().data();
+    float* y = output->flat<float>().data();
+    // A mask that is broadcast along the last dimension is expanded into a
+    // row for each row of the logits.
+    const bool expand_mask = has_mask_ && mask_strides[rank - 1] == 0;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/(has_mask_ ? 2 : 1) * depth * sizeof(float),
+        /*bytes_stored=*/depth * sizeof(float),
+        /*compute_cycles=*/20 * depth);
+    const CPUDevice& device = context->eigen_cpu_device();
+    device.parallelFor(
+        logits.NumElements() / depth, cost, [&](int64_t first, int64_t last) {
+          std::vector<float> mask_row(expand_mask ? depth : 0);
+          for (int64_t row = first; row < last; ++row) {
+            const float* row_mask = nullptr;
+            if (has_mask_) {
+              int64_t mask_offset = 0;
+              int64_t index = row;
+              for (int i = rank - 2; i >= 0; --i) {
+                mask_offset += (index % logits.dim_size(i)) * mask_strides[i];
+                index /= logits.dim_size(i);
+              }
+              row_mask = mask + mask_offset;
+              if (expand_mask) {
+                std::fill(mask_row.begin(), mask_row.end(), *row_mask);
+                row_mask = mask_row.data();
+              }
+            }
+            row_fn_(x + row * depth, row_mask, scale_, depth, y + row * depth);
+          }
+        });
+  }
+
+ private:
+  const SoftmaxRowFn row_fn_;
+  float scale_;
+  bool has_mask_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedLayerNorm").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    FusedLayerNormOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedGelu").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    FusedGeluOp);
+REGISTER_KERNEL_BUILDER(Name("_FusedScaledMaskedSoftmax")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        FusedScaledMaskedSoftmaxOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,240 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns `n` values in [-4, 4) that cover several vector lanes.
+std::vector<float> Values(int n, int seed) {
+  std::vector<float> values(n);
+  for (int i = 0; i < n; ++i) {
+    values[i] = ((i * 7 + seed * 13) % 32) * 0.25f - 4.0f;
+  }
+  return values;
+}
+
+class FusedLayerNormOpTest : public OpsTestBase {
+ protected:
+  void Run(bool with_residual) {
+    const int rows = 3;
+    const int depth = 37;
+    TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(with_residual ? 1 : 0, DT_FLOAT))
+                     .Attr("epsilon", 1e-3f)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const std::vector<float> x = Values(rows * depth, 1);
+    const std::vector<float> residual = Values(rows * depth, 2);
+    const std::vector<float> scale = Values(depth, 3);
+    const std::vector<float> offset = Values(depth, 4);
+    AddInputFromArray<float>(TensorShape({rows, depth}), x);
+    AddInputFromArray<float>(TensorShape({depth}), scale);
+    AddInputFromArray<float>(TensorShape({depth}), offset);
+    if (with_residual) {
+      AddInputFromArray<float>(TensorShape({rows, depth}), residual);
+    }
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<float> expected_values(rows * depth);
+    for (int r = 0; r < rows; ++r) {
+      std::vector<double> z(depth);
+      double mean = 0;
+      for (int i = 0; i < depth; ++i) {
+        z[i] = x[r * depth + i] + (with_residual ? residual[r * depth + i] : 0);
+        mean += z[i] / depth;
+      }
+      double variance = 0;
+      for (int i = 0; i < depth; ++i) {
+        variance += (z[i] - mean) * (z[i] - mean) / depth;
+      }
+      for (int i = 0; i < depth; ++i) {
+        expected_values[r * depth + i] =
+            (z[i] - mean) / std::sqrt(variance + 1e-3) * scale[i] + offset[i];
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({rows, depth}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(FusedLayerNormOpTest, LayerNorm) { Run(/*with_residual=*/false); }
+
+TEST_F(FusedLayerNormOpTest, LayerNormWithResidual) {
+  Run(/*with_residual=*/true);
+}
+
+TEST_F(FusedLayerNormOpTest, InvalidScale) {
+  TF_ASSERT_OK(NodeDefBuilder("layer_norm", "_FusedLayerNorm")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(0, DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 2}), {1, 2, 3, 4});
+  AddInputFromArray<float>(TensorShape({3}), {1, 1, 1});
+  AddInputFromArray<float>(TensorShape({2}), {0, 0});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+class FusedGeluOpTest : public OpsTestBase {
+ protected:
+  void Run(bool approximate) {
+    TF_ASSERT_OK(NodeDefBuilder("gelu", "_FusedGelu")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("approximate", approximate)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    // Large enough to span several blocks.
+    const int size = 10000;
+    std::vector<float> x = Values(size, 5);
+    x[0] = -20.0f;
+    x[1] = 20.0f;
+    AddInputFromArray<float>(TensorShape({size}), x);
+    TF_ASSERT_OK(RunOpKernel());
+
+    std::vector<float> expected_values(size);
+    for (int i = 0; i < size; ++i) {
+      const double v = x[i];
+      expected_values[i] =
+          approximate
+              ? 0.5 * v *
+                    (1 + std::tanh(std::sqrt(2 / M_PI) *
+                                   (v + 0.044715 * v * v * v)))
+              : 0.5 * v * std::erfc(-v / std::sqrt(2.0));
+    }
+    Tensor expected(allocator(), DT_FLOAT, TensorShape({size}));
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+};
+
+TEST_F(FusedGeluOpTest, Exact) { Run(/*approximate=*/false); }
+
+TEST_F(FusedGeluOpTest, Approximate) { Run(/*approximate=*/true); }
+
+class FusedScaledMaskedSoftmaxOpTest : public OpsTestBase {
+ protected:
+  void Run(const TensorShape& logits_shape, const TensorShape* mask_shape) {
+    TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(mask_shape == nullptr ? 0 : 1, DT_FLOAT))
+                     .Attr("scale", 0.5f)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const int64_t size = logits_shape.num_elements();
+    const std::vector<float> logits = Values(size, 6);
+    AddInputFromArray<float>(logits_shape, logits);
+    std::vector<float> mask;
+    if (mask_shape != nullptr) {
+      mask = Values(mask_shape->num_elements(), 7);
+      // Mask out some of the logits.
+      for (int i = 0; i < mask.size(); i += 3) mask[i] = -1e9f;
+      AddInputFromArray<float>(*mask_shape, mask);
+    }
+    TF_ASSERT_OK(RunOpKernel());
+
+    // Index of the mask value for each logit, following the broadcasting
+    // rules.
+    const int rank = logits_shape.dims();
+    auto mask_index = [&](int64_t index) {
+      int64_t result = 0;
+      int64_t stride = 1;
+      for (int i = 1; i <= mask_shape->dims(); ++i) {
+        const int64_t dim = logits_shape.dim_size(rank - i);
+        const int64_t mask_dim = mask_shape->dim_size(mask_shape->dims() - i);
+        if (mask_dim != 1) result += (index % dim) * stride;
+        stride *= mask_dim;
+        index /= dim;
+      }
+      return result;
+    };
+    const int64_t depth = logits_shape.dim_size(rank - 1);
+    std::vector<float> expected_values(size);
+    for (int64_t row = 0; row < size / depth; ++row) {
+      std::vector<double> v(depth);
+      double max = -1e30;
+      for (int64_t i = 0; i < depth; ++i) {
+        const int64_t index = row * depth + i;
+        v[i] = logits[index] * 0.5 +
+               (mask_shape == nullptr ? 0 : mask[mask_index(index)]);
+        max = std::max(max, v[i]);
+      }
+      double sum = 0;
+      for (int64_t i = 0; i < depth; ++i) sum += std::exp(v[i] - max);
+      for (int64_t i = 0; i < depth; ++i) {
+        expected_values[row * depth + i] = std::exp(v[i] - max) / sum;
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT, logits_shape);
+    test::FillValues<float>(&expected, expected_values);
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-6);
+  }
+};
+
+TEST_F(FusedScaledMaskedSoftmaxOpTest, NoMask) {
+  Run(TensorShape({4, 19}), nullptr);
+}
+
+TEST_F(FusedScaledMaskedSoftmaxOpTest, AttentionMask) {
+  // [batch, heads, queries, keys] logits with a [batch, 1, 1, keys] mask.
+  const TensorShape mask_shape({2, 1, 1, 33});
+  Run(TensorShape({2, 3, 5, 33}), &mask_shape);
+}
+
+TEST_F(FusedScaledMaskedSoftmaxOpTest, MaskBroadcastAlongLastDimension) {
+  const TensorShape mask_shape({3, 1});
+  Run(TensorShape({3, 17}), &mask_shape);
+}
+
+TEST_F(FusedScaledMaskedSoftmaxOpTest, LowerRankMask) {
+  const TensorShape mask_shape({7, 20});
+  Run(TensorShape({2, 7, 20}), &mask_shape);
+}
+
+TEST_F(FusedScaledMaskedSoftmaxOpTest, InvalidMask) {
+  TF_ASSERT_OK(NodeDefBuilder("softmax", "_FusedScaledMaskedSoftmax")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(1, DT_FLOAT))
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<float>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<float>(TensorShape({2, 2}), {0, 0, 0, 0});
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
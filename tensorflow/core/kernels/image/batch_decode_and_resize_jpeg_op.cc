@@ -0,0 +1,299 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns the largest libjpeg scaling denominator that keeps the scaled crop
+// window at least as large as the output, so that decoding only discards
+// resolution that the resize would discard anyway.
+int ChooseRatio(int64_t crop_height, int64_t crop_width, int64_t out_height,
+                int64_t out_width) {
+  for (int ratio : {8, 4, 2}) {
+    if (crop_height / ratio >= out_height && crop_width / ratio >= out_width) {
+      return ratio;
+    }
+  }
+  return 1;
+}
+
+struct CachedInterpolation {
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+// Computes the weights to resize the interval [offset, offset + extent) of an
+// input dimension of `in_size` pixels to `out_size` pixels, with half-pixel
+// centers as in ResizeBilinear.
+void ComputeInterpolationWeights(int64_t out_size, int64_t in_size,
+                                 float offset, float extent,
+                                 std::vector<CachedInterpolation>* weights) {
+  weights->resize(out_size);
+  const float scale = extent / out_size;
+  for (int64_t i = 0; i < out_size; ++i) {
+    const float in = std::max(offset + (i + 0.5f) * scale - 0.5f, 0.0f);
+    const float in_f = std::floor(in);
+    CachedInterpolation& w = (*weights)[i];
+    w.lower = std::min(static_cast<int64_t>(in_f), in_size - 1);
+    w.upper = std::min(static_cast<int64_t>(std::ceil(in)), in_size - 1);
+    w.lerp = in - in_f;
+  }
+}
+
+void ResizeImageBilinear(const uint8* input, int64_t in_width, int channels,
+                         const std::vector<CachedInterpolation>& ys,
+                         const std::vector<CachedInterpolation>& xs,
+                         uint8* output) {
+  const int64_t in_row_size = in_width * channels;
+  for (const CachedInterpolation& y : ys) {
+    const uint8* top = input + y.lower * in_row_size;
+    const uint8* bottom = input + y.upper * in_row_size;
+    for (const CachedInterpolation& x : xs) {
+      const int64_t left = x.lower * channels;
+      const int64_t right = x.upper * channels;
+      for (int c = 0; c < channels; ++c) {
+        const float top_value =
+            top[left + c] + (top[right + c] - top[left + c]) * x.lerp;
+        const float bottom_value =
+            bottom[left + c] + (bottom[right + c] - bottom[left + c]) * x.lerp;
+        *output++ = static_cast<uint8>(
+            top_value + (bottom_value - top_value) * y.lerp + 0.5f);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Decodes a batch of JPEG images, optionally cropped, and resizes them to a
+// common size. Each image is downscaled by libjpeg in the DCT domain as much
+// as possible while decoding only the rows and MCU columns of its crop
+// window, and the remaining bilinear resize writes straight into the batched
+// output.
+class BatchDecodeAndResizeJpegOp : public OpKernel {
+ public:
+  explicit BatchDecodeAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 1 or 3, got ",
+                                        channels_));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    // The TensorFlow-chosen default for JPEG decoding is IFAST, sacrificing
+    // image quality for speed.
+    flags_.dct_method =
+        dct_method == "INTEGER_ACCURATE" ? JDCT_ISLOW : JDCT_IFAST;
+    flags_.components = channels_;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    const Tensor& size = context->input(1);
+    const Tensor& crop_windows = context->input(2);
+    OP_REQUIRES(context, TensorShapeUtils::IsVector(contents.shape()),
+                errors::InvalidArgument("contents must be 1-D, got shape ",
+                                        contents.shape().DebugString()));
+    const int64_t batch_size = contents.dim_size(0);
+    OP_REQUIRES(context, size.shape() == TensorShape({2}),
+                errors::InvalidArgument(
+                    "size must be 1-D with two elements, got shape ",
+                    size.shape().DebugString()));
+    OP_REQUIRES(context,
+                crop_windows.dims() == 2 &&
+                    crop_windows.dim_size(0) == batch_size &&
+                    crop_windows.dim_size(1) == 4,
+                errors::InvalidArgument("crop_windows must have shape [",
+                                        batch_size, ", 4], got shape ",
+                                        crop_windows.shape().DebugString()));
+    const int64_t out_height = size.vec<int32>()(0);
+    const int64_t out_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, out_height > 0 && out_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        out_height, ", ", out_width, "]"));
+
+    TensorShape output_shape;
+    OP_REQUIRES_OK(context,
+                   TensorShape::BuildTensorShape(
+                       {batch_size, out_height, out_width, channels_},
+                       &output_shape));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (batch_size == 0) return;
+
+    auto contents_vec = contents.vec<tstring>();
+    auto windows = crop_windows.matrix<int32>();
+    uint8* output_data = output->flat<uint8>().data();
+    const int64_t image_size = out_height * out_width * channels_;
+
+    // If several images fail to decode, report the error of the first one.
+    mutex mu;
+    int64_t first_error_image = batch_size;
+    Status first_error;
+    auto decode_images = [&](int64_t begin, int64_t end) {
+      std::vector<uint8> scratch;
+      for (int64_t i = begin; i < end; ++i) {
+        Status s = DecodeImage(contents_vec(i), windows(i, 0), windows(i, 1),
+                               windows(i, 2), windows(i, 3), out_height,
+                               out_width, output_data + i * image_size,
+                               &scratch);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < first_error_image) {
+            first_error_image = i;
+            first_error = errors::InvalidArgument("Image ", i, ": ",
+                                                  s.error_message());
+          }
+          return;
+        }
+      }
+    };
+
+    int64_t total_bytes = 0;
+    for (int64_t i = 0; i < batch_size; ++i) {
+      total_bytes += contents_vec(i).size();
+    }
+    const int64_t cost_per_image =
+        kCostPerCompressedByte * (total_bytes / batch_size) +
+        kCostPerOutputByte * image_size;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_image, decode_images);
+    OP_REQUIRES_OK(context, first_error);
+  }
+
+ private:
+  // Approximate cost in cycles of decoding one byte of JPEG data and of
+  // writing one byte of the resized output, used to shard the batch.
+  static constexpr int64_t kCostPerCompressedByte = 200;
+  static constexpr int64_t kCostPerOutputByte = 20;
+
+  // Decodes the crop window [crop_y, crop_x, crop_height, crop_width] of
+  // `input`, or the whole image if the window is empty, and resizes it to
+  // `out_height` x `out_width` into `output`. `scratch` holds the decoded
+  // image until it is resized.
+  Status DecodeImage(StringPiece input, int64_t crop_y, int64_t crop_x,
+                     int64_t crop_height, int64_t crop_width,
+                     int64_t out_height, int64_t out_width, uint8* output,
+                     std::vector<uint8>* scratch) const {
+    int height, width;
+    if (!jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                            nullptr)) {
+      return errors::InvalidArgument("Invalid JPEG data, size ", input.size());
+    }
+    if (crop_height == 0 || crop_width == 0) {
+      crop_y = 0;
+      crop_x = 0;
+      crop_height = height;
+      crop_width = width;
+    }
+    if (crop_y < 0 || crop_x < 0 || crop_height < 0 || crop_width < 0 ||
+        crop_y + crop_height > height || crop_x + crop_width > width) {
+      return errors::InvalidArgument(
+          "Crop window [", crop_y, ", ", crop_x, ", ", crop_height, ", ",
+          crop_width, "] is out of bounds for an image of size ", height, "x",
+          width);
+    }
+
+    // Scale the crop window to the MCU-scaled image and round it outwards, so
+    // that it covers the requested window.
+    jpeg::UncompressFlags flags = flags_;
+    flags.ratio = ChooseRatio(crop_height, crop_width, out_height, out_width);
+    const int64_t ratio = flags.ratio;
+    const int64_t scaled_height = (height + ratio - 1) / ratio;
+    const int64_t scaled_width = (width + ratio - 1) / ratio;
+    const int64_t y0 = crop_y / ratio;
+    const int64_t x0 = crop_x / ratio;
+    const int64_t y1 =
+        std::min((crop_y + crop_height + ratio - 1) / ratio, scaled_height);
+    const int64_t x1 =
+        std::min((crop_x + crop_width + ratio - 1) / ratio, scaled_width);
+    if (y0 != 0 || x0 != 0 || y1 != scaled_height || x1 != scaled_width) {
+      flags.crop = true;
+      flags.crop_y = y0;
+      flags.crop_x = x0;
+      flags.crop_height = y1 - y0;
+      flags.crop_width = x1 - x0;
+    }
+
+    // If the scaled window is exactly the output size there is nothing to
+    // resize, so decode directly into the output.
+    const bool decode_to_output =
+        crop_height == out_height * ratio && crop_width == out_width * ratio &&
+        crop_y % ratio == 0 && crop_x % ratio == 0;
+    int decoded_height = 0;
+    int decoded_width = 0;
+    const uint8* decoded = jpeg::Uncompress(
+        input.data(), input.size(), flags, nullptr /* nwarn */,
+        [&](int width, int height, int components) -> uint8* {
+          if (components != channels_) return nullptr;
+          decoded_height = height;
+          decoded_width = width;
+          if (decode_to_output) {
+            return width == out_width && height == out_height ? output
+                                                              : nullptr;
+          }
+          scratch->resize(static_cast<int64_t>(height) * width * components);
+          return scratch->data();
+        });
+    if (decoded == nullptr) {
+      return errors::InvalidArgument(
+          "jpeg::Uncompress failed. Invalid JPEG data or crop window.");
+    }
+    if (decode_to_output) return OkStatus();
+
+    std::vector<CachedInterpolation> ys, xs;
+    ComputeInterpolationWeights(out_height, decoded_height,
+                                static_cast<float>(crop_y) / ratio - y0,
+                                static_cast<float>(crop_height) / ratio, &ys);
+    ComputeInterpolationWeights(out_width, decoded_width,
+                                static_cast<float>(crop_x) / ratio - x0,
+                                static_cast<float>(crop_width) / ratio, &xs);
+    ResizeImageBilinear(decoded, decoded_width, channels_, ys, xs, output);
+    return OkStatus();
+  }
+
+  int channels_;
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("BatchDecodeAndResizeJpeg").Device(DEVICE_CPU),
+                        BatchDecodeAndResizeJpegOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,156 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Encodes an RGB image whose red channel increases from 0 to 255 from left to
+// right and whose green channel increases from top to bottom.
+tstring MakeGradientJpeg(int height, int width) {
+  std::vector<uint8> image(height * width * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8* pixel = &image[(y * width + x) * 3];
+      pixel[0] = x * 255 / (width - 1);
+      pixel[1] = y * 255 / (height - 1);
+      pixel[2] = 128;
+    }
+  }
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  return jpeg::Compress(image.data(), width, height, flags);
+}
+
+class BatchDecodeAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  struct Window {
+    int y, x, height, width;
+  };
+
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("decode", "BatchDecodeAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("dct_method", "INTEGER_ACCURATE")
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  void AddInputs(const std::vector<tstring>& images, int out_height,
+                 int out_width, const std::vector<int32>& crop_windows) {
+    const int batch_size = images.size();
+    AddInputFromArray<tstring>(TensorShape({batch_size}), images);
+    AddInputFromArray<int32>(TensorShape({2}), {out_height, out_width});
+    AddInputFromArray<int32>(TensorShape({batch_size, 4}), crop_windows);
+  }
+
+  // Maximum difference due to compression artifacts.
+  static constexpr float kTolerance = 6;
+
+  // Checks that image `i` of the output matches the resize of the crop
+  // window `window` of a gradient image of size `height` x `width`.
+  void CheckGradient(int i, int height, int width, const Window& window) {
+    const Tensor& output = *GetOutput(0);
+    const int out_height = output.dim_size(1);
+    const int out_width = output.dim_size(2);
+    auto images = output.tensor<uint8, 4>();
+    for (int y = 0; y < out_height; ++y) {
+      for (int x = 0; x < out_width; ++x) {
+        const float in_y = std::clamp<float>(
+            window.y + (y + 0.5f) * window.height / out_height - 0.5f, 0,
+            height - 1);
+        const float in_x = std::clamp<float>(
+            window.x + (x + 0.5f) * window.width / out_width - 0.5f, 0,
+            width - 1);
+        EXPECT_NEAR(images(i, y, x, 0), in_x * 255 / (width - 1), kTolerance)
+            << "image " << i << " at " << y << ", " << x;
+        EXPECT_NEAR(images(i, y, x, 1), in_y * 255 / (height - 1),
+                    kTolerance)
+            << "image " << i << " at " << y << ", " << x;
+        EXPECT_NEAR(images(i, y, x, 2), 128, kTolerance);
+      }
+    }
+  }
+};
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, WholeImages) {
+  MakeOp();
+  // The first image is scaled by exactly 1/4 during decoding, the second
+  // one is scaled by 1/4 and then resized, and the third one is scaled by 1/2
+  // and then resized.
+  AddInputs({MakeGradientJpeg(192, 256), MakeGradientJpeg(200, 300),
+             MakeGradientJpeg(97, 131)},
+            48, 64, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  EXPECT_EQ(GetOutput(0)->shape(), TensorShape({3, 48, 64, 3}));
+  CheckGradient(0, 192, 256, {0, 0, 192, 256});
+  CheckGradient(1, 200, 300, {0, 0, 200, 300});
+  CheckGradient(2, 97, 131, {0, 0, 97, 131});
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, CropWindows) {
+  MakeOp();
+  const tstring image = MakeGradientJpeg(256, 256);
+  // The first window is aligned to the 1/8 scaling, the second one is not.
+  AddInputs({image, image}, 20, 16, {40, 24, 160, 128, 37, 21, 150, 120});
+  TF_ASSERT_OK(RunOpKernel());
+
+  CheckGradient(0, 256, 256, {40, 24, 160, 128});
+  CheckGradient(1, 256, 256, {37, 21, 150, 120});
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, Upscale) {
+  MakeOp();
+  AddInputs({MakeGradientJpeg(64, 64)}, 100, 90, {0, 0, 0, 0});
+  TF_ASSERT_OK(RunOpKernel());
+
+  CheckGradient(0, 64, 64, {0, 0, 64, 64});
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, InvalidImage) {
+  MakeOp();
+  AddInputs({MakeGradientJpeg(30, 40), "not a jpeg"}, 10, 10,
+            {0, 0, 0, 0, 0, 0, 0, 0});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(absl::StartsWith(s.error_message(), "Image 1: ")) << s;
+}
+
+TEST_F(BatchDecodeAndResizeJpegOpTest, CropWindowOutOfBounds) {
+  MakeOp();
+  AddInputs({MakeGradientJpeg(30, 40)}, 10, 10, {20, 0, 20, 40});
+  Status s = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(absl::StrContains(s.error_message(), "out of bounds")) << s;
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -83,6 +83,49 @@ static inline Status ParseAndCheckBoxSizes(const Tensor& boxes,
   return OkStatus();
 }
 
+// Validates the inputs of CropAndResize and _FusedCropAndResize, and computes
+// the shape of the crops.
+static inline Status ParseAndCheckCropAndResizeInputs(
+    const Tensor& image, const Tensor& boxes, const Tensor& box_index,
+    const Tensor& crop_size, TensorShape* crops_shape) {
+  // Validate inputs dimensions.
+  if (image.dims() != 4) {
+    return errors::InvalidArgument("input image must be 4-D",
+                                   image.shape().DebugString());
+  }
+  const int image_height = image.dim_size(1);
+  const int image_width = image.dim_size(2);
+  const int depth = image.dim_size(3);
+  if (image_height <= 0 || image_width <= 0) {
+    return errors::InvalidArgument("image dimensions must be positive");
+  }
+  int num_boxes = 0;
+  TF_RETURN_IF_ERROR(ParseAndCheckBoxSizes(boxes, box_index, &num_boxes));
+
+  if (crop_size.dims() != 1) {
+    return errors::InvalidArgument("crop_size must be 1-D",
+                                   crop_size.shape().DebugString());
+  }
+  if (crop_size.dim_size(0) != 2) {
+    return errors::InvalidArgument("crop_size must have two elements",
+                                   crop_size.shape().DebugString());
+  }
+
+  // Copy and validate crop sizes.
+  auto crop_size_vec = crop_size.vec<int32>();
+  const int crop_height = internal::SubtleMustCopy(crop_size_vec(0));
+  const int crop_width = internal::SubtleMustCopy(crop_size_vec(1));
+  if (crop_height <= 0 || crop_width <= 0) {
+    return errors::InvalidArgument("crop dimensions must be positive");
+  }
+
+  crops_shape->Clear();
+  TF_RETURN_IF_ERROR(crops_shape->AddDimWithStatus(num_boxes));
+  TF_RETURN_IF_ERROR(crops_shape->AddDimWithStatus(crop_height));
+  TF_RETURN_IF_ERROR(crops_shape->AddDimWithStatus(crop_width));
+  return crops_shape->AddDimWithStatus(depth);
+}
+
 // Conditionally calls the compute callback if all values in box_index are in
 // [0, batch_size) then calls done.
 template <typename Device>
@@ -136,45 +179,12 @@ class CropAndResizeOp : public AsyncOpKernel {
     // The shape of 'crop_size' is [2].
     const Tensor& crop_size = context->input(3);
 
-    // Validate inputs dimensions.
-    OP_REQUIRES_ASYNC(context, image.dims() == 4,
-                      errors::InvalidArgument("input image must be 4-D",
-                                              image.shape().DebugString()),
-                      done);
-    const int batch_size = image.dim_size(0);
-    const int image_height = image.dim_size(1);
-    const int image_width = image.dim_size(2);
-    const int depth = image.dim_size(3);
-    OP_REQUIRES_ASYNC(
-        context, image_height > 0 && image_width > 0,
-        errors::InvalidArgument("image dimensions must be positive"), done);
-    int num_boxes = 0;
-    OP_REQUIRES_OK_ASYNC(
-        context, ParseAndCheckBoxSizes(boxes, box_index, &num_boxes), done);
-
-    OP_REQUIRES_ASYNC(context, crop_size.dims() == 1,
-                      errors::InvalidArgument("crop_size must be 1-D",
-                                              crop_size.shape().DebugString()),
-                      done);
-    OP_REQUIRES_ASYNC(
-        context, crop_size.dim_size(0) == 2,
-        errors::InvalidArgument("crop_size must have two elements",
-                                crop_size.shape().DebugString()),
-        done);
-
-    // Copy and validate crop sizes.
-    auto crop_size_vec = crop_size.vec<int32>();
-    const int crop_height = internal::SubtleMustCopy(crop_size_vec(0));
-    const int crop_width = internal::SubtleMustCopy(crop_size_vec(1));
-    OP_REQUIRES_ASYNC(
-        context, crop_height > 0 && crop_width > 0,
-        errors::InvalidArgument("crop dimensions must be positive"), done);
-
     TensorShape shape;
-    OP_REQUIRES_OK_ASYNC(context, shape.AddDimWithStatus(num_boxes), done);
-    OP_REQUIRES_OK_ASYNC(context, shape.AddDimWithStatus(crop_height), done);
-    OP_REQUIRES_OK_ASYNC(context, shape.AddDimWithStatus(crop_width), done);
-    OP_REQUIRES_OK_ASYNC(context, shape.AddDimWithStatus(depth), done);
+    OP_REQUIRES_OK_ASYNC(context,
+                         ParseAndCheckCropAndResizeInputs(
+                             image, boxes, box_index, crop_size, &shape),
+                         done);
+    const int batch_size = image.dim_size(0);
     // Allocate output tensor.
     Tensor* output = nullptr;
     OP_REQUIRES_OK_ASYNC(context, context->allocate_output(0, shape, &output),
@@ -205,146 +215,285 @@ class CropAndResizeOp : public AsyncOpKernel {
   string method_;
 };
 
-// Partial specialization of CropAndResize functor for a CPUDevice.
-namespace functor {
-template <typename T>
-struct CropAndResize<CPUDevice, T> {
-  bool operator()(OpKernelContext* context,
-                  typename TTypes<T, 4>::ConstTensor image,
-                  typename TTypes<float, 2>::ConstTensor boxes,
-                  typename TTypes<int32, 1>::ConstTensor box_index,
-                  const string& method_name, float extrapolation_value,
-                  typename TTypes<float, 4>::Tensor crops) {
-    const int batch_size = image.dimension(0);
-    const int image_height = image.dimension(1);
-    const int image_width = image.dimension(2);
+// Computes (CropAndResize(image) - mean) * scale, or / scale if
+// `divide_by_scale`, cast to `OutT`, in a single pass over the crops. This is
+// created by the grappler remapper from the preprocessing pattern that follows
+// a CropAndResize, so that the float crops are never materialized.
+template <typename Device, typename T, typename OutT>
+class FusedCropAndResizeOp : public AsyncOpKernel {
+ public:
+  explicit FusedCropAndResizeOp(OpKernelConstruction* context)
+      : AsyncOpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("method", &method_));
+    OP_REQUIRES(context, method_ == "bilinear" || method_ == "nearest",
+                errors::InvalidArgument(
+                    "method must be 'bilinear' or 'nearest'", method_));
+    OP_REQUIRES_OK(context, context->GetAttr("extrapolation_value",
+                                             &extrapolation_value_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("divide_by_scale", &divide_by_scale_));
+  }
 
-    const int num_boxes = crops.dimension(0);
-    const int crop_height = crops.dimension(1);
-    const int crop_width = crops.dimension(2);
-    const int depth = crops.dimension(3);
-
-    // Since `functor::CropAndResize` operates on float, we first validate
-    // that we don't overflow (since overflow causes undefined behavior which
-    // could result in segfault in this scenario).
-    const Eigen::Tensor<bool, 0, Eigen::RowMajor> only_finite_elements =
-        boxes.isfinite().all();
-    if (!only_finite_elements()) {
-      context->SetStatus(errors::InvalidArgument(
-          "Boxes contains at least one element that is not finite"));
-      return false;
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& image = context->input(0);
+    const Tensor& boxes = context->input(1);
+    const Tensor& box_index = context->input(2);
+    const Tensor& crop_size = context->input(3);
+    // 'mean' and 'scale' have either one element, or one element per channel.
+    const Tensor& mean = context->input(4);
+    const Tensor& scale = context->input(5);
+
+    TensorShape shape;
+    OP_REQUIRES_OK_ASYNC(context,
+                         ParseAndCheckCropAndResizeInputs(
+                             image, boxes, box_index, crop_size, &shape),
+                         done);
+    const int batch_size = image.dim_size(0);
+    const int depth = image.dim_size(3);
+    for (const Tensor* t : {&mean, &scale}) {
+      OP_REQUIRES_ASYNC(
+          context, t->NumElements() == 1 || t->NumElements() == depth,
+          errors::InvalidArgument(
+              "mean and scale must have 1 or ", depth,
+              " elements, got shape ", t->shape().DebugString()),
+          done);
     }
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK_ASYNC(context, context->allocate_output(0, shape, &output),
+                         done);
 
-    // Sharding across boxes.
-    auto CropAndResizePerBox = [&](int64_t start_box, int64_t limit_box) {
-      for (int b = start_box; b < limit_box; ++b) {
-        const float y1 = boxes(b, 0);
-        const float x1 = boxes(b, 1);
-        const float y2 = boxes(b, 2);
-        const float x2 = boxes(b, 3);
+    auto compute_callback = [this, context, output]() {
+      const Tensor& image = context->input(0);
+      const Tensor& boxes = context->input(1);
+      const Tensor& box_index = context->input(2);
+      const Tensor& mean = context->input(4);
+      const Tensor& scale = context->input(5);
+      functor::CropAndResizeNormalization normalization;
+      normalization.mean = mean.flat<float>().data();
+      normalization.scale = scale.flat<float>().data();
+      normalization.mean_stride = mean.NumElements() == 1 ? 0 : 1;
+      normalization.scale_stride = scale.NumElements() == 1 ? 0 : 1;
+      normalization.divide = divide_by_scale_;
+      const bool status = functor::FusedCropAndResize<Device, T, OutT>()(
+          context, image.tensor<T, 4>(), boxes.tensor<float, 2>(),
+          box_index.tensor<int32, 1>(), method_, extrapolation_value_,
+          normalization, output->tensor<OutT, 4>());
+      if (!status) {
+        context->SetStatus(
+            errors::Internal("Failed to launch FusedCropAndResizeKernel."));
+      }
+    };
 
-        const int32_t b_in = box_index(b);
-        if (!FastBoundsCheck(b_in, batch_size)) {
-          continue;
-        }
+    RunIfBoxIndexIsValid<Device>(context, box_index.tensor<int32, 1>(),
+                                 batch_size, std::move(compute_callback),
+                                 std::move(done));
+  }
 
-        const float height_scale =
-            (crop_height > 1)
-                ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
-                : 0;
-        const float width_scale =
-            (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
-                             : 0;
+ private:
+  float extrapolation_value_;
+  string method_;
+  bool divide_by_scale_;
+};
 
-        for (int y = 0; y < crop_height; ++y) {
-          const float in_y = (crop_height > 1)
-                                 ? y1 * (image_height - 1) + y * height_scale
-                                 : 0.5 * (y1 + y2) * (image_height - 1);
-          if (in_y < 0 || in_y > image_height - 1) {
-            for (int x = 0; x < crop_width; ++x) {
-              for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = extrapolation_value;
-              }
+namespace functor {
+namespace {
+
+// Crops and resizes `image` on the CPU, and passes each interpolated (or
+// extrapolated) value to `store(b, y, x, d, value)`, so that the resized crops
+// can be transformed before being written to the output.
+template <typename T, typename StoreFn>
+bool CropAndResizeCPU(OpKernelContext* context,
+                      typename TTypes<T, 4>::ConstTensor image,
+                      typename TTypes<float, 2>::ConstTensor boxes,
+                      typename TTypes<int32, 1>::ConstTensor box_index,
+                      const string& method_name, float extrapolation_value,
+                      int num_boxes, int crop_height, int crop_width,
+                      int depth, double store_cost, const StoreFn& store) {
+  const int batch_size = image.dimension(0);
+  const int image_height = image.dimension(1);
+  const int image_width = image.dimension(2);
+
+  // Since `functor::CropAndResize` operates on float, we first validate
+  // that we don't overflow (since overflow causes undefined behavior which
+  // could result in segfault in this scenario).
+  const Eigen::Tensor<bool, 0, Eigen::RowMajor> only_finite_elements =
+      boxes.isfinite().all();
+  if (!only_finite_elements()) {
+    context->SetStatus(errors::InvalidArgument(
+        "Boxes contains at least one element that is not finite"));
+    return false;
+  }
+
+  // Sharding across boxes.
+  auto CropAndResizePerBox = [&](int64_t start_box, int64_t limit_box) {
+    for (int b = start_box; b < limit_box; ++b) {
+      const float y1 = boxes(b, 0);
+      const float x1 = boxes(b, 1);
+      const float y2 = boxes(b, 2);
+      const float x2 = boxes(b, 3);
+
+      const int32_t b_in = box_index(b);
+      if (!FastBoundsCheck(b_in, batch_size)) {
+        continue;
+      }
+
+      const float height_scale =
+          (crop_height > 1)
+              ? (y2 - y1) * (image_height - 1) / (crop_height - 1)
+              : 0;
+      const float width_scale =
+          (crop_width > 1) ? (x2 - x1) * (image_width - 1) / (crop_width - 1)
+                           : 0;
+
+      for (int y = 0; y < crop_height; ++y) {
+        const float in_y = (crop_height > 1)
+                               ? y1 * (image_height - 1) + y * height_scale
+                               : 0.5 * (y1 + y2) * (image_height - 1);
+        if (in_y < 0 || in_y > image_height - 1) {
+          for (int x = 0; x < crop_width; ++x) {
+            for (int d = 0; d < depth; ++d) {
+              store(b, y, x, d, extrapolation_value);
             }
-            continue;
           }
-          if (method_name == "bilinear") {
-            const int top_y_index = floorf(in_y);
-            const int bottom_y_index = ceilf(in_y);
-            const float y_lerp = in_y - top_y_index;
-
-            for (int x = 0; x < crop_width; ++x) {
-              const float in_x = (crop_width > 1)
-                                     ? x1 * (image_width - 1) + x * width_scale
-                                     : 0.5 * (x1 + x2) * (image_width - 1);
-              if (in_x < 0 || in_x > image_width - 1) {
-                for (int d = 0; d < depth; ++d) {
-                  crops(b, y, x, d) = extrapolation_value;
-                }
-                continue;
-              }
-              const int left_x_index = floorf(in_x);
-              const int right_x_index = ceilf(in_x);
-              const float x_lerp = in_x - left_x_index;
+          continue;
+        }
+        if (method_name == "bilinear") {
+          const int top_y_index = floorf(in_y);
+          const int bottom_y_index = ceilf(in_y);
+          const float y_lerp = in_y - top_y_index;
 
+          for (int x = 0; x < crop_width; ++x) {
+            const float in_x = (crop_width > 1)
+                                   ? x1 * (image_width - 1) + x * width_scale
+                                   : 0.5 * (x1 + x2) * (image_width - 1);
+            if (in_x < 0 || in_x > image_width - 1) {
               for (int d = 0; d < depth; ++d) {
-                const float top_left(static_cast<float>(
-                    image(b_in, top_y_index, left_x_index, d)));
-                const float top_right(static_cast<float>(
-                    image(b_in, top_y_index, right_x_index, d)));
-                const float bottom_left(static_cast<float>(
-                    image(b_in, bottom_y_index, left_x_index, d)));
-                const float bottom_right(static_cast<float>(
-                    image(b_in, bottom_y_index, right_x_index, d)));
-                const float top = top_left + (top_right - top_left) * x_lerp;
-                const float bottom =
-                    bottom_left + (bottom_right - bottom_left) * x_lerp;
-                crops(b, y, x, d) = top + (bottom - top) * y_lerp;
+                store(b, y, x, d, extrapolation_value);
               }
+              continue;
             }
-          } else {  // method == "nearest"
-            for (int x = 0; x < crop_width; ++x) {
-              const float in_x = (crop_width > 1)
-                                     ? x1 * (image_width - 1) + x * width_scale
-                                     : 0.5 * (x1 + x2) * (image_width - 1);
-              if (in_x < 0 || in_x > image_width - 1) {
-                for (int d = 0; d < depth; ++d) {
-                  crops(b, y, x, d) = extrapolation_value;
-                }
-                continue;
-              }
-              const int closest_x_index = roundf(in_x);
-              const int closest_y_index = roundf(in_y);
+            const int left_x_index = floorf(in_x);
+            const int right_x_index = ceilf(in_x);
+            const float x_lerp = in_x - left_x_index;
+
+            for (int d = 0; d < depth; ++d) {
+              const float top_left(static_cast<float>(
+                  image(b_in, top_y_index, left_x_index, d)));
+              const float top_right(static_cast<float>(
+                  image(b_in, top_y_index, right_x_index, d)));
+              const float bottom_left(static_cast<float>(
+                  image(b_in, bottom_y_index, left_x_index, d)));
+              const float bottom_right(static_cast<float>(
+                  image(b_in, bottom_y_index, right_x_index, d)));
+              const float top = top_left + (top_right - top_left) * x_lerp;
+              const float bottom =
+                  bottom_left + (bottom_right - bottom_left) * x_lerp;
+              store(b, y, x, d, top + (bottom - top) * y_lerp);
+            }
+          }
+        } else {  // method == "nearest"
+          for (int x = 0; x < crop_width; ++x) {
+            const float in_x = (crop_width > 1)
+                                   ? x1 * (image_width - 1) + x * width_scale
+                                   : 0.5 * (x1 + x2) * (image_width - 1);
+            if (in_x < 0 || in_x > image_width - 1) {
               for (int d = 0; d < depth; ++d) {
-                crops(b, y, x, d) = static_cast<float>(
-                    image(b_in, closest_y_index, closest_x_index, d));
+                store(b, y, x, d, extrapolation_value);
               }
+              continue;
+            }
+            const int closest_x_index = roundf(in_x);
+            const int closest_y_index = roundf(in_y);
+            for (int d = 0; d < depth; ++d) {
+              store(b, y, x, d,
+                    static_cast<float>(
+                        image(b_in, closest_y_index, closest_x_index, d)));
             }
           }
         }
       }
-    };
-
-    // A rough estimation of the cost for each cropped box.
-    double cost_per_pixel =
-        depth * (Eigen::TensorOpCost::AddCost<float>() * 6 +
-                 Eigen::TensorOpCost::MulCost<float>() * 3 +
-                 Eigen::TensorOpCost::CastCost<T, float>() * 4) +
-        (Eigen::TensorOpCost::AddCost<float>() * 2 +
-         Eigen::TensorOpCost::AddCost<float>() * 3);
-    if (method_name == "nearest") {
-      cost_per_pixel = depth * Eigen::TensorOpCost::CastCost<T, float>() +
-                       Eigen::TensorOpCost::AddCost<float>() * 4 +
-                       Eigen::TensorOpCost::MulCost<float>() * 4;
     }
-    const double cost_per_box = crop_height * crop_width * cost_per_pixel;
+  };
 
-    const DeviceBase::CpuWorkerThreads& worker_threads =
-        *(context->device()->tensorflow_cpu_worker_threads());
-    Shard(worker_threads.num_threads, worker_threads.workers, num_boxes,
-          cost_per_box, CropAndResizePerBox);
+  // A rough estimation of the cost for each cropped box.
+  double cost_per_pixel =
+      depth * (Eigen::TensorOpCost::AddCost<float>() * 6 +
+               Eigen::TensorOpCost::MulCost<float>() * 3 +
+               Eigen::TensorOpCost::CastCost<T, float>() * 4) +
+      (Eigen::TensorOpCost::AddCost<float>() * 2 +
+       Eigen::TensorOpCost::AddCost<float>() * 3);
+  if (method_name == "nearest") {
+    cost_per_pixel = depth * Eigen::TensorOpCost::CastCost<T, float>() +
+                     Eigen::TensorOpCost::AddCost<float>() * 4 +
+                     Eigen::TensorOpCost::MulCost<float>() * 4;
+  }
+  cost_per_pixel += depth * store_cost;
+  const double cost_per_box = crop_height * crop_width * cost_per_pixel;
 
-    return true;
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(context->device()->tensorflow_cpu_worker_threads());
+  Shard(worker_threads.num_threads, worker_threads.workers, num_boxes,
+        cost_per_box, CropAndResizePerBox);
+
+  return true;
+}
+
+}  // namespace
+
+// Partial specialization of CropAndResize functor for a CPUDevice.
+template <typename T>
+struct CropAndResize<CPUDevice, T> {
+  bool operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor image,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<int32, 1>::ConstTensor box_index,
+                  const string& method_name, float extrapolation_value,
+                  typename TTypes<float, 4>::Tensor crops) {
+    return CropAndResizeCPU<T>(
+        context, image, boxes, box_index, method_name, extrapolation_value,
+        crops.dimension(0), crops.dimension(1), crops.dimension(2),
+        crops.dimension(3), /*store_cost=*/0,
+        [&crops](int b, int y, int x, int d, float value) {
+          crops(b, y, x, d) = value;
+        });
+  }
+};
+
+// Partial specialization of FusedCropAndResize functor for a CPUDevice.
+template <typename T, typename OutT>
+struct FusedCropAndResize<CPUDevice, T, OutT> {
+  bool operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor image,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<int32, 1>::ConstTensor box_index,
+                  const string& method_name, float extrapolation_value,
+                  const CropAndResizeNormalization& normalization,
+                  typename TTypes<OutT, 4>::Tensor crops) {
+    const float* mean = normalization.mean;
+    const float* scale = normalization.scale;
+    const int mean_stride = normalization.mean_stride;
+    const int scale_stride = normalization.scale_stride;
+    const double store_cost = Eigen::TensorOpCost::AddCost<float>() +
+                              Eigen::TensorOpCost::MulCost<float>() +
+                              Eigen::TensorOpCost::CastCost<float, OutT>();
+    if (normalization.divide) {
+      return CropAndResizeCPU<T>(
+          context, image, boxes, box_index, method_name, extrapolation_value,
+          crops.dimension(0), crops.dimension(1), crops.dimension(2),
+          crops.dimension(3), store_cost,
+          [&](int b, int y, int x, int d, float value) {
+            crops(b, y, x, d) = static_cast<OutT>(
+                (value - mean[d * mean_stride]) / scale[d * scale_stride]);
+          });
+    }
+    return CropAndResizeCPU<T>(
+        context, image, boxes, box_index, method_name, extrapolation_value,
+        crops.dimension(0), crops.dimension(1), crops.dimension(2),
+        crops.dimension(3), store_cost,
+        [&](int b, int y, int x, int d, float value) {
+          crops(b, y, x, d) = static_cast<OutT>(
+              (value - mean[d * mean_stride]) * scale[d * scale_stride]);
+        });
   }
 };
 
@@ -807,6 +956,24 @@ TF_CALL_double(REGISTER_KERNEL);
 
 #undef REGISTER_KERNEL
 
+#define REGISTER_FUSED_KERNEL(DEVICE, T, OutT)                      \
+  REGISTER_KERNEL_BUILDER(Name("_FusedCropAndResize")               \
+                              .Device(DEVICE_##DEVICE)              \
+                              .TypeConstraint<T>("T")               \
+                              .TypeConstraint<OutT>("out_type")     \
+                              .HostMemory("crop_size"),             \
+                          FusedCropAndResizeOp<DEVICE##Device, T, OutT>);
+
+#define REGISTER_FUSED_KERNELS(DEVICE, T)         \
+  REGISTER_FUSED_KERNEL(DEVICE, T, float);        \
+  REGISTER_FUSED_KERNEL(DEVICE, T, Eigen::half);  \
+  REGISTER_FUSED_KERNEL(DEVICE, T, bfloat16);
+
+REGISTER_FUSED_KERNELS(CPU, uint8);
+REGISTER_FUSED_KERNELS(CPU, uint16);
+REGISTER_FUSED_KERNELS(CPU, Eigen::half);
+REGISTER_FUSED_KERNELS(CPU, float);
+
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
 // Forward declaration of the CheckValidBoxIndexHelper specialization for GPU.
@@ -918,6 +1085,14 @@ TF_CALL_GPU_NUMBER_TYPES(REGISTER_KERNEL);
 
 #undef REGISTER_KERNEL
 
+REGISTER_FUSED_KERNELS(GPU, uint8);
+REGISTER_FUSED_KERNELS(GPU, uint16);
+REGISTER_FUSED_KERNELS(GPU, Eigen::half);
+REGISTER_FUSED_KERNELS(GPU, float);
+
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+#undef REGISTER_FUSED_KERNELS
+#undef REGISTER_FUSED_KERNEL
+
 }  // namespace tensorflow
@@ -35,6 +35,31 @@ struct CropAndResize {
                   typename TTypes<float, 4>::Tensor crops);
 };
 
+// Normalization fused into the crops by _FusedCropAndResize: channel `d` of
+// each crop becomes `(crop - mean[d]) * scale[d]`, or `(crop - mean[d]) /
+// scale[d]` if `divide` is true. `mean` and `scale` are in device memory and
+// each hold either a single value (stride 0) or one value per channel
+// (stride 1).
+struct CropAndResizeNormalization {
+  const float* mean = nullptr;
+  const float* scale = nullptr;
+  int mean_stride = 0;
+  int scale_stride = 0;
+  bool divide = false;
+};
+
+template <typename Device, typename T, typename OutT>
+struct FusedCropAndResize {
+  // We assume that the tensor sizes are correct.
+  bool operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor image,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<int32, 1>::ConstTensor box_ind,
+                  const std::string& method_name, float extrapolation_value,
+                  const CropAndResizeNormalization& normalization,
+                  typename TTypes<OutT, 4>::Tensor crops);
+};
+
 template <typename Device, typename T>
 struct CropAndResizeBackpropImage {
   // We assume that the tensor sizes are correct.
@@ -36,13 +36,28 @@ enum InterpolationMethod {
   NEAREST = 1,
 };
 
-template <typename T>
+// Writes `value` to `out`, after applying `normalization` if it has a mean.
+template <typename OutT>
+__device__ __forceinline__ void StoreCrop(
+    const functor::CropAndResizeNormalization& normalization, int d,
+    float value, OutT* out) {
+  if (normalization.mean != nullptr) {
+    value -= normalization.mean[d * normalization.mean_stride];
+    const float scale = normalization.scale[d * normalization.scale_stride];
+    value = normalization.divide ? value / scale : value * scale;
+  }
+  *out = static_cast<OutT>(value);
+}
+
+template <typename T, typename OutT>
 __global__ void CropAndResizeKernel(
     const int32 nthreads, const T* __restrict__ image_ptr,
     const float* __restrict__ boxes_ptr, const int32* __restrict__ box_ind_ptr,
     int num_boxes, int batch, int image_height, int image_width,
     int crop_height, int crop_width, int depth, int method_id,
-    float extrapolation_value, float* __restrict__ crops_ptr) {
+    float extrapolation_value,
+    const functor::CropAndResizeNormalization normalization,
+    OutT* __restrict__ crops_ptr) {
   // Precompute some constants outside the loop.
   //
   // The compiler doesn't hoist them outside the loop because of the
@@ -83,7 +98,7 @@ __global__ void CropAndResizeKernel(
             ? y1 * image_height_minus_one + y * (y2 - y1) * height_scale_factor
             : 0.5f * (y1 + y2) * image_height_minus_one;
     if (in_y < 0 || in_y > image_height_minus_one) {
-      crops_ptr[out_idx] = extrapolation_value;
+      StoreCrop(normalization, d, extrapolation_value, &crops_ptr[out_idx]);
       continue;
     }
 
@@ -92,7 +107,7 @@ __global__ void CropAndResizeKernel(
             ? x1 * image_width_minus_one + x * (x2 - x1) * width_scale_factor
             : 0.5f * (x1 + x2) * image_width_minus_one;
     if (in_x < 0 || in_x > image_width_minus_one) {
-      crops_ptr[out_idx] = extrapolation_value;
+      StoreCrop(normalization, d, extrapolation_value, &crops_ptr[out_idx]);
       continue;
     }
 
@@ -127,15 +142,19 @@ __global__ void CropAndResizeKernel(
                     d]));
       const float top = top_left + (top_right - top_left) * x_lerp;
       const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
-      crops_ptr[out_idx] = top + (bottom - top) * y_lerp;
+      StoreCrop(normalization, d, top + (bottom - top) * y_lerp,
+                &crops_ptr[out_idx]);
     } else {  // method_id == kMethodNearestId
       const int closest_x_index = roundf(in_x);
       const int closest_y_index = roundf(in_y);
-      crops_ptr[out_idx] = static_cast<float>(
-          image_ptr[((b_in * image_height + closest_y_index) * image_width +
-                     closest_x_index) *
-                        depth +
-                    d]);
+      StoreCrop(normalization, d,
+                static_cast<float>(
+                    image_ptr[((b_in * image_height + closest_y_index) *
+                                   image_width +
+                               closest_x_index) *
+                                  depth +
+                              d]),
+                &crops_ptr[out_idx]);
     }
   }
 }
@@ -356,6 +375,46 @@ __global__ void CropAndResizeBackpropBoxesKernel(
 }  // namespace
 
 namespace functor {
+namespace {
+
+template <typename T, typename OutT>
+bool LaunchCropAndResizeKernel(
+    const OpKernelContext* context, typename TTypes<T, 4>::ConstTensor image,
+    typename TTypes<float, 2>::ConstTensor boxes,
+    typename TTypes<int32, 1>::ConstTensor box_ind,
+    const std::string& method_name, float extrapolation_value,
+    const CropAndResizeNormalization& normalization,
+    typename TTypes<OutT, 4>::Tensor crops) {
+  const int batch = image.dimension(0);
+  const int image_height = image.dimension(1);
+  const int image_width = image.dimension(2);
+
+  const int num_boxes = crops.dimension(0);
+  const int crop_height = crops.dimension(1);
+  const int crop_width = crops.dimension(2);
+  const int depth = crops.dimension(3);
+
+  const int total_count = num_boxes * crop_height * crop_width * depth;
+  const GPUDevice& d = context->eigen_device<GPUDevice>();
+
+  InterpolationMethod method = BILINEAR;
+  if (method_name == "nearest") {
+    method = NEAREST;
+  }
+
+  if (total_count > 0) {
+    GpuLaunchConfig config = GetGpuLaunchConfig(total_count, d);
+    TF_CHECK_OK(GpuLaunchKernel(
+        CropAndResizeKernel<T, OutT>, config.block_count,
+        config.thread_per_block, 0, d.stream(), config.virtual_thread_count,
+        image.data(), boxes.data(), box_ind.data(), num_boxes, batch,
+        image_height, image_width, crop_height, crop_width, depth, method,
+        extrapolation_value, normalization, crops.data()));
+  }
+  return d.ok();
+}
+
+}  // namespace
 
 template <typename T>
 struct CropAndResize<GPUDevice, T> {
@@ -365,33 +424,24 @@ struct CropAndResize<GPUDevice, T> {
                   typename TTypes<int32, 1>::ConstTensor box_ind,
                   const std::string& method_name, float extrapolation_value,
                   typename TTypes<float, 4>::Tensor crops) {
-    const int batch = image.dimension(0);
-    const int image_height = image.dimension(1);
-    const int image_width = image.dimension(2);
-
-    const int num_boxes = crops.dimension(0);
-    const int crop_height = crops.dimension(1);
-    const int crop_width = crops.dimension(2);
-    const int depth = crops.dimension(3);
-
-    const int total_count = num_boxes * crop_height * crop_width * depth;
-    const GPUDevice& d = context->eigen_device<GPUDevice>();
-
-    InterpolationMethod method = BILINEAR;
-    if (method_name == "nearest") {
-      method = NEAREST;
-    }
+    return LaunchCropAndResizeKernel<T, float>(
+        context, image, boxes, box_ind, method_name, extrapolation_value,
+        CropAndResizeNormalization(), crops);
+  }
+};
 
-    if (total_count > 0) {
-      GpuLaunchConfig config = GetGpuLaunchConfig(total_count, d);
-      TF_CHECK_OK(GpuLaunchKernel(
-          CropAndResizeKernel<T>, config.block_count, config.thread_per_block,
-          0, d.stream(), config.virtual_thread_count, image.data(),
-          boxes.data(), box_ind.data(), num_boxes, batch, image_height,
-          image_width, crop_height, crop_width, depth, method,
-          extrapolation_value, crops.data()));
-    }
-    return d.ok();
+template <typename T, typename OutT>
+struct FusedCropAndResize<GPUDevice, T, OutT> {
+  bool operator()(OpKernelContext* context,
+                  typename TTypes<T, 4>::ConstTensor image,
+                  typename TTypes<float, 2>::ConstTensor boxes,
+                  typename TTypes<int32, 1>::ConstTensor box_ind,
+                  const std::string& method_name, float extrapolation_value,
+                  const CropAndResizeNormalization& normalization,
+                  typename TTypes<OutT, 4>::Tensor crops) {
+    return LaunchCropAndResizeKernel<T, OutT>(
+        context, image, boxes, box_ind, method_name, extrapolation_value,
+        normalization, crops);
   }
 };
 
@@ -499,6 +549,18 @@ TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPECS);
 
 #undef DEFINE_GPU_SPECS
 
+#define DEFINE_FUSED_GPU_SPECS(T)                                    \
+  template struct FusedCropAndResize<GPUDevice, T, float>;       \
+  template struct FusedCropAndResize<GPUDevice, T, Eigen::half>; \
+  template struct FusedCropAndResize<GPUDevice, T, bfloat16>;
+
+TF_CALL_uint8(DEFINE_FUSED_GPU_SPECS);
+TF_CALL_uint16(DEFINE_FUSED_GPU_SPECS);
+TF_CALL_half(DEFINE_FUSED_GPU_SPECS);
+TF_CALL_float(DEFINE_FUSED_GPU_SPECS);
+
+#undef DEFINE_FUSED_GPU_SPECS
+
 template struct CheckValidBoxIndexHelper<GPUDevice>;
 
 }  // namespace functor
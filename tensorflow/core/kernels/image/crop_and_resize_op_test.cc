@@ -454,4 +454,93 @@ TEST_F(CropAndResizeOpTest, TestWithSharding) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+class FusedCropAndResizeOpTest : public OpsTestBase {
+ protected:
+  template <typename T>
+  void MakeOp(DataType out_type, bool divide_by_scale,
+              float extrapolation_value = 0) {
+    TF_EXPECT_OK(NodeDefBuilder("fused_crop_and_resize_op",
+                                "_FusedCropAndResize")
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("out_type", out_type)
+                     .Attr("extrapolation_value", extrapolation_value)
+                     .Attr("divide_by_scale", divide_by_scale)
+                     .Finalize(node_def()));
+    TF_EXPECT_OK(InitOp());
+  }
+};
+
+TEST_F(FusedCropAndResizeOpTest, PerChannelMul) {
+  MakeOp<uint8>(DT_FLOAT, /*divide_by_scale=*/false);
+  AddInputFromArray<uint8>(TensorShape({1, 2, 2, 2}),
+                           {1, 10, 2, 20, 3, 30, 4, 40});
+  AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  AddInputFromArray<float>(TensorShape({1, 1, 2}), {1, 10});
+  AddInputFromArray<float>(TensorShape({2}), {2, 0.5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({1, 2, 2, 2}));
+  test::FillValues<float>(&expected, {0, 0, 2, 5, 4, 10, 6, 15});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedCropAndResizeOpTest, PerChannelDivToHalf) {
+  MakeOp<float>(DT_HALF, /*divide_by_scale=*/true);
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 2}),
+                           {1, 10, 2, 20, 3, 30, 4, 40});
+  AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  AddInputFromArray<float>(TensorShape({2}), {1, 10});
+  AddInputFromArray<float>(TensorShape({2}), {0.5, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_HALF, TensorShape({1, 2, 2, 2}));
+  test::FillFn<Eigen::half>(&expected, [](int i) -> Eigen::half {
+    static const float kValues[] = {0, 0, 2, 5, 4, 10, 6, 15};
+    return static_cast<Eigen::half>(kValues[i]);
+  });
+  test::ExpectTensorEqual<Eigen::half>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedCropAndResizeOpTest, ScalarNormalizationAndExtrapolation) {
+  MakeOp<float>(DT_FLOAT, /*divide_by_scale=*/false,
+                /*extrapolation_value=*/9);
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 1}), {1, 2, 3, 4});
+  // The second box lies outside of the image.
+  AddInputFromArray<float>(TensorShape({2, 4}), {0, 0, 1, 1, 2, 2, 3, 3});
+  AddInputFromArray<int32>(TensorShape({2}), {0, 0});
+  AddInputFromArray<int32>(TensorShape({2}), {1, 1});
+  AddInputFromArray<float>(TensorShape({}), {0.5});
+  AddInputFromArray<float>(TensorShape({}), {2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 1, 1, 1}));
+  test::FillValues<float>(&expected, {4, 17});
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(FusedCropAndResizeOpTest, InvalidMeanSize) {
+  MakeOp<float>(DT_FLOAT, /*divide_by_scale=*/false);
+  AddInputFromArray<float>(TensorShape({1, 2, 2, 2}),
+                           {1, 10, 2, 20, 3, 30, 4, 40});
+  AddInputFromArray<float>(TensorShape({1, 4}), {0, 0, 1, 1});
+  AddInputFromArray<int32>(TensorShape({1}), {0});
+  AddInputFromArray<int32>(TensorShape({2}), {2, 2});
+  AddInputFromArray<float>(TensorShape({3}), {1, 2, 3});
+  AddInputFromArray<float>(TensorShape({}), {1});
+  Status s = RunOpKernel();
+  ASSERT_FALSE(s.ok());
+  EXPECT_TRUE(
+      absl::StrContains(s.ToString(), "mean and scale must have 1 or 2"))
+      << s;
+}
+
 }  // namespace tensorflow
@@ -0,0 +1,371 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Curated benchmarks of the hot kernels, at the shapes seen in production.
+//
+// Unlike the benchmarks next to each kernel's tests, every benchmark of this
+// suite is named
+//
+//   BM_KernelSuite/<op>/<shape>/<device>
+//
+// and reports the same counters: items_per_second (flops for matmul and conv,
+// output elements otherwise) and bytes_per_second (bytes of the inputs and the
+// output). So the JSON output of two builds, or of CPU and GPU, can be diffed
+// with //tensorflow/tools/test:compare_kernel_benchmarks:
+//
+//   kernel_benchmark_suite_test --benchmark_filter=all \
+//       --benchmark_repetitions=5 --benchmark_out_format=json \
+//       --benchmark_out=/tmp/baseline.json
+//   compare_kernel_benchmarks --baseline=/tmp/baseline.json \
+//       --candidate=/tmp/candidate.json
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/stringprintf.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// A benchmark of the suite: the graph of a single op, and the work it does
+// per run.
+struct SuiteCase {
+  string op;
+  string shape;
+  // The op has no GPU kernel.
+  bool cpu_only = false;
+  std::function<Graph*()> graph;
+  int64_t items_per_run = 0;
+  int64_t bytes_per_run = 0;
+};
+
+Tensor RandomFloats(const TensorShape& shape) {
+  Tensor t(DT_FLOAT, shape);
+  t.flat<float>().setRandom();
+  return t;
+}
+
+template <typename Index>
+Tensor RandomIndices(int64_t size, Index limit) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor t(DataTypeToEnum<Index>::value, TensorShape({size}));
+  auto flat = t.flat<Index>();
+  for (int64_t i = 0; i < size; ++i) flat(i) = rnd.Uniform(limit);
+  return t;
+}
+
+Tensor Vector(const std::vector<int32>& values) {
+  Tensor t(DT_INT32, TensorShape({static_cast<int64_t>(values.size())}));
+  for (int i = 0; i < values.size(); ++i) t.flat<int32>()(i) = values[i];
+  return t;
+}
+
+Tensor Scalar(int32 value) {
+  Tensor t(DT_INT32, TensorShape({}));
+  t.scalar<int32>()() = value;
+  return t;
+}
+
+SuiteCase MatMul(int m, int k, int n) {
+  SuiteCase c;
+  c.op = "MatMul";
+  c.shape = strings::StrCat(m, "x", k, "x", n);
+  c.graph = [m, k, n] {
+    Graph* g = new Graph(OpRegistry::Global());
+    test::graph::Matmul(
+        g, test::graph::Constant(g, RandomFloats({m, k})),
+        test::graph::Constant(g, RandomFloats({k, n})), false, false);
+    return g;
+  };
+  c.items_per_run = 2LL * m * k * n;
+  c.bytes_per_run = (1LL * m * k + 1LL * k * n + 1LL * m * n) * sizeof(float);
+  return c;
+}
+
+// NHWC input and HWIO filter, with unit strides and SAME padding.
+SuiteCase Conv2D(int batch, int size, int depth, int filter_size,
+                 int out_depth) {
+  SuiteCase c;
+  c.op = "Conv2D";
+  c.shape = strings::StrCat(batch, "x", size, "x", size, "x", depth, "_",
+                            filter_size, "x", filter_size, "x", out_depth);
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    test::graph::Conv2D(
+        g, test::graph::Constant(g, RandomFloats({batch, size, size, depth})),
+        test::graph::Constant(
+            g, RandomFloats({filter_size, filter_size, depth, out_depth})));
+    return g;
+  };
+  const int64_t outputs = 1LL * batch * size * size * out_depth;
+  c.items_per_run = 2 * outputs * filter_size * filter_size * depth;
+  c.bytes_per_run = (1LL * batch * size * size * depth +
+                     1LL * filter_size * filter_size * depth * out_depth +
+                     outputs) *
+                    sizeof(float);
+  return c;
+}
+
+// Embedding lookup of `lookups` rows of a [rows, dim] table.
+SuiteCase Gather(int rows, int dim, int lookups) {
+  SuiteCase c;
+  c.op = "GatherV2";
+  c.shape = strings::StrCat(rows, "x", dim, "_", lookups);
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    test::graph::Gather(
+        g, test::graph::Constant(g, RandomFloats({rows, dim})),
+        test::graph::Constant(g, RandomIndices<int32>(lookups, rows)),
+        test::graph::HostConstant(g, Scalar(0)));
+    return g;
+  };
+  c.items_per_run = 1LL * lookups * dim;
+  c.bytes_per_run = 2 * c.items_per_run * sizeof(float);
+  return c;
+}
+
+// Sums the rows of a [rows, cols] tensor into `segments` segments, with sorted
+// segment ids for SegmentSum and random ones for UnsortedSegmentSum.
+SuiteCase SegmentSum(const string& op, int rows, int cols, int segments) {
+  SuiteCase c;
+  c.op = op;
+  c.shape = strings::StrCat(rows, "x", cols, "_", segments);
+  const bool sorted = op == "SegmentSum";
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    Tensor ids = RandomIndices<int32>(rows, segments);
+    if (sorted) {
+      for (int i = 0; i < rows; ++i) {
+        ids.flat<int32>()(i) = static_cast<int64_t>(i) * segments / rows;
+      }
+    }
+    NodeBuilder builder(g->NewName("n"), op);
+    builder.Input(test::graph::Constant(g, RandomFloats({rows, cols})))
+        .Input(test::graph::Constant(g, ids));
+    if (!sorted) builder.Input(test::graph::HostConstant(g, Scalar(segments)));
+    Node* ret;
+    TF_CHECK_OK(builder.Finalize(g, &ret));
+    return g;
+  };
+  c.items_per_run = 1LL * rows * cols;
+  c.bytes_per_run = (c.items_per_run + 1LL * segments * cols) * sizeof(float);
+  return c;
+}
+
+// A binary op on two tensors of `shape`, or on a tensor of `shape` and a
+// vector broadcast along its last dimension.
+SuiteCase Binary(const string& op, const TensorShape& shape, bool broadcast) {
+  SuiteCase c;
+  c.op = op;
+  c.shape = strings::StrCat(absl::StrJoin(shape.dim_sizes(), "x"),
+                            broadcast ? "_bcast" : "");
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    const TensorShape other_shape =
+        broadcast ? TensorShape({shape.dim_size(shape.dims() - 1)}) : shape;
+    test::graph::Binary(g, op, test::graph::Constant(g, RandomFloats(shape)),
+                        test::graph::Constant(g, RandomFloats(other_shape)));
+    return g;
+  };
+  c.items_per_run = shape.num_elements();
+  c.bytes_per_run = (broadcast ? 2 : 3) * c.items_per_run * sizeof(float);
+  return c;
+}
+
+SuiteCase Unary(const string& op, const TensorShape& shape) {
+  SuiteCase c;
+  c.op = op;
+  c.shape = absl::StrJoin(shape.dim_sizes(), "x");
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    test::graph::Unary(g, op, test::graph::Constant(g, RandomFloats(shape)));
+    return g;
+  };
+  c.items_per_run = shape.num_elements();
+  c.bytes_per_run = 2 * c.items_per_run * sizeof(float);
+  return c;
+}
+
+SuiteCase Transpose(const TensorShape& shape, const std::vector<int32>& perm) {
+  SuiteCase c;
+  c.op = "Transpose";
+  c.shape = strings::StrCat(absl::StrJoin(shape.dim_sizes(), "x"), "_",
+                            absl::StrJoin(perm, ""));
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    Node* ret;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Transpose")
+                    .Input(test::graph::Constant(g, RandomFloats(shape)))
+                    .Input(test::graph::HostConstant(g, Vector(perm)))
+                    .Finalize(g, &ret));
+    return g;
+  };
+  c.items_per_run = shape.num_elements();
+  c.bytes_per_run = 2 * c.items_per_run * sizeof(float);
+  return c;
+}
+
+// Concatenates `num_inputs` tensors of `shape` along `axis`.
+SuiteCase Concat(int num_inputs, const TensorShape& shape, int axis) {
+  SuiteCase c;
+  c.op = "ConcatV2";
+  c.shape = strings::StrCat(num_inputs, "x",
+                            absl::StrJoin(shape.dim_sizes(), "x"), "_axis",
+                            axis);
+  c.graph = [=] {
+    Graph* g = new Graph(OpRegistry::Global());
+    std::vector<Node*> inputs;
+    for (int i = 0; i < num_inputs; ++i) {
+      inputs.push_back(test::graph::Constant(g, RandomFloats(shape)));
+    }
+    test::graph::ConcatV2(g, inputs,
+                          test::graph::HostConstant(g, Scalar(axis)));
+    return g;
+  };
+  c.items_per_run = num_inputs * shape.num_elements();
+  c.bytes_per_run = 2 * c.items_per_run * sizeof(float);
+  return c;
+}
+
+// Parses a batch of serialized Examples, each with `num_features` dense float
+// features of `feature_size` values.
+SuiteCase ParseExample(int batch_size, int num_features, int feature_size) {
+  SuiteCase c;
+  c.op = "ParseExample";
+  c.shape = strings::StrCat(batch_size, "x", num_features, "x", feature_size);
+  c.cpu_only = true;
+  c.graph = [=] {
+    Tensor serialized(DT_STRING, TensorShape({batch_size}));
+    Tensor names(DT_STRING, TensorShape({batch_size}));
+    for (int b = 0; b < batch_size; ++b) {
+      Example example;
+      auto& features = *example.mutable_features()->mutable_feature();
+      for (int i = 0; i < num_features; ++i) {
+        auto* values = features[strings::Printf("feature_%d", i)]
+                           .mutable_float_list();
+        for (int j = 0; j < feature_size; ++j) values->add_value(b + i + j);
+      }
+      serialized.flat<tstring>()(b) = example.SerializeAsString();
+    }
+
+    Graph* g = new Graph(OpRegistry::Global());
+    std::vector<NodeBuilder::NodeOut> dense_keys;
+    std::vector<NodeBuilder::NodeOut> dense_defaults;
+    std::vector<PartialTensorShape> dense_shapes;
+    for (int i = 0; i < num_features; ++i) {
+      Tensor key(DT_STRING, TensorShape({}));
+      key.scalar<tstring>()() = strings::Printf("feature_%d", i);
+      dense_keys.emplace_back(test::graph::Constant(g, key));
+      Tensor dense_default(DT_FLOAT, TensorShape({feature_size}));
+      dense_default.flat<float>().setZero();
+      dense_defaults.emplace_back(test::graph::Constant(g, dense_default));
+      dense_shapes.push_back(PartialTensorShape({feature_size}));
+    }
+    Node* ret;
+    TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                    .Input(test::graph::Constant(g, serialized))
+                    .Input(test::graph::Constant(g, names))
+                    .Input(std::vector<NodeBuilder::NodeOut>())
+                    .Input(dense_keys)
+                    .Input(dense_defaults)
+                    .Attr("sparse_types", DataTypeVector())
+                    .Attr("dense_shapes", dense_shapes)
+                    .Finalize(g, &ret));
+    return g;
+  };
+  c.items_per_run = 1LL * batch_size * num_features * feature_size;
+  // The serialized protos are roughly as large as the parsed values.
+  c.bytes_per_run = 2 * c.items_per_run * sizeof(float);
+  return c;
+}
+
+// The shapes come from production models: the dense layers and embedding
+// tables of recommendation models, the convolutions of ResNet-50 and the
+// attention blocks of Transformers.
+std::vector<SuiteCase> SuiteCases() {
+  return {
+      MatMul(1, 1024, 1024),
+      MatMul(128, 1024, 1024),
+      MatMul(256, 1024, 4096),
+      MatMul(2048, 2048, 2048),
+      Conv2D(32, 56, 64, 3, 64),
+      Conv2D(32, 28, 128, 3, 128),
+      Conv2D(32, 14, 256, 1, 1024),
+      Conv2D(32, 7, 512, 3, 512),
+      Gather(1000000, 64, 4096),
+      Gather(100000, 256, 16384),
+      SegmentSum("SegmentSum", 16384, 64, 1024),
+      SegmentSum("UnsortedSegmentSum", 16384, 64, 1024),
+      SegmentSum("UnsortedSegmentSum", 65536, 128, 4096),
+      Binary("AddV2", {1 << 20}, false),
+      Binary("Mul", {1024, 4096}, false),
+      Binary("AddV2", {1024, 4096}, true),
+      Unary("Tanh", {1024, 4096}),
+      Unary("Relu", {1024, 4096}),
+      Transpose({4096, 4096}, {1, 0}),
+      Transpose({32, 128, 16, 64}, {0, 2, 1, 3}),
+      Transpose({32, 56, 56, 64}, {0, 3, 1, 2}),
+      Concat(4, {1024, 256}, 1),
+      Concat(16, {64, 1024}, 0),
+      Concat(64, {256, 32}, 1),
+      ParseExample(128, 16, 32),
+      ParseExample(512, 64, 1),
+  };
+}
+
+void RegisterCase(const SuiteCase& c, const string& device) {
+  const string name =
+      strings::StrCat("BM_KernelSuite/", c.op, "/", c.shape, "/", device);
+  ::benchmark::RegisterBenchmark(
+      name.c_str(),
+      [c, device](::testing::benchmark::State& state) {
+        test::Benchmark(device, c.graph(), /*old_benchmark_api=*/false)
+            .Run(state);
+        state.SetItemsProcessed(state.iterations() * c.items_per_run);
+        state.SetBytesProcessed(state.iterations() * c.bytes_per_run);
+      })
+      ->UseRealTime();
+}
+
+bool RegisterSuite() {
+  for (const SuiteCase& c : SuiteCases()) {
+    RegisterCase(c, "cpu");
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+    if (!c.cpu_only) RegisterCase(c, "gpu");
+#endif
+  }
+  return true;
+}
+
+static bool suite_registered TF_ATTRIBUTE_UNUSED = RegisterSuite();
+
+}  // namespace
+}  // namespace tensorflow
@@ -15,16 +15,25 @@ limitations under the License.
 
 // Tests kernels of lookup ops.
 
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/shape_inference_testutil.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace {
@@ -62,7 +71,32 @@ REGISTER_KERNEL_BUILDER(
     AnonymousLookupTableOp<MockHashTable<key_dtype, value_dtype>, key_dtype,
                            value_dtype>);
 
-class LookupOpsTest : public OpsTestBase {};
+class LookupOpsTest : public OpsTestBase {
+ protected:
+  // Runs the table op set up in `node_def()`, and returns the table it
+  // creates. The table is alive as long as the outputs of the kernel.
+  lookup::LookupInterface* RunTableOp() {
+    TF_CHECK_OK(InitOp());
+    TF_CHECK_OK(RunOpKernel());
+    auto table_or = GetOutput(0)
+                        ->scalar<ResourceHandle>()()
+                        .GetResource<lookup::LookupInterface>();
+    TF_CHECK_OK(table_or.status());
+    return table_or.ValueOrDie();
+  }
+
+  // Returns an int64 -> float `AnonymousShardedMutableHashTable`.
+  lookup::LookupInterface* MakeShardedTable(const TensorShape& value_shape,
+                                            int num_shards) {
+    TF_CHECK_OK(NodeDefBuilder("table", "AnonymousShardedMutableHashTable")
+                    .Attr("key_dtype", DT_INT64)
+                    .Attr("value_dtype", DT_FLOAT)
+                    .Attr("value_shape", value_shape)
+                    .Attr("num_shards", num_shards)
+                    .Finalize(node_def()));
+    return RunTableOp();
+  }
+};
 
 TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   TF_ASSERT_OK(
@@ -100,5 +134,214 @@ TEST_F(LookupOpsTest, AnonymousHashTable_RefCounting) {
   EXPECT_FALSE(alive);
 }
 
+TEST_F(LookupOpsTest, ShardedMutableHashTable_InsertFindRemove) {
+  lookup::LookupInterface* table =
+      MakeShardedTable(TensorShape({2}), /*num_shards=*/4);
+  EXPECT_EQ(table->value_shape(), TensorShape({2}));
+
+  // Enough keys to grow every shard several times.
+  constexpr int kNumKeys = 1000;
+  std::vector<int64_t> keys;
+  std::vector<float> values;
+  for (int i = 0; i < kNumKeys; ++i) {
+    keys.push_back(i * 1000);
+    values.push_back(i);
+    values.push_back(-i);
+  }
+  TF_ASSERT_OK(table->Insert(nullptr, test::AsTensor<int64_t>(keys),
+                             test::AsTensor<float>(values, {kNumKeys, 2})));
+  EXPECT_EQ(table->size(), kNumKeys);
+
+  // Overwrite the value of key 0, and remove the keys of odd indices.
+  TF_ASSERT_OK(table->Insert(nullptr, test::AsTensor<int64_t>({0}),
+                             test::AsTensor<float>({7, 8}, {1, 2})));
+  std::vector<int64_t> removed;
+  for (int i = 1; i < kNumKeys; i += 2) removed.push_back(keys[i]);
+  TF_ASSERT_OK(table->Remove(nullptr, test::AsTensor<int64_t>(removed)));
+  EXPECT_EQ(table->size(), kNumKeys / 2);
+
+  Tensor found(DT_FLOAT, TensorShape({kNumKeys, 2}));
+  TF_ASSERT_OK(table->Find(nullptr, test::AsTensor<int64_t>(keys), &found,
+                           test::AsTensor<float>({-1, -2})));
+  auto found_matrix = found.matrix<float>();
+  EXPECT_EQ(found_matrix(0, 0), 7);
+  EXPECT_EQ(found_matrix(0, 1), 8);
+  for (int i = 1; i < kNumKeys; ++i) {
+    EXPECT_EQ(found_matrix(i, 0), i % 2 ? -1 : i) << i;
+    EXPECT_EQ(found_matrix(i, 1), i % 2 ? -2 : -i) << i;
+  }
+
+  // Removed keys can be inserted again.
+  TF_ASSERT_OK(table->Insert(nullptr, test::AsTensor<int64_t>({1000}),
+                             test::AsTensor<float>({3, 4}, {1, 2})));
+  EXPECT_EQ(table->size(), kNumKeys / 2 + 1);
+
+  // Importing replaces the contents of the table, and each key may have its
+  // own default value.
+  TF_ASSERT_OK(table->ImportValues(nullptr, test::AsTensor<int64_t>({5}),
+                                   test::AsTensor<float>({5, 6}, {1, 2})));
+  EXPECT_EQ(table->size(), 1);
+  Tensor imported(DT_FLOAT, TensorShape({2, 2}));
+  TF_ASSERT_OK(table->Find(nullptr, test::AsTensor<int64_t>({5, 0}), &imported,
+                           test::AsTensor<float>({0, 0, 9, 10}, {2, 2})));
+  test::ExpectTensorEqual<float>(imported,
+                                 test::AsTensor<float>({5, 6, 9, 10}, {2, 2}));
+}
+
+TEST_F(LookupOpsTest, ShardedMutableHashTable_ScalarValues) {
+  lookup::LookupInterface* table =
+      MakeShardedTable(TensorShape({}), /*num_shards=*/1);
+  TF_ASSERT_OK(table->Insert(nullptr, test::AsTensor<int64_t>({1, 2}),
+                             test::AsTensor<float>({10, 20})));
+  Tensor found(DT_FLOAT, TensorShape({3}));
+  TF_ASSERT_OK(table->Find(nullptr, test::AsTensor<int64_t>({2, 3, 1}), &found,
+                           test::AsScalar<float>(-1)));
+  test::ExpectTensorEqual<float>(found, test::AsTensor<float>({20, -1, 10}));
+}
+
+// Readers must never observe a partially written value while writers update
+// and remove the keys they look up.
+TEST_F(LookupOpsTest, ShardedMutableHashTable_ConcurrentReadsAndWrites) {
+  constexpr int kValueDim = 8;
+  constexpr int kNumKeys = 256;
+  constexpr int kNumWriters = 2;
+  constexpr int kNumReaders = 4;
+  constexpr int kNumRounds = 200;
+  lookup::LookupInterface* table =
+      MakeShardedTable(TensorShape({kValueDim}), /*num_shards=*/4);
+  std::vector<int64_t> keys;
+  for (int i = 0; i < kNumKeys; ++i) keys.push_back(i);
+  const Tensor keys_tensor = test::AsTensor<int64_t>(keys);
+
+  std::atomic<int> num_writers_done{0};
+  std::atomic<int> num_errors{0};
+  {
+    thread::ThreadPool pool(Env::Default(), "test",
+                            kNumWriters + kNumReaders);
+    for (int w = 0; w < kNumWriters; ++w) {
+      pool.Schedule([&, w]() {
+        Tensor values(DT_FLOAT, TensorShape({kNumKeys, kValueDim}));
+        for (int round = 0; round < kNumRounds; ++round) {
+          // Every component of a value is the same.
+          values.flat<float>().setConstant(round * kNumWriters + w);
+          TF_CHECK_OK(table->Insert(nullptr, keys_tensor, values));
+          if (round % 10 == 0) {
+            TF_CHECK_OK(table->Remove(nullptr, keys_tensor));
+          }
+        }
+        num_writers_done.fetch_add(1);
+      });
+    }
+    for (int r = 0; r < kNumReaders; ++r) {
+      pool.Schedule([&]() {
+        Tensor found(DT_FLOAT, TensorShape({kNumKeys, kValueDim}));
+        do {
+          TF_CHECK_OK(table->Find(nullptr, keys_tensor, &found,
+                                  test::AsTensor<float>({-1, -1, -1, -1, -1,
+                                                         -1, -1, -1})));
+          auto found_matrix = found.matrix<float>();
+          for (int i = 0; i < kNumKeys; ++i) {
+            for (int j = 1; j < kValueDim; ++j) {
+              if (found_matrix(i, j) != found_matrix(i, 0)) {
+                num_errors.fetch_add(1);
+              }
+            }
+          }
+        } while (num_writers_done.load() < kNumWriters);
+      });
+    }
+  }
+  EXPECT_EQ(num_errors.load(), 0);
+  EXPECT_EQ(table->size(), kNumKeys);
+}
+
+// Benchmarks concurrent lookups of int64 keys, where every
+// `insert_period`-th batch of every thread is an update of the same keys.
+// `sharded` selects `ShardedMutableHashTable` instead of `MutableHashTable`
+// (or `MutableHashTableOfTensors` when `value_dim` is not 1).
+class LookupTableBM : public LookupOpsTest {
+ public:
+  void TestBody() override {}
+
+  lookup::LookupInterface* MakeTable(bool sharded, int value_dim) {
+    const TensorShape value_shape =
+        value_dim == 1 ? TensorShape({}) : TensorShape({value_dim});
+    if (sharded) return MakeShardedTable(value_shape, /*num_shards=*/64);
+    NodeDefBuilder builder("table", value_dim == 1
+                                        ? "AnonymousMutableHashTable"
+                                        : "AnonymousMutableHashTableOfTensors");
+    builder.Attr("key_dtype", DT_INT64).Attr("value_dtype", DT_FLOAT);
+    if (value_dim != 1) builder.Attr("value_shape", value_shape);
+    TF_CHECK_OK(builder.Finalize(node_def()));
+    return RunTableOp();
+  }
+};
+
+constexpr int kBenchmarkNumKeys = 1 << 16;
+constexpr int kBenchmarkBatchSize = 1024;
+
+// Returns a table populated with `kBenchmarkNumKeys` keys, shared by all the
+// threads of a benchmark.
+lookup::LookupInterface* GetBenchmarkTable(bool sharded, int value_dim) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* tables =
+      new std::map<std::pair<bool, int>, lookup::LookupInterface*>;
+  mutex_lock l(mu);
+  lookup::LookupInterface*& table = (*tables)[{sharded, value_dim}];
+  if (table == nullptr) {
+    // Leaked, so that the table outlives the benchmark.
+    auto* bm = new LookupTableBM;
+    table = bm->MakeTable(sharded, value_dim);
+    std::vector<int64_t> keys(kBenchmarkNumKeys);
+    for (int i = 0; i < kBenchmarkNumKeys; ++i) keys[i] = i;
+    Tensor values(DT_FLOAT, TensorShape({kBenchmarkNumKeys, value_dim}));
+    values.flat<float>().setConstant(1);
+    TF_CHECK_OK(table->Insert(nullptr, test::AsTensor<int64_t>(keys), values));
+  }
+  return table;
+}
+
+void BM_LookupTable(::testing::benchmark::State& state) {
+  const bool sharded = state.range(0);
+  const int value_dim = state.range(1);
+  const int insert_period = state.range(2);
+  lookup::LookupInterface* table = GetBenchmarkTable(sharded, value_dim);
+
+  std::vector<int64_t> keys(kBenchmarkBatchSize);
+  uint64 x = state.thread_index() + 1;
+  for (int64_t& key : keys) {
+    // A linear congruential generator, so that threads see different keys.
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    key = (x >> 33) % kBenchmarkNumKeys;
+  }
+  const Tensor keys_tensor = test::AsTensor<int64_t>(keys);
+  TensorShape value_shape({kBenchmarkBatchSize});
+  if (value_dim != 1) value_shape.AddDim(value_dim);
+  Tensor values(DT_FLOAT, value_shape);
+  values.flat<float>().setConstant(2);
+  Tensor found(DT_FLOAT, value_shape);
+  Tensor default_value(DT_FLOAT, value_dim == 1 ? TensorShape({})
+                                                : TensorShape({value_dim}));
+  default_value.flat<float>().setZero();
+
+  int64_t i = 0;
+  for (auto s : state) {
+    if (insert_period > 0 && ++i % insert_period == 0) {
+      TF_CHECK_OK(table->Insert(nullptr, keys_tensor, values));
+    } else {
+      TF_CHECK_OK(table->Find(nullptr, keys_tensor, &found, default_value));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kBenchmarkBatchSize);
+}
+
+// Args: sharded, value dimension, insert period (0 for lookups only).
+BENCHMARK(BM_LookupTable)
+    ->UseRealTime()
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(64)
+    ->ArgsProduct({{0, 1}, {1, 16}, {0, 10}});
+
 }  // namespace
 }  // namespace tensorflow
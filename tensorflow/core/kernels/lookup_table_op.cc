@@ -16,9 +16,12 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -878,6 +881,453 @@ class MutableDenseHashTable final : public LookupInterface {
   uint64 deleted_key_hash_;
 };
 
+// Lookup table for integer keys, optimized for concurrent lookups and updates,
+// where each value is a scalar or a vector.
+//
+// The keys are distributed over `num_shards` open addressing hash tables with
+// linear probing. Each shard is protected by a mutex, which is only held by
+// writers, and by a sequence lock: writers make the sequence number of the
+// shard odd while they modify it, and lookups read the shard without
+// acquiring any lock, retrying if its sequence number changed in the meantime.
+// Buckets are only accessed through relaxed atomic operations, so that a
+// lookup that races with a writer reads well-defined (if inconsistent) values,
+// which are discarded by the retry.
+//
+// The bucket array of a shard is resized in place when it contains too many
+// deleted entries, and replaced by an array of twice the capacity when it
+// contains too many entries. Since concurrent lookups may still read a
+// replaced array, replaced arrays are only freed with the table. Capacities
+// double, so they use at most as much memory as the current arrays.
+//
+// Each of `Insert()`, `Remove()` and `ImportValues()` is atomic with respect
+// to lookups of the keys of one shard, but not across shards.
+template <class K, class V>
+class ShardedMutableHashTable final : public LookupInterface {
+  static_assert(std::is_integral<K>::value,
+                "ShardedMutableHashTable only supports integer keys");
+
+ public:
+  ShardedMutableHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    OP_REQUIRES_OK(ctx,
+                   GetNodeAttr(kernel->def(), "value_shape", &value_shape_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsScalar(value_shape_) ||
+                    TensorShapeUtils::IsVector(value_shape_),
+                errors::InvalidArgument(
+                    "Value must be a scalar or a vector, got shape ",
+                    value_shape_.DebugString()));
+    value_dim_ = value_shape_.num_elements();
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "num_shards", &num_shards_));
+    OP_REQUIRES(ctx, num_shards_ >= 1,
+                errors::InvalidArgument("num_shards must be positive, got: ",
+                                        num_shards_));
+    shards_.reset(new Shard[num_shards_]);
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      Shard& shard = shards_[i];
+      mutex_lock l(shard.mu);
+      shard.bucket_arrays.emplace_back(
+          new BucketArray(kInitialCapacity, value_dim_));
+      shard.buckets.store(shard.bucket_arrays.back().get(),
+                          std::memory_order_release);
+    }
+  }
+
+  size_t size() const override {
+    int64_t size = 0;
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      size += shards_[i].num_entries.load(std::memory_order_relaxed);
+    }
+    return size;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto key_values = key.flat<K>();
+    const int64_t num_elements = key_values.size();
+    auto value_matrix = value->shaped<V, 2>({num_elements, value_dim_});
+    const auto default_flat = default_value.flat<V>();
+    // As in `MutableHashTableOfTensors`, each key either has its own default
+    // value, or all keys share the first default value.
+    const bool is_full_size_default =
+        default_flat.size() == num_elements * value_dim_;
+
+    for (int64_t i = 0; i < num_elements; ++i) {
+      const K k = SubtleMustCopyIfIntegral(key_values(i));
+      const uint64 hash = HashKey(k);
+      V* out = value_dim_ > 0 ? &value_matrix(i, 0) : nullptr;
+      if (!FindInShard(&shards_[ShardIndex(hash)], hash, k, out)) {
+        const int64_t offset = is_full_size_default ? i * value_dim_ : 0;
+        for (int64_t j = 0; j < value_dim_; ++j) {
+          out[j] = SubtleMustCopyIfIntegral(default_flat(offset + j));
+        }
+      }
+    }
+    return OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    const auto key_values = keys.flat<K>();
+    const int64_t num_elements = key_values.size();
+    const auto value_matrix = values.shaped<V, 2>({num_elements, value_dim_});
+    for (int64_t i = 0; i < num_elements; ++i) {
+      const K k = SubtleMustCopyIfIntegral(key_values(i));
+      const uint64 hash = HashKey(k);
+      Shard& shard = shards_[ShardIndex(hash)];
+      mutex_lock l(shard.mu);
+      BeginWrite(&shard);
+      InsertInShard(&shard, hash, k,
+                    value_dim_ > 0 ? &value_matrix(i, 0) : nullptr);
+      EndWrite(&shard);
+    }
+    return OkStatus();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    const auto key_values = keys.flat<K>();
+    for (int64_t i = 0; i < key_values.size(); ++i) {
+      const K k = SubtleMustCopyIfIntegral(key_values(i));
+      const uint64 hash = HashKey(k);
+      Shard& shard = shards_[ShardIndex(hash)];
+      mutex_lock l(shard.mu);
+      BucketArray* buckets = shard.buckets.load(std::memory_order_relaxed);
+      const int64_t index = buckets->Find(hash, k);
+      if (index < 0) continue;
+      BeginWrite(&shard);
+      buckets->states[index].store(kDeleted, std::memory_order_relaxed);
+      shard.num_entries.fetch_sub(1, std::memory_order_relaxed);
+      EndWrite(&shard);
+    }
+    return OkStatus();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      Shard& shard = shards_[i];
+      mutex_lock l(shard.mu);
+      BeginWrite(&shard);
+      ClearShard(&shard);
+      EndWrite(&shard);
+    }
+    return Insert(ctx, keys, values);
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    std::vector<mutex_lock> locks = LockAllShards();
+    const int64_t size = this->size();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({size, value_dim_}), &values));
+    ExportKeysAndValues(keys, values);
+    return OkStatus();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64_t MemoryUsed() const override {
+    int64_t ret = sizeof(ShardedMutableHashTable) + num_shards_ * sizeof(Shard);
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      const Shard& shard = shards_[i];
+      tf_shared_lock l(shard.mu);
+      for (const auto& buckets : shard.bucket_arrays) {
+        ret += buckets->capacity *
+               (sizeof(uint8) + sizeof(K) + value_dim_ * sizeof(V));
+      }
+    }
+    return ret;
+  }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override {
+    std::vector<mutex_lock> locks = LockAllShards();
+    const int64_t size = this->size();
+    Tensor keys(key_dtype(), TensorShape({size}));
+    Tensor values(value_dtype(), TensorShape({size, value_dim_}));
+    ExportKeysAndValues(&keys, &values);
+
+    // See `MutableHashTableOfTensors::AsGraphDef()` for why the node name is
+    // used for sharing.
+    Node* table =
+        ops::SourceOp("ShardedMutableHashTable",
+                      builder->opts()
+                          .WithName(UniqueNodeName("ShardedMutableHashTable"))
+                          .WithAttr("use_node_name_sharing", true)
+                          .WithAttr("key_dtype", key_dtype())
+                          .WithAttr("value_dtype", value_dtype())
+                          .WithAttr("value_shape", value_shape_)
+                          .WithAttr("num_shards", num_shards_));
+    Node* keys_node = ops::SourceOp(
+        "Const",
+        builder->opts().WithAttr("dtype", key_dtype()).WithAttr("value", keys));
+    Node* values_node =
+        ops::SourceOp("Const", builder->opts()
+                                   .WithAttr("dtype", value_dtype())
+                                   .WithAttr("value", values));
+    Node* import_table =
+        ops::TernaryOp("LookupTableImportV2", table, keys_node, values_node,
+                       builder->opts()
+                           .WithAttr("Tin", key_dtype())
+                           .WithAttr("Tout", value_dtype()));
+    *out = ops::UnaryOp("Identity", table,
+                        builder->opts().WithControlInput(import_table));
+    return OkStatus();
+  }
+
+ private:
+  // Bucket states.
+  static constexpr uint8 kEmpty = 0;
+  static constexpr uint8 kFull = 1;
+  static constexpr uint8 kDeleted = 2;
+
+  // Capacity of the bucket array of each shard when the table is created.
+  // Must be a power of 2.
+  static constexpr int64_t kInitialCapacity = 32;
+
+  // An open addressing hash table with linear probing. The capacity is a power
+  // of 2, and bucket `i` holds `values[i * value_dim, (i + 1) * value_dim)`.
+  struct BucketArray {
+    BucketArray(int64_t capacity, int64_t value_dim)
+        : capacity(capacity),
+          value_dim(value_dim),
+          states(new std::atomic<uint8>[capacity]()),
+          keys(new std::atomic<K>[capacity]()),
+          values(new std::atomic<V>[capacity * value_dim]()) {}
+
+    // Returns the index of the full bucket holding `key`, or -1 if there is
+    // none. The probe sequence is bounded by the capacity, so that lookups
+    // terminate even if they race with a writer.
+    int64_t Find(uint64 hash, K key) const {
+      const int64_t mask = capacity - 1;
+      int64_t index = hash & mask;
+      for (int64_t i = 0; i < capacity; ++i, index = (index + 1) & mask) {
+        const uint8 state = states[index].load(std::memory_order_relaxed);
+        if (state == kEmpty) return -1;
+        if (state == kFull &&
+            keys[index].load(std::memory_order_relaxed) == key) {
+          return index;
+        }
+      }
+      return -1;
+    }
+
+    const int64_t capacity;
+    const int64_t value_dim;
+    std::unique_ptr<std::atomic<uint8>[]> states;
+    std::unique_ptr<std::atomic<K>[]> keys;
+    std::unique_ptr<std::atomic<V>[]> values;
+  };
+
+  // Aligned to avoid false sharing between the sequence numbers of different
+  // shards.
+  struct alignas(64) Shard {
+    mutable mutex mu;
+    // Odd while a writer modifies the shard.
+    std::atomic<uint64> sequence{0};
+    // The current bucket array, one of `bucket_arrays`.
+    std::atomic<BucketArray*> buckets{nullptr};
+    // Number of full buckets. Only modified while holding `mu`.
+    std::atomic<int64_t> num_entries{0};
+    // Number of full or deleted buckets.
+    int64_t num_used TF_GUARDED_BY(mu) = 0;
+    // The current bucket array and all the arrays it replaced.
+    std::vector<std::unique_ptr<BucketArray>> bucket_arrays TF_GUARDED_BY(mu);
+  };
+
+  static uint64 HashKey(K key) {
+    // The finalizer of MurmurHash3, so that keys with regular patterns spread
+    // over shards and buckets.
+    uint64 x = static_cast<uint64>(key);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  // The low bits of the hash select the bucket.
+  int64_t ShardIndex(uint64 hash) const { return (hash >> 32) % num_shards_; }
+
+  static void BeginWrite(Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->sequence.store(shard->sequence.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  static void EndWrite(Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    shard->sequence.store(shard->sequence.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_release);
+  }
+
+  // Copies the value of `key` to `value` and returns true, or returns false if
+  // `shard` does not contain `key`. Does not acquire `shard->mu` unless a
+  // writer is modifying the shard.
+  bool FindInShard(Shard* shard, uint64 hash, K key, V* value) const {
+    while (true) {
+      const uint64 sequence = shard->sequence.load(std::memory_order_acquire);
+      if (sequence & 1) {
+        // Wait for the writer instead of spinning, since it may be resizing
+        // the shard.
+        mutex_lock l(shard->mu);
+        continue;
+      }
+      const BucketArray* buckets =
+          shard->buckets.load(std::memory_order_acquire);
+      const int64_t index = buckets->Find(hash, key);
+      if (index >= 0) {
+        const std::atomic<V>* bucket_values =
+            &buckets->values[index * value_dim_];
+        for (int64_t j = 0; j < value_dim_; ++j) {
+          value[j] = bucket_values[j].load(std::memory_order_relaxed);
+        }
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (shard->sequence.load(std::memory_order_relaxed) == sequence) {
+        return index >= 0;
+      }
+    }
+  }
+
+  void InsertInShard(Shard* shard, uint64 hash, K key, const V* value)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    BucketArray* buckets = shard->buckets.load(std::memory_order_relaxed);
+    // Keep the load factor, including deleted buckets, at most 3/4, and grow
+    // the shard if more than half of its buckets are full.
+    if (4 * (shard->num_used + 1) > 3 * buckets->capacity) {
+      const int64_t num_entries =
+          shard->num_entries.load(std::memory_order_relaxed);
+      buckets = Rehash(shard, 2 * (num_entries + 1) > buckets->capacity
+                                  ? 2 * buckets->capacity
+                                  : buckets->capacity);
+    }
+    const int64_t mask = buckets->capacity - 1;
+    int64_t index = hash & mask;
+    int64_t target = -1;
+    while (true) {
+      const uint8 state =
+          buckets->states[index].load(std::memory_order_relaxed);
+      if (state == kEmpty) break;
+      if (state == kDeleted) {
+        if (target < 0) target = index;
+      } else if (buckets->keys[index].load(std::memory_order_relaxed) == key) {
+        StoreValue(buckets, index, value);
+        return;
+      }
+      index = (index + 1) & mask;
+    }
+    if (target < 0) {
+      target = index;
+      ++shard->num_used;
+    }
+    buckets->keys[target].store(key, std::memory_order_relaxed);
+    StoreValue(buckets, target, value);
+    buckets->states[target].store(kFull, std::memory_order_relaxed);
+    shard->num_entries.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void StoreValue(BucketArray* buckets, int64_t index, const V* value) const {
+    std::atomic<V>* bucket_values = &buckets->values[index * value_dim_];
+    for (int64_t j = 0; j < value_dim_; ++j) {
+      bucket_values[j].store(value[j], std::memory_order_relaxed);
+    }
+  }
+
+  // Moves the entries of `shard` to a bucket array of `capacity` buckets, and
+  // returns it. If the capacity does not change, the current array is reused,
+  // which drops its deleted buckets.
+  BucketArray* Rehash(Shard* shard, int64_t capacity)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    BucketArray* buckets = shard->buckets.load(std::memory_order_relaxed);
+    std::vector<K> keys;
+    std::vector<V> values;
+    for (int64_t i = 0; i < buckets->capacity; ++i) {
+      if (buckets->states[i].load(std::memory_order_relaxed) != kFull) continue;
+      keys.push_back(buckets->keys[i].load(std::memory_order_relaxed));
+      for (int64_t j = 0; j < value_dim_; ++j) {
+        values.push_back(buckets->values[i * value_dim_ + j].load(
+            std::memory_order_relaxed));
+      }
+    }
+
+    if (capacity == buckets->capacity) {
+      for (int64_t i = 0; i < buckets->capacity; ++i) {
+        buckets->states[i].store(kEmpty, std::memory_order_relaxed);
+      }
+    } else {
+      shard->bucket_arrays.emplace_back(new BucketArray(capacity, value_dim_));
+      buckets = shard->bucket_arrays.back().get();
+    }
+    const int64_t mask = buckets->capacity - 1;
+    for (int64_t i = 0; i < keys.size(); ++i) {
+      int64_t index = HashKey(keys[i]) & mask;
+      while (buckets->states[index].load(std::memory_order_relaxed) != kEmpty) {
+        index = (index + 1) & mask;
+      }
+      buckets->keys[index].store(keys[i], std::memory_order_relaxed);
+      StoreValue(buckets, index, values.data() + i * value_dim_);
+      buckets->states[index].store(kFull, std::memory_order_relaxed);
+    }
+    shard->num_used = keys.size();
+    shard->buckets.store(buckets, std::memory_order_release);
+    return buckets;
+  }
+
+  void ClearShard(Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu) {
+    BucketArray* buckets = shard->buckets.load(std::memory_order_relaxed);
+    for (int64_t i = 0; i < buckets->capacity; ++i) {
+      buckets->states[i].store(kEmpty, std::memory_order_relaxed);
+    }
+    shard->num_used = 0;
+    shard->num_entries.store(0, std::memory_order_relaxed);
+  }
+
+  std::vector<mutex_lock> LockAllShards() const {
+    std::vector<mutex_lock> locks;
+    locks.reserve(num_shards_);
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      locks.emplace_back(shards_[i].mu);
+    }
+    return locks;
+  }
+
+  // Writes all keys and values into `keys` and `values`, which must have
+  // `size()` rows. All the shards must be locked.
+  void ExportKeysAndValues(Tensor* keys, Tensor* values) const {
+    auto keys_data = keys->flat<K>();
+    auto values_data = values->matrix<V>();
+    int64_t row = 0;
+    for (int64_t i = 0; i < num_shards_; ++i) {
+      const BucketArray* buckets =
+          shards_[i].buckets.load(std::memory_order_relaxed);
+      for (int64_t index = 0; index < buckets->capacity; ++index) {
+        if (buckets->states[index].load(std::memory_order_relaxed) != kFull) {
+          continue;
+        }
+        keys_data(row) = buckets->keys[index].load(std::memory_order_relaxed);
+        for (int64_t j = 0; j < value_dim_; ++j) {
+          values_data(row, j) = buckets->values[index * value_dim_ + j].load(
+              std::memory_order_relaxed);
+        }
+        ++row;
+      }
+    }
+  }
+
+  TensorShape value_shape_;
+  int64_t value_dim_ = 0;
+  int64_t num_shards_ = 0;
+  std::unique_ptr<Shard[]> shards_;
+};
+
 }  // namespace lookup
 
 // Base class for kernels that take a LookupTable handle as the 0th input.
@@ -1201,6 +1651,34 @@ REGISTER_KERNEL(tstring, int64_t);
 
 #undef REGISTER_KERNEL
 
+// Register the ShardedMutableHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("ShardedMutableHashTable")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::ShardedMutableHashTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)                                 \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("AnonymousShardedMutableHashTable")                               \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      AnonymousLookupTableOp<                                                \
+          lookup::ShardedMutableHashTable<key_dtype, value_dtype>,           \
+          key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int32, double);
+REGISTER_KERNEL(int32, float);
+REGISTER_KERNEL(int32, int32);
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableDenseHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                             \
   REGISTER_KERNEL_BUILDER(                                                  \
@@ -226,6 +226,98 @@ struct SequentialMatMulKernel {
     }
   }
 };
+
+// Batch matmul kernel for small real matrices, which are too small to amortize
+// the packing and dispatch of the Eigen matrix products. Each row of the
+// output is accumulated as a linear combination of the rows of y, with the
+// number of columns known at compile time for common sizes, so that the row
+// stays in registers.
+template <typename Scalar>
+struct SmallMatMulKernel {
+  static constexpr bool kSupported =
+      std::is_same<Scalar, float>::value || std::is_same<Scalar, double>::value;
+
+  // Matrices with all dimensions at most this large are considered small.
+  static constexpr int64_t kMaxDim = 64;
+
+  using Matrix = typename SequentialMatMulKernel<Scalar>::Matrix;
+
+  static bool IsSmall(int64_t m, int64_t k, int64_t n) {
+    return m <= kMaxDim && k <= kMaxDim && n <= kMaxDim && k > 0;
+  }
+
+  // Computes the m x n matrix z = x * y, where x(i, l) is
+  // `x[i * x_row_stride + l * x_col_stride]` and y is a row-major k x n
+  // matrix. `N` is either n or Eigen::Dynamic.
+  template <int N>
+  static void MatMul(const Scalar* x, int64_t x_row_stride,
+                     int64_t x_col_stride, const Scalar* y, int64_t m,
+                     int64_t k, int64_t n, Scalar* z) {
+    using Row = Eigen::Array<Scalar, 1, N>;
+    for (int64_t i = 0; i < m; ++i) {
+      const Scalar* x_row = x + i * x_row_stride;
+      Row z_row = x_row[0] * Eigen::Map<const Row>(y, n);
+      for (int64_t l = 1; l < k; ++l) {
+        z_row += x_row[l * x_col_stride] * Eigen::Map<const Row>(y + l * n, n);
+      }
+      Eigen::Map<Row>(z + i * n, n) = z_row;
+    }
+  }
+
+  static void Run(const Tensor& in_x, const Tensor& in_y, bool adj_x,
+                  bool adj_y, bool trans_x, bool trans_y,
+                  const MatMulBCast& bcast, Tensor* out, int start, int limit) {
+    const bool should_bcast = bcast.IsBroadcastingRequired();
+    const auto& x_batch_indices = bcast.x_batch_indices();
+    const auto& y_batch_indices = bcast.y_batch_indices();
+    const bool transpose_x = adj_x || trans_x;
+    const bool transpose_y = adj_y || trans_y;
+    const int64_t m = out->dim_size(1);
+    const int64_t n = out->dim_size(2);
+    const int64_t k = transpose_x ? in_x.dim_size(1) : in_x.dim_size(2);
+    const int64_t x_row_stride = transpose_x ? 1 : k;
+    const int64_t x_col_stride = transpose_x ? m : 1;
+
+    auto* matmul = &MatMul<Eigen::Dynamic>;
+    switch (n) {
+      case 4:
+        matmul = &MatMul<4>;
+        break;
+      case 8:
+        matmul = &MatMul<8>;
+        break;
+      case 16:
+        matmul = &MatMul<16>;
+        break;
+      case 32:
+        matmul = &MatMul<32>;
+        break;
+      case 64:
+        matmul = &MatMul<64>;
+        break;
+    }
+
+    // A transposed y is copied to row-major order first.
+    Matrix y_buffer(transpose_y ? k : 0, transpose_y ? n : 0);
+    const Scalar* x_base = in_x.flat<Scalar>().data();
+    const Scalar* y_base = in_y.flat<Scalar>().data();
+    Scalar* z_base = out->flat<Scalar>().data();
+    for (int64_t i = start; i < limit; ++i) {
+      const int64_t x_batch_index = should_bcast ? x_batch_indices[i] : i;
+      const int64_t y_batch_index = should_bcast ? y_batch_indices[i] : i;
+      const Scalar* y = y_base + y_batch_index * k * n;
+      if (transpose_y) {
+        y_buffer.noalias() =
+            SequentialMatMulKernel<Scalar>::ConstTensorSliceToEigenMatrix(
+                in_y, y_batch_index)
+                .transpose();
+        y = y_buffer.data();
+      }
+      matmul(x_base + x_batch_index * m * k, x_row_stride, x_col_stride, y, m,
+             k, n, z_base + i * m * n);
+    }
+  }
+};
 }  // namespace
 
 template <typename Device, typename Scalar>
@@ -250,6 +342,23 @@ struct LaunchBatchMatMul<CPUDevice, Scalar> {
     // Jan 21, 2020.
     const int64_t kMaxCostOuterParallelism = 128 * 128;  // heuristic.
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    if constexpr (SmallMatMulKernel<Scalar>::kSupported) {
+      const int64_t k = adj_x || trans_x ? in_x.dim_size(1) : in_x.dim_size(2);
+      if (batch_size > 1 && SmallMatMulKernel<Scalar>::IsSmall(
+                                out->dim_size(1), k, out->dim_size(2))) {
+        // Parallelize over outer dims, without the overhead of an Eigen matrix
+        // product for every small matrix.
+        Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+              cost_per_unit,
+              [&in_x, &in_y, adj_x, adj_y, trans_x, trans_y, &bcast, out](
+                  int start, int limit) {
+                SmallMatMulKernel<Scalar>::Run(in_x, in_y, adj_x, adj_y,
+                                               trans_x, trans_y, bcast, out,
+                                               start, limit);
+              });
+        return;
+      }
+    }
     // TODO(rmlarsen): Reconsider the heuristics now that we have asynchronous
     // evaluation in Eigen Tensor.
     if (small_dim > 1 &&
@@ -0,0 +1,511 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/memmapped_lookup_table.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/lookup_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/refcount.h"
+
+namespace tensorflow {
+namespace lookup {
+
+uint64 MemmappedLookupTableHash(int64_t key) {
+  return Hash64(reinterpret_cast<const char*>(&key), sizeof(key));
+}
+
+uint64 MemmappedLookupTableHash(StringPiece key) {
+  return Hash64(key.data(), key.size());
+}
+
+namespace {
+
+// Keys and values of a table to write, as arrays of `num_entries` elements.
+struct TableContents {
+  DataType key_dtype;
+  DataType value_dtype;
+  int64_t num_entries = 0;
+  // `int64_keys` is set for int64 keys, and `string_keys` for string keys.
+  const int64_t* int64_keys = nullptr;
+  const tstring* string_keys = nullptr;
+  // The values in their in-memory representation.
+  StringPiece value_bytes;
+};
+
+uint64 AlignOffset(uint64 offset) {
+  return (offset + kMemmappedLookupTableAlignment - 1) /
+         kMemmappedLookupTableAlignment * kMemmappedLookupTableAlignment;
+}
+
+bool IsSupportedKeyType(DataType dtype) {
+  return dtype == DT_INT64 || dtype == DT_STRING;
+}
+
+bool IsSupportedValueType(DataType dtype) {
+  return dtype == DT_INT32 || dtype == DT_INT64 || dtype == DT_FLOAT ||
+         dtype == DT_DOUBLE;
+}
+
+// Appends to a file while keeping track of the current offset.
+class SectionWriter {
+ public:
+  explicit SectionWriter(WritableFile* file) : file_(file) {}
+
+  Status Append(StringPiece data) {
+    offset_ += data.size();
+    return file_->Append(data);
+  }
+
+  template <typename T>
+  Status AppendArray(const T* data, size_t num_elements) {
+    return Append(StringPiece(reinterpret_cast<const char*>(data),
+                              num_elements * sizeof(T)));
+  }
+
+  // Pads the file with zeros up to `offset`.
+  Status PadTo(uint64 offset) {
+    DCHECK_GE(offset, offset_);
+    return Append(string(offset - offset_, '\0'));
+  }
+
+ private:
+  WritableFile* const file_;
+  uint64 offset_ = 0;
+};
+
+Status WriteTable(Env* env, const string& filename,
+                  const TableContents& contents) {
+  const int64_t num_entries = contents.num_entries;
+  const bool string_keys = contents.key_dtype == DT_STRING;
+  auto hash_at = [&contents](int64_t i) {
+    return contents.string_keys != nullptr
+               ? MemmappedLookupTableHash(StringPiece(contents.string_keys[i]))
+               : MemmappedLookupTableHash(contents.int64_keys[i]);
+  };
+  auto same_key = [&contents](int64_t i, int64_t j) {
+    return contents.string_keys != nullptr
+               ? contents.string_keys[i] == contents.string_keys[j]
+               : contents.int64_keys[i] == contents.int64_keys[j];
+  };
+
+  // Keep the load factor at most 3/4, so that probe sequences stay short.
+  uint64 num_buckets = 16;
+  while (4 * static_cast<uint64>(num_entries) > 3 * num_buckets) {
+    num_buckets *= 2;
+  }
+  const uint64 mask = num_buckets - 1;
+  std::vector<MemmappedLookupTableBucket> buckets(num_buckets, {0, 0});
+  for (int64_t i = 0; i < num_entries; ++i) {
+    const uint64 hash = hash_at(i);
+    uint64 index = hash & mask;
+    while (buckets[index].entry != 0) {
+      if (buckets[index].hash == hash &&
+          same_key(buckets[index].entry - 1, i)) {
+        return errors::InvalidArgument("Duplicate key at index ", i,
+                                       " of the table written to ", filename);
+      }
+      index = (index + 1) & mask;
+    }
+    buckets[index] = {hash, static_cast<uint64>(i + 1)};
+  }
+
+  std::vector<uint64> string_offsets;
+  uint64 strings_size = 0;
+  if (string_keys) {
+    string_offsets.reserve(num_entries + 1);
+    for (int64_t i = 0; i < num_entries; ++i) {
+      string_offsets.push_back(strings_size);
+      strings_size += contents.string_keys[i].size();
+    }
+    string_offsets.push_back(strings_size);
+  }
+
+  MemmappedLookupTableHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMemmappedLookupTableMagic, sizeof(header.magic));
+  header.version = kMemmappedLookupTableVersion;
+  header.key_dtype = contents.key_dtype;
+  header.value_dtype = contents.value_dtype;
+  header.num_entries = num_entries;
+  header.num_buckets = num_buckets;
+  header.buckets_offset = AlignOffset(sizeof(header));
+  header.keys_offset = AlignOffset(
+      header.buckets_offset + num_buckets * sizeof(MemmappedLookupTableBucket));
+  const uint64 keys_size = string_keys
+                               ? string_offsets.size() * sizeof(uint64)
+                               : num_entries * sizeof(int64_t);
+  header.values_offset = AlignOffset(header.keys_offset + keys_size);
+  header.strings_offset =
+      AlignOffset(header.values_offset + contents.value_bytes.size());
+  header.strings_size = strings_size;
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  SectionWriter writer(file.get());
+  TF_RETURN_IF_ERROR(writer.AppendArray(&header, 1));
+  TF_RETURN_IF_ERROR(writer.PadTo(header.buckets_offset));
+  TF_RETURN_IF_ERROR(writer.AppendArray(buckets.data(), buckets.size()));
+  TF_RETURN_IF_ERROR(writer.PadTo(header.keys_offset));
+  if (string_keys) {
+    TF_RETURN_IF_ERROR(
+        writer.AppendArray(string_offsets.data(), string_offsets.size()));
+  } else {
+    TF_RETURN_IF_ERROR(writer.AppendArray(contents.int64_keys, num_entries));
+  }
+  TF_RETURN_IF_ERROR(writer.PadTo(header.values_offset));
+  TF_RETURN_IF_ERROR(writer.Append(contents.value_bytes));
+  TF_RETURN_IF_ERROR(writer.PadTo(header.strings_offset));
+  for (int64_t i = 0; string_keys && i < num_entries; ++i) {
+    TF_RETURN_IF_ERROR(writer.Append(contents.string_keys[i]));
+  }
+  return file->Close();
+}
+
+// Collects the entries produced by `InitializeTableFromTextFile()`.
+class EntryCollector : public InitializableLookupTable {
+ public:
+  EntryCollector(DataType key_dtype, DataType value_dtype)
+      : key_dtype_(key_dtype), value_dtype_(value_dtype) {}
+
+  size_t size() const override { return num_entries_; }
+
+  DataType key_dtype() const override { return key_dtype_; }
+
+  DataType value_dtype() const override { return value_dtype_; }
+
+  TableContents contents() const {
+    TableContents contents;
+    contents.key_dtype = key_dtype_;
+    contents.value_dtype = value_dtype_;
+    contents.num_entries = num_entries_;
+    if (key_dtype_ == DT_STRING) {
+      contents.string_keys = string_keys_.data();
+    } else {
+      contents.int64_keys = int64_keys_.data();
+    }
+    contents.value_bytes = value_bytes_;
+    return contents;
+  }
+
+ protected:
+  Status DoPrepare(size_t expected_num_elements) override {
+    return OkStatus();
+  }
+
+  // Avoids reading the whole file to count its lines.
+  Status DoLazyPrepare(
+      std::function<int64_t(void)> get_expected_num_elements) override {
+    return OkStatus();
+  }
+
+  Status DoInsert(const Tensor& keys, const Tensor& values) override {
+    if (key_dtype_ == DT_STRING) {
+      const auto key_values = keys.flat<tstring>();
+      string_keys_.insert(string_keys_.end(), key_values.data(),
+                          key_values.data() + key_values.size());
+    } else {
+      const auto key_values = keys.flat<int64_t>();
+      int64_keys_.insert(int64_keys_.end(), key_values.data(),
+                         key_values.data() + key_values.size());
+    }
+    const StringPiece value_data = values.tensor_data();
+    value_bytes_.append(value_data.data(), value_data.size());
+    num_entries_ += keys.NumElements();
+    return OkStatus();
+  }
+
+  Status DoFind(const Tensor& keys, Tensor* values,
+                const Tensor& default_value) override {
+    return errors::Unimplemented("Find not supported by EntryCollector");
+  }
+
+ private:
+  const DataType key_dtype_;
+  const DataType value_dtype_;
+  int64_t num_entries_ = 0;
+  std::vector<int64_t> int64_keys_;
+  std::vector<tstring> string_keys_;
+  string value_bytes_;
+};
+
+Status CheckTypes(DataType key_dtype, DataType value_dtype) {
+  if (!IsSupportedKeyType(key_dtype)) {
+    return errors::InvalidArgument("Unsupported key type ",
+                                   DataTypeString(key_dtype),
+                                   ", expected int64 or string");
+  }
+  if (!IsSupportedValueType(value_dtype)) {
+    return errors::InvalidArgument(
+        "Unsupported value type ", DataTypeString(value_dtype),
+        ", expected int32, int64, float or double");
+  }
+  return OkStatus();
+}
+
+void SetKey(StringPiece view, tstring* key) {
+  key->assign(view.data(), view.size());
+}
+
+void SetKey(int64_t view, int64_t* key) { *key = view; }
+
+}  // namespace
+
+Status WriteMemmappedLookupTable(Env* env, const string& filename,
+                                 const Tensor& keys, const Tensor& values) {
+  TF_RETURN_IF_ERROR(CheckTypes(keys.dtype(), values.dtype()));
+  if (keys.dims() != 1 || keys.shape() != values.shape()) {
+    return errors::InvalidArgument(
+        "Keys and values must be vectors of the same size, got shapes ",
+        keys.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+  TableContents contents;
+  contents.key_dtype = keys.dtype();
+  contents.value_dtype = values.dtype();
+  contents.num_entries = keys.NumElements();
+  if (keys.dtype() == DT_STRING) {
+    contents.string_keys = keys.flat<tstring>().data();
+  } else {
+    contents.int64_keys = keys.flat<int64_t>().data();
+  }
+  contents.value_bytes = values.tensor_data();
+  return WriteTable(env, filename, contents);
+}
+
+Status WriteMemmappedLookupTableFromTextFile(
+    Env* env, const string& filename, int64_t vocab_size, char delimiter,
+    int32_t key_index, int32_t value_index, int64_t offset,
+    DataType key_dtype, DataType value_dtype, const string& output) {
+  TF_RETURN_IF_ERROR(CheckTypes(key_dtype, value_dtype));
+  core::RefCountPtr<EntryCollector> collector(
+      new EntryCollector(key_dtype, value_dtype));
+  TF_RETURN_IF_ERROR(InitializeTableFromTextFile(filename, vocab_size,
+                                                 delimiter, key_index,
+                                                 value_index, offset, env,
+                                                 collector.get()));
+  return WriteTable(env, output, collector->contents());
+}
+
+template <class K, class V>
+MemmappedLookupTable<K, V>::MemmappedLookupTable(OpKernelContext* ctx,
+                                                 OpKernel* kernel) {
+  OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "filename", &filename_));
+  OP_REQUIRES_OK(ctx, Open(ctx->env()));
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::Open(Env* env) {
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(filename_, &region_));
+  const uint64 file_size = region_->length();
+  const char* data = static_cast<const char*>(region_->data());
+  if (file_size < sizeof(MemmappedLookupTableHeader) ||
+      std::memcmp(data, kMemmappedLookupTableMagic,
+                  sizeof(kMemmappedLookupTableMagic)) != 0) {
+    return errors::InvalidArgument(filename_,
+                                   " is not a memmapped lookup table");
+  }
+  const auto* header =
+      reinterpret_cast<const MemmappedLookupTableHeader*>(data);
+  if (header->version != kMemmappedLookupTableVersion) {
+    return errors::InvalidArgument(
+        "Unsupported version ", header->version, " of memmapped lookup table ",
+        filename_, ", expected ", kMemmappedLookupTableVersion,
+        ". The table may have been written on a machine with a different byte "
+        "order.");
+  }
+  if (header->key_dtype != key_dtype() ||
+      header->value_dtype != value_dtype()) {
+    return errors::InvalidArgument(
+        "Memmapped lookup table ", filename_, " maps ",
+        DataTypeString(static_cast<DataType>(header->key_dtype)), " to ",
+        DataTypeString(static_cast<DataType>(header->value_dtype)),
+        ", expected ", DataTypeString(key_dtype()), " to ",
+        DataTypeString(value_dtype()));
+  }
+
+  // Checks that `num_elements` elements of `element_size` bytes at `offset`
+  // are within the file and aligned, without overflowing.
+  auto check_section = [&](const char* name, uint64 offset,
+                           uint64 num_elements, uint64 element_size) {
+    if (offset % kMemmappedLookupTableAlignment != 0 || offset > file_size ||
+        num_elements > (file_size - offset) / element_size) {
+      return errors::DataLoss("Invalid ", name,
+                              " section in memmapped lookup table ",
+                              filename_);
+    }
+    return OkStatus();
+  };
+  const uint64 num_buckets = header->num_buckets;
+  const uint64 num_entries = header->num_entries;
+  if (num_buckets == 0 || (num_buckets & (num_buckets - 1)) != 0 ||
+      num_entries >= num_buckets) {
+    return errors::DataLoss("Invalid number of buckets ", num_buckets,
+                            " for ", num_entries,
+                            " entries in memmapped lookup table ", filename_);
+  }
+  TF_RETURN_IF_ERROR(check_section("buckets", header->buckets_offset,
+                                   num_buckets,
+                                   sizeof(MemmappedLookupTableBucket)));
+  if (std::is_same<K, tstring>::value) {
+    TF_RETURN_IF_ERROR(check_section("keys", header->keys_offset,
+                                     num_entries + 1, sizeof(uint64)));
+    TF_RETURN_IF_ERROR(check_section("strings", header->strings_offset,
+                                     header->strings_size, 1));
+  } else {
+    TF_RETURN_IF_ERROR(check_section("keys", header->keys_offset, num_entries,
+                                     sizeof(int64_t)));
+  }
+  TF_RETURN_IF_ERROR(
+      check_section("values", header->values_offset, num_entries, sizeof(V)));
+
+  header_ = header;
+  buckets_ = reinterpret_cast<const MemmappedLookupTableBucket*>(
+      data + header->buckets_offset);
+  keys_ = data + header->keys_offset;
+  values_ = reinterpret_cast<const V*>(data + header->values_offset);
+  strings_ = data + header->strings_offset;
+  return OkStatus();
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::GetKey(uint64 entry, KeyView* key) const {
+  if (entry >= header_->num_entries) {
+    return errors::DataLoss("Invalid entry ", entry,
+                            " in memmapped lookup table ", filename_);
+  }
+  if constexpr (std::is_same<K, tstring>::value) {
+    const uint64* offsets = static_cast<const uint64*>(keys_);
+    const uint64 begin = offsets[entry];
+    const uint64 end = offsets[entry + 1];
+    if (begin > end || end > header_->strings_size) {
+      return errors::DataLoss("Invalid key of entry ", entry,
+                              " in memmapped lookup table ", filename_);
+    }
+    *key = StringPiece(strings_ + begin, end - begin);
+  } else {
+    *key = static_cast<const int64_t*>(keys_)[entry];
+  }
+  return OkStatus();
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::FindEntry(KeyView key,
+                                             int64_t* entry) const {
+  const uint64 hash = MemmappedLookupTableHash(key);
+  const uint64 num_buckets = header_->num_buckets;
+  const uint64 mask = num_buckets - 1;
+  uint64 index = hash & mask;
+  // The probe sequence is bounded in case the file is corrupted.
+  for (uint64 i = 0; i < num_buckets; ++i, index = (index + 1) & mask) {
+    const MemmappedLookupTableBucket& bucket = buckets_[index];
+    if (bucket.entry == 0) break;
+    if (bucket.hash != hash) continue;
+    KeyView bucket_key;
+    TF_RETURN_IF_ERROR(GetKey(bucket.entry - 1, &bucket_key));
+    if (bucket_key == key) {
+      *entry = bucket.entry - 1;
+      return OkStatus();
+    }
+  }
+  *entry = -1;
+  return OkStatus();
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::Find(OpKernelContext* ctx,
+                                        const Tensor& keys, Tensor* values,
+                                        const Tensor& default_value) {
+  const auto key_values = keys.flat<K>();
+  auto value_values = values->flat<V>();
+  const auto default_flat = default_value.flat<V>();
+  const bool is_full_size_default = default_flat.size() == key_values.size();
+  for (int64_t i = 0; i < key_values.size(); ++i) {
+    int64_t entry;
+    TF_RETURN_IF_ERROR(
+        FindEntry(SubtleMustCopyIfIntegral(key_values(i)), &entry));
+    value_values(i) = entry >= 0 ? values_[entry]
+                                 : default_flat(is_full_size_default ? i : 0);
+  }
+  return OkStatus();
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::ExportValues(OpKernelContext* ctx) {
+  const int64_t size = this->size();
+  Tensor* keys;
+  Tensor* values;
+  TF_RETURN_IF_ERROR(ctx->allocate_output("keys", TensorShape({size}), &keys));
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output("values", TensorShape({size}), &values));
+  auto keys_data = keys->flat<K>();
+  auto values_data = values->flat<V>();
+  for (int64_t i = 0; i < size; ++i) {
+    KeyView key;
+    TF_RETURN_IF_ERROR(GetKey(i, &key));
+    SetKey(key, &keys_data(i));
+    values_data(i) = values_[i];
+  }
+  return OkStatus();
+}
+
+template <class K, class V>
+Status MemmappedLookupTable<K, V>::AsGraphDef(GraphDefBuilder* builder,
+                                              Node** out) const {
+  // The table is serialized by reference to its file. See
+  // `MutableHashTableOfTensors::AsGraphDef()` for why the node name is used
+  // for sharing.
+  *out = ops::SourceOp("MemmappedHashTable",
+                       builder->opts()
+                           .WithName(UniqueNodeName("MemmappedHashTable"))
+                           .WithAttr("use_node_name_sharing", true)
+                           .WithAttr("key_dtype", key_dtype())
+                           .WithAttr("value_dtype", value_dtype())
+                           .WithAttr("filename", filename_));
+  return OkStatus();
+}
+
+}  // namespace lookup
+
+// Register the MemmappedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                           \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("MemmappedHashTable")                                          \
+          .Device(DEVICE_CPU)                                             \
+          .TypeConstraint<key_dtype>("key_dtype")                         \
+          .TypeConstraint<value_dtype>("value_dtype"),                    \
+      LookupTableOp<lookup::MemmappedLookupTable<key_dtype, value_dtype>, \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int64_t, double);
+REGISTER_KERNEL(int64_t, float);
+REGISTER_KERNEL(int64_t, int32);
+REGISTER_KERNEL(int64_t, int64_t);
+REGISTER_KERNEL(tstring, double);
+REGISTER_KERNEL(tstring, float);
+REGISTER_KERNEL(tstring, int32);
+REGISTER_KERNEL(tstring, int64_t);
+
+#undef REGISTER_KERNEL
+
+}  // namespace tensorflow
@@ -0,0 +1,174 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
+#define TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
+
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// A prebuilt hash table stored in a file, designed to be memory mapped and
+// queried without any preprocessing, so that large vocabularies load in
+// constant time and share their memory across sessions and processes through
+// the page cache.
+//
+// The file starts with a `MemmappedLookupTableHeader`, followed by sections
+// aligned to `kMemmappedLookupTableAlignment` bytes:
+//
+// * buckets: `num_buckets` `MemmappedLookupTableBucket`s, an open addressing
+//   hash table with linear probing. `num_buckets` is a power of 2.
+// * keys: for int64 keys, `num_entries` int64 values. For string keys,
+//   `num_entries + 1` uint64 offsets into the strings section, where entry `i`
+//   is `strings[offsets[i], offsets[i + 1])`.
+// * values: `num_entries` values.
+// * strings: the concatenated string keys, if any.
+//
+// All integers are in the native byte order of the machine that wrote the
+// file; files are rejected by readers with a different byte order.
+struct MemmappedLookupTableHeader {
+  char magic[8];
+  uint32 version;
+  // `DataType`s of the keys and values.
+  uint32 key_dtype;
+  uint32 value_dtype;
+  uint32 reserved;
+  uint64 num_entries;
+  uint64 num_buckets;
+  // Offsets of the sections, in bytes from the start of the file.
+  uint64 buckets_offset;
+  uint64 keys_offset;
+  uint64 values_offset;
+  uint64 strings_offset;
+  uint64 strings_size;
+};
+
+struct MemmappedLookupTableBucket {
+  // `MemmappedLookupTableHash()` of the key.
+  uint64 hash;
+  // One plus the index of the entry, or 0 if the bucket is empty.
+  uint64 entry;
+};
+
+constexpr char kMemmappedLookupTableMagic[8] = {'T', 'F', 'L', 'U',
+                                                'T', 'B', 'L', '\0'};
+constexpr uint32 kMemmappedLookupTableVersion = 1;
+constexpr uint64 kMemmappedLookupTableAlignment = 64;
+
+// Hash functions of the keys, stable across processes and releases.
+uint64 MemmappedLookupTableHash(int64_t key);
+uint64 MemmappedLookupTableHash(StringPiece key);
+
+// Writes a table mapping `keys[i]` to `values[i]` to `filename`. `keys` must be
+// a vector of int64 or strings without duplicates, and `values` a vector of
+// int32, int64, float or double of the same size.
+Status WriteMemmappedLookupTable(Env* env, const string& filename,
+                                 const Tensor& keys, const Tensor& values);
+
+// Reads a vocabulary from the text file `filename` with the same arguments as
+// `InitializeTableFromTextFile()`, and writes it as a table to `output`.
+Status WriteMemmappedLookupTableFromTextFile(
+    Env* env, const string& filename, int64_t vocab_size, char delimiter,
+    int32_t key_index, int32_t value_index, int64_t offset,
+    DataType key_dtype, DataType value_dtype, const string& output);
+
+// Read-only lookup table that serves lookups directly from a file written by
+// `WriteMemmappedLookupTable()`, mapped with
+// `Env::NewReadOnlyMemoryRegionFromFile()`. Opening the table only validates
+// the header, so its cost does not depend on the size of the table. Entries
+// are validated lazily as lookups read them, and corrupted entries make
+// lookups fail with `DataLoss`.
+template <class K, class V>
+class MemmappedLookupTable final : public LookupInterface {
+ public:
+  // Maps the file named by the `filename` attr of `kernel`.
+  MemmappedLookupTable(OpKernelContext* ctx, OpKernel* kernel);
+
+  size_t size() const override {
+    return header_ == nullptr ? 0 : header_->num_entries;
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& keys, Tensor* values,
+              const Tensor& default_value) override;
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::Unimplemented("Insert not supported by MemmappedHashTable");
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    return errors::Unimplemented("Remove not supported by MemmappedHashTable");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::Unimplemented(
+        "ImportValues not supported by MemmappedHashTable");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override;
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const override { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  // The mapped file is not counted, since it is shared through the page
+  // cache.
+  int64_t MemoryUsed() const override { return sizeof(MemmappedLookupTable); }
+
+  Status AsGraphDef(GraphDefBuilder* builder, Node** out) const override;
+
+ private:
+  // String keys are compared in place in the mapped file.
+  using KeyView = typename std::conditional<std::is_same<K, tstring>::value,
+                                            StringPiece, K>::type;
+
+  Status Open(Env* env);
+
+  // Sets `*entry` to the index of the entry of `key`, or to -1 if there is
+  // none.
+  Status FindEntry(KeyView key, int64_t* entry) const;
+
+  // Sets `*key` to the key of entry `entry`.
+  Status GetKey(uint64 entry, KeyView* key) const;
+
+  string filename_;
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const MemmappedLookupTableHeader* header_ = nullptr;
+  const MemmappedLookupTableBucket* buckets_ = nullptr;
+  // Either int64 keys, or offsets of string keys into `strings_`.
+  const void* keys_ = nullptr;
+  const V* values_ = nullptr;
+  const char* strings_ = nullptr;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_MEMMAPPED_LOOKUP_TABLE_H_
@@ -0,0 +1,171 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/memmapped_lookup_table.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/refcount.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class MemmappedLookupTableTest : public OpsTestBase {
+ protected:
+  // Runs a MemmappedHashTable op for `filename`, and sets `*table` to the
+  // table it creates.
+  Status OpenTable(const string& filename, DataType key_dtype,
+                   DataType value_dtype, lookup::LookupInterface** table) {
+    TF_RETURN_IF_ERROR(NodeDefBuilder("table", "MemmappedHashTable")
+                           .Attr("filename", filename)
+                           .Attr("key_dtype", key_dtype)
+                           .Attr("value_dtype", value_dtype)
+                           .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    TF_RETURN_IF_ERROR(RunOpKernel());
+    return LookupResource(context_.get(),
+                          GetOutput(0)->scalar<ResourceHandle>()(), table);
+  }
+
+  static string TablePath(const string& name) {
+    return io::JoinPath(testing::TmpDir(), name);
+  }
+};
+
+TEST_F(MemmappedLookupTableTest, Int64Keys) {
+  const string filename = TablePath("int64_keys");
+  TF_ASSERT_OK(lookup::WriteMemmappedLookupTable(
+      Env::Default(), filename,
+      test::AsTensor<int64_t>({3, 100, -7, int64_t{1} << 40}),
+      test::AsTensor<float>({0.5, 1.5, 2.5, 3.5})));
+
+  lookup::LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_FLOAT, &table));
+  core::ScopedUnref unref(table);
+  EXPECT_EQ(table->size(), 4);
+
+  const Tensor keys = test::AsTensor<int64_t>({100, 5, -7, int64_t{1} << 40});
+  Tensor values(DT_FLOAT, TensorShape({4}));
+  TF_ASSERT_OK(table->Find(nullptr, keys, &values, test::AsScalar<float>(-1)));
+  test::ExpectTensorEqual<float>(values,
+                                 test::AsTensor<float>({1.5, -1, 2.5, 3.5}));
+
+  // Each key may have its own default value.
+  TF_ASSERT_OK(table->Find(nullptr, keys, &values,
+                           test::AsTensor<float>({10, 20, 30, 40})));
+  test::ExpectTensorEqual<float>(values,
+                                 test::AsTensor<float>({1.5, 20, 2.5, 3.5}));
+
+  // The table is read-only.
+  EXPECT_TRUE(errors::IsUnimplemented(
+      table->Insert(nullptr, test::AsTensor<int64_t>({1}),
+                    test::AsTensor<float>({1}))));
+}
+
+TEST_F(MemmappedLookupTableTest, ManyKeys) {
+  constexpr int kNumKeys = 10000;
+  std::vector<int64_t> keys;
+  std::vector<int64_t> values;
+  for (int i = 0; i < kNumKeys; ++i) {
+    keys.push_back(i * 7919);
+    values.push_back(i);
+  }
+  const string filename = TablePath("many_keys");
+  TF_ASSERT_OK(lookup::WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<int64_t>(keys),
+      test::AsTensor<int64_t>(values)));
+
+  lookup::LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_INT64, DT_INT64, &table));
+  core::ScopedUnref unref(table);
+  Tensor found(DT_INT64, TensorShape({kNumKeys}));
+  TF_ASSERT_OK(table->Find(nullptr, test::AsTensor<int64_t>(keys), &found,
+                           test::AsScalar<int64_t>(-1)));
+  test::ExpectTensorEqual<int64_t>(found, test::AsTensor<int64_t>(values));
+}
+
+TEST_F(MemmappedLookupTableTest, StringKeysFromTextFile) {
+  const string vocab_file = TablePath("vocab.txt");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), vocab_file,
+                                 "a\nbb\n\xe2\x82\xac\nccc\n"));
+  const string filename = TablePath("string_keys");
+  TF_ASSERT_OK(lookup::WriteMemmappedLookupTableFromTextFile(
+      Env::Default(), vocab_file, /*vocab_size=*/-1, /*delimiter=*/'\t',
+      /*key_index=*/-2, /*value_index=*/-1, /*offset=*/0, DT_STRING, DT_INT64,
+      filename));
+
+  lookup::LookupInterface* table;
+  TF_ASSERT_OK(OpenTable(filename, DT_STRING, DT_INT64, &table));
+  core::ScopedUnref unref(table);
+  EXPECT_EQ(table->size(), 4);
+  Tensor values(DT_INT64, TensorShape({5}));
+  TF_ASSERT_OK(table->Find(
+      nullptr, test::AsTensor<tstring>({"ccc", "a", "", "\xe2\x82\xac", "b"}),
+      &values, test::AsScalar<int64_t>(-1)));
+  test::ExpectTensorEqual<int64_t>(values,
+                                   test::AsTensor<int64_t>({3, 0, -1, 2, -1}));
+}
+
+TEST_F(MemmappedLookupTableTest, DuplicateKeys) {
+  EXPECT_TRUE(errors::IsInvalidArgument(lookup::WriteMemmappedLookupTable(
+      Env::Default(), TablePath("duplicate_keys"),
+      test::AsTensor<tstring>({"a", "b", "a"}),
+      test::AsTensor<int64_t>({0, 1, 2}))));
+}
+
+TEST_F(MemmappedLookupTableTest, WrongTypes) {
+  const string filename = TablePath("wrong_types");
+  TF_ASSERT_OK(lookup::WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<int64_t>({1}),
+      test::AsTensor<int32>({2})));
+  lookup::LookupInterface* table;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      OpenTable(filename, DT_INT64, DT_FLOAT, &table)));
+}
+
+TEST_F(MemmappedLookupTableTest, InvalidFile) {
+  const string filename = TablePath("invalid_file");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "not a table"));
+  lookup::LookupInterface* table;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      OpenTable(filename, DT_INT64, DT_INT64, &table)));
+}
+
+TEST_F(MemmappedLookupTableTest, TruncatedFile) {
+  const string filename = TablePath("truncated_file");
+  TF_ASSERT_OK(lookup::WriteMemmappedLookupTable(
+      Env::Default(), filename, test::AsTensor<int64_t>({1, 2, 3}),
+      test::AsTensor<int64_t>({4, 5, 6})));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  contents.resize(contents.size() / 2);
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, contents));
+  lookup::LookupInterface* table;
+  EXPECT_TRUE(
+      errors::IsDataLoss(OpenTable(filename, DT_INT64, DT_INT64, &table)));
+}
+
+}  // namespace
+}  // namespace tensorflow
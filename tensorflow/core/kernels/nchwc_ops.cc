@@ -0,0 +1,734 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// CPU kernels of the ops of the blocked NCHWc layout, which the generic layout
+// optimizer creates for the convolution chains of NHWC graphs on CPU. An NHWC
+// tensor of shape [batch, rows, cols, channels] has the shape
+// [batch, ceil(channels / b), rows, cols, b] in the NCHWc layout, with the
+// channels padded with zeros to a multiple of the block size `b`. The `b`
+// channels of a pixel fill one vector register, so that the convolution
+// broadcasts each input channel against a block of output channels, keeping
+// the accumulators of a tile of output pixels in registers. There is an
+// AVX-512 version of the convolution for blocks of 16 channels.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/kernel_shape_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/padding.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(TENSORFLOW_DISABLE_NCHWC_SIMD)
+#define TENSORFLOW_USE_NCHWC_SIMD (1)
+#include <immintrin.h>
+#define TF_NCHWC_TARGET __attribute__((target("avx512f")))
+#endif
+
+// The loops over the accumulators must be unrolled for them to be kept in
+// registers.
+#if defined(__clang__)
+#define TF_NCHWC_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define TF_NCHWC_UNROLL _Pragma("GCC unroll 16")
+#else
+#define TF_NCHWC_UNROLL
+#endif
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Number of output blocks and of output pixels computed together.
+constexpr int kOutBlocks = 4;
+constexpr int kTile = 6;
+
+enum class Activation { kNone, kRelu, kRelu6 };
+
+struct ConvParams {
+  int64_t in_blocks;
+  int64_t in_rows;
+  int64_t in_cols;
+  int64_t out_blocks;
+  int64_t out_rows;
+  int64_t out_cols;
+  int64_t filter_rows;
+  int64_t filter_cols;
+  int64_t stride_rows;
+  int64_t stride_cols;
+  int64_t dilation_rows;
+  int64_t dilation_cols;
+  int64_t pad_top;
+  int64_t pad_left;
+  Activation activation;
+};
+
+Status ParseActivation(const std::string& name, Activation* activation) {
+  if (name == "None") {
+    *activation = Activation::kNone;
+  } else if (name == "Relu") {
+    *activation = Activation::kRelu;
+  } else if (name == "Relu6") {
+    *activation = Activation::kRelu6;
+  } else {
+    return errors::InvalidArgument("Unsupported activation: ", name);
+  }
+  return OkStatus();
+}
+
+// Computes the output row `out_row` of the output blocks
+// [`out_block`, `out_block + kNumOutBlocks`) of the image `input`, which
+// points to the first block of a batch element. `filter` points to the
+// filter of `out_block`, and `bias` to its bias, or is null. The row is
+// accumulated in `output` one input block at a time, so that the filter of an
+// input block stays in cache while it is applied to the whole row.
+template <int kBlock, int kNumOutBlocks>
+void ConvRow(const ConvParams& p, const float* input, const float* filter,
+             const float* bias, int64_t out_block, int64_t out_row,
+             float* output) {
+  const int64_t filter_stride =
+      p.in_blocks * p.filter_rows * p.filter_cols * kBlock * kBlock;
+  const int64_t out_block_stride = p.out_rows * p.out_cols * kBlock;
+  float* out =
+      output + (out_block * p.out_rows + out_row) * p.out_cols * kBlock;
+  for (int64_t ib = 0; ib < p.in_blocks; ++ib) {
+    const bool first = ib == 0;
+    const bool last = ib == p.in_blocks - 1;
+    for (int64_t col = 0; col < p.out_cols; col += kTile) {
+      const int num_cols = std::min<int64_t>(kTile, p.out_cols - col);
+      float acc[kNumOutBlocks][kTile][kBlock];
+      TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+        TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+          for (int o = 0; o < kBlock; ++o) {
+            acc[j][t][o] =
+                first ? (bias == nullptr ? 0.0f : bias[j * kBlock + o])
+                : t < num_cols ? out[j * out_block_stride +
+                                     (col + t) * kBlock + o]
+                               : 0.0f;
+          }
+        }
+      }
+      for (int64_t kr = 0; kr < p.filter_rows; ++kr) {
+        const int64_t in_row =
+            out_row * p.stride_rows - p.pad_top + kr * p.dilation_rows;
+        if (in_row < 0 || in_row >= p.in_rows) continue;
+        const float* in =
+            input + (ib * p.in_rows + in_row) * p.in_cols * kBlock;
+        for (int64_t kc = 0; kc < p.filter_cols; ++kc) {
+          const float* w = filter + ((ib * p.filter_rows + kr) *
+                                         p.filter_cols + kc) *
+                                        kBlock * kBlock;
+          const int64_t in_col =
+              col * p.stride_cols - p.pad_left + kc * p.dilation_cols;
+          TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+            const int64_t c = in_col + t * p.stride_cols;
+            if (t >= num_cols || c < 0 || c >= p.in_cols) continue;
+            const float* x = in + c * kBlock;
+            for (int i = 0; i < kBlock; ++i) {
+              TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+                const float* wv = w + j * filter_stride + i * kBlock;
+                for (int o = 0; o < kBlock; ++o) {
+                  acc[j][t][o] += x[i] * wv[o];
+                }
+              }
+            }
+          }
+        }
+      }
+      TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+        TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+          if (t >= num_cols) continue;
+          float* y = out + j * out_block_stride + (col + t) * kBlock;
+          for (int o = 0; o < kBlock; ++o) {
+            float v = acc[j][t][o];
+            if (last && p.activation != Activation::kNone) {
+              v = std::max(v, 0.0f);
+              if (p.activation == Activation::kRelu6) v = std::min(v, 6.0f);
+            }
+            y[o] = v;
+          }
+        }
+      }
+    }
+  }
+}
+
+#ifdef TENSORFLOW_USE_NCHWC_SIMD
+
+bool IsAvx512Supported() {
+  static const bool supported =
+      port::TestCPUFeature(port::CPUFeature::AVX512F);
+  return supported;
+}
+
+// The AVX-512 version of `ConvRow` for blocks of 16 channels. The tiles of
+// output pixels whose inputs are all inside the image use a loop without
+// bounds checks, whose body loads `kNumOutBlocks` filter vectors and
+// broadcasts `kTile` input channels for `kNumOutBlocks * kTile` FMAs.
+template <int kNumOutBlocks>
+TF_NCHWC_TARGET void ConvRowAvx512(const ConvParams& p, const float* input,
+                                   const float* filter, const float* bias,
+                                   int64_t out_block, int64_t out_row,
+                                   float* output) {
+  constexpr int kBlock = 16;
+  const int64_t filter_stride =
+      p.in_blocks * p.filter_rows * p.filter_cols * kBlock * kBlock;
+  const int64_t out_block_stride = p.out_rows * p.out_cols * kBlock;
+  float* out =
+      output + (out_block * p.out_rows + out_row) * p.out_cols * kBlock;
+  const __m512 zero = _mm512_setzero_ps();
+  const __m512 six = _mm512_set1_ps(6.0f);
+  for (int64_t ib = 0; ib < p.in_blocks; ++ib) {
+    const bool first = ib == 0;
+    const bool last = ib == p.in_blocks - 1;
+    for (int64_t col = 0; col < p.out_cols; col += kTile) {
+      const int num_cols = std::min<int64_t>(kTile, p.out_cols - col);
+      __m512 acc[kNumOutBlocks][kTile];
+      TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+        const __m512 b =
+            bias == nullptr ? zero : _mm512_loadu_ps(bias + j * kBlock);
+        TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+          acc[j][t] = first ? b
+                      : t < num_cols
+                          ? _mm512_loadu_ps(out + j * out_block_stride +
+                                            (col + t) * kBlock)
+                          : zero;
+        }
+      }
+      for (int64_t kr = 0; kr < p.filter_rows; ++kr) {
+        const int64_t in_row =
+            out_row * p.stride_rows - p.pad_top + kr * p.dilation_rows;
+        if (in_row < 0 || in_row >= p.in_rows) continue;
+        const float* in =
+            input + (ib * p.in_rows + in_row) * p.in_cols * kBlock;
+        for (int64_t kc = 0; kc < p.filter_cols; ++kc) {
+          const float* w = filter + ((ib * p.filter_rows + kr) *
+                                         p.filter_cols + kc) *
+                                        kBlock * kBlock;
+          const int64_t in_col =
+              col * p.stride_cols - p.pad_left + kc * p.dilation_cols;
+          if (num_cols == kTile && in_col >= 0 &&
+              in_col + (kTile - 1) * p.stride_cols < p.in_cols) {
+            const float* x = in + in_col * kBlock;
+            const int64_t x_stride = p.stride_cols * kBlock;
+            for (int i = 0; i < kBlock; ++i) {
+              __m512 wv[kNumOutBlocks];
+              TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+                wv[j] = _mm512_loadu_ps(w + j * filter_stride + i * kBlock);
+              }
+              TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+                const __m512 v = _mm512_set1_ps(x[t * x_stride + i]);
+                TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+                  acc[j][t] = _mm512_fmadd_ps(v, wv[j], acc[j][t]);
+                }
+              }
+            }
+            continue;
+          }
+          TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+            const int64_t c = in_col + t * p.stride_cols;
+            if (t >= num_cols || c < 0 || c >= p.in_cols) continue;
+            const float* x = in + c * kBlock;
+            for (int i = 0; i < kBlock; ++i) {
+              const __m512 v = _mm512_set1_ps(x[i]);
+              TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+                acc[j][t] = _mm512_fmadd_ps(
+                    v, _mm512_loadu_ps(w + j * filter_stride + i * kBlock),
+                    acc[j][t]);
+              }
+            }
+          }
+        }
+      }
+      TF_NCHWC_UNROLL for (int j = 0; j < kNumOutBlocks; ++j) {
+        TF_NCHWC_UNROLL for (int t = 0; t < kTile; ++t) {
+          if (t >= num_cols) continue;
+          __m512 v = acc[j][t];
+          if (last && p.activation != Activation::kNone) {
+            v = _mm512_max_ps(v, zero);
+            if (p.activation == Activation::kRelu6) v = _mm512_min_ps(v, six);
+          }
+          _mm512_storeu_ps(out + j * out_block_stride + (col + t) * kBlock, v);
+        }
+      }
+    }
+  }
+}
+
+#endif  // TENSORFLOW_USE_NCHWC_SIMD
+
+using ConvRowFn = void (*)(const ConvParams&, const float*, const float*,
+                           const float*, int64_t, int64_t, float*);
+
+// Returns the row functions for `kOutBlocks` output blocks and for a single
+// output block, or nulls if `block_size` is not supported.
+std::pair<ConvRowFn, ConvRowFn> GetConvRowFns(int64_t block_size) {
+  if (block_size == 16) {
+#ifdef TENSORFLOW_USE_NCHWC_SIMD
+    if (IsAvx512Supported()) {
+      return {ConvRowAvx512<kOutBlocks>, ConvRowAvx512<1>};
+    }
+#endif
+    return {ConvRow<16, kOutBlocks>, ConvRow<16, 1>};
+  }
+  if (block_size == 8) return {ConvRow<8, kOutBlocks>, ConvRow<8, 1>};
+  return {nullptr, nullptr};
+}
+
+Status GetNchwcWindowAttrs(OpKernelConstruction* context,
+                           const std::string& name, std::vector<int32>* attr) {
+  TF_RETURN_IF_ERROR(context->GetAttr(name, attr));
+  if (attr->size() != 4 || (*attr)[0] != 1 || (*attr)[3] != 1 ||
+      (*attr)[1] < 1 || (*attr)[2] < 1) {
+    return errors::InvalidArgument(name,
+                                   " must be of the form [1, rows, cols, 1]");
+  }
+  return OkStatus();
+}
+
+Status CheckBlockSize(int64_t block_size) {
+  if (block_size != 8 && block_size != 16) {
+    return errors::InvalidArgument(
+        "The NCHWc layout supports blocks of 8 or 16 channels, got ",
+        block_size);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+class NhwcToNchwcOp : public OpKernel {
+ public:
+  explicit NhwcToNchwcOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("block_size", &block_size_));
+    OP_REQUIRES_OK(context, CheckBlockSize(block_size_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OP_REQUIRES(context, x.dims() == 4,
+                errors::InvalidArgument("x must be 4-dimensional, got ",
+                                        x.shape().DebugString()));
+    const int64_t batch = x.dim_size(0);
+    const int64_t rows = x.dim_size(1);
+    const int64_t cols = x.dim_size(2);
+    const int64_t channels = x.dim_size(3);
+    const int64_t blocks = Eigen::divup(channels, block_size_);
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, blocks, rows, cols, block_size_}),
+                       &y));
+    if (y->NumElements() == 0) return;
+
+    const float* in = x.flat<float>().data();
+    float* out = y->flat<float>().data();
+    const int64_t b = block_size_;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/cols * channels * sizeof(float),
+        /*bytes_stored=*/cols * blocks * b * sizeof(float),
+        /*compute_cycles=*/cols * blocks * b);
+    context->eigen_cpu_device().parallelFor(
+        batch * rows, cost, [&](int64_t first, int64_t last) {
+          for (int64_t image_row = first; image_row < last; ++image_row) {
+            const int64_t n = image_row / rows;
+            const int64_t row = image_row % rows;
+            const float* x_row = in + image_row * cols * channels;
+            for (int64_t block = 0; block < blocks; ++block) {
+              float* y_row =
+                  out + ((n * blocks + block) * rows + row) * cols * b;
+              const int64_t c0 = block * b;
+              const int64_t size = std::min(b, channels - c0);
+              for (int64_t col = 0; col < cols; ++col) {
+                const float* src = x_row + col * channels + c0;
+                float* dst = y_row + col * b;
+                std::copy_n(src, size, dst);
+                std::fill(dst + size, dst + b, 0.0f);
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  int64_t block_size_;
+};
+
+class NchwcToNhwcOp : public OpKernel {
+ public:
+  explicit NchwcToNhwcOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OP_REQUIRES(context, x.dims() == 5,
+                errors::InvalidArgument("x must be 5-dimensional, got ",
+                                        x.shape().DebugString()));
+    const int64_t batch = x.dim_size(0);
+    const int64_t blocks = x.dim_size(1);
+    const int64_t rows = x.dim_size(2);
+    const int64_t cols = x.dim_size(3);
+    const int64_t b = x.dim_size(4);
+    OP_REQUIRES(context, channels_ <= blocks * b,
+                errors::InvalidArgument("x of shape ", x.shape().DebugString(),
+                                        " has fewer than ", channels_,
+                                        " channels"));
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, rows, cols, channels_}), &y));
+    if (y->NumElements() == 0) return;
+
+    const float* in = x.flat<float>().data();
+    float* out = y->flat<float>().data();
+    const int64_t channels = channels_;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/cols * channels * sizeof(float),
+        /*bytes_stored=*/cols * channels * sizeof(float),
+        /*compute_cycles=*/cols * channels);
+    context->eigen_cpu_device().parallelFor(
+        batch * rows, cost, [&](int64_t first, int64_t last) {
+          for (int64_t image_row = first; image_row < last; ++image_row) {
+            const int64_t n = image_row / rows;
+            const int64_t row = image_row % rows;
+            float* y_row = out + image_row * cols * channels;
+            for (int64_t block = 0; block * b < channels; ++block) {
+              const float* x_row =
+                  in + ((n * blocks + block) * rows + row) * cols * b;
+              const int64_t c0 = block * b;
+              const int64_t size = std::min(b, channels - c0);
+              for (int64_t col = 0; col < cols; ++col) {
+                std::copy_n(x_row + col * b, size, y_row + col * channels + c0);
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  int64_t channels_;
+};
+
+class NchwcFilterOp : public OpKernel {
+ public:
+  explicit NchwcFilterOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("block_size", &block_size_));
+    OP_REQUIRES_OK(context, CheckBlockSize(block_size_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& filter = context->input(0);
+    OP_REQUIRES(context, filter.dims() == 4,
+                errors::InvalidArgument("filter must be 4-dimensional, got ",
+                                        filter.shape().DebugString()));
+    const int64_t rows = filter.dim_size(0);
+    const int64_t cols = filter.dim_size(1);
+    const int64_t in_channels = filter.dim_size(2);
+    const int64_t out_channels = filter.dim_size(3);
+    const int64_t b = block_size_;
+    const int64_t in_blocks = Eigen::divup(in_channels, b);
+    const int64_t out_blocks = Eigen::divup(out_channels, b);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({out_blocks, in_blocks, rows,
+                                             cols, b, b}),
+                                &output));
+    const auto in = filter.tensor<float, 4>();
+    float* out = output->flat<float>().data();
+    for (int64_t ob = 0; ob < out_blocks; ++ob) {
+      for (int64_t ib = 0; ib < in_blocks; ++ib) {
+        for (int64_t r = 0; r < rows; ++r) {
+          for (int64_t c = 0; c < cols; ++c) {
+            for (int64_t i = 0; i < b; ++i) {
+              for (int64_t o = 0; o < b; ++o) {
+                const int64_t ic = ib * b + i;
+                const int64_t oc = ob * b + o;
+                *out++ = ic < in_channels && oc < out_channels
+                             ? in(r, c, ic, oc)
+                             : 0.0f;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  int64_t block_size_;
+};
+
+class NchwcConv2DOp : public OpKernel {
+ public:
+  explicit NchwcConv2DOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetNchwcWindowAttrs(context, "strides", &strides_));
+    OP_REQUIRES_OK(context,
+                   GetNchwcWindowAttrs(context, "dilations", &dilations_));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    std::string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    OP_REQUIRES_OK(context, ParseActivation(activation, &activation_));
+    int num_bias;
+    OP_REQUIRES_OK(context, context->GetAttr("num_bias", &num_bias));
+    OP_REQUIRES(context, num_bias <= 1,
+                errors::InvalidArgument(
+                    "_NchwcConv2D supports at most one bias, got ", num_bias));
+    has_bias_ = num_bias == 1;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional, got ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 6,
+                errors::InvalidArgument("filter must be 6-dimensional, got ",
+                                        filter.shape().DebugString()));
+    const int64_t b = input.dim_size(4);
+    OP_REQUIRES(context,
+                filter.dim_size(1) == input.dim_size(1) &&
+                    filter.dim_size(4) == b && filter.dim_size(5) == b,
+                errors::InvalidArgument(
+                    "filter of shape ", filter.shape().DebugString(),
+                    " does not match the input of shape ",
+                    input.shape().DebugString()));
+    const std::pair<ConvRowFn, ConvRowFn> row_fns = GetConvRowFns(b);
+    OP_REQUIRES(context, row_fns.first != nullptr,
+                errors::InvalidArgument(
+                    "_NchwcConv2D supports blocks of 8 or 16 channels, got ",
+                    b));
+
+    ConvParams p;
+    p.in_blocks = input.dim_size(1);
+    p.in_rows = input.dim_size(2);
+    p.in_cols = input.dim_size(3);
+    p.out_blocks = filter.dim_size(0);
+    p.filter_rows = filter.dim_size(2);
+    p.filter_cols = filter.dim_size(3);
+    p.stride_rows = strides_[1];
+    p.stride_cols = strides_[2];
+    p.dilation_rows = dilations_[1];
+    p.dilation_cols = dilations_[2];
+    p.activation = activation_;
+    int64_t pad_bottom, pad_right;
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSizeVerboseV2(
+                       p.in_rows, p.filter_rows, p.dilation_rows,
+                       p.stride_rows, padding_, &p.out_rows, &p.pad_top,
+                       &pad_bottom));
+    OP_REQUIRES_OK(context,
+                   GetWindowedOutputSizeVerboseV2(
+                       p.in_cols, p.filter_cols, p.dilation_cols,
+                       p.stride_cols, padding_, &p.out_cols, &p.pad_left,
+                       &pad_right));
+
+    const float* bias = nullptr;
+    if (has_bias_) {
+      const Tensor& bias_tensor = context->input(2);
+      OP_REQUIRES(context,
+                  TensorShapeUtils::IsVector(bias_tensor.shape()) &&
+                      bias_tensor.NumElements() == p.out_blocks * b,
+                  errors::InvalidArgument(
+                      "bias must be a vector of size ", p.out_blocks * b,
+                      ", got ", bias_tensor.shape().DebugString()));
+      bias = bias_tensor.flat<float>().data();
+    }
+
+    const int64_t batch = input.dim_size(0);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0,
+                                TensorShape({batch, p.out_blocks, p.out_rows,
+                                             p.out_cols, b}),
+                                &output));
+    if (output->NumElements() == 0) return;
+
+    const float* in = input.flat<float>().data();
+    const float* w = filter.flat<float>().data();
+    float* out = output->flat<float>().data();
+    const int64_t in_image_size = p.in_blocks * p.in_rows * p.in_cols * b;
+    const int64_t out_image_size = p.out_blocks * p.out_rows * p.out_cols * b;
+    const int64_t filter_block_size =
+        p.in_blocks * p.filter_rows * p.filter_cols * b * b;
+    // Each task computes a row of `kOutBlocks` output blocks.
+    const int64_t num_groups = Eigen::divup<int64_t>(p.out_blocks, kOutBlocks);
+    const int64_t macs_per_task =
+        kOutBlocks * b * p.out_cols * filter_block_size / b;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/kOutBlocks * filter_block_size * sizeof(float),
+        /*bytes_stored=*/kOutBlocks * p.out_cols * b * sizeof(float),
+        /*compute_cycles=*/macs_per_task / 8);
+    context->eigen_cpu_device().parallelFor(
+        batch * num_groups * p.out_rows, cost,
+        [&](int64_t first, int64_t last) {
+          for (int64_t task = first; task < last; ++task) {
+            const int64_t out_row = task % p.out_rows;
+            const int64_t group = task / p.out_rows % num_groups;
+            const int64_t n = task / p.out_rows / num_groups;
+            const float* image = in + n * in_image_size;
+            float* out_image = out + n * out_image_size;
+            int64_t ob = group * kOutBlocks;
+            const int64_t end = std::min(p.out_blocks, ob + kOutBlocks);
+            if (end - ob == kOutBlocks) {
+              row_fns.first(p, image, w + ob * filter_block_size,
+                            bias == nullptr ? nullptr : bias + ob * b, ob,
+                            out_row, out_image);
+              continue;
+            }
+            for (; ob < end; ++ob) {
+              row_fns.second(p, image, w + ob * filter_block_size,
+                             bias == nullptr ? nullptr : bias + ob * b, ob,
+                             out_row, out_image);
+            }
+          }
+        });
+  }
+
+ private:
+  std::vector<int32> strides_;
+  std::vector<int32> dilations_;
+  Padding padding_;
+  Activation activation_;
+  bool has_bias_;
+};
+
+class NchwcPoolOp : public OpKernel {
+ public:
+  explicit NchwcPoolOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetNchwcWindowAttrs(context, "ksize", &ksize_));
+    OP_REQUIRES_OK(context, GetNchwcWindowAttrs(context, "strides", &strides_));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    std::string pooling_type;
+    OP_REQUIRES_OK(context, context->GetAttr("pooling_type", &pooling_type));
+    is_max_ = pooling_type == "MAX";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional, got ",
+                                        input.shape().DebugString()));
+    const int64_t batch = input.dim_size(0);
+    const int64_t blocks = input.dim_size(1);
+    const int64_t in_rows = input.dim_size(2);
+    const int64_t in_cols = input.dim_size(3);
+    const int64_t b = input.dim_size(4);
+    const int64_t window_rows = ksize_[1];
+    const int64_t window_cols = ksize_[2];
+    const int64_t stride_rows = strides_[1];
+    const int64_t stride_cols = strides_[2];
+    int64_t out_rows, out_cols, pad_top, pad_left, pad_after;
+    OP_REQUIRES_OK(context, GetWindowedOutputSizeVerbose(
+                                in_rows, window_rows, stride_rows, padding_,
+                                &out_rows, &pad_top, &pad_after));
+    OP_REQUIRES_OK(context, GetWindowedOutputSizeVerbose(
+                                in_cols, window_cols, stride_cols, padding_,
+                                &out_cols, &pad_left, &pad_after));
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, blocks, out_rows, out_cols, b}),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    const float* in = input.flat<float>().data();
+    float* out = output->flat<float>().data();
+    const bool is_max = is_max_;
+    const Eigen::TensorOpCost cost(
+        /*bytes_loaded=*/window_rows * window_cols * out_cols * b *
+            sizeof(float),
+        /*bytes_stored=*/out_cols * b * sizeof(float),
+        /*compute_cycles=*/window_rows * window_cols * out_cols * b);
+    context->eigen_cpu_device().parallelFor(
+        batch * blocks * out_rows, cost, [&](int64_t first, int64_t last) {
+          std::vector<float> acc(b);
+          for (int64_t task = first; task < last; ++task) {
+            const int64_t out_row = task % out_rows;
+            const float* image = in + task / out_rows * in_rows * in_cols * b;
+            float* y = out + task * out_cols * b;
+            const int64_t row_start = out_row * stride_rows - pad_top;
+            const int64_t row_begin = std::max<int64_t>(row_start, 0);
+            const int64_t row_end =
+                std::min<int64_t>(row_start + window_rows, in_rows);
+            for (int64_t out_col = 0; out_col < out_cols; ++out_col) {
+              const int64_t col_start = out_col * stride_cols - pad_left;
+              const int64_t col_begin = std::max<int64_t>(col_start, 0);
+              const int64_t col_end =
+                  std::min<int64_t>(col_start + window_cols, in_cols);
+              std::fill(acc.begin(), acc.end(),
+                        is_max ? std::numeric_limits<float>::lowest() : 0.0f);
+              for (int64_t r = row_begin; r < row_end; ++r) {
+                for (int64_t c = col_begin; c < col_end; ++c) {
+                  const float* x = image + (r * in_cols + c) * b;
+                  if (is_max) {
+                    for (int64_t o = 0; o < b; ++o) {
+                      acc[o] = std::max(acc[o], x[o]);
+                    }
+                  } else {
+                    for (int64_t o = 0; o < b; ++o) acc[o] += x[o];
+                  }
+                }
+              }
+              float* dst = y + out_col * b;
+              if (is_max) {
+                std::copy(acc.begin(), acc.end(), dst);
+              } else {
+                const float scale =
+                    1.0f / ((row_end - row_begin) * (col_end - col_begin));
+                for (int64_t o = 0; o < b; ++o) dst[o] = acc[o] * scale;
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  std::vector<int32> ksize_;
+  std::vector<int32> strides_;
+  Padding padding_;
+  bool is_max_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_NhwcToNchwc").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NhwcToNchwcOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NchwcToNhwc").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NchwcToNhwcOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NchwcFilter").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NchwcFilterOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NchwcConv2D").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NchwcConv2DOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NchwcPool").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NchwcPoolOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,310 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Returns `n` values in [-2, 2).
+std::vector<float> Values(int n, int seed) {
+  std::vector<float> values(n);
+  for (int i = 0; i < n; ++i) {
+    values[i] = ((i * 7 + seed * 13) % 32) * 0.125f - 2.0f;
+  }
+  return values;
+}
+
+// Converts a [batch, rows, cols, channels] tensor to the NCHWc layout.
+std::vector<float> ToNchwc(const std::vector<float>& x, int batch, int rows,
+                           int cols, int channels, int block_size) {
+  const int blocks = (channels + block_size - 1) / block_size;
+  std::vector<float> y(batch * blocks * rows * cols * block_size, 0.0f);
+  for (int n = 0; n < batch; ++n) {
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        for (int ch = 0; ch < channels; ++ch) {
+          y[(((n * blocks + ch / block_size) * rows + r) * cols + c) *
+                block_size +
+            ch % block_size] = x[((n * rows + r) * cols + c) * channels + ch];
+        }
+      }
+    }
+  }
+  return y;
+}
+
+// Converts a [rows, cols, in_channels, out_channels] filter to the layout of
+// the _NchwcConv2D filters.
+std::vector<float> FilterToNchwc(const std::vector<float>& filter, int rows,
+                                 int cols, int in_channels, int out_channels,
+                                 int block_size) {
+  const int in_blocks = (in_channels + block_size - 1) / block_size;
+  const int out_blocks = (out_channels + block_size - 1) / block_size;
+  std::vector<float> y(
+      out_blocks * in_blocks * rows * cols * block_size * block_size, 0.0f);
+  for (int r = 0; r < rows; ++r) {
+    for (int c = 0; c < cols; ++c) {
+      for (int i = 0; i < in_channels; ++i) {
+        for (int o = 0; o < out_channels; ++o) {
+          const int block =
+              ((o / block_size * in_blocks + i / block_size) * rows + r) *
+                  cols +
+              c;
+          y[(block * block_size + i % block_size) * block_size +
+            o % block_size] =
+              filter[((r * cols + c) * in_channels + i) * out_channels + o];
+        }
+      }
+    }
+  }
+  return y;
+}
+
+class NchwcOpsTest : public OpsTestBase {};
+
+TEST_F(NchwcOpsTest, NhwcToNchwc) {
+  TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_NhwcToNchwc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("block_size", 8)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  // 20 channels are padded to 3 blocks of 8.
+  const std::vector<float> x = Values(2 * 3 * 4 * 20, 1);
+  AddInputFromArray<float>(TensorShape({2, 3, 4, 20}), x);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3, 3, 4, 8}));
+  test::FillValues<float>(&expected, ToNchwc(x, 2, 3, 4, 20, 8));
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(NchwcOpsTest, NchwcToNhwc) {
+  TF_ASSERT_OK(NodeDefBuilder("to_nhwc", "_NchwcToNhwc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("channels", 20)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<float> x = Values(2 * 3 * 4 * 20, 1);
+  AddInputFromArray<float>(TensorShape({2, 3, 3, 4, 8}),
+                           ToNchwc(x, 2, 3, 4, 20, 8));
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 3, 4, 20}));
+  test::FillValues<float>(&expected, x);
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(NchwcOpsTest, NchwcFilter) {
+  TF_ASSERT_OK(NodeDefBuilder("filter", "_NchwcFilter")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("block_size", 8)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const std::vector<float> filter = Values(3 * 2 * 11 * 16, 1);
+  AddInputFromArray<float>(TensorShape({3, 2, 11, 16}), filter);
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({2, 2, 3, 2, 8, 8}));
+  test::FillValues<float>(&expected, FilterToNchwc(filter, 3, 2, 11, 16, 8));
+  test::ExpectTensorEqual<float>(expected, *GetOutput(0));
+}
+
+TEST_F(NchwcOpsTest, InvalidBlockSize) {
+  TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_NhwcToNchwc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("block_size", 4)
+                   .Finalize(node_def()));
+  Status status = InitOp();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+struct ConvTestParams {
+  int block_size;
+  int stride;
+  int dilation;
+  std::string padding;
+  std::string activation;
+};
+
+class NchwcConv2DOpTest : public OpsTestBase {
+ protected:
+  // Compares _NchwcConv2D with a reference convolution in NHWC.
+  void Run(const ConvTestParams& params) {
+    const int batch = 2, rows = 7, cols = 9, in_channels = 11;
+    const int out_channels = 5 * params.block_size;
+    const int filter_rows = 3, filter_cols = 2;
+    const int b = params.block_size;
+    const std::vector<float> x =
+        Values(batch * rows * cols * in_channels, 1);
+    const std::vector<float> filter =
+        Values(filter_rows * filter_cols * in_channels * out_channels, 2);
+    const std::vector<float> bias = Values(out_channels, 3);
+
+    const std::vector<int> strides = {1, params.stride, params.stride, 1};
+    const std::vector<int> dilations = {1, params.dilation, params.dilation, 1};
+    TF_ASSERT_OK(NodeDefBuilder("conv", "_NchwcConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(1, DT_FLOAT))
+                     .Attr("strides", strides)
+                     .Attr("dilations", dilations)
+                     .Attr("padding", params.padding)
+                     .Attr("activation", params.activation)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const int in_blocks = (in_channels + b - 1) / b;
+    AddInputFromArray<float>(TensorShape({batch, in_blocks, rows, cols, b}),
+                             ToNchwc(x, batch, rows, cols, in_channels, b));
+    AddInputFromArray<float>(
+        TensorShape({5, in_blocks, filter_rows, filter_cols, b, b}),
+        FilterToNchwc(filter, filter_rows, filter_cols, in_channels,
+                      out_channels, b));
+    AddInputFromArray<float>(TensorShape({out_channels}), bias);
+    TF_ASSERT_OK(RunOpKernel());
+
+    const bool same = params.padding == "SAME";
+    const int window_rows = (filter_rows - 1) * params.dilation + 1;
+    const int window_cols = (filter_cols - 1) * params.dilation + 1;
+    const int out_rows = same ? (rows + params.stride - 1) / params.stride
+                              : (rows - window_rows) / params.stride + 1;
+    const int out_cols = same ? (cols + params.stride - 1) / params.stride
+                              : (cols - window_cols) / params.stride + 1;
+    // Like TensorFlow, SAME puts the excess padding after the image.
+    const int pad_rows = (out_rows - 1) * params.stride + window_rows - rows;
+    const int pad_cols = (out_cols - 1) * params.stride + window_cols - cols;
+    const int pad_top = same ? std::max(0, pad_rows) / 2 : 0;
+    const int pad_left = same ? std::max(0, pad_cols) / 2 : 0;
+    std::vector<float> expected_values(batch * out_rows * out_cols *
+                                       out_channels);
+    for (int n = 0; n < batch; ++n) {
+      for (int r = 0; r < out_rows; ++r) {
+        for (int c = 0; c < out_cols; ++c) {
+          for (int oc = 0; oc < out_channels; ++oc) {
+            double sum = bias[oc];
+            for (int fr = 0; fr < filter_rows; ++fr) {
+              for (int fc = 0; fc < filter_cols; ++fc) {
+                const int ir =
+                    r * params.stride - pad_top + fr * params.dilation;
+                const int ic =
+                    c * params.stride - pad_left + fc * params.dilation;
+                if (ir < 0 || ir >= rows || ic < 0 || ic >= cols) continue;
+                for (int i = 0; i < in_channels; ++i) {
+                  sum += x[((n * rows + ir) * cols + ic) * in_channels + i] *
+                         filter[((fr * filter_cols + fc) * in_channels + i) *
+                                    out_channels +
+                                oc];
+                }
+              }
+            }
+            if (params.activation != "None") sum = std::max(sum, 0.0);
+            if (params.activation == "Relu6") sum = std::min(sum, 6.0);
+            expected_values[((n * out_rows + r) * out_cols + c) * out_channels +
+                            oc] = sum;
+          }
+        }
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT,
+                    TensorShape({batch, 5, out_rows, out_cols, b}));
+    test::FillValues<float>(&expected,
+                            ToNchwc(expected_values, batch, out_rows, out_cols,
+                                    out_channels, b));
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-4);
+  }
+};
+
+TEST_F(NchwcConv2DOpTest, Block8) {
+  Run({/*block_size=*/8, /*stride=*/1, /*dilation=*/1, "SAME", "None"});
+}
+
+TEST_F(NchwcConv2DOpTest, Block16WithRelu) {
+  Run({/*block_size=*/16, /*stride=*/1, /*dilation=*/1, "SAME", "Relu"});
+}
+
+TEST_F(NchwcConv2DOpTest, StridedWithRelu6) {
+  Run({/*block_size=*/16, /*stride=*/2, /*dilation=*/1, "SAME", "Relu6"});
+}
+
+TEST_F(NchwcConv2DOpTest, DilatedValid) {
+  Run({/*block_size=*/8, /*stride=*/1, /*dilation=*/2, "VALID", "None"});
+}
+
+class NchwcPoolOpTest : public OpsTestBase {
+ protected:
+  void Run(const std::string& pooling_type) {
+    const int batch = 1, rows = 5, cols = 6, channels = 16, b = 8;
+    TF_ASSERT_OK(NodeDefBuilder("pool", "_NchwcPool")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("pooling_type", pooling_type)
+                     .Attr("ksize", {1, 3, 3, 1})
+                     .Attr("strides", {1, 2, 2, 1})
+                     .Attr("padding", "SAME")
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    const std::vector<float> x = Values(batch * rows * cols * channels, 1);
+    AddInputFromArray<float>(TensorShape({batch, 2, rows, cols, b}),
+                             ToNchwc(x, batch, rows, cols, channels, b));
+    TF_ASSERT_OK(RunOpKernel());
+
+    // The SAME padding of 3x3 windows with a stride of 2 is 1 on each side
+    // for 5 rows, and 0 before and 1 after for 6 columns.
+    const int out_rows = 3, out_cols = 3;
+    std::vector<float> expected_values;
+    for (int r = 0; r < out_rows; ++r) {
+      for (int c = 0; c < out_cols; ++c) {
+        for (int ch = 0; ch < channels; ++ch) {
+          float max = -1e9f, sum = 0.0f;
+          int count = 0;
+          for (int ir = std::max(0, 2 * r - 1); ir < std::min(rows, 2 * r + 2);
+               ++ir) {
+            for (int ic = 2 * c; ic < std::min(cols, 2 * c + 3); ++ic) {
+              const float v = x[(ir * cols + ic) * channels + ch];
+              max = std::max(max, v);
+              sum += v;
+              ++count;
+            }
+          }
+          expected_values.push_back(pooling_type == "MAX" ? max
+                                                          : sum / count);
+        }
+      }
+    }
+    Tensor expected(allocator(), DT_FLOAT,
+                    TensorShape({batch, 2, out_rows, out_cols, b}));
+    test::FillValues<float>(&expected,
+                            ToNchwc(expected_values, batch, out_rows, out_cols,
+                                    channels, b));
+    test::ExpectTensorNear<float>(expected, *GetOutput(0), 1e-5);
+  }
+};
+
+TEST_F(NchwcPoolOpTest, MaxPool) { Run("MAX"); }
+
+TEST_F(NchwcPoolOpTest, AvgPool) { Run("AVG"); }
+
+}  // namespace
+}  // namespace tensorflow
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/kernels/vnni_support.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/util/padding.h"
@@ -399,6 +400,14 @@ class Im2ColConvFunctor {
         meta::QuantizedGemm(context, transpose_a, transpose_b, im2col_buffer,
                             filter_data, chunk_output_data, m, n, k,
                             -input_offset, -filter_offset, lda, ldb, ldc);
+      } else if (vnni::IsSupportedAndEnabled() && std::is_same<T1, quint8>() &&
+                 std::is_same<T2, quint8>() && std::is_same<T3, qint32>() &&
+                 (output_offset == 0) && (output_mult == 1) &&
+                 (output_shift == 0) && (transpose_c == false)) {
+        // Uses the AVX-512 VNNI instructions on x86 CPUs that support them.
+        vnni::QuantizedGemm(context, transpose_a, transpose_b, im2col_buffer,
+                            filter_data, chunk_output_data, m, n, k,
+                            -input_offset, -filter_offset, lda, ldb, ldc);
       } else if (std::is_same<T1, quint8>() && std::is_same<T2, quint8>() &&
                  std::is_same<T3, qint32>() && (output_offset == 0) &&
                  (output_mult == 1) && (output_shift == 0)) {
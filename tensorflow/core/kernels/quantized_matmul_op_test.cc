@@ -30,13 +30,69 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/reference_gemm.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
 
 class QuantizedMatMulTest : public OpsTestBase {
  protected:
+  // Multiplies random matrices whose sizes are not multiples of the tiles of
+  // the optimized kernels, and checks that the results match ReferenceGemm.
+  void RunAgainstReference(bool transpose_a, bool transpose_b) {
+    TF_ASSERT_OK(NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMul")
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_QUINT8))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("Toutput", DataTypeToEnum<qint32>::v())
+                     .Attr("transpose_a", transpose_a)
+                     .Attr("transpose_b", transpose_b)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+
+    const int m = 37;
+    const int n = 70;
+    const int k = 131;
+    random::PhiloxRandom philox(123, 17);
+    random::SimplePhilox rnd(&philox);
+    Tensor a(DT_QUINT8,
+             transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+    Tensor b(DT_QUINT8,
+             transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+    for (int i = 0; i < a.NumElements(); ++i) {
+      a.flat<quint8>()(i) = static_cast<uint8>(rnd.Uniform(256));
+    }
+    for (int i = 0; i < b.NumElements(); ++i) {
+      b.flat<quint8>()(i) = static_cast<uint8>(rnd.Uniform(256));
+    }
+    const float a_min = -12.0f;
+    const float a_max = 3.0f;
+    const float b_min = -1.0f;
+    const float b_max = 2.0f;
+    AddInputFromArray<quint8>(a.shape(), a.flat<quint8>());
+    AddInputFromArray<quint8>(b.shape(), b.flat<quint8>());
+    AddInputFromArray<float>(TensorShape({}), {a_min});
+    AddInputFromArray<float>(TensorShape({}), {a_max});
+    AddInputFromArray<float>(TensorShape({}), {b_min});
+    AddInputFromArray<float>(TensorShape({}), {b_max});
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected(DT_QINT32, {m, n});
+    ReferenceGemm<quint8, quint8, qint32>(
+        transpose_a, transpose_b, /*transpose_c=*/false, m, n, k,
+        a.flat<quint8>().data(),
+        FloatToQuantizedUnclamped<quint8>(0.0f, a_min, a_max), a.dim_size(1),
+        b.flat<quint8>().data(),
+        FloatToQuantizedUnclamped<quint8>(0.0f, b_min, b_max), b.dim_size(1),
+        expected.flat<qint32>().data(), /*shift_c=*/0, /*offset_c=*/0,
+        /*mult_c=*/1, /*ldc=*/n);
+    test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
+  }
 };
 
 // Runs two small matrices through the operator, and leaves all the parameters
@@ -393,4 +449,16 @@ TEST_F(QuantizedMatMulTest, Medium_WithParams) {
   test::ExpectTensorNear<float>(expected_float, output_float, 15.0);
 }
 
+TEST_F(QuantizedMatMulTest, Large_MatchesReference) {
+  RunAgainstReference(/*transpose_a=*/false, /*transpose_b=*/false);
+}
+
+TEST_F(QuantizedMatMulTest, Large_TransposeA_MatchesReference) {
+  RunAgainstReference(/*transpose_a=*/true, /*transpose_b=*/false);
+}
+
+TEST_F(QuantizedMatMulTest, Large_TransposeB_MatchesReference) {
+  RunAgainstReference(/*transpose_a=*/false, /*transpose_b=*/true);
+}
+
 }  // namespace tensorflow
@@ -12,8 +12,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+
+#include <string.h>
+
+#include <algorithm>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
@@ -21,32 +26,70 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 namespace {
 
-// For each slice in `(start, limit)` in `value_slices`, append
-// `params_dense_values_in[start:limit] to `values_out`.  `value_size` indicates
-// the number of scalars contained in each value params_dense_values_in[i].
+// A contiguous run of values to copy: `params_dense_values[start:limit]` is
+// copied to `values[out_start:out_start + limit - start]`.
+template <typename SPLITS_TYPE>
+struct ValueSlice {
+  SPLITS_TYPE start;
+  SPLITS_TYPE limit;
+  SPLITS_TYPE out_start;
+};
+
+// For each slice in `value_slices`, copies the corresponding values of
+// `params_dense_values_in` to `values_out`.  `value_size` indicates the number
+// of scalars contained in each value params_dense_values_in[i].  The output
+// values are sharded evenly across threads, regardless of the lengths of the
+// slices, and each piece of a slice is copied with a single memcpy when the
+// type allows it.
 template <typename VALUE_TYPE, typename SPLITS_TYPE>
-void WriteValueSlices(
-    const Tensor& params_dense_values_in,
-    const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
-    SPLITS_TYPE value_size, Tensor* values_out) {
-  const auto& params_dense_values =
-      params_dense_values_in.flat_outer_dims<VALUE_TYPE, 2>();
-  auto values = values_out->flat_outer_dims<VALUE_TYPE, 2>();
-  int out_pos = 0;
-  for (const auto& slice : value_slices) {
-    for (int i = slice.first; i < slice.second; ++i) {
-      for (int j = 0; j < value_size; ++j) {
-        values(out_pos, j) = params_dense_values(i, j);
+void WriteValueSlices(OpKernelContext* context,
+                      const Tensor& params_dense_values_in,
+                      const std::vector<ValueSlice<SPLITS_TYPE>>& value_slices,
+                      SPLITS_TYPE value_size, Tensor* values_out) {
+  const int64_t num_values = values_out->dim_size(0);
+  if (num_values == 0 || value_size == 0) return;
+  const VALUE_TYPE* params_dense_values =
+      params_dense_values_in.flat<VALUE_TYPE>().data();
+  VALUE_TYPE* values = values_out->flat<VALUE_TYPE>().data();
+  const bool can_memcpy =
+      DataTypeCanUseMemcpy(DataTypeToEnum<VALUE_TYPE>::value);
+
+  auto starts_after = [](int64_t pos, const ValueSlice<SPLITS_TYPE>& slice) {
+    return pos < slice.out_start;
+  };
+  // Copies the output values in [begin, end).
+  auto copy_values = [&](int64_t begin, int64_t end) {
+    // The last slice that starts at or before `begin`.
+    auto slice = std::upper_bound(value_slices.begin(), value_slices.end(),
+                                  begin, starts_after) -
+                 1;
+    for (int64_t pos = begin; pos < end; ++slice) {
+      const int64_t offset = pos - slice->out_start;
+      const int64_t count =
+          std::min<int64_t>(slice->limit - slice->start - offset, end - pos);
+      const VALUE_TYPE* src =
+          params_dense_values + (slice->start + offset) * value_size;
+      VALUE_TYPE* dst = values + pos * value_size;
+      if (can_memcpy) {
+        memcpy(dst, src, count * value_size * sizeof(VALUE_TYPE));
+      } else {
+        std::copy_n(src, count * value_size, dst);
       }
-      ++out_pos;
+      pos += count;
     }
-  }
+  };
+
+  auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, num_values,
+        value_size * sizeof(VALUE_TYPE), copy_values);
 }
 
 }  // namespace
@@ -80,25 +123,50 @@ class RaggedGatherOpBase : public OpKernel {
                 errors::InvalidArgument("params.rank must be nonzero"));
     SPLITS_TYPE num_params_dense_values = params_dense_values_in.dim_size(0);
 
-    // Calculate the `splits`, and store the value slices that we need to
-    // copy in `value_slices`.
-    std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>> value_slices;
-    SPLITS_TYPE num_values = 0;
-    std::vector<std::vector<SPLITS_TYPE>> out_splits;
-    OP_REQUIRES_OK(context, MakeSplits(indices_in, params_nested_splits_in,
-                                       num_params_dense_values, &out_splits,
-                                       &value_slices, &num_values));
+    // Get Eigen tensors.
+    std::vector<ConstFlatType> params_nested_splits;
+    params_nested_splits.reserve(params_nested_splits_in.size());
+    for (const auto& splits_in : params_nested_splits_in) {
+      params_nested_splits.push_back(splits_in.flat<SPLITS_TYPE>());
+    }
+    OP_REQUIRES_OK(context, ValidateSplits(params_nested_splits,
+                                           num_params_dense_values));
+
+    // Find the rows to copy at each ragged level, and store the value slices
+    // that we need to copy in `value_slices`.
+    RowRuns runs;
+    std::vector<ValueSlice<SPLITS_TYPE>> value_slices;
+    MakeRowRuns(indices_in, params_nested_splits, &runs, &value_slices);
 
     // Write the output tensors.
-    OP_REQUIRES_OK(context, WriteSplits(out_splits, context));
+    OP_REQUIRES_OK(context, WriteSplits(indices_in, params_nested_splits, runs,
+                                        context));
+    const int num_splits =
+        indices_in.dims() - 1 + params_nested_splits_in.size();
     OP_REQUIRES_OK(context,
                    WriteValues(params_dense_values_in, value_slices,
-                               out_splits.size(), num_values, context));
+                               num_splits, runs.totals.back(), context));
   }
 
  private:
   using ConstFlatType = typename TTypes<SPLITS_TYPE>::ConstFlat;
 
+  // The indices are grouped into runs of consecutive indices, so that e.g.
+  // the indices [3, 4, 5] are processed as the single slice `params[3:6]`.
+  // For run `r` and ragged level `l` (level 0 being the indices, and the last
+  // level the dense values), the rows spanned by the run at that level are
+  // `[starts[r * num_levels + l], limits[r * num_levels + l])`, and the first
+  // of them is written to row `out_starts[r * num_levels + l]` of the output.
+  struct RowRuns {
+    int num_levels = 0;
+    int64_t num_runs = 0;
+    std::vector<SPLITS_TYPE> starts;
+    std::vector<SPLITS_TYPE> limits;
+    std::vector<SPLITS_TYPE> out_starts;
+    // The number of output rows at each level.
+    std::vector<SPLITS_TYPE> totals;
+  };
+
   // Check if any indices are out-of-bounds.
   ::tensorflow::Status ValidateIndices(const Tensor& indices_in,
                                        SPLITS_TYPE num_params) {
@@ -114,81 +182,53 @@ class RaggedGatherOpBase : public OpKernel {
     return OkStatus();
   }
 
-  // Construct the `splits` output tensors, encoded using a nested vector.
-  // Also find the slices of values that need to be copied, and store them
-  // in `value_slices`.  The total number of values that will be copied (which
-  // we need for allocating the output values tensor) is stored in `num_values`.
-  ::tensorflow::Status MakeSplits(
-      const Tensor& indices_in, const OpInputList& params_nested_splits_in,
-      SPLITS_TYPE num_params_dense_values,
-      std::vector<std::vector<SPLITS_TYPE>>* out_splits,
-      std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>* value_slices,
-      SPLITS_TYPE* num_values) {
-    *num_values = 0;
-    value_slices->clear();
-
-    int num_splits = indices_in.dims() - 1 + params_nested_splits_in.size();
-    out_splits->assign(num_splits, {0});
-
-    // Get Eigen tensors.
+  // Groups the indices into runs, and computes the rows spanned by each run
+  // at each ragged level, together with their position in the output, as an
+  // exclusive prefix sum of the numbers of rows of the previous runs.  Also
+  // finds the slices of values that need to be copied, and stores them in
+  // `value_slices`, merging the slices of consecutive runs when they are
+  // adjacent in `params`.
+  void MakeRowRuns(const Tensor& indices_in,
+                   const std::vector<ConstFlatType>& params_nested_splits,
+                   RowRuns* runs,
+                   std::vector<ValueSlice<SPLITS_TYPE>>* value_slices) {
     const auto& indices = indices_in.flat<INDEX_TYPE>();
-    std::vector<ConstFlatType> params_nested_splits;
-    params_nested_splits.reserve(params_nested_splits_in.size());
-    for (const auto& splits_in : params_nested_splits_in) {
-      params_nested_splits.push_back(splits_in.flat<SPLITS_TYPE>());
-    }
-
-    TF_RETURN_IF_ERROR(
-        ValidateSplits(params_nested_splits, num_params_dense_values));
+    const int num_levels = params_nested_splits.size() + 1;
+    runs->num_levels = num_levels;
+    runs->totals.assign(num_levels, 0);
+    value_slices->clear();
 
-    // Add `splits` that come from all but the last dimension of the dense
-    // Tensor `indices`.  In particular, for each dimension D, we add a
-    // splits tensor whose values are:
-    //   range(reduce_prod(splits.shape[:D]) + 1) * splits.shape[D+1]
-    // E.g., if indices.shape=[2, 3, 4] then we will add splits tensors:
-    //   [0, 3, 6]                    # length=2+1, stride=3
-    //   [0, 4, 8, 12, 16, 20, 24]    # length=2*3+1, stride=4
-    int nrows = 1;
-    for (int dim = 0; dim < indices_in.dims() - 1; ++dim) {
-      nrows *= indices_in.dim_size(dim);
-      int row_length = indices_in.dim_size(dim + 1);
-      for (int i = 1; i < nrows + 1; ++i) {
-        out_splits->at(dim).push_back(i * row_length);
+    for (int64_t i = 0; i < indices.size();) {
+      // Find the run of consecutive indices starting at `i`.
+      const SPLITS_TYPE first = indices(i);
+      int64_t end = i + 1;
+      while (end < indices.size() && indices(end) == first + (end - i)) {
+        ++end;
       }
-    }
-
-    // Add `splits` that come from `params_nested_splits`.  Starting with the
-    // outermost ragged dimension (i.e., the first `splits` tensor), we work
-    // our way in, finding the range of values that should be copied.  As we
-    // go, we update the output `splits` for each dimension with the appropriate
-    // values.  In particular, the *lengths* of the slices from `param_splits`
-    // should be copied to generate corresponding slice lengths in the output
-    // splits.  E.g., if we are copying a ragged row with length 4, then we
-    // should add a new split point to out_splits that is 4 greater than the
-    // previous split point in out_splits.
-    for (int i = 0; i < indices.size(); ++i) {
-      int start = indices(i);
-      int limit = indices(i) + 1;
-
-      // Copy splits.
-      for (int dim = 0; dim < params_nested_splits.size(); ++dim) {
-        const auto& splits = params_nested_splits[dim];
-        int out_dim = dim + indices_in.dims() - 1;
-        if (out_dim >= 0) {
-          SPLITS_TYPE delta = out_splits->at(out_dim).back() - splits(start);
-          for (int j = start; j < limit; ++j) {
-            out_splits->at(out_dim).push_back(splits(j + 1) + delta);
-          }
+      SPLITS_TYPE start = first;
+      SPLITS_TYPE limit = first + (end - i);
+      for (int level = 0; level < num_levels; ++level) {
+        runs->starts.push_back(start);
+        runs->limits.push_back(limit);
+        runs->out_starts.push_back(runs->totals[level]);
+        runs->totals[level] += limit - start;
+        if (level + 1 < num_levels) {
+          const auto& splits = params_nested_splits[level];
+          start = splits(start);
+          limit = splits(limit);
         }
-        start = splits(start);
-        limit = splits(limit);
       }
       if (limit != start) {
-        value_slices->emplace_back(start, limit);
-        *num_values += limit - start;
+        const SPLITS_TYPE out_start = runs->totals.back() - (limit - start);
+        if (!value_slices->empty() && value_slices->back().limit == start) {
+          value_slices->back().limit = limit;
+        } else {
+          value_slices->push_back({start, limit, out_start});
+        }
       }
+      ++runs->num_runs;
+      i = end;
     }
-    return OkStatus();
   }
 
   ::tensorflow::Status ValidateSplits(
@@ -219,27 +259,88 @@ class RaggedGatherOpBase : public OpKernel {
     return OkStatus();
   }
 
+  // Writes the `splits` output tensors.  The splits that come from the
+  // dimensions of `indices` are uniform, and the splits that come from
+  // `params_nested_splits` are written by the runs in parallel, at the
+  // positions computed by MakeRowRuns.
   ::tensorflow::Status WriteSplits(
-      const std::vector<std::vector<SPLITS_TYPE>>& out_splits,
-      OpKernelContext* context) {
+      const Tensor& indices_in,
+      const std::vector<ConstFlatType>& params_nested_splits,
+      const RowRuns& runs, OpKernelContext* context) {
     OpOutputList splits_out;
     TF_RETURN_IF_ERROR(
         context->output_list("output_nested_splits", &splits_out));
-    for (int i = 0; i < out_splits.size(); ++i) {
+
+    // Add `splits` that come from all but the last dimension of the dense
+    // Tensor `indices`.  In particular, for each dimension D, we add a
+    // splits tensor whose values are:
+    //   range(reduce_prod(splits.shape[:D]) + 1) * splits.shape[D+1]
+    // E.g., if indices.shape=[2, 3, 4] then we will add splits tensors:
+    //   [0, 3, 6]                    # length=2+1, stride=3
+    //   [0, 4, 8, 12, 16, 20, 24]    # length=2*3+1, stride=4
+    SPLITS_TYPE nrows = 1;
+    for (int dim = 0; dim < indices_in.dims() - 1; ++dim) {
+      nrows *= indices_in.dim_size(dim);
+      const SPLITS_TYPE row_length = indices_in.dim_size(dim + 1);
       Tensor* splits;
-      SPLITS_TYPE num_splits = out_splits[i].size();
       TF_RETURN_IF_ERROR(
-          splits_out.allocate(i, TensorShape({num_splits}), &splits));
+          splits_out.allocate(dim, TensorShape({nrows + 1}), &splits));
       auto splits_flat = splits->flat<SPLITS_TYPE>();
-      std::copy_n(out_splits[i].data(), out_splits[i].size(),
-                  splits_flat.data());
+      for (SPLITS_TYPE i = 0; i < nrows + 1; ++i) {
+        splits_flat(i) = i * row_length;
+      }
+    }
+
+    // Add `splits` that come from `params_nested_splits`.  The *lengths* of
+    // the rows copied from `params_splits` give the lengths of the rows of the
+    // output splits.  E.g., if we are copying a ragged row with length 4, then
+    // the split point that closes it in the output is 4 greater than the
+    // previous split point.  Since runs write disjoint ranges of the outputs,
+    // they are processed in parallel.
+    const int num_levels = runs.num_levels;
+    std::vector<SPLITS_TYPE*> out_splits(num_levels - 1, nullptr);
+    for (int level = 0; level < num_levels - 1; ++level) {
+      const int out_dim = level + indices_in.dims() - 1;
+      if (out_dim < 0) continue;
+      Tensor* splits;
+      TF_RETURN_IF_ERROR(splits_out.allocate(
+          out_dim, TensorShape({runs.totals[level] + 1}), &splits));
+      out_splits[level] = splits->flat<SPLITS_TYPE>().data();
+      out_splits[level][0] = 0;
+    }
+    auto write_runs = [&](int64_t begin, int64_t end) {
+      for (int64_t run = begin; run < end; ++run) {
+        for (int level = 0; level < num_levels - 1; ++level) {
+          if (out_splits[level] == nullptr) continue;
+          const int64_t pos = run * num_levels + level;
+          const auto& splits = params_nested_splits[level];
+          const SPLITS_TYPE start = runs.starts[pos];
+          // Position of the rows of the next level in the output.
+          const SPLITS_TYPE delta = runs.out_starts[pos + 1] - splits(start);
+          SPLITS_TYPE* out = out_splits[level] + runs.out_starts[pos] + 1;
+          for (SPLITS_TYPE j = start; j < runs.limits[pos]; ++j) {
+            *out++ = splits(j + 1) + delta;
+          }
+        }
+      }
+    };
+    if (runs.num_runs > 0) {
+      const int64_t num_out_splits = std::accumulate(
+          runs.totals.begin(), runs.totals.end() - 1, int64_t{0});
+      auto worker_threads =
+          context->device()->tensorflow_cpu_worker_threads();
+      Shard(worker_threads->num_threads, worker_threads->workers,
+            runs.num_runs,
+            std::max<int64_t>(1, num_out_splits / runs.num_runs) *
+                sizeof(SPLITS_TYPE),
+            write_runs);
     }
     return OkStatus();
   }
 
   ::tensorflow::Status WriteValues(
       const Tensor& params_dense_values_in,
-      const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
+      const std::vector<ValueSlice<SPLITS_TYPE>>& value_slices,
       int values_index, SPLITS_TYPE num_values,
       OpKernelContext* context) const {
     Tensor* values_out = nullptr;
@@ -251,8 +352,8 @@ class RaggedGatherOpBase : public OpKernel {
     const SPLITS_TYPE value_size =
         num_elements == 0 ? 0
                           : (num_elements / params_dense_values_in.dim_size(0));
-    CallWriteValueSlices(params_dense_values_in, value_slices, value_size,
-                         values_out);
+    CallWriteValueSlices(context, params_dense_values_in, value_slices,
+                         value_size, values_out);
     return OkStatus();
   }
 
@@ -263,8 +364,8 @@ class RaggedGatherOpBase : public OpKernel {
   // index type), rather than 14 (one for each index type and value type),
   // which cuts the binary size of this op from ~300k to <90k.
   virtual void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
-      const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
+      OpKernelContext* context, const Tensor& params_dense_values_in,
+      const std::vector<ValueSlice<SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const = 0;
 };
 
@@ -275,14 +376,13 @@ class RaggedGatherOp : public RaggedGatherOpBase<INDEX_TYPE, SPLITS_TYPE> {
 
  private:
   void CallWriteValueSlices(
-      const Tensor& params_dense_values_in,
-      const std::vector<std::pair<SPLITS_TYPE, SPLITS_TYPE>>& value_slices,
+      OpKernelContext* context, const Tensor& params_dense_values_in,
+      const std::vector<ValueSlice<SPLITS_TYPE>>& value_slices,
       SPLITS_TYPE value_size, Tensor* values_out) const override {
-    WriteValueSlices<VALUE_TYPE>(params_dense_values_in, value_slices,
+    WriteValueSlices<VALUE_TYPE>(context, params_dense_values_in, value_slices,
                                  value_size, values_out);
   }
 };
-
 #define REGISTER_CPU_KERNEL_WITH_INDEX_TYPE(index_type, value_type, \
                                             splits_type)            \
   REGISTER_KERNEL_BUILDER(                                          \
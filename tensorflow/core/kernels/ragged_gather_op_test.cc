@@ -175,6 +175,67 @@ TEST_F(RaggedGatherOpTest, RaggedGather_ScalarIndices) {
                                 test::AsTensor<float>({.4, .5, .6, .7}), 0.1);
 }
 
+TEST_F(RaggedGatherOpTest, RaggedGather_ConsecutiveIndices) {
+  // indices = [1, 2, 3, 0, 1]
+  // params = [[.1, .2, .3], [], [.4, .5, .6, .7], [.8, .9]]
+  BuildRaggedGatherGraph<float, int32>(
+      TensorShape({5}),                     // indices.shape
+      {1, 2, 3, 0, 1},                      // indices
+      {{0, 3, 3, 7, 9}},                    // params_nested_splits
+      TensorShape({9}),                     // params_dense_values.shape
+      {.1, .2, .3, .4, .5, .6, .7, .8, .9}  // params_dense_values
+  );
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Expected: [[], [.4, .5, .6, .7], [.8, .9], [.1, .2, .3], []]
+  test::ExpectTensorEqual<int64_t>(
+      *GetOutput(0), test::AsTensor<int64_t>({0, 0, 4, 6, 9, 9}));
+  test::ExpectTensorNear<float>(
+      *GetOutput(1),
+      test::AsTensor<float>({.4, .5, .6, .7, .8, .9, .1, .2, .3}), 0.1);
+}
+
+TEST_F(RaggedGatherOpTest, RaggedGather_ManyRows) {
+  // params[i] = [[i, i], ...] with `i % 5` values of shape [2], and indices
+  // alternate between runs of consecutive rows and single rows.
+  constexpr int kNumParams = 3000;
+  std::vector<int64_t> params_splits = {0};
+  std::vector<tstring> params_values;
+  for (int i = 0; i < kNumParams; ++i) {
+    params_splits.push_back(params_splits.back() + i % 5);
+    for (int j = 0; j < 2 * (i % 5); ++j) {
+      params_values.push_back(std::to_string(i));
+    }
+  }
+  std::vector<int32> indices;
+  for (int i = 0; i < kNumParams; i += 7) {
+    for (int j = i; j < std::min(i + 4, kNumParams); ++j) indices.push_back(j);
+    indices.push_back(kNumParams - 1 - i);
+  }
+  const int64_t num_params_values = params_splits.back();
+  BuildRaggedGatherGraph<tstring, int32>(
+      TensorShape({static_cast<int64_t>(indices.size())}), indices,
+      {params_splits}, TensorShape({num_params_values, 2}), params_values);
+
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<int64_t> expected_splits = {0};
+  std::vector<tstring> expected_values;
+  for (int32 index : indices) {
+    expected_splits.push_back(expected_splits.back() + index % 5);
+    for (int j = 0; j < 2 * (index % 5); ++j) {
+      expected_values.push_back(std::to_string(index));
+    }
+  }
+  const int64_t num_values = expected_splits.back();
+  test::ExpectTensorEqual<int64_t>(*GetOutput(0),
+                                   test::AsTensor<int64_t>(expected_splits));
+  test::ExpectTensorEqual<tstring>(
+      *GetOutput(1),
+      test::AsTensor<tstring>(expected_values, TensorShape({num_values, 2})));
+}
+
 TEST_F(RaggedGatherOpTest, RaggedGather_OutOfBounds) {
   // indices = [2, 10]
   // params = [[.1, .2, .3], [], [.4, .5, .6, .7], [.8, .9]]
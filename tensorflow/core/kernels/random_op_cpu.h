@@ -21,6 +21,7 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <memory>
+#include <type_traits>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/random_op.h"
 #include "tensorflow/core/kernels/random_ops_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/random/philox_random_batch.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/logging.h"
@@ -76,6 +78,20 @@ struct FillPhiloxRandom {
 template <class Distribution, bool VariableSamplesPerOutput>
 struct FillPhiloxRandomTask;
 
+// Rebinds a distribution over PhiloxRandom to another generator `Generator`.
+// Only stateless distributions are rebound, since the state of the others
+// cannot be carried over generically.
+template <class Distribution, class Generator>
+struct RebindPhiloxDistribution {
+  static constexpr bool kSupported = false;
+};
+
+template <template <class, typename> class D, typename T, class Generator>
+struct RebindPhiloxDistribution<D<PhiloxRandom, T>, Generator> {
+  static constexpr bool kSupported = std::is_empty<D<PhiloxRandom, T>>::value;
+  typedef D<Generator, T> Type;
+};
+
 // Specialization for distribution that takes a fixed number of samples for
 // each output.
 template <class Distribution>
@@ -90,7 +106,32 @@ struct FillPhiloxRandomTask<Distribution, false> {
 
     // First fill all the full-size groups
     int64_t limit_group_full = std::min(limit_group, size / kGroupSize);
-    for (int64_t index = start_group; index < limit_group_full; ++index) {
+    int64_t index = start_group;
+    if constexpr (RebindPhiloxDistribution<
+                      Distribution,
+                      random::PrecomputedPhiloxRandom>::kSupported) {
+      // Generate the random bits of a batch of groups with SIMD instructions,
+      // and then transform them. The results are the same as with `gen`.
+      typedef typename RebindPhiloxDistribution<
+          Distribution, random::PrecomputedPhiloxRandom>::Type
+          BatchDistribution;
+      constexpr int64_t kBatchGroups = 64;
+      alignas(64) uint32 bits[kBatchGroups * PhiloxRandom::kResultElementCount];
+      BatchDistribution batch_dist;
+      for (; index < limit_group_full; index += kBatchGroups) {
+        const int64_t num_groups =
+            std::min(kBatchGroups, limit_group_full - index);
+        random::GeneratePhiloxBatch(&gen, num_groups, bits);
+        random::PrecomputedPhiloxRandom precomputed(bits);
+        for (int64_t i = 0; i < num_groups; ++i) {
+          auto samples = batch_dist(&precomputed);
+          std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
+          offset += kGroupSize;
+        }
+      }
+      index = limit_group_full;
+    }
+    for (; index < limit_group_full; ++index) {
       auto samples = dist(&gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
@@ -23,6 +23,9 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
@@ -268,9 +271,155 @@ struct ReduceFunctorBase {
   }
 };
 
+// Sum and mean reductions of bfloat16 and half that are computed on the CPU
+// by `ReduceHalfFloatCPU` below.
+template <typename Reducer>
+struct HalfFloatReducerTraits {
+  static constexpr bool kSupported = false;
+  static constexpr bool kIsMean = false;
+};
+
+#define HALF_FLOAT_REDUCER(Reducer, T, is_mean)       \
+  template <>                                         \
+  struct HalfFloatReducerTraits<Reducer<T>> {         \
+    static constexpr bool kSupported = true;          \
+    static constexpr bool kIsMean = is_mean;          \
+  };
+HALF_FLOAT_REDUCER(Eigen::internal::SumReducer, bfloat16, false)
+HALF_FLOAT_REDUCER(Eigen::internal::SumReducer, Eigen::half, false)
+HALF_FLOAT_REDUCER(functor::MeanReducer, bfloat16, true)
+HALF_FLOAT_REDUCER(functor::MeanReducer, Eigen::half, true)
+#undef HALF_FLOAT_REDUCER
+
+// Returns the sum of `in[0, n)` accumulated in float. The independent
+// accumulators let the compiler keep them in SIMD registers.
+template <typename T>
+inline float SumAsFloat(const T* in, int64_t n) {
+  constexpr int kLanes = 16;
+  float acc[kLanes] = {0.0f};
+  int64_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int k = 0; k < kLanes; ++k) acc[k] += static_cast<float>(in[i + k]);
+  }
+  float sum = 0.0f;
+  for (; i < n; ++i) sum += static_cast<float>(in[i]);
+  for (int k = 0; k < kLanes; ++k) sum += acc[k];
+  return sum;
+}
+
+// Adds `in[0, n)` to `acc[0, n)`.
+template <typename T>
+inline void AddAsFloat(const T* in, int64_t n, float* acc) {
+  for (int64_t i = 0; i < n; ++i) acc[i] += static_cast<float>(in[i]);
+}
+
+// Reduces the row-major `rows` x `cols` matrix `in` along its inner dimension
+// (`reduce_inner`) or its outer dimension into `out`, accumulating in float,
+// and multiplies the result by `scale`. Rows, or blocks of columns, are
+// computed in parallel. When there are too few of them to use all threads,
+// the reduced dimension is also split into chunks whose partial sums are
+// added at the end.
+template <typename T>
+void ReduceHalfFloatCPU(const CPUDevice& d, const T* in, int64_t rows,
+                        int64_t cols, bool reduce_inner, float scale, T* out) {
+  // Minimum number of elements reduced by one task.
+  constexpr int64_t kMinChunkSize = 16 << 10;
+  // Number of columns of a task of an outer reduction.
+  constexpr int64_t kBlockCols = 1024;
+  const int64_t num_threads = d.numThreads();
+  const int64_t reduced = reduce_inner ? cols : rows;
+  const int64_t num_outputs = reduce_inner ? rows : cols;
+  const int64_t num_blocks =
+      reduce_inner ? rows : Eigen::divup(cols, kBlockCols);
+  const int64_t num_chunks =
+      num_blocks >= num_threads
+          ? 1
+          : std::max<int64_t>(
+                1, std::min(Eigen::divup(num_threads, num_blocks),
+                            reduced / kMinChunkSize));
+  const int64_t chunk_size = Eigen::divup(reduced, num_chunks);
+
+  // With a single chunk, the tasks write to `out` directly.
+  std::vector<float> partials(num_chunks > 1 ? num_chunks * num_outputs : 0);
+  auto store = [&](int64_t chunk, int64_t index, float value) {
+    if (num_chunks > 1) {
+      partials[chunk * num_outputs + index] = value;
+    } else {
+      out[index] = static_cast<T>(value * scale);
+    }
+  };
+
+  const int64_t block_size =
+      reduce_inner ? cols : std::min(cols, kBlockCols) * rows;
+  const Eigen::TensorOpCost cost(
+      /*bytes_loaded=*/sizeof(T) * block_size / num_chunks,
+      /*bytes_stored=*/sizeof(float) * (reduce_inner ? 1 : kBlockCols),
+      /*compute_cycles=*/block_size / num_chunks);
+  d.parallelFor(
+      num_blocks * num_chunks, cost, [&](int64_t first, int64_t last) {
+        float acc[kBlockCols];
+        for (int64_t task = first; task < last; ++task) {
+          const int64_t block = task / num_chunks;
+          const int64_t chunk = task % num_chunks;
+          const int64_t begin = chunk * chunk_size;
+          const int64_t end = std::min(reduced, begin + chunk_size);
+          if (reduce_inner) {
+            store(chunk, block,
+                  SumAsFloat(in + block * cols + begin, end - begin));
+            continue;
+          }
+          const int64_t col_begin = block * kBlockCols;
+          const int64_t width = std::min(kBlockCols, cols - col_begin);
+          std::fill(acc, acc + width, 0.0f);
+          for (int64_t row = begin; row < end; ++row) {
+            AddAsFloat(in + row * cols + col_begin, width, acc);
+          }
+          for (int64_t k = 0; k < width; ++k) {
+            store(chunk, col_begin + k, acc[k]);
+          }
+        }
+      });
+
+  if (num_chunks > 1) {
+    for (int64_t i = 0; i < num_outputs; ++i) {
+      float sum = 0.0f;
+      for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        sum += partials[chunk * num_outputs + i];
+      }
+      out[i] = static_cast<T>(sum * scale);
+    }
+  }
+}
+
 template <typename Reducer>
 struct ReduceFunctor<CPUDevice, Reducer>
-    : ReduceFunctorBase<CPUDevice, Reducer> {};
+    : ReduceFunctorBase<CPUDevice, Reducer> {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static void Reduce(OpKernelContext* ctx, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes,
+                     const Reducer& reducer) {
+    typedef HalfFloatReducerTraits<Reducer> Traits;
+    // Reductions of a vector to a scalar, and of a matrix along one of its
+    // dimensions, of bfloat16 or half are computed in float, rather than by
+    // Eigen with a conversion of each element.
+    if constexpr (Traits::kSupported && IN_T::NumIndices <= 2 &&
+                  OUT_T::NumIndices + 1 == IN_T::NumIndices) {
+      const int64_t rows = IN_T::NumIndices == 2 ? in.dimension(0) : 1;
+      const int64_t cols = in.dimension(IN_T::NumIndices - 1);
+      const bool reduce_inner =
+          IN_T::NumIndices == 1 || reduction_axes[0] == 1;
+      const float scale =
+          Traits::kIsMean ? 1.0f / (reduce_inner ? cols : rows) : 1.0f;
+      if (in.size() > 0) {
+        ReduceHalfFloatCPU(ctx->eigen_device<CPUDevice>(), in.data(), rows,
+                           cols, reduce_inner, scale, out.data());
+        return;
+      }
+    }
+    ReduceFunctorBase<CPUDevice, Reducer>::Reduce(ctx, out, in,
+                                                  reduction_axes, reducer);
+  }
+};
 
 }  // namespace functor
 }  // namespace tensorflow
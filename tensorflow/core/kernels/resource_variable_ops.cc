@@ -57,6 +57,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/strings/str_join.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -145,6 +146,19 @@ void ReadVariableOp::Compute(OpKernelContext* ctx) {
                   "Debug info: container=", handle.container(),
                   ", status error message=", status.error_message()));
 
+  // In snapshot mode, alias the last published value without waiting for
+  // concurrent writers.
+  Tensor snapshot;
+  if (variable->ReadSnapshot(&snapshot)) {
+    OP_REQUIRES(
+        ctx, dtype_ == snapshot.dtype(),
+        errors::InvalidArgument(
+            "Trying to read variable with wrong dtype. Expected ",
+            DataTypeString(dtype_), " got ", DataTypeString(snapshot.dtype())));
+    ctx->set_output(0, snapshot);
+    return;
+  }
+
   tf_shared_lock ml(*variable->mu());
   // We're acquiring a reference to the underlying buffer while
   // holding a shared lock to guarantee ordering of reads and
@@ -195,6 +209,18 @@ void ReadVariablesOp::Compute(OpKernelContext* ctx) {
                   absl::StrJoin(uninitialized_vars, ", ")));
 
   for (size_t i = 0; i < dtypes_.size(); ++i) {
+    Tensor snapshot;
+    if (variables[i]->ReadSnapshot(&snapshot)) {
+      OP_REQUIRES(ctx, dtypes_[i] == snapshot.dtype(),
+                  errors::InvalidArgument(
+                      "Trying to read variable ", handles[i]->name(),
+                      " from Container: ", handles[i]->container(),
+                      " with wrong dtype. Expected ",
+                      DataTypeString(dtypes_[i]), " got ",
+                      DataTypeString(snapshot.dtype())));
+      ctx->set_output(i, snapshot);
+      continue;
+    }
     // We're acquiring a reference to the underlying buffer while
     // holding a shared lock to guarantee ordering of reads and
     // writes.
@@ -464,6 +490,8 @@ class AssignVariableOp : public OpKernel {
       *variable->tensor() = value;
     }
     variable->is_initialized = true;
+    variable->PublishSnapshot();
+    variable->MarkAllRowsDirty();
   }
 
  private:
@@ -522,6 +550,8 @@ class AssignVariableOp<Device, Variant> : public OpKernel {
 
     if (input_alias) {
       *variable->tensor() = *input_alias;
+      variable->PublishSnapshot();
+      variable->MarkAllRowsDirty();
       return;
     }
 
@@ -539,6 +569,8 @@ class AssignVariableOp<Device, Variant> : public OpKernel {
     for (int64_t i = 0; i < elements_in.size(); ++i) {
       elements_out(i) = elements_in(i);
     }
+    variable->PublishSnapshot();
+    variable->MarkAllRowsDirty();
   }
 
  private:
@@ -605,6 +637,8 @@ class AssignUpdateVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(), var_tensor->flat<T>(),
                    value.flat<T>());
+    variable->MaybePublishSnapshot();
+    variable->MarkAllRowsDirty();
   }
 };
 
@@ -681,13 +715,19 @@ class ResourceGatherOp : public OpKernel {
     core::RefCountPtr<Var> v;
     OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
     OP_REQUIRES_OK(c, EnsureSparseVariableAccess<Device, T>(c, v.get()));
-    // NOTE: We hold the lock for the whole gather operation instead
-    // of increasing the reference count of v->tensor() to avoid a
-    // situation where a write to the same variable will see a
-    // reference count greater than one and make a copy of the
-    // (potentially very large) tensor buffer.
-    tf_shared_lock ml(*v->mu());
-    const Tensor& params = *v->tensor();
+    // In snapshot mode, gather from the last published value without waiting
+    // for concurrent writers. Writers already copy the published buffer.
+    Tensor snapshot;
+    absl::optional<tf_shared_lock> ml;
+    if (!v->ReadSnapshot(&snapshot)) {
+      // NOTE: We hold the lock for the whole gather operation instead
+      // of increasing the reference count of v->tensor() to avoid a
+      // situation where a write to the same variable will see a
+      // reference count greater than one and make a copy of the
+      // (potentially very large) tensor buffer.
+      ml.emplace(*v->mu());
+    }
+    const Tensor& params = ml.has_value() ? *v->tensor() : snapshot;
     const Tensor& indices = c->input(1);
     OP_REQUIRES(
         c, TensorShapeUtils::IsVectorOrHigher(params.shape()),
@@ -1047,13 +1087,23 @@ class ResourceScatterUpdateOp : public OpKernel {
     const bool is_non_pod_dtype = c->input_dtype(0) == DT_RESOURCE ||
                                   c->input_dtype(0) == DT_STRING ||
                                   c->input_dtype(0) == DT_VARIANT;
-    if (is_non_pod_dtype || use_exclusive_lock_) {
+    if (v->snapshot_mode()) {
+      // Snapshot mode requires exclusive access to publish the update.
+      mutex_lock ml(*v->mu());
+      OP_REQUIRES_OK(c,
+                     PrepareToUpdateSnapshotVariable<Device, T>(c, v.get()));
+      DoCompute(c);
+      v->MaybePublishSnapshot();
+      v->MarkRowsDirty(c->input(1));
+    } else if (is_non_pod_dtype || use_exclusive_lock_) {
       mutex_lock ml(*v->mu());
       DoCompute(c);
+      v->MarkRowsDirty(c->input(1));
     } else {
       // For POD dtypes, we can safely run the update without the mutex.
       tf_shared_lock ml(*v->mu());
       DoCompute(c);
+      v->MarkRowsDirty(c->input(1));
     }
   }
 
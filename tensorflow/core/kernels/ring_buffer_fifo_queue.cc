@@ -0,0 +1,598 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/ring_buffer_fifo_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Limits on the memory allocated up front by a RingBufferFIFOQueue. Queues
+// with larger elements gain little from avoiding `mu_`, and are better served
+// by FIFOQueue, which does not copy the enqueued tensors.
+constexpr int64_t kMaxElementBytes = 16 << 10;
+constexpr int64_t kMaxBufferBytes = 64 << 20;
+
+char* ElementData(const Tensor& t, int64_t index, int64_t element_bytes) {
+  return static_cast<char*>(t.data()) + index * element_bytes;
+}
+
+}  // namespace
+
+RingBufferFIFOQueue::RingBufferFIFOQueue(
+    int32_t capacity, const DataTypeVector& component_dtypes,
+    const std::vector<TensorShape>& component_shapes, const string& name)
+    : QueueBase(capacity, component_dtypes, component_shapes, name) {}
+
+/* static */
+bool RingBufferFIFOQueue::IsSupported(
+    int32_t capacity, const DataTypeVector& component_dtypes,
+    const std::vector<TensorShape>& component_shapes) {
+  if (capacity <= 0 || capacity == kUnbounded || component_dtypes.empty() ||
+      component_dtypes.size() != component_shapes.size()) {
+    return false;
+  }
+  int64_t element_bytes = 0;
+  for (int i = 0; i < component_dtypes.size(); ++i) {
+    if (!DataTypeCanUseMemcpy(component_dtypes[i]) ||
+        component_shapes[i].num_elements() == 0) {
+      return false;
+    }
+    element_bytes +=
+        DataTypeSize(component_dtypes[i]) * component_shapes[i].num_elements();
+  }
+  return element_bytes <= kMaxElementBytes &&
+         element_bytes * capacity <= kMaxBufferBytes;
+}
+
+Status RingBufferFIFOQueue::Initialize() {
+  if (!IsSupported(capacity_, component_dtypes_, component_shapes_)) {
+    return errors::InvalidArgument(
+        "Unsupported attributes for RingBufferFIFOQueue ", name_,
+        ": capacity ", capacity_,
+        ", types: ", DataTypeSliceString(component_dtypes_),
+        ", shapes: ", ShapeListString(component_shapes_));
+  }
+  buffers_.reserve(num_components());
+  element_bytes_.reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    buffers_.emplace_back(cpu_allocator(), component_dtypes_[i],
+                          ManyOutShape(i, capacity_));
+    if (!buffers_.back().IsInitialized()) {
+      return errors::ResourceExhausted("Failed to allocate the buffers of ",
+                                       "queue ", name_);
+    }
+    element_bytes_.push_back(DataTypeSize(component_dtypes_[i]) *
+                             component_shapes_[i].num_elements());
+  }
+  return OkStatus();
+}
+
+int64_t RingBufferFIFOQueue::ReserveEnqueue(int64_t min_n, int64_t max_n,
+                                            uint64* pos) {
+  uint64 head = prod_head_.load(std::memory_order_relaxed);
+  while (true) {
+    // If `head` is stale, `free` may exceed the capacity, but then the
+    // compare-and-swap below fails.
+    const uint64 free = capacity_ + cons_tail_.load() - head;
+    if (free == 0 || free < static_cast<uint64>(min_n)) return 0;
+    const int64_t n = std::min<uint64>(max_n, free);
+    if (prod_head_.compare_exchange_weak(head, head + n)) {
+      *pos = head;
+      return n;
+    }
+  }
+}
+
+int64_t RingBufferFIFOQueue::ReserveDequeue(int64_t min_n, int64_t max_n,
+                                            uint64* pos) {
+  uint64 head = cons_head_.load(std::memory_order_relaxed);
+  while (true) {
+    const uint64 entries = prod_tail_.load() - head;
+    // A stale `head` may make `entries` wrap around, in that case the
+    // compare-and-swap below fails.
+    if (entries == 0 || entries < static_cast<uint64>(min_n)) return 0;
+    const int64_t n = std::min<uint64>(max_n, entries);
+    if (cons_head_.compare_exchange_weak(head, head + n)) {
+      *pos = head;
+      return n;
+    }
+  }
+}
+
+void RingBufferFIFOQueue::CommitEnqueue(uint64 pos, int64_t n) {
+  while (prod_tail_.load(std::memory_order_acquire) != pos) {
+    std::this_thread::yield();
+  }
+  prod_tail_.store(pos + n);
+}
+
+void RingBufferFIFOQueue::CommitDequeue(uint64 pos, int64_t n) {
+  while (cons_tail_.load(std::memory_order_acquire) != pos) {
+    std::this_thread::yield();
+  }
+  cons_tail_.store(pos + n);
+}
+
+void RingBufferFIFOQueue::CopyToRing(const Tuple& tuple, int64_t index,
+                                     uint64 pos, int64_t n) {
+  const int64_t slot = pos % capacity_;
+  const int64_t first = std::min<int64_t>(n, capacity_ - slot);
+  for (int i = 0; i < num_components(); ++i) {
+    const int64_t bytes = element_bytes_[i];
+    const char* src = ElementData(tuple[i], index, bytes);
+    memcpy(ElementData(buffers_[i], slot, bytes), src, first * bytes);
+    if (first < n) {
+      memcpy(ElementData(buffers_[i], 0, bytes), src + first * bytes,
+             (n - first) * bytes);
+    }
+  }
+}
+
+void RingBufferFIFOQueue::CopyFromRing(uint64 pos, int64_t n, Tuple* tuple,
+                                       int64_t index) {
+  const int64_t slot = pos % capacity_;
+  const int64_t first = std::min<int64_t>(n, capacity_ - slot);
+  for (int i = 0; i < num_components(); ++i) {
+    const int64_t bytes = element_bytes_[i];
+    char* dst = ElementData((*tuple)[i], index, bytes);
+    memcpy(dst, ElementData(buffers_[i], slot, bytes), first * bytes);
+    if (first < n) {
+      memcpy(dst + first * bytes, ElementData(buffers_[i], 0, bytes),
+             (n - first) * bytes);
+    }
+  }
+}
+
+int64_t RingBufferFIFOQueue::RingEnqueue(const Tuple& tuple, int64_t index,
+                                         int64_t min_n, int64_t max_n) {
+  uint64 pos;
+  const int64_t n = ReserveEnqueue(min_n, max_n, &pos);
+  if (n > 0) {
+    CopyToRing(tuple, index, pos, n);
+    CommitEnqueue(pos, n);
+  }
+  return n;
+}
+
+int64_t RingBufferFIFOQueue::RingDequeue(int64_t min_n, int64_t max_n,
+                                         Tuple* tuple, int64_t index) {
+  uint64 pos;
+  const int64_t n = ReserveDequeue(min_n, max_n, &pos);
+  if (n > 0) {
+    CopyFromRing(pos, n, tuple, index);
+    CommitDequeue(pos, n);
+  }
+  return n;
+}
+
+int64_t RingBufferFIFOQueue::RingSize() const {
+  const uint64 head = cons_head_.load();
+  const uint64 tail = prod_tail_.load();
+  return tail > head ? tail - head : 0;
+}
+
+int32 RingBufferFIFOQueue::size() const {
+  const uint64 cons_tail = cons_tail_.load();
+  const uint64 prod_tail = prod_tail_.load();
+  return (prod_tail > cons_tail ? prod_tail - cons_tail : 0) +
+         num_restored_.load();
+}
+
+int64_t RingBufferFIFOQueue::MemoryUsed() const {
+  int64_t memory_size = 0;
+  for (const Tensor& buffer : buffers_) {
+    memory_size += buffer.TotalBytes();
+  }
+  return memory_size;
+}
+
+int64_t RingBufferFIFOQueue::DequeueLocked(int64_t min_n, int64_t max_n,
+                                           Tuple* tuple, int64_t index) {
+  const int64_t num_restored = std::min<int64_t>(max_n, restored_.size());
+  int64_t num_from_ring = 0;
+  uint64 pos = 0;
+  if (num_restored < max_n) {
+    num_from_ring = ReserveDequeue(std::max<int64_t>(min_n - num_restored, 0),
+                                   max_n - num_restored, &pos);
+    if (num_from_ring == 0 && num_restored < min_n) return 0;
+  }
+  for (int64_t j = 0; j < num_restored; ++j) {
+    for (int i = 0; i < num_components(); ++i) {
+      const int64_t bytes = element_bytes_[i];
+      memcpy(ElementData((*tuple)[i], index + j, bytes),
+             restored_.front()[i].data(), bytes);
+    }
+    restored_.pop_front();
+  }
+  num_restored_.fetch_sub(num_restored);
+  if (num_from_ring > 0) {
+    CopyFromRing(pos, num_from_ring, tuple, index + num_restored);
+    CommitDequeue(pos, num_from_ring);
+  }
+  return num_restored + num_from_ring;
+}
+
+Status RingBufferFIFOQueue::RestoreLocked(const Tuple& tuple,
+                                          int64_t num_elements,
+                                          OpKernelContext* ctx) {
+  for (int64_t j = num_elements - 1; j >= 0; --j) {
+    Tuple element;
+    TF_RETURN_IF_ERROR(AllocateTuple(ctx, -1, &element));
+    for (int i = 0; i < num_components(); ++i) {
+      const int64_t bytes = element_bytes_[i];
+      memcpy(element[i].data(), ElementData(tuple[i], j, bytes), bytes);
+    }
+    restored_.push_front(std::move(element));
+    num_restored_.fetch_add(1);
+  }
+  return OkStatus();
+}
+
+Status RingBufferFIFOQueue::AllocateTuple(OpKernelContext* ctx,
+                                          int64_t batch_size, Tuple* tuple) {
+  tuple->clear();
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor element;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        component_dtypes_[i],
+        batch_size < 0 ? component_shapes_[i] : ManyOutShape(i, batch_size),
+        &element));
+    tuple->push_back(std::move(element));
+  }
+  return OkStatus();
+}
+
+bool RingBufferFIFOQueue::TryEnqueueWithoutBlocking(const Tuple& tuple,
+                                                    int64_t n) {
+  if (num_pending_enqueues_.load() > 0) return false;
+  // Close() sets `closing_` and then waits for the active enqueues, so that
+  // an enqueue never succeeds after the queue is closed.
+  num_active_enqueues_.fetch_add(1);
+  const bool enqueued = !closing_.load() && RingEnqueue(tuple, 0, n, n) > 0;
+  num_active_enqueues_.fetch_sub(1);
+  // Blocked dequeues register before checking the ring buffers, so either
+  // they see the new elements, or they are seen here.
+  if (enqueued && num_pending_dequeues_.load() > 0) FlushUnlocked();
+  return enqueued;
+}
+
+bool RingBufferFIFOQueue::TryDequeueWithoutBlocking(OpKernelContext* ctx,
+                                                    int64_t batch_size,
+                                                    Tuple* tuple) {
+  const int64_t n = std::max<int64_t>(batch_size, 1);
+  if (n > capacity_ || num_pending_dequeues_.load() > 0 ||
+      num_restored_.load() > 0 || RingSize() < n) {
+    return false;
+  }
+  // On allocation failure, the blocking path reports the error.
+  if (!AllocateTuple(ctx, batch_size, tuple).ok()) return false;
+  if (RingDequeue(n, n, tuple, 0) == 0) return false;
+  if (num_pending_enqueues_.load() > 0) FlushUnlocked();
+  return true;
+}
+
+QueueInterface::DoneCallback RingBufferFIFOQueue::EnqueueDone(
+    DoneCallback callback) {
+  return [this, callback]() {
+    num_pending_enqueues_.fetch_sub(1);
+    callback();
+  };
+}
+
+QueueInterface::DoneCallback RingBufferFIFOQueue::DequeueDone(
+    CallbackWithTuple callback, Tuple tuple) {
+  return [this, callback, tuple]() {
+    num_pending_dequeues_.fetch_sub(1);
+    callback(tuple);
+  };
+}
+
+void RingBufferFIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                                     DoneCallback callback) {
+  if (TryEnqueueWithoutBlocking(tuple, 1)) {
+    callback();
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      num_pending_enqueues_.fetch_add(1);
+      enqueue_attempts_.emplace_back(
+          1, EnqueueDone(callback), ctx, cm, token,
+          [tuple, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_) {
+              attempt->context->SetStatus(
+                  errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            return RingEnqueue(tuple, 0, 1, 1) > 0 ? kComplete : kNoProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void RingBufferFIFOQueue::TryEnqueueMany(const Tuple& tuple,
+                                         OpKernelContext* ctx,
+                                         DoneCallback callback) {
+  const int64_t batch_size = tuple[0].dim_size(0);
+  if (batch_size == 0 ||
+      (batch_size <= capacity_ &&
+       TryEnqueueWithoutBlocking(tuple, batch_size))) {
+    callback();
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kEnqueue, cm, token); });
+    if (!already_cancelled) {
+      num_pending_enqueues_.fetch_add(1);
+      enqueue_attempts_.emplace_back(
+          batch_size, EnqueueDone(callback), ctx, cm, token,
+          [tuple, batch_size,
+           this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (closed_) {
+              attempt->context->SetStatus(
+                  errors::Cancelled("FIFOQueue '", name_, "' is closed."));
+              return kComplete;
+            }
+            // Like FIFOQueue, enqueue as many elements as fit.
+            const int64_t n =
+                RingEnqueue(tuple, batch_size - attempt->elements_requested,
+                            1, attempt->elements_requested);
+            if (n == 0) return kNoProgress;
+            attempt->elements_requested -= n;
+            return attempt->elements_requested == 0 ? kComplete : kProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Enqueue operation was cancelled"));
+    callback();
+  }
+}
+
+void RingBufferFIFOQueue::TryDequeue(OpKernelContext* ctx,
+                                     CallbackWithTuple callback) {
+  Tuple tuple;
+  if (TryDequeueWithoutBlocking(ctx, -1, &tuple)) {
+    callback(tuple);
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      num_pending_dequeues_.fetch_add(1);
+      dequeue_attempts_.emplace_back(
+          1, DequeueDone(callback, Tuple()), ctx, cm, token,
+          [callback, this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            if (!restored_.empty()) {
+              Tuple tuple = std::move(restored_.front());
+              restored_.pop_front();
+              num_restored_.fetch_sub(1);
+              attempt->done_callback = DequeueDone(callback, std::move(tuple));
+              return kComplete;
+            }
+            if (RingSize() > 0) {
+              Tuple tuple;
+              attempt->context->SetStatus(
+                  AllocateTuple(attempt->context, -1, &tuple));
+              if (!attempt->context->status().ok()) return kComplete;
+              if (RingDequeue(1, 1, &tuple, 0) > 0) {
+                attempt->done_callback =
+                    DequeueDone(callback, std::move(tuple));
+                return kComplete;
+              }
+            }
+            if (closed_) {
+              attempt->context->SetStatus(errors::OutOfRange(
+                  "FIFOQueue '", name_, "' is closed and has ",
+                  "insufficient elements (requested ", 1,
+                  ", current size ", 0, ")"));
+              return kComplete;
+            }
+            return kNoProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(Tuple());
+  }
+}
+
+void RingBufferFIFOQueue::TryDequeueMany(int num_elements,
+                                         OpKernelContext* ctx,
+                                         bool allow_small_batch,
+                                         CallbackWithTuple callback) {
+  Tuple tuple;
+  if (num_elements == 0) {
+    Status status = AllocateTuple(ctx, 0, &tuple);
+    if (!status.ok()) {
+      ctx->SetStatus(status);
+      tuple.clear();
+    }
+    callback(tuple);
+    return;
+  }
+  if (TryDequeueWithoutBlocking(ctx, num_elements, &tuple)) {
+    callback(tuple);
+    return;
+  }
+
+  CancellationManager* cm = ctx->cancellation_manager();
+  CancellationToken token = cm->get_cancellation_token();
+  bool already_cancelled;
+  {
+    mutex_lock l(mu_);
+    already_cancelled = !cm->RegisterCallback(
+        token, [this, cm, token]() { Cancel(kDequeue, cm, token); });
+    if (!already_cancelled) {
+      num_pending_dequeues_.fetch_add(1);
+      dequeue_attempts_.emplace_back(
+          num_elements, DequeueDone(callback, Tuple()), ctx, cm, token,
+          [callback, allow_small_batch, num_elements,
+           this](Attempt* attempt) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+            OpKernelContext* context = attempt->context;
+            const int64_t num_dequeued =
+                attempt->tuple.empty()
+                    ? 0
+                    : num_elements - attempt->elements_requested;
+            const int64_t available = restored_.size() + RingSize();
+
+            if (closed_ && available < attempt->elements_requested) {
+              if (allow_small_batch && num_dequeued + available > 0) {
+                // Return all the remaining elements.
+                if (attempt->tuple.empty()) {
+                  context->SetStatus(
+                      AllocateTuple(context, available, &attempt->tuple));
+                  if (!context->status().ok()) return kComplete;
+                }
+                const int64_t n = DequeueLocked(0, available, &attempt->tuple,
+                                                num_dequeued);
+                // The elements may have been taken by a dequeue that started
+                // before this attempt was registered. Run it again to report
+                // the error.
+                if (num_dequeued + n == 0) return kProgress;
+                Tuple tuple;
+                for (const Tensor& t : attempt->tuple) {
+                  tuple.push_back(t.Slice(0, num_dequeued + n));
+                }
+                attempt->done_callback =
+                    DequeueDone(callback, std::move(tuple));
+                return kComplete;
+              }
+              // There may be some other attempts containing values. If so,
+              // we'll yield and wait for them to add elements to the queue.
+              if (allow_small_batch && !enqueue_attempts_.empty()) {
+                return kProgress;
+              }
+              if (num_dequeued > 0) {
+                // Restore already-dequeued elements to the front of the
+                // queue.
+                Status s = RestoreLocked(attempt->tuple, num_dequeued, context);
+                if (!s.ok()) {
+                  context->SetStatus(errors::DataLoss(
+                      "Failed to restore element from partially-dequeued "
+                      "batch to FIFOQueue: ",
+                      s.error_message()));
+                }
+              }
+              if (context->status().ok()) {
+                context->SetStatus(errors::OutOfRange(
+                    "FIFOQueue '", name_, "' is closed and has ",
+                    "insufficient elements (requested ",
+                    attempt->elements_requested, ", current size ",
+                    num_dequeued + available, ")"));
+              }
+              return kComplete;
+            }
+
+            // Batches that fit in the queue are dequeued at once, so that
+            // they never need to be restored. Larger batches are assembled
+            // from the elements available.
+            const int64_t min_n =
+                num_elements <= capacity_ ? attempt->elements_requested : 1;
+            if (available < min_n) return kNoProgress;
+            if (attempt->tuple.empty()) {
+              // Only allocate tuple when we have something to dequeue
+              // so we don't use excessive memory when there are many
+              // blocked dequeue attempts waiting.
+              context->SetStatus(
+                  AllocateTuple(context, num_elements, &attempt->tuple));
+              if (!context->status().ok()) return kComplete;
+            }
+            const int64_t n =
+                DequeueLocked(min_n, attempt->elements_requested,
+                              &attempt->tuple, num_dequeued);
+            if (n == 0) return kNoProgress;
+            attempt->elements_requested -= n;
+            if (attempt->elements_requested == 0) {
+              attempt->done_callback = DequeueDone(callback, attempt->tuple);
+              return kComplete;
+            }
+            return kProgress;
+          });
+    }
+  }
+  if (!already_cancelled) {
+    FlushUnlocked();
+  } else {
+    ctx->SetStatus(errors::Cancelled("Dequeue operation was cancelled"));
+    callback(Tuple());
+  }
+}
+
+void RingBufferFIFOQueue::Close(OpKernelContext* ctx,
+                                bool cancel_pending_enqueues,
+                                DoneCallback callback) {
+  closing_.store(true);
+  while (num_active_enqueues_.load() > 0) {
+    std::this_thread::yield();
+  }
+  QueueBase::Close(ctx, cancel_pending_enqueues, std::move(callback));
+}
+
+Status RingBufferFIFOQueue::MatchesNodeDef(const NodeDef& node_def) {
+  if (!MatchesNodeDefOp(node_def, "FIFOQueue").ok() &&
+      !MatchesNodeDefOp(node_def, "FIFOQueueV2").ok()) {
+    return errors::InvalidArgument("Expected FIFOQueue, found ", node_def.op());
+  }
+  TF_RETURN_IF_ERROR(MatchesNodeDefCapacity(node_def, capacity_));
+  TF_RETURN_IF_ERROR(MatchesNodeDefTypes(node_def));
+  TF_RETURN_IF_ERROR(MatchesNodeDefShapes(node_def));
+  return OkStatus();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,166 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_RING_BUFFER_FIFO_QUEUE_H_
+#define TENSORFLOW_CORE_KERNELS_RING_BUFFER_FIFO_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/queue_base.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A FIFOQueue for queues with a bounded capacity, whose components have fully
+// defined shapes and types that can be copied with memcpy.
+//
+// Elements are stored in one preallocated ring buffer per component. An
+// enqueue or dequeue that can complete immediately does not take `mu_`: it
+// reserves a range of slots with a compare-and-swap on the producer (or
+// consumer) head, copies the whole range with at most two memcpy calls per
+// component, and then publishes it by advancing the matching tail, in the
+// order in which the ranges were reserved. EnqueueMany and DequeueMany thus
+// copy whole batches instead of one element at a time.
+//
+// Operations that would block, and operations that arrive while earlier
+// operations of the same kind are blocked, fall back to the attempt queues
+// of `QueueBase`, which implement blocking, cancellation and closing with
+// the same semantics as `FIFOQueue`. A non-blocking operation that adds
+// elements (or frees slots) flushes the blocked operations of the other kind.
+class RingBufferFIFOQueue : public QueueBase {
+ public:
+  RingBufferFIFOQueue(int32_t capacity, const DataTypeVector& component_dtypes,
+                      const std::vector<TensorShape>& component_shapes,
+                      const string& name);
+
+  // Returns true if a FIFOQueue with the given attributes can be backed by a
+  // RingBufferFIFOQueue. Since the ring buffers are allocated up front, this
+  // is limited to queues with small elements and a bounded total size.
+  static bool IsSupported(int32_t capacity,
+                          const DataTypeVector& component_dtypes,
+                          const std::vector<TensorShape>& component_shapes);
+
+  Status Initialize();  // Must be called before any other method.
+
+  // Implementations of QueueInterface methods --------------------------------
+
+  void TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
+                  DoneCallback callback) override;
+  void TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
+                      DoneCallback callback) override;
+  void TryDequeue(OpKernelContext* ctx, CallbackWithTuple callback) override;
+  void TryDequeueMany(int num_elements, OpKernelContext* ctx,
+                      bool allow_small_batch,
+                      CallbackWithTuple callback) override;
+  void Close(OpKernelContext* ctx, bool cancel_pending_enqueues,
+             DoneCallback callback) override;
+  Status MatchesNodeDef(const NodeDef& node_def) override;
+
+  int32 size() const override;
+  int64_t MemoryUsed() const override;
+
+ private:
+  ~RingBufferFIFOQueue() override {}
+
+  // Reserves between `min_n` and `max_n` free slots (resp. filled slots)
+  // starting at `*pos`, and returns the number of reserved slots, or 0 if
+  // fewer than `min_n` (or no) slots are available.
+  int64_t ReserveEnqueue(int64_t min_n, int64_t max_n, uint64* pos);
+  int64_t ReserveDequeue(int64_t min_n, int64_t max_n, uint64* pos);
+
+  // Publishes the `n` slots reserved at `pos`, once all the earlier
+  // reservations have been published.
+  void CommitEnqueue(uint64 pos, int64_t n);
+  void CommitDequeue(uint64 pos, int64_t n);
+
+  // Copies `n` elements between the ring buffers, starting at position `pos`,
+  // and the batches in `tuple`, starting at element `index`.
+  void CopyToRing(const Tuple& tuple, int64_t index, uint64 pos, int64_t n);
+  void CopyFromRing(uint64 pos, int64_t n, Tuple* tuple, int64_t index);
+
+  // Enqueues (resp. dequeues) between `min_n` and `max_n` elements of the
+  // batches in `tuple` starting at element `index`, and returns the number of
+  // elements copied, or 0 if fewer than `min_n` can be copied immediately.
+  int64_t RingEnqueue(const Tuple& tuple, int64_t index, int64_t min_n,
+                      int64_t max_n);
+  int64_t RingDequeue(int64_t min_n, int64_t max_n, Tuple* tuple,
+                      int64_t index);
+
+  // Number of published elements that have not been reserved by a dequeue.
+  int64_t RingSize() const;
+
+  // Like RingDequeue(), but first dequeues the elements in `restored_`.
+  int64_t DequeueLocked(int64_t min_n, int64_t max_n, Tuple* tuple,
+                        int64_t index) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Moves the first `num_elements` elements of the partially dequeued batch
+  // `tuple` back to the front of the queue.
+  Status RestoreLocked(const Tuple& tuple, int64_t num_elements,
+                       OpKernelContext* ctx) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Allocates a tuple of batches of `batch_size` elements, or of single
+  // elements if `batch_size` is negative.
+  Status AllocateTuple(OpKernelContext* ctx, int64_t batch_size, Tuple* tuple);
+
+  // Enqueues (resp. dequeues) `n` elements without taking `mu_` if this can
+  // be done immediately and without reordering blocked operations.
+  bool TryEnqueueWithoutBlocking(const Tuple& tuple, int64_t n);
+  bool TryDequeueWithoutBlocking(OpKernelContext* ctx, int64_t batch_size,
+                                 Tuple* tuple);
+
+  // Callbacks for blocked attempts, which maintain the number of pending
+  // attempts of each kind. These must also be called when an attempt is
+  // cancelled.
+  DoneCallback EnqueueDone(DoneCallback callback);
+  DoneCallback DequeueDone(CallbackWithTuple callback, Tuple tuple);
+
+  std::vector<Tensor> buffers_;
+  std::vector<int64_t> element_bytes_;
+
+  // Slots [cons_tail_, prod_tail_) are ready to be dequeued, and slots
+  // [prod_head_, cons_tail_ + capacity_) are free. The counters are never
+  // wrapped to the capacity.
+  alignas(64) std::atomic<uint64> prod_head_{0};
+  alignas(64) std::atomic<uint64> prod_tail_{0};
+  alignas(64) std::atomic<uint64> cons_head_{0};
+  alignas(64) std::atomic<uint64> cons_tail_{0};
+
+  // Number of enqueue and dequeue attempts registered with `QueueBase`.
+  alignas(64) std::atomic<int64_t> num_pending_enqueues_{0};
+  std::atomic<int64_t> num_pending_dequeues_{0};
+  // Number of enqueues in TryEnqueueWithoutBlocking(). Close() waits for
+  // them after setting `closing_`.
+  std::atomic<int64_t> num_active_enqueues_{0};
+  std::atomic<bool> closing_{false};
+
+  // Elements of partially dequeued batches that were restored when the queue
+  // was closed. They precede the elements in the ring buffers.
+  std::deque<Tuple> restored_ TF_GUARDED_BY(mu_);
+  std::atomic<int64_t> num_restored_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RingBufferFIFOQueue);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_RING_BUFFER_FIFO_QUEUE_H_
@@ -33,6 +33,8 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/tensor_bundle/delta_checkpoint.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -359,6 +361,41 @@ struct RestoreOp {
   ::tensorflow::Status status;
 };
 
+// Restores full tensors from a delta checkpoint written by the
+// SaveDeltaCheckpoint op, merging the rows stored in its chain of bases.
+Status RestoreDeltaTensors(OpKernelContext* context, const string& prefix,
+                           const Tensor& tensor_names,
+                           const Tensor& shape_and_slices,
+                           gtl::ArraySlice<DataType> dtypes) {
+  DeltaBundleReader reader(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  const auto& tensor_names_flat = tensor_names.flat<tstring>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
+  for (int i = 0; i < tensor_names_flat.size(); ++i) {
+    const string& tensor_name = tensor_names_flat(i);
+    if (!shape_and_slices_flat(i).empty()) {
+      return errors::Unimplemented(
+          "tensor_name = ", tensor_name, "; restoring slices from delta "
+          "checkpoint ", prefix, " is not supported");
+    }
+    DataType original_dtype;
+    TensorShape restored_full_shape;
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(tensor_name, &original_dtype,
+                                                  &restored_full_shape));
+    if (dtypes[i] != original_dtype) {
+      return errors::InvalidArgument(
+          "tensor_name = ", tensor_name, "; expected dtype ",
+          DataTypeString(dtypes[i]), " does not equal original dtype ",
+          DataTypeString(original_dtype));
+    }
+    Tensor* restored_tensor;
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(i, restored_full_shape, &restored_tensor));
+    TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
+  }
+  return OkStatus();
+}
+
 }  // namespace
 
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
@@ -379,6 +416,10 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
 
   BundleReader default_reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(default_reader.status());
+  if (default_reader.Contains(kDeltaBaseKey)) {
+    return RestoreDeltaTensors(context, prefix_string, tensor_names,
+                               shape_and_slices, dtypes);
+  }
 
   TF_RETURN_IF_ERROR(default_reader.SortForSequentialAccess<RestoreOp>(
       restore_ops, [](const RestoreOp& op) { return op.tensor_name; }));
@@ -402,10 +443,29 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     return errors::InvalidArgument(error_msg);
   }
 
+  // When set, full tensors are restored together with
+  // BundleReader::BatchLookup(), using this many threads to read them.
+  int64_t num_batch_lookup_threads;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_RESTORE_BATCH_LOOKUP_THREADS", 0,
+                                         &num_batch_lookup_threads));
+
+  // When set, full tensors are restored with BundleReader::LookupMapped(), so
+  // they share the memory of the data files when possible.
+  bool restore_mapped;
+  TF_RETURN_IF_ERROR(
+      ReadBoolFromEnvVar("TF_RESTORE_MMAP", false, &restore_mapped));
+
+  std::vector<RestoreOp*> mapped_restore_ops;
+  std::vector<RestoreOp*> batch_restore_ops;
   std::vector<RestoreOp*> pool_restore_ops;
   std::vector<RestoreOp*> direct_restore_ops;
   for (RestoreOp& restore_op : restore_ops) {
-    if (restore_op.should_run_in_pool(&default_reader)) {
+    if (restore_mapped && restore_op.shape_and_slice.empty()) {
+      mapped_restore_ops.push_back(&restore_op);
+    } else if (num_batch_lookup_threads > 0 &&
+               restore_op.shape_and_slice.empty()) {
+      batch_restore_ops.push_back(&restore_op);
+    } else if (restore_op.should_run_in_pool(&default_reader)) {
       pool_restore_ops.push_back(&restore_op);
     } else {
       direct_restore_ops.push_back(&restore_op);
@@ -428,6 +488,32 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
     for (auto* op : direct_restore_ops) {
       TF_RETURN_IF_ERROR(op->run(&default_reader));
     }
+
+    for (auto* op : mapped_restore_ops) {
+      Tensor restored_tensor;
+      TF_RETURN_IF_ERROR(
+          default_reader.LookupMapped(op->tensor_name, &restored_tensor));
+      context->set_output(op->idx, restored_tensor);
+    }
+
+    if (!batch_restore_ops.empty()) {
+      std::vector<string> keys;
+      std::vector<Tensor*> tensors;
+      for (auto* op : batch_restore_ops) {
+        TensorShape restored_full_shape;
+        TF_RETURN_IF_ERROR(default_reader.LookupTensorShape(
+            op->tensor_name, &restored_full_shape));
+        Tensor* restored_tensor;
+        TF_RETURN_IF_ERROR(context->allocate_output(
+            op->idx, restored_full_shape, &restored_tensor));
+        keys.push_back(op->tensor_name);
+        tensors.push_back(restored_tensor);
+      }
+      thread::ThreadPool batch_pool(Env::Default(), "restore_tensors_batch",
+                                    num_batch_lookup_threads);
+      TF_RETURN_IF_ERROR(
+          default_reader.BatchLookup(keys, tensors, &batch_pool));
+    }
   }
 
   // Check status of pool ops; this must come after the pool shuts down.
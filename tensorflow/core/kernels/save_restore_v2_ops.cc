@@ -21,9 +21,12 @@ limitations under the License.
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
 #include "tensorflow/core/kernels/checkpoint_callback_manager.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -31,7 +34,9 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/delta_checkpoint.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 
@@ -87,12 +92,84 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Writes `tensors` to the checkpoint at `prefix`, as done by SaveV2.
+Status WriteCheckpoint(const string& prefix,
+                       const std::vector<string>& tensor_names,
+                       const std::vector<string>& shape_and_slices,
+                       const std::vector<Tensor>& tensors) {
+  // Bundles written with an alignment of (a multiple of)
+  // Allocator::kAllocatorAlignment can be restored without copies with
+  // TF_RESTORE_MMAP.
+  int64_t data_alignment;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar("TF_CHECKPOINT_DATA_ALIGNMENT", 1,
+                                         &data_alignment));
+  if (data_alignment < 1 || data_alignment > std::numeric_limits<int>::max()) {
+    return errors::InvalidArgument(
+        "TF_CHECKPOINT_DATA_ALIGNMENT must be positive, got ", data_alignment);
+  }
+  BundleWriter::Options options;
+  options.data_alignment = data_alignment;
+  BundleWriter writer(Env::Default(), prefix, options);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (int i = 0; i < tensors.size(); ++i) {
+    const string& tensor_name = tensor_names[i];
+    const Tensor& tensor = tensors[i];
+    VLOG(2) << "Starting save of " << tensor_name;
+
+    if (!shape_and_slices[i].empty()) {
+      const string& shape_spec = shape_and_slices[i];
+      TensorShape shape;
+      TensorSlice slice(tensor.dims());
+      TensorShape slice_shape;
+
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(shape_spec, &shape,
+                                                        &slice, &slice_shape));
+      if (!slice_shape.IsSameSize(tensor.shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice specification does not match the shape "
+            "of the tensor to  save: ",
+            shape_spec, ", tensor: ", tensor.shape().DebugString());
+      }
+
+      TF_RETURN_IF_ERROR(writer.AddSlice(tensor_name, shape, slice, tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(tensor_name, tensor));
+    }
+
+    if (VLOG_IS_ON(5)) {
+      if (tensor.dtype() == DT_FLOAT) {
+        const float* t_data = tensor.flat<float>().data();
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+        double avg = 0.0;
+        for (int i = 0; i < tensor.NumElements(); ++i) {
+          if (t_data[i] < min) min = t_data[i];
+          if (t_data[i] > max) max = t_data[i];
+          avg += t_data[i];
+        }
+        VLOG(5) << " min " << min << " max " << max << " avg "
+                << avg / tensor.NumElements() << " total elts "
+                << tensor.NumElements();
+      }
+    }
+
+    VLOG(2) << "Done save of " << tensor_name;
+  }
+  TF_RETURN_IF_ERROR(writer.Finish());
+  VLOG(1) << "Done BundleWriter, prefix_string: " << prefix;
+  return OkStatus();
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("async_write", &async_write_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -108,57 +185,36 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<tstring>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<tstring>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
+    std::vector<string> names;
+    std::vector<string> specs;
+    std::vector<Tensor> tensors;
+    names.reserve(num_tensors);
+    specs.reserve(num_tensors);
+    tensors.reserve(num_tensors);
     for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-      VLOG(2) << "Starting save of " << tensor_name;
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
-
-      if (VLOG_IS_ON(5)) {
-        if (tensor.dtype() == DT_FLOAT) {
-          const float* t_data = tensor.flat<float>().data();
-          float min = std::numeric_limits<float>::infinity();
-          float max = -std::numeric_limits<float>::infinity();
-          double avg = 0.0;
-          for (int i = 0; i < tensor.NumElements(); ++i) {
-            if (t_data[i] < min) min = t_data[i];
-            if (t_data[i] > max) max = t_data[i];
-            avg += t_data[i];
-          }
-          VLOG(5) << " min " << min << " max " << max << " avg "
-                  << avg / tensor.NumElements() << " total elts "
-                  << tensor.NumElements();
-        }
-      }
+      names.push_back(tensor_names_flat(i));
+      specs.push_back(shape_and_slices_flat(i));
+      tensors.push_back(context->input(i + kFixedInputs));
+    }
 
-      VLOG(2) << "Done save of " << tensor_name;
+    auto* async_writer = checkpoint::AsyncCheckpointWriter::Global();
+    if (async_write_) {
+      // The snapshot of the tensors shares their buffers: resource variables
+      // copy their buffer before updating it while it is shared, so the
+      // checkpoint holds the values at the time of this op.
+      OP_REQUIRES_OK(
+          context,
+          async_writer->Schedule(
+              prefix_string, [prefix_string, names = std::move(names),
+                              specs = std::move(specs),
+                              tensors = std::move(tensors)]() {
+                return WriteCheckpoint(prefix_string, names, specs, tensors);
+              }));
+    } else {
+      OP_REQUIRES_OK(context, async_writer->Wait(prefix_string));
+      OP_REQUIRES_OK(context,
+                     WriteCheckpoint(prefix_string, names, specs, tensors));
     }
-    OP_REQUIRES_OK(context, writer.Finish());
-    VLOG(1) << "Done BundleWriter, prefix_string: " << prefix_string;
 
     ResourceMgr* resource_manager = context->resource_manager();
     if (resource_manager != nullptr) {
@@ -179,6 +235,10 @@ class SaveV2 : public OpKernel {
       checkpoint_callback_manager->Unref();
     }
   }
+
+ private:
+  // Whether the checkpoint is written on a background thread.
+  bool async_write_ = false;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
@@ -202,6 +262,9 @@ class RestoreV2 : public OpKernel {
     if (!context->status().ok()) return;
 
     const string& prefix_string = prefix.scalar<tstring>()();
+    OP_REQUIRES_OK(
+        context,
+        checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix_string));
 
     // Intention: we plan to use the RestoreV2 op as a backward-compatible
     // reader as we upgrade to the V2 format.  This allows transparent upgrade.
@@ -281,6 +344,11 @@ class MergeV2Checkpoints : public OpKernel {
         gtl::ArraySlice<tstring>(checkpoint_prefixes.flat<tstring>());
     Env* env = Env::Default();
     const string& merged_prefix = destination_prefix.scalar<tstring>()();
+    for (const string& input_prefix : input_prefixes) {
+      OP_REQUIRES_OK(
+          context,
+          checkpoint::AsyncCheckpointWriter::Global()->Wait(input_prefix));
+    }
     OP_REQUIRES_OK(context,
                    tensorflow::MergeBundles(env, input_prefixes, merged_prefix,
                                             allow_missing_files_));
@@ -309,4 +377,140 @@ class MergeV2Checkpoints : public OpKernel {
 REGISTER_KERNEL_BUILDER(Name("MergeV2Checkpoints").Device(DEVICE_CPU),
                         MergeV2Checkpoints);
 
+// Saves resource variables to a delta checkpoint, see delta_checkpoint.h.
+class SaveDeltaCheckpointOp : public OpKernel {
+ public:
+  explicit SaveDeltaCheckpointOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const int kFixedInputs = 3;  // Prefix, base prefix, tensor names.
+    const Tensor& prefix = context->input(0);
+    const Tensor& base_prefix = context->input(1);
+    const Tensor& tensor_names = context->input(2);
+    const int num_variables = context->num_inputs() - kFixedInputs;
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsScalar(prefix.shape()) &&
+                    TensorShapeUtils::IsScalar(base_prefix.shape()),
+                errors::InvalidArgument(
+                    "Inputs prefix and base_prefix should be scalars, got ",
+                    prefix.shape().DebugString(), " and ",
+                    base_prefix.shape().DebugString(), " instead."));
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(tensor_names.shape()) &&
+                    tensor_names.NumElements() == num_variables,
+                errors::InvalidArgument(
+                    "Got ", tensor_names.shape().DebugString(),
+                    " tensor names for ", num_variables, " variables."));
+    const string& prefix_string = prefix.scalar<tstring>()();
+    const string& base_string = base_prefix.scalar<tstring>()();
+    OP_REQUIRES(context, prefix_string != base_string,
+                errors::InvalidArgument("Cannot save delta checkpoint ",
+                                        prefix_string, " based on itself."));
+    OP_REQUIRES_OK(
+        context,
+        checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix_string));
+
+    std::vector<core::RefCountPtr<Var>> variables(num_variables);
+    Status status =
+        Save(context, prefix_string, base_string, tensor_names, &variables);
+    if (!status.ok()) {
+      // The variables may have started tracking the rows updated after this
+      // checkpoint, which was not written.
+      for (const auto& var : variables) {
+        if (var) var->MarkAllRowsDirty();
+      }
+    }
+    OP_REQUIRES_OK(context, status);
+  }
+
+ private:
+  Status Save(OpKernelContext* context, const string& prefix,
+              const string& base_prefix, const Tensor& tensor_names,
+              std::vector<core::RefCountPtr<Var>>* variables) {
+    const int kFixedInputs = 3;
+    const auto& tensor_names_flat = tensor_names.flat<tstring>();
+    const int num_variables = variables->size();
+
+    // Copies the rows to write while holding the lock of each variable, so
+    // that updates are not blocked by the write.
+    std::vector<Tensor> full(num_variables);
+    std::vector<Tensor> ranges(num_variables);
+    std::vector<Tensor> values(num_variables);
+    std::vector<bool> is_delta(num_variables, false);
+    std::vector<int64_t> rows;
+    for (int i = 0; i < num_variables; ++i) {
+      TF_RETURN_IF_ERROR(LookupResource(
+          context, HandleFromInput(context, i + kFixedInputs),
+          &(*variables)[i]));
+      Var* var = (*variables)[i].get();
+      mutex_lock ml(*var->mu());
+      if (!var->is_initialized) {
+        return errors::FailedPrecondition("Variable ", tensor_names_flat(i),
+                                          " is not initialized.");
+      }
+      const Tensor& tensor = *var->tensor();
+      if (var->TakeDirtyRows(base_prefix, prefix, &rows) &&
+          DataTypeCanUseMemcpy(tensor.dtype())) {
+        TF_RETURN_IF_ERROR(
+            GatherDeltaRows(tensor, rows, &ranges[i], &values[i]));
+        is_delta[i] = true;
+      } else {
+        full[i] = tensor::DeepCopy(tensor);
+      }
+    }
+
+    BundleWriter writer(Env::Default(), prefix);
+    TF_RETURN_IF_ERROR(writer.status());
+    if (!base_prefix.empty()) {
+      TF_RETURN_IF_ERROR(AddDeltaBase(&writer, base_prefix));
+    }
+    int num_deltas = 0;
+    for (int i = 0; i < num_variables; ++i) {
+      if (is_delta[i]) {
+        TF_RETURN_IF_ERROR(
+            AddDelta(&writer, tensor_names_flat(i), ranges[i], values[i]));
+        ++num_deltas;
+      } else {
+        TF_RETURN_IF_ERROR(writer.Add(tensor_names_flat(i), full[i]));
+      }
+    }
+    TF_RETURN_IF_ERROR(writer.Finish());
+    VLOG(1) << "Saved delta checkpoint " << prefix << " of " << base_prefix
+            << " with " << num_deltas << " deltas and "
+            << num_variables - num_deltas << " full variables";
+    return OkStatus();
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("SaveDeltaCheckpoint").Device(DEVICE_CPU),
+                        SaveDeltaCheckpointOp);
+
+// Merges a delta checkpoint and its bases into a full checkpoint.
+class CompactDeltaCheckpointOp : public OpKernel {
+ public:
+  explicit CompactDeltaCheckpointOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& output_prefix = context->input(1);
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsScalar(prefix.shape()) &&
+                    TensorShapeUtils::IsScalar(output_prefix.shape()),
+                errors::InvalidArgument(
+                    "Inputs prefix and output_prefix should be scalars, got ",
+                    prefix.shape().DebugString(), " and ",
+                    output_prefix.shape().DebugString(), " instead."));
+    const string& prefix_string = prefix.scalar<tstring>()();
+    OP_REQUIRES_OK(
+        context,
+        checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix_string));
+    OP_REQUIRES_OK(context, CompactDeltaCheckpoint(
+                                Env::Default(), prefix_string,
+                                output_prefix.scalar<tstring>()()));
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("CompactDeltaCheckpoint").Device(DEVICE_CPU),
+                        CompactDeltaCheckpointOp);
+
 }  // namespace tensorflow
@@ -18,17 +18,22 @@ limitations under the License.
 
 #include "tensorflow/core/framework/fake_input.h"
 #include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/resource_var.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/kernels/async_checkpoint_writer.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/delta_checkpoint.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
@@ -340,5 +345,182 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class AsyncSaveV2OpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "SaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_INT32}))  // tensors
+                     .Attr("async_write", true)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(AsyncSaveV2OpTest, Simple) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_async");
+  MakeOp();
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring {
+    return x == 0 ? "tensor_float" : "tensor_int";
+  });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring { return ""; });
+  AddInput<float>(TensorShape({2, 4}),
+                  [](int x) -> float { return static_cast<float>(x) / 10; });
+  AddInput<int32>(TensorShape({10}), [](int x) -> int32 { return x + 1; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  TF_ASSERT_OK(checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix));
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_EXPECT_OK(reader.Lookup("tensor_float", &val));
+  EXPECT_EQ(TensorShape({2, 4}), val.shape());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(static_cast<float>(i) / 10, val.flat<float>()(i));
+  }
+  TF_EXPECT_OK(reader.Lookup("tensor_int", &val));
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i + 1, val.flat<int32>()(i));
+  }
+}
+
+TEST_F(AsyncSaveV2OpTest, WriteErrorIsReturnedByWait) {
+  // The parent directory of the prefix is a file.
+  const string file = io::JoinPath(testing::TmpDir(), "async_not_a_dir");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), file, "x"));
+  const string prefix = io::JoinPath(file, "ckpt");
+  MakeOp();
+  AddInput<tstring>(TensorShape({}),
+                    [&prefix](int x) -> tstring { return prefix; });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring {
+    return x == 0 ? "tensor_float" : "tensor_int";
+  });
+  AddInput<tstring>(TensorShape({2}), [](int x) -> tstring { return ""; });
+  AddInput<float>(TensorShape({2, 4}), [](int x) -> float { return x; });
+  AddInput<int32>(TensorShape({10}), [](int x) -> int32 { return x; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  EXPECT_FALSE(checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix).ok());
+  // The error is only returned once.
+  TF_EXPECT_OK(checkpoint::AsyncCheckpointWriter::Global()->Wait(prefix));
+}
+
+class SaveDeltaCheckpointOpTest : public OpsTestBase {
+ protected:
+  void MakeOp() {
+    TF_ASSERT_OK(NodeDefBuilder("myop", "SaveDeltaCheckpoint")
+                     .Input(FakeInput())                // prefix
+                     .Input(FakeInput())                // base_prefix
+                     .Input(FakeInput())                // tensor_names
+                     .Input(FakeInput(2, DT_RESOURCE))  // variables
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Creates the variables "emb", which tracks dirty rows, and "bias".
+  void AddVariables() {
+    emb_ = new Var(DT_FLOAT);
+    emb_->EnableDirtyRowTracking();
+    *emb_->tensor() =
+        test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2}));
+    emb_->is_initialized = true;
+    Var* bias = new Var(DT_FLOAT);
+    *bias->tensor() = test::AsTensor<float>({0, 1});
+    bias->is_initialized = true;
+    ResourceMgr* rm = device_->resource_manager();
+    TF_ASSERT_OK(rm->Create(rm->default_container(), "emb", emb_));
+    TF_ASSERT_OK(rm->Create(rm->default_container(), "bias", bias));
+  }
+
+  Status Save(const string& prefix, const string& base_prefix) {
+    inputs_.clear();
+    AddInputFromArray<tstring>(TensorShape({}), {prefix});
+    AddInputFromArray<tstring>(TensorShape({}), {base_prefix});
+    AddInputFromArray<tstring>(TensorShape({2}), {"emb", "bias"});
+    ResourceMgr* rm = device_->resource_manager();
+    for (const char* name : {"emb", "bias"}) {
+      AddResourceInputInternal(rm->default_container(), name,
+                               TypeIndex::Make<Var>());
+    }
+    return RunOpKernel();
+  }
+
+  void UpdateRow(int64_t row, float value) {
+    mutex_lock ml(*emb_->mu());
+    emb_->tensor()->matrix<float>()(row, 0) = value;
+    emb_->MarkRowsDirty(test::AsTensor<int64_t>({row}));
+  }
+
+  // Owned by the resource manager.
+  Var* emb_ = nullptr;
+};
+
+TEST_F(SaveDeltaCheckpointOpTest, WritesUpdatedRows) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "delta");
+  MakeOp();
+  AddVariables();
+  TF_ASSERT_OK(Save(prefix + "-0", ""));
+  {
+    BundleReader reader(Env::Default(), prefix + "-0");
+    TF_ASSERT_OK(reader.status());
+    EXPECT_FALSE(reader.Contains(kDeltaBaseKey));
+    EXPECT_TRUE(reader.Contains("emb"));
+  }
+
+  UpdateRow(1, 10);
+  UpdateRow(2, 20);
+  TF_ASSERT_OK(Save(prefix + "-1", prefix + "-0"));
+  {
+    BundleReader reader(Env::Default(), prefix + "-1");
+    TF_ASSERT_OK(reader.status());
+    EXPECT_TRUE(reader.Contains(kDeltaBaseKey));
+    EXPECT_FALSE(reader.Contains("emb"));
+    EXPECT_TRUE(reader.Contains("bias"));
+    Tensor values(DT_FLOAT, TensorShape({2, 2}));
+    TF_ASSERT_OK(reader.Lookup(strings::StrCat("emb", kDeltaValuesSuffix),
+                               &values));
+    test::ExpectTensorEqual<float>(
+        values, test::AsTensor<float>({10, 3, 20, 5}, TensorShape({2, 2})));
+  }
+
+  UpdateRow(3, 30);
+  TF_ASSERT_OK(Save(prefix + "-2", prefix + "-1"));
+  DeltaBundleReader reader(Env::Default(), prefix + "-2");
+  TF_ASSERT_OK(reader.status());
+  Tensor emb(DT_FLOAT, TensorShape({4, 2}));
+  TF_ASSERT_OK(reader.Lookup("emb", &emb));
+  test::ExpectTensorEqual<float>(
+      emb, test::AsTensor<float>({0, 1, 10, 3, 20, 5, 30, 7},
+                                 TensorShape({4, 2})));
+}
+
+TEST_F(SaveDeltaCheckpointOpTest, StaleBaseWritesFullVariable) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "delta_stale");
+  MakeOp();
+  AddVariables();
+  TF_ASSERT_OK(Save(prefix + "-0", ""));
+  TF_ASSERT_OK(Save(prefix + "-1", prefix + "-0"));
+  UpdateRow(0, 10);
+  // The rows updated since the first checkpoint are not known anymore.
+  TF_ASSERT_OK(Save(prefix + "-2", prefix + "-0"));
+  BundleReader reader(Env::Default(), prefix + "-2");
+  TF_ASSERT_OK(reader.status());
+  EXPECT_TRUE(reader.Contains("emb"));
+
+  // Neither are the rows updated by a dense update.
+  {
+    mutex_lock ml(*emb_->mu());
+    emb_->MarkAllRowsDirty();
+  }
+  TF_ASSERT_OK(Save(prefix + "-3", prefix + "-2"));
+  BundleReader reader_3(Env::Default(), prefix + "-3");
+  TF_ASSERT_OK(reader_3.status());
+  EXPECT_TRUE(reader_3.Contains("emb"));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/determinism.h"
 #include "tensorflow/core/util/util.h"
 
@@ -726,6 +727,29 @@ class SparseSegmentReductionOpBase : public OpKernel {
     return res;
   }
 
+  // Prefetches the rows of `input_flat` at `indices_vec(i)` for `i` in
+  // [begin, end), so that they are in cache when they are accumulated.
+  template <typename Tin, typename Tindex>
+  EIGEN_ALWAYS_INLINE void PrefetchRows(
+      const typename TTypes<Tin>::ConstMatrix& input_flat,
+      const typename TTypes<Tindex>::ConstVec& indices_vec, int64_t begin,
+      int64_t end) {
+    constexpr int64_t kCacheLineBytes = 64;
+    constexpr int64_t kMaxPrefetchBytesPerRow = 16 * kCacheLineBytes;
+    const int64_t row_bytes =
+        std::min<int64_t>(input_flat.dimension(1) * sizeof(Tin),
+                          kMaxPrefetchBytesPerRow);
+    if (row_bytes == 0) return;
+    for (int64_t i = begin; i < end; ++i) {
+      const auto index = indices_vec(i);
+      if (!FastBoundsCheck(index, input_flat.dimension(0))) continue;
+      const char* row = reinterpret_cast<const char*>(&input_flat(index, 0));
+      for (int64_t offset = 0; offset < row_bytes; offset += kCacheLineBytes) {
+        port::prefetch<port::PREFETCH_HINT_T0>(row + offset);
+      }
+    }
+  }
+
   template <typename Tin, typename Tindex, typename Tout>
   int64_t ReduceImpl(
       const typename TTypes<Tin>::ConstMatrix& input_flat,
@@ -743,6 +767,8 @@ class SparseSegmentReductionOpBase : public OpKernel {
       INDEX(0, 0);
       out = L(0);
     } else {
+      PrefetchRows<Tin, Tindex>(input_flat, indices_vec, start,
+                                start + std::min<int64_t>(num, 16));
       int64_t r = num & 7;
       switch (r) {
         case 2: {
@@ -828,6 +854,10 @@ class SparseSegmentReductionOpBase : public OpKernel {
         }
       }
       for (; r < num; r += 8) {
+        // Table rows are read in random order, so fetch the rows of the next
+        // iteration while accumulating the current ones.
+        PrefetchRows<Tin, Tindex>(input_flat, indices_vec, start + r + 8,
+                                  start + std::min<int64_t>(num, r + 16));
         INDEX(0, r);
         INDEX(1, r + 1);
         INDEX(2, r + 2);
@@ -290,4 +290,89 @@ BENCHMARK(BM_SparseSegmentMeanGrad_High_FP16)
     ->Arg(1000)
     ->Arg(100000);
 
+// Looks up `num_ids` rows of a table, and averages each group of 16
+// consecutive rows. With `gather_rows`, the rows are first gathered with
+// GatherV2, otherwise SparseSegmentMean reads them from the table.
+template <DataType T>
+static void EmbeddingLookupHelper(::testing::benchmark::State& state,
+                                  bool gather_rows) {
+  typedef typename EnumToDataType<T>::Type DT;
+  const int num_ids = state.range(0);
+  const int dim = state.range(1);
+  constexpr int kVocabSize = 100000;
+  constexpr int kSegmentSize = 16;
+
+  Tensor table(T, TensorShape({kVocabSize, dim}));
+  table.flat<DT>().setRandom();
+  Tensor ids(DT_INT32, TensorShape({num_ids}));
+  Tensor range(DT_INT32, TensorShape({num_ids}));
+  Tensor segments(DT_INT32, TensorShape({num_ids}));
+  for (int i = 0; i < num_ids; ++i) {
+    ids.flat<int32>()(i) = (i * 7919) % kVocabSize;
+    range.flat<int32>()(i) = i;
+    segments.flat<int32>()(i) = i / kSegmentSize;
+  }
+
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* data = test::graph::Constant(g, table);
+  Node* indices = test::graph::Constant(g, ids);
+  if (gather_rows) {
+    Node* axis = test::graph::Constant(g, test::AsScalar<int32>(0));
+    TF_CHECK_OK(NodeBuilder(g->NewName("gather"), "GatherV2")
+                    .Input(data)
+                    .Input(indices)
+                    .Input(axis)
+                    .Finalize(g, &data));
+    indices = test::graph::Constant(g, range);
+  }
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentMean")
+                  .Input(data)
+                  .Input(indices)
+                  .Input(test::graph::Constant(g, segments))
+                  .Attr("T", T)
+                  .Finalize(g, &node));
+
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * num_ids *
+                          dim * sizeof(DT));
+}
+
+static void BM_EmbeddingLookup_Gather_FP32(
+    ::testing::benchmark::State& state) {
+  EmbeddingLookupHelper<DT_FLOAT>(state, /*gather_rows=*/true);
+}
+
+static void BM_EmbeddingLookup_Direct_FP32(
+    ::testing::benchmark::State& state) {
+  EmbeddingLookupHelper<DT_FLOAT>(state, /*gather_rows=*/false);
+}
+
+static void BM_EmbeddingLookup_Gather_BF16(
+    ::testing::benchmark::State& state) {
+  EmbeddingLookupHelper<DT_BFLOAT16>(state, /*gather_rows=*/true);
+}
+
+static void BM_EmbeddingLookup_Direct_BF16(
+    ::testing::benchmark::State& state) {
+  EmbeddingLookupHelper<DT_BFLOAT16>(state, /*gather_rows=*/false);
+}
+
+BENCHMARK(BM_EmbeddingLookup_Gather_FP32)
+    ->UseRealTime()
+    ->ArgPair(4096, 32)
+    ->ArgPair(4096, 128);
+BENCHMARK(BM_EmbeddingLookup_Direct_FP32)
+    ->UseRealTime()
+    ->ArgPair(4096, 32)
+    ->ArgPair(4096, 128);
+BENCHMARK(BM_EmbeddingLookup_Gather_BF16)
+    ->UseRealTime()
+    ->ArgPair(4096, 32)
+    ->ArgPair(4096, 128);
+BENCHMARK(BM_EmbeddingLookup_Direct_BF16)
+    ->UseRealTime()
+    ->ArgPair(4096, 32)
+    ->ArgPair(4096, 128);
+
 }  // namespace tensorflow
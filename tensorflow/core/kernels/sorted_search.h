@@ -0,0 +1,211 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
+#define TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+// CPU implementation of the searches of SearchSorted and Bucketize.
+//
+// A run of query values that is sorted is merged with the sorted sequence,
+// with an exponential search from the position of the previous value. Other
+// values are searched independently without branches on the comparisons,
+// either in the sorted sequence itself, or, when many values are searched in
+// the same sequence, in a copy of it in Eytzinger (breadth-first) order, in
+// which the elements compared in the first steps of all searches share a few
+// cache lines.
+//
+// With `kUpper`, the searches return the index of the first element greater
+// than the value, like `std::upper_bound()`, otherwise the index of the first
+// element not less than the value, like `std::lower_bound()`. Both use the same
+// comparisons as the standard algorithms, so that the results agree for all
+// values, including NaNs.
+
+namespace tensorflow {
+namespace sorted_search {
+
+// Returns whether `element` is before the position of `value` in a sorted
+// sequence.
+template <bool kUpper, typename T, typename V>
+inline bool IsBefore(const T& element, const V& value) {
+  if (kUpper) return !(value < element);
+  return element < value;
+}
+
+// Returns the position of `value` in `sorted[0, size)`.
+template <bool kUpper, typename T, typename V>
+inline int64_t BranchlessSearch(const T* sorted, int64_t size, const V& value) {
+  if (size == 0) return 0;
+  const T* base = sorted;
+  while (size > 1) {
+    const int64_t half = size / 2;
+    base = IsBefore<kUpper>(base[half], value) ? base + half : base;
+    size -= half;
+  }
+  return (base - sorted) + IsBefore<kUpper>(*base, value);
+}
+
+// Returns the position of `value` in `sorted[0, size)`, knowing that it is
+// not before `start`.
+template <bool kUpper, typename T, typename V>
+inline int64_t ExponentialSearch(const T* sorted, int64_t size, int64_t start,
+                                 const V& value) {
+  int64_t step = 1;
+  while (start + step <= size &&
+         IsBefore<kUpper>(sorted[start + step - 1], value)) {
+    start += step;
+    step *= 2;
+  }
+  const int64_t limit = std::min(start + step - 1, size);
+  return start + BranchlessSearch<kUpper>(sorted + start, limit - start, value);
+}
+
+// A sorted sequence in Eytzinger order.
+template <typename T>
+class EytzingerTable {
+ public:
+  EytzingerTable() = default;
+
+  EytzingerTable(const T* sorted, int64_t size) { Reset(sorted, size); }
+
+  void Reset(const T* sorted, int64_t size) {
+    // Elements are stored from index 1, so that the children of the element
+    // at index `k` are at `2 * k` and `2 * k + 1`.
+    elements_.resize(size + 1);
+    indices_.resize(size + 1);
+    int64_t next = 0;
+    Fill(sorted, size, 1, &next);
+  }
+
+  int64_t size() const { return static_cast<int64_t>(elements_.size()) - 1; }
+
+  // Returns the position of `value` in the sorted sequence.
+  template <bool kUpper, typename V>
+  int64_t Search(const V& value) const {
+    const uint64 size = this->size();
+    uint64 k = 1;
+    while (k <= size) {
+      k = 2 * k + IsBefore<kUpper>(elements_[k], value);
+    }
+    // Remove the trailing right turns and the final left turn, to get the
+    // first element that is not before `value`.
+    k >>= absl::countr_one(k) + 1;
+    return k == 0 ? static_cast<int64_t>(size) : indices_[k];
+  }
+
+ private:
+  void Fill(const T* sorted, int64_t size, uint64 k, int64_t* next) {
+    if (k > static_cast<uint64>(size)) return;
+    Fill(sorted, size, 2 * k, next);
+    elements_[k] = sorted[*next];
+    indices_[k] = (*next)++;
+    Fill(sorted, size, 2 * k + 1, next);
+  }
+
+  std::vector<T> elements_;
+  std::vector<int64_t> indices_;
+};
+
+// Sequences with at most this many elements fit in a few cache lines, and are
+// searched directly.
+constexpr int64_t kMaxDirectSearchSize = 64;
+
+// Returns whether the searches of `num_values` values in a sequence of `size`
+// elements should use an `EytzingerTable`, which takes about as long to build
+// as searching `size` values directly.
+inline bool ShouldUseTable(int64_t size, int64_t num_values) {
+  return size > kMaxDirectSearchSize && num_values >= size;
+}
+
+// Writes the positions of `values[0, num_values)` in `sorted[0, size)` to
+// `output`. `table` is an optional `EytzingerTable` of `sorted`.
+template <bool kUpper, typename T, typename V, typename OutType>
+void SearchRange(const T* sorted, int64_t size, const EytzingerTable<T>* table,
+                 const V* values, int64_t num_values, OutType* output) {
+  if (num_values == 0) return;
+  // The positions of sorted values are nondecreasing. This does not hold for
+  // NaNs, which fail the comparison.
+  bool values_sorted = true;
+  for (int64_t i = 1; i < num_values; ++i) {
+    values_sorted &= values[i - 1] <= values[i];
+  }
+  if (values_sorted) {
+    int64_t position = 0;
+    for (int64_t i = 0; i < num_values; ++i) {
+      position = ExponentialSearch<kUpper>(sorted, size, position, values[i]);
+      output[i] = static_cast<OutType>(position);
+    }
+  } else if (table != nullptr) {
+    for (int64_t i = 0; i < num_values; ++i) {
+      output[i] =
+          static_cast<OutType>(table->template Search<kUpper>(values[i]));
+    }
+  } else {
+    for (int64_t i = 0; i < num_values; ++i) {
+      output[i] = static_cast<OutType>(
+          BranchlessSearch<kUpper>(sorted, size, values[i]));
+    }
+  }
+}
+
+// For each of the `batch_size` rows, writes the positions of
+// `values[b * num_values, (b + 1) * num_values)` in
+// `sorted[b * size, (b + 1) * size)` to the same range of `output`, in
+// parallel over values.
+template <bool kUpper, typename T, typename V, typename OutType>
+void SearchSorted(OpKernelContext* context, const T* sorted, int64_t batch_size,
+                  int64_t size, const V* values, int64_t num_values,
+                  OutType* output) {
+  thread::ThreadPool* thread_pool =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  const int64_t cost_per_value = 4 * (Log2Ceiling64(size) + 1);
+
+  std::vector<EytzingerTable<T>> tables;
+  if (ShouldUseTable(size, num_values)) {
+    tables.resize(batch_size);
+    thread_pool->ParallelFor(batch_size, 8 * size,
+                             [&](int64_t first, int64_t last) {
+                               for (int64_t b = first; b < last; ++b) {
+                                 tables[b].Reset(sorted + b * size, size);
+                               }
+                             });
+  }
+
+  auto work_fn = [&](int64_t first, int64_t last) {
+    // Split the range at row boundaries.
+    while (first < last) {
+      const int64_t b = first / num_values;
+      const int64_t row_limit = std::min(last, (b + 1) * num_values);
+      SearchRange<kUpper>(sorted + b * size, size,
+                          tables.empty() ? nullptr : &tables[b],
+                          values + first, row_limit - first, output + first);
+      first = row_limit;
+    }
+  };
+  thread_pool->ParallelFor(batch_size * num_values, cost_per_value, work_fn);
+}
+
+}  // namespace sorted_search
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_KERNELS_SORTED_SEARCH_H_
@@ -700,25 +700,22 @@ GenerateKeyedColumnsFromInput(const OpInputList& indices_list_in,
   return columns;
 }
 
-// Allocates output tensors with proper size and sets the shape tensor of
-// the output SparseTensor.
-// It also output_start_indices which contains the start indices for each
-// input in the output SparseTensor.
-template <typename InternalType>
-Status CreateOutputTensors(
-    const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns,
-    int64_t batch_size, OpKernelContext* context, Tensor** indices_out,
-    Tensor** values_out, Tensor** shape_out,
-    std::vector<int64_t>* output_start_indices) {
+// Allocates output tensors for the number of crosses of each row given by
+// `cross_counts`, sets the shape tensor of the output SparseTensor and
+// computes output_start_indices.
+Status AllocateOutputTensors(const std::vector<int64_t>& cross_counts,
+                             int64_t batch_size, OpKernelContext* context,
+                             Tensor** indices_out, Tensor** values_out,
+                             Tensor** shape_out,
+                             std::vector<int64_t>* output_start_indices) {
   // Calculates dimensions for output tensors.
   int64_t cross_count_total = 0;
   int64_t max_cross_count = 0;
   for (int64_t b = 0; b < batch_size; b++) {
     // For each input, sets starting indices in output SparseTensor
     (*output_start_indices)[b] = cross_count_total;
-    const auto cross_count = CrossCountByBatchIndex(columns, b);
-    max_cross_count = std::max(max_cross_count, cross_count);
-    cross_count_total += cross_count;
+    max_cross_count = std::max(max_cross_count, cross_counts[b]);
+    cross_count_total += cross_counts[b];
   }
 
   // Allocates tensors.
@@ -736,6 +733,31 @@ Status CreateOutputTensors(
   return OkStatus();
 }
 
+// Allocates output tensors with proper size and sets the shape tensor of
+// the output SparseTensor.
+// It also output_start_indices which contains the start indices for each
+// input in the output SparseTensor.
+template <typename InternalType>
+Status CreateOutputTensors(
+    const std::vector<std::unique_ptr<ColumnInterface<InternalType>>>& columns,
+    int64_t batch_size, OpKernelContext* context, Tensor** indices_out,
+    Tensor** values_out, Tensor** shape_out,
+    std::vector<int64_t>* output_start_indices) {
+  std::vector<int64_t> cross_counts(batch_size);
+  for (int64_t b = 0; b < batch_size; b++) {
+    cross_counts[b] = CrossCountByBatchIndex(columns, b);
+  }
+  return AllocateOutputTensors(cross_counts, batch_size, context, indices_out,
+                               values_out, shape_out, output_start_indices);
+}
+
+// The feature hashes of one column of SparseCrossHashedOp, laid out row by
+// row. The features of row `b` are at [row_starts[b], row_starts[b + 1]).
+struct ColumnHashes {
+  std::vector<int64_t> row_starts;
+  std::vector<uint64> hashes;
+};
+
 template <bool HASHED_OUTPUT, typename InternalType>
 class SparseCrossOp : public OpKernel {
  public:
@@ -916,39 +938,115 @@ class SparseCrossHashedOp : public OpKernel {
         GenerateKeyedColumnsFromInput<int64_t>(indices_list_in, values_list_in,
                                                shapes_list_in, dense_list_in,
                                                key_);
+    const int64_t batch_size =
+        CalculateBatchSize(shapes_list_in, dense_list_in);
+    const int num_columns = columns.size();
+
+    // Hashes every feature once, instead of once per cross that uses it, and
+    // counts the crosses of each row so that the outputs can be allocated
+    // before they are filled in parallel.
+    std::vector<ColumnHashes> column_hashes(num_columns);
+    int64_t num_features = 0;
+    for (int i = 0; i < num_columns; ++i) {
+      ColumnHashes& column = column_hashes[i];
+      column.row_starts.resize(batch_size + 1);
+      int64_t row_start = 0;
+      for (int64_t b = 0; b < batch_size; ++b) {
+        column.row_starts[b] = row_start;
+        row_start += columns[i]->FeatureCount(b);
+      }
+      column.row_starts[batch_size] = row_start;
+      column.hashes.resize(row_start);
+      num_features += row_start;
+    }
+    std::vector<int64_t> cross_counts(batch_size);
+    auto hash_features = [&](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; ++b) {
+        int64_t cross_count = 1;
+        for (int i = 0; i < num_columns; ++i) {
+          ColumnHashes& column = column_hashes[i];
+          const int64_t row_start = column.row_starts[b];
+          const int64_t feature_count = column.row_starts[b + 1] - row_start;
+          for (int64_t n = 0; n < feature_count; ++n) {
+            column.hashes[row_start + n] =
+                columns[i]->Feature(b, n, strong_hash);
+          }
+          cross_count *= feature_count;
+        }
+        cross_counts[b] = cross_count;
+      }
+    };
+
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    const int64_t kCostPerFeature = 100;
+    const int64_t rows = std::max<int64_t>(1, batch_size);
+    Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+          kCostPerFeature * std::max<int64_t>(1, num_features / rows),
+          hash_features);
+
     Tensor* indices_out;
     Tensor* values_out;
     Tensor* shape_out;
-    const int64_t batch_size =
-        CalculateBatchSize(shapes_list_in, dense_list_in);
     std::vector<int64_t> output_start_indices(batch_size);
     OP_REQUIRES_OK(
         context,
-        CreateOutputTensors(columns, batch_size, context, &indices_out,
-                            &values_out, &shape_out, &output_start_indices));
-    const tstring unused_sep;
-    HashCrosserV2 crosser(columns, num_buckets, 0, unused_sep);
-    OutputUpdater<int64_t> updater(output_start_indices, indices_out,
-                                   values_out);
-    auto do_work = [&columns, crosser, updater, strong_hash](int64_t begin,
-                                                             int64_t end) {
-      for (int b = begin; b < end; b++) {
-        ProductIterator<int64_t> product_iterator(columns, b);
-        int64_t cross_count = 0;
-        while (product_iterator.HasNext()) {
-          const auto permutation = product_iterator.Next();
-          updater.Update(b, cross_count,
-                         crosser.Generate(b, permutation, strong_hash));
-          cross_count++;
+        AllocateOutputTensors(cross_counts, batch_size, context, &indices_out,
+                              &values_out, &shape_out, &output_start_indices));
+
+    // Enumerates the crosses of each row in the same order as
+    // ProductIterator, with the last column varying fastest. The partial
+    // fingerprints of the columns that did not change since the previous
+    // cross are reused, so most crosses cost a single FingerprintCat64.
+    auto indices_matrix = indices_out->matrix<int64_t>();
+    auto values_vec = values_out->vec<int64_t>();
+    auto do_work = [&](int64_t begin, int64_t end) {
+      gtl::InlinedVector<int64_t, 8> positions(num_columns, 0);
+      gtl::InlinedVector<uint64, 8> partial_hashes(num_columns);
+      for (int64_t b = begin; b < end; ++b) {
+        int first_changed = 0;
+        for (int64_t c = 0; c < cross_counts[b]; ++c) {
+          for (int i = first_changed; i < num_columns; ++i) {
+            const ColumnHashes& column = column_hashes[i];
+            const uint64 hash_i =
+                column.hashes[column.row_starts[b] + positions[i]];
+            partial_hashes[i] = i == 0 ? hash_i
+                                       : FingerprintCat64(partial_hashes[i - 1],
+                                                          hash_i);
+          }
+          const uint64 hashed_output = partial_hashes[num_columns - 1];
+          const int64_t output_index = output_start_indices[b] + c;
+          indices_matrix(output_index, 0) = b;
+          indices_matrix(output_index, 1) = c;
+          // The return value is int64 based on the number of buckets.
+          if (num_buckets > 0) {
+            values_vec(output_index) = hashed_output % num_buckets;
+          } else {
+            // To prevent negative output we take modulo to max int64.
+            values_vec(output_index) =
+                hashed_output % std::numeric_limits<int64_t>::max();
+          }
+
+          // Advances to the next cross. After the last cross of the row all
+          // positions wrap back to zero.
+          int i = num_columns - 1;
+          for (; i >= 0; --i) {
+            const ColumnHashes& column = column_hashes[i];
+            if (++positions[i] <
+                column.row_starts[b + 1] - column.row_starts[b]) {
+              break;
+            }
+            positions[i] = 0;
+          }
+          first_changed = i;
         }
       }
     };
 
-    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
-    // TODO(zakaria): optimize kCostPerUnit
-    const int kCostPerUnit = 5000 * indices_list_in.size();
+    const int64_t kCostPerCross = 50;
+    const int64_t num_crosses = indices_out->dim_size(0);
     Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
-          kCostPerUnit, do_work);
+          kCostPerCross * std::max<int64_t>(1, num_crosses / rows),
+          do_work);
   }
 };
 
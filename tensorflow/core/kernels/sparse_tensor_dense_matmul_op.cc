@@ -19,17 +19,233 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace functor {
+
+namespace {
+Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
+                         std::size_t lhs_right) {
+  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
+                                 "] out of bounds (>=", lhs_right, ")");
+}
+
+Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
+                         int64_t out_dim0) {
+  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
+                                 "] out of bounds (>=", out_dim0, ")");
+}
+
+}  // namespace
+
+// The sparse operand of SparseTensorDenseMatMul in compressed sparse row
+// format: row `m` of op(A) holds the entries `[row_ptr[m], row_ptr[m + 1])` of
+// `cols` and `values`, in the order in which they appear in `a_indices`.
+// Values are conjugated if `adjoint_a`.
+template <typename T, typename Tindices>
+struct SparseTensorDenseMatMulCsr {
+  std::vector<int64_t> row_ptr;
+  std::vector<Tindices> cols;
+  std::vector<T> values;
+};
+
+// Converts op(A) to CSR with a counting sort over its rows. The indices are
+// validated in order, so that the same error as the COO path is reported.
+template <typename T, typename Tindices, bool ADJ_A>
+Status BuildSparseTensorDenseMatMulCsr(
+    typename TTypes<Tindices>::ConstMatrix a_indices,
+    typename TTypes<T>::ConstVec a_values, int64_t num_rows,
+    int64_t lhs_right, SparseTensorDenseMatMulCsr<T, Tindices>* csr) {
+  const std::size_t nnz = a_values.size();
+  const int lhs_index_a = ADJ_A ? 1 : 0;
+  const int rhs_index_a = ADJ_A ? 0 : 1;
+
+  std::vector<Tindices> rows(nnz);
+  csr->row_ptr.assign(num_rows + 1, 0);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+    const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+    if (!FastBoundsCheck(k, lhs_right)) {
+      return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+    }
+    if (!FastBoundsCheck(m, num_rows)) {
+      return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+    }
+    rows[i] = m;
+    ++csr->row_ptr[m + 1];
+  }
+  for (int64_t m = 0; m < num_rows; ++m) {
+    csr->row_ptr[m + 1] += csr->row_ptr[m];
+  }
+
+  // Scatter the entries, using `next` as the insertion point of each row.
+  std::vector<int64_t> next(csr->row_ptr.begin(), csr->row_ptr.end() - 1);
+  csr->cols.resize(nnz);
+  csr->values.resize(nnz);
+  for (std::size_t i = 0; i < nnz; ++i) {
+    const int64_t pos = next[rows[i]]++;
+    csr->cols[pos] = a_indices(i, rhs_index_a);
+    csr->values[pos] = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+  }
+  return OkStatus();
+}
+
+// Computes `out = op(A) * op(B)` from the CSR form of op(A), with the rows of
+// the output sharded across the CPU worker threads. Each row is accumulated
+// in the same order as the COO path, so the results are identical.
+template <typename T, typename Tindices, bool ADJ_B>
+Status SparseTensorDenseMatMulCsrCompute(
+    OpKernelContext* ctx, const SparseTensorDenseMatMulCsr<T, Tindices>& csr,
+    typename TTypes<T>::ConstMatrix b, typename TTypes<T>::Matrix out) {
+  using Tsum = typename SumType<T>::type;
+  using Row = Eigen::Array<Tsum, Eigen::Dynamic, 1>;
+  using ConstRow = Eigen::Array<T, Eigen::Dynamic, 1>;
+
+  const int64_t num_rows = out.dimension(0);
+  const int64_t rhs_right = out.dimension(1);
+  const T* b_data = b.data();
+  Tensor b_adjoint_t;
+  if (ADJ_B) {
+    // Transpose and conjugate B once, so that each row of op(B) is contiguous.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value, TensorShape({b.dimension(1), rhs_right}),
+        &b_adjoint_t));
+    Eigen::array<int, 2> shuffle({1, 0});
+    b_adjoint_t.matrix<T>().device(ctx->eigen_device<CPUDevice>()) =
+        b.shuffle(shuffle).conjugate();
+    b_data = b_adjoint_t.flat<T>().data();
+  }
+
+  auto compute_rows = [&](int64_t begin, int64_t end) {
+    // Rows are accumulated in `Tsum`, in place when it is `T`.
+    constexpr bool kAccumulateInPlace = std::is_same<T, Tsum>::value;
+    std::vector<Tsum> buffer(kAccumulateInPlace ? 0 : rhs_right);
+    for (int64_t m = begin; m < end; ++m) {
+      T* out_row = out.data() + m * rhs_right;
+      Eigen::Map<Row> acc(kAccumulateInPlace
+                              ? reinterpret_cast<Tsum*>(out_row)
+                              : buffer.data(),
+                          rhs_right);
+      acc.setZero();
+      for (int64_t j = csr.row_ptr[m]; j < csr.row_ptr[m + 1]; ++j) {
+        const Tsum a_value = static_cast<Tsum>(csr.values[j]);
+        Eigen::Map<const ConstRow> b_row(
+            b_data + static_cast<int64_t>(csr.cols[j]) * rhs_right, rhs_right);
+        acc += b_row.template cast<Tsum>() * a_value;
+      }
+      if (!kAccumulateInPlace) {
+        Eigen::Map<ConstRow>(out_row, rhs_right) = acc.template cast<T>();
+      }
+    }
+  };
+
+  const int64_t nnz = csr.values.size();
+  const int64_t cost_per_row =
+      (nnz / std::max<int64_t>(num_rows, 1) + 1) * rhs_right *
+      (Eigen::TensorOpCost::AddCost<Tsum>() +
+       Eigen::TensorOpCost::MulCost<Tsum>());
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(ctx->device()->tensorflow_cpu_worker_threads());
+  Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
+        cost_per_row, compute_rows);
+  return OkStatus();
+}
+
+// Caches the CSR form of the sparse operand across calls, for operands that do
+// not change between steps, such as constants or rarely updated variables.
+//
+// A copy of the operand is only kept once the same buffers are seen twice in a
+// row, and every hit is verified against the copy, so operands that change on
+// each step only pay for the pointer comparison.
+template <typename T, typename Tindices>
+class SparseTensorDenseMatMulCsrCache {
+ public:
+  using Csr = SparseTensorDenseMatMulCsr<T, Tindices>;
+
+  // Sets `csr` to the CSR form of the operand `(a_indices, a_values)` of op(A)
+  // with shape `[num_rows, num_cols]`, calling `build` on a miss.
+  Status Get(const Tensor& a_indices, const Tensor& a_values,
+             int64_t num_rows, int64_t num_cols,
+             const std::function<Status(Csr*)>& build,
+             std::shared_ptr<const Csr>* csr) {
+    const void* indices_data = a_indices.tensor_data().data();
+    const void* values_data = a_values.tensor_data().data();
+    Tensor cached_indices;
+    Tensor cached_values;
+    std::shared_ptr<const Csr> cached_csr;
+    bool same_buffers = false;
+    {
+      mutex_lock l(mu_);
+      if (csr_ != nullptr && num_rows_ == num_rows && num_cols_ == num_cols) {
+        cached_indices = indices_;
+        cached_values = values_;
+        cached_csr = csr_;
+      }
+      same_buffers = indices_data == last_indices_data_ &&
+                     values_data == last_values_data_;
+      last_indices_data_ = indices_data;
+      last_values_data_ = values_data;
+    }
+    if (cached_csr != nullptr &&
+        cached_indices.tensor_data() == a_indices.tensor_data() &&
+        cached_values.tensor_data() == a_values.tensor_data()) {
+      *csr = std::move(cached_csr);
+      return OkStatus();
+    }
+
+    auto new_csr = std::make_shared<Csr>();
+    TF_RETURN_IF_ERROR(build(new_csr.get()));
+    *csr = new_csr;
+
+    mutex_lock l(mu_);
+    if (same_buffers) {
+      indices_ = tensor::DeepCopy(a_indices);
+      values_ = tensor::DeepCopy(a_values);
+      num_rows_ = num_rows;
+      num_cols_ = num_cols;
+      csr_ = std::move(new_csr);
+    } else if (cached_csr != nullptr) {
+      // The operand changed, do not keep a stale copy alive.
+      indices_ = Tensor();
+      values_ = Tensor();
+      csr_ = nullptr;
+    }
+    return OkStatus();
+  }
+
+ private:
+  mutex mu_;
+  // Buffers of the operand of the previous call.
+  const void* last_indices_data_ TF_GUARDED_BY(mu_) = nullptr;
+  const void* last_values_data_ TF_GUARDED_BY(mu_) = nullptr;
+  // Copy of the cached operand and its CSR form.
+  Tensor indices_ TF_GUARDED_BY(mu_);
+  Tensor values_ TF_GUARDED_BY(mu_);
+  int64_t num_rows_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_cols_ TF_GUARDED_BY(mu_) = 0;
+  std::shared_ptr<const Csr> csr_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace functor
+
 template <typename Device, typename T, typename Tindices>
 class SparseTensorDenseMatMulOp : public OpKernel {
  public:
@@ -133,8 +349,16 @@ class SparseTensorDenseMatMulOp : public OpKernel {
       return;
     }
 
+    const bool use_csr = UseCsr(ctx, nnz, outer_right);
+
 #define MAYBE_ADJOINT(ADJ_A, ADJ_B)                                           \
   if (adjoint_a_ == ADJ_A && adjoint_b_ == ADJ_B) {                           \
+    if (use_csr) {                                                            \
+      OP_REQUIRES_OK(ctx, (ComputeWithCsr<ADJ_A, ADJ_B>(                      \
+                              ctx, *a_indices, *a_values, *b, inner_left,     \
+                              out)));                                         \
+      return;                                                                 \
+    }                                                                         \
     Status functor_status = functor::SparseTensorDenseMatMulFunctor<          \
         Device, T, Tindices, ADJ_A,                                           \
         ADJ_B>::Compute(ctx, out->matrix<T>(), a_indices->matrix<Tindices>(), \
@@ -151,8 +375,38 @@ class SparseTensorDenseMatMulOp : public OpKernel {
   }
 
  private:
+  // Minimum number of multiply-adds for which the sparse operand is converted
+  // to CSR, so that the output rows can be computed in parallel.
+  static constexpr int64_t kMinCsrWork = 1 << 16;
+
+  bool UseCsr(OpKernelContext* ctx, int64_t nnz, int64_t outer_right) const {
+    return std::is_same<Device, CPUDevice>::value &&
+           ctx->device()->tensorflow_cpu_worker_threads()->num_threads > 1 &&
+           nnz * outer_right >= kMinCsrWork;
+  }
+
+  template <bool ADJ_A, bool ADJ_B>
+  Status ComputeWithCsr(OpKernelContext* ctx, const Tensor& a_indices,
+                        const Tensor& a_values, const Tensor& b,
+                        int64_t inner_left, Tensor* out) {
+    using Csr = functor::SparseTensorDenseMatMulCsr<T, Tindices>;
+    const int64_t num_rows = out->dim_size(0);
+    std::shared_ptr<const Csr> csr;
+    TF_RETURN_IF_ERROR(csr_cache_.Get(
+        a_indices, a_values, num_rows, inner_left,
+        [&](Csr* csr) {
+          return functor::BuildSparseTensorDenseMatMulCsr<T, Tindices, ADJ_A>(
+              a_indices.matrix<Tindices>(), a_values.vec<T>(), num_rows,
+              inner_left, csr);
+        },
+        &csr));
+    return functor::SparseTensorDenseMatMulCsrCompute<T, Tindices, ADJ_B>(
+        ctx, *csr, b.matrix<T>(), out->matrix<T>());
+  }
+
   bool adjoint_a_;
   bool adjoint_b_;
+  functor::SparseTensorDenseMatMulCsrCache<T, Tindices> csr_cache_;
 };
 
 #define REGISTER_CPU(TypeT, TypeIndex)           \
@@ -238,18 +492,6 @@ REGISTER_KERNELS_GPU(complex128);
 namespace functor {
 
 namespace {
-Status KOutOfBoundsError(int64_t k, std::size_t i, int rhs_index_a,
-                         std::size_t lhs_right) {
-  return errors::InvalidArgument("k (", k, ") from index[", i, ",", rhs_index_a,
-                                 "] out of bounds (>=", lhs_right, ")");
-}
-
-Status MOutOfBoundsError(int64_t m, std::size_t i, int lhs_index_a,
-                         int64_t out_dim0) {
-  return errors::InvalidArgument("m (", m, ") from index[", i, ",", lhs_index_a,
-                                 "] out of bounds (>=", out_dim0, ")");
-}
-
 template <typename T, typename Tsum, typename Tindices, bool ADJ_A, bool ADJ_B>
 Status SparseTensorDenseMatMulImpl(
     typename TTypes<Tsum>::Matrix out,
@@ -120,4 +120,10 @@ BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, false, true);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, false);
 BM_SparseTensorDenseMatmul(16384, 4096, 4096, 4096, true, true);
 
+// Wide linear models: a batch of sparse features times a tall embedding.
+BM_SparseTensorDenseMatmul(65536, 512, 262144, 16, false, false);
+BM_SparseTensorDenseMatmul(65536, 512, 262144, 64, false, false);
+BM_SparseTensorDenseMatmul(65536, 512, 262144, 64, false, true);
+BM_SparseTensorDenseMatmul(65536, 512, 262144, 64, true, false);
+
 }  // end namespace tensorflow
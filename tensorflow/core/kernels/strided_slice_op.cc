@@ -327,6 +327,9 @@ class StridedSliceAssignOp : public OpKernel {
         OP_REQUIRES_OK(context,
                        EnsureSparseVariableAccess<Device, T>(context, v.get()));
         mutex_lock ml(*v->mu());
+        OP_REQUIRES_OK(context, PrepareToUpdateSnapshotVariable<Device, T>(
+                                    context, v.get()));
+        v->MarkAllRowsDirty();
         old_lhs = v->tensor();
         OP_REQUIRES(context, old_lhs->dtype() == DataTypeToEnum<T>::value,
                     errors::InvalidArgument(
@@ -21,6 +21,7 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/kernels/string_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -40,6 +41,7 @@ class StringNGramsOp : public tensorflow::OpKernel {
     OP_REQUIRES_OK(context, context->GetAttr("pad_width", &pad_width_));
     OP_REQUIRES_OK(context, context->GetAttr("preserve_short_sequences",
                                              &preserve_short_));
+    OP_REQUIRES_OK(context, context->GetAttr("output_views", &output_views_));
   }
 
   int get_pad_width(const int ngram_width) const {
@@ -133,10 +135,18 @@ class StringNGramsOp : public tensorflow::OpKernel {
     }
 
     tensorflow::Tensor* ngrams;
-    OP_REQUIRES_OK(
-        context,
-        context->allocate_output(
-            0, TensorShape({ngrams_splits_data[num_batch_items]}), &ngrams));
+    tensorflow::Tensor ngrams_views;
+    const TensorShape ngrams_shape({ngrams_splits_data[num_batch_items]});
+    if (output_views_) {
+      // Unigrams point into the strings of `data`, whose buffer is kept alive
+      // by the output.
+      OP_REQUIRES_OK(context, AllocateStringViewTensor(
+                                  context, *data, ngrams_shape, &ngrams_views));
+      ngrams = &ngrams_views;
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(0, ngrams_shape, &ngrams));
+    }
     auto ngrams_data = ngrams->flat<tstring>().data();
 
     for (int i = 0; i < num_batch_items; ++i) {
@@ -182,6 +192,7 @@ class StringNGramsOp : public tensorflow::OpKernel {
         CreateNgrams(data_start, output_start, num_ngrams, ngram_width);
       }
     }
+    if (output_views_) context->set_output(0, ngrams_views);
   }
 
   void CreateNgrams(const tstring* data, tstring* output, int num_ngrams,
@@ -194,6 +205,13 @@ class StringNGramsOp : public tensorflow::OpKernel {
       int num_tokens = ngram_width - (left_padding + right_padding);
       int data_start_index = left_padding > 0 ? 0 : ngram_index - pad_width;
 
+      tstring* ngram = &output[ngram_index];
+      if (output_views_ && num_tokens == 1 && left_padding == 0 &&
+          right_padding == 0) {
+        SetStringOrView(data[data_start_index], ngram);
+        continue;
+      }
+
       // Calculate the total expected size of the ngram so we can reserve the
       // correct amount of space in the string.
       int ngram_size = 0;
@@ -210,7 +228,6 @@ class StringNGramsOp : public tensorflow::OpKernel {
       ngram_size += num_separators * separator_.length();
 
       // Build the ngram.
-      tstring* ngram = &output[ngram_index];
       ngram->reserve(ngram_size);
       for (int n = 0; n < left_padding; ++n) {
         ngram->append(left_pad_);
@@ -256,6 +273,7 @@ class StringNGramsOp : public tensorflow::OpKernel {
   bool use_pad_;
   bool extend_pad_;
   bool preserve_short_;
+  bool output_views_;
 
   std::vector<int> ngram_widths_;
   int pad_width_;
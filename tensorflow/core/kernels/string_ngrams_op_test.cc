@@ -37,7 +37,8 @@ using tensorflow::TensorShape;
 class NgramKernelTest : public tensorflow::OpsTestBase {
  public:
   void MakeOp(string separator, std::vector<int> ngram_width, string left_pad,
-              string right_pad, int pad_width, bool preserve) {
+              string right_pad, int pad_width, bool preserve,
+              bool output_views = false) {
     TF_ASSERT_OK(NodeDefBuilder("tested_op", "StringNGrams")
                      .Attr("separator", separator)
                      .Attr("ngram_widths", ngram_width)
@@ -45,6 +46,7 @@ class NgramKernelTest : public tensorflow::OpsTestBase {
                      .Attr("right_pad", right_pad)
                      .Attr("pad_width", pad_width)
                      .Attr("preserve_short_sequences", preserve)
+                     .Attr("output_views", output_views)
                      .Input(FakeInput())
                      .Input(FakeInput())
                      .Finalize(node_def()));
@@ -578,6 +580,29 @@ TEST_F(NgramKernelTest, TestNoTokensNoPad) {
   assert_int64_equal(expected_splits, *GetOutput(1));
 }
 
+TEST_F(NgramKernelTest, TestOutputViews) {
+  const tstring long_token = "a_token_that_does_not_fit_in_a_small_string";
+  MakeOp("|", {1, 2}, "LP", "RP", 0, false, /*output_views=*/true);
+  // Batch items are:
+  // 0: "a", long_token
+  AddInputFromArray<tstring>(TensorShape({2}), {"a", long_token});
+  AddInputFromArray<int64_t>(TensorShape({2}), {0, 2});
+  TF_ASSERT_OK(RunOpKernel());
+
+  std::vector<tstring> expected_values({"a", long_token, "a|" + long_token});
+  std::vector<int64_t> expected_splits({0, 3});
+
+  assert_string_equal(expected_values, *GetOutput(0));
+  assert_int64_equal(expected_splits, *GetOutput(1));
+
+  // Only unigrams that do not fit in a small string are views.
+  auto ngrams = GetOutput(0)->vec<tstring>();
+  EXPECT_EQ(ngrams(0).type(), tstring::SMALL);
+  EXPECT_EQ(ngrams(1).type(), tstring::VIEW);
+  EXPECT_EQ(ngrams(1).data(), GetInput(0).vec<tstring>()(1).data());
+  EXPECT_EQ(ngrams(2).type(), tstring::LARGE);
+}
+
 TEST_F(NgramKernelTest, ShapeFn) {
   ShapeInferenceTestOp op("StringNGrams");
   INFER_OK(op, "?;?", "[?];[?]");
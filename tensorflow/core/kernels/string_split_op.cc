@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/kernel_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/string_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -244,6 +245,7 @@ class StringSplitV2Op : public OpKernel {
   explicit StringSplitV2Op(OpKernelConstruction* context)
       : OpKernel(context), maxsplit_(-1) {
     OP_REQUIRES_OK(context, context->GetAttr("maxsplit", &maxsplit_));
+    OP_REQUIRES_OK(context, context->GetAttr("output_views", &output_views_));
   }
 
   void Compute(OpKernelContext* ctx) override {
@@ -284,8 +286,18 @@ class StringSplitV2Op : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({output_size, 2}),
                                              &sp_indices_t));
     Tensor* sp_tokens_t;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_output(1, TensorShape({output_size}), &sp_tokens_t));
+    Tensor sp_tokens_views;
+    if (output_views_) {
+      // The tokens point into the strings of `input`, whose buffer is kept
+      // alive by the output.
+      OP_REQUIRES_OK(ctx, AllocateStringViewTensor(
+                              ctx, *input_tensor, TensorShape({output_size}),
+                              &sp_tokens_views));
+      sp_tokens_t = &sp_tokens_views;
+    } else {
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({output_size}),
+                                               &sp_tokens_t));
+    }
     Tensor* sp_shape_t;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({2}), &sp_shape_t));
 
@@ -299,14 +311,20 @@ class StringSplitV2Op : public OpKernel {
       for (size_t j = 0; j < num_indices[i]; ++j) {
         sp_indices(c, 0) = i;
         sp_indices(c, 1) = j;
-        sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
+        if (output_views_) {
+          SetStringOrView(tokens[c], &sp_tokens(c));
+        } else {
+          sp_tokens(c).assign(tokens[c].data(), tokens[c].size());
+        }
         ++c;
       }
     }
+    if (output_views_) ctx->set_output(1, sp_tokens_views);
   }
 
  private:
   int maxsplit_;
+  bool output_views_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("StringSplit").Device(DEVICE_CPU), StringSplitOp);
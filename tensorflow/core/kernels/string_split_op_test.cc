@@ -126,4 +126,81 @@ BENCHMARK(BM_StringSplitV2)
     ->Arg(128)
     ->Arg(256);
 
+class StringSplitV2OpTest : public OpsTestBase {
+ protected:
+  void MakeOp(bool output_views) {
+    TF_ASSERT_OK(NodeDefBuilder("string_split_op", "StringSplitV2")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_STRING))
+                     .Attr("output_views", output_views)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+};
+
+TEST_F(StringSplitV2OpTest, OutputViews) {
+  const tstring long_token = "a_token_that_does_not_fit_in_a_small_string";
+  MakeOp(/*output_views=*/true);
+  AddInputFromArray<tstring>(TensorShape({2}),
+                             {"a " + long_token, long_token + " b c"});
+  AddInputFromArray<tstring>(TensorShape({}), {" "});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected_values(DT_STRING, TensorShape({5}));
+  test::FillValues<tstring>(&expected_values,
+                            {"a", long_token, long_token, "b", "c"});
+  test::ExpectTensorEqual<tstring>(expected_values, *GetOutput(1));
+
+  // Long tokens are views into the input, and short ones are copied.
+  auto values = GetOutput(1)->vec<tstring>();
+  EXPECT_EQ(values(0).type(), tstring::SMALL);
+  EXPECT_EQ(values(1).type(), tstring::VIEW);
+  EXPECT_EQ(values(1).data(), GetInput(0).vec<tstring>()(0).data() + 2);
+  EXPECT_EQ(values(2).type(), tstring::VIEW);
+}
+
+TEST_F(StringSplitV2OpTest, OutputViewsKeepInputAlive) {
+  const tstring long_token = "a_token_that_does_not_fit_in_a_small_string";
+  Tensor values;
+  {
+    MakeOp(/*output_views=*/true);
+    AddInputFromArray<tstring>(TensorShape({1}), {long_token + " x"});
+    AddInputFromArray<tstring>(TensorShape({}), {" "});
+    TF_ASSERT_OK(RunOpKernel());
+    values = *GetOutput(1);
+    // Drops the references held by the test to the input and the output.
+    context_.reset();
+    inputs_.clear();
+    for (Tensor* t : tensors_) delete t;
+    tensors_.clear();
+  }
+  EXPECT_EQ(values.vec<tstring>()(0), long_token);
+}
+
+static void BM_StringSplitV2Views(::testing::benchmark::State& state) {
+  const int batch_size = state.range(0);
+
+  Tensor input = GetTestTensor(batch_size);
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor sep(DT_STRING, TensorShape({}));
+  sep.flat<tstring>().setConstant(" ");
+  TF_CHECK_OK(NodeBuilder("string_split_op", "StringSplitV2")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, sep))
+                  .Attr("output_views", true)
+                  .Finalize(g, nullptr /* node */));
+  test::Benchmark("cpu", g, /*old_benchmark_api*/ false).Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_StringSplitV2Views)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64)
+    ->Arg(128)
+    ->Arg(256);
+
 }  // end namespace tensorflow
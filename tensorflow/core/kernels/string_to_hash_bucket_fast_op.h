@@ -20,9 +20,11 @@ limitations under the License.
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/batch_fingerprint.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -61,6 +63,55 @@ class StringToHashBucketOp : public OpKernel {
   TF_DISALLOW_COPY_AND_ASSIGN(StringToHashBucketOp);
 };
 
+// StringToHashBucketOp<Fingerprint64>, which fingerprints the strings with
+// BatchFingerprint64() in parallel shards.
+class StringToHashBucketFastOp : public OpKernel {
+ public:
+  explicit StringToHashBucketFastOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_buckets", &num_buckets_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor* input_tensor;
+    OP_REQUIRES_OK(context, context->input("input", &input_tensor));
+    const auto& input_flat = input_tensor->flat<tstring>();
+
+    Tensor* output_tensor = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output("output", input_tensor->shape(),
+                                            &output_tensor));
+    auto output_flat = output_tensor->flat<int64_t>();
+
+    const tstring* inputs = input_flat.data();
+    // The fingerprints are written to the output and replaced by the bucket
+    // ids in place.
+    uint64* fingerprints = reinterpret_cast<uint64*>(output_flat.data());
+    const uint64 num_buckets = num_buckets_;
+    auto work = [inputs, fingerprints, num_buckets](int64_t start,
+                                                    int64_t limit) {
+      BatchFingerprint64(inputs + start, limit - start, fingerprints + start);
+      for (int64_t i = start; i < limit; ++i) {
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        fingerprints[i] = fingerprints[i] % num_buckets;
+      }
+    };
+    // Fingerprinting a short string and reducing it to a bucket take in the
+    // order of 50 cycles.
+    const int64_t kCostPerString = 50;
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          input_flat.size(), kCostPerString, work);
+  }
+
+ private:
+  int64_t num_buckets_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StringToHashBucketFastOp);
+};
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_FAST_OP_H_
@@ -14,10 +14,49 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/kernels/string_util.h"
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/typed_allocator.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The buffer of a string tensor whose elements may be views into the strings
+// of another tensor, which is kept alive by this buffer.
+class StringViewBuffer : public TensorBuffer {
+ public:
+  StringViewBuffer(Allocator* alloc, tstring* data, int64_t num_elements,
+                   const Tensor& source)
+      : TensorBuffer(data),
+        alloc_(alloc),
+        num_elements_(num_elements),
+        source_(source) {}
+
+  ~StringViewBuffer() override {
+    TypedAllocator::Deallocate<tstring>(alloc_, base<tstring>(),
+                                        num_elements_);
+  }
+
+  size_t size() const override { return sizeof(tstring) * num_elements_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size());
+    proto->set_allocator_name(alloc_->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data()));
+  }
+
+ private:
+  Allocator* const alloc_;
+  const int64_t num_elements_;
+  // Holds a reference to the buffer that the views point into.
+  const Tensor source_;
+};
+
+}  // namespace
+
 // Sets unit value based on str.
 Status ParseUnicodeEncoding(const string& str, UnicodeEncoding* encoding) {
   if (str == "UTF-8") {
@@ -61,4 +100,24 @@ int32 UTF8StrLen(const string& str) {
   return result;
 }
 
+Status AllocateStringViewTensor(OpKernelContext* ctx, const Tensor& source,
+                                const TensorShape& shape, Tensor* out) {
+  const int64_t num_elements = shape.num_elements();
+  if (num_elements == 0) {
+    *out = Tensor(DT_STRING, shape);
+    return OkStatus();
+  }
+  Allocator* alloc = ctx->get_allocator(AllocatorAttributes());
+  tstring* data = TypedAllocator::Allocate<tstring>(alloc, num_elements,
+                                                    AllocationAttributes());
+  if (data == nullptr) {
+    return errors::ResourceExhausted(
+        "OOM when allocating string tensor with shape", shape.DebugString());
+  }
+  auto* buf = new StringViewBuffer(alloc, data, num_elements, source);
+  *out = Tensor(DT_STRING, shape, buf);
+  buf->Unref();
+  return OkStatus();
+}
+
 }  // namespace tensorflow
@@ -15,7 +15,12 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_STRING_UTIL_H_
 #define TENSORFLOW_CORE_KERNELS_STRING_UTIL_H_
 
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
 
 namespace tensorflow {
 
@@ -82,6 +87,28 @@ bool BackNUTF8CharPositions(const StringPiece in,
   return utf8_chars_counted == num_utf8_chars_to_shift;
 }
 
+// Allocates a string tensor of `shape` whose elements may be set with
+// `SetStringOrView()` to views into the strings of `source`. The buffer of
+// `*out` holds a reference to the buffer of `source`, so the views stay valid
+// for as long as `*out`, or any tensor sharing its buffer, is alive.
+//
+// Copying a VIEW tstring copies the view and not the characters, so kernels
+// that copy the elements of `*out` into new tensors produce views that do not
+// keep `source` alive. Only use this for outputs that the caller opts into,
+// such as the `output_views` attr of StringSplitV2.
+Status AllocateStringViewTensor(OpKernelContext* ctx, const Tensor& source,
+                                const TensorShape& shape, Tensor* out);
+
+// Sets `*dst` to `str`. Strings that fit in a SMALL tstring are copied, since
+// that needs no allocation, and longer strings are assigned as a VIEW.
+inline void SetStringOrView(StringPiece str, tstring* dst) {
+  if (str.size() <= TF_TString_SmallCapacity) {
+    dst->assign(str.data(), str.size());
+  } else {
+    dst->assign_as_view(str);
+  }
+}
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_CORE_KERNELS_STRING_UTIL_H_
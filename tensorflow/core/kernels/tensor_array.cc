@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/aggregate_ops_cpu.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -81,6 +82,75 @@ TF_CALL_COMPLEX_TYPES(TENSOR_ARRAY_SET_ZERO_GPU);
 
 std::atomic<int64_t> TensorArray::tensor_array_counter{0};
 
+/* static */
+bool TensorArray::ContiguousStorageEnabled() {
+  static const bool enabled = [] {
+    bool enabled = false;
+    TF_CHECK_OK(ReadBoolFromEnvVar("TF_TENSOR_ARRAY_CONTIGUOUS_STORAGE",
+                                   /*default_val=*/false, &enabled));
+    return enabled;
+  }();
+  return enabled;
+}
+
+Status TensorArray::MaybeUseContiguousStorage(OpKernelContext* ctx) {
+  mutex_lock l(mu_);
+  TensorShape element_shape;
+  if (dynamic_size_ || multiple_writes_aggregate_ || tensors_.empty() ||
+      !DataTypeCanUseMemcpy(dtype_) ||
+      !element_shape_.AsTensorShape(&element_shape) ||
+      element_shape.num_elements() == 0) {
+    return OkStatus();
+  }
+  AllocatorAttributes attr;
+  attr.set_on_host(true);
+  TensorShape buffer_shape = element_shape;
+  buffer_shape.InsertDim(0, tensors_.size());
+  return ctx->allocate_temp(dtype_, buffer_shape, &buffer_, attr);
+}
+
+void TensorArray::LockedWriteToBuffer(const int32_t index,
+                                      const Tensor& value) {
+  TensorAndState& t = tensors_[index];
+  // The element shape is fully defined, so 'value' has the shape of the
+  // elements of buffer_.
+  t.tensor = buffer_.SubSlice(index);
+  memcpy(t.tensor.data(), value.data(), value.TotalBytes());
+  t.shape = value.shape();
+  t.written = true;
+}
+
+bool TensorArray::ReadContiguous(int32_t begin, int32_t end, Tensor* value) {
+  mutex_lock l(mu_);
+  if (closed_ || !buffer_.IsInitialized() || begin < 0 || begin >= end ||
+      static_cast<size_t>(end) > tensors_.size()) {
+    return false;
+  }
+  Tensor slice = buffer_.Slice(begin, end);
+  if (!slice.IsAligned()) return false;
+  const int64_t element_bytes = buffer_.TotalBytes() / tensors_.size();
+  const char* data = static_cast<const char*>(slice.data());
+  for (int32_t i = begin; i < end; ++i) {
+    // Elements that were never written, or that were read as zeros, are not
+    // in buffer_.
+    const TensorAndState& t = tensors_[i];
+    if (!t.written || t.cleared || !t.tensor.IsInitialized() ||
+        t.tensor.data() != data + (i - begin) * element_bytes) {
+      return false;
+    }
+  }
+  for (int32_t i = begin; i < end; ++i) {
+    TensorAndState& t = tensors_[i];
+    if (clear_after_read_) {
+      t.tensor = Tensor();
+      t.cleared = true;
+    }
+    t.read = true;
+  }
+  *value = std::move(slice);
+  return true;
+}
+
 Status TensorArray::CopyShapesFrom(TensorArray* rhs,
                                    const TensorShape* shape_to_prepend) {
   mutex_lock l(mu_);
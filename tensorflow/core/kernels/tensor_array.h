@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_CORE_KERNELS_TENSOR_ARRAY_H_
 
 #include <limits.h>
+
+#include <cstring>
 #include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -113,6 +115,9 @@ TF_CALL_COMPLEX_TYPES(TENSOR_ARRAY_SET_ZERO_GPU);
 //     All operations on a TensorArray are thread-safe.
 //   * A TensorArray may be preemptively closed, which releases all
 //     memory associated with it.
+//   * Optionally, the elements of a TensorArray with a fixed size and a fully
+//     defined element shape on the CPU may be stored contiguously, see
+//     MaybeUseContiguousStorage().
 //
 // These properties together allow the TensorArray to work as a
 // functional object and makes gradient computation easy.  For
@@ -225,6 +230,15 @@ class TensorArray : public ResourceBase {
     return LockedRead<Device, T>(ctx, index, value);
   }
 
+  // If the elements in [begin, end) are all stored contiguously (see
+  // MaybeUseContiguousStorage()), reads them without copying as a single
+  // Tensor of shape [end - begin] + element shape, and returns true.
+  // Otherwise returns false without side effects, and the elements must be
+  // read with ReadMany().
+  //
+  // Side effects are the same as those of Read() on each element.
+  bool ReadContiguous(int32_t begin, int32_t end, Tensor* value);
+
   template <typename Device, typename T>
   Status ReadMany(OpKernelContext* ctx, const std::vector<int32>& indices,
                   std::vector<Tensor>* values) {
@@ -333,10 +347,28 @@ class TensorArray : public ResourceBase {
   // to the rhs to access its mutex.
   Status CopyShapesFrom(TensorArray* rhs, const TensorShape* shape_to_prepend);
 
+  // Returns true if TensorArrays should use contiguous storage when possible,
+  // as requested by setting TF_TENSOR_ARRAY_CONTIGUOUS_STORAGE=1.
+  static bool ContiguousStorageEnabled();
+
+  // Preallocates one buffer of shape [N] + element shape for all the elements,
+  // if the TensorArray has a fixed size, a fully defined element shape, and a
+  // type that can be copied with memcpy.  Must only be called for
+  // TensorArrays on the CPU, before any other method.
+  //
+  // Writes then copy their values into the buffer, instead of holding a
+  // reference to them, and reads return views of the buffer.  Stacking or
+  // concatenating all the elements then returns the buffer itself, which
+  // avoids the copy, and halves the peak memory, of loops that write a full
+  // sequence and stack it.  Writes of elements that are never stacked pay
+  // for a copy instead.
+  Status MaybeUseContiguousStorage(OpKernelContext* ctx);
+
   // Clear the TensorArray, including any Tensor references, and mark as closed.
   void ClearAndMarkClosed() {
     mutex_lock l(mu_);
     tensors_.clear();
+    buffer_ = Tensor();
     closed_ = true;
   }
 
@@ -361,6 +393,10 @@ class TensorArray : public ResourceBase {
   Status LockedRead(OpKernelContext* ctx, const int32_t index, Tensor* value)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Copies the first write of 'value' to 'index' into buffer_.
+  void LockedWriteToBuffer(const int32_t index, const Tensor& value)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   Status LockedReturnIfClosed() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     if (closed_) {
       return errors::InvalidArgument("TensorArray ", handle_.vec<tstring>()(1),
@@ -434,6 +470,11 @@ class TensorArray : public ResourceBase {
   };
   // The list of underlying Tensors and states.
   std::vector<TensorAndState> tensors_ TF_GUARDED_BY(mu_);
+
+  // If initialized, the contiguous storage of the elements, of shape
+  // [N] + element_shape_.  The tensors of the elements that were written are
+  // views of this buffer.
+  Tensor buffer_ TF_GUARDED_BY(mu_);
 };
 
 template <typename Device, typename T>
@@ -530,6 +571,8 @@ Status TensorArray::LockedWriteOrAggregate(OpKernelContext* ctx,
     // We've aggregated the values, so disallow backprop on this
     // TensorArray.
     gradients_disallowed_ = true;
+  } else if (buffer_.IsInitialized()) {
+    LockedWriteToBuffer(index, *value);
   } else {
     t.tensor = *value;
     t.shape = value->shape();
@@ -611,7 +654,13 @@ Status TensorArray::LockedRead(OpKernelContext* ctx, const int32_t index,
   }
 
   // Data is available inside the tensor, copy the reference over.
-  *value = t.tensor;
+  if (t.tensor.IsAligned()) {
+    *value = t.tensor;
+  } else {
+    // Views of the contiguous storage may not be aligned.
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(dtype_, t.shape, value));
+    memcpy(value->data(), t.tensor.data(), t.tensor.TotalBytes());
+  }
 
   if (clear_after_read_) {
     t.tensor = Tensor();
@@ -97,6 +97,15 @@ Status SetupFlowControlInputs(OpKernelContext* ctx, bool set_output) {
   return OkStatus();
 }
 
+// Returns true if 'indices' is a non-empty range of consecutive indices.
+bool IsRange(const std::vector<int32>& indices) {
+  if (indices.empty()) return false;
+  for (size_t i = 1; i < indices.size(); ++i) {
+    if (indices[i] != indices[0] + static_cast<int32>(i)) return false;
+  }
+  return true;
+}
+
 // CREATION *******************************************************************
 
 // Virtual class for shared behavior between TensorArrayOp and
@@ -150,7 +159,6 @@ class TensorArrayCreationOp : public OpKernel {
                                    Tensor* tensor_array_output_handle,
                                    TensorArray** output_tensor_array) = 0;
 
- private:
   const DeviceType device_type_;
 };
 
@@ -209,6 +217,13 @@ class TensorArrayOp : public TensorArrayCreationOp {
         identical_element_shapes_, dynamic_size_,
         false /* multiple_writes_aggregate */, false /* is_grad */,
         -1 /* marked_size */, clear_after_read_);
+    if (TensorArray::ContiguousStorageEnabled() && device_type_ == DEVICE_CPU) {
+      Status s = tensor_array->MaybeUseContiguousStorage(ctx);
+      if (!s.ok()) {
+        tensor_array->Unref();
+        return s;
+      }
+    }
 
     TF_RETURN_IF_ERROR(ctx->step_container()->Create(rm, key, tensor_array));
 
@@ -649,6 +664,23 @@ class TensorArrayPackOrGatherOp : public OpKernel {
       return;
     }
 
+    // A range of elements in contiguous storage is returned without copying.
+    Tensor contiguous;
+    if (IsRange(indices) &&
+        tensor_array->ReadContiguous(indices[0], indices[0] + num_indices,
+                                     &contiguous)) {
+      TensorShape element_shape = contiguous.shape();
+      element_shape.RemoveDim(0);
+      OP_REQUIRES(ctx, element_shape_.IsCompatibleWith(element_shape),
+                  errors::InvalidArgument(
+                      "TensorArray was passed element_shape ",
+                      element_shape_.DebugString(),
+                      " which does not match the Tensor at index 0: ",
+                      element_shape.DebugString()));
+      ctx->set_output(0, contiguous);
+      return;
+    }
+
     // Read all the Tensors into a vector to keep track of their memory.
     Status s = tensor_array->ReadMany<Device, T>(ctx, indices, &values);
     OP_REQUIRES_OK(ctx, s);
@@ -853,6 +885,34 @@ class TensorArrayConcatOp : public OpKernel {
       return;
     }
 
+    // Elements in contiguous storage all have the same shape, so their
+    // concatenation is a reshape of the storage.
+    Tensor contiguous;
+    if (tensor_array->ElemShape().dims() > 0 &&
+        tensor_array->ReadContiguous(0, array_size, &contiguous)) {
+      TensorShape output_shape = contiguous.shape();
+      const int64_t length = output_shape.dim_size(1);
+      output_shape.RemoveDim(0);
+      output_shape.set_dim(0, array_size * length);
+      TensorShape output_shape_except0 = output_shape;
+      output_shape_except0.RemoveDim(0);
+      OP_REQUIRES(
+          ctx, element_shape_except0_.IsCompatibleWith(output_shape_except0),
+          errors::InvalidArgument(
+              "TensorArray was passed element_shape_except0 ",
+              element_shape_except0_.DebugString(),
+              " but index 0 has (excepting dimension 0) shape: ",
+              output_shape_except0.DebugString(), " which does not match."));
+      Tensor output;
+      CHECK(output.CopyFrom(contiguous, output_shape));
+      ctx->set_output(0, output);
+      Tensor* lengths_tensor = nullptr;
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(1, TensorShape({array_size}),
+                                               &lengths_tensor));
+      lengths_tensor->vec<int64_t>().setConstant(length);
+      return;
+    }
+
     // Read all the Tensors into a vector to keep track of their memory.
     std::vector<Tensor> values;
     std::vector<int32> indices(array_size);
@@ -20,8 +20,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/topk_op.h"
 
 #include <algorithm>
+#include <memory>
 #include <numeric>
 #include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/gtl/top_n.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -109,6 +112,135 @@ class TopK : public OpKernel {
 
 namespace functor {
 
+// Rows with at least this many columns per thread are split into chunks of
+// columns that are processed by different threads.
+constexpr int64_t kTopKMinColsPerChunk = 64 * 1024;
+// Number of columns compared at once against the smallest selected value.
+constexpr int32 kTopKFilterBlockSize = 256;
+
+// Orders column indices by decreasing value, then by increasing index.
+template <typename T>
+struct TopKStableGreater {
+  bool operator()(const int32 a, const int32 b) const {
+    if (input_data[b] < input_data[a]) {
+      return true;
+    } else if (input_data[b] > input_data[a]) {
+      return false;
+    } else {
+      return a < b;
+    }
+  }
+
+  const T* input_data;
+};
+
+// Pushes the columns in [begin, end) of `input_data` into `filter`, in
+// increasing order.
+//
+// Once `filter` is full, a column can only be selected if its value is greater
+// than the smallest selected value, which has a smaller index. Each block of
+// columns is first compared against that value in a loop that the compiler can
+// vectorize, and blocks without a candidate are skipped. The selected columns
+// are the same as when pushing every column.
+template <typename T>
+void PushTopKCandidates(const T* input_data, int32 begin, int32 end,
+                        gtl::TopN<int32, TopKStableGreater<T>>* filter) {
+  int32 c = begin;
+  for (; c < end && filter->size() < filter->limit(); ++c) {
+    filter->push(c);
+  }
+  while (c < end) {
+    const int32 block_end = static_cast<int32>(
+        std::min<int64_t>(end, int64_t{c} + kTopKFilterBlockSize));
+    const T threshold = input_data[filter->peek_bottom()];
+    // NaNs are not filtered out, and are handled by the comparator as when
+    // pushing every column.
+    bool has_candidate = false;
+    for (int32 i = c; i < block_end; ++i) {
+      has_candidate |= !(input_data[i] <= threshold);
+    }
+    if (has_candidate) {
+      for (; c < block_end; ++c) {
+        if (!(input_data[c] <= threshold)) filter->push(c);
+      }
+    }
+    c = block_end;
+  }
+}
+
+// Computes the top `k` columns of rows that are too wide to be processed by a
+// single thread each. Every row is split into `num_chunks` chunks of columns,
+// the top `k` columns of each chunk are selected in parallel, and the selected
+// columns of the chunks of each row are merged.
+template <typename T>
+void TopKWideRows(OpKernelContext* context, bool sorted, int k,
+                  const typename TTypes<T, 2>::ConstTensor& input,
+                  const int64_t num_rows, const int64_t num_cols,
+                  const int64_t num_chunks,
+                  typename TTypes<T, 2>::Tensor values,
+                  typename TTypes<int, 2>::Tensor indices) {
+  const int64_t chunk_size = (num_cols + num_chunks - 1) / num_chunks;
+  // The selected columns of chunk `i` of row `r` are stored at offset
+  // `(r * num_chunks + i) * k` of `candidates`.
+  std::vector<int32> candidates(num_rows * num_chunks * k);
+  std::vector<int32> num_candidates(num_rows * num_chunks, 0);
+  auto select_chunk = [&](int64_t task) {
+    const int64_t row = task / num_chunks;
+    const int64_t begin = std::min(num_cols, (task % num_chunks) * chunk_size);
+    const int64_t end = std::min(num_cols, begin + chunk_size);
+    const T* input_data = &input(row, 0);
+    gtl::TopN<int32, TopKStableGreater<T>> filter(
+        k, TopKStableGreater<T>{input_data});
+    PushTopKCandidates<T>(input_data, begin, end, &filter);
+    std::copy(filter.unsorted_begin(), filter.unsorted_end(),
+              &candidates[task * k]);
+    num_candidates[task] = filter.size();
+  };
+  thread::ThreadPool* workers =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  workers->ParallelFor(
+      num_rows * num_chunks,
+      thread::ThreadPool::SchedulingParams(
+          thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+          absl::nullopt, /*block_size=*/1),
+      [&select_chunk](int64_t begin, int64_t end) {
+        for (int64_t task = begin; task < end; ++task) select_chunk(task);
+      });
+
+  auto merge_rows = [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const T* input_data = &input(row, 0);
+      gtl::TopN<int32, TopKStableGreater<T>> filter(
+          k, TopKStableGreater<T>{input_data});
+      for (int64_t task = row * num_chunks; task < (row + 1) * num_chunks;
+           ++task) {
+        for (int32 i = 0; i < num_candidates[task]; ++i) {
+          filter.push(candidates[task * k + i]);
+        }
+      }
+      int32 i = 0;
+      if (sorted) {
+        std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
+        for (const int32 c : *top_k) indices(row, i++) = c;
+      } else {
+        for (auto it = filter.unsorted_begin(); it != filter.unsorted_end();
+             ++it) {
+          indices(row, i++) = *it;
+        }
+      }
+      std::transform(
+          &indices(row, 0), &indices(row, k), &values(row, 0),
+          [input_data](const int32_t loc) { return input_data[loc]; });
+    }
+  };
+  const double cmp_cost = 3 * Eigen::TensorOpCost::AddCost<int32>() +
+                          Eigen::TensorOpCost::AddCost<T>();
+  const double merge_cost =
+      4 * cmp_cost * num_chunks * k *
+      Eigen::numext::log2(static_cast<float>(k + 1));
+  workers->ParallelFor(num_rows, static_cast<int64_t>(merge_cost), merge_rows);
+}
+
 template <typename T>
 struct TopKFunctor<CPUDevice, T> {
   static EIGEN_ALWAYS_INLINE Status Compute(
@@ -141,6 +273,23 @@ struct TopKFunctor<CPUDevice, T> {
       return OkStatus();
     }
 
+    // Split wide rows across threads when there are not enough rows to
+    // keep every thread busy.
+    const auto* cpu_worker_threads =
+        context->device()->tensorflow_cpu_worker_threads();
+    if (k < num_cols) {
+      const int64_t min_chunk_size =
+          std::max<int64_t>(kTopKMinColsPerChunk, 8 * static_cast<int64_t>(k));
+      const int64_t num_chunks =
+          std::min<int64_t>(cpu_worker_threads->num_threads / num_rows,
+                            num_cols / min_chunk_size);
+      if (num_chunks > 1) {
+        TopKWideRows<T>(context, sorted, k, input, num_rows, num_cols,
+                        num_chunks, values, indices);
+        return OkStatus();
+      }
+    }
+
     auto SortIndices = [&](int64_t start_batch, int64_t limit_batch) {
       for (int32_t b = start_batch; b < limit_batch; ++b) {
         const T* input_data = &input(b, 0);
@@ -228,7 +377,7 @@ struct TopKFunctor<CPUDevice, T> {
     const int64_t final_cost = (total_cost >= static_cast<double>(kint64max))
                                    ? kint64max
                                    : static_cast<int64_t>(total_cost);
-    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    auto worker_threads = *cpu_worker_threads;
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           final_cost, SortIndices);
 
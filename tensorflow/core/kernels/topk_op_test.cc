@@ -0,0 +1,153 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+class TopKOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(bool sorted) {
+    TF_ASSERT_OK(NodeDefBuilder("topk", "TopKV2")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("sorted", sorted)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Runs TopKV2 over `rows` and checks the result against a stable sort of
+  // the columns of each row by decreasing value.
+  void RunAndCheck(const std::vector<std::vector<float>>& rows, int k,
+                   bool sorted) {
+    MakeOp(sorted);
+    const int64_t num_rows = rows.size();
+    const int64_t num_cols = rows[0].size();
+    std::vector<float> input;
+    for (const auto& row : rows) {
+      input.insert(input.end(), row.begin(), row.end());
+    }
+    AddInputFromArray<float>(TensorShape({num_rows, num_cols}), input);
+    AddInputFromArray<int32>(TensorShape({}), {k});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const auto values = GetOutput(0)->matrix<float>();
+    const auto indices = GetOutput(1)->matrix<int32>();
+    for (int64_t r = 0; r < num_rows; ++r) {
+      std::vector<int32> expected(num_cols);
+      std::iota(expected.begin(), expected.end(), 0);
+      std::stable_sort(
+          expected.begin(), expected.end(),
+          [&](int32 a, int32 b) { return rows[r][a] > rows[r][b]; });
+      expected.resize(k);
+      std::vector<int32> actual(&indices(r, 0), &indices(r, 0) + k);
+      if (!sorted) {
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+      }
+      EXPECT_EQ(actual, expected) << "row " << r;
+      for (int i = 0; i < k; ++i) {
+        EXPECT_EQ(values(r, i), rows[r][indices(r, i)]);
+      }
+    }
+  }
+};
+
+std::vector<std::vector<float>> RandomRows(int num_rows, int num_cols,
+                                           int num_distinct_values) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> dist(0, num_distinct_values - 1);
+  std::vector<std::vector<float>> rows(num_rows, std::vector<float>(num_cols));
+  for (auto& row : rows) {
+    for (float& value : row) value = dist(rng);
+  }
+  return rows;
+}
+
+// Wide rows are split across threads. Many columns share the same value, so
+// ties must be broken by index across chunks.
+TEST_F(TopKOpTest, WideRowSorted) {
+  RunAndCheck(RandomRows(1, 1 << 20, 1000), /*k=*/100, /*sorted=*/true);
+}
+
+TEST_F(TopKOpTest, WideRowUnsorted) {
+  RunAndCheck(RandomRows(1, 1 << 20, 1000), /*k=*/100, /*sorted=*/false);
+}
+
+TEST_F(TopKOpTest, WideRowsIncreasing) {
+  // Increasing values replace the selected columns throughout each chunk.
+  auto rows = RandomRows(2, 1 << 19, 1);
+  for (auto& row : rows) std::iota(row.begin(), row.end(), 0.0f);
+  RunAndCheck(rows, /*k=*/1000, /*sorted=*/true);
+}
+
+TEST_F(TopKOpTest, NarrowRows) {
+  RunAndCheck(RandomRows(16, 1000, 100), /*k=*/10, /*sorted=*/true);
+}
+
+Graph* TopKGraph(int num_rows, int num_cols, int k) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor input(DT_FLOAT, TensorShape({num_rows, num_cols}));
+  input.flat<float>().setRandom();
+  Tensor k_t(DT_INT32, TensorShape({}));
+  k_t.scalar<int32>()() = k;
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("topk"), "TopKV2")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, k_t))
+                  .Attr("sorted", true)
+                  .Finalize(g, &node));
+  return g;
+}
+
+// Selects the top `k` of a single row of `num_cols` candidates, as when
+// scoring candidates for retrieval.
+void BM_TopKWideRow(::testing::benchmark::State& state) {
+  const int num_cols = state.range(0);
+  const int k = state.range(1);
+  test::Benchmark("cpu", TopKGraph(1, num_cols, k),
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          num_cols);
+}
+
+BENCHMARK(BM_TopKWideRow)
+    ->UseRealTime()
+    ->ArgPair(1 << 20, 100)
+    ->ArgPair(1 << 20, 1000)
+    ->ArgPair(10 << 20, 100)
+    ->ArgPair(10 << 20, 1000)
+    ->ArgPair(100 << 20, 100)
+    ->ArgPair(100 << 20, 1000);
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,10 +27,11 @@ namespace tensorflow {
 
 // Must be called before performing a sparse operation on a variable. Ensures
 // that no concurrent dense operations can happen while holding the variable's
-// lock.
+// lock. Variables in snapshot mode stay in copy-on-write mode, and must be
+// updated under an exclusive lock after `PrepareToUpdateSnapshotVariable()`.
 template <typename Device, typename T>
 Status EnsureSparseVariableAccess(OpKernelContext* ctx, Var* var) {
-  if (var->copy_on_read_mode.load()) {
+  if (var->copy_on_read_mode.load() || var->snapshot_mode()) {
     return OkStatus();
   }
   mutex_lock ml(*var->mu());
@@ -69,22 +70,45 @@ Status EnsureSparseVariableAccess(OpKernelContext* ctx, Var* var) {
 }
 
 // Utility structure that releases a sequence of borrowed mutexes when it is
-// deleted.
+// deleted. If `dirty_indices` is not null, the update only changed these rows
+// of the variables, otherwise it may have changed all of them.
 struct VariableInputLockHolder {
  public:
   VariableInputLockHolder(
       std::vector<Var*> vars, std::unique_ptr<std::vector<mutex_lock>> locks,
-      std::unique_ptr<std::vector<tf_shared_lock>> shared_locks)
+      std::unique_ptr<std::vector<tf_shared_lock>> shared_locks,
+      const Tensor* dirty_indices = nullptr)
       : vars_(std::move(vars)),
         locks_(std::move(locks)),
-        shared_locks_(std::move(shared_locks)) {}
+        shared_locks_(std::move(shared_locks)) {
+    if (dirty_indices != nullptr) {
+      has_dirty_indices_ = true;
+      dirty_indices_ = *dirty_indices;
+    }
+  }
 
   VariableInputLockHolder(VariableInputLockHolder&& other)
       : vars_(std::move(other.vars_)),
         locks_(std::move(other.locks_)),
-        shared_locks_(std::move(other.shared_locks_)) {}
+        shared_locks_(std::move(other.shared_locks_)),
+        has_dirty_indices_(other.has_dirty_indices_),
+        dirty_indices_(std::move(other.dirty_indices_)) {}
 
   ~VariableInputLockHolder() {
+    // Variables are locked exclusively when any of them is in snapshot mode,
+    // to publish their updated values.
+    if (locks_ != nullptr && !locks_->empty()) {
+      for (Var* var : vars_) {
+        var->MaybePublishSnapshot();
+      }
+    }
+    for (Var* var : vars_) {
+      if (has_dirty_indices_) {
+        var->MarkRowsDirty(dirty_indices_);
+      } else {
+        var->MarkAllRowsDirty();
+      }
+    }
     // Release the locks before unreffing the Vars, because each lock
     // is potentially borrowed from a Var in vars_.
     locks_.reset();
@@ -99,6 +123,8 @@ struct VariableInputLockHolder {
   // because a `std::vector<mutex_lock>` is not movable on all platforms.
   std::unique_ptr<std::vector<mutex_lock>> locks_;
   std::unique_ptr<std::vector<tf_shared_lock>> shared_locks_;
+  bool has_dirty_indices_ = false;
+  Tensor dirty_indices_;
 };
 
 // Returns a borrowed pointer to the mutex for the variable `input` in `ctx`.
@@ -133,9 +159,12 @@ mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input, bool sparse,
 // variable gets switched to copy-on-read mode before trying to acquire the
 // locks. If do_lock is false, returns immediately for reference variables. For
 // resource variables in copy-on-read-mode it will grab a shared lock if do_lock
-// is false, exclusive lock otherwise.  Note that this silently doesn't lock
-// mutexes for invalid variable references; in all usages this is followed by
-// GetInputTensor which will signal a failure.
+// is false, exclusive lock otherwise. Variables in snapshot mode always require
+// an exclusive lock.  Note that this silently doesn't lock mutexes for invalid
+// variable references; in all usages this is followed by GetInputTensor which
+// will signal a failure. Variables that track dirty rows record the "indices"
+// input of sparse updates as dirty when the structure is deleted, and all
+// their rows for dense updates.
 template <typename Device, typename T>
 VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
     OpKernelContext* ctx, bool do_lock, bool sparse,
@@ -152,29 +181,36 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
   }
   std::vector<Var*> vars;
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
+  bool exclusive = !sparse || do_lock;
+  bool track_dirty_rows = false;
   for (auto input : input_ids) {
     Var* var;
     mutex* mutex =
         GetTrainingVariableMutex<Device, T>(ctx, input, sparse, &var);
-    if (var) vars.push_back(var);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
-      mutexes.push_back(mutex);
+    if (var) {
+      vars.push_back(var);
+      exclusive |= var->snapshot_mode();
+      track_dirty_rows |= var->tracks_dirty_rows();
     }
+    mutexes.push_back(mutex);
   }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
+  const Tensor* dirty_indices = nullptr;
+  if (sparse && track_dirty_rows) {
+    // All the rows are marked dirty if the input is missing.
+    if (!ctx->input("indices", &dirty_indices).ok()) dirty_indices = nullptr;
+  }
+  // Only lock each mutex once if duplicates exist. Sorting also keeps the
+  // n log n cost low for the multi-tensor ops, which lock many variables.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
 
   auto locks = std::make_unique<std::vector<mutex_lock>>();
   auto shared_locks = std::make_unique<std::vector<tf_shared_lock>>();
-  locks->reserve(acquire_order.size());
+  locks->reserve(mutexes.size());
 
-  for (auto acquire : acquire_order) {
-    mutex* mu = mutexes[acquire];
+  for (mutex* mu : mutexes) {
     if (mu != nullptr) {
-      if (!sparse || do_lock) {
+      if (exclusive) {
         locks->emplace_back(*mu);
       } else {
         shared_locks->emplace_back(*mu);
@@ -182,7 +218,7 @@ VariableInputLockHolder MaybeLockVariableInputMutexesInOrder(
     }
   }
   return VariableInputLockHolder(std::move(vars), std::move(locks),
-                                 std::move(shared_locks));
+                                 std::move(shared_locks), dirty_indices);
 }
 
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
@@ -224,6 +260,18 @@ Status PrepareToUpdateVariable(OpKernelContext* ctx, Tensor* tensor,
   return OkStatus();
 }
 
+// Ensures that the tensor of `var` does not alias a published snapshot or a
+// read before a sparse update, if `var` is in snapshot mode.
+// REQUIRES: *var->mu() is held exclusively.
+template <typename Device, typename T>
+Status PrepareToUpdateSnapshotVariable(OpKernelContext* ctx, Var* var) {
+  if (!var->snapshot_mode() || var->copy_on_read_mode.load()) {
+    return OkStatus();
+  }
+  return PrepareToUpdateVariable<Device, T>(ctx, var->tensor(),
+                                            /*copy_on_read_mode=*/false);
+}
+
 // This gives you `*out`, a tensor you can update, corresponding to a variable
 // passed as input index `input`.  This handles the differences between
 // reference and resource variables. For reference variables we can just grab
@@ -240,6 +288,8 @@ Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
     TF_RETURN_IF_ERROR(LookupResource(ctx, HandleFromInput(ctx, input), &var));
     if (sparse) {
       TF_RETURN_IF_ERROR(EnsureSparseVariableAccess<Device, T>(ctx, var.get()));
+      TF_RETURN_IF_ERROR(
+          PrepareToUpdateSnapshotVariable<Device, T>(ctx, var.get()));
       *out = *var->tensor();
       return OkStatus();
     }
@@ -4689,4 +4689,375 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Multi-tensor variants of the dense resource apply ops. The remapper groups
+// independent ResourceApply* nodes that share their hyperparameters into one
+// _FusedResourceApply* node, which locks all the variables once, and on CPU
+// updates them in a single parallel loop over their concatenated elements
+// instead of one Eigen expression (and one scheduling round) per variable.
+namespace {
+
+// Reads the `n` variables in inputs [start, start + n) into `tensors`.
+template <typename Device, typename T>
+Status GetVariableListInput(OpKernelContext* ctx, int start, int n,
+                            bool lock_held, std::vector<Tensor>* tensors) {
+  tensors->resize(n);
+  for (int i = 0; i < n; ++i) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<Device, T>(
+        ctx, start + i, lock_held, /*sparse=*/false, &(*tensors)[i]));
+    if (!(*tensors)[i].IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ",
+          ctx->op_kernel().requested_input(start + i));
+    }
+  }
+  return OkStatus();
+}
+
+Status CheckSameShape(const Tensor& var, const Tensor& other,
+                      const char* other_name) {
+  if (!var.shape().IsSameSize(other.shape())) {
+    return errors::InvalidArgument("var and ", other_name,
+                                   " do not have the same shape",
+                                   var.shape().DebugString(), " ",
+                                   other.shape().DebugString());
+  }
+  return OkStatus();
+}
+
+Status CheckScalar(const Tensor& t, const char* name) {
+  if (!TensorShapeUtils::IsScalar(t.shape())) {
+    return errors::InvalidArgument(name, " is not a scalar: ",
+                                   t.shape().DebugString());
+  }
+  return OkStatus();
+}
+
+std::vector<int> ResourceListInputIds(int num_lists, int n) {
+  std::vector<int> ids(num_lists * n);
+  for (int i = 0; i < ids.size(); ++i) ids[i] = i;
+  return ids;
+}
+
+// Calls `fn(i, begin, end)` for slices [begin, end) of the flattened
+// variables `vars[i]`, in parallel over the concatenation of all variables,
+// so that many small variables are updated in few large shards.
+template <typename Fn>
+void ParallelForVariables(const CPUDevice& d, const std::vector<Tensor>& vars,
+                          const Eigen::TensorOpCost& cost_per_element,
+                          Fn fn) {
+  std::vector<Index> offsets(vars.size() + 1, 0);
+  for (int i = 0; i < vars.size(); ++i) {
+    offsets[i + 1] = offsets[i] + vars[i].NumElements();
+  }
+  d.parallelFor(offsets.back(), cost_per_element,
+                [&offsets, &fn](Index begin, Index end) {
+                  int i = std::upper_bound(offsets.begin(), offsets.end(),
+                                           begin) -
+                          offsets.begin() - 1;
+                  while (begin < end) {
+                    const Index slice_end = std::min(end, offsets[i + 1]);
+                    if (slice_end > begin) {
+                      fn(i, begin - offsets[i], slice_end - offsets[i]);
+                    }
+                    begin = slice_end;
+                    ++i;
+                  }
+                });
+}
+
+}  // namespace
+
+namespace functor {
+
+// The generic implementations run the single-variable functors in turn.
+template <typename Device, typename T>
+struct MultiApplyGradientDescent {
+  void operator()(const Device& d, std::vector<Tensor>* var, const Tensor& lr,
+                  const std::vector<Tensor>& grad) {
+    for (int i = 0; i < var->size(); ++i) {
+      ApplyGradientDescent<Device, T>()(d, (*var)[i].flat<T>(), lr.scalar<T>(),
+                                        grad[i].flat<T>());
+    }
+  }
+};
+
+template <typename T>
+struct MultiApplyGradientDescent<CPUDevice, T> {
+  void operator()(const CPUDevice& d, std::vector<Tensor>* var,
+                  const Tensor& lr, const std::vector<Tensor>& grad) {
+    const T alpha = lr.scalar<T>()();
+    const Eigen::TensorOpCost cost(2 * sizeof(T), sizeof(T),
+                                   Eigen::TensorOpCost::AddCost<T>() +
+                                       Eigen::TensorOpCost::MulCost<T>());
+    ParallelForVariables(d, *var, cost, [&](int i, Index begin, Index end) {
+      typename TTypes<T>::UnalignedTensor v((*var)[i].flat<T>().data() + begin,
+                                            end - begin);
+      typename TTypes<T>::UnalignedConstTensor g(
+          grad[i].flat<T>().data() + begin, end - begin);
+      v -= g * alpha;
+    });
+  }
+};
+
+template <typename Device, typename T>
+struct MultiApplyAdagrad {
+  void operator()(const Device& d, std::vector<Tensor>* var,
+                  std::vector<Tensor>* accum, const Tensor& lr,
+                  const std::vector<Tensor>& grad, bool update_slots) {
+    for (int i = 0; i < var->size(); ++i) {
+      ApplyAdagrad<Device, T>()(d, (*var)[i].flat<T>(), (*accum)[i].flat<T>(),
+                                lr.scalar<T>(), grad[i].flat<T>(),
+                                update_slots);
+    }
+  }
+};
+
+template <typename T>
+struct MultiApplyAdagrad<CPUDevice, T> {
+  void operator()(const CPUDevice& d, std::vector<Tensor>* var,
+                  std::vector<Tensor>* accum, const Tensor& lr,
+                  const std::vector<Tensor>& grad, bool update_slots) {
+    const T alpha = lr.scalar<T>()();
+    const Eigen::TensorOpCost cost(
+        3 * sizeof(T), 2 * sizeof(T),
+        Eigen::TensorOpCost::AddCost<T>() * 2 +
+            Eigen::TensorOpCost::MulCost<T>() * 3 +
+            Eigen::TensorOpCost::DivCost<T>());
+    ParallelForVariables(d, *var, cost, [&](int i, Index begin, Index end) {
+      typename TTypes<T>::UnalignedTensor v((*var)[i].flat<T>().data() + begin,
+                                            end - begin);
+      typename TTypes<T>::UnalignedTensor a(
+          (*accum)[i].flat<T>().data() + begin, end - begin);
+      typename TTypes<T>::UnalignedConstTensor g(
+          grad[i].flat<T>().data() + begin, end - begin);
+      if (update_slots) {
+        a += g.square();
+      }
+      v -= g * alpha * a.rsqrt();
+    });
+  }
+};
+
+template <typename Device, typename T>
+struct MultiApplyAdam {
+  void operator()(const Device& d, std::vector<Tensor>* var,
+                  std::vector<Tensor>* m, std::vector<Tensor>* v,
+                  const Tensor& beta1_power, const Tensor& beta2_power,
+                  const Tensor& lr, const Tensor& beta1, const Tensor& beta2,
+                  const Tensor& epsilon, const std::vector<Tensor>& grad,
+                  bool use_nesterov) {
+    for (int i = 0; i < var->size(); ++i) {
+      ApplyAdam<Device, T>()(d, (*var)[i].flat<T>(), (*m)[i].flat<T>(),
+                             (*v)[i].flat<T>(), beta1_power.scalar<T>(),
+                             beta2_power.scalar<T>(), lr.scalar<T>(),
+                             beta1.scalar<T>(), beta2.scalar<T>(),
+                             epsilon.scalar<T>(), grad[i].flat<T>(),
+                             use_nesterov);
+    }
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<CPUDevice, T> {
+  void operator()(const CPUDevice& d, std::vector<Tensor>* var,
+                  std::vector<Tensor>* m, std::vector<Tensor>* v,
+                  const Tensor& beta1_power, const Tensor& beta2_power,
+                  const Tensor& lr, const Tensor& beta1, const Tensor& beta2,
+                  const Tensor& epsilon, const std::vector<Tensor>& grad,
+                  bool use_nesterov) {
+    // Same update as ApplyAdamNonCuda.
+    const T b1 = beta1.scalar<T>()();
+    const T b2 = beta2.scalar<T>()();
+    const T eps = epsilon.scalar<T>()();
+    const T alpha =
+        lr.scalar<T>()() *
+        Eigen::numext::sqrt(T(1) - beta2_power.scalar<T>()()) /
+        (T(1) - beta1_power.scalar<T>()());
+    const Eigen::TensorOpCost cost(4 * sizeof(T), 3 * sizeof(T),
+                                   Eigen::TensorOpCost::AddCost<T>() * 10 +
+                                       Eigen::TensorOpCost::MulCost<T>() * 6 +
+                                       Eigen::TensorOpCost::DivCost<T>());
+    ParallelForVariables(d, *var, cost, [&](int i, Index begin, Index end) {
+      const Index size = end - begin;
+      typename TTypes<T>::UnalignedTensor var_i(
+          (*var)[i].flat<T>().data() + begin, size);
+      typename TTypes<T>::UnalignedTensor m_i((*m)[i].flat<T>().data() + begin,
+                                              size);
+      typename TTypes<T>::UnalignedTensor v_i((*v)[i].flat<T>().data() + begin,
+                                              size);
+      typename TTypes<T>::UnalignedConstTensor g(
+          grad[i].flat<T>().data() + begin, size);
+      m_i += (g - m_i) * (T(1) - b1);
+      v_i += (g.square() - v_i) * (T(1) - b2);
+      if (use_nesterov) {
+        var_i -= ((g * (T(1) - b1) + b1 * m_i) * alpha) / (v_i.sqrt() + eps);
+      } else {
+        var_i -= (m_i * alpha) / (v_i.sqrt() + eps);
+      }
+    });
+  }
+};
+
+}  // namespace functor
+
+template <typename Device, typename T>
+class FusedApplyGradientDescentOp : public OpKernel {
+ public:
+  explicit FusedApplyGradientDescentOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, /*sparse=*/false,
+        ResourceListInputIds(1, n_));
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, 0, n_, use_exclusive_lock_, &var));
+    const Tensor& alpha = ctx->input(n_);
+    OP_REQUIRES_OK(ctx, CheckScalar(alpha, "alpha"));
+    std::vector<Tensor> delta(n_);
+    for (int i = 0; i < n_; ++i) {
+      delta[i] = ctx->input(n_ + 1 + i);
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], delta[i], "delta"));
+    }
+
+    functor::MultiApplyGradientDescent<Device, T>()(
+        ctx->template eigen_device<Device>(), &var, alpha, delta);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  int n_;
+};
+
+template <typename Device, typename T>
+class FusedApplyAdagradOp : public OpKernel {
+ public:
+  explicit FusedApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, /*sparse=*/false,
+        ResourceListInputIds(2, n_));
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, 0, n_, use_exclusive_lock_, &var));
+    std::vector<Tensor> accum;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, n_, n_, use_exclusive_lock_, &accum));
+    const Tensor& lr = ctx->input(2 * n_);
+    OP_REQUIRES_OK(ctx, CheckScalar(lr, "lr"));
+    std::vector<Tensor> grad(n_);
+    for (int i = 0; i < n_; ++i) {
+      grad[i] = ctx->input(2 * n_ + 1 + i);
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], accum[i], "accum"));
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], grad[i], "grad"));
+    }
+
+    functor::MultiApplyAdagrad<Device, T>()(
+        ctx->template eigen_device<Device>(), &var, &accum, lr, grad,
+        update_slots_);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool update_slots_;
+  int n_;
+};
+
+template <typename Device, typename T>
+class FusedApplyAdamOp : public OpKernel {
+ public:
+  explicit FusedApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, /*sparse=*/false,
+        ResourceListInputIds(3, n_));
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, 0, n_, use_exclusive_lock_, &var));
+    std::vector<Tensor> m;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, n_, n_, use_exclusive_lock_, &m));
+    std::vector<Tensor> v;
+    OP_REQUIRES_OK(ctx, GetVariableListInput<Device, T>(
+                            ctx, 2 * n_, n_, use_exclusive_lock_, &v));
+
+    const int scalars = 3 * n_;
+    const Tensor& beta1_power = ctx->input(scalars);
+    const Tensor& beta2_power = ctx->input(scalars + 1);
+    const Tensor& lr = ctx->input(scalars + 2);
+    const Tensor& beta1 = ctx->input(scalars + 3);
+    const Tensor& beta2 = ctx->input(scalars + 4);
+    const Tensor& epsilon = ctx->input(scalars + 5);
+    OP_REQUIRES_OK(ctx, CheckScalar(beta1_power, "beta1_power"));
+    OP_REQUIRES_OK(ctx, CheckScalar(beta2_power, "beta2_power"));
+    OP_REQUIRES_OK(ctx, CheckScalar(lr, "lr"));
+    OP_REQUIRES_OK(ctx, CheckScalar(beta1, "beta1"));
+    OP_REQUIRES_OK(ctx, CheckScalar(beta2, "beta2"));
+    OP_REQUIRES_OK(ctx, CheckScalar(epsilon, "epsilon"));
+
+    std::vector<Tensor> grad(n_);
+    for (int i = 0; i < n_; ++i) {
+      grad[i] = ctx->input(scalars + 6 + i);
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], m[i], "m"));
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], v[i], "v"));
+      OP_REQUIRES_OK(ctx, CheckSameShape(var[i], grad[i], "grad"));
+    }
+
+    functor::MultiApplyAdam<Device, T>()(
+        ctx->template eigen_device<Device>(), &var, &m, &v, beta1_power,
+        beta2_power, lr, beta1, beta2, epsilon, grad, use_nesterov_);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+  int n_;
+};
+
+#define REGISTER_KERNELS(D, T)                                        \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResourceApplyGradientDescent")  \
+                              .Device(DEVICE_##D)                     \
+                              .HostMemory("var")                      \
+                              .TypeConstraint<T>("T"),                \
+                          FusedApplyGradientDescentOp<D##Device, T>); \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResourceApplyAdagrad")          \
+                              .Device(DEVICE_##D)                     \
+                              .HostMemory("var")                      \
+                              .HostMemory("accum")                    \
+                              .TypeConstraint<T>("T"),                \
+                          FusedApplyAdagradOp<D##Device, T>);         \
+  REGISTER_KERNEL_BUILDER(Name("_FusedResourceApplyAdam")             \
+                              .Device(DEVICE_##D)                     \
+                              .HostMemory("var")                      \
+                              .HostMemory("m")                        \
+                              .HostMemory("v")                        \
+                              .TypeConstraint<T>("T"),                \
+                          FusedApplyAdamOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_FLOAT_TYPES(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+// The GPU functor specializations are declared above.
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 }  // namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <complex>
+#include <functional>
+#include <memory>
+#include <type_traits>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/attr_value.pb.h"
@@ -25,6 +28,11 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
+#include "tensorflow/core/platform/mutex.h"
+
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/compiler/xla/pjrt/transpose.h"
+#endif  // !defined(IS_MOBILE_PLATFORM)
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
@@ -68,12 +76,57 @@ void TransposeSimple(const CPUDevice& device, const Tensor& in,
   device.parallelFor(in.NumElements(), cost, std::move(transpose_fn));
 }
 
+#if !defined(IS_MOBILE_PLATFORM)
+// Smaller tensors are transposed with Eigen, since the cost of looking up a
+// transpose plan would not be amortized.
+constexpr int64_t kMinElementsForTransposePlan = 64 * 1024;
+
+// Transposes `in` into `out` with an `xla::TransposePlan`, which tiles over
+// the dimensions that move with cache-blocked and vectorized kernels, and runs
+// independent tiles on the threads of `device`. Plans are cached by shape and
+// permutation. Returns false if no plan can be made, for example for an
+// unsupported element size.
+bool TransposeUsingPlan(const CPUDevice& device, const Tensor& in,
+                        const gtl::ArraySlice<int32> perm, size_t element_size,
+                        Tensor* out) {
+  static mutex mu(LINKER_INITIALIZED);
+  static xla::TransposePlanCache* plan_cache =
+      new xla::TransposePlanCache(/*capacity=*/64);
+  gtl::InlinedVector<int64_t, 8> dims(in.shape().dim_sizes().begin(),
+                                      in.shape().dim_sizes().end());
+  gtl::InlinedVector<int64_t, 8> permutation(perm.begin(), perm.end());
+  xla::StatusOr<std::shared_ptr<xla::TransposePlan>> plan;
+  {
+    mutex_lock l(mu);
+    plan = plan_cache->GetOrCreate(
+        element_size, dims, permutation,
+        /*input_layout=*/xla::TransposePlan::Tiling{},
+        /*output_tiling=*/xla::TransposePlan::Tiling{},
+        xla::TransposePlan::Transformation::kNone, device.numThreads());
+  }
+  if (!plan.ok()) return false;
+  (*plan)->Execute(
+      in.tensor_data().data(), const_cast<char*>(out->tensor_data().data()),
+      [&device](std::function<void()> fn) {
+        device.getPool()->Schedule(std::move(fn));
+      });
+  return true;
+}
+#endif  // !defined(IS_MOBILE_PLATFORM)
+
 }  // namespace
 
 template <typename T, bool conjugate>
 struct Transpose<CPUDevice, T, conjugate> {
   static void run(const CPUDevice& d, const Tensor& in,
                   const gtl::ArraySlice<int32> perm, Tensor* out) {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (!conjugate && std::is_trivially_copyable<T>::value && in.dims() >= 2 &&
+        in.NumElements() >= kMinElementsForTransposePlan &&
+        TransposeUsingPlan(d, in, perm, sizeof(T), out)) {
+      return;
+    }
+#endif  // !defined(IS_MOBILE_PLATFORM)
     switch (in.dims()) {
       case 2:
         internal::TransposeUsingEigen<CPUDevice, T, 2>(d, in, perm, conjugate,
@@ -13,9 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#define EIGEN_USE_THREADS
+
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -130,4 +136,45 @@ TEST_F(TransposeUtilTest, NonSingletonDimensionAlignment) {
                                                      {0, 1, 2, 5, 4, 3}));
 }
 
+template <typename T>
+void TestLargeTranspose(const TensorShape& shape,
+                        const std::vector<int32>& perm) {
+  Eigen::ThreadPool pool(4);
+  Eigen::ThreadPoolDevice device(&pool, 4);
+  Tensor in(DataTypeToEnum<T>::value, shape);
+  in.flat<T>().setRandom();
+  TensorShape out_shape;
+  for (int32 d : perm) out_shape.AddDim(shape.dim_size(d));
+  Tensor out(DataTypeToEnum<T>::value, out_shape);
+  TF_ASSERT_OK(DoTranspose(device, in, perm, &out));
+
+  Tensor expected(DataTypeToEnum<T>::value, out_shape);
+  auto in_flat = in.flat<T>();
+  auto expected_flat = expected.flat<T>();
+  for (int64_t i = 0; i < in.NumElements(); ++i) {
+    // Map the index of each input element to its index in the output.
+    int64_t index = i;
+    std::vector<int64_t> coords(shape.dims());
+    for (int d = shape.dims() - 1; d >= 0; --d) {
+      coords[d] = index % shape.dim_size(d);
+      index /= shape.dim_size(d);
+    }
+    int64_t out_index = 0;
+    for (int d = 0; d < perm.size(); ++d) {
+      out_index = out_index * out_shape.dim_size(d) + coords[perm[d]];
+    }
+    expected_flat(out_index) = in_flat(i);
+  }
+  test::ExpectTensorEqual<T>(out, expected);
+}
+
+TEST_F(TransposeUtilTest, LargeTranspose) {
+  // [B, S, H, D] -> [B, H, S, D], as in attention layers.
+  TestLargeTranspose<float>({2, 128, 8, 64}, {0, 2, 1, 3});
+  TestLargeTranspose<Eigen::half>({2, 128, 8, 64}, {0, 2, 1, 3});
+  TestLargeTranspose<int8>({7, 33, 5, 61}, {3, 1, 0, 2});
+  TestLargeTranspose<double>({3, 5, 7, 11, 13}, {4, 2, 0, 3, 1});
+  TestLargeTranspose<complex128>({301, 257}, {1, 0});
+}
+
 }  // namespace tensorflow
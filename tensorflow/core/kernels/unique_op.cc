@@ -13,9 +13,12 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
 #include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/framework/bounds_check.h"
@@ -26,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/bfloat16.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace {
@@ -68,6 +72,42 @@ struct UniqueOpHashMap<bfloat16, TIndex> {
   using map_type = std::unordered_map<bfloat16, TIndex>;
 };
 
+// Inputs are split into at most this many partitions, so that partition
+// numbers fit in a `uint8`.
+constexpr int kUniqueMaxPartitions = 256;
+// Below this number of elements per thread, the single-threaded
+// implementation is faster.
+constexpr int64_t kUniqueMinElementsPerPartition = 32 * 1024;
+
+// Returns the number of partitions to use for the multi-threaded
+// implementation of unique over `num_elements` elements of type `T`, or 1 to
+// use the single-threaded implementation.
+template <typename T>
+int NumUniquePartitions(int64_t num_elements, int num_threads) {
+  // NOTE: The hashes of `Eigen::half` and `bfloat16` distinguish `0` and
+  // `-0`, which compare equal, so their unique elements would depend on the
+  // partitioning. `bool` has at most two unique elements.
+  if (std::is_same<T, Eigen::half>::value || std::is_same<T, bfloat16>::value ||
+      std::is_same<T, bool>::value) {
+    return 1;
+  }
+  return static_cast<int>(
+      std::min<int64_t>({num_threads, kUniqueMaxPartitions,
+                         num_elements / kUniqueMinElementsPerPartition}));
+}
+
+// Returns the partition of `value`, in [0, num_partitions).
+template <typename T>
+inline uint8 UniquePartition(const T& value, int num_partitions) {
+  // Mix the hash, since the hash of integers is the identity, and scale the
+  // high bits to the number of partitions.
+  uint64 h = static_cast<uint64>(hash<T>{}(value));
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return static_cast<uint8>(((h >> 32) * num_partitions) >> 32);
+}
+
 // `UniqueOp` computes the unique elements in the input tensor.
 //
 // * `T` is the element type.
@@ -150,6 +190,16 @@ class UniqueOp : public OpKernel {
       auto Tin = input.flat<T>();
       const int64_t N = static_cast<int64_t>(Tin.size());
 
+      const DeviceBase::CpuWorkerThreads* worker_threads =
+          context->device()->tensorflow_cpu_worker_threads();
+      const int num_partitions =
+          NumUniquePartitions<T>(N, worker_threads->num_threads);
+      if (num_partitions > 1) {
+        ComputeVectorInParallel(context, input, axis, num_partitions,
+                                worker_threads->workers, idx);
+        return;
+      }
+
       typename UniqueOpHashMap<T, TIndex>::map_type uniq;
       uniq.reserve(2 * N);
       for (Eigen::Index i = 0, j = 0; i < N; ++i) {
@@ -237,6 +287,152 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Multi-threaded implementation over the elements of a vector, which
+  // produces the same outputs as the single-threaded implementation.
+  //
+  // The elements are partitioned by hash, and the partitions are deduplicated
+  // independently by different threads, each numbering the unique elements of
+  // its partition in order of first occurrence. The unique elements of all
+  // partitions are then numbered in order of first occurrence in the input,
+  // in parallel over chunks of the input, and the indices of the elements are
+  // remapped from partition-local to global numbers.
+  void ComputeVectorInParallel(OpKernelContext* context, const Tensor& input,
+                               int64_t axis, int num_partitions,
+                               thread::ThreadPool* workers, Tensor* idx) {
+    auto Tin = input.flat<T>();
+    auto idx_vec = idx->template vec<TIndex>();
+    const int64_t N = Tin.size();
+    const bool with_counts = num_outputs() > 2;
+
+    // Runs `fn(task)` for each task in [0, num_tasks) on a separate thread.
+    auto parallel_for = [workers](int64_t num_tasks,
+                                  const std::function<void(int64_t)>& fn) {
+      workers->ParallelFor(
+          num_tasks,
+          thread::ThreadPool::SchedulingParams(
+              thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+              absl::nullopt, /*block_size=*/1),
+          [&fn](int64_t begin, int64_t end) {
+            for (int64_t task = begin; task < end; ++task) fn(task);
+          });
+    };
+    // The input is split into one chunk per partition for the phases that
+    // are parallel over the input.
+    const int64_t num_chunks = num_partitions;
+    const int64_t chunk_size = (N + num_chunks - 1) / num_chunks;
+    auto chunk_begin = [N, chunk_size](int64_t chunk) {
+      return std::min(N, chunk * chunk_size);
+    };
+
+    // Partition the indices of the elements with a counting sort, so that
+    // the indices of each partition are contiguous and increasing.
+    std::vector<uint8> partitions(N);
+    std::vector<int64_t> offsets(num_chunks * num_partitions, 0);
+    parallel_for(num_chunks, [&](int64_t chunk) {
+      int64_t* chunk_counts = &offsets[chunk * num_partitions];
+      for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+        partitions[i] = UniquePartition(Tin(i), num_partitions);
+        ++chunk_counts[partitions[i]];
+      }
+    });
+    std::vector<int64_t> partition_begin(num_partitions + 1, 0);
+    int64_t offset = 0;
+    for (int p = 0; p < num_partitions; ++p) {
+      partition_begin[p] = offset;
+      for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const int64_t count = offsets[chunk * num_partitions + p];
+        offsets[chunk * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+    partition_begin[num_partitions] = offset;
+    // The input has at most `int32` max elements.
+    std::vector<int32> order(N);
+    parallel_for(num_chunks, [&](int64_t chunk) {
+      int64_t* chunk_offsets = &offsets[chunk * num_partitions];
+      for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+        order[chunk_offsets[partitions[i]]++] = i;
+      }
+    });
+
+    // Deduplicate each partition. `idx_vec` temporarily holds the number of
+    // each element within its partition.
+    std::vector<uint8> is_first_occurrence(N, 0);
+    std::vector<std::vector<TIndex>> partition_counts(num_partitions);
+    std::vector<int64_t> partition_sizes(num_partitions);
+    parallel_for(num_partitions, [&](int64_t p) {
+      typename UniqueOpHashMap<T, TIndex>::map_type uniq;
+      const int64_t begin = partition_begin[p];
+      const int64_t end = partition_begin[p + 1];
+      uniq.reserve(2 * (end - begin));
+      std::vector<TIndex>& counts = partition_counts[p];
+      for (int64_t k = begin; k < end; ++k) {
+        const int32 i = order[k];
+        auto it = uniq.emplace(Tin(i), uniq.size());
+        idx_vec(i) = it.first->second;
+        if (it.second) {
+          is_first_occurrence[i] = 1;
+          if (with_counts) counts.push_back(0);
+        }
+        if (with_counts) ++counts[idx_vec(i)];
+      }
+      partition_sizes[p] = uniq.size();
+    });
+
+    int64_t uniq_size = 0;
+    for (int p = 0; p < num_partitions; ++p) uniq_size += partition_sizes[p];
+    TensorShape output_shape(input.shape());
+    output_shape.set_dim(axis, uniq_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    auto Tout = output->flat<T>();
+    Tensor* count_output = nullptr;
+    if (with_counts) {
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &count_output));
+    }
+
+    // Number the first occurrences of the unique elements in order, starting
+    // from the number of first occurrences in the previous chunks.
+    std::vector<int64_t> chunk_first_number(num_chunks, 0);
+    parallel_for(num_chunks, [&](int64_t chunk) {
+      for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+        chunk_first_number[chunk] += is_first_occurrence[i];
+      }
+    });
+    int64_t number = 0;
+    for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+      const int64_t count = chunk_first_number[chunk];
+      chunk_first_number[chunk] = number;
+      number += count;
+    }
+    std::vector<std::vector<TIndex>> global_numbers(num_partitions);
+    for (int p = 0; p < num_partitions; ++p) {
+      global_numbers[p].resize(partition_sizes[p]);
+    }
+    parallel_for(num_chunks, [&](int64_t chunk) {
+      int64_t next = chunk_first_number[chunk];
+      for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+        if (!is_first_occurrence[i]) continue;
+        const int p = partitions[i];
+        global_numbers[p][idx_vec(i)] = next;
+        Tout(next) = Tin(i);
+        if (with_counts) {
+          count_output->vec<TIndex>()(next) = partition_counts[p][idx_vec(i)];
+        }
+        ++next;
+      }
+    });
+
+    parallel_for(num_chunks, [&](int64_t chunk) {
+      for (int64_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); ++i) {
+        idx_vec(i) = global_numbers[partitions[i]][idx_vec(i)];
+      }
+    });
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                      \
@@ -14,11 +14,16 @@ limitations under the License.
 ==============================================================================*/
 
 #include <functional>
+#include <map>
 #include <memory>
+#include <vector>
 
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
@@ -28,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -64,6 +70,85 @@ TensorProto GetRandomInt32TensorProtoWithRepeat(int dim, int repeat,
   return tensor_proto;
 }
 
+class UniqueOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(const string& op, DataType dtype) {
+    TF_ASSERT_OK(NodeDefBuilder("unique", op)
+                     .Input(FakeInput(dtype))
+                     .Attr("T", dtype)
+                     .Attr("out_idx", DT_INT32)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  // Checks the outputs against a reference implementation, where unique
+  // elements are numbered in order of first occurrence.
+  template <typename T>
+  void CheckOutputs(const std::vector<T>& values, bool with_counts) {
+    std::vector<T> expected_y;
+    std::vector<int32> expected_idx;
+    std::vector<int32> expected_count;
+    std::map<T, int32> numbers;
+    for (const T& value : values) {
+      auto it = numbers.emplace(value, expected_y.size());
+      if (it.second) {
+        expected_y.push_back(value);
+        expected_count.push_back(0);
+      }
+      expected_idx.push_back(it.first->second);
+      ++expected_count[it.first->second];
+    }
+
+    const int64_t num_unique = expected_y.size();
+    const int64_t num_values = values.size();
+    test::ExpectTensorEqual<T>(
+        *GetOutput(0), test::AsTensor<T>(expected_y, {num_unique}));
+    test::ExpectTensorEqual<int32>(
+        *GetOutput(1), test::AsTensor<int32>(expected_idx, {num_values}));
+    if (with_counts) {
+      test::ExpectTensorEqual<int32>(
+          *GetOutput(2), test::AsTensor<int32>(expected_count, {num_unique}));
+    }
+  }
+};
+
+// Large enough inputs are deduplicated on multiple threads, which must
+// preserve the order of first occurrence.
+TEST_F(UniqueOpTest, LargeInt64) {
+  MakeOp("Unique", DT_INT64);
+  std::vector<int64_t> values(1 << 20);
+  for (int64_t& value : values) value = std::rand() % (64 * 1024);
+  AddInputFromArray<int64_t>(TensorShape({static_cast<int64_t>(values.size())}),
+                             values);
+  TF_ASSERT_OK(RunOpKernel());
+  CheckOutputs(values, /*with_counts=*/false);
+}
+
+TEST_F(UniqueOpTest, LargeInt64WithCounts) {
+  MakeOp("UniqueWithCounts", DT_INT64);
+  std::vector<int64_t> values(1 << 20);
+  // Mostly unique elements, with some heavy hitters.
+  for (int64_t i = 0; i < values.size(); ++i) {
+    values[i] = (i % 7 == 0) ? i % 3 : std::rand();
+  }
+  AddInputFromArray<int64_t>(TensorShape({static_cast<int64_t>(values.size())}),
+                             values);
+  TF_ASSERT_OK(RunOpKernel());
+  CheckOutputs(values, /*with_counts=*/true);
+}
+
+TEST_F(UniqueOpTest, LargeStringWithCounts) {
+  MakeOp("UniqueWithCounts", DT_STRING);
+  std::vector<tstring> values(512 * 1024);
+  for (tstring& value : values) {
+    value = strings::StrCat("feature_", std::rand() % (16 * 1024));
+  }
+  AddInputFromArray<tstring>(TensorShape({static_cast<int64_t>(values.size())}),
+                             values);
+  TF_ASSERT_OK(RunOpKernel());
+  CheckOutputs(values, /*with_counts=*/true);
+}
+
 void BM_Unique_INT32(::testing::benchmark::State& state) {
   const int dim = state.range(0);
   const int max_int = state.range(1);
@@ -0,0 +1,204 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/vnni_support.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && \
+    !defined(TENSORFLOW_DISABLE_VNNI)
+#define TENSORFLOW_USE_VNNI (1)
+#include <immintrin.h>
+#define TF_VNNI_TARGET __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#endif
+
+namespace tensorflow {
+namespace vnni {
+
+namespace {
+
+std::atomic<bool> g_enabled{true};
+
+#ifdef TENSORFLOW_USE_VNNI
+
+// The products are computed in tiles of kTileRows x kTileCols outputs. The
+// inputs are packed so that every tile reads groups of 4 consecutive values of
+// k, the number of bytes multiplied by the VNNI instructions in each lane.
+constexpr int kTileRows = 4;
+constexpr int kBlockCols = 16;
+constexpr int kBlocksPerTile = 4;
+constexpr int kTileCols = kBlockCols * kBlocksPerTile;
+
+int64_t RoundUp(int64_t x, int64_t multiple) {
+  return (x + multiple - 1) / multiple * multiple;
+}
+
+// Returns whether the CPU and OS support the instructions used below.
+bool IsSupported() {
+  static const bool supported =
+      port::TestCPUFeature(port::CPUFeature::AVX512F) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512BW) &&
+      port::TestCPUFeature(port::CPUFeature::AVX512_VNNI);
+  return supported;
+}
+
+// Computes one tile of the product of `a`, packed in rows of `packed_k` bytes,
+// and of `b`, packed in blocks of kBlockCols columns, and writes the
+// `num_rows` x `num_cols` outputs that are in range to `c`, after adding the
+// row and column terms.
+TF_VNNI_TARGET void ComputeTile(const uint8* a, const int8* b,
+                                int64_t packed_k, const int32* row_terms,
+                                const int32* col_terms, int num_rows,
+                                int num_cols, int32* c, int64_t ldc) {
+  __m512i acc[kTileRows][kBlocksPerTile];
+  for (int r = 0; r < kTileRows; ++r) {
+    for (int j = 0; j < kBlocksPerTile; ++j) acc[r][j] = _mm512_setzero_si512();
+  }
+  const int64_t block_size = packed_k * kBlockCols;
+  for (int64_t l = 0; l < packed_k; l += 4) {
+    __m512i b_blocks[kBlocksPerTile];
+    for (int j = 0; j < kBlocksPerTile; ++j) {
+      b_blocks[j] = _mm512_loadu_si512(b + j * block_size + l * kBlockCols);
+    }
+    for (int r = 0; r < kTileRows; ++r) {
+      int32 a_group;
+      std::memcpy(&a_group, a + r * packed_k + l, sizeof(a_group));
+      const __m512i a_broadcast = _mm512_set1_epi32(a_group);
+      for (int j = 0; j < kBlocksPerTile; ++j) {
+        acc[r][j] = _mm512_dpbusd_epi32(acc[r][j], a_broadcast, b_blocks[j]);
+      }
+    }
+  }
+  for (int r = 0; r < num_rows; ++r) {
+    const __m512i row_term = _mm512_set1_epi32(row_terms[r]);
+    for (int j = 0; j < kBlocksPerTile && j * kBlockCols < num_cols; ++j) {
+      const int cols = std::min(kBlockCols, num_cols - j * kBlockCols);
+      const __mmask16 mask = static_cast<__mmask16>((1u << cols) - 1);
+      const __m512i col_term = _mm512_loadu_si512(col_terms + j * kBlockCols);
+      const __m512i result = _mm512_add_epi32(
+          acc[r][j], _mm512_add_epi32(row_term, col_term));
+      _mm512_mask_storeu_epi32(c + r * ldc + j * kBlockCols, mask, result);
+    }
+  }
+}
+
+#endif  // TENSORFLOW_USE_VNNI
+
+}  // namespace
+
+void SetEnabled(bool enabled) { g_enabled = enabled; }
+
+bool IsSupportedAndEnabled() {
+#ifdef TENSORFLOW_USE_VNNI
+  return g_enabled && IsSupported();
+#else
+  return false;
+#endif
+}
+
+void QuantizedGemm(OpKernelContext* context, bool transpose_a, bool transpose_b,
+                   const quint8* a_data, const quint8* b_data, qint32* c_data,
+                   int m, int n, int k, int offset_a, int offset_b, int lda,
+                   int ldb, int ldc) {
+#ifdef TENSORFLOW_USE_VNNI
+  CHECK(IsSupported()) << "VNNI QuantizedGemm is not supported on this CPU.";
+  if (m == 0 || n == 0) return;
+  const uint8* a = &a_data->value;
+  const uint8* b = &b_data->value;
+  int32* c = &c_data->value;
+  auto a_at = [=](int64_t i, int64_t l) {
+    return transpose_a ? a[l * lda + i] : a[i * lda + l];
+  };
+  auto b_at = [=](int64_t l, int64_t j) {
+    return transpose_b ? b[j * ldb + l] : b[l * ldb + j];
+  };
+
+  // The instructions multiply unsigned by signed bytes, so b is shifted by
+  // -128 when it is packed, and the product is corrected with the sums of the
+  // rows of a:
+  //   sum((a + offset_a) * (b + offset_b)) =
+  //       sum(a * (b - 128)) + (128 + offset_b) * sum(a) +
+  //       offset_a * sum(b) + k * offset_a * offset_b
+  // The terms are computed modulo 2^32, like the products.
+  const int64_t packed_k = RoundUp(k, 4);
+  const int64_t packed_m = RoundUp(m, kTileRows);
+  const int64_t packed_n = RoundUp(n, kTileCols);
+  std::vector<uint8> packed_a(packed_m * packed_k, 0);
+  std::vector<int8> packed_b(packed_n * packed_k, 0);
+  std::vector<int32> row_terms(packed_m, 0);
+  std::vector<int32> col_terms(packed_n, 0);
+
+  thread::ThreadPool* thread_pool =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  thread_pool->ParallelFor(m, 2 * k, [&](int64_t first, int64_t last) {
+    for (int64_t i = first; i < last; ++i) {
+      uint8* row = packed_a.data() + i * packed_k;
+      uint32 sum = 0;
+      for (int64_t l = 0; l < k; ++l) {
+        row[l] = a_at(i, l);
+        sum += row[l];
+      }
+      row_terms[i] = static_cast<int32>(
+          sum * static_cast<uint32>(128 + offset_b) +
+          static_cast<uint32>(k) * static_cast<uint32>(offset_a) *
+              static_cast<uint32>(offset_b));
+    }
+  });
+  thread_pool->ParallelFor(n, 2 * k, [&](int64_t first, int64_t last) {
+    for (int64_t j = first; j < last; ++j) {
+      int8* block = packed_b.data() + (j / kBlockCols) * packed_k * kBlockCols;
+      uint32 sum = 0;
+      for (int64_t l = 0; l < k; ++l) {
+        const uint8 value = b_at(l, j);
+        block[(l / 4) * 4 * kBlockCols + (j % kBlockCols) * 4 + l % 4] =
+            static_cast<int8>(static_cast<int32>(value) - 128);
+        sum += value;
+      }
+      col_terms[j] = static_cast<int32>(sum * static_cast<uint32>(offset_a));
+    }
+  });
+
+  const int64_t num_tile_rows = packed_m / kTileRows;
+  const int64_t num_tile_cols = packed_n / kTileCols;
+  thread_pool->ParallelFor(
+      num_tile_rows * num_tile_cols, kTileRows * kTileCols * packed_k / 16,
+      [&](int64_t first, int64_t last) {
+        for (int64_t tile = first; tile < last; ++tile) {
+          const int64_t i = (tile / num_tile_cols) * kTileRows;
+          const int64_t j = (tile % num_tile_cols) * kTileCols;
+          ComputeTile(packed_a.data() + i * packed_k,
+                      packed_b.data() + j * packed_k, packed_k,
+                      row_terms.data() + i, col_terms.data() + j,
+                      std::min<int64_t>(kTileRows, m - i),
+                      std::min<int64_t>(kTileCols, n - j), c + i * ldc + j,
+                      ldc);
+        }
+      });
+#else
+  LOG(FATAL) << "VNNI QuantizedGemm is not supported on this platform.";
+#endif
+}
+
+}  // namespace vnni
+}  // namespace tensorflow
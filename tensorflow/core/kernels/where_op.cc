@@ -23,8 +23,17 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/where_op.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <numeric>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif  // __AVX2__
+
+#include "absl/numeric/bits.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/bounds_check.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -54,75 +63,137 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-namespace functor {
-
 namespace {
-template <typename T>
-int64_t CountAccumulator(const T* begin, const T* end) {
-  return std::accumulate(begin, end, 0LL, [](int64_t accum, const T& val) {
-    return accum + (val != T(0));
-  });
-}
 
-template <>
-int64_t CountAccumulator<bool>(const bool* begin, const bool* end) {
-  return std::accumulate(begin, end, 0LL);
+// Elements of the input are processed in blocks of this size, which are
+// counted and then written in parallel.
+constexpr int64_t kWhereBlockSize = 1 << 14;
+
+// Returns a mask of the non-zero bytes among the 32 bytes at 'p'.
+inline uint32 NonZeroByteMask(const uint8* p) {
+#ifdef __AVX2__
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i is_zero = _mm256_cmpeq_epi8(v, _mm256_setzero_si256());
+  return ~static_cast<uint32>(_mm256_movemask_epi8(is_zero));
+#else
+  uint32 mask = 0;
+  for (int i = 0; i < 32; ++i) {
+    mask |= static_cast<uint32>(p[i] != 0) << i;
+  }
+  return mask;
+#endif  // __AVX2__
 }
 
-}  // namespace
-
+// Returns the number of non-zero elements in [begin, end).
 template <typename T>
-struct NumTrue<CPUDevice, T, int64_t> {
-  static Status Compute(OpKernelContext* ctx, const CPUDevice& d,
-                        typename TTypes<T>::ConstFlat input,
-                        TTypes<int64_t>::UnalignedScalar num_true) {
-    num_true() = CountAccumulator<T>(input.data(), input.data() + input.size());
-    return OkStatus();
-  }
-};
-
-template <int DIMS, typename T, typename TIndex>
-struct Where<CPUDevice, DIMS, T, TIndex> {
-  EIGEN_ALWAYS_INLINE static void WriteIndexRowMajor(
-      typename TTypes<int64_t>::Matrix output,
-      const typename Eigen::DSizes<TIndex, DIMS>& strides, TIndex true_n,
-      TIndex index) {
-    for (int i = 0; i < DIMS; ++i) {
-      output(true_n, i) = index / strides[i];
-      index -= output(true_n, i) * strides[i];
+int64_t CountNonZero(const T* data, int64_t begin, int64_t end) {
+  if constexpr (sizeof(T) == 1) {
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    int64_t count = 0;
+    int64_t i = begin;
+    for (; i + 32 <= end; i += 32) {
+      count += absl::popcount(NonZeroByteMask(bytes + i));
     }
+    for (; i < end; ++i) {
+      count += bytes[i] != 0;
+    }
+    return count;
+  } else {
+    return std::accumulate(data + begin, data + end, int64_t{0},
+                           [](int64_t accum, const T& val) {
+                             return accum + (val != T(0));
+                           });
   }
+}
 
-  EIGEN_ALWAYS_INLINE static Status Compute(
-      OpKernelContext* ctx, const CPUDevice& d,
-      typename TTypes<T, DIMS>::ConstTensor input,
-      typename TTypes<int64_t>::Matrix output, TIndex* found_true) {
-    Eigen::DSizes<Eigen::DenseIndex, DIMS> dims = input.dimensions();
-    Eigen::DSizes<TIndex, DIMS> strides;
-
-    EIGEN_STATIC_ASSERT((static_cast<int>(decltype(input)::Layout) ==
-                         static_cast<int>(Eigen::RowMajor)),
-                        INTERNAL_ERROR_INPUT_SHOULD_BE_ROWMAJOR);
-
-    strides[DIMS - 1] = 1;
-    for (int i = DIMS - 2; i >= 0; --i) {
-      strides[i] = strides[i + 1] * dims[i + 1];
+// Calls 'fn(i)' for each index 'i' of a non-zero element in [begin, end), in
+// increasing order.
+template <typename T, typename Fn>
+void ForEachNonZero(const T* data, int64_t begin, int64_t end, Fn fn) {
+  int64_t i = begin;
+  if constexpr (sizeof(T) == 1) {
+    // Skips 32 elements at a time, which is fast for sparse masks.
+    const uint8* bytes = reinterpret_cast<const uint8*>(data);
+    for (; i + 32 <= end; i += 32) {
+      for (uint32 mask = NonZeroByteMask(bytes + i); mask != 0;
+           mask &= mask - 1) {
+        fn(i + absl::countr_zero(mask));
+      }
     }
+  }
+  for (; i < end; ++i) {
+    if (data[i] != T(0)) fn(i);
+  }
+}
 
-    Eigen::DenseIndex output_size = output.dimension(0);
-    for (Eigen::DenseIndex n = 0; n < input.size(); ++n) {
-      if (input.data()[n] != T(0)) {
-        if (FastBoundsCheck(*found_true, output_size)) {
-          WriteIndexRowMajor(output, strides, *found_true, n);
+// Writes the coordinates of the non-zero elements of 'input' into 'output'
+// in two parallel passes: one counts the non-zero elements of each block,
+// and after a prefix sum over the blocks gives the first output row of each
+// block, the other writes their coordinates.
+template <int DIMS, typename T>
+Status WhereCPU(OpKernelContext* ctx, const Tensor& input, Tensor** output) {
+  const CPUDevice& d = ctx->eigen_device<CPUDevice>();
+  const T* data = input.flat<T>().data();
+  const int64_t num_elements = input.NumElements();
+  const int64_t num_blocks = Eigen::divup(num_elements, kWhereBlockSize);
+  const Eigen::TensorOpCost block_cost(kWhereBlockSize * sizeof(T), 0,
+                                       kWhereBlockSize);
+
+  std::vector<int64_t> block_offsets(num_blocks + 1, 0);
+  d.parallelFor(num_blocks, block_cost,
+                [&](Eigen::Index first, Eigen::Index last) {
+                  for (Eigen::Index b = first; b < last; ++b) {
+                    block_offsets[b + 1] = CountNonZero(
+                        data, b * kWhereBlockSize,
+                        std::min(num_elements, (b + 1) * kWhereBlockSize));
+                  }
+                });
+  std::partial_sum(block_offsets.begin(), block_offsets.end(),
+                   block_offsets.begin());
+  const int64_t num_true = block_offsets[num_blocks];
+
+  TF_RETURN_IF_ERROR(
+      ctx->allocate_output(0, TensorShape({num_true, DIMS}), output));
+  if (num_true == 0) return OkStatus();
+
+  Eigen::DSizes<int64_t, DIMS> strides;
+  strides[DIMS - 1] = 1;
+  for (int i = DIMS - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * input.dim_size(i + 1);
+  }
+  auto output_t = (*output)->matrix<int64_t>();
+  std::atomic<bool> race(false);
+  d.parallelFor(
+      num_blocks,
+      block_cost + Eigen::TensorOpCost(0, sizeof(int64_t) * DIMS, 0),
+      [&](Eigen::Index first, Eigen::Index last) {
+        for (Eigen::Index b = first; b < last; ++b) {
+          int64_t row = block_offsets[b];
+          const int64_t end_row = block_offsets[b + 1];
+          ForEachNonZero(
+              data, b * kWhereBlockSize,
+              std::min(num_elements, (b + 1) * kWhereBlockSize),
+              [&](int64_t index) {
+                if (row < end_row) {
+                  for (int i = 0; i < DIMS; ++i) {
+                    output_t(row, i) = index / strides[i];
+                    index -= output_t(row, i) * strides[i];
+                  }
+                }
+                ++row;
+              });
+          if (row != end_row) race = true;
         }
-        ++*found_true;
-      }
-    }
-    return OkStatus();
+      });
+  if (race) {
+    return errors::InvalidArgument(
+        "WhereOp: Race condition between counting the number of true "
+        "elements and writing them.");
   }
-};
+  return OkStatus();
+}
 
-}  // namespace functor
+}  // namespace
 
 template <typename T>
 class WhereCPUOp : public OpKernel {
@@ -139,29 +210,11 @@ class WhereCPUOp : public OpKernel {
                               "creating costly copies from device."));
 
     const int input_dims = input.dims();
-
-    int64_t num_true;
-    TTypes<int64_t>::UnalignedScalar num_true_t(&num_true);
-
-    Status s = functor::NumTrue<CPUDevice, T, int64_t>::Compute(
-        context, context->eigen_device<CPUDevice>(), input.flat<T>(),
-        num_true_t);
-    OP_REQUIRES_OK(context, s);
-    TensorShape output_shape({num_true, input_dims});
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
-
-    // TODO(ebrevdo): Replace single-threaded copy with a multithreaded block
-    // copy by getting block counts above instead of a global NumTrue, then
-    // having each block filled in separate threads below.
-    int64_t found_true = 0;
-
-#define HANDLE_DIM(NDIM)                                                      \
-  case NDIM: {                                                                \
-    Status s = functor::Where<CPUDevice, NDIM, T, int64_t>::Compute(          \
-        context, context->eigen_device<CPUDevice>(), input.tensor<T, NDIM>(), \
-        output->matrix<int64_t>(), &found_true);                              \
-    OP_REQUIRES_OK(context, s);                                               \
+
+#define HANDLE_DIM(NDIM)                                                 \
+  case NDIM: {                                                           \
+    OP_REQUIRES_OK(context, WhereCPU<NDIM, T>(context, input, &output)); \
   } break;
 
     switch (input_dims) {
@@ -180,14 +233,6 @@ class WhereCPUOp : public OpKernel {
                         "WhereOp : Unhandled input dimensions: ", input_dims));
     }
 #undef HANDLE_DIM
-
-    OP_REQUIRES(
-        context, found_true == num_true_t(),
-        errors::InvalidArgument(
-            "WhereOp: Race condition between counting the number of true "
-            "elements and writing them.  When counting, saw ",
-            num_true_t(), " elements; but when writing their indices, saw ",
-            found_true, " elements."));
   }
 
  private:
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/threadpool.h"
 
 #include <atomic>
+#include <memory>
 
 #include "absl/synchronization/barrier.h"
 #include "absl/synchronization/blocking_counter.h"
@@ -371,6 +372,77 @@ TEST(ThreadPool, Parallelism) {
   }
 }
 
+// Consumes at least `nanos` of CPU time on the calling thread.
+static void SpinForCpuNanos(int64_t nanos) {
+  const int64_t start = CpuTimeAccumulator::ThreadCpuNanos();
+  while (CpuTimeAccumulator::ThreadCpuNanos() - start < nanos) {
+  }
+}
+
+TEST(CpuTimeAccumulator, ScheduledClosuresInheritAccumulator) {
+  // The per-thread CPU clock is not available on all platforms.
+  if (CpuTimeAccumulator::ThreadCpuNanos() == 0) return;
+  constexpr int64_t kSpinNanos = 10 * 1000 * 1000;
+  auto accumulator = std::make_shared<CpuTimeAccumulator>();
+  auto unrelated = std::make_shared<CpuTimeAccumulator>();
+  {
+    ThreadPool pool(Env::Default(), "test", 4);
+    {
+      ScopedCpuTimeAccumulator scope(accumulator);
+      for (int i = 0; i < 4; ++i) {
+        pool.Schedule([&pool]() {
+          SpinForCpuNanos(kSpinNanos);
+          // Closures scheduled from a pool thread inherit the accumulator too.
+          pool.Schedule([]() { SpinForCpuNanos(kSpinNanos); });
+        });
+      }
+      EXPECT_EQ(CpuTimeAccumulator::Current(), accumulator);
+    }
+    EXPECT_EQ(CpuTimeAccumulator::Current(), nullptr);
+    {
+      ScopedCpuTimeAccumulator scope(unrelated);
+      pool.Schedule([]() { SpinForCpuNanos(kSpinNanos); });
+    }
+    // Closures scheduled without an accumulator are not attributed.
+    pool.Schedule([]() { SpinForCpuNanos(kSpinNanos); });
+    // Destroying the pool waits for all the closures to complete.
+  }
+  EXPECT_GE(accumulator->total_nanos(), 8 * kSpinNanos);
+  EXPECT_GE(unrelated->total_nanos(), kSpinNanos);
+  EXPECT_LT(unrelated->total_nanos(), 2 * kSpinNanos);
+}
+
+TEST(CpuTimeAccumulator, NestedScopes) {
+  if (CpuTimeAccumulator::ThreadCpuNanos() == 0) return;
+  constexpr int64_t kSpinNanos = 10 * 1000 * 1000;
+  auto outer = std::make_shared<CpuTimeAccumulator>();
+  auto child = std::make_shared<CpuTimeAccumulator>(outer);
+  auto unrelated = std::make_shared<CpuTimeAccumulator>();
+  {
+    ScopedCpuTimeAccumulator outer_scope(outer);
+    {
+      ScopedCpuTimeAccumulator child_scope(child);
+      SpinForCpuNanos(kSpinNanos);
+    }
+    EXPECT_GE(child->total_nanos(), kSpinNanos);
+    EXPECT_EQ(outer->total_nanos(), child->total_nanos());
+    {
+      // Time spent under an unrelated accumulator is not added to `outer`.
+      ScopedCpuTimeAccumulator unrelated_scope(unrelated);
+      SpinForCpuNanos(4 * kSpinNanos);
+    }
+    {
+      ScopedCpuTimeAccumulator no_accumulator_scope(nullptr);
+      EXPECT_EQ(CpuTimeAccumulator::Current(), nullptr);
+      SpinForCpuNanos(4 * kSpinNanos);
+    }
+    EXPECT_EQ(CpuTimeAccumulator::Current(), outer);
+  }
+  EXPECT_GE(unrelated->total_nanos(), 4 * kSpinNanos);
+  EXPECT_GE(outer->total_nanos(), child->total_nanos());
+  EXPECT_LT(outer->total_nanos(), 4 * kSpinNanos);
+}
+
 static void BM_Sequential(::testing::benchmark::State& state) {
   for (auto s : state) {
     state.PauseTiming();
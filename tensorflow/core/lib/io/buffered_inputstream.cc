@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 
+#include <cstring>
+
 #include "tensorflow/core/lib/io/random_inputstream.h"
 
 namespace tensorflow {
@@ -55,37 +57,54 @@ Status BufferedInputStream::FillBuffer() {
   return s;
 }
 
+namespace {
+
+// Appends [begin, end) to `result`, without its '\r' characters.
+template <typename StringType>
+void AppendWithoutCarriageReturns(const char* begin, const char* end,
+                                  StringType* result) {
+  while (begin < end) {
+    const char* cr =
+        static_cast<const char*>(memchr(begin, '\r', end - begin));
+    if (cr == nullptr) {
+      result->append(begin, end - begin);
+      return;
+    }
+    result->append(begin, cr - begin);
+    begin = cr + 1;
+  }
+}
+
+}  // namespace
+
 template <typename StringType>
 Status BufferedInputStream::ReadLineHelper(StringType* result,
                                            bool include_eol) {
   result->clear();
   Status s;
-  size_t start_pos = pos_;
   while (true) {
     if (pos_ == limit_) {
-      result->append(buf_.data() + start_pos, pos_ - start_pos);
       // Get more data into buffer
       s = FillBuffer();
       if (limit_ == 0) {
         break;
       }
-      start_pos = pos_;
     }
-    char c = buf_[pos_];
-    if (c == '\n') {
-      result->append(buf_.data() + start_pos, pos_ - start_pos);
+    const char* begin = buf_.data() + pos_;
+    const char* end = buf_.data() + limit_;
+    const char* newline =
+        static_cast<const char*>(memchr(begin, '\n', end - begin));
+    // We don't append '\r' to *result
+    if (newline != nullptr) {
+      AppendWithoutCarriageReturns(begin, newline, result);
       if (include_eol) {
-        result->append(1, c);
+        result->append(1, '\n');
       }
-      pos_++;
+      pos_ += newline - begin + 1;
       return OkStatus();
     }
-    // We don't append '\r' to *result
-    if (c == '\r') {
-      result->append(buf_.data() + start_pos, pos_ - start_pos);
-      start_pos = pos_ + 1;
-    }
-    pos_++;
+    AppendWithoutCarriageReturns(begin, end, result);
+    pos_ = limit_;
   }
   if (errors::IsOutOfRange(s) && !result->empty()) {
     return OkStatus();
@@ -227,6 +246,46 @@ std::string BufferedInputStream::ReadLineAsString() {
   return result;
 }
 
+Status BufferedInputStream::ReadLines(size_t max_lines,
+                                      std::vector<StringPiece>* lines) {
+  lines->clear();
+  copied_lines_.clear();
+  if (max_lines == 0) {
+    return OkStatus();
+  }
+  if (pos_ == limit_) {
+    Status s = FillBuffer();
+    if (limit_ == 0) {
+      return s;
+    }
+  }
+  while (lines->size() < max_lines) {
+    const char* begin = buf_.data() + pos_;
+    const char* newline =
+        static_cast<const char*>(memchr(begin, '\n', limit_ - pos_));
+    if (newline == nullptr) {
+      break;
+    }
+    if (memchr(begin, '\r', newline - begin) == nullptr) {
+      lines->emplace_back(begin, newline - begin);
+    } else {
+      // The buffer is not modified, since Seek() may reuse it.
+      copied_lines_.emplace_back();
+      AppendWithoutCarriageReturns(begin, newline, &copied_lines_.back());
+      lines->emplace_back(copied_lines_.back());
+    }
+    pos_ += newline - begin + 1;
+  }
+  if (lines->empty()) {
+    // The next line does not end in the buffered data, so it is copied.
+    copied_lines_.emplace_back();
+    TF_RETURN_IF_ERROR(
+        ReadLineHelper(&copied_lines_.back(), /*include_eol=*/false));
+    lines->emplace_back(copied_lines_.back());
+  }
+  return OkStatus();
+}
+
 Status BufferedInputStream::SkipLine() {
   Status s;
   bool skipped = false;
@@ -238,11 +297,15 @@ Status BufferedInputStream::SkipLine() {
         break;
       }
     }
-    char c = buf_[pos_++];
     skipped = true;
-    if (c == '\n') {
+    const char* begin = buf_.data() + pos_;
+    const char* newline =
+        static_cast<const char*>(memchr(begin, '\n', limit_ - pos_));
+    if (newline != nullptr) {
+      pos_ += newline - begin + 1;
       return OkStatus();
     }
+    pos_ = limit_;
   }
   if (errors::IsOutOfRange(s) && skipped) {
     return OkStatus();
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_LIB_IO_BUFFERED_INPUTSTREAM_H_
 #define TENSORFLOW_CORE_LIB_IO_BUFFERED_INPUTSTREAM_H_
 
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/platform/file_system.h"
 
@@ -77,6 +81,20 @@ class BufferedInputStream : public InputStreamInterface {
   // no special treatment.
   std::string ReadLineAsString();
 
+  // Reads up to `max_lines` text lines, with the same semantics as ReadLine(),
+  // and stores views of them in `*lines`. The lines that end in the buffered
+  // data are not copied, so reading many short lines per call avoids most of
+  // the per-line overhead of ReadLine(). At least one line is read, unless
+  // `max_lines` is 0.
+  //
+  // The views are invalidated by the next call on this stream.
+  //
+  // If successful, returns OK.  If we are already at the end of the
+  // file, we return an OUT_OF_RANGE error.  Otherwise, we return
+  // some other non-OK status.
+  tensorflow::Status ReadLines(size_t max_lines,
+                               std::vector<StringPiece>* lines);
+
   // Skip one text line of data.
   //
   // If successful, returns OK.  If we are already at the end of the
@@ -108,6 +126,9 @@ class BufferedInputStream : public InputStreamInterface {
   // When EoF is reached, file_status_ contains the status to skip unnecessary
   // buffer allocations.
   tensorflow::Status file_status_ = OkStatus();
+  // Holds the lines returned by ReadLines() that could not be returned as
+  // views of `buf_`. A deque keeps the views valid as lines are added.
+  std::deque<std::string> copied_lines_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(BufferedInputStream);
 };
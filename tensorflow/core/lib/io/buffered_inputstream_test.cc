@@ -189,6 +189,63 @@ TEST(BufferedInputStream, ReadLine_CRLF) {
   }
 }
 
+TEST(BufferedInputStream, ReadLines) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(
+      env, fname, "line one\r\n\r\n\nline\r two\r\nline three"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  for (auto buf_size : BufferSizes()) {
+    for (size_t max_lines : {1, 2, 10}) {
+      std::unique_ptr<RandomAccessInputStream> input_stream(
+          new RandomAccessInputStream(file.get()));
+      BufferedInputStream in(input_stream.get(), buf_size);
+      std::vector<string> lines;
+      std::vector<StringPiece> views;
+      Status s;
+      while ((s = in.ReadLines(max_lines, &views)).ok()) {
+        EXPECT_GE(views.size(), 1);
+        EXPECT_LE(views.size(), max_lines);
+        for (StringPiece view : views) {
+          lines.emplace_back(view);
+        }
+      }
+      EXPECT_TRUE(errors::IsOutOfRange(s));
+      EXPECT_EQ(lines, std::vector<string>(
+                           {"line one", "", "", "line two", "line three"}))
+          << "buf_size: " << buf_size << " max_lines: " << max_lines;
+    }
+  }
+}
+
+TEST(BufferedInputStream, ReadLinesThenSeek) {
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "one\r\ntwo\r\n"));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  std::unique_ptr<RandomAccessInputStream> input_stream(
+      new RandomAccessInputStream(file.get()));
+  BufferedInputStream in(input_stream.get(), 1024);
+
+  std::vector<StringPiece> views;
+  TF_ASSERT_OK(in.ReadLines(2, &views));
+  ASSERT_EQ(views.size(), 2);
+  EXPECT_EQ(views[0], "one");
+  EXPECT_EQ(views[1], "two");
+  EXPECT_EQ(in.Tell(), 10);
+
+  // Seeking back reuses the buffer, which must not have been modified.
+  TF_ASSERT_OK(in.Seek(0));
+  tstring contents;
+  TF_ASSERT_OK(in.ReadNBytes(10, &contents));
+  EXPECT_EQ(contents, "one\r\ntwo\r\n");
+}
+
 TEST(BufferedInputStream, SkipLine1) {
   Env* env = Env::Default();
   string fname;
@@ -564,6 +621,42 @@ BENCHMARK(BM_BufferedReaderSmallReads)
     ->ArgPair(1024 * 1024, 1024 * 1024)
     ->ArgPair(256 * 1024 * 1024, 1024);
 
+void BM_BufferedReaderReadLines(::testing::benchmark::State& state) {
+  const int max_lines = state.range(0);
+  Env* env = Env::Default();
+  string fname;
+  ASSERT_TRUE(env->LocalTempFilename(&fname));
+
+  const string line = "a line of text that is not very long\n";
+  std::unique_ptr<WritableFile> write_file;
+  TF_ASSERT_OK(env->NewWritableFile(fname, &write_file));
+  constexpr int kNumLines = 100000;
+  for (int i = 0; i < kNumLines; ++i) {
+    TF_ASSERT_OK(write_file->Append(line));
+  }
+  TF_ASSERT_OK(write_file->Close());
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+
+  tstring result;
+  std::vector<StringPiece> views;
+  for (auto s : state) {
+    BufferedInputStream in(file.get(), 256 * 1024);
+    if (max_lines == 0) {
+      while (in.ReadLine(&result).ok()) {
+      }
+    } else {
+      while (in.ReadLines(max_lines, &views).ok()) {
+      }
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kNumLines * line.size());
+}
+// An argument of 0 reads lines one at a time with ReadLine().
+BENCHMARK(BM_BufferedReaderReadLines)->Arg(0)->Arg(1)->Arg(1024);
+
 }  // anonymous namespace
 }  // namespace io
 }  // namespace tensorflow
@@ -0,0 +1,148 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace io {
+
+ReadaheadInputStream::ReadaheadInputStream(RandomAccessFile* file,
+                                           size_t chunk_bytes,
+                                           int max_outstanding_reads)
+    : file_(file),
+      chunk_bytes_(chunk_bytes),
+      max_outstanding_reads_(max_outstanding_reads) {
+  DCHECK_GT(chunk_bytes, 0);
+  DCHECK_GT(max_outstanding_reads, 0);
+}
+
+ReadaheadInputStream::~ReadaheadInputStream() { WaitForReads(); }
+
+void ReadaheadInputStream::IssueReads() {
+  while (static_cast<int>(chunks_.size()) < max_outstanding_reads_) {
+    Chunk* chunk;
+    {
+      mutex_lock l(mu_);
+      if (end_of_file_) {
+        return;
+      }
+      chunks_.push_back(std::make_unique<Chunk>());
+      chunk = chunks_.back().get();
+      ++num_outstanding_reads_;
+    }
+    chunk->buffer.reset(new char[chunk_bytes_]);
+    // `ReadAsync()` may call `done` before it returns, so it is called without
+    // holding `mu_`.
+    file_->ReadAsync(next_offset_, chunk_bytes_, chunk->buffer.get(),
+                     [this, chunk](const Status& s, StringPiece result) {
+                       mutex_lock l(mu_);
+                       chunk->status = s;
+                       chunk->size = result.size();
+                       chunk->done = true;
+                       if (result.size() < chunk_bytes_) {
+                         end_of_file_ = true;
+                       }
+                       --num_outstanding_reads_;
+                       cv_.notify_all();
+                     });
+    next_offset_ += chunk_bytes_;
+  }
+}
+
+Status ReadaheadInputStream::Consume(int64_t bytes, tstring* result) {
+  while (bytes > 0) {
+    if (chunks_.empty()) {
+      IssueReads();
+    }
+    if (chunks_.empty()) {
+      return errors::OutOfRange("reached end of file");
+    }
+    Chunk* chunk = chunks_.front().get();
+    {
+      mutex_lock l(mu_);
+      while (!chunk->done) {
+        cv_.wait(l);
+      }
+    }
+    if (!chunk->status.ok() && !errors::IsOutOfRange(chunk->status)) {
+      return chunk->status;
+    }
+    const size_t n = std::min<size_t>(bytes, chunk->size - chunk->consumed);
+    if (result != nullptr) {
+      result->append(chunk->buffer.get() + chunk->consumed, n);
+    }
+    chunk->consumed += n;
+    pos_ += n;
+    bytes -= n;
+    if (chunk->consumed == chunk->size) {
+      if (chunk->size < chunk_bytes_) {
+        // The last chunk of the file is kept, so that later reads also reach
+        // the end of the file.
+        if (bytes > 0) {
+          return errors::OutOfRange("reached end of file");
+        }
+        break;
+      }
+      chunks_.pop_front();
+      IssueReads();
+    }
+  }
+  return OkStatus();
+}
+
+Status ReadaheadInputStream::ReadNBytes(int64_t bytes_to_read,
+                                        tstring* result) {
+  if (bytes_to_read < 0) {
+    return errors::InvalidArgument("Can't read a negative number of bytes: ",
+                                   bytes_to_read);
+  }
+  result->clear();
+  result->reserve(bytes_to_read);
+  return Consume(bytes_to_read, result);
+}
+
+Status ReadaheadInputStream::SkipNBytes(int64_t bytes_to_skip) {
+  if (bytes_to_skip < 0) {
+    return errors::InvalidArgument("Can't skip a negative number of bytes: ",
+                                   bytes_to_skip);
+  }
+  return Consume(bytes_to_skip, /*result=*/nullptr);
+}
+
+int64_t ReadaheadInputStream::Tell() const { return pos_; }
+
+Status ReadaheadInputStream::Reset() {
+  WaitForReads();
+  chunks_.clear();
+  next_offset_ = 0;
+  pos_ = 0;
+  mutex_lock l(mu_);
+  end_of_file_ = false;
+  return OkStatus();
+}
+
+void ReadaheadInputStream::WaitForReads() {
+  mutex_lock l(mu_);
+  while (num_outstanding_reads_ > 0) {
+    cv_.wait(l);
+  }
+}
+
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+#define TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
+
+#include <deque>
+#include <memory>
+
+#include "tensorflow/core/lib/io/inputstream_interface.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace io {
+
+// Reads a RandomAccessFile sequentially, keeping up to `max_outstanding_reads`
+// reads of `chunk_bytes` bytes in flight ahead of the consumer with
+// `RandomAccessFile::ReadAsync()`, so that a single reader keeps the device
+// queue full. A single instance of ReadaheadInputStream is NOT safe for
+// concurrent use by multiple threads.
+class ReadaheadInputStream : public InputStreamInterface {
+ public:
+  // Does not take ownership of `file`, which must outlive *this.
+  ReadaheadInputStream(RandomAccessFile* file, size_t chunk_bytes,
+                       int max_outstanding_reads);
+
+  // Waits for the outstanding reads.
+  ~ReadaheadInputStream() override;
+
+  Status ReadNBytes(int64_t bytes_to_read, tstring* result) override;
+
+  Status SkipNBytes(int64_t bytes_to_skip) override;
+
+  int64_t Tell() const override;
+
+  // Discards the chunks read ahead, and starts reading from the beginning of
+  // the file again.
+  Status Reset() override;
+
+ private:
+  struct Chunk {
+    std::unique_ptr<char[]> buffer;
+    // Set once the read completes, under `mu_`.
+    bool done = false;
+    Status status;
+    size_t size = 0;
+    // Number of bytes of the chunk already consumed.
+    size_t consumed = 0;
+  };
+
+  // Issues reads until `max_outstanding_reads_` chunks are buffered, or the
+  // end of the file has been reached.
+  void IssueReads() TF_LOCKS_EXCLUDED(mu_);
+
+  // Consumes up to `bytes` bytes, appending them to `result` if it is not
+  // null.
+  Status Consume(int64_t bytes, tstring* result);
+
+  // Waits until all outstanding reads complete.
+  void WaitForReads() TF_LOCKS_EXCLUDED(mu_);
+
+  RandomAccessFile* const file_;
+  const size_t chunk_bytes_;
+  const int max_outstanding_reads_;
+
+  // Chunks read ahead, in file order. The first one is being consumed.
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  // Offset of the next chunk to read.
+  uint64 next_offset_ = 0;
+  // Offset of the next byte returned to the consumer.
+  int64_t pos_ = 0;
+
+  // Guards the state updated by the completions of reads.
+  mutex mu_;
+  condition_variable cv_;
+  int num_outstanding_reads_ TF_GUARDED_BY(mu_) = 0;
+  // Set once a read returns less than a full chunk, after which no further
+  // reads are issued.
+  bool end_of_file_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_READAHEAD_INPUTSTREAM_H_
@@ -0,0 +1,150 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+// A file whose reads fail past a given offset.
+class FailingFile : public RandomAccessFile {
+ public:
+  FailingFile(RandomAccessFile* file, uint64 fail_offset)
+      : file_(file), fail_offset_(fail_offset) {}
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    if (offset + n > fail_offset_) {
+      *result = StringPiece();
+      return errors::Internal("read failed");
+    }
+    return file_->Read(offset, n, result, scratch);
+  }
+
+ private:
+  RandomAccessFile* const file_;
+  const uint64 fail_offset_;
+};
+
+class ReadaheadInputStreamTest
+    : public ::testing::TestWithParam<std::pair<size_t, int>> {
+ protected:
+  size_t chunk_bytes() const { return GetParam().first; }
+  int max_outstanding_reads() const { return GetParam().second; }
+};
+
+TEST_P(ReadaheadInputStreamTest, ReadNBytes) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  tstring read;
+  ReadaheadInputStream in(file.get(), chunk_bytes(), max_outstanding_reads());
+  TF_ASSERT_OK(in.ReadNBytes(3, &read));
+  EXPECT_EQ(read, "012");
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(0, &read));
+  EXPECT_EQ(read, "");
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(5, &read));
+  EXPECT_EQ(read, "34567");
+  EXPECT_EQ(8, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(20, &read)));
+  EXPECT_EQ(read, "89");
+  EXPECT_EQ(10, in.Tell());
+  EXPECT_TRUE(errors::IsOutOfRange(in.ReadNBytes(1, &read)));
+  EXPECT_EQ(read, "");
+  EXPECT_EQ(10, in.Tell());
+}
+
+TEST_P(ReadaheadInputStreamTest, SkipNBytesAndReset) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "0123456789"));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  tstring read;
+  ReadaheadInputStream in(file.get(), chunk_bytes(), max_outstanding_reads());
+  TF_ASSERT_OK(in.SkipNBytes(3));
+  EXPECT_EQ(3, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(4, &read));
+  EXPECT_EQ(read, "3456");
+  EXPECT_TRUE(errors::IsOutOfRange(in.SkipNBytes(20)));
+  EXPECT_EQ(10, in.Tell());
+
+  TF_ASSERT_OK(in.Reset());
+  EXPECT_EQ(0, in.Tell());
+  TF_ASSERT_OK(in.ReadNBytes(10, &read));
+  EXPECT_EQ(read, "0123456789");
+}
+
+TEST_P(ReadaheadInputStreamTest, LargeFile) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_large_test";
+  string contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents.push_back('a' + i % 26);
+  }
+  TF_ASSERT_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  ReadaheadInputStream in(file.get(), chunk_bytes(), max_outstanding_reads());
+  tstring read;
+  string result;
+  Status s;
+  while ((s = in.ReadNBytes(777, &read)).ok()) {
+    result.append(read);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(s));
+  result.append(read);
+  EXPECT_EQ(result, contents);
+  EXPECT_EQ(contents.size(), in.Tell());
+}
+
+TEST_P(ReadaheadInputStreamTest, ReadError) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/readahead_inputstream_test";
+  TF_ASSERT_OK(WriteStringToFile(env, fname, string(64, 'x')));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  FailingFile failing_file(file.get(), /*fail_offset=*/16);
+  ReadaheadInputStream in(&failing_file, chunk_bytes(),
+                          max_outstanding_reads());
+  tstring read;
+  Status s;
+  while ((s = in.ReadNBytes(1, &read)).ok()) {
+  }
+  EXPECT_TRUE(errors::IsInternal(s)) << s;
+  EXPECT_LE(in.Tell(), 16);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ReadaheadInputStreamTests, ReadaheadInputStreamTest,
+    ::testing::Values(std::make_pair(1, 1), std::make_pair(3, 2),
+                      std::make_pair(4, 8), std::make_pair(1024, 4)));
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
@@ -0,0 +1,164 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <string.h>
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/strcat.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+constexpr char kIndexSuffix[] = ".index";
+constexpr char kMagic[] = "TFRINDEX";
+constexpr size_t kMagicSize = 8;
+constexpr size_t kHeaderSize = RecordReader::kHeaderSize;
+constexpr size_t kFooterSize = RecordReader::kFooterSize;
+
+}  // namespace
+
+/* static */ std::string RecordIndex::SidecarFilename(
+    const std::string& filename) {
+  return strings::StrCat(filename, kIndexSuffix);
+}
+
+/* static */ Status RecordIndex::Read(Env* env, const std::string& filename,
+                                      RecordIndex* index) {
+  std::string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+  const size_t min_size = kMagicSize + 2 * sizeof(uint64) + sizeof(uint32);
+  if (contents.size() < min_size ||
+      memcmp(contents.data(), kMagic, kMagicSize) != 0) {
+    return errors::DataLoss(filename, " is not a TFRecord index.");
+  }
+  const size_t crc_offset = contents.size() - sizeof(uint32);
+  if (crc32c::Unmask(core::DecodeFixed32(contents.data() + crc_offset)) !=
+      crc32c::Value(contents.data(), crc_offset)) {
+    return errors::DataLoss("Corrupted TFRecord index ", filename, ".");
+  }
+  const uint64 num_records = core::DecodeFixed64(contents.data() + kMagicSize);
+  if (num_records != (crc_offset - kMagicSize) / sizeof(uint64) - 2 ||
+      (crc_offset - kMagicSize) % sizeof(uint64) != 0) {
+    return errors::DataLoss("Corrupted TFRecord index ", filename, ".");
+  }
+  const char* data = contents.data() + kMagicSize + sizeof(uint64);
+  index->offsets_.resize(num_records + 1);
+  for (uint64 i = 0; i <= num_records; ++i) {
+    index->offsets_[i] = core::DecodeFixed64(data + i * sizeof(uint64));
+    if (i > 0 && index->offsets_[i] <
+                     index->offsets_[i - 1] + kHeaderSize + kFooterSize) {
+      return errors::DataLoss("Corrupted TFRecord index ", filename, ".");
+    }
+  }
+  return OkStatus();
+}
+
+/* static */ Status RecordIndex::Build(RandomAccessFile* file,
+                                       RecordIndex* index) {
+  index->offsets_ = {0};
+  char header[kHeaderSize];
+  while (true) {
+    const uint64 offset = index->offsets_.back();
+    StringPiece data;
+    Status s = file->Read(offset, kHeaderSize, &data, header);
+    if (!s.ok() && !errors::IsOutOfRange(s)) {
+      return s;
+    }
+    if (data.empty()) {
+      break;
+    }
+    if (data.size() < kHeaderSize) {
+      return errors::DataLoss("truncated record at ", offset);
+    }
+    const uint32 masked_crc = core::DecodeFixed32(data.data() + sizeof(uint64));
+    if (crc32c::Unmask(masked_crc) !=
+        crc32c::Value(data.data(), sizeof(uint64))) {
+      return errors::DataLoss("corrupted record at ", offset);
+    }
+    index->Add(core::DecodeFixed64(data.data()));
+  }
+  // Check that the last record is complete.
+  if (index->num_records() > 0) {
+    StringPiece data;
+    Status s = file->Read(index->offsets_.back() - 1, 1, &data, header);
+    if (!s.ok() && !errors::IsOutOfRange(s)) {
+      return s;
+    }
+    if (data.size() != 1) {
+      return errors::DataLoss("truncated record at ",
+                              index->offset(index->num_records() - 1));
+    }
+  }
+  return OkStatus();
+}
+
+Status RecordIndex::Write(Env* env, const std::string& filename) const {
+  std::string contents(kMagic, kMagicSize);
+  core::PutFixed64(&contents, num_records());
+  for (uint64 offset : offsets_) {
+    core::PutFixed64(&contents, offset);
+  }
+  const uint32 crc = crc32c::Value(contents.data(), contents.size());
+  core::PutFixed32(&contents, crc32c::Mask(crc));
+  return WriteStringToFile(env, filename, contents);
+}
+
+void RecordIndex::Add(uint64 length) {
+  offsets_.push_back(offsets_.back() + kHeaderSize + length + kFooterSize);
+}
+
+Status RecordIndex::ReadRecord(RandomAccessFile* file, int64_t i,
+                               tstring* record) const {
+  if (i < 0 || i >= num_records()) {
+    return errors::OutOfRange("Record ", i, " is out of range for an index of ",
+                              num_records(), " records.");
+  }
+  const uint64 offset = offsets_[i];
+  const size_t size = offsets_[i + 1] - offset;
+  const size_t length = size - kHeaderSize - kFooterSize;
+  // The header, data and footer are read at once, and the data is then moved
+  // to the start of the record.
+  record->resize_uninitialized(size);
+  StringPiece data;
+  Status s = file->Read(offset, size, &data, record->mdata());
+  if (!s.ok() && !errors::IsOutOfRange(s)) {
+    return s;
+  }
+  if (data.size() != size) {
+    return errors::DataLoss("truncated record at ", offset);
+  }
+  if (core::DecodeFixed64(data.data()) != length ||
+      crc32c::Unmask(core::DecodeFixed32(data.data() + sizeof(uint64))) !=
+          crc32c::Value(data.data(), sizeof(uint64))) {
+    return errors::DataLoss("corrupted record header at ", offset);
+  }
+  const char* payload = data.data() + kHeaderSize;
+  if (crc32c::Unmask(core::DecodeFixed32(payload + length)) !=
+      crc32c::Value(payload, length)) {
+    return errors::DataLoss("corrupted record at ", offset);
+  }
+  memmove(record->mdata(), payload, length);
+  record->resize(length);
+  return OkStatus();
+}
+
+}  // namespace io
+}  // namespace tensorflow
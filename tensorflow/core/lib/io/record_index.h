@@ -0,0 +1,77 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+#define TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace io {
+
+// The offsets of the records of an uncompressed TFRecord file, which allow
+// reading the records in any order.
+//
+// An index is stored in a sidecar file next to the TFRecord file, named by
+// `SidecarFilename()`, with the format:
+//  char[8]   magic "TFRINDEX"
+//  uint64    number of records n
+//  uint64    offsets[n + 1]: the start of each record, then the end of the
+//            last record
+//  uint32    masked crc of the above
+class RecordIndex {
+ public:
+  RecordIndex() : offsets_({0}) {}
+
+  // Returns the name of the index of the TFRecord file `filename`.
+  static std::string SidecarFilename(const std::string& filename);
+
+  // Reads the index stored in `filename`.
+  static Status Read(Env* env, const std::string& filename,
+                     RecordIndex* index);
+
+  // Builds the index of `file` by reading the headers of its records.
+  static Status Build(RandomAccessFile* file, RecordIndex* index);
+
+  // Writes the index to `filename`.
+  Status Write(Env* env, const std::string& filename) const;
+
+  // Appends a record of `length` bytes of data, for example after it is
+  // written with `RecordWriter`.
+  void Add(uint64 length);
+
+  int64_t num_records() const { return offsets_.size() - 1; }
+
+  // Returns the offset of record `i` in the file.
+  uint64 offset(int64_t i) const { return offsets_[i]; }
+
+  // Reads record `i` of `file`, which must be the file of this index.
+  Status ReadRecord(RandomAccessFile* file, int64_t i, tstring* record) const;
+
+ private:
+  std::vector<uint64> offsets_;
+};
+
+}  // namespace io
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_IO_RECORD_INDEX_H_
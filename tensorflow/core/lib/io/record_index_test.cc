@@ -0,0 +1,128 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/lib/io/record_index.h"
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace io {
+namespace {
+
+string Record(int i) { return strings::StrCat("record_", string(i, 'x')); }
+
+// Writes `num_records` records to `fname`, and returns their index.
+RecordIndex WriteRecords(const string& fname, int num_records) {
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  RecordWriter writer(file.get());
+  RecordIndex index;
+  for (int i = 0; i < num_records; ++i) {
+    TF_CHECK_OK(writer.WriteRecord(Record(i)));
+    index.Add(Record(i).size());
+  }
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+  return index;
+}
+
+TEST(RecordIndexTest, BuildMatchesWriter) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_index_build_test";
+  RecordIndex written = WriteRecords(fname, 20);
+  EXPECT_EQ(written.num_records(), 20);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  RecordIndex built;
+  TF_ASSERT_OK(RecordIndex::Build(file.get(), &built));
+  ASSERT_EQ(built.num_records(), 20);
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(built.offset(i), written.offset(i));
+  }
+}
+
+TEST(RecordIndexTest, WriteAndRead) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_index_read_test";
+  RecordIndex written = WriteRecords(fname, 10);
+  const string index_fname = RecordIndex::SidecarFilename(fname);
+  TF_ASSERT_OK(written.Write(env, index_fname));
+
+  RecordIndex index;
+  TF_ASSERT_OK(RecordIndex::Read(env, index_fname, &index));
+  ASSERT_EQ(index.num_records(), 10);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  tstring record;
+  for (int i : {7, 0, 9, 3, 3}) {
+    TF_ASSERT_OK(index.ReadRecord(file.get(), i, &record));
+    EXPECT_EQ(record, Record(i));
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(index.ReadRecord(file.get(), 10, &record)));
+}
+
+TEST(RecordIndexTest, EmptyFile) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_index_empty_test";
+  WriteRecords(fname, 0);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  RecordIndex index;
+  TF_ASSERT_OK(RecordIndex::Build(file.get(), &index));
+  EXPECT_EQ(index.num_records(), 0);
+}
+
+TEST(RecordIndexTest, CorruptedIndex) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_index_corrupted_test";
+  TF_ASSERT_OK(WriteRecords(fname, 5).Write(env, fname));
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &contents));
+  contents[12] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(env, fname, contents));
+  RecordIndex index;
+  EXPECT_TRUE(errors::IsDataLoss(RecordIndex::Read(env, fname, &index)));
+  TF_ASSERT_OK(WriteStringToFile(env, fname, "not an index"));
+  EXPECT_TRUE(errors::IsDataLoss(RecordIndex::Read(env, fname, &index)));
+}
+
+TEST(RecordIndexTest, TruncatedFile) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_index_truncated_test";
+  RecordIndex written = WriteRecords(fname, 5);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(env, fname, &contents));
+  TF_ASSERT_OK(
+      WriteStringToFile(env, fname, contents.substr(0, contents.size() - 1)));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_ASSERT_OK(env->NewRandomAccessFile(fname, &file));
+  RecordIndex index;
+  EXPECT_TRUE(errors::IsDataLoss(RecordIndex::Build(file.get(), &index)));
+  tstring record;
+  TF_ASSERT_OK(written.ReadRecord(file.get(), 3, &record));
+  EXPECT_TRUE(errors::IsDataLoss(written.ReadRecord(file.get(), 4, &record)));
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace tensorflow
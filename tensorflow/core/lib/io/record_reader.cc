@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/buffered_inputstream.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/lib/io/readahead_inputstream.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
@@ -59,7 +60,10 @@ RecordReader::RecordReader(RandomAccessFile* file,
     : options_(options),
       input_stream_(new RandomAccessInputStream(file)),
       last_read_failed_(false) {
-  if (options.buffer_size > 0) {
+  if (options.readahead_depth > 0) {
+    input_stream_.reset(new ReadaheadInputStream(
+        file, options.readahead_chunk_size, options.readahead_depth));
+  } else if (options.buffer_size > 0) {
     input_stream_.reset(new BufferedInputStream(input_stream_.release(),
                                                 options.buffer_size, true));
   }
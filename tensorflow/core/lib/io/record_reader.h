@@ -47,6 +47,13 @@ struct RecordReaderOptions {
   // compressed files.) Consider using SequentialRecordReader.
   int64_t buffer_size = 0;
 
+  // If readahead_depth is non-zero, the file is read in chunks of
+  // readahead_chunk_size bytes, keeping up to readahead_depth chunks in
+  // flight with asynchronous reads. This is intended for sequential reads,
+  // and buffer_size is ignored.
+  int readahead_depth = 0;
+  int64_t readahead_chunk_size = 256 * 1024;
+
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
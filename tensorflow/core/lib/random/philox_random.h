@@ -190,13 +190,14 @@ class PhiloxRandom {
     return counter;
   }
 
- private:
-  // We use the same constants as recommended by the original paper.
+  // We use the same constants as recommended by the original paper. They are
+  // public for the SIMD implementation in philox_random_batch.h.
   static constexpr uint32_t kPhiloxW32A = 0x9E3779B9;
   static constexpr uint32_t kPhiloxW32B = 0xBB67AE85;
   static constexpr uint32_t kPhiloxM4x32A = 0xD2511F53;
   static constexpr uint32_t kPhiloxM4x32B = 0xCD9E8D57;
 
+ private:
   // Helper function to skip the next sample of 128-bits in the current stream.
   PHILOX_DEVICE_INLINE void SkipOne() {
     if (++counter_[0] == 0) {
@@ -0,0 +1,188 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
+#define TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
+
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "tensorflow/core/lib/random/philox_random.h"
+
+namespace tensorflow {
+namespace random {
+
+namespace internal {
+
+// Evaluates PhiloxRandom on `Simd::kLanes` consecutive counters at once, one
+// counter per SIMD lane. `Simd` provides the vector type and its operations.
+template <typename Simd>
+void GeneratePhiloxLanes(const PhiloxRandom& gen, uint32_t* output) {
+  typedef typename Simd::Vec Vec;
+  constexpr int kLanes = Simd::kLanes;
+  alignas(64) uint32_t lanes[4][kLanes];
+  const PhiloxRandom::ResultType& counter = gen.counter();
+  if (counter[0] <= std::numeric_limits<uint32_t>::max() - (kLanes - 1)) {
+    // The counters of all lanes only differ in their first word.
+    for (int i = 0; i < kLanes; ++i) {
+      lanes[0][i] = counter[0] + i;
+      lanes[1][i] = counter[1];
+      lanes[2][i] = counter[2];
+      lanes[3][i] = counter[3];
+    }
+  } else {
+    PhiloxRandom lane_gen = gen;
+    for (int i = 0; i < kLanes; ++i) {
+      for (int k = 0; k < 4; ++k) lanes[k][i] = lane_gen.counter()[k];
+      lane_gen.Skip(1);
+    }
+  }
+
+  Vec c0 = Simd::Load(lanes[0]);
+  Vec c1 = Simd::Load(lanes[1]);
+  Vec c2 = Simd::Load(lanes[2]);
+  Vec c3 = Simd::Load(lanes[3]);
+  const Vec m0 = Simd::Set1(PhiloxRandom::kPhiloxM4x32A);
+  const Vec m1 = Simd::Set1(PhiloxRandom::kPhiloxM4x32B);
+  uint32_t key0 = gen.key()[0];
+  uint32_t key1 = gen.key()[1];
+  for (int round = 0; round < 10; ++round) {
+    const Vec lo0 = Simd::MulLo(c0, m0);
+    const Vec hi0 = Simd::MulHi(c0, m0);
+    const Vec lo1 = Simd::MulLo(c2, m1);
+    const Vec hi1 = Simd::MulHi(c2, m1);
+    c0 = Simd::Xor(Simd::Xor(hi1, c1), Simd::Set1(key0));
+    c1 = lo1;
+    c2 = Simd::Xor(Simd::Xor(hi0, c3), Simd::Set1(key1));
+    c3 = lo0;
+    key0 += PhiloxRandom::kPhiloxW32A;
+    key1 += PhiloxRandom::kPhiloxW32B;
+  }
+  Simd::Store(lanes[0], c0);
+  Simd::Store(lanes[1], c1);
+  Simd::Store(lanes[2], c2);
+  Simd::Store(lanes[3], c3);
+  for (int i = 0; i < kLanes; ++i) {
+    for (int k = 0; k < 4; ++k) output[4 * i + k] = lanes[k][i];
+  }
+}
+
+#if defined(__AVX512F__)
+struct PhiloxAvx512 {
+  typedef __m512i Vec;
+  static constexpr int kLanes = 16;
+  static Vec Set1(uint32_t x) { return _mm512_set1_epi32(x); }
+  static Vec Load(const uint32_t* p) { return _mm512_load_si512(p); }
+  static void Store(uint32_t* p, Vec v) { _mm512_store_si512(p, v); }
+  static Vec Xor(Vec a, Vec b) { return _mm512_xor_si512(a, b); }
+  static Vec MulLo(Vec a, Vec b) { return _mm512_mullo_epi32(a, b); }
+  // The products of the even lanes, and of the odd lanes shifted down, are
+  // computed in 64 bits.
+  static Vec MulHi(Vec a, Vec b) {
+    const Vec even = _mm512_mul_epu32(a, b);
+    const Vec odd =
+        _mm512_mul_epu32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32));
+    return _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+  }
+};
+#endif  // __AVX512F__
+
+#if defined(__AVX2__)
+struct PhiloxAvx2 {
+  typedef __m256i Vec;
+  static constexpr int kLanes = 8;
+  static Vec Set1(uint32_t x) { return _mm256_set1_epi32(x); }
+  static Vec Load(const uint32_t* p) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void Store(uint32_t* p, Vec v) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  static Vec Xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+  static Vec MulLo(Vec a, Vec b) { return _mm256_mullo_epi32(a, b); }
+  static Vec MulHi(Vec a, Vec b) {
+    const Vec even = _mm256_mul_epu32(a, b);
+    const Vec odd =
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+  }
+};
+#endif  // __AVX2__
+
+}  // namespace internal
+
+// Writes the results of `num_groups` successive invocations of `*gen` to
+// `output[0, 4 * num_groups)`, and advances `*gen` past them, as if
+// `(*gen)()` was called `num_groups` times. With AVX-512 or AVX2, 16 or 8
+// counters are evaluated at once in SIMD lanes. The results are identical to
+// those of the scalar implementation.
+inline void GeneratePhiloxBatch(PhiloxRandom* gen, int64_t num_groups,
+                                uint32_t* output) {
+  int64_t group = 0;
+#if defined(__AVX512F__)
+  for (; group + internal::PhiloxAvx512::kLanes <= num_groups;
+       group += internal::PhiloxAvx512::kLanes) {
+    internal::GeneratePhiloxLanes<internal::PhiloxAvx512>(*gen,
+                                                          output + 4 * group);
+    gen->Skip(internal::PhiloxAvx512::kLanes);
+  }
+#endif  // __AVX512F__
+#if defined(__AVX2__)
+  for (; group + internal::PhiloxAvx2::kLanes <= num_groups;
+       group += internal::PhiloxAvx2::kLanes) {
+    internal::GeneratePhiloxLanes<internal::PhiloxAvx2>(*gen,
+                                                        output + 4 * group);
+    gen->Skip(internal::PhiloxAvx2::kLanes);
+  }
+#endif  // __AVX2__
+  for (; group < num_groups; ++group) {
+    const PhiloxRandom::ResultType result = (*gen)();
+    for (int k = 0; k < 4; ++k) output[4 * group + k] = result[k];
+  }
+}
+
+// A generator that returns precomputed results of PhiloxRandom, e.g. from
+// GeneratePhiloxBatch(), so that they can be transformed by the distributions
+// of random_distributions.h.
+class PrecomputedPhiloxRandom {
+ public:
+  using ResultType = PhiloxRandom::ResultType;
+  using ResultElementType = PhiloxRandom::ResultElementType;
+  static constexpr int kResultElementCount = PhiloxRandom::kResultElementCount;
+  static constexpr int kElementCost = PhiloxRandom::kElementCost;
+
+  // `results` must outlive this object, and hold 4 values per invocation.
+  explicit PrecomputedPhiloxRandom(const uint32_t* results)
+      : next_(results) {}
+
+  ResultType operator()() {
+    ResultType result;
+    for (int k = 0; k < kResultElementCount; ++k) result[k] = next_[k];
+    next_ += kResultElementCount;
+    return result;
+  }
+
+ private:
+  const uint32_t* next_;
+};
+
+}  // namespace random
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_LIB_RANDOM_PHILOX_RANDOM_BATCH_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/lib/random/philox_random_batch.h"
 #include "tensorflow/core/lib/random/philox_random_test_utils.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/random/random_distributions.h"
@@ -68,6 +69,34 @@ TEST(PhiloxRandomTest, SkipMatchTest) {
   }
 }
 
+// This test checks that GeneratePhiloxBatch() produces the same samples as
+// PhiloxRandom, including when the low word of the counter wraps around.
+TEST(PhiloxRandomTest, BatchMatchTest) {
+  uint64 test_seed = GetTestSeed();
+  constexpr int kCount = PhiloxRandom::kResultElementCount;
+  for (uint64 skip : {0ull, 0xfffffff0ull, 0xfffffffaull, 0x1fffffffdull}) {
+    for (int num_groups : {0, 1, 7, 8, 9, 16, 17, 31, 100}) {
+      PhiloxRandom batch_gen(test_seed, skip);
+      batch_gen.Skip(skip);
+      PhiloxRandom gen = batch_gen;
+
+      std::vector<uint32> batch(num_groups * kCount);
+      GeneratePhiloxBatch(&batch_gen, num_groups, batch.data());
+      for (int i = 0; i < num_groups; ++i) {
+        PhiloxRandom::ResultType samples = gen();
+        for (int j = 0; j < kCount; ++j) {
+          ASSERT_EQ(samples[j], batch[i * kCount + j])
+              << "skip " << skip << ", group " << i << " of " << num_groups;
+        }
+      }
+      // Both generators are advanced by the same number of groups.
+      for (int j = 0; j < kCount; ++j) {
+        EXPECT_EQ(gen.counter()[j], batch_gen.counter()[j]);
+      }
+    }
+  }
+}
+
 }  // namespace
 }  // namespace random
 }  // namespace tensorflow
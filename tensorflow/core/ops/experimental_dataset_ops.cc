@@ -105,6 +105,38 @@ REGISTER_OP("ExperimentalAutoShardDataset")
                                                            "output_types"))
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("BucketBySequenceLengthDataset")
+    .Input("input_dataset: variant")
+    .Input("other_arguments: Targuments")
+    .Input("bucket_boundaries: int64")
+    .Input("bucket_batch_sizes: int64")
+    .Input("padded_shapes: N * int64")
+    .Input("padding_values: Toutput_types")
+    .Input("drop_remainder: bool")
+    .Output("handle: variant")
+    .Attr("element_length_func: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("pad_to_bucket_boundary: bool = false")
+    .Attr("Toutput_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .Attr("N: int >= 1")
+    .Attr("metadata: string = ''")
+    .SetTypeConstructor(full_type::VariadicTensorContainer(TFT_DATASET,
+                                                           "Toutput_types"))
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      std::vector<shape_inference::ShapeHandle> shapes;
+      shape_inference::ShapeHandle unused;
+      // `bucket_boundaries` and `bucket_batch_sizes` should be vectors.
+      TF_RETURN_IF_ERROR(c->input("bucket_boundaries", &shapes));
+      TF_RETURN_IF_ERROR(c->WithRank(shapes[0], 1, &unused));
+      TF_RETURN_IF_ERROR(c->input("bucket_batch_sizes", &shapes));
+      TF_RETURN_IF_ERROR(c->WithRank(shapes[0], 1, &unused));
+      // `drop_remainder` should be a scalar.
+      TF_RETURN_IF_ERROR(
+          c->WithRank(c->input(c->num_inputs() - 1), 0, &unused));
+      return shape_inference::ScalarShape(c);
+    });
+
 REGISTER_OP("BytesProducedStatsDataset")
     .Input("input_dataset: variant")
     .Input("tag: string")
@@ -524,6 +556,29 @@ REGISTER_OP("ExperimentalIgnoreErrorsDataset")
                                                            "output_types"))
     .SetShapeFn(shape_inference::ScalarShape);
 
+REGISTER_OP("IndexedTFRecordDataset")
+    .Input("filenames: string")
+    .Input("num_shards: int64")
+    .Input("shard_index: int64")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Output("handle: variant")
+    .Attr("shuffle: bool = false")
+    .Attr("metadata: string = ''")
+    .SetDoNotOptimize()  // TODO(b/123753214): See comment in dataset_ops.cc.
+    .SetTypeConstructor(full_type::UnaryTensorContainer(TFT_DATASET,
+                                                        TFT_STRING))
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle unused;
+      // `filenames` must be a scalar or a vector.
+      TF_RETURN_IF_ERROR(c->WithRankAtMost(c->input(0), 1, &unused));
+      // num_shards, shard_index, seed, and seed2 should be scalars.
+      for (int i = 1; i < 5; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      return shape_inference::ScalarShape(c);
+    });
+
 REGISTER_OP("IteratorGetDevice")
     .Input("resource: resource")
     .Output("device: string")
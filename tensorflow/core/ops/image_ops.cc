@@ -511,6 +511,36 @@ REGISTER_OP("DecodeAndCropJpeg")
       return OkStatus();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("BatchDecodeAndResizeJpeg")
+    .Input("contents: string")
+    .Input("size: int32")
+    .Input("crop_windows: int32")
+    .Attr("channels: int = 3")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("dct_method: string = ''")
+    .Output("images: uint8")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle contents;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &contents));
+      ShapeHandle crop_windows;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &crop_windows));
+      DimensionHandle batch_dim;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(contents, 0),
+                                  c->Dim(crop_windows, 0), &batch_dim));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_windows, 1), 4, &unused));
+
+      int32_t channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels != 1 && channels != 3) {
+        return errors::InvalidArgument("channels must be 1 or 3, got ",
+                                       channels);
+      }
+      return SetOutputToSizedImage(c, batch_dim, 1 /* size_input_idx */,
+                                   c->MakeDim(channels));
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -876,6 +906,33 @@ REGISTER_OP("ExtractGlimpseV2")
 
 // --------------------------------------------------------------------------
 
+namespace {
+
+// Shape function of CropAndResize and _FusedCropAndResize.
+Status CropAndResizeShapeFn(InferenceContext* c) {
+  // Get inputs and validate ranks.
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &input));
+  ShapeHandle boxes;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &boxes));
+  ShapeHandle box_ind;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &box_ind));
+
+  // boxes[0] and box_ind[0] are both num_boxes.
+  DimensionHandle num_boxes_dim;
+  TF_RETURN_IF_ERROR(
+      c->Merge(c->Dim(boxes, 0), c->Dim(box_ind, 0), &num_boxes_dim));
+
+  // boxes.dim(1) is 4.
+  DimensionHandle unused;
+  TF_RETURN_IF_ERROR(c->WithValue(c->Dim(boxes, 1), 4, &unused));
+
+  return SetOutputToSizedImage(c, num_boxes_dim, 3 /* size_input_idx */,
+                               c->Dim(input, 3));
+}
+
+}  // namespace
+
 REGISTER_OP("CropAndResize")
     .Input("image: T")
     .Input("boxes: float")
@@ -885,27 +942,32 @@ REGISTER_OP("CropAndResize")
     .Attr("T: {uint8, uint16, int8, int16, int32, int64, half, float, double}")
     .Attr("method: {'bilinear', 'nearest'} = 'bilinear'")
     .Attr("extrapolation_value: float = 0")
-    .SetShapeFn([](InferenceContext* c) {
-      // Get inputs and validate ranks.
-      ShapeHandle input;
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &input));
-      ShapeHandle boxes;
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &boxes));
-      ShapeHandle box_ind;
-      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &box_ind));
-
-      // boxes[0] and box_ind[0] are both num_boxes.
-      DimensionHandle num_boxes_dim;
-      TF_RETURN_IF_ERROR(
-          c->Merge(c->Dim(boxes, 0), c->Dim(box_ind, 0), &num_boxes_dim));
+    .SetShapeFn(CropAndResizeShapeFn);
 
-      // boxes.dim(1) is 4.
-      DimensionHandle unused;
-      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(boxes, 1), 4, &unused));
-
-      return SetOutputToSizedImage(c, num_boxes_dim, 3 /* size_input_idx */,
-                                   c->Dim(input, 3));
-    });
+REGISTER_OP("_FusedCropAndResize")
+    .Input("image: T")
+    .Input("boxes: float")
+    .Input("box_ind: int32")
+    .Input("crop_size: int32")
+    .Input("mean: float")
+    .Input("scale: float")
+    .Output("crops: out_type")
+    .Attr("T: {uint8, uint16, half, float}")
+    .Attr("out_type: {float, half, bfloat16} = DT_FLOAT")
+    .Attr("method: {'bilinear', 'nearest'} = 'bilinear'")
+    .Attr("extrapolation_value: float = 0")
+    .Attr("divide_by_scale: bool = false")
+    .SetShapeFn(CropAndResizeShapeFn)
+    .Doc(R"doc(
+Internal CropAndResize operation: reserved for internal use.
+
+Computes `cast((CropAndResize(image) - mean) * scale, out_type)`, or divides by
+`scale` if `divide_by_scale` is true, where `mean` and `scale` hold either one
+value or one value per channel.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
 
 REGISTER_OP("CropAndResizeGradImage")
     .Input("grads: float")
@@ -63,6 +63,7 @@ REGISTER_OP("SaveV2")
     .Input("shape_and_slices: string")
     .Input("tensors: dtypes")
     .Attr("dtypes: list(type)")
+    .Attr("async_write: bool = false")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
@@ -147,6 +148,36 @@ REGISTER_OP("MergeV2Checkpoints")
       return OkStatus();
     });
 
+REGISTER_OP("SaveDeltaCheckpoint")
+    .Input("prefix: string")
+    .Input("base_prefix: string")
+    .Input("tensor_names: string")
+    .Input("variables: N * resource")
+    .Attr("N: int >= 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &s));
+      TF_RETURN_IF_ERROR(
+          c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
+      return OkStatus();
+    });
+
+REGISTER_OP("CompactDeltaCheckpoint")
+    .Input("prefix: string")
+    .Input("output_prefix: string")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 0, &unused));
+      return OkStatus();
+    });
+
 REGISTER_OP("Save")
     .Input("filename: string")
     .Input("tensor_names: string")
@@ -383,6 +383,17 @@ REGISTER_OP("AnonymousHashTable")
     .SetIsStateful()
     .SetShapeFn(ScalarOutput);
 
+REGISTER_OP("MemmappedHashTable")
+    .Output("table_handle: resource")
+    .Attr("filename: string")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: {int64, string}")
+    .Attr("value_dtype: {int32, int64, float, double}")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput);
+
 REGISTER_OP("MutableHashTable")
     .Output("table_handle: Ref(string)")
     .Attr("container: string = ''")
@@ -440,6 +451,27 @@ REGISTER_OP("AnonymousMutableHashTableOfTensors")
     .SetIsStateful()
     .SetShapeFn(MutableHashTableOfTensorsShapeFn);
 
+REGISTER_OP("ShardedMutableHashTable")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("value_shape: shape = {}")
+    .Attr("num_shards: int >= 1 = 64")
+    .SetIsStateful()
+    .SetShapeFn(MutableHashTableOfTensorsShapeFn);
+
+REGISTER_OP("AnonymousShardedMutableHashTable")
+    .Output("table_handle: resource")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("value_shape: shape = {}")
+    .Attr("num_shards: int >= 1 = 64")
+    .SetIsStateful()
+    .SetShapeFn(MutableHashTableOfTensorsShapeFn);
+
 REGISTER_OP("MutableDenseHashTable")
     .Input("empty_key: key_dtype")
     .Output("table_handle: Ref(string)")
@@ -1015,6 +1015,52 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 1")
+    .Attr("fused_ops: list(string)")
+    .Attr("operands: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      // Arguments are scalars or have the shape of the output. An argument of
+      // unknown rank may be either.
+      ShapeHandle out;
+      bool has_unknown_rank = false;
+      for (int i = 0; i < c->num_inputs(); ++i) {
+        ShapeHandle arg = c->input(i);
+        if (!c->RankKnown(arg)) {
+          has_unknown_rank = true;
+        } else if (c->Rank(arg) > 0) {
+          if (!out.Handle()) {
+            out = arg;
+          } else {
+            TF_RETURN_IF_ERROR(c->Merge(out, arg, &out));
+          }
+        }
+      }
+      if (!out.Handle()) {
+        out = has_unknown_rank ? c->UnknownShape() : c->Scalar();
+      }
+      c->set_output(0, out);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Evaluates a chain of elementwise operations in a single pass.
+
+The operations are specified by `fused_ops`, a list of TF op names (e.g.
+"Mul", "AddV2", "Tanh"), that are evaluated in order. The operands of
+`fused_ops[i]` are `operands[2 * i]` and `operands[2 * i + 1]`, where an
+operand `k < num_args` refers to `args[k]`, and `k >= num_args` refers to the
+result of `fused_ops[k - num_args]`. The second operand of unary ops is -1.
+The output is the result of the last op.
+
+Each of `args` must be a scalar, or have the shape of the output.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
@@ -30,6 +30,7 @@ limitations under the License.
 namespace tensorflow {
 
 using shape_inference::DimensionHandle;
+using shape_inference::DimensionOrConstant;
 using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
@@ -1228,6 +1229,293 @@ REGISTER_OP("LogSoftmax")
 
 // --------------------------------------------------------------------------
 
+REGISTER_OP("_FusedLayerNorm")
+    .Input("x: T")
+    .Input("scale: T")
+    .Input("offset: T")
+    .Input("residual: num_residual * T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("num_residual: int >= 0 = 0")
+    .Attr("epsilon: float = 0.001")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &x));
+      for (int i = 3; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(c->Merge(x, c->input(i), &x));
+      }
+      DimensionHandle depth = c->Dim(x, -1);
+      for (int i = 1; i <= 2; ++i) {
+        ShapeHandle vec;
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &vec));
+        TF_RETURN_IF_ERROR(c->Merge(depth, c->Dim(vec, 0), &depth));
+      }
+      ShapeHandle y;
+      TF_RETURN_IF_ERROR(c->ReplaceDim(x, -1, depth, &y));
+      c->set_output(0, y);
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Normalizes `x + residual` over its last dimension.
+
+Computes `(z - mean(z)) * rsqrt(variance(z) + epsilon) * scale + offset` with
+`z = x + residual`, or `z = x` if there is no residual, where the mean and the
+variance are taken over the last dimension, as in the Keras
+LayerNormalization layer. `scale` and `offset` are vectors whose size is the
+last dimension of `x`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedGelu")
+    .Input("features: T")
+    .Output("activations: T")
+    .Attr("T: {float}")
+    .Attr("approximate: bool = false")
+    .SetShapeFn(shape_inference::UnchangedShape)
+    .Doc(R"doc(
+Computes the Gaussian error linear unit of `features`.
+
+Computes `0.5 * x * (1 + erf(x / sqrt(2)))`, or its tanh approximation
+`0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))` if `approximate`
+is true, as `tf.nn.gelu`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedScaledMaskedSoftmax")
+    .Input("logits: T")
+    .Input("mask: num_mask * T")
+    .Output("softmax: T")
+    .Attr("T: {float}")
+    .Attr("num_mask: int >= 0 = 0")
+    .Attr("scale: float = 1.0")
+    .SetShapeFn([](InferenceContext* c) {
+      return shape_inference::UnchangedShapeWithRankAtLeast(c, 1);
+    })
+    .Doc(R"doc(
+Computes `softmax(logits * scale + mask)` over the last dimension.
+
+The optional `mask` is additive, like the attention masks of transformer
+models, and must broadcast to the shape of `logits`. Every dimension of
+`mask` is either 1 or the corresponding dimension of `logits`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+// --------------------------------------------------------------------------
+
+namespace {
+
+// Returns the number of blocks of `block_size` channels for `channels`.
+Status NumChannelBlocks(InferenceContext* c, DimensionHandle channels,
+                        int64_t block_size, DimensionHandle* num_blocks) {
+  if (!c->ValueKnown(channels)) {
+    *num_blocks = c->UnknownDim();
+    return OkStatus();
+  }
+  *num_blocks =
+      c->MakeDim(MathUtil::CeilOfRatio(c->Value(channels), block_size));
+  return OkStatus();
+}
+
+// Sets the output of an op with a [batch, blocks, rows, cols, block] input and
+// NHWC-style `ksize`, `strides` and `dilations`, where `filter_rows` and
+// `filter_cols` are the spatial dimensions of the window.
+Status NchwcWindowedOutputShape(InferenceContext* c,
+                                DimensionHandle output_blocks,
+                                DimensionOrConstant filter_rows,
+                                DimensionOrConstant filter_cols,
+                                const std::vector<int32>& strides,
+                                const std::vector<int32>& dilations) {
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+  if (strides.size() != 4 || strides[0] != 1 || strides[3] != 1) {
+    return errors::InvalidArgument(
+        "strides must be of the form [1, rows, cols, 1]");
+  }
+  if (dilations.size() != 4 || dilations[0] != 1 || dilations[3] != 1) {
+    return errors::InvalidArgument(
+        "dilations must be of the form [1, rows, cols, 1]");
+  }
+  Padding padding;
+  TF_RETURN_IF_ERROR(c->GetAttr("padding", &padding));
+  DimensionHandle output_rows, output_cols;
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDimsV2(
+      c, c->Dim(input, 2), filter_rows, dilations[1], strides[1], padding,
+      /*padding_before=*/0, /*padding_after=*/0, &output_rows));
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDimsV2(
+      c, c->Dim(input, 3), filter_cols, dilations[2], strides[2], padding,
+      /*padding_before=*/0, /*padding_after=*/0, &output_cols));
+  c->set_output(0, c->MakeShape({c->Dim(input, 0), output_blocks, output_rows,
+                                 output_cols, c->Dim(input, 4)}));
+  return OkStatus();
+}
+
+}  // namespace
+
+REGISTER_OP("_NhwcToNchwc")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("block_size: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &x));
+      int64_t block_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("block_size", &block_size));
+      DimensionHandle num_blocks;
+      TF_RETURN_IF_ERROR(
+          NumChannelBlocks(c, c->Dim(x, 3), block_size, &num_blocks));
+      c->set_output(0, c->MakeShape({c->Dim(x, 0), num_blocks, c->Dim(x, 1),
+                                     c->Dim(x, 2), c->MakeDim(block_size)}));
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Converts `x` from the NHWC layout to the blocked NCHWc layout.
+
+The output has the shape `[batch, ceil(channels / block_size), rows, cols,
+block_size]`, where the channels of each block are contiguous. The channels
+are padded with zeros to a multiple of `block_size`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_NchwcToNhwc")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("channels: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &x));
+      int64_t channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      c->set_output(0, c->MakeShape({c->Dim(x, 0), c->Dim(x, 2), c->Dim(x, 3),
+                                     c->MakeDim(channels)}));
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Converts `x` from the blocked NCHWc layout to the NHWC layout.
+
+The NHWC output keeps the first `channels` channels of `x`, which drops the
+padding added by `_NhwcToNchwc`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_NchwcFilter")
+    .Input("filter: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("block_size: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle filter;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &filter));
+      int64_t block_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("block_size", &block_size));
+      DimensionHandle input_blocks, output_blocks;
+      TF_RETURN_IF_ERROR(
+          NumChannelBlocks(c, c->Dim(filter, 2), block_size, &input_blocks));
+      TF_RETURN_IF_ERROR(
+          NumChannelBlocks(c, c->Dim(filter, 3), block_size, &output_blocks));
+      DimensionHandle block = c->MakeDim(block_size);
+      c->set_output(0, c->MakeShape({output_blocks, input_blocks,
+                                     c->Dim(filter, 0), c->Dim(filter, 1),
+                                     block, block}));
+      return OkStatus();
+    })
+    .Doc(R"doc(
+Converts a Conv2D filter to the layout of the `_NchwcConv2D` filters.
+
+The `[rows, cols, in_channels, out_channels]` input becomes
+`[ceil(out_channels / block_size), ceil(in_channels / block_size), rows, cols,
+block_size, block_size]`, where the last dimension indexes the output channels
+of a block. The channels are padded with zeros to a multiple of `block_size`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_NchwcConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("bias: num_bias * T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("num_bias: int >= 0 = 0")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("dilations: list(int) = [1, 1, 1, 1]")
+    .Attr("activation: {'None', 'Relu', 'Relu6'} = 'None'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input, filter;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 6, &filter));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(input, 1), c->Dim(filter, 1), &unused));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(input, 4), c->Dim(filter, 4), &unused));
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(input, 4), c->Dim(filter, 5), &unused));
+      std::vector<int32> strides, dilations;
+      TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+      TF_RETURN_IF_ERROR(c->GetAttr("dilations", &dilations));
+      return NchwcWindowedOutputShape(c, c->Dim(filter, 0), c->Dim(filter, 2),
+                                      c->Dim(filter, 3), strides, dilations);
+    })
+    .Doc(R"doc(
+Computes a 2-D convolution in the blocked NCHWc layout.
+
+`input` has the shape `[batch, in_blocks, rows, cols, block]` and `filter` is
+the output of `_NchwcFilter`. The output has the shape `[batch, out_blocks,
+out_rows, out_cols, block]`. `strides` and `dilations` have the NHWC layout of
+the Conv2D attributes. The optional `bias`, whose size is
+`out_blocks * block`, and `activation` are applied to the output.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_NchwcPool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("pooling_type: {'MAX', 'AVG'}")
+    .Attr("ksize: list(int)")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle input;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+      std::vector<int32> ksize, strides;
+      TF_RETURN_IF_ERROR(c->GetAttr("ksize", &ksize));
+      TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+      if (ksize.size() != 4 || ksize[0] != 1 || ksize[3] != 1) {
+        return errors::InvalidArgument(
+            "ksize must be of the form [1, rows, cols, 1]");
+      }
+      return NchwcWindowedOutputShape(c, c->Dim(input, 1), ksize[1], ksize[2],
+                                      strides, /*dilations=*/{1, 1, 1, 1});
+    })
+    .Doc(R"doc(
+Computes a max or average pooling in the blocked NCHWc layout.
+
+`ksize` and `strides` have the NHWC layout of the MaxPool and AvgPool
+attributes. Like AvgPool, the average pooling excludes the padding.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
+// --------------------------------------------------------------------------
+
 REGISTER_OP("SoftmaxCrossEntropyWithLogits")
     .Input("features: T")
     .Input("labels: T")
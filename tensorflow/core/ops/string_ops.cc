@@ -218,6 +218,7 @@ REGISTER_OP("StringSplitV2")
     .Output("values: string")
     .Output("shape: int64")
     .Attr("maxsplit: int = -1")
+    .Attr("output_views: bool = false")
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
       TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &unused));
@@ -388,6 +389,7 @@ REGISTER_OP("StringNGrams")
     .Attr("pad_width: int")
     .Attr("preserve_short_sequences: bool")
     .Attr("Tsplits: {int32, int64} = DT_INT64")
+    .Attr("output_views: bool = false")
     .Input("data: string")
     .Input("data_splits: Tsplits")
     .Output("ngrams: string")
@@ -1173,4 +1173,89 @@ REGISTER_OP("ResourceApplyPowerSign")
     .Attr("use_locking: bool = false")
     .SetShapeFn(ApplyPowerSignShapeFn</*is_resource=*/true>);
 
+// Shape function of the multi-tensor variants of the dense resource apply ops,
+// whose inputs are `kNumSlots` lists of `N` variables (the variables and their
+// slots), followed by `kNumScalars` scalar hyperparameters, and the list of `N`
+// gradients.
+template <int kNumSlots, int kNumScalars>
+static Status FusedResourceApplyShapeFn(InferenceContext* c) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  for (int i = 0; i < kNumScalars; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(kNumSlots * n + i), 0, &unused));
+  }
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = ShapeOrHandleShape</*is_resource=*/true>(c, i);
+    for (int slot = 1; slot < kNumSlots; ++slot) {
+      TF_RETURN_IF_ERROR(c->Merge(
+          s, ShapeOrHandleShape</*is_resource=*/true>(c, slot * n + i), &s));
+    }
+    TF_RETURN_IF_ERROR(
+        c->Merge(s, c->input(kNumSlots * n + kNumScalars + i), &s));
+  }
+  return OkStatus();
+}
+
+REGISTER_OP("_FusedResourceApplyGradientDescent")
+    .Input("var: N * resource")
+    .Input("alpha: T")
+    .Input("delta: N * T")
+    .Attr("T: numbertype")
+    .Attr("N: int >= 1")
+    .Attr("use_locking: bool = false")
+    .SetShapeFn(FusedResourceApplyShapeFn</*kNumSlots=*/1, /*kNumScalars=*/1>)
+    .Doc(R"doc(
+Internal ResourceApplyGradientDescent operation: reserved for internal use.
+
+Applies the update of ResourceApplyGradientDescent to `N` variables at once.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedResourceApplyAdagrad")
+    .Input("var: N * resource")
+    .Input("accum: N * resource")
+    .Input("lr: T")
+    .Input("grad: N * T")
+    .Attr("T: numbertype")
+    .Attr("N: int >= 1")
+    .Attr("use_locking: bool = false")
+    .Attr("update_slots: bool = true")
+    .SetShapeFn(FusedResourceApplyShapeFn</*kNumSlots=*/2, /*kNumScalars=*/1>)
+    .Doc(R"doc(
+Internal ResourceApplyAdagrad operation: reserved for internal use.
+
+Applies the update of ResourceApplyAdagrad to `N` variables at once.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("_FusedResourceApplyAdam")
+    .Input("var: N * resource")
+    .Input("m: N * resource")
+    .Input("v: N * resource")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("T: numbertype")
+    .Attr("N: int >= 1")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn(FusedResourceApplyShapeFn</*kNumSlots=*/3, /*kNumScalars=*/6>)
+    .Doc(R"doc(
+Internal ResourceApplyAdam operation: reserved for internal use.
+
+Applies the update of ResourceApplyAdam to `N` variables at once.
+
+Do not invoke this operator directly in Python. A fusion optimization is
+expected to create these operators.
+)doc");
+
 }  // namespace tensorflow
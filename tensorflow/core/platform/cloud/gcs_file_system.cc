@@ -148,6 +148,11 @@ constexpr char kAppendMode[] = "GCS_APPEND_MODE";
 // default as the multiple API calls required add a risk of stranding temporary
 // objects.
 constexpr char kComposeAppend[] = "compose";
+// Each range of a parallel read should take about this long, to amortize the
+// latency of a request.
+constexpr double kParallelReadTargetChunkSecs = 2.0;
+// Weight of the latest measurement in the estimated throughput of a range.
+constexpr double kParallelReadThroughputDecay = 0.25;
 
 Status GetTmpFilename(string* filename) {
   *filename = io::GetTempFilename("");
@@ -803,12 +808,18 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   if (GetEnvVar(kMaxStaleness, strings::safe_strtou64, &value)) {
     max_staleness = value;
   }
+  GetEnvVar(kCacheShards, strings::safe_strto32, &block_cache_shards_);
+  if (GetEnvVar(kCachePrefetchBlocks, strings::safe_strtou64, &value)) {
+    block_cache_prefetch_blocks_ = value;
+  }
   if (!make_default_cache) {
     max_bytes = 0;
   }
   VLOG(1) << "GCS cache max size = " << max_bytes << " ; "
           << "block size = " << block_size_ << " ; "
-          << "max staleness = " << max_staleness;
+          << "max staleness = " << max_staleness << " ; "
+          << "shards = " << block_cache_shards_ << " ; "
+          << "prefetch blocks = " << block_cache_prefetch_blocks_;
   file_block_cache_ = MakeFileBlockCache(block_size_, max_bytes, max_staleness);
   // Apply overrides for the stat cache max age and max entries, if provided.
   uint64 stat_cache_max_age = kStatCacheDefaultMaxAge;
@@ -929,6 +940,14 @@ GcsFileSystem::GcsFileSystem(bool make_default_cache) {
   } else {
     compose_append_ = false;
   }
+
+  int32_t parallel_reads = 1;
+  GetEnvVar(kParallelReads, strings::safe_strto32, &parallel_reads);
+  size_t parallel_read_min_chunk_size = kDefaultParallelReadMinChunkSize;
+  if (GetEnvVar(kParallelReadMinChunkSize, strings::safe_strtou64, &value)) {
+    parallel_read_min_chunk_size = value * 1024 * 1024;
+  }
+  SetParallelReads(parallel_reads, parallel_read_min_chunk_size);
 }
 
 GcsFileSystem::GcsFileSystem(
@@ -958,6 +977,13 @@ GcsFileSystem::GcsFileSystem(
       compose_append_(compose_append),
       additional_header_(additional_header) {}
 
+GcsFileSystem::~GcsFileSystem() {
+  // Destroy the block cache first, since its readahead threads read from GCS
+  // through this filesystem.
+  mutex_lock l(block_cache_lock_);
+  file_block_cache_.reset();
+}
+
 Status GcsFileSystem::NewRandomAccessFile(
     const string& fname, TransactionToken* token,
     std::unique_ptr<RandomAccessFile>* result) {
@@ -1030,13 +1056,17 @@ void GcsFileSystem::ResetFileBlockCache(size_t block_size_bytes,
 // A helper function to build a FileBlockCache for GcsFileSystem.
 std::unique_ptr<FileBlockCache> GcsFileSystem::MakeFileBlockCache(
     size_t block_size, size_t max_bytes, uint64 max_staleness) {
+  RamFileBlockCache::Options options;
+  options.num_shards = block_cache_shards_;
+  options.prefetch_blocks = block_cache_prefetch_blocks_;
   std::unique_ptr<FileBlockCache> file_block_cache(new RamFileBlockCache(
       block_size, max_bytes, max_staleness,
       [this](const string& filename, size_t offset, size_t n, char* buffer,
              size_t* bytes_transferred) {
         return LoadBufferFromGCS(filename, offset, n, buffer,
                                  bytes_transferred);
-      }));
+      },
+      options));
 
   // Check if cache is enabled here to avoid unnecessary mutex contention.
   cache_enabled_ = file_block_cache->IsCacheEnabled();
@@ -1055,24 +1085,30 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
   profiler::TraceMe activity(
       [fname]() { return absl::StrCat("LoadBufferFromGCS ", fname); });
 
-  std::unique_ptr<HttpRequest> request;
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(&request),
-                                  "when reading gs://", bucket, "/", object);
+  size_t bytes_read;
+  if (parallel_reads_ > 1 && n >= 2 * parallel_read_min_chunk_size_) {
+    TF_RETURN_IF_ERROR(LoadBufferFromGCSInParallel(fname, bucket, object,
+                                                   offset, n, buffer,
+                                                   &bytes_read));
+  } else {
+    std::unique_ptr<HttpRequest> request;
+    TF_RETURN_IF_ERROR(
+        CreateRangedReadRequest(bucket, object, offset, n, buffer, &request));
 
-  request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket, "/",
-                                  request->EscapeString(object)));
-  request->SetRange(offset, offset + n - 1);
-  request->SetResultBufferDirect(buffer, n);
-  request->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
+    if (stats_ != nullptr) {
+      stats_->RecordBlockLoadRequest(fname, offset);
+    }
 
-  if (stats_ != nullptr) {
-    stats_->RecordBlockLoadRequest(fname, offset);
-  }
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading gs://",
+                                    bucket, "/", object);
 
-  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading gs://",
-                                  bucket, "/", object);
+    bytes_read = request->GetResultBufferDirectBytesTransferred();
+    if (stats_ != nullptr) {
+      stats_->RecordBlockRetrieved(fname, offset, bytes_read);
+    }
 
-  size_t bytes_read = request->GetResultBufferDirectBytesTransferred();
+    throttle_.RecordResponse(bytes_read);
+  }
   *bytes_transferred = bytes_read;
   VLOG(1) << "Successful read of gs://" << bucket << "/" << object << " @ "
           << offset << " of size: " << bytes_read;
@@ -1080,12 +1116,6 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
     return profiler::TraceMeEncode({{"block_size", bytes_read}});
   });
 
-  if (stats_ != nullptr) {
-    stats_->RecordBlockRetrieved(fname, offset, bytes_read);
-  }
-
-  throttle_.RecordResponse(bytes_read);
-
   if (bytes_read < n) {
     // Check stat cache to see if we encountered an interrupted read.
     GcsFileStat stat;
@@ -1103,6 +1133,153 @@ Status GcsFileSystem::LoadBufferFromGCS(const string& fname, size_t offset,
   return OkStatus();
 }
 
+Status GcsFileSystem::CreateRangedReadRequest(
+    const string& bucket, const string& object, size_t offset, size_t n,
+    char* buffer, std::unique_ptr<HttpRequest>* request) {
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(CreateHttpRequest(request),
+                                  "when reading gs://", bucket, "/", object);
+
+  (*request)->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket, "/",
+                                     (*request)->EscapeString(object)));
+  (*request)->SetRange(offset, offset + n - 1);
+  (*request)->SetResultBufferDirect(buffer, n);
+  (*request)->SetTimeouts(timeouts_.connect, timeouts_.idle, timeouts_.read);
+  return OkStatus();
+}
+
+Status GcsFileSystem::LoadBufferFromGCSInParallel(
+    const string& fname, const string& bucket, const string& object,
+    size_t offset, size_t n, char* buffer, size_t* bytes_transferred) {
+  const size_t chunk_size = GetParallelReadChunkSize(n);
+  const size_t num_chunks = (n + chunk_size - 1) / chunk_size;
+  std::vector<std::unique_ptr<HttpRequest>> requests(num_chunks);
+  std::vector<Status> statuses(num_chunks);
+  std::vector<size_t> chunk_bytes(num_chunks, 0);
+
+  mutex mu;
+  condition_variable done_cv;
+  int num_in_flight = 0;
+  // Set once a range fails or ends before its end, after which the following
+  // ranges aren't requested.
+  bool stop = false;
+  // Requests are created in order on this thread, and sent concurrently by the
+  // pool, at most `parallel_reads_` at a time.
+  Status status;
+  size_t num_started = 0;
+  for (; num_started < num_chunks; ++num_started) {
+    const size_t chunk = num_started;
+    {
+      mutex_lock l(mu);
+      while (num_in_flight >= parallel_reads_ && !stop) {
+        done_cv.wait(l);
+      }
+      if (stop) break;
+      ++num_in_flight;
+    }
+    const size_t chunk_offset = offset + chunk * chunk_size;
+    const size_t chunk_n = std::min(chunk_size, n - chunk * chunk_size);
+    status = CreateRangedReadRequest(bucket, object, chunk_offset, chunk_n,
+                                     buffer + chunk * chunk_size,
+                                     &requests[chunk]);
+    if (!status.ok()) {
+      mutex_lock l(mu);
+      --num_in_flight;
+      break;
+    }
+    if (stats_ != nullptr) {
+      stats_->RecordBlockLoadRequest(fname, chunk_offset);
+    }
+    parallel_read_pool_->Schedule([&, chunk, chunk_offset, chunk_n]() {
+      const uint64 start_micros = Env::Default()->NowMicros();
+      Status send_status = requests[chunk]->Send();
+      const size_t bytes_read =
+          requests[chunk]->GetResultBufferDirectBytesTransferred();
+      requests[chunk].reset();
+      if (send_status.ok()) {
+        if (stats_ != nullptr) {
+          stats_->RecordBlockRetrieved(fname, chunk_offset, bytes_read);
+        }
+        throttle_.RecordResponse(bytes_read);
+        if (bytes_read == chunk_n) {
+          RecordParallelReadThroughput(
+              bytes_read, Env::Default()->NowMicros() - start_micros);
+        }
+      }
+      mutex_lock l(mu);
+      statuses[chunk] = std::move(send_status);
+      chunk_bytes[chunk] = bytes_read;
+      if (!statuses[chunk].ok() || bytes_read < chunk_n) stop = true;
+      --num_in_flight;
+      done_cv.notify_all();
+    });
+  }
+  {
+    mutex_lock l(mu);
+    while (num_in_flight > 0) {
+      done_cv.wait(l);
+    }
+  }
+  TF_RETURN_IF_ERROR(status);
+
+  // The ranges are contiguous in `buffer`, up to the first incomplete one.
+  *bytes_transferred = 0;
+  for (size_t chunk = 0; chunk < num_started; ++chunk) {
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(statuses[chunk], " when reading gs://",
+                                    bucket, "/", object);
+    *bytes_transferred += chunk_bytes[chunk];
+    if (chunk_bytes[chunk] < std::min(chunk_size, n - chunk * chunk_size)) {
+      for (size_t next = chunk + 1; next < num_started; ++next) {
+        if (chunk_bytes[next] > 0) {
+          return errors::Internal(strings::Printf(
+              "File contents are inconsistent for file: %s @ %lu.",
+              fname.c_str(), offset));
+        }
+      }
+      break;
+    }
+  }
+  return OkStatus();
+}
+
+size_t GcsFileSystem::GetParallelReadChunkSize(size_t n) {
+  size_t chunk_size = parallel_read_min_chunk_size_;
+  {
+    mutex_lock l(parallel_read_mu_);
+    chunk_size =
+        std::max(chunk_size, static_cast<size_t>(parallel_read_bytes_per_sec_ *
+                                                 kParallelReadTargetChunkSecs));
+  }
+  // Smaller ranges keep all the concurrent requests busy.
+  const size_t even_chunk_size = (n + parallel_reads_ - 1) / parallel_reads_;
+  return std::max(std::min(chunk_size, even_chunk_size),
+                  parallel_read_min_chunk_size_);
+}
+
+void GcsFileSystem::RecordParallelReadThroughput(size_t bytes,
+                                                 uint64 elapsed_micros) {
+  if (elapsed_micros == 0) return;
+  const double bytes_per_sec = bytes * 1e6 / elapsed_micros;
+  mutex_lock l(parallel_read_mu_);
+  if (parallel_read_bytes_per_sec_ == 0) {
+    parallel_read_bytes_per_sec_ = bytes_per_sec;
+  } else {
+    parallel_read_bytes_per_sec_ +=
+        kParallelReadThroughputDecay *
+        (bytes_per_sec - parallel_read_bytes_per_sec_);
+  }
+}
+
+void GcsFileSystem::SetParallelReads(int max_parallel_reads,
+                                     size_t min_chunk_size) {
+  parallel_reads_ = std::max(max_parallel_reads, 1);
+  parallel_read_min_chunk_size_ = std::max<size_t>(min_chunk_size, 1);
+  parallel_read_pool_.reset();
+  if (parallel_reads_ > 1) {
+    parallel_read_pool_ = std::make_unique<thread::ThreadPool>(
+        Env::Default(), "gcs_parallel_read", parallel_reads_);
+  }
+}
+
 /// Initiates a new upload session.
 Status GcsFileSystem::CreateNewUploadSession(
     uint64 start_offset, const std::string& object_to_upload,
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_GCS_FILE_SYSTEM_H_
 
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -30,8 +31,10 @@ limitations under the License.
 #include "tensorflow/core/platform/cloud/gcs_throttle.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
 #include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/retrying_file_system.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
@@ -62,6 +65,24 @@ constexpr size_t kDefaultMaxCacheSize = 0;
 // will be evicted on the next read.
 constexpr char kMaxStaleness[] = "GCS_READ_CACHE_MAX_STALENESS";
 constexpr uint64 kDefaultMaxStaleness = 0;
+// The environment variable that sets the number of independently locked shards
+// of the LRU cache of blocks read from GCS. The blocks of a file are all in the
+// same shard, and each shard holds an equal part of the cache.
+constexpr char kCacheShards[] = "GCS_READ_CACHE_SHARDS";
+// The environment variable that sets the number of blocks read ahead in the
+// background once a file is read sequentially through the block cache. A value
+// of 0 (the default) disables readahead.
+constexpr char kCachePrefetchBlocks[] = "GCS_READ_CACHE_PREFETCH_BLOCKS";
+// The environment variable that sets the maximum number of concurrent ranged
+// requests used by a single large read. A value of 1 (the default) disables
+// parallel reads.
+constexpr char kParallelReads[] = "GCS_PARALLEL_READS";
+// The environment variable that overrides the minimum size of the ranges of a
+// parallel read. Reads shorter than twice this size use a single request.
+// Specified in MB.
+constexpr char kParallelReadMinChunkSize[] =
+    "GCS_PARALLEL_READ_MIN_CHUNK_SIZE_MB";
+constexpr size_t kDefaultParallelReadMinChunkSize = 8 * 1024 * 1024;
 
 // Helper function to extract an environment variable and convert it into a
 // value of type T.
@@ -141,6 +162,7 @@ class GcsFileSystem : public FileSystem {
                 const std::unordered_set<string>& allowed_locations,
                 std::pair<const string, const string>* additional_header,
                 bool compose_append);
+  ~GcsFileSystem() override;
 
   TF_USE_FILESYSTEM_METHODS_WITH_NO_TRANSACTION_SUPPORT;
 
@@ -232,6 +254,11 @@ class GcsFileSystem : public FileSystem {
     return matching_paths_cache_->max_entries();
   }
 
+  int parallel_reads() const { return parallel_reads_; }
+  size_t parallel_read_min_chunk_size() const {
+    return parallel_read_min_chunk_size_;
+  }
+
   /// Structure containing the information for timeouts related to accessing the
   /// GCS APIs.
   ///
@@ -284,6 +311,15 @@ class GcsFileSystem : public FileSystem {
   void ResetFileBlockCache(size_t block_size_bytes, size_t max_bytes,
                            uint64 max_staleness_secs);
 
+  /// \brief Splits reads of at least `2 * min_chunk_size` bytes from GCS into
+  /// up to `max_parallel_reads` concurrent ranged requests.
+  ///
+  /// The size of the ranges adapts to the observed throughput of the requests,
+  /// so that each takes long enough to amortize its latency, and is at least
+  /// `min_chunk_size`. A `max_parallel_reads` of 1 disables parallel reads.
+  /// Must be called before any read.
+  void SetParallelReads(int max_parallel_reads, size_t min_chunk_size);
+
  protected:
   virtual std::unique_ptr<FileBlockCache> MakeFileBlockCache(
       size_t block_size, size_t max_bytes, uint64 max_staleness);
@@ -407,6 +443,25 @@ class GcsFileSystem : public FileSystem {
   // Clear all the caches related to the file with name `filename`.
   void ClearFileCaches(const string& fname);
 
+  /// Creates a request for the range of `n` bytes at `offset` of `bucket` and
+  /// `object`, to be written to `buffer`. The caller must call `Send()`.
+  Status CreateRangedReadRequest(const string& bucket, const string& object,
+                                 size_t offset, size_t n, char* buffer,
+                                 std::unique_ptr<HttpRequest>* request);
+
+  /// Implements `LoadBufferFromGCS()` with concurrent ranged requests.
+  Status LoadBufferFromGCSInParallel(const string& fname,
+                                     const string& bucket,
+                                     const string& object, size_t offset,
+                                     size_t n, char* buffer,
+                                     size_t* bytes_transferred);
+
+  /// Returns the size of the ranges of a parallel read of `n` bytes.
+  size_t GetParallelReadChunkSize(size_t n);
+
+  /// Updates the estimated throughput of a ranged request.
+  void RecordParallelReadThroughput(size_t bytes, uint64 elapsed_micros);
+
   mutex mu_;
   std::unique_ptr<AuthProvider> auth_provider_ TF_GUARDED_BY(mu_);
   std::shared_ptr<HttpRequest::Factory> http_request_factory_;
@@ -415,6 +470,10 @@ class GcsFileSystem : public FileSystem {
   // Reads smaller than block_size_ will trigger a read of block_size_.
   uint64 block_size_;
 
+  // Sharding and readahead of the block cache, used by MakeFileBlockCache().
+  int block_cache_shards_ = 1;
+  size_t block_cache_prefetch_blocks_ = 0;
+
   // block_cache_lock_ protects the file_block_cache_ pointer (Note that
   // FileBlockCache instances are themselves threadsafe).
   mutex block_cache_lock_;
@@ -438,6 +497,15 @@ class GcsFileSystem : public FileSystem {
 
   GcsStatsInterface* stats_ = nullptr;  // Not owned.
 
+  // Parallel reads, see SetParallelReads().
+  int parallel_reads_ = 1;
+  size_t parallel_read_min_chunk_size_ = kDefaultParallelReadMinChunkSize;
+  std::unique_ptr<thread::ThreadPool> parallel_read_pool_;
+  mutex parallel_read_mu_;
+  // Estimated throughput of one ranged request in bytes per second, or 0 if
+  // no parallel read completed yet.
+  double parallel_read_bytes_per_sec_ TF_GUARDED_BY(parallel_read_mu_) = 0;
+
   // Additional header material to be transmitted with all GCS requests
   std::unique_ptr<std::pair<const string, const string>> additional_header_;
 
@@ -106,6 +106,99 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_NoBlockCache) {
   EXPECT_EQ("6789", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_ParallelReads) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-2\n"
+           "Timeouts: 5 1 20\n",
+           "012"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 3-5\n"
+           "Timeouts: 5 1 20\n",
+           "345"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 6-8\n"
+           "Timeouts: 5 1 20\n",
+           "678"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 9-11\n"
+           "Timeouts: 5 1 20\n",
+           "9")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  fs.SetParallelReads(2 /* max parallel reads */, 3 /* min chunk size */);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  char scratch[6];
+  StringPiece result;
+
+  // Each read is split into two ranges, which are reassembled in order.
+  TF_EXPECT_OK(file->Read(0, sizeof(scratch), &result, scratch));
+  EXPECT_EQ("012345", result);
+
+  // The second range of the second read is past the end of the file.
+  EXPECT_TRUE(errors::IsOutOfRange(
+      file->Read(sizeof(scratch), sizeof(scratch), &result, scratch)));
+  EXPECT_EQ("6789", result);
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_ParallelReadsFailure) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-2\n"
+           "Timeouts: 5 1 20\n",
+           "012"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/random_access.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 3-5\n"
+           "Timeouts: 5 1 20\n",
+           "", errors::Unavailable("important HTTP error 503"), 503)});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      std::unique_ptr<ZoneProvider>(new FakeZoneProvider), 0 /* block size */,
+      0 /* max bytes */, 0 /* max staleness */, 0 /* stat cache max age */,
+      0 /* stat cache max entries */, 0 /* matching paths cache max age */,
+      0 /* matching paths cache max entries */, kTestRetryConfig,
+      kTestTimeoutConfig, *kAllowedLocationsDefault,
+      nullptr /* gcs additional header */, false /* compose append */);
+  fs.SetParallelReads(2 /* max parallel reads */, 3 /* min chunk size */);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(
+      fs.NewRandomAccessFile("gs://bucket/random_access.txt", nullptr, &file));
+
+  char scratch[6];
+  StringPiece result;
+  const Status status = file->Read(0, sizeof(scratch), &result, scratch);
+  EXPECT_TRUE(errors::IsUnavailable(status));
+  EXPECT_TRUE(absl::StrContains(status.error_message(),
+                                "important HTTP error 503"));
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_Buffered) {
   std::vector<HttpRequest*> requests({
       new FakeHttpRequest(
@@ -3685,6 +3778,20 @@ TEST(GcsFileSystemTest, OverrideCacheParameters) {
   EXPECT_EQ(40, fs5.timeouts().write);
 }
 
+TEST(GcsFileSystemTest, OverrideParallelReadParameters) {
+  GcsFileSystem fs1;
+  EXPECT_EQ(1, fs1.parallel_reads());
+  EXPECT_EQ(8 * 1024 * 1024, fs1.parallel_read_min_chunk_size());
+
+  setenv("GCS_PARALLEL_READS", "16", 1);
+  setenv("GCS_PARALLEL_READ_MIN_CHUNK_SIZE_MB", "4", 1);
+  GcsFileSystem fs2;
+  EXPECT_EQ(16, fs2.parallel_reads());
+  EXPECT_EQ(4 * 1024 * 1024, fs2.parallel_read_min_chunk_size());
+  unsetenv("GCS_PARALLEL_READS");
+  unsetenv("GCS_PARALLEL_READ_MIN_CHUNK_SIZE_MB");
+}
+
 TEST(GcsFileSystemTest, CreateHttpRequest) {
   std::vector<HttpRequest*> requests(
       {// IsDirectory is checking whether there are children objects.
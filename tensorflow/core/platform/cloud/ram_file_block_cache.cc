@@ -14,13 +14,82 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
+
+#include <algorithm>
 #include <cstring>
 #include <memory>
+
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/env.h"
 
 namespace tensorflow {
 
+namespace {
+
+// The number of consecutive sequential reads of a file after which the
+// following blocks are read ahead.
+constexpr int kSequentialReadsBeforePrefetch = 2;
+
+// Returns the number of shards to use, such that each shard can hold at least
+// one block.
+int NumShards(int num_shards, size_t block_size, size_t max_bytes) {
+  if (block_size == 0 || num_shards <= 1) return 1;
+  return static_cast<int>(std::max<size_t>(
+      1, std::min<size_t>(num_shards, max_bytes / block_size)));
+}
+
+}  // namespace
+
+RamFileBlockCache::RamFileBlockCache(size_t block_size, size_t max_bytes,
+                                     uint64 max_staleness,
+                                     BlockFetcher block_fetcher,
+                                     const Options& options, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      max_staleness_(max_staleness),
+      block_fetcher_(std::move(block_fetcher)),
+      env_(env),
+      num_shards_(NumShards(options.num_shards, block_size, max_bytes)),
+      shard_max_bytes_(max_bytes / num_shards_),
+      prefetch_blocks_(
+          block_size > 0
+              ? std::min(options.prefetch_blocks,
+                         shard_max_bytes_ / block_size / 2)
+              : 0),
+      shards_(new Shard[num_shards_]) {
+  if (max_staleness_ > 0) {
+    pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
+                                            [this] { Prune(); }));
+  }
+  if (IsCacheEnabled() && prefetch_blocks_ > 0) {
+    prefetch_pool_ = std::make_unique<thread::ThreadPool>(
+        env_, "TF_prefetch_FBC", std::max(options.prefetch_threads, 1));
+  }
+  VLOG(1) << "GCS file block cache is "
+          << (IsCacheEnabled() ? "enabled" : "disabled") << " ; "
+          << "shards = " << num_shards_ << " ; "
+          << "prefetch blocks = " << prefetch_blocks_;
+}
+
+RamFileBlockCache::~RamFileBlockCache() {
+  // Destroying prefetch_pool_ blocks until the scheduled readaheads return,
+  // which they do after at most one more fetch once stop_prefetch_ is set.
+  stop_prefetch_ = true;
+  prefetch_pool_.reset();
+  if (pruning_thread_) {
+    stop_pruning_thread_.Notify();
+    // Destroying pruning_thread_ will block until Prune() receives the above
+    // notification and returns.
+    pruning_thread_.reset();
+  }
+}
+
+RamFileBlockCache::Shard* RamFileBlockCache::GetShard(
+    const string& filename) const {
+  if (num_shards_ == 1) return &shards_[0];
+  return &shards_[std::hash<string>()(filename) % num_shards_];
+}
+
 bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
   mutex_lock l(block->mu);
   if (block->state != FetchState::FINISHED) {
@@ -31,52 +100,67 @@ bool RamFileBlockCache::BlockNotStale(const std::shared_ptr<Block>& block) {
 }
 
 std::shared_ptr<RamFileBlockCache::Block> RamFileBlockCache::Lookup(
-    const Key& key) {
-  mutex_lock lock(mu_);
-  auto entry = block_map_.find(key);
-  if (entry != block_map_.end()) {
+    Shard* shard, const Key& key, bool prefetch) {
+  mutex_lock lock(shard->mu);
+  auto entry = shard->block_map.find(key);
+  if (entry != shard->block_map.end()) {
     if (BlockNotStale(entry->second)) {
-      if (cache_stats_ != nullptr) {
-        cache_stats_->RecordCacheHitBlockSize(entry->second->data.size());
+      if (!prefetch) {
+        Block* block = entry->second.get();
+        if (cache_stats_ != nullptr) {
+          cache_stats_->RecordCacheHitBlockSize(block->data.size());
+        }
+        ++hits_;
+        if (block->prefetched && !block->accessed) {
+          ++prefetch_hits_;
+        }
+        block->accessed = true;
       }
       return entry->second;
     } else {
       // Remove the stale block and continue.
-      RemoveFile_Locked(key.first);
+      RemoveFile_Locked(shard, key.first);
     }
   }
 
   // Insert a new empty block, setting the bookkeeping to sentinel values
   // in order to update them as appropriate.
   auto new_entry = std::make_shared<Block>();
-  lru_list_.push_front(key);
-  lra_list_.push_front(key);
-  new_entry->lru_iterator = lru_list_.begin();
-  new_entry->lra_iterator = lra_list_.begin();
+  shard->lru_list.push_front(key);
+  shard->lra_list.push_front(key);
+  new_entry->lru_iterator = shard->lru_list.begin();
+  new_entry->lra_iterator = shard->lra_list.begin();
   new_entry->timestamp = env_->NowSeconds();
-  block_map_.emplace(std::make_pair(key, new_entry));
+  new_entry->prefetched = prefetch;
+  new_entry->accessed = !prefetch;
+  if (prefetch) {
+    ++prefetched_;
+  } else {
+    ++misses_;
+  }
+  shard->block_map.emplace(std::make_pair(key, new_entry));
   return new_entry;
 }
 
 // Remove blocks from the cache until we do not exceed our maximum size.
-void RamFileBlockCache::Trim() {
-  while (!lru_list_.empty() && cache_size_ > max_bytes_) {
-    RemoveBlock(block_map_.find(lru_list_.back()));
+void RamFileBlockCache::Trim(Shard* shard) {
+  while (!shard->lru_list.empty() && shard->cache_size > shard_max_bytes_) {
+    RemoveBlock(shard, shard->block_map.find(shard->lru_list.back()));
   }
 }
 
 /// Move the block to the front of the LRU list if it isn't already there.
-Status RamFileBlockCache::UpdateLRU(const Key& key,
+Status RamFileBlockCache::UpdateLRU(Shard* shard, const Key& key,
                                     const std::shared_ptr<Block>& block) {
-  mutex_lock lock(mu_);
+  mutex_lock lock(shard->mu);
   if (block->timestamp == 0) {
     // The block was evicted from another thread. Allow it to remain evicted.
     return OkStatus();
   }
-  if (block->lru_iterator != lru_list_.begin()) {
-    lru_list_.erase(block->lru_iterator);
-    lru_list_.push_front(key);
-    block->lru_iterator = lru_list_.begin();
+  if (block->lru_iterator != shard->lru_list.begin()) {
+    shard->lru_list.erase(block->lru_iterator);
+    shard->lru_list.push_front(key);
+    block->lru_iterator = shard->lru_list.begin();
   }
 
   // Check for inconsistent state. If there is a block later in the same file
@@ -85,35 +169,35 @@ Status RamFileBlockCache::UpdateLRU(const Key& key,
   // incomplete reads may still go undetected.
   if (block->data.size() < block_size_) {
     Key fmax = std::make_pair(key.first, std::numeric_limits<size_t>::max());
-    auto fcmp = block_map_.upper_bound(fmax);
-    if (fcmp != block_map_.begin() && key < (--fcmp)->first) {
+    auto fcmp = shard->block_map.upper_bound(fmax);
+    if (fcmp != shard->block_map.begin() && key < (--fcmp)->first) {
       return errors::Internal("Block cache contents are inconsistent.");
     }
   }
 
-  Trim();
+  Trim(shard);
 
   return OkStatus();
 }
 
-Status RamFileBlockCache::MaybeFetch(const Key& key,
+Status RamFileBlockCache::MaybeFetch(Shard* shard, const Key& key,
                                      const std::shared_ptr<Block>& block) {
   bool downloaded_block = false;
   auto reconcile_state =
-      gtl::MakeCleanup([this, &downloaded_block, &key, &block] {
-        // Perform this action in a cleanup callback to avoid locking mu_ after
-        // locking block->mu.
+      gtl::MakeCleanup([this, shard, &downloaded_block, &key, &block] {
+        // Perform this action in a cleanup callback to avoid locking the
+        // shard after locking block->mu.
         if (downloaded_block) {
-          mutex_lock l(mu_);
+          mutex_lock l(shard->mu);
           // Do not update state if the block is already to be evicted.
           if (block->timestamp != 0) {
             // Use capacity() instead of size() to account for all  memory
             // used by the cache.
-            cache_size_ += block->data.capacity();
+            shard->cache_size += block->data.capacity();
             // Put to beginning of LRA list.
-            lra_list_.erase(block->lra_iterator);
-            lra_list_.push_front(key);
-            block->lra_iterator = lra_list_.begin();
+            shard->lra_list.erase(block->lra_iterator);
+            shard->lra_list.push_front(key);
+            block->lra_iterator = shard->lra_list.begin();
             block->timestamp = env_->NowSeconds();
           }
         }
@@ -176,6 +260,7 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     // fetcher without breaking it up into blocks.
     return block_fetcher_(filename, offset, n, buffer, bytes_transferred);
   }
+  Shard* shard = GetShard(filename);
   // Calculate the block-aligned start and end of the read.
   size_t start = block_size_ * (offset / block_size_);
   size_t finish = block_size_ * ((offset + n) / block_size_);
@@ -183,15 +268,16 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     finish += block_size_;
   }
   size_t total_bytes_transferred = 0;
+  bool eof = false;
   // Now iterate through the blocks, reading them one at a time.
   for (size_t pos = start; pos < finish; pos += block_size_) {
     Key key = std::make_pair(filename, pos);
     // Look up the block, fetching and inserting it if necessary, and update the
     // LRU iterator for the key and block.
-    std::shared_ptr<Block> block = Lookup(key);
+    std::shared_ptr<Block> block = Lookup(shard, key, /*prefetch=*/false);
     DCHECK(block) << "No block for key " << key.first << "@" << key.second;
-    TF_RETURN_IF_ERROR(MaybeFetch(key, block));
-    TF_RETURN_IF_ERROR(UpdateLRU(key, block));
+    TF_RETURN_IF_ERROR(MaybeFetch(shard, key, block));
+    TF_RETURN_IF_ERROR(UpdateLRU(shard, key, block));
     // Copy the relevant portion of the block into the result buffer.
     const auto& data = block->data;
     if (offset >= pos + data.size()) {
@@ -220,83 +306,179 @@ Status RamFileBlockCache::Read(const string& filename, size_t offset, size_t n,
     }
     if (data.size() < block_size_) {
       // The block was a partial block and thus signals EOF at its upper bound.
+      eof = true;
       break;
     }
   }
   *bytes_transferred = total_bytes_transferred;
+  if (prefetch_pool_) {
+    MaybePrefetch(shard, filename, offset, total_bytes_transferred, finish,
+                  eof);
+  }
   return OkStatus();
 }
 
+void RamFileBlockCache::MaybePrefetch(Shard* shard, const string& filename,
+                                      size_t offset, size_t n, size_t finish,
+                                      bool eof) {
+  size_t prefetch_start;
+  size_t prefetch_end;
+  {
+    mutex_lock lock(shard->mu);
+    ReadState& state = shard->read_states[filename];
+    if (offset == state.next_offset) {
+      ++state.sequential_reads;
+    } else {
+      state.sequential_reads = 0;
+      state.prefetch_limit = 0;
+    }
+    state.next_offset = offset + n;
+    if (eof || state.prefetching ||
+        state.sequential_reads < kSequentialReadsBeforePrefetch) {
+      return;
+    }
+    prefetch_start = std::max(finish, state.prefetch_limit);
+    prefetch_end = finish + prefetch_blocks_ * block_size_;
+    if (prefetch_start >= prefetch_end) {
+      return;
+    }
+    state.prefetch_limit = prefetch_end;
+    state.prefetching = true;
+  }
+  prefetch_pool_->Schedule([this, shard, filename, prefetch_start,
+                            prefetch_end]() {
+    Prefetch(shard, filename, prefetch_start, prefetch_end);
+  });
+}
+
+void RamFileBlockCache::Prefetch(Shard* shard, const string& filename,
+                                 size_t start, size_t end) {
+  // Blocks are fetched in order so that no block is added past the end of the
+  // file, which UpdateLRU() would report as an inconsistency.
+  for (size_t pos = start; pos < end && !stop_prefetch_; pos += block_size_) {
+    Key key = std::make_pair(filename, pos);
+    std::shared_ptr<Block> block = Lookup(shard, key, /*prefetch=*/true);
+    // Errors are left to the reads that request the block, which fetch it
+    // again.
+    if (!MaybeFetch(shard, key, block).ok() ||
+        !UpdateLRU(shard, key, block).ok() ||
+        block->data.size() < block_size_) {
+      break;
+    }
+  }
+  mutex_lock lock(shard->mu);
+  auto it = shard->read_states.find(filename);
+  if (it != shard->read_states.end()) {
+    it->second.prefetching = false;
+  }
+}
+
 bool RamFileBlockCache::ValidateAndUpdateFileSignature(const string& filename,
                                                        int64_t file_signature) {
-  mutex_lock lock(mu_);
-  auto it = file_signature_map_.find(filename);
-  if (it != file_signature_map_.end()) {
+  Shard* shard = GetShard(filename);
+  mutex_lock lock(shard->mu);
+  auto it = shard->file_signature_map.find(filename);
+  if (it != shard->file_signature_map.end()) {
     if (it->second == file_signature) {
       return true;
     }
     // Remove the file from cache if the signatures don't match.
-    RemoveFile_Locked(filename);
+    RemoveFile_Locked(shard, filename);
     it->second = file_signature;
     return false;
   }
-  file_signature_map_[filename] = file_signature;
+  shard->file_signature_map[filename] = file_signature;
   return true;
 }
 
 size_t RamFileBlockCache::CacheSize() const {
-  mutex_lock lock(mu_);
-  return cache_size_;
+  size_t cache_size = 0;
+  for (int i = 0; i < num_shards_; ++i) {
+    mutex_lock lock(shards_[i].mu);
+    cache_size += shards_[i].cache_size;
+  }
+  return cache_size;
+}
+
+RamFileBlockCache::Stats RamFileBlockCache::GetStats() const {
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.prefetched = prefetched_;
+  stats.prefetch_hits = prefetch_hits_;
+  stats.prefetch_wasted = prefetch_wasted_;
+  return stats;
 }
 
 void RamFileBlockCache::Prune() {
   while (!WaitForNotificationWithTimeout(&stop_pruning_thread_, 1000000)) {
-    mutex_lock lock(mu_);
     uint64 now = env_->NowSeconds();
-    while (!lra_list_.empty()) {
-      auto it = block_map_.find(lra_list_.back());
-      if (now - it->second->timestamp <= max_staleness_) {
-        // The oldest block is not yet expired. Come back later.
-        break;
+    for (int i = 0; i < num_shards_; ++i) {
+      Shard* shard = &shards_[i];
+      mutex_lock lock(shard->mu);
+      while (!shard->lra_list.empty()) {
+        auto it = shard->block_map.find(shard->lra_list.back());
+        if (now - it->second->timestamp <= max_staleness_) {
+          // The oldest block is not yet expired. Come back later.
+          break;
+        }
+        // We need to make a copy of the filename here, since it could
+        // otherwise be used within RemoveFile_Locked after `it` is deleted.
+        RemoveFile_Locked(shard, std::string(it->first.first));
       }
-      // We need to make a copy of the filename here, since it could otherwise
-      // be used within RemoveFile_Locked after `it` is deleted.
-      RemoveFile_Locked(std::string(it->first.first));
     }
   }
 }
 
 void RamFileBlockCache::Flush() {
-  mutex_lock lock(mu_);
-  block_map_.clear();
-  lru_list_.clear();
-  lra_list_.clear();
-  cache_size_ = 0;
+  for (int i = 0; i < num_shards_; ++i) {
+    Shard* shard = &shards_[i];
+    mutex_lock lock(shard->mu);
+    for (const auto& entry : shard->block_map) {
+      if (entry.second->prefetched && !entry.second->accessed) {
+        ++prefetch_wasted_;
+      }
+      // Keep blocks still referenced by a read or a readahead from being
+      // reinserted in UpdateLRU.
+      entry.second->timestamp = 0;
+    }
+    shard->block_map.clear();
+    shard->lru_list.clear();
+    shard->lra_list.clear();
+    shard->read_states.clear();
+    shard->cache_size = 0;
+  }
 }
 
 void RamFileBlockCache::RemoveFile(const string& filename) {
-  mutex_lock lock(mu_);
-  RemoveFile_Locked(filename);
+  Shard* shard = GetShard(filename);
+  mutex_lock lock(shard->mu);
+  RemoveFile_Locked(shard, filename);
+  shard->read_states.erase(filename);
 }
 
-void RamFileBlockCache::RemoveFile_Locked(const string& filename) {
+void RamFileBlockCache::RemoveFile_Locked(Shard* shard,
+                                          const string& filename) {
   Key begin = std::make_pair(filename, 0);
-  auto it = block_map_.lower_bound(begin);
-  while (it != block_map_.end() && it->first.first == filename) {
+  auto it = shard->block_map.lower_bound(begin);
+  while (it != shard->block_map.end() && it->first.first == filename) {
     auto next = std::next(it);
-    RemoveBlock(it);
+    RemoveBlock(shard, it);
     it = next;
   }
 }
 
-void RamFileBlockCache::RemoveBlock(BlockMap::iterator entry) {
+void RamFileBlockCache::RemoveBlock(Shard* shard, BlockMap::iterator entry) {
   // This signals that the block is removed, and should not be inadvertently
   // reinserted into the cache in UpdateLRU.
   entry->second->timestamp = 0;
-  lru_list_.erase(entry->second->lru_iterator);
-  lra_list_.erase(entry->second->lra_iterator);
-  cache_size_ -= entry->second->data.capacity();
-  block_map_.erase(entry);
+  if (entry->second->prefetched && !entry->second->accessed) {
+    ++prefetch_wasted_;
+  }
+  shard->lru_list.erase(entry->second->lru_iterator);
+  shard->lra_list.erase(entry->second->lra_iterator);
+  shard->cache_size -= entry->second->data.capacity();
+  shard->block_map.erase(entry);
 }
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 #define TENSORFLOW_CORE_PLATFORM_CLOUD_RAM_FILE_BLOCK_CACHE_H_
 
+#include <atomic>
 #include <functional>
 #include <list>
 #include <map>
@@ -30,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/stringpiece.h"
 #include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -38,6 +40,10 @@ namespace tensorflow {
 ///
 /// This class should be shared by read-only random access files on a remote
 /// filesystem (e.g. GCS).
+///
+/// Files are spread over independently locked shards, and blocks following a
+/// sequential read can be fetched ahead of time in background threads (see
+/// `Options`).
 class RamFileBlockCache : public FileBlockCache {
  public:
   /// The callback executed when a block is not found in the cache, and needs to
@@ -50,29 +56,47 @@ class RamFileBlockCache : public FileBlockCache {
                                size_t* bytes_transferred)>
       BlockFetcher;
 
+  /// Options for lock sharding and readahead.
+  struct Options {
+    /// The number of shards. The blocks of a file are all in the same shard,
+    /// each shard has its own lock and LRU list, and holds at most
+    /// `max_bytes / num_shards` bytes. The number of shards is reduced so that
+    /// each shard can hold at least one block.
+    int num_shards = 1;
+    /// The number of blocks fetched in the background past the end of a read,
+    /// once a file is read sequentially. 0 disables readahead. Readahead is
+    /// limited to half of the capacity of a shard.
+    size_t prefetch_blocks = 0;
+    /// The number of threads fetching blocks ahead of time.
+    int prefetch_threads = 4;
+  };
+
+  /// Counters of cache activity since the cache was created.
+  struct Stats {
+    /// Blocks requested by a read and found in the cache (possibly while
+    /// still being fetched).
+    int64_t hits = 0;
+    /// Blocks requested by a read and not found in the cache.
+    int64_t misses = 0;
+    /// Blocks added to the cache by readahead.
+    int64_t prefetched = 0;
+    /// Blocks added by readahead and later requested by a read.
+    int64_t prefetch_hits = 0;
+    /// Blocks added by readahead and evicted or removed before any read
+    /// requested them.
+    int64_t prefetch_wasted = 0;
+  };
+
   RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
                     BlockFetcher block_fetcher, Env* env = Env::Default())
-      : block_size_(block_size),
-        max_bytes_(max_bytes),
-        max_staleness_(max_staleness),
-        block_fetcher_(block_fetcher),
-        env_(env) {
-    if (max_staleness_ > 0) {
-      pruning_thread_.reset(env_->StartThread(ThreadOptions(), "TF_prune_FBC",
-                                              [this] { Prune(); }));
-    }
-    VLOG(1) << "GCS file block cache is "
-            << (IsCacheEnabled() ? "enabled" : "disabled");
-  }
+      : RamFileBlockCache(block_size, max_bytes, max_staleness,
+                          std::move(block_fetcher), Options(), env) {}
 
-  ~RamFileBlockCache() override {
-    if (pruning_thread_) {
-      stop_pruning_thread_.Notify();
-      // Destroying pruning_thread_ will block until Prune() receives the above
-      // notification and returns.
-      pruning_thread_.reset();
-    }
-  }
+  RamFileBlockCache(size_t block_size, size_t max_bytes, uint64 max_staleness,
+                    BlockFetcher block_fetcher, const Options& options,
+                    Env* env = Env::Default());
+
+  ~RamFileBlockCache() override;
 
   /// Read `n` bytes from `filename` starting at `offset` into `out`. This
   /// method will return:
@@ -96,14 +120,13 @@ class RamFileBlockCache : public FileBlockCache {
   // exist before. If the signature changes, update the existing signature with
   // the new one and remove the file from cache.
   bool ValidateAndUpdateFileSignature(const string& filename,
-                                      int64_t file_signature) override
-      TF_LOCKS_EXCLUDED(mu_);
+                                      int64_t file_signature) override;
 
   /// Remove all cached blocks for `filename`.
-  void RemoveFile(const string& filename) override TF_LOCKS_EXCLUDED(mu_);
+  void RemoveFile(const string& filename) override;
 
   /// Remove all cached data.
-  void Flush() override TF_LOCKS_EXCLUDED(mu_);
+  void Flush() override;
 
   /// Accessors for cache parameters.
   size_t block_size() const override { return block_size_; }
@@ -111,7 +134,7 @@ class RamFileBlockCache : public FileBlockCache {
   uint64 max_staleness() const override { return max_staleness_; }
 
   /// The current size (in bytes) of the cache.
-  size_t CacheSize() const override TF_LOCKS_EXCLUDED(mu_);
+  size_t CacheSize() const override;
 
   // Returns true if the cache is enabled. If false, the BlockFetcher callback
   // is always executed during Read.
@@ -119,6 +142,13 @@ class RamFileBlockCache : public FileBlockCache {
     return block_size_ > 0 && max_bytes_ > 0;
   }
 
+  /// The number of shards and of readahead blocks actually used.
+  int num_shards() const { return num_shards_; }
+  size_t prefetch_blocks() const { return prefetch_blocks_; }
+
+  /// Returns the counters of cache activity.
+  Stats GetStats() const;
+
  private:
   /// The size of the blocks stored in the LRU cache, as well as the size of the
   /// reads from the underlying filesystem.
@@ -131,6 +161,11 @@ class RamFileBlockCache : public FileBlockCache {
   const BlockFetcher block_fetcher_;
   /// The Env from which we read timestamps.
   Env* const env_;  // not owned
+  /// The number of shards, and the maximum number of bytes in each shard.
+  const int num_shards_;
+  const size_t shard_max_bytes_;
+  /// The number of blocks to read ahead of a sequential read.
+  const size_t prefetch_blocks_;
 
   /// \brief The key type for the file block cache.
   ///
@@ -158,14 +193,14 @@ class RamFileBlockCache : public FileBlockCache {
   /// was cached, a coordination lock, and state & condition variables.
   ///
   /// Thread safety:
-  /// The iterator and timestamp fields should only be accessed while holding
-  /// the block-cache-wide mu_ instance variable. The state variable should only
-  /// be accessed while holding the Block's mu lock. The data vector should only
-  /// be accessed after state == FINISHED, and it should never be modified.
+  /// The iterator, timestamp, prefetched and accessed fields should only be
+  /// accessed while holding the mu lock of the block's Shard. The state
+  /// variable should only be accessed while holding the Block's mu lock. The
+  /// data vector should only be accessed after state == FINISHED, and it should
+  /// never be modified.
   ///
-  /// In order to prevent deadlocks, never grab the block-cache-wide mu_ lock
-  /// AFTER grabbing any block's mu lock. It is safe to grab mu without locking
-  /// mu_.
+  /// In order to prevent deadlocks, never grab a shard's mu lock AFTER grabbing
+  /// any block's mu lock. It is safe to grab mu without locking the shard.
   struct Block {
     /// The block data.
     std::vector<char> data;
@@ -175,6 +210,10 @@ class RamFileBlockCache : public FileBlockCache {
     std::list<Key>::iterator lra_iterator;
     /// The timestamp (seconds since epoch) at which the block was cached.
     uint64 timestamp;
+    /// True if the block was added to the cache by readahead.
+    bool prefetched = false;
+    /// True once a read requested the block.
+    bool accessed = false;
     /// Mutex to guard state variable
     mutex mu;
     /// The state of the block.
@@ -188,32 +227,97 @@ class RamFileBlockCache : public FileBlockCache {
   /// The block map is an ordered map from Key to Block.
   typedef std::map<Key, std::shared_ptr<Block>> BlockMap;
 
+  /// \brief The reads of a file, used to detect sequential access.
+  struct ReadState {
+    /// The offset following the last read of the file.
+    size_t next_offset = 0;
+    /// The number of consecutive reads that started at the end of the previous
+    /// read. A first read at offset 0 counts as sequential.
+    int sequential_reads = 0;
+    /// The end of the range already scheduled for readahead.
+    size_t prefetch_limit = 0;
+    /// True while a readahead of the file is scheduled or running.
+    bool prefetching = false;
+  };
+
+  /// \brief A shard of the cache, holding the blocks of a subset of the files.
+  struct Shard {
+    /// Guards access to the block map, LRU lists, and cached byte count.
+    mutable mutex mu;
+
+    /// The block map (map from Key to Block).
+    BlockMap block_map TF_GUARDED_BY(mu);
+
+    /// The LRU list of block keys. The front of the list identifies the most
+    /// recently accessed block.
+    std::list<Key> lru_list TF_GUARDED_BY(mu);
+
+    /// The LRA (least recently added) list of block keys. The front of the
+    /// list identifies the most recently added block.
+    ///
+    /// Note: blocks are added to lra_list only after they have successfully
+    /// been fetched from the underlying block store.
+    std::list<Key> lra_list TF_GUARDED_BY(mu);
+
+    /// The combined number of bytes in all of the cached blocks.
+    size_t cache_size TF_GUARDED_BY(mu) = 0;
+
+    // A filename->file_signature map.
+    std::map<string, int64_t> file_signature_map TF_GUARDED_BY(mu);
+
+    // A filename->read state map.
+    std::map<string, ReadState> read_states TF_GUARDED_BY(mu);
+  };
+
+  /// Returns the shard holding the blocks of `filename`.
+  Shard* GetShard(const string& filename) const;
+
   /// Prune the cache by removing files with expired blocks.
-  void Prune() TF_LOCKS_EXCLUDED(mu_);
+  void Prune();
 
-  bool BlockNotStale(const std::shared_ptr<Block>& block)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool BlockNotStale(const std::shared_ptr<Block>& block);
 
-  /// Look up a Key in the block cache.
-  std::shared_ptr<Block> Lookup(const Key& key) TF_LOCKS_EXCLUDED(mu_);
+  /// Look up a Key in the block cache. `prefetch` is true for lookups made by
+  /// readahead rather than by a read.
+  std::shared_ptr<Block> Lookup(Shard* shard, const Key& key, bool prefetch)
+      TF_LOCKS_EXCLUDED(shard->mu);
 
-  Status MaybeFetch(const Key& key, const std::shared_ptr<Block>& block)
-      TF_LOCKS_EXCLUDED(mu_);
+  Status MaybeFetch(Shard* shard, const Key& key,
+                    const std::shared_ptr<Block>& block)
+      TF_LOCKS_EXCLUDED(shard->mu);
 
   /// Trim the block cache to make room for another entry.
-  void Trim() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void Trim(Shard* shard) TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
 
   /// Update the LRU iterator for the block at `key`.
-  Status UpdateLRU(const Key& key, const std::shared_ptr<Block>& block)
-      TF_LOCKS_EXCLUDED(mu_);
-
-  /// Remove all blocks of a file, with mu_ already held.
-  void RemoveFile_Locked(const string& filename)
-      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  Status UpdateLRU(Shard* shard, const Key& key,
+                   const std::shared_ptr<Block>& block)
+      TF_LOCKS_EXCLUDED(shard->mu);
+
+  /// Records a successful read of [offset, offset + n) from `filename`, and
+  /// schedules a readahead of the blocks following `finish` (the block-aligned
+  /// end of the read) if the file is read sequentially. `eof` is true if the
+  /// read reached the end of the file.
+  void MaybePrefetch(Shard* shard, const string& filename, size_t offset,
+                     size_t n, size_t finish, bool eof)
+      TF_LOCKS_EXCLUDED(shard->mu);
+
+  /// Fetches the blocks of `filename` in [start, end), in order, stopping at
+  /// the end of the file or at the first error.
+  void Prefetch(Shard* shard, const string& filename, size_t start, size_t end)
+      TF_LOCKS_EXCLUDED(shard->mu);
+
+  /// Remove all blocks of a file, with the shard's mu already held.
+  void RemoveFile_Locked(Shard* shard, const string& filename)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
 
   /// Remove the block `entry` from the block map and LRU list, and update the
   /// cache size accordingly.
-  void RemoveBlock(BlockMap::iterator entry) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void RemoveBlock(Shard* shard, BlockMap::iterator entry)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+
+  /// The shards of the cache.
+  std::unique_ptr<Shard[]> shards_;
 
   /// The cache pruning thread that removes files with expired blocks.
   std::unique_ptr<Thread> pruning_thread_;
@@ -221,28 +325,18 @@ class RamFileBlockCache : public FileBlockCache {
   /// Notification for stopping the cache pruning thread.
   Notification stop_pruning_thread_;
 
-  /// Guards access to the block map, LRU list, and cached byte count.
-  mutable mutex mu_;
-
-  /// The block map (map from Key to Block).
-  BlockMap block_map_ TF_GUARDED_BY(mu_);
-
-  /// The LRU list of block keys. The front of the list identifies the most
-  /// recently accessed block.
-  std::list<Key> lru_list_ TF_GUARDED_BY(mu_);
-
-  /// The LRA (least recently added) list of block keys. The front of the list
-  /// identifies the most recently added block.
-  ///
-  /// Note: blocks are added to lra_list_ only after they have successfully been
-  /// fetched from the underlying block store.
-  std::list<Key> lra_list_ TF_GUARDED_BY(mu_);
+  /// Counters returned by GetStats().
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> prefetched_{0};
+  std::atomic<int64_t> prefetch_hits_{0};
+  std::atomic<int64_t> prefetch_wasted_{0};
 
-  /// The combined number of bytes in all of the cached blocks.
-  size_t cache_size_ TF_GUARDED_BY(mu_) = 0;
+  /// Set when the cache is destroyed, to skip pending readahead.
+  std::atomic<bool> stop_prefetch_{false};
 
-  // A filename->file_signature map.
-  std::map<string, int64_t> file_signature_map_ TF_GUARDED_BY(mu_);
+  /// The threads fetching blocks ahead of time, if readahead is enabled.
+  std::unique_ptr<thread::ThreadPool> prefetch_pool_;
 };
 
 }  // namespace tensorflow
@@ -15,12 +15,14 @@ limitations under the License.
 
 #include "tensorflow/core/platform/cloud/ram_file_block_cache.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/blocking_counter.h"
 #include "tensorflow/core/platform/cloud/now_seconds_env.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -566,5 +568,137 @@ TEST(RamFileBlockCacheTest, Flush) {
   EXPECT_EQ(calls, 2);
 }
 
+TEST(RamFileBlockCacheTest, Shards) {
+  auto fetcher = [](const string& filename, size_t offset, size_t n,
+                    char* buffer, size_t* bytes_transferred) {
+    memset(buffer, filename[0], n);
+    *bytes_transferred = n;
+    return OkStatus();
+  };
+  RamFileBlockCache::Options options;
+  options.num_shards = 8;
+  // Each shard must be able to hold at least one block.
+  RamFileBlockCache cache(16, 64, 0, fetcher, options);
+  EXPECT_EQ(cache.num_shards(), 4);
+  std::vector<char> out;
+  for (char c = 'a'; c <= 'z'; ++c) {
+    TF_EXPECT_OK(ReadCache(&cache, string(1, c), 0, 16, &out));
+    EXPECT_EQ(out, std::vector<char>(16, c));
+    EXPECT_LE(cache.CacheSize(), 64);
+  }
+  // Every shard holds the most recently read block of one of its files.
+  TF_EXPECT_OK(ReadCache(&cache, "z", 0, 16, &out));
+  EXPECT_EQ(out, std::vector<char>(16, 'z'));
+  RamFileBlockCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 26);
+}
+
+TEST(RamFileBlockCacheTest, PrefetchSequentialReads) {
+  const size_t block_size = 16;
+  mutex mu;
+  std::vector<size_t> calls;
+  auto fetcher = [&mu, &calls](const string& filename, size_t offset, size_t n,
+                               char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      calls.push_back(offset);
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return OkStatus();
+  };
+  RamFileBlockCache::Options options;
+  options.prefetch_blocks = 2;
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher, options);
+  std::vector<char> out;
+  // Random reads do not trigger readahead.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 8 * block_size, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  // The second sequential read triggers a readahead of the next two blocks.
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", 2 * block_size, block_size, &out));
+  const int64_t start = Env::Default()->NowSeconds();
+  while (cache.GetStats().prefetched < 2 &&
+         Env::Default()->NowSeconds() - start < 10) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  RamFileBlockCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.misses, 4);
+  EXPECT_EQ(stats.prefetched, 2);
+  // The prefetched block is read without another fetch, possibly waiting for
+  // the readahead to complete.
+  TF_EXPECT_OK(ReadCache(&cache, "a", 3 * block_size, block_size, &out));
+  EXPECT_EQ(out, std::vector<char>(block_size, 'x'));
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.misses, 4);
+  EXPECT_EQ(stats.prefetch_hits, 1);
+  mutex_lock l(mu);
+  EXPECT_EQ(std::count(calls.begin(), calls.end(), 3 * block_size), 1);
+}
+
+TEST(RamFileBlockCacheTest, PrefetchStopsAtEndOfFile) {
+  const size_t block_size = 16;
+  const size_t file_size = 2 * block_size + 8;
+  mutex mu;
+  std::vector<size_t> calls;
+  Notification last_block_fetched;
+  auto fetcher = [&](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    {
+      mutex_lock l(mu);
+      calls.push_back(offset);
+    }
+    *bytes_transferred = offset < file_size ? std::min(n, file_size - offset)
+                                            : 0;
+    memset(buffer, 'x', *bytes_transferred);
+    if (offset == 2 * block_size) {
+      last_block_fetched.Notify();
+    }
+    return OkStatus();
+  };
+  RamFileBlockCache::Options options;
+  options.prefetch_blocks = 4;
+  {
+    RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher, options);
+    std::vector<char> out;
+    TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+    TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+    last_block_fetched.WaitForNotification();
+    TF_EXPECT_OK(ReadCache(&cache, "a", 2 * block_size, block_size, &out));
+    EXPECT_EQ(out.size(), 8);
+    // Destroying the cache waits for the readahead to return.
+  }
+  mutex_lock l(mu);
+  EXPECT_EQ(calls, std::vector<size_t>({0, block_size, 2 * block_size}));
+}
+
+TEST(RamFileBlockCacheTest, PrefetchWasted) {
+  const size_t block_size = 16;
+  Notification prefetch_started;
+  auto fetcher = [&](const string& filename, size_t offset, size_t n,
+                     char* buffer, size_t* bytes_transferred) {
+    if (offset == 2 * block_size) {
+      prefetch_started.Notify();
+    }
+    memset(buffer, 'x', n);
+    *bytes_transferred = n;
+    return OkStatus();
+  };
+  RamFileBlockCache::Options options;
+  options.prefetch_blocks = 1;
+  RamFileBlockCache cache(block_size, 16 * block_size, 0, fetcher, options);
+  std::vector<char> out;
+  TF_EXPECT_OK(ReadCache(&cache, "a", 0, block_size, &out));
+  TF_EXPECT_OK(ReadCache(&cache, "a", block_size, block_size, &out));
+  prefetch_started.WaitForNotification();
+  // The prefetched block is removed before any read requests it.
+  cache.RemoveFile("a");
+  RamFileBlockCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(stats.prefetched, 1);
+  EXPECT_EQ(stats.prefetch_hits, 0);
+  EXPECT_EQ(stats.prefetch_wasted, 1);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -22,6 +22,10 @@ limitations under the License.
 #if defined(PLATFORM_IS_X86)
 #include <mutex>  // NOLINT
 #endif
+#if defined(PLATFORM_IS_ARM64) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
 
 // SIMD extension querying is only available on x86.
 #ifdef PLATFORM_IS_X86
@@ -350,6 +354,19 @@ void InitCPUIDInfo() {
 bool TestCPUFeature(CPUFeature feature) {
 #ifdef PLATFORM_IS_X86
   return CPUIDInfo::TestFeature(feature);
+#elif defined(PLATFORM_IS_ARM64) && defined(__linux__)
+  switch (feature) {
+#ifdef HWCAP_ASIMDHP
+    case ARM_FP16:
+      return (getauxval(AT_HWCAP) & HWCAP_ASIMDHP) != 0;
+#endif
+#ifdef HWCAP2_BF16
+    case ARM_BF16:
+      return (getauxval(AT_HWCAP2) & HWCAP2_BF16) != 0;
+#endif
+    default:
+      return false;
+  }
 #else
   return false;
 #endif
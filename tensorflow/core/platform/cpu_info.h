@@ -132,6 +132,11 @@ enum CPUFeature {
   AMX_TILE = 41,  // Tile configuration and load/store
   AMX_INT8 = 42,  // Int8 tile matrix multiplication
   AMX_BF16 = 43,  // Bfloat16 tile matrix multiplication
+
+  // Arm: only detected on Linux, from the hardware capabilities reported by
+  // the kernel.
+  ARM_FP16 = 44,  // Armv8.2-A half precision vector arithmetic
+  ARM_BF16 = 45,  // Armv8.6-A bfloat16 dot products and matrix multiplication
 };
 
 // Checks whether the current processor supports one of the features above.
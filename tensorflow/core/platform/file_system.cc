@@ -35,9 +35,24 @@ limitations under the License.
 #include "tensorflow/core/platform/scanner.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/strcat.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 
+void RandomAccessFile::ReadAsync(
+    uint64 offset, size_t n, char* scratch,
+    std::function<void(const Status&, StringPiece)> done) const {
+  // Reads block on I/O rather than on the CPU, so the pool is not sized by the
+  // number of cores.
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "random_access_file_read_async", /*num_threads=*/16);
+  pool->Schedule([this, offset, n, scratch, done = std::move(done)]() {
+    StringPiece result;
+    Status s = Read(offset, n, &result, scratch);
+    done(s, result);
+  });
+}
+
 bool FileSystem::Match(const string& filename, const string& pattern) {
 #if defined(PLATFORM_POSIX) || defined(IS_MOBILE_PLATFORM)
   // We avoid relying on RE2 on mobile platforms, because it incurs a
@@ -774,6 +774,19 @@ class RandomAccessFile {
   virtual tensorflow::Status Read(uint64 offset, size_t n, StringPiece* result,
                                   char* scratch) const = 0;
 
+  /// \brief Starts reading up to `n` bytes from the file starting at
+  /// `offset`, and calls `done` with the status and result of the read, with
+  /// the same meaning as for `Read()`, once it completes.
+  ///
+  /// `done` may be called on another thread, and must not block. The file and
+  /// `scratch[0..n-1]` must stay live until `done` is called.
+  ///
+  /// The default implementation runs `Read()` on a shared thread pool.
+  /// Filesystems that support asynchronous I/O natively may override it.
+  virtual void ReadAsync(
+      uint64 offset, size_t n, char* scratch,
+      std::function<void(const tensorflow::Status&, StringPiece)> done) const;
+
 #if defined(TF_CORD_SUPPORT)
   /// \brief Read up to `n` bytes from the file starting at `offset`.
   virtual tensorflow::Status Read(uint64 offset, size_t n,
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/platform/threadpool.h"
 
+#include <time.h>
+
 #define EIGEN_USE_THREADS
 
 #include "absl/types/optional.h"
@@ -31,12 +33,28 @@ limitations under the License.
 namespace tensorflow {
 namespace thread {
 
+namespace {
+
+// The accumulator and the innermost `ScopedCpuTimeAccumulator` of a thread.
+struct ThreadCpuTimeState {
+  std::shared_ptr<CpuTimeAccumulator> accumulator;
+  ScopedCpuTimeAccumulator* scope = nullptr;
+};
+
+ThreadCpuTimeState& CurrentThreadCpuTimeState() {
+  static thread_local ThreadCpuTimeState state;
+  return state;
+}
+
+}  // namespace
+
 struct EigenEnvironment {
   typedef Thread EnvThread;
   struct TaskImpl {
     std::function<void()> f;
     Context context;
     uint64 trace_id;
+    std::shared_ptr<CpuTimeAccumulator> cpu_time_accumulator;
   };
   struct Task {
     std::unique_ptr<TaskImpl> f;
@@ -74,6 +92,7 @@ struct EigenEnvironment {
             std::move(f),
             Context(ContextKind::kThread),
             id,
+            CpuTimeAccumulator::Current(),
         }),
     };
   }
@@ -82,10 +101,67 @@ struct EigenEnvironment {
     WithContext wc(t.f->context);
     tracing::ScopedRegion region(tracing::EventCategory::kRunClosure,
                                  t.f->trace_id);
-    t.f->f();
+    if (t.f->cpu_time_accumulator != nullptr) {
+      ScopedCpuTimeAccumulator cpu_time(t.f->cpu_time_accumulator);
+      t.f->f();
+    } else {
+      t.f->f();
+    }
   }
 };
 
+void CpuTimeAccumulator::Add(int64_t nanos) {
+  for (CpuTimeAccumulator* accumulator = this; accumulator != nullptr;
+       accumulator = accumulator->parent_.get()) {
+    accumulator->total_nanos_.fetch_add(nanos, std::memory_order_relaxed);
+  }
+}
+
+const std::shared_ptr<CpuTimeAccumulator>& CpuTimeAccumulator::Current() {
+  return CurrentThreadCpuTimeState().accumulator;
+}
+
+int64_t CpuTimeAccumulator::ThreadCpuNanos() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+ScopedCpuTimeAccumulator::ScopedCpuTimeAccumulator(
+    std::shared_ptr<CpuTimeAccumulator> accumulator)
+    : previous_scope_(CurrentThreadCpuTimeState().scope) {
+  ThreadCpuTimeState& state = CurrentThreadCpuTimeState();
+  previous_accumulator_ = std::move(state.accumulator);
+  // The enclosing scope subtracts the CPU time of this one, so it needs to be
+  // measured even if this scope does not attribute it.
+  if (accumulator != nullptr || previous_scope_ != nullptr) {
+    start_nanos_ = CpuTimeAccumulator::ThreadCpuNanos();
+  }
+  state.accumulator = std::move(accumulator);
+  state.scope = this;
+}
+
+ScopedCpuTimeAccumulator::~ScopedCpuTimeAccumulator() {
+  ThreadCpuTimeState& state = CurrentThreadCpuTimeState();
+  DCHECK_EQ(state.scope, this);
+  if (start_nanos_ >= 0) {
+    const int64_t elapsed_nanos =
+        CpuTimeAccumulator::ThreadCpuNanos() - start_nanos_;
+    if (state.accumulator != nullptr) {
+      state.accumulator->Add(elapsed_nanos - nested_nanos_);
+    }
+    if (previous_scope_ != nullptr) {
+      previous_scope_->nested_nanos_ += elapsed_nanos;
+    }
+  }
+  state.accumulator = std::move(previous_accumulator_);
+  state.scope = previous_scope_;
+}
+
 ThreadPool::ThreadPool(Env* env, const string& name, int num_threads)
     : ThreadPool(env, ThreadOptions(), name, num_threads, true, nullptr) {}
 
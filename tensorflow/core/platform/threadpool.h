@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_PLATFORM_THREADPOOL_H_
 #define TENSORFLOW_CORE_PLATFORM_THREADPOOL_H_
 
+#include <atomic>
 #include <functional>
 #include <memory>
 
@@ -238,6 +239,75 @@ class ThreadPool {
   TF_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
 
+// Accumulates the CPU time consumed on behalf of a unit of work, such as a
+// request, by all the threads that run closures for it.
+//
+// While an accumulator is current on a thread (see `ScopedCpuTimeAccumulator`),
+// the closures that the thread schedules on a `ThreadPool` inherit it: the CPU
+// time they consume is added to the accumulator, and the closures they
+// schedule in turn inherit it. This covers the closures of an executor on the
+// inter-op pool as well as the shards of `ParallelFor()` and of the Eigen
+// expressions evaluated on an intra-op pool. Closures scheduled on a
+// `ThreadPool` that wraps a user-provided `ThreadPoolInterface` do not inherit
+// the accumulator.
+//
+// CPU time is read from the per-thread CPU clock of the OS, and is always zero
+// on platforms that do not provide one. All methods are thread-safe.
+class CpuTimeAccumulator {
+ public:
+  // CPU time added to this accumulator is also added to `parent`, if any.
+  explicit CpuTimeAccumulator(
+      std::shared_ptr<CpuTimeAccumulator> parent = nullptr)
+      : parent_(std::move(parent)) {}
+
+  // Returns the CPU time added so far, in nanoseconds. The CPU time of a
+  // closure, or of a `ScopedCpuTimeAccumulator`, is added when it completes.
+  int64_t total_nanos() const {
+    return total_nanos_.load(std::memory_order_relaxed);
+  }
+
+  // Adds `nanos` to this accumulator and to its ancestors.
+  void Add(int64_t nanos);
+
+  // Returns the accumulator that is current on the calling thread, or nullptr.
+  static const std::shared_ptr<CpuTimeAccumulator>& Current();
+
+  // Returns the CPU time consumed so far by the calling thread, in
+  // nanoseconds, or 0 if the platform does not support it.
+  static int64_t ThreadCpuNanos();
+
+ private:
+  const std::shared_ptr<CpuTimeAccumulator> parent_;
+  std::atomic<int64_t> total_nanos_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CpuTimeAccumulator);
+};
+
+// Makes `accumulator` current on the calling thread for the lifetime of the
+// object, and adds to it the CPU time consumed by the thread in the meantime.
+// The CPU time of nested scopes is only added to the accumulators of these
+// scopes. `accumulator` may be null, in which case the CPU time of the scope
+// is not attributed.
+//
+// Must be destroyed on the thread that created it, in reverse order of
+// creation with respect to the other scopes of the thread.
+class ScopedCpuTimeAccumulator {
+ public:
+  explicit ScopedCpuTimeAccumulator(
+      std::shared_ptr<CpuTimeAccumulator> accumulator);
+  ~ScopedCpuTimeAccumulator();
+
+ private:
+  std::shared_ptr<CpuTimeAccumulator> previous_accumulator_;
+  ScopedCpuTimeAccumulator* const previous_scope_;
+  // -1 if neither this scope nor an enclosing scope needs the CPU time.
+  int64_t start_nanos_ = -1;
+  // CPU time consumed by nested scopes.
+  int64_t nested_nanos_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedCpuTimeAccumulator);
+};
+
 }  // namespace thread
 }  // namespace tensorflow
 
@@ -0,0 +1,370 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/backends/cpu/continuous_recorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+#include "tensorflow/core/profiler/utils/xplane_builder.h"
+#include "tensorflow/core/profiler/utils/xplane_schema.h"
+#include "tensorflow/core/profiler/utils/xplane_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace internal {
+
+std::atomic<int> g_continuous_sampling_period(0);
+
+}  // namespace internal
+
+namespace {
+
+struct Event {
+  uint32 name_id;
+  int64_t start_time;
+  int64_t end_time;
+};
+
+// A fixed-size single-producer single-consumer queue of Events.
+//
+// head_ is the number of events pushed, and tail_ the number of events
+// drained. Push writes the slot at head_ and then advances it, or drops the
+// event if the buffer is full. Drain reads the slots in [tail_, head_) and then
+// advances tail_. Push is only called by the owner thread, and Drain is only
+// called while holding the ContinuousRecorder mutex, so both are lock free.
+class EventRingBuffer {
+ public:
+  // `capacity` must be a power of two.
+  explicit EventRingBuffer(size_t capacity)
+      : mask_(capacity - 1), events_(new Event[capacity]) {
+    DCHECK_EQ(capacity & mask_, 0);
+  }
+
+  // Adds an event, or returns false if the buffer is full. Fast and lock-free.
+  bool Push(const Event& event) {
+    uint64 head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) return false;
+    events_[head & mask_] = event;
+    head_.store(head + 1, std::memory_order_release);  // Write index after.
+    return true;
+  }
+
+  // Calls `fn` on the events in the buffer at the time of invocation, and
+  // removes them.
+  template <typename Fn>
+  void Drain(Fn&& fn) {
+    uint64 tail = tail_.load(std::memory_order_relaxed);
+    // Read index before contents.
+    const uint64 head = head_.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      fn(events_[tail & mask_]);
+    }
+    tail_.store(tail, std::memory_order_release);  // Free slots after reading.
+  }
+
+ private:
+  const uint64 mask_;
+  std::unique_ptr<Event[]> events_;
+  // Written by the owner thread.
+  alignas(64) std::atomic<uint64> head_{0};
+  // Written by the draining thread.
+  alignas(64) std::atomic<uint64> tail_{0};
+};
+
+size_t RoundUpToPowerOfTwo(int n) {
+  size_t capacity = 2;
+  while (static_cast<int64_t>(capacity) < n) capacity <<= 1;
+  return capacity;
+}
+
+}  // namespace
+
+class ContinuousRecorder::Impl {
+ public:
+  // The events of a thread. Ownership is shared with ThreadLocalBuffer, which
+  // is allocated in thread_local storage. If the thread is destroyed, the
+  // ThreadBuffer is kept alive until it is drained.
+  struct ThreadBuffer {
+    explicit ThreadBuffer(size_t capacity) : ring_buffer(capacity) {
+      auto* env = Env::Default();
+      tid = env->GetCurrentThreadId();
+      env->GetCurrentThreadName(&name);
+    }
+
+    uint32 tid;
+    std::string name;
+    EventRingBuffer ring_buffer;
+    // Events dropped because ring_buffer was full.
+    std::atomic<int64_t> dropped{0};
+    // Cleared when the owner thread is destroyed.
+    std::atomic<int> active{1};  // std::atomic<bool> is not always lock-free.
+  };
+
+  // Creates and registers the ThreadBuffer of a thread on its first event.
+  class ThreadLocalBuffer {
+   public:
+    ThreadLocalBuffer()
+        : buffer_(std::make_shared<ThreadBuffer>(
+              Get()->ring_buffer_size_.load(std::memory_order_relaxed))) {
+      Get()->RegisterThread(buffer_);
+    }
+
+    ~ThreadLocalBuffer() {
+      buffer_->active.store(0, std::memory_order_release);
+      Get()->UnregisterThread();
+    }
+
+    void Push(const Event& event) {
+      if (TF_PREDICT_FALSE(!buffer_->ring_buffer.Push(event))) {
+        buffer_->dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+   private:
+    std::shared_ptr<ThreadBuffer> buffer_;
+  };
+
+  Impl() {
+    mutex_lock lock(mutex_);
+    ResetPlane();
+  }
+
+  bool Start(const Options& options) TF_LOCKS_EXCLUDED(control_mutex_, mutex_) {
+    mutex_lock control_lock(control_mutex_);
+    if (Active()) return false;
+    ring_buffer_size_.store(RoundUpToPowerOfTwo(options.ring_buffer_size),
+                            std::memory_order_relaxed);
+    {
+      mutex_lock lock(mutex_);
+      max_buffered_events_ = options.max_buffered_events;
+    }
+    stop_drain_ = std::make_unique<Notification>();
+    const int64_t drain_interval_us = std::max<int64_t>(
+        options.drain_interval_us, 1);
+    drain_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "TF_continuous_profiler",
+        [this, drain_interval_us, stop_drain = stop_drain_.get()] {
+          while (!WaitForNotificationWithTimeout(stop_drain,
+                                                 drain_interval_us)) {
+            mutex_lock lock(mutex_);
+            Drain();
+          }
+        }));
+    internal::g_continuous_sampling_period.store(
+        std::max(options.sampling_period, 1), std::memory_order_release);
+    return true;
+  }
+
+  void Stop() TF_LOCKS_EXCLUDED(control_mutex_, mutex_) {
+    mutex_lock control_lock(control_mutex_);
+    if (internal::g_continuous_sampling_period.exchange(
+            0, std::memory_order_acq_rel) == 0) {
+      return;
+    }
+    stop_drain_->Notify();
+    // Destroying drain_thread_ blocks until it receives the above
+    // notification and returns.
+    drain_thread_.reset();
+    mutex_lock lock(mutex_);
+    Drain();
+  }
+
+  uint32 RegisterName(absl::string_view name) TF_LOCKS_EXCLUDED(names_mutex_) {
+    mutex_lock lock(names_mutex_);
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) return it->second;
+    const uint32 name_id = names_.size();
+    names_.emplace_back(name);
+    name_ids_.emplace(names_.back(), name_id);
+    return name_id;
+  }
+
+  void Collect(XPlane* plane) TF_LOCKS_EXCLUDED(mutex_) {
+    mutex_lock lock(mutex_);
+    Drain();
+    SortXLinesBy(&plane_, XLinesComparatorByName());
+    *plane = std::move(plane_);
+    ResetPlane();
+  }
+
+  Stats GetStats() TF_LOCKS_EXCLUDED(mutex_) {
+    mutex_lock lock(mutex_);
+    Stats stats;
+    stats.recorded = recorded_;
+    stats.dropped = dropped_;
+    for (const auto& thread : threads_) {
+      stats.dropped += thread->dropped.load(std::memory_order_relaxed);
+    }
+    return stats;
+  }
+
+ private:
+  void RegisterThread(std::shared_ptr<ThreadBuffer> thread)
+      TF_LOCKS_EXCLUDED(mutex_) {
+    mutex_lock lock(mutex_);
+    threads_.push_back(std::move(thread));
+  }
+
+  void UnregisterThread() TF_LOCKS_EXCLUDED(mutex_) {
+    // If recording is active, the ThreadBuffer is released by the next drain.
+    if (Active()) return;
+    mutex_lock lock(mutex_);
+    Drain();
+  }
+
+  void ResetPlane() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    plane_ = XPlane();
+    plane_.set_name(std::string(kHostThreadsPlaneName));
+    plane_start_ns_ = GetCurrentTimeNanos();
+    num_buffered_events_ = 0;
+  }
+
+  // Moves the events of all threads into plane_, and releases the
+  // ThreadBuffers of destroyed threads.
+  void Drain() TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    XPlaneBuilder plane(&plane_);
+    for (auto it = threads_.begin(); it != threads_.end();) {
+      ThreadBuffer* thread = it->get();
+      // Read before draining, so that the last events of a destroyed thread
+      // are drained before its ThreadBuffer is released.
+      const bool active = thread->active.load(std::memory_order_acquire);
+      absl::optional<XLineBuilder> line;
+      thread->ring_buffer.Drain([&](const Event& event) {
+        if (num_buffered_events_ >= max_buffered_events_) {
+          ++dropped_;
+          return;
+        }
+        // Events that started before the plane are discarded, as in
+        // ConvertCompleteEventsToXPlane().
+        if (event.start_time < plane_start_ns_) return;
+        if (!line) {
+          line = plane.GetOrCreateLine(thread->tid);
+          if (line->Name().empty()) {
+            line->SetName(thread->name);
+            line->SetTimestampNs(plane_start_ns_);
+          }
+        }
+        XEventBuilder xevent = line->AddEvent(*GetEventMetadata(
+            &plane, event.name_id));
+        xevent.SetTimestampNs(event.start_time);
+        xevent.SetEndTimestampNs(event.end_time);
+        ++recorded_;
+        ++num_buffered_events_;
+      });
+      dropped_ += thread->dropped.exchange(0, std::memory_order_relaxed);
+      if (active) {
+        ++it;
+      } else {
+        it = threads_.erase(it);
+      }
+    }
+  }
+
+  // Event metadata ids are the registered name ids plus one, since 0 is not a
+  // valid metadata id.
+  XEventMetadata* GetEventMetadata(XPlaneBuilder* plane, uint32 name_id)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mutex_) TF_LOCKS_EXCLUDED(names_mutex_) {
+    XEventMetadata* metadata = plane->GetOrCreateEventMetadata(name_id + 1);
+    if (TF_PREDICT_FALSE(metadata->name().empty())) {
+      mutex_lock lock(names_mutex_);
+      if (name_id < names_.size()) metadata->set_name(names_[name_id]);
+    }
+    return metadata;
+  }
+
+  // Serializes Start() and Stop().
+  mutex control_mutex_;
+  std::unique_ptr<Notification> stop_drain_ TF_GUARDED_BY(control_mutex_);
+  std::unique_ptr<Thread> drain_thread_ TF_GUARDED_BY(control_mutex_);
+
+  // Read by threads on their first event.
+  std::atomic<size_t> ring_buffer_size_{4096};
+
+  mutex names_mutex_;
+  std::vector<std::string> names_ TF_GUARDED_BY(names_mutex_);
+  absl::flat_hash_map<std::string, uint32> name_ids_
+      TF_GUARDED_BY(names_mutex_);
+
+  mutex mutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> threads_ TF_GUARDED_BY(mutex_);
+  XPlane plane_ TF_GUARDED_BY(mutex_);
+  int64_t plane_start_ns_ TF_GUARDED_BY(mutex_) = 0;
+  int64_t num_buffered_events_ TF_GUARDED_BY(mutex_) = 0;
+  int64_t max_buffered_events_ TF_GUARDED_BY(mutex_) = 1 << 20;
+  int64_t recorded_ TF_GUARDED_BY(mutex_) = 0;
+  int64_t dropped_ TF_GUARDED_BY(mutex_) = 0;
+};
+
+/*static*/ ContinuousRecorder::Impl* ContinuousRecorder::Get() {
+  static Impl* singleton = new Impl;
+  return singleton;
+}
+
+/*static*/ bool ContinuousRecorder::Start(const Options& options) {
+  return Get()->Start(options);
+}
+
+/*static*/ void ContinuousRecorder::Stop() { Get()->Stop(); }
+
+/*static*/ uint32 ContinuousRecorder::RegisterName(absl::string_view name) {
+  return Get()->RegisterName(name);
+}
+
+/*static*/ bool ContinuousRecorder::Sample() {
+  // The number of events to skip before the next sampled one.
+  static thread_local int countdown = 0;
+  if (countdown > 0) {
+    --countdown;
+    return false;
+  }
+  countdown = internal::g_continuous_sampling_period.load(
+                  std::memory_order_relaxed) -
+              1;
+  return true;
+}
+
+/*static*/ void ContinuousRecorder::Record(uint32 name_id,
+                                           int64_t start_time_ns,
+                                           int64_t end_time_ns) {
+  static thread_local Impl::ThreadLocalBuffer thread_local_buffer;
+  thread_local_buffer.Push({name_id, start_time_ns, end_time_ns});
+}
+
+/*static*/ void ContinuousRecorder::Collect(XPlane* plane) {
+  Get()->Collect(plane);
+}
+
+/*static*/ ContinuousRecorder::Stats ContinuousRecorder::GetStats() {
+  return Get()->GetStats();
+}
+
+}  // namespace profiler
+}  // namespace tensorflow
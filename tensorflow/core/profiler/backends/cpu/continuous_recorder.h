@@ -0,0 +1,115 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_BACKENDS_CPU_CONTINUOUS_RECORDER_H_
+#define TENSORFLOW_CORE_PROFILER_BACKENDS_CPU_CONTINUOUS_RECORDER_H_
+
+#include <atomic>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace profiler {
+
+class XPlane;
+
+namespace internal {
+
+// Sampling period of the ContinuousRecorder, or 0 when it is stopped.
+// Static atomic so ContinuousRecorder::Active can be fast and non-blocking.
+TF_EXPORT extern std::atomic<int> g_continuous_sampling_period;
+
+}  // namespace internal
+
+// ContinuousRecorder is a low-overhead alternative to TraceMeRecorder, meant
+// to be left running in production.
+//
+// Events have a fixed format: the id of a name registered once with
+// RegisterName(), and start and end times in ns since the Unix epoch, so that
+// no string is built on the hot path. Each thread keeps one event out of every
+// `sampling_period`, and writes it into its own fixed-size single-producer
+// single-consumer ring buffer without locking. A background thread
+// periodically drains the ring buffers into an XPlane, which Collect() hands
+// out. When a ring buffer is full, new events of its thread are dropped until
+// it is drained.
+//
+// This is the backend for ContinuousTraceMe instrumentation.
+class ContinuousRecorder {
+ public:
+  struct Options {
+    // The number of events held by the ring buffer of each thread, rounded up
+    // to a power of two. Applies to threads that record their first event
+    // after Start().
+    int ring_buffer_size = 4096;
+    // One out of every `sampling_period` events of each thread is recorded.
+    int sampling_period = 1;
+    // The interval between two drains of the ring buffers.
+    int64_t drain_interval_us = 100000;
+    // The maximum number of events held in the XPlane between two calls to
+    // Collect(). Later events are dropped.
+    int64_t max_buffered_events = 1 << 20;
+  };
+
+  struct Stats {
+    // Events moved from the ring buffers to the XPlane.
+    int64_t recorded = 0;
+    // Events dropped because a ring buffer or the XPlane was full.
+    int64_t dropped = 0;
+  };
+
+  // Starts recording and the background drain. Returns false if the recorder
+  // is already started.
+  static bool Start(const Options& options);
+
+  // Stops recording. Events recorded until then remain available to
+  // Collect().
+  static void Stop();
+
+  // Returns whether we're currently recording. Racy, but cheap!
+  static inline bool Active() {
+    return internal::g_continuous_sampling_period.load(
+               std::memory_order_relaxed) > 0;
+  }
+
+  // Returns the id of `name`, to be passed to Record(). Takes a lock, so call
+  // sites should register their names once, e.g. in a function-level static.
+  static uint32 RegisterName(absl::string_view name);
+
+  // Returns whether the calling thread should record its next event, per the
+  // sampling period. Call only if Active().
+  static bool Sample();
+
+  // Records an event of the calling thread. Non-blocking.
+  static void Record(uint32 name_id, int64_t start_time_ns,
+                     int64_t end_time_ns);
+
+  // Drains the ring buffers, and replaces `plane` with the events recorded
+  // since the previous call, one line per thread.
+  static void Collect(XPlane* plane);
+
+  static Stats GetStats();
+
+ private:
+  class Impl;
+
+  // Returns singleton.
+  static Impl* Get();
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_BACKENDS_CPU_CONTINUOUS_RECORDER_H_
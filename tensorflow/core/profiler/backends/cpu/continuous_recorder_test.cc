@@ -0,0 +1,140 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/profiler/backends/cpu/continuous_recorder.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/profiler/protobuf/xplane.pb.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+
+namespace tensorflow {
+namespace profiler {
+namespace {
+
+// Records `num_events` events named `name_id` on the calling thread, subject
+// to sampling.
+void RecordEvents(uint32 name_id, int num_events) {
+  for (int i = 0; i < num_events; ++i) {
+    if (ContinuousRecorder::Active() && ContinuousRecorder::Sample()) {
+      int64_t start_time = GetCurrentTimeNanos();
+      ContinuousRecorder::Record(name_id, start_time, start_time + 1000);
+    }
+  }
+}
+
+int NumEvents(const XPlane& plane) {
+  int num_events = 0;
+  for (const auto& line : plane.lines()) num_events += line.events_size();
+  return num_events;
+}
+
+class ContinuousRecorderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // Discard the events of previous tests.
+    XPlane plane;
+    ContinuousRecorder::Collect(&plane);
+  }
+
+  void TearDown() override { ContinuousRecorder::Stop(); }
+};
+
+TEST_F(ContinuousRecorderTest, RecordsSampledEvents) {
+  const uint32 name_id = ContinuousRecorder::RegisterName("sampled");
+  EXPECT_EQ(ContinuousRecorder::RegisterName("sampled"), name_id);
+  RecordEvents(name_id, 10);
+
+  ContinuousRecorder::Options options;
+  options.sampling_period = 4;
+  ASSERT_TRUE(ContinuousRecorder::Start(options));
+  EXPECT_FALSE(ContinuousRecorder::Start(options));
+  EXPECT_TRUE(ContinuousRecorder::Active());
+  RecordEvents(name_id, 40);
+  ContinuousRecorder::Stop();
+  EXPECT_FALSE(ContinuousRecorder::Active());
+  RecordEvents(name_id, 10);
+
+  XPlane plane;
+  ContinuousRecorder::Collect(&plane);
+  ASSERT_EQ(plane.lines_size(), 1);
+  EXPECT_EQ(plane.lines(0).id(),
+            static_cast<uint32>(Env::Default()->GetCurrentThreadId()));
+  EXPECT_EQ(plane.lines(0).events_size(), 10);
+  const XEvent& event = plane.lines(0).events(0);
+  EXPECT_EQ(plane.event_metadata().at(event.metadata_id()).name(), "sampled");
+  EXPECT_EQ(event.duration_ps(), 1000 * 1000);
+
+  // Collected events are not returned again.
+  ContinuousRecorder::Collect(&plane);
+  EXPECT_EQ(NumEvents(plane), 0);
+}
+
+TEST_F(ContinuousRecorderTest, DropsEventsWhenRingBufferIsFull) {
+  const uint32 name_id = ContinuousRecorder::RegisterName("dropped");
+  ContinuousRecorder::Options options;
+  options.ring_buffer_size = 8;
+  // Only drain in Collect().
+  options.drain_interval_us = 3600 * 1000000LL;
+  ContinuousRecorder::Stats stats = ContinuousRecorder::GetStats();
+  ASSERT_TRUE(ContinuousRecorder::Start(options));
+  // The ring buffer of a new thread holds 8 events.
+  std::unique_ptr<Thread> thread(
+      Env::Default()->StartThread({}, "recorder", [name_id] {
+        RecordEvents(name_id, 20);
+      }));
+  thread.reset();
+  XPlane plane;
+  ContinuousRecorder::Collect(&plane);
+  EXPECT_EQ(NumEvents(plane), 8);
+  ContinuousRecorder::Stats new_stats = ContinuousRecorder::GetStats();
+  EXPECT_EQ(new_stats.recorded - stats.recorded, 8);
+  EXPECT_EQ(new_stats.dropped - stats.dropped, 12);
+}
+
+TEST_F(ContinuousRecorderTest, DrainsInBackground) {
+  const uint32 name_id = ContinuousRecorder::RegisterName("drained");
+  constexpr int kNumThreads = 4;
+  constexpr int kNumEvents = 10000;
+  ContinuousRecorder::Options options;
+  options.ring_buffer_size = 64;
+  options.drain_interval_us = 100;
+  ASSERT_TRUE(ContinuousRecorder::Start(options));
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back(
+        Env::Default()->StartThread({}, "recorder", [name_id] {
+          for (int j = 0; j < kNumEvents; ++j) {
+            RecordEvents(name_id, 1);
+            if (j % 32 == 0) Env::Default()->SleepForMicroseconds(100);
+          }
+        }));
+  }
+  threads.clear();
+  ContinuousRecorder::Stop();
+  XPlane plane;
+  ContinuousRecorder::Collect(&plane);
+  EXPECT_EQ(plane.lines_size(), kNumThreads);
+  // The background drain keeps up with most of the events, even though each
+  // ring buffer is much smaller than the number of events of its thread.
+  EXPECT_GT(NumEvents(plane), kNumThreads * kNumEvents / 2);
+}
+
+}  // namespace
+}  // namespace profiler
+}  // namespace tensorflow
@@ -0,0 +1,101 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_TRACEME_H_
+#define TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_TRACEME_H_
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+
+#if !defined(IS_MOBILE_PLATFORM)
+#include "tensorflow/core/profiler/backends/cpu/continuous_recorder.h"
+#include "tensorflow/core/profiler/utils/time_utils.h"
+#endif
+
+namespace tensorflow {
+namespace profiler {
+
+// A TraceMe for always-on profiling. Unlike TraceMe, it is recorded by the
+// ContinuousRecorder, which samples events and stores them in per-thread ring
+// buffers without locking, so it can be left enabled in production.
+//
+// Names are registered once per call site and events carry no metadata, so
+// that no string is built while tracing:
+//   {
+//     static const uint32 kStepName = ContinuousTraceMe::RegisterName("step");
+//     ContinuousTraceMe trace(kStepName);
+//     ... do some work ...
+//   }
+class ContinuousTraceMe {
+ public:
+  explicit ContinuousTraceMe(uint32 name_id) {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(ContinuousRecorder::Active()) &&
+        ContinuousRecorder::Sample()) {
+      name_id_ = name_id;
+      start_time_ = GetCurrentTimeNanos();
+    }
+#endif
+  }
+
+  ~ContinuousTraceMe() { Stop(); }
+
+  // Stop tracing the activity. Called by the destructor, but exposed to allow
+  // stopping tracing before the object goes out of scope. Only has an effect
+  // the first time it is called.
+  void Stop() {
+#if !defined(IS_MOBILE_PLATFORM)
+    if (TF_PREDICT_FALSE(start_time_ != kUntracedActivity)) {
+      if (TF_PREDICT_TRUE(ContinuousRecorder::Active())) {
+        ContinuousRecorder::Record(name_id_, start_time_,
+                                   GetCurrentTimeNanos());
+      }
+      start_time_ = kUntracedActivity;
+    }
+#endif
+  }
+
+  // Returns the id of `name` to pass to the constructor.
+  static uint32 RegisterName(absl::string_view name) {
+#if !defined(IS_MOBILE_PLATFORM)
+    return ContinuousRecorder::RegisterName(name);
+#else
+    return 0;
+#endif
+  }
+
+  static bool Active() {
+#if !defined(IS_MOBILE_PLATFORM)
+    return ContinuousRecorder::Active();
+#else
+    return false;
+#endif
+  }
+
+ private:
+  // Start time used when tracing is disabled.
+  constexpr static int64_t kUntracedActivity = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousTraceMe);
+
+  uint32 name_id_ = 0;
+  int64_t start_time_ = kUntracedActivity;
+};
+
+}  // namespace profiler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PROFILER_LIB_CONTINUOUS_TRACEME_H_
@@ -166,21 +166,23 @@ Status SetUpKernelFallbackCompatRequestContext(
   return OkStatus();
 }
 
-static llvm::Expected<gtl::InlinedVector<tensorflow::Tensor, 4>>
-ConvertInputTensors(llvm::ArrayRef<tfrt::Tensor*> arguments,
-                    const tfrt::ExecutionContext& exec_ctx) {
-  gtl::InlinedVector<tensorflow::Tensor, 4> input_tf_tensors;
-  input_tf_tensors.reserve(arguments.size());
+// Converts `arguments` into `input_tf_tensors`, which is reused across calls
+// to avoid reallocating it.
+static llvm::Error ConvertInputTensors(
+    llvm::ArrayRef<tfrt::Tensor*> arguments,
+    const tfrt::ExecutionContext& exec_ctx,
+    gtl::InlinedVector<tensorflow::Tensor, 4>* input_tf_tensors) {
+  input_tf_tensors->reserve(arguments.size());
   for (tfrt::Tensor* argument : arguments) {
     auto expected_tf_tensor = TFRTTensorToTFTensor(*argument, exec_ctx.host());
     if (!expected_tf_tensor) {
       return tfrt::MakeStringError(
           tfrt::StrCat(expected_tf_tensor.takeError()));
     }
-    input_tf_tensors.push_back(std::move(expected_tf_tensor.get()));
+    input_tf_tensors->push_back(std::move(expected_tf_tensor.get()));
   }
 
-  return input_tf_tensors;
+  return llvm::Error::success();
 }
 
 static Status ValidateInputTypes(
@@ -337,21 +339,21 @@ tfrt::AsyncValueRef<tfrt::Chain> KernelFallbackExecuteCompatCoreRuntimeDispatch(
   auto op_chain = tfrt::GetReadyChain();
   tensorflow::Status status;
 
-  auto expected_input_tf_tensors = ConvertInputTensors(arguments, exec_ctx);
-  if (!expected_input_tf_tensors) {
-    status = tensorflow::errors::Internal(
-        tfrt::StrCat(expected_input_tf_tensors.takeError()));
-    KernelFallbackEmitError(exec_ctx, &fallback_request_state, op_name,
-                            &op_chain, results, status);
-    return op_chain;
-  }
-
   auto& run_state = GetThreadLocalOpKernelRunState();
   auto clean_up_inputs =
       gtl::MakeCleanup([&]() { run_state.input_tf_tensors.clear(); });
 
+  // Convert the inputs directly into the thread local run state, so that the
+  // tensors are not moved again.
   auto& input_tf_tensors = run_state.input_tf_tensors;
-  input_tf_tensors = std::move(expected_input_tf_tensors.get());
+  DCHECK(input_tf_tensors.empty());
+  if (auto error =
+          ConvertInputTensors(arguments, exec_ctx, &input_tf_tensors)) {
+    status = tensorflow::errors::Internal(tfrt::StrCat(std::move(error)));
+    KernelFallbackEmitError(exec_ctx, &fallback_request_state, op_name,
+                            &op_chain, results, status);
+    return op_chain;
+  }
 
   // Check if input tensor dtypes are valid.
   status = ValidateInputTypes(op_name, input_tf_tensors,
@@ -31,6 +31,7 @@ void SetUpParams(const tfrt_stub::OpKernelRunner& runner,
   params.inputs = run_state.input_tf_tensor_values;
   params.device = device;
   params.op_kernel = runner.op_kernel();
+  params.op_device_context = runner.op_device_context();
   // Still use original device's resource_manager.
   params.resource_manager = runner.resource_manager();
   params.input_alloc_attrs = runner.input_alloc_attrs();
@@ -141,6 +141,10 @@ OpKernelRunner::OpKernelRunner(
   DCHECK(device_);
   DCHECK(function_library_runtime_);
 
+  if (const auto* device_info = device_->tensorflow_accelerator_device_info()) {
+    op_device_context_ = device_info->default_context;
+  }
+
   const auto& input_memory_types = op_kernel_->input_memory_types();
   input_alloc_attrs_.resize(op_kernel_->num_inputs());
   for (size_t i = 0, e = op_kernel_->num_inputs(); i < e; ++i) {
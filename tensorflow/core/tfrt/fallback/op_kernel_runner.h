@@ -72,6 +72,11 @@ class OpKernelRunner {
   tensorflow::ResourceMgr* resource_manager() const {
     return resource_manager_;
   }
+  // The default device context of `device()`, or nullptr if it has none.
+  // Resolved once so that each kernel execution does not look it up.
+  tensorflow::DeviceContext* op_device_context() const {
+    return op_device_context_;
+  }
 
   const gtl::InlinedVector<AllocatorAttributes, 4>& input_alloc_attrs() const {
     return input_alloc_attrs_;
@@ -89,6 +94,7 @@ class OpKernelRunner {
   tensorflow::Device* device_ = nullptr;
   tensorflow::FunctionLibraryRuntime* function_library_runtime_ = nullptr;
   tensorflow::ResourceMgr* resource_manager_ = nullptr;
+  tensorflow::DeviceContext* op_device_context_ = nullptr;
   std::unique_ptr<OpKernel> op_kernel_;
   bool is_async_ = false;
   gtl::InlinedVector<AllocatorAttributes, 4> input_alloc_attrs_;
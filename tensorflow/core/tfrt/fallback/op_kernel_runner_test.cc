@@ -19,13 +19,16 @@ limitations under the License.
 
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/device_factory.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/tfrt/fallback/fallback_state.h"
 
 namespace tensorflow {
 namespace {
@@ -74,5 +77,28 @@ TEST(OpKernelRunnerTest, OpKernelRunState) {
   EXPECT_THAT(run_state.params.eigen_gpu_device, IsNull());
 }
 
+TEST(OpKernelRunnerTest, ResolvesDeviceContextOnce) {
+  SessionOptions options;
+  options.config.mutable_device_count()->insert({kDeviceType, 1});
+  TF_ASSERT_OK_AND_ASSIGN(auto fallback_state,
+                          tfrt_stub::FallbackState::Create(
+                              options, FunctionDefLibrary()));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto runner,
+      tfrt_stub::OpKernelRunner::Create(
+          "NoOp", /*device_name=*/
+          strings::StrCat("/job:localhost/replica:0/task:0/device:",
+                          kDeviceType, ":0"),
+          /*num_args=*/0, [](AttrValueMap*) { return OkStatus(); },
+          fallback_state->device_manager(),
+          fallback_state->process_function_library_runtime()));
+
+  const auto* device_info =
+      runner.device()->tensorflow_accelerator_device_info();
+  EXPECT_EQ(runner.op_device_context(),
+            device_info == nullptr ? nullptr : device_info->default_context);
+}
+
 }  // namespace
 }  // namespace tensorflow
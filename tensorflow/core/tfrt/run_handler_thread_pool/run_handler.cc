@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/threadpool_interface.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/denormal.h"
@@ -40,6 +41,16 @@ namespace {
 typedef typename internal::RunHandlerEnvironment::Task Task;
 typedef Eigen::RunQueue<Task, 1024> Queue;
 
+tensorflow::monitoring::Sampler<1>* QueueWaitTimeUs() {
+  static auto* queue_wait_time_us = tensorflow::monitoring::Sampler<1>::New(
+      {"/tensorflow/tfrt/run_handler/queue_wait_time_us",
+       "Time in microseconds tasks wait in the RunHandler queues before "
+       "running.",
+       "priority"},
+      {tensorflow::monitoring::Buckets::Exponential(1, 2, 24)});
+  return queue_wait_time_us;
+}
+
 }  // namespace
 
 namespace internal {
@@ -74,6 +85,7 @@ RunHandlerEnvironment::Task RunHandlerEnvironment::CreateTask(TaskFunction f) {
           std::move(f),
           tensorflow::Context(tensorflow::ContextKind::kThread),
           id,
+          tensorflow::EnvTime::NowMicros(),
       }),
   };
 }
@@ -133,6 +145,9 @@ ThreadWorkSource::ThreadWorkSource()
       non_blocking_inflight_(0),
       pending_tasks_(0),
       traceme_id_(0),
+      priority_(0),
+      queued_since_us_(0),
+      queue_wait_time_cell_(QueueWaitTimeUs()->GetCell("0")),
       version_(0),
       sub_thread_pool_waiter_(nullptr) {
   queue_waiters_.next = &queue_waiters_;
@@ -160,6 +175,7 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
   tensorflow::mutex* mu = nullptr;
   Queue* task_queue = nullptr;
   thread_local int64_t closure_counter = 0;
+  const uint64_t enqueue_time_us = t.f->enqueue_time_us;
 
   if (!is_blocking) {
     int queue_index = ++closure_counter % non_blocking_work_sharding_factor_;
@@ -176,6 +192,12 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
     t = task_queue->PushFront(std::move(t));
   }
   IncrementPendingTaskCount();
+  if (!t.f && queued_since_us_.load(std::memory_order_relaxed) == 0) {
+    // The task is the first one queued.
+    uint64_t expected = 0;
+    queued_since_us_.compare_exchange_strong(expected, enqueue_time_us,
+                                             std::memory_order_relaxed);
+  }
 
   if (enable_wake_up) {
     // Try to wake up waiting thread if there is any for the given sub thread
@@ -229,7 +251,11 @@ Task ThreadWorkSource::EnqueueTask(Task t, bool is_blocking,
 }
 
 Task ThreadWorkSource::PopBlockingTask() {
-  return blocking_work_queue_.PopBack();
+  Task t = blocking_work_queue_.PopBack();
+  if (t.f) {
+    UpdateQueuedSince();
+  }
+  return t;
 }
 
 Task ThreadWorkSource::PopNonBlockingTask(int start_index,
@@ -240,6 +266,7 @@ Task ThreadWorkSource::PopNonBlockingTask(int start_index,
     t = non_blocking_work_queues_[(start_index + j) % sharding_factor]
             ->queue.PopBack();
     if (t.f) {
+      UpdateQueuedSince();
       return t;
     }
     if (!search_from_all_queue) {
@@ -267,6 +294,39 @@ int64_t ThreadWorkSource::GetTracemeId() {
 
 void ThreadWorkSource::SetTracemeId(int64_t value) { traceme_id_ = value; }
 
+int64_t ThreadWorkSource::GetPriority() {
+  return priority_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::SetPriority(int64_t value) {
+  if (priority_.exchange(value, std::memory_order_relaxed) != value) {
+    queue_wait_time_cell_.store(
+        QueueWaitTimeUs()->GetCell(tensorflow::strings::StrCat(value)),
+        std::memory_order_relaxed);
+  }
+}
+
+uint64_t ThreadWorkSource::GetQueuedSinceUs() {
+  return queued_since_us_.load(std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::UpdateQueuedSince() {
+  // This races with concurrent enqueues, which is fine as the value is only
+  // used as a scheduling hint.
+  const bool has_queued_tasks =
+      TaskQueueSize(/*is_blocking=*/true) > 0 ||
+      TaskQueueSize(/*is_blocking=*/false) > 0;
+  queued_since_us_.store(
+      has_queued_tasks ? tensorflow::EnvTime::NowMicros() : 0,
+      std::memory_order_relaxed);
+}
+
+void ThreadWorkSource::RecordQueueWaitTime(const Task& t, uint64_t now_us) {
+  const uint64_t enqueue_time_us = t.f->enqueue_time_us;
+  queue_wait_time_cell_.load(std::memory_order_relaxed)
+      ->Add(now_us > enqueue_time_us ? now_us - enqueue_time_us : 0);
+}
+
 void ThreadWorkSource::SetWaiter(uint64_t version, Waiter* waiter,
                                  tensorflow::mutex* mutex) {
   {
@@ -325,7 +385,7 @@ unsigned ThreadWorkSource::NonBlockingWorkShardingFactor() {
 
 std::string ThreadWorkSource::ToString() {
   return tensorflow::strings::StrCat(
-      "traceme_id = ", GetTracemeId(),
+      "traceme_id = ", GetTracemeId(), ", priority = ", GetPriority(),
       ", inter queue size = ", TaskQueueSize(true),
       ", inter inflight = ", GetInflightTaskCount(true),
       ", intra queue size = ", TaskQueueSize(false),
@@ -348,6 +408,7 @@ RunHandlerThreadPool::RunHandlerThreadPool(
       blocking_thread_max_waiting_time_(
           options.blocking_threads_max_sleep_time_micro_sec),
       enable_wake_up_(options.enable_wake_up),
+      starvation_threshold_us_(options.starvation_threshold_micro_sec),
       thread_data_(num_threads_),
       env_(env, thread_options, name),
       name_(name),
@@ -476,9 +537,23 @@ Task RunHandlerThreadPool::FindTask(
     const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources,
     bool* task_from_blocking_queue, ThreadWorkSource** tws) {
   Task t;
-  int current_index = thread_data_[thread_id].current_index;
   *task_from_blocking_queue = false;
 
+  // Serve starved requests first.
+  if (starvation_threshold_us_ > 0) {
+    ThreadWorkSource* starved = FindStarvedWorkSource(
+        searching_range_start, searching_range_end, thread_work_sources);
+    if (starved != nullptr) {
+      t = PopTask(starved, thread_id, max_blocking_inflight,
+                  may_steal_blocking_work, task_from_blocking_queue);
+      if (t.f) {
+        *tws = starved;
+        return t;
+      }
+    }
+  }
+
+  int current_index = thread_data_[thread_id].current_index;
   for (int i = 0; i < searching_range_end - searching_range_start; ++i) {
     if (current_index >= searching_range_end ||
         current_index < searching_range_start) {
@@ -487,18 +562,8 @@ Task RunHandlerThreadPool::FindTask(
     *tws = thread_work_sources[current_index];
     ++current_index;
 
-    // For blocking thread, search for blocking tasks first.
-    if (may_steal_blocking_work &&
-        (*tws)->GetInflightTaskCount(true) < max_blocking_inflight) {
-      t = (*tws)->PopBlockingTask();
-      if (t.f) {
-        *task_from_blocking_queue = true;
-        break;
-      }
-    }
-
-    // Search for non-blocking tasks.
-    t = (*tws)->PopNonBlockingTask(thread_id, true);
+    t = PopTask(*tws, thread_id, max_blocking_inflight,
+                may_steal_blocking_work, task_from_blocking_queue);
     if (t.f) {
       break;
     }
@@ -507,6 +572,48 @@ Task RunHandlerThreadPool::FindTask(
   return t;
 }
 
+Task RunHandlerThreadPool::PopTask(ThreadWorkSource* tws, int thread_id,
+                                   int max_blocking_inflight,
+                                   bool may_steal_blocking_work,
+                                   bool* task_from_blocking_queue) {
+  // For blocking thread, search for blocking tasks first.
+  if (may_steal_blocking_work &&
+      tws->GetInflightTaskCount(true) < max_blocking_inflight) {
+    Task t = tws->PopBlockingTask();
+    if (t.f) {
+      *task_from_blocking_queue = true;
+      return t;
+    }
+  }
+
+  // Search for non-blocking tasks.
+  return tws->PopNonBlockingTask(thread_id, true);
+}
+
+ThreadWorkSource* RunHandlerThreadPool::FindStarvedWorkSource(
+    int searching_range_start, int searching_range_end,
+    const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources) {
+  const uint64_t now = tensorflow::EnvTime::NowMicros();
+  ThreadWorkSource* starved = nullptr;
+  int64_t starved_priority = 0;
+  uint64_t starved_since = 0;
+  for (int i = searching_range_start; i < searching_range_end; ++i) {
+    ThreadWorkSource* tws = thread_work_sources[i];
+    const uint64_t queued_since = tws->GetQueuedSinceUs();
+    if (queued_since == 0 || queued_since + starvation_threshold_us_ > now) {
+      continue;
+    }
+    const int64_t priority = tws->GetPriority();
+    if (starved == nullptr || priority > starved_priority ||
+        (priority == starved_priority && queued_since < starved_since)) {
+      starved = tws;
+      starved_priority = priority;
+      starved_since = queued_since;
+    }
+  }
+  return starved;
+}
+
 // Main worker thread loop.
 void RunHandlerThreadPool::WorkerLoop(int thread_id,
                                       bool may_steal_blocking_work) {
@@ -573,6 +680,7 @@ void RunHandlerThreadPool::WorkerLoop(int thread_id,
     if (t.f) {
       VLOG(2) << "Running " << (task_from_blocking_queue ? "inter" : "intra")
               << " work from " << tws->GetTracemeId();
+      tws->RecordQueueWaitTime(t, tensorflow::EnvTime::NowMicros());
       tws->IncrementInflightTaskCount(task_from_blocking_queue);
       env_.ExecuteTask(t);
       tws->DecrementInflightTaskCount(task_from_blocking_queue);
@@ -724,7 +832,8 @@ class RunHandlerPool::Impl {
                 options.use_adaptive_waiting_time, options.enable_wake_up,
                 options.max_concurrent_handler,
                 options.num_threads_in_sub_thread_pool,
-                options.sub_thread_request_percentage),
+                options.sub_thread_request_percentage,
+                options.starvation_threshold_micro_sec),
             tensorflow::Env::Default(), tensorflow::ThreadOptions(),
             "tf_run_handler_pool", &waiters_mu_, &queue_waiters_)),
         iterations_(0),
@@ -1010,6 +1119,7 @@ void RunHandler::Impl::Reset(int64_t step_id,
   step_id_ = step_id;
   options_ = options;
   tws_.SetTracemeId(step_id);
+  tws_.SetPriority(options.priority);
 }
 
 int RunHandler::Impl::RunHandlerEigenThreadPool::NumThreads() const {
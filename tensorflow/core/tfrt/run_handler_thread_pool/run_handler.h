@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/context.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -39,7 +40,9 @@ class RunHandler;
 struct RunHandlerOptions {
   RunHandlerOptions() : priority(0) {}
 
-  // Request priority.
+  // Request priority. Requests with a higher priority are served first, and
+  // their queued work is stolen first once it starves (see
+  // `RunHandlerPool::Options::starvation_threshold_micro_sec`).
   int priority;
 };
 
@@ -101,6 +104,13 @@ class RunHandlerPool {
 
     // If true, threads will be waken up by new tasks.
     bool enable_wake_up = true;
+
+    // If positive, a request whose queued work has not been served for this
+    // long is considered starved, and threads looking for work serve starved
+    // requests first, in priority order and then oldest first, before falling
+    // back to the round robin search. This prevents long running requests from
+    // starving newer ones under bursty workloads.
+    int starvation_threshold_micro_sec = 0;
   };
   explicit RunHandlerPool(Options options);
   ~RunHandlerPool();
@@ -175,6 +185,8 @@ class RunHandlerEnvironment {
     TaskFunction f;
     tensorflow::Context context;
     uint64_t trace_id;
+    // Time (in microseconds) at which the task was created.
+    uint64_t enqueue_time_us;
   };
   tensorflow::Env* const env_;
   const tensorflow::ThreadOptions thread_options_;
@@ -232,6 +244,20 @@ class ThreadWorkSource {
 
   void SetTracemeId(int64_t value);
 
+  int64_t GetPriority();
+
+  // Sets the priority of the request this work source belongs to, which is
+  // used to pick starved work sources and to label queue wait times.
+  void SetPriority(int64_t value);
+
+  // Returns the time (in microseconds) since which the queued tasks of this
+  // work source have been waiting without any of them being dequeued, or 0 if
+  // no task is queued. This is a best effort estimate.
+  uint64_t GetQueuedSinceUs();
+
+  // Records the time `t` waited in the queue, labeled with the priority.
+  void RecordQueueWaitTime(const Task& t, uint64_t now_us);
+
   void SetWaiter(uint64_t version, Waiter* waiter, tensorflow::mutex* mutex);
 
   int64_t GetInflightTaskCount(bool is_blocking);
@@ -251,6 +277,10 @@ class ThreadWorkSource {
   std::string ToString();
 
  private:
+  // Called after a task is dequeued, since the remaining queued tasks, if
+  // any, have made progress.
+  void UpdateQueuedSince();
+
   struct NonBlockingQueue {
     tensorflow::mutex queue_op_mu;
     char pad[128];
@@ -273,6 +303,11 @@ class ThreadWorkSource {
   tensorflow::mutex waiters_mu_;
   Waiter queue_waiters_ TF_GUARDED_BY(waiters_mu_);
   std::atomic<int64_t> traceme_id_;
+  std::atomic<int64_t> priority_;
+  // See `GetQueuedSinceUs()`.
+  std::atomic<uint64_t> queued_since_us_;
+  // Queue wait time histogram for the current priority.
+  std::atomic<tensorflow::monitoring::SamplerCell*> queue_wait_time_cell_;
 
   tensorflow::mutex run_handler_waiter_mu_;
   uint64_t version_ TF_GUARDED_BY(run_handler_waiter_mu_);
@@ -294,6 +329,7 @@ class RunHandlerThreadPool {
     int max_concurrent_handler;
     std::vector<int> num_threads_in_sub_thread_pool;
     std::vector<double> sub_thread_request_percentage;
+    int starvation_threshold_micro_sec;
     Options(int num_blocking_threads, int num_non_blocking_threads,
             bool wait_if_no_active_request,
             int non_blocking_threads_sleep_time_micro_sec,
@@ -301,7 +337,8 @@ class RunHandlerThreadPool {
             bool use_adaptive_waiting_time, bool enable_wake_up,
             int max_concurrent_handler,
             const std::vector<int>& num_threads_in_sub_thread_pool,
-            const std::vector<double>& sub_thread_request_percentage)
+            const std::vector<double>& sub_thread_request_percentage,
+            int starvation_threshold_micro_sec = 0)
         : num_blocking_threads(num_blocking_threads),
           num_non_blocking_threads(num_non_blocking_threads),
           wait_if_no_active_request(wait_if_no_active_request),
@@ -313,7 +350,8 @@ class RunHandlerThreadPool {
           enable_wake_up(enable_wake_up),
           max_concurrent_handler(max_concurrent_handler),
           num_threads_in_sub_thread_pool(num_threads_in_sub_thread_pool),
-          sub_thread_request_percentage(sub_thread_request_percentage) {}
+          sub_thread_request_percentage(sub_thread_request_percentage),
+          starvation_threshold_micro_sec(starvation_threshold_micro_sec) {}
   };
   struct PerThread {
     constexpr PerThread() : pool(nullptr), thread_id(-1) {}
@@ -354,7 +392,9 @@ class RunHandlerThreadPool {
 
   // Search tasks from Requets range searching_range_start to
   // searching_range_end. If there is no tasks in the search range and
-  // may_steal_blocking_work is true, then search from all requests.
+  // may_steal_blocking_work is true, then search from all requests. If a
+  // starvation threshold is set, starved requests in the range are searched
+  // first, in priority order and then oldest first.
   Task FindTask(
       int searching_range_start, int searching_range_end, int thread_id,
       int sub_thread_pool_id, int max_blocking_inflight,
@@ -366,6 +406,19 @@ class RunHandlerThreadPool {
                                   int sub_thread_pool_id);
 
  private:
+  // Pops a task from `tws`, searching the blocking queue first if
+  // `may_steal_blocking_work` is true and the blocking inflight tasks are
+  // below `max_blocking_inflight`.
+  Task PopTask(ThreadWorkSource* tws, int thread_id, int max_blocking_inflight,
+               bool may_steal_blocking_work, bool* task_from_blocking_queue);
+
+  // Returns the work source in the given range whose queued work has waited
+  // for at least the starvation threshold, with the highest priority and then
+  // the longest wait, or nullptr if there is none.
+  ThreadWorkSource* FindStarvedWorkSource(
+      int searching_range_start, int searching_range_end,
+      const Eigen::MaxSizeVector<ThreadWorkSource*>& thread_work_sources);
+
   struct ThreadData {
     ThreadData();
     tensorflow::mutex mu;
@@ -392,6 +445,7 @@ class RunHandlerThreadPool {
   const int non_blocking_thread_sleep_time_;
   const int blocking_thread_max_waiting_time_;
   const bool enable_wake_up_;
+  const int starvation_threshold_us_;
   Eigen::MaxSizeVector<ThreadData> thread_data_;
   internal::RunHandlerEnvironment env_;
   std::atomic<bool> cancelled_;
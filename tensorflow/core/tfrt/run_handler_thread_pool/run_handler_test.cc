@@ -30,6 +30,8 @@ limitations under the License.
 #include "absl/synchronization/notification.h"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/lib/monitoring/test_utils.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
@@ -39,6 +41,9 @@ namespace tfrt {
 namespace tf {
 namespace {
 
+using ::tensorflow::monitoring::testing::CellReader;
+using ::tensorflow::monitoring::testing::Histogram;
+
 TEST(RunHandlerUtilTest, TestBasicScheduling) {
   int num_threads = 2;
   int num_handlers = 10;
@@ -134,6 +139,28 @@ TEST(RunHandlerUtilTest, IntraOpThreadPool) {
   notification.WaitForNotification();
 }
 
+TEST(RunHandlerUtilTest, RecordsQueueWaitTimePerPriority) {
+  CellReader<Histogram> queue_wait_time(
+      "/tensorflow/tfrt/run_handler/queue_wait_time_us");
+  RunHandlerPool::Options pool_options;
+  pool_options.num_inter_op_threads = 1;
+  pool_options.num_intra_op_threads = 1;
+  std::unique_ptr<RunHandlerPool> pool(new RunHandlerPool(pool_options));
+
+  RunHandlerOptions options = RunHandlerOptions();
+  options.priority = 7;
+  auto handler = pool->Get(/*step_id=*/1, /*timeout_in_ms=*/0, options);
+  tensorflow::BlockingCounter counter(2);
+  for (int i = 0; i < 2; ++i) {
+    handler->ScheduleInterOpClosure(
+        TaskFunction([&counter]() { counter.DecrementCount(); }));
+  }
+  counter.Wait();
+  handler.reset();
+  EXPECT_FLOAT_EQ(queue_wait_time.Delta("7").num(), 2.0);
+  EXPECT_FLOAT_EQ(queue_wait_time.Delta("0").num(), 0.0);
+}
+
 class RunHandlerThreadPoolTest
     : public testing::TestWithParam<std::tuple<bool, bool>> {
  protected:
@@ -477,6 +504,70 @@ TEST_P(RunHandlerThreadPoolTest, FindTask) {
   }
 }
 
+TEST_P(RunHandlerThreadPoolTest, FindTaskServesStarvedRequestsFirst) {
+  Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
+  waiters_mu.resize(1);
+  Eigen::MaxSizeVector<internal::Waiter> waiters(1);
+  waiters.resize(1);
+  internal::RunHandlerThreadPool run_handler_thread_pool(
+      internal::RunHandlerThreadPool::Options(
+          /*num_blocking_threads=*/1, /*num_non_blocking_threads=*/0,
+          /*wait_if_no_active_request=*/true,
+          /*non_blocking_threads_sleep_time_micro_sec=*/250,
+          /*blocking_threads_max_sleep_time_micro_sec=*/250,
+          /*use_adaptive_waiting_time=*/true, /*enable_wake_up=*/true,
+          /*max_concurrent_handler=*/128,
+          /*num_threads_in_sub_thread_pool=*/{1},
+          /*sub_thread_request_percentage=*/{1},
+          /*starvation_threshold_micro_sec=*/1000),
+      tensorflow::Env::Default(), tensorflow::ThreadOptions(),
+      "tf_run_handler_pool", &waiters_mu, &waiters);
+
+  Eigen::MaxSizeVector<internal::ThreadWorkSource*> thread_work_sources(3);
+  thread_work_sources.resize(3);
+  internal::ThreadWorkSource tws[3];
+  for (int i = 0; i < 3; ++i) {
+    tws[i].SetWaiter(1, &waiters[0], &waiters_mu[0]);
+    thread_work_sources[i] = &tws[i];
+  }
+  tws[2].SetPriority(1);
+
+  int result = -1;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(tws[i].GetQueuedSinceUs(), 0);
+    run_handler_thread_pool.AddWorkToQueue(
+        &tws[i], /*is_blocking=*/true, TaskFunction([&result, i] {
+          result = i;
+        }));
+    EXPECT_GT(tws[i].GetQueuedSinceUs(), 0);
+  }
+  // Let all the requests starve.
+  tensorflow::Env::Default()->SleepForMicroseconds(2000);
+
+  const auto find_task = [&](internal::Task* t) {
+    internal::ThreadWorkSource* found_tws;
+    bool task_from_blocking_queue;
+    *t = run_handler_thread_pool.FindTask(
+        /*searching_range_start=*/0, /*searching_range_end=*/3,
+        /*thread_id=*/0,
+        /*sub_thread_pool_id=*/0, /*max_blocking_inflight=*/10,
+        /*may_steal_blocking_work=*/true, thread_work_sources,
+        &task_from_blocking_queue, &found_tws);
+  };
+  // The starved request with the highest priority is served first, and then
+  // the one that has been starved the longest.
+  internal::Task t;
+  for (int expected : {2, 0, 1}) {
+    find_task(&t);
+    ASSERT_NE(t.f, nullptr);
+    t.f->f();
+    EXPECT_EQ(result, expected);
+    EXPECT_EQ(tws[expected].GetQueuedSinceUs(), 0);
+  }
+  find_task(&t);
+  EXPECT_EQ(t.f, nullptr);
+}
+
 TEST_P(RunHandlerThreadPoolTest, RoundRobinExecution) {
   Eigen::MaxSizeVector<tensorflow::mutex> waiters_mu(1);
   waiters_mu.resize(1);
@@ -582,12 +582,31 @@ std::unique_ptr<SavedModel> SavedModelImpl::LoadSavedModel(
                               std::move(*meta_graph_def->mutable_graph_def())));
 
     // Finally, create the saved model.
-    return {std::make_unique<SavedModelImpl>(
+    auto saved_model_impl = std::make_unique<SavedModelImpl>(
         std::move(options), *std::move(meta_graph_def), std::move(bef),
         std::move(bef_file),
         std::move(initializers_and_signatures.signature_map),
         std::move(fallback_state), std::move(tpu_model_resource),
-        std::move(resource_context), std::move(graph_executor))};
+        std::move(resource_context), std::move(graph_executor));
+
+    // Load the warmup signatures upfront if the other signatures are loaded
+    // lazily.
+    if (lazy_loading_enabled) {
+      const auto warmup_start_time = absl::Now();
+      const auto& warmup_signatures =
+          saved_model_impl->options_.lazy_loading_warmup_signatures;
+      for (const auto& name : warmup_signatures) {
+        TF_RET_CHECK(saved_model_impl->signatures_.contains(name))
+            << "failed to find warmup signature " << name << " in the graph";
+        TF_RETURN_IF_ERROR(
+            saved_model_impl->GetOrCreateLoadingResult({name}).status());
+      }
+      LOG(INFO) << "TFRT finished loading " << warmup_signatures.size()
+                << " warmup signatures. Took "
+                << absl::ToInt64Milliseconds(absl::Now() - warmup_start_time)
+                << " ms.";
+    }
+    return {std::move(saved_model_impl)};
   }();
 
   if (!saved_model.ok()) {
@@ -121,6 +121,12 @@ class SavedModel {
     // will be loaded along with the saved model.
     int32_t lazy_loading_threshold = std::numeric_limits<int32_t>::max();
 
+    // If lazy loading is enabled, the signatures listed here are still loaded
+    // along with the saved model, so that their first invocation does not pay
+    // for pruning and compiling their subgraph. It is an error to list a
+    // signature that is not in the saved model.
+    std::vector<std::string> lazy_loading_warmup_signatures;
+
     // If true, we'll attempt to find MLArchive within the given loading path.
     // If not found, will use the path as a normal SavedModel directory.
     bool maybe_load_from_mla = false;
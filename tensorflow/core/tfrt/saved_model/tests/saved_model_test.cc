@@ -134,6 +134,53 @@ TEST(SavedModelTest, CostMeasurementEnabled) {
   ASSERT_EQ(op_count, 3);
 }
 
+TEST(SavedModelTest, LazyLoadingWarmupSignatures) {
+  std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
+      "tensorflow/core/tfrt/saved_model/tests/toy_v1");
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  auto options = DefaultSavedModelOptions(runtime.get());
+  options.lazy_loading_threshold = 0;
+  options.lazy_loading_warmup_signatures = {"toy"};
+
+  tensorflow::Status status;
+  auto saved_model =
+      SavedModelImpl::LoadSavedModel(options, saved_model_dir,
+                                     /*tags=*/{"serve"}, &status);
+  TF_CHECK_OK(status);
+
+  std::vector<tensorflow::Tensor> inputs;
+  inputs.push_back(
+      CreateTfTensor<int32_t>(/*shape=*/{1, 3}, /*data=*/{1, 1, 1}));
+
+  // Both the warmed up signature and a lazily loaded one can run.
+  std::vector<tensorflow::Tensor> outputs;
+  TF_ASSERT_OK(saved_model->Run(/*run_options=*/{}, "toy", inputs, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  EXPECT_THAT(GetTfTensorData<int32_t>(outputs[0]),
+              ::testing::ElementsAreArray({6}));
+  TF_ASSERT_OK(
+      saved_model->Run(/*run_options=*/{}, "another_toy", inputs, &outputs));
+  EXPECT_EQ(outputs.size(), 2);
+}
+
+TEST(SavedModelTest, LazyLoadingUnknownWarmupSignature) {
+  std::string saved_model_dir = tensorflow::GetDataDependencyFilepath(
+      "tensorflow/core/tfrt/saved_model/tests/toy_v1");
+
+  auto runtime = DefaultTfrtRuntime(/*num_threads=*/1);
+  auto options = DefaultSavedModelOptions(runtime.get());
+  options.lazy_loading_threshold = 0;
+  options.lazy_loading_warmup_signatures = {"unknown"};
+
+  tensorflow::Status status;
+  auto saved_model =
+      SavedModelImpl::LoadSavedModel(options, saved_model_dir,
+                                     /*tags=*/{"serve"}, &status);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(saved_model, nullptr);
+}
+
 TEST(SavedModelTest, BasicV2) {
   // SavedModel toy contains a graph of a single 'tf.AddV2' op. It is generated
   // using the following python code:
@@ -16,13 +16,25 @@ limitations under the License.
 // For Google-internal use only.
 #include "tensorflow/core/util/autotune_maps/autotune_serialize.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
 #include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/compiler/xla/stream_executor/dnn.h"
 #include "tensorflow/compiler/xla/stream_executor/dnn.pb.h"
+#include "tensorflow/compiler/xla/stream_executor/stream_executor.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/util/activation_mode.h"
 #include "tensorflow/core/util/autotune_maps/autotune_map.pb.h"
@@ -178,6 +190,43 @@ Status PopulateConvMap(
 }  // namespace
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
 
+namespace {
+
+// Adds the entries of `update` to `base`, replacing the entries of `base`
+// with the same key, and sorts the result by key.
+void MergeConvMapProto(const ConvMapProto &update, ConvMapProto *base) {
+  std::map<string, ConvMapProto::Entry> sorted_map;
+  for (const ConvMapProto::Entry &kv : base->kv_pairs()) {
+    sorted_map[autotune_maps_utils::SerializeProtoDeterministic(kv.key())] = kv;
+  }
+  for (const ConvMapProto::Entry &kv : update.kv_pairs()) {
+    sorted_map[autotune_maps_utils::SerializeProtoDeterministic(kv.key())] = kv;
+  }
+  base->clear_kv_pairs();
+  for (auto const &p : sorted_map) {
+    *base->add_kv_pairs() = p.second;
+  }
+}
+
+// Path of the file the autotune maps are saved to on exit.
+std::string *PersistentAutotuneMapsPath() {
+  static std::string *path = new std::string;
+  return path;
+}
+
+void SavePersistentAutotuneMaps() {
+  const std::string &path = *PersistentAutotuneMapsPath();
+  Status status = SaveAutotuneMapsToFile(path);
+  if (status.ok()) {
+    VLOG(1) << "Saved autotune maps to " << path;
+  } else {
+    LOG(WARNING) << "Failed to save autotune maps to " << path << ": "
+                 << status;
+  }
+}
+
+}  // namespace
+
 Status SerializeAutotuneMaps(std::string *output) {
   AutotuneMapsProto proto;
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -208,6 +257,110 @@ Status LoadSerializedAutotuneMaps(absl::string_view s) {
   return OkStatus();
 }
 
+Status LoadAutotuneMapsFromFile(const std::string &path) {
+  std::string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path, &contents));
+  return LoadSerializedAutotuneMaps(contents);
+}
+
+Status SaveAutotuneMapsToFile(const std::string &path) {
+  Env *env = Env::Default();
+  AutotuneMapsProto proto;
+  if (env->FileExists(path).ok()) {
+    std::string contents;
+    TF_RETURN_IF_ERROR(ReadFileToString(env, path, &contents));
+    if (!proto.ParseFromString(contents)) {
+      LOG(WARNING) << "Replacing autotune maps file that cannot be parsed: "
+                   << path;
+      proto.Clear();
+    }
+  }
+
+  std::string serialized;
+  TF_RETURN_IF_ERROR(SerializeAutotuneMaps(&serialized));
+  AutotuneMapsProto runtime_proto;
+  if (!runtime_proto.ParseFromString(serialized)) {
+    return errors::Internal("Failed to parse the serialized autotune maps.");
+  }
+  MergeConvMapProto(runtime_proto.conv_map(), proto.mutable_conv_map());
+  MergeConvMapProto(runtime_proto.fused_conv_map(),
+                    proto.mutable_fused_conv_map());
+
+  // Write to a unique temporary file first, so that readers never see a
+  // partially written file.
+  const std::string tmp_path =
+      absl::StrCat(path, ".tmp.", absl::Hex(random::New64()));
+  TF_RETURN_IF_ERROR(WriteStringToFile(
+      env, tmp_path, autotune_maps_utils::SerializeProtoDeterministic(proto)));
+  Status status = env->RenameFile(tmp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_path).IgnoreError();
+  }
+  return status;
+}
+
+std::string AutotuneMapsFileName(stream_executor::StreamExecutor *executor) {
+  std::vector<std::string> fingerprint;
+#if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  fingerprint.push_back(absl::StrCat("version ", ConvParameters::kVersion));
+  std::vector<std::string> device_identifiers =
+      autotune_maps_utils::GetDeviceIdToIdentifierMap();
+  std::sort(device_identifiers.begin(), device_identifiers.end());
+  device_identifiers.erase(
+      std::unique(device_identifiers.begin(), device_identifiers.end()),
+      device_identifiers.end());
+  fingerprint.push_back(absl::StrJoin(device_identifiers, ", "));
+
+  const auto &description = executor->GetDeviceDescription();
+  fingerprint.push_back(
+      absl::StrCat("driver ", description.driver_version()));
+  fingerprint.push_back(
+      absl::StrCat("runtime ", description.runtime_version()));
+  std::string dnn_version = "none";
+  if (auto *dnn = executor->AsDnn()) {
+    auto version = dnn->GetVersion();
+    if (version.ok()) {
+      dnn_version = absl::StrCat(version->major_version(), ".",
+                                 version->minor_version(), ".",
+                                 version->patch());
+    }
+  }
+  fingerprint.push_back(absl::StrCat("dnn ", dnn_version));
+#endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
+  const std::string joined = absl::StrJoin(fingerprint, "; ");
+  VLOG(1) << "Autotune maps fingerprint: " << joined;
+  return absl::StrCat("autotune_maps_",
+                      absl::Hex(Hash64(joined), absl::kZeroPad16), ".pb");
+}
+
+void InitPersistentAutotuneMaps(stream_executor::StreamExecutor *executor) {
+  static const bool initialized = [executor] {
+    const char *dir = getenv("TF_AUTOTUNE_CACHE_DIR");
+    if (dir == nullptr || dir[0] == '\0') return false;
+    Env *env = Env::Default();
+    Status status = env->RecursivelyCreateDir(dir);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to create autotune cache directory " << dir
+                   << ": " << status;
+      return false;
+    }
+    const std::string path = io::JoinPath(dir, AutotuneMapsFileName(executor));
+    *PersistentAutotuneMapsPath() = path;
+    if (env->FileExists(path).ok()) {
+      status = LoadAutotuneMapsFromFile(path);
+      if (status.ok()) {
+        LOG(INFO) << "Loaded autotune maps from " << path;
+      } else {
+        LOG(WARNING) << "Failed to load autotune maps from " << path << ": "
+                     << status;
+      }
+    }
+    std::atexit(SavePersistentAutotuneMaps);
+    return true;
+  }();
+  (void)initialized;
+}
+
 void ResetAutotuneMaps() {
 #if GOOGLE_CUDA || TENSORFLOW_USE_ROCM
   ConvAutotuneMap::GetInstance()->ClearMap();
@@ -18,7 +18,9 @@ limitations under the License.
 // Supports serializing the autotune maps to string
 // (SerializeAutotuneMaps), as well as deserializing them from
 // string and injecting them into TF runtime
-// (LoadSerializedAutotuneMaps).
+// (LoadSerializedAutotuneMaps). The maps can also be persisted in a file
+// that is shared by the processes running on the same kind of GPU
+// (InitPersistentAutotuneMaps).
 //
 // Aims to speed up the warmup time of neural nets.
 
@@ -29,6 +31,10 @@ limitations under the License.
 
 #include "tensorflow/core/platform/status.h"
 
+namespace stream_executor {
+class StreamExecutor;
+}  // namespace stream_executor
+
 namespace tensorflow {
 
 // TODO(b/189530096) Support autotune maps for more ops.
@@ -40,6 +46,28 @@ Status LoadSerializedAutotuneMaps(absl::string_view s);
 // LoadSerializedAutotuneMaps.
 Status SerializeAutotuneMaps(std::string* output);
 
+// Loads the autotune maps from the file at `path` written by
+// SaveAutotuneMapsToFile.
+Status LoadAutotuneMapsFromFile(const std::string& path);
+
+// Writes the autotune maps to the file at `path`. Entries already in the file
+// are kept, unless the autotune maps have an entry for the same operation.
+// The file is replaced atomically, so concurrent writers may lose each
+// other's entries but never leave a partially written file.
+Status SaveAutotuneMapsToFile(const std::string& path);
+
+// Returns the base name of the file that holds the autotune results for the
+// GPU models of this machine and the driver and DNN library used by
+// `executor`, so that results measured with a different driver or library
+// are not reused.
+std::string AutotuneMapsFileName(stream_executor::StreamExecutor* executor);
+
+// If the environment variable TF_AUTOTUNE_CACHE_DIR is set, loads the
+// autotune maps from the file named by AutotuneMapsFileName in that
+// directory, and saves them back to it when the process exits. Only the first
+// call has an effect.
+void InitPersistentAutotuneMaps(stream_executor::StreamExecutor* executor);
+
 // Resets all autotune maps. For test use only.
 void ResetAutotuneMaps();
 
@@ -20,6 +20,8 @@ limitations under the License.
 
 #include "absl/types/variant.h"
 #include "tensorflow/compiler/xla/stream_executor/gpu/gpu_driver.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/util/autotune_maps/conv_autotune_maps.h"
@@ -173,6 +175,48 @@ TEST(AutotuneSerializeTest, VersionControl) {
                HasSubstr("Aborted because the loaded autotune results")));
   EXPECT_EQ(ConvAutotuneMap::GetInstance()->GetMap().size(), 0);
 }
+
+// Tests that SaveAutotuneMapsToFile keeps the entries already in the file,
+// and that LoadAutotuneMapsFromFile restores the merged entries.
+TEST(AutotuneSerializeTest, MergesIntoFile) {
+  TF_CHECK_OK(GpuDriver::Init());
+  ResetAutotuneMaps();
+  const std::string path =
+      io::JoinPath(testing::TmpDir(), "autotune_maps_merge.pb");
+  Env::Default()->DeleteFile(path).IgnoreError();
+
+  auto make_params = [](int64_t batch) {
+    return ConvParameters(
+        batch, /*in_depths=*/1, /*in=*/{{1, 1}},
+        /*data_format=*/TensorFormat::FORMAT_NCHW, /*out_depths=*/1,
+        /*filter=*/{{1, 1}}, /*dilation=*/{{1, 1}}, /*stride=*/{{1, 1}},
+        /*padding=*/{{1, 1}}, /*dtype=*/DataType::DT_FLOAT, /*device_id=*/0,
+        /*group_count=*/1);
+  };
+  const ConvParameters params_a = make_params(1);
+  const ConvParameters params_b = make_params(2);
+  AutotuneEntry<se::dnn::ConvOp> entry_a(
+      AlgorithmDesc(/*algo_id=*/1, /*use_tensor_ops=*/true), absl::nullopt);
+  AutotuneEntry<se::dnn::ConvOp> entry_b(
+      AlgorithmDesc(/*algo_id=*/2, /*use_tensor_ops=*/false), absl::nullopt);
+
+  // The first process autotunes `params_a`, and the second one `params_b`.
+  ConvAutotuneMap::GetInstance()->Insert(params_a, entry_a);
+  TF_ASSERT_OK(SaveAutotuneMapsToFile(path));
+  ResetAutotuneMaps();
+  ConvAutotuneMap::GetInstance()->Insert(params_b, entry_b);
+  TF_ASSERT_OK(SaveAutotuneMapsToFile(path));
+
+  ResetAutotuneMaps();
+  TF_ASSERT_OK(LoadAutotuneMapsFromFile(path));
+  EXPECT_EQ(ConvAutotuneMap::GetInstance()->GetMap().size(), 2);
+  AutotuneEntry<se::dnn::ConvOp> entry;
+  EXPECT_TRUE(ConvAutotuneMap::GetInstance()->Find(params_a, &entry));
+  EXPECT_EQ(entry, entry_a);
+  EXPECT_TRUE(ConvAutotuneMap::GetInstance()->Find(params_b, &entry));
+  EXPECT_EQ(entry, entry_b);
+}
+
 }  // namespace
 }  // namespace tensorflow
 #endif  // GOOGLE_CUDA || TENSORFLOW_USE_ROCM
@@ -14,8 +14,13 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <cstring>
 #include <vector>
 
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_map.h"
 #include "tensorflow/core/example/example.pb.h"
@@ -25,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -113,6 +119,96 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+// Returns the number of varints in a packed field, which is the number of
+// bytes without a continuation bit. The compiler vectorizes the loop.
+inline size_t CountPackedVarints(const uint8* begin, const uint8* end) {
+  size_t count = 0;
+  for (const uint8* p = begin; p < end; ++p) count += *p < 0x80;
+  return count;
+}
+
+// Decodes the varint at `*p` one byte at a time, without reading past `end`,
+// and advances `*p` past it. Returns false if the varint is longer than 10
+// bytes or truncated.
+inline bool DecodeVarintSlow(const uint8** p, const uint8* end,
+                             uint64* value) {
+  uint64 result = 0;
+  for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+    const uint8 byte = *(*p)++;
+    result |= static_cast<uint64>(byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Decodes the varints of the packed field [begin, end), and stores the first
+// `max_values` of them in `out`. Returns false if the field is malformed.
+//
+// Varints of at most 8 bytes, which encode values below 2^56, are decoded
+// from a single 64-bit load: the position of the first byte without a
+// continuation bit gives the length, and the 7-bit groups are then gathered
+// without branches.
+inline bool DecodePackedVarints(const uint8* begin, const uint8* end,
+                                int64_t* out, size_t max_values) {
+  constexpr uint64 kContinuationBits = 0x8080808080808080ULL;
+  const uint8* p = begin;
+  for (size_t i = 0; p < end; ++i) {
+    uint64 value;
+    uint64 word = 0;
+    uint64 stops = 0;
+    if (port::kLittleEndian && end - p >= 8) {
+      memcpy(&word, p, sizeof(word));
+      stops = ~word & kContinuationBits;
+    }
+    if (stops != 0) {
+      // The lowest stop bit ends the varint.
+      const int num_bytes = Log2Floor64(stops & -stops) / 8 + 1;
+      if (num_bytes < 8) word &= (uint64{1} << (8 * num_bytes)) - 1;
+#if defined(__BMI2__)
+      value = _pext_u64(word, ~kContinuationBits);
+#else
+      value = 0;
+      for (int k = 0; k < 8; ++k) {
+        value |= (word >> k) & (uint64{0x7f} << (7 * k));
+      }
+#endif
+      p += num_bytes;
+    } else if (!DecodeVarintSlow(&p, end, &value)) {
+      return false;
+    }
+    if (i < max_values) out[i] = static_cast<int64_t>(value);
+  }
+  return true;
+}
+
+// Reads the packed varints in the next `packed_length` bytes of `stream`, and
+// appends them to `int64_list`, which is resized only once.
+//
+// If `int64_list` is a LimitedArraySlice, the values that do not fit are
+// dropped, and reported by its `EndDistance()` as with `push_back()`.
+template <typename Result>
+bool ReadPackedInt64s(protobuf::io::CodedInputStream* stream,
+                      uint32 packed_length, Result* int64_list) {
+  if (packed_length == 0) return true;
+  const void* data;
+  int size;
+  if (!stream->GetDirectBufferPointer(&data, &size) || size < packed_length) {
+    return false;
+  }
+  const uint8* begin = static_cast<const uint8*>(data);
+  const uint8* end = begin + packed_length;
+  const size_t initial_size = int64_list->size();
+  int64_list->resize(initial_size + CountPackedVarints(begin, end));
+  if (!DecodePackedVarints(begin, end, int64_list->data() + initial_size,
+                           int64_list->size() - initial_size)) {
+    return false;
+  }
+  return stream->Skip(packed_length);
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -299,15 +395,9 @@ class Feature {
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
         uint32 packed_length;
         if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64_t>(n));
+        if (!ReadPackedInt64s(&stream, packed_length, int64_list)) {
+          return false;
         }
-
-        stream.PopLimit(packed_limit);
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -583,6 +673,23 @@ void LogSparseFeatureDataLoss(StringPiece feature_name) {
   duplicated_sparse_feature->GetCell()->IncrementBy(1);
 }
 
+// Buffers reused across the examples parsed by one thread, so that
+// `FastParseSerializedExample` does not allocate them for every example.
+struct ExampleParserScratch {
+  explicit ExampleParserScratch(const Config& config)
+      : sparse_feature_last_example(config.sparse.size(), -1),
+        dense_feature_last_example(config.dense.size(), -1),
+        ragged_feature_last_example(config.ragged.size(), -1) {}
+
+  parsed::Example parsed_example;
+  // Index of the last example in which each feature was seen, or -1. Since
+  // every example has a different index, these are not reset between
+  // examples.
+  std::vector<int64_t> sparse_feature_last_example;
+  std::vector<int64_t> dense_feature_last_example;
+  std::vector<int64_t> ragged_feature_last_example;
+};
+
 Status FastParseSerializedExample(
     const tstring& serialized_example, const tstring& example_name,
     const size_t example_index, const Config& config,
@@ -591,18 +698,23 @@ Status FastParseSerializedExample(
     std::vector<SparseBuffer>* output_varlen_dense,
     std::vector<SparseBuffer>* output_sparse,
     std::vector<SparseBuffer>* output_ragged,
-    PerExampleFeatureStats* output_stats) {
+    PerExampleFeatureStats* output_stats, ExampleParserScratch* scratch) {
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
   DCHECK(output_ragged != nullptr);
-  parsed::Example parsed_example;
+  DCHECK(scratch != nullptr);
+  parsed::Example& parsed_example = scratch->parsed_example;
+  parsed_example.clear();
   if (!ParseExample(serialized_example, &parsed_example)) {
     return errors::InvalidArgument("Could not parse example input, value: '",
                                    serialized_example, "'");
   }
-  std::vector<int64_t> sparse_feature_last_example(config.sparse.size(), -1);
-  std::vector<int64_t> dense_feature_last_example(config.dense.size(), -1);
-  std::vector<int64_t> ragged_feature_last_example(config.ragged.size(), -1);
+  std::vector<int64_t>& sparse_feature_last_example =
+      scratch->sparse_feature_last_example;
+  std::vector<int64_t>& dense_feature_last_example =
+      scratch->dense_feature_last_example;
+  std::vector<int64_t>& ragged_feature_last_example =
+      scratch->ragged_feature_last_example;
 
   // Handle features present in the example.
   const size_t parsed_example_size = parsed_example.size();
@@ -1131,7 +1243,22 @@ Status FastParseExample(const Config& config,
                         gtl::ArraySlice<tstring> serialized,
                         gtl::ArraySlice<tstring> example_names,
                         thread::ThreadPool* thread_pool, Result* result) {
+  return FastParseExample(config, serialized, example_names, thread_pool,
+                          /*dense_outputs=*/{}, result);
+}
+
+Status FastParseExample(const Config& config,
+                        gtl::ArraySlice<tstring> serialized,
+                        gtl::ArraySlice<tstring> example_names,
+                        thread::ThreadPool* thread_pool,
+                        const std::vector<Tensor>& dense_outputs,
+                        Result* result) {
   DCHECK(result != nullptr);
+  if (!dense_outputs.empty() && dense_outputs.size() != config.dense.size()) {
+    return errors::InvalidArgument("Expected ", config.dense.size(),
+                                   " dense outputs but got ",
+                                   dense_outputs.size(), ".");
+  }
   // Check config so we can safely CHECK(false) in switches on config.*.dtype
   TF_RETURN_IF_ERROR(CheckConfigDataTypes(config));
 
@@ -1180,7 +1307,15 @@ Status FastParseExample(const Config& config,
     for (const int64_t dim : config.dense[d].shape.dim_sizes()) {
       out_shape.AddDim(dim);
     }
-    fixed_dense_values[d] = Tensor(config.dense[d].dtype, out_shape);
+    // Every example writes all of its values, so a provided output does not
+    // need to be cleared.
+    if (!dense_outputs.empty() && dense_outputs[d].IsInitialized() &&
+        dense_outputs[d].dtype() == config.dense[d].dtype &&
+        dense_outputs[d].shape() == out_shape) {
+      fixed_dense_values[d] = dense_outputs[d];
+    } else {
+      fixed_dense_values[d] = Tensor(config.dense[d].dtype, out_shape);
+    }
   }
 
   // This parameter affects performance in a big and data-dependent way.
@@ -1231,6 +1366,7 @@ Status FastParseExample(const Config& config,
     ragged_buffers[minibatch].resize(config.ragged.size());
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
+    ExampleParserScratch scratch(config);
     for (size_t e = start; e < end; ++e) {
       PerExampleFeatureStats* stats = nullptr;
       if (config.collect_feature_stats) {
@@ -1241,7 +1377,7 @@ Status FastParseExample(const Config& config,
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
           config_index, hasher, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch],
-          &ragged_buffers[minibatch], stats);
+          &ragged_buffers[minibatch], stats, &scratch);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
   };
@@ -1533,6 +1669,10 @@ Status FastParseSingleExample(const Config& config, StringPiece serialized,
   std::vector<bool> sparse_feature_already_seen(config.sparse.size(), false);
   std::vector<bool> dense_feature_already_seen(config.dense.size(), false);
   std::vector<bool> ragged_feature_already_seen(config.ragged.size(), false);
+  // Buffers for the values of variable-length features, reused across
+  // features.
+  SmallVector<tstring> bytes_list;
+  SmallVector<int64_t> int64_list;
 
   if (stats) {
     // TODO(b/111553342): This may over-count the number of features if there
@@ -1640,9 +1780,9 @@ Status FastParseSingleExample(const Config& config, StringPiece serialized,
       }
 
     } else {  // if variable length
-      SmallVector<tstring> bytes_list;
+      bytes_list.clear();
       TensorVector<float> float_list;
-      SmallVector<int64_t> int64_list;
+      int64_list.clear();
 
       const size_t num_elements_divisor =
           is_dense ? config.dense[d].elements_per_stride : 1;
@@ -1920,18 +2060,20 @@ inline int ParseFloatFeature(protobuf::io::CodedInputStream* stream,
           !stream->ReadVarint32(&packed_length)) {
         return -1;
       }
-      auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        uint32 buffer32;
-        if (!stream->ReadLittleEndian32(&buffer32)) {
-          return -1;
-        }
-        if (out != nullptr) {
+      if (packed_length % sizeof(float) != 0) return -1;
+      num_elements = packed_length / sizeof(float);
+      if (out == nullptr) {
+        if (!stream->Skip(packed_length)) return -1;
+      } else if (port::kLittleEndian) {
+        // The packed floats can be copied in bulk.
+        if (!stream->ReadRaw(out, packed_length)) return -1;
+      } else {
+        for (int i = 0; i < num_elements; ++i) {
+          uint32 buffer32;
+          if (!stream->ReadLittleEndian32(&buffer32)) return -1;
           *out++ = absl::bit_cast<float>(buffer32);
         }
-        num_elements++;
       }
-      stream->PopLimit(packed_limit);
     } else if (peek_tag == kFixed32Tag(1)) {
       while (!stream->ExpectAtEnd()) {
         uint32 buffer32;
@@ -1971,18 +2113,23 @@ inline int ParseInt64Feature(protobuf::io::CodedInputStream* stream,
           !stream->ReadVarint32(&packed_length)) {
         return -1;
       }
-      auto packed_limit = stream->PushLimit(packed_length);
-      while (!stream->ExpectAtEnd()) {
-        protobuf_uint64 n;  // There is no API for int64
-        if (!stream->ReadVarint64(&n)) {
+      if (packed_length > 0) {
+        const void* data;
+        int size;
+        if (!stream->GetDirectBufferPointer(&data, &size) ||
+            size < packed_length) {
           return -1;
         }
-        if (out != nullptr) {
-          *out++ = n;
+        const uint8* begin = static_cast<const uint8*>(data);
+        const uint8* end = begin + packed_length;
+        num_elements = CountPackedVarints(begin, end);
+        // When only counting, the varints are still decoded to validate them.
+        if (!DecodePackedVarints(begin, end, out,
+                                 out == nullptr ? 0 : num_elements) ||
+            !stream->Skip(packed_length)) {
+          return -1;
         }
-        num_elements++;
       }
-      stream->PopLimit(packed_limit);
     } else if (peek_tag == kVarintTag(1)) {
       while (!stream->ExpectAtEnd()) {
         protobuf_uint64 n;  // There is no API for int64
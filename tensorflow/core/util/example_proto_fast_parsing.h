@@ -138,6 +138,19 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         gtl::ArraySlice<tstring> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
+// Same as above, but parses the values of every fixed-length dense feature `d`
+// directly into `dense_outputs[d]` when that tensor has the dtype and the
+// batched shape of `config.dense[d]`, instead of allocating a new tensor. This
+// allows callers to reuse output buffers across batches. `dense_outputs` must
+// either be empty or have one entry per dense feature, and its tensors must not
+// be accessed concurrently.
+Status FastParseExample(const FastParseExampleConfig& config,
+                        gtl::ArraySlice<tstring> serialized,
+                        gtl::ArraySlice<tstring> example_names,
+                        thread::ThreadPool* thread_pool,
+                        const std::vector<Tensor>& dense_outputs,
+                        Result* result);
+
 // TODO(mrry): Move the hash table construction into the config object.
 typedef FastParseExampleConfig FastParseSingleExampleConfig;
 
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <limits>
 #include <utility>
 
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
@@ -217,6 +218,35 @@ TEST(FastParse, SingleInt64) {
   TestCorrectness(Serialize(example));
 }
 
+TEST(FastParse, PackedInt64AllVarintLengths) {
+  Example example;
+  auto* int64_list = (*example.mutable_features()->mutable_feature())["ids"]
+                         .mutable_int64_list();
+  // Varints of every length from 1 to 10 bytes, including negative values,
+  // which are encoded with 10 bytes.
+  for (int bits = 0; bits < 64; bits += 3) {
+    int64_list->add_value((int64_t{1} << bits) - 1);
+    int64_list->add_value(int64_t{1} << bits);
+    int64_list->add_value(-(int64_t{1} << bits));
+  }
+  int64_list->add_value(std::numeric_limits<int64_t>::max());
+  int64_list->add_value(std::numeric_limits<int64_t>::min());
+  TestCorrectness(Serialize(example));
+}
+
+TEST(FastParse, TruncatedPackedInt64) {
+  // A packed Int64List with the single value 13.
+  TestCorrectness(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01"
+      "\x0d");
+  // The same, with a continuation bit on the last byte of the packed field.
+  Example example;
+  EXPECT_FALSE(TestFastParse(
+      "\x0a\x0e\x0a\x0c\x0a\x03\x61\x67\x65\x12\x05\x1a\x03\x0a\x01"
+      "\x8d",
+      &example));
+}
+
 static string ExampleWithSomeFeatures() {
   Example example;
 
@@ -325,6 +355,42 @@ TEST(FastParse, StatsCollection) {
   }
 }
 
+TEST(FastParse, ParsesIntoProvidedDenseOutputs) {
+  const size_t kNumExamples = 5;
+  std::vector<tstring> serialized(kNumExamples, ExampleWithSomeFeatures());
+
+  FastParseExampleConfig config;
+  AddDenseFeature("float_list", DT_FLOAT, {2}, false, 2, &config);
+  AddDenseFeature("int64_list", DT_INT64, {3}, false, 3, &config);
+
+  // The first output matches the dense feature and is reused, the second one
+  // has the wrong shape and is replaced by a new tensor.
+  std::vector<Tensor> dense_outputs = {
+      Tensor(DT_FLOAT, {kNumExamples, 2}),
+      Tensor(DT_INT64, {kNumExamples, 2}),
+  };
+  for (int i = 0; i < 2; ++i) {
+    Result result;
+    TF_CHECK_OK(FastParseExample(config, serialized, {}, nullptr,
+                                 dense_outputs, &result));
+    ASSERT_EQ(2, result.dense_values.size());
+    EXPECT_EQ(dense_outputs[0].flat<float>().data(),
+              result.dense_values[0].flat<float>().data());
+    EXPECT_NE(dense_outputs[1].flat<int64_t>().data(),
+              result.dense_values[1].flat<int64_t>().data());
+    for (int e = 0; e < kNumExamples; ++e) {
+      EXPECT_EQ(2.0, result.dense_values[0].matrix<float>()(e, 1));
+      EXPECT_EQ(86942, result.dense_values[1].matrix<int64_t>()(e, 2));
+    }
+  }
+
+  Result result;
+  EXPECT_FALSE(FastParseExample(config, serialized, {}, nullptr,
+                                {Tensor(DT_FLOAT, {kNumExamples, 2})},
+                                &result)
+                   .ok());
+}
+
 string RandStr(random::SimplePhilox* rng) {
   static const char key_char_lookup[] =
       "0123456789{}~`!@#$%^&*()"
@@ -0,0 +1,313 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/delta_checkpoint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <unordered_set>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
+
+namespace tensorflow {
+
+const char* const kDeltaBaseKey = "_DELTA_BASE_PREFIX";
+const char* const kDeltaRangesSuffix = "/.DELTA_RANGES";
+const char* const kDeltaValuesSuffix = "/.DELTA_VALUES";
+
+namespace {
+
+Status CheckDeltaSupported(StringPiece key, DataType dtype,
+                           const TensorShape& shape) {
+  if (shape.dims() == 0 || !DataTypeCanUseMemcpy(dtype)) {
+    return errors::InvalidArgument(
+        "Delta checkpoints do not support tensor ", key, " of dtype ",
+        DataTypeString(dtype), " and shape ", shape.DebugString());
+  }
+  return OkStatus();
+}
+
+// Reads the tensor keyed by `key` in `reader` into a new tensor.
+Status LookupNew(BundleReader* reader, StringPiece key, Tensor* val) {
+  DataType dtype;
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(reader->LookupDtypeAndShape(key, &dtype, &shape));
+  *val = Tensor(dtype, shape);
+  return reader->Lookup(key, val);
+}
+
+// Copies the rows stored in the delta `ranges` and `values` of "key" into
+// `val`.
+Status ApplyDelta(StringPiece key, const Tensor& ranges, const Tensor& values,
+                  Tensor* val) {
+  if (ranges.dtype() != DT_INT64 || ranges.dims() != 2 ||
+      ranges.dim_size(1) != 2) {
+    return errors::DataLoss("Invalid delta ranges for tensor ", key, ": ",
+                            ranges.DebugString());
+  }
+  TensorShape row_shape = val->shape();
+  row_shape.RemoveDim(0);
+  TensorShape values_row_shape = values.shape();
+  if (values.dims() > 0) values_row_shape.RemoveDim(0);
+  if (values.dtype() != val->dtype() || values.dims() == 0 ||
+      !values_row_shape.IsSameSize(row_shape)) {
+    return errors::DataLoss("Delta values of tensor ", key, " with dtype ",
+                            DataTypeString(values.dtype()), " and shape ",
+                            values.shape().DebugString(),
+                            " do not match the tensor, with dtype ",
+                            DataTypeString(val->dtype()), " and shape ",
+                            val->shape().DebugString());
+  }
+
+  const int64_t num_rows = val->dim_size(0);
+  const int64_t row_bytes =
+      num_rows > 0 ? val->TotalBytes() / num_rows : int64_t{0};
+  const auto ranges_matrix = ranges.matrix<int64_t>();
+  const char* src = values.tensor_data().data();
+  char* dst = const_cast<char*>(val->tensor_data().data());
+  int64_t prev_limit = 0;
+  int64_t num_values = 0;
+  for (int64_t i = 0; i < ranges_matrix.dimension(0); ++i) {
+    const int64_t start = ranges_matrix(i, 0);
+    const int64_t limit = ranges_matrix(i, 1);
+    if (start < prev_limit || limit <= start || limit > num_rows ||
+        num_values + limit - start > values.dim_size(0)) {
+      return errors::DataLoss("Invalid delta range [", start, ", ", limit,
+                              ") for tensor ", key, " with ", num_rows,
+                              " rows");
+    }
+    const int64_t size = (limit - start) * row_bytes;
+    std::memcpy(dst + start * row_bytes, src + num_values * row_bytes, size);
+    num_values += limit - start;
+    prev_limit = limit;
+  }
+  if (num_values != values.dim_size(0)) {
+    return errors::DataLoss("Delta of tensor ", key, " has ",
+                            values.dim_size(0), " rows, but its ranges cover ",
+                            num_values);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status GatherDeltaRows(const Tensor& val, gtl::ArraySlice<int64_t> rows,
+                       Tensor* ranges, Tensor* values) {
+  TF_RETURN_IF_ERROR(CheckDeltaSupported("", val.dtype(), val.shape()));
+  const int64_t num_rows = val.dim_size(0);
+  std::vector<std::pair<int64_t, int64_t>> row_ranges;
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i] < 0 || rows[i] >= num_rows ||
+        (i > 0 && rows[i] <= rows[i - 1])) {
+      return errors::InvalidArgument(
+          "Delta rows must be sorted, unique, and in [0, ", num_rows,
+          "), got ", rows[i], " at position ", i);
+    }
+    if (!row_ranges.empty() && row_ranges.back().second == rows[i]) {
+      ++row_ranges.back().second;
+    } else {
+      row_ranges.emplace_back(rows[i], rows[i] + 1);
+    }
+  }
+
+  *ranges = Tensor(DT_INT64,
+                   TensorShape({static_cast<int64_t>(row_ranges.size()), 2}));
+  auto ranges_matrix = ranges->matrix<int64_t>();
+  TensorShape values_shape = val.shape();
+  values_shape.set_dim(0, rows.size());
+  *values = Tensor(val.dtype(), values_shape);
+
+  const int64_t row_bytes =
+      num_rows > 0 ? val.TotalBytes() / num_rows : int64_t{0};
+  const char* src = val.tensor_data().data();
+  char* dst = const_cast<char*>(values->tensor_data().data());
+  for (size_t i = 0; i < row_ranges.size(); ++i) {
+    const int64_t start = row_ranges[i].first;
+    const int64_t limit = row_ranges[i].second;
+    ranges_matrix(i, 0) = start;
+    ranges_matrix(i, 1) = limit;
+    const int64_t size = (limit - start) * row_bytes;
+    std::memcpy(dst, src + start * row_bytes, size);
+    dst += size;
+  }
+  return OkStatus();
+}
+
+Status AddDelta(BundleWriter* writer, StringPiece key, const Tensor& ranges,
+                const Tensor& values) {
+  TF_RETURN_IF_ERROR(writer->Add(strings::StrCat(key, kDeltaRangesSuffix),
+                                 ranges));
+  return writer->Add(strings::StrCat(key, kDeltaValuesSuffix), values);
+}
+
+Status AddDeltaBase(BundleWriter* writer, StringPiece base_prefix) {
+  Tensor base(DT_STRING, TensorShape({}));
+  base.scalar<tstring>()() = tstring(base_prefix);
+  return writer->Add(kDeltaBaseKey, base);
+}
+
+DeltaBundleReader::DeltaBundleReader(Env* env, StringPiece prefix) {
+  std::unordered_set<string> seen;
+  string current(prefix);
+  while (true) {
+    if (!seen.insert(current).second) {
+      status_ = errors::DataLoss("Delta checkpoint ", prefix,
+                                 " has a cycle of bases through ", current);
+      return;
+    }
+    if (readers_.size() >= kMaxDeltaChainLength) {
+      status_ = errors::FailedPrecondition(
+          "Delta checkpoint ", prefix, " has more than ", kMaxDeltaChainLength,
+          " bases, compact it with CompactDeltaCheckpoint()");
+      return;
+    }
+    auto reader = std::make_unique<BundleReader>(env, current);
+    if (!reader->status().ok()) {
+      status_ = reader->status();
+      return;
+    }
+    const bool has_base = reader->Contains(kDeltaBaseKey);
+    Tensor base;
+    if (has_base) {
+      status_ = LookupNew(reader.get(), kDeltaBaseKey, &base);
+      if (status_.ok() &&
+          (base.dtype() != DT_STRING || base.NumElements() != 1)) {
+        status_ = errors::DataLoss("Invalid base of delta checkpoint ",
+                                   current, ": ", base.DebugString());
+      }
+      if (!status_.ok()) return;
+    }
+    prefixes_.push_back(current);
+    readers_.push_back(std::move(reader));
+    if (!has_base) return;
+    current = string(base.flat<tstring>()(0));
+  }
+}
+
+Status DeltaBundleReader::FindEntries(StringPiece key, int* full,
+                                      std::vector<int>* deltas) {
+  deltas->clear();
+  const string ranges_key = strings::StrCat(key, kDeltaRangesSuffix);
+  for (int i = 0; i < readers_.size(); ++i) {
+    if (readers_[i]->Contains(key)) {
+      *full = i;
+      return OkStatus();
+    }
+    if (readers_[i]->Contains(ranges_key)) deltas->push_back(i);
+  }
+  if (deltas->empty()) {
+    return errors::NotFound("Key ", key, " not found in checkpoint");
+  }
+  return errors::DataLoss("Key ", key,
+                          " only has deltas in the chain of checkpoint ",
+                          prefixes_.front(), ", ending at ", prefixes_.back());
+}
+
+Status DeltaBundleReader::LookupDtypeAndShape(StringPiece key, DataType* dtype,
+                                              TensorShape* shape) {
+  int full;
+  std::vector<int> deltas;
+  TF_RETURN_IF_ERROR(FindEntries(key, &full, &deltas));
+  return readers_[full]->LookupDtypeAndShape(key, dtype, shape);
+}
+
+Status DeltaBundleReader::Lookup(StringPiece key, Tensor* val) {
+  int full;
+  std::vector<int> deltas;
+  TF_RETURN_IF_ERROR(FindEntries(key, &full, &deltas));
+  TF_RETURN_IF_ERROR(readers_[full]->Lookup(key, val));
+  if (deltas.empty()) return OkStatus();
+  TF_RETURN_IF_ERROR(CheckDeltaSupported(key, val->dtype(), val->shape()));
+
+  // Applies the deltas from the oldest to the newest.
+  const string ranges_key = strings::StrCat(key, kDeltaRangesSuffix);
+  const string values_key = strings::StrCat(key, kDeltaValuesSuffix);
+  for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+    BundleReader* reader = readers_[*it].get();
+    Tensor ranges;
+    Tensor values;
+    TF_RETURN_IF_ERROR(LookupNew(reader, ranges_key, &ranges));
+    TF_RETURN_IF_ERROR(LookupNew(reader, values_key, &values));
+    TF_RETURN_IF_ERROR(ApplyDelta(key, ranges, values, val));
+  }
+  return OkStatus();
+}
+
+Status DeltaBundleReader::ListKeys(std::vector<string>* keys) {
+  std::set<string> all_keys;
+  BundleEntryProto entry;
+  for (const auto& reader : readers_) {
+    // The slices of partitioned tensors have their own entries, which are
+    // skipped like in `checkpoint::CheckpointReader`.
+    std::unordered_set<string> slice_keys;
+    reader->Seek(kHeaderEntryKey);
+    for (reader->Next(); reader->Valid(); reader->Next()) {
+      if (!entry.ParseFromArray(reader->value().data(),
+                                reader->value().size())) {
+        return errors::DataLoss("Unable to parse BundleEntryProto");
+      }
+      for (const auto& slice : entry.slices()) {
+        slice_keys.insert(checkpoint::EncodeTensorNameSlice(
+            string(reader->key()), TensorSlice(slice)));
+      }
+    }
+    reader->Seek(kHeaderEntryKey);
+    for (reader->Next(); reader->Valid(); reader->Next()) {
+      StringPiece key = reader->key();
+      if (key == kDeltaBaseKey || absl::EndsWith(key, kDeltaValuesSuffix) ||
+          slice_keys.count(string(key)) > 0) {
+        continue;
+      }
+      absl::ConsumeSuffix(&key, kDeltaRangesSuffix);
+      all_keys.insert(string(key));
+    }
+  }
+  keys->assign(all_keys.begin(), all_keys.end());
+  return OkStatus();
+}
+
+Status CompactDeltaCheckpoint(Env* env, StringPiece prefix,
+                              StringPiece output_prefix) {
+  DeltaBundleReader reader(env, prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  if (std::find(reader.prefixes().begin(), reader.prefixes().end(),
+                string(output_prefix)) != reader.prefixes().end()) {
+    return errors::InvalidArgument(
+        "Cannot compact delta checkpoint ", prefix, " into ", output_prefix,
+        ", which is part of its chain");
+  }
+  std::vector<string> keys;
+  TF_RETURN_IF_ERROR(reader.ListKeys(&keys));
+
+  BundleWriter writer(env, output_prefix);
+  for (const string& key : keys) {
+    DataType dtype;
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(key, &dtype, &shape));
+    Tensor val(dtype, shape);
+    TF_RETURN_IF_ERROR(reader.Lookup(key, &val));
+    TF_RETURN_IF_ERROR(writer.Add(key, val));
+  }
+  return writer.Finish();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,125 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_CHECKPOINT_H_
+#define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_CHECKPOINT_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+
+// A delta checkpoint is a tensor bundle that only stores the rows of some of
+// its tensors that changed since a base checkpoint, which is itself a full or
+// a delta checkpoint.
+//
+// The bundle of a delta checkpoint contains a scalar string tensor keyed by
+// `kDeltaBaseKey` with the prefix of its base checkpoint. Each tensor is either
+// stored in full under its own key, or as a delta of the tensor in the base
+// checkpoint under two keys:
+//   * "<key>" + kDeltaRangesSuffix: an int64 tensor of shape [num_ranges, 2]
+//     holding sorted and disjoint [start, limit) ranges of updated rows.
+//   * "<key>" + kDeltaValuesSuffix: a tensor holding the updated rows, in the
+//     order of the ranges.
+// Deltas are only supported for tensors with at least one dimension whose
+// dtype can be copied with memcpy.
+//
+// Restoring a delta checkpoint requires all the checkpoints of its chain of
+// bases, up to the last full checkpoint of each tensor. A chain can be merged
+// into a single full checkpoint with `CompactDeltaCheckpoint()`.
+extern const char* const kDeltaBaseKey;
+extern const char* const kDeltaRangesSuffix;
+extern const char* const kDeltaValuesSuffix;
+
+// Maximum number of checkpoints in a chain of delta checkpoints.
+constexpr int kMaxDeltaChainLength = 1000;
+
+// Copies the rows `rows` of `val`, which must be sorted and unique, into
+// `*values`, and sets `*ranges` to the ranges of these rows in the format
+// described above.
+Status GatherDeltaRows(const Tensor& val, gtl::ArraySlice<int64_t> rows,
+                       Tensor* ranges, Tensor* values);
+
+// Adds the delta of the tensor keyed by `key` to `writer`, with `ranges` and
+// `values` as returned by `GatherDeltaRows()`.
+Status AddDelta(BundleWriter* writer, StringPiece key, const Tensor& ranges,
+                const Tensor& values);
+
+// Marks the bundle of `writer` as a delta of the checkpoint at `base_prefix`.
+Status AddDeltaBase(BundleWriter* writer, StringPiece base_prefix);
+
+// Reads the tensors of a delta checkpoint, merging the rows stored in the
+// chain of checkpoints it is based on. Also reads regular bundles, which are
+// chains of length one.
+//
+// If the caller intends to call any function afterwards, "status()" must be
+// checked. All threads accessing the same DeltaBundleReader must synchronize.
+class DeltaBundleReader {
+ public:
+  DeltaBundleReader(Env* env, StringPiece prefix);
+
+  Status status() const { return status_; }
+
+  // The prefixes of the checkpoints of the chain, newest first.
+  const std::vector<string>& prefixes() const { return prefixes_; }
+
+  // Looks up the dtype and the shape of the tensor keyed by "key".
+  // REQUIRES: status().ok()
+  Status LookupDtypeAndShape(StringPiece key, DataType* dtype,
+                             TensorShape* shape) TF_MUST_USE_RESULT;
+
+  // Looks up the tensor keyed by "key", which must be stored in full in one of
+  // the checkpoints of the chain. Like `BundleReader::Lookup()`, "val" must
+  // have the shape and dtype returned by "LookupDtypeAndShape()".
+  // REQUIRES: status().ok()
+  Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
+  // Returns the sorted keys of the tensors of the checkpoint, excluding the
+  // entries used by the delta format.
+  // REQUIRES: status().ok()
+  Status ListKeys(std::vector<string>* keys) TF_MUST_USE_RESULT;
+
+ private:
+  // Sets `*full` to the index in `readers_` of the newest checkpoint storing
+  // "key" in full, and `*deltas` to the indices of the newer checkpoints
+  // storing a delta of it, newest first.
+  Status FindEntries(StringPiece key, int* full, std::vector<int>* deltas);
+
+  // The chain of checkpoints, newest first.
+  std::vector<string> prefixes_;
+  std::vector<std::unique_ptr<BundleReader>> readers_;
+  Status status_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeltaBundleReader);
+};
+
+// Writes to `output_prefix` a full checkpoint with the contents of the delta
+// checkpoint at `prefix`.
+Status CompactDeltaCheckpoint(Env* env, StringPiece prefix,
+                              StringPiece output_prefix);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_DELTA_CHECKPOINT_H_
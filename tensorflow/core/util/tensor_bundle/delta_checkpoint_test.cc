@@ -0,0 +1,149 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/tensor_bundle/delta_checkpoint.h"
+
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace {
+
+string Prefix(const string& prefix) {
+  return strings::StrCat(testing::TmpDir(), "/", prefix);
+}
+
+Tensor Lookup(DeltaBundleReader* reader, const string& key) {
+  DataType dtype;
+  TensorShape shape;
+  TF_EXPECT_OK(reader->LookupDtypeAndShape(key, &dtype, &shape));
+  Tensor val(dtype, shape);
+  TF_EXPECT_OK(reader->Lookup(key, &val));
+  return val;
+}
+
+// Writes to `prefix` a delta of `val` with the rows `rows` in "a", based on
+// `base_prefix`, and a full "b".
+void WriteDelta(const string& prefix, const string& base_prefix,
+                const Tensor& val, const std::vector<int64_t>& rows,
+                float b) {
+  BundleWriter writer(Env::Default(), prefix);
+  TF_ASSERT_OK(AddDeltaBase(&writer, base_prefix));
+  Tensor ranges;
+  Tensor values;
+  TF_ASSERT_OK(GatherDeltaRows(val, rows, &ranges, &values));
+  TF_ASSERT_OK(AddDelta(&writer, "a", ranges, values));
+  TF_ASSERT_OK(writer.Add("b", test::AsScalar<float>(b)));
+  TF_ASSERT_OK(writer.Finish());
+}
+
+TEST(DeltaCheckpointTest, GatherDeltaRows) {
+  Tensor val = test::AsTensor<int32>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11},
+                                     TensorShape({6, 2}));
+  Tensor ranges;
+  Tensor values;
+  TF_ASSERT_OK(GatherDeltaRows(val, {0, 2, 3, 5}, &ranges, &values));
+  test::ExpectTensorEqual<int64_t>(
+      ranges, test::AsTensor<int64_t>({0, 1, 2, 4, 5, 6}, TensorShape({3, 2})));
+  test::ExpectTensorEqual<int32>(
+      values, test::AsTensor<int32>({0, 1, 4, 5, 6, 7, 10, 11},
+                                    TensorShape({4, 2})));
+
+  EXPECT_FALSE(GatherDeltaRows(val, {2, 1}, &ranges, &values).ok());
+  EXPECT_FALSE(GatherDeltaRows(val, {6}, &ranges, &values).ok());
+  EXPECT_FALSE(
+      GatherDeltaRows(test::AsScalar<int32>(0), {}, &ranges, &values).ok());
+}
+
+TEST(DeltaCheckpointTest, MergesChain) {
+  Tensor a = test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7},
+                                   TensorShape({4, 2}));
+  {
+    BundleWriter writer(Env::Default(), Prefix("chain-0"));
+    TF_ASSERT_OK(writer.Add("a", a));
+    TF_ASSERT_OK(writer.Add("b", test::AsScalar<float>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  a.matrix<float>()(1, 0) = 10;
+  a.matrix<float>()(2, 1) = 20;
+  WriteDelta(Prefix("chain-1"), Prefix("chain-0"), a, {1, 2}, 1);
+  a.matrix<float>()(2, 1) = 30;
+  a.matrix<float>()(3, 0) = 40;
+  WriteDelta(Prefix("chain-2"), Prefix("chain-1"), a, {2, 3}, 2);
+
+  DeltaBundleReader reader(Env::Default(), Prefix("chain-2"));
+  TF_ASSERT_OK(reader.status());
+  EXPECT_EQ(reader.prefixes(),
+            std::vector<string>({Prefix("chain-2"), Prefix("chain-1"),
+                                 Prefix("chain-0")}));
+  std::vector<string> keys;
+  TF_ASSERT_OK(reader.ListKeys(&keys));
+  EXPECT_EQ(keys, std::vector<string>({"a", "b"}));
+  test::ExpectTensorEqual<float>(Lookup(&reader, "a"), a);
+  test::ExpectTensorEqual<float>(Lookup(&reader, "b"),
+                                 test::AsScalar<float>(2));
+
+  // Compaction writes a regular bundle.
+  TF_ASSERT_OK(CompactDeltaCheckpoint(Env::Default(), Prefix("chain-2"),
+                                      Prefix("chain-compact")));
+  BundleReader compact(Env::Default(), Prefix("chain-compact"));
+  TF_ASSERT_OK(compact.status());
+  EXPECT_FALSE(compact.Contains(kDeltaBaseKey));
+  Tensor compact_a(DT_FLOAT, TensorShape({4, 2}));
+  TF_ASSERT_OK(compact.Lookup("a", &compact_a));
+  test::ExpectTensorEqual<float>(compact_a, a);
+
+  EXPECT_FALSE(CompactDeltaCheckpoint(Env::Default(), Prefix("chain-2"),
+                                      Prefix("chain-0"))
+                   .ok());
+}
+
+TEST(DeltaCheckpointTest, InvalidChains) {
+  Tensor a = test::AsTensor<float>({0, 1}, TensorShape({2, 1}));
+  WriteDelta(Prefix("cycle"), Prefix("cycle"), a, {0}, 0);
+  EXPECT_EQ(DeltaBundleReader(Env::Default(), Prefix("cycle")).status().code(),
+            error::DATA_LOSS);
+
+  WriteDelta(Prefix("missing-base"), Prefix("does-not-exist"), a, {0}, 0);
+  EXPECT_EQ(DeltaBundleReader(Env::Default(), Prefix("missing-base"))
+                .status()
+                .code(),
+            error::NOT_FOUND);
+
+  // The base does not store "a" in full.
+  {
+    BundleWriter writer(Env::Default(), Prefix("no-full"));
+    TF_ASSERT_OK(writer.Add("b", test::AsScalar<float>(0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  WriteDelta(Prefix("only-delta"), Prefix("no-full"), a, {0}, 0);
+  DeltaBundleReader reader(Env::Default(), Prefix("only-delta"));
+  TF_ASSERT_OK(reader.status());
+  DataType dtype;
+  TensorShape shape;
+  EXPECT_EQ(reader.LookupDtypeAndShape("a", &dtype, &shape).code(),
+            error::DATA_LOSS);
+  EXPECT_EQ(reader.LookupDtypeAndShape("c", &dtype, &shape).code(),
+            error::NOT_FOUND);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,11 +16,15 @@ limitations under the License.
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -31,6 +35,7 @@ limitations under the License.
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/versions.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
@@ -63,6 +68,16 @@ const int kTensorBundleVersion = 1;
 // Size of our input buffer for streaming reads
 static const int kBufferSize = 1024 * 1024;
 
+// Reads issued by BundleReader::BatchLookup() span at most this many bytes.
+// Tensors larger than kBufferSize are split at multiples of it in the data
+// file, and smaller neighboring tensors are coalesced into reads of up to
+// this size.
+static const int64_t kBatchLookupReadSize = 16 << 20;
+
+// Largest gap between two tensors coalesced into one read by
+// BundleReader::BatchLookup().
+static const int64_t kBatchLookupMaxGap = 64 << 10;
+
 // Key to the special BundleHeaderProto entry.  Do not change this, as clients
 // can make the assumption that the header is always the first entry in the
 // bundle.
@@ -383,6 +398,44 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// A tensor buffer backed by a read-only memory mapping of a data file, which
+// it keeps alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : TensorBuffer(const_cast<char*>(data)),
+        region_(std::move(region)),
+        size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("MappedTensorBuffer");
+  }
+  // The memory cannot be written, so tensors must never be updated in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const size_t size_;
+};
+
+// Returns a DataLoss error if "actual_crc32c" does not match the checksum
+// stored in "entry".
+Status VerifyChecksum(const string& prefix, const BundleEntryProto& entry,
+                      uint32 actual_crc32c) {
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "TensorBundle at ", prefix, " shard ", entry.shard_id(), " (",
+        entry.size(), " bytes): Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  return OkStatus();
+}
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -853,6 +906,34 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return OkStatus();
 }
 
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  // Open the data file if it has not been opened.
+  io::InputBuffer*& file_buffer = data_[shard_id];
+  if (file_buffer == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    file_buffer = new io::InputBuffer(file.release(), kBufferSize);
+  }
+  *buffered_file = file_buffer;
+  return OkStatus();
+}
+
+Status BundleReader::GetMappedDataFile(
+    int32 shard_id, std::shared_ptr<ReadOnlyMemoryRegion>* region) {
+  std::shared_ptr<ReadOnlyMemoryRegion>& mapped = mapped_data_[shard_id];
+  if (mapped == nullptr) {
+    std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+    TF_RETURN_IF_ERROR(env_->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix_, shard_id, num_shards_), &new_region));
+    mapped = std::move(new_region);
+  }
+  *region = mapped;
+  return OkStatus();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
@@ -882,17 +963,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file = new io::InputBuffer(file.release(), kBufferSize);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -936,13 +1008,7 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
         buffered_file, ret->NumElements(), entry.offset(), entry.size(),
         GetStringBackingBuffer(*ret), &actual_crc32c, need_to_swap_bytes_));
   }
-  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
-    return errors::DataLoss(
-        "TensorBundle at ", prefix_, " shard ", entry.shard_id(), " (",
-        entry.size(), " bytes): Checksum does not match: stored ",
-        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
-        " vs. calculated on the restored bytes ", actual_crc32c);
-  }
+  TF_RETURN_IF_ERROR(VerifyChecksum(prefix_, entry, actual_crc32c));
 
   *val = *ret;
   if (ret != val) delete ret;
@@ -963,6 +1029,199 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupMapped(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape shape(entry.shape());
+  const size_t num_bytes = shape.num_elements() * DataTypeSize(entry.dtype());
+  std::shared_ptr<ReadOnlyMemoryRegion> region;
+  const char* data = nullptr;
+  if (entry.slices().empty() && DataTypeCanUseMemcpy(entry.dtype()) &&
+      !need_to_swap_bytes_ && num_bytes > 0 && entry.size() == num_bytes &&
+      GetMappedDataFile(entry.shard_id(), &region).ok() &&
+      entry.offset() + entry.size() <= region->length()) {
+    data = static_cast<const char*>(region->data()) + entry.offset();
+  }
+  if (data == nullptr ||
+      reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment != 0) {
+    *val = Tensor(entry.dtype(), shape);
+    return Lookup(key, val);
+  }
+  core::RefCountPtr<TensorBuffer> buf(
+      new MappedTensorBuffer(std::move(region), data, num_bytes));
+  *val = Tensor(entry.dtype(), shape, std::move(buf));
+  return OkStatus();
+}
+
+Status BundleReader::BatchLookup(gtl::ArraySlice<string> keys,
+                                 gtl::ArraySlice<Tensor*> vals,
+                                 thread::ThreadPool* pool) {
+  if (keys.size() != vals.size()) {
+    return errors::InvalidArgument("BatchLookup: got ", keys.size(),
+                                   " keys but ", vals.size(), " tensors");
+  }
+
+  // A tensor read directly into its buffer.
+  struct PlannedTensor {
+    BundleEntryProto entry;
+    Tensor* val = nullptr;
+    // Number of reads covering the tensor that have not completed yet.
+    std::atomic<int> num_pending_reads{0};
+    std::atomic<bool> read_failed{false};
+    // Set by the last read covering the tensor.
+    Status status;
+  };
+  // The part of a read that is copied to the tensor buffer at "dest".
+  struct ReadPiece {
+    PlannedTensor* tensor;
+    int64_t offset_in_read;
+    int64_t size;
+    char* dest;
+  };
+  // A read of "size" bytes at "offset" in a data file.  Unless "coalesced",
+  // the read is issued directly into the buffer of its single piece.
+  struct Read {
+    RandomAccessFile* file;
+    int64_t offset;
+    int64_t size;
+    bool coalesced;
+    std::vector<ReadPiece> pieces;
+    Status status;
+  };
+
+  // Plans the tensors.  Pointers to the elements of a deque are stable.
+  std::deque<PlannedTensor> planned;
+  std::vector<int> unplanned;
+  std::unordered_map<int32, RandomAccessFile*> files;
+  for (int i = 0; i < keys.size(); ++i) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], &entry));
+    if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype()) ||
+        vals[i]->NumElements() == 0) {
+      unplanned.push_back(i);
+      continue;
+    }
+    if (entry.size() != vals[i]->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry.size(),
+                              "; expected size ", vals[i]->TotalBytes());
+    }
+    if (files.count(entry.shard_id()) == 0) {
+      io::InputBuffer* buffered_file;
+      TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+      files[entry.shard_id()] = buffered_file->file();
+    }
+    planned.emplace_back();
+    planned.back().entry.Swap(&entry);
+    planned.back().val = vals[i];
+  }
+
+  std::vector<PlannedTensor*> sorted;
+  sorted.reserve(planned.size());
+  for (PlannedTensor& tensor : planned) sorted.push_back(&tensor);
+  std::sort(sorted.begin(), sorted.end(),
+            [](const PlannedTensor* a, const PlannedTensor* b) {
+              return std::make_pair(a->entry.shard_id(), a->entry.offset()) <
+                     std::make_pair(b->entry.shard_id(), b->entry.offset());
+            });
+
+  // Plans the reads, in the order of the data files.
+  std::vector<Read> reads;
+  for (PlannedTensor* tensor : sorted) {
+    const BundleEntryProto& entry = tensor->entry;
+    RandomAccessFile* file = files[entry.shard_id()];
+    char* dest = const_cast<char*>(tensor->val->tensor_data().data());
+    const int64_t begin = entry.offset();
+    const int64_t end = begin + entry.size();
+    if (entry.size() > kBufferSize) {
+      int num_reads = 0;
+      for (int64_t offset = begin; offset < end; ++num_reads) {
+        const int64_t read_end = std::min(
+            end, (offset / kBatchLookupReadSize + 1) * kBatchLookupReadSize);
+        const int64_t size = read_end - offset;
+        reads.push_back({file, offset, size, /*coalesced=*/false,
+                         {{tensor, 0, size, dest + (offset - begin)}},
+                         OkStatus()});
+        offset = read_end;
+      }
+      tensor->num_pending_reads = num_reads;
+      continue;
+    }
+    Read* read = reads.empty() ? nullptr : &reads.back();
+    if (read == nullptr || !read->coalesced || read->file != file ||
+        begin < read->offset + read->size ||
+        begin - (read->offset + read->size) > kBatchLookupMaxGap ||
+        end - read->offset > kBatchLookupReadSize) {
+      reads.push_back({file, begin, 0, /*coalesced=*/true, {}, OkStatus()});
+      read = &reads.back();
+    }
+    read->pieces.push_back({tensor, begin - read->offset, entry.size(), dest});
+    read->size = end - read->offset;
+    tensor->num_pending_reads = 1;
+  }
+
+  // Verifies the checksum of a tensor once all its reads have completed.
+  auto finish_tensor = [this](PlannedTensor* tensor) {
+    if (tensor->read_failed) return;
+    const BundleEntryProto& entry = tensor->entry;
+    tensor->status = VerifyChecksum(
+        prefix_, entry,
+        crc32c::Value(tensor->val->tensor_data().data(), entry.size()));
+    if (tensor->status.ok() && need_to_swap_bytes_) {
+      tensor->status = ByteSwapTensor(tensor->val);
+    }
+  };
+  auto run_read = [&finish_tensor](Read* read) {
+    StringPiece result;
+    if (!read->coalesced) {
+      char* dest = read->pieces[0].dest;
+      read->status = read->file->Read(read->offset, read->size, &result, dest);
+      if (read->status.ok() && result.data() != dest) {
+        memmove(dest, result.data(), read->size);
+      }
+    } else {
+      std::unique_ptr<char[]> buffer(new char[read->size]);
+      read->status =
+          read->file->Read(read->offset, read->size, &result, buffer.get());
+      if (read->status.ok()) {
+        for (const ReadPiece& piece : read->pieces) {
+          memcpy(piece.dest, result.data() + piece.offset_in_read, piece.size);
+        }
+      }
+    }
+    for (const ReadPiece& piece : read->pieces) {
+      if (!read->status.ok()) piece.tensor->read_failed = true;
+      if (piece.tensor->num_pending_reads.fetch_sub(1) == 1) {
+        finish_tensor(piece.tensor);
+      }
+    }
+  };
+
+  BlockingCounter counter(reads.size());
+  for (Read& read : reads) {
+    pool->Schedule([&run_read, &read, &counter]() {
+      run_read(&read);
+      counter.DecrementCount();
+    });
+  }
+  // The other tensors are read meanwhile from this thread.
+  Status status;
+  for (int i : unplanned) {
+    status = Lookup(keys[i], vals[i]);
+    if (!status.ok()) break;
+  }
+  counter.Wait();
+  TF_RETURN_IF_ERROR(status);
+  for (const Read& read : reads) {
+    TF_RETURN_IF_ERROR(read.status);
+  }
+  for (const PlannedTensor& tensor : planned) {
+    TF_RETURN_IF_ERROR(tensor.status);
+  }
+  return OkStatus();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
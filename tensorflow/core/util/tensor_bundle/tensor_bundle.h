@@ -62,6 +62,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_UTIL_TENSOR_BUNDLE_TENSOR_BUNDLE_H_
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -72,6 +73,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/cache.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
@@ -245,6 +247,40 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys[i]" into "vals[i]", with the same
+  // requirements and checks as calling "Lookup()" for each key.
+  //
+  // The reads of all the tensors are planned together: tensors are sorted by
+  // their position in the data files, neighboring small tensors are coalesced
+  // into a single read, and large tensors are split into reads of bounded
+  // size, aligned in the data file.  The reads are issued concurrently from
+  // "pool", directly into the buffers of "vals" for large tensors.
+  // Partitioned, string and variant tensors are looked up one at a time from
+  // the calling thread.
+  //
+  // On error, the contents of "vals" are unspecified.
+  // REQUIRES: status().ok()
+  Status BatchLookup(gtl::ArraySlice<string> keys,
+                     gtl::ArraySlice<Tensor*> vals,
+                     thread::ThreadPool* pool) TF_MUST_USE_RESULT;
+
+  // Looks up the tensor keyed by "key" into "*val", which is replaced by a
+  // tensor backed directly by a read-only memory mapping of the data file when
+  // possible, without copying its contents.  The mapping is shared by all the
+  // tensors looked up from the same data file, and stays valid as long as one
+  // of them does, so readers of the same bundle share the physical pages.
+  //
+  // Tensors are mapped when the file system supports memory mappings, their
+  // dtype can be copied with memcpy, their endianness matches, and their
+  // contents are aligned to Allocator::kAllocatorAlignment in memory, which
+  // requires writing the bundle with an "Options::data_alignment" of (a
+  // multiple of) this alignment.  Other tensors are read like "Lookup()".
+  // Mapped tensors do not own their memory, so kernels never update them in
+  // place, and their checksums are not verified, since that would read every
+  // page of the mapping.
+  // REQUIRES: status().ok()
+  Status LookupMapped(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -296,6 +332,16 @@ class BundleReader {
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Returns the buffered data file of shard "shard_id", opening it if needed.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
+  // Returns a memory mapping of the data file of shard "shard_id", mapping it
+  // if needed.
+  Status GetMappedDataFile(int32 shard_id,
+                           std::shared_ptr<ReadOnlyMemoryRegion>* region)
+      TF_MUST_USE_RESULT;
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
@@ -319,6 +365,9 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The data files mapped by LookupMapped().
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
@@ -946,6 +946,126 @@ TEST(TensorBundleTest, SortForSequentialAccess) {
                           "tensor-1-2", "tensor-1-1", "tensor-1-0"));
 }
 
+TEST(TensorBundleTest, BatchLookup) {
+  Env* env = Env::Default();
+  const std::vector<string> kBundlePrefixes = {Prefix("batch0"),
+                                               Prefix("batch1")};
+  // Larger than the size of the reads issued by BatchLookup().
+  Tensor large(DT_FLOAT, TensorShape({5 << 20}));
+  large.flat<float>().setRandom();
+  std::vector<std::pair<string, Tensor>> expected = {
+      {"large", large},
+      {"small-0", Constant_2x3<float>(1.)},
+      {"small-1", Constant_2x3<int64_t>(2)},
+      {"medium", Constant<double>(3., TensorShape({1 << 18}))},
+      {"strings", test::AsTensor<tstring>({"hello", "world"})},
+      {"small-2", Constant_2x3<int8>(4)},
+  };
+  {
+    BundleWriter writer0(env, kBundlePrefixes[0]);
+    BundleWriter writer1(env, kBundlePrefixes[1]);
+    for (int i = 0; i < expected.size(); ++i) {
+      BundleWriter& writer = i % 2 == 0 ? writer0 : writer1;
+      TF_EXPECT_OK(writer.Add(expected[i].first, expected[i].second));
+    }
+    TF_ASSERT_OK(writer0.Finish());
+    TF_ASSERT_OK(writer1.Finish());
+  }
+  const string kMerged = Prefix("batch_merged");
+  TF_ASSERT_OK(MergeBundles(env, {kBundlePrefixes[0], kBundlePrefixes[1]},
+                            kMerged));
+
+  BundleReader reader(env, kMerged);
+  TF_ASSERT_OK(reader.status());
+  std::vector<string> keys;
+  std::vector<Tensor> vals;
+  std::vector<Tensor*> val_ptrs;
+  for (const auto& key_and_value : expected) {
+    keys.push_back(key_and_value.first);
+    vals.emplace_back(key_and_value.second.dtype(),
+                      key_and_value.second.shape());
+  }
+  for (Tensor& val : vals) val_ptrs.push_back(&val);
+  thread::ThreadPool pool(env, "test", 4);
+  TF_ASSERT_OK(reader.BatchLookup(keys, val_ptrs, &pool));
+  for (int i = 0; i < expected.size(); ++i) {
+    test::ExpectEqual(expected[i].second, vals[i]);
+  }
+}
+
+TEST(TensorBundleTest, BatchLookupChecksum) {
+  Env* env = Env::Default();
+  {
+    BundleWriter writer(env, Prefix("batch_checksum"));
+    TF_EXPECT_OK(writer.Add("bar", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Corrupts the last byte of "foo".
+  const string datafile = DataFilename(Prefix("batch_checksum"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(env, datafile, &data));
+  data.back() = ~data.back();
+  TF_ASSERT_OK(WriteStringToFile(env, datafile, data));
+
+  BundleReader reader(env, Prefix("batch_checksum"));
+  TF_ASSERT_OK(reader.status());
+  Tensor bar(DT_FLOAT, TensorShape({2, 3}));
+  Tensor foo(DT_FLOAT, TensorShape({2, 3}));
+  thread::ThreadPool pool(env, "test", 2);
+  Status status = reader.BatchLookup({"bar", "foo"}, {&bar, &foo}, &pool);
+  EXPECT_TRUE(errors::IsDataLoss(status));
+  EXPECT_TRUE(absl::StrContains(status.ToString(), "Checksum does not match"));
+  EXPECT_TRUE(errors::IsNotFound(
+      reader.BatchLookup({"baz"}, {&bar}, &pool)));
+}
+
+TEST(TensorBundleTest, LookupMapped) {
+  Env* env = Env::Default();
+  BundleWriter::Options opts;
+  opts.data_alignment = Allocator::kAllocatorAlignment;
+  {
+    BundleWriter writer(env, Prefix("mapped"), opts);
+    TF_EXPECT_OK(writer.Add("bar", Constant_2x3(1.f)));
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<int8>(2)));
+    TF_EXPECT_OK(writer.Add("strings", test::AsTensor<tstring>({"a", "b"})));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  {
+    // Unaligned tensors are copied.
+    BundleWriter writer(env, Prefix("mapped_unaligned"));
+    TF_EXPECT_OK(writer.Add("bar", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3(2.f)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  Tensor bar;
+  Tensor foo;
+  Tensor strings;
+  Tensor unaligned;
+  {
+    BundleReader reader(env, Prefix("mapped"));
+    TF_ASSERT_OK(reader.status());
+    TF_ASSERT_OK(reader.LookupMapped("bar", &bar));
+    TF_ASSERT_OK(reader.LookupMapped("foo", &foo));
+    TF_ASSERT_OK(reader.LookupMapped("strings", &strings));
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMapped("baz", &bar)));
+    BundleReader unaligned_reader(env, Prefix("mapped_unaligned"));
+    TF_ASSERT_OK(unaligned_reader.status());
+    TF_ASSERT_OK(unaligned_reader.LookupMapped("foo", &unaligned));
+  }
+  // The mapped tensors outlive the readers, and are never forwarded.
+  test::ExpectTensorEqual<float>(bar, Constant_2x3(1.f));
+  test::ExpectTensorEqual<int8>(foo, Constant_2x3<int8>(2));
+  test::ExpectTensorEqual<tstring>(strings,
+                                   test::AsTensor<tstring>({"a", "b"}));
+  test::ExpectTensorEqual<float>(unaligned, Constant_2x3(2.f));
+  EXPECT_FALSE(bar.RefCountIsOne());
+  EXPECT_FALSE(foo.RefCountIsOne());
+  EXPECT_TRUE(strings.RefCountIsOne());
+  EXPECT_TRUE(unaligned.RefCountIsOne());
+}
+
 TEST(TensorBundleTest, Error) {
   {  // Dup keys.
     BundleWriter writer(Env::Default(), Prefix("dup"));
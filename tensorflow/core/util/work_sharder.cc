@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <atomic>
+
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/platform/env_time.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -51,6 +55,57 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
       max_parallelism);
 }
 
+ShardCostModel::ShardCostModel() {
+  for (auto& picos_per_unit : picos_per_unit_) {
+    picos_per_unit.store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t ShardCostModel::CostPerUnit(int64_t total,
+                                    int64_t default_cost_per_unit) const {
+  if (total <= 0) {
+    return default_cost_per_unit;
+  }
+  const int64_t picos_per_unit =
+      picos_per_unit_[Log2Floor64(total)].load(std::memory_order_relaxed);
+  if (picos_per_unit == 0) {
+    return default_cost_per_unit;
+  }
+  return std::max(int64_t{1}, (picos_per_unit + 500) / 1000);
+}
+
+void ShardCostModel::Record(int64_t total, int64_t nanos) {
+  if (total <= 0) {
+    return;
+  }
+  std::atomic<int64_t>& bucket = picos_per_unit_[Log2Floor64(total)];
+  // Saturates, as an overflowing cost would not change the sharding anyway.
+  const int64_t sample = std::max(
+      int64_t{1}, nanos < kint64max / 1000 ? nanos * 1000 / total
+                                           : kint64max / total);
+  const int64_t previous = bucket.load(std::memory_order_relaxed);
+  // Concurrent updates may be lost, which only delays the adaptation.
+  bucket.store(previous == 0 ? sample : previous + (sample - previous) / 8,
+               std::memory_order_relaxed);
+}
+
+void AdaptiveShard(ShardCostModel* cost_model, int max_parallelism,
+                   thread::ThreadPool* workers, int64_t total,
+                   int64_t cost_per_unit,
+                   std::function<void(int64_t, int64_t)> work) {
+  CHECK(cost_model != nullptr);
+  std::atomic<int64_t> work_nanos(0);
+  Shard(max_parallelism, workers, total,
+        cost_model->CostPerUnit(total, cost_per_unit),
+        [&work, &work_nanos](int64_t start, int64_t limit) {
+          const uint64 start_nanos = EnvTime::NowNanos();
+          work(start, limit);
+          work_nanos.fetch_add(EnvTime::NowNanos() - start_nanos,
+                               std::memory_order_relaxed);
+        });
+  cost_model->Record(total, work_nanos.load(std::memory_order_relaxed));
+}
+
 // DEPRECATED: Prefer threadpool->ParallelFor with SchedulingStrategy, which
 // allows you to specify the strategy for choosing shard sizes, including using
 // a fixed shard size.
@@ -16,9 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 #define TENSORFLOW_CORE_UTIL_WORK_SHARDER_H_
 
+#include <atomic>
 #include <functional>
 
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -59,6 +61,51 @@ namespace tensorflow {
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64_t total,
            int64_t cost_per_unit, std::function<void(int64_t, int64_t)> work);
 
+// The measured cost per unit of work of the Shard() calls of one call site.
+// Calls are bucketed by the power of two of their "total", since the cost per
+// unit often depends on the size of the work (e.g. whether it fits in cache).
+//
+// A call site typically owns a function-local static instance:
+//
+//   static ShardCostModel* cost_model = new ShardCostModel;
+//   AdaptiveShard(cost_model, max_parallelism, workers, total, cost_per_unit,
+//                 work);
+//
+// Thread-safe.
+class ShardCostModel {
+ public:
+  ShardCostModel();
+
+  // Returns the measured cost per unit in nanoseconds of calls with "total"
+  // units, or "default_cost_per_unit" if no such call was measured yet.
+  int64_t CostPerUnit(int64_t total, int64_t default_cost_per_unit) const;
+
+  // Records that "total" units took "nanos" nanoseconds to compute, summed
+  // over all the shards.
+  void Record(int64_t total, int64_t nanos);
+
+ private:
+  static constexpr int kNumBuckets = 64;
+
+  // Moving average of the cost per unit in picoseconds for each bucket, or 0
+  // if the bucket was not measured yet.
+  std::atomic<int64_t> picos_per_unit_[kNumBuckets];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardCostModel);
+};
+
+// Like Shard(), but measures the time each shard takes and records it in
+// "cost_model". "cost_per_unit" is only used until calls of a similar "total"
+// have been measured; later calls use the measured cost per unit instead. So
+// work that is cheaper than estimated runs on fewer threads, and work that is
+// more expensive on more.
+//
+// REQUIRES: cost_model != nullptr
+void AdaptiveShard(ShardCostModel* cost_model, int max_parallelism,
+                   thread::ThreadPool* workers, int64_t total,
+                   int64_t cost_per_unit,
+                   std::function<void(int64_t, int64_t)> work);
+
 // Each thread has an associated option to express the desired maximum
 // parallelism. Its default is a very large quantity.
 //
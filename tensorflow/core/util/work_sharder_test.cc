@@ -90,6 +90,46 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(ShardCostModel, CostPerUnit) {
+  ShardCostModel cost_model;
+  EXPECT_EQ(cost_model.CostPerUnit(0, 7), 7);
+  EXPECT_EQ(cost_model.CostPerUnit(100, 7), 7);
+
+  cost_model.Record(100, 50000);
+  EXPECT_EQ(cost_model.CostPerUnit(100, 7), 500);
+  // Totals of the same power of two share the measurement, others do not.
+  EXPECT_EQ(cost_model.CostPerUnit(127, 7), 500);
+  EXPECT_EQ(cost_model.CostPerUnit(128, 7), 7);
+
+  // Later measurements are averaged with the earlier ones.
+  cost_model.Record(100, 130000);
+  EXPECT_EQ(cost_model.CostPerUnit(100, 7), 600);
+
+  // The cost of work cheaper than a nanosecond per unit is rounded up.
+  cost_model.Record(1 << 20, 1000);
+  EXPECT_EQ(cost_model.CostPerUnit(1 << 20, 7), 1);
+}
+
+TEST(AdaptiveShard, Basic) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  ShardCostModel cost_model;
+  for (auto total : {0, 1, 7, 1000, 9999, 1000000}) {
+    for (int i = 0; i < 3; ++i) {
+      std::vector<std::atomic<int>> work(total);
+      AdaptiveShard(&cost_model, 16, &threads, total, /*cost_per_unit=*/1,
+                    [&work](int64_t start, int64_t limit) {
+                      for (; start < limit; ++start) ++work[start];
+                    });
+      for (auto& count : work) {
+        ASSERT_EQ(count.load(), 1);
+      }
+    }
+    if (total > 0) {
+      EXPECT_GE(cost_model.CostPerUnit(total, 0), 1);
+    }
+  }
+}
+
 void BM_Sharding(::testing::benchmark::State& state) {
   const int arg = state.range(0);
 
@@ -1365,6 +1365,9 @@ void DTensorDevice::LowerToSPMDFunction(
               << ". DTensor is (re-)computing its SPMD transformation.";
   }
 
+  // Key of the function in the on-disk tier of the cache, if it is used.
+  absl::optional<tensorflow::Fprint128> disk_cache_key;
+
   // It includes remote devices when the coordination service is enabled.
   const auto device_list = tensorflow::unwrap(context)->ListAllTfDevices();
   DeviceSet device_set;
@@ -1386,9 +1389,19 @@ void DTensorDevice::LowerToSPMDFunction(
                                    num_outputs),
           status);
       *execution_functions = function_manager_.AddCachedFunction(
-          doperation, cache_key_and_func.first, std::move(functions));
+          doperation, cache_key_and_func.first, std::move(functions), context);
       return;
     }
+    if (function_manager_.disk_cache_enabled()) {
+      disk_cache_key = function_manager_.DiskCacheKey(
+          doperation, *flib_def, default_layout_, cache_key_and_func.first);
+      *execution_functions = function_manager_.LoadCachedFunction(
+          doperation, cache_key_and_func.first, *disk_cache_key, context);
+      if (*execution_functions != nullptr) {
+        function_compilation_hits_and_misses_["disk_hit"]++;
+        return;
+      }
+    }
     // Output layouts of a function are inferred by MLIR lowering. They are
     // not necessary for cache key computation, so run PrepareGraphForMlir after
     // cache key computation to reduce the overheads of running the same
@@ -1448,8 +1461,11 @@ void DTensorDevice::LowerToSPMDFunction(
     }
   }
 
+  if (disk_cache_key.has_value()) {
+    function_manager_.SaveCachedFunction(*disk_cache_key, functions, *flib_def);
+  }
   *execution_functions = function_manager_.AddCachedFunction(
-      doperation, cache_key_and_func.first, std::move(functions));
+      doperation, cache_key_and_func.first, std::move(functions), context);
 }
 
 void DTensorDevice::ExecuteFunctionAndWait(
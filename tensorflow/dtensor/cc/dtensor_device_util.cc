@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/dtensor/cc/dtensor_device_util.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <string>
 #include <utility>
@@ -32,15 +34,21 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/public/version.h"
 #include "tensorflow/dtensor/cc/constants.h"
 #include "tensorflow/dtensor/cc/dstatus.h"
+#include "tensorflow/dtensor/cc/dtensor_utils.h"
 #include "tensorflow/dtensor/cc/small_constant_optimization.h"
+#include "tensorflow/dtensor/proto/function_cache.pb.h"
+#include "tensorflow/dtensor/proto/layout.pb.h"
 
 namespace tensorflow {
 namespace dtensor {
@@ -253,6 +261,146 @@ StatusOr<Layout> GetLayoutThroughIdentityOps(Node* op, int output_index) {
   return Layout::FromString(serialized_layouts->list().s(output_index));
 }
 
+// Converts `functions` to a proto, with all the functions they call from
+// `flib_def`.
+StatusOr<ExecutionFunctionsProto> ExecutionFunctionsToProto(
+    const ExecutionFunctions& functions,
+    const FunctionLibraryDefinition& flib_def) {
+  ExecutionFunctionsProto proto;
+  proto.set_num_device_ids(functions.num_device_ids);
+  proto.set_function_mesh_fingerprint(functions.function_mesh_fingerprint);
+  FunctionLibraryDefinition library(flib_def.default_registry(),
+                                    FunctionDefLibrary());
+  for (const TranslatedFunction& function : functions.function_list) {
+    TranslatedFunctionProto* function_proto = proto.add_function_list();
+    *function_proto->mutable_function_mesh() = function.function_mesh.ToProto();
+    function_proto->mutable_input_index_map()->Add(
+        function.input_index_map.begin(), function.input_index_map.end());
+    function_proto->mutable_output_index_map()->Add(
+        function.output_index_map.begin(), function.output_index_map.end());
+    function_proto->set_translated_function_name(
+        function.translated_function_name);
+    for (const auto& [index, layout] : function.resource_input_layouts) {
+      (*function_proto->mutable_resource_input_layouts())[index] =
+          layout.ToProto();
+    }
+    for (const auto& [index, layout] : function.shape_output_metadata) {
+      (*function_proto->mutable_shape_output_metadata())[index] =
+          layout.ToProto();
+    }
+    for (const Layout& layout : function.output_layouts) {
+      *function_proto->add_output_layouts() = layout.ToProto();
+    }
+    for (const PartialTensorShape& shape : function.local_output_shapes) {
+      shape.AsProto(function_proto->add_local_output_shapes());
+    }
+    for (const TF_DataType dtype : function.output_dtypes) {
+      function_proto->add_output_dtypes(static_cast<DataType>(dtype));
+    }
+
+    const FunctionDef* function_def =
+        flib_def.Find(function.translated_function_name);
+    if (function_def == nullptr) {
+      return errors::NotFound("Translated function ",
+                              function.translated_function_name,
+                              " is not in the function library.");
+    }
+    TF_RETURN_IF_ERROR(library.AddFunctionDef(*function_def));
+    TF_RETURN_IF_ERROR(
+        library.AddLibrary(flib_def.ReachableDefinitions(*function_def)));
+  }
+  *proto.mutable_library() = library.ToProto();
+  return proto;
+}
+
+// Converts `proto` back to the functions to execute, and adds the functions
+// they call to `context`. The translated functions are renamed, so that they
+// cannot conflict with the functions lowered by this process.
+StatusOr<ExecutionFunctions> ExecutionFunctionsFromProto(
+    const ExecutionFunctionsProto& proto, TFE_Context* context) {
+  static std::atomic<int64_t> unique_function_number(0);
+  ExecutionFunctions functions;
+  functions.num_device_ids = proto.num_device_ids();
+  functions.function_mesh_fingerprint = proto.function_mesh_fingerprint();
+  absl::flat_hash_map<std::string, std::string> renamed_functions;
+  for (const TranslatedFunctionProto& function_proto : proto.function_list()) {
+    TranslatedFunction function;
+    TF_ASSIGN_OR_RETURN(function.function_mesh,
+                        Mesh::ParseFromProto(function_proto.function_mesh()));
+    function.input_index_map.assign(function_proto.input_index_map().begin(),
+                                    function_proto.input_index_map().end());
+    function.output_index_map.assign(function_proto.output_index_map().begin(),
+                                     function_proto.output_index_map().end());
+    function.translated_function_name =
+        absl::StrCat(function_proto.translated_function_name(), "_cached_",
+                     unique_function_number.fetch_add(1));
+    renamed_functions[function_proto.translated_function_name()] =
+        function.translated_function_name;
+    for (const auto& [index, layout_proto] :
+         function_proto.resource_input_layouts()) {
+      TF_ASSIGN_OR_RETURN(Layout layout, Layout::FromProto(layout_proto));
+      function.resource_input_layouts.emplace(index, std::move(layout));
+    }
+    for (const auto& [index, layout_proto] :
+         function_proto.shape_output_metadata()) {
+      TF_ASSIGN_OR_RETURN(Layout layout, Layout::FromProto(layout_proto));
+      function.shape_output_metadata.emplace(index, std::move(layout));
+    }
+    for (const LayoutProto& layout_proto : function_proto.output_layouts()) {
+      TF_ASSIGN_OR_RETURN(Layout layout, Layout::FromProto(layout_proto));
+      function.output_layouts.push_back(std::move(layout));
+    }
+    for (const TensorShapeProto& shape : function_proto.local_output_shapes()) {
+      function.local_output_shapes.emplace_back(shape);
+    }
+    for (const int dtype : function_proto.output_dtypes()) {
+      function.output_dtypes.push_back(static_cast<TF_DataType>(dtype));
+    }
+    functions.function_list.push_back(std::move(function));
+  }
+
+  // Checks for conflicts before changing the function library, so that a
+  // failure leaves it untouched.
+  ImmediateExecutionContext* ctx = tensorflow::unwrap(context);
+  std::vector<FunctionDef> function_defs_to_add;
+  for (const FunctionDef& function_def : proto.library().function()) {
+    auto renamed = renamed_functions.find(function_def.signature().name());
+    if (renamed != renamed_functions.end()) {
+      function_defs_to_add.push_back(function_def);
+      function_defs_to_add.back().mutable_signature()->set_name(
+          renamed->second);
+      continue;
+    }
+    const FunctionDef* existing =
+        ctx->FindFunctionDef(function_def.signature().name());
+    if (existing == nullptr) {
+      function_defs_to_add.push_back(function_def);
+    } else if (!FunctionDefsEqual(*existing, function_def)) {
+      return errors::AlreadyExists("A different function ",
+                                   function_def.signature().name(),
+                                   " is already in the function library.");
+    }
+  }
+  for (const FunctionDef& function_def : function_defs_to_add) {
+    TF_RETURN_IF_ERROR(ctx->AddFunctionDef(function_def));
+  }
+  return functions;
+}
+
+// Writes `proto` to `path` through a temporary file, so that other processes
+// sharing the directory never read a partially written one.
+Status WriteExecutionFunctionsProto(const std::string& path,
+                                    const ExecutionFunctionsProto& proto) {
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(std::string(io::Dirname(path))));
+  std::string tmp_path = path;
+  if (!env->CreateUniqueFileName(&tmp_path, ".tmp")) {
+    return errors::Internal("Failed to create a temporary file for ", path);
+  }
+  TF_RETURN_IF_ERROR(WriteBinaryProto(env, tmp_path, proto));
+  return env->RenameFile(tmp_path, path);
+}
+
 }  // namespace
 
 tensorflow::Fprint128 TensorWithLayout::CacheKey() const {
@@ -515,6 +663,15 @@ absl::flat_hash_map<int, NodeDef> GetConstantFoldableTensors(
   return small_tensors;
 }
 
+FunctionManager::FunctionManager()
+    : max_size_(FunctionCacheMaxSize()),
+      cache_dir_(NumClients() == 1 ? FunctionCacheDir() : "") {
+  if (cache_dir_.empty() && !FunctionCacheDir().empty()) {
+    LOG(WARNING) << "DTENSOR_FUNCTION_CACHE_DIR is ignored with multiple "
+                    "DTensor clients.";
+  }
+}
+
 // Thread unsafe method. go/thread-unsafe
 // Cache key computation should consider all features of an op that affects
 // the SPMD lowering. The cache keys of two ops must be different if the
@@ -563,7 +720,9 @@ FunctionManager::GetCachedFunction(
 
   // Early return if we have a cache hit.
   if (iter != function_cache_.end()) {
-    return std::pair<Fprint128, ExecutionFunctions*>(cache_key, &iter->second);
+    lru_list_.splice(lru_list_.begin(), lru_list_, iter->second.lru_position);
+    return std::pair<Fprint128, ExecutionFunctions*>(cache_key,
+                                                     &iter->second.functions);
   }
 
   // For eager ops we early return the cache miss and do not make further
@@ -613,9 +772,107 @@ FunctionManager::GetCachedFunction(
 
 const ExecutionFunctions* FunctionManager::AddCachedFunction(
     const DTensorOperation& op, tensorflow::Fprint128 cache_key,
-    ExecutionFunctions function) {
-  return &function_cache_.insert({cache_key, std::move(function)})
-              .first->second;
+    ExecutionFunctions function, TFE_Context* context) {
+  auto iter = function_cache_.find(cache_key);
+  if (iter != function_cache_.end()) {
+    lru_list_.splice(lru_list_.begin(), lru_list_, iter->second.lru_position);
+    return &iter->second.functions;
+  }
+  if (max_size_ > 0 && function_cache_.size() >= max_size_) {
+    auto evicted = function_cache_.find(lru_list_.back());
+    for (const TranslatedFunction& translated_function :
+         evicted->second.functions.function_list) {
+      Status s = tensorflow::unwrap(context)->RemoveFunction(
+          translated_function.translated_function_name);
+      if (!s.ok()) {
+        LOG(WARNING) << "Failed to remove evicted function "
+                     << translated_function.translated_function_name << ": "
+                     << s;
+      }
+    }
+    function_cache_.erase(evicted);
+    lru_list_.pop_back();
+  }
+  lru_list_.push_front(cache_key);
+  return &function_cache_
+              .insert({cache_key, {std::move(function), lru_list_.begin()}})
+              .first->second.functions;
+}
+
+tensorflow::Fprint128 FunctionManager::DiskCacheKey(
+    const DTensorOperation& doperation,
+    const tensorflow::FunctionLibraryDefinition& flib_def,
+    const absl::optional<Layout>& default_layout,
+    tensorflow::Fprint128 cache_key) const {
+  tensorflow::Fprint128 disk_cache_key = FingerprintCat128(
+      cache_key, tensorflow::Fingerprint128(TF_VERSION_STRING));
+  disk_cache_key = FingerprintCat128(disk_cache_key, TF_GRAPH_DEF_VERSION);
+  if (default_layout.has_value()) {
+    disk_cache_key = FingerprintCat128(
+        disk_cache_key, tensorflow::Fingerprint128(default_layout->ToString()));
+  }
+  // Function names are sorted, since the order of the library is not
+  // deterministic.
+  FunctionLibraryDefinition reachable =
+      flib_def.ReachableDefinitions(*doperation.function_def);
+  std::vector<std::string> function_names = reachable.ListFunctionNames();
+  std::sort(function_names.begin(), function_names.end());
+  std::vector<const FunctionDef*> function_defs = {doperation.function_def};
+  for (const std::string& name : function_names) {
+    function_defs.push_back(reachable.Find(name));
+  }
+  for (const FunctionDef* function_def : function_defs) {
+    std::string serialized;
+    SerializeToStringDeterministic(*function_def, &serialized);
+    disk_cache_key = FingerprintCat128(disk_cache_key,
+                                       tensorflow::Fingerprint128(serialized));
+  }
+  return disk_cache_key;
+}
+
+std::string FunctionManager::DiskCachePath(
+    tensorflow::Fprint128 disk_cache_key) const {
+  return io::JoinPath(
+      cache_dir_,
+      absl::StrCat(absl::Hex(disk_cache_key.high64, absl::kZeroPad16),
+                   absl::Hex(disk_cache_key.low64, absl::kZeroPad16), ".pb"));
+}
+
+const ExecutionFunctions* FunctionManager::LoadCachedFunction(
+    const DTensorOperation& doperation, tensorflow::Fprint128 cache_key,
+    tensorflow::Fprint128 disk_cache_key, TFE_Context* context) {
+  const std::string path = DiskCachePath(disk_cache_key);
+  Env* env = Env::Default();
+  if (!env->FileExists(path).ok()) return nullptr;
+  ExecutionFunctionsProto proto;
+  Status s = ReadBinaryProto(env, path, &proto);
+  StatusOr<ExecutionFunctions> functions =
+      s.ok() ? ExecutionFunctionsFromProto(proto, context)
+             : StatusOr<ExecutionFunctions>(s);
+  if (!functions.ok()) {
+    LOG(WARNING) << "Failed to load the DTensor functions of "
+                 << doperation.name << " from " << path << ": "
+                 << functions.status();
+    return nullptr;
+  }
+  VLOG(1) << "Loaded the DTensor functions of " << doperation.name << " from "
+          << path;
+  return AddCachedFunction(doperation, cache_key, std::move(*functions),
+                           context);
+}
+
+void FunctionManager::SaveCachedFunction(
+    tensorflow::Fprint128 disk_cache_key, const ExecutionFunctions& functions,
+    const tensorflow::FunctionLibraryDefinition& flib_def) {
+  const std::string path = DiskCachePath(disk_cache_key);
+  StatusOr<ExecutionFunctionsProto> proto =
+      ExecutionFunctionsToProto(functions, flib_def);
+  Status s = proto.ok() ? WriteExecutionFunctionsProto(path, *proto)
+                        : proto.status();
+  if (!s.ok()) {
+    LOG(WARNING) << "Failed to save the DTensor functions to " << path << ": "
+                 << s;
+  }
 }
 
 bool FunctionManager::IsConstantFoldable(const DTensorOperation& doperation,
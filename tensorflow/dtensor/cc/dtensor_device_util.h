@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_DTENSOR_CC_DTENSOR_DEVICE_UTIL_H_
 #define TENSORFLOW_DTENSOR_CC_DTENSOR_DEVICE_UTIL_H_
 
+#include <list>
 #include <string>
 #include <utility>
 
@@ -535,15 +536,50 @@ std::string ShapeToDebugString(const std::vector<T> shape_vector) {
 //   next call to the same function call, we compare the values of constant
 //   folded inputs to the previous constant folded inputs. We disable constant
 //   folding for the changed values, and save these new inputs.
-// TODO(b/169348205) Support cache eviction if the cache gets bloated.
+//
+// The cache keeps at most FunctionCacheMaxSize() lowered computations, if not
+// 0, and evicts the least recently used ones. If FunctionCacheDir() is set,
+// lowered functions are also saved there, so that another process running the
+// same functions with the same layouts can load them instead of lowering them
+// again. The on-disk tier is only used with a single client, since all the
+// clients must lower a function the same way.
 class FunctionManager {
  public:
-  FunctionManager() = default;
+  FunctionManager();
 
-  // Caches the graph with the lowered 'function'.
+  // Caches the graph with the lowered 'function'. If the cache is full, the
+  // least recently used entry is evicted, and its translated functions are
+  // removed from `context`.
   const ExecutionFunctions* AddCachedFunction(const DTensorOperation& op,
                                               tensorflow::Fprint128 cache_key,
-                                              ExecutionFunctions function);
+                                              ExecutionFunctions function,
+                                              TFE_Context* context);
+
+  // Returns whether the on-disk tier of the cache is enabled.
+  bool disk_cache_enabled() const { return !cache_dir_.empty(); }
+
+  // Returns the key of the function `doperation` in the on-disk tier of the
+  // cache, given its key in memory. Unlike the key in memory, it covers the
+  // contents of the function and of the functions it calls, which may change
+  // across processes for the same function name.
+  tensorflow::Fprint128 DiskCacheKey(
+      const DTensorOperation& doperation,
+      const tensorflow::FunctionLibraryDefinition& flib_def,
+      const absl::optional<Layout>& default_layout,
+      tensorflow::Fprint128 cache_key) const;
+
+  // Loads the functions saved under `disk_cache_key`, adds them to `context`
+  // and caches them in memory under `cache_key`. Returns a nullptr if no
+  // functions were saved, or if they could not be loaded.
+  const ExecutionFunctions* LoadCachedFunction(
+      const DTensorOperation& doperation, tensorflow::Fprint128 cache_key,
+      tensorflow::Fprint128 disk_cache_key, TFE_Context* context);
+
+  // Saves `functions`, with all the functions they call from `flib_def`, under
+  // `disk_cache_key`. Failures are logged but otherwise ignored.
+  void SaveCachedFunction(
+      tensorflow::Fprint128 disk_cache_key, const ExecutionFunctions& functions,
+      const tensorflow::FunctionLibraryDefinition& flib_def);
 
   // Returns the cache key and the cached lowered graph for the function.
   // Returns a nullptr for the lowered graph if there is a cache miss.
@@ -575,11 +611,29 @@ class FunctionManager {
       const std::vector<TensorWithLayout*>& inputs,
       const std::vector<const Layout*>& output_layouts);
 
+  // Returns the path of the file saving the functions under `disk_cache_key`.
+  std::string DiskCachePath(tensorflow::Fprint128 disk_cache_key) const;
+
+  struct CachedFunction {
+    ExecutionFunctions functions;
+    // Position of the entry in `lru_list_`.
+    std::list<tensorflow::Fprint128>::iterator lru_position;
+  };
+
   // Maps the hash of a graph with the lowered graph.
-  absl::flat_hash_map<tensorflow::Fprint128, ExecutionFunctions,
+  absl::flat_hash_map<tensorflow::Fprint128, CachedFunction,
                       tensorflow::Fprint128Hasher>
       function_cache_;
 
+  // Keys of `function_cache_`, from the most recently used.
+  std::list<tensorflow::Fprint128> lru_list_;
+
+  // Maximum number of entries of `function_cache_`, or 0 if not bounded.
+  const int max_size_;
+
+  // Directory of the on-disk tier, or empty if it is disabled.
+  const std::string cache_dir_;
+
   // Maps the hash of dtensor_operation and its input shapes to a map
   // representing the small constant indices and values to the function. The
   // small constant indices are saved to make faster comparisons for constant
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/dtensor/cc/dtensor_utils.h"
 
 #include <cstdlib>
+#include <string>
 
 #include "absl/strings/numbers.h"
 #include "tensorflow/core/platform/logging.h"
@@ -97,5 +98,26 @@ int ReduceInBfloat16MaxGroupSize() {
   return 8;
 }
 
+int FunctionCacheMaxSize() {
+  char* dtensor_function_cache_max_size_str =
+      std::getenv("DTENSOR_FUNCTION_CACHE_MAX_SIZE");
+  if (dtensor_function_cache_max_size_str == nullptr) return 0;
+  int dtensor_function_cache_max_size;
+  if (absl::SimpleAtoi(dtensor_function_cache_max_size_str,
+                       &dtensor_function_cache_max_size) &&
+      dtensor_function_cache_max_size >= 0)
+    return dtensor_function_cache_max_size;
+  LOG(WARNING) << "Invalid DTENSOR_FUNCTION_CACHE_MAX_SIZE, using "
+                  "the default value 0.";
+  return 0;
+}
+
+std::string FunctionCacheDir() {
+  char* dtensor_function_cache_dir_str =
+      std::getenv("DTENSOR_FUNCTION_CACHE_DIR");
+  if (dtensor_function_cache_dir_str == nullptr) return "";
+  return dtensor_function_cache_dir_str;
+}
+
 }  // namespace dtensor
 }  // namespace tensorflow
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_DTENSOR_CC_DTENSOR_UTILS_H_
 #define TENSORFLOW_DTENSOR_CC_DTENSOR_UTILS_H_
 
+#include <string>
+
 namespace tensorflow {
 namespace dtensor {
 
@@ -51,6 +53,15 @@ bool DoNotFuseReduceScatter();
 // reduce op.
 int ReduceInBfloat16MaxGroupSize();
 
+// Returns the maximum number of lowered computations kept in the function cache
+// of the DTensor device, or 0 if the cache is not bounded.
+int FunctionCacheMaxSize();
+
+// Returns the directory where the DTensor device saves the lowered functions,
+// so that other processes can load them instead of lowering them again, or an
+// empty string if the functions are not saved.
+std::string FunctionCacheDir();
+
 }  // namespace dtensor
 }  // namespace tensorflow
 
@@ -19,9 +19,11 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "tensorflow/lite/core/api/error_reporter.h"
 
@@ -60,8 +62,24 @@ class Allocation {
 // Use `IsSupported()` to check.
 class MMAPAllocation : public Allocation {
  public:
+  // Options to reduce the page faults taken when the mapped model is first
+  // read, e.g. by the first inference. All of them are best-effort hints.
+  struct Options {
+    // Populates the whole mapping when it is created, reading the file
+    // synchronously.
+    bool prefault = false;
+    // Asks the kernel to back the mapping with transparent huge pages, which
+    // requires kernel and file system support for file-backed huge pages.
+    bool use_huge_pages = false;
+    // Starts reading the file ahead, and touches every page of the mapping on
+    // a background thread after it is created.
+    bool warm_up_async = false;
+  };
+
   // Loads and maps the provided file to a memory region.
   MMAPAllocation(const char* filename, ErrorReporter* error_reporter);
+  MMAPAllocation(const char* filename, const Options& options,
+                 ErrorReporter* error_reporter);
 
   // Maps the provided file descriptor to a memory region.
   // Note: The provided file descriptor will be dup'ed for usage; the caller
@@ -74,6 +92,8 @@ class MMAPAllocation : public Allocation {
   // retains ownership of the provided descriptor and should close accordingly.
   MMAPAllocation(int fd, size_t offset, size_t length,
                  ErrorReporter* error_reporter);
+  MMAPAllocation(int fd, size_t offset, size_t length, const Options& options,
+                 ErrorReporter* error_reporter);
 
   ~MMAPAllocation() override;
   const void* base() const override;
@@ -94,12 +114,22 @@ class MMAPAllocation : public Allocation {
 
  private:
   // Assumes ownership of the provided `owned_fd` instance.
-  MMAPAllocation(ErrorReporter* error_reporter, int owned_fd);
+  MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                 const Options& options);
 
   // Assumes ownership of the provided `owned_fd` instance, and uses the given
   // offset and length (both in bytes) for memory mapping.
   MMAPAllocation(ErrorReporter* error_reporter, int owned_fd, size_t offset,
-                 size_t length);
+                 size_t length, const Options& options);
+
+  // Reads one byte of every page of the mapping, stopping early if
+  // `stop_warm_up_` is set.
+  void TouchPages();
+
+  // Runs `TouchPages()` when `Options::warm_up_async` is set, and is joined
+  // before the memory is unmapped.
+  std::thread warm_up_thread_;
+  std::atomic<bool> stop_warm_up_{false};
 };
 
 class FileCopyAllocation : public Allocation {
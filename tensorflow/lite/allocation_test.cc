@@ -20,6 +20,7 @@ limitations under the License.
 
 #include <sys/stat.h>
 
+#include <cstring>
 #include <string>
 
 #include <gtest/gtest.h>
@@ -139,6 +140,55 @@ TEST(MMAPAllocation, TestValidFileDescriptorWithOffset) {
 
   close(fd);
 }
+
+TEST(MMAPAllocation, TestOptions) {
+  if (!MMAPAllocation::IsSupported()) {
+    return;
+  }
+
+  const char* filename = "tensorflow/lite/testdata/empty_model.bin";
+  TestErrorReporter error_reporter;
+  FileCopyAllocation expected(filename, &error_reporter);
+  ASSERT_TRUE(expected.valid());
+
+  for (int i = 0; i < 8; ++i) {
+    MMAPAllocation::Options options;
+    options.prefault = i & 1;
+    options.use_huge_pages = i & 2;
+    options.warm_up_async = i & 4;
+    MMAPAllocation allocation(filename, options, &error_reporter);
+    ASSERT_TRUE(allocation.valid());
+    ASSERT_EQ(allocation.bytes(), expected.bytes());
+    EXPECT_EQ(
+        std::memcmp(allocation.base(), expected.base(), expected.bytes()), 0);
+  }
+}
+
+TEST(MMAPAllocation, TestOptionsWithOffset) {
+  if (!MMAPAllocation::IsSupported()) {
+    return;
+  }
+
+  const char* filename = "tensorflow/lite/testdata/empty_model.bin";
+  TestErrorReporter error_reporter;
+  FileCopyAllocation expected(filename, &error_reporter);
+  ASSERT_TRUE(expected.valid());
+  int fd = open(filename, O_RDONLY);
+  ASSERT_GT(fd, 0);
+
+  MMAPAllocation::Options options;
+  options.use_huge_pages = true;
+  options.warm_up_async = true;
+  MMAPAllocation allocation(fd, /*offset=*/10,
+                            /*length=*/expected.bytes() - 10, options,
+                            &error_reporter);
+  close(fd);
+  ASSERT_TRUE(allocation.valid());
+  EXPECT_EQ(std::memcmp(allocation.base(),
+                        static_cast<const char*>(expected.base()) + 10,
+                        allocation.bytes()),
+            0);
+}
 #endif  // defined(__linux__)
 
 }  // namespace tflite
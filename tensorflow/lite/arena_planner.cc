@@ -110,7 +110,9 @@ TfLiteStatus ArenaPlanner::PlanAllocations() {
       return kTfLiteOk;
     }
     TF_LITE_ENSURE(context_, dealloc_node_[tensor] == kNodeNotAssigned);
-    dealloc_node_[tensor] = node;
+    // The tensor is in use until all nodes that may run concurrently with its
+    // last consumer completed.
+    dealloc_node_[tensor] = graph_info_->last_concurrent_node(node);
     return kTfLiteOk;
   };
 
@@ -204,7 +206,7 @@ TfLiteStatus ArenaPlanner::ExecuteAllocations(int first_node, int last_node) {
       int tensor_index = node_temporaries->data[j];
       alloc_node_[tensor_index] = i;
       if (!preserve_all_tensors_) {
-        dealloc_node_[tensor_index] = i;
+        dealloc_node_[tensor_index] = graph_info_->last_concurrent_node(i);
       }
     }
   }
@@ -309,6 +311,18 @@ std::vector<int32_t> ArenaPlanner::CreateTensorAllocationVector(int first_node,
 }
 
 TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
+  // Plans starting from empty arenas only depend on the tensors, so they can
+  // be reused when the tensors are the same as for a previous plan.
+  const bool cacheable = first_node == 0 && arena_.IsPlanEmpty() &&
+                         persistent_arena_.IsPlanEmpty();
+  std::vector<size_t> plan_key;
+  if (cacheable) {
+    plan_key = CreatePlanKey(last_node);
+    if (RestoreCachedPlan(plan_key)) {
+      return kTfLiteOk;
+    }
+  }
+
   // Indices of tensors in order their allocation offsets will be calculated.
   const std::vector<int32_t> tensor_order =
       CreateTensorAllocationVector(first_node, last_node);
@@ -341,9 +355,47 @@ TfLiteStatus ArenaPlanner::CalculateAllocations(int first_node, int last_node) {
           &allocs_[tensor_index]));
     }
   }
+
+  if (cacheable) {
+    CachePlan(std::move(plan_key));
+  }
   return kTfLiteOk;
 }
 
+std::vector<size_t> ArenaPlanner::CreatePlanKey(int last_node) const {
+  std::vector<size_t> key = {static_cast<size_t>(last_node),
+                             graph_info_->num_tensors()};
+  for (int i = 0; i < static_cast<int>(graph_info_->num_tensors()); ++i) {
+    if (alloc_node_[i] > last_node) continue;
+    const TfLiteTensor& tensor = *graph_info_->tensor(i);
+    key.insert(key.end(),
+               {static_cast<size_t>(i), static_cast<size_t>(alloc_node_[i]),
+                static_cast<size_t>(dealloc_node_[i]),
+                static_cast<size_t>(tensor.allocation_type), tensor.bytes});
+  }
+  return key;
+}
+
+bool ArenaPlanner::RestoreCachedPlan(const std::vector<size_t>& key) {
+  for (const CachedPlan& plan : cached_plans_) {
+    if (plan.key == key) {
+      allocs_ = plan.allocs;
+      arena_.SetPlan(plan.arena_plan);
+      persistent_arena_.SetPlan(plan.persistent_arena_plan);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ArenaPlanner::CachePlan(std::vector<size_t> key) {
+  if (cached_plans_.size() >= kMaxCachedPlans) {
+    cached_plans_.erase(cached_plans_.begin());
+  }
+  cached_plans_.push_back({std::move(key), allocs_, arena_.GetPlan(),
+                           persistent_arena_.GetPlan()});
+}
+
 TfLiteStatus ArenaPlanner::ResolveTensorAllocation(int tensor_index) {
   TfLiteTensor& tensor = *graph_info_->tensor(tensor_index);
   if (tensor.allocation_type == kTfLiteArenaRw) {
@@ -89,6 +89,17 @@ class ArenaPlanner : public MemoryPlanner {
   // for all tensors affected by ops in the interval [first_node, last_node].
   TfLiteStatus CalculateAllocations(int first_node, int last_node);
 
+  // Returns the inputs of the plan of the tensors affected by ops in the
+  // interval [0, last_node]: the lifetimes, allocation types and sizes of the
+  // tensors.
+  std::vector<size_t> CreatePlanKey(int last_node) const;
+
+  // Restores the plan cached for `key`, if any, and returns true if it did.
+  bool RestoreCachedPlan(const std::vector<size_t>& key);
+
+  // Caches the current plan for `key`.
+  void CachePlan(std::vector<size_t> key);
+
   // Assign absolute memory location to a tensor, based on its relative
   // position inside the corresponding arena buffer.
   TfLiteStatus ResolveTensorAllocation(int tensor_index);
@@ -130,6 +141,23 @@ class ArenaPlanner : public MemoryPlanner {
 
   // Number of bytes that tensor buffers should be aligned to.
   int tensor_alignment_;
+
+  // Maximum number of plans in `cached_plans_`.
+  static constexpr int kMaxCachedPlans = 4;
+
+  // A plan of the whole graph made by `CalculateAllocations()`.
+  struct CachedPlan {
+    std::vector<size_t> key;
+    std::vector<ArenaAllocWithUsageInterval> allocs;
+    SimpleMemoryArena::Plan arena_plan;
+    SimpleMemoryArena::Plan persistent_arena_plan;
+  };
+
+  // Recent plans of the whole graph, from the oldest to the most recent. Since
+  // plans only depend on the sizes and lifetimes of the tensors, models that
+  // alternate between a few input shapes, such as sequence models, reuse the
+  // plan of each shape instead of planning again after each resize.
+  std::vector<CachedPlan> cached_plans_;
 };
 
 }  // namespace tflite
@@ -128,16 +128,27 @@ class TestGraph {
   const std::vector<int>& outputs() { return outputs_; }
   const std::vector<int>& variables() { return variables_; }
 
+  const std::vector<int>& last_concurrent_nodes() {
+    return last_concurrent_nodes_;
+  }
+
   void SetVariables(const std::vector<int>& variables) {
     variables_ = variables;
   }
 
+  // `last_concurrent_nodes[i]` is the last node that may run concurrently with
+  // node `i`.
+  void SetLastConcurrentNodes(const std::vector<int>& last_concurrent_nodes) {
+    last_concurrent_nodes_ = last_concurrent_nodes;
+  }
+
   void Swap(TestGraph* other) {
     std::swap(nodes_, other->nodes_);
     std::swap(tensors_, other->tensors_);
     std::swap(inputs_, other->inputs_);
     std::swap(outputs_, other->outputs_);
     std::swap(variables_, other->variables_);
+    std::swap(last_concurrent_nodes_, other->last_concurrent_nodes_);
   }
 
  private:
@@ -146,6 +157,7 @@ class TestGraph {
   std::vector<int> inputs_;
   std::vector<int> outputs_;
   std::vector<int> variables_;
+  std::vector<int> last_concurrent_nodes_;
 };
 
 // The GraphInfo for a TestGraph.
@@ -168,6 +180,10 @@ class TestGraphInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return graph_->variables();
   }
+  size_t last_concurrent_node(size_t index) const override {
+    const std::vector<int>& last_nodes = graph_->last_concurrent_nodes();
+    return index < last_nodes.size() ? last_nodes[index] : index;
+  }
 
  private:
   TestGraph* graph_;
@@ -307,6 +323,76 @@ TEST_F(ArenaPlannerTest, SimpleGraph) {
   EXPECT_EQ(GetOffset(1), 4);
 }
 
+TEST_F(ArenaPlannerTest, ConcurrentNodesDoNotShareMemory) {
+  TestGraph graph({0},
+                  {
+                      /* in, out, tmp */
+                      {{0}, {1}, {2}},     // First op
+                      {{0}, {3}, {4}},     // Second op
+                      {{1, 3}, {5}, {}}    // Third op
+                  },
+                  {5});
+  auto overlap = [this](int a, int b) {
+    return GetOffset(a) < GetOffsetAfter(b) && GetOffset(b) < GetOffsetAfter(a);
+  };
+
+  // When the ops run one at a time, the temporaries of the first two ops can
+  // share memory.
+  SetGraph(&graph);
+  Execute(0, 10);
+  EXPECT_TRUE(overlap(2, 4));
+
+  // When the first two ops run concurrently, none of the tensors they use can
+  // share memory.
+  graph.SetLastConcurrentNodes({1, 1, 2});
+  SetGraph(&graph);
+  Execute(0, 10);
+  const std::vector<int> concurrent_tensors = {0, 1, 2, 3, 4};
+  for (int a : concurrent_tensors) {
+    for (int b : concurrent_tensors) {
+      if (a != b) EXPECT_FALSE(overlap(a, b)) << a << " " << b;
+    }
+  }
+}
+
+TEST_F(ArenaPlannerTest, SimpleGraphReusesPlanAfterResize) {
+  TestGraph graph({0, 1},
+                  {
+                      /* in, out, tmp */
+                      {{0, 1}, {2}, {}},     // First op
+                      {{2, 0}, {4, 5}, {}},  // Second op
+                      {{4, 5}, {3}, {}}      // Third op
+                  },
+                  {3});
+  SetGraph(&graph);
+  Execute(0, 10);
+  std::vector<std::ptrdiff_t> offsets;
+  for (int i = 0; i < 6; ++i) offsets.push_back(GetOffset(i));
+
+  // Make #1 larger, as after resizing an input, and plan again.
+  (*graph.tensors())[1].bytes = 40;
+  ASSERT_EQ(planner_->ResetAllocations(), kTfLiteOk);
+  Execute(0, 10);
+  EXPECT_EQ(GetOffset(1), 4);
+  EXPECT_EQ(GetOffset(5), GetOffsetAfter(1));
+
+  // Going back to the original size gives the original plan, in an arena that
+  // is still large enough for the larger plan.
+  (*graph.tensors())[1].bytes = 6;
+  ASSERT_EQ(planner_->ResetAllocations(), kTfLiteOk);
+  Execute(0, 10);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]) << i;
+  }
+
+  // The plan is the same as that of a new planner.
+  SetGraph(&graph);
+  Execute(0, 10);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(GetOffset(i), offsets[i]) << i;
+  }
+}
+
 TEST_F(ArenaPlannerTest, SimpleGraphInputsPreserved) {
   TestGraph graph({0, 1},
                   {
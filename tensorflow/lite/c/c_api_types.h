@@ -99,6 +99,9 @@ typedef enum {
   kTfLiteVariant = 15,
   kTfLiteUInt32 = 16,
   kTfLiteUInt16 = 17,
+  // Signed 4-bit integers, packed two per byte with the lower nibble first.
+  // Each row of the innermost dimension starts on a byte boundary.
+  kTfLiteInt4 = 18,
 } TfLiteType;
 
 // Legacy. Will be deprecated in favor of TfLiteAffineQuantization.
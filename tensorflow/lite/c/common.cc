@@ -257,6 +257,8 @@ const char* TfLiteTypeGetName(TfLiteType type) {
       return "UINT8";
     case kTfLiteInt8:
       return "INT8";
+    case kTfLiteInt4:
+      return "INT4";
     case kTfLiteInt64:
       return "INT64";
     case kTfLiteUInt64:
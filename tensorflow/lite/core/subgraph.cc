@@ -19,17 +19,24 @@ limitations under the License.
 #include <stddef.h>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <numeric>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/builtin_ops.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/c/common_internal.h"
@@ -38,7 +45,9 @@ limitations under the License.
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/core/macros.h"
+#include "tensorflow/lite/experimental/remat/rematerializer.h"
 #include "tensorflow/lite/experimental/resource/resource_base.h"
+#include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/graph_info.h"
 #include "tensorflow/lite/memory_planner.h"
 #include "tensorflow/lite/minimal_logging.h"
@@ -188,8 +197,212 @@ TfLiteStatus VerifyCustomAllocationForTensor(
   return kTfLiteOk;
 }
 
+// Returns true if `node` reads or writes a tensor whose contents may be
+// accessed outside of the data flow of the graph, so that it must not run
+// concurrently with other nodes.
+bool UsesStatefulTensors(const std::vector<TfLiteTensor>& tensors,
+                         const TfLiteNode& node) {
+  for (const TfLiteIntArray* tensor_indices : {node.inputs, node.outputs}) {
+    for (int tensor_index : TfLiteIntArrayView(tensor_indices)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors[tensor_index];
+      if (tensor.is_variable || tensor.type == kTfLiteResource ||
+          tensor.type == kTfLiteVariant || tensor.type == kTfLiteString) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if the builtin op `builtin_code` is cheap to recompute and
+// stateless, and sets `*builtin_data_size` to the size of its builtin data,
+// which is copied for the nodes that recompute its outputs.
+bool GetRematerializableBuiltinDataSize(int builtin_code,
+                                        size_t* builtin_data_size) {
+  switch (builtin_code) {
+    case kTfLiteBuiltinAbs:
+    case kTfLiteBuiltinDequantize:
+    case kTfLiteBuiltinExpandDims:
+    case kTfLiteBuiltinLogistic:
+    case kTfLiteBuiltinMaximum:
+    case kTfLiteBuiltinMinimum:
+    case kTfLiteBuiltinNeg:
+    case kTfLiteBuiltinRelu:
+    case kTfLiteBuiltinRelu6:
+    case kTfLiteBuiltinTanh:
+      *builtin_data_size = 0;
+      return true;
+    case kTfLiteBuiltinAdd:
+      *builtin_data_size = sizeof(TfLiteAddParams);
+      return true;
+    case kTfLiteBuiltinCast:
+      *builtin_data_size = sizeof(TfLiteCastParams);
+      return true;
+    case kTfLiteBuiltinMul:
+      *builtin_data_size = sizeof(TfLiteMulParams);
+      return true;
+    case kTfLiteBuiltinReshape:
+      *builtin_data_size = sizeof(TfLiteReshapeParams);
+      return true;
+    case kTfLiteBuiltinSqueeze:
+      *builtin_data_size = sizeof(TfLiteSqueezeParams);
+      return true;
+    case kTfLiteBuiltinSub:
+      *builtin_data_size = sizeof(TfLiteSubParams);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if the single output of `node` may be recomputed by a copy of
+// the node.
+bool IsRematerializable(const std::vector<TfLiteTensor>& tensors,
+                        const TfLiteNode& node,
+                        const TfLiteRegistration& registration) {
+  size_t builtin_data_size;
+  if (!GetRematerializableBuiltinDataSize(registration.builtin_code,
+                                          &builtin_data_size) ||
+      (builtin_data_size == 0 && node.builtin_data != nullptr)) {
+    return false;
+  }
+  if (node.delegate != nullptr || node.might_have_side_effect ||
+      (node.intermediates != nullptr && node.intermediates->size != 0) ||
+      node.outputs->size != 1) {
+    return false;
+  }
+  const int output = node.outputs->data[0];
+  return output >= 0 && tensors[output].allocation_type == kTfLiteArenaRw;
+}
+
+// Returns a deep copy of `quantization`.
+TfLiteQuantization CopyQuantization(const TfLiteQuantization& quantization) {
+  TfLiteQuantization copy = {kTfLiteNoQuantization, nullptr};
+  if (quantization.type != kTfLiteAffineQuantization ||
+      quantization.params == nullptr) {
+    return copy;
+  }
+  const auto* params =
+      static_cast<const TfLiteAffineQuantization*>(quantization.params);
+  auto* copy_params = static_cast<TfLiteAffineQuantization*>(
+      malloc(sizeof(TfLiteAffineQuantization)));
+  copy_params->scale = nullptr;
+  if (params->scale != nullptr) {
+    copy_params->scale = TfLiteFloatArrayCreate(params->scale->size);
+    std::copy_n(params->scale->data, params->scale->size,
+                copy_params->scale->data);
+  }
+  copy_params->zero_point = params->zero_point != nullptr
+                                ? TfLiteIntArrayCopy(params->zero_point)
+                                : nullptr;
+  copy_params->quantized_dimension = params->quantized_dimension;
+  copy.type = kTfLiteAffineQuantization;
+  copy.params = copy_params;
+  return copy;
+}
+
+// The CPU backend context to use instead of the one of the interpreter on the
+// current thread, if set. Set on the threads of `ConcurrentNodeRunner`.
+thread_local ExternalCpuBackendContext* thread_cpu_backend_context = nullptr;
+
 }  // namespace
 
+// Runs tasks on the calling thread and on a fixed set of worker threads. Each
+// worker thread has its own CPU backend context, limited to one thread after
+// its first use, so that the kernels running concurrently don't share the
+// thread pools and caches of the backend.
+class Subgraph::ConcurrentNodeRunner {
+ public:
+  explicit ConcurrentNodeRunner(int num_threads) {
+    for (int i = 1; i < num_threads; ++i) {
+      cpu_backend_contexts_.emplace_back(new ExternalCpuBackendContext());
+    }
+    for (auto& cpu_backend_context : cpu_backend_contexts_) {
+      workers_.emplace_back(&ConcurrentNodeRunner::WorkerLoop, this,
+                            cpu_backend_context.get());
+    }
+  }
+
+  ~ConcurrentNodeRunner() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int num_threads() const { return workers_.size() + 1; }
+
+  // Calls `task(i)` for every `i` in [0, num_tasks), and returns when all the
+  // calls are done.
+  void Run(int num_tasks, const std::function<void(int)>& task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      num_tasks_ = num_tasks;
+      next_task_.store(0);
+      num_busy_workers_ = workers_.size();
+      ++generation_;
+    }
+    work_cv_.notify_all();
+    RunTasks();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return num_busy_workers_ == 0; });
+    task_ = nullptr;
+  }
+
+ private:
+  void RunTasks() {
+    for (int i = next_task_.fetch_add(1); i < num_tasks_;
+         i = next_task_.fetch_add(1)) {
+      (*task_)(i);
+    }
+  }
+
+  void WorkerLoop(ExternalCpuBackendContext* cpu_backend_context) {
+    thread_cpu_backend_context = cpu_backend_context;
+    int64_t generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cv_.wait(lock,
+                      [&] { return stop_ || generation_ != generation; });
+        if (stop_) return;
+        generation = generation_;
+      }
+      RunTasks();
+      // The internal context is created by the first kernel that uses it,
+      // with the number of threads of the interpreter.
+      if (TfLiteInternalBackendContext* internal_context =
+              cpu_backend_context->internal_backend_context()) {
+        internal_context->SetMaxNumThreads(1);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--num_busy_workers_ == 0) done_cv_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<ExternalCpuBackendContext>>
+      cpu_backend_contexts_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  bool stop_ = false;
+  int64_t generation_ = 0;
+  int num_busy_workers_ = 0;
+  const std::function<void(int)>* task_ = nullptr;
+  int num_tasks_ = 0;
+  std::atomic<int> next_task_{0};
+};
+
 // A trivial implementation of GraphInfo around the Interpreter.
 // NOTE: this interpreter info represents the subset of the
 // graph that is executed according to execution plan. Thus,
@@ -223,6 +436,11 @@ class InterpreterInfo : public GraphInfo {
   const std::vector<int>& variables() const override {
     return subgraph_->variables();
   }
+  size_t last_concurrent_node(size_t index) const override {
+    const std::vector<int>& group_end = subgraph_->concurrent_group_end_;
+    if (group_end.size() != num_execution_nodes()) return index;
+    return group_end[index] - 1;
+  }
 
  public:
   Subgraph* subgraph_;
@@ -471,6 +689,9 @@ TfLiteStatus Subgraph::ReplaceNodeSubsetsWithDelegateKernels(
 
 TfLiteExternalContext* Subgraph::GetExternalContext(
     TfLiteExternalContextType type) {
+  if (type == kTfLiteCpuBackendContext && thread_cpu_backend_context) {
+    return thread_cpu_backend_context;
+  }
   if (static_cast<int>(type) >= 0 && type < kTfLiteMaxExternalContexts) {
     return external_contexts_[type];
   }
@@ -698,6 +919,12 @@ TfLiteStatus Subgraph::BytesRequired(TfLiteType type, const int* dims,
         MultiplyAndCheckOverflow(old_count, dims[k], &count) == kTfLiteOk,
         "BytesRequired number of elements overflowed.\n");
   }
+  if (type == kTfLiteInt4) {
+    // Each row of the innermost dimension is packed two values per byte.
+    const size_t row_size = dims_size > 0 ? dims[dims_size - 1] : 1;
+    *bytes = row_size > 0 ? count / row_size * ((row_size + 1) / 2) : 0;
+    return kTfLiteOk;
+  }
   size_t type_size = 0;
   TF_LITE_ENSURE_OK(&context_, GetSizeOfType(&context_, type, &type_size));
   TF_LITE_ENSURE_MSG(
@@ -750,6 +977,7 @@ TfLiteStatus Subgraph::AllocateTensors() {
     TF_LITE_ENSURE_STATUS(memory_planner_->ResetAllocations());
   }
 
+  TF_LITE_ENSURE_STATUS(MaybeGroupIndependentNodes());
   TF_LITE_ENSURE_STATUS(PrepareOpsAndTensors());
 
   state_ = kStateInvokable;
@@ -767,6 +995,171 @@ TfLiteStatus Subgraph::AllocateTensors() {
   return kTfLiteOk;
 }
 
+TfLiteStatus Subgraph::MaybeGroupIndependentNodes() {
+  const int max_concurrent_nodes = MaxConcurrentNodes();
+  if (max_concurrent_nodes <= 1) {
+    concurrent_group_end_.clear();
+    grouped_execution_plan_.clear();
+    concurrent_node_runner_.reset();
+    return kTfLiteOk;
+  }
+
+  if (concurrent_group_end_.empty() ||
+      execution_plan_ != grouped_execution_plan_) {
+    // Delegate kernels and custom ops may use resources shared with other
+    // nodes, and stateful tensors may be accessed by any node.
+    std::vector<bool> is_barrier(execution_plan_.size());
+    for (int i = 0; i < execution_plan_.size(); ++i) {
+      const auto& node_and_registration =
+          nodes_and_registration_[execution_plan_[i]];
+      const TfLiteNode& node = node_and_registration.first;
+      const TfLiteRegistration& registration = node_and_registration.second;
+      is_barrier[i] = node.delegate != nullptr ||
+                      registration.builtin_code == kTfLiteBuiltinCustom ||
+                      registration.builtin_code == kTfLiteBuiltinDelegate ||
+                      UsesStatefulTensors(tensors_, node);
+    }
+    std::vector<int> execution_plan;
+    InterpreterInfo info(this);
+    GroupIndependentNodes(&info, is_barrier, &execution_plan,
+                          &concurrent_group_end_);
+    execution_plan_ = execution_plan;
+    grouped_execution_plan_ = std::move(execution_plan);
+    // The memory planner must account for the nodes that run concurrently.
+    if (memory_planner_) {
+      TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+    }
+  }
+
+  if (!concurrent_node_runner_ ||
+      concurrent_node_runner_->num_threads() != max_concurrent_nodes) {
+    concurrent_node_runner_ =
+        std::make_unique<ConcurrentNodeRunner>(max_concurrent_nodes);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Subgraph::MaybeRematerialize(
+    int* last_execution_plan_index_prepared) {
+  const size_t memory_budget = RematerializationMemoryBudget();
+  // The sizes of all tensors must be known. Grouping concurrent nodes by
+  // depth would move the recomputations away from their uses, and delegate
+  // kernels manage their own memory.
+  if (memory_budget == 0 || rematerialization_planned_ ||
+      MaxConcurrentNodes() > 1 || HasDelegates() ||
+      ShouldPreserveAllTensors() || has_dynamic_tensors_ ||
+      *last_execution_plan_index_prepared + 1 != execution_plan_.size()) {
+    return kTfLiteOk;
+  }
+  rematerialization_planned_ = true;
+
+  // The last operation stands for the end of the execution, keeping the
+  // outputs live from their producers on, like the `ArenaPlanner` does.
+  std::vector<Rematerializer::Operation> operations(execution_plan_.size() +
+                                                    1);
+  operations.back().inputs = outputs_;
+  for (int i = 0; i < execution_plan_.size(); ++i) {
+    const auto& node_and_registration =
+        nodes_and_registration_[execution_plan_[i]];
+    const TfLiteNode& node = node_and_registration.first;
+    Rematerializer::Operation& operation = operations[i];
+    operation.inputs.assign(node.inputs->data,
+                            node.inputs->data + node.inputs->size);
+    operation.outputs.assign(node.outputs->data,
+                             node.outputs->data + node.outputs->size);
+    for (int tensor_index : TfLiteIntArrayView(node.temporaries)) {
+      if (tensors_[tensor_index].allocation_type == kTfLiteArenaRw) {
+        operation.scratch_bytes += tensors_[tensor_index].bytes;
+      }
+    }
+    operation.is_rematerializable =
+        IsRematerializable(tensors_, node, node_and_registration.second) &&
+        std::find(outputs_.begin(), outputs_.end(), node.outputs->data[0]) ==
+            outputs_.end();
+  }
+  std::vector<size_t> tensor_sizes(tensors_.size(), 0);
+  for (int i = 0; i < tensors_.size(); ++i) {
+    if (tensors_[i].allocation_type == kTfLiteArenaRw) {
+      tensor_sizes[i] = tensors_[i].bytes;
+    }
+  }
+  std::vector<int> pinned_tensors = inputs_;
+  pinned_tensors.insert(pinned_tensors.end(), variables_.begin(),
+                        variables_.end());
+
+  Rematerializer rematerializer(std::move(operations), std::move(tensor_sizes),
+                                pinned_tensors);
+  const size_t peak_bytes = rematerializer.GetPeakMemory();
+  const std::vector<Rematerializer::Remat> remats =
+      rematerializer.Run(memory_budget, /*max_remats=*/execution_plan_.size());
+  if (rematerializer.GetPeakMemory() > memory_budget) {
+    TFLITE_LOG_PROD(tflite::TFLITE_LOG_WARNING,
+                    "Rematerialization reduced the estimated peak memory "
+                    "from %zu to %zu bytes, above the budget of %zu bytes.",
+                    peak_bytes, rematerializer.GetPeakMemory(), memory_budget);
+  }
+  if (remats.empty()) return kTfLiteOk;
+
+  // Maps the tensor ids of `rematerializer` to tensor indices.
+  std::vector<int> tensor_indices(tensors_.size());
+  std::iota(tensor_indices.begin(), tensor_indices.end(), 0);
+  for (const Rematerializer::Remat& remat : remats) {
+    // Copies what the new node needs, since adding tensors and nodes may
+    // reallocate them.
+    const int source_node_index = execution_plan_[remat.operation];
+    const TfLiteNode& source = nodes_and_registration_[source_node_index].first;
+    const TfLiteRegistration registration =
+        nodes_and_registration_[source_node_index].second;
+    const std::vector<int> inputs(source.inputs->data,
+                                  source.inputs->data + source.inputs->size);
+    size_t builtin_data_size = 0;
+    GetRematerializableBuiltinDataSize(registration.builtin_code,
+                                       &builtin_data_size);
+    void* builtin_data = nullptr;
+    if (source.builtin_data != nullptr && builtin_data_size > 0) {
+      builtin_data = malloc(builtin_data_size);
+      memcpy(builtin_data, source.builtin_data, builtin_data_size);
+    }
+
+    const int tensor_index = tensor_indices[remat.tensor];
+    int new_tensor_index;
+    TF_LITE_ENSURE_STATUS(AddTensors(1, &new_tensor_index));
+    TF_LITE_ENSURE_EQ(&context_, remat.new_tensor, tensor_indices.size());
+    tensor_indices.push_back(new_tensor_index);
+    const TfLiteTensor& tensor = tensors_[tensor_index];
+    const TfLiteIntArray* dims_signature =
+        tensor.dims_signature ? tensor.dims_signature : tensor.dims;
+    TF_LITE_ENSURE_STATUS(SetTensorParametersReadWrite(
+        new_tensor_index, tensor.type, tensor.name, tensor.dims->size,
+        tensor.dims->data, CopyQuantization(tensor.quantization),
+        /*is_variable=*/false, dims_signature->size, dims_signature->data));
+
+    int new_node_index;
+    TF_LITE_ENSURE_STATUS(AddNodeWithParameters(
+        inputs, {new_tensor_index}, {}, nullptr, 0, builtin_data,
+        &registration, &new_node_index));
+    // `AddNodeWithParameters` appends the node to the execution plan.
+    execution_plan_.pop_back();
+    for (int i = remat.insert_before; i < execution_plan_.size(); ++i) {
+      TfLiteIntArray* node_inputs =
+          nodes_and_registration_[execution_plan_[i]].first.inputs;
+      std::replace(node_inputs->data, node_inputs->data + node_inputs->size,
+                   tensor_index, new_tensor_index);
+    }
+    execution_plan_.insert(execution_plan_.begin() + remat.insert_before,
+                           new_node_index);
+  }
+  TFLITE_LOG_PROD(tflite::TFLITE_LOG_VERBOSE,
+                  "Rematerialized %zu tensor(s), reducing the estimated peak "
+                  "memory from %zu to %zu bytes.",
+                  remats.size(), peak_bytes, rematerializer.GetPeakMemory());
+
+  // Nothing was allocated yet for the original graph.
+  TF_LITE_ENSURE_STATUS(memory_planner_->PlanAllocations());
+  return PrepareOpsStartingAt(0, execution_plan_,
+                              last_execution_plan_index_prepared);
+}
+
 // TODO(b/115961645): Support non-zero default values.
 TfLiteStatus Subgraph::ResetVariableTensors() {
   for (auto& tensor : tensors_) {
@@ -1152,6 +1545,9 @@ TfLiteStatus Subgraph::PrepareOpsAndTensors() {
   TF_LITE_ENSURE_STATUS(
       PrepareOpsStartingAt(next_execution_plan_index_to_prepare_,
                            execution_plan_, &last_exec_plan_index_prepared));
+  if (next_execution_plan_index_to_prepare_ == 0) {
+    TF_LITE_ENSURE_STATUS(MaybeRematerialize(&last_exec_plan_index_prepared));
+  }
   next_execution_plan_index_to_prepare_ = last_exec_plan_index_prepared + 1;
 
   // Execute arena allocations.
@@ -1245,6 +1641,14 @@ TfLiteStatus Subgraph::Invoke() {
       tflite::OnTfLiteSubgraphInvoke(name_.c_str(), subgraph_index_);
 #endif  // TF_LITE_TENSORFLOW_PROFILER
 
+  // Groups of independent nodes may only run concurrently if the execution
+  // plan wasn't modified since they were computed. The events of a profiler
+  // must be nested, so nodes run one at a time when profiling.
+  const bool invoke_groups_concurrently =
+      concurrent_node_runner_ && !profiler_ &&
+      concurrent_group_end_.size() == execution_plan_.size() &&
+      execution_plan_ == grouped_execution_plan_;
+
   // Invocations are always done in node order.
   // Note that calling Invoke repeatedly will cause the original memory plan to
   // be reused, unless either ResizeInputTensor() or AllocateTensors() has been
@@ -1256,6 +1660,16 @@ TfLiteStatus Subgraph::Invoke() {
       TF_LITE_ENSURE(&context_, next_execution_plan_index_to_prepare_ >=
                                     execution_plan_index);
     }
+    if (invoke_groups_concurrently) {
+      const int group_end = concurrent_group_end_[execution_plan_index];
+      if (group_end - execution_plan_index > 1 &&
+          CanInvokeConcurrently(execution_plan_index, group_end)) {
+        TF_LITE_ENSURE_STATUS(
+            InvokeConcurrently(execution_plan_index, group_end));
+        execution_plan_index = group_end - 1;
+        continue;
+      }
+    }
     int node_index = execution_plan_[execution_plan_index];
     TfLiteNode& node = nodes_and_registration_[node_index].first;
     const TfLiteRegistration& registration =
@@ -1352,6 +1766,54 @@ TfLiteStatus Subgraph::Invoke() {
   return status;
 }
 
+bool Subgraph::CanInvokeConcurrently(int begin, int end) {
+  if (end > next_execution_plan_index_to_prepare_) return false;
+  for (int i = begin; i < end; ++i) {
+    const TfLiteNode& node = nodes_and_registration_[execution_plan_[i]].first;
+    // A resized dynamic output requires preparing the following nodes.
+    if (HasDynamicTensor(context_, node.outputs, nullptr)) return false;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index == kTfLiteOptionalTensor) continue;
+      const TfLiteTensor& tensor = tensors_[tensor_index];
+      if ((tensor.delegate && tensor.data_is_stale) ||
+          (tensor.data.raw == nullptr && tensor.bytes > 0)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+TfLiteStatus Subgraph::InvokeConcurrently(int begin, int end) {
+  if (check_cancelled_func_ != nullptr &&
+      check_cancelled_func_(cancellation_data_)) {
+    ReportError("Client requested cancel during Invoke()");
+    return kTfLiteError;
+  }
+
+  EnsureTensorsVectorCapacity();
+  tensor_resized_since_op_invoke_ = false;
+  std::vector<TfLiteStatus> statuses(end - begin, kTfLiteOk);
+  concurrent_node_runner_->Run(end - begin, [&](int i) {
+    auto& node_and_registration =
+        nodes_and_registration_[execution_plan_[begin + i]];
+    statuses[i] =
+        OpInvoke(node_and_registration.second, &node_and_registration.first);
+  });
+
+  for (int i = begin; i < end; ++i) {
+    const int node_index = execution_plan_[i];
+    const TfLiteNode& node = nodes_and_registration_[node_index].first;
+    if (statuses[i - begin] != kTfLiteOk) {
+      return ReportOpError(&context_, node,
+                           nodes_and_registration_[node_index].second,
+                           node_index, "failed to invoke");
+    }
+    MaybeReleaseDynamicTensors(node, node_index);
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus Subgraph::ResizeTensor(TfLiteContext* context,
                                     TfLiteTensor* tensor,
                                     TfLiteIntArray* new_size) {
@@ -437,7 +437,9 @@ class Subgraph {
 
  private:
   friend class InterpreterBuilder;
+  friend class InterpreterInfo;
   friend class TestDelegate;
+  class ConcurrentNodeRunner;
   // SubgraphAwareProfiler wraps an actual TFLite profiler, such as a
   // BufferedProfiler instance, and takes care of event profiling/tracing in a
   // certain subgraph.
@@ -742,6 +744,39 @@ class Subgraph {
   // tensors if configured.
   void MaybeReleaseDynamicTensors(const TfLiteNode& node, size_t node_index);
 
+  // Returns the maximum number of nodes that may run concurrently, as set by
+  // `InterpreterOptions::SetMaxConcurrentNodes`.
+  int MaxConcurrentNodes() const {
+    return options_ ? options_->GetMaxConcurrentNodes() : 1;
+  }
+
+  // Reorders `execution_plan_` so that nodes that may run concurrently are
+  // adjacent, and records the groups of such nodes in `concurrent_group_end_`,
+  // if `MaxConcurrentNodes()` is greater than one. Clears the groups
+  // otherwise.
+  TfLiteStatus MaybeGroupIndependentNodes();
+
+  // Returns true if the nodes at execution-plan indices [begin, end) can be
+  // invoked concurrently, that is, they are prepared and none of them reads a
+  // tensor without data or produces a dynamic tensor.
+  bool CanInvokeConcurrently(int begin, int end);
+
+  // Invokes the nodes at execution-plan indices [begin, end) concurrently.
+  TfLiteStatus InvokeConcurrently(int begin, int end);
+
+  // Returns the arena size targeted by rematerialization, as set by
+  // `InterpreterOptions::SetRematerializationMemoryBudget`.
+  size_t RematerializationMemoryBudget() const {
+    return options_ ? options_->GetRematerializationMemoryBudget() : 0;
+  }
+
+  // Adds nodes that recompute intermediate tensors before their late uses, as
+  // planned by `Rematerializer` for `RematerializationMemoryBudget()`, once
+  // all the nodes were prepared for the first time and before the arena is
+  // allocated. If nodes are added, plans and prepares the graph again, and
+  // updates `*last_execution_plan_index_prepared`.
+  TfLiteStatus MaybeRematerialize(int* last_execution_plan_index_prepared);
+
   // The state of the Subgraph.
   enum State {
     // The Subgraph isn't ready to be invoked.
@@ -903,6 +938,21 @@ class Subgraph {
 
   // `InterpreterOptions` object which is being used and owned by Interpreter.
   InterpreterOptions* options_;
+
+  // If not empty, `concurrent_group_end_[i]` is the execution-plan index one
+  // past the last node of the group of independent nodes that contains
+  // execution-plan index `i`. Set by `MaybeGroupIndependentNodes()`.
+  std::vector<int> concurrent_group_end_;
+
+  // The execution plan for which `concurrent_group_end_` was computed. The
+  // groups are ignored if `execution_plan_` is changed.
+  std::vector<int> grouped_execution_plan_;
+
+  // Threads that invoke groups of independent nodes.
+  std::unique_ptr<ConcurrentNodeRunner> concurrent_node_runner_;
+
+  // True once `MaybeRematerialize()` planned the graph.
+  bool rematerialization_planned_ = false;
 };
 
 }  // namespace tflite
@@ -24,6 +24,7 @@ limitations under the License.
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <variant>
 #include <vector>
 
@@ -919,6 +920,7 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     if (!IsValid(options)) {
       return absl::InvalidArgumentError("InferenceOptions are invalid.");
     }
+    std::lock_guard<std::mutex> lock(build_mutex_);
     InferenceOptions resolved_options = options;
     ResolveAutoPriority(&resolved_options);
     if (environment_.program_cache() &&
@@ -944,6 +946,7 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     if (!IsValid(options)) {
       return absl::InvalidArgumentError("InferenceOptions are invalid.");
     }
+    std::lock_guard<std::mutex> lock(build_mutex_);
     InferenceOptions resolved_options = options;
     ResolveAutoPriority(&resolved_options);
     if (environment_.program_cache() &&
@@ -966,6 +969,7 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
   absl::Status NewInferenceBuilder(
       const absl::Span<const uint8_t> serialized_model,
       std::unique_ptr<InferenceBuilder>* builder) final {
+    std::lock_guard<std::mutex> lock(build_mutex_);
     if (environment_.program_cache() &&
         !options_.serialized_binary_cache.empty()) {
       // Ignore returned error. Cache is discarded.
@@ -990,6 +994,15 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
     return data;
   }
 
+  void AddSerializedBinaryCache(
+      absl::Span<const uint8_t> serialized_binary_cache) {
+    // Ignore returned error. Cache is discarded.
+    environment_.program_cache()
+        ->AddSerializedCache(environment_.context(), environment_.device(),
+                             serialized_binary_cache)
+        .IgnoreError();
+  }
+
   const InferenceEnvironmentProperties& properties() const {
     return properties_;
   }
@@ -998,8 +1011,24 @@ class InferenceEnvironmentImpl : public InferenceEnvironment {
   const InferenceEnvironmentOptions options_;
   Environment environment_;
   InferenceEnvironmentProperties properties_;
+  // Serializes the creation of builders, which tune their kernels on the
+  // profiling queue of the environment, when it is shared by several
+  // delegates.
+  std::mutex build_mutex_;
 };
 
+// The environment returned by GetSharedInferenceEnvironment, that stays around
+// while any caller holds it.
+struct SharedInferenceEnvironment {
+  std::mutex mutex;
+  std::weak_ptr<InferenceEnvironmentImpl> environment;
+};
+
+SharedInferenceEnvironment& GetSharedEnvironment() {
+  static SharedInferenceEnvironment* shared = new SharedInferenceEnvironment;
+  return *shared;
+}
+
 }  // namespace
 
 absl::Status NewInferenceEnvironment(
@@ -1016,6 +1045,41 @@ absl::Status NewInferenceEnvironment(
   return absl::OkStatus();
 }
 
+absl::Status GetSharedInferenceEnvironment(
+    const InferenceEnvironmentOptions& options,
+    std::shared_ptr<InferenceEnvironment>* environment,
+    InferenceEnvironmentProperties* properties) {
+  if (options.device || options.context || options.command_queue ||
+      options.IsGlAware()) {
+    return absl::InvalidArgumentError(
+        "Shared OpenCL environment cannot use the given device, context, "
+        "command queue or EGL objects.");
+  }
+  SharedInferenceEnvironment& shared = GetSharedEnvironment();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  std::shared_ptr<InferenceEnvironmentImpl> env_impl =
+      shared.environment.lock();
+  if (!env_impl) {
+    // The binary cache is not part of the options of the shared environment,
+    // since its data is only valid during this call.
+    env_impl = std::make_shared<InferenceEnvironmentImpl>(
+        InferenceEnvironmentOptions());
+    absl::Status status = env_impl->Init();
+    if (properties) {
+      *properties = env_impl->properties();
+    }
+    RETURN_IF_ERROR(status);
+    shared.environment = env_impl;
+  } else if (properties) {
+    *properties = env_impl->properties();
+  }
+  if (!options.serialized_binary_cache.empty()) {
+    env_impl->AddSerializedBinaryCache(options.serialized_binary_cache);
+  }
+  *environment = std::move(env_impl);
+  return absl::OkStatus();
+}
+
 }  // namespace cl
 }  // namespace gpu
 }  // namespace tflite
@@ -141,6 +141,20 @@ absl::Status NewInferenceEnvironment(
     std::unique_ptr<InferenceEnvironment>* environment,
     InferenceEnvironmentProperties* properties /* optional */);
 
+// Returns the OpenCL environment shared by all callers in the process,
+// creating it on first use. It stays around while any caller holds it.
+// Inference builders created by several delegates from the shared environment
+// use the same OpenCL context, command queues and cache of compiled programs,
+// so that every kernel is compiled once, and GetSerializedBinaryCache returns
+// the kernels compiled for all of them.
+// options.serialized_binary_cache is added to the cache of the shared
+// environment. The other options must be left unset, since the environment is
+// created with the default device and context.
+absl::Status GetSharedInferenceEnvironment(
+    const InferenceEnvironmentOptions& options,
+    std::shared_ptr<InferenceEnvironment>* environment,
+    InferenceEnvironmentProperties* properties /* optional */);
+
 class CLInferenceRunner : public ::tflite::gpu::InferenceRunner {
  public:
   // The RunWithoutExternalBufferCopy provides a contract where the user of this
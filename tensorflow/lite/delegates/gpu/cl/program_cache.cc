@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/gpu/cl/program_cache.h"
 
 #include <cstdint>
+#include <mutex>  // NOLINT
 #include <string>
 #include <utility>
 
@@ -66,11 +67,14 @@ ProgramCache::ProgramDescriptor::ProgramDescriptor(
 ProgramCache::ProgramDescriptor::ProgramDescriptor(uint64_t fingerprints)
     : fingerprint(fingerprints) {}
 
-ProgramCache::ProgramCache(ProgramCache&& program_cache)
-    : programs_(std::move(program_cache.programs_)) {}
+ProgramCache::ProgramCache(ProgramCache&& program_cache) {
+  std::lock_guard<std::mutex> lock(program_cache.mutex_);
+  programs_ = std::move(program_cache.programs_);
+}
 
 ProgramCache& ProgramCache::operator=(ProgramCache&& program_cache) {
   if (this != &program_cache) {
+    std::scoped_lock lock(mutex_, program_cache.mutex_);
     programs_ = std::move(program_cache.programs_);
   }
   return *this;
@@ -87,6 +91,9 @@ absl::Status ProgramCache::GetOrCreateCLKernel(
   if (kernel_fingerprint) {
     *kernel_fingerprint = desc.fingerprint;
   }
+  // The lock is held while compiling, so that a program requested from several
+  // threads at once is only compiled once.
+  std::lock_guard<std::mutex> lock(mutex_);
   auto it = programs_.find(desc);
   if (it != programs_.end()) {
     return result->CreateFromProgram(it->second, function_name);
@@ -113,6 +120,7 @@ absl::Status ProgramCache::GetKernel(uint64_t fingerprint,
                                      const std::string& function_name,
                                      CLKernel* result) const {
   ProgramDescriptor desc(fingerprint);
+  std::lock_guard<std::mutex> lock(mutex_);
   auto it = programs_.find(desc);
   if (it == programs_.end()) {
     return absl::NotFoundError("No program with this fingerprint.");
@@ -125,6 +133,7 @@ absl::Status ProgramCache::AddProgramBinary(const CLContext& context,
                                             uint64_t fingerprint,
                                             absl::Span<const uint8_t> binary) {
   ProgramDescriptor desc(fingerprint);
+  std::lock_guard<std::mutex> lock(mutex_);
   auto it = programs_.find(desc);
   if (it == programs_.end()) {
     CLProgram program;
@@ -138,6 +147,7 @@ absl::Status ProgramCache::AddProgramBinary(const CLContext& context,
 absl::Status ProgramCache::GetProgramBinary(
     uint64_t fingerprint, std::vector<uint8_t>* program_binary) const {
   ProgramDescriptor desc(fingerprint);
+  std::lock_guard<std::mutex> lock(mutex_);
   auto it = programs_.find(desc);
   if (it == programs_.end()) {
     return absl::NotFoundError("No program with this fingerprint.");
@@ -176,6 +186,7 @@ absl::Status ProgramCache::GetSerializedCache(
     const CLDevice& device, std::vector<uint8_t>* serialized_cache) const {
   ::flatbuffers::FlatBufferBuilder builder;
   std::vector<flatbuffers::Offset<data::Program>> serialized_programs;
+  std::lock_guard<std::mutex> lock(mutex_);
   for (auto& program : programs_) {
     std::vector<uint8_t> binary;
     RETURN_IF_ERROR(program.second.GetBinary(&binary));
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_DELEGATES_GPU_CL_PROGRAM_CACHE_H_
 
 #include <cstdint>
+#include <mutex>  // NOLINT
 #include <string>
 #include <vector>
 
@@ -32,6 +33,9 @@ namespace tflite {
 namespace gpu {
 namespace cl {
 
+// Caches the compiled OpenCL programs by the fingerprint of their code and
+// compiler options. Thread-safe, so that an environment shared by several
+// delegates can compile kernels from several threads.
 class ProgramCache {
  public:
   ProgramCache() = default;
@@ -89,6 +93,7 @@ class ProgramCache {
     }
   };
 
+  mutable std::mutex mutex_;
   absl::flat_hash_map<ProgramDescriptor, CLProgram, ProgramDescriptorHasher,
                       ProgramDescriptorEqual>
       programs_;
@@ -49,6 +49,7 @@ using delegates::Serialization;
 using delegates::SerializationParams;
 
 constexpr char kSerializedDataPrefix[] = "gpuv2_data_";
+constexpr char kSharedBinaryCacheKey[] = "gpuv2_shared_binary_cache";
 
 InferencePriority ToPriority(int32_t priority) {
   switch (priority) {
@@ -105,6 +106,11 @@ class Delegate {
   Serialization* serialization() { return serialization_.get(); }
   const TfLiteGpuDelegateOptionsV2& options() const { return options_; }
 
+  bool IsClEnvironmentShared() const {
+    return options_.experimental_flags &
+           TFLITE_GPU_EXPERIMENTAL_FLAGS_SHARE_CL_ENVIRONMENT;
+  }
+
   bool IsQuantOpsAllowed() const {
     return options_.experimental_flags &
            TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT;
@@ -366,8 +372,7 @@ class DelegateKernel {
 
     if (!serialization) {
       // This path is faster when there is no serialization involved.
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
-                                                  &properties));
+      RETURN_IF_ERROR(NewOpenClEnvironment(env_options, &properties));
       *graph_is_destroyed = true;
       RETURN_IF_ERROR(cl_environment_->NewInferenceBuilder(
           options, std::move(*graph), builder));
@@ -380,8 +385,17 @@ class DelegateKernel {
         return absl::OkStatus();
       }
 
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(env_options, &cl_environment_,
-                                                  &properties));
+      // Kernels compiled for other models of the shared environment may be
+      // common to this one.
+      std::string binary_cache;
+      if (delegate_->IsClEnvironmentShared() &&
+          serialization->GetEntryForDelegate(kSharedBinaryCacheKey, context)
+                  .GetData(context, &binary_cache) == kTfLiteOk) {
+        env_options.serialized_binary_cache = absl::MakeConstSpan(
+            reinterpret_cast<const uint8_t*>(binary_cache.data()),
+            binary_cache.size());
+      }
+      RETURN_IF_ERROR(NewOpenClEnvironment(env_options, &properties));
       *graph_is_destroyed = true;
       std::vector<uint8_t> serialized_model;
       RETURN_IF_ERROR(cl_environment_->BuildSerializedModel(
@@ -391,6 +405,16 @@ class DelegateKernel {
 
       RETURN_IF_ERROR(SaveSerializedOpenCL(context, delegate_params, &options,
                                            serialization, serialized_model));
+      if (delegate_->IsClEnvironmentShared()) {
+        // Failing to save the shared kernels only slows down later
+        // initializations.
+        const std::vector<uint8_t> shared_cache =
+            cl_environment_->GetSerializedBinaryCache();
+        serialization->GetEntryForDelegate(kSharedBinaryCacheKey, context)
+            .SetData(context,
+                     reinterpret_cast<const char*>(shared_cache.data()),
+                     shared_cache.size());
+      }
     }
 
     TFLITE_LOG_PROD_ONCE(tflite::TFLITE_LOG_INFO,
@@ -398,6 +422,22 @@ class DelegateKernel {
     return absl::OkStatus();
   }
 
+  // Creates `cl_environment_`, or attaches to the environment shared by all the
+  // delegates of the process if the delegate options ask for it.
+  absl::Status NewOpenClEnvironment(
+      const cl::InferenceEnvironmentOptions& env_options,
+      cl::InferenceEnvironmentProperties* properties) {
+    if (delegate_->IsClEnvironmentShared()) {
+      return cl::GetSharedInferenceEnvironment(env_options, &cl_environment_,
+                                               properties);
+    }
+    std::unique_ptr<cl::InferenceEnvironment> environment;
+    RETURN_IF_ERROR(
+        cl::NewInferenceEnvironment(env_options, &environment, properties));
+    cl_environment_ = std::move(environment);
+    return absl::OkStatus();
+  }
+
   // Returns Ok only if serialized data is successsfully found.
   absl::Status MaybeInitializeSerializedOpenCL(
       TfLiteContext* context, const TfLiteDelegateParams* delegate_params,
@@ -419,8 +459,7 @@ class DelegateKernel {
       absl::Span<const uint8_t> model_span = absl::Span<const uint8_t>{
           reinterpret_cast<const uint8_t*>(model_data.data()),
           model_data.size()};
-      RETURN_IF_ERROR(cl::NewInferenceEnvironment(
-          *env_options, &cl_environment_, properties));
+      RETURN_IF_ERROR(NewOpenClEnvironment(*env_options, properties));
       RETURN_IF_ERROR(
           cl_environment_->NewInferenceBuilder(model_span, builder));
       TFLITE_LOG_PROD_ONCE(
@@ -481,7 +520,8 @@ class DelegateKernel {
 
   // The Delegate instance that's shared across all DelegateKernel instances.
   Delegate* const delegate_;  // doesn't own the memory.
-  std::unique_ptr<cl::InferenceEnvironment> cl_environment_;
+  // Shared with the other delegates if IsClEnvironmentShared().
+  std::shared_ptr<cl::InferenceEnvironment> cl_environment_;
 #ifndef CL_DELEGATE_NO_GL
   std::unique_ptr<gl::InferenceEnvironment> gl_environment_;
 #endif
@@ -66,6 +66,13 @@ enum TfLiteGpuExperimentalFlags {
   // TfLiteGpuDelegateOptionsV2.
   // Currently works only if CL backend is used.
   TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_SERIALIZATION = 1 << 3,
+  // Shares one OpenCL environment, with its context, command queues and cache
+  // of compiled kernels, across all the delegates in the process that set this
+  // flag, so that the kernels common to several models are compiled once.
+  // If serialization is also enabled, the kernels compiled for all of them are
+  // saved as well, and used when a model has no serialized data yet.
+  // Currently works only if CL backend is used.
+  TFLITE_GPU_EXPERIMENTAL_FLAGS_SHARE_CL_ENVIRONMENT = 1 << 4,
 };
 
 // IMPORTANT: Always use TfLiteGpuDelegateOptionsV2Default() method to create
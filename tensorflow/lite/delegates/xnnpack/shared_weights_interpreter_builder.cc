@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/xnnpack/shared_weights_interpreter_builder.h"
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/minimal_logging.h"
+
+namespace tflite {
+namespace xnnpack {
+
+SharedWeightsInterpreterBuilder::SharedWeightsInterpreterBuilder(
+    const FlatBufferModel& model, const OpResolver& op_resolver,
+    int num_threads)
+    : flatbuffer_model_(&model),
+      model_(model.GetModel()),
+      op_resolver_(op_resolver),
+      num_threads_(num_threads),
+      weights_cache_(TfLiteXNNPackDelegateWeightsCacheCreate(),
+                     TfLiteXNNPackDelegateWeightsCacheDelete) {}
+
+SharedWeightsInterpreterBuilder::SharedWeightsInterpreterBuilder(
+    const ::tflite::Model* model, const OpResolver& op_resolver,
+    int num_threads)
+    : flatbuffer_model_(nullptr),
+      model_(model),
+      op_resolver_(op_resolver),
+      num_threads_(num_threads),
+      weights_cache_(TfLiteXNNPackDelegateWeightsCacheCreate(),
+                     TfLiteXNNPackDelegateWeightsCacheDelete) {}
+
+TfLiteStatus SharedWeightsInterpreterBuilder::operator()(
+    std::unique_ptr<Interpreter>* interpreter) {
+  interpreter->reset();
+  if (weights_cache_ == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                    "Failed to create XNNPACK weights cache.");
+    return kTfLiteError;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<Interpreter> new_interpreter;
+  const TfLiteStatus status =
+      flatbuffer_model_ != nullptr
+          ? InterpreterBuilder(*flatbuffer_model_, op_resolver_)(
+                &new_interpreter, num_threads_)
+          : InterpreterBuilder(model_, op_resolver_)(&new_interpreter,
+                                                     num_threads_);
+  if (status != kTfLiteOk) return status;
+
+  TfLiteXNNPackDelegateOptions options = TfLiteXNNPackDelegateOptionsDefault();
+  // Note that we don't want to use the thread pool for num_threads == 1.
+  options.num_threads = num_threads_ > 1 ? num_threads_ : 0;
+  options.weights_cache = weights_cache_.get();
+  std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+      delegate(TfLiteXNNPackDelegateCreate(&options),
+               TfLiteXNNPackDelegateDelete);
+  if (delegate == nullptr) {
+    TFLITE_LOG_PROD(TFLITE_LOG_ERROR, "Failed to create XNNPACK delegate.");
+    return kTfLiteError;
+  }
+  // The delegate packs the weights, or looks them up in the weights cache once
+  // it is finalized, while the graph is modified.
+  if (new_interpreter->ModifyGraphWithDelegate(std::move(delegate)) !=
+      kTfLiteOk) {
+    return kTfLiteError;
+  }
+  if (!weights_cache_finalized_) {
+    if (!TfLiteXNNPackDelegateWeightsCacheFinalizeSoft(weights_cache_.get())) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "Failed to finalize XNNPACK weights cache.");
+      return kTfLiteError;
+    }
+    weights_cache_finalized_ = true;
+  }
+  *interpreter = std::move(new_interpreter);
+  return kTfLiteOk;
+}
+
+}  // namespace xnnpack
+}  // namespace tflite
@@ -0,0 +1,90 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_DELEGATES_XNNPACK_SHARED_WEIGHTS_INTERPRETER_BUILDER_H_
+#define TENSORFLOW_LITE_DELEGATES_XNNPACK_SHARED_WEIGHTS_INTERPRETER_BUILDER_H_
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/op_resolver.h"
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+namespace xnnpack {
+
+// Builds interpreters for the same model that run concurrently, for example
+// one per thread of a server, while sharing as much memory as possible.
+//
+// All the interpreters share the read-only tensors of the model, which point
+// into the model buffer, and the weights packed by the XNNPACK delegate,
+// which are stored once in a weights cache owned by this builder. Each
+// interpreter only holds its own activation arena, its own variable tensors
+// and its own delegate runtime.
+//
+// The first interpreter packs the weights into the cache, which is then
+// soft-finalized, so that later interpreters reuse the packed weights instead
+// of packing them again.
+//
+// The model, the op resolver and this builder must outlive the interpreters
+// it builds. Building interpreters is thread-safe.
+//
+// WARNING: This is an experimental API and subject to change.
+class SharedWeightsInterpreterBuilder {
+ public:
+  // `num_threads` is the number of threads used by each interpreter and its
+  // XNNPACK delegate.
+  SharedWeightsInterpreterBuilder(const FlatBufferModel& model,
+                                  const OpResolver& op_resolver,
+                                  int num_threads = 1);
+  // Builds interpreters given only the raw flatbuffer Model object. Mostly
+  // used for testing.
+  SharedWeightsInterpreterBuilder(const ::tflite::Model* model,
+                                  const OpResolver& op_resolver,
+                                  int num_threads = 1);
+
+  SharedWeightsInterpreterBuilder(const SharedWeightsInterpreterBuilder&) =
+      delete;
+  SharedWeightsInterpreterBuilder& operator=(
+      const SharedWeightsInterpreterBuilder&) = delete;
+
+  // Builds an interpreter with an XNNPACK delegate that uses the shared
+  // weights cache. The interpreter is ready for `AllocateTensors()`. On
+  // failure, `interpreter` is reset to nullptr.
+  TfLiteStatus operator()(std::unique_ptr<Interpreter>* interpreter);
+
+ private:
+  const FlatBufferModel* const flatbuffer_model_;
+  const ::tflite::Model* const model_;
+  const OpResolver& op_resolver_;
+  const int num_threads_;
+
+  std::unique_ptr<TfLiteXNNPackDelegateWeightsCache,
+                  decltype(&TfLiteXNNPackDelegateWeightsCacheDelete)>
+      weights_cache_;
+
+  // Serializes building, since the weights cache must be finalized after the
+  // first interpreter packed the weights and before any other one uses it.
+  std::mutex mutex_;
+  bool weights_cache_finalized_ = false;
+};
+
+}  // namespace xnnpack
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_DELEGATES_XNNPACK_SHARED_WEIGHTS_INTERPRETER_BUILDER_H_
@@ -0,0 +1,98 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/delegates/xnnpack/shared_weights_interpreter_builder.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/delegates/xnnpack/conv_2d_tester.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+
+namespace tflite {
+namespace xnnpack {
+namespace {
+
+// Runs `interpreter` on an input filled with `value` and returns its output.
+std::vector<float> Run(Interpreter* interpreter, float value) {
+  const TfLiteTensor* input = interpreter->input_tensor(0);
+  float* input_data = interpreter->typed_input_tensor<float>(0);
+  std::fill(input_data, input_data + NumElements(input), value);
+  EXPECT_EQ(kTfLiteOk, interpreter->Invoke());
+  const TfLiteTensor* output = interpreter->output_tensor(0);
+  const float* output_data = interpreter->typed_output_tensor<float>(0);
+  return std::vector<float>(output_data, output_data + NumElements(output));
+}
+
+TEST(SharedWeightsInterpreterBuilder, InterpretersShareWeights) {
+  std::vector<char> buffer = Conv2DTester().CreateTfLiteModel();
+  const Model* model = GetModel(buffer.data());
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  SharedWeightsInterpreterBuilder builder(model, resolver);
+
+  std::unique_ptr<Interpreter> interpreter1;
+  ASSERT_EQ(kTfLiteOk, builder(&interpreter1));
+  ASSERT_EQ(kTfLiteOk, interpreter1->AllocateTensors());
+  std::unique_ptr<Interpreter> interpreter2;
+  ASSERT_EQ(kTfLiteOk, builder(&interpreter2));
+  ASSERT_EQ(kTfLiteOk, interpreter2->AllocateTensors());
+
+  // The graph is delegated to XNNPACK in both interpreters.
+  EXPECT_EQ(1, interpreter1->execution_plan().size());
+  EXPECT_EQ(1, interpreter2->execution_plan().size());
+  // Each interpreter has its own activations.
+  EXPECT_NE(interpreter1->typed_input_tensor<float>(0),
+            interpreter2->typed_input_tensor<float>(0));
+
+  const std::vector<float> output1 = Run(interpreter1.get(), 1.0f);
+  const std::vector<float> output2 = Run(interpreter2.get(), 1.0f);
+  EXPECT_EQ(output1, output2);
+}
+
+TEST(SharedWeightsInterpreterBuilder, ConcurrentInterpreters) {
+  std::vector<char> buffer = Conv2DTester().CreateTfLiteModel();
+  const Model* model = GetModel(buffer.data());
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+  SharedWeightsInterpreterBuilder builder(model, resolver);
+
+  std::unique_ptr<Interpreter> reference;
+  ASSERT_EQ(kTfLiteOk, builder(&reference));
+  ASSERT_EQ(kTfLiteOk, reference->AllocateTensors());
+  const std::vector<float> expected = Run(reference.get(), 0.5f);
+
+  constexpr int kNumThreads = 4;
+  std::vector<std::thread> threads;
+  threads.reserve(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      std::unique_ptr<Interpreter> interpreter;
+      ASSERT_EQ(kTfLiteOk, builder(&interpreter));
+      ASSERT_EQ(kTfLiteOk, interpreter->AllocateTensors());
+      EXPECT_EQ(expected, Run(interpreter.get(), 0.5f));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+}  // namespace xnnpack
+}  // namespace tflite
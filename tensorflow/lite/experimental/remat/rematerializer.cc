@@ -0,0 +1,225 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/remat/rematerializer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+namespace {
+
+size_t GetExcess(size_t bytes, size_t memory_budget) {
+  return bytes > memory_budget ? bytes - memory_budget : 0;
+}
+
+}  // namespace
+
+Rematerializer::Rematerializer(std::vector<Operation> operations,
+                               std::vector<size_t> tensor_sizes,
+                               const std::vector<int>& pinned_tensors)
+    : operations_(std::move(operations)),
+      tensor_sizes_(std::move(tensor_sizes)),
+      is_pinned_(tensor_sizes_.size(), false) {
+  for (int tensor : pinned_tensors) {
+    if (tensor < 0 || tensor >= tensor_sizes_.size() || is_pinned_[tensor]) {
+      continue;
+    }
+    is_pinned_[tensor] = true;
+    pinned_bytes_ += tensor_sizes_[tensor];
+  }
+}
+
+std::vector<Rematerializer::TensorInfo> Rematerializer::ComputeTensorInfos()
+    const {
+  std::vector<TensorInfo> infos(tensor_sizes_.size());
+  for (int i = 0; i < operations_.size(); ++i) {
+    for (int tensor : operations_[i].outputs) {
+      if (tensor >= 0 && infos[tensor].producer < 0) {
+        infos[tensor].producer = i;
+      }
+    }
+    for (int tensor : operations_[i].inputs) {
+      if (tensor >= 0) infos[tensor].uses.push_back(i);
+    }
+  }
+  for (TensorInfo& info : infos) {
+    auto& uses = info.uses;
+    uses.erase(std::unique(uses.begin(), uses.end()), uses.end());
+    info.first = std::max(info.producer, 0);
+    if (!uses.empty()) {
+      info.last = std::max(info.first, uses.back());
+    } else if (info.producer >= 0) {
+      info.last = info.producer;
+    }
+  }
+  return infos;
+}
+
+std::vector<size_t> Rematerializer::GetMemoryProfile() const {
+  const int num_operations = operations_.size();
+  // Differences between consecutive steps.
+  std::vector<size_t> added(num_operations + 1, 0);
+  std::vector<size_t> removed(num_operations + 1, 0);
+  const std::vector<TensorInfo> infos = ComputeTensorInfos();
+  for (int tensor = 0; tensor < infos.size(); ++tensor) {
+    const TensorInfo& info = infos[tensor];
+    if (is_pinned_[tensor] || info.last < info.first) continue;
+    added[info.first] += tensor_sizes_[tensor];
+    removed[info.last + 1] += tensor_sizes_[tensor];
+  }
+  std::vector<size_t> profile(num_operations);
+  size_t live_bytes = pinned_bytes_;
+  for (int i = 0; i < num_operations; ++i) {
+    live_bytes += added[i];
+    live_bytes -= removed[i];
+    profile[i] = live_bytes + operations_[i].scratch_bytes;
+  }
+  return profile;
+}
+
+size_t Rematerializer::GetPeakMemory() const {
+  const std::vector<size_t> profile = GetMemoryProfile();
+  return profile.empty() ? pinned_bytes_
+                         : *std::max_element(profile.begin(), profile.end());
+}
+
+std::vector<Rematerializer::Remat> Rematerializer::Run(size_t memory_budget,
+                                                       int max_remats) {
+  std::vector<Remat> remats;
+  while (static_cast<int>(remats.size()) < max_remats) {
+    const std::vector<size_t> profile = GetMemoryProfile();
+    const int num_operations = profile.size();
+    // Excess and peak of the steps from each index on, which rematerializing
+    // a tensor before that index does not change.
+    std::vector<size_t> suffix_excess(num_operations + 1, 0);
+    std::vector<size_t> suffix_peak(num_operations + 1, 0);
+    for (int i = num_operations - 1; i >= 0; --i) {
+      suffix_excess[i] =
+          suffix_excess[i + 1] + GetExcess(profile[i], memory_budget);
+      suffix_peak[i] = std::max(suffix_peak[i + 1], profile[i]);
+    }
+    if (suffix_excess[0] == 0) break;
+
+    const std::vector<TensorInfo> infos = ComputeTensorInfos();
+    // `crossing[i]` is the number of bytes live at both steps i - 1 and i,
+    // which are live during a copy inserted before step i.
+    std::vector<size_t> crossing(num_operations + 1, pinned_bytes_);
+    {
+      std::vector<size_t> added(num_operations + 1, 0);
+      std::vector<size_t> removed(num_operations + 1, 0);
+      for (int tensor = 0; tensor < infos.size(); ++tensor) {
+        const TensorInfo& info = infos[tensor];
+        if (is_pinned_[tensor] || info.last <= info.first) continue;
+        added[info.first + 1] += tensor_sizes_[tensor];
+        removed[info.last + 1] += tensor_sizes_[tensor];
+      }
+      size_t live_bytes = 0;
+      for (int i = 0; i <= num_operations; ++i) {
+        live_bytes += added[i];
+        live_bytes -= removed[i];
+        crossing[i] += live_bytes;
+      }
+    }
+
+    // Greedily picks the rematerialization with the lowest excess, then the
+    // lowest peak.
+    std::tuple<size_t, size_t> best_cost(suffix_excess[0], suffix_peak[0]);
+    Remat best_remat = {-1, -1, -1, -1};
+    std::vector<size_t> window;
+    for (int op = 0; op < num_operations; ++op) {
+      const Operation& operation = operations_[op];
+      if (!operation.is_rematerializable || operation.outputs.size() != 1) {
+        continue;
+      }
+      const int tensor = operation.outputs[0];
+      if (tensor < 0 || is_pinned_[tensor] || tensor_sizes_[tensor] == 0) {
+        continue;
+      }
+      const size_t tensor_size = tensor_sizes_[tensor];
+      std::vector<int> inputs;
+      for (int input : operation.inputs) {
+        if (input >= 0 && !is_pinned_[input] && tensor_sizes_[input] > 0 &&
+            std::find(inputs.begin(), inputs.end(), input) == inputs.end()) {
+          inputs.push_back(input);
+        }
+      }
+      const std::vector<int>& uses = infos[tensor].uses;
+      for (int j = 0; j + 1 < uses.size(); ++j) {
+        const int previous_use = uses[j];
+        const int insert_before = uses[j + 1];
+        if (insert_before - previous_use < 2) continue;
+
+        // Steps in [begin, insert_before) change: the tensor is released
+        // after its previous use, and the inputs of the copy live longer.
+        int begin = previous_use + 1;
+        size_t copy_bytes = crossing[insert_before] + operation.scratch_bytes;
+        for (int input : inputs) {
+          if (infos[input].last < insert_before) {
+            begin = std::min(begin, infos[input].last + 1);
+            copy_bytes += tensor_sizes_[input];
+          }
+        }
+        window.assign(profile.begin() + begin,
+                      profile.begin() + insert_before);
+        for (int i = previous_use + 1; i < insert_before; ++i) {
+          window[i - begin] -= tensor_size;
+        }
+        for (int input : inputs) {
+          for (int i = infos[input].last + 1; i < insert_before; ++i) {
+            window[i - begin] += tensor_sizes_[input];
+          }
+        }
+
+        size_t excess = suffix_excess[0] - suffix_excess[begin] +
+                        suffix_excess[insert_before] +
+                        GetExcess(copy_bytes, memory_budget);
+        size_t peak = std::max(suffix_peak[insert_before], copy_bytes);
+        for (int i = 0; i < begin; ++i) peak = std::max(peak, profile[i]);
+        for (size_t bytes : window) {
+          excess += GetExcess(bytes, memory_budget);
+          peak = std::max(peak, bytes);
+        }
+        const std::tuple<size_t, size_t> cost(excess, peak);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_remat = {op, insert_before, tensor,
+                        static_cast<int>(tensor_sizes_.size())};
+        }
+      }
+    }
+    if (best_remat.operation < 0) break;
+    Apply(best_remat);
+    remats.push_back(best_remat);
+  }
+  return remats;
+}
+
+void Rematerializer::Apply(const Remat& remat) {
+  Operation copy = operations_[remat.operation];
+  copy.outputs = {remat.new_tensor};
+  tensor_sizes_.push_back(tensor_sizes_[remat.tensor]);
+  is_pinned_.push_back(false);
+  for (int i = remat.insert_before; i < operations_.size(); ++i) {
+    std::replace(operations_[i].inputs.begin(), operations_[i].inputs.end(),
+                 remat.tensor, remat.new_tensor);
+  }
+  operations_.insert(operations_.begin() + remat.insert_before,
+                     std::move(copy));
+}
+
+}  // namespace tflite
@@ -0,0 +1,111 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+/// \file
+/// Planning of the rematerialization of intermediate tensors, which trades
+/// recomputation for a lower peak memory usage.
+///
+
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_REMAT_REMATERIALIZER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_REMAT_REMATERIALIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tflite {
+
+/// Plans the rematerialization of tensors of a sequence of operations: an
+/// operation whose output is used much later is executed a second time right
+/// before the late use, so that the first copy of the output is released
+/// early and the memory of long-lived tensors is reused in between.
+///
+/// Memory is estimated as the total size of the live tensors at each step,
+/// where a tensor is live from the operation that produces it to its last
+/// use. This is a lower bound of the arena size of the `ArenaPlanner`, which
+/// uses the same lifetimes.
+class Rematerializer {
+ public:
+  /// An operation, in execution order.
+  struct Operation {
+    /// Tensor ids. Negative ids are ignored.
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+    /// Bytes of temporary tensors used during the execution of the operation.
+    size_t scratch_bytes = 0;
+    /// True if the operation is cheap to recompute and free of side effects.
+    /// Only operations with a single output are rematerialized.
+    bool is_rematerializable = false;
+  };
+
+  /// Rematerialization of `tensor`, the output of the operation at index
+  /// `operation`: a copy of the operation that writes `new_tensor` is run
+  /// before the operation at index `insert_before`, and the operations from
+  /// `insert_before` on read `new_tensor` instead of `tensor`. Indices refer to
+  /// the sequence of operations before this rematerialization is applied, and
+  /// new tensor ids follow the existing ones.
+  struct Remat {
+    int operation;
+    int insert_before;
+    int tensor;
+    int new_tensor;
+  };
+
+  /// `tensor_sizes` holds the size of each tensor in bytes, zero for tensors
+  /// that don't use planned memory. `pinned_tensors` are live during the whole
+  /// sequence and never rematerialized, such as the inputs and outputs.
+  Rematerializer(std::vector<Operation> operations,
+                 std::vector<size_t> tensor_sizes,
+                 const std::vector<int>& pinned_tensors);
+
+  /// Greedily applies the rematerialization that most reduces the memory
+  /// above `memory_budget`, until the peak memory is within the budget, no
+  /// rematerialization helps, or `max_remats` were applied. Returns them in
+  /// order of application.
+  std::vector<Remat> Run(size_t memory_budget, int max_remats);
+
+  /// Returns the live bytes at each step of the current sequence.
+  std::vector<size_t> GetMemoryProfile() const;
+
+  /// Returns the maximum of `GetMemoryProfile()`.
+  size_t GetPeakMemory() const;
+
+  /// Returns the current sequence of operations, including copies.
+  const std::vector<Operation>& operations() const { return operations_; }
+
+ private:
+  // Lifetime of a tensor in the current sequence.
+  struct TensorInfo {
+    int producer = -1;
+    // Sorted unique indices of the operations using the tensor.
+    std::vector<int> uses;
+    int first = 0;
+    int last = -1;
+  };
+
+  std::vector<TensorInfo> ComputeTensorInfos() const;
+
+  // Applies `remat` to `operations_` and `tensor_sizes_`.
+  void Apply(const Remat& remat);
+
+  std::vector<Operation> operations_;
+  std::vector<size_t> tensor_sizes_;
+  std::vector<bool> is_pinned_;
+  // Total size of the pinned tensors.
+  size_t pinned_bytes_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_REMAT_REMATERIALIZER_H_
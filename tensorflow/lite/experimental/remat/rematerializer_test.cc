@@ -0,0 +1,113 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/remat/rematerializer.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace {
+
+using ::testing::ElementsAre;
+using Operation = Rematerializer::Operation;
+
+Operation Op(std::vector<int> inputs, std::vector<int> outputs,
+             bool is_rematerializable = false) {
+  Operation operation;
+  operation.inputs = std::move(inputs);
+  operation.outputs = std::move(outputs);
+  operation.is_rematerializable = is_rematerializable;
+  return operation;
+}
+
+// Tensor 0 is a constant, which op 0 converts into tensor 1 of 100 bytes.
+// Tensor 1 is used right away by op 1 and again by op 4, while ops 2 and 3
+// use large tensors.
+std::vector<Operation> LongLivedTensorGraph(bool is_rematerializable) {
+  return {
+      Op({0}, {1}, is_rematerializable),
+      Op({1, 6}, {2}),
+      Op({2}, {3}),
+      Op({3}, {4}),
+      Op({4, 1}, {5}),
+  };
+}
+
+const std::vector<size_t> kTensorSizes = {0, 100, 400, 400, 50, 100, 10};
+
+TEST(RematerializerTest, MemoryProfile) {
+  Rematerializer remat(LongLivedTensorGraph(true), kTensorSizes,
+                       /*pinned_tensors=*/{6});
+  EXPECT_THAT(remat.GetMemoryProfile(),
+              ElementsAre(110, 510, 910, 560, 260));
+  EXPECT_EQ(remat.GetPeakMemory(), 910);
+}
+
+TEST(RematerializerTest, RematerializesLongLivedTensor) {
+  Rematerializer remat(LongLivedTensorGraph(true), kTensorSizes,
+                       /*pinned_tensors=*/{6});
+  const auto remats = remat.Run(/*memory_budget=*/850, /*max_remats=*/10);
+  ASSERT_EQ(remats.size(), 1);
+  EXPECT_EQ(remats[0].operation, 0);
+  EXPECT_EQ(remats[0].insert_before, 4);
+  EXPECT_EQ(remats[0].tensor, 1);
+  EXPECT_EQ(remats[0].new_tensor, 7);
+  EXPECT_THAT(remat.GetMemoryProfile(),
+              ElementsAre(110, 510, 810, 460, 160, 260));
+  EXPECT_EQ(remat.GetPeakMemory(), 810);
+
+  const auto& operations = remat.operations();
+  ASSERT_EQ(operations.size(), 6);
+  EXPECT_THAT(operations[4].inputs, ElementsAre(0));
+  EXPECT_THAT(operations[4].outputs, ElementsAre(7));
+  EXPECT_THAT(operations[5].inputs, ElementsAre(4, 7));
+  EXPECT_THAT(operations[1].inputs, ElementsAre(1, 6));
+}
+
+TEST(RematerializerTest, NothingToDoWithinBudget) {
+  Rematerializer remat(LongLivedTensorGraph(true), kTensorSizes,
+                       /*pinned_tensors=*/{6});
+  EXPECT_TRUE(remat.Run(/*memory_budget=*/910, /*max_remats=*/10).empty());
+  EXPECT_EQ(remat.operations().size(), 5);
+}
+
+TEST(RematerializerTest, OnlyRematerializesAllowedOperations) {
+  Rematerializer remat(LongLivedTensorGraph(false), kTensorSizes,
+                       /*pinned_tensors=*/{6});
+  EXPECT_TRUE(remat.Run(/*memory_budget=*/850, /*max_remats=*/10).empty());
+  EXPECT_EQ(remat.GetPeakMemory(), 910);
+}
+
+TEST(RematerializerTest, AccountsForInputsOfTheCopy) {
+  // Same graph, but tensor 0 needs planned memory, and recomputing tensor 1
+  // would keep it alive instead.
+  std::vector<size_t> tensor_sizes = kTensorSizes;
+  tensor_sizes[0] = 100;
+  Rematerializer remat(LongLivedTensorGraph(true), tensor_sizes,
+                       /*pinned_tensors=*/{6});
+  EXPECT_TRUE(remat.Run(/*memory_budget=*/850, /*max_remats=*/10).empty());
+}
+
+TEST(RematerializerTest, StopsAtMaxRemats) {
+  Rematerializer remat(LongLivedTensorGraph(true), kTensorSizes,
+                       /*pinned_tensors=*/{6});
+  EXPECT_TRUE(remat.Run(/*memory_budget=*/850, /*max_remats=*/0).empty());
+}
+
+}  // namespace
+}  // namespace tflite
@@ -37,6 +37,12 @@ class LookupInterface : public ResourceBase {
                               const TfLiteTensor* default_value) = 0;
   virtual TfLiteStatus Import(TfLiteContext* context, const TfLiteTensor* keys,
                               const TfLiteTensor* values) = 0;
+  // Same as `Import`, with the table layout given by a prebuilt int32 index
+  // tensor, see `BuildHashtableIndex`.
+  virtual TfLiteStatus ImportWithIndex(TfLiteContext* context,
+                                       const TfLiteTensor* keys,
+                                       const TfLiteTensor* values,
+                                       const TfLiteTensor* index) = 0;
   virtual size_t Size() = 0;
 
   virtual TfLiteType GetKeyType() const = 0;
@@ -15,14 +15,139 @@ limitations under the License.
 
 #include "tensorflow/lite/experimental/resource/static_hashtable.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
 
 namespace tflite {
 namespace resource {
 namespace internal {
+namespace {
+
+// Number of keys hashed ahead of probing in `StaticHashtable::Lookup`, so
+// that the memory accesses of the first probes overlap.
+constexpr int kLookupBatchSize = 16;
+
+// Reads the keys of a tensor without copying string keys.
+template <typename KeyType>
+class KeyReader;
+
+template <>
+class KeyReader<std::int64_t> {
+ public:
+  explicit KeyReader(const TfLiteTensor* input)
+      : input_data_(GetTensorData<std::int64_t>(input)) {}
+
+  std::int64_t GetKey(int index) const { return input_data_[index]; }
+
+ private:
+  const std::int64_t* input_data_;
+};
+
+template <>
+class KeyReader<std::string> {
+ public:
+  explicit KeyReader(const TfLiteTensor* input) : input_(input) {}
+
+  StringRef GetKey(int index) const { return GetString(input_, index); }
+
+ private:
+  const TfLiteTensor* input_;
+};
+
+// The hash functions must not change, since indices built by
+// `BuildHashtableIndex` may be stored in models.
+inline uint64_t Mix(uint64_t h) {
+  // Finalizer of SplitMix64.
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+inline uint64_t HashKey(std::int64_t key) {
+  return Mix(static_cast<uint64_t>(key));
+}
+
+inline uint64_t HashKey(const StringRef& key) {
+  // 64-bit FNV-1a.
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < key.len; ++i) {
+    h ^= static_cast<unsigned char>(key.str[i]);
+    h *= 0x100000001b3ULL;
+  }
+  return Mix(h);
+}
+
+inline bool KeyEquals(std::int64_t a, std::int64_t b) { return a == b; }
+
+inline bool KeyEquals(const StringRef& a, const StringRef& b) {
+  return a.len == b.len && std::memcmp(a.str, b.str, a.len) == 0;
+}
+
+inline bool KeyEquals(const std::string& a, const StringRef& b) {
+  return a.size() == b.len && std::memcmp(a.data(), b.str, b.len) == 0;
+}
+
+inline void PrefetchSlot(const int32_t* slot) {
+#ifdef __GNUC__
+  __builtin_prefetch(slot, /* 0 means read */ 0, /* 3 means high locality */ 3);
+#else
+  (void)slot;
+#endif
+}
+
+// Returns the number of slots for `size` keys, keeping the load factor at or
+// below 1/2 and at least one slot empty so that probing terminates.
+size_t GetIndexCapacity(size_t size) {
+  size_t capacity = 1;
+  while (capacity < 2 * size) capacity <<= 1;
+  return capacity;
+}
+
+template <typename KeyType>
+void BuildIndex(const TfLiteTensor* keys, std::vector<int32_t>* index,
+                size_t* size) {
+  const int num_keys = GetTensorShape(keys).FlatSize();
+  KeyReader<KeyType> key_reader(keys);
+  index->assign(GetIndexCapacity(num_keys), -1);
+  const size_t mask = index->size() - 1;
+  *size = 0;
+  for (int i = 0; i < num_keys; ++i) {
+    const auto key = key_reader.GetKey(i);
+    size_t slot = HashKey(key) & mask;
+    while ((*index)[slot] >= 0 &&
+           !KeyEquals(key_reader.GetKey((*index)[slot]), key)) {
+      slot = (slot + 1) & mask;
+    }
+    if ((*index)[slot] < 0) {
+      (*index)[slot] = i;
+      ++*size;
+    }
+  }
+}
+
+}  // namespace
+
+TfLiteStatus BuildHashtableIndex(const TfLiteTensor* keys,
+                                 std::vector<int32_t>* index) {
+  size_t size;
+  if (keys->type == kTfLiteInt64) {
+    BuildIndex<std::int64_t>(keys, index, &size);
+  } else if (keys->type == kTfLiteString) {
+    BuildIndex<std::string>(keys, index, &size);
+  } else {
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
 
 template <typename KeyType, typename ValueType>
 TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
@@ -36,17 +161,33 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
+  auto key_tensor_reader = KeyReader<KeyType>(keys);
   auto value_tensor_writer = TensorWriter<ValueType>(values);
   auto default_value_tensor_reader = TensorReader<ValueType>(default_value);
   ValueType first_default_value = default_value_tensor_reader.GetData(0);
 
-  for (int i = 0; i < size; ++i) {
-    auto result = map_.find(key_tensor_reader.GetData(i));
-    if (result != map_.end()) {
-      value_tensor_writer.SetData(i, result->second);
-    } else {
-      value_tensor_writer.SetData(i, first_default_value);
+  const size_t mask = index_.size() - 1;
+  size_t slots[kLookupBatchSize];
+  for (int begin = 0; begin < size; begin += kLookupBatchSize) {
+    const int end = std::min(begin + kLookupBatchSize, size);
+    // Hashes the whole batch first so that the loads of the first slots are in
+    // flight together, then probes.
+    for (int i = begin; i < end; ++i) {
+      slots[i - begin] = HashKey(key_tensor_reader.GetKey(i)) & mask;
+      PrefetchSlot(&index_[slots[i - begin]]);
+    }
+    for (int i = begin; i < end; ++i) {
+      const auto key = key_tensor_reader.GetKey(i);
+      size_t slot = slots[i - begin];
+      int32_t entry;
+      while ((entry = index_[slot]) >= 0 && !KeyEquals(keys_[entry], key)) {
+        slot = (slot + 1) & mask;
+      }
+      if (entry >= 0) {
+        value_tensor_writer.SetData(i, values_[entry]);
+      } else {
+        value_tensor_writer.SetData(i, first_default_value);
+      }
     }
   }
 
@@ -58,6 +199,19 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Lookup(
   return kTfLiteOk;
 }
 
+template <typename KeyType, typename ValueType>
+void StaticHashtable<KeyType, ValueType>::CopyEntries(
+    const TfLiteTensor* keys, const TfLiteTensor* values, int size) {
+  auto key_tensor_reader = TensorReader<KeyType>(keys);
+  auto value_tensor_reader = TensorReader<ValueType>(values);
+  keys_.reserve(size);
+  values_.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    keys_.push_back(key_tensor_reader.GetData(i));
+    values_.push_back(value_tensor_reader.GetData(i));
+  }
+}
+
 template <typename KeyType, typename ValueType>
 TfLiteStatus StaticHashtable<KeyType, ValueType>::Import(
     TfLiteContext* context, const TfLiteTensor* keys,
@@ -72,12 +226,46 @@ TfLiteStatus StaticHashtable<KeyType, ValueType>::Import(
   const int size =
       MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
 
-  auto key_tensor_reader = TensorReader<KeyType>(keys);
-  auto value_tensor_writer = TensorReader<ValueType>(values);
-  for (int i = 0; i < size; ++i) {
-    map_.insert({key_tensor_reader.GetData(i), value_tensor_writer.GetData(i)});
+  BuildIndex<KeyType>(keys, &index_, &size_);
+  CopyEntries(keys, values, size);
+
+  is_initialized_ = true;
+  return kTfLiteOk;
+}
+
+template <typename KeyType, typename ValueType>
+TfLiteStatus StaticHashtable<KeyType, ValueType>::ImportWithIndex(
+    TfLiteContext* context, const TfLiteTensor* keys,
+    const TfLiteTensor* values, const TfLiteTensor* index) {
+  if (is_initialized_) {
+    return kTfLiteOk;
   }
 
+  const int size =
+      MatchingFlatSize(GetTensorShape(keys), GetTensorShape(values));
+
+  // Only checks that probing stays in bounds and terminates: the index is
+  // trusted to match the hash functions, and a mismatching index makes lookups
+  // miss but does not access memory outside of the table.
+  TF_LITE_ENSURE_TYPES_EQ(context, index->type, kTfLiteInt32);
+  const int capacity = GetTensorShape(index).FlatSize();
+  TF_LITE_ENSURE(context, capacity > 0 && (capacity & (capacity - 1)) == 0);
+  const int32_t* index_data = GetTensorData<int32_t>(index);
+  std::vector<bool> is_indexed(size, false);
+  size_t num_entries = 0;
+  for (int slot = 0; slot < capacity; ++slot) {
+    const int32_t entry = index_data[slot];
+    if (entry < 0) continue;
+    TF_LITE_ENSURE(context, entry < size && !is_indexed[entry]);
+    is_indexed[entry] = true;
+    ++num_entries;
+  }
+  TF_LITE_ENSURE(context, num_entries < static_cast<size_t>(capacity));
+
+  index_.assign(index_data, index_data + capacity);
+  size_ = num_entries;
+  CopyEntries(keys, values, size);
+
   is_initialized_ = true;
   return kTfLiteOk;
 }
@@ -15,7 +15,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 #define TENSORFLOW_LITE_EXPERIMENTAL_RESOURCE_STATIC_HASHTABLE_H_
 
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
@@ -28,8 +29,24 @@ namespace tflite {
 namespace resource {
 namespace internal {
 
+// Builds the slot index of the open-addressing table used by StaticHashtable
+// for the given 1-D keys tensor of type int64 or string. `index` has a power of
+// two size with at least one empty slot, and each slot holds either the
+// position of a key in `keys` or -1. When a key is repeated, only its first
+// occurrence is indexed.
+//
+// The hash functions are fixed, so the index can be computed offline and
+// stored in the model as the optional index input of HASHTABLE_IMPORT.
+TfLiteStatus BuildHashtableIndex(const TfLiteTensor* keys,
+                                 std::vector<int32_t>* index);
+
 // A static hash table class. This hash table allows initialization one time in
 // its life cycle. This hash table implements Tensorflow core's HashTableV2 op.
+//
+// Keys and values are stored in flat arrays in import order, and looked up
+// through an open-addressing index with linear probing, which keeps lookups in
+// a few contiguous cache lines instead of chasing the nodes of a chained hash
+// map.
 template <typename KeyType, typename ValueType>
 class StaticHashtable : public tflite::resource::LookupInterface {
  public:
@@ -48,8 +65,14 @@ class StaticHashtable : public tflite::resource::LookupInterface {
   TfLiteStatus Import(TfLiteContext* context, const TfLiteTensor* keys,
                       const TfLiteTensor* values) override;
 
+  // Inserts the given key and value tensor data into the hash table, using
+  // the slot index built by `BuildHashtableIndex` instead of hashing the keys.
+  TfLiteStatus ImportWithIndex(TfLiteContext* context, const TfLiteTensor* keys,
+                               const TfLiteTensor* values,
+                               const TfLiteTensor* index) override;
+
   // Returns the item size of the hash table.
-  size_t Size() override { return map_.size(); }
+  size_t Size() override { return size_; }
 
   TfLiteType GetKeyType() const override { return key_type_; }
   TfLiteType GetValueType() const override { return value_type_; }
@@ -65,13 +88,26 @@ class StaticHashtable : public tflite::resource::LookupInterface {
   // Returns true if the hash table is initialized.
   bool IsInitialized() override { return is_initialized_; }
 
-  size_t GetMemoryUsage() override { return map_.size() * sizeof(ValueType); }
+  size_t GetMemoryUsage() override {
+    return keys_.size() * sizeof(KeyType) +
+           values_.size() * sizeof(ValueType) +
+           index_.size() * sizeof(int32_t);
+  }
 
  private:
+  // Copies the key and value tensor data into `keys_` and `values_`.
+  void CopyEntries(const TfLiteTensor* keys, const TfLiteTensor* values,
+                   int size);
+
   TfLiteType key_type_;
   TfLiteType value_type_;
 
-  std::unordered_map<KeyType, ValueType> map_;
+  std::vector<KeyType> keys_;
+  std::vector<ValueType> values_;
+  // Open-addressing slots holding positions in `keys_` and `values_`, or -1
+  // for empty slots. The size is a power of two.
+  std::vector<int32_t> index_;
+  size_t size_ = 0;
   bool is_initialized_ = false;
 };
 
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/lite/graph_info.h"
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/c/common.h"
@@ -274,4 +275,73 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
                                                   control_edges, node_subsets);
 }
 
+void GroupIndependentNodes(const GraphInfo* info,
+                           const std::vector<bool>& is_barrier,
+                           std::vector<int>* execution_plan,
+                           std::vector<int>* group_end) {
+  const int num_nodes = info->num_execution_nodes();
+  execution_plan->clear();
+  execution_plan->reserve(num_nodes);
+  group_end->clear();
+  group_end->reserve(num_nodes);
+
+  // Depth of the node that produces each tensor, for the tensors produced
+  // since the last barrier, or -1.
+  std::vector<int> tensor_depth(info->num_tensors(), -1);
+  // (depth, execution-plan index) of the nodes since the last barrier.
+  std::vector<std::pair<int, int>> segment;
+
+  // Appends the nodes since the last barrier in order of depth.
+  auto flush_segment = [&]() {
+    std::stable_sort(segment.begin(), segment.end(),
+                     [](const std::pair<int, int>& a,
+                        const std::pair<int, int>& b) {
+                       return a.first < b.first;
+                     });
+    const int segment_start = execution_plan->size();
+    for (const auto& depth_and_index : segment) {
+      execution_plan->push_back(info->node_index(depth_and_index.second));
+      for (int tensor_index :
+           TfLiteIntArrayView(info->node(depth_and_index.second).outputs)) {
+        if (tensor_index != kTfLiteOptionalTensor) {
+          tensor_depth[tensor_index] = -1;
+        }
+      }
+    }
+    const int segment_size = segment.size();
+    for (int begin = 0, end = 0; begin < segment_size; begin = end) {
+      while (end < segment_size &&
+             segment[end].first == segment[begin].first) {
+        ++end;
+      }
+      group_end->insert(group_end->end(), end - begin, segment_start + end);
+    }
+    segment.clear();
+  };
+
+  for (int i = 0; i < num_nodes; ++i) {
+    const TfLiteNode& node = info->node(i);
+    if (is_barrier[i] || node.might_have_side_effect) {
+      flush_segment();
+      execution_plan->push_back(info->node_index(i));
+      group_end->push_back(execution_plan->size());
+      continue;
+    }
+    int depth = 0;
+    for (int tensor_index : TfLiteIntArrayView(node.inputs)) {
+      if (tensor_index != kTfLiteOptionalTensor &&
+          tensor_depth[tensor_index] >= 0) {
+        depth = std::max(depth, tensor_depth[tensor_index] + 1);
+      }
+    }
+    for (int tensor_index : TfLiteIntArrayView(node.outputs)) {
+      if (tensor_index != kTfLiteOptionalTensor) {
+        tensor_depth[tensor_index] = depth;
+      }
+    }
+    segment.emplace_back(depth, i);
+  }
+  flush_segment();
+}
+
 }  // namespace tflite
@@ -63,6 +63,12 @@ class GraphInfo {
 
   // Returns the indices of the variable tensors.
   virtual const std::vector<int>& variables() const = 0;
+
+  // Returns the execution-plan index of the last node that may run
+  // concurrently with the node at execution-plan index `index`. Tensors used by
+  // the node must stay alive until that node completes. By default nodes run
+  // one at a time in execution-plan order.
+  virtual size_t last_concurrent_node(size_t index) const { return index; }
 };
 
 // Represents a subset of nodes in a TensorFlow Lite graph.
@@ -133,6 +139,31 @@ TfLiteStatus PartitionGraphIntoIndependentNodeSubsets(
     const GraphInfo* info, const TfLiteIntArray* nodes_to_partition,
     const ControlEdges& control_edges, std::vector<NodeSubset>* node_subsets);
 
+// Reorders the execution plan of `info` so that nodes that may run
+// concurrently are adjacent. Each node is placed according to the length of
+// the longest chain of data dependencies that leads to it from the start of
+// the graph, so nodes at the same depth cannot depend on each other and form a
+// group. Nodes for which `is_barrier` is true, and nodes that might have side
+// effects, form a group of their own and keep their position relative to all
+// other nodes.
+//
+// On return, `execution_plan` holds the node indices (see
+// `GraphInfo::node_index()`) in the new order, and `group_end[i]` is the
+// position in `execution_plan` one past the last node of the group that
+// contains position `i`.
+//
+// (Example: the graph
+//
+// 0 --> 1 --> 2 --> 6
+// 3 --> 4 --> 5 ----^
+//
+// is reordered to {0, 3, 1, 4, 2, 5, 6}, with groups {0, 3}, {1, 4}, {2, 5}
+// and {6}.)
+void GroupIndependentNodes(const GraphInfo* info,
+                           const std::vector<bool>& is_barrier,
+                           std::vector<int>* execution_plan,
+                           std::vector<int>* group_end);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_GRAPH_INFO_H_
@@ -442,5 +442,71 @@ TEST(PartitionTest, Nodes4PartitionNodes3_WithExternalControlDependency) {
       {expected_subgraph0, expected_subgraph1, expected_subgraph2});
 }
 
+// Two independent chains are interleaved so that nodes at the same depth are
+// grouped.
+//
+// 0 --> 1 --> 2 --> 6
+// 3 --> 4 --> 5 ----^
+TEST(GroupIndependentNodesTest, InterleavesIndependentChains) {
+  SimpleTestGraph graph;
+  graph.AddTensors(8);
+  graph.AddNode({0}, {1});
+  graph.AddNode({1}, {2});
+  graph.AddNode({2}, {3});
+  graph.AddNode({0}, {4});
+  graph.AddNode({4}, {5});
+  graph.AddNode({5}, {6});
+  graph.AddNode({3, 6}, {7});
+  graph.SetInputsAndOutputs({0}, {7});
+
+  std::vector<int> execution_plan;
+  std::vector<int> group_end;
+  GroupIndependentNodes(&graph, std::vector<bool>(7, false), &execution_plan,
+                        &group_end);
+  EXPECT_EQ(execution_plan, std::vector<int>({0, 3, 1, 4, 2, 5, 6}));
+  EXPECT_EQ(group_end, std::vector<int>({2, 2, 4, 4, 6, 6, 7}));
+}
+
+// Barriers and nodes with side effects are never grouped, and nodes are not
+// moved across them.
+TEST(GroupIndependentNodesTest, KeepsOrderAroundBarriers) {
+  SimpleTestGraph graph;
+  graph.AddTensors(6);
+  graph.AddNode({0}, {1});
+  graph.AddNode({0}, {2});
+  graph.AddNode({0}, {3}, /*might_have_side_effect=*/true);
+  graph.AddNode({1}, {4});
+  graph.AddNode({2}, {5});
+  graph.SetInputsAndOutputs({0}, {3, 4, 5});
+
+  std::vector<int> execution_plan;
+  std::vector<int> group_end;
+  GroupIndependentNodes(&graph, std::vector<bool>(5, false), &execution_plan,
+                        &group_end);
+  EXPECT_EQ(execution_plan, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(group_end, std::vector<int>({2, 2, 3, 5, 5}));
+
+  GroupIndependentNodes(&graph, {false, true, false, false, false},
+                        &execution_plan, &group_end);
+  EXPECT_EQ(execution_plan, std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(group_end, std::vector<int>({1, 2, 3, 5, 5}));
+}
+
+// Nodes outside of the execution plan are not included.
+TEST(GroupIndependentNodesTest, UsesNodeIndices) {
+  SimpleTestGraph graph(/*node_index_offset=*/2);
+  graph.AddTensors(3);
+  graph.AddNode({0}, {1});
+  graph.AddNode({0}, {2});
+  graph.SetInputsAndOutputs({0}, {1, 2});
+
+  std::vector<int> execution_plan;
+  std::vector<int> group_end;
+  GroupIndependentNodes(&graph, std::vector<bool>(2, false), &execution_plan,
+                        &group_end);
+  EXPECT_EQ(execution_plan, std::vector<int>({2, 3}));
+  EXPECT_EQ(group_end, std::vector<int>({2, 2}));
+}
+
 }  // namespace
 }  // namespace tflite
@@ -18,6 +18,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_INTERPRETER_OPTIONS_H_
 #define TENSORFLOW_LITE_INTERPRETER_OPTIONS_H_
 
+#include <cstddef>
+
 namespace tflite {
 
 /// Options class for `Interpreter`.
@@ -27,7 +29,9 @@ class InterpreterOptions {
   InterpreterOptions()
       : experimental_preserve_all_tensors_(false),
         experimental_ensure_dynamic_tensors_are_released_(false),
-        experimental_optimize_memory_for_large_tensors_(0) {}
+        experimental_optimize_memory_for_large_tensors_(0),
+        experimental_max_concurrent_nodes_(1),
+        experimental_rematerialization_memory_budget_(0) {}
 
   /// Preserving all intermediates tensors for debugging.
   /// WARNING: This is an experimental API and subject to change.
@@ -76,10 +80,49 @@ class InterpreterOptions {
     return experimental_optimize_memory_for_large_tensors_;
   }
 
+  /// Runs nodes of the execution plan that don't depend on each other
+  /// concurrently, on up to `value` threads. The execution plan is reordered
+  /// so that independent nodes are adjacent, and tensors used by nodes that
+  /// run concurrently don't share memory, so this may increase the arena
+  /// size. Nodes with side effects, custom ops and delegate kernels always run
+  /// alone. Each additional thread uses its own CPU backend context, limited
+  /// to one thread, so kernels don't oversubscribe the cores. This option must
+  /// be applied before `AllocateTensors`, and has no effect with a profiler.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetMaxConcurrentNodes(int value) {
+    experimental_max_concurrent_nodes_ = value;
+  }
+
+  /// Returns the maximum number of nodes that run concurrently.
+  /// WARNING: This is an experimental API and subject to change.
+  int GetMaxConcurrentNodes() { return experimental_max_concurrent_nodes_; }
+
+  /// Recomputes cheap intermediate tensors, such as the outputs of
+  /// elementwise ops and dequantized weights, right before their late uses
+  /// instead of keeping them alive, until the estimated peak of the tensor
+  /// arena is at most `bytes`. The nodes that recompute them are added to the
+  /// execution plan by the first `AllocateTensors`, using the shapes known at
+  /// that time. Zero disables rematerialization, which has no effect on
+  /// delegated graphs, with `SetPreserveAllTensors` or with
+  /// `SetMaxConcurrentNodes`.
+  /// WARNING: This is an experimental API and subject to change.
+  void SetRematerializationMemoryBudget(size_t bytes) {
+    experimental_rematerialization_memory_budget_ = bytes;
+  }
+
+  /// Returns the arena size targeted by rematerialization, or zero if it is
+  /// disabled.
+  /// WARNING: This is an experimental API and subject to change.
+  size_t GetRematerializationMemoryBudget() {
+    return experimental_rematerialization_memory_budget_;
+  }
+
  private:
   bool experimental_preserve_all_tensors_;
   bool experimental_ensure_dynamic_tensors_are_released_;
   int experimental_optimize_memory_for_large_tensors_;
+  int experimental_max_concurrent_nodes_;
+  size_t experimental_rematerialization_memory_budget_;
 };
 
 }  // namespace tflite
@@ -30,6 +30,7 @@ limitations under the License.
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/lite/builtin_ops.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/c_api_types.h"
 #include "tensorflow/lite/delegates/utils/simple_delegate.h"
@@ -1114,6 +1115,110 @@ TEST(BasicInterpreter, ReleaseDynamicTensors) {
   ASSERT_EQ(interpreter.tensor(3)->bytes, sizeof(float) * 6 * 6);
 }
 
+TEST(BasicInterpreter, InvokeIndependentNodesConcurrently) {
+  // Assemble a graph with two independent chains of negate ops.
+  Interpreter interpreter;
+  interpreter.AddTensors(5);
+  interpreter.SetInputs({0});
+  interpreter.SetOutputs({2, 4});
+  TfLiteQuantizationParams quant;
+  for (int i = 0; i < 5; ++i) {
+    interpreter.SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {3},
+                                             quant);
+  }
+  TfLiteRegistration* neg_op = tflite::ops::builtin::Register_NEG();
+  interpreter.AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, neg_op);
+  interpreter.AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, neg_op);
+  interpreter.AddNodeWithParameters({0}, {3}, nullptr, 0, nullptr, neg_op);
+  interpreter.AddNodeWithParameters({3}, {4}, nullptr, 0, nullptr, neg_op);
+
+  InterpreterOptions options;
+  options.SetMaxConcurrentNodes(2);
+  interpreter.ApplyOptions(&options);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // The nodes at the same depth of both chains are adjacent.
+  EXPECT_THAT(interpreter.execution_plan(), testing::ElementsAre(0, 2, 1, 3));
+  // Nodes 1 and 3 run concurrently, so the input of one can't share memory
+  // with the output of the other.
+  EXPECT_NE(interpreter.tensor(1)->data.raw, interpreter.tensor(4)->data.raw);
+
+  for (int step = 0; step < 3; ++step) {
+    float* input = interpreter.typed_tensor<float>(0);
+    for (int i = 0; i < 3; ++i) {
+      input[i] = step * 3 + i;
+    }
+    ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(interpreter.typed_tensor<float>(2)[i], step * 3 + i);
+      EXPECT_EQ(interpreter.typed_tensor<float>(4)[i], step * 3 + i);
+    }
+  }
+}
+
+TEST(BasicInterpreter, RematerializeUnderMemoryBudget) {
+  // Tensor 1 is used by the second and the last node, and stays live while
+  // tensors 2 to 4 are.
+  auto build = [](Interpreter* interpreter) {
+    interpreter->AddTensors(6);
+    interpreter->SetInputs({0});
+    interpreter->SetOutputs({5});
+    TfLiteQuantizationParams quant;
+    for (int i = 0; i < 6; ++i) {
+      interpreter->SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {64},
+                                                quant);
+    }
+    TfLiteRegistration neg_op = *tflite::ops::builtin::Register_NEG();
+    neg_op.builtin_code = kTfLiteBuiltinNeg;
+    TfLiteRegistration add_op = *tflite::ops::builtin::Register_ADD();
+    add_op.builtin_code = kTfLiteBuiltinAdd;
+    auto add_params = [] {
+      auto* params =
+          reinterpret_cast<TfLiteAddParams*>(malloc(sizeof(TfLiteAddParams)));
+      params->activation = kTfLiteActNone;
+      params->pot_scale_int16 = false;
+      return params;
+    };
+    interpreter->AddNodeWithParameters({0}, {1}, nullptr, 0, nullptr, &neg_op);
+    interpreter->AddNodeWithParameters({1}, {2}, nullptr, 0, nullptr, &neg_op);
+    interpreter->AddNodeWithParameters({2}, {3}, nullptr, 0, nullptr, &neg_op);
+    interpreter->AddNodeWithParameters({3, 2}, {4}, nullptr, 0, add_params(),
+                                       &add_op);
+    interpreter->AddNodeWithParameters({4, 1}, {5}, nullptr, 0, add_params(),
+                                       &add_op);
+  };
+
+  Interpreter reference;
+  build(&reference);
+  ASSERT_EQ(reference.AllocateTensors(), kTfLiteOk);
+  EXPECT_EQ(reference.execution_plan().size(), 5);
+
+  Interpreter interpreter;
+  build(&interpreter);
+  InterpreterOptions options;
+  options.SetRematerializationMemoryBudget(4 * 64 * sizeof(float));
+  interpreter.ApplyOptions(&options);
+  ASSERT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+
+  // A copy of node 0 recomputes tensor 1 before the last node.
+  EXPECT_THAT(interpreter.execution_plan(),
+              testing::ElementsAre(0, 1, 2, 3, 5, 4));
+  Subgraph::SubgraphAllocInfo reference_info;
+  reference.primary_subgraph().GetMemoryAllocInfo(&reference_info);
+  Subgraph::SubgraphAllocInfo info;
+  interpreter.primary_subgraph().GetMemoryAllocInfo(&info);
+  EXPECT_LT(info.arena_size, reference_info.arena_size);
+
+  float* input = interpreter.typed_input_tensor<float>(0);
+  for (int i = 0; i < 64; ++i) {
+    input[i] = i;
+  }
+  ASSERT_EQ(interpreter.Invoke(), kTfLiteOk);
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(interpreter.typed_output_tensor<float>(0)[i], -i);
+  }
+}
+
 TEST(InterpreterTensorsCapacityTest, TestWithinHeadroom) {
   Interpreter interpreter;
   ASSERT_EQ(interpreter.AddTensors(Interpreter::kTensorsReservedCapacity),
@@ -148,6 +148,35 @@ void CpuBackendContext::SetMaxNumThreads(int max_num_threads) {
 
 void CpuBackendContext::SetUseCaching(bool flag) { use_caching_ = flag; }
 
+void CpuBackendContext::SetPrepackedCacheMaxBytes(size_t max_bytes) {
+  prepacked_cache_max_bytes_ = max_bytes;
+  if (max_bytes > 0) SetUseCaching(true);
+}
+
+bool CpuBackendContext::ShouldCachePrepacked(const void* data,
+                                             size_t packed_bytes) {
+  if (prepacked_matrices_.count(data) > 0) {
+    ++prepacked_cache_stats_.hits;
+    return true;
+  }
+  if (prepacked_cache_max_bytes_ > 0 &&
+      prepacked_cache_stats_.bytes + packed_bytes >
+          prepacked_cache_max_bytes_) {
+    ++prepacked_cache_stats_.bypasses;
+    return false;
+  }
+  prepacked_matrices_.insert(data);
+  prepacked_cache_stats_.bytes += packed_bytes;
+  ++prepacked_cache_stats_.misses;
+  return true;
+}
+
+void CpuBackendContext::ClearCaches() {
+  ruy_context_->ClearPrepackedCache();
+  prepacked_matrices_.clear();
+  prepacked_cache_stats_.bytes = 0;
+}
+
 bool CpuBackendContext::PreferGemmlowpOnX86() {
   bool use_gemmlowp_on_x86 = false;
 #if defined(TFLITE_X86_PLATFORM) && TFLITE_HAS_ATTRIBUTE_WEAK && \
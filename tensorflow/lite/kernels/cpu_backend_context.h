@@ -21,7 +21,10 @@ limitations under the License.
 #define TFLITE_X86_PLATFORM
 #endif
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <unordered_set>
 
 #include "public/gemmlowp.h"
 #include "ruy/context.h"  // from @ruy
@@ -53,7 +56,39 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
 
   bool use_caching() const { return use_caching_; }
 
-  void ClearCaches() override { ruy_context_->ClearPrepackedCache(); }
+  // Statistics of the caching of packed constant matrices.
+  struct PrepackedCacheStats {
+    // Number of matrix multiplications that reused a cached packed matrix.
+    int64_t hits = 0;
+    // Number of matrix multiplications that packed a matrix and cached it.
+    int64_t misses = 0;
+    // Number of matrix multiplications that packed a constant matrix without
+    // caching it, because the cache was full.
+    int64_t bypasses = 0;
+    // Estimated size of the cached packed matrices.
+    size_t bytes = 0;
+  };
+
+  // Caps the estimated size of the cached packed constant matrices, and
+  // enables caching if `max_bytes` is positive. While caching is enabled,
+  // every constant matrix is packed once and its packed version is reused by
+  // later calls, until the cap is reached. Zero means no cap.
+  void SetPrepackedCacheMaxBytes(size_t max_bytes);
+
+  size_t prepacked_cache_max_bytes() const {
+    return prepacked_cache_max_bytes_;
+  }
+
+  // Returns true if the packed version of the constant matrix at `data`, of
+  // about `packed_bytes` bytes, should be cached, and updates the statistics.
+  // Only meaningful while `use_caching()` is true.
+  bool ShouldCachePrepacked(const void* data, size_t packed_bytes);
+
+  const PrepackedCacheStats& prepacked_cache_stats() const {
+    return prepacked_cache_stats_;
+  }
+
+  void ClearCaches() override;
 
   // Gemmlowp on x86 is a deprecated path but some clients may still use
   // this path based on link time dependencies.
@@ -115,6 +150,11 @@ class CpuBackendContext final : public TfLiteInternalBackendContext {
   // (currently the Ruy library only).
   bool use_caching_;
 
+  size_t prepacked_cache_max_bytes_ = 0;
+  // Data of the constant matrices that are cached.
+  std::unordered_set<const void*> prepacked_matrices_;
+  PrepackedCacheStats prepacked_cache_stats_;
+
   CpuBackendContext(const CpuBackendContext&) = delete;
 };
 
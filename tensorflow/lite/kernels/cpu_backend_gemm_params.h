@@ -63,7 +63,9 @@ struct MatrixParams {
   // a CachePolicy may be used instead of the default kNeverCache,
   // which will enable ruy to take advantage of this constancy of the data to
   // cache the packing work, which can be a large speedup in matrix*vector
-  // and other narrow shapes.
+  // and other narrow shapes. When the CpuBackendContext uses caching, any
+  // policy other than kNeverCache caches the packed matrix, within the cap
+  // set by CpuBackendContext::SetPrepackedCacheMaxBytes.
   CachePolicy cache_policy = CachePolicy::kNeverCache;
 };
 
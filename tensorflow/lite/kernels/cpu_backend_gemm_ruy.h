@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_RUY_H_
 #define TENSORFLOW_LITE_KERNELS_CPU_BACKEND_GEMM_RUY_H_
 
+#include <cstddef>
+
 #include "ruy/matrix.h"  // from @ruy
 #include "ruy/mul_params.h"  // from @ruy
 #include "ruy/ruy.h"  // from @ruy
@@ -27,23 +29,31 @@ namespace tflite {
 namespace cpu_backend_gemm {
 namespace detail {
 
-inline ruy::CachePolicy ToRuyCachePolicy(CachePolicy cache_policy) {
-  switch (cache_policy) {
-    case CachePolicy::kNeverCache:
-      return ruy::CachePolicy::kNeverCache;
-    case CachePolicy::kCacheIfLargeSpeedup:
-      return ruy::CachePolicy::kCacheIfLargeSpeedup;
-    case CachePolicy::kAlwaysCache:
-      return ruy::CachePolicy::kAlwaysCache;
-    default:
-      TFLITE_DCHECK(false);
-      return ruy::CachePolicy::kNeverCache;
+// Returns the ruy cache policy for the matrix with `params` and `data`. Every
+// constant matrix is cached, until the cap of `context` on the size of the
+// cached packed matrices is reached.
+template <typename Scalar>
+ruy::CachePolicy GetRuyCachePolicy(const MatrixParams<Scalar>& params,
+                                   const Scalar* data,
+                                   CpuBackendContext* context) {
+  if (params.cache_policy == CachePolicy::kNeverCache) {
+    return ruy::CachePolicy::kNeverCache;
   }
+  // Packing pads the matrix to a multiple of the kernel block size, which is
+  // ignored here.
+  const size_t packed_bytes =
+      static_cast<size_t>(params.rows) * params.cols * sizeof(Scalar);
+  return context->ShouldCachePrepacked(data, packed_bytes)
+             ? ruy::CachePolicy::kAlwaysCache
+             : ruy::CachePolicy::kNeverCache;
 }
 
+// If `caching_context` is not null, the packed version of `dst` may be cached
+// in it.
 template <typename Scalar, typename DataPointer>
 void MakeRuyMatrix(const MatrixParams<Scalar>& params, DataPointer data_ptr,
-                   ruy::Matrix<Scalar>* dst, bool use_caching = false) {
+                   ruy::Matrix<Scalar>* dst,
+                   CpuBackendContext* caching_context = nullptr) {
   ruy::Order ruy_order = params.order == Order::kColMajor
                              ? ruy::Order::kColMajor
                              : ruy::Order::kRowMajor;
@@ -53,8 +63,8 @@ void MakeRuyMatrix(const MatrixParams<Scalar>& params, DataPointer data_ptr,
   // It does care whether we assign to it a Scalar* or a const Scalar*.
   dst->set_data(data_ptr);
   dst->set_zero_point(params.zero_point);
-  if (use_caching) {
-    dst->set_cache_policy(ToRuyCachePolicy(params.cache_policy));
+  if (caching_context != nullptr) {
+    dst->set_cache_policy(GetRuyCachePolicy(params, data_ptr, caching_context));
   }
 }
 
@@ -131,8 +141,10 @@ struct GemmImplUsingRuy {
     ruy::Matrix<LhsScalar> ruy_lhs;
     ruy::Matrix<RhsScalar> ruy_rhs;
     ruy::Matrix<DstScalar> ruy_dst;
-    MakeRuyMatrix(lhs_params, lhs_data, &ruy_lhs, context->use_caching());
-    MakeRuyMatrix(rhs_params, rhs_data, &ruy_rhs, context->use_caching());
+    CpuBackendContext* caching_context =
+        context->use_caching() ? context : nullptr;
+    MakeRuyMatrix(lhs_params, lhs_data, &ruy_lhs, caching_context);
+    MakeRuyMatrix(rhs_params, rhs_data, &ruy_rhs, caching_context);
     MakeRuyMatrix(dst_params, dst_data, &ruy_dst);
 
     ruy::MulParams<AccumScalar, DstScalar> ruy_mul_params;
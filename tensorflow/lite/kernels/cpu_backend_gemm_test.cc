@@ -627,6 +627,60 @@ TEST(CpuBackendGemmInvalidGemmTest, Float) {
 #endif
 }
 
+TEST(CpuBackendGemmPrepackedCacheTest, CachesConstantMatricesWithinCap) {
+  constexpr int kRows = 4;
+  constexpr int kDepth = 8;
+  constexpr int kCols = 1;
+  CpuBackendContext cpu_backend_context;
+  cpu_backend_context.SetPrepackedCacheMaxBytes(kRows * kDepth * sizeof(float));
+  EXPECT_TRUE(cpu_backend_context.use_caching());
+
+  std::vector<float> weights;
+  std::vector<float> other_weights;
+  std::vector<float> input;
+  MakeVectorFilledWithConsecutiveInts(kRows * kDepth, &weights);
+  MakeVectorFilledWithConsecutiveInts(kRows * kDepth, &other_weights);
+  MakeVectorFilledWithConsecutiveInts(kDepth * kCols, &input);
+  MatrixParams<float> lhs_params;
+  lhs_params.order = cpu_backend_gemm::Order::kRowMajor;
+  lhs_params.rows = kRows;
+  lhs_params.cols = kDepth;
+  lhs_params.cache_policy = cpu_backend_gemm::DefaultCachePolicy(true);
+  MatrixParams<float> rhs_params;
+  rhs_params.rows = kDepth;
+  rhs_params.cols = kCols;
+  MatrixParams<float> dst_params;
+  dst_params.rows = kRows;
+  dst_params.cols = kCols;
+  GemmParams<float, float> params;
+
+  auto gemm = [&](const std::vector<float>& lhs) {
+    std::vector<float> dst(kRows * kCols);
+    Gemm(lhs_params, lhs.data(), rhs_params, input.data(), dst_params,
+         dst.data(), params, &cpu_backend_context);
+    return dst;
+  };
+  const std::vector<float> expected = gemm(weights);
+  EXPECT_EQ(gemm(weights), expected);
+  EXPECT_EQ(gemm(weights), expected);
+  auto stats = cpu_backend_context.prepacked_cache_stats();
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.hits, 2);
+  EXPECT_EQ(stats.bypasses, 0);
+  EXPECT_EQ(stats.bytes, kRows * kDepth * sizeof(float));
+
+  // The cache is full, so other constant matrices are packed on every call.
+  EXPECT_EQ(gemm(other_weights), expected);
+  EXPECT_EQ(cpu_backend_context.prepacked_cache_stats().bypasses, 1);
+
+  cpu_backend_context.ClearCaches();
+  EXPECT_EQ(cpu_backend_context.prepacked_cache_stats().bytes, 0);
+  EXPECT_EQ(gemm(other_weights), expected);
+  stats = cpu_backend_context.prepacked_cache_stats();
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.bypasses, 1);
+}
+
 TEST(CpuBackendGemmSimpleTestAgainstGolden, Int8Int16) {
   TestSomeGemm<std::int8_t, std::int8_t, std::int32_t, std::int16_t>(
       3, 5, 4, {19, 48, 77, 48, 149, 250, 76, 249, 422, 105, 350, 595});
@@ -26,6 +26,8 @@ limitations under the License.
 //   Output.dim[1] == Tensor[1].dim[1],  num of items per row
 //   Each item in output is a raw bytes copy of the corresponding item in input,
 //   or a dequantized value in the case of a uint8 input.
+//   Int4 matrices must be 2-dimensional and are dequantized with either one
+//   scale per row or a single scale.
 //   When indices are out of bound, the ops will not succeed.
 //
 
@@ -35,6 +37,7 @@ limitations under the License.
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 
 namespace tflite {
@@ -57,6 +60,19 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   TfLiteTensor* output;
   TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+  if (value->type == kTfLiteInt4) {
+    TF_LITE_ENSURE_EQ(context, NumDimensions(value), 2);
+    TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteFloat32);
+    TF_LITE_ENSURE_EQ(context, value->quantization.type,
+                      kTfLiteAffineQuantization);
+    const auto* params = reinterpret_cast<const TfLiteAffineQuantization*>(
+        value->quantization.params);
+    TF_LITE_ENSURE(context, params != nullptr && params->scale != nullptr);
+    TF_LITE_ENSURE(context, params->scale->size == 1 ||
+                                (params->quantized_dimension == 0 &&
+                                 params->scale->size ==
+                                     SizeOfDimension(value, 0)));
+  }
   TfLiteIntArray* outputSize = TfLiteIntArrayCreate(NumDimensions(value));
 
   outputSize->data[0] = SizeOfDimension(lookup, 0);
@@ -135,6 +151,40 @@ TfLiteStatus EvalHybrid(TfLiteContext* context, TfLiteNode* node,
   return kTfLiteOk;
 }
 
+TfLiteStatus EvalInt4Hybrid(TfLiteContext* context, TfLiteNode* node,
+                            const TfLiteTensor* lookup,
+                            const TfLiteTensor* value, TfLiteTensor* output) {
+  const int row_size = SizeOfDimension(value, 0);
+  const int col_size = SizeOfDimension(value, 1);
+  // Each row is packed two values per byte, padded to a whole byte.
+  const int row_bytes = (col_size + 1) / 2;
+  const TfLiteFloatArray* scales =
+      reinterpret_cast<const TfLiteAffineQuantization*>(
+          value->quantization.params)
+          ->scale;
+
+  float* output_ptr = GetTensorData<float>(output);
+  const int8_t* value_ptr = GetTensorData<int8_t>(value);
+  const int32_t* lookup_data = GetTensorData<int32_t>(lookup);
+
+  for (int i = 0; i < SizeOfDimension(lookup, 0); i++) {
+    int idx = lookup_data[i];
+    if (idx >= row_size || idx < 0) {
+      TF_LITE_KERNEL_LOG(context,
+                         "Embedding Lookup: index out of bounds. "
+                         "Got %d, and bounds are [0, %d]",
+                         idx, row_size - 1);
+      return kTfLiteError;
+    }
+    const float scale = scales->data[scales->size == 1 ? 0 : idx];
+    tensor_utils::Int4VectorScalarMultiply(value_ptr + idx * row_bytes,
+                                           col_size, scale,
+                                           output_ptr + i * col_size);
+  }
+
+  return kTfLiteOk;
+}
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* lookup;
   TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 0, &lookup));
@@ -152,6 +202,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       } else {
         return EvalSimple(context, node, lookup, value, output);
       }
+    case kTfLiteInt4:
+      return EvalInt4Hybrid(context, node, lookup, value, output);
     default:
       TF_LITE_KERNEL_LOG(context, "Type not currently supported.");
       return kTfLiteError;
@@ -101,6 +101,45 @@ class HybridEmbeddingLookupOpModel : public BaseEmbeddingLookupOpModel {
   }
 };
 
+class Int4EmbeddingLookupOpModel : public SingleOpModel {
+ public:
+  // `weight` holds unpacked int4 values in row-major order.
+  Int4EmbeddingLookupOpModel(std::initializer_list<int> index_shape,
+                             std::initializer_list<int> weight_shape,
+                             const std::vector<int8_t>& weight,
+                             const std::vector<float>& scales) {
+    const std::vector<int> shape = weight_shape;
+    const int cols = shape[1];
+    const int row_bytes = (cols + 1) / 2;
+    std::vector<uint8_t> packed(shape[0] * row_bytes, 0);
+    for (int i = 0; i < weight.size(); ++i) {
+      const int row = i / cols;
+      const int col = i % cols;
+      packed[row * row_bytes + col / 2] |= (weight[i] & 0x0F)
+                                           << (4 * (col % 2));
+    }
+    input_ = AddInput(TensorType_INT32);
+    TensorData weight_data(TensorType_INT4, shape);
+    weight_data.per_channel_quantization = true;
+    weight_data.per_channel_quantization_scales = scales;
+    weight_data.per_channel_quantization_offsets.resize(scales.size(), 0);
+    AddConstInput(weight_data, packed.data(), packed.size());
+    output_ = AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_EMBEDDING_LOOKUP, BuiltinOptions_NONE, 0);
+    BuildInterpreter({index_shape});
+  }
+
+  void SetInput(std::initializer_list<int> data) {
+    PopulateTensor(input_, data);
+  }
+
+  std::vector<float> GetOutput() { return ExtractVector<float>(output_); }
+
+ private:
+  int input_;
+  int output_;
+};
+
 // TODO(ahentz): write more tests that exercise the details of the op, such as
 // lookup errors and variable input shapes.
 TEST(EmbeddingLookupOpTest, SimpleTest) {
@@ -261,5 +300,42 @@ TEST(EmbeddingLookupHybridOpTest, Simple3DTestQuantized) {
               }));
 }
 
+TEST(EmbeddingLookupInt4OpTest, PerRowScales) {
+  // Rows have an odd number of columns, so each is padded to a whole byte.
+  Int4EmbeddingLookupOpModel m({3}, {3, 5},
+                               {
+                                   -8, -1, 0, 1, 7,   // Row 0
+                                   1,  2,  3,  4, 5,  // Row 1
+                                   -2, -3, -4, 6, 0,  // Row 2
+                               },
+                               {0.5, 0.25, 2.0});
+  m.SetInput({1, 0, 2});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 0.25, 0.5, 0.75, 1.0, 1.25,   // Row 1
+                                 -4.0, -0.5, 0.0, 0.5, 3.5,    // Row 0
+                                 -4.0, -6.0, -8.0, 12.0, 0.0,  // Row 2
+                             })));
+}
+
+TEST(EmbeddingLookupInt4OpTest, PerTensorScale) {
+  Int4EmbeddingLookupOpModel m({2}, {2, 4},
+                               {
+                                   1, -2, 3, -4,  // Row 0
+                                   5, -6, 7, -8,  // Row 1
+                               },
+                               {0.5});
+  m.SetInput({1, 1});
+
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput(), ElementsAreArray(ArrayFloatNear({
+                                 2.5, -3.0, 3.5, -4.0,  // Row 1
+                                 2.5, -3.0, 3.5, -4.0,  // Row 1
+                             })));
+}
+
 }  // namespace
 }  // namespace tflite
@@ -1030,6 +1030,16 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                 GetTensorData<int32_t>(bias), output_shape,
                 GetTensorData<int8_t>(output),
                 CpuBackendContext::GetFromContext(context));
+          } else if (sparsity.dim_metadata_size ==
+                         kDimMetadataSizeBlockSparse &&
+                     sparsity.dim_metadata[2].dense_size == 4) {
+            // Block sparse with block size of 1x4.
+            optimized_ops::FullyConnectedSparseWeight1x4(
+                sparsity, op_params, input_shape, GetTensorData<int8_t>(input),
+                filter_shape, GetTensorData<int8_t>(filter), bias_shape,
+                GetTensorData<int32_t>(bias), output_shape,
+                GetTensorData<int8_t>(output),
+                CpuBackendContext::GetFromContext(context));
           } else {
             TF_LITE_KERNEL_LOG(
                 context, "Unsupported sparse fully-connected weight format.");
@@ -27,9 +27,12 @@ namespace hashtable {
 constexpr int kInputResourceIdTensor = 0;
 constexpr int kKeyTensor = 1;
 constexpr int kValueTensor = 2;
+// Optional int32 slot index built offline by `BuildHashtableIndex`, which
+// saves hashing the keys when the table is imported.
+constexpr int kIndexTensor = 3;
 
 TfLiteStatus PrepareHashtableImport(TfLiteContext* context, TfLiteNode* node) {
-  TF_LITE_ENSURE_EQ(context, NumInputs(node), 3);
+  TF_LITE_ENSURE(context, NumInputs(node) == 3 || NumInputs(node) == 4);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 0);
 
   const TfLiteTensor* input_resource_id_tensor;
@@ -52,6 +55,13 @@ TfLiteStatus PrepareHashtableImport(TfLiteContext* context, TfLiteNode* node) {
   // TODO(b/144731295): Tensorflow lookup ops support 1-D vector in storing
   // values.
   TF_LITE_ENSURE(context, HaveSameShapes(key_tensor, value_tensor));
+
+  const TfLiteTensor* index_tensor =
+      GetOptionalInputTensor(context, node, kIndexTensor);
+  if (index_tensor != nullptr) {
+    TF_LITE_ENSURE_TYPES_EQ(context, index_tensor->type, kTfLiteInt32);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(index_tensor), 1);
+  }
   return kTfLiteOk;
 }
 
@@ -76,6 +86,12 @@ TfLiteStatus EvalHashtableImport(TfLiteContext* context, TfLiteNode* node) {
       lookup->CheckKeyAndValueTypes(context, key_tensor, value_tensor));
   // The hashtable resource will only be initialized once, attempting to
   // initialize it multiple times will be a no-op.
+  const TfLiteTensor* index_tensor =
+      GetOptionalInputTensor(context, node, kIndexTensor);
+  if (index_tensor != nullptr) {
+    return lookup->ImportWithIndex(context, key_tensor, value_tensor,
+                                   index_tensor);
+  }
   auto result = lookup->Import(context, key_tensor, value_tensor);
   return result;
 }
@@ -20,6 +20,7 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "tensorflow/lite/experimental/resource/lookup_interfaces.h"
+#include "tensorflow/lite/experimental/resource/static_hashtable.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/test_util.h"
@@ -859,6 +860,49 @@ TEST(HashtableOpsTest, TestHashtableLookupInt64ToString) {
   EXPECT_THAT(m.GetOutputShape(), ElementsAreArray({3}));
 }
 
+TEST(HashtableOpsTest, TestHashtableLookupManyKeys) {
+  // More keys than a lookup batch, with many probe collisions.
+  const int kResourceId = 42;
+  const int kNumQueries = 50;
+  HashtableFindOpModel<std::int64_t, std::string> m(
+      TensorType_INT64, TensorType_STRING, kNumQueries);
+
+  std::vector<std::int64_t> keys;
+  std::vector<std::string> values;
+  for (int i = 0; i < 40; ++i) {
+    keys.push_back(i * 1024);
+    values.push_back(std::to_string(i));
+  }
+  // Repeated keys keep the first value.
+  keys.push_back(0);
+  values.push_back("repeated");
+
+  resource::CreateHashtableResourceIfNotAvailable(
+      &m.GetResources(), kResourceId, kTfLiteInt64, kTfLiteString);
+  auto* hashtable =
+      resource::GetHashtableResource(&m.GetResources(), kResourceId);
+  TfLiteContext context;
+  TfLiteTensor key_tensor = CreateTensor<std::int64_t>(kTfLiteInt64, keys);
+  TfLiteTensor value_tensor = CreateTensor<std::string>(kTfLiteString, values);
+  ASSERT_EQ(hashtable->Import(&context, &key_tensor, &value_tensor), kTfLiteOk);
+  TfLiteTensorFree(&key_tensor);
+  TfLiteTensorFree(&value_tensor);
+  EXPECT_EQ(hashtable->Size(), 40);
+
+  std::vector<std::int64_t> queries;
+  std::vector<std::string> expected;
+  for (int i = 0; i < kNumQueries; ++i) {
+    queries.push_back(i * 1024 + (i % 2));
+    expected.push_back(i % 2 == 0 && i < 40 ? std::to_string(i) : "none");
+  }
+  m.SetResourceId(kResourceId);
+  m.SetLookup(queries);
+  m.SetStringDefaultValue({"none"});
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  EXPECT_THAT(m.GetOutput<std::string>(), ElementsAreArray(expected));
+}
+
 // HashtableImportOpModel creates a model with a HashtableImport op.
 template <typename KeyType, typename ValueType>
 class HashtableImportOpModel : public BaseHashtableOpModel {
@@ -938,6 +982,105 @@ TEST(HashtableOpsTest, TestHashtableImportTwice) {
   EXPECT_EQ(hashtable->Size(), 3);
 }
 
+// HashtableImportWithIndexOpModel creates a model with a HashtableImport op
+// that takes a prebuilt index.
+template <typename KeyType, typename ValueType>
+class HashtableImportWithIndexOpModel : public BaseHashtableOpModel {
+ public:
+  HashtableImportWithIndexOpModel(const TensorType key_type,
+                                  const TensorType value_type,
+                                  int initdata_size, int index_size) {
+    key_type_ = key_type;
+    value_type_ = value_type;
+
+    resource_id_ = AddInput({TensorType_RESOURCE, {1}});
+    keys_ = AddInput({key_type, {initdata_size}});
+    values_ = AddInput({value_type, {initdata_size}});
+    index_ = AddInput({TensorType_INT32, {index_size}});
+
+    SetBuiltinOp(BuiltinOperator_HASHTABLE_IMPORT,
+                 BuiltinOptions_HashtableImportOptions,
+                 CreateHashtableImportOptions(builder_).Union());
+    BuildInterpreter({GetShape(resource_id_), GetShape(keys_),
+                      GetShape(values_), GetShape(index_)});
+  }
+
+  void SetStringKeys(const std::vector<std::string>& data) {
+    PopulateStringTensor(keys_, data);
+  }
+
+  void SetValues(const std::vector<ValueType>& data) {
+    PopulateTensor(values_, data);
+  }
+
+  void SetIndex(const std::vector<int32_t>& data) {
+    PopulateTensor(index_, data);
+  }
+
+ private:
+  int index_;
+};
+
+TEST(HashtableOpsTest, TestHashtableImportWithIndex) {
+  const int kResourceId = 42;
+  const std::vector<std::string> keys = {"a", "b", "c", "d", "e"};
+  TfLiteTensor key_tensor = CreateTensor<std::string>(kTfLiteString, keys);
+  std::vector<int32_t> index;
+  ASSERT_EQ(resource::internal::BuildHashtableIndex(&key_tensor, &index),
+            kTfLiteOk);
+  EXPECT_EQ(index.size(), 16);
+
+  HashtableImportWithIndexOpModel<std::string, std::int64_t> m(
+      TensorType_STRING, TensorType_INT64, keys.size(), index.size());
+  m.SetResourceId(kResourceId);
+  m.SetStringKeys(keys);
+  m.SetValues({1, 2, 3, 4, 5});
+  m.SetIndex(index);
+  m.CreateHashtableResource(kResourceId);
+  ASSERT_EQ(m.Invoke(), kTfLiteOk);
+
+  auto* hashtable =
+      resource::GetHashtableResource(&m.GetResources(), kResourceId);
+  ASSERT_TRUE(hashtable != nullptr);
+  EXPECT_EQ(hashtable->Size(), 5);
+
+  TfLiteContext context;
+  TfLiteTensor query_tensor =
+      CreateTensor<std::string>(kTfLiteString, {"e", "a", "f", "c"});
+  TfLiteTensor result_tensor =
+      CreateTensor<std::int64_t>(kTfLiteInt64, {0, 0, 0, 0});
+  TfLiteTensor default_value_tensor =
+      CreateTensor<std::int64_t>(kTfLiteInt64, {-1});
+  ASSERT_EQ(hashtable->Lookup(&context, &query_tensor, &result_tensor,
+                              &default_value_tensor),
+            kTfLiteOk);
+  const std::int64_t* result = GetTensorData<std::int64_t>(&result_tensor);
+  EXPECT_THAT(std::vector<std::int64_t>(result, result + 4),
+              ElementsAreArray({5, 1, -1, 3}));
+  TfLiteTensorFree(&key_tensor);
+  TfLiteTensorFree(&query_tensor);
+  TfLiteTensorFree(&result_tensor);
+  TfLiteTensorFree(&default_value_tensor);
+}
+
+TEST(HashtableOpsTest, TestHashtableImportWithInvalidIndex) {
+  const int kResourceId = 42;
+  // The index must have an empty slot, and entries must be in range and
+  // unique.
+  const std::vector<std::vector<int32_t>> invalid_indices = {
+      {0, 1}, {-1, 2}, {0, -1, 0, -1}, {-1, -1, -1}};
+  for (const auto& index : invalid_indices) {
+    HashtableImportWithIndexOpModel<std::string, std::int64_t> m(
+        TensorType_STRING, TensorType_INT64, 2, index.size());
+    m.SetResourceId(kResourceId);
+    m.SetStringKeys({"a", "b"});
+    m.SetValues({1, 2});
+    m.SetIndex(index);
+    m.CreateHashtableResource(kResourceId);
+    EXPECT_NE(m.Invoke(), kTfLiteOk);
+  }
+}
+
 // HashtableSizeOpModel creates a model with a HashtableSize op.
 template <typename KeyType, typename ValueType>
 class HashtableSizeOpModel : public BaseHashtableOpModel {
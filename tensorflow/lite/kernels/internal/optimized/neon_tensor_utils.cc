@@ -2031,6 +2031,68 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
   }
 }
 
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result) {
+  constexpr int kBlockSize = 4;
+  TFLITE_DCHECK_EQ(m_cols % kBlockSize, 0);
+
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* matrix_ptr = matrix;
+    for (int row = 0; row < m_rows; ++row) {
+      // Accumulation loop. Blocks of 4 values are too small for a NEON
+      // register, so two blocks are processed per iteration.
+      int32x4_t acc_i32x4 = vmovq_n_s32(0);
+      int32x4_t matrix_row_sum_i32x4 = vmovq_n_s32(0);
+      const int8_t* vector_in_batch = vector + batch * m_cols;
+
+      int i = segments[row];
+      for (; i + 1 < segments[row + 1]; i += 2) {
+        // Gather the two vector blocks that match the two matrix blocks.
+        int32_t vector_blocks[2];
+        memcpy(&vector_blocks[0], vector_in_batch + indices[i] * kBlockSize,
+               kBlockSize);
+        memcpy(&vector_blocks[1],
+               vector_in_batch + indices[i + 1] * kBlockSize, kBlockSize);
+        const int8x8_t vector_i8x8 =
+            vreinterpret_s8_s32(vld1_s32(vector_blocks));
+        const int8x8_t matrix_i8x8 = vld1_s8(matrix_ptr);
+
+        // Multiply the vector and matrix blocks and add to accumulator.
+        const int16x8_t prod_i16x8 = vmull_s8(vector_i8x8, matrix_i8x8);
+        acc_i32x4 = vpadalq_s16(acc_i32x4, prod_i16x8);
+        matrix_row_sum_i32x4 =
+            vpadalq_s16(matrix_row_sum_i32x4, vmovl_s8(matrix_i8x8));
+        matrix_ptr += 2 * kBlockSize;
+      }
+      int32_t acc = AccumulateNeonLane(acc_i32x4);
+      int32_t matrix_row_sum = AccumulateNeonLane(matrix_row_sum_i32x4);
+      // Leftover block, if the row has an odd number of blocks.
+      if (i < segments[row + 1]) {
+        const int8_t* vector_block_in_batch_ptr =
+            vector_in_batch + indices[i] * kBlockSize;
+        for (int c = 0; c < kBlockSize; ++c) {
+          acc += *matrix_ptr * *vector_block_in_batch_ptr++;
+          matrix_row_sum += *matrix_ptr++;
+        }
+      }
+
+      const int32_t bias_value = bias_vector != nullptr ? bias_vector[row] : 0;
+      acc = acc + bias_value + input_offset * matrix_row_sum;
+      acc = MultiplyByQuantizedMultiplier(acc, output_multiplier, output_shift);
+      acc += output_offset;
+      result[batch * m_rows + row] =
+          static_cast<int8_t>(ActivationFunctionWithMinMax(
+              acc, output_activation_min, output_activation_max));
+    }
+  }
+}
+
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
     const float* __restrict__ matrix, const uint8_t* __restrict__ ledger,
     int m_rows, int m_cols, const float* __restrict__ vector, int n_batch,
@@ -2328,6 +2390,54 @@ void NeonVectorScalarMultiply(const int8_t* vector, const int v_size,
   }
 }
 
+// Multiplies sixteen int8 values with a scalar and stores the results.
+inline void MultiplyInt8x16ByScalar(const int8x16_t v_i8x16,
+                                    const float32x4_t scale_f32x4,
+                                    float* result) {
+  const int16x8_t v0_i16x8 = vmovl_s8(vget_low_s8(v_i8x16));
+  const int16x8_t v1_i16x8 = vmovl_s8(vget_high_s8(v_i8x16));
+  vst1q_f32(result, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v0_i16x8))),
+                              scale_f32x4));
+  vst1q_f32(result + 4,
+            vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v0_i16x8))),
+                      scale_f32x4));
+  vst1q_f32(result + 8,
+            vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v1_i16x8))),
+                      scale_f32x4));
+  vst1q_f32(result + 12,
+            vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v1_i16x8))),
+                      scale_f32x4));
+}
+
+void NeonInt4VectorScalarMultiply(const int8_t* packed_vector,
+                                  const int v_size, const float scale,
+                                  float* result) {
+  // Each iteration unpacks sixteen bytes into 32 values.
+  const int postamble_start =
+      RoundDownVectors<2 * kInt8ValuesPerNeonVector>(v_size);
+  const float32x4_t scale_f32x4 = vdupq_n_f32(scale);
+  int v = 0;
+  for (; v < postamble_start; v += 2 * kInt8ValuesPerNeonVector) {
+    const int8x16_t packed_i8x16 = vld1q_s8(packed_vector + v / 2);
+    // Sign-extend the lower and upper nibbles with arithmetic shifts.
+    const int8x16_t low_i8x16 = vshrq_n_s8(vshlq_n_s8(packed_i8x16, 4), 4);
+    const int8x16_t high_i8x16 = vshrq_n_s8(packed_i8x16, 4);
+    // Interleave them back into their original order.
+    const int8x16x2_t values = vzipq_s8(low_i8x16, high_i8x16);
+    MultiplyInt8x16ByScalar(values.val[0], scale_f32x4, result + v);
+    MultiplyInt8x16ByScalar(values.val[1], scale_f32x4,
+                            result + v + kInt8ValuesPerNeonVector);
+  }
+
+  // Postamble loop.
+  for (; TFLITE_UNLIKELY(v < v_size); v++) {
+    const uint8_t packed = packed_vector[v / 2];
+    const int8_t value =
+        static_cast<int8_t>((v % 2 == 0) ? packed << 4 : packed & 0xF0) >> 4;
+    result[v] = scale * value;
+  }
+}
+
 // TODO(b/185850916): Consider changing the rounding stragey from "ties to away"
 // to "ties to even" since vcvtnq_s32_f32 is generally more available.
 inline int32x4_t RoundToNearest(const float32x4_t input) {
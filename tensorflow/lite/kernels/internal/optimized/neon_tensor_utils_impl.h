@@ -126,6 +126,16 @@ void NeonSparseMatrixBatchVectorMultiplyAccumulate1x16(
     const int32_t output_activation_min, const int32_t output_activation_max,
     int8_t* __restrict__ result);
 
+// Same as above, but with block pattern 1x4.
+void NeonSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 // Matrix multiplication for quantized values using symmetric quantization.
 // Sparse version.
 void NeonSparseMatrixBatchVectorMultiplyAccumulate(
@@ -146,6 +156,9 @@ void NeonSub1Vector(const int16_t* vector, int v_size, int16_t* result);
 void NeonVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                               float* result);
 
+void NeonInt4VectorScalarMultiply(const int8_t* packed_vector, int v_size,
+                                  float scale, float* result);
+
 // Check if all entries of a vector are zero.
 bool NeonIsZeroVector(const float* vector, int v_size);
 
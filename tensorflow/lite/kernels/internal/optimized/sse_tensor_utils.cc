@@ -655,6 +655,61 @@ void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
   }
 }
 
+namespace {
+
+// Multiplies sixteen int8 values with a scalar and stores the results.
+inline void MultiplyInt8x16ByScalar(const __m128i values_8x16,
+                                    const __m128 scale_f32x4, float* result) {
+  // Sign-extend to 16 bits, then to 32 bits, by duplicating each value into
+  // the upper half of a wider lane and shifting it back down.
+  const __m128i values_lo_16x8 =
+      _mm_srai_epi16(_mm_unpacklo_epi8(values_8x16, values_8x16), 8);
+  const __m128i values_hi_16x8 =
+      _mm_srai_epi16(_mm_unpackhi_epi8(values_8x16, values_8x16), 8);
+  const __m128i values_32x4[4] = {
+      _mm_srai_epi32(_mm_unpacklo_epi16(values_lo_16x8, values_lo_16x8), 16),
+      _mm_srai_epi32(_mm_unpackhi_epi16(values_lo_16x8, values_lo_16x8), 16),
+      _mm_srai_epi32(_mm_unpacklo_epi16(values_hi_16x8, values_hi_16x8), 16),
+      _mm_srai_epi32(_mm_unpackhi_epi16(values_hi_16x8, values_hi_16x8), 16)};
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_ps(result + 4 * i,
+                  _mm_mul_ps(_mm_cvtepi32_ps(values_32x4[i]), scale_f32x4));
+  }
+}
+
+}  // namespace
+
+void SseInt4VectorScalarMultiply(const int8_t* packed_vector, const int v_size,
+                                 const float scale, float* result) {
+  // Each iteration unpacks sixteen bytes into 32 values.
+  static constexpr int kBlockSize = 32;
+  const __m128i nibble_mask = _mm_set1_epi8(0x0F);
+  const __m128i sign_bit = _mm_set1_epi8(0x08);
+  const __m128 scale_f32x4 = _mm_set1_ps(scale);
+  int v = 0;
+  for (; v < (v_size & ~(kBlockSize - 1)); v += kBlockSize) {
+    const __m128i packed_8x16 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(packed_vector + v / 2));
+    __m128i low_8x16 = _mm_and_si128(packed_8x16, nibble_mask);
+    __m128i high_8x16 =
+        _mm_and_si128(_mm_srli_epi16(packed_8x16, 4), nibble_mask);
+    // Sign-extend the nibbles: (x ^ 8) - 8.
+    low_8x16 = _mm_sub_epi8(_mm_xor_si128(low_8x16, sign_bit), sign_bit);
+    high_8x16 = _mm_sub_epi8(_mm_xor_si128(high_8x16, sign_bit), sign_bit);
+    // Interleave them back into their original order.
+    MultiplyInt8x16ByScalar(_mm_unpacklo_epi8(low_8x16, high_8x16),
+                            scale_f32x4, result + v);
+    MultiplyInt8x16ByScalar(_mm_unpackhi_epi8(low_8x16, high_8x16),
+                            scale_f32x4, result + v + kBlockSize / 2);
+  }
+  for (; v < v_size; ++v) {
+    const uint8_t packed = packed_vector[v / 2];
+    const int8_t value =
+        static_cast<int8_t>((v % 2 == 0) ? packed << 4 : packed & 0xF0) >> 4;
+    result[v] = scale * value;
+  }
+}
+
 }  // namespace tensor_utils
 }  // namespace tflite
 
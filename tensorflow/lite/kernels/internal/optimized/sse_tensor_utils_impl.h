@@ -79,6 +79,9 @@ void SseSparseMatrixBatchVectorMultiplyAccumulate(
 void SseReductionSumVector(const int8_t* input_vector, int32_t* output_vector,
                            const int output_size, const int reduction_size);
 
+void SseInt4VectorScalarMultiply(const int8_t* packed_vector, int v_size,
+                                 float scale, float* result);
+
 #endif  // __SSSE3__
 
 }  // namespace tensor_utils
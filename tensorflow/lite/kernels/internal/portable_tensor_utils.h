@@ -240,6 +240,17 @@ void SparseMatrixBatchVectorMultiplyAccumulate1x16(
     const int32_t output_activation_min, const int32_t output_activation_max,
     int8_t* __restrict__ result);
 
+// Same as the function above, but the matrix is a sparse tensor with block
+// pattern 1x4. This function assumes that m_cols is a multiple of 4.
+void SparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 // Same as the function above, but the matrix is stored in block compressed
 // sparse row format with block pattern 1x16 which consists of two arrays:
 //   1. A matrix array stores non-zero blocks of the matrix in row major.
@@ -447,6 +458,11 @@ void Sub1Vector(const int16_t* vector, int v_size, int16_t* result);
 void VectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                           float* result);
 
+// Multiply all elements of a vector of v_size signed int4 values, packed two
+// per byte with the lower nibble first, with a scalar.
+void Int4VectorScalarMultiply(const int8_t* packed_vector, int v_size,
+                              float scale, float* result);
+
 // Reduce-sum on a float input vector:
 // input_vector: float pointer to input vector.
 // output_vector: float pointer to vector.
@@ -96,6 +96,15 @@ void PortableSparseMatrixBatchVectorMultiplyAccumulate1x16(
     const int32_t output_activation_min, const int32_t output_activation_max,
     int8_t* __restrict__ result);
 
+void PortableSparseMatrixBatchVectorMultiplyAccumulate1x4(
+    const int8_t* __restrict__ matrix, const int32_t* __restrict__ segments,
+    const int32_t* __restrict__ indices, int m_rows, int m_cols,
+    const int8_t* __restrict__ vector, const int32_t* __restrict__ bias_vector,
+    int n_batch, const int32_t input_offset, const int32_t output_multiplier,
+    const int32_t output_shift, const int32_t output_offset,
+    const int32_t output_activation_min, const int32_t output_activation_max,
+    int8_t* __restrict__ result);
+
 void PortableSparseMatrixBatchVectorMultiplyAccumulate(
     const int8_t* __restrict__ matrix, const uint8_t* ledger, const int m_rows,
     const int m_cols, const int8_t* __restrict__ vectors,
@@ -203,6 +212,9 @@ void PortableSub1Vector(const int16_t* vector, int v_size, int16_t* result);
 void PortableVectorScalarMultiply(const int8_t* vector, int v_size, float scale,
                                   float* result);
 
+void PortableInt4VectorScalarMultiply(const int8_t* packed_vector, int v_size,
+                                      float scale, float* result);
+
 // Reduce-sum on a vector:
 // input_vector: pointer to input vector.
 // output_vector: pointer to vector.
@@ -78,6 +78,22 @@ TEST(uKernels, VectorScalarMultiply) {
                    0.6,  0.7,  0.8,  0.9,  1.0,  1.1,  1.2,  1.3,  1.4})));
 }
 
+TEST(uKernels, Int4VectorScalarMultiply) {
+  // Large enough to exercise both the vectorized loop and the postamble.
+  constexpr int kVectorSize = 39;
+  std::vector<int8_t> packed((kVectorSize + 1) / 2, 0);
+  std::vector<float> expected(kVectorSize);
+  const float scale = 0.5f;
+  for (int i = 0; i < kVectorSize; ++i) {
+    const int value = i % 16 - 8;
+    packed[i / 2] |= static_cast<int8_t>((value & 0x0F) << (4 * (i % 2)));
+    expected[i] = value * scale;
+  }
+  std::vector<float> output(kVectorSize, 0.0f);
+  Int4VectorScalarMultiply(packed.data(), kVectorSize, scale, output.data());
+  EXPECT_THAT(output, ElementsAreArray(ArrayFloatNear(expected)));
+}
+
 #define ARRAY_SIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
 
 // Test if a float array if full of zero values.
@@ -40,18 +40,31 @@ size_t GetFdSizeBytes(int fd) {
   return fd_stat.st_size;
 }
 
+size_t GetPageSize() {
+#ifdef __ANDROID__
+  static int pagesize = getpagesize();
+#else
+  static int pagesize = sysconf(_SC_PAGE_SIZE);
+#endif
+  return pagesize;
+}
+
 }  // namespace
 
 MMAPAllocation::MMAPAllocation(const char* filename,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, open(filename, O_RDONLY)) {
+    : MMAPAllocation(filename, Options(), error_reporter) {}
+
+MMAPAllocation::MMAPAllocation(const char* filename, const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, open(filename, O_RDONLY), options) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Could not open '%s'.", filename);
   }
 }
 
 MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, dup(fd)) {
+    : MMAPAllocation(error_reporter, dup(fd), Options()) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Failed to dup '%d' file descriptor.",
                          fd);
@@ -60,19 +73,26 @@ MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
 
 MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, dup(fd), offset, length) {
+    : MMAPAllocation(fd, offset, length, Options(), error_reporter) {}
+
+MMAPAllocation::MMAPAllocation(int fd, size_t offset, size_t length,
+                               const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, dup(fd), offset, length, options) {
   if (mmap_fd_ == -1) {
     TF_LITE_REPORT_ERROR(error_reporter, "Failed to dup '%d' file descriptor.",
                          fd);
   }
 }
 
-MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd)
+MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                               const Options& options)
     : MMAPAllocation(error_reporter, owned_fd, /*offset=*/0,
-                     /*length=*/GetFdSizeBytes(owned_fd)) {}
+                     /*length=*/GetFdSizeBytes(owned_fd), options) {}
 
 MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
-                               size_t offset, size_t length)
+                               size_t offset, size_t length,
+                               const Options& options)
     : Allocation(error_reporter, Allocation::Type::kMMap),
       mmap_fd_(owned_fd),
       mmapped_buffer_(MAP_FAILED),
@@ -81,13 +101,7 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
     return;
   }
 
-#ifdef __ANDROID__
-  static int pagesize = getpagesize();
-#else
-  static int pagesize = sysconf(_SC_PAGE_SIZE);
-#endif
-
-  offset_in_buffer_ = offset % pagesize;
+  offset_in_buffer_ = offset % GetPageSize();
 
   size_t file_size = GetFdSizeBytes(mmap_fd_);
   if (length + offset > file_size) {
@@ -98,18 +112,48 @@ MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
     return;
   }
 
-  mmapped_buffer_ =
-      mmap(nullptr, /*__len=*/length + offset_in_buffer_, PROT_READ, MAP_SHARED,
-           mmap_fd_, /*__offset=*/offset - offset_in_buffer_);
+  int flags = MAP_SHARED;
+  // Huge pages must be requested before the mapping is populated, in which
+  // case the pages are touched after the request instead.
+  bool touch_pages = options.prefault;
+#ifdef MAP_POPULATE
+  if (options.prefault && !options.use_huge_pages) {
+    flags |= MAP_POPULATE;
+    touch_pages = false;
+  }
+#endif
+  const size_t mapped_length = length + offset_in_buffer_;
+  mmapped_buffer_ = mmap(nullptr, /*__len=*/mapped_length, PROT_READ, flags,
+                         mmap_fd_, /*__offset=*/offset - offset_in_buffer_);
   if (mmapped_buffer_ == MAP_FAILED) {
     TF_LITE_REPORT_ERROR(error_reporter,
                          "Mmap of '%d' at offset '%d' failed with error '%d'.",
                          mmap_fd_, offset, errno);
     return;
   }
+
+  // The hints below are best-effort, so their failures are ignored.
+  void* mapped = const_cast<void*>(mmapped_buffer_);
+#ifdef MADV_HUGEPAGE
+  if (options.use_huge_pages) {
+    madvise(mapped, mapped_length, MADV_HUGEPAGE);
+  }
+#endif
+  if (options.prefault || options.warm_up_async) {
+    madvise(mapped, mapped_length, MADV_WILLNEED);
+  }
+  if (touch_pages) {
+    TouchPages();
+  } else if (options.warm_up_async && !options.prefault) {
+    warm_up_thread_ = std::thread([this] { TouchPages(); });
+  }
 }
 
 MMAPAllocation::~MMAPAllocation() {
+  if (warm_up_thread_.joinable()) {
+    stop_warm_up_ = true;
+    warm_up_thread_.join();
+  }
   if (valid()) {
     munmap(const_cast<void*>(mmapped_buffer_),
            buffer_size_bytes_ + offset_in_buffer_);
@@ -130,4 +174,16 @@ bool MMAPAllocation::valid() const { return mmapped_buffer_ != MAP_FAILED; }
 
 bool MMAPAllocation::IsSupported() { return true; }
 
+void MMAPAllocation::TouchPages() {
+  const volatile char* data =
+      reinterpret_cast<const volatile char*>(mmapped_buffer_);
+  const size_t mapped_length = buffer_size_bytes_ + offset_in_buffer_;
+  char checksum = 0;
+  for (size_t i = 0; i < mapped_length && !stop_warm_up_;
+       i += GetPageSize()) {
+    checksum ^= data[i];
+  }
+  (void)checksum;
+}
+
 }  // namespace tflite
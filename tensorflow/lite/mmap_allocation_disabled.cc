@@ -21,12 +21,17 @@ namespace tflite {
 
 MMAPAllocation::MMAPAllocation(const char* filename,
                                ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, -1) {}
+    : MMAPAllocation(error_reporter, -1, Options()) {}
+
+MMAPAllocation::MMAPAllocation(const char* filename, const Options& options,
+                               ErrorReporter* error_reporter)
+    : MMAPAllocation(error_reporter, -1, options) {}
 
 MMAPAllocation::MMAPAllocation(int fd, ErrorReporter* error_reporter)
-    : MMAPAllocation(error_reporter, -1) {}
+    : MMAPAllocation(error_reporter, -1, Options()) {}
 
-MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd)
+MMAPAllocation::MMAPAllocation(ErrorReporter* error_reporter, int owned_fd,
+                               const Options& options)
     : Allocation(error_reporter, Allocation::Type::kMMap),
       mmapped_buffer_(nullptr) {
   // The disabled variant should never be created.
@@ -0,0 +1,105 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace tflite {
+namespace profiling {
+
+#ifdef __linux__
+namespace {
+
+constexpr uint64_t kCounterConfigs[] = {
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+constexpr int kNumCounters = sizeof(kCounterConfigs) / sizeof(uint64_t);
+
+// Opens a counter of the calling thread in the group of `group_fd`, or as the
+// leader of a new group if `group_fd` is -1.
+int OpenCounter(uint64_t config, int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = group_fd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, group_fd,
+                 /*flags=*/0);
+}
+
+}  // namespace
+#endif
+
+std::unique_ptr<PerfEventCounters> PerfEventCounters::Create() {
+#ifdef __linux__
+  std::vector<int> fds;
+  for (uint64_t config : kCounterConfigs) {
+    const int fd = OpenCounter(config, fds.empty() ? -1 : fds[0]);
+    if (fd < 0) {
+      for (int opened_fd : fds) close(opened_fd);
+      return nullptr;
+    }
+    fds.push_back(fd);
+  }
+  ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return std::unique_ptr<PerfEventCounters>(
+      new PerfEventCounters(std::move(fds)));
+#else
+  return nullptr;
+#endif
+}
+
+PerfEventCounters::~PerfEventCounters() {
+#ifdef __linux__
+  for (int fd : fds_) close(fd);
+#endif
+}
+
+bool PerfEventCounters::Read(PerfCounterValues* values) const {
+#ifdef __linux__
+  // With PERF_FORMAT_GROUP, the leader reads the number of counters followed
+  // by their values.
+  uint64_t buffer[1 + kNumCounters];
+  if (read(fds_[0], buffer, sizeof(buffer)) != sizeof(buffer) ||
+      buffer[0] != kNumCounters) {
+    return false;
+  }
+  values->instructions = buffer[1];
+  values->cache_misses = buffer[2];
+  values->branch_misses = buffer[3];
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace profiling
+}  // namespace tflite
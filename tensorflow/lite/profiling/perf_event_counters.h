@@ -0,0 +1,81 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
+#define TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace tflite {
+namespace profiling {
+
+// Values of the hardware counters read by `PerfEventCounters`.
+struct PerfCounterValues {
+  int64_t instructions = 0;
+  int64_t cache_misses = 0;
+  int64_t branch_misses = 0;
+
+  PerfCounterValues operator+(const PerfCounterValues& obj) const {
+    PerfCounterValues res;
+    res.instructions = instructions + obj.instructions;
+    res.cache_misses = cache_misses + obj.cache_misses;
+    res.branch_misses = branch_misses + obj.branch_misses;
+    return res;
+  }
+
+  PerfCounterValues operator-(const PerfCounterValues& obj) const {
+    PerfCounterValues res;
+    res.instructions = instructions - obj.instructions;
+    res.cache_misses = cache_misses - obj.cache_misses;
+    res.branch_misses = branch_misses - obj.branch_misses;
+    return res;
+  }
+};
+
+// Counts the instructions, cache misses and branch misses of the calling
+// thread with the Linux perf events interface. Threads created by the calling
+// thread, like the worker threads of the CPU backend, are not counted.
+// This class is *not thread safe*, and must be used on the thread that created
+// it.
+class PerfEventCounters {
+ public:
+  // Returns nullptr if the counters are not supported on this platform, or if
+  // they can't be opened, e.g. because of the value of
+  // /proc/sys/kernel/perf_event_paranoid.
+  static std::unique_ptr<PerfEventCounters> Create();
+
+  ~PerfEventCounters();
+
+  // Reads the current values of the counters. Returns false on failure.
+  bool Read(PerfCounterValues* values) const;
+
+ private:
+  explicit PerfEventCounters(std::vector<int> fds) : fds_(std::move(fds)) {}
+
+  PerfEventCounters(const PerfEventCounters&) = delete;
+  PerfEventCounters& operator=(const PerfEventCounters&) = delete;
+
+  // File descriptors of the counters, in the order of the fields of
+  // `PerfCounterValues`. The first one is the leader of the group, which reads
+  // all the counters at once.
+  const std::vector<int> fds_;
+};
+
+}  // namespace profiling
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_PROFILING_PERF_EVENT_COUNTERS_H_
@@ -0,0 +1,65 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace profiling {
+namespace {
+
+TEST(PerfCounterValues, AddAndSub) {
+  PerfCounterValues values1, values2;
+  values1.instructions = 1000;
+  values1.cache_misses = 20;
+  values1.branch_misses = 3;
+
+  values2.instructions = 400;
+  values2.cache_misses = 30;
+  values2.branch_misses = 1;
+
+  const auto add_values = values1 + values2;
+  EXPECT_EQ(1400, add_values.instructions);
+  EXPECT_EQ(50, add_values.cache_misses);
+  EXPECT_EQ(4, add_values.branch_misses);
+
+  const auto sub_values = values1 - values2;
+  EXPECT_EQ(600, sub_values.instructions);
+  EXPECT_EQ(-10, sub_values.cache_misses);
+  EXPECT_EQ(2, sub_values.branch_misses);
+}
+
+TEST(PerfEventCounters, CountsInstructions) {
+  auto counters = PerfEventCounters::Create();
+#ifndef __linux__
+  EXPECT_EQ(counters, nullptr);
+#endif
+  if (counters == nullptr) {
+    // Hardware counters may not be available, e.g. in virtual machines.
+    GTEST_SKIP();
+  }
+  PerfCounterValues begin, end;
+  ASSERT_TRUE(counters->Read(&begin));
+  volatile int sum = 0;
+  for (int i = 0; i < 100000; ++i) sum += i;
+  ASSERT_TRUE(counters->Read(&end));
+  EXPECT_GT(end.instructions, begin.instructions);
+  EXPECT_GE(end.cache_misses, begin.cache_misses);
+  EXPECT_GE(end.branch_misses, begin.branch_misses);
+}
+
+}  // namespace
+}  // namespace profiling
+}  // namespace tflite
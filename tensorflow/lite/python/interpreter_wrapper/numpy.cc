@@ -67,6 +67,8 @@ int TfLiteTypeToPyArrayType(TfLiteType tf_lite_type) {
     case kTfLiteResource:
     case kTfLiteVariant:
       return NPY_OBJECT;
+    case kTfLiteInt4:
+      // Packed int4 data has no numpy equivalent.
     case kTfLiteNoType:
       return NPY_NOTYPE;
       // Avoid default so compiler errors created when new types are made.
@@ -105,6 +105,8 @@ inline TensorType TfLiteTypeToSchemaType(TfLiteType type) {
       return TensorType_RESOURCE;
     case kTfLiteVariant:
       return TensorType_VARIANT;
+    case kTfLiteInt4:
+      return TensorType_INT4;
   }
   // No default to get compiler error when new type is introduced.
 }
@@ -93,6 +93,28 @@ class SimpleMemoryArena {
                             const ArenaAllocWithUsageInterval& alloc,
                             char** output_ptr);
 
+  // The allocations of the arena, which can be saved after planning and
+  // restored later to avoid planning the same allocations again.
+  struct Plan {
+    std::vector<ArenaAllocWithUsageInterval> ordered_allocs;
+    size_t high_water_mark = 0;
+  };
+
+  Plan GetPlan() const { return Plan{ordered_allocs_, high_water_mark_}; }
+
+  // Replaces the allocation details by `plan`. As after ClearPlan(), the arena
+  // should be committed & resolved before using it again.
+  void SetPlan(const Plan& plan) {
+    committed_ = false;
+    ordered_allocs_ = plan.ordered_allocs;
+    high_water_mark_ = plan.high_water_mark;
+  }
+
+  // Returns true if no allocation was made since the last ClearPlan().
+  bool IsPlanEmpty() const {
+    return ordered_allocs_.empty() && high_water_mark_ == 0;
+  }
+
   // This clears allocation details but does not release the underlying buffer.
   // New allocations should be committed & resolved before using this arena
   // again.
@@ -59,6 +59,8 @@ BenchmarkParams BenchmarkModel::DefaultParams() {
   params.AddParam("run_frequency", BenchmarkParam::Create<float>(-1.0f));
   params.AddParam("num_threads", BenchmarkParam::Create<int32_t>(-1));
   params.AddParam("use_caching", BenchmarkParam::Create<bool>(false));
+  params.AddParam("prepacked_cache_max_mb",
+                  BenchmarkParam::Create<int32_t>(0));
   params.AddParam("benchmark_name", BenchmarkParam::Create<std::string>(""));
   params.AddParam("output_prefix", BenchmarkParam::Create<std::string>(""));
   params.AddParam("warmup_runs", BenchmarkParam::Create<int32_t>(1));
@@ -139,6 +141,10 @@ std::vector<Flag> BenchmarkModel::GetFlags() {
           "Enable caching of prepacked weights matrices in matrix "
           "multiplication routines. Currently implies the use of the Ruy "
           "library."),
+      CreateFlag<int32_t>(
+          "prepacked_cache_max_mb", &params_,
+          "Cap, in MB, on the size of the cached prepacked weights matrices. "
+          "If positive, implies --use_caching. 0 means no cap."),
       CreateFlag<std::string>("benchmark_name", &params_, "benchmark name"),
       CreateFlag<std::string>("output_prefix", &params_,
                               "benchmark output prefix"),
@@ -185,6 +191,8 @@ void BenchmarkModel::LogParams() {
                       "Number of prorated runs per second", verbose);
   LOG_BENCHMARK_PARAM(int32_t, "num_threads", "Num threads", verbose);
   LOG_BENCHMARK_PARAM(bool, "use_caching", "Use caching", verbose);
+  LOG_BENCHMARK_PARAM(int32_t, "prepacked_cache_max_mb",
+                      "Prepacked cache cap (MB)", verbose);
   LOG_BENCHMARK_PARAM(std::string, "benchmark_name", "Benchmark name", verbose);
   LOG_BENCHMARK_PARAM(std::string, "output_prefix", "Output prefix", verbose);
   LOG_BENCHMARK_PARAM(int32_t, "warmup_runs", "Min warmup runs", verbose);
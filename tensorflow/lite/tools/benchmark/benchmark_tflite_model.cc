@@ -46,6 +46,7 @@ limitations under the License.
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #include "tensorflow/lite/string_util.h"
 #include "tensorflow/lite/tools/benchmark/benchmark_utils.h"
+#include "tensorflow/lite/tools/benchmark/op_stats_listener.h"
 #include "tensorflow/lite/tools/benchmark/profiling_listener.h"
 #include "tensorflow/lite/tools/delegates/delegate_provider.h"
 #include "tensorflow/lite/tools/logging.h"
@@ -357,6 +358,10 @@ BenchmarkParams BenchmarkTfLiteModel::DefaultParams() {
                           BenchmarkParam::Create<bool>(false));
   default_params.AddParam("profiling_output_csv_file",
                           BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("op_stats_csv_file",
+                          BenchmarkParam::Create<std::string>(""));
+  default_params.AddParam("op_stats_chrome_trace_file",
+                          BenchmarkParam::Create<std::string>(""));
 
   default_params.AddParam("print_preinvoke_state",
                           BenchmarkParam::Create<bool>(false));
@@ -430,6 +435,14 @@ std::vector<Flag> BenchmarkTfLiteModel::GetFlags() {
           "profiling_output_csv_file", &params_,
           "File path to export profile data as CSV, if not set "
           "prints to stdout."),
+      CreateFlag<std::string>(
+          "op_stats_csv_file", &params_,
+          "File path to export per-op memory usage and hardware counters as "
+          "CSV."),
+      CreateFlag<std::string>(
+          "op_stats_chrome_trace_file", &params_,
+          "File path to export the per-op memory usage and hardware counters "
+          "of the last run as a Chrome trace."),
       CreateFlag<bool>(
           "print_preinvoke_state", &params_,
           "print out the interpreter internals just before calling Invoke. The "
@@ -482,6 +495,10 @@ void BenchmarkTfLiteModel::LogParams() {
                       verbose);
   LOG_BENCHMARK_PARAM(std::string, "profiling_output_csv_file",
                       "CSV File to export profiling data to", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "op_stats_csv_file",
+                      "CSV file to export op stats to", verbose);
+  LOG_BENCHMARK_PARAM(std::string, "op_stats_chrome_trace_file",
+                      "Chrome trace file to export op stats to", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_preinvoke_state",
                       "Print pre-invoke interpreter state", verbose);
   LOG_BENCHMARK_PARAM(bool, "print_postinvoke_state",
@@ -659,7 +676,10 @@ TfLiteStatus BenchmarkTfLiteModel::ResetInputsAndOutputs() {
 TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
   auto resolver = GetOpResolver();
   const int32_t num_threads = params_.Get<int32_t>("num_threads");
-  const bool use_caching = params_.Get<bool>("use_caching");
+  const int32_t prepacked_cache_max_mb =
+      params_.Get<int32_t>("prepacked_cache_max_mb");
+  const bool use_caching =
+      params_.Get<bool>("use_caching") || prepacked_cache_max_mb > 0;
 
   tflite::InterpreterBuilder builder(*model_, *resolver);
   if (builder.SetNumThreads(num_threads) != kTfLiteOk) {
@@ -678,6 +698,10 @@ TfLiteStatus BenchmarkTfLiteModel::InitInterpreter() {
     std::unique_ptr<tflite::CpuBackendContext> cpu_backend_context(
         new tflite::CpuBackendContext());
     cpu_backend_context->SetUseCaching(true);
+    if (prepacked_cache_max_mb > 0) {
+      cpu_backend_context->SetPrepackedCacheMaxBytes(
+          static_cast<size_t>(prepacked_cache_max_mb) << 20);
+    }
     cpu_backend_context->SetMaxNumThreads(num_threads);
     external_context_->set_internal_backend_context(
         std::move(cpu_backend_context));
@@ -709,6 +733,7 @@ TfLiteStatus BenchmarkTfLiteModel::Init() {
   }
 
   AddOwnedListener(MayCreateProfilingListener());
+  AddOwnedListener(MayCreateOpStatsListener());
   AddOwnedListener(std::unique_ptr<BenchmarkListener>(
       new InterpreterStatePrinter(interpreter_.get())));
 
@@ -883,6 +908,17 @@ BenchmarkTfLiteModel::MayCreateProfilingListener() const {
           !params_.Get<std::string>("profiling_output_csv_file").empty())));
 }
 
+std::unique_ptr<BenchmarkListener>
+BenchmarkTfLiteModel::MayCreateOpStatsListener() const {
+  const std::string csv_file = params_.Get<std::string>("op_stats_csv_file");
+  const std::string chrome_trace_file =
+      params_.Get<std::string>("op_stats_chrome_trace_file");
+  if (csv_file.empty() && chrome_trace_file.empty()) return nullptr;
+
+  return std::unique_ptr<BenchmarkListener>(
+      new OpStatsListener(interpreter_.get(), csv_file, chrome_trace_file));
+}
+
 TfLiteStatus BenchmarkTfLiteModel::RunImpl() { return interpreter_->Invoke(); }
 
 }  // namespace benchmark
@@ -102,6 +102,10 @@ class BenchmarkTfLiteModel : public BenchmarkModel {
   // necessary.
   virtual std::unique_ptr<BenchmarkListener> MayCreateProfilingListener() const;
 
+  // Create a BenchmarkListener that collects per-op memory usage and hardware
+  // counters if necessary.
+  std::unique_ptr<BenchmarkListener> MayCreateOpStatsListener() const;
+
   void CleanUp();
 
   utils::InputTensorData LoadInputTensorData(
@@ -0,0 +1,267 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/benchmark/op_stats_listener.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/profiling/time.h"
+#include "tensorflow/lite/tools/logging.h"
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+constexpr uint32_t kInvalidEventHandle = static_cast<uint32_t>(~0);
+
+// Returns `str` quoted as a JSON string.
+std::string JsonQuote(const std::string& str) {
+  std::string result = "\"";
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      result += escaped;
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+}  // namespace
+
+// Records the memory usage and hardware counters at the beginning and end of
+// each op invocation.
+class OpStatsListener::OpStatsProfiler : public Profiler {
+ public:
+  OpStatsProfiler() : counters_(profiling::PerfEventCounters::Create()) {}
+
+  bool has_counters() const { return counters_ != nullptr; }
+  bool enabled() const { return enabled_; }
+  const std::vector<OpEvent>& events() const { return events_; }
+
+  void StartProfiling() {
+    events_.clear();
+    enabled_ = true;
+  }
+  void StopProfiling() { enabled_ = false; }
+
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override {
+    if (!enabled_ || event_type != EventType::OPERATOR_INVOKE_EVENT) {
+      return kInvalidEventHandle;
+    }
+    events_.emplace_back();
+    OpEvent& event = events_.back();
+    event.name = tag ? tag : "";
+    event.node_index = event_metadata1;
+    event.subgraph_index = event_metadata2;
+    event.begin_mem = profiling::memory::GetMemoryUsage();
+    ReadCounters(&event.begin_counters);
+    // Read the time last and first, so that it excludes the other reads.
+    event.begin_us = profiling::time::NowMicros();
+    return events_.size() - 1;
+  }
+
+  void EndEvent(uint32_t event_handle) override {
+    if (event_handle >= events_.size()) return;
+    OpEvent& event = events_[event_handle];
+    event.end_us = profiling::time::NowMicros();
+    ReadCounters(&event.end_counters);
+    event.end_mem = profiling::memory::GetMemoryUsage();
+  }
+
+ private:
+  void ReadCounters(profiling::PerfCounterValues* values) {
+    if (counters_ && !counters_->Read(values)) {
+      TFLITE_LOG(WARN) << "Failed to read the hardware counters.";
+      counters_.reset();
+    }
+  }
+
+  std::unique_ptr<profiling::PerfEventCounters> counters_;
+  bool enabled_ = false;
+  std::vector<OpEvent> events_;
+};
+
+OpStatsListener::OpStatsListener(Interpreter* interpreter,
+                                 const std::string& csv_file_path,
+                                 const std::string& chrome_trace_file_path)
+    : interpreter_(interpreter),
+      csv_file_path_(csv_file_path),
+      chrome_trace_file_path_(chrome_trace_file_path),
+      profiler_(new OpStatsProfiler()) {
+  TFLITE_TOOLS_CHECK(interpreter);
+  if (!profiler_->has_counters()) {
+    TFLITE_LOG(INFO) << "Hardware counters are not available, op stats only "
+                        "include time and memory usage.";
+  }
+  interpreter_->AddProfiler(profiler_.get());
+}
+
+OpStatsListener::~OpStatsListener() = default;
+
+void OpStatsListener::OnSingleRunStart(RunType run_type) {
+  if (run_type == REGULAR) {
+    profiler_->StartProfiling();
+  }
+}
+
+void OpStatsListener::OnSingleRunEnd() {
+  if (!profiler_->enabled()) return;
+  profiler_->StopProfiling();
+  for (const OpEvent& event : profiler_->events()) {
+    OpStats& stats = stats_[{event.subgraph_index, event.node_index}];
+    if (stats.count == 0) {
+      stats.name = event.name;
+      SetArenaBytes(event.subgraph_index, event.node_index, &stats);
+    }
+    ++stats.count;
+    stats.total_us += event.end_us - event.begin_us;
+    stats.rss_delta_kb += event.end_mem.max_rss_kb - event.begin_mem.max_rss_kb;
+    stats.max_heap_delta_bytes = std::max(
+        stats.max_heap_delta_bytes,
+        static_cast<int64_t>(event.end_mem.in_use_allocated_bytes) -
+            static_cast<int64_t>(event.begin_mem.in_use_allocated_bytes));
+    stats.counters =
+        stats.counters + (event.end_counters - event.begin_counters);
+  }
+  last_run_events_ = profiler_->events();
+}
+
+void OpStatsListener::OnBenchmarkEnd(const BenchmarkResults& results) {
+  if (stats_.empty()) return;
+  if (!csv_file_path_.empty()) {
+    std::ofstream csv_file(csv_file_path_);
+    if (csv_file.good()) {
+      WriteCsv(stats_, profiler_->has_counters(), &csv_file);
+      TFLITE_LOG(INFO) << "Op stats written to " << csv_file_path_;
+    } else {
+      TFLITE_LOG(ERROR) << "Failed to open " << csv_file_path_;
+    }
+  }
+  if (!chrome_trace_file_path_.empty()) {
+    std::ofstream trace_file(chrome_trace_file_path_);
+    if (trace_file.good()) {
+      WriteChromeTrace(last_run_events_, profiler_->has_counters(),
+                       &trace_file);
+      TFLITE_LOG(INFO) << "Op trace written to " << chrome_trace_file_path_;
+    } else {
+      TFLITE_LOG(ERROR) << "Failed to open " << chrome_trace_file_path_;
+    }
+  }
+}
+
+void OpStatsListener::SetArenaBytes(int64_t subgraph_index, int64_t node_index,
+                                    OpStats* stats) const {
+  Subgraph* subgraph = interpreter_->subgraph(subgraph_index);
+  if (subgraph == nullptr) return;
+  const auto* node_and_registration =
+      subgraph->node_and_registration(node_index);
+  if (node_and_registration == nullptr) return;
+  auto arena_bytes = [subgraph](const TfLiteIntArray* tensor_indices) {
+    int64_t bytes = 0;
+    if (tensor_indices == nullptr) return bytes;
+    for (int i = 0; i < tensor_indices->size; ++i) {
+      const TfLiteTensor* tensor = subgraph->tensor(tensor_indices->data[i]);
+      if (tensor != nullptr && (tensor->allocation_type == kTfLiteArenaRw ||
+                                tensor->allocation_type ==
+                                    kTfLiteArenaRwPersistent)) {
+        bytes += tensor->bytes;
+      }
+    }
+    return bytes;
+  };
+  const TfLiteNode& node = node_and_registration->first;
+  stats->arena_output_bytes = arena_bytes(node.outputs);
+  stats->arena_temporary_bytes = arena_bytes(node.temporaries);
+}
+
+void OpStatsListener::WriteCsv(
+    const std::map<std::pair<int64_t, int64_t>, OpStats>& stats,
+    bool has_counters, std::ostream* stream) {
+  *stream << "subgraph_index,node_index,op_name,count,avg_time_us,"
+             "arena_output_bytes,arena_temporary_bytes,avg_rss_delta_kb,"
+             "max_heap_delta_bytes";
+  if (has_counters) {
+    *stream << ",avg_instructions,avg_cache_misses,avg_branch_misses,"
+               "cache_misses_per_kilo_instruction";
+  }
+  *stream << "\n";
+  for (const auto& key_and_stats : stats) {
+    const OpStats& op_stats = key_and_stats.second;
+    const double count = std::max<int64_t>(op_stats.count, 1);
+    *stream << key_and_stats.first.first << "," << key_and_stats.first.second
+            << "," << op_stats.name << "," << op_stats.count << ","
+            << op_stats.total_us / count << "," << op_stats.arena_output_bytes
+            << "," << op_stats.arena_temporary_bytes << ","
+            << op_stats.rss_delta_kb / count << ","
+            << op_stats.max_heap_delta_bytes;
+    if (has_counters) {
+      const profiling::PerfCounterValues& counters = op_stats.counters;
+      *stream << "," << counters.instructions / count << ","
+              << counters.cache_misses / count << ","
+              << counters.branch_misses / count << ","
+              << (counters.instructions > 0
+                      ? 1000.0 * counters.cache_misses / counters.instructions
+                      : 0.0);
+    }
+    *stream << "\n";
+  }
+}
+
+void OpStatsListener::WriteChromeTrace(const std::vector<OpEvent>& events,
+                                       bool has_counters,
+                                       std::ostream* stream) {
+  const uint64_t start_us = events.empty() ? 0 : events.front().begin_us;
+  *stream << "{\"traceEvents\":[";
+  for (int i = 0; i < events.size(); ++i) {
+    const OpEvent& event = events[i];
+    const profiling::PerfCounterValues counters =
+        event.end_counters - event.begin_counters;
+    *stream << (i == 0 ? "\n" : ",\n") << "{\"name\":" << JsonQuote(event.name)
+            << ",\"cat\":\"op\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+            << event.subgraph_index << ",\"ts\":" << event.begin_us - start_us
+            << ",\"dur\":" << event.end_us - event.begin_us
+            << ",\"args\":{\"node_index\":" << event.node_index
+            << ",\"rss_delta_kb\":"
+            << event.end_mem.max_rss_kb - event.begin_mem.max_rss_kb
+            << ",\"heap_delta_bytes\":"
+            << static_cast<int64_t>(event.end_mem.in_use_allocated_bytes) -
+                   static_cast<int64_t>(event.begin_mem.in_use_allocated_bytes);
+    if (has_counters) {
+      *stream << ",\"instructions\":" << counters.instructions
+              << ",\"cache_misses\":" << counters.cache_misses
+              << ",\"branch_misses\":" << counters.branch_misses;
+    }
+    *stream << "}}";
+  }
+  *stream << "\n]}\n";
+}
+
+}  // namespace benchmark
+}  // namespace tflite
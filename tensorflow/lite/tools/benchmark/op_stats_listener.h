@@ -0,0 +1,112 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_STATS_LISTENER_H_
+#define TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_STATS_LISTENER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/profiling/memory_info.h"
+#include "tensorflow/lite/profiling/perf_event_counters.h"
+#include "tensorflow/lite/tools/benchmark/benchmark_model.h"
+
+namespace tflite {
+namespace benchmark {
+
+// Collects per-op memory statistics and hardware counters during the regular
+// benchmark runs, to find memory-bound kernels and compare model versions.
+// For each op, it records the arena bytes of its outputs and temporaries, the
+// peak RSS and heap deltas, and, where the Linux perf events interface is
+// available, the instructions, cache misses and branch misses of the thread
+// that invokes the interpreter.
+//
+// At the end of the benchmark, the statistics averaged over the runs are
+// written as CSV to `csv_file_path`, and the ops of the last run are written
+// as a Chrome trace (viewable in chrome://tracing or Perfetto) to
+// `chrome_trace_file_path`. Empty paths disable the corresponding output.
+class OpStatsListener : public BenchmarkListener {
+ public:
+  OpStatsListener(Interpreter* interpreter, const std::string& csv_file_path,
+                  const std::string& chrome_trace_file_path);
+  ~OpStatsListener() override;
+
+  void OnSingleRunStart(RunType run_type) override;
+
+  void OnSingleRunEnd() override;
+
+  void OnBenchmarkEnd(const BenchmarkResults& results) override;
+
+  // Measurements of one invocation of an op.
+  struct OpEvent {
+    std::string name;
+    int64_t subgraph_index = 0;
+    int64_t node_index = 0;
+    uint64_t begin_us = 0;
+    uint64_t end_us = 0;
+    profiling::memory::MemoryUsage begin_mem;
+    profiling::memory::MemoryUsage end_mem;
+    profiling::PerfCounterValues begin_counters;
+    profiling::PerfCounterValues end_counters;
+  };
+
+  // Statistics of an op accumulated over the runs.
+  struct OpStats {
+    std::string name;
+    int64_t count = 0;
+    uint64_t total_us = 0;
+    int64_t arena_output_bytes = 0;
+    int64_t arena_temporary_bytes = 0;
+    // Sum of the deltas of the peak RSS, which only grows.
+    int64_t rss_delta_kb = 0;
+    int64_t max_heap_delta_bytes = 0;
+    profiling::PerfCounterValues counters;
+  };
+
+  // Writes `stats`, keyed by (subgraph index, node index), as CSV.
+  static void WriteCsv(
+      const std::map<std::pair<int64_t, int64_t>, OpStats>& stats,
+      bool has_counters, std::ostream* stream);
+
+  // Writes `events` in the Chrome trace event format.
+  static void WriteChromeTrace(const std::vector<OpEvent>& events,
+                               bool has_counters, std::ostream* stream);
+
+ private:
+  class OpStatsProfiler;
+
+  // Sets the arena bytes of `stats` from the tensors of its node.
+  void SetArenaBytes(int64_t subgraph_index, int64_t node_index,
+                     OpStats* stats) const;
+
+  Interpreter* const interpreter_;
+  const std::string csv_file_path_;
+  const std::string chrome_trace_file_path_;
+  std::unique_ptr<OpStatsProfiler> profiler_;
+  std::map<std::pair<int64_t, int64_t>, OpStats> stats_;
+  // The ops of the last regular run.
+  std::vector<OpEvent> last_run_events_;
+};
+
+}  // namespace benchmark
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_TOOLS_BENCHMARK_OP_STATS_LISTENER_H_
@@ -0,0 +1,91 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/tools/benchmark/op_stats_listener.h"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace tflite {
+namespace benchmark {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+TEST(OpStatsListenerTest, WriteCsv) {
+  std::map<std::pair<int64_t, int64_t>, OpStatsListener::OpStats> stats;
+  OpStatsListener::OpStats& conv = stats[{0, 1}];
+  conv.name = "CONV_2D";
+  conv.count = 2;
+  conv.total_us = 300;
+  conv.arena_output_bytes = 4096;
+  conv.arena_temporary_bytes = 1024;
+  conv.rss_delta_kb = 8;
+  conv.max_heap_delta_bytes = 16;
+  conv.counters.instructions = 20000;
+  conv.counters.cache_misses = 100;
+  conv.counters.branch_misses = 10;
+
+  std::stringstream stream;
+  OpStatsListener::WriteCsv(stats, /*has_counters=*/true, &stream);
+  std::string header, row;
+  std::getline(stream, header);
+  std::getline(stream, row);
+  EXPECT_EQ(header,
+            "subgraph_index,node_index,op_name,count,avg_time_us,"
+            "arena_output_bytes,arena_temporary_bytes,avg_rss_delta_kb,"
+            "max_heap_delta_bytes,avg_instructions,avg_cache_misses,"
+            "avg_branch_misses,cache_misses_per_kilo_instruction");
+  EXPECT_EQ(row, "0,1,CONV_2D,2,150,4096,1024,4,16,10000,50,5,5");
+
+  std::stringstream no_counters_stream;
+  OpStatsListener::WriteCsv(stats, /*has_counters=*/false,
+                            &no_counters_stream);
+  EXPECT_THAT(no_counters_stream.str(), Not(HasSubstr("instructions")));
+}
+
+TEST(OpStatsListenerTest, WriteChromeTrace) {
+  std::vector<OpStatsListener::OpEvent> events(2);
+  events[0].name = "ADD";
+  events[0].node_index = 0;
+  events[0].begin_us = 1000;
+  events[0].end_us = 1010;
+  events[1].name = "my\"op";
+  events[1].node_index = 1;
+  events[1].begin_us = 1010;
+  events[1].end_us = 1030;
+  events[1].begin_counters.cache_misses = 5;
+  events[1].end_counters.cache_misses = 12;
+
+  std::stringstream stream;
+  OpStatsListener::WriteChromeTrace(events, /*has_counters=*/true, &stream);
+  const std::string trace = stream.str();
+  EXPECT_THAT(trace, HasSubstr("{\"traceEvents\":["));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"ADD\",\"cat\":\"op\",\"ph\":\"X\","
+                               "\"pid\":0,\"tid\":0,\"ts\":0,\"dur\":10"));
+  EXPECT_THAT(trace, HasSubstr("\"name\":\"my\\\"op\""));
+  EXPECT_THAT(trace, HasSubstr("\"ts\":10,\"dur\":20"));
+  EXPECT_THAT(trace, HasSubstr("\"cache_misses\":7"));
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace tflite
@@ -18,10 +18,31 @@ limitations under the License.
 #include <fstream>
 #include <string>
 
+#include "tensorflow/lite/external_cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/tools/logging.h"
 
 namespace tflite {
 namespace benchmark {
+namespace {
+
+// Returns the CPU backend context of `interpreter` if it caches prepacked
+// matrices, or nullptr.
+const CpuBackendContext* GetCachingCpuBackendContext(Interpreter* interpreter) {
+  TfLiteContext* context = interpreter->primary_subgraph().context();
+  auto* external_context = static_cast<ExternalCpuBackendContext*>(
+      context->GetExternalContext(context, kTfLiteCpuBackendContext));
+  if (external_context == nullptr) return nullptr;
+  // The internal backend context is always a `CpuBackendContext`.
+  const auto* cpu_backend_context = static_cast<const CpuBackendContext*>(
+      external_context->internal_backend_context());
+  if (cpu_backend_context == nullptr || !cpu_backend_context->use_caching()) {
+    return nullptr;
+  }
+  return cpu_backend_context;
+}
+
+}  // namespace
 
 ProfilingListener::ProfilingListener(
     Interpreter* interpreter, uint32_t max_num_initial_entries,
@@ -81,6 +102,14 @@ void ProfilingListener::OnBenchmarkEnd(const BenchmarkResults& results) {
                 run_summarizer_.GetOutputString(),
                 output_stream == nullptr ? &TFLITE_LOG(INFO) : output_stream);
   }
+  if (const CpuBackendContext* cpu_backend_context =
+          GetCachingCpuBackendContext(interpreter_)) {
+    const CpuBackendContext::PrepackedCacheStats& stats =
+        cpu_backend_context->prepacked_cache_stats();
+    TFLITE_LOG(INFO) << "Prepacked matrix cache: " << stats.hits << " hits, "
+                     << stats.misses << " misses, " << stats.bypasses
+                     << " bypasses, " << stats.bytes << " bytes cached.";
+  }
 }
 
 void ProfilingListener::WriteOutput(const std::string& header,
@@ -609,6 +609,53 @@ TfLiteStatus SymmetricQuantizeTensorPerChannel(ModelT* model, TensorT* tensor,
                                model, tensor, error_reporter);
 }
 
+TfLiteStatus SymmetricQuantizeTensorPerRowInt4(ModelT* model, TensorT* tensor,
+                                               ErrorReporter* error_reporter) {
+  if (tensor->shape.size() != 2) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter,
+        "SymmetricQuantizeTensorPerRowInt4 requires a 2D tensor, but got %d "
+        "dimension(s).",
+        tensor->shape.size());
+    return kTfLiteError;
+  }
+  const int32_t rows = tensor->shape[0];
+  const int32_t cols = tensor->shape[1];
+  const int32_t row_bytes = (cols + 1) / 2;
+
+  const BufferT* buffer = model->buffers[tensor->buffer].get();
+  const float* float_input_data =
+      reinterpret_cast<const float*>(buffer->data.data());
+
+  // Like int8, the quantized range is symmetric and does not use the lowest
+  // value.
+  const int32_t kMaxInt4 = 7;
+  std::vector<float> scales(rows);
+  std::vector<uint8_t> final_buffer(rows * row_bytes, 0);
+  for (int32_t row = 0; row < rows; ++row) {
+    const float* row_data = float_input_data + row * cols;
+    float max_abs = 0;
+    for (int32_t col = 0; col < cols; ++col) {
+      max_abs = std::max(max_abs, std::abs(row_data[col]));
+    }
+    scales[row] = max_abs / kMaxInt4;
+    const float scaling_factor_inv = max_abs == 0 ? 0 : kMaxInt4 / max_abs;
+    for (int32_t col = 0; col < cols; ++col) {
+      const int32_t quantized_value = std::min(
+          kMaxInt4,
+          std::max(-kMaxInt4, static_cast<int32_t>(TfLiteRound(
+                                  row_data[col] * scaling_factor_inv))));
+      final_buffer[row * row_bytes + col / 2] |= (quantized_value & 0x0F)
+                                                 << (4 * (col % 2));
+    }
+  }
+
+  std::vector<int64_t> zero_point(scales.size(), 0);
+  return AddQuantizationParams(scales, zero_point, /*quantized_dimension=*/0,
+                               final_buffer.data(), final_buffer.size(),
+                               TensorType_INT4, model, tensor, error_reporter);
+}
+
 template <class BiasType>
 std::vector<BiasType> SymmetricBiasQuantize(const float* data,
                                             uint64_t num_elements,
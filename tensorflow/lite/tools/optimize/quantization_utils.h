@@ -108,6 +108,12 @@ TfLiteStatus SymmetricQuantizeTensorPerChannel(ModelT* model, TensorT* tensor,
                                                int32_t channel_dim_index,
                                                ErrorReporter* error_reporter);
 
+// Quantizes a 2D tensor to int4 with one symmetric scale per row. Values are
+// packed two per byte with the lower nibble first, and each row is padded to a
+// whole byte.
+TfLiteStatus SymmetricQuantizeTensorPerRowInt4(ModelT* model, TensorT* tensor,
+                                               ErrorReporter* error_reporter);
+
 // Symmetrically quantizes float to 16bits.
 TfLiteStatus SymmetricQuantizeFloatsToInt16(ModelT* model, TensorT* tensor,
                                             float scaling_factor,
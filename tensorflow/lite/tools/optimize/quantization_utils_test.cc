@@ -713,6 +713,44 @@ TEST_F(QuantizationUtilsTest, QuantizeFloat16) {
   EXPECT_EQ(quant_buffer_size * 2, float_buffer_size);
 }
 
+TEST_F(QuantizationUtilsTest, SymmetricQuantizeTensorPerRowInt4) {
+  auto model = std::make_unique<ModelT>();
+  auto subgraph = std::make_unique<tflite::SubGraphT>();
+  auto tensor = std::make_unique<TensorT>();
+  auto buffer = std::make_unique<tflite::BufferT>();
+  // Rows have an odd number of columns, so each is padded to a whole byte.
+  const std::vector<float> weights = {-3.5, 1.0, 0.5,  // Row 0
+                                      0.0,  0.0, 0.0,  // Row 1
+                                      0.6,  1.4, -0.2};
+  auto weights_reinterpreted_data =
+      reinterpret_cast<const unsigned char*>(weights.data());
+  buffer->data.assign(weights_reinterpreted_data,
+                      weights_reinterpreted_data + weights.size() * 4);
+  tensor->buffer = 0;
+  tensor->shape = {3, 3};
+
+  // Wire the model.
+  model->subgraphs.push_back(std::move(subgraph));
+  model->subgraphs[0]->tensors.push_back(std::move(tensor));
+  model->buffers.push_back(std::move(buffer));
+
+  // Call and verify.
+  TensorT* quantized_tensor = model->subgraphs[0]->tensors[0].get();
+  EXPECT_EQ(SymmetricQuantizeTensorPerRowInt4(model.get(), quantized_tensor,
+                                              &error_reporter_),
+            kTfLiteOk);
+  EXPECT_EQ(quantized_tensor->type, TensorType_INT4);
+  EXPECT_EQ(quantized_tensor->quantization->quantized_dimension, 0);
+  const std::vector<float>& scales = quantized_tensor->quantization->scale;
+  ASSERT_EQ(scales.size(), 3);
+  EXPECT_FLOAT_EQ(scales[0], 0.5);
+  EXPECT_FLOAT_EQ(scales[1], 0);
+  EXPECT_FLOAT_EQ(scales[2], 0.2);
+  // Row 0 is {-7, 2, 1}, row 1 is all zeros and row 2 is {3, 7, -1}.
+  EXPECT_THAT(model->buffers[0]->data,
+              ElementsAreArray({0x29, 0x01, 0x00, 0x00, 0x73, 0x0F}));
+}
+
 TEST_F(QuantizationUtilsTest, AddQuantizationParams) {
   // Create data.
   auto model = std::make_unique<ModelT>();
@@ -31,7 +31,10 @@ namespace optimize {
 using absl::flat_hash_set;
 
 // Supported resulting types from quantization process.
-enum class BufferType { QUANTIZED_INT8, QUANTIZED_FLOAT16 };
+// QUANTIZED_INT4 quantizes the tables of EMBEDDING_LOOKUP ops to int4 with one
+// scale per row, and the other weights as QUANTIZED_INT8 does. It is only
+// supported by the old quantizer.
+enum class BufferType { QUANTIZED_INT8, QUANTIZED_FLOAT16, QUANTIZED_INT4 };
 enum class QuantizerType { OLD_QUANTIZER, MLIR_QUANTIZER };
 
 // Stores information about how to quantize a user-specified custom operation.
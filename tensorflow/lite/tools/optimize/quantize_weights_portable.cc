@@ -378,11 +378,46 @@ inline bool IsOpDenylisted(const flat_hash_set<BuiltinOperator>& op_denylist,
   return op_denylist.find(op_code) != op_denylist.end();
 }
 
+// Returns true if the tensor is a 2D table that is only used as the value
+// input of EMBEDDING_LOOKUP ops, which can look up int4 values directly.
+bool IsInt4EmbeddingTable(const ModelT* model, const SubGraphT* subgraph,
+                          int32_t tensor_idx) {
+  if (subgraph->tensors[tensor_idx]->shape.size() != 2) {
+    return false;
+  }
+  for (int32_t output : subgraph->outputs) {
+    if (output == tensor_idx) {
+      return false;
+    }
+  }
+  const std::vector<ConsumerOpInfo> consumer_op_infos =
+      GetTensorConsumers(model, subgraph, tensor_idx);
+  if (consumer_op_infos.empty()) {
+    return false;
+  }
+  for (const ConsumerOpInfo& consumer_op_info : consumer_op_infos) {
+    const BuiltinOperator op_code = GetBuiltinCode(
+        model->operator_codes[consumer_op_info.op->opcode_index].get());
+    if (op_code != BuiltinOperator_EMBEDDING_LOOKUP ||
+        consumer_op_info.op_input_idx != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
 TfLiteStatus QuantizeWeightsInt8(
     flatbuffers::FlatBufferBuilder* builder, const Model* input_model,
     bool use_hybrid_evaluation, uint64_t weights_min_num_elements,
     const CustomOpMap& custom_op_map, bool use_updated_hybrid_scheme,
-    const flat_hash_set<BuiltinOperator>& op_denylist = {}) {
+    const flat_hash_set<BuiltinOperator>& op_denylist = {},
+    bool quantize_embedding_tables_to_int4 = false) {
+  // Int4 tables cannot be dequantized, so they are only used when the lookups
+  // are evaluated in hybrid mode.
+  quantize_embedding_tables_to_int4 =
+      quantize_embedding_tables_to_int4 && use_hybrid_evaluation &&
+      !IsOpDenylisted(op_denylist, BuiltinOperator_EMBEDDING_LOOKUP);
+  bool has_int4_embedding_tables = false;
   std::unique_ptr<ModelT> model;
   model.reset(input_model->UnPack());
 
@@ -400,7 +435,12 @@ TfLiteStatus QuantizeWeightsInt8(
 
     for (std::pair<int32_t, TensorPerChannel> tensor_pair : tensor_map) {
       // Quantize the tensor.
-      if (tensor_pair.second.is_per_channel) {
+      if (quantize_embedding_tables_to_int4 &&
+          IsInt4EmbeddingTable(model.get(), subgraph, tensor_pair.first)) {
+        TF_LITE_ENSURE_STATUS(utils::SymmetricQuantizeTensorPerRowInt4(
+            model.get(), tensor_pair.second.t, nullptr));
+        has_int4_embedding_tables = true;
+      } else if (tensor_pair.second.is_per_channel) {
         TF_LITE_ENSURE_STATUS(utils::SymmetricQuantizeTensorPerChannel(
             model.get(), tensor_pair.second.t, tensor_pair.second.channel_dim,
             nullptr));
@@ -414,6 +454,10 @@ TfLiteStatus QuantizeWeightsInt8(
     for (const auto& tensor_pair : tensor_map) {
       int32_t tensor_idx = tensor_pair.first;
       TensorT* tensor = tensor_pair.second.t;
+      if (tensor->type == TensorType_INT4) {
+        // All the consumers of int4 tables evaluate them in hybrid mode.
+        continue;
+      }
       std::vector<ConsumerOpInfo> consumer_op_infos =
           GetTensorConsumers(model.get(), subgraph, tensor_idx);
       if (IsQuantizationPassThroughOps(model.get(), consumer_op_infos)) {
@@ -498,6 +542,13 @@ TfLiteStatus QuantizeWeightsInt8(
 
   // Update the modified operator code versions.
   UpdateInt8OperatorVersions(model.get(), use_updated_hybrid_scheme);
+  if (has_int4_embedding_tables) {
+    for (auto& op_code : model->operator_codes) {
+      if (GetBuiltinCode(op_code.get()) == BuiltinOperator_EMBEDDING_LOOKUP) {
+        op_code->version = 4;
+      }
+    }
+  }
 
   flatbuffers::Offset<Model> output_model_location =
       Model::Pack(*builder, model.get());
@@ -635,6 +686,13 @@ TfLiteStatus QuantizeWeights(flatbuffers::FlatBufferBuilder* builder,
     }
     case BufferType::QUANTIZED_FLOAT16:
       return QuantizeWeightsFloat16(builder, input_model);
+    case BufferType::QUANTIZED_INT4: {
+      CustomOpMap custom_op_map;
+      return QuantizeWeightsInt8(builder, input_model, true,
+                                 kWeightsMinNumElementsDefault, custom_op_map,
+                                 use_updated_hybrid_scheme, /*op_denylist=*/{},
+                                 /*quantize_embedding_tables_to_int4=*/true);
+    }
   }
 }
 
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
 #include "tensorflow/lite/tools/optimize/test_util.h"
+#include "tensorflow/lite/version.h"
 
 namespace {
 tensorflow::string* g_test_model_dir = nullptr;
@@ -668,6 +669,73 @@ TEST_F(QuantizeWeightsTest, DequantizeConvBlocklisted) {
   }
 }
 
+TEST_F(QuantizeWeightsTest, QuantizeEmbeddingLookupInt4) {
+  // Builds a model that looks up rows of a constant [4, 301] float table.
+  constexpr int kRows = 4;
+  constexpr int kCols = 301;
+  ModelT model;
+  model.version = TFLITE_SCHEMA_VERSION;
+  auto op_code = std::make_unique<OperatorCodeT>();
+  op_code->builtin_code = BuiltinOperator_EMBEDDING_LOOKUP;
+  op_code->deprecated_builtin_code =
+      static_cast<int8_t>(BuiltinOperator_EMBEDDING_LOOKUP);
+  op_code->version = 1;
+  model.operator_codes.push_back(std::move(op_code));
+  model.buffers.push_back(std::make_unique<BufferT>());
+  std::vector<float> table(kRows * kCols);
+  for (int i = 0; i < table.size(); ++i) {
+    table[i] = (i % 15 - 7) * 0.1f;
+  }
+  auto table_buffer = std::make_unique<BufferT>();
+  const uint8_t* table_data = reinterpret_cast<const uint8_t*>(table.data());
+  table_buffer->data.assign(table_data, table_data + table.size() * 4);
+  model.buffers.push_back(std::move(table_buffer));
+
+  auto subgraph = std::make_unique<SubGraphT>();
+  auto add_tensor = [&](const std::vector<int>& shape, TensorType type,
+                        int buffer) {
+    auto tensor = std::make_unique<TensorT>();
+    tensor->shape = shape;
+    tensor->type = type;
+    tensor->buffer = buffer;
+    subgraph->tensors.push_back(std::move(tensor));
+  };
+  add_tensor({2}, TensorType_INT32, 0);
+  add_tensor({kRows, kCols}, TensorType_FLOAT32, 1);
+  add_tensor({2, kCols}, TensorType_FLOAT32, 0);
+  auto op = std::make_unique<OperatorT>();
+  op->opcode_index = 0;
+  op->inputs = {0, 1};
+  op->outputs = {2};
+  subgraph->operators.push_back(std::move(op));
+  subgraph->inputs = {0};
+  subgraph->outputs = {2};
+  model.subgraphs.push_back(std::move(subgraph));
+
+  flatbuffers::FlatBufferBuilder input_builder;
+  FinishModelBuffer(input_builder, Model::Pack(input_builder, &model));
+  const Model* input_model = GetModel(input_builder.GetBufferPointer());
+
+  flatbuffers::FlatBufferBuilder builder;
+  ASSERT_EQ(QuantizeWeights(&builder, input_model, BufferType::QUANTIZED_INT4),
+            kTfLiteOk);
+  const Model* output_model = GetModel(builder.GetBufferPointer());
+  ASSERT_TRUE(output_model);
+
+  // The lookup reads the int4 table directly, without a Dequantize op.
+  const auto subgraph_output = output_model->subgraphs()->Get(0);
+  ASSERT_EQ(subgraph_output->operators()->size(), 1);
+  EXPECT_EQ(output_model->operator_codes()->Get(0)->version(), 4);
+  const auto table_tensor = subgraph_output->tensors()->Get(1);
+  EXPECT_EQ(table_tensor->type(), TensorType_INT4);
+  EXPECT_EQ(table_tensor->quantization()->scale()->size(), kRows);
+  EXPECT_EQ(table_tensor->quantization()->quantized_dimension(), 0);
+  EXPECT_EQ(
+      output_model->buffers()->Get(table_tensor->buffer())->data()->size(),
+      kRows * ((kCols + 1) / 2));
+  EXPECT_EQ(subgraph_output->tensors()->Get(2)->type(), TensorType_FLOAT32);
+}
+
 }  // namespace
 }  // namespace optimize
 }  // namespace tflite
@@ -94,6 +94,8 @@ inline TensorType TfLiteTypeToSchemaType(TfLiteType type) {
       return TensorType_RESOURCE;
     case kTfLiteVariant:
       return TensorType_VARIANT;
+    case kTfLiteInt4:
+      return TensorType_INT4;
   }
   // TODO(aselle): consider an error
 }
@@ -445,6 +445,20 @@ bool VerifyNumericTensorBuffer(const Tensor& tensor, const Buffer& buffer,
     case TensorType_COMPLEX128:
       bytes_required *= sizeof(std::complex<double>);
       break;
+    case TensorType_INT4: {
+      // Each row of the innermost dimension is packed two values per byte.
+      const int num_dims = tensor.shape()->size();
+      const int row_size = num_dims > 0 ? tensor.shape()->Get(num_dims - 1) : 1;
+      if (tensor.sparsity() != nullptr) {
+        ReportError(error_reporter, "Tensor %s is a sparse int4 tensor",
+                    NameOrEmptyString(tensor.name()));
+        return false;
+      }
+      if (row_size > 0) {
+        bytes_required = bytes_required / row_size * ((row_size + 1) / 2);
+      }
+      break;
+    }
     default:
       ReportError(error_reporter, "Tensor %s invalid type: %d",
                   NameOrEmptyString(tensor.name()), tensor.type());
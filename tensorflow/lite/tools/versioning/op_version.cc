@@ -190,6 +190,21 @@ int GetBuiltinOperatorVersion(const OpSignature& op_sig) {
       return 1;
     }
 
+    case BuiltinOperator_EMBEDDING_LOOKUP: {
+      // Packed int4 tables are supported since version 4.
+      if (op_sig.inputs.at(1).type == kTfLiteInt4) {
+        return 4;
+      }
+      return 1;
+    }
+
+    case BuiltinOperator_HASHTABLE_IMPORT:
+      // The optional prebuilt index input is supported since version 2.
+      if (op_sig.inputs.size() == 4) {
+        return 2;
+      }
+      return 1;
+
     case BuiltinOperator_GATHER: {
       auto gather_params =
           reinterpret_cast<TfLiteGatherParams*>(op_sig.builtin_data);
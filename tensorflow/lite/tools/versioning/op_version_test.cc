@@ -728,6 +728,33 @@ TEST(OpVersionTest, VersioningTransposeConvOperatorTest) {
   EXPECT_EQ(GetBuiltinOperatorVersion(fake_op_sig), 2);
 }
 
+TEST(OpVersionTest, VersioningEmbeddingLookupTest) {
+  OpSignature fake_op_sig = {
+      .op = BuiltinOperator_EMBEDDING_LOOKUP,
+      .inputs = CreateOpSignatureTensorSpecs(
+          std::vector<TfLiteType>{kTfLiteInt32, kTfLiteFloat32}),
+      .outputs = CreateOpSignatureTensorSpecs(kTfLiteFloat32),
+  };
+  EXPECT_EQ(GetBuiltinOperatorVersion(fake_op_sig), 1);
+
+  fake_op_sig.inputs = CreateOpSignatureTensorSpecs(
+      std::vector<TfLiteType>{kTfLiteInt32, kTfLiteInt4});
+  EXPECT_EQ(GetBuiltinOperatorVersion(fake_op_sig), 4);
+}
+
+TEST(OpVersionTest, VersioningHashtableImportTest) {
+  OpSignature fake_op_sig = {
+      .op = BuiltinOperator_HASHTABLE_IMPORT,
+      .inputs = CreateOpSignatureTensorSpecs(std::vector<TfLiteType>{
+          kTfLiteResource, kTfLiteString, kTfLiteInt64}),
+  };
+  EXPECT_EQ(GetBuiltinOperatorVersion(fake_op_sig), 1);
+
+  fake_op_sig.inputs = CreateOpSignatureTensorSpecs(std::vector<TfLiteType>{
+      kTfLiteResource, kTfLiteString, kTfLiteInt64, kTfLiteInt32});
+  EXPECT_EQ(GetBuiltinOperatorVersion(fake_op_sig), 2);
+}
+
 TEST(OpVersionTest, VersioningSVDFOperatorTest) {
   TfLiteSVDFParams svdf_params = {};
   OpSignature fake_op_sig = {
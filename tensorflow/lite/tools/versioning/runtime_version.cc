@@ -109,6 +109,7 @@ std::string FindMinimumRuntimeVersionForOp(tflite::BuiltinOperator op_code,
            {{BuiltinOperator_EMBEDDING_LOOKUP, 1}, "1.13.0"},
            {{BuiltinOperator_EMBEDDING_LOOKUP, 2}, "1.14.0"},
            {{BuiltinOperator_EMBEDDING_LOOKUP, 3}, "1.14.0"},
+          {{BuiltinOperator_EMBEDDING_LOOKUP, 4}, "2.11.0"},
            {{BuiltinOperator_EMBEDDING_LOOKUP_SPARSE, 1}, "1.5.0"},
            {{BuiltinOperator_FAKE_QUANT, 1}, "1.5.0"},
            {{BuiltinOperator_FAKE_QUANT, 2}, "1.10.0"},
@@ -366,6 +367,7 @@ std::string FindMinimumRuntimeVersionForOp(tflite::BuiltinOperator op_code,
            {{BuiltinOperator_HASHTABLE, 1}, "2.5.0"},
            {{BuiltinOperator_HASHTABLE_FIND, 1}, "2.5.0"},
            {{BuiltinOperator_HASHTABLE_IMPORT, 1}, "2.5.0"},
+           {{BuiltinOperator_HASHTABLE_IMPORT, 2}, "2.11.0"},
            {{BuiltinOperator_HASHTABLE_SIZE, 1}, "2.5.0"},
            {{BuiltinOperator_REDUCE_ALL, 1}, "2.6.0"},
            {{BuiltinOperator_CONV_3D_TRANSPOSE, 1}, "2.6.0"},
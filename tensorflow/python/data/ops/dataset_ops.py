@@ -3108,10 +3108,25 @@ name=None))
           drop_remainder=drop_remainder,
           name=name)
 
-    return self.group_by_window(
-        key_func=element_to_bucket_id,
-        reduce_func=batching_fn,
-        window_size_func=window_size_fn,
+    if no_padding:
+      return self.group_by_window(
+          key_func=element_to_bucket_id,
+          reduce_func=batching_fn,
+          window_size_func=window_size_fn,
+          name=name)
+    # The native op keeps one buffer per bucket and pads elements into the
+    # batch of their bucket as they arrive, instead of running a window
+    # dataset and a padded batch per group.
+    return _BucketBySequenceLengthDataset(
+        self,
+        element_length_func,
+        bucket_boundaries,
+        bucket_batch_sizes,
+        padded_shapes=make_padded_shapes(
+            padded_shapes or get_legacy_output_shapes(self)),
+        padding_values=padding_values,
+        pad_to_bucket_boundary=pad_to_bucket_boundary,
+        drop_remainder=drop_remainder,
         name=name)
 
   @staticmethod
@@ -5389,6 +5404,101 @@ class PaddedBatchDataset(UnaryDataset):
     return self._structure
 
 
+class _BucketBySequenceLengthDataset(UnaryDataset):
+  """A `Dataset` that batches and pads elements of similar length together."""
+
+  def __init__(self,
+               input_dataset,
+               element_length_func,
+               bucket_boundaries,
+               bucket_batch_sizes,
+               padded_shapes,
+               padding_values,
+               pad_to_bucket_boundary,
+               drop_remainder,
+               name=None):
+    """See `Dataset.bucket_by_sequence_length()` for details."""
+
+    def check_types(component_spec):
+      if not isinstance(component_spec, tensor_spec.TensorSpec):
+        raise TypeError(f"`bucket_by_sequence_length` is only supported for "
+                        f"datasets that produce tensor elements but the input "
+                        f"dataset produces elements of unsupported type "
+                        f"{component_spec.value_type()}.")
+
+    nest.map_structure(check_types, input_dataset.element_spec)
+    self._input_dataset = input_dataset
+
+    def element_length(*args):
+      return math_ops.cast(element_length_func(*args), dtypes.int64)
+
+    self._element_length_func = structured_function.StructuredFunctionWrapper(
+        element_length,
+        "Dataset.bucket_by_sequence_length()",
+        dataset=input_dataset)
+    if not self._element_length_func.output_structure.is_compatible_with(
+        tensor_spec.TensorSpec([], dtypes.int64)):
+      raise ValueError(
+          f"Invalid `element_length_func`. `element_length_func` must return a "
+          f"single scalar, but its return type is "
+          f"{self._element_length_func.output_structure}.")
+
+    input_shapes = get_legacy_output_shapes(input_dataset)
+    flat_padded_shapes = nest.flatten_up_to(input_shapes, padded_shapes)
+    self._padded_shapes = [
+        _padded_shape_to_tensor(padded_shape, input_component_shape)
+        for input_component_shape, padded_shape in zip(
+            nest.flatten(input_shapes), flat_padded_shapes)
+    ]
+
+    padding_values = _padding_values_or_default(padding_values, input_dataset)
+    if nest.is_nested(input_shapes) and not nest.is_nested(padding_values):
+      padding_values = nest.map_structure(lambda _: padding_values,
+                                          input_shapes)
+    self._padding_values = nest.map_structure_up_to(
+        input_shapes, _padding_value_to_tensor, padding_values,
+        get_legacy_output_types(input_dataset))
+    self._drop_remainder = ops.convert_to_tensor(
+        drop_remainder, dtype=dtypes.bool, name="drop_remainder")
+
+    # The batch dimension is unknown since the last batch of each bucket may
+    # be partial, and so are the padded dimensions that are filled in per
+    # bucket.
+    output_shapes = nest.pack_sequence_as(input_shapes, [
+        tensor_shape.TensorShape([None]).concatenate(
+            tensor_util.constant_value_as_shape(s))
+        for s in self._padded_shapes
+    ])
+    self._structure = structure.convert_legacy_structure(
+        get_legacy_output_types(input_dataset), output_shapes,
+        get_legacy_output_classes(input_dataset))
+
+    self._name = name
+    variant_tensor = ged_ops.bucket_by_sequence_length_dataset(
+        input_dataset._variant_tensor,  # pylint: disable=protected-access
+        self._element_length_func.function.captured_inputs,
+        bucket_boundaries=constant_op.constant(
+            list(bucket_boundaries), dtype=dtypes.int64),
+        bucket_batch_sizes=constant_op.constant(
+            list(bucket_batch_sizes), dtype=dtypes.int64),
+        padded_shapes=self._padded_shapes,
+        padding_values=nest.flatten(self._padding_values),
+        drop_remainder=self._drop_remainder,
+        element_length_func=self._element_length_func.function,
+        pad_to_bucket_boundary=pad_to_bucket_boundary,
+        output_shapes=structure.get_flat_tensor_shapes(self._structure),
+        metadata=self._metadata.SerializeToString())
+    super(_BucketBySequenceLengthDataset, self).__init__(input_dataset,
+                                                         variant_tensor)
+
+  def _functions(self):
+    return [self._element_length_func]
+
+  @property
+  def element_spec(self):
+    return self._structure
+
+
 class MapDataset(UnaryDataset):
   """A `Dataset` that maps a function over elements in its input."""
 
@@ -369,6 +369,15 @@ class OptimizationOptions(options_lib.OptionsBase):
       "Whether to parallelize stateless map transformations. If None, defaults "
       "to True.")
 
+  map_vectorization = options_lib.create_option(
+      name="map_vectorization",
+      ty=bool,
+      docstring=
+      "Whether to vectorize map transformations that are followed by a batch "
+      "transformation, by batching the inputs first and applying a vectorized "
+      "version of the map function to each batch. Only map functions made of "
+      "element-wise ops are vectorized. If None, defaults to False.")
+
   noop_elimination = options_lib.create_option(
       name="noop_elimination",
       ty=bool,
@@ -405,6 +414,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       pb.map_fusion = self.map_fusion
     if self.map_parallelization is not None:
       pb.map_parallelization = self.map_parallelization
+    if self.map_vectorization is not None:
+      pb.map_vectorization = self.map_vectorization
     if self.noop_elimination is not None:
       pb.noop_elimination = self.noop_elimination
     if self.parallel_batch is not None:
@@ -430,6 +441,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       self.map_fusion = pb.map_fusion
     if pb.WhichOneof("optional_map_parallelization") is not None:
       self.map_parallelization = pb.map_parallelization
+    if pb.WhichOneof("optional_map_vectorization") is not None:
+      self.map_vectorization = pb.map_vectorization
     if pb.WhichOneof("optional_noop_elimination") is not None:
       self.noop_elimination = pb.noop_elimination
     if pb.WhichOneof("optional_parallel_batch") is not None:
@@ -571,6 +584,18 @@ class Options(options_lib.OptionsBase):
       "frequency is determined by the number of devices attached to this "
       "input pipeline. If None, defaults to False.")
 
+  experimental_symbolic_checkpoint = options_lib.create_option(
+      name="experimental_symbolic_checkpoint",
+      ty=bool,
+      docstring="Whether to checkpoint iterators symbolically. Symbolic "
+      "checkpoints save the positions of the inputs of buffering "
+      "transformations, such as `shuffle` and `prefetch`, instead of the "
+      "buffered elements, and recompute the buffers on restore. This makes "
+      "checkpoints smaller and faster to write, at the cost of slower "
+      "restores. If a transformation of the input pipeline does not support "
+      "symbolic checkpoints, the full iterator state is saved instead. If "
+      "None, defaults to False.")
+
   experimental_threading = options_lib.create_option(
       name="experimental_threading",
       ty=ThreadingOptions,
@@ -622,6 +647,8 @@ class Options(options_lib.OptionsBase):
     pb.optimization_options.CopyFrom(self.experimental_optimization._to_proto())  # pylint: disable=protected-access
     if self.experimental_slack is not None:
       pb.slack = self.experimental_slack
+    if self.experimental_symbolic_checkpoint is not None:
+      pb.symbolic_checkpoint = self.experimental_symbolic_checkpoint
     pb.threading_options.CopyFrom(self.threading._to_proto())  # pylint: disable=protected-access
     return pb
 
@@ -637,6 +664,8 @@ class Options(options_lib.OptionsBase):
     self.experimental_optimization._from_proto(pb.optimization_options)  # pylint: disable=protected-access
     if pb.WhichOneof("optional_slack") is not None:
       self.experimental_slack = pb.slack
+    if pb.WhichOneof("optional_symbolic_checkpoint") is not None:
+      self.experimental_symbolic_checkpoint = pb.symbolic_checkpoint
     self.threading._from_proto(pb.threading_options)  # pylint: disable=protected-access
 
   def _set_mutable(self, mutable):
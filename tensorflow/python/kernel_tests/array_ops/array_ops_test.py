@@ -2038,6 +2038,31 @@ class SortedSearchTest(test_util.TensorFlowTestCase):
 
     self.assertAllEqual(result, tf_result)
 
+  def testLargeSortedAndUnsortedValues(self):
+    # Exercises merging sorted values and searching unsorted values in an
+    # Eytzinger layout of a large sequence, with duplicates and NaNs.
+    batch_size = 3
+    size_search_array = 5000
+    size_values = 20000
+    cdf = np.sort(
+        np.random.randint(
+            low=0, high=1000, size=[batch_size,
+                                    size_search_array]).astype(np.float32),
+        axis=1)
+    arr = np.random.uniform(
+        low=-10, high=1010, size=[batch_size, size_values]).astype(np.float32)
+    arr[:, ::7] = np.round(arr[:, ::7])
+    arr[1, :] = np.sort(arr[1, :])
+    arr[2, 17] = np.nan
+    for side in ("left", "right"):
+      with self.subTest(side=side):
+        tf_result = self.evaluate(
+            array_ops.searchsorted(cdf, arr, side=side))
+        result = np.zeros(arr.shape, dtype=np.int32)
+        for i in range(batch_size):
+          result[i, :] = np.searchsorted(cdf[i, :], arr[i, :], side=side)
+        self.assertAllEqual(result, tf_result)
+
   def testZeroSequenceSize(self):
     dtype = dtypes.int32
     for side in ("left", "right"):
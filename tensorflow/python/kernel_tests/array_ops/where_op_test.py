@@ -69,6 +69,13 @@ class WhereOpTest(test.TestCase):
     truth = np.vstack([np.where(x)[0].astype(np.int64)]).T
     self._testWhere(x, truth, None, fn)
 
+  def _testRandomSparse(self, dtype, fn=array_ops.where):
+    # Long runs of zeros, with true elements on both sides of block boundaries.
+    x = (np.random.rand(3, 100003) > 0.999).astype(dtype)
+    x[:, 16383:16385] = 1
+    truth = np.vstack(np.where(x)).T
+    self._testWhere(x, truth, None, fn)
+
   def _testBasicMat(self, fn=array_ops.where):
     x = np.asarray([[True, False], [True, False]])
 
@@ -114,6 +121,12 @@ class WhereOpTest(test.TestCase):
   def testRandomVec(self):
     self._testRandomVec()
 
+  @test_util.run_deprecated_v1
+  def testRandomSparse(self):
+    self._testRandomSparse(np.bool_)
+    self._testRandomSparse(np.int8)
+    self._testRandomSparse(np.float32)
+
   @test_util.run_deprecated_v1
   def testBasicMat(self):
     self._testBasicMat()
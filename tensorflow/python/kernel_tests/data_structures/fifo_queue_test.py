@@ -1492,6 +1492,27 @@ class FIFOQueueParallelTests(test.TestCase):
       for elem in cleanup_elems:
         self.assertTrue(elem in (10.0, 20.0))
 
+  def testConcurrentEnqueueManyAndDequeueManyWrapAround(self):
+    # A bounded queue with fixed shapes, whose batches do not divide the
+    # capacity, so that they wrap around the end of the buffer.
+    with self.cached_session() as sess:
+      q = data_flow_ops.FIFOQueue(7, dtypes_lib.int32, shapes=(2,))
+      batch_placeholder = array_ops.placeholder(dtypes_lib.int32, shape=(3, 2))
+      enqueue_op = q.enqueue_many((batch_placeholder,))
+      dequeued_t = q.dequeue_many(5)
+      elems = np.arange(180, dtype=np.int32).reshape(90, 2)
+
+      def enqueue():
+        for i in range(0, 90, 3):
+          sess.run(enqueue_op, feed_dict={batch_placeholder: elems[i:i + 3]})
+
+      enqueue_thread = self.checkedThread(target=enqueue)
+      enqueue_thread.start()
+      for i in range(0, 90, 5):
+        self.assertAllEqual(elems[i:i + 5], self.evaluate(dequeued_t))
+      enqueue_thread.join()
+      self.assertEqual(0, q.size().eval())
+
   def testMixtureOfEnqueueAndEnqueueMany(self):
     with self.cached_session() as sess:
       q = data_flow_ops.FIFOQueue(10, dtypes_lib.int32, shapes=())
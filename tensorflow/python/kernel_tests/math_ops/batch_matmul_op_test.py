@@ -89,6 +89,9 @@ class BatchMatmulOpTest(test.TestCase):
     CompareNonEmpty(self, [7, 2, 3], [7, 3, 1])
     CompareNonEmpty(self, [7, 2, 3], [7, 3, 5])
     CompareNonEmpty(self, [10, 64, 75], [10, 75, 30])
+    CompareNonEmpty(self, [9, 64, 64], [9, 64, 64])
+    CompareNonEmpty(self, [9, 5, 16], [9, 16, 8])
+    CompareNonEmpty(self, [9, 5, 3], [9, 3, 7])
     CompareNonEmpty(self, [5, 7, 2, 3], [5, 7, 3, 5])
 
   def _testBroadcasting(self, dtype, adjoint_a, adjoint_b, use_static_shape):
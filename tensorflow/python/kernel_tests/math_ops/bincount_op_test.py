@@ -250,6 +250,34 @@ class BincountOpTest(test_util.TensorFlowTestCase, parameterized.TestCase):
               gen_math_ops.dense_bincount(
                   input=inp, weights=np_weight, size=size, binary_output=True)))
 
+  @parameterized.parameters([{
+      "size": 1000,
+  }, {
+      "size": 1 << 20,
+  }])
+  def test_bincount_large_input(self, size):
+    # Large enough to be sharded on CPU, with bins that fit in the cache or
+    # that are partitioned by range.
+    np.random.seed(42)
+    num_samples = 1 << 20
+    inp = np.random.randint(0, size, (num_samples,), dtype=np.int32)
+    np_weight = np.random.random((num_samples,))
+    with test_util.use_gpu():
+      self.assertAllEqual(
+          np.bincount(inp, minlength=size),
+          self.evaluate(
+              gen_math_ops.dense_bincount(input=inp, weights=[], size=size)))
+      self.assertAllClose(
+          np.bincount(inp, minlength=size, weights=np_weight),
+          self.evaluate(
+              gen_math_ops.dense_bincount(
+                  input=inp, weights=np_weight, size=size)))
+      self.assertAllEqual(
+          np.bincount(inp, minlength=size) > 0,
+          self.evaluate(
+              gen_math_ops.dense_bincount(
+                  input=inp, weights=[], size=size, binary_output=True)))
+
   def _test_bincount_col_count(self, num_rows, num_cols, size, dtype):
     np.random.seed(42)
     inp = np.random.randint(0, size, (num_rows, num_cols), dtype=dtype)
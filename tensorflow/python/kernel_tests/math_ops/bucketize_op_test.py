@@ -58,6 +58,20 @@ class BucketizationOpTest(test.TestCase):
     with self.session():
       self.assertAllEqual(expected_out, self.evaluate(op))
 
+  def testManyBoundaries(self):
+    boundaries = np.sort(np.random.uniform(size=1000) * 100).tolist()
+    values = np.random.uniform(low=-1, high=101, size=[100, 500])
+    values[0, :] = np.sort(values[0, :])
+    op = math_ops._bucketize(
+        constant_op.constant(values, dtype=dtypes.float32),
+        boundaries=boundaries)
+    expected_out = np.searchsorted(
+        np.array(boundaries, dtype=np.float32),
+        values.astype(np.float32),
+        side="right")
+    with self.session():
+      self.assertAllEqual(expected_out, self.evaluate(op))
+
   @test_util.run_deprecated_v1
   def testInvalidBoundariesOrder(self):
     op = math_ops._bucketize(
@@ -230,10 +230,6 @@ class SumReductionTest(BaseReductionTest):
       self._compareAllAxes(np_arr)
 
     # test that mean doesn't overflow
-    # only on GPU, since it has the more accurate implementation
-    if not test.is_gpu_available():
-      return
-
     arr = np.ones([68000], dtype=np.float16)
 
     with self.session(graph=ops.Graph(), use_gpu=True) as sess:
@@ -243,6 +239,22 @@ class SumReductionTest(BaseReductionTest):
       tf_out_mean = self.evaluate(tf_mean)
     self.assertAllClose(tf_out_mean, 1.)
 
+  @test_util.run_deprecated_v1
+  def testBFloat16LargeRowsAndColumns(self):
+    np_type = dtypes.bfloat16.as_numpy_dtype
+    for size_x, size_y in [(1, 100000), (3, 50000), (1000, 37), (50000, 3)]:
+      arr = np.random.uniform(size=[size_x, size_y]).astype(np_type)
+      arr_f32 = arr.astype(np.float32)
+      with self.session(graph=ops.Graph(), use_gpu=True):
+        tf_row_sum = self._tf_reduce(arr, 1, False)
+        tf_col_sum = self._tf_reduce(arr, 0, False)
+        tf_sum = self._tf_reduce(arr, None, False)
+        tf_out_row, tf_out_col, tf_out_sum = self.evaluate(
+            [tf_row_sum, tf_col_sum, tf_sum])
+      self.assertAllClose(np.sum(arr_f32, axis=1), tf_out_row, rtol=1e-2)
+      self.assertAllClose(np.sum(arr_f32, axis=0), tf_out_col, rtol=1e-2)
+      self.assertAllClose(np.sum(arr_f32), tf_out_sum, rtol=1e-2)
+
   @test_util.run_deprecated_v1
   def testFloat32(self):
     for rank in range(1, _MAX_RANK + 1):
@@ -1054,6 +1054,43 @@ class SparseCrossHashedOpTest(BaseSparseCrossOpTest):
       self.assertAllEqual(out.indices, out_2.indices)
       self.assertAllEqual(out.values, out_2.values)
 
+  def test_hashed_large_batch_matches_single_rows(self):
+    """Tests that crossing many rows matches crossing each row separately."""
+    batch_size = 100
+    data_1 = [['batch%d-FC1-F%d' % (b, f)
+               for f in range(b % 4)]
+              for b in range(batch_size)]
+    data_2 = [[b * 10 + f for f in range((b + 1) % 3 + 1)]
+              for b in range(batch_size)]
+    dense = [['batch%d-FC3-F%d' % (b, f) for f in range(2)]
+             for b in range(batch_size)]
+
+    def cross(rows_1, rows_2, dense_rows):
+      sp_inp_1 = self._sparse_tensor(rows_1)
+      sp_inp_2 = self._sparse_tensor(rows_2)
+      inds, vals, shapes = gen_sparse_ops.sparse_cross_hashed(
+          indices=[sp_inp_1.indices, sp_inp_2.indices],
+          values=[sp_inp_1.values, sp_inp_2.values],
+          shapes=[sp_inp_1.dense_shape, sp_inp_2.dense_shape],
+          dense_inputs=[constant_op.constant(dense_rows)],
+          strong_hash=False,
+          num_buckets=1000,
+          salt=[137, 173])
+      return self.evaluate(sparse_tensor.SparseTensor(inds, vals, shapes))
+
+    with self.cached_session():
+      out = cross(data_1, data_2, dense)
+      expected_indices = []
+      expected_values = []
+      for b in range(batch_size):
+        if not data_1[b]:
+          continue
+        row = cross([data_1[b]], [data_2[b]], [dense[b]])
+        expected_indices.extend([b, i] for i in range(len(row.values)))
+        expected_values.extend(row.values)
+      self.assertAllEqual(expected_indices, out.indices)
+      self.assertAllEqual(expected_values, out.values)
+
 
 if __name__ == '__main__':
   test.main()
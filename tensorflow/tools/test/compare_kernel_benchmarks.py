@@ -0,0 +1,207 @@
+# Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Compares two runs of the kernel benchmark suite and flags regressions.
+
+The inputs are the JSON output of
+//tensorflow/core/kernels:kernel_benchmark_suite_test, run with
+`--benchmark_out_format=json --benchmark_out=<file>`, typically once for each
+build. Each benchmark is reduced to one record of the same schema whatever its
+device:
+
+  {"name": "BM_KernelSuite/MatMul/128x1024x1024/cpu",
+   "op": "MatMul", "shape": "128x1024x1024", "device": "cpu",
+   "real_time_ns": ..., "cpu_time_ns": ...,
+   "items_per_second": ..., "bytes_per_second": ...}
+
+using the median of the repetitions when the benchmarks are repeated. A
+benchmark regresses when its real time grows by more than `--threshold`.
+
+Usage:
+  compare_kernel_benchmarks --baseline=baseline.json \
+      --candidate=candidate.json [--threshold=0.05] [--output=report.json]
+
+Exits with a non-zero status if any benchmark regressed.
+"""
+
+import json
+import statistics
+
+from absl import app
+from absl import flags
+
+FLAGS = flags.FLAGS
+
+flags.DEFINE_string("baseline", None, "Benchmark JSON of the baseline build.")
+flags.DEFINE_string("candidate", None,
+                    "Benchmark JSON of the build to compare to the baseline.")
+flags.DEFINE_float(
+    "threshold", 0.05,
+    "Relative growth of the real time above which a benchmark regresses.")
+flags.DEFINE_string("output", None,
+                    "If set, the comparison is also written there as JSON.")
+
+SUITE_PREFIX = "BM_KernelSuite/"
+
+_NANOS_PER_UNIT = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+# Suffixes appended by the benchmark library to the registered name.
+_NAME_SUFFIXES = ("/real_time", "/process_time")
+
+_RATE_FIELDS = ("items_per_second", "bytes_per_second")
+
+
+def _benchmark_name(benchmark):
+  name = benchmark.get("run_name", benchmark["name"])
+  stripped = True
+  while stripped:
+    stripped = False
+    for suffix in _NAME_SUFFIXES:
+      if name.endswith(suffix):
+        name = name[:-len(suffix)]
+        stripped = True
+  return name
+
+
+def _record(name, runs):
+  """Reduces the runs of one benchmark to a single record."""
+  record = {"name": name}
+  parts = name.split("/")
+  if name.startswith(SUITE_PREFIX) and len(parts) == 4:
+    record.update(op=parts[1], shape=parts[2], device=parts[3])
+  else:
+    record.update(op=name, shape="", device="")
+
+  def median(field, scale=lambda run: 1.0):
+    values = [run[field] * scale(run) for run in runs if field in run]
+    return statistics.median(values) if values else None
+
+  to_nanos = lambda run: _NANOS_PER_UNIT[run.get("time_unit", "ns")]
+  record["real_time_ns"] = median("real_time", to_nanos)
+  record["cpu_time_ns"] = median("cpu_time", to_nanos)
+  for field in _RATE_FIELDS:
+    record[field] = median(field)
+  return record
+
+
+def load_results(benchmark_json):
+  """Returns the records of a benchmark JSON output, by benchmark name.
+
+  Args:
+    benchmark_json: The parsed JSON output of a benchmark binary.
+
+  Returns:
+    A dict from the name of each benchmark to its record. Benchmarks that
+    failed are left out.
+  """
+  iterations = {}
+  medians = {}
+  for benchmark in benchmark_json.get("benchmarks", []):
+    if benchmark.get("error_occurred"):
+      continue
+    name = _benchmark_name(benchmark)
+    if benchmark.get("run_type") == "aggregate":
+      if benchmark.get("aggregate_name") == "median":
+        medians[name] = [benchmark]
+    else:
+      iterations.setdefault(name, []).append(benchmark)
+  runs = dict(iterations)
+  runs.update(medians)
+  return {name: _record(name, r) for name, r in runs.items()}
+
+
+def compare(baseline, candidate, threshold):
+  """Compares the records of two builds.
+
+  Args:
+    baseline: Records of the baseline build, as returned by load_results().
+    candidate: Records of the other build.
+    threshold: Relative growth of the real time above which a benchmark is a
+      regression.
+
+  Returns:
+    A list of dicts, sorted by name, each with the `name`, `op`, `shape` and
+    `device` of a benchmark, its `baseline` and `candidate` records, the
+    `ratio` of the candidate real time to the baseline one, and a `status` of
+    "regression", "improvement", "unchanged", "added" or "removed".
+  """
+  results = []
+  for name in sorted(set(baseline) | set(candidate)):
+    base = baseline.get(name)
+    cand = candidate.get(name)
+    any_record = base or cand
+    result = {key: any_record[key] for key in ("name", "op", "shape", "device")}
+    result.update(baseline=base, candidate=cand, ratio=None)
+    if base is None:
+      result["status"] = "added"
+    elif cand is None:
+      result["status"] = "removed"
+    elif not base["real_time_ns"]:
+      result["status"] = "unchanged"
+    else:
+      ratio = cand["real_time_ns"] / base["real_time_ns"]
+      result["ratio"] = ratio
+      if ratio > 1.0 + threshold:
+        result["status"] = "regression"
+      elif ratio < 1.0 / (1.0 + threshold):
+        result["status"] = "improvement"
+      else:
+        result["status"] = "unchanged"
+    results.append(result)
+  return results
+
+
+def format_results(results):
+  """Returns a human-readable table of the results of compare()."""
+  lines = ["%-72s %14s %14s %8s  %s" %
+           ("Benchmark", "Baseline (ns)", "Candidate (ns)", "Ratio", "Status")]
+  for result in results:
+    base = result["baseline"]
+    cand = result["candidate"]
+    lines.append("%-72s %14s %14s %8s  %s" % (
+        result["name"],
+        "%.0f" % base["real_time_ns"] if base else "-",
+        "%.0f" % cand["real_time_ns"] if cand else "-",
+        "%.3f" % result["ratio"] if result["ratio"] is not None else "-",
+        result["status"]))
+  return "\n".join(lines)
+
+
+def _load(path):
+  with open(path) as f:
+    return load_results(json.load(f))
+
+
+def main(unused_argv):
+  if not FLAGS.baseline or not FLAGS.candidate:
+    raise app.UsageError("--baseline and --candidate are required.")
+
+  results = compare(
+      _load(FLAGS.baseline), _load(FLAGS.candidate), FLAGS.threshold)
+  print(format_results(results))
+  if FLAGS.output:
+    with open(FLAGS.output, "w") as f:
+      json.dump({"threshold": FLAGS.threshold, "results": results}, f,
+                indent=2)
+
+  regressions = [r for r in results if r["status"] == "regression"]
+  if regressions:
+    print("\n%d of %d benchmarks regressed by more than %.1f%%." %
+          (len(regressions), len(results), 100 * FLAGS.threshold))
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  app.run(main)
@@ -0,0 +1,124 @@
+# Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_kernel_benchmarks."""
+
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_kernel_benchmarks
+
+_MATMUL = "BM_KernelSuite/MatMul/128x1024x1024/cpu"
+_CONCAT = "BM_KernelSuite/ConcatV2/4x1024x256_axis1/gpu"
+
+
+def _iteration(name, real_time, time_unit="ns", **kwargs):
+  benchmark = {
+      "name": name + "/real_time",
+      "run_name": name + "/real_time",
+      "run_type": "iteration",
+      "real_time": real_time,
+      "cpu_time": real_time / 2,
+      "time_unit": time_unit,
+      "items_per_second": 1e9 / real_time,
+  }
+  benchmark.update(kwargs)
+  return benchmark
+
+
+def _median(name, real_time):
+  benchmark = _iteration(name, real_time, aggregate_name="median")
+  benchmark.update(name=name + "/real_time_median", run_type="aggregate")
+  return benchmark
+
+
+class CompareKernelBenchmarksTest(googletest.TestCase):
+
+  def testLoadResultsParsesSuiteNames(self):
+    results = compare_kernel_benchmarks.load_results(
+        {"benchmarks": [_iteration(_MATMUL, 2.0, time_unit="us")]})
+    self.assertEqual(list(results), [_MATMUL])
+    record = results[_MATMUL]
+    self.assertEqual(record["op"], "MatMul")
+    self.assertEqual(record["shape"], "128x1024x1024")
+    self.assertEqual(record["device"], "cpu")
+    self.assertEqual(record["real_time_ns"], 2000.0)
+    self.assertEqual(record["cpu_time_ns"], 1000.0)
+    self.assertEqual(record["items_per_second"], 5e8)
+    self.assertIsNone(record["bytes_per_second"])
+
+  def testLoadResultsUsesMedians(self):
+    results = compare_kernel_benchmarks.load_results({
+        "benchmarks": [
+            _iteration(_MATMUL, 100.0),
+            _iteration(_MATMUL, 300.0),
+            _iteration(_MATMUL, 110.0),
+            _iteration(_CONCAT, 100.0),
+            _iteration(_CONCAT, 300.0),
+            _iteration(_CONCAT, 110.0),
+            _median(_CONCAT, 120.0),
+        ]
+    })
+    # The median of the iterations, without an aggregate.
+    self.assertEqual(results[_MATMUL]["real_time_ns"], 110.0)
+    # The median aggregate of the benchmark library.
+    self.assertEqual(results[_CONCAT]["real_time_ns"], 120.0)
+
+  def testLoadResultsSkipsErrors(self):
+    results = compare_kernel_benchmarks.load_results({
+        "benchmarks": [
+            _iteration(_MATMUL, 100.0),
+            _iteration(_CONCAT, 100.0, error_occurred=True),
+        ]
+    })
+    self.assertEqual(list(results), [_MATMUL])
+
+  def testCompare(self):
+    added = "BM_KernelSuite/Tanh/1024x4096/cpu"
+    removed = "BM_KernelSuite/Relu/1024x4096/cpu"
+    improved = "BM_KernelSuite/Transpose/4096x4096_10/cpu"
+    baseline = compare_kernel_benchmarks.load_results({
+        "benchmarks": [
+            _iteration(_MATMUL, 100.0),
+            _iteration(_CONCAT, 100.0),
+            _iteration(removed, 100.0),
+            _iteration(improved, 100.0),
+        ]
+    })
+    candidate = compare_kernel_benchmarks.load_results({
+        "benchmarks": [
+            _iteration(_MATMUL, 110.0),
+            _iteration(_CONCAT, 104.0),
+            _iteration(added, 100.0),
+            _iteration(improved, 80.0),
+        ]
+    })
+    results = compare_kernel_benchmarks.compare(
+        baseline, candidate, threshold=0.05)
+    statuses = {r["name"]: r["status"] for r in results}
+    self.assertEqual(
+        statuses, {
+            _MATMUL: "regression",
+            _CONCAT: "unchanged",
+            added: "added",
+            removed: "removed",
+            improved: "improvement",
+        })
+    self.assertEqual([r["name"] for r in results], sorted(statuses))
+    matmul = next(r for r in results if r["name"] == _MATMUL)
+    self.assertAlmostEqual(matmul["ratio"], 1.1)
+    self.assertEqual(matmul["device"], "cpu")
+    self.assertIn(_MATMUL, compare_kernel_benchmarks.format_results(results))
+
+
+if __name__ == "__main__":
+  googletest.main()
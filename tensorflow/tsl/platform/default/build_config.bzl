@@ -664,6 +664,7 @@ def tf_additional_lib_hdrs():
         ],
         "//conditions:default": [
             "//tensorflow/tsl/platform/default:posix_file_system.h",
+            "//tensorflow/tsl/platform/default:posix_io_uring.h",
             "//tensorflow/tsl/platform/default:subprocess.h",
         ],
     })
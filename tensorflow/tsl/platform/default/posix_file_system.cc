@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/platform/strcat.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow/tsl/platform/default/posix_file_system.h"
+#include "tensorflow/tsl/platform/default/posix_io_uring.h"
 
 namespace tensorflow {
 
@@ -96,6 +97,27 @@ class PosixRandomAccessFile : public RandomAccessFile {
     return s;
   }
 
+  void ReadAsync(
+      uint64 offset, size_t n, char* scratch,
+      std::function<void(const Status&, StringPiece)> done) const override {
+    PosixIoUring* io_uring = PosixIoUring::Get();
+    if (io_uring == nullptr) {
+      RandomAccessFile::ReadAsync(offset, n, scratch, std::move(done));
+      return;
+    }
+    io_uring->Read(fd_, offset, n, scratch,
+                   [this, scratch, done = std::move(done)](const Status& s,
+                                                           size_t length) {
+                     Status status = s;
+                     if (!s.ok() && !errors::IsOutOfRange(s)) {
+                       status = errors::CreateWithUpdatedMessage(
+                           s, strings::StrCat(filename_, "; ",
+                                              s.error_message()));
+                     }
+                     done(status, StringPiece(scratch, length));
+                   });
+  }
+
 #if defined(TF_CORD_SUPPORT)
   Status Read(uint64 offset, size_t n, absl::Cord* cord) const override {
     if (n == 0) {
@@ -0,0 +1,312 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/tsl/platform/default/posix_io_uring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TF_POSIX_HAS_IO_URING 1
+#endif
+#endif
+
+#if defined(TF_POSIX_HAS_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+#if defined(TF_POSIX_HAS_IO_URING)
+
+struct PosixIoUring::Rings {
+  int fd;
+  // Submission queue.
+  unsigned* sq_head;
+  unsigned* sq_tail;
+  unsigned sq_mask;
+  unsigned* sq_array;
+  struct io_uring_sqe* sqes;
+  // Completion queue.
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned cq_mask;
+  struct io_uring_cqe* cqes;
+};
+
+struct PosixIoUring::Request {
+  int fd;
+  uint64 offset;
+  char* scratch;
+  size_t n;
+  size_t bytes_read;
+  struct iovec iov;
+  DoneCallback done;
+};
+
+namespace {
+
+// Sets up a ring with `entries` submission queue entries, or returns nullptr
+// if io_uring is not available. The rings live until the process exits.
+template <typename Rings>
+Rings* CreateRings(unsigned entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    VLOG(1) << "io_uring is not available: " << strerror(errno);
+    return nullptr;
+  }
+  size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_size = cq_size = std::max(sq_size, cq_size);
+  }
+  const size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  char* sq = static_cast<char*>(mmap(nullptr, sq_size, PROT_READ | PROT_WRITE,
+                                     MAP_SHARED | MAP_POPULATE, fd,
+                                     IORING_OFF_SQ_RING));
+  char* cq = single_mmap ? sq
+                         : static_cast<char*>(mmap(
+                               nullptr, cq_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, fd,
+                               IORING_OFF_CQ_RING));
+  void* sqes = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sq == MAP_FAILED || cq == MAP_FAILED || sqes == MAP_FAILED) {
+    VLOG(1) << "Failed to map io_uring rings: " << strerror(errno);
+    if (sq != MAP_FAILED) munmap(sq, sq_size);
+    if (!single_mmap && cq != MAP_FAILED) munmap(cq, cq_size);
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    close(fd);
+    return nullptr;
+  }
+  Rings* rings = new Rings;
+  rings->fd = fd;
+  rings->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  rings->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  rings->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  rings->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  rings->sqes = static_cast<struct io_uring_sqe*>(sqes);
+  rings->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  rings->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  rings->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  rings->cqes =
+      reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  return rings;
+}
+
+int IoUringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 nullptr, 0);
+}
+
+}  // namespace
+
+/* static */ PosixIoUring* PosixIoUring::Get() {
+  static PosixIoUring* instance = []() -> PosixIoUring* {
+    const char* enabled = getenv("TF_POSIX_IO_URING");
+    if (enabled != nullptr && strcmp(enabled, "0") == 0) {
+      return nullptr;
+    }
+    Rings* rings = CreateRings<Rings>(kMaxInFlight);
+    if (rings == nullptr) {
+      return nullptr;
+    }
+    return new PosixIoUring(rings);
+  }();
+  return instance;
+}
+
+PosixIoUring::PosixIoUring(Rings* rings) : rings_(rings) {
+  completion_thread_.reset(Env::Default()->StartThread(
+      ThreadOptions(), "tf_io_uring_completions", [this]() {
+        CompletionLoop();
+      }));
+}
+
+bool PosixIoUring::Submit(Request* request) {
+  const unsigned tail = *rings_->sq_tail;
+  const unsigned index = tail & rings_->sq_mask;
+  struct io_uring_sqe* sqe = &rings_->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  request->iov.iov_base = request->scratch + request->bytes_read;
+  // Some kernels fail reads of more than `INT32_MAX` bytes.
+  request->iov.iov_len = std::min<size_t>(request->n - request->bytes_read,
+                                          INT32_MAX);
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = request->fd;
+  sqe->off = request->offset + request->bytes_read;
+  sqe->addr = reinterpret_cast<uint64>(&request->iov);
+  sqe->len = 1;
+  sqe->user_data = reinterpret_cast<uint64>(request);
+  rings_->sq_array[index] = index;
+  __atomic_store_n(rings_->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  int submitted;
+  do {
+    submitted = IoUringEnter(rings_->fd, /*to_submit=*/1, /*min_complete=*/0,
+                             /*flags=*/0);
+  } while (submitted < 0 && errno == EINTR);
+  if (submitted == 1) {
+    return true;
+  }
+  VLOG(1) << "Failed to submit io_uring read: "
+          << (submitted < 0 ? strerror(errno) : "no entry consumed");
+  // Only this thread adds entries, so if the kernel did not consume the entry
+  // it can be taken back.
+  if (__atomic_load_n(rings_->sq_head, __ATOMIC_ACQUIRE) != tail + 1) {
+    __atomic_store_n(rings_->sq_tail, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+  return true;
+}
+
+namespace {
+
+// Completes the remainder of `request` with `pread()`.
+template <typename Request>
+Status PreadRemainder(Request* request) {
+  while (request->bytes_read < request->n) {
+    const size_t length =
+        std::min<size_t>(request->n - request->bytes_read, INT32_MAX);
+    const ssize_t r =
+        pread(request->fd, request->scratch + request->bytes_read, length,
+              static_cast<off_t>(request->offset + request->bytes_read));
+    if (r > 0) {
+      request->bytes_read += r;
+    } else if (r == 0) {
+      return errors::OutOfRange("Read less bytes than requested");
+    } else if (errno != EINTR && errno != EAGAIN) {
+      return errors::IOError("pread", errno);
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+void PosixIoUring::Read(int fd, uint64 offset, size_t n, char* scratch,
+                        DoneCallback done) {
+  if (n == 0) {
+    done(OkStatus(), 0);
+    return;
+  }
+  Request* request = new Request{
+      fd, offset, scratch, n, /*bytes_read=*/0, {}, std::move(done)};
+  {
+    mutex_lock l(mu_);
+    while (num_in_flight_ >= kMaxInFlight) {
+      in_flight_cv_.wait(l);
+    }
+    if (Submit(request)) {
+      ++num_in_flight_;
+      return;
+    }
+  }
+  const Status status = PreadRemainder(request);
+  request->done(status, request->bytes_read);
+  delete request;
+}
+
+void PosixIoUring::CompletionLoop() {
+  std::vector<std::pair<Request*, int>> completions;
+  while (true) {
+    if (IoUringEnter(rings_->fd, /*to_submit=*/0, /*min_complete=*/1,
+                     IORING_ENTER_GETEVENTS) < 0 &&
+        errno != EINTR) {
+      LOG(ERROR) << "Failed to wait for io_uring completions: "
+                 << strerror(errno);
+      Env::Default()->SleepForMicroseconds(1000);
+    }
+    unsigned head = *rings_->cq_head;
+    const unsigned tail = __atomic_load_n(rings_->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe* cqe = &rings_->cqes[head & rings_->cq_mask];
+      completions.emplace_back(reinterpret_cast<Request*>(cqe->user_data),
+                               cqe->res);
+    }
+    __atomic_store_n(rings_->cq_head, head, __ATOMIC_RELEASE);
+
+    for (const auto& completion : completions) {
+      Request* request = completion.first;
+      const int res = completion.second;
+      Status status;
+      if (res == -EINTR || res == -EAGAIN) {
+        // Retried below.
+      } else if (res < 0) {
+        status = errors::IOError("io_uring read", -res);
+      } else if (res == 0) {
+        status = errors::OutOfRange("Read less bytes than requested");
+      } else {
+        request->bytes_read += res;
+      }
+      if (status.ok() && request->bytes_read < request->n) {
+        mutex_lock l(mu_);
+        if (Submit(request)) {
+          continue;
+        }
+        // Fall through to finish the read synchronously.
+      }
+      if (status.ok()) {
+        status = PreadRemainder(request);
+      }
+      {
+        mutex_lock l(mu_);
+        --num_in_flight_;
+        in_flight_cv_.notify_one();
+      }
+      request->done(status, request->bytes_read);
+      delete request;
+    }
+    completions.clear();
+  }
+}
+
+#else  // TF_POSIX_HAS_IO_URING
+
+struct PosixIoUring::Rings {};
+
+/* static */ PosixIoUring* PosixIoUring::Get() { return nullptr; }
+
+PosixIoUring::PosixIoUring(Rings* rings) : rings_(rings) {}
+
+bool PosixIoUring::Submit(Request* request) { return false; }
+
+void PosixIoUring::Read(int fd, uint64 offset, size_t n, char* scratch,
+                        DoneCallback done) {
+  done(errors::Unimplemented("io_uring is not supported on this platform"), 0);
+}
+
+void PosixIoUring::CompletionLoop() {}
+
+#endif  // TF_POSIX_HAS_IO_URING
+
+}  // namespace tensorflow
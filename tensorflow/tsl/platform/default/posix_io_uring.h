@@ -0,0 +1,78 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_TSL_PLATFORM_DEFAULT_POSIX_IO_URING_H_
+#define TENSORFLOW_TSL_PLATFORM_DEFAULT_POSIX_IO_URING_H_
+
+#include <functional>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A process-wide io_uring instance for asynchronous reads of file descriptors.
+//
+// Reads are submitted to the kernel as soon as they are issued, and a single
+// completion thread runs their callbacks, so the callbacks must not block.
+// At most `kMaxInFlight` reads are in flight; further reads block the caller
+// until one completes.
+class PosixIoUring {
+ public:
+  static constexpr int kMaxInFlight = 256;
+
+  // `status` is OK if all requested bytes were read, OUT_OF_RANGE if the end
+  // of the file was reached first, and an error otherwise.
+  using DoneCallback = std::function<void(const Status& status, size_t n)>;
+
+  // Returns the process-wide instance, or nullptr if io_uring is not supported
+  // by this platform or kernel, or was disabled by setting the environment
+  // variable `TF_POSIX_IO_URING` to 0.
+  static PosixIoUring* Get();
+
+  // Reads `n` bytes of `fd` at `offset` into `scratch`, and calls `done` with
+  // the number of bytes read. Short reads are continued until `n` bytes are
+  // read or the end of the file is reached. `fd` and `scratch` must stay valid
+  // until `done` is called.
+  void Read(int fd, uint64 offset, size_t n, char* scratch,
+            DoneCallback done);
+
+ private:
+  struct Rings;
+  struct Request;
+
+  explicit PosixIoUring(Rings* rings);
+
+  // Submits the next read of `request`, or returns false if it could not be
+  // submitted.
+  bool Submit(Request* request) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Runs the callbacks of completed reads. Never returns.
+  void CompletionLoop();
+
+  Rings* const rings_;
+  std::unique_ptr<Thread> completion_thread_;
+
+  mutex mu_;
+  condition_variable in_flight_cv_;
+  int num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_TSL_PLATFORM_DEFAULT_POSIX_IO_URING_H_